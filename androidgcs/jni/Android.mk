@@ -68,3 +68,16 @@ LOCAL_LDFLAGS   := -L $(LIBDIR) \
 -lOpenThreads
 
 include $(BUILD_SHARED_LIBRARY)
+
+### Native UAVTalk decoder, shares the CRC code with the flight firmware
+
+include $(CLEAR_VARS)
+
+FLIGHT_DIR              := $(LOCAL_PATH)/../../flight
+
+LOCAL_MODULE    := uavtalkNativeLib
+LOCAL_C_INCLUDES:= $(LOCAL_PATH)/include $(FLIGHT_DIR)/PiOS/inc
+LOCAL_CFLAGS    := -Werror -fno-short-enums -std=gnu99
+LOCAL_SRC_FILES := uavtalkNativeLib.c uavtalk_scanner.c ../../flight/PiOS/Common/pios_crc.c
+
+include $(BUILD_SHARED_LIBRARY)
@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @file       uavtalkNativeLib.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      JNI interface of the native UAVTalk decoder
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <stdlib.h>
+#include <jni.h>
+
+#include "uavtalk_scanner.h"
+
+JNIEXPORT jlong JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_create(JNIEnv *env, jclass cls);
+JNIEXPORT void JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_destroy(JNIEnv *env, jclass cls, jlong handle);
+JNIEXPORT jboolean JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_registerObject(JNIEnv *env, jclass cls, jlong handle, jint objId, jint numBytes, jboolean singleInstance);
+JNIEXPORT jint JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_process(JNIEnv *env, jclass cls, jlong handle, jobject in, jint length, jobject out);
+JNIEXPORT jint JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_getRxErrors(JNIEnv *env, jclass cls, jlong handle);
+
+JNIEXPORT jlong JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_create(JNIEnv *env, jclass cls)
+{
+	struct uavtalk_scanner *s = malloc(sizeof(*s));
+	if (s != NULL)
+		uavtalk_scanner_init(s);
+	return (jlong)(intptr_t)s;
+}
+
+JNIEXPORT void JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_destroy(JNIEnv *env, jclass cls, jlong handle)
+{
+	free((struct uavtalk_scanner *)(intptr_t)handle);
+}
+
+JNIEXPORT jboolean JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_registerObject(JNIEnv *env, jclass cls, jlong handle, jint objId, jint numBytes, jboolean singleInstance)
+{
+	struct uavtalk_scanner *s = (struct uavtalk_scanner *)(intptr_t)handle;
+	return uavtalk_scanner_register(s, (uint32_t)objId, numBytes, singleInstance) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Decode length bytes of the direct buffer in into the direct buffer out
+ * @return The number of bytes of decoded packets in out, or -1 if either
+ *         buffer is not direct
+ */
+JNIEXPORT jint JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_process(JNIEnv *env, jclass cls, jlong handle, jobject in, jint length, jobject out)
+{
+	struct uavtalk_scanner *s = (struct uavtalk_scanner *)(intptr_t)handle;
+
+	const uint8_t *in_buf = (*env)->GetDirectBufferAddress(env, in);
+	uint8_t *out_buf = (*env)->GetDirectBufferAddress(env, out);
+	if (in_buf == NULL || out_buf == NULL)
+		return -1;
+
+	jlong in_size = (*env)->GetDirectBufferCapacity(env, in);
+	if (length > in_size)
+		length = in_size;
+
+	return uavtalk_scanner_process(s, in_buf, length, out_buf, (*env)->GetDirectBufferCapacity(env, out));
+}
+
+JNIEXPORT jint JNICALL Java_org_taulabs_uavtalk_UAVTalkNative_getRxErrors(JNIEnv *env, jclass cls, jlong handle)
+{
+	struct uavtalk_scanner *s = (struct uavtalk_scanner *)(intptr_t)handle;
+	return s->rx_errors;
+}
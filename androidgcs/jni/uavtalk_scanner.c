@@ -0,0 +1,277 @@
+/**
+ ******************************************************************************
+ * @file       uavtalk_scanner.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      UAVTalk frame scanner for the native telemetry decoder.  The
+ *             state machine follows UAVTalkProcessInputStreamQuiet() in
+ *             flight/UAVTalk/uavtalk.c and accepts the packet types the
+ *             Java UAVTalk class handles.
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <string.h>
+
+#include "pios.h"
+#include "uavtalk_scanner.h"
+
+#define SYNC_VAL        0x3C
+#define TYPE_MASK       0xF8
+#define TYPE_VER        0x20
+#define TYPE_OBJ_REQ    (TYPE_VER | 0x01)
+#define TYPE_ACK        (TYPE_VER | 0x03)
+#define TYPE_NACK       (TYPE_VER | 0x04)
+#define TYPE_OBJ_DELTA  (TYPE_VER | 0x05)
+#define TYPE_OBJ_BUNDLE (TYPE_VER | 0x06)
+
+#define MIN_HEADER_LENGTH 8
+#define MAX_HEADER_LENGTH 10
+
+static uint32_t hash_id(uint32_t id)
+{
+	return (id ^ (id >> 10) ^ (id >> 20)) & (UAVTALK_SCANNER_TABLE_SIZE - 1);
+}
+
+static const struct uavtalk_scanner_obj *find_object(const struct uavtalk_scanner *s, uint32_t id)
+{
+	uint32_t i = hash_id(id);
+	for (uint32_t n = 0; n < UAVTALK_SCANNER_TABLE_SIZE; n++) {
+		const struct uavtalk_scanner_obj *o = &s->objects[i];
+		if (!o->used)
+			return NULL;
+		if (o->id == id)
+			return o;
+		i = (i + 1) & (UAVTALK_SCANNER_TABLE_SIZE - 1);
+	}
+	return NULL;
+}
+
+void uavtalk_scanner_init(struct uavtalk_scanner *s)
+{
+	memset(s, 0, sizeof(*s));
+	s->state = SCANNER_SYNC;
+}
+
+/**
+ * Add an object to the table the scanner looks the payload lengths up in
+ * @return false if the table is full
+ */
+bool uavtalk_scanner_register(struct uavtalk_scanner *s, uint32_t id, uint16_t length, bool single_instance)
+{
+	uint32_t i = hash_id(id);
+	for (uint32_t n = 0; n < UAVTALK_SCANNER_TABLE_SIZE; n++) {
+		struct uavtalk_scanner_obj *o = &s->objects[i];
+		if (!o->used || o->id == id) {
+			o->id = id;
+			o->length = length;
+			o->single_instance = single_instance;
+			o->used = 1;
+			return true;
+		}
+		i = (i + 1) & (UAVTALK_SCANNER_TABLE_SIZE - 1);
+	}
+	return false;
+}
+
+static int32_t write_frame(struct uavtalk_scanner *s, uint8_t *out, int32_t out_size)
+{
+	int32_t size = UAVTALK_SCANNER_FRAME_HEADER + s->length;
+	if (size > out_size) {
+		s->rx_errors++;
+		return 0;
+	}
+
+	out[0] = s->type;
+	out[1] = 0;
+	out[2] = s->length & 0xff;
+	out[3] = s->length >> 8;
+	out[4] = s->obj_id & 0xff;
+	out[5] = (s->obj_id >> 8) & 0xff;
+	out[6] = (s->obj_id >> 16) & 0xff;
+	out[7] = s->obj_id >> 24;
+	out[8] = s->inst_id & 0xff;
+	out[9] = s->inst_id >> 8;
+	memcpy(&out[UAVTALK_SCANNER_FRAME_HEADER], s->payload, s->length);
+
+	return size;
+}
+
+/**
+ * Run a block of the telemetry stream through the state machine. The noise
+ * between packets and the payloads are handled a run at a time.
+ * @param[in] in Received bytes
+ * @param[out] out Complete packets, see UAVTALK_SCANNER_FRAME_HEADER
+ * @return The number of bytes written to out
+ */
+int32_t uavtalk_scanner_process(struct uavtalk_scanner *s, const uint8_t *in, int32_t in_len, uint8_t *out, int32_t out_size)
+{
+	int32_t written = 0;
+	int32_t i = 0;
+
+	while (i < in_len) {
+		if (s->state == SCANNER_SYNC) {
+			const uint8_t *sync = memchr(&in[i], SYNC_VAL, in_len - i);
+			if (sync == NULL)
+				break;
+			i = sync - in + 1;
+
+			s->cs = PIOS_CRC_updateByte(0, SYNC_VAL);
+			s->packet_length = 1;
+			s->state = SCANNER_TYPE;
+			continue;
+		}
+
+		if (s->state == SCANNER_DATA) {
+			int32_t n = s->length - s->count;
+			if (n > in_len - i)
+				n = in_len - i;
+
+			memcpy(&s->payload[s->count], &in[i], n);
+			s->cs = PIOS_CRC_updateCRC(s->cs, &in[i], n);
+			s->count += n;
+			s->packet_length += n;
+			i += n;
+
+			if (s->count >= s->length) {
+				s->state = SCANNER_CS;
+				s->count = 0;
+			}
+			continue;
+		}
+
+		const uint8_t rxbyte = in[i++];
+		s->packet_length++;
+
+		switch (s->state) {
+		case SCANNER_TYPE:
+			s->cs = PIOS_CRC_updateByte(s->cs, rxbyte);
+
+			if ((rxbyte & TYPE_MASK) != TYPE_VER) {
+				s->state = SCANNER_SYNC;
+				break;
+			}
+
+			s->type = rxbyte;
+			s->packet_size = 0;
+			s->count = 0;
+			s->state = SCANNER_SIZE;
+			break;
+
+		case SCANNER_SIZE:
+			s->cs = PIOS_CRC_updateByte(s->cs, rxbyte);
+
+			if (s->count == 0) {
+				s->packet_size = rxbyte;
+				s->count++;
+				break;
+			}
+
+			s->packet_size += rxbyte << 8;
+
+			if (s->packet_size < MIN_HEADER_LENGTH ||
+			    s->packet_size > MAX_HEADER_LENGTH + UAVTALK_SCANNER_MAX_PAYLOAD) {
+				s->state = SCANNER_SYNC;
+				break;
+			}
+
+			s->count = 0;
+			s->obj_id = 0;
+			s->state = SCANNER_OBJID;
+			break;
+
+		case SCANNER_OBJID:
+		{
+			s->cs = PIOS_CRC_updateByte(s->cs, rxbyte);
+
+			s->obj_id += (uint32_t)rxbyte << (8 * s->count++);
+			if (s->count < 4)
+				break;
+
+			s->inst_id = 0;
+			s->count = 0;
+
+			// Bundles carry the ids of their objects in the payload
+			if (s->type == TYPE_OBJ_BUNDLE) {
+				s->length = s->packet_size - s->packet_length;
+				if (s->length >= UAVTALK_SCANNER_MAX_PAYLOAD) {
+					s->rx_errors++;
+					s->state = SCANNER_SYNC;
+					break;
+				}
+				s->state = (s->length > 0) ? SCANNER_DATA : SCANNER_CS;
+				break;
+			}
+
+			const struct uavtalk_scanner_obj *obj = find_object(s, s->obj_id);
+			if (obj == NULL) {
+				s->rx_errors++;
+				s->state = SCANNER_SYNC;
+				break;
+			}
+
+			if (s->type == TYPE_OBJ_REQ || s->type == TYPE_ACK || s->type == TYPE_NACK)
+				s->length = 0;
+			else if (s->type == TYPE_OBJ_DELTA && obj->single_instance)
+				s->length = s->packet_size - s->packet_length;
+			else
+				s->length = obj->length;
+
+			if (s->length >= UAVTALK_SCANNER_MAX_PAYLOAD ||
+			    s->packet_length + (obj->single_instance ? 0 : 2) + s->length != s->packet_size) {
+				s->rx_errors++;
+				s->state = SCANNER_SYNC;
+				break;
+			}
+
+			if (!obj->single_instance)
+				s->state = SCANNER_INSTID;
+			else if (s->length > 0)
+				s->state = SCANNER_DATA;
+			else
+				s->state = SCANNER_CS;
+			break;
+		}
+
+		case SCANNER_INSTID:
+			s->cs = PIOS_CRC_updateByte(s->cs, rxbyte);
+
+			s->inst_id += rxbyte << (8 * s->count++);
+			if (s->count < 2)
+				break;
+
+			s->count = 0;
+			s->state = (s->length > 0) ? SCANNER_DATA : SCANNER_CS;
+			break;
+
+		case SCANNER_CS:
+			if (rxbyte != s->cs || s->packet_length != s->packet_size + 1) {
+				s->rx_errors++;
+				s->state = SCANNER_SYNC;
+				break;
+			}
+
+			written += write_frame(s, &out[written], out_size - written);
+			s->state = SCANNER_SYNC;
+			break;
+
+		default:
+			s->rx_errors++;
+			s->state = SCANNER_SYNC;
+		}
+	}
+
+	return written;
+}
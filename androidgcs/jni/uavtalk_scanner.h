@@ -0,0 +1,73 @@
+/**
+ ******************************************************************************
+ * @file       uavtalk_scanner.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      UAVTalk frame scanner for the native telemetry decoder
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVTALK_SCANNER_H
+#define UAVTALK_SCANNER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! Same limit as the Java UAVTalk implementation
+#define UAVTALK_SCANNER_MAX_PAYLOAD 256
+//! Size of the object table, a power of two well above the number of objects
+#define UAVTALK_SCANNER_TABLE_SIZE 1024
+
+/**
+ * Each complete packet is written to the output as this header, little
+ * endian, followed by the payload:
+ *   type (1), reserved (1), payload length (2), object id (4), instance id (2)
+ */
+#define UAVTALK_SCANNER_FRAME_HEADER 10
+
+enum uavtalk_scanner_state {
+	SCANNER_SYNC, SCANNER_TYPE, SCANNER_SIZE, SCANNER_OBJID, SCANNER_INSTID, SCANNER_DATA, SCANNER_CS
+};
+
+struct uavtalk_scanner_obj {
+	uint32_t id;
+	uint16_t length;
+	uint8_t single_instance;
+	uint8_t used;
+};
+
+struct uavtalk_scanner {
+	struct uavtalk_scanner_obj objects[UAVTALK_SCANNER_TABLE_SIZE];
+
+	enum uavtalk_scanner_state state;
+	uint8_t type;
+	uint8_t cs;
+	uint16_t packet_size;
+	uint16_t packet_length;
+	uint32_t obj_id;
+	uint16_t inst_id;
+	uint16_t length;
+	uint16_t count;
+	uint8_t payload[UAVTALK_SCANNER_MAX_PAYLOAD];
+
+	uint32_t rx_errors;
+};
+
+void uavtalk_scanner_init(struct uavtalk_scanner *s);
+bool uavtalk_scanner_register(struct uavtalk_scanner *s, uint32_t id, uint16_t length, bool single_instance);
+int32_t uavtalk_scanner_process(struct uavtalk_scanner *s, const uint8_t *in, int32_t in_len, uint8_t *out, int32_t out_size);
+
+#endif /* UAVTALK_SCANNER_H */
@@ -27,8 +27,8 @@ package org.taulabs.androidgcs.telemetry;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
-import java.nio.ByteBuffer;
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.HashMap;
 import java.util.List;
 import java.util.UUID;
@@ -72,6 +72,15 @@ public class BluetoothLowEnergyUAVTalk extends TelemetryTask {
 	//! The stream which sends data to the HID device
 	private TalkOutputStream outTalkStream;
 
+	//! Largest write the HM-10 serial characteristic accepts
+	private static final int BLE_PAYLOAD_SIZE = 20;
+	//! Bytes waiting to be written to the characteristic
+	private final ByteFifo txFifo = new ByteFifo(4096);
+	private final byte[] txChunk = new byte[BLE_PAYLOAD_SIZE];
+	//! Set while a characteristic write has not been acknowledged
+	private boolean txBusy = false;
+	private final Object txLock = new Object();
+
     public final static UUID HM_RX_TX =
             UUID.fromString(SampleGattAttributes.HM_RX_TX);
 
@@ -157,16 +166,35 @@ public class BluetoothLowEnergyUAVTalk extends TelemetryTask {
         
     }
 
-    private void writeData(byte[] tx) {
+    private boolean writeData(byte[] tx) {
 		 if(mConnected && characteristicTX != null) {
 			if (DEBUG) Log.d(TAG, "Sending data: " + tx + " # bytes: " + tx.length);
 
 		    characteristicTX.setValue(tx);
-			writeCharacteristic(characteristicTX);
+			return writeCharacteristic(characteristicTX);
 		 } else {
 			 if (ERROR) Log.e(TAG, "Invalid connection: " + mConnected + " " + characteristicTX);
+			 return false;
 		 }
     }
+
+	/**
+	 * Write the next chunk of queued data unless a write is still in flight.
+	 * Only one write can be outstanding on a GATT connection, so packets
+	 * queued in the meantime go out together in full sized writes.
+	 */
+	private void sendNextChunk() {
+		synchronized (txLock) {
+			if (txBusy)
+				return;
+
+			int n = txFifo.get(txChunk, 0, BLE_PAYLOAD_SIZE);
+			if (n == 0)
+				return;
+
+			txBusy = writeData(Arrays.copyOf(txChunk, n));
+		}
+	}
     
     private void receiveData(String data) {
     	//if (DEBUG) Log.d(TAG, "Received data: " + data);
@@ -218,6 +246,9 @@ public class BluetoothLowEnergyUAVTalk extends TelemetryTask {
         		telemService.toastMessage("Bluetooth device connected");
 
             	mConnected = true;
+        		synchronized (txLock) {
+        			txBusy = false;
+        		}
         		inTalkStream = new TalkInputStream();
         		outTalkStream = new TalkOutputStream();
         		inStream = inTalkStream;
@@ -246,6 +277,18 @@ public class BluetoothLowEnergyUAVTalk extends TelemetryTask {
             }
         }
 
+        @Override
+        public void onCharacteristicWrite(BluetoothGatt gatt,
+                                          BluetoothGattCharacteristic characteristic,
+                                          int status) {
+        	if (status != BluetoothGatt.GATT_SUCCESS && WARN)
+        		Log.w(TAG, "onCharacteristicWrite received: " + status);
+        	synchronized (txLock) {
+        		txBusy = false;
+        	}
+        	sendNextChunk();
+        }
+
         @Override
         public void onCharacteristicChanged(BluetoothGatt gatt,
                                             BluetoothGattCharacteristic characteristic) {
@@ -370,13 +413,13 @@ public class BluetoothLowEnergyUAVTalk extends TelemetryTask {
      * Write to a given char
      * @param characteristic The characteristic to write to
      */
-	public void writeCharacteristic(BluetoothGattCharacteristic characteristic) {
+	public boolean writeCharacteristic(BluetoothGattCharacteristic characteristic) {
 		if (mBluetoothAdapter == null || mBluetoothGatt == null) {
 			if (WARN) Log.w(TAG, "BluetoothAdapter not initialized");
-			return;
+			return false;
 		}
 
-		mBluetoothGatt.writeCharacteristic(characteristic);
+		return mBluetoothGatt.writeCharacteristic(characteristic);
 	}   
     
     /**
@@ -420,39 +463,29 @@ public class BluetoothLowEnergyUAVTalk extends TelemetryTask {
 		
 		@Override
 		public void write(int oneByte) throws IOException {
-			Log.d(TAG, "Writing byte");
 			byte [] b = new byte[1];
 			b[0] = (byte) oneByte;
-			writeData(b);
+			write(b, 0, 1);
 		}
 		
 		@Override
 		public void write(byte [] bytes) throws IOException {
+			write(bytes, 0, bytes.length);
+		}
+
+		@Override
+		public void write(byte [] bytes, int off, int len) throws IOException {
 			
-			final int STRIDE = 20; // max size of BT device
-			final int LEN = bytes.length;
-			int idx = 0;
-			
-			while(idx < LEN) {
-				int n = LEN - idx;
-				if (n > STRIDE)
-					n = STRIDE;
-				byte [] send = new byte[n];
-				for (int i = 0; i < n; i++)
-					send[i] = bytes[idx + i];
-
-				if (DEBUG) Log.d(TAG, "Sending " + n + " bytes starting at " + idx + " out of " + LEN);
-
-				writeData(send);
-				idx = idx + n;
-			}
+			// A full queue drops the packet like a busy link would
+			txFifo.put(bytes, off, len);
+			sendNextChunk();
 		}
 	};
 
 	private class TalkInputStream extends InputStream {
-		// Uses ByteFifo.getByteBlocking()
+		// Uses ByteFifo.getBlocking()
 		// Uses ByteFifo.put(byte[])
-		ByteFifo data = new ByteFifo();
+		ByteFifo data = new ByteFifo(4096);
 
 		@Override
 		public int read() {
@@ -469,78 +502,23 @@ public class BluetoothLowEnergyUAVTalk extends TelemetryTask {
 			return -1;
 		}
 
-		public void write(byte[] b) {
-			synchronized(data) {
-				data.put(b);
-				data.notify();
-			}
-		}
-	};
-
-	private class ByteFifo {
-
-		//! The maximum size of the fifo
-		private final int MAX_SIZE = 256;
-		//! The number of bytes in the buffer
-		private int size = 0;
-		//! Internal buffer
-		private final ByteBuffer buf;
-
-		ByteFifo() {
-			buf = ByteBuffer.allocate(MAX_SIZE);
-			size = 0;
-		}
-
-		private int byteToInt(byte b) { return b & 0x000000ff; }
-
-		final int remaining() { return size; };
-
-		public boolean put(byte b) {
-			byte[] a = {b};
-			return put(a);
-		}
-
-		public boolean put(byte[] dat) {
-			if ((size + dat.length) > MAX_SIZE) {
-				Log.e(TAG, "Dropped data.  Size:" + size + " data length: " + dat.length);
-				return false;
-			}
-
-			// Place data at the end of the buffer
-			synchronized(buf) {
-				buf.position(size);
-				buf.put(dat);
-				size = size + dat.length;
-				buf.notify();
-			}
-			return true;
-		}
-
-		//! Return buffer if enough bytes are available
-		public ByteBuffer get(byte[] dst, int offset, int size) {
-			if (size < this.size)
-				return null;
-
-			synchronized(buf) {
-				buf.flip();
-				buf.get(dst, offset, size);
-				buf.compact();
-				this.size -= size;
+		@Override
+		public int read(byte[] b, int off, int len) {
+			try {
+				return data.getBlocking(b, off, len);
+			} catch (InterruptedException e) {
+				if (!shutdown) {
+					Log.e(TAG, "Timed out");
+					if (DEBUG) e.printStackTrace();
+					disconnect();
+					telemService.connectionBroken();
+				}
 			}
-			return buf;
+			return -1;
 		}
 
-		public int getByteBlocking() throws InterruptedException {
-			synchronized(buf) {
-				while (size <= 0) {
-					buf.wait();
-				}
-				int val = byteToInt(buf.get(0));
-				buf.position(1);
-				buf.compact();
-				size--;
-				return val;
-			}
+		public void write(byte[] b) {
+			data.put(b);
 		}
-	}
+	};
 }
@@ -0,0 +1,121 @@
+/**
+ ******************************************************************************
+ * @file       ByteFifo.java
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Byte queue between the transport threads and UAVTalk.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+package org.taulabs.androidgcs.telemetry;
+
+import android.util.Log;
+
+/**
+ * Ring buffer of bytes shared by the transports that receive their data
+ * in a callback or on their own thread.  Data is copied in and out in
+ * blocks so nothing is moved around when bytes are taken out.
+ */
+class ByteFifo {
+
+	private static final String TAG = ByteFifo.class.getSimpleName();
+
+	//! The default size of the fifo
+	static final int DEFAULT_SIZE = 256;
+
+	//! Internal buffer
+	private final byte[] buf;
+	//! Index of the oldest byte
+	private int head = 0;
+	//! The number of bytes in the buffer
+	private int size = 0;
+
+	ByteFifo() {
+		this(DEFAULT_SIZE);
+	}
+
+	ByteFifo(int maxSize) {
+		buf = new byte[maxSize];
+	}
+
+	private int byteToInt(byte b) { return b & 0x000000ff; }
+
+	final synchronized int remaining() { return size; };
+
+	public boolean put(byte b) {
+		byte[] a = {b};
+		return put(a);
+	}
+
+	public boolean put(byte[] dat) {
+		return put(dat, 0, dat.length);
+	}
+
+	public synchronized boolean put(byte[] dat, int offset, int len) {
+		if ((size + len) > buf.length) {
+			Log.e(TAG, "Dropped data.  Size:" + size + " data length: " + len);
+			return false;
+		}
+
+		// Place data at the end of the buffer, wrapping around if needed
+		int tail = (head + size) % buf.length;
+		int first = Math.min(len, buf.length - tail);
+		System.arraycopy(dat, offset, buf, tail, first);
+		System.arraycopy(dat, offset + first, buf, 0, len - first);
+		size += len;
+		notifyAll();
+
+		return true;
+	}
+
+	/**
+	 * Take up to len bytes without waiting
+	 * @return The number of bytes copied into dst
+	 */
+	public synchronized int get(byte[] dst, int offset, int len) {
+		len = Math.min(len, size);
+
+		int first = Math.min(len, buf.length - head);
+		System.arraycopy(buf, head, dst, offset, first);
+		System.arraycopy(buf, 0, dst, offset + first, len - first);
+		head = (head + len) % buf.length;
+		size -= len;
+
+		return len;
+	}
+
+	/**
+	 * Wait for data and then take as much of it as fits in dst
+	 * @return The number of bytes copied into dst
+	 */
+	public synchronized int getBlocking(byte[] dst, int offset, int len) throws InterruptedException {
+		while (size <= 0) {
+			wait();
+		}
+		return get(dst, offset, len);
+	}
+
+	public synchronized int getByteBlocking() throws InterruptedException {
+		while (size <= 0) {
+			wait();
+		}
+		int val = byteToInt(buf[head]);
+		head = (head + 1) % buf.length;
+		size--;
+		return val;
+	}
+}
@@ -637,10 +637,21 @@ public class HidUAVTalk extends TelemetryTask {
 			}
 		}
 
+		@Override
+		public void write(byte[] b, int off, int len) throws IOException {
+			if (shutdown)
+				throw new IOException();
+
+			synchronized(data) {
+				data.put(b, off, len);
+				data.notify();
+			}
+		}
+
 	};
 
 	private class TalkInputStream extends InputStream {
-		// Uses ByteFifo.getByteBlocking()
+		// Uses ByteFifo.getBlocking()
 		// Uses ByteFifo.put(byte[])
 		ByteFifo data = new ByteFifo();
 
@@ -662,71 +673,23 @@ public class HidUAVTalk extends TelemetryTask {
 			return -1;
 		}
 
-		public void write(byte[] b) {
-			data.put(b);
-		}
-	};
-
-	private class ByteFifo {
-
-		//! The maximum size of the fifo
-		private final int MAX_SIZE = 256;
-		//! The number of bytes in the buffer
-		private int size = 0;
-		//! Internal buffer
-		private final ByteBuffer buf;
-
-		ByteFifo() {
-			buf = ByteBuffer.allocate(MAX_SIZE);
-			size = 0;
-		}
-
-		private int byteToInt(byte b) { return b & 0x000000ff; }
-
-		final int remaining() { return size; };
-
-		public boolean put(byte b) {
-			byte[] a = {b};
-			return put(a);
-		}
-
-		public boolean put(byte[] dat) {
-			if ((size + dat.length) > MAX_SIZE) {
-				Log.e(TAG, "Dropped data.  Size:" + size + " data length: " + dat.length);
-				return false;
-			}
-
-			// Place data at the end of the buffer
-			synchronized(buf) {
-				buf.position(size);
-				buf.put(dat);
-				size = size + dat.length;
-				buf.notify();
-			}
-			return true;
-		}
-
-		public ByteBuffer get(byte[] dst, int offset, int size) {
-			synchronized(buf) {
-				buf.flip();
-				buf.get(dst, offset, size);
-				buf.compact();
-				this.size -= size;
+		@Override
+		public int read(byte[] b, int off, int len) {
+			try {
+				return data.getBlocking(b, off, len);
+			} catch (InterruptedException e) {
+				if (!shutdown) {
+					Log.e(TAG, "Timed out");
+					if (DEBUG) e.printStackTrace();
+					disconnect();
+					telemService.connectionBroken();
+				}
 			}
-			return buf;
+			return -1;
 		}
 
-		public int getByteBlocking() throws InterruptedException {
-			synchronized(buf) {
-				if (size == 0) {
-					buf.wait();
-				}
-				int val = byteToInt(buf.get(0));
-				buf.position(1);
-				buf.compact();
-				size--;
-				return val;
-			}
+		public void write(byte[] b) {
+			data.put(b);
 		}
-	}
-}
\ No newline at end of file
+	};
+}
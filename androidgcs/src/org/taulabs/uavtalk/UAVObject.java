@@ -25,6 +25,7 @@ package org.taulabs.uavtalk;
 
 import java.nio.ByteBuffer;
 import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
 import java.util.ListIterator;
 import java.util.Observable;
@@ -441,8 +442,10 @@ public abstract class UAVObject {
 		this.numBytes = numBytes;
 		this.fields = fields;
 		// Initialize fields
+		fieldsByName = new HashMap<String, UAVObjectField>(fields.size() * 2);
 		for (int n = 0; n < fields.size(); ++n) {
 			fields.get(n).initialize(this);
+			fieldsByName.put(fields.get(n).getName(), fields.get(n));
 		}
 		unpack(data);
 	}
@@ -573,15 +576,19 @@ public abstract class UAVObject {
 	 * @returns The field or NULL if not found
 	 */
 	public UAVObjectField getField(String name) {
-		// Look for field
-		ListIterator<UAVObjectField> li = fields.listIterator();
-		while (li.hasNext()) {
-			UAVObjectField field = li.next();
-			if (field.getName().equals(name))
-				return field;
-		}
 		//throw new Exception("Field not found");
-		return null;
+		return fieldsByName.get(name);
+	}
+
+	/**
+	 * Get a field by its position in the object, the generated objects
+	 * have a FIELD_ constant for each of them
+	 * @returns The field or NULL if out of range
+	 */
+	public UAVObjectField getField(int index) {
+		if (index < 0 || index >= fields.size())
+			return null;
+		return fields.get(index);
 	}
 
 	/**
@@ -852,4 +859,5 @@ public abstract class UAVObject {
 	// TODO: QMutex* mutex;
 //	protected ByteBuffer data;
 	protected List<UAVObjectField> fields;
+	private HashMap<String, UAVObjectField> fieldsByName;
 }
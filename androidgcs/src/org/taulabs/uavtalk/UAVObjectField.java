@@ -26,6 +26,7 @@ package org.taulabs.uavtalk;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
 import java.util.ArrayList;
+import java.util.Arrays;
 import java.util.List;
 
 public class UAVObjectField {
@@ -115,66 +116,35 @@ public class UAVObjectField {
      * @param dataOut
      * @return the number of bytes added
      **/
-    @SuppressWarnings("unchecked")
 	public synchronized int pack(ByteBuffer dataOut) {
         // Pack each element in output buffer
     	dataOut.order(ByteOrder.LITTLE_ENDIAN);
         switch (type)
         {
             case INT8:
-            	for (int index = 0; index < numElements; ++index) {
-            		Integer val = (Integer) getValue(index);
-            		dataOut.put(val.byteValue());
-            	}
+            case UINT8:
+            case ENUM:
+            case BITFIELD:
+            	for (int index = 0; index < numElements; ++index)
+            		dataOut.put((byte) intData[index]);
                 break;
             case INT16:
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (Integer) getValue(index);
-                	dataOut.putShort(val.shortValue());
-                }
+            case UINT16:
+                for (int index = 0; index < numElements; ++index)
+                	dataOut.putShort((short) intData[index]);
                 break;
             case INT32:
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (Integer) getValue(index);
-                	dataOut.putInt(val);
-                }
-                break;
-            case UINT8:
-            	// TODO: Deal properly with unsigned
-            	for (int index = 0; index < numElements; ++index) {
-            		Integer val = (Integer) getValue(index);
-            		dataOut.put(val.byteValue());
-            	}
-                break;
-            case UINT16:
-            	// TODO: Deal properly with unsigned
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (Integer) getValue(index);
-                	dataOut.putShort(val.shortValue());
-                }
+                for (int index = 0; index < numElements; ++index)
+                	dataOut.putInt(intData[index]);
                 break;
             case UINT32:
-            	// TODO: Deal properly with unsigned
-                for (int index = 0; index < numElements; ++index) {
-                	Integer val = (int) ( ((Long) getValue(index)).longValue() & 0xffffffffL);
-                	dataOut.putInt(val);
-                }
-                break;
-            case FLOAT32:
                 for (int index = 0; index < numElements; ++index)
-                	dataOut.putFloat((Float) getValue(index));
+                	dataOut.putInt((int) longData[index]);
                 break;
-            case ENUM:
-            	List<Byte> l = (List<Byte>) data;
+            case FLOAT32:
                 for (int index = 0; index < numElements; ++index)
-                	dataOut.put(l.get(index));
+                	dataOut.putFloat(floatData[index]);
                 break;
-            case BITFIELD:
-            	for (int index = 0; index < numElements; ++index) {
-            		Integer val = (Integer) getValue(index);
-            		dataOut.put(val.byteValue());
-            	}
-            	break;
             case STRING:
             	// TODO: Implement strings
             	throw new Error("Strings not yet implemented.  Field name: " + getName());
@@ -183,96 +153,41 @@ public class UAVObjectField {
         return getNumBytes();
     }
 
-    @SuppressWarnings("unchecked")
 	public synchronized int unpack(ByteBuffer dataIn) {
         // Unpack each element from input buffer
     	dataIn.order(ByteOrder.LITTLE_ENDIAN);
         switch (type)
         {
             case INT8:
-            {
-            	List<Byte> l = (List<Byte>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Long val = bound(dataIn.get());
-            		l.set(index, val.byteValue());
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		intData[index] = dataIn.get();
                 break;
-            }
             case INT16:
-            {
-            	List<Short> l = (List<Short>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Long val = bound(dataIn.getShort());
-            		l.set(index, val.shortValue());
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		intData[index] = dataIn.getShort();
                 break;
-            }
             case INT32:
-            {
-            	List<Integer> l = (List<Integer>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Long val = bound(dataIn.getInt());
-            		l.set(index, val.intValue());
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		intData[index] = dataIn.getInt();
                 break;
-            }
             case UINT8:
-            {
-            	List<Short> l = (List<Short>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		int signedval = dataIn.get();  // this sign extends it
-            		int unsignedval = signedval & 0xff;    // drop sign extension
-            		l.set(index, (short) unsignedval);
-            	}
+            case BITFIELD:
+            case ENUM:
+            	for (int index = 0 ; index < numElements; ++index)
+            		intData[index] = dataIn.get() & 0xff;    // drop sign extension
                 break;
-            }
             case UINT16:
-            {
-            	List<Integer> l = (List<Integer>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		int signedval = dataIn.getShort();  // this sign extends it
-            		int unsignedval = signedval & 0xffff;    // drop sign extension
-            		l.set(index, unsignedval);
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		intData[index] = dataIn.getShort() & 0xffff;
                 break;
-            }
             case UINT32:
-            {
-            	List<Long> l = (List<Long>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		long signedval = dataIn.getInt();  // this sign extends it
-            		long unsignedval = signedval & 0xffffffffL;    // drop sign extension
-            		l.set(index, unsignedval);
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		longData[index] = dataIn.getInt() & 0xffffffffL;
                 break;
-            }
             case FLOAT32:
-            {
-            	List<Float> l = (List<Float>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		Float val = dataIn.getFloat();
-            		l.set(index, val);
-            	}
+            	for (int index = 0 ; index < numElements; ++index)
+            		floatData[index] = dataIn.getFloat();
                 break;
-            }
-            case BITFIELD:
-            {
-            	List<Short> l = (List<Short>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		int signedval = dataIn.get();  // this sign extends it
-            		int unsignedval = signedval & 0xff;    // drop sign extension
-            		l.set(index, (short) unsignedval);
-            	}
-                break;
-            }
-            case ENUM:
-            {
-        		List<Byte> l = (List<Byte>) this.data;
-            	for (int index = 0 ; index < numElements; ++index) {
-            		l.set(index, dataIn.get());
-            	}
-                break;
-            }
             case STRING:
             	// TODO: implement strings
             	//throw new Exception("Strings not handled");
@@ -282,7 +197,6 @@ public class UAVObjectField {
     }
 
     public Object getValue()  { return getValue(0); };
-    @SuppressWarnings("unchecked")
 	public synchronized Object getValue(int index)  {
         // Check that index is not out of bounds
         if ( index >= numElements )
@@ -293,32 +207,25 @@ public class UAVObjectField {
         switch (type)
         {
             case INT8:
-            	return ((List<Byte>) data).get(index).intValue();
             case INT16:
-            	return ((List<Short>) data).get(index).intValue();
             case INT32:
-            	return ((List<Integer>) data).get(index).intValue();
             case UINT8:
-            	return ((List<Short>) data).get(index).intValue();
             case UINT16:
-            	return ((List<Integer>) data).get(index).intValue();
+            case BITFIELD:
+            	return intData[index];
             case UINT32:
-            	return ((List<Long>) data).get(index);
+            	return longData[index];
             case FLOAT32:
-            	return ((List<Float>) data).get(index);
+            	return floatData[index];
             case ENUM:
             {
-            	List<Byte> l = (List<Byte>) data;
-            	Byte val = l.get(index);
+            	int val = intData[index];
 
                 //if(val >= options.size() || val < 0)
                 //	throw new Exception("Invalid value for" + name);
 
                 return options.get(val);
             }
-            case BITFIELD:
-            	return ((List<Short>) data).get(index).intValue();
-
             case STRING:
             {
             	//throw new Exception("Shit I should do this");
@@ -329,105 +236,132 @@ public class UAVObjectField {
     }
 
     public void setValue(Object data) { setValue(data,0); }
-    @SuppressWarnings("unchecked")
 	public synchronized void setValue(Object data, int index) {
     	// Check that index is not out of bounds
     	//if ( index >= numElements );
     		//throw new Exception("Index out of bounds");
 
-    	// Get metadata
-    	UAVObject.Metadata mdata = obj.getMetadata();
-    	// Update value if the access mode permits
-    	if ( mdata.GetGcsAccess() == UAVObject.AccessMode.ACCESS_READWRITE )
+    	switch (type)
     	{
-    		switch (type)
-    		{
-    		case INT8:
-    		{
-    			List<Byte> l = (List<Byte>) this.data;
-    			l.set(index, bound(data).byteValue());
-    			break;
-    		}
-    		case INT16:
-    		{
-    			List<Short> l = (List<Short>) this.data;
-    			l.set(index, bound(data).shortValue());
-    			break;
-    		}
-    		case INT32:
-    		{
-    			List<Integer> l = (List<Integer>) this.data;
-    			l.set(index, bound(data).intValue());
-    			break;
-    		}
-    		case UINT8:
-    		{
-    			List<Short> l = (List<Short>) this.data;
-    			l.set(index, bound(data).shortValue());
-    			break;
-    		}
-    		case UINT16:
-    		{
-    			List<Integer> l = (List<Integer>) this.data;
-    			l.set(index, bound(data).intValue());
-    			break;
-    		}
-    		case UINT32:
-    		{
-    			List<Long> l = (List<Long>) this.data;
-    			l.set(index, bound(data));
-    			break;
-    		}
-    		case FLOAT32:
-    		{
-    			List<Float> l = (List<Float>) this.data;
-    			l.set(index, ((Number) data).floatValue());
-    			break;
-    		}
-    		case ENUM:
-    		{
-    			byte val;
-    			try {
-    				// Test if numeric constant passed in
-    				val = ((Number) data).byteValue();
-    			} catch (Exception e) {
-    				val = (byte) options.indexOf(data);
-    			}
-    			//if(val < 0) throw new Exception("Enumerated value not found");
-    			List<Byte> l = (List<Byte>) this.data;
-    			l.set(index, val);
-    			break;
-    		}
-    		case BITFIELD:
-    		{
-    			List<Short> l = (List<Short>) this.data;
-    			l.set(index, bound(data).shortValue());
-    			break;
-    		}
-    		case STRING:
-    		{
-    			//throw new Exception("Sorry I haven't implemented strings yet");
-    		}
+    	case FLOAT32:
+    		setFloat(((Number) data).floatValue(), index);
+    		break;
+    	case ENUM:
+    	{
+    		byte val;
+    		try {
+    			// Test if numeric constant passed in
+    			val = ((Number) data).byteValue();
+    		} catch (Exception e) {
+    			val = (byte) options.indexOf(data);
     		}
-    		//obj.updated();
+    		//if(val < 0) throw new Exception("Enumerated value not found");
+    		setLong(val & 0xff, index);
+    		break;
+    	}
+    	case STRING:
+    	{
+    		//throw new Exception("Sorry I haven't implemented strings yet");
+    		break;
+    	}
+    	default:
+    		setLong(bound(data), index);
+    	}
+    }
+
+    /**
+     * The typed getters and setters below read the primitive storage directly
+     * and do not allocate, so they are the ones to use for frequent updates.
+     * Enums are handled as the index of their option.
+     */
+    public int getInt() { return getInt(0); };
+	public synchronized int getInt(int index) {
+    	switch (type) {
+    	case UINT32:
+    		return (int) longData[index];
+    	case FLOAT32:
+    		return (int) floatData[index];
+    	default:
+    		return intData[index];
+    	}
+    }
+
+    public long getLong() { return getLong(0); };
+	public synchronized long getLong(int index) {
+    	switch (type) {
+    	case UINT32:
+    		return longData[index];
+    	case FLOAT32:
+    		return (long) floatData[index];
+    	default:
+    		return intData[index];
+    	}
+    }
+
+    public float getFloat() { return getFloat(0); };
+	public synchronized float getFloat(int index) {
+    	switch (type) {
+    	case UINT32:
+    		return longData[index];
+    	case FLOAT32:
+    		return floatData[index];
+    	default:
+    		return intData[index];
     	}
     }
 
     public double getDouble() { return getDouble(0); };
-    @SuppressWarnings("unchecked")
 	public double getDouble(int index) {
+    	if (type == FieldType.UINT32)
+    		return getLong(index);
+    	return getFloat(index);
+    }
+
+    public void setInt(int value) { setLong(value, 0); };
+    public void setInt(int value, int index) { setLong(value, index); };
+
+    public void setLong(long value) { setLong(value, 0); };
+	public synchronized void setLong(long value, int index) {
+    	if (!isWritable())
+    		return;
+
     	switch (type) {
-    	case ENUM:
-    		return ((List<Byte>)data).get(index);
-    	default:
+    	case UINT32:
+    		longData[index] = bound(value);
+    		break;
+    	case FLOAT32:
+    		floatData[index] = value;
     		break;
+    	case STRING:
+    		break;
+    	default:
+    		intData[index] = (int) bound(value);
     	}
-    	return ((Number) getValue(index)).doubleValue();
+    }
+
+    public void setFloat(float value) { setFloat(value, 0); };
+	public synchronized void setFloat(float value, int index) {
+    	if (!isWritable())
+    		return;
+
+    	if (type == FieldType.FLOAT32)
+    		floatData[index] = value;
+    	else
+    		setLong((long) value, index);
     }
 
     public void setDouble(double value) { setDouble(value, 0); };
     public void setDouble(double value, int index) {
-    	setValue(value, index);
+    	if (type == FieldType.FLOAT32)
+    		setFloat((float) value, index);
+    	else
+    		setLong((long) value, index);
+    }
+
+    //! Update a value only if the access mode permits
+    private boolean isWritable() {
+    	UAVObject.Metadata mdata = obj.getMetadata();
+    	return mdata.GetGcsAccess() == UAVObject.AccessMode.ACCESS_READWRITE;
     }
 
     public int getDataOffset() {
@@ -520,71 +454,13 @@ public class UAVObjectField {
 
     }
 
-    @SuppressWarnings("unchecked")
 	public synchronized void clear() {
-    	switch (type)
-        {
-            case INT8:
-            	((ArrayList<Byte>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Byte>) data).add((byte) 0);
-            	}
-                break;
-            case INT16:
-            	((ArrayList<Short>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Short>) data).add((short) 0);
-            	}
-                break;
-            case INT32:
-            	((ArrayList<Integer>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Integer>) data).add(0);
-            	}
-                break;
-            case UINT8:
-            	((ArrayList<Short>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Short>) data).add((short) 0);
-            	}
-                break;
-            case UINT16:
-            	((ArrayList<Integer>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Integer>) data).add(0);
-            	}
-                break;
-            case UINT32:
-            	((ArrayList<Long>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Long>) data).add((long) 0);
-            	}
-                break;
-            case FLOAT32:
-            	((ArrayList<Float>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Float>) data).add((float) 0);
-            	}
-                break;
-            case BITFIELD:
-            	((ArrayList<Short>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Short>) data).add((short) 0);
-            	}
-                break;
-            case ENUM:
-            	((ArrayList<Byte>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Byte>) data).add((byte) 0);
-            	}
-                break;
-            case STRING:
-            	((ArrayList<Byte>) data).clear();
-            	for(int index = 0; index < numElements; ++index) {
-            		((ArrayList<Byte>) data).add((byte) 0);
-            	}
-                break;
-        }
+    	if (intData != null)
+    		Arrays.fill(intData, 0);
+    	if (longData != null)
+    		Arrays.fill(longData, 0);
+    	if (floatData != null)
+    		Arrays.fill(floatData, 0);
     }
 
     public synchronized void constructorInitialize(String name, String units, FieldType type, List<String> elementNames, List<String> options) {
@@ -595,7 +471,9 @@ public class UAVObjectField {
         this.options = options;
         this.numElements = elementNames.size();
         this.offset = 0;
-        this.data = null;
+        this.intData = null;
+        this.longData = null;
+        this.floatData = null;
         this.obj = null;
         this.elementNames = elementNames;
 
@@ -603,47 +481,36 @@ public class UAVObjectField {
         switch (type)
         {
             case INT8:
-            	data = new ArrayList<Byte>(this.numElements);
-                numBytesPerElement = 1;
-                break;
-            case INT16:
-            	data = new ArrayList<Short>(this.numElements);
-                numBytesPerElement = 2;
-                break;
-            case INT32:
-            	data = new ArrayList<Integer>(this.numElements);
-                numBytesPerElement = 4;
-                break;
             case UINT8:
-            	data = new ArrayList<Short>(this.numElements);
+            case ENUM:
+            case BITFIELD:
+            case STRING:
                 numBytesPerElement = 1;
                 break;
+            case INT16:
             case UINT16:
-            	data = new ArrayList<Integer>(this.numElements);
                 numBytesPerElement = 2;
                 break;
+            case INT32:
             case UINT32:
-            	data = new ArrayList<Long>(this.numElements);
-                numBytesPerElement = 4;
-                break;
             case FLOAT32:
-            	data = new ArrayList<Float>(this.numElements);
                 numBytesPerElement = 4;
                 break;
-            case ENUM:
-            	data = new ArrayList<Byte>(this.numElements);
-                numBytesPerElement = 1;
-                break;
-            case BITFIELD:
-            	data = new ArrayList<Short>(this.numElements);
-                numBytesPerElement = 1;
+            default:
+                numBytesPerElement = 0;
+        }
+
+        // Values are kept in a primitive array wide enough for the type
+        switch (type)
+        {
+            case UINT32:
+                longData = new long[numElements];
                 break;
-            case STRING:
-            	data = new ArrayList<Byte>(this.numElements);
-                numBytesPerElement = 1;
+            case FLOAT32:
+                floatData = new float[numElements];
                 break;
             default:
-                numBytesPerElement = 0;
+                intData = new int[numElements];
         }
         clear();
     }
@@ -655,11 +522,17 @@ public class UAVObjectField {
      * @note This is mostly needed because java has no unsigned integer
      */
     protected Long bound (Object val) {
+    	if (type == FieldType.FLOAT32)
+    		return ((Number) val).longValue();
 
     	long num = 0;
     	if (isNumeric())
     		num = ((Number) val).longValue();
 
+    	return bound(num);
+    }
+
+    private long bound (long num) {
     	switch(type) {
     	case INT8:
     		if(num < Byte.MIN_VALUE)
@@ -703,11 +576,15 @@ public class UAVObjectField {
     		if(num > 255)
     			return (long) 255;
     		return num;
-    	case FLOAT32:
-    		return ((Number) val).longValue();
     	case ENUM:
+    		if(num < 0)
+    			return 0;
+    		if(num > 255)
+    			return 255;
+    		return num;
+    	case FLOAT32:
     	case STRING:
-    		return 0L;
+    		return num;
     	}
 
     	return num;
@@ -720,7 +597,9 @@ public class UAVObjectField {
     			new ArrayList<String>(elementNames),
     			new ArrayList<String>(options));
     	newField.initialize(obj);
-    	newField.data = data;
+    	newField.intData = intData;
+    	newField.longData = longData;
+    	newField.floatData = floatData;
 		return newField;
     }
 
@@ -733,6 +612,8 @@ public class UAVObjectField {
     private int numBytesPerElement;
     private int offset;
     private UAVObject obj;
-    protected Object data;
+    private int[] intData;
+    private long[] longData;
+    private float[] floatData;
 
 }
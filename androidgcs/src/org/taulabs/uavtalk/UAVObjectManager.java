@@ -26,6 +26,7 @@
 package org.taulabs.uavtalk;
 
 import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
 import java.util.ListIterator;
 import java.util.Observable;
@@ -65,6 +66,9 @@ public class UAVObjectManager {
 
 	// Use array list to store objects since rarely added or deleted
 	private final List<List<UAVObject>> objects = new ArrayList<List<UAVObject>>();
+	// The same instance lists indexed for the lookups done on every packet
+	private final HashMap<Long, List<UAVObject>> objectsById = new HashMap<Long, List<UAVObject>>();
+	private final HashMap<String, List<UAVObject>> objectsByName = new HashMap<String, List<UAVObject>>();
 
 	public UAVObjectManager()
 	{
@@ -81,90 +85,85 @@ public class UAVObjectManager {
 	public synchronized boolean registerObject(UAVDataObject obj) throws Exception
 	{
 
-		ListIterator<List<UAVObject>> objIt = objects.listIterator(0);
-
 		// Check if this object type is already in the list
-		while(objIt.hasNext()) {
-			List<UAVObject> instList = objIt.next();
+		List<UAVObject> instList = objectsById.get(obj.getObjID());
 
-			// Check if the object ID is in the list
-			if( (instList.size() > 0) && (instList.get(0).getObjID() == obj.getObjID() )) {
-				// Check if this is a single instance object, if yes we can not add a new instance
-				if(obj.isSingleInstance()) {
-					return false;
-				}
-				// The object type has alredy been added, so now we need to initialize the new instance with the appropriate id
-				// There is a single metaobject for all object instances of this type, so no need to create a new one
-				// Get object type metaobject from existing instance
-				UAVDataObject refObj = (UAVDataObject) instList.get(0);
-				if (refObj == null)
-				{
-					return false;
-				}
-				UAVMetaObject mobj = refObj.getMetaObject();
+		// Check if the object ID is in the list
+		if( (instList != null) && (instList.size() > 0) ) {
+			// Check if this is a single instance object, if yes we can not add a new instance
+			if(obj.isSingleInstance()) {
+				return false;
+			}
+			// The object type has alredy been added, so now we need to initialize the new instance with the appropriate id
+			// There is a single metaobject for all object instances of this type, so no need to create a new one
+			// Get object type metaobject from existing instance
+			UAVDataObject refObj = (UAVDataObject) instList.get(0);
+			if (refObj == null)
+			{
+				return false;
+			}
+			UAVMetaObject mobj = refObj.getMetaObject();
 
-				// Make sure we aren't requesting to create too many instances
-				if(obj.getInstID() >= MAX_INSTANCES || instList.size() >= MAX_INSTANCES || obj.getInstID() < 0) {
-					return false;
-				}
+			// Make sure we aren't requesting to create too many instances
+			if(obj.getInstID() >= MAX_INSTANCES || instList.size() >= MAX_INSTANCES || obj.getInstID() < 0) {
+				return false;
+			}
 
-				// If InstID is zero then we find the next open instId and create it
-				if (obj.getInstID() == 0)
-				{
-					// Assign the next available ID and initialize the object instance the nadd
-					obj.initialize(instList.size(), mobj);
-					instList.add(obj);
-					return true;
-				}
+			// If InstID is zero then we find the next open instId and create it
+			if (obj.getInstID() == 0)
+			{
+				// Assign the next available ID and initialize the object instance the nadd
+				obj.initialize(instList.size(), mobj);
+				instList.add(obj);
+				return true;
+			}
 
-				// Check if that inst ID already exists
-				ListIterator<UAVObject> instIter = instList.listIterator();
-				while(instIter.hasNext()) {
-					UAVObject testObj = instIter.next();
-					if(testObj.getInstID() == obj.getInstID()) {
-						return false;
-					}
+			// Check if that inst ID already exists
+			ListIterator<UAVObject> instIter = instList.listIterator();
+			while(instIter.hasNext()) {
+				UAVObject testObj = instIter.next();
+				if(testObj.getInstID() == obj.getInstID()) {
+					return false;
 				}
+			}
 
-				// If the instance ID is specified and not at the default value (0) then we need to make sure
-				// that there are no gaps in the instance list. If gaps are found then then additional instances
-				// will be created.
-				for(long instId = instList.size(); instId < obj.getInstID(); instId++) {
-					UAVDataObject newObj = obj.clone(instId);
-					newObj.initialize(mobj);
-					instList.add(newObj);
-					newInstance.event(newObj);
-				}
-				obj.initialize(mobj);
-				instList.add(obj);
-				newInstance.event(obj);
-
-				instIter = instList.listIterator();
-				while(instIter.hasNext()) {
-					UAVObject testObj = instIter.next();
-					if(testObj.getInstID() == obj.getInstID()) {
-						return false;
-					}
+			// If the instance ID is specified and not at the default value (0) then we need to make sure
+			// that there are no gaps in the instance list. If gaps are found then then additional instances
+			// will be created.
+			for(long instId = instList.size(); instId < obj.getInstID(); instId++) {
+				UAVDataObject newObj = obj.clone(instId);
+				newObj.initialize(mobj);
+				instList.add(newObj);
+				newInstance.event(newObj);
+			}
+			obj.initialize(mobj);
+			instList.add(obj);
+			newInstance.event(obj);
+
+			instIter = instList.listIterator();
+			while(instIter.hasNext()) {
+				UAVObject testObj = instIter.next();
+				if(testObj.getInstID() == obj.getInstID()) {
+					return false;
 				}
+			}
 
 
-				// Check if there are any gaps between the requested instance ID and the ones in the list,
-				// if any then create the missing instances.
-				for (long instId = instList.size(); instId < obj.getInstID(); ++instId)
-				{
-					UAVDataObject cobj = obj.clone(instId);
-					cobj.initialize(mobj);
-					instList.add(cobj);
-					newInstance.event(cobj);
-				}
-				// Finally, initialize the actual object instance
-				obj.initialize(mobj);
-				// Add the actual object instance in the list
-				instList.add(obj);
-				newInstance.event(obj);
-				return true;
+			// Check if there are any gaps between the requested instance ID and the ones in the list,
+			// if any then create the missing instances.
+			for (long instId = instList.size(); instId < obj.getInstID(); ++instId)
+			{
+				UAVDataObject cobj = obj.clone(instId);
+				cobj.initialize(mobj);
+				instList.add(cobj);
+				newInstance.event(cobj);
 			}
-
+			// Finally, initialize the actual object instance
+			obj.initialize(mobj);
+			// Add the actual object instance in the list
+			instList.add(obj);
+			newInstance.event(obj);
+			return true;
 		}
 
 		// If this point is reached then this is the first time this object type (ID) is added in the list
@@ -188,6 +187,8 @@ public class UAVObjectManager {
 		List<UAVObject> ls = new ArrayList<UAVObject>();
 		ls.add(obj);
 		objects.add(ls);
+		objectsById.put(obj.getObjID(), ls);
+		objectsByName.put(obj.getName(), ls);
 		newObject.event(obj);
 	}
 
@@ -310,21 +311,23 @@ public class UAVObjectManager {
 	 */
 	public synchronized UAVObject getObject(String name, long objId, long instId)
 	{
-		// Check if this object type is already in the list
-		ListIterator<List<UAVObject>> objIter = objects.listIterator();
-		while(objIter.hasNext()) {
-			List<UAVObject> instList = objIter.next();
-			if (instList.size() > 0) {
-				if ( (name != null && instList.get(0).getName().compareTo(name) == 0) || (name == null && instList.get(0).getObjID() == objId) ) {
-					// Look for the requested instance ID
-					ListIterator<UAVObject> iter = instList.listIterator();
-					while(iter.hasNext()) {
-						UAVObject obj = iter.next();
-						if(obj.getInstID() == instId) {
-							return obj;
-						}
-					}
-				}
+		List<UAVObject> instList = getObjectInstances(name, objId);
+		if (instList == null)
+			return null;
+
+		// Instances are added in order so the ID is normally the index
+		if (instId >= 0 && instId < instList.size()) {
+			UAVObject obj = instList.get((int) instId);
+			if (obj.getInstID() == instId)
+				return obj;
+		}
+
+		// Look for the requested instance ID
+		ListIterator<UAVObject> iter = instList.listIterator();
+		while(iter.hasNext()) {
+			UAVObject obj = iter.next();
+			if(obj.getInstID() == instId) {
+				return obj;
 			}
 		}
 
@@ -352,18 +355,9 @@ public class UAVObjectManager {
 	 */
 	public synchronized List<UAVObject> getObjectInstances(String name, long objId)
 	{
-		// Check if this object type is already in the list
-		ListIterator<List<UAVObject>> objIter = objects.listIterator();
-		while(objIter.hasNext()) {
-			List<UAVObject> instList = objIter.next();
-			if (instList.size() > 0) {
-				if ( (name != null && instList.get(0).getName().compareTo(name) == 0) || (name == null && instList.get(0).getObjID() == objId) ) {
-					return instList;
-				}
-			}
-		}
-
-		return null;
+		if (name != null)
+			return objectsByName.get(name);
+		return objectsById.get(objId);
 	}
 
 	/**
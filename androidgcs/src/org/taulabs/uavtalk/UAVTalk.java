@@ -31,6 +31,9 @@ import java.io.InputStream;
 import java.io.OutputStream;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
+import java.util.List;
+import java.util.Observable;
+import java.util.Observer;
 
 import junit.framework.Assert;
 import android.util.Log;
@@ -115,6 +118,17 @@ public class UAVTalk {
 	//! Packet is an ack for an object
 	static final int TYPE_ACK = (TYPE_VER | 0x03);
 	static final int TYPE_NACK = (TYPE_VER | 0x04);
+	//! Packet carries the changed chunks of a single instance object
+	static final int TYPE_OBJ_DELTA = (TYPE_VER | 0x05);
+	//! Packet carries several small single instance objects
+	static final int TYPE_OBJ_BUNDLE = (TYPE_VER | 0x06);
+
+	//! Every object in a bundle follows its id (4) and its size (1)
+	static final int BUNDLE_ENTRY_LENGTH = 5;
+	//! Deltas start with the mask of the chunks that follow
+	static final int DELTA_MASK_LENGTH = 4;
+	//! Objects are split into up to this many chunks for deltas
+	static final int DELTA_CHUNKS = 32;
 
 	static final int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2),
 											// object ID(4)
@@ -131,6 +145,8 @@ public class UAVTalk {
 
 	static final int ALL_INSTANCES = 0xFFFF;
 	static final int TX_BUFFER_SIZE = 2 * 1024;
+	//! Bytes taken from the input stream with each read
+	static final int RX_BUFFER_SIZE = 1024;
 
 	/**
 	 * Private data
@@ -148,6 +164,8 @@ public class UAVTalk {
 	int respType;
 
 	// Variables used by the receive state machine
+	private final Object rxLock = new Object();
+	byte[] rxReadBuffer;
 	ByteBuffer rxTmpBuffer /* 4 */;
 	ByteBuffer rxBuffer;
 	int rxType;
@@ -162,6 +180,17 @@ public class UAVTalk {
 	RxStateType rxState;
 	ComStats stats = new ComStats();
 
+	//! Packet being transmitted, reused for every packet and locked while in use
+	private final ByteBuffer txBuffer;
+	//! Object a delta is merged into before it is unpacked
+	private final ByteBuffer deltaBuffer;
+
+	//! Handle of the native decoder, 0 when the Java state machine is used
+	private long nativeDecoder = 0;
+	private ByteBuffer nativeIn;
+	private ByteBuffer nativeOut;
+	private int nativeRxErrors;
+
 	/**
 	 * Comm stats
 	 */
@@ -196,11 +225,58 @@ public class UAVTalk {
 		rxTmpBuffer.order(ByteOrder.LITTLE_ENDIAN);
 		rxBuffer = ByteBuffer.allocate(MAX_PAYLOAD_LENGTH);
 		rxBuffer.order(ByteOrder.LITTLE_ENDIAN);
+		rxReadBuffer = new byte[RX_BUFFER_SIZE];
+		txBuffer = ByteBuffer.allocate(MAX_PACKET_LENGTH);
+		txBuffer.order(ByteOrder.LITTLE_ENDIAN);
+		deltaBuffer = ByteBuffer.allocate(MAX_PAYLOAD_LENGTH);
+		deltaBuffer.order(ByteOrder.LITTLE_ENDIAN);
+
+		if (UAVTalkNative.isAvailable())
+			setupNativeDecoder();
 
 		// TOOD: Callback connect(io, SIGNAL(readyRead()), this,
 		// SLOT(processInputStream()));
 	}
 
+	/**
+	 * Create the native decoder and give it the length of every object
+	 * so it can find the packets without calling back into Java
+	 */
+	private void setupNativeDecoder() {
+		nativeDecoder = UAVTalkNative.create();
+		if (nativeDecoder == 0)
+			return;
+
+		nativeIn = ByteBuffer.allocateDirect(RX_BUFFER_SIZE);
+		// Room for the decoded packets of one read and the one it completes
+		nativeOut = ByteBuffer.allocateDirect(2 * (RX_BUFFER_SIZE + MAX_PACKET_LENGTH));
+		nativeOut.order(ByteOrder.LITTLE_ENDIAN);
+
+		synchronized(objMngr) {
+			for (List<UAVObject> instances : objMngr.getObjects())
+				registerNativeObject(instances.get(0));
+		}
+
+		objMngr.addNewObjectObserver(new Observer() {
+			@Override
+			public void update(Observable observable, Object data) {
+				registerNativeObject((UAVObject) data);
+			}
+		});
+	}
+
+	private void registerNativeObject(UAVObject obj) {
+		if (!UAVTalkNative.registerObject(nativeDecoder, (int) obj.getObjID(), obj.getNumBytes(), obj.isSingleInstance()))
+			if (ERROR) Log.e(TAG, "Native decoder object table full");
+	}
+
+	@Override
+	protected void finalize() throws Throwable {
+		if (nativeDecoder != 0)
+			UAVTalkNative.destroy(nativeDecoder);
+		super.finalize();
+	}
+
 	/**
 	 * Reset the statistics counters
 	 */
@@ -218,23 +294,66 @@ public class UAVTalk {
 	}
 
 	/**
-	 * Process any data in the queue
+	 * Process any data in the queue.  Blocks until the stream has some data
+	 * and then takes as much of it as is available in one read.
+	 * @return False if the stream has ended
 	 * @throws IOException
 	 */
 	public boolean processInputStream() throws IOException {
-		int val;
-
-		//inStream.wait();
-		val = inStream.read();
+		int len = inStream.read(rxReadBuffer, 0, rxReadBuffer.length);
 
-		if (VERBOSE) Log.v(TAG, "Read: " + val);
+		if (VERBOSE) Log.v(TAG, "Read: " + len + " bytes");
 
-		if (val == -1) {
+		if (len == -1) {
 			return false;
 		}
 
-		 processInputByte(val);
-		 return true;
+		if (nativeDecoder != 0)
+			processNativeBytes(rxReadBuffer, 0, len);
+		else
+			processInputBytes(rxReadBuffer, 0, len);
+		return true;
+	}
+
+	/**
+	 * Pass a block of the stream to the native decoder and handle the
+	 * packets it completed.  Length must not exceed RX_BUFFER_SIZE.
+	 * @throws IOException
+	 */
+	private void processNativeBytes(byte[] data, int offset, int length) throws IOException {
+		synchronized(rxLock) {
+			stats.rxBytes += length;
+
+			nativeIn.clear();
+			nativeIn.put(data, offset, length);
+			int decoded = UAVTalkNative.process(nativeDecoder, nativeIn, length, nativeOut);
+
+			int errors = UAVTalkNative.getRxErrors(nativeDecoder);
+			stats.rxErrors += errors - nativeRxErrors;
+			nativeRxErrors = errors;
+
+			final int HEADER = UAVTalkNative.FRAME_HEADER_LENGTH;
+			int pos = 0;
+			while (pos + HEADER <= decoded) {
+				int type = nativeOut.get(pos) & 0xff;
+				int payloadLength = nativeOut.getShort(pos + 2) & 0xffff;
+				long objId = nativeOut.getInt(pos + 4) & 0xffffffffL;
+				long instId = nativeOut.getShort(pos + 8) & 0xffff;
+
+				// Unpack straight out of the direct buffer
+				nativeOut.limit(pos + HEADER + payloadLength);
+				nativeOut.position(pos + HEADER);
+				try {
+					receiveObject(type, objId, instId, nativeOut);
+				} finally {
+					nativeOut.clear();
+				}
+
+				stats.rxObjectBytes += payloadLength;
+				stats.rxObjects++;
+				pos += HEADER + payloadLength;
+			}
+		}
 	}
 
 
@@ -334,211 +453,288 @@ public class UAVTalk {
 	public boolean processInputByte(int rxbyte) throws IOException {
 		Assert.assertNotNull(objMngr);
 
-		// Only need to synchronize this method on the state machine state
-		synchronized(rxState) {
-			// Update stats
+		synchronized(rxLock) {
 			stats.rxBytes++;
+			processRxByte(rxbyte);
+		}
 
-			rxPacketLength++; // update packet byte count
+		return true;
+	}
+
+	/**
+	 * Process a block of bytes from the telemetry stream.  The noise between
+	 * packets and the payloads are handled a run at a time, only the header
+	 * and checksum go through the state machine byte by byte.
+	 * @param[in] data Buffer holding the received bytes
+	 * @param[in] offset Index of the first byte to process
+	 * @param[in] length Number of bytes to process
+	 * @throws IOException
+	 */
+	public void processInputBytes(byte[] data, int offset, int length) throws IOException {
+		Assert.assertNotNull(objMngr);
 
-			// Receive state machine
-			switch (rxState) {
-			case STATE_SYNC:
+		synchronized(rxLock) {
+			stats.rxBytes += length;
+
+			final int end = offset + length;
+			int i = offset;
+			while (i < end) {
+				switch (rxState) {
+				case STATE_SYNC:
+					// Skip everything up to the next sync byte
+					while (i < end && (data[i] & 0xff) != SYNC_VAL)
+						i++;
+					if (i < end)
+						processRxByte(data[i++] & 0xff);
+					break;
 
-				if (rxbyte != SYNC_VAL)
+				case STATE_DATA:
+					// Copy as much of the payload as this block holds
+					int n = Math.min(end - i, rxLength - rxCount);
+					System.arraycopy(data, i, rxBuffer.array(), rxCount, n);
+					rxCS = updateCRC(rxCS, data, i, n);
+					rxCount += n;
+					rxPacketLength += n;
+					i += n;
+
+					if (rxCount >= rxLength) {
+						rxState = RxStateType.STATE_CS;
+						rxCount = 0;
+					}
 					break;
 
-				// Initialize and update CRC
-				rxCS = updateCRC(0, rxbyte);
+				default:
+					processRxByte(data[i++] & 0xff);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Run the receive state machine on one byte.  The caller holds rxLock.
+	 * @throws IOException
+	 */
+	private void processRxByte(int rxbyte) throws IOException {
+		rxPacketLength++; // update packet byte count
 
-				rxPacketLength = 1;
+		// Receive state machine
+		switch (rxState) {
+		case STATE_SYNC:
 
-				rxState = RxStateType.STATE_TYPE;
+			if (rxbyte != SYNC_VAL)
 				break;
 
-			case STATE_TYPE:
+			// Initialize and update CRC
+			rxCS = updateCRC(0, rxbyte);
 
-				// Update CRC
-				rxCS = updateCRC(rxCS, rxbyte);
+			rxPacketLength = 1;
 
-				if ((rxbyte & TYPE_MASK) != TYPE_VER) {
-					if (ERROR) Log.e(TAG, "Unknown UAVTalk type:" + rxbyte);
-					rxState = RxStateType.STATE_SYNC;
-					break;
-				}
+			rxState = RxStateType.STATE_TYPE;
+			break;
 
-				rxType = rxbyte;
-				if (VERBOSE) Log.v(TAG, "Received packet type: " + rxType);
-				packetSize = 0;
+		case STATE_TYPE:
 
-				rxState = RxStateType.STATE_SIZE;
-				rxCount = 0;
-				break;
+			// Update CRC
+			rxCS = updateCRC(rxCS, rxbyte);
 
-			case STATE_SIZE:
+			if ((rxbyte & TYPE_MASK) != TYPE_VER) {
+				if (ERROR) Log.e(TAG, "Unknown UAVTalk type:" + rxbyte);
+				rxState = RxStateType.STATE_SYNC;
+				break;
+			}
 
-				// Update CRC
-				rxCS = updateCRC(rxCS, rxbyte);
+			rxType = rxbyte;
+			if (VERBOSE) Log.v(TAG, "Received packet type: " + rxType);
+			packetSize = 0;
 
-				if (rxCount == 0) {
-					packetSize += rxbyte;
-					rxCount++;
-					break;
-				}
+			rxState = RxStateType.STATE_SIZE;
+			rxCount = 0;
+			break;
 
-				packetSize += (rxbyte << 8) & 0xff00;
+		case STATE_SIZE:
 
-				if (packetSize < MIN_HEADER_LENGTH
-						|| packetSize > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH) { // incorrect
-					// packet
-					// size
-					rxState = RxStateType.STATE_SYNC;
-					break;
-				}
+			// Update CRC
+			rxCS = updateCRC(rxCS, rxbyte);
 
-				rxCount = 0;
-				rxState = RxStateType.STATE_OBJID;
-				rxTmpBuffer.position(0);
+			if (rxCount == 0) {
+				packetSize += rxbyte;
+				rxCount++;
 				break;
+			}
 
-			case STATE_OBJID:
+			packetSize += (rxbyte << 8) & 0xff00;
 
-				// Update CRC
-				rxCS = updateCRC(rxCS, rxbyte);
+			if (packetSize < MIN_HEADER_LENGTH
+					|| packetSize > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH) { // incorrect
+				// packet
+				// size
+				rxState = RxStateType.STATE_SYNC;
+				break;
+			}
 
-				rxTmpBuffer.put(rxCount++, (byte) (rxbyte & 0xff));
-				if (rxCount < 4)
-					break;
+			rxCount = 0;
+			rxState = RxStateType.STATE_OBJID;
+			rxTmpBuffer.position(0);
+			break;
 
-				// Search for object, if not found reset state machine
-				rxObjId = rxTmpBuffer.getInt(0);
-				// Because java treats ints as only signed we need to do this manually
-				if (rxObjId < 0)
-					rxObjId = 0x100000000l + rxObjId;
-				{
-					UAVObject rxObj = objMngr.getObject(rxObjId);
-					if (rxObj == null) {
-						if (WARN) Log.w(TAG, "Unknown ID: " + rxObjId);
-						stats.rxErrors++;
-						rxState = RxStateType.STATE_SYNC;
-						break;
-					}
+		case STATE_OBJID:
 
-					// Determine data length
-					if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK)
-						rxLength = 0;
-					else
-						rxLength = rxObj.getNumBytes();
-
-					// Check length and determine next state
-					if (rxLength >= MAX_PAYLOAD_LENGTH) {
-						if (WARN) Log.w(TAG, "Greater than max payload length");
-						stats.rxErrors++;
-						rxState = RxStateType.STATE_SYNC;
-						break;
-					}
+			// Update CRC
+			rxCS = updateCRC(rxCS, rxbyte);
 
-	                // Check the lengths match
-	                if ((rxPacketLength + (rxObj.isSingleInstance() ? 0 : 2) + rxLength) != packetSize)
-	                {   // packet error - mismatched packet size
-	                    if (WARN) Log.w(TAG, "Packet size does not match what it should");
-	                    stats.rxErrors++;
-	                    rxState = RxStateType.STATE_SYNC;
-	                    break;
-	                }
-
-					// Check if this is a single instance object (i.e. if the
-					// instance ID field is coming next)
-					if (rxObj.isSingleInstance()) {
-						// If there is a payload get it, otherwise receive checksum
-						if (rxLength > 0)
-							rxState = RxStateType.STATE_DATA;
-						else
-							rxState = RxStateType.STATE_CS;
-						rxInstId = 0;
-						rxCount = 0;
-					} else {
-						rxState = RxStateType.STATE_INSTID;
-						rxCount = 0;
-					}
+			rxTmpBuffer.put(rxCount++, (byte) (rxbyte & 0xff));
+			if (rxCount < 4)
+				break;
+
+			// Search for object, if not found reset state machine
+			rxObjId = rxTmpBuffer.getInt(0);
+			// Because java treats ints as only signed we need to do this manually
+			if (rxObjId < 0)
+				rxObjId = 0x100000000l + rxObjId;
+
+			if (rxType == TYPE_OBJ_BUNDLE) {
+				// Bundles carry the ids of their objects in the payload
+				rxLength = packetSize - rxPacketLength;
+				if (rxLength >= MAX_PAYLOAD_LENGTH) {
+					if (WARN) Log.w(TAG, "Greater than max payload length");
+					stats.rxErrors++;
+					rxState = RxStateType.STATE_SYNC;
+					break;
 				}
 
+				rxState = (rxLength > 0) ? RxStateType.STATE_DATA : RxStateType.STATE_CS;
+				rxInstId = 0;
+				rxCount = 0;
 				break;
+			}
 
-			case STATE_INSTID:
+			{
+				UAVObject rxObj = objMngr.getObject(rxObjId);
+				if (rxObj == null) {
+					if (WARN) Log.w(TAG, "Unknown ID: " + rxObjId);
+					stats.rxErrors++;
+					rxState = RxStateType.STATE_SYNC;
+					break;
+				}
 
-				// Update CRC
-				rxCS = updateCRC(rxCS, rxbyte);
+				// Determine data length
+				if (rxType == TYPE_OBJ_REQ || rxType == TYPE_ACK || rxType == TYPE_NACK)
+					rxLength = 0;
+				else if (rxType == TYPE_OBJ_DELTA && rxObj.isSingleInstance())
+					rxLength = packetSize - rxPacketLength;
+				else
+					rxLength = rxObj.getNumBytes();
 
-				rxTmpBuffer.put(rxCount++, (byte) (rxbyte & 0xff));
-				if (rxCount < 2)
+				// Check length and determine next state
+				if (rxLength >= MAX_PAYLOAD_LENGTH) {
+					if (WARN) Log.w(TAG, "Greater than max payload length");
+					stats.rxErrors++;
+					rxState = RxStateType.STATE_SYNC;
 					break;
+				}
 
-				rxInstId = rxTmpBuffer.getShort(0);
+                // Check the lengths match
+                if ((rxPacketLength + (rxObj.isSingleInstance() ? 0 : 2) + rxLength) != packetSize)
+                {   // packet error - mismatched packet size
+                    if (WARN) Log.w(TAG, "Packet size does not match what it should");
+                    stats.rxErrors++;
+                    rxState = RxStateType.STATE_SYNC;
+                    break;
+                }
+
+				// Check if this is a single instance object (i.e. if the
+				// instance ID field is coming next)
+				if (rxObj.isSingleInstance()) {
+					// If there is a payload get it, otherwise receive checksum
+					if (rxLength > 0)
+						rxState = RxStateType.STATE_DATA;
+					else
+						rxState = RxStateType.STATE_CS;
+					rxInstId = 0;
+					rxCount = 0;
+				} else {
+					rxState = RxStateType.STATE_INSTID;
+					rxCount = 0;
+				}
+			}
 
-				rxCount = 0;
+			break;
 
-				// If there is a payload get it, otherwise receive checksum
-				if (rxLength > 0)
-					rxState = RxStateType.STATE_DATA;
-				else
-					rxState = RxStateType.STATE_CS;
+		case STATE_INSTID:
 
-				break;
+			// Update CRC
+			rxCS = updateCRC(rxCS, rxbyte);
 
-			case STATE_DATA:
+			rxTmpBuffer.put(rxCount++, (byte) (rxbyte & 0xff));
+			if (rxCount < 2)
+				break;
 
-				// Update CRC
-				rxCS = updateCRC(rxCS, rxbyte);
+			rxInstId = rxTmpBuffer.getShort(0);
 
-				rxBuffer.put(rxCount++, (byte) (rxbyte & 0xff));
-				if (rxCount < rxLength)
-					break;
+			rxCount = 0;
 
+			// If there is a payload get it, otherwise receive checksum
+			if (rxLength > 0)
+				rxState = RxStateType.STATE_DATA;
+			else
 				rxState = RxStateType.STATE_CS;
-				rxCount = 0;
-				break;
 
-			case STATE_CS:
+			break;
 
-				// The CRC byte
-				rxCSPacket = rxbyte;
+		case STATE_DATA:
 
-				if (rxCS != rxCSPacket) { // packet error - faulty CRC
-					if (WARN) Log.w(TAG,"Bad crc");
-					stats.rxErrors++;
-					rxState = RxStateType.STATE_SYNC;
-					break;
-				}
+			// Update CRC
+			rxCS = updateCRC(rxCS, rxbyte);
 
-				if (rxPacketLength != (packetSize + 1)) { // packet error -
-					// mismatched packet
-					// size
-					if (WARN) Log.w(TAG,"Bad size");
-					stats.rxErrors++;
-					rxState = RxStateType.STATE_SYNC;
-					break;
-				}
+			rxBuffer.put(rxCount++, (byte) (rxbyte & 0xff));
+			if (rxCount < rxLength)
+				break;
 
-				if (DEBUG) Log.d(TAG,"Received");
+			rxState = RxStateType.STATE_CS;
+			rxCount = 0;
+			break;
 
-				rxBuffer.position(0);
-				receiveObject(rxType, rxObjId, rxInstId, rxBuffer);
-				stats.rxObjectBytes += rxLength;
-				stats.rxObjects++;
+		case STATE_CS:
 
+			// The CRC byte
+			rxCSPacket = rxbyte;
+
+			if (rxCS != rxCSPacket) { // packet error - faulty CRC
+				if (WARN) Log.w(TAG,"Bad crc");
+				stats.rxErrors++;
 				rxState = RxStateType.STATE_SYNC;
 				break;
+			}
 
-			default:
-				if (WARN) Log.w(TAG, "Bad state");
-				rxState = RxStateType.STATE_SYNC;
+			if (rxPacketLength != (packetSize + 1)) { // packet error -
+				// mismatched packet
+				// size
+				if (WARN) Log.w(TAG,"Bad size");
 				stats.rxErrors++;
+				rxState = RxStateType.STATE_SYNC;
+				break;
 			}
-		}
 
-		// Done
-		return true;
+			if (DEBUG) Log.d(TAG,"Received");
+
+			rxBuffer.limit(rxLength);
+			rxBuffer.position(0);
+			try {
+				receiveObject(rxType, rxObjId, rxInstId, rxBuffer);
+			} finally {
+				rxBuffer.clear();
+			}
+			stats.rxObjectBytes += rxLength;
+			stats.rxObjects++;
+
+			rxState = RxStateType.STATE_SYNC;
+			break;
+
+		default:
+			if (WARN) Log.w(TAG, "Bad state");
+			rxState = RxStateType.STATE_SYNC;
+			stats.rxErrors++;
+		}
 	}
 
 	/**
@@ -612,6 +808,15 @@ public class UAVTalk {
 				error = true;
 			}
 			break;
+		case TYPE_OBJ_DELTA:
+			// Only the changed chunks of a single instance object
+			obj = updateObjectDelta(objId, data);
+			error = (obj == null);
+			break;
+		case TYPE_OBJ_BUNDLE:
+			// Several small objects in one packet
+			error = !updateObjectBundle(data);
+			break;
 	    case TYPE_NACK:
         	if (DEBUG) Log.d(TAG, "Received NAK: " + objId + " " + objMngr.getObject(objId).getName());
         	// All instances, not allowed for NACK messages
@@ -700,6 +905,82 @@ public class UAVTalk {
 		}
 	}
 
+	/**
+	 * Merge the chunks of a delta into the current data of the object and
+	 * unpack the result
+	 * @param data The delta payload, from its position to its limit
+	 * @return The updated object or null if the delta does not match it
+	 */
+	private synchronized UAVObject updateObjectDelta(long objId, ByteBuffer data) {
+		UAVObject obj = objMngr.getObject(objId);
+		int start = data.position();
+		int length = data.remaining();
+		if (obj == null || !obj.isSingleInstance() || length < DELTA_MASK_LENGTH)
+			return null;
+
+		int numBytes = obj.getNumBytes();
+		int chunk = (numBytes + DELTA_CHUNKS - 1) / DELTA_CHUNKS;
+		data.order(ByteOrder.LITTLE_ENDIAN);
+		long mask = data.getInt(start) & 0xffffffffL;
+
+		deltaBuffer.clear();
+		try {
+			obj.pack(deltaBuffer);
+		} catch (Exception e) {
+			return null;
+		}
+
+		int in = DELTA_MASK_LENGTH;
+		for (int i = 0, pos = 0; pos < numBytes; i++, pos += chunk) {
+			if ((mask & (1L << i)) != 0) {
+				int size = Math.min(chunk, numBytes - pos);
+				if (in + size > length)
+					return null;
+				for (int k = 0; k < size; k++)
+					deltaBuffer.put(pos + k, data.get(start + in + k));
+				in += size;
+			}
+		}
+		if (in != length)
+			return null;
+
+		deltaBuffer.position(0);
+		obj.unpack(deltaBuffer);
+		return obj;
+	}
+
+	/**
+	 * Unpack the objects of a bundle.  Every object follows its id and its
+	 * size so objects that are not known here can be skipped.
+	 * @param data The bundle payload, from its position to its limit
+	 * @return False if the bundle is malformed or an object was skipped
+	 */
+	private boolean updateObjectBundle(ByteBuffer data) {
+		boolean ok = true;
+		final int end = data.limit();
+		int pos = data.position();
+
+		data.order(ByteOrder.LITTLE_ENDIAN);
+		while (pos + BUNDLE_ENTRY_LENGTH <= end) {
+			long objId = data.getInt(pos) & 0xffffffffL;
+			int size = data.get(pos + 4) & 0xff;
+			pos += BUNDLE_ENTRY_LENGTH;
+			if (pos + size > end)
+				return false;
+
+			UAVObject obj = objMngr.getObject(objId);
+			if (obj != null && obj.isSingleInstance() && obj.getNumBytes() == size) {
+				data.position(pos);
+				obj.unpack(data);
+			} else {
+				ok = false;
+			}
+			pos += size;
+		}
+
+		return ok && pos == end;
+	}
+
 	/**
 	 * Called when an object is received to check if this completes
 	 * a UAVTalk transaction
@@ -827,9 +1108,6 @@ public class UAVTalk {
 
 		assert (objMngr != null && outStream != null);
 
-		ByteBuffer bbuf = ByteBuffer.allocate(MAX_PACKET_LENGTH);
-		bbuf.order(ByteOrder.LITTLE_ENDIAN);
-
 		// Determine data length
 		if (type == TYPE_OBJ_REQ || type == TYPE_ACK) {
 			length = 0;
@@ -837,57 +1115,59 @@ public class UAVTalk {
 			length = obj.getNumBytes();
 		}
 
-		// Setup type and object id fields
-		bbuf.put((byte) (SYNC_VAL & 0xff));
-		bbuf.put((byte) (type & 0xff));
-		bbuf.putShort((short) (length + 2 /* SYNC, Type */+ 2 /* Size */+ 4 /* ObjID */+ (obj
-						.isSingleInstance() ? 0 : 2)));
-		bbuf.putInt((int)obj.getObjID());
-
-		// Setup instance ID if one is required
-		if (!obj.isSingleInstance()) {
-			// Check if all instances are requested
-			if (allInstances)
-				bbuf.putShort((short) (allInstId & 0xffff));
-			else
-				bbuf.putShort((short) (obj.getInstID() & 0xffff));
-		}
-
 		// Check length
 		if (length >= MAX_PAYLOAD_LENGTH)
 			return false;
 
-		// Copy data (if any)
-		if (length > 0)
-			try {
-				if (obj.pack(bbuf) == 0)
-					return false;
-			} catch (Exception e) {
-				// TODO Auto-generated catch block
-				e.printStackTrace();
-				return false;
-			}
-
-		// Calculate checksum
-		bbuf.put((byte) (updateCRC(0, bbuf.array(), bbuf.position()) & 0xff));
-
-		int packlen = bbuf.position();
-		bbuf.position(0);
-		byte[] dst = new byte[packlen];
-		bbuf.get(dst, 0, packlen);
-
 		if (type == TYPE_OBJ_ACK || type == TYPE_OBJ_REQ) {
 			// Once we send a UAVTalk packet that requires an ack or object let's set up
-			// the transaction here
+			// the transaction here.  This is done before taking the transmit buffer
+			// because the listeners may send from inside a transaction callback.
 			setupTransaction(obj, allInstances, type);
 		}
 
-		outStream.write(dst);
+		int packlen;
+		synchronized(txBuffer) {
+			ByteBuffer bbuf = txBuffer;
+			bbuf.clear();
+
+			// Setup type and object id fields
+			bbuf.put((byte) (SYNC_VAL & 0xff));
+			bbuf.put((byte) (type & 0xff));
+			bbuf.putShort((short) (length + 2 /* SYNC, Type */+ 2 /* Size */+ 4 /* ObjID */+ (obj
+							.isSingleInstance() ? 0 : 2)));
+			bbuf.putInt((int)obj.getObjID());
+
+			// Setup instance ID if one is required
+			if (!obj.isSingleInstance()) {
+				// Check if all instances are requested
+				if (allInstances)
+					bbuf.putShort((short) (allInstId & 0xffff));
+				else
+					bbuf.putShort((short) (obj.getInstID() & 0xffff));
+			}
 
+			// Copy data (if any)
+			if (length > 0)
+				try {
+					if (obj.pack(bbuf) == 0)
+						return false;
+				} catch (Exception e) {
+					// TODO Auto-generated catch block
+					e.printStackTrace();
+					return false;
+				}
+
+			// Calculate checksum
+			bbuf.put((byte) (updateCRC(0, bbuf.array(), bbuf.position()) & 0xff));
+
+			packlen = bbuf.position();
+			outStream.write(bbuf.array(), 0, packlen);
+		}
 
 		// Update stats
 		++stats.txObjects;
-		stats.txBytes += bbuf.position();
+		stats.txBytes += packlen;
 		stats.txObjectBytes += length;
 
 		// Done
@@ -910,8 +1190,12 @@ public class UAVTalk {
 	}
 
 	int updateCRC(int crc, byte[] data, int length) {
-		for (int i = 0; i < length; i++)
-			crc = updateCRC(crc, data[i]);
+		return updateCRC(crc, data, 0, length);
+	}
+
+	int updateCRC(int crc, byte[] data, int offset, int length) {
+		for (int i = offset; i < offset + length; i++)
+			crc = crc_table[crc ^ (data[i] & 0xff)];
 		return crc;
 	}
 
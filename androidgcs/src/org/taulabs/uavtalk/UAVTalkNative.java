@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @file       UAVTalkNative.java
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Interface to the native UAVTalk decoder.  The packets are found
+ *             and checked in C and handed back as frames in a direct buffer.
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+package org.taulabs.uavtalk;
+
+import java.nio.ByteBuffer;
+
+import android.util.Log;
+
+public class UAVTalkNative {
+
+	private static final String TAG = UAVTalkNative.class.getSimpleName();
+
+	//! Each decoded packet is this header followed by the payload, see uavtalk_scanner.h
+	public static final int FRAME_HEADER_LENGTH = 10;
+
+	private static boolean available = false;
+
+	static {
+		try {
+			System.loadLibrary("uavtalkNativeLib");
+			available = true;
+		} catch (UnsatisfiedLinkError e) {
+			Log.w(TAG, "Native UAVTalk decoder not available, using the Java one");
+		}
+	}
+
+	//! True if the library is loaded and the native methods can be used
+	public static boolean isAvailable() {
+		return available;
+	}
+
+	public static native long		create();
+	public static native void		destroy(long handle);
+	public static native boolean	registerObject(long handle, int objId, int numBytes, boolean singleInstance);
+	public static native int		process(long handle, ByteBuffer in, int length, ByteBuffer out);
+	public static native int		getRxErrors(long handle);
+
+}
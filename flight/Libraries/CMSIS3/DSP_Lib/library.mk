@@ -14,6 +14,11 @@ SRC += $(CMSIS3_DSPLIB_DIR)/Source/ComplexMathFunctions/arm_cmplx_mag_q15.c
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/FastMathFunctions/arm_sqrt_q15.c
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/CommonTables/arm_common_tables.c
 SRC += $(CMSIS3_DSPLIB_DIR)/Source/TransformFunctions/arm_bitreversal.c
+SRC += $(CMSIS3_DSPLIB_DIR)/Source/MatrixFunctions/arm_mat_init_f32.c
+SRC += $(CMSIS3_DSPLIB_DIR)/Source/MatrixFunctions/arm_mat_mult_f32.c
+SRC += $(CMSIS3_DSPLIB_DIR)/Source/BasicMathFunctions/arm_scale_f32.c
+SRC += $(CMSIS3_DSPLIB_DIR)/Source/BasicMathFunctions/arm_dot_prod_f32.c
+SRC += $(CMSIS3_DSPLIB_DIR)/Source/FilteringFunctions/arm_biquad_cascade_df1_f32.c
 endif
 
 EXTRAINCDIRS += $(CMSIS3_DSPLIB_DIR)Include
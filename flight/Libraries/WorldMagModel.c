@@ -22,6 +22,7 @@
  *                - Hard coded coefficients for model
  *                - Elimination of user interface
  *                - Elimination of dynamic memory allocation
+ *                - Coefficients looked up directly and the last field cached
  *
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -61,6 +62,19 @@ static WMMtype_Ellipsoid        Ellip;
 static WMMtype_MagneticModel    MagneticModel;
 static float                    decimal_date;
 
+//! Closer than this to the last position the last field is returned again
+#define WMM_CACHE_MAX_DEG       0.05f   // about 5 km
+#define WMM_CACHE_MAX_ALT_M     500.0f
+
+static struct {
+	bool  valid;
+	float Lat;
+	float Lon;
+	float AltEllipsoid;
+	float decimal_date;
+	float B[3];
+} cache;
+
 /**************************************************************************************
 *   Example use - very simple - only two exposed functions
 *
@@ -70,6 +84,9 @@ static float                    decimal_date;
 *	e.g. Iceland in may of 2012 = WMM_GetMagVector(65.0, -20.0, 0.0, 5, 5, 2012, B);
 *	Alt is above the WGS-84 Ellipsoid
 *	B is the NED (XYZ) magnetic vector in nTesla
+*
+*	The field is cached, asking again on the same day within WMM_CACHE_MAX_DEG
+*	and WMM_CACHE_MAX_ALT_M of the last position is free
 **************************************************************************************/
 
 int WMM_Initialize()
@@ -125,6 +142,23 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
             returned = -6;  // error
     }
 
+    if (returned >= 0)
+    {
+        if (WMM_DateToYear(Month, Day, Year) < 0)
+            returned = -8;  // error
+    }
+
+    if (returned >= 0 && cache.valid && cache.decimal_date == decimal_date &&
+        fabsf(Lat - cache.Lat) < WMM_CACHE_MAX_DEG &&
+        fabsf(Lon - cache.Lon) < WMM_CACHE_MAX_DEG &&
+        fabsf(AltEllipsoid - cache.AltEllipsoid) < WMM_CACHE_MAX_ALT_M)
+    {
+        B[0] = cache.B[0];
+        B[1] = cache.B[1];
+        B[2] = cache.B[2];
+        return 0;
+    }
+
     if (returned >= 0)
     {
         CoordGeodetic.lambda = Lon;
@@ -136,13 +170,6 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
             returned = -7;  // error
     }
 
-
-    if (returned >= 0)
-    {
-        if (WMM_DateToYear(Month, Day, Year) < 0)
-            returned = -8;  // error
-    }
-
     if (returned >= 0)
     {
         // Compute the geoMagnetic field elements and their time change
@@ -160,6 +187,18 @@ int WMM_GetMagVector(float Lat, float Lon, float AltEllipsoid, uint16_t Month, u
 	B[1] = GeoMagneticElements.Y * 1e-2f;
 	B[2] = GeoMagneticElements.Z * 1e-2f;
 
+	if (returned >= 0)
+	{
+		cache.valid = true;
+		cache.Lat = Lat;
+		cache.Lon = Lon;
+		cache.AltEllipsoid = AltEllipsoid;
+		cache.decimal_date = decimal_date;
+		cache.B[0] = B[0];
+		cache.B[1] = B[1];
+		cache.B[2] = B[2];
+	}
+
     return returned;
 }
 
@@ -1013,34 +1052,28 @@ int WMM_SecVarSummationSpecial(WMMtype_SphericalHarmonicVariables *
 /**
  * @brief Comput the MainFieldCoeffH accounting for the date
  */
+/**
+ * Terms index = n * (n + 1) / 2 + m with n from 1 to nMax and m from 0 to n
+ * have a secular variation, up to the degree of the secular model. Index 0
+ * is not used by the model.
+ */
+static bool WMM_has_secular_var(uint16_t index)
+{
+	uint16_t a = MagneticModel.nMaxSecVar;
+
+	return index >= 1 && index <= (a * (a + 1) / 2 + a);
+}
+
 float WMM_get_main_field_coeff_g(uint16_t index) 
 {	
 	if (index >= NUMTERMS)
 		return 0;
 
-    uint16_t n, m, sum_index, a, b;
+	float coeff = CoeffFile[index][2];
+
+	if (WMM_has_secular_var(index))
+		coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_g(index);
 
-    float coeff = CoeffFile[index][2];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_g(sum_index);
-			
-		}
-	}
-	
 	return coeff;
 }
 
@@ -1048,29 +1081,13 @@ float WMM_get_main_field_coeff_h(uint16_t index)
 {	
 	if (index >= NUMTERMS)
 		return 0;
-	
-    uint16_t n, m, sum_index, a, b;
+
 	float coeff = CoeffFile[index][3];
-	
-	a = MagneticModel.nMaxSecVar;
-	b = (a * (a + 1) / 2 + a);
-	for (n = 1; n <= MagneticModel.nMax; n++)
-	{
-		for (m = 0; m <= n; m++)
-		{
-			
-			sum_index = (n * (n + 1) / 2 + m);
-			
-			/* Hacky for now, will solve for which conditions need summing analytically */
-			if (sum_index != index)
-				continue;
-			
-			if (index <= b) 
-				coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_h(sum_index);
-		}
-	}
-	
-	return coeff;	
+
+	if (WMM_has_secular_var(index))
+		coeff += (decimal_date - MagneticModel.epoch) * WMM_get_secular_var_coeff_h(index);
+
+	return coeff;
 }
 
 float WMM_get_secular_var_coeff_g(uint16_t index) 
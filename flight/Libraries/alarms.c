@@ -38,6 +38,10 @@
 // Private variables
 static struct pios_mutex *lock;
 
+//! Copy of SystemAlarms.Alarm, read without the lock so that setting an
+//! alarm to the severity it already has costs a single compare
+static volatile uint8_t alarm_state[SYSTEMALARMS_ALARM_NUMELEM];
+
 // Private functions
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity);
 
@@ -50,6 +54,11 @@ int32_t AlarmsInitialize(void)
 	lock = PIOS_Mutex_Create();
 	PIOS_Assert(lock != NULL);
 
+	uint8_t alarms[SYSTEMALARMS_ALARM_NUMELEM];
+	SystemAlarmsAlarmGet(alarms);
+	for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; n++)
+		alarm_state[n] = alarms[n];
+
 	uint8_t reboot_reason = SYSTEMALARMS_REBOOTCAUSE_UNDEFINED;
 
 	switch (PIOS_RESET_GetResetReason()) {
@@ -92,29 +101,33 @@ int32_t AlarmsInitialize(void)
  */
 int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity)
 {
-	SystemAlarmsData alarms;
-
 	// Check that this is a valid alarm
 	if (alarm >= SYSTEMALARMS_ALARM_NUMELEM)
 	{
 		return -1;
 	}
 
+	// Most calls repeat the current severity, those return without
+	// taking the lock or touching the object
+	if (alarm_state[alarm] == severity)
+		return 0;
+
 	// Lock
 	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
 
-    // Read alarm and update its severity only if it was changed
-    SystemAlarmsGet(&alarms);
-    if ( alarms.Alarm[alarm] != severity )
-    {
-    	alarms.Alarm[alarm] = severity;
-    	SystemAlarmsSet(&alarms);
-    }
+	// Check again as another task may have set it meanwhile, then only
+	// write the element that changed so only a change sends an update
+	if (alarm_state[alarm] != severity) {
+		alarm_state[alarm] = severity;
 
-    // Release lock
-    PIOS_Mutex_Unlock(lock);
-    return 0;
+		uint8_t value = severity;
+		UAVObjSetDataField(SystemAlarmsHandle(), &value,
+				offsetof(SystemAlarmsData, Alarm) + alarm, sizeof(value));
+	}
 
+	// Release lock
+	PIOS_Mutex_Unlock(lock);
+	return 0;
 }
 
 /**
@@ -124,17 +137,13 @@ int32_t AlarmsSet(SystemAlarmsAlarmElem alarm, SystemAlarmsAlarmOptions severity
  */
 SystemAlarmsAlarmOptions AlarmsGet(SystemAlarmsAlarmElem alarm)
 {
-	SystemAlarmsData alarms;
-
 	// Check that this is a valid alarm
 	if (alarm >= SYSTEMALARMS_ALARM_NUMELEM)
 	{
 		return 0;
 	}
 
-    // Read alarm
-    SystemAlarmsGet(&alarms);
-    return alarms.Alarm[alarm];
+	return alarm_state[alarm];
 }
 
 /**
@@ -214,28 +223,15 @@ int32_t AlarmsHasCritical()
  */
 static int32_t hasSeverity(SystemAlarmsAlarmOptions severity)
 {
-	SystemAlarmsData alarms;
-	uint32_t n;
-
-	// Lock
-	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
-
-    // Read alarms
-    SystemAlarmsGet(&alarms);
-
-    // Go through alarms and check if any are of the given severity or higher
-    for (n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n)
-    {
-    	if ( alarms.Alarm[n] >= severity)
-    	{
-    		PIOS_Mutex_Unlock(lock);
-    		return 1;
-    	}
-    }
+	// Go through alarms and check if any are of the given severity or higher
+	for (uint32_t n = 0; n < SYSTEMALARMS_ALARM_NUMELEM; ++n)
+	{
+		if (alarm_state[n] >= severity)
+			return 1;
+	}
 
-    // If this point is reached then no alarms found
-	PIOS_Mutex_Unlock(lock);
-    return 0;
+	// If this point is reached then no alarms found
+	return 0;
 }
 
 static const char alarm_names[][9] = {
@@ -0,0 +1,84 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       attitude_cache.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      What the modules derive from AttitudeActual, computed once
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* Several modules need the rotation matrix or the heading of the same      */
+/* AttitudeActual every cycle. The first to ask after an update converts    */
+/* it, the others get a copy. An update is noticed by the quaternion having */
+/* changed, so this works with whichever module sets AttitudeActual and     */
+/* needs no task or callback of its own.                                    */
+
+#include "openpilot.h"
+#include "pios_thread.h"
+#include "attitude_cache.h"
+#include "coordinate_conversions.h"
+#include "misc_math.h"
+#include "physical_constants.h"
+
+#include "attitudeactual.h"
+
+#include <string.h>
+
+// Private variables
+static struct attitude_derived cache;
+static bool cache_valid;
+
+/**
+ * Get the current attitude and its conversions
+ * @param[out] derived where they are copied to
+ */
+void AttitudeCacheGet(struct attitude_derived *derived)
+{
+	AttitudeActualData attitude;
+	AttitudeActualGet(&attitude);
+
+	// Only copied while no other task can be converting
+	PIOS_Thread_Scheduler_Suspend();
+	bool fresh = cache_valid && memcmp(cache.q, &attitude.q1, sizeof(cache.q)) == 0;
+	if (fresh)
+		*derived = cache;
+	PIOS_Thread_Scheduler_Resume();
+
+	if (fresh)
+		return;
+
+	quat_copy(&attitude.q1, derived->q);
+	derived->rpy[0] = attitude.Roll;
+	derived->rpy[1] = attitude.Pitch;
+	derived->rpy[2] = attitude.Yaw;
+	Quaternion2R(derived->q, derived->Rbe);
+	ctrl_sincosf(attitude.Yaw * DEG2RAD, &derived->heading[1], &derived->heading[0]);
+
+	// A task that was preempted with an older update may store it over a
+	// newer one, the next caller then just converts again
+	PIOS_Thread_Scheduler_Suspend();
+	cache = *derived;
+	cache_valid = true;
+	PIOS_Thread_Scheduler_Resume();
+}
+
+/**
+ * @}
+ */
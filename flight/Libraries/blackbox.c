@@ -0,0 +1,240 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       blackbox.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      High rate capture of the control loop for tuning
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "blackbox.h"
+#include "pios_thread.h"
+
+#if defined(BLACKBOX_CAPTURE)
+
+// Private constants
+//! Interval of the time references, the cycle counter wraps after about 25 s
+#define REFERENCE_INTERVAL_US 10000000
+
+// Private variables
+static BlackboxFrameData *ring;
+static uint16_t ring_size;
+static volatile uint16_t ring_head;
+static volatile uint16_t ring_tail;
+static volatile uint32_t dropped;
+
+static BlackboxFrameData staging;
+static volatile bool staged;
+
+static uint8_t frame_divider;
+static uint8_t divider_count;
+
+static uint32_t reference_raw;
+static uint32_t reference_us;
+
+// Private functions
+static uint32_t frame_time(uint32_t sample_time);
+static int16_t scale(float value, float factor);
+
+/**
+ * Initialize library, the ring is allocated here so nothing is spent on
+ * boards that do not capture
+ * @param[in] num_frames size of the ring buffer
+ * @param[in] divider capture one frame every divider control loops
+ * @return 0 on success, -1 if the ring could not be allocated
+ */
+int32_t BlackboxInitialize(uint16_t num_frames, uint8_t divider)
+{
+	if (num_frames < 2 || divider == 0)
+		return -1;
+
+	// Only ever touched by the CPU
+	ring = PIOS_malloc_no_dma(num_frames * sizeof(*ring));
+	if (ring == NULL)
+		return -1;
+
+	ring_size = num_frames;
+	ring_head = 0;
+	ring_tail = 0;
+	dropped = 0;
+	staged = false;
+
+	frame_divider = divider;
+	divider_count = 0;
+
+	// Frame times start at the system time so they line up with the log
+	reference_raw = PIOS_DELAY_GetRaw();
+	reference_us = PIOS_Thread_Systime() * 1000;
+
+	return 0;
+}
+
+/**
+ * @return true if frames are captured
+ */
+bool BlackboxEnabled(void)
+{
+	return ring != NULL;
+}
+
+/**
+ * Stage a frame with the state of the stabilization loop, called once per
+ * iteration
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time of the gyro sample
+ * @param[in] gyro filtered gyro rates in deg/s
+ * @param[in] setpoint rate setpoints in deg/s
+ * @param[in] rate_pids the rate PIDs of roll, pitch and yaw
+ * @param[in] output roll, pitch and yaw outputs
+ */
+void BlackboxStabilization(uint32_t sample_time, const float *gyro, const float *setpoint,
+		const struct pid *rate_pids, const float *output)
+{
+	if (ring == NULL)
+		return;
+
+	if (++divider_count < frame_divider)
+		return;
+	divider_count = 0;
+
+	BlackboxFrameData frame;
+
+	frame.Time = frame_time(sample_time);
+	for (int i = 0; i < 3; i++) {
+		frame.Gyro[i] = scale(gyro[i], BLACKBOX_RATE_SCALE);
+		frame.Setpoint[i] = scale(setpoint[i], BLACKBOX_RATE_SCALE);
+		// The same terms pid_apply_setpoint() adds up
+		frame.PTerm[i] = scale(rate_pids[i].p * (setpoint[i] - gyro[i]), BLACKBOX_TERM_SCALE);
+		frame.ITerm[i] = scale(rate_pids[i].iAccumulator, BLACKBOX_TERM_SCALE);
+		frame.DTerm[i] = scale(rate_pids[i].lastDer, BLACKBOX_TERM_SCALE);
+		frame.Output[i] = scale(output[i], BLACKBOX_TERM_SCALE);
+	}
+
+	PIOS_Thread_Scheduler_Suspend();
+	staging = frame;
+	staged = true;
+	PIOS_Thread_Scheduler_Resume();
+}
+
+/**
+ * Complete the staged frame with the actuator outputs and queue it
+ * @param[in] channels the outputs in us
+ * @param[in] num_channels number of outputs
+ */
+void BlackboxActuator(const float *channels, uint8_t num_channels)
+{
+	if (ring == NULL || !staged)
+		return;
+
+	uint16_t next = (ring_head + 1) % ring_size;
+	if (next == ring_tail) {
+		staged = false;
+		dropped++;
+		return;
+	}
+
+	BlackboxFrameData *frame = &ring[ring_head];
+
+	PIOS_Thread_Scheduler_Suspend();
+	*frame = staging;
+	staged = false;
+	PIOS_Thread_Scheduler_Resume();
+
+	for (int i = 0; i < BLACKBOXFRAME_ACTUATOR_NUMELEM; i++) {
+		float value = (i < num_channels) ? channels[i] : 0;
+		frame->Actuator[i] = (value > UINT16_MAX) ? UINT16_MAX : (value < 0) ? 0 : value;
+	}
+
+	// The frame has to be complete before the reader can see it
+	__sync_synchronize();
+	ring_head = next;
+}
+
+/**
+ * Take frames out of the ring buffer, only called by the Logging task
+ * @param[out] data where to copy the frames to, need not be aligned, NULL
+ * discards them
+ * @param[in] max_frames maximum number of frames to take
+ * @return number of frames taken
+ */
+uint16_t BlackboxRead(uint8_t *data, uint16_t max_frames)
+{
+	if (ring == NULL)
+		return 0;
+
+	uint16_t count = 0;
+	while (count < max_frames && ring_tail != ring_head) {
+		if (data) {
+			memcpy(data, &ring[ring_tail], sizeof(*ring));
+			data += sizeof(*ring);
+		}
+		ring_tail = (ring_tail + 1) % ring_size;
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * @return number of frames dropped because the ring buffer was full
+ */
+uint32_t BlackboxDropped(void)
+{
+	return dropped;
+}
+
+/**
+ * Convert a gyro sample time to the time of the frame in us.  The time is
+ * taken against a reference that moves along, so the rounding to us does
+ * not add up over the frames.
+ */
+static uint32_t frame_time(uint32_t sample_time)
+{
+	uint32_t since_reference = PIOS_DELAY_DiffuS(reference_raw) - PIOS_DELAY_DiffuS(sample_time);
+	uint32_t time = reference_us + since_reference;
+
+	if (since_reference > REFERENCE_INTERVAL_US) {
+		reference_raw = sample_time;
+		reference_us = time;
+	}
+
+	return time;
+}
+
+/**
+ * Scale a value to the fixed point format of a frame
+ */
+static int16_t scale(float value, float factor)
+{
+	float scaled = value * factor;
+
+	if (scaled > INT16_MAX)
+		return INT16_MAX;
+	if (scaled < INT16_MIN)
+		return INT16_MIN;
+
+	return scaled;
+}
+
+#endif /* BLACKBOX_CAPTURE */
+
+/**
+ * @}
+ */
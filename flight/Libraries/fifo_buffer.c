@@ -257,6 +257,69 @@ uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len)
     return i;                   // return number of bytes copied
 }
 
+uint16_t fifoBuf_peekContiguous(t_fifo_buffer *buf, uint8_t **data)
+{       // get a pointer to the data at the read position and the number of bytes
+        // that follow it up to the end of the storage, for a DMA engine or a
+        // parser to read in place. fifoBuf_removeData() frees them once used
+
+    uint16_t rd = buf->rd;
+    uint16_t wr = buf->wr;
+
+    *data = buf->buf_ptr + rd;
+
+    if (wr >= rd)
+        return wr - rd;
+    else
+        return buf->buf_size - rd;      // the rest is at the start of the storage
+}
+
+uint16_t fifoBuf_reserveContiguous(t_fifo_buffer *buf, uint8_t **data)
+{       // get a pointer to the free space at the write position and the number
+        // of bytes that can be written there without wrapping, the data is only
+        // added to the buffer by fifoBuf_commit()
+
+    uint16_t rd = buf->rd;
+    uint16_t wr = buf->wr;
+    uint16_t buf_size = buf->buf_size;
+
+    *data = buf->buf_ptr + wr;
+
+    if (buf_size == 0)
+        return 0;
+
+    if (wr < rd)
+        return rd - wr - 1;
+    else if (rd == 0)
+        return buf_size - wr - 1;       // the write position must not reach rd
+    else
+        return buf_size - wr;
+}
+
+uint8_t *fifoBuf_reserve(t_fifo_buffer *buf, uint16_t len)
+{       // get a pointer to len contiguous free bytes at the write position, the
+        // data is only added to the buffer by fifoBuf_commit()
+
+    uint8_t *space;
+
+    if (fifoBuf_reserveContiguous(buf, &space) < len)
+        return 0;                       // not enough room before the end
+
+    return space;
+}
+
+void fifoBuf_commit(t_fifo_buffer *buf, uint16_t len)
+{       // add data written to the space returned by fifoBuf_reserve()
+
+    uint16_t wr = buf->wr;
+    uint16_t buf_size = buf->buf_size;
+
+    wr += len;
+    if (wr >= buf_size)
+        wr -= buf_size;
+
+    buf->wr = wr;
+}
+
 void fifoBuf_init(t_fifo_buffer *buf, const void *buffer, const uint16_t buffer_size)
 {
     buf->buf_ptr = (uint8_t *)buffer;
@@ -0,0 +1,45 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       attitude_cache.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      What the modules derive from AttitudeActual, computed once
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef ATTITUDE_CACHE_H
+#define ATTITUDE_CACHE_H
+
+#include <stdint.h>
+
+//! One AttitudeActual and the conversions of it
+struct attitude_derived {
+	float q[4];
+	float rpy[3];       //!< Roll, pitch and yaw in deg, as in AttitudeActual
+	float Rbe[3][3];    //!< Rotates a vector from earth to body frame
+	float heading[2];   //!< cos and sin of the yaw, the nose in north and east
+};
+
+void AttitudeCacheGet(struct attitude_derived *derived);
+
+#endif /* ATTITUDE_CACHE_H */
+
+/**
+ * @}
+ */
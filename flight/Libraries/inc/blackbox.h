@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       blackbox.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      High rate capture of the control loop for tuning
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pid.h"
+#include "blackboxframe.h"
+
+/*
+ * The stabilization loop stages a frame with the gyro, the rate setpoint,
+ * the terms of the rate PIDs and its output.  The actuator adds the channels
+ * it sends to the outputs and puts the frame in a ring buffer that the
+ * Logging task empties.  Nothing here waits, when the ring is full the frame
+ * is dropped and counted.  The frame layout is BlackboxFrameData, the object
+ * is never registered.  Calls are only made when built with BLACKBOX_CAPTURE.
+ */
+
+//! Scale of the rates in a frame, 0.1 deg/s
+#define BLACKBOX_RATE_SCALE 10.0f
+//! Scale of the stabilization terms and outputs in a frame
+#define BLACKBOX_TERM_SCALE 10000.0f
+
+int32_t BlackboxInitialize(uint16_t num_frames, uint8_t divider);
+bool BlackboxEnabled(void);
+void BlackboxStabilization(uint32_t sample_time, const float *gyro, const float *setpoint,
+		const struct pid *rate_pids, const float *output);
+void BlackboxActuator(const float *channels, uint8_t num_channels);
+uint16_t BlackboxRead(uint8_t *data, uint16_t max_frames);
+uint32_t BlackboxDropped(void);
+
+#endif // BLACKBOX_H
+
+/**
+ * @}
+ */
@@ -60,6 +60,12 @@ uint16_t fifoBuf_putByte(t_fifo_buffer *buf, const uint8_t b);
 
 uint16_t fifoBuf_putData(t_fifo_buffer *buf, const void *data, uint16_t len);
 
+uint16_t fifoBuf_peekContiguous(t_fifo_buffer *buf, uint8_t **data);
+uint16_t fifoBuf_reserveContiguous(t_fifo_buffer *buf, uint8_t **data);
+
+uint8_t *fifoBuf_reserve(t_fifo_buffer *buf, uint16_t len);
+void fifoBuf_commit(t_fifo_buffer *buf, uint16_t len);
+
 void fifoBuf_init(t_fifo_buffer *buf, const void *buffer, const uint16_t buffer_size);
 
 #endif /* _FIFO_BUFFER_H_ */
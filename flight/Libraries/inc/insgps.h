@@ -67,6 +67,25 @@ void INSCovariancePrediction(float dT);
 //! Correct the state and covariance estimate based on the sensors that were updated
 void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[3], float BaroAlt, uint16_t SensorsUsed);
 
+/* Per sensor corrections.  These only process the measurement rows of one
+ * sensor group so a baro or GPS update does not pay for the magnetometer
+ * linearization.  Call them in the order below to match @ref INSCorrection. */
+
+//! Correct with a GPS position, the vertical component is optional
+void INSPositionCorrection(const float Pos[3], bool vertical);
+
+//! Correct with a GPS velocity, the vertical component is optional
+void INSVelocityCorrection(const float Vel[3], bool vertical);
+
+//! Correct with a horizontal NED velocity from an optical flow sensor, with its own variance
+void INSFlowCorrection(const float Vel[2], float FlowVar);
+
+//! Correct with a magnetometer reading
+void INSMagCorrection(const float mag_data[3]);
+
+//! Correct with a barometric altitude
+void INSBaroCorrection(float BaroAlt);
+
 //! Get the current state estimate
 void INSGetState(float *pos, float *vel, float *attitude, float *gyro_bias, float *accel_bias);
 
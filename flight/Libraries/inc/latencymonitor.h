@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       latencymonitor.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Control loop latency monitoring library
+ * @see        The GNU Public License (GPL) Version 3
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <stdint.h>
+
+/*
+ * The sensors task starts a trace with the time of the gyro interrupt and
+ * each stage of the control loop marks when it is done with that sample.
+ * Only the most recent gyro sample is traced; a stage that is still busy
+ * with an older one when a new one arrives is measured against the newer
+ * sample.  Calls are only made when built with LATENCY_DIAGNOSTICS.
+ *
+ * Receiver frames are traced the same way, from when ManualControl wakes
+ * on a decoded frame to the command it publishes and the first actuator
+ * update after that.
+ */
+
+//! Stages of the control loop, in the order the LatencyStatus fields use
+enum latency_stage {
+	LATENCY_STAGE_SENSORS,
+	LATENCY_STAGE_ATTITUDE,
+	LATENCY_STAGE_STABILIZATION,
+	LATENCY_STAGE_ACTUATOR,
+	LATENCY_STAGE_NUM
+};
+
+//! Stages of a receiver frame, in the order the LatencyStatus Input fields use
+enum latency_input_stage {
+	LATENCY_INPUT_COMMAND,
+	LATENCY_INPUT_ACTUATOR,
+	LATENCY_INPUT_NUM
+};
+
+int32_t LatencyMonitorInitialize(void);
+void LatencyMonitorStart(uint32_t sample_time);
+void LatencyMonitorMark(enum latency_stage stage);
+void LatencyMonitorStartInput(uint32_t frame_time);
+void LatencyMonitorMarkInput(enum latency_input_stage stage);
+void LatencyMonitorUpdateAll(void);
+
+#endif // LATENCYMONITOR_H
+
+/**
+ * @}
+ */
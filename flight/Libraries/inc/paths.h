@@ -4,7 +4,7 @@
  * @{
  *
  * @file       paths.h
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
  * @brief      Path calculation library with common API
  *
@@ -41,7 +41,32 @@ struct path_status {
 	float path_direction[2];
 };
 
+/**
+ * The geometry of a path that doesn't change while following it, so each
+ * update only has to project the position onto it
+ */
+struct path_segment {
+	bool valid;               //!< false until worked out the first time
+
+	// The path the geometry is for
+	uint8_t mode;
+	float mode_parameters;
+	float start[2];
+	float end[2];
+
+	float length;             //!< From start to end
+	float direction[2];       //!< Unit vector from start to end
+	float normal[2];          //!< Unit vector to the left of direction
+
+	// Circles and curves
+	float center[2];
+	float radius;
+	bool clockwise;
+};
+
 void path_progress(const PathDesiredData *pathDesired, const float * cur_point, struct path_status * status);
+bool path_segment_update(struct path_segment *segment, const PathDesiredData *pathDesired);
+void path_segment_progress(const struct path_segment *segment, const float *cur_point, struct path_status *status);
 
 #endif /* PATHS_H_ */
 
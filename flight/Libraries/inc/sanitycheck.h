@@ -30,6 +30,7 @@
 #include "systemalarms.h"
 
 extern int32_t configuration_check();
+extern int32_t configuration_check_updated(UAVObjHandle obj);
 void set_config_error(SystemAlarmsConfigErrorOptions error_code);
 
 #endif /* SANITYCHECK_H */
@@ -0,0 +1,100 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TelemetryBridge Telemetry bridge runtime
+ * @{
+ *
+ * @file       telemetry_bridge.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      One task running the encoders of the telemetry bridges
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TELEMETRY_BRIDGE_H
+#define TELEMETRY_BRIDGE_H
+
+#include "openpilot.h"
+
+#include "attitudeactual.h"
+#include "baroaltitude.h"
+#include "flightbatterystate.h"
+#include "flightstatus.h"
+#include "gpsposition.h"
+#include "homelocation.h"
+#include "manualcontrolcommand.h"
+
+//! Objects of the snapshot, only those some encoder reads are fetched
+enum telemetry_bridge_object {
+	TELEMETRY_BRIDGE_ATTITUDE       = 1 << 0,
+	TELEMETRY_BRIDGE_GPS_POSITION   = 1 << 1,
+	TELEMETRY_BRIDGE_BATTERY        = 1 << 2,
+	TELEMETRY_BRIDGE_FLIGHT_STATUS  = 1 << 3,
+	TELEMETRY_BRIDGE_BARO           = 1 << 4,
+	TELEMETRY_BRIDGE_MANUAL_CONTROL = 1 << 5,
+	TELEMETRY_BRIDGE_HOME_LOCATION  = 1 << 6,
+	TELEMETRY_BRIDGE_POSITION       = 1 << 7,
+	TELEMETRY_BRIDGE_AIRSPEED       = 1 << 8,
+};
+
+/**
+ * The objects most bridges send, read once for all of them. Objects that
+ * don't exist on the board stay zero and have no bit in valid.
+ */
+struct telemetry_bridge_snapshot {
+	uint16_t valid;                      //!< telemetry_bridge_object bits of the objects read
+	AttitudeActualData attitude;
+	GPSPositionData gps_position;
+	FlightBatteryStateData battery;
+	FlightStatusData flight_status;
+	BaroAltitudeData baro;
+	ManualControlCommandData manual_control;
+	HomeLocationData home_location;
+	float position_down;                 //!< PositionActual.Down, m
+	float true_airspeed;                 //!< AirspeedActual.TrueAirspeed, m/s
+};
+
+/**
+ * A protocol run by the bridge task. Encoders that send on their own have
+ * a period, those that answer requests get the bytes of their port.
+ */
+struct telemetry_bridge_encoder {
+	uintptr_t com;                       //!< Port the requests come in on
+	uint16_t objects;                    //!< telemetry_bridge_object bits of what the encoder reads
+	uint16_t period_ms;                  //!< How often send is called
+
+	void (*send)(const struct telemetry_bridge_snapshot *snapshot);
+	//! Returns false when the encoder wants no more bytes
+	bool (*receive)(const struct telemetry_bridge_snapshot *snapshot, uint8_t b);
+
+	// Used by the bridge task
+	struct telemetry_bridge_encoder *next;
+	uint32_t next_send;
+};
+
+int32_t telemetry_bridge_register(struct telemetry_bridge_encoder *encoder);
+int32_t telemetry_bridge_start(void);
+
+#endif /* TELEMETRY_BRIDGE_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -29,6 +29,8 @@
 
 #include "insgps.h"
 #include "physical_constants.h"
+#include "matrix_math.h"
+#include "pios_heap.h"		/* PIOS_FAST_DATA */
 #include <math.h>
 #include <stdint.h>
 
@@ -56,13 +58,13 @@ static void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
 		 float G[NUMX][NUMW]);
 static void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
 static void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+static void NormalizeQuaternion();
 
 // Private variables
-static float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
+static PIOS_FAST_DATA float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
 static float Be[3];	                    // local magnetic unit vector in NED frame
-static float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
+static PIOS_FAST_DATA float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
 static float Q[NUMW], R[NUMV];   // input noise and measurement noise variances
-static float K[NUMX][NUMV];	     // feedback gain matrix
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -87,10 +89,8 @@ void INSGPSInit()		//pretty much just a place holder for now
 		for (int j = 0; j < NUMW; j++)
 			G[i][j] = 0.0f;
 			
-		for (int j = 0; j < NUMV; j++) {
+		for (int j = 0; j < NUMV; j++)
 			H[j][i] = 0.0f;
-			K[i][j] = 0.0f;
-		}
 			
 		X[i] = 0.0f;
 	}
@@ -100,6 +100,11 @@ void INSGPSInit()		//pretty much just a place holder for now
 		R[i] = 0.0f;
 
 	
+	// constant rows of H, the quaternion dependent rows are set by LinearizeH
+	H[0][0] = H[1][1] = H[2][2] = 1.0f;
+	H[3][3] = H[4][4] = H[5][5] = 1.0f;
+	H[9][2] = -1.0f;
+
 	P[0][0] = P[1][1] = P[2][2] = 25.0f;            // initial position variance (m^2)
 	P[3][3] = P[4][4] = P[5][5] = 5.0f;             // initial velocity variance (m/s)^2
 	P[6][6] = P[7][7] = P[8][8] = P[9][9] = 1e-5f;  // initial quaternion variance
@@ -296,7 +301,6 @@ void INSSetMagNorth(const float B[3])
 void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT)
 {
 	float U[6];
-	float qmag;
 
 	// rate gyro inputs in units of rad/s
 	U[0] = gyro_data[0];
@@ -311,11 +315,7 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 	// EKF prediction step
 	LinearizeFG(X, U, F, G);
 	RungeKutta(X, U, dT);
-	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
-	X[6] /= qmag;
-	X[7] /= qmag;
-	X[8] /= qmag;
-	X[9] /= qmag;
+	NormalizeQuaternion();
 }
 
 void INSCovariancePrediction(float dT)
@@ -327,7 +327,6 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 		   float BaroAlt, uint16_t SensorsUsed)
 {
 	float Z[10], Y[10];
-	float qmag;
 
 	// GPS Position in meters and in local NED frame
 	Z[0] = Pos[0];
@@ -351,7 +350,85 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	LinearizeH(X, Be, H);
 	MeasurementEq(X, Be, Y);
 	SerialUpdate(H, R, Z, Y, P, X, SensorsUsed);
-	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
+	NormalizeQuaternion();
+}
+
+void INSPositionCorrection(const float Pos[3], bool vertical)
+{
+	float Z[NUMV], Y[NUMV];
+
+	for (uint8_t i = 0; i < 3; i++) {
+		Z[i] = Pos[i];
+		Y[i] = X[i];
+	}
+
+	SerialUpdate(H, R, Z, Y, P, X, vertical ? POS_SENSORS : HORIZ_POS_SENSORS);
+	NormalizeQuaternion();
+}
+
+void INSVelocityCorrection(const float Vel[3], bool vertical)
+{
+	float Z[NUMV], Y[NUMV];
+
+	for (uint8_t i = 3; i < 6; i++) {
+		Z[i] = Vel[i - 3];
+		Y[i] = X[i];
+	}
+
+	SerialUpdate(H, R, Z, Y, P, X, HORIZ_VEL_SENSORS | (vertical ? VERT_VEL_SENSORS : 0));
+	NormalizeQuaternion();
+}
+
+void INSFlowCorrection(const float Vel[2], float FlowVar)
+{
+	float Z[NUMV], Y[NUMV];
+	float R_vel[2] = {R[3], R[4]};
+
+	for (uint8_t i = 3; i < 5; i++) {
+		Z[i] = Vel[i - 3];
+		Y[i] = X[i];
+	}
+
+	// Same rows as the GPS velocity, with the noise of the flow sensor
+	R[3] = R[4] = FlowVar;
+	SerialUpdate(H, R, Z, Y, P, X, HORIZ_VEL_SENSORS);
+	R[3] = R_vel[0];
+	R[4] = R_vel[1];
+	NormalizeQuaternion();
+}
+
+void INSMagCorrection(const float mag_data[3])
+{
+	float Z[NUMV], Y[NUMV];
+
+	// magnetometer data in any units (use unit vector) and in body frame
+	Z[6] = mag_data[0];
+	Z[7] = mag_data[1];
+	Z[8] = mag_data[2];
+
+	// Only the magnetometer rows depend on the attitude
+	LinearizeH(X, Be, H);
+	MeasurementEq(X, Be, Y);
+	SerialUpdate(H, R, Z, Y, P, X, MAG_SENSORS);
+	NormalizeQuaternion();
+}
+
+void INSBaroCorrection(float BaroAlt)
+{
+	float Z[NUMV], Y[NUMV];
+
+	Z[9] = BaroAlt;
+	Y[9] = -X[2];
+
+	SerialUpdate(H, R, Z, Y, P, X, BARO_SENSOR);
+	NormalizeQuaternion();
+}
+
+//! Keep the attitude quaternion at unit length after a correction
+static void NormalizeQuaternion()
+{
+	float qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
+
 	X[6] /= qmag;
 	X[7] /= qmag;
 	X[8] /= qmag;
@@ -374,28 +451,27 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX])
 {
-	float Dummy[NUMX][NUMX], dTsq;
+	float Dummy[NUMX][NUMX], DF[NUMX], dTsq;
 	uint8_t i, j, k;
 
 	//  Pnew = (I+F*T)*P*(I+F*T)' + T^2*G*Q*G' = T^2[(P/T + F*P)*(I/T + F') + G*Q*G')]
 
 	dTsq = dT * dT;
 
+	matrix_mul(&F[0][0], &P[0][0], &Dummy[0][0], NUMX, NUMX, NUMX);
 	for (i = 0; i < NUMX; i++)	// Calculate Dummy = (P/T +F*P)
-		for (j = 0; j < NUMX; j++) {
-			Dummy[i][j] = P[i][j] / dT;
-			for (k = 0; k < NUMX; k++)
-				Dummy[i][j] += F[i][k] * P[k][j];
-		}
-	for (i = 0; i < NUMX; i++)	// Calculate Pnew = Dummy/T + Dummy*F' + G*Qw*G'
-		for (j = i; j < NUMX; j++) {	// Use symmetry, ie only find upper triangular
-			P[i][j] = Dummy[i][j] / dT;
-			for (k = 0; k < NUMX; k++)
-				P[i][j] += Dummy[i][k] * F[j][k];	// P = Dummy/T + Dummy*F'
+		for (j = 0; j < NUMX; j++)
+			Dummy[i][j] += P[i][j] / dT;
+	for (i = 0; i < NUMX; i++) {	// Calculate Pnew = Dummy/T + Dummy*F' + G*Qw*G'
+		// Use symmetry, ie only find the upper triangular of Dummy*F'
+		matrix_mul_trans(Dummy[i], &F[i][0], &DF[i], 1, NUMX, NUMX - i);
+		for (j = i; j < NUMX; j++) {
+			P[i][j] = Dummy[i][j] / dT + DF[j];	// P = Dummy/T + Dummy*F'
 			for (k = 0; k < NUMW; k++)
 				P[i][j] += Q[k] * G[i][k] * G[j][k];	// P = Dummy/T + Dummy*F' + G*Q*G'
 			P[j][i] = P[i][j] = P[i][j] * dTsq;	// Pnew = T^2*P and fill in lower triangular;
 		}
+	}
 }
 
 #else
@@ -1350,40 +1426,45 @@ static void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //            - or see Simon, "Optimal State Estimation," 1st Ed, p.150
 //  The SensorsUsed variable is a bitwise mask indicating which sensors
 //     should be used in the update.
+//  Only the columns listed in H_nz_col are visited when multiplying by H
 //  ************************************************
 
+#define H_MAX_NZ 4
+static const uint8_t H_nz_len[NUMV] = { 1, 1, 1, 1, 1, 1, 4, 4, 4, 1 };
+static const uint8_t H_nz_col[NUMV][H_MAX_NZ] = {
+	{ 0 }, { 1 }, { 2 }, { 3 }, { 4 }, { 5 },
+	{ 6, 7, 8, 9 }, { 6, 7, 8, 9 }, { 6, 7, 8, 9 }, { 2 }
+};
+
 static void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
 		  uint16_t SensorsUsed)
 {
-	float HP[NUMX], HPHR, Error;
-	uint8_t i, j, k, m;
+	float HP[NUMX], K[NUMX], HPHR, Error;
+	uint8_t m, n;
 
 	for (m = 0; m < NUMV; m++) {
 
 		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
 
-			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
-				HP[j] = 0;
-				for (k = 0; k < NUMX; k++)
-					HP[j] += H[m][k] * P[k][j];
-			}
+			const uint8_t *cols = H_nz_col[m];
+
+			// Find Hp = H*P, only the non zero columns of H contribute
+			vector_scale(HP, P[cols[0]], H[m][cols[0]], NUMX);
+			for (n = 1; n < H_nz_len[m]; n++)
+				vector_axpy(HP, P[cols[n]], H[m][cols[n]], NUMX);
+
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
-				HPHR += HP[k] * H[m][k];
+			for (n = 0; n < H_nz_len[m]; n++)
+				HPHR += HP[cols[n]] * H[m][cols[n]];
 
-			for (k = 0; k < NUMX; k++)
-				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
+			vector_scale(K, HP, 1.0f / HPHR, NUMX);	// find K = HP/HPHR
 
-			for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) + K*HP
-				for (j = i; j < NUMX; j++)
-					P[i][j] = P[j][i] =
-					    P[i][j] - K[i][m] * HP[j];
-			}
+			// Find P(m)= P(m-1) + K*HP
+			matrix_sym_rank1_sub(&P[0][0], K, HP, NUMX);
 
 			Error = Z[m] - Y[m];
-			for (i = 0; i < NUMX; i++)	// Find X(m)= X(m-1) + K*Error
-				X[i] = X[i] + K[i][m] * Error;
+			vector_axpy(X, K, Error, NUMX);	// Find X(m)= X(m-1) + K*Error
 
 		}
 	}
@@ -32,6 +32,8 @@
 
 #include "insgps.h"
 #include "physical_constants.h"
+#include "matrix_math.h"
+#include "pios_heap.h"		/* PIOS_FAST_DATA */
 #include <math.h>
 #include <stdint.h>
 
@@ -45,6 +47,9 @@
 // This might trick people so I have a note here.  There is a slower but bigger version of the 
 // code here but won't fit when debugging disabled (requires -Os)
 #define COVARIANCE_PREDICTION_GENERAL
+#elif defined(SYMBOLIC_COV)
+// Fully expanded symbolic version, kept as a reference for the sparse version
+#define COVARIANCE_PREDICTION_SYMBOLIC
 #endif
 
 // Private functions
@@ -59,14 +64,15 @@ void LinearizeFG(float X[NUMX], float U[NUMU], float F[NUMX][NUMX],
 		 float G[NUMX][NUMW]);
 void MeasurementEq(float X[NUMX], float Be[3], float Y[NUMV]);
 void LinearizeH(float X[NUMX], float Be[3], float H[NUMV][NUMX]);
+static void MagHorizontal(const float mag_data[3], float Z[3]);
+static void NormalizeQuaternion();
 
 // Private variables
-float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
-													// global to init to zero and maintain zero elements
+PIOS_FAST_DATA float F[NUMX][NUMX], G[NUMX][NUMW], H[NUMV][NUMX];	// linearized system matrices
+													// cleared by INSGPSInit, the zero elements are never written
 float Be[3];			// local magnetic unit vector in NED frame
-float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
+PIOS_FAST_DATA float P[NUMX][NUMX], X[NUMX];	// covariance matrix and state vector
 float Q[NUMW], R[NUMV];		// input noise and measurement noise variances
-float K[NUMX][NUMV];		// feedback gain matrix
 
 //  *************  Exposed Functions ****************
 //  *************************************************
@@ -90,10 +96,8 @@ void INSGPSInit()		//pretty much just a place holder for now
 		for (int j = 0; j < NUMW; j++)
 			G[i][j] = 0.0f;
 			
-		for (int j = 0; j < NUMV; j++) {
+		for (int j = 0; j < NUMV; j++)
 			H[j][i] = 0.0f;
-			K[i][j] = 0.0f;
-		}
 			
 		X[i] = 0.0f;
 	}
@@ -102,6 +106,11 @@ void INSGPSInit()		//pretty much just a place holder for now
 	for (int i = 0; i < NUMV; i++) 
 		R[i] = 0.0f;
 	
+	// constant rows of H, the quaternion dependent rows are set by LinearizeH
+	H[0][0] = H[1][1] = H[2][2] = 1.0f;
+	H[3][3] = H[4][4] = H[5][5] = 1.0f;
+	H[9][2] = -1.0f;
+
 	P[0][0] = P[1][1] = P[2][2] = 25.0f;	// initial position variance (m^2)
 	P[3][3] = P[4][4] = P[5][5] = 5.0f;	// initial velocity variance (m/s)^2
 	P[6][6] = P[7][7] = P[8][8] = P[9][9] = 1e-5f;	// initial quaternion variance
@@ -310,7 +319,6 @@ void INSSetMagNorth(const float B[3])
 void INSStatePrediction(const float gyro_data[3], const float accel_data[3], float dT)
 {
 	float U[6];
-	float qmag;
 
 	// rate gyro inputs in units of rad/s
 	U[0] = gyro_data[0];
@@ -325,11 +333,7 @@ void INSStatePrediction(const float gyro_data[3], const float accel_data[3], flo
 	// EKF prediction step
 	LinearizeFG(X, U, F, G);
 	RungeKutta(X, U, dT);
-	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
-	X[6] /= qmag;
-	X[7] /= qmag;
-	X[8] /= qmag;
-	X[9] /= qmag;
+	NormalizeQuaternion();
 }
 
 void INSCovariancePrediction(float dT)
@@ -341,7 +345,6 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 		   float BaroAlt, uint16_t SensorsUsed)
 {
 	float Z[10], Y[10];
-	float qmag;
 
 	// GPS Position in meters and in local NED frame
 	Z[0] = Pos[0];
@@ -353,30 +356,9 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	Z[4] = Vel[1];
 	Z[5] = Vel[2];
 
-	if (SensorsUsed & MAG_SENSORS) {
-		// magnetometer data in any units (use unit vector) and in body frame
-		float Rbe_a[3][3];
-		float q0 = X[6];
-		float q1 = X[7];
-		float q2 = X[8];
-		float q3 = X[9];
-		float k1 = 1.0f/sqrtf(powf(q0*q1*2.0f+q2*q3*2.0f,2.0f)+powf(q0*q0-q1*q1-q2*q2+q3*q3,2.0f));
-		float k2 = sqrtf(-powf(q0*q2*2.0f-q1*q3*2.0f,2.0f)+1.0f);
-
-		Rbe_a[0][0] = k2;
-		Rbe_a[0][1] = 0.0f;
-		Rbe_a[0][2] = q0*q2*-2.0f+q1*q3*2.0f;
-		Rbe_a[1][0] = k1*(q0*q1*2.0f+q2*q3*2.0f)*(q0*q2*2.0f-q1*q3*2.0f);
-		Rbe_a[1][1] = k1*(q0*q0-q1*q1-q2*q2+q3*q3);
-		Rbe_a[1][2] = k1*sqrtf(-powf(q0*q2*2.0f-q1*q3*2.0f,2.0f)+1.0f)*(q0*q1*2.0f+q2*q3*2.0f);
-		Rbe_a[2][0] = k1*(q0*q2*2.0f-q1*q3*2.0f)*(q0*q0-q1*q1-q2*q2+q3*q3);
-		Rbe_a[2][1] = -k1*(q0*q1*2.0f+q2*q3*2.0f);
-		Rbe_a[2][2] = k1*k2*(q0*q0-q1*q1-q2*q2+q3*q3);
-
-		Z[6] = Rbe_a[0][0]*mag_data[0] + Rbe_a[1][0]*mag_data[1] + Rbe_a[2][0]*mag_data[2] ;
-		Z[7] = Rbe_a[0][1]*mag_data[0] + Rbe_a[1][1]*mag_data[1] + Rbe_a[2][1]*mag_data[2] ;
-		Z[8] = Rbe_a[0][2]*mag_data[0] + Rbe_a[1][2]*mag_data[1] + Rbe_a[2][2]*mag_data[2] ;
-	}
+	// magnetometer data in any units (use unit vector) and in body frame
+	if (SensorsUsed & MAG_SENSORS)
+		MagHorizontal(mag_data, &Z[6]);
 
 	// barometric altimeter in meters and in local NED frame
 	Z[9] = BaroAlt;
@@ -385,7 +367,112 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 	LinearizeH(X, Be, H);
 	MeasurementEq(X, Be, Y);
 	SerialUpdate(H, R, Z, Y, P, X, SensorsUsed);
-	qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
+	NormalizeQuaternion();
+}
+
+void INSPositionCorrection(const float Pos[3], bool vertical)
+{
+	float Z[NUMV], Y[NUMV];
+
+	for (uint8_t i = 0; i < 3; i++) {
+		Z[i] = Pos[i];
+		Y[i] = X[i];
+	}
+
+	SerialUpdate(H, R, Z, Y, P, X, vertical ? POS_SENSORS : HORIZ_POS_SENSORS);
+	NormalizeQuaternion();
+}
+
+void INSVelocityCorrection(const float Vel[3], bool vertical)
+{
+	float Z[NUMV], Y[NUMV];
+
+	for (uint8_t i = 3; i < 6; i++) {
+		Z[i] = Vel[i - 3];
+		Y[i] = X[i];
+	}
+
+	SerialUpdate(H, R, Z, Y, P, X, HORIZ_VEL_SENSORS | (vertical ? VERT_VEL_SENSORS : 0));
+	NormalizeQuaternion();
+}
+
+void INSFlowCorrection(const float Vel[2], float FlowVar)
+{
+	float Z[NUMV], Y[NUMV];
+	float R_vel[2] = {R[3], R[4]};
+
+	for (uint8_t i = 3; i < 5; i++) {
+		Z[i] = Vel[i - 3];
+		Y[i] = X[i];
+	}
+
+	// Same rows as the GPS velocity, with the noise of the flow sensor
+	R[3] = R[4] = FlowVar;
+	SerialUpdate(H, R, Z, Y, P, X, HORIZ_VEL_SENSORS);
+	R[3] = R_vel[0];
+	R[4] = R_vel[1];
+	NormalizeQuaternion();
+}
+
+void INSMagCorrection(const float mag_data[3])
+{
+	float Z[NUMV], Y[NUMV];
+
+	MagHorizontal(mag_data, &Z[6]);
+
+	// Only the magnetometer rows depend on the attitude
+	LinearizeH(X, Be, H);
+	MeasurementEq(X, Be, Y);
+	SerialUpdate(H, R, Z, Y, P, X, MAG_SENSORS);
+	NormalizeQuaternion();
+}
+
+void INSBaroCorrection(float BaroAlt)
+{
+	float Z[NUMV], Y[NUMV];
+
+	Z[9] = BaroAlt;
+	Y[9] = -X[2];
+
+	SerialUpdate(H, R, Z, Y, P, X, BARO_SENSOR);
+	NormalizeQuaternion();
+}
+
+/**
+ * Rotate a body frame magnetometer reading into the horizontal plane
+ * @param[in] mag_data magnetometer data in any units and in body frame
+ * @param[out] Z the three magnetometer measurements
+ */
+static void MagHorizontal(const float mag_data[3], float Z[3])
+{
+	float Rbe_a[3][3];
+	float q0 = X[6];
+	float q1 = X[7];
+	float q2 = X[8];
+	float q3 = X[9];
+	float k1 = 1.0f/sqrtf(powf(q0*q1*2.0f+q2*q3*2.0f,2.0f)+powf(q0*q0-q1*q1-q2*q2+q3*q3,2.0f));
+	float k2 = sqrtf(-powf(q0*q2*2.0f-q1*q3*2.0f,2.0f)+1.0f);
+
+	Rbe_a[0][0] = k2;
+	Rbe_a[0][1] = 0.0f;
+	Rbe_a[0][2] = q0*q2*-2.0f+q1*q3*2.0f;
+	Rbe_a[1][0] = k1*(q0*q1*2.0f+q2*q3*2.0f)*(q0*q2*2.0f-q1*q3*2.0f);
+	Rbe_a[1][1] = k1*(q0*q0-q1*q1-q2*q2+q3*q3);
+	Rbe_a[1][2] = k1*sqrtf(-powf(q0*q2*2.0f-q1*q3*2.0f,2.0f)+1.0f)*(q0*q1*2.0f+q2*q3*2.0f);
+	Rbe_a[2][0] = k1*(q0*q2*2.0f-q1*q3*2.0f)*(q0*q0-q1*q1-q2*q2+q3*q3);
+	Rbe_a[2][1] = -k1*(q0*q1*2.0f+q2*q3*2.0f);
+	Rbe_a[2][2] = k1*k2*(q0*q0-q1*q1-q2*q2+q3*q3);
+
+	Z[0] = Rbe_a[0][0]*mag_data[0] + Rbe_a[1][0]*mag_data[1] + Rbe_a[2][0]*mag_data[2] ;
+	Z[1] = Rbe_a[0][1]*mag_data[0] + Rbe_a[1][1]*mag_data[1] + Rbe_a[2][1]*mag_data[2] ;
+	Z[2] = Rbe_a[0][2]*mag_data[0] + Rbe_a[1][2]*mag_data[1] + Rbe_a[2][2]*mag_data[2] ;
+}
+
+//! Keep the attitude quaternion at unit length after a correction
+static void NormalizeQuaternion()
+{
+	float qmag = sqrtf(X[6] * X[6] + X[7] * X[7] + X[8] * X[8] + X[9] * X[9]);
+
 	X[6] /= qmag;
 	X[7] /= qmag;
 	X[8] /= qmag;
@@ -400,7 +487,8 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 //  Q is vector of the diagonal for a square matrix with
 //    dimensions equal to the number of disturbance noise variables
 //  The General Method is very inefficient,not taking advantage of the sparse F and G
-//  The first Method is very specific to this implementation
+//  The symbolic Method is very specific to this implementation
+//  The default Method walks tables of the non zero entries of F and G
 //  ************************************************
 
 #ifdef COVARIANCE_PREDICTION_GENERAL
@@ -408,31 +496,30 @@ void INSCorrection(const float mag_data[3], const float Pos[3], const float Vel[
 void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX])
 {
-	float Dummy[NUMX][NUMX], dTsq;
+	float Dummy[NUMX][NUMX], DF[NUMX], dTsq;
 	uint8_t i, j, k;
 
 	//  Pnew = (I+F*T)*P*(I+F*T)' + T^2*G*Q*G' = T^2[(P/T + F*P)*(I/T + F') + G*Q*G')]
 
 	dTsq = dT * dT;
 
+	matrix_mul(&F[0][0], &P[0][0], &Dummy[0][0], NUMX, NUMX, NUMX);
 	for (i = 0; i < NUMX; i++)	// Calculate Dummy = (P/T +F*P)
-		for (j = 0; j < NUMX; j++) {
-			Dummy[i][j] = P[i][j] / dT;
-			for (k = 0; k < NUMX; k++)
-				Dummy[i][j] += F[i][k] * P[k][j];
-		}
-	for (i = 0; i < NUMX; i++)	// Calculate Pnew = Dummy/T + Dummy*F' + G*Qw*G'
-		for (j = i; j < NUMX; j++) {	// Use symmetry, ie only find upper triangular
-			P[i][j] = Dummy[i][j] / dT;
-			for (k = 0; k < NUMX; k++)
-				P[i][j] += Dummy[i][k] * F[j][k];	// P = Dummy/T + Dummy*F'
+		for (j = 0; j < NUMX; j++)
+			Dummy[i][j] += P[i][j] / dT;
+	for (i = 0; i < NUMX; i++) {	// Calculate Pnew = Dummy/T + Dummy*F' + G*Qw*G'
+		// Use symmetry, ie only find the upper triangular of Dummy*F'
+		matrix_mul_trans(Dummy[i], &F[i][0], &DF[i], 1, NUMX, NUMX - i);
+		for (j = i; j < NUMX; j++) {
+			P[i][j] = Dummy[i][j] / dT + DF[j];	// P = Dummy/T + Dummy*F'
 			for (k = 0; k < NUMW; k++)
 				P[i][j] += Q[k] * G[i][k] * G[j][k];	// P = Dummy/T + Dummy*F' + G*Q*G'
 			P[j][i] = P[i][j] = P[i][j] * dTsq;	// Pnew = T^2*P and fill in lower triangular;
 		}
+	}
 }
 
-#else
+#elif defined(COVARIANCE_PREDICTION_SYMBOLIC)
 
 void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 			  float Q[NUMW], float dT, float P[NUMX][NUMX])
@@ -588,6 +675,83 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 	P[15][15] = Q[11]*Tsq + D[15][15];
 
 
+}
+#else
+
+// Structure of F and G as filled in by LinearizeFG, these tables must be
+// kept in sync with it. The diagonal of the quaternion block is always zero.
+// The bias random walks (G[10..15][6..11]) are an identity that LinearizeFG
+// never stores, they are added straight to the diagonal below.
+#define F_MAX_NZ 7
+#define G_MAX_NZ 3
+#define F_NZ_ROWS 10	// rows 10..15 (the bias states) of F are empty
+static const uint8_t F_nz_len[F_NZ_ROWS] = { 1, 1, 1, 7, 7, 7, 6, 6, 6, 6 };
+static const uint8_t F_nz_col[F_NZ_ROWS][F_MAX_NZ] = {
+	{ 3 }, { 4 }, { 5 },
+	{ 6, 7, 8, 9, 13, 14, 15 },
+	{ 6, 7, 8, 9, 13, 14, 15 },
+	{ 6, 7, 8, 9, 13, 14, 15 },
+	{ 7, 8, 9, 10, 11, 12 },
+	{ 6, 8, 9, 10, 11, 12 },
+	{ 6, 7, 9, 10, 11, 12 },
+	{ 6, 7, 8, 10, 11, 12 },
+};
+static const uint8_t G_nz_len[F_NZ_ROWS] = { 0, 0, 0, 3, 3, 3, 3, 3, 3, 3 };
+static const uint8_t G_nz_col[F_NZ_ROWS][G_MAX_NZ] = {
+	{ 0 }, { 0 }, { 0 },
+	{ 3, 4, 5 }, { 3, 4, 5 }, { 3, 4, 5 },
+	{ 0, 1, 2 }, { 0, 1, 2 }, { 0, 1, 2 }, { 0, 1, 2 },
+};
+
+void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
+			  float Q[NUMW], float dT, float P[NUMX][NUMX])
+{
+	float FP[F_NZ_ROWS][NUMX], Tsq;
+	uint8_t i, j, k;
+
+	//  Pnew = (I+F*T)*P*(I+F*T)' + T^2*G*Q*G'
+	//       = P + T*(F*P + (F*P)') + T^2*((F*P)*F' + G*Q*G')
+	//  F*P is formed once using only the non zero entries of F, then only
+	//  the upper triangle of Pnew is computed and mirrored
+
+	Tsq = dT * dT;
+
+	for (i = 0; i < F_NZ_ROWS; i++) {	// FP = F*P
+		const uint8_t *cols = F_nz_col[i];
+		for (j = 0; j < NUMX; j++) {
+			float sum = 0.0f;
+			for (k = 0; k < F_nz_len[i]; k++)
+				sum += F[i][cols[k]] * P[cols[k]][j];
+			FP[i][j] = sum;
+		}
+	}
+
+	for (i = 0; i < NUMX; i++)
+		for (j = i; j < NUMX; j++) {
+			float first = 0.0f, second = 0.0f;
+
+			if (i < F_NZ_ROWS)
+				first += FP[i][j];
+			if (j < F_NZ_ROWS) {
+				first += FP[j][i];
+
+				// (F*P)*F' only has terms where row j of F is non zero
+				if (i < F_NZ_ROWS) {
+					const uint8_t *cols = F_nz_col[j];
+					for (k = 0; k < F_nz_len[j]; k++)
+						second += FP[i][cols[k]] * F[j][cols[k]];
+
+					cols = G_nz_col[i];
+					for (k = 0; k < G_nz_len[i]; k++)
+						second += Q[cols[k]] * G[i][cols[k]] * G[j][cols[k]];
+				}
+			}
+
+			if (i == j && i >= F_NZ_ROWS)
+				second += Q[i - F_NZ_ROWS + 6];
+
+			P[j][i] = P[i][j] = P[i][j] + first * dT + second * Tsq;
+		}
 }
 #endif
 
@@ -605,42 +769,49 @@ void CovariancePrediction(float F[NUMX][NUMX], float G[NUMX][NUMW],
 //            - or see Simon, "Optimal State Estimation," 1st Ed, p.150
 //  The SensorsUsed variable is a bitwise mask indicating which sensors
 //     should be used in the update.
+//  Only the columns listed in H_nz_col are visited when multiplying by H
 //  ************************************************
 
+#define H_MAX_NZ 4
+static const uint8_t H_nz_len[NUMV] = { 1, 1, 1, 1, 1, 1, 4, 4, 0, 1 };
+static const uint8_t H_nz_col[NUMV][H_MAX_NZ] = {
+	{ 0 }, { 1 }, { 2 }, { 3 }, { 4 }, { 5 },
+	{ 6, 7, 8, 9 }, { 6, 7, 8, 9 }, { 0 }, { 2 }
+};
+
 void SerialUpdate(float H[NUMV][NUMX], float R[NUMV], float Z[NUMV],
 		  float Y[NUMV], float P[NUMX][NUMX], float X[NUMX],
 		  uint16_t SensorsUsed)
 {
-	float HP[NUMX], HPHR, Error;
-	uint8_t i, j, k, m;
+	float HP[NUMX], K[NUMX], HPHR, Error;
+	uint8_t m, n;
 
 	// Iterate through all the possible measurements and apply the
 	// appropriate corrections
 	for (m = 0; m < NUMV; m++) {
 
-		if (SensorsUsed & (0x01 << m)) {	// use this sensor for update
+		// use this sensor for update, rows of H that are all zero cannot
+		// correct anything
+		if ((SensorsUsed & (0x01 << m)) && H_nz_len[m] > 0) {
+
+			const uint8_t *cols = H_nz_col[m];
+
+			// Find Hp = H*P, only the non zero columns of H contribute
+			vector_scale(HP, P[cols[0]], H[m][cols[0]], NUMX);
+			for (n = 1; n < H_nz_len[m]; n++)
+				vector_axpy(HP, P[cols[n]], H[m][cols[n]], NUMX);
 
-			for (j = 0; j < NUMX; j++) {	// Find Hp = H*P
-				HP[j] = 0.0f;
-				for (k = 0; k < NUMX; k++)
-					HP[j] += H[m][k] * P[k][j];
-			}
 			HPHR = R[m];	// Find  HPHR = H*P*H' + R
-			for (k = 0; k < NUMX; k++)
-				HPHR += HP[k] * H[m][k];
+			for (n = 0; n < H_nz_len[m]; n++)
+				HPHR += HP[cols[n]] * H[m][cols[n]];
 
-			for (k = 0; k < NUMX; k++)
-				K[k][m] = HP[k] / HPHR;	// find K = HP/HPHR
+			vector_scale(K, HP, 1.0f / HPHR, NUMX);	// find K = HP/HPHR
 
-			for (i = 0; i < NUMX; i++) {	// Find P(m)= P(m-1) + K*HP
-				for (j = i; j < NUMX; j++)
-					P[i][j] = P[j][i] =
-					    P[i][j] - K[i][m] * HP[j];
-			}
+			// Find P(m)= P(m-1) + K*HP
+			matrix_sym_rank1_sub(&P[0][0], K, HP, NUMX);
 
 			Error = Z[m] - Y[m];
-			for (i = 0; i < NUMX; i++)	// Find X(m)= X(m-1) + K*Error
-				X[i] = X[i] + K[i][m] * Error;
+			vector_axpy(X, K, Error, NUMX);	// Find X(m)= X(m-1) + K*Error
 
 		}
 	}
@@ -0,0 +1,216 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ *
+ * @file       latencymonitor.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Control loop latency monitoring library
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "openpilot.h"
+#include "latencymonitor.h"
+#include "latencystatus.h"
+#include "pios_mutex.h"
+
+#if defined(LATENCY_DIAGNOSTICS)
+
+// Private constants
+#define HISTOGRAM_BIN_US 250
+
+// Private types
+struct latency_stats {
+	float min;
+	float max;
+	float sum;
+	uint32_t count;
+};
+
+// Private variables
+static struct pios_mutex *lock;
+static volatile uint32_t trace_start;
+static volatile bool trace_valid;
+static struct latency_stats stats[LATENCY_STAGE_NUM];
+static uint16_t histogram[LATENCYSTATUS_HISTOGRAM_NUMELEM];
+
+//! Stage the traced receiver frame reaches next, LATENCY_INPUT_NUM when none
+static volatile uint32_t input_start;
+static volatile enum latency_input_stage input_stage = LATENCY_INPUT_NUM;
+static struct latency_stats input_stats[LATENCY_INPUT_NUM];
+
+// Private functions
+static void reset_stats(void);
+static void add_sample(struct latency_stats *s, float latency);
+
+/**
+ * Initialize library
+ */
+int32_t LatencyMonitorInitialize(void)
+{
+	lock = PIOS_Mutex_Create();
+	PIOS_Assert(lock != NULL);
+
+	if (LatencyStatusInitialize() != 0)
+		return -1;
+
+	reset_stats();
+	trace_valid = false;
+
+	return 0;
+}
+
+/**
+ * Start tracing a new gyro sample
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time of the gyro interrupt
+ */
+void LatencyMonitorStart(uint32_t sample_time)
+{
+	trace_start = sample_time;
+	trace_valid = true;
+}
+
+/**
+ * Record that a stage of the control loop is done with the traced sample
+ * @param[in] stage the stage that is done
+ */
+void LatencyMonitorMark(enum latency_stage stage)
+{
+	if (stage >= LATENCY_STAGE_NUM)
+		return;
+
+	// The first outputs after a new command are where the sticks show
+	if (stage == LATENCY_STAGE_ACTUATOR)
+		LatencyMonitorMarkInput(LATENCY_INPUT_ACTUATOR);
+
+	if (!trace_valid)
+		return;
+
+	float latency = PIOS_DELAY_DiffuS(trace_start);
+
+	// Never stall the control loop, drop the measurement instead
+	if (PIOS_Mutex_Lock(lock, 0) != true)
+		return;
+
+	add_sample(&stats[stage], latency);
+
+	if (stage == LATENCY_STAGE_ACTUATOR) {
+		uint32_t bin = latency / HISTOGRAM_BIN_US;
+		if (bin >= LATENCYSTATUS_HISTOGRAM_NUMELEM)
+			bin = LATENCYSTATUS_HISTOGRAM_NUMELEM - 1;
+		if (histogram[bin] < UINT16_MAX)
+			histogram[bin]++;
+	}
+
+	PIOS_Mutex_Unlock(lock);
+}
+
+/**
+ * Start tracing a new receiver frame
+ * @param[in] frame_time PIOS_DELAY_GetRaw() time the frame was decoded
+ */
+void LatencyMonitorStartInput(uint32_t frame_time)
+{
+	input_start = frame_time;
+	input_stage = LATENCY_INPUT_COMMAND;
+}
+
+/**
+ * Record that the traced receiver frame reached a stage, stages it is not
+ * waiting for are ignored
+ * @param[in] stage the stage that is reached
+ */
+void LatencyMonitorMarkInput(enum latency_input_stage stage)
+{
+	if (stage != input_stage)
+		return;
+
+	float latency = PIOS_DELAY_DiffuS(input_start);
+	input_stage = stage + 1;
+
+	if (PIOS_Mutex_Lock(lock, 0) != true)
+		return;
+
+	add_sample(&input_stats[stage], latency);
+
+	PIOS_Mutex_Unlock(lock);
+}
+
+/**
+ * Publish the statistics gathered since the last call and start over
+ */
+void LatencyMonitorUpdateAll(void)
+{
+	LatencyStatusData latencyStatus;
+
+	PIOS_Mutex_Lock(lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	for (int i = 0; i < LATENCY_STAGE_NUM; i++) {
+		latencyStatus.Min[i] = stats[i].min;
+		latencyStatus.Max[i] = stats[i].max;
+		latencyStatus.Average[i] = stats[i].count ? stats[i].sum / stats[i].count : 0;
+	}
+	memcpy(latencyStatus.Histogram, histogram, sizeof(histogram));
+
+	for (int i = 0; i < LATENCY_INPUT_NUM; i++) {
+		latencyStatus.InputMin[i] = input_stats[i].min;
+		latencyStatus.InputMax[i] = input_stats[i].max;
+		latencyStatus.InputAverage[i] = input_stats[i].count ? input_stats[i].sum / input_stats[i].count : 0;
+	}
+
+	reset_stats();
+
+	PIOS_Mutex_Unlock(lock);
+
+	LatencyStatusSet(&latencyStatus);
+}
+
+/**
+ * Clear the statistics, called with the lock held
+ */
+static void reset_stats(void)
+{
+	memset(stats, 0, sizeof(stats));
+	memset(histogram, 0, sizeof(histogram));
+	memset(input_stats, 0, sizeof(input_stats));
+}
+
+/**
+ * Add a measurement to a statistic, called with the lock held
+ */
+static void add_sample(struct latency_stats *s, float latency)
+{
+	if (s->count == 0 || latency < s->min)
+		s->min = latency;
+	if (latency > s->max)
+		s->max = latency;
+	s->sum += latency;
+	s->count++;
+}
+
+DONT_BUILD_IF(LATENCY_STAGE_NUM != LATENCYSTATUS_MIN_NUMELEM, LatencyStageCount);
+DONT_BUILD_IF((int) LATENCYSTATUS_AVERAGE_ACTUATOR != (int) LATENCY_STAGE_ACTUATOR, LatencyStageOrder);
+DONT_BUILD_IF(LATENCY_INPUT_NUM != LATENCYSTATUS_INPUTMIN_NUMELEM, LatencyInputStageCount);
+DONT_BUILD_IF((int) LATENCYSTATUS_INPUTAVERAGE_ACTUATOR != (int) LATENCY_INPUT_ACTUATOR, LatencyInputStageOrder);
+
+#endif /* LATENCY_DIAGNOSTICS */
+
+/**
+ * @}
+ */
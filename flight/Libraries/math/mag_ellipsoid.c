@@ -0,0 +1,182 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       mag_ellipsoid.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Recursive least squares fit of the magnetometer ellipsoid
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include "mag_ellipsoid.h"		/* API declarations */
+
+//! Initial variance of the parameters, the fit starts from a sphere of radius norm
+#define INITIAL_VARIANCE 10.0f
+//! Samples closer than this to the last one used, relative to norm, are skipped
+#define MIN_SPACING 0.05f
+//! Weight of a new sample in the smoothed residual
+#define RESIDUAL_ALPHA 0.02f
+//! Samples needed before the fit can be trusted
+#define MIN_SAMPLES 300
+//! Largest diagonal of P in a converged fit. P only depends on where the
+//! samples are, it stays large while they do not cover all the axes
+#define CONVERGED_COVERAGE 0.1f
+//! Largest variance of the parameters in a converged fit, which is P scaled
+//! by the residual, about 1% error in each of them
+#define CONVERGED_VARIANCE 1e-4f
+//! Largest smoothed squared residual of a converged fit, about 5% field error
+#define CONVERGED_RESIDUAL 0.01f
+//! Largest ratio between the radii along the axes that is believable
+#define MAX_AXIS_RATIO 2.0f
+
+/**
+ * Start a new fit from a sphere around the origin
+ * @param[in] norm Rough length of the field in the units of the samples
+ */
+void mag_ellipsoid_init(struct mag_ellipsoid *me, float norm)
+{
+	memset(me, 0, sizeof(*me));
+
+	me->norm = norm;
+	for (int i = 0; i < MAG_ELLIPSOID_PARAMS; i++) {
+		me->p[i] = (i < 3) ? 1.0f : 0.0f;
+		me->P[i][i] = INITIAL_VARIANCE;
+	}
+	me->residual = 1.0f;
+}
+
+/**
+ * Update the fit with a raw sample. Samples right next to the previous one
+ * add little and would let a long stretch in one attitude dominate the fit,
+ * so they are skipped.
+ * @param[in] mag Raw sample in the sensor frame
+ * @return true if the sample was used
+ */
+bool mag_ellipsoid_add(struct mag_ellipsoid *me, const float mag[3])
+{
+	const float u[3] = { mag[0] / me->norm, mag[1] / me->norm, mag[2] / me->norm };
+
+	if (isnan(u[0]) || isnan(u[1]) || isnan(u[2]) ||
+	    isinf(u[0]) || isinf(u[1]) || isinf(u[2]))
+		return false;
+
+	const float d[3] = { u[0] - me->last[0], u[1] - me->last[1], u[2] - me->last[2] };
+	if (me->samples > 0 && d[0] * d[0] + d[1] * d[1] + d[2] * d[2] < MIN_SPACING * MIN_SPACING)
+		return false;
+
+	const float phi[MAG_ELLIPSOID_PARAMS] = { u[0] * u[0], u[1] * u[1], u[2] * u[2], u[0], u[1], u[2] };
+
+	float Pphi[MAG_ELLIPSOID_PARAMS];
+	float denom = 1.0f;
+	float err = 1.0f;
+	for (int i = 0; i < MAG_ELLIPSOID_PARAMS; i++) {
+		Pphi[i] = 0;
+		for (int j = 0; j < MAG_ELLIPSOID_PARAMS; j++)
+			Pphi[i] += me->P[i][j] * phi[j];
+		denom += phi[i] * Pphi[i];
+		err -= phi[i] * me->p[i];
+	}
+
+	// P is symmetric so only the upper half is computed, which also keeps
+	// rounding from making it drift away from symmetric
+	for (int i = 0; i < MAG_ELLIPSOID_PARAMS; i++) {
+		me->p[i] += Pphi[i] / denom * err;
+		for (int j = i; j < MAG_ELLIPSOID_PARAMS; j++) {
+			me->P[i][j] -= Pphi[i] * Pphi[j] / denom;
+			me->P[j][i] = me->P[i][j];
+		}
+	}
+
+	me->residual += (err * err - me->residual) * RESIDUAL_ALPHA;
+	me->last[0] = u[0];
+	me->last[1] = u[1];
+	me->last[2] = u[2];
+	me->samples++;
+
+	return true;
+}
+
+/**
+ * Whether the samples so far pin down all the parameters and fit them well
+ */
+bool mag_ellipsoid_converged(const struct mag_ellipsoid *me)
+{
+	if (me->samples < MIN_SAMPLES || me->residual > CONVERGED_RESIDUAL)
+		return false;
+
+	for (int i = 0; i < MAG_ELLIPSOID_PARAMS; i++)
+		if (me->P[i][i] > CONVERGED_COVERAGE || me->P[i][i] * me->residual > CONVERGED_VARIANCE)
+			return false;
+
+	return true;
+}
+
+/**
+ * Get the calibration that maps the ellipsoid onto a sphere, to be applied
+ * as mag * scale - bias
+ * @param[in] length Field length the calibrated samples should have, or 0
+ *            to keep the average length of the raw samples
+ * @param[out] bias Offset to remove after scaling
+ * @param[out] scale Gain of each axis
+ * @return true if the parameters describe a believable ellipsoid
+ */
+bool mag_ellipsoid_solve(const struct mag_ellipsoid *me, float length, float bias[3], float scale[3])
+{
+	const float *p = me->p;
+	float center[3];
+	float radius[3];
+
+	// Complete the squares: a (x - x0)^2 + b (y - y0)^2 + c (z - z0)^2 = g
+	float g = 1.0f;
+	for (int i = 0; i < 3; i++) {
+		if (!(p[i] > 0))
+			return false;
+		center[i] = -p[i + 3] / (2 * p[i]);
+		g += p[i] * center[i] * center[i];
+	}
+
+	for (int i = 0; i < 3; i++)
+		radius[i] = sqrtf(g / p[i]) * me->norm;
+
+	float rmin = fminf(radius[0], fminf(radius[1], radius[2]));
+	float rmax = fmaxf(radius[0], fmaxf(radius[1], radius[2]));
+	if (!(rmin > 0) || rmax > rmin * MAX_AXIS_RATIO)
+		return false;
+
+	if (length <= 0)
+		length = cbrtf(radius[0] * radius[1] * radius[2]);
+
+	for (int i = 0; i < 3; i++) {
+		scale[i] = length / radius[i];
+		bias[i] = center[i] * me->norm * scale[i];
+	}
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       mag_ellipsoid.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Recursive least squares fit of the magnetometer ellipsoid
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef MAG_ELLIPSOID_H
+#define MAG_ELLIPSOID_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MAG_ELLIPSOID_PARAMS 6
+
+/**
+ * Fits a x^2 + b y^2 + c z^2 + d x + e y + f z = 1 to the raw magnetometer
+ * samples one at a time, which is the hard iron offset and the soft iron
+ * scale of each axis. Samples are divided by norm so the parameters stay
+ * close to one and the fit works in single precision.
+ */
+struct mag_ellipsoid {
+	float norm;                                             //!< Rough field length the samples are scaled by
+	float p[MAG_ELLIPSOID_PARAMS];                          //!< Parameters of the fit
+	float P[MAG_ELLIPSOID_PARAMS][MAG_ELLIPSOID_PARAMS];    //!< Covariance of the parameters
+	float last[3];                                          //!< Last sample used, scaled
+	float residual;                                         //!< Smoothed squared residual
+	uint32_t samples;                                       //!< Samples used so far
+};
+
+void mag_ellipsoid_init(struct mag_ellipsoid *me, float norm);
+bool mag_ellipsoid_add(struct mag_ellipsoid *me, const float mag[3]);
+bool mag_ellipsoid_converged(const struct mag_ellipsoid *me);
+bool mag_ellipsoid_solve(const struct mag_ellipsoid *me, float length, float bias[3], float scale[3]);
+
+#endif /* MAG_ELLIPSOID_H */
+
+/**
+ * @}
+ * @}
+ */
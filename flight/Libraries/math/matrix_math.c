@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       matrix_math.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Small dense matrix kernels used by the INS filters
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "matrix_math.h" 		/* API declarations */
+
+#if defined(ARM_MATH_CM4)
+#include "arm_math.h"
+#endif
+
+/**
+ * Multiply two matrices
+ * @param[in] a left matrix with m rows and n columns
+ * @param[in] b right matrix with n rows and p columns
+ * @param[out] out result with m rows and p columns, must not alias a or b
+ */
+void matrix_mul(const float *a, const float *b, float *out,
+		uint16_t m, uint16_t n, uint16_t p)
+{
+#if defined(ARM_MATH_CM4)
+	arm_matrix_instance_f32 A, B, C;
+
+	arm_mat_init_f32(&A, m, n, (float32_t *) a);
+	arm_mat_init_f32(&B, n, p, (float32_t *) b);
+	arm_mat_init_f32(&C, m, p, out);
+
+	arm_mat_mult_f32(&A, &B, &C);
+#else
+	for (uint16_t i = 0; i < m; i++) {
+		for (uint16_t j = 0; j < p; j++) {
+			float sum = 0.0f;
+			for (uint16_t k = 0; k < n; k++)
+				sum += a[i * n + k] * b[k * p + j];
+			out[i * p + j] = sum;
+		}
+	}
+#endif
+}
+
+/**
+ * Multiply a matrix by the transpose of another one.  Both operands are
+ * walked along their rows so no transposed copy is needed.
+ * @param[in] a left matrix with m rows and n columns
+ * @param[in] b right matrix with p rows and n columns
+ * @param[out] out result with m rows and p columns, must not alias a or b
+ */
+void matrix_mul_trans(const float *a, const float *b, float *out,
+		uint16_t m, uint16_t n, uint16_t p)
+{
+	for (uint16_t i = 0; i < m; i++)
+		for (uint16_t j = 0; j < p; j++)
+			out[i * p + j] = vector_dot(&a[i * n], &b[j * n], n);
+}
+
+/**
+ * Subtract an outer product from a symmetric matrix.  Only the upper
+ * triangle is computed and then mirrored, so the result stays exactly
+ * symmetric even though k * v' is only symmetric up to rounding.
+ * @param[in,out] P symmetric matrix with n rows and n columns
+ * @param[in] k left vector of the outer product
+ * @param[in] v right vector of the outer product
+ */
+void matrix_sym_rank1_sub(float *P, const float *k, const float *v, uint16_t n)
+{
+	for (uint16_t i = 0; i < n; i++) {
+		vector_axpy(&P[i * n + i], &v[i], -k[i], n - i);
+		for (uint16_t j = i + 1; j < n; j++)
+			P[j * n + i] = P[i * n + j];
+	}
+}
+
+/**
+ * Add a scaled vector to another one in place
+ * @note CMSIS DSP has no in place multiply accumulate for vectors so this
+ * is plain C on all targets, the compiler emits fused multiply adds for it
+ */
+void vector_axpy(float *y, const float *x, float alpha, uint16_t n)
+{
+	for (uint16_t i = 0; i < n; i++)
+		y[i] += alpha * x[i];
+}
+
+/**
+ * Scale a vector
+ * @param[out] out scaled vector, may alias x
+ */
+void vector_scale(float *out, const float *x, float alpha, uint16_t n)
+{
+#if defined(ARM_MATH_CM4)
+	arm_scale_f32((float32_t *) x, alpha, out, n);
+#else
+	for (uint16_t i = 0; i < n; i++)
+		out[i] = alpha * x[i];
+#endif
+}
+
+/**
+ * Dot product of two vectors
+ */
+float vector_dot(const float *a, const float *b, uint16_t n)
+{
+#if defined(ARM_MATH_CM4)
+	float32_t result;
+
+	arm_dot_prod_f32((float32_t *) a, (float32_t *) b, n, &result);
+
+	return result;
+#else
+	float sum = 0.0f;
+
+	for (uint16_t i = 0; i < n; i++)
+		sum += a[i] * b[i];
+
+	return sum;
+#endif
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,67 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       matrix_math.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Small dense matrix kernels used by the INS filters
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef MATRIX_MATH_H
+#define MATRIX_MATH_H
+
+#include "stdint.h"
+
+/*
+ * All matrices are row major arrays of floats, so a float P[N][N] can be
+ * passed as &P[0][0].  On Cortex-M4 targets (ARM_MATH_CM4) the kernels are
+ * backed by the CMSIS DSP library, elsewhere by portable C loops.
+ */
+
+//! out(m x p) = a(m x n) * b(n x p)
+void matrix_mul(const float *a, const float *b, float *out,
+		uint16_t m, uint16_t n, uint16_t p);
+
+//! out(m x p) = a(m x n) * b(p x n)'
+void matrix_mul_trans(const float *a, const float *b, float *out,
+		uint16_t m, uint16_t n, uint16_t p);
+
+//! P(n x n) = P - k * v' for a symmetric P and a symmetric update
+void matrix_sym_rank1_sub(float *P, const float *k, const float *v, uint16_t n);
+
+//! y = y + alpha * x
+void vector_axpy(float *y, const float *x, float alpha, uint16_t n);
+
+//! out = alpha * x
+void vector_scale(float *out, const float *x, float alpha, uint16_t n);
+
+//! Dot product of two vectors
+float vector_dot(const float *a, const float *b, uint16_t n);
+
+#endif /* MATRIX_MATH_H */
+
+/**
+ * @}
+ * @}
+ */
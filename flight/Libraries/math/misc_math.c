@@ -6,7 +6,7 @@
  * @{
  *
  * @file       math_misc.c
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @brief      Miscellaneous math support
  *
  * @see        The GNU Public License (GPL) Version 3
@@ -111,7 +111,7 @@ float circular_modulus_rad(float err)
  */
 float expo3(float x, int32_t g)
 {
-	return (x * ((100 - g) / 100.0f) + powf(x, 3) * (g / 100.0f));
+	return (x * ((100 - g) / 100.0f) + x * x * x * (g / 100.0f));
 }
 
 /**
@@ -142,7 +142,7 @@ float vectorn_magnitude(const float *v, int n)
 	float sum=0;
 
 	for (int i=0; i<n; i++) {
-		sum += powf(v[i], 2);
+		sum += v[i] * v[i];
 	}
 
 	return sqrtf(sum);
@@ -310,6 +310,121 @@ uint16_t randomize_int(uint16_t interval)
 	return (uint16_t)( ((float)interval * (float)lo) / (float)0x7FFFFFFF );
 }
 
+/**
+ * Scale a vector to unit length, with one inverse square root for all
+ * elements instead of a divide for each
+ * @param[in,out] v the vector
+ * @param[in] n number of elements
+ * @returns the length the vector had, 0 if it had none and was left as is
+ */
+float vectorn_normalize(float *v, int n)
+{
+	float mag2 = 0;
+
+	for (int i = 0; i < n; i++) {
+		mag2 += v[i] * v[i];
+	}
+
+	// Also catches NaN
+	if (!(mag2 > 0))
+		return 0;
+
+	float inv_mag = ctrl_invsqrtf(mag2);
+
+	for (int i = 0; i < n; i++) {
+		v[i] *= inv_mag;
+	}
+
+	return mag2 * inv_mag;
+}
+
+/**
+ * Four quadrant arc tangent with a polynomial on [0, 1], from Abramowitz
+ * and Stegun 4.4.49
+ * @returns the angle in rad, within 2e-5 rad of atan2f(y, x); 0 for (0, 0)
+ */
+float fast_atan2f(float y, float x)
+{
+	float ax = fabsf(x);
+	float ay = fabsf(y);
+	float num = fminf(ax, ay);
+	float den = fmaxf(ax, ay);
+
+	if (den == 0)
+		return 0;
+
+	float z = num / den;
+	float z2 = z * z;
+	float a = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f +
+			z2 * (-0.0851330f + z2 * 0.0208351f))));
+
+	if (ay > ax)
+		a = (float)M_PI_2 - a;
+	if (x < 0)
+		a = (float)M_PI - a;
+
+	return y < 0 ? -a : a;
+}
+
+/**
+ * Sine and cosine of the same angle, which share the range reduction to
+ * [-pi/4, pi/4] and then are two short polynomials without branches
+ * @param[in] x the angle in rad, accurate to 1e-6 for |x| up to 100
+ * @param[out] s sin(x)
+ * @param[out] c cos(x)
+ */
+void fast_sincosf(float x, float *s, float *c)
+{
+	// Nearest multiple of pi/2, the split constant keeps r exact enough
+	int32_t k = (int32_t)(x * (float)M_2_PI + (x < 0 ? -0.5f : 0.5f));
+	float r = (x - k * 1.5703125f) - k * 4.83826794897e-4f;
+	float r2 = r * r;
+
+	float sr = r * (1 + r2 * (-1.0f / 6 + r2 * (1.0f / 120 + r2 * (-1.0f / 5040))));
+	float cr = 1 + r2 * (-0.5f + r2 * (1.0f / 24 + r2 * (-1.0f / 720 + r2 * (1.0f / 40320))));
+
+	switch (k & 3) {
+	case 0:
+		*s = sr;
+		*c = cr;
+		break;
+	case 1:
+		*s = cr;
+		*c = -sr;
+		break;
+	case 2:
+		*s = -sr;
+		*c = -cr;
+		break;
+	default:
+		*s = -cr;
+		*c = sr;
+		break;
+	}
+}
+
+/**
+ * Inverse square root from the exponent trick and two Newton steps, these
+ * are only multiplies where 1.0f / sqrtf(x) needs a VSQRT and a VDIV
+ * @param[in] x a positive number
+ * @returns 1/sqrt(x) within 1e-5 relative
+ */
+float fast_invsqrtf(float x)
+{
+	union {
+		float f;
+		uint32_t i;
+	} u = { .f = x };
+
+	u.i = 0x5f3759df - (u.i >> 1);
+
+	float half_x = 0.5f * x;
+	u.f = u.f * (1.5f - half_x * u.f * u.f);
+	u.f = u.f * (1.5f - half_x * u.f * u.f);
+
+	return u.f;
+}
+
 /**
  * @}
  * @}
@@ -66,6 +66,44 @@ float cubic_deadband(float in, float w, float b, float m, float r);
 void cubic_deadband_setup(float w, float b, float *m, float *r);
 float linear_interpolate(float const input, float const * curve, uint8_t num_points, const float input_min, const float input_max);
 uint16_t randomize_int(uint16_t interval);
+float vectorn_normalize(float *v, int n);
+
+//! Bounded-error approximations, see misc_math.c for the bounds
+float fast_atan2f(float y, float x);
+void fast_sincosf(float x, float *s, float *c);
+float fast_invsqrtf(float x);
+
+/* The control loops call these instead of libm. They are the libm
+ * functions unless the firmware is built with FAST_MATH_APPROX=YES, which
+ * trades the last digits for not going through the generic newlib code.
+ */
+#if defined(MISC_MATH_FAST)
+static inline float ctrl_atan2f(float y, float x) {
+	return fast_atan2f(y, x);
+}
+
+static inline void ctrl_sincosf(float x, float *s, float *c) {
+	fast_sincosf(x, s, c);
+}
+
+static inline float ctrl_invsqrtf(float x) {
+	return fast_invsqrtf(x);
+}
+#else
+static inline float ctrl_atan2f(float y, float x) {
+	return atan2f(y, x);
+}
+
+static inline void ctrl_sincosf(float x, float *s, float *c) {
+	*s = sinf(x);
+	*c = cosf(x);
+}
+
+static inline float ctrl_invsqrtf(float x) {
+	// A single VSQRT and VDIV with -ffast-math
+	return 1.0f / sqrtf(x);
+}
+#endif
 
 /* Note--- current compiler chain has been verified to produce proper call
  * to fpclassify even when compiling with -ffast-math / -ffinite-math.
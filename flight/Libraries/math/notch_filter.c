@@ -0,0 +1,139 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       notch_filter.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Bank of notch filters for the three gyro axes
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include "notch_filter.h"		/* API declarations */
+
+// Both define PI
+#if defined(ARM_MATH_CM4)
+#include "arm_math.h"
+#else
+#include "physical_constants.h"
+#endif
+
+/**
+ * Start with no notches, the samples pass unchanged
+ */
+void notch_filter_init(struct notch_filter *nf)
+{
+	memset(nf, 0, sizeof(*nf));
+}
+
+/**
+ * Move the notches, the state of the stages that stay in use is kept so
+ * following a peak causes no step in the output
+ * @param[in] frequencies Centre of each notch in Hz, those not below
+ *            Nyquist are left out
+ * @param[in] num_notches How many frequencies there are
+ * @param[in] sample_rate Rate apply is called at in Hz
+ * @param[in] q Centre frequency over the -3 dB width of each notch
+ * @return the number of notches in use, -1 if the parameters make no sense
+ *         and the notches were left as they were
+ */
+int32_t notch_filter_set(struct notch_filter *nf, const float *frequencies, uint8_t num_notches,
+		float sample_rate, float q)
+{
+	if (!(sample_rate > 0) || !(q > 0))
+		return -1;
+
+	uint8_t stages = 0;
+
+	for (uint8_t i = 0; i < num_notches && stages < NOTCH_FILTER_MAX_STAGES; i++) {
+		if (!(frequencies[i] > 0) || frequencies[i] >= sample_rate / 2)
+			continue;
+
+		// The notch of the Audio EQ Cookbook, normalized by a0
+		float w0 = 2 * PI * frequencies[i] / sample_rate;
+		float alpha = sinf(w0) / (2 * q);
+		float a0 = 1 + alpha;
+		float *c = &nf->coefs[5 * stages];
+
+		c[0] = 1 / a0;
+		c[1] = -2 * cosf(w0) / a0;
+		c[2] = c[0];
+		c[3] = -c[1];
+		c[4] = -(1 - alpha) / a0;
+
+		// A stage coming back into use starts from rest
+		if (stages >= nf->stages) {
+			for (uint8_t j = 0; j < NOTCH_FILTER_AXES; j++)
+				memset(&nf->state[j][4 * stages], 0, 4 * sizeof(float));
+		}
+
+		stages++;
+	}
+
+	nf->stages = stages;
+
+	return stages;
+}
+
+/**
+ * Filter one sample of each axis in place
+ * @param[in,out] samples NOTCH_FILTER_AXES values
+ */
+void notch_filter_apply(struct notch_filter *nf, float *samples)
+{
+	if (nf->stages == 0)
+		return;
+
+	for (uint8_t i = 0; i < NOTCH_FILTER_AXES; i++) {
+#if defined(ARM_MATH_CM4)
+		// The instance only points at the arrays, the init function
+		// would clear the state
+		arm_biquad_casd_df1_inst_f32 inst = {
+			.numStages = nf->stages,
+			.pState = nf->state[i],
+			.pCoeffs = nf->coefs,
+		};
+		arm_biquad_cascade_df1_f32(&inst, &samples[i], &samples[i], 1);
+#else
+		float x = samples[i];
+		for (uint8_t s = 0; s < nf->stages; s++) {
+			const float *c = &nf->coefs[5 * s];
+			float *st = &nf->state[i][4 * s];
+			float y = c[0] * x + c[1] * st[0] + c[2] * st[1] + c[3] * st[2] + c[4] * st[3];
+
+			st[1] = st[0];
+			st[0] = x;
+			st[3] = st[2];
+			st[2] = y;
+			x = y;
+		}
+		samples[i] = x;
+#endif
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
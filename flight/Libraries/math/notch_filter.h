@@ -0,0 +1,61 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       notch_filter.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Bank of notch filters for the three gyro axes
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef NOTCH_FILTER_H
+#define NOTCH_FILTER_H
+
+#include <stdint.h>
+
+#define NOTCH_FILTER_MAX_STAGES 3
+#define NOTCH_FILTER_AXES 3
+
+/**
+ * Up to NOTCH_FILTER_MAX_STAGES biquad notches in cascade, the same for
+ * each axis. The coefficients are kept in the order the CMSIS biquads
+ * use, b0 b1 b2 a1 a2 per stage with the a terms negated, so the F4 runs
+ * arm_biquad_cascade_df1_f32 on them directly.
+ */
+struct notch_filter {
+	uint8_t stages;                                       //!< Notches in use, 0 passes the samples through
+	float coefs[5 * NOTCH_FILTER_MAX_STAGES];
+	float state[NOTCH_FILTER_AXES][4 * NOTCH_FILTER_MAX_STAGES];  //!< x[n-1] x[n-2] y[n-1] y[n-2] per stage
+};
+
+void notch_filter_init(struct notch_filter *nf);
+int32_t notch_filter_set(struct notch_filter *nf, const float *frequencies, uint8_t num_notches,
+		float sample_rate, float q);
+void notch_filter_apply(struct notch_filter *nf, float *samples);
+
+#endif /* NOTCH_FILTER_H */
+
+/**
+ * @}
+ * @}
+ */
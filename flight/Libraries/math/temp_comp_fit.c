@@ -0,0 +1,205 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       temp_comp_fit.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Fit of the gyro bias over temperature from binned samples
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <math.h>
+#include <string.h>
+#include "temp_comp_fit.h"		/* API declarations */
+
+//! Samples a bin needs before it is used in the fit
+#define MIN_BIN_SAMPLES 200
+//! Bins needed for the fit, one more than the parameters so noise shows
+#define MIN_FILLED_BINS (TEMP_COMP_FIT_ORDER + 2)
+
+#define NUM_PARAMS (TEMP_COMP_FIT_ORDER + 1)
+
+void temp_comp_fit_init(struct temp_comp_fit *tf)
+{
+	memset(tf, 0, sizeof(*tf));
+}
+
+/**
+ * Add a gyro sample of the still board to the bin of its temperature
+ * @param[in] gyro Rates in the sensor frame before any bias correction
+ * @return true if this sample completed a bin, which is when solving again
+ *         gives a different answer
+ */
+bool temp_comp_fit_add(struct temp_comp_fit *tf, float temperature, const float gyro[3])
+{
+	if (isnan(temperature) || isnan(gyro[0]) || isnan(gyro[1]) || isnan(gyro[2]))
+		return false;
+
+	float pos = (temperature - TEMP_COMP_FIT_MIN_TEMP) / TEMP_COMP_FIT_BIN_WIDTH;
+	if (!(pos >= 0 && pos < TEMP_COMP_FIT_BINS))
+		return false;
+
+	struct temp_comp_bin *bin = &tf->bins[(int)pos];
+
+	// Once the count saturates this becomes a slow running average
+	if (bin->count < UINT16_MAX)
+		bin->count++;
+
+	float w = 1.0f / bin->count;
+	bin->temp += (temperature - bin->temp) * w;
+	for (int i = 0; i < 3; i++)
+		bin->mean[i] += (gyro[i] - bin->mean[i]) * w;
+
+	if (bin->count == MIN_BIN_SAMPLES) {
+		tf->filled++;
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Temperature span between the coldest and the warmest bin that is used
+ */
+float temp_comp_fit_range(const struct temp_comp_fit *tf)
+{
+	int first = -1, last = -1;
+	for (int i = 0; i < TEMP_COMP_FIT_BINS; i++) {
+		if (tf->bins[i].count >= MIN_BIN_SAMPLES) {
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	}
+
+	if (first < 0)
+		return 0;
+
+	return tf->bins[last].temp - tf->bins[first].temp;
+}
+
+/**
+ * Least squares fit of a polynomial in temperature to the bin means, giving
+ * each bin the same weight
+ * @param[out] coeffs the coefficients of each axis, constant term first, as
+ *             SensorSettings keeps them
+ * @return false if there are not enough bins
+ */
+bool temp_comp_fit_solve(const struct temp_comp_fit *tf, float coeffs[3][TEMP_COMP_FIT_ORDER + 1])
+{
+	if (tf->filled < MIN_FILLED_BINS)
+		return false;
+
+	// Fit in a temperature shifted and scaled to [-1, 1], powers of the raw
+	// temperature make the normal equations too badly conditioned for floats
+	float range = temp_comp_fit_range(tf);
+	if (!(range > 0))
+		return false;
+
+	float t_min = INFINITY;
+	for (int i = 0; i < TEMP_COMP_FIT_BINS; i++)
+		if (tf->bins[i].count >= MIN_BIN_SAMPLES && tf->bins[i].temp < t_min)
+			t_min = tf->bins[i].temp;
+
+	const float half = range / 2;
+	const float center = t_min + half;
+
+	float A[NUM_PARAMS][NUM_PARAMS + 3];
+	memset(A, 0, sizeof(A));
+
+	for (int b = 0; b < TEMP_COMP_FIT_BINS; b++) {
+		if (tf->bins[b].count < MIN_BIN_SAMPLES)
+			continue;
+
+		float s = (tf->bins[b].temp - center) / half;
+		float phi[NUM_PARAMS];
+		phi[0] = 1;
+		for (int i = 1; i < NUM_PARAMS; i++)
+			phi[i] = phi[i - 1] * s;
+
+		for (int i = 0; i < NUM_PARAMS; i++) {
+			for (int j = 0; j < NUM_PARAMS; j++)
+				A[i][j] += phi[i] * phi[j];
+			for (int k = 0; k < 3; k++)
+				A[i][NUM_PARAMS + k] += phi[i] * tf->bins[b].mean[k];
+		}
+	}
+
+	// Gauss-Jordan elimination with partial pivoting on [A | B]
+	for (int c = 0; c < NUM_PARAMS; c++) {
+		int pivot = c;
+		for (int r = c + 1; r < NUM_PARAMS; r++)
+			if (fabsf(A[r][c]) > fabsf(A[pivot][c]))
+				pivot = r;
+
+		if (!(fabsf(A[pivot][c]) > 1e-6f))
+			return false;
+
+		if (pivot != c) {
+			for (int j = 0; j < NUM_PARAMS + 3; j++) {
+				float tmp = A[c][j];
+				A[c][j] = A[pivot][j];
+				A[pivot][j] = tmp;
+			}
+		}
+
+		for (int r = 0; r < NUM_PARAMS; r++) {
+			if (r == c)
+				continue;
+			float f = A[r][c] / A[c][c];
+			for (int j = c; j < NUM_PARAMS + 3; j++)
+				A[r][j] -= f * A[c][j];
+		}
+	}
+
+	// Expand sum a_k ((t - center) / half)^k into powers of t
+	static const float binomial[NUM_PARAMS][NUM_PARAMS] = {
+		{1, 0, 0, 0},
+		{1, 1, 0, 0},
+		{1, 2, 1, 0},
+		{1, 3, 3, 1},
+	};
+
+	for (int axis = 0; axis < 3; axis++) {
+		for (int j = 0; j < NUM_PARAMS; j++)
+			coeffs[axis][j] = 0;
+
+		float inv_half_k = 1;
+		for (int k = 0; k < NUM_PARAMS; k++) {
+			float a = A[k][NUM_PARAMS + axis] / A[k][k] * inv_half_k;
+			float shift = 1;
+			for (int j = k; j >= 0; j--) {
+				coeffs[axis][j] += a * binomial[k][j] * shift;
+				shift *= -center;
+			}
+			inv_half_k /= half;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @}
+ * @}
+ */
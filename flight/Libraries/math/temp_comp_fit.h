@@ -0,0 +1,69 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TauLabsMath Tau Labs math support libraries
+ * @{
+ *
+ * @file       temp_comp_fit.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Fit of the gyro bias over temperature from binned samples
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TEMP_COMP_FIT_H
+#define TEMP_COMP_FIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TEMP_COMP_FIT_MIN_TEMP -10.0f   //!< Same range the sensors module clamps to
+#define TEMP_COMP_FIT_BIN_WIDTH 2.0f
+#define TEMP_COMP_FIT_BINS 35
+#define TEMP_COMP_FIT_ORDER 3
+
+/**
+ * Mean gyro reading of a still board in bins of temperature. The samples
+ * of a slow warm-up pile up in a few bins, so keeping only the mean of each
+ * bin needs little memory and gives every temperature the same weight in
+ * the polynomial fit.
+ */
+struct temp_comp_bin {
+	float temp;             //!< Mean temperature of the samples in the bin
+	float mean[3];
+	uint16_t count;
+};
+
+struct temp_comp_fit {
+	struct temp_comp_bin bins[TEMP_COMP_FIT_BINS];
+	uint8_t filled;         //!< Bins with enough samples to be used
+};
+
+void temp_comp_fit_init(struct temp_comp_fit *tf);
+bool temp_comp_fit_add(struct temp_comp_fit *tf, float temperature, const float gyro[3]);
+float temp_comp_fit_range(const struct temp_comp_fit *tf);
+bool temp_comp_fit_solve(const struct temp_comp_fit *tf, float coeffs[3][TEMP_COMP_FIT_ORDER + 1]);
+
+#endif /* TEMP_COMP_FIT_H */
+
+/**
+ * @}
+ * @}
+ */
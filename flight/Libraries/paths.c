@@ -4,7 +4,7 @@
  * @{
  *
  * @file       paths.c
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
  * @brief      Path calculation library with common API
  *
@@ -40,86 +40,224 @@
 #include "pathdesired.h"
 
 // private functions
-static void path_endpoint(const float * start_point, const float * end_point,
-                          const float * cur_point, struct path_status * status);
-static void path_vector(const float * start_point, const float * end_point,
-                        const float * cur_point, struct path_status * status);
-static void path_circle(const float * center_point, float radius,
-                        const float * cur_point, struct path_status * status,
-                        bool clockwise);
-static void path_curve(const float * start_point, const float * end_point,
-                       float radius, const float * cur_point,
-                       struct path_status * status, bool clockwise);
+static void prepare_curve(struct path_segment *segment, float radius, bool clockwise);
+static void path_endpoint(const struct path_segment *segment,
+                          const float *cur_point, struct path_status *status);
+static void path_vector(const struct path_segment *segment,
+                        const float *cur_point, struct path_status *status);
+static void path_circle(const struct path_segment *segment,
+                        const float *cur_point, struct path_status *status);
+static void path_curve(const struct path_segment *segment,
+                       const float *cur_point, struct path_status *status);
 
 /**
  * @brief Compute progress along path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
+ * @param[in] pathDesired The path
  * @param[in] cur_point Current location
- * @param[in] mode Path following mode
  * @param[out] status Structure containing progress along path and deviation
+ *
+ * Works out the geometry of the path on every call, followers should keep a
+ * @ref path_segment instead.
  */
 void path_progress(const PathDesiredData *pathDesired,
                    const float *cur_point,
                    struct path_status *status)
 {
-	uint8_t mode = pathDesired->Mode;
-	float start_point[2] = {pathDesired->Start[0],pathDesired->Start[1]};
-	float end_point[2] = {pathDesired->End[0],pathDesired->End[1]};
+	struct path_segment segment;
+	segment.valid = false;
+
+	path_segment_update(&segment, pathDesired);
+	path_segment_progress(&segment, cur_point, status);
+}
+
+/**
+ * @brief Work out the geometry of a path, unless the segment already has it
+ * @param[in,out] segment The geometry, set valid to false before the first call
+ * @param[in] pathDesired The path
+ *
+ * This is cheap when the path didn't change, so it can be called before each
+ * @ref path_segment_progress.
+ * @return true if the path changed
+ */
+bool path_segment_update(struct path_segment *segment, const PathDesiredData *pathDesired)
+{
+	if (segment->valid &&
+	    segment->mode == pathDesired->Mode &&
+	    segment->mode_parameters == pathDesired->ModeParameters &&
+	    segment->start[0] == pathDesired->Start[0] &&
+	    segment->start[1] == pathDesired->Start[1] &&
+	    segment->end[0] == pathDesired->End[0] &&
+	    segment->end[1] == pathDesired->End[1])
+		return false;
+
+	segment->mode = pathDesired->Mode;
+	segment->mode_parameters = pathDesired->ModeParameters;
+	segment->start[0] = pathDesired->Start[0];
+	segment->start[1] = pathDesired->Start[1];
+	segment->end[0] = pathDesired->End[0];
+	segment->end[1] = pathDesired->End[1];
+
+	// Distance to go
+	float path_north = segment->end[0] - segment->start[0];
+	float path_east = segment->end[1] - segment->start[1];
+
+	segment->length = sqrtf(path_north * path_north + path_east * path_east);
+	if (segment->length > 0) {
+		segment->direction[0] = path_north / segment->length;
+		segment->direction[1] = path_east / segment->length;
+	} else {
+		segment->direction[0] = segment->direction[1] = 0;
+	}
+
+	// The normal to the path
+	segment->normal[0] = -segment->direction[1];
+	segment->normal[1] = segment->direction[0];
+
+	switch (segment->mode) {
+	case PATHDESIRED_MODE_CIRCLERIGHT:
+		prepare_curve(segment, segment->mode_parameters, true);
+		break;
+	case PATHDESIRED_MODE_CIRCLELEFT:
+		prepare_curve(segment, segment->mode_parameters, false);
+		break;
+	case PATHDESIRED_MODE_CIRCLEPOSITIONLEFT:
+	case PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT:
+		segment->center[0] = segment->end[0];
+		segment->center[1] = segment->end[1];
+		segment->radius = segment->mode_parameters;
+		if (segment->radius < 0.10f) {
+			segment->radius = 0.10f;	// Never try a circle less than 10cm
+		}
+		segment->clockwise = segment->mode == PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT;
+		break;
+	default:
+		break;
+	}
+
+	segment->valid = true;
+
+	return true;
+}
 
-	switch(mode) {
+/**
+ * @brief Compute progress along path and deviation from it
+ * @param[in] segment The geometry from @ref path_segment_update
+ * @param[in] cur_point Current location
+ * @param[out] status Structure containing progress along path and deviation
+ */
+void path_segment_progress(const struct path_segment *segment,
+                           const float *cur_point,
+                           struct path_status *status)
+{
+	switch(segment->mode) {
 		case PATHDESIRED_MODE_VECTOR:
-			return path_vector(start_point, end_point, cur_point, status);
+			return path_vector(segment, cur_point, status);
 			break;
 		case PATHDESIRED_MODE_CIRCLERIGHT:
-			return path_curve(start_point, end_point, pathDesired->ModeParameters, cur_point, status, 1);
-			break;
 		case PATHDESIRED_MODE_CIRCLELEFT:
-			return path_curve(start_point, end_point, pathDesired->ModeParameters, cur_point, status, 0);
+			return path_curve(segment, cur_point, status);
 			break;
 		case PATHDESIRED_MODE_CIRCLEPOSITIONLEFT:
-			return path_circle(end_point, pathDesired->ModeParameters, cur_point, status, 0);
-			break;
 		case PATHDESIRED_MODE_CIRCLEPOSITIONRIGHT:
-			return path_circle(end_point, pathDesired->ModeParameters, cur_point, status, 1);
+			return path_circle(segment, cur_point, status);
 			break;
 		case PATHDESIRED_MODE_ENDPOINT:
 		case PATHDESIRED_MODE_HOLDPOSITION:
 		default:
 			// use the endpoint as default failsafe if called in unknown modes
-			return path_endpoint(start_point, end_point, cur_point, status);
+			return path_endpoint(segment, cur_point, status);
 			break;
 	}
 }
 
+/**
+ * @brief Work out the circle through the start and end of a curve segment
+ * @param[in,out] segment The segment with its start, end and length
+ * @param[in] radius Radius of the curve segment
+ * @param[in] clockwise Direction of the curve
+ */
+static void prepare_curve(struct path_segment *segment, float radius, bool clockwise)
+{
+	const float *start_point = segment->start;
+	const float *end_point = segment->end;
+
+	// OK for up to 10km
+	float min_radius = segment->length / 2.0f + 0.01f;
+
+	if (fabsf(radius) < min_radius) {
+		// This was possibly floating point confusion.
+		// Add 5cm and .5% and call it good.
+		if (radius >= 0) {
+			radius += 0.05f;
+		} else {
+			radius -= 0.05f;
+		}
+
+		radius *= 1.005f;
+
+		if (fabsf(radius) < min_radius) {
+			// Whoops! Radius was not close.  Convert to (nearly)
+			// straight line.
+			radius = min_radius * 1000;
+		}
+	}
+
+	// Compute the center of the circle connecting the two points as the intersection of two circles
+	// around the two points from
+	// http://www.mathworks.com/matlabcentral/newsreader/view_thread/255121
+	float m_n, m_e, p_n, p_e, d;
+
+	// Center between start and end
+	m_n = (start_point[0] + end_point[0]) / 2;
+	m_e = (start_point[1] + end_point[1]) / 2;
+
+	// Normal vector the line between start and end.
+	if (clockwise) {
+		p_n = -(end_point[1] - start_point[1]);
+		p_e = (end_point[0] - start_point[0]);
+	} else {
+		p_n = (end_point[1] - start_point[1]);
+		p_e = -(end_point[0] - start_point[0]);		
+	}
+
+	// Work out how far to go along the perpendicular bisector
+	d = sqrtf(radius * radius / (p_n * p_n + p_e * p_e) - 0.25f);
+
+	float radius_sign = (radius > 0) ? 1 : -1;
+
+	if (fabsf(p_n) < 1e-3f && fabsf(p_e) < 1e-3f) {
+		segment->center[0] = m_n;
+		segment->center[1] = m_e;
+	} else {
+		segment->center[0] = m_n + p_n * d * radius_sign;
+		segment->center[1] = m_e + p_e * d * radius_sign;
+	}
+
+	segment->radius = fabsf(radius);
+	segment->clockwise = clockwise;
+}
+
 /**
  * @brief Compute progress towards endpoint. Deviation equals distance
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
+ * @param[in] segment The geometry of the path
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_endpoint(const float *start_point,
-                          const float *end_point,
+static void path_endpoint(const struct path_segment *segment,
                           const float *cur_point,
                           struct path_status *status)
 {
-	float path_north, path_east, diff_north, diff_east;
-	float dist_path, dist_diff;
+	float diff_north, diff_east;
+	float dist_diff;
 
 	// we do not correct in this mode
 	status->correction_direction[0] = status->correction_direction[1] = 0;
 
-	// Distance to go
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-
 	// Current progress location relative to end
-	diff_north = end_point[0] - cur_point[0];
-	diff_east = end_point[1] - cur_point[1];
+	diff_north = segment->end[0] - cur_point[0];
+	diff_east = segment->end[1] - cur_point[1];
 
 	dist_diff = sqrtf( diff_north * diff_north + diff_east * diff_east );
-	dist_path = sqrtf( path_north * path_north + path_east * path_east );
 
 	if(dist_diff < 1e-6f ) {
 		status->fractional_progress = 1;
@@ -128,7 +266,7 @@ static void path_endpoint(const float *start_point,
 		return;
 	}
 
-	status->fractional_progress = 1 - dist_diff / (1 + dist_path);
+	status->fractional_progress = 1 - dist_diff / (1 + segment->length);
 	status->error = dist_diff;
 
 	// Compute direction to travel
@@ -138,92 +276,70 @@ static void path_endpoint(const float *start_point,
 
 /**
  * @brief Compute progress along path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
+ * @param[in] segment The geometry of the path
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_vector(const float *start_point,
-                        const float *end_point,
+static void path_vector(const struct path_segment *segment,
                         const float *cur_point,
                         struct path_status *status)
 {
-	float path_north, path_east, diff_north, diff_east;
-	float dist_path;
-	float dot;
-	float normal[2];
-
-	// Distance to go
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-
-	// Current progress location relative to start
-	diff_north = cur_point[0] - start_point[0];
-	diff_east = cur_point[1] - start_point[1];
-
-	dot = path_north * diff_north + path_east * diff_east;
-	dist_path = sqrtf( path_north * path_north + path_east * path_east );
+	float diff_north, diff_east;
 
-	if(dist_path < 1e-6f) {
+	if(segment->length < 1e-6f) {
 		// if the path is too short, we cannot determine vector direction.
 		// Fly towards the endpoint to prevent flying away,
 		// but assume progress=1 either way.
-		path_endpoint( start_point, end_point, cur_point, status );
+		path_endpoint( segment, cur_point, status );
 		status->fractional_progress = 1;
 		return;
 	}
 
-	// Compute the normal to the path
-	normal[0] = -path_east / dist_path;
-	normal[1] = path_north / dist_path;
+	// Current progress location relative to start
+	diff_north = cur_point[0] - segment->start[0];
+	diff_east = cur_point[1] - segment->start[1];
 
-	status->fractional_progress = dot / (dist_path * dist_path);
-	status->error = normal[0] * diff_north + normal[1] * diff_east;
+	status->fractional_progress = (segment->direction[0] * diff_north +
+		segment->direction[1] * diff_east) / segment->length;
+	status->error = segment->normal[0] * diff_north + segment->normal[1] * diff_east;
 
 	// Compute direction to correct error
-	status->correction_direction[0] = (status->error > 0) ? -normal[0] : normal[0];
-	status->correction_direction[1] = (status->error > 0) ? -normal[1] : normal[1];
+	status->correction_direction[0] = (status->error > 0) ? -segment->normal[0] : segment->normal[0];
+	status->correction_direction[1] = (status->error > 0) ? -segment->normal[1] : segment->normal[1];
 	
 	// Now just want magnitude of error
 	status->error = fabsf(status->error);
 
 	// Compute direction to travel
-	status->path_direction[0] = path_north / dist_path;
-	status->path_direction[1] = path_east / dist_path;
+	status->path_direction[0] = segment->direction[0];
+	status->path_direction[1] = segment->direction[1];
 
 }
 
 /**
  * @brief Circle location continuously
- * @param[in] start_point Starting point
- * @param[in] end_point Center point
+ * @param[in] segment The geometry of the path, centered on its end
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_circle(const float * center_point,
-                        float radius,
+static void path_circle(const struct path_segment *segment,
                         const float * cur_point,
-                        struct path_status * status,
-                        bool clockwise)
+                        struct path_status * status)
 {
 	float diff_north, diff_east;
 	float cradius;
 	float normal[2];
 
-	if (radius < 0.10f) {
-		radius = 0.10f;		// Never try a circle less than 10cm
-	}
-
 	// Current location relative to center
-	diff_north = cur_point[0] - center_point[0];
-	diff_east = cur_point[1] - center_point[1];
+	diff_north = cur_point[0] - segment->center[0];
+	diff_east = cur_point[1] - segment->center[1];
 
 	cradius = sqrtf(  diff_north * diff_north   +   diff_east * diff_east );
 
 	if (cradius < 1e-6f) {
 		// cradius is zero, just fly somewhere and make sure correction is still a normal
 		status->fractional_progress = 1;
-		status->error = radius;
+		status->error = segment->radius;
 		status->correction_direction[0] = 0;
 		status->correction_direction[1] = 1;
 		status->path_direction[0] = 1;
@@ -231,7 +347,7 @@ static void path_circle(const float * center_point,
 		return;
 	}
 
-	if (clockwise) {
+	if (segment->clockwise) {
 		// Compute the normal to the radius clockwise
 		normal[0] = -diff_east / cradius;
 		normal[1] = diff_north / cradius;
@@ -244,7 +360,7 @@ static void path_circle(const float * center_point,
 	status->fractional_progress = 0;
 
 	// error is current radius minus wanted radius - positive if too close
-	status->error = radius - cradius;
+	status->error = segment->radius - cradius;
 
 	// Compute direction to correct error
 	status->correction_direction[0] = (status->error>0?1:-1) * diff_north / cradius;
@@ -259,93 +375,33 @@ static void path_circle(const float * center_point,
 
 /**
  * @brief Compute progress along circular path and deviation from it
- * @param[in] start_point Starting point
- * @param[in] end_point Ending point
- * @param[in] radius Radius of the curve segment
+ * @param[in] segment The geometry of the path with the center of the curve
  * @param[in] cur_point Current location
  * @param[out] status Structure containing progress along path and deviation
  */
-static void path_curve(const float * start_point,
-                       const float * end_point,
-                       float radius,
+static void path_curve(const struct path_segment *segment,
                        const float * cur_point,
-                       struct path_status *status,
-                       bool clockwise)
+                       struct path_status *status)
 {
-	// OK for up to 10km
-	float min_radius = sqrtf(powf(start_point[0] - end_point[0], 2) +
-		powf(start_point[1] - end_point[1], 2)) / 2.0f + 0.01f;
-
-	if (fabsf(radius) < min_radius) {
-		// This was possibly floating point confusion.
-		// Add 5cm and .5% and call it good.
-		if (radius >= 0) {
-			radius += 0.05f;
-		} else {
-			radius -= 0.05f;
-		}
-
-		radius *= 1.005f;
-
-		if (fabsf(radius) < min_radius) {
-			// Whoops! Radius was not close.  Convert to (nearly)
-			// straight line.
-			radius = min_radius * 1000;
-		}
-	}
-
 	float diff_north, diff_east;
-	float path_north, path_east;
 	float cradius;
 	float normal[2];
 
-	// Compute the center of the circle connecting the two points as the intersection of two circles
-	// around the two points from
-	// http://www.mathworks.com/matlabcentral/newsreader/view_thread/255121
-	float m_n, m_e, p_n, p_e, d, center[2];
-
-	// Center between start and end
-	m_n = (start_point[0] + end_point[0]) / 2;
-	m_e = (start_point[1] + end_point[1]) / 2;
-
-	// Normal vector the line between start and end.
-	if (clockwise) {
-		p_n = -(end_point[1] - start_point[1]);
-		p_e = (end_point[0] - start_point[0]);
-	} else {
-		p_n = (end_point[1] - start_point[1]);
-		p_e = -(end_point[0] - start_point[0]);		
-	}
-
-	// Work out how far to go along the perpendicular bisector
-	d = sqrtf(radius * radius / (p_n * p_n + p_e * p_e) - 0.25f);
-
-	float radius_sign = (radius > 0) ? 1 : -1;
-	float m_radius = fabsf(radius);
-
-	if (fabsf(p_n) < 1e-3f && fabsf(p_e) < 1e-3f) {
-		center[0] = m_n;
-		center[1] = m_e;
-	} else {
-		center[0] = m_n + p_n * d * radius_sign;
-		center[1] = m_e + p_e * d * radius_sign;
-	}
-
 	// Current location relative to center
-	diff_north = cur_point[0] - center[0];
-	diff_east = cur_point[1] - center[1];
+	diff_north = cur_point[0] - segment->center[0];
+	diff_east = cur_point[1] - segment->center[1];
 
 	// Compute current radius from the center
 	cradius = sqrtf(  diff_north * diff_north   +   diff_east * diff_east );
 
 	// Compute error in terms of meters from the curve (the distance projected
 	// normal onto the path i.e. cross-track distance)
-	status->error = m_radius - cradius;
+	status->error = segment->radius - cradius;
 
 	if (cradius < 1e-6f) {
 		// cradius is zero, just fly somewhere and make sure correction is still a normal
 		status->fractional_progress = 1;
-		status->error = m_radius;
+		status->error = segment->radius;
 		status->correction_direction[0] = 0;
 		status->correction_direction[1] = 1;
 		status->path_direction[0] = 1;
@@ -353,7 +409,7 @@ static void path_curve(const float * start_point,
 		return;
 	}
 
-	if (clockwise) {
+	if (segment->clockwise) {
 		// Compute the normal to the radius clockwise
 		normal[0] = -diff_east / cradius;
 		normal[1] = diff_north / cradius;
@@ -371,14 +427,11 @@ static void path_curve(const float * start_point,
 	status->path_direction[0] = normal[0];
 	status->path_direction[1] = normal[1];
 
-	path_north = end_point[0] - start_point[0];
-	path_east = end_point[1] - start_point[1];
-	diff_north = cur_point[0] - start_point[0];
-	diff_east = cur_point[1] - start_point[1];
-	float dist_path = sqrtf( path_north * path_north + path_east * path_east );
-	float dot = path_north * diff_north + path_east * diff_east;
+	diff_north = cur_point[0] - segment->start[0];
+	diff_east = cur_point[1] - segment->start[1];
 
-	status->fractional_progress = dot / (dist_path * dist_path);
+	status->fractional_progress = (segment->direction[0] * diff_north +
+		segment->direction[1] * diff_east) / segment->length;
 
 	status->error = fabsf(status->error);
 }
@@ -38,47 +38,34 @@
 #include <stdio.h>
 #include "ecc.h"
 
-/* The Error Locator Polynomial, also known as Lambda or Sigma. Lambda[0] == 1 */
-static int Lambda[MAXDEG];
-
-/* The Error Evaluator Polynomial */
-static int Omega[MAXDEG];
-
 /* local ANSI declarations */
-static int compute_discrepancy(int lambda[], int S[], int L, int n);
-static void init_gamma(int gamma[]);
-static void compute_modified_omega (void);
-static void mul_z_poly (int src[]);
-
-/* error locations found using Chien's search*/
-static int ErrorLocs[256];
-static int NErrors;
-
-/* erasure flags */
-static int ErasureLocs[256];
-static int NErasures;
+static uint8_t compute_discrepancy(const uint8_t lambda[], const uint8_t S[], int L, int n);
+static void init_gamma(const struct rs_decoder *dec, uint8_t gamma[]);
+static void compute_modified_omega (struct rs_decoder *dec);
+static void mul_z_poly (uint8_t src[]);
 
 /* From  Cain, Clark, "Error-Correction Coding For Digital Communications", pp. 216. */
-void
-Modified_Berlekamp_Massey (void)
+static void
+Modified_Berlekamp_Massey (struct rs_decoder *dec)
 {	
-  int n, L, L2, k, d, i;
-  int psi[MAXDEG], psi2[MAXDEG], D[MAXDEG];
-  int gamma[MAXDEG];
+  int n, L, L2, k, i;
+  uint8_t d;
+  uint8_t psi[MAXDEG], psi2[MAXDEG], D[MAXDEG];
+  uint8_t gamma[MAXDEG];
 	
   /* initialize Gamma, the erasure locator polynomial */
-  init_gamma(gamma);
+  init_gamma(dec, gamma);
 
   /* initialize to z */
   copy_poly(D, gamma);
   mul_z_poly(D);
 	
   copy_poly(psi, gamma);	
-  k = -1; L = NErasures;
+  k = -1; L = dec->NErasures;
 	
-  for (n = NErasures; n < RS_ECC_NPARITY; n++) {
+  for (n = dec->NErasures; n < RS_ECC_NPARITY; n++) {
 	
-    d = compute_discrepancy(psi, synBytes, L, n);
+    d = compute_discrepancy(psi, dec->synBytes, L, n);
 		
     if (d != 0) {
 		
@@ -90,99 +77,88 @@ Modified_Berlekamp_Massey (void)
 	L2 = n-k;
 	k = n-L;
 	/* D = scale_poly(ginv(d), psi); */
-	for (i = 0; i < MAXDEG; i++) D[i] = gmult(psi[i], ginv(d));
+	uint8_t dinv = ginv(d);
+	for (i = 0; i < MAXDEG; i++) D[i] = gmult(psi[i], dinv);
 	L = L2;
       }
 			
       /* psi = psi2 */
-      for (i = 0; i < MAXDEG; i++) psi[i] = psi2[i];
+      copy_poly(psi, psi2);
     }
 		
     mul_z_poly(D);
   }
 	
-  for(i = 0; i < MAXDEG; i++) Lambda[i] = psi[i];
-  compute_modified_omega();
+  copy_poly(dec->Lambda, psi);
+  compute_modified_omega(dec);
 
 	
 }
 
 /* given Psi (called Lambda in Modified_Berlekamp_Massey) and synBytes,
    compute the combined erasure/error evaluator polynomial as 
-   Psi*S mod z^4
+   Psi*S mod z^RS_ECC_NPARITY, only the terms that are kept are multiplied
   */
-void
-compute_modified_omega ()
+static void
+compute_modified_omega (struct rs_decoder *dec)
 {
-  int i;
-  int product[MAXDEG*2];
+  int i, j;
 	
-  mult_polys(product, Lambda, synBytes);	
-  zero_poly(Omega);
-  for(i = 0; i < RS_ECC_NPARITY; i++) Omega[i] = product[i];
-
+  zero_poly(dec->Omega);
+  for (i = 0; i < RS_ECC_NPARITY; i++) {
+    uint8_t sum = 0;
+    for (j = 0; j <= i; j++)
+      sum ^= gmult(dec->Lambda[j], dec->synBytes[i-j]);
+    dec->Omega[i] = sum;
+  }
 }
 
 /* polynomial multiplication */
 void
-mult_polys (int dst[], int p1[], int p2[])
+mult_polys (uint8_t dst[], const uint8_t p1[], const uint8_t p2[])
 {
   int i, j;
-  int tmp1[MAXDEG*2];
 	
   for (i=0; i < (MAXDEG*2); i++) dst[i] = 0;
 	
   for (i = 0; i < MAXDEG; i++) {
-    for(j=MAXDEG; j<(MAXDEG*2); j++) tmp1[j]=0;
-		
-    /* scale tmp1 by p1[i] */
-    for(j=0; j<MAXDEG; j++) tmp1[j]=gmult(p2[j], p1[i]);
-    /* and mult (shift) tmp1 right by i */
-    for (j = (MAXDEG*2)-1; j >= i; j--) tmp1[j] = tmp1[j-i];
-    for (j = 0; j < i; j++) tmp1[j] = 0;
-		
-    /* add into partial product */
-    for(j=0; j < (MAXDEG*2); j++) dst[j] ^= tmp1[j];
+    if (p1[i] == 0)
+      continue;
+
+    /* add p2 scaled by p1[i] and shifted right by i */
+    for (j = 0; j < MAXDEG; j++)
+      dst[i+j] ^= gmult(p2[j], p1[i]);
   }
 }
 
 
 	
 /* gamma = product (1-z*a^Ij) for erasure locs Ij */
-void
-init_gamma (int gamma[])
+static void
+init_gamma (const struct rs_decoder *dec, uint8_t gamma[])
 {
-  int e, tmp[MAXDEG];
+  int e;
+  uint8_t tmp[MAXDEG];
 	
   zero_poly(gamma);
   zero_poly(tmp);
   gamma[0] = 1;
 	
-  for (e = 0; e < NErasures; e++) {
+  for (e = 0; e < dec->NErasures; e++) {
     copy_poly(tmp, gamma);
-    scale_poly(gexp[ErasureLocs[e]], tmp);
+    scale_poly(gexp[dec->ErasureLocs[e]], tmp);
     mul_z_poly(tmp);
     add_polys(gamma, tmp);
   }
 }
 	
 	
-	
-void 
-compute_next_omega (int d, int A[], int dst[], int src[])
-{
-  int i;
-  for ( i = 0; i < MAXDEG;  i++) {
-    dst[i] = src[i] ^ gmult(d, A[i]);
-  }
-}
-	
-
 
-int
-compute_discrepancy (int lambda[], int S[], int L, int n)
+static uint8_t
+compute_discrepancy (const uint8_t lambda[], const uint8_t S[], int L, int n)
 {
-  int i, sum=0;
+  int i;
+  uint8_t sum=0;
 	
   for (i = 0; i <= L; i++) 
     sum ^= gmult(lambda[i], S[n-i]);
@@ -191,26 +167,26 @@ compute_discrepancy (int lambda[], int S[], int L, int n)
 
 /********** polynomial arithmetic *******************/
 
-void add_polys (int dst[], int src[]) 
+void add_polys (uint8_t dst[], const uint8_t src[]) 
 {
   int i;
   for (i = 0; i < MAXDEG; i++) dst[i] ^= src[i];
 }
 
-void copy_poly (int dst[], int src[]) 
+void copy_poly (uint8_t dst[], const uint8_t src[]) 
 {
   int i;
   for (i = 0; i < MAXDEG; i++) dst[i] = src[i];
 }
 
-void scale_poly (int k, int poly[]) 
+void scale_poly (uint8_t k, uint8_t poly[]) 
 {	
   int i;
   for (i = 0; i < MAXDEG; i++) poly[i] = gmult(k, poly[i]);
 }
 
 
-void zero_poly (int poly[]) 
+void zero_poly (uint8_t poly[]) 
 {
   int i;
   for (i = 0; i < MAXDEG; i++) poly[i] = 0;
@@ -218,7 +194,7 @@ void zero_poly (int poly[])
 
 
 /* multiply by z, i.e., shift right by 1 */
-static void mul_z_poly (int src[])
+static void mul_z_poly (uint8_t src[])
 {
   int i;
   for (i = MAXDEG-1; i > 0; i--) src[i] = src[i-1];
@@ -226,31 +202,56 @@ static void mul_z_poly (int src[])
 }
 
 
-/* Finds all the roots of an error-locator polynomial with coefficients
- * Lambda[j] by evaluating Lambda at successive values of alpha. 
- * 
- * This can be tested with the decoder's equations case.
+/* Finds the roots of an error-locator polynomial with coefficients
+ * Lambda[j] by evaluating Lambda at successive values of alpha.
+ *
+ * Only the powers that are locations within the codeword of csize
+ * bytes are tried. The term k of the sum is kept as a log and grows
+ * by k with each power, so each step is one lookup per term.
+ *
+ * Returns 0 if there are more roots than the code can correct.
  */
 
-
-void 
-Find_Roots (void)
+static int
+Find_Roots (struct rs_decoder *dec, int csize)
 {
-  int sum, r, k;	
-  NErrors = 0;
-  
-  for (r = 1; r < 256; r++) {
-    sum = 0;
+  int r, k, degree = 0;
+  int first = (csize < 255) ? 255 - csize + 1 : 1;
+  int logs[RS_ECC_NPARITY+1];
+
+  dec->NErrors = 0;
+
+  for (k = 0; k < RS_ECC_NPARITY+1; k++) {
+    if (dec->Lambda[k] != 0) {
+      logs[k] = (glog[dec->Lambda[k]] + k*first) % 255;
+      degree = k;
+    } else {
+      logs[k] = -1;
+    }
+  }
+
+  for (r = first; r < 256; r++) {
+    uint8_t sum = 0;
+
     /* evaluate lambda at r */
-    for (k = 0; k < RS_ECC_NPARITY+1; k++) {
-      sum ^= gmult(gexp[(k*r)%255], Lambda[k]);
+    for (k = 0; k <= degree; k++) {
+      if (logs[k] < 0)
+	continue;
+      sum ^= gexp[logs[k]];
+      logs[k] += k;
+      if (logs[k] >= 255)
+	logs[k] -= 255;
+    }
+
+    if (sum == 0) {
+      if (dec->NErrors >= RS_ECC_NPARITY)
+	return 0;
+      dec->ErrorLocs[dec->NErrors++] = 255-r;
     }
-    if (sum == 0) 
-      { 
-	ErrorLocs[NErrors] = (255-r); NErrors++; 
-	//if (DEBUG) fprintf(stderr, "Root found at r = %d, (255-r) = %d\n", r, (255-r));
-      }
   }
+
+  /* A root outside the codeword leaves fewer locations than the degree */
+  return dec->NErrors == degree;
 }
 
 /* Combined Erasure And Error Magnitude Computation 
@@ -262,63 +263,64 @@ Find_Roots (void)
  * Evaluate Omega(actually Psi)/Lambda' at the roots
  * alpha^(-i) for error locs i. 
  *
+ * A codeword with a zero syndrome and no erasures has no errors,
+ * it is left as it is without running Berlekamp-Massey.
+ *
  * Returns 1 if everything ok, or 0 if an out-of-bounds error is found
  *
  */
 
 int
-correct_errors_erasures (unsigned char codeword[], 
+correct_errors_erasures (struct rs_decoder *dec,
+			 unsigned char codeword[], 
 			 int csize,
 			 int nerasures,
-			 int erasures[])
+			 const int erasures[])
 {
-  int r, i, j, err;
+  int r, i, j;
+  uint8_t err;
+
+  if (nerasures == 0 && !check_syndrome(dec))
+    return(1);
+
+  if (nerasures > RS_ECC_NPARITY)
+    return(0);
 
   /* If you want to take advantage of erasure correction, be sure to
      set NErasures and ErasureLocs[] with the locations of erasures. 
      */
-  NErasures = nerasures;
-  for (i = 0; i < NErasures; i++) ErasureLocs[i] = erasures[i];
+  dec->NErasures = nerasures;
+  for (i = 0; i < nerasures; i++) dec->ErasureLocs[i] = erasures[i];
 
-  Modified_Berlekamp_Massey();
-  Find_Roots();
-  
+  Modified_Berlekamp_Massey(dec);
 
-  if ((NErrors <= RS_ECC_NPARITY) && NErrors > 0) { 
+  if (Find_Roots(dec, csize) && dec->NErrors > 0) {
 
-    /* first check for illegal error locs */
-    for (r = 0; r < NErrors; r++) {
-      if (ErrorLocs[r] >= csize) {
-				//if (DEBUG) fprintf(stderr, "Error loc i=%d outside of codeword length %d\n", i, csize);
-	return(0);
-      }
-    }
-
-    for (r = 0; r < NErrors; r++) {
-      int num, denom;
-      i = ErrorLocs[r];
+    for (r = 0; r < dec->NErrors; r++) {
+      uint8_t num, denom;
+      i = dec->ErrorLocs[r];
       /* evaluate Omega at alpha^(-i) */
 
       num = 0;
       for (j = 0; j < MAXDEG; j++) 
-	num ^= gmult(Omega[j], gexp[((255-i)*j)%255]);
+	num ^= gmult(dec->Omega[j], gexp[((255-i)*j)%255]);
       
       /* evaluate Lambda' (derivative) at alpha^(-i) ; all odd powers disappear */
       denom = 0;
       for (j = 1; j < MAXDEG; j += 2) {
-	denom ^= gmult(Lambda[j], gexp[((255-i)*(j-1)) % 255]);
+	denom ^= gmult(dec->Lambda[j], gexp[((255-i)*(j-1)) % 255]);
       }
+
+      if (denom == 0)
+	return(0);
       
       err = gmult(num, ginv(denom));
-      //if (DEBUG) fprintf(stderr, "Error magnitude %#x at loc %d\n", err, csize-i);
       
       codeword[csize-i-1] ^= err;
     }
     return(1);
   }
   else {
-    //if (DEBUG && NErrors) fprintf(stderr, "Uncorrectable codeword\n");
     return(0);
   }
 }
-
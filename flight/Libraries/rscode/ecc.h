@@ -44,8 +44,11 @@
 
 /****************************************************************/
 
+#ifndef ECC_H
+#define ECC_H
 
 #include <openpilot.h>
+#include <stdint.h>
 
 #if !defined(TRUE) && !defined(FALSE)
 #define TRUE 1
@@ -61,40 +64,66 @@ typedef unsigned short BIT16;
 #define MAXDEG (RS_ECC_NPARITY*2)
 
 /*************************************/
-/* Encoder parity bytes */
-extern int pBytes[MAXDEG];
+/* Decoder state. There is nothing global that changes after
+ * initialize_ecc(), so every link keeps one of these and links can
+ * decode at the same time. */
+struct rs_decoder {
+  /* Decoder syndrome bytes */
+  uint8_t synBytes[MAXDEG];
 
-/* Decoder syndrome bytes */
-extern int synBytes[MAXDEG];
+  /* The Error Locator Polynomial, also known as Lambda or Sigma. Lambda[0] == 1 */
+  uint8_t Lambda[MAXDEG];
 
-/* print debugging info */
-extern int DEBUG;
+  /* The Error Evaluator Polynomial */
+  uint8_t Omega[MAXDEG];
+
+  /* error locations found using Chien's search */
+  uint8_t ErrorLocs[RS_ECC_NPARITY];
+  int NErrors;
+
+  /* erasure flags */
+  uint8_t ErasureLocs[RS_ECC_NPARITY];
+  int NErasures;
+};
 
 /* Reed Solomon encode/decode routines */
 void initialize_ecc (void);
-int check_syndrome (void);
-void decode_data (unsigned char data[], int nbytes);
-void encode_data (unsigned char msg[], int nbytes, unsigned char dst[]);
+int check_syndrome (const struct rs_decoder *dec);
+void decode_data (struct rs_decoder *dec, const unsigned char data[], int nbytes);
+void encode_data (const unsigned char msg[], int nbytes, unsigned char dst[]);
 
 /* CRC-CCITT checksum generator */
 BIT16 crc_ccitt(unsigned char *msg, int len);
 
 /* galois arithmetic tables */
-extern const int gexp[];
-extern const int glog[];
+extern const uint8_t gexp[];
+extern const uint8_t glog[];
 
 void init_galois_tables (void);
-int ginv(int elt); 
-int gmult(int a, int b);
+
+/* multiplication using logarithms */
+static inline uint8_t gmult(uint8_t a, uint8_t b)
+{
+  if (a == 0 || b == 0) return 0;
+  return gexp[glog[a] + glog[b]];
+}
+
+static inline uint8_t ginv(uint8_t elt)
+{
+  return gexp[255 - glog[elt]];
+}
 
 
 /* Error location routines */
-int correct_errors_erasures (unsigned char codeword[], int csize,int nerasures, int erasures[]);
+int correct_errors_erasures (struct rs_decoder *dec, unsigned char codeword[], int csize,
+			     int nerasures, const int erasures[]);
 
 /* polynomial arithmetic */
-void add_polys(int dst[], int src[]) ;
-void scale_poly(int k, int poly[]);
-void mult_polys(int dst[], int p1[], int p2[]);
+void add_polys(uint8_t dst[], const uint8_t src[]) ;
+void scale_poly(uint8_t k, uint8_t poly[]);
+void mult_polys(uint8_t dst[], const uint8_t p1[], const uint8_t p2[]);
+
+void copy_poly(uint8_t dst[], const uint8_t src[]);
+void zero_poly(uint8_t poly[]);
 
-void copy_poly(int dst[], int src[]);
-void zero_poly(int poly[]);
+#endif /* ECC_H */
@@ -29,124 +29,73 @@
 #include <ctype.h>
 #include "ecc.h"
 
-/* Encoder parity bytes */
-int pBytes[MAXDEG];
-
-/* Decoder syndrome bytes */
-int synBytes[MAXDEG];
-
 /* generator polynomial */
-int genPoly[MAXDEG*2];
+static uint8_t genPoly[MAXDEG*2];
 
-int DEBUG = FALSE;
+/* log of each generator polynomial coefficient, GEN_LOG_ZERO for zero ones */
+#define GEN_LOG_ZERO 0xFF
+static uint8_t genLog[RS_ECC_NPARITY];
 
 static void
-compute_genpoly (int nbytes, int genpoly[]);
+compute_genpoly (int nbytes, uint8_t genpoly[]);
 
 /* Initialize lookup tables, polynomials, etc. */
 void
 initialize_ecc ()
 {
+  int i;
+
   /* Initialize the galois field arithmetic tables */
     init_galois_tables();
 
     /* Compute the encoder generator polynomial */
     compute_genpoly(RS_ECC_NPARITY, genPoly);
-}
 
-void
-zero_fill_from (unsigned char buf[], int from, int to)
-{
-  int i;
-  for (i = from; i < to; i++) buf[i] = 0;
+    /* The encoder multiplies by the coefficients in the log domain */
+    for (i = 0; i < RS_ECC_NPARITY; i++)
+      genLog[i] = genPoly[i] ? glog[genPoly[i]] : GEN_LOG_ZERO;
 }
 
-/* debugging routines */
-void
-print_parity (void)
-{
-#ifdef NEVER
-  int i;
-  printf("Parity Bytes: ");
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
-    printf("[%d]:%x, ",i,pBytes[i]);
-  printf("\n");
-#endif
-}
-
-
-void
-print_syndrome (void)
-{
-#ifdef NEVER
-  int i;
-  printf("Syndrome Bytes: ");
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
-    printf("[%d]:%x, ",i,synBytes[i]);
-  printf("\n");
-#endif
-}
-
-/* Append the parity bytes onto the end of the message */
-void
-build_codeword (unsigned char msg[], int nbytes, unsigned char dst[])
-{
-  int i;
-	
-  for (i = 0; i < nbytes; i++) dst[i] = msg[i];
-	
-  for (i = 0; i < RS_ECC_NPARITY; i++) {
-    dst[i+nbytes] = pBytes[RS_ECC_NPARITY-1-i];
-  }
-}
-	
 /**********************************************************
  * Reed Solomon Decoder 
  *
  * Computes the syndrome of a codeword. Puts the results
- * into the synBytes[] array.
+ * into the synBytes[] array of the decoder.
+ *
+ * Each step multiplies by the constant a^(j+1), so only the
+ * log of the running sum is looked up.
  */
  
 void
-decode_data(unsigned char data[], int nbytes)
+decode_data(struct rs_decoder *dec, const unsigned char data[], int nbytes)
 {
-  int i, j, sum;
-  for (j = 0; j < RS_ECC_NPARITY;  j++) {
-    sum	= 0;
-    for (i = 0; i < nbytes; i++) {
-      sum = data[i] ^ gmult(gexp[j+1], sum);
+  int i, j;
+  uint8_t sum[RS_ECC_NPARITY] = { 0 };
+
+  for (i = 0; i < nbytes; i++) {
+    for (j = 0; j < RS_ECC_NPARITY; j++) {
+      uint8_t scaled = sum[j] ? gexp[glog[sum[j]] + j + 1] : 0;
+      sum[j] = data[i] ^ scaled;
     }
-    synBytes[j]  = sum;
   }
+
+  for (j = 0; j < RS_ECC_NPARITY; j++)
+    dec->synBytes[j] = sum[j];
+  for (; j < MAXDEG; j++)
+    dec->synBytes[j] = 0;
 }
 
 
 /* Check if the syndrome is zero */
 int
-check_syndrome (void)
+check_syndrome (const struct rs_decoder *dec)
 {
- int i, nz = 0;
+ int i;
  for (i =0 ; i < RS_ECC_NPARITY; i++) {
-  if (synBytes[i] != 0) {
-      nz = 1;
-      break;
-  }
+  if (dec->synBytes[i] != 0)
+      return 1;
  }
- return nz;
-}
-
-
-void
-debug_check_syndrome (void)
-{	
-#ifdef NEVER
-  int i;
-	
-  for (i = 0; i < 3; i++) {
-    printf(" inv log S[%d]/S[%d] = %d\n", i, i+1, 
-	   glog[gmult(synBytes[i], ginv(synBytes[i+1]))]);
-  }
-#endif
+ return 0;
 }
 
 
@@ -157,9 +106,10 @@ debug_check_syndrome (void)
  */
 
 static void
-compute_genpoly (int nbytes, int genpoly[])
+compute_genpoly (int nbytes, uint8_t genpoly[])
 {
-  int i, tp[MAXDEG], tp1[MAXDEG];
+  int i;
+  uint8_t tp[MAXDEG], tp1[MAXDEG];
 	
   /* multiply (x + a^n) for n = 1 to nbytes */
 
@@ -179,29 +129,40 @@ compute_genpoly (int nbytes, int genpoly[])
 /* Simulate a LFSR with generator polynomial for n byte RS code. 
  * Pass in a pointer to the data array, and amount of data. 
  *
- * The parity bytes are deposited into pBytes[], and the whole message
- * and parity are copied to dest to make a codeword.
+ * The message is copied to dst, unless it is already there, and
+ * the parity bytes are appended to make a codeword.
  * 
  */
 
 void
-encode_data (unsigned char msg[], int nbytes, unsigned char dst[])
+encode_data (const unsigned char msg[], int nbytes, unsigned char dst[])
 {
-  int i, LFSR[RS_ECC_NPARITY+1],dbyte, j;
+  int i, j;
+  uint8_t LFSR[RS_ECC_NPARITY];
 	
-  for(i=0; i < RS_ECC_NPARITY+1; i++) LFSR[i]=0;
+  for (i = 0; i < RS_ECC_NPARITY; i++) LFSR[i] = 0;
 
   for (i = 0; i < nbytes; i++) {
-    dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY-1];
+    uint8_t dbyte = msg[i] ^ LFSR[RS_ECC_NPARITY-1];
+
+    if (dbyte == 0) {
+      for (j = RS_ECC_NPARITY-1; j > 0; j--)
+	LFSR[j] = LFSR[j-1];
+      LFSR[0] = 0;
+      continue;
+    }
+
+    uint8_t dlog = glog[dbyte];
     for (j = RS_ECC_NPARITY-1; j > 0; j--) {
-      LFSR[j] = LFSR[j-1] ^ gmult(genPoly[j], dbyte);
+      LFSR[j] = LFSR[j-1] ^
+	(genLog[j] != GEN_LOG_ZERO ? gexp[genLog[j] + dlog] : 0);
     }
-    LFSR[0] = gmult(genPoly[0], dbyte);
+    LFSR[0] = genLog[0] != GEN_LOG_ZERO ? gexp[genLog[0] + dlog] : 0;
   }
 
-  for (i = 0; i < RS_ECC_NPARITY; i++) 
-    pBytes[i] = LFSR[i];
-	
-  build_codeword(msg, nbytes, dst);
-}
+  if (dst != msg)
+    for (i = 0; i < nbytes; i++) dst[i] = msg[i];
 
+  for (i = 0; i < RS_ECC_NPARITY; i++)
+    dst[i+nbytes] = LFSR[RS_ECC_NPARITY-1-i];
+}
@@ -43,6 +43,9 @@
  * 2. If airframe is a multirotor and either manual is available or a stabilization mode uses "none"
  ****************************/
 
+//! Check the modes on the flight mode switch can be flown with this airframe
+static int32_t check_flight_modes();
+
 //! Check it is safe to arm in this position
 static int32_t check_safe_to_arm();
 
@@ -55,18 +58,37 @@ static int32_t check_stabilization_rates();
 //! Check the system is safe for autonomous flight
 static int32_t check_safe_autonomous();
 
+/**
+ * The checks are split in groups by the objects they read, so an update
+ * only reruns the groups that depend on the object updated. The groups
+ * are listed in order of priority, the first one with an error sets the
+ * alarm.
+ */
+enum check_group {
+	CHECK_GROUP_FLIGHTMODES,	//!< ManualControlSettings, SystemSettings and StateEstimation
+	CHECK_GROUP_RATES,		//!< StabilizationSettings
+	CHECK_GROUP_ARMING,		//!< FlightStatus
+	CHECK_GROUP_NUMELEM
+};
+
+//! Last result of each group
+static int32_t group_error[CHECK_GROUP_NUMELEM];
+
 /**
  * Run a preflight check over the hardware configuration
  * and currently active modules
  */
 int32_t configuration_check()
 {
-	SystemAlarmsConfigErrorOptions error_code = SYSTEMALARMS_CONFIGERROR_NONE;
-	
-	// Get board type
-	const struct pios_board_info * bdinfo = &pios_board_info_blob;	
-	bool coptercontrol = bdinfo->board_type == 0x04;
+	return configuration_check_updated(NULL);
+}
 
+/**
+ * Rerun the checks that depend on an object after it was updated
+ * @param[in] obj The object updated, NULL to run all the checks
+ */
+int32_t configuration_check_updated(UAVObjHandle obj)
+{
 	// For when modules are not running we should explicitly check the objects are
 	// valid
 	if (ManualControlSettingsHandle() == NULL ||
@@ -75,6 +97,50 @@ int32_t configuration_check()
 		return 0;
 	}
 
+	static bool checked = false;
+	bool all = obj == NULL || !checked;
+
+	if (all || obj == ManualControlSettingsHandle() || obj == SystemSettingsHandle()
+#if !defined(SMALLF1)
+		|| obj == StateEstimationHandle()
+#endif
+		)
+		group_error[CHECK_GROUP_FLIGHTMODES] = check_flight_modes();
+
+	if (all || obj == StabilizationSettingsHandle())
+		group_error[CHECK_GROUP_RATES] = check_stabilization_rates();
+
+	if (all || obj == FlightStatusHandle())
+		group_error[CHECK_GROUP_ARMING] = check_safe_to_arm();
+
+	checked = true;
+
+	SystemAlarmsConfigErrorOptions error_code = SYSTEMALARMS_CONFIGERROR_NONE;
+	for (uint32_t i = 0; i < CHECK_GROUP_NUMELEM; i++) {
+		if (group_error[i] != SYSTEMALARMS_CONFIGERROR_NONE) {
+			error_code = group_error[i];
+			break;
+		}
+	}
+
+	set_config_error(error_code);
+
+	return 0;
+}
+
+/**
+ * Check each position of the flight mode switch against the airframe
+ * and the modules running
+ * @return error code if a mode is not safe
+ */
+static int32_t check_flight_modes()
+{
+	SystemAlarmsConfigErrorOptions error_code = SYSTEMALARMS_CONFIGERROR_NONE;
+
+	// Get board type
+	const struct pios_board_info * bdinfo = &pios_board_info_blob;
+	bool coptercontrol = bdinfo->board_type == 0x04;
+
 	// Classify airframe type
 	bool multirotor = true;
 	uint8_t airframe_type;
@@ -173,15 +239,7 @@ int32_t configuration_check()
 		}
 	}
 
-	// Check the stabilization rates are within what the sensors can track
-	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? check_stabilization_rates() : error_code;
-
-	// Only check safe to arm if no other errors exist
-	error_code = (error_code == SYSTEMALARMS_CONFIGERROR_NONE) ? check_safe_to_arm() : error_code;
-
-	set_config_error(error_code);
-
-	return 0;
+	return error_code;
 }
 
 
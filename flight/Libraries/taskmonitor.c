@@ -145,12 +145,19 @@ void TaskMonitorUpdateAll(void)
 			data.StackRemaining[n] = PIOS_Thread_Get_Stack_Usage(handles[n]);
 			/* Generate run time stats */
 			data.RunningTime[n] = PIOS_Thread_Get_Runtime(handles[n]) / deltaTime;
+			/* Scheduling stats since the last update */
+			uint32_t switches = PIOS_Thread_Get_Context_Switches(handles[n]);
+			data.ContextSwitches[n] = (switches > UINT16_MAX) ? UINT16_MAX : switches;
+			uint32_t latency = PIOS_Thread_Get_Max_Latency(handles[n]);
+			data.MaxLatency[n] = (latency > UINT16_MAX) ? UINT16_MAX : latency;
 		}
 		else
 		{
 			data.Running[n] = TASKINFO_RUNNING_FALSE;
 			data.StackRemaining[n] = 0;
 			data.RunningTime[n] = 0;
+			data.ContextSwitches[n] = 0;
+			data.MaxLatency[n] = 0;
 		}
 	}
 
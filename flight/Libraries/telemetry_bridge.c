@@ -0,0 +1,253 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsLibraries Tau Labs Libraries
+ * @{
+ * @addtogroup TelemetryBridge Telemetry bridge runtime
+ * @{
+ *
+ * @file       telemetry_bridge.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      One task running the encoders of the telemetry bridges
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* The bridge modules register their encoders when they are initialized and */
+/* the first of them to start creates the task, so however many bridges    */
+/* are enabled there is one stack. The task sleeps until the next encoder   */
+/* is due, or until a byte comes in on the port of the first encoder that   */
+/* answers requests. The ports of other such encoders are polled.           */
+
+#include "pios.h"
+#include "openpilot.h"
+#include "pios_thread.h"
+#include "telemetry_bridge.h"
+
+#include "airspeedactual.h"
+#include "positionactual.h"
+
+// Private constants
+#if defined(PIOS_TELEMETRY_BRIDGE_STACK_SIZE)
+#define STACK_SIZE_BYTES PIOS_TELEMETRY_BRIDGE_STACK_SIZE
+#else
+#define STACK_SIZE_BYTES 768
+#endif
+#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
+
+//! The snapshot is read again when it is older than this
+#define SNAPSHOT_PERIOD_MS 20
+
+//! How long the task sleeps at most when nothing is due
+#define MAX_WAIT_MS 100
+
+//! How often the ports are polled when more than one encoder takes requests
+#define POLL_PERIOD_MS 2
+
+// Private variables
+static struct telemetry_bridge_encoder *encoders;
+static struct telemetry_bridge_snapshot snapshot;
+static uint16_t snapshot_objects;
+static uint32_t snapshot_time;
+static bool started;
+
+// Private functions
+static void telemetryBridgeTask(void *parameters);
+static void updateSnapshot(void);
+static void receiveBytes(struct telemetry_bridge_encoder *encoder, uint32_t timeout_ms);
+
+/**
+ * Add an encoder to the bridge task, before it is started
+ * @param[in] encoder The encoder, it has to stay around
+ * @return 0 on success, -1 if the task was started already
+ */
+int32_t telemetry_bridge_register(struct telemetry_bridge_encoder *encoder)
+{
+	if (started || (encoder->send == NULL && encoder->receive == NULL))
+		return -1;
+
+	if (encoder->send != NULL && encoder->period_ms == 0)
+		return -1;
+
+	encoder->next = NULL;
+
+	// Kept in the order of registration, the first one taking requests
+	// is the one the task waits on
+	struct telemetry_bridge_encoder **tail = &encoders;
+	while (*tail != NULL)
+		tail = &(*tail)->next;
+	*tail = encoder;
+
+	snapshot_objects |= encoder->objects;
+
+	return 0;
+}
+
+/**
+ * Start the bridge task, called by every bridge module from its start
+ * @return 0 if the task runs, -1 if there is nothing to run
+ */
+int32_t telemetry_bridge_start(void)
+{
+	if (encoders == NULL)
+		return -1;
+
+	if (started)
+		return 0;
+
+	started = true;
+
+	struct pios_thread *task = PIOS_Thread_Create(
+			telemetryBridgeTask, "TelemetryBridge",
+			STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	TaskMonitorAdd(TASKINFO_RUNNING_TELEMETRYBRIDGE, task);
+
+	return 0;
+}
+
+static void telemetryBridgeTask(void *parameters)
+{
+	struct telemetry_bridge_encoder *waiting = NULL;
+	bool polling = false;
+
+	uint32_t now = PIOS_Thread_Systime();
+	for (struct telemetry_bridge_encoder *e = encoders; e != NULL; e = e->next) {
+		e->next_send = now;
+
+		if (e->receive != NULL) {
+			if (waiting == NULL)
+				waiting = e;
+			else
+				polling = true;
+		}
+	}
+
+	snapshot_time = now - SNAPSHOT_PERIOD_MS;
+
+	while (1) {
+		now = PIOS_Thread_Systime();
+		uint32_t wait = MAX_WAIT_MS;
+
+		for (struct telemetry_bridge_encoder *e = encoders; e != NULL; e = e->next) {
+			if (e->receive != NULL && e != waiting)
+				receiveBytes(e, 0);
+
+			if (e->send == NULL)
+				continue;
+
+			int32_t due = (int32_t)(e->next_send - now);
+			if (due <= 0) {
+				updateSnapshot();
+				e->send(&snapshot);
+
+				// Late sends are not caught up with, that would only
+				// make a slow port slower
+				e->next_send += e->period_ms;
+				if ((int32_t)(e->next_send - now) <= 0)
+					e->next_send = now + e->period_ms;
+				due = (int32_t)(e->next_send - now);
+			}
+
+			if ((uint32_t)due < wait)
+				wait = due;
+		}
+
+		if (polling && wait > POLL_PERIOD_MS)
+			wait = POLL_PERIOD_MS;
+
+		if (waiting != NULL && waiting->receive != NULL)
+			receiveBytes(waiting, wait);
+		else
+			PIOS_Thread_Sleep(wait);
+	}
+}
+
+/**
+ * Hand the bytes that came in to an encoder taking requests
+ * @param[in] timeout_ms How long to wait for the first byte
+ */
+static void receiveBytes(struct telemetry_bridge_encoder *encoder, uint32_t timeout_ms)
+{
+	uint8_t b;
+
+	while (PIOS_COM_ReceiveBuffer(encoder->com, &b, 1, timeout_ms) == 1) {
+		updateSnapshot();
+
+		if (!encoder->receive(&snapshot, b)) {
+			encoder->receive = NULL;
+			return;
+		}
+
+		timeout_ms = 0;
+	}
+}
+
+/**
+ * Read the objects the encoders use, unless they were read just before
+ */
+static void updateSnapshot(void)
+{
+	uint32_t now = PIOS_Thread_Systime();
+	if (now - snapshot_time < SNAPSHOT_PERIOD_MS)
+		return;
+
+	snapshot_time = now;
+	snapshot.valid = 0;
+
+	if ((snapshot_objects & TELEMETRY_BRIDGE_ATTITUDE) && AttitudeActualHandle() != NULL) {
+		AttitudeActualGet(&snapshot.attitude);
+		snapshot.valid |= TELEMETRY_BRIDGE_ATTITUDE;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_GPS_POSITION) && GPSPositionHandle() != NULL) {
+		GPSPositionGet(&snapshot.gps_position);
+		snapshot.valid |= TELEMETRY_BRIDGE_GPS_POSITION;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_BATTERY) && FlightBatteryStateHandle() != NULL) {
+		FlightBatteryStateGet(&snapshot.battery);
+		snapshot.valid |= TELEMETRY_BRIDGE_BATTERY;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_FLIGHT_STATUS) && FlightStatusHandle() != NULL) {
+		FlightStatusGet(&snapshot.flight_status);
+		snapshot.valid |= TELEMETRY_BRIDGE_FLIGHT_STATUS;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_BARO) && BaroAltitudeHandle() != NULL) {
+		BaroAltitudeGet(&snapshot.baro);
+		snapshot.valid |= TELEMETRY_BRIDGE_BARO;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_MANUAL_CONTROL) && ManualControlCommandHandle() != NULL) {
+		ManualControlCommandGet(&snapshot.manual_control);
+		snapshot.valid |= TELEMETRY_BRIDGE_MANUAL_CONTROL;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_HOME_LOCATION) && HomeLocationHandle() != NULL) {
+		HomeLocationGet(&snapshot.home_location);
+		snapshot.valid |= TELEMETRY_BRIDGE_HOME_LOCATION;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_POSITION) && PositionActualHandle() != NULL) {
+		PositionActualDownGet(&snapshot.position_down);
+		snapshot.valid |= TELEMETRY_BRIDGE_POSITION;
+	}
+	if ((snapshot_objects & TELEMETRY_BRIDGE_AIRSPEED) && AirspeedActualHandle() != NULL) {
+		AirspeedActualTrueAirspeedGet(&snapshot.true_airspeed);
+		snapshot.valid |= TELEMETRY_BRIDGE_AIRSPEED;
+	}
+}
+
+/**
+ * @}
+ * @}
+ */
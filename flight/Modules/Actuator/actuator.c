@@ -35,6 +35,7 @@
  */
 
 #include "openpilot.h"
+#include "actuator.h"
 #include "accessorydesired.h"
 #include "actuatorsettings.h"
 #include "systemsettings.h"
@@ -44,10 +45,14 @@
 #include "mixersettings.h"
 #include "mixerstatus.h"
 #include "cameradesired.h"
+#include "controlloopstatus.h"
 #include "manualcontrolcommand.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "pios_mutex.h"
 #include "misc_math.h"
+#include "latencymonitor.h"
+#include "blackbox.h"
 
 // Private constants
 #define MAX_QUEUE_SIZE 2
@@ -62,6 +67,7 @@
 #define FAILSAFE_TIMEOUT_MS 100
 #define MAX_MIX_ACTUATORS ACTUATORCOMMAND_CHANNEL_NUMELEM
 #define MULTIROTOR_MIXER_UPPER_BOUND 128
+#define LATENCY_PUBLISH_PERIOD_MS 1000
 
 // Private types
 
@@ -78,6 +84,27 @@ static MixerSettingsData mixerSettings;
 // Ditto, for the actuator settings.
 static ActuatorSettingsData actuatorSettings;
 
+// The mixers compiled from the settings, so mixing doesn't look each one up
+static struct {
+	MixerSettingsMixer1TypeOptions type[MAX_MIX_ACTUATORS];
+	float matrix[MAX_MIX_ACTUATORS][MIXERSETTINGS_MIXER1VECTOR_NUMELEM];
+	int num_mixers;
+	bool linear_motors;
+} mixer;
+
+// Held while mixing or reloading settings, as the mixer can run from two tasks
+static struct pios_mutex *mixer_mutex;
+
+// System time of the last mixer update
+static uint32_t last_mix_time;
+
+// Set when the stabilization task already output the pending ActuatorDesired
+static volatile bool fused_output_done;
+
+// Time the gyro data behind the pending ActuatorDesired was received
+static volatile uint32_t latency_sample_time;
+static volatile bool latency_sample_valid;
+
 // Private functions
 static void actuator_task(void* parameters);
 static float scale_channel(float value, int idx);
@@ -87,10 +114,11 @@ static float collective_curve(const float input, const float* curve, uint8_t num
 static bool set_channel(uint8_t mixer_channel, float value);
 static void actuator_update_rate_if_changed(bool force_update);
 static void settings_update_cb(UAVObjEvent * ev);
-float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired);
-static float mix_channel(int ct, ActuatorDesiredData *desired,
-		float curve1, float curve2);
+static bool actuator_mix_and_output(ActuatorDesiredData *desired);
+static void update_latency(uint32_t sample_time);
+static void compile_mixer();
+static float process_mixer(const int index, const float *inputs);
+static float mix_channel(int ct, const float *inputs);
 
 static MixerSettingsMixer1TypeOptions get_mixer_type(int idx);
 static typeof(mixerSettings.Mixer1Vector) *get_mixer_vec(int idx);
@@ -131,6 +159,12 @@ int32_t ActuatorInitialize()
 	// Primary output of this module
 	ActuatorCommandInitialize();
 
+	ControlLoopStatusInitialize();
+
+	mixer_mutex = PIOS_Mutex_Create();
+	if (mixer_mutex == NULL)
+		return -1;
+
 #if defined(MIXERSTATUS_DIAGNOSTICS)
 	// UAVO only used for inspecting the internal status of the mixer during debug
 	MixerStatusInitialize();
@@ -138,7 +172,7 @@ int32_t ActuatorInitialize()
 
 	return 0;
 }
-MODULE_INITCALL(ActuatorInitialize, ActuatorStart);
+MODULE_CRITICAL_INITCALL(ActuatorInitialize, ActuatorStart);
 
 static float get_curve2_source(ActuatorDesiredData *desired, MixerSettingsCurve2SourceOptions source)
 {
@@ -183,46 +217,41 @@ static float get_curve2_source(ActuatorDesiredData *desired, MixerSettingsCurve2
 /**
  * @brief Main Actuator module task
  *
- * Universal matrix based mixer for VTOL, helis and fixed wing.
- * Converts desired roll,pitch,yaw and throttle to servo/ESC outputs.
- *
- * Because of how the Throttle ranges from 0 to 1, the motors should too!
- *
- * Note this code depends on the UAVObjects for the mixers being all being the same
- * and in sequence. If you change the object definition, make sure you check the code!
+ * Waits for updates of @ref ActuatorDesired and mixes them to the outputs.
+ * When the fused control loop is enabled the stabilization task mixes
+ * itself through @ref actuator_fused_update and this task is only left with
+ * the settings, the failsafe timeout and updates from other sources.
  *
  * @return -1 if error, 0 if success
  */
 static void actuator_task(void* parameters)
 {
-	uint32_t lastSysTime;
-	float dT = 0.0f;
-
-	ActuatorCommandData command;
 	ActuatorDesiredData desired;
-	MixerStatusData mixerStatus;
-	FlightStatusData flightStatus;
 
 	/* Read initial values of ActuatorSettings */
 	settings_updated = true;
 
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
+	last_mix_time = PIOS_Thread_Systime();
 
 	bool rc = false;
 
 	while (1) {
 		if (settings_updated) {
+			PIOS_Mutex_Lock(mixer_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 			settings_updated = false;
 			ActuatorSettingsGet(&actuatorSettings);
 			actuator_update_rate_if_changed(false);
 			MixerSettingsGet(&mixerSettings);
+			compile_mixer();
+			PIOS_Mutex_Unlock(mixer_mutex);
 		}
 
 		if (rc != true) {
 			/* Update of ActuatorDesired timed out,
 			 * or first iteration.  Go to failsafe */
+			PIOS_Mutex_Lock(mixer_mutex, PIOS_MUTEX_TIMEOUT_MAX);
 			set_failsafe();
+			PIOS_Mutex_Unlock(mixer_mutex);
 		}
 
 		PIOS_WDG_UpdateFlag(PIOS_WDG_ACTUATOR);
@@ -238,115 +267,250 @@ static void actuator_task(void* parameters)
 			continue;
 		}
 
-		// Check how long since last update
-		uint32_t thisSysTime = PIOS_Thread_Systime();
-		if (thisSysTime > lastSysTime) // reuse dt in case of wraparound
-			dT = (thisSysTime - lastSysTime) / 1000.0f;
-		lastSysTime = thisSysTime;
+		/* The stabilization task output this update before setting
+		 * ActuatorDesired, so there is nothing left to do for it */
+		if (fused_output_done) {
+			fused_output_done = false;
+			continue;
+		}
 
-		FlightStatusGet(&flightStatus);
 		ActuatorDesiredGet(&desired);
-		ActuatorCommandGet(&command);
-
-#if defined(MIXERSTATUS_DIAGNOSTICS)
-		MixerStatusGet(&mixerStatus);
-#endif
-		int nMixers = 0;
 
-		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			if (get_mixer_type(ct) != MIXERSETTINGS_MIXER1TYPE_DISABLED) {
-				nMixers++;
-			}
-		}
-		if ((nMixers < 2) && !ActuatorCommandReadOnly()) { //Nothing can fly with less than two mixers.
+		PIOS_Mutex_Lock(mixer_mutex, PIOS_MUTEX_TIMEOUT_MAX);
+		if (!actuator_mix_and_output(&desired)) {
 			set_failsafe(); // So that channels like PWM buzzer keep working
-			continue;
 		}
+		PIOS_Mutex_Unlock(mixer_mutex);
+	}
+}
 
-		AlarmsClear(SYSTEMALARMS_ALARM_ACTUATOR);
+/**
+ * Mix and output an ActuatorDesired update directly from the stabilization
+ * task, which saves the queue hand off and the context switch to the
+ * actuator task.  Only does anything when FusedControlLoop is enabled.
+ *
+ * @param[in] desired the update that is about to be set in ActuatorDesired
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time the gyro data behind the
+ * update was received, used to measure the gyro to output latency
+ * @return true if the outputs were updated, false if the caller should
+ * just set ActuatorDesired and let the actuator task handle it
+ */
+bool actuator_fused_update(ActuatorDesiredData *desired, uint32_t sample_time)
+{
+	latency_sample_time = sample_time;
+	latency_sample_valid = true;
 
-		bool armed = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED;
-		bool positiveThrottle = desired.Throttle >= 0.00f;
-		bool spinWhileArmed = actuatorSettings.MotorsSpinWhileArmed == ACTUATORSETTINGS_MOTORSSPINWHILEARMED_TRUE;
+	if (actuatorSettings.FusedControlLoop != ACTUATORSETTINGS_FUSEDCONTROLLOOP_TRUE)
+		return false;
 
-		float curve1 = throt_curve(desired.Throttle, mixerSettings.ThrottleCurve1, MIXERSETTINGS_THROTTLECURVE1_NUMELEM);
+	// Never wait on the actuator task from the control loop
+	if (PIOS_Mutex_Lock(mixer_mutex, 0) != true)
+		return false;
 
-		//The source for the secondary curve is selectable
-		float curve2 = collective_curve(
-				get_curve2_source(&desired, mixerSettings.Curve2Source),
-				mixerSettings.ThrottleCurve2,
-				MIXERSETTINGS_THROTTLECURVE2_NUMELEM);
+	fused_output_done = actuator_mix_and_output(desired);
+
+	PIOS_Mutex_Unlock(mixer_mutex);
+
+	return fused_output_done;
+}
+
+/**
+ * Universal matrix based mixer for VTOL, helis and fixed wing.
+ * Converts desired roll,pitch,yaw and throttle to servo/ESC outputs.
+ *
+ * Because of how the Throttle ranges from 0 to 1, the motors should too!
+ *
+ * Note this code depends on the UAVObjects for the mixers being all being the same
+ * and in sequence. If you change the object definition, make sure you check the code!
+ *
+ * Must be called with mixer_mutex held.
+ *
+ * @return false if the mixer is not configured and the outputs should go to failsafe
+ */
+static bool actuator_mix_and_output(ActuatorDesiredData *desired)
+{
+	static float dT = 0.0f;
 
-		float * status = (float *)&mixerStatus; //access status objects as an array of floats
+	ActuatorCommandData command;
+	MixerStatusData mixerStatus;
+	FlightStatusData flightStatus;
 
-		for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
-			status[ct] = mix_channel(ct, &desired, curve1, curve2);
+	// Check how long since last update
+	uint32_t thisSysTime = PIOS_Thread_Systime();
+	if (thisSysTime > last_mix_time) // reuse dt in case of wraparound
+		dT = (thisSysTime - last_mix_time) / 1000.0f;
+	last_mix_time = thisSysTime;
 
-			// Motors have additional protection for when to be on
-			if (get_mixer_type(ct) == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+	FlightStatusGet(&flightStatus);
+	ActuatorCommandGet(&command);
 
-				// If not armed or motors aren't meant to spin all the time
-				if (!armed ||
-						(!spinWhileArmed && !positiveThrottle)) {
-					status[ct] = -1;  //force min throttle
-				}
-				// If armed meant to keep spinning,
-				else if ((spinWhileArmed && !positiveThrottle) ||
-						(status[ct] < 0) )
-					status[ct] = 0;
-			}
+#if defined(MIXERSTATUS_DIAGNOSTICS)
+	MixerStatusGet(&mixerStatus);
+#endif
+	if ((mixer.num_mixers < 2) && !ActuatorCommandReadOnly()) { //Nothing can fly with less than two mixers.
+		return false;
+	}
 
-			command.Channel[ct] = scale_channel(status[ct], ct);
+	AlarmsClear(SYSTEMALARMS_ALARM_ACTUATOR);
+
+	bool armed = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED;
+	bool positiveThrottle = desired->Throttle >= 0.00f;
+	bool spinWhileArmed = actuatorSettings.MotorsSpinWhileArmed == ACTUATORSETTINGS_MOTORSSPINWHILEARMED_TRUE;
+
+	// What each row of the mixer matrix is multiplied with
+	const float inputs[MIXERSETTINGS_MIXER1VECTOR_NUMELEM] = {
+		[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] =
+			throt_curve(desired->Throttle, mixerSettings.ThrottleCurve1, MIXERSETTINGS_THROTTLECURVE1_NUMELEM),
+		//The source for the secondary curve is selectable
+		[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] =
+			collective_curve(get_curve2_source(desired, mixerSettings.Curve2Source),
+				mixerSettings.ThrottleCurve2, MIXERSETTINGS_THROTTLECURVE2_NUMELEM),
+		[MIXERSETTINGS_MIXER1VECTOR_ROLL] = desired->Roll,
+		[MIXERSETTINGS_MIXER1VECTOR_PITCH] = desired->Pitch,
+		[MIXERSETTINGS_MIXER1VECTOR_YAW] = desired->Yaw,
+	};
+
+	float * status = (float *)&mixerStatus; //access status objects as an array of floats
+
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		status[ct] = mix_channel(ct, inputs);
+
+		// Motors have additional protection for when to be on
+		if (mixer.type[ct] == MIXERSETTINGS_MIXER1TYPE_MOTOR) {
+
+			// If not armed or motors aren't meant to spin all the time
+			if (!armed ||
+					(!spinWhileArmed && !positiveThrottle)) {
+				status[ct] = -1;  //force min throttle
+			}
+			// If armed meant to keep spinning,
+			else if ((spinWhileArmed && !positiveThrottle) ||
+					(status[ct] < 0) )
+				status[ct] = 0;
 		}
 
-		// Store update time
-		command.UpdateTime = 1000.0f*dT;
-		if (1000.0f*dT > command.MaxUpdateTime)
-			command.MaxUpdateTime = 1000.0f*dT;
+		command.Channel[ct] = scale_channel(status[ct], ct);
+	}
 
-		// Update output object
-		ActuatorCommandSet(&command);
-		// Update in case read only (eg. during servo configuration)
-		ActuatorCommandGet(&command);
+	// Store update time
+	command.UpdateTime = 1000.0f*dT;
+	if (1000.0f*dT > command.MaxUpdateTime)
+		command.MaxUpdateTime = 1000.0f*dT;
+
+	// Update output object
+	ActuatorCommandSet(&command);
+	// Update in case read only (eg. during servo configuration)
+	ActuatorCommandGet(&command);
+
+#if defined(BLACKBOX_CAPTURE)
+	BlackboxActuator(command.Channel, ACTUATORCOMMAND_CHANNEL_NUMELEM);
+#endif
 
 #if defined(MIXERSTATUS_DIAGNOSTICS)
-		MixerStatusSet(&mixerStatus);
+	MixerStatusSet(&mixerStatus);
 #endif
 
-		// Update servo outputs
-		bool success = true;
+	// Update servo outputs
+	bool success = true;
 
-		for (int n = 0; n < ACTUATORCOMMAND_CHANNEL_NUMELEM; ++n) {
-			success &= set_channel(n, command.Channel[n]);
-		}
+	for (int n = 0; n < ACTUATORCOMMAND_CHANNEL_NUMELEM; ++n) {
+		success &= set_channel(n, command.Channel[n]);
+	}
 #if defined(PIOS_INCLUDE_HPWM)
-		PIOS_Servo_Update();
+	PIOS_Servo_Update();
 #endif
 
-		if (!success) {
-			command.NumFailedUpdates++;
-			ActuatorCommandSet(&command);
-			AlarmsSet(SYSTEMALARMS_ALARM_ACTUATOR, SYSTEMALARMS_ALARM_CRITICAL);
-		}
+	// Only updates that came from the stabilization loop carry a gyro time
+	if (latency_sample_valid) {
+		latency_sample_valid = false;
+		update_latency(latency_sample_time);
+#if defined(LATENCY_DIAGNOSTICS)
+		LatencyMonitorMark(LATENCY_STAGE_ACTUATOR);
+#endif
+	}
+
+	if (!success) {
+		command.NumFailedUpdates++;
+		ActuatorCommandSet(&command);
+		AlarmsSet(SYSTEMALARMS_ALARM_ACTUATOR, SYSTEMALARMS_ALARM_CRITICAL);
+	}
+
+	return true;
+}
+
+/**
+ * Accumulate the gyro to output latency and periodically publish it
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time the gyro data was received
+ */
+static void update_latency(uint32_t sample_time)
+{
+	static uint32_t last_publish_time;
+	static float latency_sum;
+	static float latency_max;
+	static uint32_t latency_count;
+
+	float latency = PIOS_DELAY_DiffuS(sample_time);
+
+	latency_sum += latency;
+	latency_count++;
+	if (latency > latency_max)
+		latency_max = latency;
+
+	uint32_t now = PIOS_Thread_Systime();
+	if (now - last_publish_time < LATENCY_PUBLISH_PERIOD_MS)
+		return;
+
+	ControlLoopStatusData status;
+
+	status.FusedControlLoop = actuatorSettings.FusedControlLoop == ACTUATORSETTINGS_FUSEDCONTROLLOOP_TRUE ?
+		CONTROLLOOPSTATUS_FUSEDCONTROLLOOP_TRUE : CONTROLLOOPSTATUS_FUSEDCONTROLLOOP_FALSE;
+	status.GyroToOutput[CONTROLLOOPSTATUS_GYROTOOUTPUT_AVERAGE] = latency_sum / latency_count;
+	status.GyroToOutput[CONTROLLOOPSTATUS_GYROTOOUTPUT_MAX] = latency_max;
+	ControlLoopStatusSet(&status);
+
+	last_publish_time = now;
+	latency_sum = 0;
+	latency_max = 0;
+	latency_count = 0;
+}
+
+/**
+ * Compile the mixer settings into the mixer matrix, must be called with
+ * mixer_mutex held after either settings object changed.
+ *
+ * The scale is a power of two, so applying it here gives the same results
+ * as scaling each sum.
+ */
+static void compile_mixer()
+{
+	mixer.num_mixers = 0;
 
+	for (int ct = 0; ct < MAX_MIX_ACTUATORS; ct++) {
+		// Taking the pointer to the array preserves type information so smart compilers
+		// can detect accesses past the end.
+		typeof(mixerSettings.Mixer1Vector) *vector = get_mixer_vec(ct);
+
+		mixer.type[ct] = get_mixer_type(ct);
+		if (mixer.type[ct] != MIXERSETTINGS_MIXER1TYPE_DISABLED)
+			mixer.num_mixers++;
+
+		for (int i = 0; i < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; i++)
+			mixer.matrix[ct][i] = (*vector)[i] * (1.0f / MULTIROTOR_MIXER_UPPER_BOUND);
 	}
+
+	// powf() is expensive without an FPU and the usual curve is linear
+	mixer.linear_motors = actuatorSettings.MotorInputOutputCurveFit[ACTUATORSETTINGS_MOTORINPUTOUTPUTCURVEFIT_B] == 1.0f;
 }
 
 /**
  *Process mixing for one actuator
  */
-float process_mixer(const int index, const float curve1, const float curve2,
-		ActuatorDesiredData *desired)
+static float process_mixer(const int index, const float *inputs)
 {
-	// Taking the pointer to the array preserves type information so smart compilers
-	// can detect accesses past the end.
-	typeof(mixerSettings.Mixer1Vector) *vector = get_mixer_vec(index);
+	float result = 0;
 
-	float result = (((*vector)[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE1] * curve1) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_THROTTLECURVE2] * curve2) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_ROLL] * desired->Roll) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_PITCH] * desired->Pitch) +
-			((*vector)[MIXERSETTINGS_MIXER1VECTOR_YAW] * desired->Yaw)) * (1.0f / MULTIROTOR_MIXER_UPPER_BOUND);
+	for (int i = 0; i < MIXERSETTINGS_MIXER1VECTOR_NUMELEM; i++)
+		result += mixer.matrix[index][i] * inputs[i];
 
 	return (result);
 }
@@ -413,7 +577,7 @@ static float scale_channel(float value, int idx)
 
 static float channel_failsafe_value(int idx)
 {
-	switch (get_mixer_type(idx)) {
+	switch (mixer.type[idx]) {
 	case MIXERSETTINGS_MIXER1TYPE_MOTOR:
 		return actuatorSettings.ChannelMin[idx];
 	case MIXERSETTINGS_MIXER1TYPE_SERVO:
@@ -588,16 +752,23 @@ static bool set_channel(uint8_t mixer_channel, float value)
 static void actuator_update_rate_if_changed(bool force_update)
 {
 	static uint16_t prevChannelUpdateFreq[ACTUATORSETTINGS_TIMERUPDATEFREQ_NUMELEM];
+	static uint8_t prevPwmResolution[ACTUATORSETTINGS_TIMERPWMRESOLUTION_NUMELEM];
 
-	// check if the any rate setting is changed
+	// check if the any rate or resolution setting is changed
 	if (force_update ||
 			memcmp(prevChannelUpdateFreq,
 				actuatorSettings.TimerUpdateFreq,
-				sizeof(prevChannelUpdateFreq)) != 0) {
+				sizeof(prevChannelUpdateFreq)) != 0 ||
+			memcmp(prevPwmResolution,
+				actuatorSettings.TimerPwmResolution,
+				sizeof(prevPwmResolution)) != 0) {
 		/* Something has changed, apply the settings to HW */
 		memcpy(prevChannelUpdateFreq,
 				actuatorSettings.TimerUpdateFreq,
 				sizeof(prevChannelUpdateFreq));
+		memcpy(prevPwmResolution,
+				actuatorSettings.TimerPwmResolution,
+				sizeof(prevPwmResolution));
 		PIOS_Servo_SetMode(actuatorSettings.TimerUpdateFreq, actuatorSettings.TimerPwmResolution,
 				ACTUATORSETTINGS_TIMERPWMRESOLUTION_NUMELEM);
 	}
@@ -608,10 +779,9 @@ static void settings_update_cb(UAVObjEvent * ev)
 	settings_updated = true;
 }
 
-static float mix_channel(int ct, ActuatorDesiredData *desired,
-		float curve1, float curve2)
+static float mix_channel(int ct, const float *inputs)
 {
-	MixerSettingsMixer1TypeOptions type = get_mixer_type(ct);
+	MixerSettingsMixer1TypeOptions type = mixer.type[ct];
 
 	switch (type) {
 	case MIXERSETTINGS_MIXER1TYPE_DISABLED:
@@ -620,17 +790,18 @@ static float mix_channel(int ct, ActuatorDesiredData *desired,
 		break;
 
 	case MIXERSETTINGS_MIXER1TYPE_SERVO:
-		return process_mixer(ct, curve1, curve2, desired);
+		return process_mixer(ct, inputs);
 		break;
 
 	case MIXERSETTINGS_MIXER1TYPE_MOTOR:
 		(void) 0;               // nil statement
-		float val = process_mixer(ct, curve1, curve2, desired);
+		float val = process_mixer(ct, inputs);
 
 		if (val > 0) {
 			// Apply curve fitting, mapping the input to the propeller output.
-			val = actuatorSettings.MotorInputOutputCurveFit[ACTUATORSETTINGS_MOTORINPUTOUTPUTCURVEFIT_A] *
-					powf(val, actuatorSettings.MotorInputOutputCurveFit[ACTUATORSETTINGS_MOTORINPUTOUTPUTCURVEFIT_B]);
+			if (!mixer.linear_motors)
+				val = powf(val, actuatorSettings.MotorInputOutputCurveFit[ACTUATORSETTINGS_MOTORINPUTOUTPUTCURVEFIT_B]);
+			val *= actuatorSettings.MotorInputOutputCurveFit[ACTUATORSETTINGS_MOTORINPUTOUTPUTCURVEFIT_A];
 		} else {
 			// Idle throttle
 			val = 0.0f;
@@ -764,7 +935,10 @@ static typeof(mixerSettings.Mixer1Vector) *get_mixer_vec(int idx)
 }
 
 #define OUTPUT_MODE_ASSUMPTIONS ( ( (int) PWM_MODE_1MHZ == ACTUATORSETTINGS_TIMERPWMRESOLUTION_1MHZ ) && \
-	( (int) PWM_MODE_12MHZ == ACTUATORSETTINGS_TIMERPWMRESOLUTION_12MHZ ) )
+	( (int) PWM_MODE_12MHZ == ACTUATORSETTINGS_TIMERPWMRESOLUTION_12MHZ ) && \
+	( (int) PWM_MODE_DSHOT150 == ACTUATORSETTINGS_TIMERPWMRESOLUTION_DSHOT150 ) && \
+	( (int) PWM_MODE_DSHOT300 == ACTUATORSETTINGS_TIMERPWMRESOLUTION_DSHOT300 ) && \
+	( (int) PWM_MODE_DSHOT600 == ACTUATORSETTINGS_TIMERPWMRESOLUTION_DSHOT600 ) )
 
 DONT_BUILD_IF(!OUTPUT_MODE_ASSUMPTIONS, OutputModeAssumptions);
 
@@ -0,0 +1,44 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup ActuatorModule Actuator Module
+ * @{
+ *
+ * @file       actuator.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Actuator module. Drives the actuators (servos, motors etc).
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include "openpilot.h"
+#include "actuatordesired.h"
+
+bool actuator_fused_update(ActuatorDesiredData *desired, uint32_t sample_time);
+
+#endif /* ACTUATOR_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -36,6 +36,7 @@
 #include "gpsvelocity.h"
 #include "attitudeactual.h"
 #include "coordinate_conversions.h"
+#include "attitude_cache.h"
 
 
 // Private constants
@@ -73,18 +74,12 @@ void gps_airspeedInitialize()
 	gps->gpsVelOld_E=gpsVelData.East;
 	gps->gpsVelOld_D=gpsVelData.Down;
 	
-	AttitudeActualData attData;
-	AttitudeActualGet(&attData);
+	struct attitude_derived attitude;
+	AttitudeCacheGet(&attitude);
 	
-	float Rbe[3][3];
-	float q[4] ={attData.q1, attData.q2, attData.q3, attData.q4};
-	
-	//Calculate rotation matrix
-	Quaternion2R(q, Rbe);
-	
-	gps->RbeCol1_old[0]=Rbe[0][0];
-	gps->RbeCol1_old[1]=Rbe[0][1];
-	gps->RbeCol1_old[2]=Rbe[0][2];
+	gps->RbeCol1_old[0]=attitude.Rbe[0][0];
+	gps->RbeCol1_old[1]=attitude.Rbe[0][1];
+	gps->RbeCol1_old[2]=attitude.Rbe[0][2];
 }
 
 /*
@@ -98,17 +93,9 @@ void gps_airspeedInitialize()
  */
 void gps_airspeedGet(float *v_air_GPS)
 {	
-	float Rbe[3][3];
-	
-	{ //Scoping to save memory. We really just need Rbe.
-		AttitudeActualData attData;
-		AttitudeActualGet(&attData);
-		
-		float q[4] ={attData.q1, attData.q2, attData.q3, attData.q4};
-		
-		//Calculate rotation matrix
-		Quaternion2R(q, Rbe);
-	}
+	struct attitude_derived attitude;
+	AttitudeCacheGet(&attitude);
+	float (*Rbe)[3] = attitude.Rbe;
 	
 	//Calculate the cos(angle) between the two fuselage basis vectors
 	float cosDiff=(Rbe[0][0]*gps->RbeCol1_old[0]) + (Rbe[0][1]*gps->RbeCol1_old[1]) + (Rbe[0][2]*gps->RbeCol1_old[2]);
@@ -55,6 +55,8 @@
 #include "physical_constants.h"
 #include "coordinate_conversions.h"
 #include "WorldMagModel.h"
+#include "latencymonitor.h"
+#include "attitude_cache.h"
 
 // UAVOs
 #include "accels.h"
@@ -74,7 +76,10 @@
 #include "magnetometer.h"
 #include "nedaccel.h"
 #include "nedposition.h"
+#include "opticalflow.h"
+#include "opticalflowsettings.h"
 #include "positionactual.h"
+#include "rangefinderdistance.h"
 #include "stateestimation.h"
 #include "systemalarms.h"
 #include "velocityactual.h"
@@ -142,6 +147,7 @@ static struct pios_queue *magQueue;
 static struct pios_queue *baroQueue;
 static struct pios_queue *gpsQueue;
 static struct pios_queue *gpsVelQueue;
+static struct pios_queue *flowQueue;
 
 static AttitudeSettingsData attitudeSettings;
 static HomeLocationData homeLocation;
@@ -195,6 +201,15 @@ static void accumulate_gyro_zero();
 //! Store a gyro sample
 static void accumulate_gyro(GyrosData *gyrosData);
 
+//! Time the samples behind the latest gyro update were taken
+static uint32_t gyro_sample_time();
+
+//! Remember the INS velocity at a gyro sample time
+static void flow_history_record(uint32_t sample_time);
+
+//! Shift a flow velocity to the current time by the INS velocity change since it was sampled
+static void flow_delay_compensate(uint32_t flow_time, const float vel_now[2], float flow_ned[2]);
+
 //! Set alarm and alarm code
 static void set_state_estimation_error(SystemAlarmsStateEstimationOptions error_code);
 
@@ -252,6 +267,7 @@ int32_t AttitudeStart(void)
 	baroQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	gpsQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	gpsVelQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	flowQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 
 	// Initialize quaternion
 	AttitudeActualData attitude;
@@ -280,16 +296,18 @@ int32_t AttitudeStart(void)
 		GPSPositionConnectQueue(gpsQueue);
 	if (GPSVelocityHandle())
 		GPSVelocityConnectQueue(gpsVelQueue);
+	if (OpticalFlowHandle())
+		OpticalFlowConnectQueue(flowQueue);
 
 	// Start main task
-	attitudeTaskHandle = PIOS_Thread_Create(AttitudeTask, "Attitude", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	attitudeTaskHandle = PIOS_Thread_Create_Fast(AttitudeTask, "Attitude", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 	TaskMonitorAdd(TASKINFO_RUNNING_ATTITUDE, attitudeTaskHandle);
 	PIOS_WDG_RegisterFlag(PIOS_WDG_ATTITUDE);
 
 	return 0;
 }
 
-MODULE_INITCALL(AttitudeInitialize, AttitudeStart)
+MODULE_CRITICAL_INITCALL(AttitudeInitialize, AttitudeStart)
 
 /**
  * Module thread, should not return.
@@ -407,7 +425,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	UAVObjEvent ev;
 	GyrosData gyrosData;
 	AccelsData accelsData;
-	static int32_t timeval;
+	static uint32_t timeval;
 	float dT;
 
 	// If this is the primary estimation filter, wait until the accel and
@@ -442,7 +460,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 		magData.z = 0;
 
 		// Wait for a mag reading if a magnetometer was registered
-		if (PIOS_SENSORS_GetQueue(PIOS_SENSOR_MAG) != NULL) {
+		if (PIOS_SENSORS_IsRegistered(PIOS_SENSOR_MAG)) {
 			if (!secondary && PIOS_Queue_Receive(magQueue, &ev, 20) != true) {
 				return -1;
 			}
@@ -484,7 +502,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 
 		complementary_filter_state.initialization = CF_POWERON;
 		complementary_filter_state.reset_timeval = PIOS_DELAY_GetRaw();
-		timeval = PIOS_DELAY_GetRaw();
+		timeval = gyro_sample_time();
 
 		complementary_filter_state.arming_count = 0;
 
@@ -574,9 +592,11 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	GyrosGet(&gyrosData);
 	accumulate_gyro(&gyrosData);
 
-	// Compute the dT using the cpu clock
-	dT = PIOS_DELAY_DiffuS(timeval) / 1000000.0f;
-	timeval = PIOS_DELAY_GetRaw();
+	// Integrate over the time between the gyro samples rather than the
+	// time between the runs of this task
+	uint32_t sample_time = gyro_sample_time();
+	dT = PIOS_DELAY_DiffuS2(timeval, sample_time) / 1000000.0f;
+	timeval = sample_time;
 
 	float grot[3];
 	float accel_err[3];
@@ -586,11 +606,10 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	// Apply smoothing to accel values, to reduce vibration noise before main calculations.
 	apply_accel_filter(&accelsData.x,accels_filtered);
 
-	// Rotate gravity to body frame and cross with accels
+	// Rotate gravity to body frame
 	grot[0] = -(2 * (cf_q[1] * cf_q[3] - cf_q[0] * cf_q[2]));
 	grot[1] = -(2 * (cf_q[2] * cf_q[3] + cf_q[0] * cf_q[1]));
 	grot[2] = -(cf_q[0]*cf_q[0] - cf_q[1]*cf_q[1] - cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3]);
-	CrossProduct((const float *) &accelsData.x, (const float *) grot, accel_err);
 
 	// Apply same filtering to the rotated attitude to match delays
 	apply_accel_filter(grot,grot_filtered);
@@ -699,12 +718,7 @@ static int32_t updateAttitudeComplementary(bool first_run, bool secondary, bool
 	}
 
 	// Renomalize
-	float qmag;
-	qmag = sqrtf(cf_q[0]*cf_q[0] + cf_q[1]*cf_q[1] + cf_q[2]*cf_q[2] + cf_q[3]*cf_q[3]);
-	cf_q[0] = cf_q[0] / qmag;
-	cf_q[1] = cf_q[1] / qmag;
-	cf_q[2] = cf_q[2] / qmag;
-	cf_q[3] = cf_q[3] / qmag;
+	float qmag = vectorn_normalize(cf_q, 4);
 
 	// If quaternion has become inappropriately short or has become Nan reinit.
 	// THIS SHOULD NEVER ACTUALLY HAPPEN
@@ -888,6 +902,9 @@ static int32_t setAttitudeComplementary()
 	AttitudeActualData attitude;
 	quat_copy(cf_q, &attitude.q1);
 	Quaternion2RPY(&attitude.q1,&attitude.Roll);
+#if defined(LATENCY_DIAGNOSTICS)
+	LatencyMonitorMark(LATENCY_STAGE_ATTITUDE);
+#endif
 	AttitudeActualSet(&attitude);
 
 	return 0;
@@ -927,6 +944,17 @@ static void accumulate_gyro_zero()
 	complementary_filter_state.accumulated_gyro[2] = 0;
 }
 
+/**
+ * Get the PIOS_DELAY_GetRaw() time the samples behind the latest gyro
+ * update were taken, or the current time when the sensors do not report
+ * it (e.g. the simulated ones)
+ */
+static uint32_t gyro_sample_time()
+{
+	uint32_t sample_time = PIOS_SENSORS_GetUpdateTime(PIOS_SENSOR_GYRO);
+	return sample_time ? sample_time : PIOS_DELAY_GetRaw();
+}
+
 /**
  * Accumulate a set of gyro samples for computing the
  * bias
@@ -981,11 +1009,16 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	static bool baro_updated;
 	static bool gps_updated;
 	static bool gps_vel_updated;
+	static bool flow_updated;
 
 	static float baro_offset = 0;
 
 	static uint32_t ins_last_time = 0;
 	static uint32_t ins_init_time = 0;
+	static uint32_t flow_used_time = 0;
+
+	static float cov_dT = 0;
+	static uint8_t cov_skipped = 0;
 
 	static enum {INS_INIT, INS_WARMUP, INS_RUNNING} ins_state;
 
@@ -1006,10 +1039,12 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		baro_updated = false;
 		gps_updated = false;
 		gps_vel_updated = false;
+		flow_updated = false;
+		flow_used_time = 0;
 
 		home_location_updated = false;
 
-		ins_last_time = PIOS_DELAY_GetRaw();
+		ins_last_time = gyro_sample_time();
 
 		return 0;
 	}
@@ -1018,6 +1053,7 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	baro_updated = baro_updated || PIOS_Queue_Receive(baroQueue, &ev, 0);
 	gps_updated = gps_updated || (PIOS_Queue_Receive(gpsQueue, &ev, 0) && outdoor_mode);
 	gps_vel_updated = gps_vel_updated || (PIOS_Queue_Receive(gpsVelQueue, &ev, 0) && outdoor_mode);
+	flow_updated = flow_updated || PIOS_Queue_Receive(flowQueue, &ev, 0);
 
 	// Wait until the gyro and accel object is updated, if a timeout then go to failsafe
 	if (PIOS_Queue_Receive(gyroQueue, &ev, FAILSAFE_TIMEOUT_MS) != true ||
@@ -1148,8 +1184,11 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		// state to make sure filter converges
 		ins_state = INS_WARMUP;
 
-		ins_last_time = PIOS_DELAY_GetRaw();	
-		ins_init_time = ins_last_time;
+		cov_dT = 0;
+		cov_skipped = 0;
+
+		ins_last_time = gyro_sample_time();
+		ins_init_time = PIOS_DELAY_GetRaw();
 
 		return 0;
 	} else if (ins_state == INS_INIT)
@@ -1170,8 +1209,9 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	      (gpsData.PDOP <= insSettings.MinRNAVPDOP) &&
 	      (homeLocation.Set == HOMELOCATION_SET_TRUE);
 
-	dT = PIOS_DELAY_DiffuS(ins_last_time) / 1.0e6f;
-	ins_last_time = PIOS_DELAY_GetRaw();
+	uint32_t sample_time = gyro_sample_time();
+	dT = PIOS_DELAY_DiffuS2(ins_last_time, sample_time) / 1.0e6f;
+	ins_last_time = sample_time;
 
 	// This should only happen at start up or at mode switches
 	if(dT > 0.01f)
@@ -1204,8 +1244,8 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	// Advance the state estimate
 	INSStatePrediction(gyros, &accelsData.x, dT);
 
-	// Advance the covariance estimate
-	INSCovariancePrediction(dT);
+	if (OpticalFlowHandle())
+		flow_history_record(sample_time);
 
 	if(mag_updated) {
 		sensors |= MAG_SENSORS;
@@ -1271,9 +1311,46 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		INSSetPosVelVar(pos_var, speed_var, v_pos_var);
 	}
 
-	// Update fake position at 10 hz
+	// Optical flow velocity update, at the rate of the flow sensor. The
+	// flow is only metric while the rangefinder sees the ground.
+	bool flow_usable = false;
+	float flow_vel[2];
+	if (flow_updated) {
+		OpticalFlowData flow;
+		OpticalFlowGet(&flow);
+
+		uint8_t min_quality;
+		OpticalFlowSettingsQualityGet(&min_quality);
+
+		uint8_t ranging = RANGEFINDERDISTANCE_RANGINGSTATUS_INRANGE;
+		if (RangefinderDistanceHandle())
+			RangefinderDistanceRangingStatusGet(&ranging);
+
+		if (flow.Quality >= min_quality && ranging == RANGEFINDERDISTANCE_RANGINGSTATUS_INRANGE &&
+		    !IS_NOT_FINITE(flow.x) && !IS_NOT_FINITE(flow.y)) {
+			float ins_vel[3], q[4];
+			INSGetState(NULL, ins_vel, q, NULL, NULL);
+
+			// The flow is in the body frame, rotate it by the heading
+			float psi = atan2f(2.0f * (q[0] * q[3] + q[1] * q[2]), 1.0f - 2.0f * (q[2] * q[2] + q[3] * q[3]));
+			float c = cosf(psi), s = sinf(psi);
+			flow_vel[0] = c * flow.x - s * flow.y;
+			flow_vel[1] = s * flow.x + c * flow.y;
+
+			flow_delay_compensate(PIOS_SENSORS_GetUpdateTime(PIOS_SENSOR_OPTICAL_FLOW), ins_vel, flow_vel);
+
+			flow_usable = true;
+			flow_used_time = PIOS_DELAY_GetRaw();
+		}
+
+		flow_updated = false;
+	}
+
+	// Update fake position at 10 hz, unless the flow has recently been
+	// holding the horizontal velocity
 	static uint32_t indoor_pos_time;
-	if (!outdoor_mode && PIOS_DELAY_DiffuS(indoor_pos_time) > 100000) {
+	bool flow_active = flow_used_time != 0 && PIOS_DELAY_DiffuS(flow_used_time) < 200000;
+	if (!outdoor_mode && !flow_active && PIOS_DELAY_DiffuS(indoor_pos_time) > 100000) {
 		sensors |= HORIZ_VEL_SENSORS | HORIZ_POS_SENSORS;
 
 		indoor_pos_time = PIOS_DELAY_GetRaw();
@@ -1282,12 +1359,33 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 		NED[2] = -(baroData.Altitude + baro_offset);
 	}
 
+	// Advance the covariance estimate.  To save CPU this can run once every
+	// few cycles over the accumulated time step, but it always runs before
+	// a correction so that uses an up to date covariance.
+	cov_dT += dT;
+	cov_skipped++;
+	if (sensors || flow_usable || cov_skipped >= insSettings.CovariancePredictionDecimation) {
+		INSCovariancePrediction(cov_dT);
+		cov_dT = 0;
+		cov_skipped = 0;
+	}
+
 	/*
 	 * TODO: Need to add a general sanity check for all the inputs to make sure their kosher
 	 * although probably should occur within INS itself
 	 */
-	if (sensors)
-		INSCorrection(&magData.x, NED, vel, ( baroData.Altitude + baro_offset ), sensors);
+	// Only run the correction rows of the sensors that were updated, in
+	// the same order INSCorrection would process them
+	if (sensors & POS_SENSORS)
+		INSPositionCorrection(NED, sensors & VERT_POS_SENSORS);
+	if (sensors & (HORIZ_VEL_SENSORS | VERT_VEL_SENSORS))
+		INSVelocityCorrection(vel, sensors & VERT_VEL_SENSORS);
+	if (flow_usable)
+		INSFlowCorrection(flow_vel, insSettings.FlowVar);
+	if (sensors & MAG_SENSORS)
+		INSMagCorrection(&magData.x);
+	if (sensors & BARO_SENSOR)
+		INSBaroCorrection(baroData.Altitude + baro_offset);
 
 	// Export the state and variance for monitoring the EKF
 	INSStateData state;
@@ -1304,6 +1402,59 @@ static int32_t updateAttitudeINSGPS(bool first_run, bool outdoor_mode)
 	return 0;
 }
 
+#define FLOW_HISTORY_LEN 32
+
+//! INS horizontal velocities at the latest gyro sample times, as a ring
+static struct {
+	uint32_t time;
+	float vel[2];
+} flow_history[FLOW_HISTORY_LEN];
+static uint8_t flow_history_head;
+
+/**
+ * Store the INS velocity after the prediction for a gyro sample, so a flow
+ * sample can later be compared to the state at the time it was taken
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time of the gyro sample
+ */
+static void flow_history_record(uint32_t sample_time)
+{
+	float vel[3];
+	INSGetState(NULL, vel, NULL, NULL, NULL);
+
+	flow_history_head = (flow_history_head + 1) % FLOW_HISTORY_LEN;
+	flow_history[flow_history_head].time = sample_time;
+	flow_history[flow_history_head].vel[0] = vel[0];
+	flow_history[flow_history_head].vel[1] = vel[1];
+}
+
+/**
+ * The flow arrives some tens of ms after the motion it measured. Rather than
+ * rewinding the filter, add the velocity change the INS predicted since then
+ * so the innovation is taken against the state at the sample time.
+ * @param[in] flow_time PIOS_DELAY_GetRaw() time the flow was sampled
+ * @param[in] vel_now current INS horizontal velocity
+ * @param[in,out] flow_ned the flow velocity in NED, shifted to the current time
+ */
+static void flow_delay_compensate(uint32_t flow_time, const float vel_now[2], float flow_ned[2])
+{
+	if (flow_time == 0)
+		return;
+
+	// Newest entry at or before the flow sample, or the oldest one we have
+	uint8_t idx = flow_history_head;
+	for (uint8_t i = 0; i < FLOW_HISTORY_LEN - 1; i++) {
+		if ((int32_t)(flow_history[idx].time - flow_time) <= 0)
+			break;
+		idx = (idx + FLOW_HISTORY_LEN - 1) % FLOW_HISTORY_LEN;
+	}
+
+	if (flow_history[idx].time == 0)
+		return;
+
+	flow_ned[0] += vel_now[0] - flow_history[idx].vel[0];
+	flow_ned[1] += vel_now[1] - flow_history[idx].vel[1];
+}
+
 //! Set the attitude to the current INSGPS estimate
 static int32_t setAttitudeINSGPS()
 {
@@ -1312,6 +1463,9 @@ static int32_t setAttitudeINSGPS()
 
 	INSGetState(NULL, NULL, &attitude.q1, gyro_bias, NULL);
 	Quaternion2RPY(&attitude.q1,&attitude.Roll);
+#if defined(LATENCY_DIAGNOSTICS)
+	LatencyMonitorMark(LATENCY_STAGE_ATTITUDE);
+#endif
 	AttitudeActualSet(&attitude);
 
 	if (insSettings.ComputeGyroBias == INSSETTINGS_COMPUTEGYROBIAS_TRUE && 
@@ -1386,8 +1540,6 @@ static int32_t getNED(GPSPositionData * gpsPosition, float * NED)
 static void updateNedAccel()
 {
 	float accel[3];
-	float q[4];
-	float Rbe[3][3];
 	float accel_ned[3];
 	const float TAU = 0.95f;
 
@@ -1399,17 +1551,12 @@ static void updateNedAccel()
 	accel[2] = accels.z;
 	
 	//rotate avg accels into earth frame and store it
-	AttitudeActualData attitudeActual;
-	AttitudeActualGet(&attitudeActual);
-	q[0]=attitudeActual.q1;
-	q[1]=attitudeActual.q2;
-	q[2]=attitudeActual.q3;
-	q[3]=attitudeActual.q4;
-	Quaternion2R(q, Rbe);
+	struct attitude_derived attitude;
+	AttitudeCacheGet(&attitude);
 	for (uint8_t i = 0; i < 3; i++) {
 		accel_ned[i] = 0;
 		for (uint8_t j = 0; j < 3; j++)
-			accel_ned[i] += Rbe[j][i] * accel[j];
+			accel_ned[i] += attitude.Rbe[j][i] * accel[j];
 	}
 	accel_ned[2] += GRAVITY;
 	
@@ -55,6 +55,7 @@
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 
 #define SENSOR_PERIOD 4
+#define MAX_GYRO_BLOCK 8	// most gyro samples integrated per filter update
 #define GYRO_NEUTRAL 1665
 
 // Private types
@@ -74,11 +75,11 @@ static void AttitudeTask(void *parameters);
 
 static float gyro_correct_int[3] = {0,0,0};
 
-static int32_t updateSensorsDigital(AccelsData * accelsData, GyrosData * gyrosData);
-static void updateAttitude(AccelsData *, GyrosData *);
+static int32_t updateSensorsDigital(AccelsData * accelsData, GyrosData * gyrosData, float gyro_block[][3], uint32_t *block_len, uint32_t *block_time);
+static void updateAttitude(AccelsData *, float gyro_block[][3], uint32_t block_len, uint32_t block_time);
 static void settingsUpdatedCb(UAVObjEvent * objEv);
-static void update_accels(struct pios_sensor_accel_data *accels, AccelsData * accelsData);
-static void update_gyros(struct pios_sensor_gyro_data *gyros, GyrosData * gyrosData);
+static void update_accels(const struct pios_sensor_accel_data *accels, AccelsData * accelsData);
+static void update_gyros(const struct pios_sensor_gyro_data *gyros, GyrosData * gyrosData);
 static void updateTemperatureComp(float temperature, float *temp_bias);
 
 //! Compute the mean gyro accumulated and assign the bias
@@ -102,6 +103,9 @@ static int8_t rotate = 0;
 static bool zero_during_arming = false;
 static bool bias_correct_gyro = true;
 
+//! Calibrated gyro samples that arrived since the last filter update
+static float gyro_block[MAX_GYRO_BLOCK][3];
+
 // For computing the average gyro during arming
 static bool accumulating_gyro = false;
 static uint32_t accumulated_gyro_samples = 0;
@@ -162,7 +166,7 @@ int32_t AttitudeInitialize(void)
 	return 0;
 }
 
-MODULE_INITCALL(AttitudeInitialize, AttitudeStart)
+MODULE_CRITICAL_INITCALL(AttitudeInitialize, AttitudeStart)
 
 /**
  * Module thread, should not return.
@@ -249,9 +253,11 @@ static void AttitudeTask(void *parameters)
 
 		AccelsData accels;
 		GyrosData gyros;
+		uint32_t block_len = 0;
+		uint32_t block_time = 0;
 		int32_t retval = 0;
 
-		retval = updateSensorsDigital(&accels, &gyros);
+		retval = updateSensorsDigital(&accels, &gyros, gyro_block, &block_len, &block_time);
 
 		// During power on set to angle from accel
 		if (complimentary_filter_status == CF_POWERON) {
@@ -269,7 +275,7 @@ static void AttitudeTask(void *parameters)
 		else {
 			// Do not update attitude data in simulation mode
 			if (!AttitudeActualReadOnly())
-				updateAttitude(&accels, &gyros);
+				updateAttitude(&accels, gyro_block, block_len, block_time);
 
 			AlarmsClear(SYSTEMALARMS_ALARM_ATTITUDE);
 		}
@@ -279,31 +285,68 @@ static void AttitudeTask(void *parameters)
 /**
  * Get an update from the sensors
  * @param[in] attitudeRaw Populate the UAVO instead of saving right here
+ * @param[out] gyro_block calibrated gyro samples waiting since the last update
+ * @param[out] block_len number of samples stored in gyro_block
+ * @param[out] block_time PIOS_DELAY_GetRaw() time the newest sample of the block was taken
  * @return 0 if successfull, -1 if not
  */
-static int32_t updateSensorsDigital(AccelsData * accelsData, GyrosData * gyrosData)
+static int32_t updateSensorsDigital(AccelsData * accelsData, GyrosData * gyrosData, float gyro_block[][3], uint32_t *block_len, uint32_t *block_time)
 {
 	struct pios_sensor_gyro_data gyros;
 	struct pios_sensor_accel_data accels;
-	struct pios_queue *queue;
+	const struct pios_sensor_gyro_data *gyro_sample;
+	const struct pios_sensor_accel_data *accel_sample;
 
-	queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
-	if(queue == NULL || PIOS_Queue_Receive(queue, (void *) &gyros, 4) == false) {
+	gyro_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_GYRO, &gyros, 4);
+	if (gyro_sample == NULL) {
 		return-1;
 	}
 
 	// As it says below, because the rest of the code expects the accel to be ready when
 	// the gyro is we must block here too
-	queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
-	if(queue == NULL || PIOS_Queue_Receive(queue, (void *) &accels, 1) == false) {
+	accel_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_ACCEL, &accels, 1);
+	if (accel_sample == NULL) {
+		PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_GYRO);
 		return -1;
 	}
-	else
-		update_accels(&accels, accelsData);
+	else {
+		update_accels(accel_sample, accelsData);
+		PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_ACCEL);
+	}
 
 	// Update gyros after the accels since the rest of the code expects
-	// the accels to be available first
-	update_gyros(&gyros, gyrosData);
+	// the accels to be available first. When the driver delivered a burst
+	// take all of it so the filter integrates the block in one pass.
+	float gyro_sum[3] = {0, 0, 0};
+	uint32_t n = 0;
+
+	do {
+		update_gyros(gyro_sample, gyrosData);
+		*block_time = gyro_sample->sample_time;
+		PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_GYRO);
+
+		gyro_block[n][0] = gyrosData->x;
+		gyro_block[n][1] = gyrosData->y;
+		gyro_block[n][2] = gyrosData->z;
+		gyro_sum[0] += gyrosData->x;
+		gyro_sum[1] += gyrosData->y;
+		gyro_sum[2] += gyrosData->z;
+		n++;
+	} while (n < MAX_GYRO_BLOCK &&
+	         (gyro_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_GYRO, &gyros, 0)) != NULL);
+
+	*block_len = n;
+
+	// Drivers that do not stamp their samples are taken as read now
+	if (*block_time == 0)
+		*block_time = PIOS_DELAY_GetRaw();
+
+	// Publish the block mean
+	if (n > 1) {
+		gyrosData->x = gyro_sum[0] / n;
+		gyrosData->y = gyro_sum[1] / n;
+		gyrosData->z = gyro_sum[2] / n;
+	}
 
 	GyrosSet(gyrosData);
 	AccelsSet(accelsData);
@@ -315,7 +358,7 @@ static int32_t updateSensorsDigital(AccelsData * accelsData, GyrosData * gyrosDa
  * @brief Apply calibration and rotation to the raw accel data
  * @param[in] accels The raw accel data
  */
-static void update_accels(struct pios_sensor_accel_data *accels, AccelsData * accelsData)
+static void update_accels(const struct pios_sensor_accel_data *accels, AccelsData * accelsData)
 {
 	// Average and scale the accels before rotation
 	float accels_out[3] = {accels->x * sensorSettings.AccelScale[0] - sensorSettings.AccelBias[0],
@@ -341,7 +384,7 @@ static void update_accels(struct pios_sensor_accel_data *accels, AccelsData * ac
  * @brief Apply calibration and rotation to the raw gyro data
  * @param[in] gyros The raw gyro data
  */
-static void update_gyros(struct pios_sensor_gyro_data *gyros, GyrosData * gyrosData)
+static void update_gyros(const struct pios_sensor_gyro_data *gyros, GyrosData * gyrosData)
 {
 	static float gyro_temp_bias[3] = {0,0,0};
 
@@ -450,23 +493,27 @@ static inline void apply_accel_filter(const float * raw, float * filtered)
 	}
 }
 
-static void updateAttitude(AccelsData * accelsData, GyrosData * gyrosData)
+static void updateAttitude(AccelsData * accelsData, float gyro_block[][3], uint32_t block_len, uint32_t block_time)
 {
 	float dT;
-	uint32_t thisSysTime = PIOS_Thread_Systime();
-	static uint32_t lastSysTime = 0;
+	static uint32_t last_block_time = 0;
 	static float accels_filtered[3] = {0,0,0};
 	static float grot_filtered[3] = {0,0,0};
 
-	dT = (thisSysTime == lastSysTime) ? 0.001f : (PIOS_THREAD_TIMEOUT_MAX & (thisSysTime - lastSysTime)) / 1000.0f;
-	lastSysTime = thisSysTime;
+	// Integrate over the time between the gyro samples rather than the
+	// time between the runs of this task
+	dT = (last_block_time == 0 || block_time == last_block_time) ? 0.001f :
+		PIOS_DELAY_DiffuS2(last_block_time, block_time) / 1000000.0f;
+	last_block_time = block_time;
+
+	// The samples of a block are spread evenly over the update period
+	dT /= block_len;
 	
 	// Bad practice to assume structure order, but saves memory
-	float * gyros = &gyrosData->x;
 	float * accels = &accelsData->x;
 	
 	float grot[3];
-	float accel_err[3];
+	float accel_err[3] = {0, 0, 0};
 
 	// Apply smoothing to accel values, to reduce vibration noise before main calculations.
 	apply_accel_filter(accels,accels_filtered);
@@ -499,16 +546,30 @@ static void updateAttitude(AccelsData * accelsData, GyrosData * gyrosData)
 		accel_err[2] /= (accel_mag*grot_mag);
 		
 		// Accumulate integral of error.  Scale here so that units are (deg/s) but Ki has units of s
-		gyro_correct_int[0] -= accel_err[0] * accelKi;
-		gyro_correct_int[1] -= accel_err[1] * accelKi;
-		
-		// Correct rates based on error, integral component dealt with in updateSensors
-		gyros[0] += accel_err[0] * accelKp / dT;
-		gyros[1] += accel_err[1] * accelKp / dT;
-		gyros[2] += accel_err[2] * accelKp / dT;
+		// The error is applied once per gyro sample as before
+		gyro_correct_int[0] -= accel_err[0] * accelKi * block_len;
+		gyro_correct_int[1] -= accel_err[1] * accelKi * block_len;
+	} else {
+		accel_err[0] = 0;
+		accel_err[1] = 0;
+		accel_err[2] = 0;
 	}
-	
-	{ // scoping variables to save memory
+
+	// Correct rates based on error, integral component dealt with in updateSensors
+	const float gyro_correct[3] = {
+		accel_err[0] * accelKp / dT,
+		accel_err[1] * accelKp / dT,
+		accel_err[2] * accelKp / dT
+	};
+
+	// Integrate the whole block before normalizing once
+	for (uint32_t i = 0; i < block_len; i++) {
+		float gyros[3] = {
+			gyro_block[i][0] + gyro_correct[0],
+			gyro_block[i][1] + gyro_correct[1],
+			gyro_block[i][2] + gyro_correct[2]
+		};
+
 		// Work out time derivative from INSAlgo writeup
 		// Also accounts for the fact that gyros are in deg/s
 		float qdot[4];
@@ -522,13 +583,13 @@ static void updateAttitude(AccelsData * accelsData, GyrosData * gyrosData)
 		q[1] = q[1] + qdot[1];
 		q[2] = q[2] + qdot[2];
 		q[3] = q[3] + qdot[3];
-		
-		if(q[0] < 0) {
-			q[0] = -q[0];
-			q[1] = -q[1];
-			q[2] = -q[2];
-			q[3] = -q[3];
-		}
+	}
+
+	if(q[0] < 0) {
+		q[0] = -q[0];
+		q[1] = -q[1];
+		q[2] = -q[2];
+		q[3] = -q[3];
 	}
 	
 	// Renomalize
@@ -11,6 +11,11 @@
  * @brief      State machine to run autotuning. Low level work done by @ref
  *             StabilizationModule 
  *
+ * The stabilization task hands every control cycle of the identification
+ * over in a ring buffer. They are run through the EKF in batches with the
+ * time each cycle really took, so no gyro sample is skipped or used twice
+ * and the run ends as soon as the parameters are known well enough.
+ *
  * @see        The GNU Public License (GPL) Version 3
  *
  ******************************************************************************/
@@ -44,6 +49,8 @@
 #include "systemident.h"
 #include <pios_board_info.h>
 #include "pios_thread.h"
+#include "pios_ringbuf.h"
+#include "stabilization.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1504
@@ -52,17 +59,30 @@
 #define AF_NUMX 13
 #define AF_NUMP 43
 
+//! How often the cycles collected are run through the EKF
+#define AF_BATCH_MS 5
+//! Cycles buffered, enough for the task being held off a while at 1 kHz
+#define AF_SAMPLES 24
+//! The process noise of the EKF was tuned for steps of this length
+#define AF_TUNED_DT_S 0.003f
+//! The run ends early once the torque scales and the motor time constant
+//! moved less than this over a whole window
+#define AF_SETTLE_CHANGE 0.05f
+#define AF_SETTLE_WINDOW_MS 5000
+
 // Private types
 enum AUTOTUNE_STATE {AT_INIT, AT_START, AT_RUN, AT_FINISHED, AT_SET};
 
 // Private variables
 static struct pios_thread *taskHandle;
+static struct pios_ringbuf *samples;
 static bool module_enabled;
 
 // Private functions
 static void AutotuneTask(void *parameters);
 static void af_predict(float X[AF_NUMX], float P[AF_NUMP], const float u_in[3], const float gyro[3], const float dT_s);
 static void af_init(float X[AF_NUMX], float P[AF_NUMP]);
+static bool af_settled(const float X[AF_NUMX], float reference[4]);
 
 /**
  * Initialise the module, called on startup
@@ -97,6 +117,11 @@ int32_t AutotuneStart(void)
 {
 	// Start main task if it is enabled
 	if(module_enabled) {
+		samples = PIOS_Ringbuf_Create(AF_SAMPLES, sizeof(struct stabilization_ident_sample));
+		if (samples == NULL)
+			return -1;
+		stabilization_ident_connect(samples);
+
 		taskHandle = PIOS_Thread_Create(AutotuneTask, "Autotune", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 
 		TaskMonitorAdd(TASKINFO_RUNNING_AUTOTUNE, taskHandle);
@@ -175,12 +200,11 @@ static void AutotuneTask(void *parameters)
 	float X[AF_NUMX] = {0};
 	float P[AF_NUMP] = {0};
 	float noise[3] = {0};
+	float settle_reference[4] = {0};
+	uint32_t settleTime = 0;
 
 	af_init(X,P);
 
-	uint32_t last_time = 0.0f;
-	const uint32_t DT_MS = 3;
-
 	while(1) {
 
 		PIOS_WDG_UpdateFlag(PIOS_WDG_AUTOTUNE);
@@ -191,6 +215,7 @@ static void AutotuneTask(void *parameters)
 		uint32_t diffTime;
 
 		const uint32_t PREPARE_TIME = 2000;
+		const uint32_t MIN_MEASURE_TIME = 20000;
 		const uint32_t MEASURE_TIME = 60000;
 
 		static uint32_t updateCounter = 0;
@@ -238,10 +263,13 @@ static void AutotuneTask(void *parameters)
 					lastUpdateTime = PIOS_Thread_Systime();
 				}
 
-
-				last_time = PIOS_DELAY_GetRaw();
+				// Cycles from before the run are not part of it
+				while (PIOS_Ringbuf_ReadPeek(samples) != NULL)
+					PIOS_Ringbuf_ReadRelease(samples);
 
 				updateCounter = 0;
+				settleTime = PIOS_Thread_Systime();
+				af_settled(X, settle_reference);
 
 				break;
 
@@ -251,41 +279,43 @@ static void AutotuneTask(void *parameters)
 
 				doingIdent = true;
 
-				// Update the system identification, but only when throttle is applied
-				// so bad values don't result when landing
-				if (throttle > 0) {
-					float y[3];
-					GyrosxGet(y+0);
-					GyrosyGet(y+1);
-					GyroszGet(y+2);
-
-					float u[3];
-					ActuatorDesiredRollGet(u+0);
-					ActuatorDesiredPitchGet(u+1);
-					ActuatorDesiredYawGet(u+2);
-
-					float dT_s = PIOS_DELAY_DiffuS(last_time) * 1.0e-6f;
-
-					af_predict(X,P,u,y, DT_MS * 0.001f);
-					for (uint32_t i = 0; i < 3; i++) {
-						const float NOISE_ALPHA = 0.9997f;  // 10 second time constant at 300 Hz
-						noise[i] = NOISE_ALPHA * noise[i] + (1-NOISE_ALPHA) * (y[i] - X[i]) * (y[i] - X[i]);
+				// Update the system identification with all cycles since the
+				// last batch, but only when throttle is applied so bad values
+				// don't result when landing
+				const struct stabilization_ident_sample *sample;
+				while ((sample = PIOS_Ringbuf_ReadPeek(samples)) != NULL) {
+					if (throttle > 0 && sample->dT > 0) {
+						af_predict(X, P, sample->actuator, sample->gyro, sample->dT);
+
+						const float NOISE_TAU = 10.0f;
+						const float noise_alpha = 1 - sample->dT / NOISE_TAU;
+						for (uint32_t i = 0; i < 3; i++) {
+							float error = sample->gyro[i] - X[i];
+							noise[i] = noise_alpha * noise[i] + (1 - noise_alpha) * error * error;
+						}
+
+						// Update uavo every 256 cycles to avoid
+						// telemetry spam
+						if (!((updateCounter++) & 0xff)) {
+							UpdateSystemIdent(X, noise, sample->dT, updateCounter);
+						}
 					}
 
-					// Update uavo every 256 cycles to avoid
-					// telemetry spam
-					if (!((updateCounter++) & 0xff)) {
-						UpdateSystemIdent(X, noise, dT_s, updateCounter);
-					}
+					PIOS_Ringbuf_ReadRelease(samples);
 				}
 
-				if (diffTime > MEASURE_TIME) { // Move on to next state
+				// Move on to next state once the parameters settled
+				bool settled = false;
+				if (PIOS_Thread_Systime() - settleTime > AF_SETTLE_WINDOW_MS) {
+					settleTime = PIOS_Thread_Systime();
+					settled = af_settled(X, settle_reference);
+				}
+
+				if (diffTime > MEASURE_TIME || (diffTime > MIN_MEASURE_TIME && settled)) {
 					state = AT_FINISHED;
 					lastUpdateTime = PIOS_Thread_Systime();
 				}
 
-				last_time = PIOS_DELAY_GetRaw();
-
 				break;
 
 			case AT_FINISHED:
@@ -316,18 +346,10 @@ static void AutotuneTask(void *parameters)
 		// Update based on manual controls
 		UpdateStabilizationDesired(doingIdent);
 
-		PIOS_Thread_Sleep(DT_MS);
+		PIOS_Thread_Sleep(AF_BATCH_MS);
 	}
 }
 
-/**
- * Prediction step for EKF on control inputs to quad that
- * learns the system properties
- * @param X the current state estimate which is updated in place
- * @param P the current covariance matrix, updated in place
- * @param[in] the current control inputs (roll, pitch, yaw)
- * @param[in] the gyro measurements
- */
 /**
  * Prediction step for EKF on control inputs to quad that
  * learns the system properties
@@ -392,7 +414,13 @@ __attribute__((always_inline)) static inline void af_predict(float X[AF_NUMX], f
 	const float q_bias = 1e-19f;
 	const float s_a = 3000.0f;  // expected gyro noise
 
-	const float Q[AF_NUMX] = {q_w, q_w, q_w, q_ud, q_ud, q_ud, q_B, q_B, q_B, q_tau, q_bias, q_bias, q_bias};
+	// The noise added per step goes with the step length, so the filter
+	// behaves the same whatever rate the loop runs at
+	const float q_scale = Ts / AF_TUNED_DT_S;
+	const float Q[AF_NUMX] = {q_w * q_scale, q_w * q_scale, q_w * q_scale,
+		q_ud * q_scale, q_ud * q_scale, q_ud * q_scale,
+		q_B * q_scale, q_B * q_scale, q_B * q_scale, q_tau * q_scale,
+		q_bias * q_scale, q_bias * q_scale, q_bias * q_scale};
 
 	float D[AF_NUMP];
 	for (uint32_t i = 0; i < AF_NUMP; i++)
@@ -538,6 +566,26 @@ __attribute__((always_inline)) static inline void af_predict(float X[AF_NUMX], f
 	    X[12] = -0.5f;
 }
 
+/**
+ * Check whether the estimates of the torque scales and of the motor time
+ * constant stayed put since the last call. The covariance is no help
+ * there, its process noise keeps it from falling much after a few seconds.
+ * @param[in,out] reference The estimates at the last call, updated
+ * @return true if none moved more than AF_SETTLE_CHANGE
+ */
+static bool af_settled(const float X[AF_NUMX], float reference[4])
+{
+	bool settled = true;
+
+	for (uint32_t i = 0; i < 4; i++) {
+		if (fabsf(X[6 + i] - reference[i]) > AF_SETTLE_CHANGE)
+			settled = false;
+		reference[i] = X[6 + i];
+	}
+
+	return settled;
+}
+
 /**
  * Initialize the state variable and covariance matrix
  * for the system identification EKF
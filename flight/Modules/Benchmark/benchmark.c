@@ -0,0 +1,336 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup BenchmarkModule Benchmark Module
+ * @{
+ *
+ * @file       benchmark.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Times a fixed set of flight code kernels with the cycle counter
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * Input object: BenchmarkResults (Command)
+ * Output object: BenchmarkResults
+ *
+ * When the GCS sets BenchmarkResults.Command to Run while the board is
+ * disarmed, each kernel is run a fixed number of times and the fewest
+ * cycles any single call took is published. Calls that were preempted only
+ * take longer, so the minimum is what the code costs on this board with its
+ * flash wait states, FPU and memory.
+ *
+ * The INS kernels share their state with the Attitude module, so they are
+ * only run while neither the attitude nor the navigation filter uses the INS.
+ */
+
+#include "openpilot.h"
+#include "modulesettings.h"
+#include "pios_thread.h"
+#include "pios_queue.h"
+
+#include "benchmarkresults.h"
+#include "flightstatus.h"
+#include "stateestimation.h"
+
+#include "coordinate_conversions.h"
+#include "insgps.h"
+#include "pid.h"
+
+// Private constants
+#define MAX_QUEUE_SIZE 2
+#define STACK_SIZE_BYTES 2000
+#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
+
+//! Calls of each kernel, the fewest cycles of any of them is reported
+#define BENCHMARK_ITERATIONS 100
+
+//! Times one call and keeps the fewest cycles seen in cycles
+#define TIME_KERNEL(cycles, call) do { \
+		uint32_t start = PIOS_DELAY_GetRaw(); \
+		call; \
+		uint32_t elapsed = PIOS_DELAY_GetRaw() - start; \
+		if (elapsed < (cycles)) \
+			(cycles) = elapsed; \
+	} while (0)
+
+// Private variables
+static bool module_enabled;
+static struct pios_thread *benchmarkTaskHandle;
+static struct pios_queue *queue;
+
+//! Results go here so the compiler can't drop the calls
+static volatile float sink;
+
+// Private functions
+static void benchmarkTask(void *parameters);
+static void runBenchmarks(BenchmarkResultsData *results);
+static bool insInUse();
+static void benchmarkINS(uint32_t *cycles);
+static void benchmarkMath(uint32_t *cycles);
+static void benchmarkUAVObjects(uint32_t *cycles);
+static void benchmarkQueue(uint32_t *cycles);
+
+/**
+ * Initialise the module, called on startup
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t BenchmarkInitialize()
+{
+#ifdef MODULE_BENCHMARK_BUILTIN
+	module_enabled = true;
+#else
+	uint8_t module_state[MODULESETTINGS_ADMINSTATE_NUMELEM];
+	ModuleSettingsAdminStateGet(module_state);
+	if (module_state[MODULESETTINGS_ADMINSTATE_BENCHMARK] == MODULESETTINGS_ADMINSTATE_ENABLED) {
+		module_enabled = true;
+	} else {
+		module_enabled = false;
+	}
+#endif
+
+	if (!module_enabled)
+		return -1;
+
+	BenchmarkResultsInitialize();
+
+	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+	if (queue == NULL)
+		return -1;
+
+	return 0;
+}
+
+/**
+ * Start the module, called on startup
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t BenchmarkStart()
+{
+	if (!module_enabled)
+		return -1;
+
+	benchmarkTaskHandle = PIOS_Thread_Create(benchmarkTask, "Benchmark", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	TaskMonitorAdd(TASKINFO_RUNNING_BENCHMARK, benchmarkTaskHandle);
+
+	return 0;
+}
+
+MODULE_INITCALL(BenchmarkInitialize, BenchmarkStart);
+
+/**
+ * Module thread, waits for the GCS to ask for a run
+ */
+static void benchmarkTask(void *parameters)
+{
+	UAVObjEvent ev;
+
+	// Only updates from the GCS, setting the object here must not start another run
+	UAVObjConnectQueue(BenchmarkResultsHandle(), queue, EV_UNPACKED);
+
+	while (1) {
+		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) != true)
+			continue;
+
+		BenchmarkResultsData results;
+		BenchmarkResultsGet(&results);
+		if (results.Command != BENCHMARKRESULTS_COMMAND_RUN)
+			continue;
+
+		results.Command = BENCHMARKRESULTS_COMMAND_IDLE;
+
+		uint8_t armed;
+		FlightStatusArmedGet(&armed);
+		if (armed != FLIGHTSTATUS_ARMED_DISARMED) {
+			results.State = BENCHMARKRESULTS_STATE_ARMED;
+			BenchmarkResultsSet(&results);
+			BenchmarkResultsUpdated();
+			continue;
+		}
+
+		results.State = BENCHMARKRESULTS_STATE_RUNNING;
+		BenchmarkResultsSet(&results);
+		BenchmarkResultsUpdated();
+
+		runBenchmarks(&results);
+
+		results.State = BENCHMARKRESULTS_STATE_COMPLETED;
+		BenchmarkResultsSet(&results);
+		BenchmarkResultsUpdated();
+	}
+}
+
+/**
+ * Runs all the kernels and fills in the results
+ */
+static void runBenchmarks(BenchmarkResultsData *results)
+{
+	uint32_t cycles[BENCHMARKRESULTS_CYCLES_NUMELEM];
+
+	for (uint32_t i = 0; i < BENCHMARKRESULTS_CYCLES_NUMELEM; i++)
+		cycles[i] = UINT32_MAX;
+
+	// What reading the counter twice costs is not part of any kernel
+	uint32_t overhead = UINT32_MAX;
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++)
+		TIME_KERNEL(overhead, );
+
+	benchmarkINS(cycles);
+	benchmarkMath(cycles);
+	benchmarkUAVObjects(cycles);
+	benchmarkQueue(cycles);
+
+	for (uint32_t i = 0; i < BENCHMARKRESULTS_CYCLES_NUMELEM; i++) {
+		if (cycles[i] == UINT32_MAX)
+			results->Cycles[i] = 0;
+		else
+			results->Cycles[i] = cycles[i] > overhead ? cycles[i] - overhead : 0;
+	}
+
+	results->SysClock = PIOS_SYSCLK;
+	results->Iterations = BENCHMARK_ITERATIONS;
+}
+
+/**
+ * The Attitude module runs the INS whenever either filter is set to it
+ */
+static bool insInUse()
+{
+	StateEstimationData stateEstimation;
+	StateEstimationGet(&stateEstimation);
+
+	return stateEstimation.AttitudeFilter != STATEESTIMATION_ATTITUDEFILTER_COMPLEMENTARY ||
+	       stateEstimation.NavigationFilter == STATEESTIMATION_NAVIGATIONFILTER_INS;
+}
+
+/**
+ * A vehicle sitting level, predicted and corrected with all the sensors
+ */
+static void benchmarkINS(uint32_t *cycles)
+{
+	const float dT = 0.002f;
+	const float gyro[3] = { 0.001f, -0.002f, 0.0005f };
+	const float accel[3] = { 0.05f, -0.03f, -9.81f };
+	const float mag[3] = { 400.0f, 20.0f, 350.0f };
+	const float pos[3] = { 1.0f, -2.0f, -10.0f };
+	const float vel[3] = { 0.1f, 0.2f, -0.05f };
+	const float baro = 10.0f;
+
+	if (insInUse())
+		return;
+
+	INSGPSInit();
+	INSSetMagNorth(mag);
+
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		// Stop as soon as the Attitude module is switched over to the INS,
+		// it initializes the INS again when it starts using it
+		if (insInUse())
+			return;
+
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_INSPREDICTION],
+			INSStatePrediction(gyro, accel, dT);
+			INSCovariancePrediction(dT));
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_INSCORRECTION],
+			INSCorrection(mag, pos, vel, baro, FULL_SENSORS));
+	}
+}
+
+static void benchmarkMath(uint32_t *cycles)
+{
+	const float dT = 0.002f;
+
+	struct pid pid;
+	pid_zero(&pid);
+	pid_configure(&pid, 0.003f, 0.002f, 0.00003f, 0.3f);
+
+	float rpy[3] = { 10.0f, -5.0f, 90.0f };
+	float q[4];
+	float Rbe[3][3];
+
+	// A long UAVTalk packet
+	uint8_t packet[256];
+	for (uint32_t i = 0; i < sizeof(packet); i++)
+		packet[i] = (uint8_t)(i * 7 + 3);
+
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		float measured = 0.1f * (float)((int32_t)(i & 0xFF) - 128) / 128.0f;
+
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_PID],
+			sink = pid_apply_setpoint(&pid, 0.0f, measured, dT));
+
+		rpy[0] = measured;
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_RPY2QUATERNION],
+			RPY2Quaternion(rpy, q));
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_QUATERNION2R],
+			Quaternion2R(q, Rbe));
+		sink = Rbe[2][2];
+
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_CRC256],
+			sink = PIOS_CRC_updateCRC(0, packet, sizeof(packet)));
+	}
+}
+
+/**
+ * Reads and writes back this module's own object, nobody else listens to
+ * its local updates
+ */
+static void benchmarkUAVObjects(uint32_t *cycles)
+{
+	BenchmarkResultsData data;
+
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_UAVOBJGETDATA],
+			UAVObjGetData(BenchmarkResultsHandle(), &data));
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_UAVOBJSETDATA],
+			UAVObjSetData(BenchmarkResultsHandle(), &data));
+	}
+}
+
+/**
+ * One event sent and received without blocking, like a module handing
+ * an update to another one
+ */
+static void benchmarkQueue(uint32_t *cycles)
+{
+	struct pios_queue *test_queue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
+	if (test_queue == NULL)
+		return;
+
+	UAVObjEvent ev = {
+		.obj = BenchmarkResultsHandle(),
+		.instId = 0,
+		.event = EV_UPDATED,
+	};
+
+	for (uint32_t i = 0; i < BENCHMARK_ITERATIONS; i++) {
+		TIME_KERNEL(cycles[BENCHMARKRESULTS_CYCLES_QUEUESENDRECEIVE],
+			PIOS_Queue_Send(test_queue, &ev, 0);
+			PIOS_Queue_Receive(test_queue, &ev, 0));
+	}
+
+	PIOS_Queue_Delete(test_queue);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,456 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup CANBridgeModule CAN Bridge Module
+ * @{
+ *
+ * @file       canbridge.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Carries sensor samples and ESC telemetry over the CAN bus
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * Input object: ModuleSettings (CANBridgeMode)
+ * Input objects in Publish mode: Magnetometer, BaroAltitude, AirspeedActual,
+ *   GPSPosition, GPSVelocity
+ * Output objects in Receive mode: GPSPosition, GPSVelocity, AirspeedActual,
+ *   EscTelemetry
+ *
+ * A board in Publish mode is a sensor node: whatever it measures goes out
+ * on the bus as soon as its object updates, a GPS fix as a burst of five
+ * messages. A flight controller in Receive mode takes those in, along with
+ * the telemetry of the ESCs on the bus. The magnetometer and barometer
+ * samples are handed to the sensors module through PIOS_SENSORS as if the
+ * sensors were on the board, unless the board has its own. The node does
+ * not calibrate the magnetometer, that is left to the flight controller.
+ *
+ * All received messages go to one queue that the thread empties a batch at
+ * a time, so each object is only updated once per burst, and the driver
+ * only accepts the messages registered here in its hardware filters.
+ */
+
+#include "openpilot.h"
+#include "modulesettings.h"
+#include "pios_thread.h"
+#include "pios_queue.h"
+#include "pios_sensors.h"
+
+#include "airspeedactual.h"
+#include "baroaltitude.h"
+#include "esctelemetry.h"
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "magnetometer.h"
+
+#if defined(PIOS_INCLUDE_CAN)
+#include "pios_can.h"
+
+extern uintptr_t pios_can_id;
+#endif /* PIOS_INCLUDE_CAN */
+
+// Private constants
+#define STACK_SIZE_BYTES 1024
+#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
+#define MAX_QUEUE_SIZE 32
+#define FRAME_BATCH 8
+#define SENSOR_QUEUE_SIZE 2
+
+//! Standard pressure for the barometric altitude in kPa
+#define BARO_P0 101.3250f
+
+// Private variables
+static bool module_enabled;
+static uint8_t mode;
+static struct pios_thread *canBridgeTaskHandle;
+static struct pios_queue *queue;
+static struct pios_queue *mag_queue;
+static struct pios_queue *baro_queue;
+
+// Private functions
+static void canBridgeTask(void *parameters);
+#if defined(PIOS_INCLUDE_CAN)
+static void receiveTask(void);
+static void publishTask(void);
+static int32_t routeMessages(void);
+#endif /* PIOS_INCLUDE_CAN */
+
+/**
+ * Initialise the module, called on startup
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t CANBridgeInitialize()
+{
+#if defined(PIOS_INCLUDE_CAN)
+#ifdef MODULE_CANBRIDGE_BUILTIN
+	module_enabled = true;
+#else
+	uint8_t module_state[MODULESETTINGS_ADMINSTATE_NUMELEM];
+	ModuleSettingsAdminStateGet(module_state);
+	if (module_state[MODULESETTINGS_ADMINSTATE_CANBRIDGE] == MODULESETTINGS_ADMINSTATE_ENABLED) {
+		module_enabled = true;
+	} else {
+		module_enabled = false;
+	}
+#endif
+
+	if (!pios_can_id)
+		module_enabled = false;
+#else
+	module_enabled = false;
+#endif /* PIOS_INCLUDE_CAN */
+
+	if (!module_enabled)
+		return -1;
+
+	EscTelemetryInitialize();
+
+	ModuleSettingsCANBridgeModeGet(&mode);
+
+#if defined(PIOS_INCLUDE_CAN)
+	if (mode == MODULESETTINGS_CANBRIDGEMODE_PUBLISH) {
+		queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+		if (queue == NULL)
+			return -1;
+
+		MagnetometerConnectQueue(queue);
+		BaroAltitudeConnectQueue(queue);
+		AirspeedActualConnectQueue(queue);
+		GPSPositionConnectQueue(queue);
+		GPSVelocityConnectQueue(queue);
+
+		return 0;
+	}
+
+	// Registered now so the sensors module finds them when it starts
+	return routeMessages();
+#else
+	return -1;
+#endif /* PIOS_INCLUDE_CAN */
+}
+
+/**
+ * Start the module, called on startup
+ * \returns 0 on success or -1 if initialisation failed
+ */
+int32_t CANBridgeStart()
+{
+	if (!module_enabled)
+		return -1;
+
+	canBridgeTaskHandle = PIOS_Thread_Create(canBridgeTask, "CANBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	TaskMonitorAdd(TASKINFO_RUNNING_CANBRIDGE, canBridgeTaskHandle);
+
+	return 0;
+}
+
+MODULE_INITCALL(CANBridgeInitialize, CANBridgeStart);
+
+/**
+ * Module thread, never returns
+ */
+static void canBridgeTask(void *parameters)
+{
+#if defined(PIOS_INCLUDE_CAN)
+	if (mode == MODULESETTINGS_CANBRIDGEMODE_PUBLISH)
+		publishTask();
+	else
+		receiveTask();
+#endif /* PIOS_INCLUDE_CAN */
+
+	while (1)
+		PIOS_Thread_Sleep(1000);
+}
+
+#if defined(PIOS_INCLUDE_CAN)
+
+/**
+ * Have the driver deliver the messages this side consumes to the queue.
+ * The magnetometer and barometer are only taken when the board has none.
+ * \returns 0 on success or -1 on failure
+ */
+static int32_t routeMessages(void)
+{
+	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(struct pios_can_frame));
+	if (queue == NULL)
+		return -1;
+
+	if (!PIOS_SENSORS_IsRegistered(PIOS_SENSOR_MAG)) {
+		mag_queue = PIOS_Queue_Create(SENSOR_QUEUE_SIZE, sizeof(struct pios_sensor_mag_data));
+		if (mag_queue == NULL)
+			return -1;
+
+		PIOS_SENSORS_Register(PIOS_SENSOR_MAG, mag_queue);
+		PIOS_CAN_RouteMessage(pios_can_id, PIOS_CAN_SENSOR_MAG, queue);
+	}
+
+	if (!PIOS_SENSORS_IsRegistered(PIOS_SENSOR_BARO)) {
+		baro_queue = PIOS_Queue_Create(SENSOR_QUEUE_SIZE, sizeof(struct pios_sensor_baro_data));
+		if (baro_queue == NULL)
+			return -1;
+
+		PIOS_SENSORS_Register(PIOS_SENSOR_BARO, baro_queue);
+		PIOS_CAN_RouteMessage(pios_can_id, PIOS_CAN_SENSOR_BARO, queue);
+	}
+
+	static const enum pios_can_messages messages[] = {
+		PIOS_CAN_SENSOR_AIRSPEED,
+		PIOS_CAN_GPS_LATLON,
+		PIOS_CAN_GPS_ALTSPEED,
+		PIOS_CAN_GPS_FIX,
+		PIOS_CAN_GPS_VEL,
+		PIOS_CAN_GPS_DOWN_HEADING,
+		PIOS_CAN_ESC_TELEMETRY,
+	};
+
+	for (uint32_t i = 0; i < NELEMENTS(messages); i++) {
+		if (PIOS_CAN_RouteMessage(pios_can_id, messages[i], queue) != 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Takes the messages in a batch at a time and updates each object the
+ * batch touched once
+ */
+static void receiveTask(void)
+{
+	struct pios_can_frame frames[FRAME_BATCH];
+
+	GPSPositionData gpsPosition;
+	GPSVelocityData gpsVelocity;
+	EscTelemetryData escTelemetry;
+
+	GPSPositionGet(&gpsPosition);
+	GPSVelocityGet(&gpsVelocity);
+	EscTelemetryGet(&escTelemetry);
+
+	while (1) {
+		uint16_t num_frames = PIOS_Queue_ReceiveMany(queue, frames, FRAME_BATCH, PIOS_QUEUE_TIMEOUT_MAX);
+
+		bool position_updated = false;
+		bool velocity_updated = false;
+		bool esc_updated = false;
+
+		for (uint16_t i = 0; i < num_frames; i++) {
+			const uint8_t *data = frames[i].data;
+
+			switch (frames[i].msg_id) {
+			case PIOS_CAN_SENSOR_MAG:
+			{
+				struct pios_can_sensor_mag msg;
+				memcpy(&msg, data, sizeof(msg));
+
+				struct pios_sensor_mag_data mag = {
+					.x = msg.x,
+					.y = msg.y,
+					.z = msg.z,
+				};
+				PIOS_Queue_Send(mag_queue, &mag, 0);
+				break;
+			}
+			case PIOS_CAN_SENSOR_BARO:
+			{
+				struct pios_can_sensor_baro msg;
+				memcpy(&msg, data, sizeof(msg));
+
+				struct pios_sensor_baro_data baro = {
+					.temperature = msg.temperature * 0.01f,
+					.pressure = msg.pressure,
+					.altitude = 44330.0f * (1.0f - powf(msg.pressure / BARO_P0, (1.0f / 5.255f))),
+				};
+				PIOS_Queue_Send(baro_queue, &baro, 0);
+				break;
+			}
+			case PIOS_CAN_SENSOR_AIRSPEED:
+			{
+				struct pios_can_sensor_airspeed msg;
+				memcpy(&msg, data, sizeof(msg));
+
+				AirspeedActualData airspeed;
+				AirspeedActualGet(&airspeed);
+				airspeed.TrueAirspeed = msg.true_airspeed;
+				airspeed.CalibratedAirspeed = msg.calibrated_airspeed;
+				AirspeedActualSet(&airspeed);
+				break;
+			}
+			case PIOS_CAN_GPS_LATLON:
+			{
+				struct pios_can_gps_latlon msg;
+				memcpy(&msg, data, sizeof(msg));
+				gpsPosition.Latitude = (int32_t) msg.lat;
+				gpsPosition.Longitude = (int32_t) msg.lon;
+				position_updated = true;
+				break;
+			}
+			case PIOS_CAN_GPS_ALTSPEED:
+			{
+				struct pios_can_gps_alt_speed msg;
+				memcpy(&msg, data, sizeof(msg));
+				gpsPosition.Altitude = msg.alt;
+				gpsPosition.Groundspeed = msg.speed;
+				break;
+			}
+			case PIOS_CAN_GPS_FIX:
+			{
+				struct pios_can_gps_fix msg;
+				memcpy(&msg, data, sizeof(msg));
+				gpsPosition.PDOP = msg.pdop;
+				gpsPosition.Satellites = msg.sats;
+				gpsPosition.Status = msg.status;
+				break;
+			}
+			case PIOS_CAN_GPS_VEL:
+			{
+				struct pios_can_gps_vel msg;
+				memcpy(&msg, data, sizeof(msg));
+				gpsVelocity.North = msg.north;
+				gpsVelocity.East = msg.east;
+				velocity_updated = true;
+				break;
+			}
+			case PIOS_CAN_GPS_DOWN_HEADING:
+			{
+				struct pios_can_gps_down_heading msg;
+				memcpy(&msg, data, sizeof(msg));
+				gpsVelocity.Down = msg.down;
+				gpsPosition.Heading = msg.heading;
+				break;
+			}
+			case PIOS_CAN_ESC_TELEMETRY:
+			{
+				struct pios_can_esc_telemetry msg;
+				memcpy(&msg, data, sizeof(msg));
+				if (msg.index >= ESCTELEMETRY_RPM_NUMELEM)
+					break;
+
+				escTelemetry.RPM[msg.index] = msg.rpm * 10.0f;
+				escTelemetry.Voltage[msg.index] = msg.voltage * 0.01f;
+				escTelemetry.Current[msg.index] = msg.current * 0.01f;
+				escTelemetry.Temperature[msg.index] = msg.temperature;
+				esc_updated = true;
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		// The position message comes last in a burst, see publishTask()
+		if (position_updated)
+			GPSPositionSet(&gpsPosition);
+		if (velocity_updated)
+			GPSVelocitySet(&gpsVelocity);
+		if (esc_updated)
+			EscTelemetrySet(&escTelemetry);
+	}
+}
+
+/**
+ * Sends the objects of this board as they update
+ */
+static void publishTask(void)
+{
+	UAVObjEvent ev;
+
+	while (1) {
+		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) != true)
+			continue;
+
+		if (ev.obj == MagnetometerHandle()) {
+			MagnetometerData magnetometer;
+			MagnetometerGet(&magnetometer);
+
+			struct pios_can_sensor_mag msg = {
+				.x = magnetometer.x,
+				.y = magnetometer.y,
+				.z = magnetometer.z,
+			};
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_SENSOR_MAG, (uint8_t *) &msg);
+		} else if (ev.obj == BaroAltitudeHandle()) {
+			BaroAltitudeData baro;
+			BaroAltitudeGet(&baro);
+
+			struct pios_can_sensor_baro msg = {
+				.pressure = baro.Pressure,
+				.temperature = baro.Temperature * 100.0f,
+			};
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_SENSOR_BARO, (uint8_t *) &msg);
+		} else if (ev.obj == AirspeedActualHandle()) {
+			AirspeedActualData airspeed;
+			AirspeedActualGet(&airspeed);
+
+			struct pios_can_sensor_airspeed msg = {
+				.true_airspeed = airspeed.TrueAirspeed,
+				.calibrated_airspeed = airspeed.CalibratedAirspeed,
+			};
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_SENSOR_AIRSPEED, (uint8_t *) &msg);
+		} else if (ev.obj == GPSVelocityHandle()) {
+			GPSVelocityData gpsVelocity;
+			GPSVelocityGet(&gpsVelocity);
+
+			struct pios_can_gps_vel msg = {
+				.north = gpsVelocity.North,
+				.east = gpsVelocity.East,
+			};
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_GPS_VEL, (uint8_t *) &msg);
+		} else if (ev.obj == GPSPositionHandle()) {
+			GPSPositionData gpsPosition;
+			GPSPositionGet(&gpsPosition);
+
+			float down;
+			GPSVelocityDownGet(&down);
+
+			struct pios_can_gps_down_heading down_heading = {
+				.down = down,
+				.heading = gpsPosition.Heading,
+			};
+			struct pios_can_gps_fix fix = {
+				.pdop = gpsPosition.PDOP,
+				.sats = gpsPosition.Satellites,
+				.status = gpsPosition.Status,
+			};
+			struct pios_can_gps_alt_speed alt_speed = {
+				.alt = gpsPosition.Altitude,
+				.speed = gpsPosition.Groundspeed,
+			};
+			struct pios_can_gps_latlon latlon = {
+				.lat = gpsPosition.Latitude,
+				.lon = gpsPosition.Longitude,
+			};
+
+			// The receiver updates the position with the last of them
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_GPS_DOWN_HEADING, (uint8_t *) &down_heading);
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_GPS_FIX, (uint8_t *) &fix);
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_GPS_ALTSPEED, (uint8_t *) &alt_speed);
+			PIOS_CAN_TxData(pios_can_id, PIOS_CAN_GPS_LATLON, (uint8_t *) &latlon);
+		}
+	}
+}
+
+#endif /* PIOS_INCLUDE_CAN */
+
+/**
+ * @}
+ * @}
+ */
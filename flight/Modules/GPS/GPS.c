@@ -62,6 +62,9 @@ static void updateSettings();
 #define GPS_TIMEOUT_MS                  750
 #define GPS_COM_TIMEOUT_MS              100
 
+//! Bytes taken from the port and handed to the parser at once
+#define GPS_READ_BUFFER_SIZE            32
+
 
 #if defined(PIOS_GPS_MINIMAL)
 	#define STACK_SIZE_BYTES            500
@@ -80,6 +83,7 @@ static bool module_enabled = false;
 static struct pios_thread *gpsTaskHandle;
 
 static char* gps_rx_buffer;
+static uint8_t gps_read_buffer[GPS_READ_BUFFER_SIZE];
 
 static struct GPS_RX_STATS gpsRxStats;
 
@@ -196,18 +200,20 @@ static void gpsConfigure(uint8_t gpsProtocol)
 			ModuleSettingsGPSConstellationOptions constellation;
 			ModuleSettingsGPSSBASConstellationOptions sbas_const;
 			ModuleSettingsGPSDynamicsModeOptions dyn_mode;
+			ModuleSettingsGPSNavPVTOptions nav_pvt;
 
 			ModuleSettingsGPSSpeedGet(&baud_rate);
 			ModuleSettingsGPSConstellationGet(&constellation);
 			ModuleSettingsGPSSBASConstellationGet(&sbas_const);
 			ModuleSettingsGPSDynamicsModeGet(&dyn_mode);
+			ModuleSettingsGPSNavPVTGet(&nav_pvt);
 
 			ubx_cfg_set_baudrate(gpsPort, baud_rate);
 
 			PIOS_Thread_Sleep(1000);
 
 			ubx_cfg_send_configuration(gpsPort, gps_rx_buffer,
-					constellation, sbas_const, dyn_mode);
+					constellation, sbas_const, dyn_mode, nav_pvt);
 		}
 		break;
 #endif
@@ -253,21 +259,21 @@ static void gpsTask(void *parameters)
 			continue;
 		}
 
-		uint8_t c;
+		uint16_t received;
 
 		// This blocks the task until there is something on the buffer
-		while (PIOS_COM_ReceiveBuffer(gpsPort, &c, 1, xDelay) > 0)
+		while ((received = PIOS_COM_ReceiveBuffer(gpsPort, gps_read_buffer, sizeof(gps_read_buffer), xDelay)) > 0)
 		{
 			int res;
 			switch (gpsProtocol) {
 #if defined(PIOS_INCLUDE_GPS_NMEA_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_NMEA:
-					res = parse_nmea_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_nmea_stream (gps_read_buffer, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 #if defined(PIOS_INCLUDE_GPS_UBX_PARSER)
 				case MODULESETTINGS_GPSDATAPROTOCOL_UBX:
-					res = parse_ubx_stream (c,gps_rx_buffer, &gpsposition, &gpsRxStats);
+					res = parse_ubx_stream (gps_read_buffer, received, gps_rx_buffer, &gpsposition, &gpsRxStats);
 					break;
 #endif
 				default:
@@ -107,7 +107,7 @@ const static struct nmea_parser nmea_parsers[] = {
 #endif //PIOS_GPS_MINIMAL
 };
 
-int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+static int parse_nmea_char (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
 	static uint8_t rx_count = 0;
 	static bool start_flag = false;
@@ -189,6 +189,23 @@ int parse_nmea_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 	return PARSER_INCOMPLETE;
 }
 
+// parse a chunk of the incoming stream for NMEA sentences
+
+int parse_nmea_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+{
+	int ret = PARSER_INCOMPLETE;
+	bool complete = false;
+
+	for (uint16_t i = 0; i < len; i++) {
+		ret = parse_nmea_char(rx[i], gps_rx_buffer, GpsData, gpsRxStats);
+		if (ret == PARSER_COMPLETE)
+			complete = true;
+	}
+
+	// at least one sentence complete & processed
+	return complete ? PARSER_COMPLETE : ret;
+}
+
 const static struct nmea_parser *NMEA_find_parser_by_prefix(const char *prefix)
 {
 	if (!prefix) {
@@ -41,9 +41,9 @@ static uint32_t parse_errors;
 static bool checksum_ubx_message(const struct UBXPacket *);
 static uint32_t parse_ubx_message(const struct UBXPacket *, GPSPositionData *);
 
-// parse incoming character stream for messages in UBX binary format
+// parse a chunk of the incoming stream for messages in UBX binary format
 
-int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
+int parse_ubx_stream (const uint8_t *rx, uint16_t len, char *gps_rx_buffer, GPSPositionData *GpsData, struct GPS_RX_STATS *gpsRxStats)
 {
 	enum proto_states {
 		START,
@@ -61,75 +61,93 @@ int parse_ubx_stream (uint8_t c, char *gps_rx_buffer, GPSPositionData *GpsData,
 	static enum proto_states proto_state = START;
 	static uint16_t rx_count = 0;
 	struct UBXPacket *ubx = (struct UBXPacket *)gps_rx_buffer;
-
-	switch (proto_state) {
-		case START: // detect protocol
-			if (c ==  UBX_SYNC1) // first UBX sync char found
-				proto_state = UBX_SY2;
-			break;
-		case UBX_SY2:
-			if (c == UBX_SYNC2) // second UBX sync char found
-				proto_state = UBX_CLASS;
-			else
-				proto_state = START; // reset state
-			break;
-		case UBX_CLASS:
-			ubx->header.class = c;
-			proto_state = UBX_ID;
-			break;
-		case UBX_ID:
-			ubx->header.id = c;
-			proto_state = UBX_LEN1;
-			break;
-		case UBX_LEN1:
-			ubx->header.len = c;
-			proto_state = UBX_LEN2;
-			break;
-		case UBX_LEN2:
-			ubx->header.len += (c << 8);
-			if (ubx->header.len > sizeof(UBXPayload)) {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
-			} else {
-				rx_count = 0;
-				proto_state = UBX_PAYLOAD;
+	bool complete = false;
+	uint16_t i = 0;
+
+	while (i < len) {
+		switch (proto_state) {
+			case START: // detect protocol
+			{
+				// Everything up to the first UBX sync char is skipped at once
+				const uint8_t *sync = memchr(&rx[i], UBX_SYNC1, len - i);
+				if (sync == NULL) {
+					i = len;
+				} else {
+					i = sync - rx + 1;
+					proto_state = UBX_SY2;
+				}
+				break;
 			}
-			break;
-		case UBX_PAYLOAD:
-			if (rx_count < ubx->header.len) {
-				ubx->payload.payload[rx_count] = c;
-				if (++rx_count == ubx->header.len)
+			case UBX_SY2:
+				if (rx[i++] == UBX_SYNC2) // second UBX sync char found
+					proto_state = UBX_CLASS;
+				else
+					proto_state = START; // reset state
+				break;
+			case UBX_CLASS:
+				ubx->header.class = rx[i++];
+				proto_state = UBX_ID;
+				break;
+			case UBX_ID:
+				ubx->header.id = rx[i++];
+				proto_state = UBX_LEN1;
+				break;
+			case UBX_LEN1:
+				ubx->header.len = rx[i++];
+				proto_state = UBX_LEN2;
+				break;
+			case UBX_LEN2:
+				ubx->header.len += (rx[i++] << 8);
+				if (ubx->header.len > sizeof(UBXPayload)) {
+					gpsRxStats->gpsRxOverflow++;
+					proto_state = START;
+				} else {
+					rx_count = 0;
+					proto_state = ubx->header.len ? UBX_PAYLOAD : UBX_CHK1;
+				}
+				break;
+			case UBX_PAYLOAD:
+			{
+				// Copy as much of the payload as this chunk holds
+				uint16_t n = ubx->header.len - rx_count;
+				if (n > len - i)
+					n = len - i;
+				memcpy(&ubx->payload.payload[rx_count], &rx[i], n);
+				rx_count += n;
+				i += n;
+				if (rx_count == ubx->header.len)
 					proto_state = UBX_CHK1;
-			} else {
-				gpsRxStats->gpsRxOverflow++;
-				proto_state = START;
-			}
-			break;
-		case UBX_CHK1:
-			ubx->header.ck_a = c;
-			proto_state = UBX_CHK2;
-			break;
-		case UBX_CHK2:
-			ubx->header.ck_b = c;
-			if (checksum_ubx_message(ubx)) { // message complete and valid
-				parse_ubx_message(ubx, GpsData);
-				proto_state = FINISHED;
-			} else {
-				gpsRxStats->gpsRxChkSumError++;
-				proto_state = START;
+				break;
 			}
-			break;
-		default: break;
-	}
+			case UBX_CHK1:
+				ubx->header.ck_a = rx[i++];
+				proto_state = UBX_CHK2;
+				break;
+			case UBX_CHK2:
+				ubx->header.ck_b = rx[i++];
+				if (checksum_ubx_message(ubx)) { // message complete and valid
+					parse_ubx_message(ubx, GpsData);
+					proto_state = FINISHED;
+				} else {
+					gpsRxStats->gpsRxChkSumError++;
+					proto_state = START;
+				}
+				break;
+			default: break;
+		}
 
-	if (proto_state == START)
-		return PARSER_ERROR;	// parser couldn't use this byte
-	else if (proto_state == FINISHED) {
-		gpsRxStats->gpsRxReceived++;
-		proto_state = START;
-		return PARSER_COMPLETE;	// message complete & processed
+		if (proto_state == FINISHED) {
+			gpsRxStats->gpsRxReceived++;
+			proto_state = START;
+			complete = true;
+		}
 	}
 
+	if (complete)
+		return PARSER_COMPLETE;	// at least one message complete & processed
+	else if (proto_state == START)
+		return PARSER_ERROR;	// parser couldn't use these bytes
+
 	return PARSER_INCOMPLETE; // message not (yet) complete
 }
 
@@ -260,6 +278,66 @@ static void parse_ubx_nav_velned (const struct UBX_NAV_VELNED *velned, GPSPositi
 	}
 }
 
+/**
+ * NAV-PVT holds everything of POSLLH, SOL, VELNED and TIMEUTC, so it is
+ * published on its own without waiting for the rest of the set
+ */
+static void parse_ubx_nav_pvt (const struct UBX_NAV_PVT *pvt, GPSPositionData *GpsPosition)
+{
+	GpsPosition->Satellites = pvt->numSV;
+	GpsPosition->Accuracy = sqrtf((float)pvt->hAcc * pvt->hAcc + (float)pvt->vAcc * pvt->vAcc) * 0.001f;
+	GpsPosition->PDOP = (float)pvt->pDOP * 0.01f;
+
+	if (pvt->flags & PVT_FLAGS_GNSSFIX_OK) {
+		switch (pvt->fixType) {
+			case STATUS_GPSFIX_2DFIX:
+				GpsPosition->Status = GPSPOSITION_STATUS_FIX2D;
+				break;
+			case STATUS_GPSFIX_3DFIX:
+				GpsPosition->Status = (pvt->flags & PVT_FLAGS_DIFFSOLN) ?
+					GPSPOSITION_STATUS_DIFF3D : GPSPOSITION_STATUS_FIX3D;
+				break;
+			default: GpsPosition->Status = GPSPOSITION_STATUS_NOFIX;
+		}
+	}
+	else // fix is not valid so we make sure to treat is as NOFIX
+		GpsPosition->Status = GPSPOSITION_STATUS_NOFIX;
+
+	if (GpsPosition->Status != GPSPOSITION_STATUS_NOFIX) {
+		GPSVelocityData GpsVelocity;
+
+		GpsPosition->Altitude = (float)pvt->hMSL*0.001f;
+		GpsPosition->GeoidSeparation = (float)(pvt->height - pvt->hMSL)*0.001f;
+		GpsPosition->Latitude = pvt->lat;
+		GpsPosition->Longitude = pvt->lon;
+		GpsPosition->Groundspeed = (float)pvt->gSpeed * 0.001f;
+		GpsPosition->Heading = (float)pvt->headMot * 1.0e-5f;
+
+		GpsVelocity.North	= (float)pvt->velN * 0.001f;
+		GpsVelocity.East	= (float)pvt->velE * 0.001f;
+		GpsVelocity.Down	= (float)pvt->velD * 0.001f;
+		GpsVelocity.Accuracy	= (float)pvt->sAcc * 0.001f;
+		GPSVelocitySet(&GpsVelocity);
+	}
+
+	GPSPositionSet(GpsPosition);
+
+#if !defined(PIOS_GPS_MINIMAL)
+	if ((pvt->valid & (PVT_VALID_DATE | PVT_VALID_TIME)) == (PVT_VALID_DATE | PVT_VALID_TIME)) {
+		GPSTimeData GpsTime;
+
+		GpsTime.Year = pvt->year;
+		GpsTime.Month = pvt->month;
+		GpsTime.Day = pvt->day;
+		GpsTime.Hour = pvt->hour;
+		GpsTime.Minute = pvt->min;
+		GpsTime.Second = pvt->sec;
+
+		GPSTimeSet(&GpsTime);
+	}
+#endif
+}
+
 #if !defined(PIOS_GPS_MINIMAL)
 static void parse_ubx_nav_timeutc (const struct UBX_NAV_TIMEUTC *timeutc)
 {
@@ -377,6 +455,12 @@ static uint32_t parse_ubx_message (const struct UBXPacket *ubx, GPSPositionData
 				case UBX_ID_VELNED:
 					parse_ubx_nav_velned (&ubx->payload.nav_velned, GpsPosition);
 					break;
+				case UBX_ID_PVT:
+					if (ubx->header.len >= UBX_NAV_PVT_MIN_LEN) {
+						parse_ubx_nav_pvt (&ubx->payload.nav_pvt, GpsPosition);
+						id = GPSPOSITION_OBJID;
+					}
+					break;
 #if !defined(PIOS_GPS_MINIMAL)
 				case UBX_ID_TIMEUTC:
 					parse_ubx_nav_timeutc (&ubx->payload.nav_timeutc);
@@ -34,7 +34,8 @@
 void ubx_cfg_send_configuration(uintptr_t gps_port, char *buffer,
 		ModuleSettingsGPSConstellationOptions constellation,
 		ModuleSettingsGPSSBASConstellationOptions sbas_const,
-		ModuleSettingsGPSDynamicsModeOptions dyn_mode);
+		ModuleSettingsGPSDynamicsModeOptions dyn_mode,
+		ModuleSettingsGPSNavPVTOptions nav_pvt);
 
 void ubx_cfg_set_baudrate(uintptr_t gps_port, ModuleSettingsGPSSpeedOptions baud_rate);
 
@@ -74,6 +74,7 @@
 #define UBLOX_NAV_STATUS    0x03
 #define UBLOX_NAV_DOP       0x04
 #define UBLOX_NAV_SOL       0x06
+#define UBLOX_NAV_PVT       0x07
 #define UBLOX_NAV_VELNED    0x12
 #define UBLOX_NAV_TIMEUTC   0x21
 #define UBLOX_NAV_SBAS      0x32
@@ -445,13 +446,13 @@ static void ubx_cfg_pause_parse(uintptr_t gps_port, uint32_t delay_ticks)
     struct GPS_RX_STATS gpsRxStats;
     GPSPositionData     gpsPosition;
 
-    uint8_t c;
+    uint8_t rx[16];
     uint32_t enterTime = PIOS_Thread_Systime();
     while ((PIOS_Thread_Systime() - enterTime) < delay_ticks)
     {
-        int32_t received = PIOS_COM_ReceiveBuffer(gps_port, &c, 1, 1);
+        uint16_t received = PIOS_COM_ReceiveBuffer(gps_port, rx, sizeof(rx), 1);
         if (received > 0)
-            parse_ubx_stream (c, gps_rx_buffer, &gpsPosition, &gpsRxStats);
+            parse_ubx_stream (rx, received, gps_rx_buffer, &gpsPosition, &gpsRxStats);
     }
 }
 
@@ -482,7 +483,8 @@ static void ubx_cfg_send_checksummed(uintptr_t gps_port,
 void ubx_cfg_send_configuration(uintptr_t gps_port, char *buffer,
         ModuleSettingsGPSConstellationOptions constellation,
         ModuleSettingsGPSSBASConstellationOptions sbas_const,
-        ModuleSettingsGPSDynamicsModeOptions dyn_mode)
+        ModuleSettingsGPSDynamicsModeOptions dyn_mode,
+        ModuleSettingsGPSNavPVTOptions nav_pvt)
 {
     gps_rx_buffer = buffer;
 
@@ -503,11 +505,24 @@ void ubx_cfg_send_configuration(uintptr_t gps_port, char *buffer,
         UBloxInfoGet(&ublox);
     } while (ublox.swVersion == 0 && i++ < 10);
 
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
-    ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
+    // NAV-PVT replaces the four messages of each solution and TIMEUTC,
+    // u-blox 6 and older don't know it
+    if (nav_pvt == MODULESETTINGS_GPSNAVPVT_TRUE && ublox.hwVersion >= 7) {
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_PVT, 1);       // NAV-PVT
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 0);    // NAV-VELNED
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 0);    // NAV-POSLLH
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 0);       // NAV-SOL
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 0);   // NAV-TIMEUTC
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 0);       // NAV-DOP
+    } else {
+        if (ublox.hwVersion >= 7)
+            ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_PVT, 0);   // NAV-PVT
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_VELNED, 1);    // NAV-VELNED
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_POSLLH, 1);    // NAV-POSLLH
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SOL, 1);       // NAV-SOL
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_TIMEUTC, 5);   // NAV-TIMEUTC
+        ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_DOP, 1);       // NAV-DOP
+    }
     ubx_cfg_enable_message(gps_port, UBLOX_NAV_CLASS, UBLOX_NAV_SVINFO, 5);    // NAV-SVINFO
 
     ubx_cfg_set_mode(gps_port, dyn_mode);
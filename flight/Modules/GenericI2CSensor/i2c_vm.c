@@ -46,6 +46,9 @@ struct i2c_vm_regs {
 	uint8_t i2c_dev_addr;
 
 	I2CVMData uavo;
+
+	/* The general purpose registers in the UAVO, by register number */
+	int32_t *regs[VM_R6 + 1];
 };
 
 /******************************
@@ -64,32 +67,10 @@ struct i2c_vm_regs {
  */
 static bool i2c_vm_set_reg (struct i2c_vm_regs * vm_state, uint8_t reg, uint32_t val)
 {
-	switch (reg) {
-	case VM_R0:
-		vm_state->uavo.r0 = val;
-		break;
-	case VM_R1:
-		vm_state->uavo.r1 = val;
-		break;
-	case VM_R2:
-		vm_state->uavo.r2 = val;
-		break;
-	case VM_R3:
-		vm_state->uavo.r3 = val;
-		break;
-	case VM_R4:
-		vm_state->uavo.r4 = val;
-		break;
-	case VM_R5:
-		vm_state->uavo.r5 = val;
-		break;
-	case VM_R6:
-		vm_state->uavo.r6 = val;
-		break;
-	default:
+	if ((reg < VM_R0) || (reg > VM_R6))
 		return false;
-	}
 
+	*vm_state->regs[reg] = val;
 	return true;
 }
 
@@ -101,32 +82,10 @@ static bool i2c_vm_set_reg (struct i2c_vm_regs * vm_state, uint8_t reg, uint32_t
  */
 static bool i2c_vm_get_reg (const struct i2c_vm_regs * vm_state, uint8_t reg, uint32_t * val)
 {
-	switch (reg) {
-	case VM_R0:
-		*val = vm_state->uavo.r0;
-		break;
-	case VM_R1:
-		*val = vm_state->uavo.r1;
-		break;
-	case VM_R2:
-		*val = vm_state->uavo.r2;
-		break;
-	case VM_R3:
-		*val = vm_state->uavo.r3;
-		break;
-	case VM_R4:
-		*val = vm_state->uavo.r4;
-		break;
-	case VM_R5:
-		*val = vm_state->uavo.r5;
-		break;
-	case VM_R6:
-		*val = vm_state->uavo.r6;
-		break;
-	default:
+	if ((reg < VM_R0) || (reg > VM_R6))
 		return false;
-	}
 
+	*val = *vm_state->regs[reg];
 	return true;
 }
 
@@ -655,6 +614,82 @@ static bool i2c_vm_write (struct i2c_vm_regs * vm_state, uint8_t ram_addr, uint8
 	return (true);
 }
 
+/* Read consecutive device registers into virtual machine RAM. The register
+ * address is written and the data read back with a repeated start, so this
+ * is a single transfer instead of a STORE, WRITE and READ.
+ *
+ * @param[in,out] vm_state virtual machine state
+ * @param[in] reg address of the first device register to read
+ * @param[in] ram_addr base address (in virtual RAM) where data will be stored
+ * @param[in] len number of bytes to read from the i2c bus and store into virtual RAM
+ */
+static bool i2c_vm_read_reg (struct i2c_vm_regs * vm_state, uint8_t reg, uint8_t ram_addr, uint8_t len)
+{
+	/* Make sure our read fits in our buffer */
+	if ((ram_addr + len) > sizeof(vm_state->uavo.ram)) {
+		return false;
+	}
+
+	const struct pios_i2c_txn txn_list[] = {
+		{
+			.info = __func__,
+			.addr = vm_state->i2c_dev_addr,
+			.rw   = PIOS_I2C_TXN_WRITE,
+			.len  = 1,
+			.buf  = &reg,
+		},
+		{
+			.info = __func__,
+			.addr = vm_state->i2c_dev_addr,
+			.rw   = PIOS_I2C_TXN_READ,
+			.len  = len,
+			.buf  = vm_state->uavo.ram + ram_addr,
+		},
+	};
+
+	int32_t rc = PIOS_I2C_Transfer(vm_state->i2c_adapter, txn_list, NELEMENTS(txn_list));
+
+	/* Fault the VM if the I2C transfer fails */
+	if (rc < 0)
+		return false;
+
+	vm_state->uavo.pc++;
+
+	return (true);
+}
+
+/* Write a device register without going through virtual machine RAM
+ *
+ * @param[in,out] vm_state virtual machine state
+ * @param[in] reg address of the device register to write
+ * @param[in] val value to write to the register
+ * @param[in] op3 unused
+ */
+static bool i2c_vm_write_reg (struct i2c_vm_regs * vm_state, uint8_t reg, uint8_t val, uint8_t op3)
+{
+	uint8_t buf[] = { reg, val };
+
+	const struct pios_i2c_txn txn_list[] = {
+		{
+			.info = __func__,
+			.addr = vm_state->i2c_dev_addr,
+			.rw   = PIOS_I2C_TXN_WRITE,
+			.len  = sizeof(buf),
+			.buf  = buf,
+		},
+	};
+
+	int32_t rc = PIOS_I2C_Transfer(vm_state->i2c_adapter, txn_list, NELEMENTS(txn_list));
+
+	/* Fault the VM if the I2C transfer fails */
+	if (rc < 0)
+		return false;
+
+	vm_state->uavo.pc++;
+
+	return (true);
+}
+
 /* Send UAVObject from virtual machine registers
  *
  * @param[in,out] vm_state virtual machine state
@@ -710,13 +745,23 @@ static bool i2c_vm_reboot (struct i2c_vm_regs * vm_state, uintptr_t i2c_adapter)
 	vm_state->uavo.r6 = 0;
 	memset(vm_state->uavo.ram, 0, sizeof(vm_state->uavo.ram));
 
+	/* Map the register numbers once instead of on every access */
+	vm_state->regs[VM_PC] = NULL;
+	vm_state->regs[VM_R0] = &vm_state->uavo.r0;
+	vm_state->regs[VM_R1] = &vm_state->uavo.r1;
+	vm_state->regs[VM_R2] = &vm_state->uavo.r2;
+	vm_state->regs[VM_R3] = &vm_state->uavo.r3;
+	vm_state->regs[VM_R4] = &vm_state->uavo.r4;
+	vm_state->regs[VM_R5] = &vm_state->uavo.r5;
+	vm_state->regs[VM_R6] = &vm_state->uavo.r6;
+
 	return true;
 }
 
 
 typedef bool (*i2c_vm_inst_handler) (struct i2c_vm_regs * vm_state, uint8_t op1, uint8_t op2, uint8_t op3);
 
-const i2c_vm_inst_handler i2c_vm_handlers[] = {
+static const i2c_vm_inst_handler i2c_vm_handlers[] = {
 	/* Program flow operations */
 	[I2C_VM_OP_HALT]         = i2c_vm_halt,         /* Halt */
 	[I2C_VM_OP_NOP]          = i2c_vm_nop,          /* No operation */
@@ -749,6 +794,8 @@ const i2c_vm_inst_handler i2c_vm_handlers[] = {
 	[I2C_VM_OP_SET_DEV_ADDR] = i2c_vm_set_dev_addr, /* Set I2C device address */
 	[I2C_VM_OP_READ]         = i2c_vm_read,         /* Read from I2C bus */
 	[I2C_VM_OP_WRITE]        = i2c_vm_write,        /* Write to I2C bus */
+	[I2C_VM_OP_READ_REG]     = i2c_vm_read_reg,     /* Read device registers */
+	[I2C_VM_OP_WRITE_REG]    = i2c_vm_write_reg,    /* Write a device register */
 
 	/* UAVO operations */
 	[I2C_VM_OP_SEND_UAVO]    = i2c_vm_send_uavo,    /* Send UAV Object */
@@ -771,38 +818,25 @@ bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_adapter)
 	i2c_vm_reboot (&vm, i2c_adapter);
 
 	while (!vm.halted) {
-		if (vm.uavo.pc > code_len) {
-			/* PC is entirely out of range */
-			vm.fault  = true;
+		if (vm.uavo.pc >= code_len) {
+			/* PC just past the end of the code means the program is
+			 * completed, anything further is entirely out of range */
+			vm.fault  = (vm.uavo.pc > code_len);
 			vm.halted = true;
-			continue;
-		}
-		if (vm.uavo.pc == code_len) {
-			/* PC is just past the end of the code, assume program is completed */
-			vm.halted = true;
-			continue;
+			break;
 		}
+
 		/* Fetch */
 		uint32_t instruction = code[vm.uavo.pc];
 
 		/* Decode */
-		uint8_t operator = (instruction & 0xFF000000) >> 24;
-		uint8_t op1      = (instruction & 0x00FF0000) >> 16;
-		uint8_t op2      = (instruction & 0x0000FF00) >>  8;
-		uint8_t op3      = (instruction & 0x000000FF);
-
-		if (operator > NELEMENTS(i2c_vm_handlers)) {
-			vm.fault = true;
-			vm.halted = true;
-			continue;
-		}
-		i2c_vm_inst_handler f = i2c_vm_handlers[operator];
+		uint8_t operator = instruction >> 24;
+		i2c_vm_inst_handler f = (operator < NELEMENTS(i2c_vm_handlers)) ? i2c_vm_handlers[operator] : NULL;
 
 		/* Execute + Writeback */
-		if (!f || !f(&vm, op1, op2, op3)) {
+		if (!f || !f(&vm, instruction >> 16, instruction >> 8, instruction)) {
 			vm.fault  = true;
 			vm.halted = true;
-			continue;
 		}
 	}
 
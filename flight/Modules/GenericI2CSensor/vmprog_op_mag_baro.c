@@ -53,9 +53,7 @@ const uint32_t vmprog_op_mag_baro[] = {
 	/* Read the Magnetometer */
 	I2C_VM_ASM_SET_DEV_ADDR(0x1C),   /* Set I2C device address (in 7-bit) */
 
-	I2C_VM_ASM_STORE(PIOS_HMC5883_DATAOUT_XMSB_REG, 0),
-	I2C_VM_ASM_WRITE_I2C(0, 1),
-	I2C_VM_ASM_READ_I2C(0,7),
+	I2C_VM_ASM_READ_REG_I2C(PIOS_HMC5883_DATAOUT_XMSB_REG, 0, 7),
 
 	I2C_VM_ASM_LOAD_BE(0, 2, VM_R0), /* mag_x */
 	I2C_VM_ASM_LOAD_BE(2, 2, VM_R1), /* mag_y */
@@ -88,33 +86,25 @@ const uint32_t vmprog_op_mag_baro[] = {
 
 	I2C_VM_ASM_SET_DEV_ADDR(0x77),   /* Set I2C device address (in 7-bit) */
 
-	I2C_VM_ASM_STORE(0xF4, 0),        /* Store ctrl register address */
-	I2C_VM_ASM_STORE(0x2E, 1),        /* Store temp conv address */
-	I2C_VM_ASM_WRITE_I2C(0, 2),       /* Write two bytes */
+	I2C_VM_ASM_WRITE_REG_I2C(0xF4, 0x2E), /* Start temperature conversion */
 	I2C_VM_ASM_DELAY(5),	          /* Wait for temperature conversion to complete */
 
-	I2C_VM_ASM_STORE(0xF6, 0),        /* Store ADC MSB address */
-	I2C_VM_ASM_WRITE_I2C(0, 1),       /* Write one byte */
-	I2C_VM_ASM_READ_I2C(0, 2),        /* Read 2 byte ADC value */
+	I2C_VM_ASM_READ_REG_I2C(0xF6, 0, 2), /* Read 2 byte ADC value */
 	I2C_VM_ASM_LOAD_BE(0, 2, VM_R3),  /* Load 16-bit formatted bytes into first output reg */
 
 	/* Pressure conversion */
 
-	I2C_VM_ASM_STORE(0xF4, 0),        /* Store ctrl register address */
-	I2C_VM_ASM_STORE(0x34 + (0x3 << 6), 1),	/* Store pressure conv address */
-	I2C_VM_ASM_WRITE_I2C(0, 2),       /* Write two bytes */
+	I2C_VM_ASM_WRITE_REG_I2C(0xF4, 0x34 + (0x3 << 6)), /* Start pressure conversion */
 	I2C_VM_ASM_DELAY(26),	          /* Wait for pressure conversion to complete */
 
-	I2C_VM_ASM_STORE(0xF6, 0),        /* Store ADC MSB address */
-	I2C_VM_ASM_WRITE_I2C(0, 1),       /* Write one byte */
-	I2C_VM_ASM_READ_I2C(0, 3),        /* Read 3 byte ADC value */
+	I2C_VM_ASM_READ_REG_I2C(0xF6, 0, 3), /* Read 3 byte ADC value */
 	I2C_VM_ASM_LOAD_BE(0, 3, VM_R4),  /* Load 24-bit formatted bytes into first output reg */
 
 	/* Scale the pressure conversion by the oversampling factor (set when conversion started) */
 	I2C_VM_ASM_LSR_IMM(VM_R4, 8 - 3),
 
 	I2C_VM_ASM_SEND_UAVO(),	          /* Set the UAVObject */
-	I2C_VM_ASM_JUMP(-38),             /* Jump back 38 instructions */
+	I2C_VM_ASM_JUMP(-28),             /* Jump back 28 instructions */
 };
 
 const uint32_t vmprog_op_mag_baro_len = NELEMENTS(vmprog_op_mag_baro);
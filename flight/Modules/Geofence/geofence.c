@@ -6,7 +6,7 @@
  * @{
  *
  * @file       geofence.c
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @brief      Check the UAV is within the geofence boundaries
  *
  * @see        The GNU Public License (GPL) Version 3
@@ -28,20 +28,45 @@
  * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  */
 
+/**
+ * Input objects: PositionActual, GeoFenceSettings, GeoFencePolygon
+ * Output: the GeoFence alarm
+ *
+ * Besides the circle of GeoFenceSettings, each GeoFencePolygon instance the
+ * GCS uploads is a keep-in or keep-out zone. When one arrives all polygons
+ * are sorted into a geofence_index, so checking a position only looks at the
+ * few edges near it. The index is saved on the waypoint filesystem once the
+ * upload is over and the vehicle is disarmed, and the polygons are restored
+ * from it on startup.
+ */
 
 #include "openpilot.h"
+#include <string.h>
 #include "misc_math.h"
 #include "physical_constants.h"
+#include "pios_flashfs.h"
+#include "pios_thread.h"
 
+#include "flightstatus.h"
+#include "geofencepolygon.h"
 #include "geofencesettings.h"
 #include "positionactual.h"
 #include "modulesettings.h"
 
+#include "geofence_index.h"
+
+extern uintptr_t pios_waypoints_settings_fs_id;
 
 //
 // Configuration
 //
-#define SAMPLE_PERIOD_MS     250
+
+//! The index is saved in chunks as instances of this file, the waypoint slots can be small
+#define INDEX_FILE_ID        0x00474600
+#define INDEX_CHUNK_SIZE     48
+
+//! Wait for the rest of the polygons of an upload before saving
+#define SAVE_DELAY_MS        2000
 
 // Private types
 
@@ -49,11 +74,19 @@
 
 // Private functions
 static void settingsUpdated(UAVObjEvent* ev);
+static void polygonsUpdated(UAVObjEvent* ev);
 static void checkPosition(UAVObjEvent* ev);
+static void loadIndex();
+static void saveIndex();
 
 // Private variables
 static bool module_enabled;
 static GeoFenceSettingsData *geofenceSettings;
+static struct geofence_index *fenceIndex;
+
+//! An index was built that is not on flash yet
+static bool indexDirty;
+static uint32_t indexBuiltTime;
 
 /**
  * Initialise the module, called on startup
@@ -81,21 +114,24 @@ int32_t GeofenceInitialize(void)
 
 		// allocate and initialize the static data storage only if module is enabled
 		geofenceSettings = (GeoFenceSettingsData *) PIOS_malloc(sizeof(GeoFenceSettingsData));
-		if (geofenceSettings == NULL) {
+		fenceIndex = (struct geofence_index *) PIOS_malloc(sizeof(struct geofence_index));
+		if (geofenceSettings == NULL || fenceIndex == NULL) {
 			module_enabled = false;
 			return -1;
 		}
 
+		GeoFencePolygonInitialize();
+		PositionActualInitialize();
+
 		GeoFenceSettingsConnectCallback(settingsUpdated);
 		settingsUpdated(NULL);
 
-		// Schedule periodic task to check position
-		UAVObjEvent ev = {
-			.obj = PositionActualHandle(),
-			.instId = 0,
-			.event = 0,
-		};
-		EventPeriodicCallbackCreate(&ev, checkPosition, SAMPLE_PERIOD_MS);
+		// Restored before listening, setting the instances here is not an upload
+		loadIndex();
+		UAVObjConnectCallback(GeoFencePolygonHandle(), polygonsUpdated, EV_UNPACKED);
+
+		// Check every new position
+		UAVObjConnectCallback(PositionActualHandle(), checkPosition, EV_UPDATED);
 
 		return 0;
 	}
@@ -112,26 +148,145 @@ int32_t GeofenceStart(void)
 MODULE_INITCALL(GeofenceInitialize, GeofenceStart);
 
 /**
- * Periodic callback that processes changes in position and
- * sets the alarm.
+ * Called on each update of the position, checks it against the circle
+ * and the polygons and sets the alarm.
  */
 static void checkPosition(UAVObjEvent* ev)
 {
-	if (PositionActualHandle()) {
-		PositionActualData positionActual;
-		PositionActualGet(&positionActual);
-
-		const float distance2 = powf(positionActual.North, 2) + powf(positionActual.East, 2);
-
-		// ErrorRadius is squared when it is fetched, so this is correct
-		if (distance2 > geofenceSettings->ErrorRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_ERROR);
-		} else if (distance2 > geofenceSettings->WarningRadius) {
-			AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_WARNING);
-		} else {
-			AlarmsClear(SYSTEMALARMS_ALARM_GEOFENCE);
+	PositionActualData positionActual;
+	PositionActualGet(&positionActual);
+
+	const float distance2 = positionActual.North * positionActual.North +
+		positionActual.East * positionActual.East;
+
+	// ErrorRadius is squared when it is fetched, so this is correct
+	if (distance2 > geofenceSettings->ErrorRadius ||
+			geofence_index_violated(fenceIndex, positionActual.North, positionActual.East)) {
+		AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_ERROR);
+	} else if (distance2 > geofenceSettings->WarningRadius ||
+			geofence_index_distance(fenceIndex, positionActual.North, positionActual.East,
+				geofenceSettings->WarningDistance) < geofenceSettings->WarningDistance) {
+		AlarmsSet(SYSTEMALARMS_ALARM_GEOFENCE, SYSTEMALARMS_ALARM_WARNING);
+	} else {
+		AlarmsClear(SYSTEMALARMS_ALARM_GEOFENCE);
+	}
+
+	// Flash is never written while armed
+	if (indexDirty && PIOS_Thread_Systime() - indexBuiltTime >= SAVE_DELAY_MS) {
+		uint8_t armed;
+		FlightStatusArmedGet(&armed);
+		if (armed == FLIGHTSTATUS_ARMED_DISARMED)
+			saveIndex();
+	}
+}
+
+/**
+ * Builds the index again from all the polygons whenever the GCS sends one
+ */
+static void polygonsUpdated(UAVObjEvent* ev)
+{
+	geofence_index_clear(fenceIndex);
+
+	uint16_t num_polygons = GeoFencePolygonGetNumInstances();
+	for (uint16_t i = 0; i < num_polygons && i < GEOFENCE_MAX_POLYGONS; i++) {
+		GeoFencePolygonData polygon;
+		GeoFencePolygonInstGet(i, &polygon);
+
+		if (polygon.Type == GEOFENCEPOLYGON_TYPE_INVALID)
+			continue;
+
+		uint8_t vertices = polygon.Vertices;
+		if (vertices > GEOFENCEPOLYGON_NORTH_NUMELEM)
+			vertices = GEOFENCEPOLYGON_NORTH_NUMELEM;
+
+		enum geofence_polygon_type type = (polygon.Type == GEOFENCEPOLYGON_TYPE_KEEPOUT) ?
+				GEOFENCE_KEEP_OUT : GEOFENCE_KEEP_IN;
+		geofence_index_add_polygon(fenceIndex, type, polygon.North, polygon.East, vertices);
+	}
+
+	geofence_index_build(fenceIndex);
+
+	indexDirty = true;
+	indexBuiltTime = PIOS_Thread_Systime();
+}
+
+/**
+ * Loads the saved index and recreates the polygons it was built from
+ */
+static void loadIndex()
+{
+	geofence_index_clear(fenceIndex);
+
+	uint8_t *buf = (uint8_t *) fenceIndex;
+	uint8_t chunk[INDEX_CHUNK_SIZE];
+	for (uint32_t offset = 0; offset < sizeof(*fenceIndex); offset += INDEX_CHUNK_SIZE) {
+		if (PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, INDEX_FILE_ID,
+				offset / INDEX_CHUNK_SIZE, chunk, INDEX_CHUNK_SIZE) != 0) {
+			geofence_index_clear(fenceIndex);
+			return;
 		}
+
+		uint32_t len = sizeof(*fenceIndex) - offset;
+		if (len > INDEX_CHUNK_SIZE)
+			len = INDEX_CHUNK_SIZE;
+		memcpy(&buf[offset], chunk, len);
 	}
+
+	// Saved by another firmware, the polygons have to be uploaded again
+	if (!geofence_index_valid(fenceIndex)) {
+		geofence_index_clear(fenceIndex);
+		return;
+	}
+
+	for (uint8_t p = 0; p < fenceIndex->num_polygons; p++) {
+		GeoFencePolygonData polygon;
+		memset(&polygon, 0, sizeof(polygon));
+
+		polygon.Type = (fenceIndex->polygon_type[p] == GEOFENCE_KEEP_OUT) ?
+				GEOFENCEPOLYGON_TYPE_KEEPOUT : GEOFENCEPOLYGON_TYPE_KEEPIN;
+
+		uint8_t start = fenceIndex->polygon_start[p];
+		uint8_t vertices = fenceIndex->polygon_start[p + 1] - start;
+		if (vertices > GEOFENCEPOLYGON_NORTH_NUMELEM)
+			vertices = GEOFENCEPOLYGON_NORTH_NUMELEM;
+
+		polygon.Vertices = vertices;
+		for (uint8_t v = 0; v < vertices; v++) {
+			polygon.North[v] = fenceIndex->north[start + v];
+			polygon.East[v] = fenceIndex->east[start + v];
+		}
+
+		if (p >= GeoFencePolygonGetNumInstances())
+			GeoFencePolygonCreateInstance();
+		GeoFencePolygonInstSet(p, &polygon);
+	}
+}
+
+/**
+ * Saves the index in chunks, the last one padded
+ */
+static void saveIndex()
+{
+	const uint8_t *buf = (const uint8_t *) fenceIndex;
+	uint8_t chunk[INDEX_CHUNK_SIZE];
+
+	for (uint32_t offset = 0; offset < sizeof(*fenceIndex); offset += INDEX_CHUNK_SIZE) {
+		uint32_t len = sizeof(*fenceIndex) - offset;
+		if (len > INDEX_CHUNK_SIZE)
+			len = INDEX_CHUNK_SIZE;
+
+		memset(chunk, 0, sizeof(chunk));
+		memcpy(chunk, &buf[offset], len);
+
+		if (PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, INDEX_FILE_ID,
+				offset / INDEX_CHUNK_SIZE, chunk, INDEX_CHUNK_SIZE) != 0) {
+			// Try again later instead of on every position
+			indexBuiltTime = PIOS_Thread_Systime();
+			return;
+		}
+	}
+
+	indexDirty = false;
 }
 
 /**
@@ -142,8 +297,8 @@ static void settingsUpdated(UAVObjEvent* ev)
 	GeoFenceSettingsGet(geofenceSettings);
 
 	// Cache squared distances to save computations
-	geofenceSettings->WarningRadius = powf(geofenceSettings->WarningRadius, 2);
-	geofenceSettings->ErrorRadius = powf(geofenceSettings->ErrorRadius, 2);
+	geofenceSettings->WarningRadius *= geofenceSettings->WarningRadius;
+	geofenceSettings->ErrorRadius *= geofenceSettings->ErrorRadius;
 }
 
 /**
@@ -0,0 +1,316 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @file       geofence_index.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Polygon geofences indexed by bands of north
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "geofence_index.h"
+
+#include <math.h>
+#include <string.h>
+
+//! Marks an index that was built, "GFIX"
+#define GEOFENCE_INDEX_MAGIC 0x58494647
+
+/**
+ * Vertex at the other end of the edge starting at vertex v
+ */
+static uint8_t next_vertex(const struct geofence_index *idx, uint8_t v)
+{
+	uint8_t p = idx->vertex_polygon[v];
+
+	if (v + 1 == idx->polygon_start[p + 1])
+		return idx->polygon_start[p];
+
+	return v + 1;
+}
+
+/**
+ * Band a north coordinate falls into, not clamped to the bands there are
+ */
+static float band_of(const struct geofence_index *idx, float north)
+{
+	return floorf((north - idx->band_origin) / idx->band_height);
+}
+
+/**
+ * Empty the index, nothing is ever violated
+ */
+void geofence_index_clear(struct geofence_index *idx)
+{
+	memset(idx, 0, sizeof(*idx));
+}
+
+/**
+ * Add a polygon, the index must be built again before it is used
+ * @param[in] north,east The vertices in m from home, in either order around
+ * @return 0 on success, -1 if the polygon has too few vertices or doesn't fit
+ */
+int32_t geofence_index_add_polygon(struct geofence_index *idx, enum geofence_polygon_type type,
+		const float *north, const float *east, uint8_t num_vertices)
+{
+	if (num_vertices < 3 || idx->num_polygons >= GEOFENCE_MAX_POLYGONS ||
+			idx->num_vertices + num_vertices > GEOFENCE_MAX_VERTICES)
+		return -1;
+
+	uint8_t p = idx->num_polygons;
+	uint8_t start = idx->num_vertices;
+
+	for (uint8_t i = 0; i < num_vertices; i++) {
+		// Whole metres are good enough for a fence and keep the index small
+		float n = fmaxf(fminf(roundf(north[i]), INT16_MAX), INT16_MIN);
+		float e = fmaxf(fminf(roundf(east[i]), INT16_MAX), INT16_MIN);
+
+		idx->north[start + i] = (int16_t)n;
+		idx->east[start + i] = (int16_t)e;
+		idx->vertex_polygon[start + i] = p;
+	}
+
+	idx->polygon_type[p] = type;
+	idx->polygon_start[p] = start;
+	idx->polygon_start[p + 1] = start + num_vertices;
+	idx->num_polygons++;
+	idx->num_vertices += num_vertices;
+	idx->num_bands = 0;
+
+	return 0;
+}
+
+/**
+ * Sort the edges into bands. Edges spanning many bands are listed in each
+ * of them, so there are fewer bands when the lists wouldn't fit.
+ */
+void geofence_index_build(struct geofence_index *idx)
+{
+	idx->magic = GEOFENCE_INDEX_MAGIC;
+	idx->size = sizeof(*idx);
+	idx->num_bands = 0;
+
+	if (idx->num_vertices == 0)
+		return;
+
+	int16_t min_north = INT16_MAX;
+	int16_t max_north = INT16_MIN;
+	for (uint8_t v = 0; v < idx->num_vertices; v++) {
+		if (idx->north[v] < min_north)
+			min_north = idx->north[v];
+		if (idx->north[v] > max_north)
+			max_north = idx->north[v];
+	}
+
+	uint32_t span = max_north - min_north;
+	idx->band_origin = min_north;
+
+	uint32_t num_bands;
+	for (num_bands = GEOFENCE_MAX_BANDS; num_bands > 1; num_bands /= 2) {
+		// Rounded up so the northernmost vertex is still in the last band
+		uint32_t height = span / num_bands + 1;
+
+		uint32_t entries = 0;
+		for (uint8_t v = 0; v < idx->num_vertices; v++) {
+			int16_t n1 = idx->north[v];
+			int16_t n2 = idx->north[next_vertex(idx, v)];
+			uint32_t lo = ((n1 < n2 ? n1 : n2) - min_north) / height;
+			uint32_t hi = ((n1 < n2 ? n2 : n1) - min_north) / height;
+			entries += hi - lo + 1;
+		}
+
+		if (entries <= GEOFENCE_MAX_BAND_EDGES)
+			break;
+	}
+
+	// A single band lists every edge once
+	idx->band_height = span / num_bands + 1;
+
+	// Count the edges of each band and then place them
+	uint16_t fill[GEOFENCE_MAX_BANDS];
+	memset(fill, 0, sizeof(fill));
+	for (uint8_t v = 0; v < idx->num_vertices; v++) {
+		int16_t n1 = idx->north[v];
+		int16_t n2 = idx->north[next_vertex(idx, v)];
+		uint32_t lo = ((n1 < n2 ? n1 : n2) - min_north) / idx->band_height;
+		uint32_t hi = ((n1 < n2 ? n2 : n1) - min_north) / idx->band_height;
+		for (uint32_t b = lo; b <= hi; b++)
+			fill[b]++;
+	}
+
+	idx->band_start[0] = 0;
+	for (uint32_t b = 0; b < num_bands; b++) {
+		idx->band_start[b + 1] = idx->band_start[b] + fill[b];
+		fill[b] = idx->band_start[b];
+	}
+
+	for (uint8_t v = 0; v < idx->num_vertices; v++) {
+		int16_t n1 = idx->north[v];
+		int16_t n2 = idx->north[next_vertex(idx, v)];
+		uint32_t lo = ((n1 < n2 ? n1 : n2) - min_north) / idx->band_height;
+		uint32_t hi = ((n1 < n2 ? n2 : n1) - min_north) / idx->band_height;
+		for (uint32_t b = lo; b <= hi; b++)
+			idx->band_edges[fill[b]++] = v;
+	}
+
+	idx->num_bands = num_bands;
+}
+
+/**
+ * Check an index that was loaded was built by this firmware and is consistent
+ */
+bool geofence_index_valid(const struct geofence_index *idx)
+{
+	if (idx->magic != GEOFENCE_INDEX_MAGIC || idx->size != sizeof(*idx))
+		return false;
+
+	if (idx->num_polygons > GEOFENCE_MAX_POLYGONS || idx->num_vertices > GEOFENCE_MAX_VERTICES ||
+			idx->num_bands > GEOFENCE_MAX_BANDS)
+		return false;
+
+	if (idx->polygon_start[0] != 0 || idx->polygon_start[idx->num_polygons] != idx->num_vertices)
+		return false;
+
+	for (uint8_t p = 0; p < idx->num_polygons; p++) {
+		if (idx->polygon_start[p + 1] < idx->polygon_start[p] + 3)
+			return false;
+	}
+
+	for (uint8_t v = 0; v < idx->num_vertices; v++) {
+		uint8_t p = idx->vertex_polygon[v];
+		if (p >= idx->num_polygons || v < idx->polygon_start[p] || v >= idx->polygon_start[p + 1])
+			return false;
+	}
+
+	if (idx->num_bands > 0) {
+		if (idx->band_height == 0 || idx->band_start[0] != 0 ||
+				idx->band_start[idx->num_bands] > GEOFENCE_MAX_BAND_EDGES)
+			return false;
+
+		for (uint8_t b = 0; b < idx->num_bands; b++) {
+			if (idx->band_start[b + 1] < idx->band_start[b])
+				return false;
+		}
+
+		for (uint16_t i = 0; i < idx->band_start[idx->num_bands]; i++) {
+			if (idx->band_edges[i] >= idx->num_vertices)
+				return false;
+		}
+	} else if (idx->num_vertices > 0) {
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * Check whether a point is outside all keep-in polygons, if there are any,
+ * or inside any keep-out polygon
+ * @param[in] north,east The point in m from home
+ */
+bool geofence_index_violated(const struct geofence_index *idx, float north, float east)
+{
+	// One bit per polygon, set when the point is inside
+	uint32_t inside = 0;
+
+	float band = idx->num_bands > 0 ? band_of(idx, north) : -1;
+	if (band >= 0 && band < idx->num_bands) {
+		uint8_t b = (uint8_t)band;
+
+		for (uint16_t i = idx->band_start[b]; i < idx->band_start[b + 1]; i++) {
+			uint8_t v = idx->band_edges[i];
+			uint8_t w = next_vertex(idx, v);
+			float n1 = idx->north[v], e1 = idx->east[v];
+			float n2 = idx->north[w], e2 = idx->east[w];
+
+			// Count the edges the ray to the east crosses
+			if ((n1 > north) != (n2 > north)) {
+				float crossing = e1 + (north - n1) * (e2 - e1) / (n2 - n1);
+				if (east < crossing)
+					inside ^= 1u << idx->vertex_polygon[v];
+			}
+		}
+	}
+
+	bool keep_in = false;
+	bool in_keep_in = false;
+	for (uint8_t p = 0; p < idx->num_polygons; p++) {
+		bool in = (inside & (1u << p)) != 0;
+
+		if (idx->polygon_type[p] == GEOFENCE_KEEP_OUT) {
+			if (in)
+				return true;
+		} else {
+			keep_in = true;
+			in_keep_in |= in;
+		}
+	}
+
+	return keep_in && !in_keep_in;
+}
+
+/**
+ * Distance from a point to the nearest edge of any polygon
+ * @param[in] north,east The point in m from home
+ * @param[in] max_distance Edges further away than this are not looked at
+ * @return The distance in m, or max_distance if no edge is closer
+ */
+float geofence_index_distance(const struct geofence_index *idx, float north, float east, float max_distance)
+{
+	if (idx->num_bands == 0)
+		return max_distance;
+
+	float lo = fmaxf(band_of(idx, north - max_distance), 0);
+	float hi = fminf(band_of(idx, north + max_distance), idx->num_bands - 1);
+
+	float nearest2 = max_distance * max_distance;
+
+	for (float band = lo; band <= hi; band++) {
+		uint8_t b = (uint8_t)band;
+
+		for (uint16_t i = idx->band_start[b]; i < idx->band_start[b + 1]; i++) {
+			uint8_t v = idx->band_edges[i];
+			uint8_t w = next_vertex(idx, v);
+			float n1 = idx->north[v], e1 = idx->east[v];
+			float dn = idx->north[w] - n1, de = idx->east[w] - e1;
+
+			// Nearest point of the segment
+			float len2 = dn * dn + de * de;
+			float t = len2 > 0 ? ((north - n1) * dn + (east - e1) * de) / len2 : 0;
+			t = fmaxf(fminf(t, 1), 0);
+
+			float rn = north - (n1 + t * dn);
+			float re = east - (e1 + t * de);
+			float dist2 = rn * rn + re * re;
+			if (dist2 < nearest2)
+				nearest2 = dist2;
+		}
+	}
+
+	return sqrtf(nearest2);
+}
+
+/**
+ * @}
+ * @}
+ */
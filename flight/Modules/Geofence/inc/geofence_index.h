@@ -0,0 +1,90 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup GeoFence GeoFence Module
+ * @{
+ *
+ * @file       geofence_index.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Polygon geofences indexed by bands of north
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef GEOFENCE_INDEX_H
+#define GEOFENCE_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GEOFENCE_MAX_POLYGONS   8
+#define GEOFENCE_MAX_VERTICES   128
+#define GEOFENCE_MAX_BANDS      32
+#define GEOFENCE_MAX_BAND_EDGES 384
+
+enum geofence_polygon_type {
+	GEOFENCE_KEEP_IN,
+	GEOFENCE_KEEP_OUT,
+};
+
+/**
+ * The polygons with their edges sorted into bands of north. The ray of the
+ * point-in-polygon test runs east, so it only crosses edges in the band of
+ * the point, however many vertices the polygons have.
+ *
+ * The whole index is one block of memory without pointers, so it can be
+ * saved and loaded as it is.
+ */
+struct geofence_index {
+	uint32_t magic;
+	uint16_t size;                  //!< sizeof(struct geofence_index) of the firmware that built it
+
+	uint8_t num_polygons;
+	uint8_t num_vertices;
+	uint8_t num_bands;              //!< 0 until built or without polygons
+	int16_t band_origin;            //!< South end of band 0, m
+	uint32_t band_height;           //!< m
+
+	uint8_t polygon_type[GEOFENCE_MAX_POLYGONS];
+	uint8_t polygon_start[GEOFENCE_MAX_POLYGONS + 1];  //!< First vertex of each polygon
+	uint8_t vertex_polygon[GEOFENCE_MAX_VERTICES];
+	int16_t north[GEOFENCE_MAX_VERTICES];              //!< m from home
+	int16_t east[GEOFENCE_MAX_VERTICES];               //!< m from home
+
+	//! The edges of band b are band_edges[band_start[b]] up to band_edges[band_start[b + 1]],
+	//! each given by its first vertex
+	uint16_t band_start[GEOFENCE_MAX_BANDS + 1];
+	uint8_t band_edges[GEOFENCE_MAX_BAND_EDGES];
+};
+
+void geofence_index_clear(struct geofence_index *idx);
+int32_t geofence_index_add_polygon(struct geofence_index *idx, enum geofence_polygon_type type,
+		const float *north, const float *east, uint8_t num_vertices);
+void geofence_index_build(struct geofence_index *idx);
+bool geofence_index_valid(const struct geofence_index *idx);
+bool geofence_index_violated(const struct geofence_index *idx, float north, float east);
+float geofence_index_distance(const struct geofence_index *idx, float north, float east, float max_distance);
+
+#endif /* GEOFENCE_INDEX_H */
+
+/**
+ * @}
+ * @}
+ */
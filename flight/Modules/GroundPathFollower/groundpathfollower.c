@@ -44,6 +44,7 @@
 #include "misc_math.h"
 #include "paths.h"
 #include "pid.h"
+#include "attitude_cache.h"
 
 #include "accels.h"
 #include "attitudeactual.h"
@@ -76,6 +77,7 @@
 // Private variables
 static struct pios_thread *pathfollowerTaskHandle;
 static PathDesiredData pathDesired;
+static struct path_segment pathSegment;
 static GroundPathFollowerSettingsData guidanceSettings;
 
 // Private functions
@@ -257,7 +259,8 @@ static void updatePathVelocity()
 	float cur[3] = {positionActual.North, positionActual.East, positionActual.Down};
 	struct path_status progress;
 
-	path_progress(&pathDesired, cur, &progress);
+	path_segment_update(&pathSegment, &pathDesired);
+	path_segment_progress(&pathSegment, cur, &progress);
 
 	// Update the path status UAVO
 	PathStatusData pathStatus;
@@ -443,8 +446,6 @@ static void updateGroundDesiredAttitude()
 static void updateNedAccel()
 {
 	float accel[3];
-	float q[4];
-	float Rbe[3][3];
 	float accel_ned[3];
 
 	// Collect downsampled attitude data
@@ -455,17 +456,12 @@ static void updateNedAccel()
 	accel[2] = accels.z;
 
 	//rotate avg accels into earth frame and store it
-	AttitudeActualData attitudeActual;
-	AttitudeActualGet(&attitudeActual);
-	q[0]=attitudeActual.q1;
-	q[1]=attitudeActual.q2;
-	q[2]=attitudeActual.q3;
-	q[3]=attitudeActual.q4;
-	Quaternion2R(q, Rbe);
+	struct attitude_derived attitude;
+	AttitudeCacheGet(&attitude);
 	for (uint8_t i=0; i<3; i++){
 		accel_ned[i]=0;
 		for (uint8_t j=0; j<3; j++)
-			accel_ned[i] += Rbe[j][i]*accel[j];
+			accel_ned[i] += attitude.Rbe[j][i]*accel[j];
 	}
 	accel_ned[2] += GRAVITY;
 
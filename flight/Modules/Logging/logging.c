@@ -31,8 +31,8 @@
 #include "modulesettings.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
-#include "pios_mutex.h"
 #include "uavobjectmanager.h"
+#include "uavobjectsinit.h"
 #include "misc_math.h"
 #include "timeutils.h"
 #include "uavobjectmanager.h"
@@ -43,6 +43,10 @@
 #include "flightstatus.h"
 #include "loggingsettings.h"
 #include "loggingstats.h"
+#include "loggingstream.h"
+#include "loggingstreamack.h"
+#include "blackbox.h"
+#include "traceblock.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1200
@@ -51,6 +55,48 @@ const char DIGITS[16] = "0123456789abcdef";
 
 #define LOGGING_PERIOD_MS 10
 #define LOGGING_QUEUE_SIZE 64
+#define LOGGING_DROPS_PERIOD_MS 1000
+
+//! Number of sectors in flight while streaming a log, each one holds a LoggingStream instance
+#ifndef LOGGING_STREAM_WINDOW
+#define LOGGING_STREAM_WINDOW 8
+#endif
+
+#if LOGGING_STREAM_WINDOW > 32
+#error LoggingStreamAck.Resend can only address 32 sectors
+#endif
+
+//! Number of blackbox frames buffered between two writes of the log
+#ifndef LOGGING_BLACKBOX_FRAMES
+#define LOGGING_BLACKBOX_FRAMES 128
+#endif
+
+//! Size of the event trace ring, drained into the log at every write
+#ifndef LOGGING_TRACE_EVENTS
+#define LOGGING_TRACE_EVENTS 512
+#endif
+
+/*
+ * Compact log format, selected with LoggingSettings.LogFormat.  The text
+ * header is followed by a "##compact" line and a table mapping the short
+ * code of each object to its ID, size and whether it has instances:
+ *   code(1) objid(4) size(2) flags(1) ... LOG_COMPACT_TIME
+ * Every record after that is
+ *   code(1) time since the previous record in ms(1) [instid(2)] data
+ * or a LOG_COMPACT_TIME record with the absolute time in ms(4).  Those are
+ * written whenever the time difference would not fit and at least every
+ * LOG_COMPACT_SYNC_MS, a reader resynchronizes on them.  Blackbox frames
+ * are records of LOG_COMPACT_BLACKBOX and event trace blocks records of
+ * LOG_COMPACT_TRACE, the table describes them as BlackboxFrame and
+ * TraceBlock objects.  Objects never get these codes.
+ */
+#define LOG_COMPACT_MARKER "##compact\n"
+#define LOG_COMPACT_TIME 0xFF
+#define LOG_COMPACT_BLACKBOX 0xFE
+#define LOG_COMPACT_TRACE 0xFD
+#define LOG_COMPACT_MULTI_INSTANCE 0x01
+#define LOG_COMPACT_SYNC_MS 1000
+#define LOG_COMPACT_RECORD_HEADER 4
 
 // Private types
 
@@ -61,24 +107,61 @@ static bool module_enabled;
 static LoggingSettingsData settings;
 static LoggingStatsData loggingData;
 struct pios_queue *logging_queue;
-static struct pios_recursive_mutex *mutex;
 
 // Private functions
 static void    loggingTask(void *parameters);
 static int32_t send_data(uint8_t *data, int32_t length);
+static uint8_t * reserve_data(uint16_t length);
+static int32_t commit_data(uint16_t length);
 static void register_object(UAVObjHandle obj);
+static void count_drops(UAVObjHandle obj);
+static void update_drops(void);
 static void logSettings(UAVObjHandle obj);
 static void SettingsUpdatedCb(UAVObjEvent * ev);
 static void writeHeader();
+static void logObject(UAVObjHandle obj, uint16_t instId);
+static void writeCompactEntry(UAVObjHandle obj);
+static void writeCompactTime(uint32_t time);
+#if defined(BLACKBOX_CAPTURE)
+static void logBlackbox(void);
+#endif
+#if defined(PIOS_INCLUDE_TRACE)
+static void logTrace(void);
+#endif
+#if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
+static int32_t read_sector(uint8_t *data);
+static int32_t stream_start(void);
+static int32_t stream_process(void);
+static void StreamAckUpdatedCb(UAVObjEvent * ev);
+#endif
 
 // Local variables
 static uintptr_t logging_com_id;
 static uint32_t written_bytes;
 static bool destination_spi_flash;
+static bool log_compact;
+static uint32_t last_record_time;
+static uint32_t last_sync_time;
+static uint8_t record_buffer[LOG_COMPACT_RECORD_HEADER + UAVOBJECTS_LARGEST];
+static uint32_t last_drops_time;
+static uint32_t drops_total;
+static uint32_t drops_id[LOGGINGSTATS_DROPPEDOBJECTID_NUMELEM];
+static uint16_t drops_events[LOGGINGSTATS_DROPPEDOBJECTEVENTS_NUMELEM];
+#if defined(PIOS_INCLUDE_TRACE)
+static bool trace_enabled;
+static uint32_t trace_dropped;
+#endif
 
 #if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
 // External variables
 extern uintptr_t streamfs_id;
+
+// Streaming state, all sectors before stream_base are acknowledged and
+// the ones up to stream_next are in flight
+static uint32_t stream_base;
+static uint32_t stream_next;
+static uint32_t stream_last;
+static volatile bool stream_ack_received;
 #endif
 
 /**
@@ -118,8 +201,26 @@ int32_t LoggingInitialize(void)
 	LoggingStatsInitialize();
 	LoggingSettingsInitialize();
 
+#if defined(BLACKBOX_CAPTURE)
+	uint8_t blackbox_divider;
+	LoggingSettingsBlackboxDividerGet(&blackbox_divider);
+	if (blackbox_divider != 0)
+		BlackboxInitialize(LOGGING_BLACKBOX_FRAMES, blackbox_divider);
+#endif
+#if defined(PIOS_INCLUDE_TRACE)
+	trace_enabled = (PIOS_TRACE_Init(LOGGING_TRACE_EVENTS) == 0);
+#endif
+#if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
+	if (destination_spi_flash) {
+		LoggingStreamInitialize();
+		LoggingStreamAckInitialize();
+		LoggingStreamAckConnectCallback(StreamAckUpdatedCb);
+	}
+#endif
+
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&send_data);
+	UAVTalkSetReserveStream(uavTalkCon, &reserve_data, &commit_data);
 
 	return 0;
 }
@@ -142,13 +243,8 @@ int32_t LoggingStart(void)
 		return -1;
 	}
 
-	// Create mutex
-	mutex = PIOS_Recursive_Mutex_Create();
-	if (mutex == NULL){
-		return -2;
-	}
-
 	// Process all registered objects and connect queue for updates
+	LoggingSettingsGet(&settings);
 	UAVObjIterate(&register_object);
 
 	// Start logging task
@@ -159,7 +255,7 @@ int32_t LoggingStart(void)
 	return 0;
 }
 
-MODULE_INITCALL(LoggingInitialize, LoggingStart);
+MODULE_DEFERRED_INITCALL(LoggingInitialize, LoggingStart);
 
 static void loggingTask(void *parameters)
 {
@@ -171,7 +267,8 @@ static void loggingTask(void *parameters)
 #if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
 	bool write_open = false;
 	bool read_open = false;
-	int32_t read_sector = 0;
+	bool streaming = false;
+	int32_t read_sector_num = 0;
 	uint8_t read_data[LOGGINGSTATS_FILESECTOR_NUMELEM];
 #endif
 
@@ -221,6 +318,26 @@ static void loggingTask(void *parameters)
 			}
 		}
 
+#if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
+		// The GCS gave up on a stream, the file is not needed anymore
+		if (streaming && loggingData.Operation != LOGGINGSTATS_OPERATION_STREAM) {
+			PIOS_STREAMFS_Close(streamfs_id);
+			read_open = false;
+			streaming = false;
+		}
+#endif /* defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC) */
+
+		// We are not logging, so all events are discarded
+		if (loggingData.Operation != LOGGINGSTATS_OPERATION_LOGGING) {
+			while (UAVObjQueueReceive(logging_queue, &ev, 0) == true);
+#if defined(BLACKBOX_CAPTURE)
+			BlackboxRead(NULL, LOGGING_BLACKBOX_FRAMES);
+#endif
+#if defined(PIOS_INCLUDE_TRACE)
+			PIOS_TRACE_Read(NULL, LOGGING_TRACE_EVENTS);
+#endif
+		}
+
 		switch (loggingData.Operation) {
 		case LOGGINGSTATS_OPERATION_FORMAT:
 			// Format the file system
@@ -265,7 +382,13 @@ static void loggingTask(void *parameters)
 			}
 #endif /* defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC) */
 
+			// Pick up changes of the logging periods, this also restarts the drop counts
+			UAVObjIterate(&register_object);
+			update_drops();
+			last_drops_time = PIOS_Thread_Systime();
+
 			// Write information at start of the log file
+			log_compact = (settings.LogFormat == LOGGINGSETTINGS_LOGFORMAT_COMPACT);
 			writeHeader();
 
 			// Log settings
@@ -274,7 +397,7 @@ static void loggingTask(void *parameters)
 			}
 
 			// Empty the queue
-			while(PIOS_Queue_Receive(logging_queue, &ev, 0))
+			while(UAVObjQueueReceive(logging_queue, &ev, 0))
 
 			LoggingStatsBytesLoggedSet(&written_bytes);
 			loggingData.Operation = LOGGINGSTATS_OPERATION_LOGGING;
@@ -286,12 +409,23 @@ static void loggingTask(void *parameters)
 				PIOS_Thread_Sleep_Until(&now, LOGGING_PERIOD_MS);
 
 				// Log the objects registred to the shared queue
-				while (PIOS_Queue_Receive(logging_queue, &ev, 0) == true) {
-					UAVTalkSendObjectTimestamped(uavTalkCon, ev.obj, ev.instId, false, 0);
+				while (UAVObjQueueReceive(logging_queue, &ev, 0) == true) {
+					logObject(ev.obj, ev.instId);
 				}
+#if defined(BLACKBOX_CAPTURE)
+				logBlackbox();
+#endif
+#if defined(PIOS_INCLUDE_TRACE)
+				logTrace();
+#endif
 				LoggingStatsBytesLoggedSet(&written_bytes);
 
 				now = PIOS_Thread_Systime();
+
+				if (now - last_drops_time >= LOGGING_DROPS_PERIOD_MS) {
+					update_drops();
+					last_drops_time = now;
+				}
 			}
 			break;
 		case LOGGINGSTATS_OPERATION_DOWNLOAD:
@@ -303,14 +437,14 @@ static void loggingTask(void *parameters)
 						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
 					} else {
 						read_open = true;
-						read_sector = -1;
+						read_sector_num = -1;
 					}
 				}
-				if (read_open && read_sector == loggingData.FileSectorNum) {
+				if (read_open && read_sector_num == loggingData.FileSectorNum) {
 					// Request received for same sector. Reupdate.
 					memcpy(loggingData.FileSector, read_data, LOGGINGSTATS_FILESECTOR_NUMELEM);
 					loggingData.Operation = LOGGINGSTATS_OPERATION_IDLE;
-				} else if (read_open && (read_sector + 1) == loggingData.FileSectorNum) {
+				} else if (read_open && (read_sector_num + 1) == loggingData.FileSectorNum) {
 					int32_t bytes_read = PIOS_COM_ReceiveBuffer(logging_com_id, read_data, LOGGINGSTATS_FILESECTOR_NUMELEM, 1);
 					if (bytes_read < 0 || bytes_read > LOGGINGSTATS_FILESECTOR_NUMELEM) {
 						// close on error
@@ -335,12 +469,43 @@ static void loggingTask(void *parameters)
 						loggingData.Operation = LOGGINGSTATS_OPERATION_IDLE;
 						memcpy(loggingData.FileSector, read_data, LOGGINGSTATS_FILESECTOR_NUMELEM);
 					}
-					read_sector = loggingData.FileSectorNum;
+					read_sector_num = loggingData.FileSectorNum;
 				}
 				LoggingStatsSet(&loggingData);
 			}
 #endif /* defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC) */
 
+			// fall-through to default case
+		case LOGGINGSTATS_OPERATION_STREAM:
+#if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
+			if (destination_spi_flash && loggingData.Operation == LOGGINGSTATS_OPERATION_STREAM) {
+				if (!streaming) {
+					// Start from the beginning of the requested file
+					if (read_open)
+						PIOS_STREAMFS_Close(streamfs_id);
+					read_open = false;
+					if (stream_start() != 0 ||
+							PIOS_STREAMFS_OpenRead(streamfs_id, loggingData.FileRequest) != 0) {
+						loggingData.Operation = LOGGINGSTATS_OPERATION_ERROR;
+						LoggingStatsSet(&loggingData);
+					} else {
+						read_open = true;
+						streaming = true;
+					}
+				}
+				if (streaming) {
+					int32_t ret = stream_process();
+					if (ret != 0) {
+						PIOS_STREAMFS_Close(streamfs_id);
+						read_open = false;
+						streaming = false;
+						loggingData.Operation = (ret > 0) ? LOGGINGSTATS_OPERATION_COMPLETE : LOGGINGSTATS_OPERATION_ERROR;
+						LoggingStatsSet(&loggingData);
+					}
+				}
+			}
+#endif /* defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC) */
+
 			// fall-through to default case
 		default:
 			//  Makes sure that we are not hogging the processor
@@ -361,6 +526,112 @@ static void loggingTask(void *parameters)
 	}
 }
 
+#if defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC)
+/**
+ * Read the next sector of the open file
+ * \param[out] data LOGGINGSTREAM_DATA_NUMELEM bytes, the part after the end
+ * of the file is left untouched
+ * \return the number of bytes read, less than a sector at the end of the file
+ * \return -1 on error
+ */
+static int32_t read_sector(uint8_t *data)
+{
+	int32_t bytes_read = PIOS_COM_ReceiveBuffer(logging_com_id, data, LOGGINGSTREAM_DATA_NUMELEM, 1);
+	if (bytes_read < 0 || bytes_read > LOGGINGSTREAM_DATA_NUMELEM)
+		return -1;
+
+	if (bytes_read < LOGGINGSTREAM_DATA_NUMELEM) {
+		// Check it has really run out of bytes by reading again
+		int32_t bytes_read2 = PIOS_COM_ReceiveBuffer(logging_com_id, &data[bytes_read], LOGGINGSTREAM_DATA_NUMELEM - bytes_read, 1);
+		if (bytes_read2 < 0)
+			return -1;
+		bytes_read += bytes_read2;
+	}
+
+	return bytes_read;
+}
+
+/**
+ * Prepare the window of LoggingStream instances for a new stream
+ * \return 0 on success, -1 if the instances could not be created
+ */
+static int32_t stream_start(void)
+{
+	for (uint16_t i = LoggingStreamGetNumInstances(); i < LOGGING_STREAM_WINDOW; i++)
+		LoggingStreamCreateInstance();
+
+	if (LoggingStreamGetNumInstances() < LOGGING_STREAM_WINDOW)
+		return -1;
+
+	stream_base = 0;
+	stream_next = 0;
+	stream_last = UINT32_MAX;
+	stream_ack_received = false;
+
+	return 0;
+}
+
+/**
+ * Push the open file to the GCS.  Up to LOGGING_STREAM_WINDOW sectors are
+ * sent ahead of the last acknowledgement.  A sector stays in its
+ * LoggingStream instance until it is acknowledged, so the sectors the GCS
+ * reports as lost are sent again from there.
+ * \return 1 once the GCS acknowledged the last sector
+ * \return 0 while the transfer is going on
+ * \return -1 on a read error
+ */
+static int32_t stream_process(void)
+{
+	if (stream_ack_received) {
+		LoggingStreamAckData ack;
+
+		stream_ack_received = false;
+		LoggingStreamAckGet(&ack);
+
+		if (ack.NextSector > stream_base && ack.NextSector <= stream_next)
+			stream_base = ack.NextSector;
+
+		if (stream_last != UINT32_MAX && stream_base > stream_last)
+			return 1;
+
+		for (uint32_t i = 0; i < 32; i++) {
+			uint32_t sector = ack.NextSector + i;
+			if ((ack.Resend & (1u << i)) && sector >= stream_base && sector < stream_next)
+				LoggingStreamInstUpdated(sector % LOGGING_STREAM_WINDOW);
+		}
+	}
+
+	while (stream_last == UINT32_MAX && stream_next < stream_base + LOGGING_STREAM_WINDOW) {
+		LoggingStreamData sector;
+
+		memset(sector.Data, 0, sizeof(sector.Data));
+		int32_t bytes_read = read_sector(sector.Data);
+		if (bytes_read < 0)
+			return -1;
+
+		sector.SectorNum = stream_next;
+		sector.Length = bytes_read;
+		if (bytes_read < LOGGINGSTREAM_DATA_NUMELEM)
+			stream_last = stream_next;
+
+		// Sent right away as the object updates on change
+		LoggingStreamInstSet(stream_next % LOGGING_STREAM_WINDOW, &sector);
+		stream_next++;
+	}
+
+	return 0;
+}
+
+/**
+ * Callback for the acknowledgements of the GCS, they are handled in the
+ * logging task
+ */
+static void StreamAckUpdatedCb(UAVObjEvent * ev)
+{
+	stream_ack_received = true;
+}
+#endif /* defined(PIOS_INCLUDE_FLASH) && defined(PIOS_INCLUDE_FLASH_JEDEC) */
+
 /**
  * Log all settings objects
  * \param[in] obj Object to log
@@ -368,10 +639,183 @@ static void loggingTask(void *parameters)
 static void logSettings(UAVObjHandle obj)
 {
 	if (UAVObjIsSettings(obj)) {
-		UAVTalkSendObjectTimestamped(uavTalkCon, obj, 0, false, 0);
+		logObject(obj, 0);
+	}
+}
+
+/**
+ * Write an object instance to the log in the selected format
+ * \param[in] obj Object to log
+ * \param[in] instId Instance to log
+ */
+static void logObject(UAVObjHandle obj, uint16_t instId)
+{
+	if (!log_compact) {
+		UAVTalkSendObjectTimestamped(uavTalkCon, obj, instId, false, 0);
+		return;
+	}
+
+	// Metaobjects have no short code, they are of no use in a log anyway
+	uint8_t code = UAVObjGetIndex(obj);
+	if (code >= LOG_COMPACT_TRACE)
+		return;
+
+	uint32_t now = PIOS_Thread_Systime();
+	if (now - last_record_time > UINT8_MAX || now - last_sync_time >= LOG_COMPACT_SYNC_MS)
+		writeCompactTime(now);
+
+	uint16_t header = UAVObjIsSingleInstance(obj) ? 2 : 4;
+	uint16_t length = header + UAVObjGetNumBytes(obj);
+
+	// Pack straight into the output buffer when it has the room
+	uint8_t *record = reserve_data(length);
+	bool reserved = (record != NULL);
+	if (!reserved)
+		record = record_buffer;
+
+	record[0] = code;
+	record[1] = now - last_record_time;
+	if (header == 4) {
+		record[2] = instId & 0xFF;
+		record[3] = instId >> 8;
+	}
+
+	if (UAVObjPack(obj, instId, &record[header]) < 0) {
+		if (reserved)
+			commit_data(0);
+		return;
+	}
+
+	if (reserved)
+		commit_data(length);
+	else
+		send_data(record, length);
+
+	last_record_time = now;
+}
+
+/**
+ * Write the short code table entry of an object
+ * \param[in] obj Object to describe
+ */
+static void writeCompactEntry(UAVObjHandle obj)
+{
+	uint8_t code = UAVObjGetIndex(obj);
+	if (code >= LOG_COMPACT_TRACE)
+		return;
+
+	uint32_t id = UAVObjGetID(obj);
+	uint16_t size = UAVObjGetNumBytes(obj);
+	uint8_t entry[8] = {
+		code,
+		id & 0xFF, (id >> 8) & 0xFF, (id >> 16) & 0xFF, id >> 24,
+		size & 0xFF, size >> 8,
+		UAVObjIsSingleInstance(obj) ? 0 : LOG_COMPACT_MULTI_INSTANCE,
+	};
+
+	send_data(entry, sizeof(entry));
+}
+
+#if defined(BLACKBOX_CAPTURE)
+/**
+ * Write the blackbox frames captured since the last call to the compact log
+ */
+static void logBlackbox(void)
+{
+	if (!log_compact) {
+		BlackboxRead(NULL, LOGGING_BLACKBOX_FRAMES);
+		return;
+	}
+
+	const uint16_t length = 2 + sizeof(BlackboxFrameData);
+	uint32_t now = PIOS_Thread_Systime();
+
+	// The frames carry their own time, the record time is when they are written
+	while (BlackboxRead(&record_buffer[2], 1) == 1) {
+		if (now - last_record_time > UINT8_MAX || now - last_sync_time >= LOG_COMPACT_SYNC_MS)
+			writeCompactTime(now);
+
+		record_buffer[0] = LOG_COMPACT_BLACKBOX;
+		record_buffer[1] = now - last_record_time;
+		send_data(record_buffer, length);
+
+		last_record_time = now;
+	}
+}
+
+DONT_BUILD_IF(2 + sizeof(BlackboxFrameData) > sizeof(record_buffer), BlackboxRecordSize);
+#endif /* BLACKBOX_CAPTURE */
+
+#if defined(PIOS_INCLUDE_TRACE)
+/**
+ * Write the events traced since the last call to the compact log, up to
+ * TRACEBLOCK_EVENT_NUMELEM of them in each record
+ */
+static void logTrace(void)
+{
+	if (!log_compact || !trace_enabled) {
+		PIOS_TRACE_Read(NULL, LOGGING_TRACE_EVENTS);
+		return;
+	}
+
+	const uint16_t length = 2 + sizeof(TraceBlockData);
+	uint32_t now = PIOS_Thread_Systime();
+
+	// Only take what was there, the events keep coming while writing
+	for (uint16_t taken = 0; taken < LOGGING_TRACE_EVENTS; ) {
+		TraceBlockData block;
+		memset(&block, 0, sizeof(block));
+
+		struct pios_trace_record event;
+		while (block.Count < TRACEBLOCK_EVENT_NUMELEM && PIOS_TRACE_Read(&event, 1) == 1) {
+			block.Cycles[block.Count] = event.cycles;
+			block.Arg[block.Count] = event.arg;
+			block.Event[block.Count] = event.event;
+			block.Count++;
+		}
+
+		if (block.Count == 0)
+			break;
+		taken += block.Count;
+
+		uint32_t dropped = PIOS_TRACE_Dropped();
+		block.Dropped = (dropped - trace_dropped > UINT16_MAX) ? UINT16_MAX : dropped - trace_dropped;
+		trace_dropped = dropped;
+		block.CyclesPerUs = PIOS_TRACE_CyclesPeruS();
+
+		if (now - last_record_time > UINT8_MAX || now - last_sync_time >= LOG_COMPACT_SYNC_MS)
+			writeCompactTime(now);
+
+		record_buffer[0] = LOG_COMPACT_TRACE;
+		record_buffer[1] = now - last_record_time;
+		memcpy(&record_buffer[2], &block, sizeof(block));
+		send_data(record_buffer, length);
+
+		last_record_time = now;
 	}
 }
 
+DONT_BUILD_IF(2 + sizeof(TraceBlockData) > sizeof(record_buffer), TraceRecordSize);
+DONT_BUILD_IF((int)PIOS_TRACE_MARK != (int)TRACEBLOCK_EVENT_MARK, TraceEventOptions);
+#endif /* PIOS_INCLUDE_TRACE */
+
+/**
+ * Write an absolute timestamp record to the compact log
+ * \param[in] time System time in ms
+ */
+static void writeCompactTime(uint32_t time)
+{
+	uint8_t record[5] = {
+		LOG_COMPACT_TIME,
+		time & 0xFF, (time >> 8) & 0xFF, (time >> 16) & 0xFF, time >> 24,
+	};
+
+	send_data(record, sizeof(record));
+
+	last_record_time = time;
+	last_sync_time = time;
+}
+
 /**
  * Forward data from UAVTalk out the serial port
  * \param[in] data Data buffer to send
@@ -390,18 +834,28 @@ static int32_t send_data(uint8_t *data, int32_t length)
 }
 
 /**
- * @brief Callback for adding an object to the logging queue
- * @param ev the event
+ * Reserve room for a packet directly in the log output buffer
+ * \param[in] length Length of the packet
+ * \return pointer to the reserved room or NULL to use send_data()
  */
-static void obj_updated_callback(UAVObjEvent * ev)
+static uint8_t * reserve_data(uint16_t length)
 {
-	if (loggingData.Operation != LOGGINGSTATS_OPERATION_LOGGING){
-		// We are not logging, so all events are discarded
-		return;
-	}
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	PIOS_Queue_Send(logging_queue, ev, 0);
-	PIOS_Recursive_Mutex_Unlock(mutex);
+	return PIOS_COM_ReserveTx(logging_com_id, length);
+}
+
+/**
+ * Write a packet that was built in the room returned by reserve_data()
+ * \param[in] length Length of the packet, zero to drop it
+ * \return number of bytes written
+ */
+static int32_t commit_data(uint16_t length)
+{
+	int32_t rc = PIOS_COM_CommitTx(logging_com_id, length);
+
+	if (rc > 0)
+		written_bytes += rc;
+
+	return rc;
 }
 
 /**
@@ -416,15 +870,78 @@ static void register_object(UAVObjHandle obj)
 		return;
 	}
 
-	if (meta_data.loggingUpdatePeriod == 0){
+	uint16_t period = meta_data.loggingUpdatePeriod;
+
+	// LoggingSettings can override the period from the metadata
+	uint32_t obj_id = UAVObjGetID(obj);
+	for (int i = 0; i < LOGGINGSETTINGS_OBJECTID_NUMELEM; i++) {
+		if (settings.ObjectID[i] != 0 && settings.ObjectID[i] == obj_id) {
+			period = settings.ObjectPeriod[i];
+			break;
+		}
+	}
+
+	if (period == 0){
+		UAVObjDisconnectQueue(obj, logging_queue);
 		return;
 	}
 
-	uint16_t interval = MAX(meta_data.loggingUpdatePeriod, LOGGING_PERIOD_MS);
-	UAVObjConnectCallbackThrottled(obj, obj_updated_callback, EV_UPDATED | EV_UNPACKED, interval);
+	uint16_t interval = MAX(period, LOGGING_PERIOD_MS);
+	// Objects updating faster than the log is written only keep their latest event queued
+	UAVObjConnectQueueCoalesced(obj, logging_queue, EV_UPDATED | EV_UNPACKED, interval);
 }
 
 
+/**
+ * Add the events of an object lost on the logging queue to the statistics,
+ * keeping the objects that lost the most sorted at the front
+ * \param[in] obj Object to check
+ */
+static void count_drops(UAVObjHandle obj)
+{
+	uint16_t dropped = UAVObjQueueDropped(obj, logging_queue);
+	if (dropped == 0)
+		return;
+
+	drops_total += dropped;
+
+	int i = LOGGINGSTATS_DROPPEDOBJECTEVENTS_NUMELEM;
+	while (i > 0 && drops_events[i - 1] < dropped) {
+		if (i < LOGGINGSTATS_DROPPEDOBJECTEVENTS_NUMELEM) {
+			drops_events[i] = drops_events[i - 1];
+			drops_id[i] = drops_id[i - 1];
+		}
+		i--;
+	}
+
+	if (i < LOGGINGSTATS_DROPPEDOBJECTEVENTS_NUMELEM) {
+		drops_events[i] = dropped;
+		drops_id[i] = UAVObjGetID(obj);
+	}
+}
+
+/**
+ * Update the dropped event counts in LoggingStats, only those fields are
+ * written so a request from the GCS is not overwritten
+ */
+static void update_drops(void)
+{
+	drops_total = 0;
+	memset(drops_id, 0, sizeof(drops_id));
+	memset(drops_events, 0, sizeof(drops_events));
+
+	UAVObjIterate(&count_drops);
+
+	LoggingStatsDroppedEventsSet(&drops_total);
+	LoggingStatsDroppedObjectIDSet(drops_id);
+	LoggingStatsDroppedObjectEventsSet(drops_events);
+
+#if defined(BLACKBOX_CAPTURE)
+	uint32_t dropped_frames = BlackboxDropped();
+	LoggingStatsDroppedFramesSet(&dropped_frames);
+#endif
+}
+
 /**
  * Write log file header
  * see firmwareinfotemplate.c
@@ -472,6 +989,37 @@ static void writeHeader()
 	}
 	tmp_str[pos++] = '\n';
 	send_data((uint8_t*)tmp_str, pos);
+
+	if (log_compact) {
+		// Short code table, records start with an absolute time
+		send_data((uint8_t *)LOG_COMPACT_MARKER, strlen(LOG_COMPACT_MARKER));
+		UAVObjIterate(&writeCompactEntry);
+#if defined(BLACKBOX_CAPTURE)
+		if (BlackboxEnabled()) {
+			uint8_t entry[8] = {
+				LOG_COMPACT_BLACKBOX,
+				BLACKBOXFRAME_OBJID & 0xFF, (BLACKBOXFRAME_OBJID >> 8) & 0xFF,
+				(BLACKBOXFRAME_OBJID >> 16) & 0xFF, BLACKBOXFRAME_OBJID >> 24,
+				sizeof(BlackboxFrameData) & 0xFF, sizeof(BlackboxFrameData) >> 8,
+				0,
+			};
+			send_data(entry, sizeof(entry));
+		}
+#endif
+#if defined(PIOS_INCLUDE_TRACE)
+		if (trace_enabled) {
+			uint8_t entry[8] = {
+				LOG_COMPACT_TRACE,
+				TRACEBLOCK_OBJID & 0xFF, (TRACEBLOCK_OBJID >> 8) & 0xFF,
+				(TRACEBLOCK_OBJID >> 16) & 0xFF, TRACEBLOCK_OBJID >> 24,
+				sizeof(TraceBlockData) & 0xFF, sizeof(TraceBlockData) >> 8,
+				0,
+			};
+			send_data(entry, sizeof(entry));
+		}
+#endif
+		writeCompactTime(PIOS_Thread_Systime());
+	}
 }
 
 /**
@@ -99,6 +99,9 @@ uint8_t transmitter_control_get_flight_mode();
 //! Get any control events
 enum control_events transmitter_control_get_events();
 
+//! Get the semaphore the receiver of the sticks gives on each new frame, if any
+struct pios_semaphore *transmitter_control_get_semaphore();
+
 #endif /* TRANSMITTER_CONTROL_H */
 
 /**
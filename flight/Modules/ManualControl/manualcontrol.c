@@ -37,8 +37,10 @@
  */
 
 #include "openpilot.h"
+#include "latencymonitor.h"
 
 #include "pios_thread.h"
+#include "pios_semaphore.h"
 
 #include "control.h"
 #include "failsafe_control.h"
@@ -59,6 +61,7 @@
 #endif
 
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGHEST
+//! Also the longest wait for a receiver frame
 #define UPDATE_PERIOD_MS 20
 
 // Private variables
@@ -103,7 +106,7 @@ int32_t ManualControlInitialize()
 	return 0;
 }
 
-MODULE_INITCALL(ManualControlInitialize, ManualControlStart);
+MODULE_CRITICAL_INITCALL(ManualControlInitialize, ManualControlStart);
 
 /**
  * Module task
@@ -192,8 +195,23 @@ static void manualControlTask(void *parameters)
 			break;
 		}
 
-		// Wait until next update
-		PIOS_Thread_Sleep_Until(&lastSysTime, UPDATE_PERIOD_MS);
+#if defined(LATENCY_DIAGNOSTICS)
+		LatencyMonitorMarkInput(LATENCY_INPUT_COMMAND);
+#endif
+
+		// Wait until the receiver decoded the next frame, or the next update
+		// without one
+		struct pios_semaphore *frame_sema = transmitter_control_get_semaphore();
+		if (frame_sema != NULL) {
+			if (PIOS_Semaphore_Take(frame_sema, UPDATE_PERIOD_MS)) {
+#if defined(LATENCY_DIAGNOSTICS)
+				LatencyMonitorStartInput(PIOS_DELAY_GetRaw());
+#endif
+			}
+			lastSysTime = PIOS_Thread_Systime();
+		} else {
+			PIOS_Thread_Sleep_Until(&lastSysTime, UPDATE_PERIOD_MS);
+		}
 		PIOS_WDG_UpdateFlag(PIOS_WDG_MANUAL);
 	}
 }
@@ -74,6 +74,19 @@ struct rcvr_activity_fsm {
 	uint8_t sample_count;
 };
 
+//! How a channel is read and scaled, resolved once when the settings change
+struct channel_scaling {
+	uintptr_t rcvr_id;
+	uint8_t number;
+	bool assigned;
+	int16_t neutral;
+	int8_t max_side;        //!< 1 if max is above neutral, -1 if below, 0 if it equals min
+	float max_gain;         //!< per us on the side of max, 0 if max is neutral
+	float min_gain;         //!< per us on the side of min, 0 if min is neutral
+	int32_t valid_low;      //!< Range of connected values in us
+	int32_t valid_high;
+};
+
 
 // Private variables
 static ManualControlCommandData   cmd;
@@ -86,6 +99,9 @@ static uint32_t               lastSysTime;
 static float                      flight_mode_value;
 static enum control_events        pending_control_event;
 static bool                       settings_updated;
+static struct channel_scaling     channel_scaling[MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM];
+static StabilizationSettingsData  stabilization_settings;
+static bool                       stabilization_settings_updated;
 
 // Private functions
 static void update_actuator_desired(ManualControlCommandData * cmd);
@@ -94,13 +110,14 @@ static void altitude_hold_desired(ManualControlCommandData * cmd, bool flightMod
 static void set_flight_mode();
 static void process_transmitter_events(ManualControlCommandData * cmd, ManualControlSettingsData * settings, bool valid);
 static void set_manual_control_error(SystemAlarmsManualControlOptions errorCode);
-static float scaleChannel(int16_t value, int16_t max, int16_t min, int16_t neutral);
+static void compile_channel_scaling(const ManualControlSettingsData * settings);
+static float scaleChannel(const struct channel_scaling *scaling, int16_t value);
 static uint32_t timeDifferenceMs(uint32_t start_time, uint32_t end_time);
-static bool validInputRange(int16_t min, int16_t max, uint16_t value, uint16_t offset);
 static void applyDeadband(float *value, float deadband);
 static void resetRcvrActivity(struct rcvr_activity_fsm * fsm);
 static bool updateRcvrActivity(struct rcvr_activity_fsm * fsm);
 static void manual_control_settings_updated(UAVObjEvent * ev);
+static void stabilization_settings_updated_cb(UAVObjEvent * ev);
 static void set_loiter_command(ManualControlCommandData * cmd);
 
 // Exposed from manualcontrol to prevent attempts to arm when unsafe
@@ -118,6 +135,7 @@ int32_t transmitter_control_initialize()
 	StabilizationDesiredInitialize();
 	ReceiverActivityInitialize();
 	ManualControlSettingsInitialize();
+	StabilizationSettingsInitialize();
 
 	// Both the gimbal and coptercontrol do not support loitering
 #if !defined(SMALLF1) && !defined(GIMBAL)
@@ -137,8 +155,12 @@ int32_t transmitter_control_initialize()
 	resetRcvrActivity(&activity_fsm);
 
 	// Use callback to update the settings when they change
-	ManualControlSettingsConnectCallback(manual_control_settings_updated);
+	UAVObjConnectCallbackPriority(ManualControlSettingsHandle(), manual_control_settings_updated,
+			EV_MASK_ALL_UPDATES, 0, EV_PRIORITY_HIGH);
 	manual_control_settings_updated(NULL);
+	UAVObjConnectCallbackPriority(StabilizationSettingsHandle(), stabilization_settings_updated_cb,
+			EV_MASK_ALL_UPDATES, 0, EV_PRIORITY_HIGH);
+	stabilization_settings_updated_cb(NULL);
 
 	// Main task loop
 	lastSysTime = PIOS_Thread_Systime();
@@ -163,6 +185,12 @@ int32_t transmitter_control_update()
 	if (settings_updated) {
 		settings_updated = false;
 		ManualControlSettingsGet(&settings);
+		compile_channel_scaling(&settings);
+	}
+
+	if (stabilization_settings_updated) {
+		stabilization_settings_updated = false;
+		StabilizationSettingsGet(&stabilization_settings);
 	}
 
 	/* Update channel activity monitor */
@@ -241,14 +269,13 @@ int32_t transmitter_control_update()
 	for (uint8_t n = 0; 
 	     n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM && n < MANUALCONTROLCOMMAND_CHANNEL_NUMELEM;
 	     ++n) {
-		extern uintptr_t pios_rcvr_group_map[];
+		const struct channel_scaling *scaling = &channel_scaling[n];
 
-		if (settings.ChannelGroups[n] >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE) {
+		if (!scaling->assigned) {
 			cmd.Channel[n] = PIOS_RCVR_INVALID;
 			validChannel[n] = false;
 		} else {
-			cmd.Channel[n] = PIOS_RCVR_Read(pios_rcvr_group_map[settings.ChannelGroups[n]],
-							settings.ChannelNumber[n]);
+			cmd.Channel[n] = PIOS_RCVR_Read(scaling->rcvr_id, scaling->number);
 		}
 
 		// If a channel has timed out this is not valid data and we shouldn't update anything
@@ -257,8 +284,8 @@ int32_t transmitter_control_update()
 			valid_input_detected = false;
 			validChannel[n] = false;
 		} else {
-			scaledChannel[n] = scaleChannel(cmd.Channel[n], settings.ChannelMax[n],	settings.ChannelMin[n], settings.ChannelNeutral[n]);
-			validChannel[n] = validInputRange(settings.ChannelMin[n], settings.ChannelMax[n], cmd.Channel[n], CONNECTION_OFFSET);
+			scaledChannel[n] = scaleChannel(scaling, cmd.Channel[n]);
+			validChannel[n] = cmd.Channel[n] >= scaling->valid_low && cmd.Channel[n] <= scaling->valid_high;
 		}
 	}
 
@@ -462,6 +489,23 @@ enum control_events transmitter_control_get_events()
 	return to_return;
 }
 
+/**
+ * Serial receivers signal each decoded frame, so the sticks are read as soon
+ * as they change. Only the receiver of the throttle is waited for, the other
+ * channels are read along with it.
+ */
+struct pios_semaphore *transmitter_control_get_semaphore()
+{
+	extern uintptr_t pios_rcvr_group_map[];
+
+	uint8_t group = settings.ChannelGroups[MANUALCONTROLSETTINGS_CHANNELGROUPS_THROTTLE];
+	if (group >= MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE)
+		return NULL;
+
+	return PIOS_RCVR_GetSemaphore(pios_rcvr_group_map[group],
+			settings.ChannelNumber[MANUALCONTROLSETTINGS_CHANNELGROUPS_THROTTLE]);
+}
+
 //! Determine which of N positions the flight mode switch is in but do not set it
 uint8_t transmitter_control_get_flight_mode()
 {
@@ -905,8 +949,7 @@ static void update_stabilization_desired(ManualControlCommandData * cmd, ManualC
 	StabilizationDesiredData stabilization;
 	StabilizationDesiredGet(&stabilization);
 
-	StabilizationSettingsData stabSettings;
-	StabilizationSettingsGet(&stabSettings);
+	const StabilizationSettingsData *stabSettings = &stabilization_settings;
 
 	const uint8_t RATE_SETTINGS[3] = {  STABILIZATIONDESIRED_STABILIZATIONMODE_RATE,
 	                                    STABILIZATIONDESIRED_STABILIZATIONMODE_RATE,
@@ -985,41 +1028,41 @@ static void update_stabilization_desired(ManualControlCommandData * cmd, ManualC
 	stabilization.StabilizationMode[STABILIZATIONDESIRED_STABILIZATIONMODE_YAW]   = stab_settings[2];
 
 	stabilization.Roll = (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_NONE) ? cmd->Roll :
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? expo3(cmd->Roll, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_ROLL] :
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS) ? expo3(cmd->Roll, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) :
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? expo3(cmd->Roll, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_ROLL]:
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? expo3(cmd->Roll, stabSettings.AttitudeExpo[STABILIZATIONSETTINGS_ATTITUDEEXPO_ROLL]) * stabSettings.RollMax :
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? expo3(cmd->Roll, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_ROLL] :
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? expo3(cmd->Roll, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_ROLL] :
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS) ? expo3(cmd->Roll, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) :
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? expo3(cmd->Roll, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_ROLL]:
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? expo3(cmd->Roll, stabSettings->AttitudeExpo[STABILIZATIONSETTINGS_ATTITUDEEXPO_ROLL]) * stabSettings->RollMax :
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? expo3(cmd->Roll, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_ROLL] :
 	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR) ? cmd->Roll :
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) ? expo3(cmd->Roll, stabSettings.HorizonExpo[STABILIZATIONSETTINGS_HORIZONEXPO_ROLL]) :
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE) ? expo3(cmd->Roll, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) :
-	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT) ? cmd->Roll * stabSettings.RollMax :
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) ? expo3(cmd->Roll, stabSettings->HorizonExpo[STABILIZATIONSETTINGS_HORIZONEXPO_ROLL]) :
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE) ? expo3(cmd->Roll, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_ROLL]) :
+	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT) ? cmd->Roll * stabSettings->RollMax :
 	     (stab_settings[0] == STABILIZATIONDESIRED_STABILIZATIONMODE_COORDINATEDFLIGHT) ? cmd->Roll :
 	     0; // this is an invalid mode
 
 	stabilization.Pitch = (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_NONE) ? cmd->Pitch :
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? expo3(cmd->Pitch, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_PITCH] :
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS) ? expo3(cmd->Pitch, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) :
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? expo3(cmd->Pitch, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_PITCH] :
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? expo3(cmd->Pitch, stabSettings.AttitudeExpo[STABILIZATIONSETTINGS_ATTITUDEEXPO_PITCH]) * stabSettings.PitchMax :
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? expo3(cmd->Pitch, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_PITCH] :
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? expo3(cmd->Pitch, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_PITCH] :
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS) ? expo3(cmd->Pitch, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) :
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? expo3(cmd->Pitch, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_PITCH] :
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? expo3(cmd->Pitch, stabSettings->AttitudeExpo[STABILIZATIONSETTINGS_ATTITUDEEXPO_PITCH]) * stabSettings->PitchMax :
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? expo3(cmd->Pitch, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_PITCH] :
 	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR) ? cmd->Pitch :
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) ? expo3(cmd->Pitch, stabSettings.HorizonExpo[STABILIZATIONSETTINGS_HORIZONEXPO_PITCH]):
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE) ? expo3(cmd->Pitch, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) :
-	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT) ? cmd->Pitch * stabSettings.PitchMax :
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) ? expo3(cmd->Pitch, stabSettings->HorizonExpo[STABILIZATIONSETTINGS_HORIZONEXPO_PITCH]):
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE) ? expo3(cmd->Pitch, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_PITCH]) :
+	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT) ? cmd->Pitch * stabSettings->PitchMax :
 	     (stab_settings[1] == STABILIZATIONDESIRED_STABILIZATIONMODE_COORDINATEDFLIGHT) ? cmd->Pitch :
 	     0; // this is an invalid mode
 
 	stabilization.Yaw = (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_NONE) ? cmd->Yaw :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? expo3(cmd->Yaw, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW] :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS) ? expo3(cmd->Yaw, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? expo3(cmd->Yaw, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW] :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? expo3(cmd->Yaw, stabSettings.AttitudeExpo[STABILIZATIONSETTINGS_ATTITUDEEXPO_YAW]) * stabSettings.YawMax :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? expo3(cmd->Yaw, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW] :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_RATE) ? expo3(cmd->Yaw, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW] :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS) ? expo3(cmd->Yaw, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) ? expo3(cmd->Yaw, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW] :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE) ? expo3(cmd->Yaw, stabSettings->AttitudeExpo[STABILIZATIONSETTINGS_ATTITUDEEXPO_YAW]) * stabSettings->YawMax :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK) ? expo3(cmd->Yaw, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW] :
 	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR) ? cmd->Yaw :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) ? expo3(cmd->Yaw, stabSettings.HorizonExpo[STABILIZATIONSETTINGS_HORIZONEXPO_YAW]) :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE) ? expo3(cmd->Yaw, stabSettings.RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) :
-	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT) ? cmd->Yaw * stabSettings.YawMax :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) ? expo3(cmd->Yaw, stabSettings->HorizonExpo[STABILIZATIONSETTINGS_HORIZONEXPO_YAW]) :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE) ? expo3(cmd->Yaw, stabSettings->RateExpo[STABILIZATIONSETTINGS_RATEEXPO_YAW]) :
+	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT) ? cmd->Yaw * stabSettings->YawMax :
 	     (stab_settings[2] == STABILIZATIONDESIRED_STABILIZATIONMODE_COORDINATEDFLIGHT) ? cmd->Yaw :
 	     0; // this is an invalid mode
 
@@ -1046,12 +1089,11 @@ static void altitude_hold_desired(ManualControlCommandData * cmd, bool flightMod
 	AltitudeHoldDesiredData altitudeHoldDesired;
 	AltitudeHoldDesiredGet(&altitudeHoldDesired);
 
-	StabilizationSettingsData stabSettings;
-	StabilizationSettingsGet(&stabSettings);
+	const StabilizationSettingsData *stabSettings = &stabilization_settings;
 
-	altitudeHoldDesired.Roll = cmd->Roll * stabSettings.RollMax;
-	altitudeHoldDesired.Pitch = cmd->Pitch * stabSettings.PitchMax;
-	altitudeHoldDesired.Yaw = cmd->Yaw * stabSettings.ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW];
+	altitudeHoldDesired.Roll = cmd->Roll * stabSettings->RollMax;
+	altitudeHoldDesired.Pitch = cmd->Pitch * stabSettings->PitchMax;
+	altitudeHoldDesired.Yaw = cmd->Yaw * stabSettings->ManualRate[STABILIZATIONSETTINGS_MANUALRATE_YAW];
 	
 	float current_down;
 	PositionActualDownGet(&current_down);
@@ -1138,28 +1180,48 @@ static void set_loiter_command(ManualControlCommandData *cmd)
 
 #endif /* !defined(SMALLF1) && !defined(GIMBAL) */
 
+/**
+ * Resolve the receiver, scaling and connected range of each channel, so an
+ * update needs no divisions and no lookups of the settings
+ */
+static void compile_channel_scaling(const ManualControlSettingsData * settings)
+{
+	extern uintptr_t pios_rcvr_group_map[];
+
+	for (uint8_t n = 0; n < MANUALCONTROLSETTINGS_CHANNELGROUPS_NUMELEM; n++) {
+		struct channel_scaling *scaling = &channel_scaling[n];
+		int16_t max = settings->ChannelMax[n];
+		int16_t min = settings->ChannelMin[n];
+		int16_t neutral = settings->ChannelNeutral[n];
+
+		scaling->assigned = settings->ChannelGroups[n] < MANUALCONTROLSETTINGS_CHANNELGROUPS_NONE;
+		scaling->rcvr_id = scaling->assigned ? pios_rcvr_group_map[settings->ChannelGroups[n]] : 0;
+		scaling->number = settings->ChannelNumber[n];
+
+		scaling->neutral = neutral;
+		scaling->max_side = (max > min) ? 1 : (min > max) ? -1 : 0;
+		scaling->max_gain = (max != neutral) ? 1.0f / (max - neutral) : 0;
+		scaling->min_gain = (min != neutral) ? 1.0f / (neutral - min) : 0;
+
+		// Allow a bit of calibration error or trim offset
+		scaling->valid_low = ((min < max) ? min : max) - CONNECTION_OFFSET;
+		scaling->valid_high = ((min < max) ? max : min) + CONNECTION_OFFSET;
+	}
+}
+
 /**
  * Convert channel from servo pulse duration (microseconds) to scaled -1/+1 range.
  */
-static float scaleChannel(int16_t value, int16_t max, int16_t min, int16_t neutral)
+static float scaleChannel(const struct channel_scaling *scaling, int16_t value)
 {
 	float valueScaled;
 
 	// Scale
-	if ((max > min && value >= neutral) || (min > max && value <= neutral))
-	{
-		if (max != neutral)
-			valueScaled = (float)(value - neutral) / (float)(max - neutral);
-		else
-			valueScaled = 0;
-	}
+	if ((scaling->max_side > 0 && value >= scaling->neutral) ||
+			(scaling->max_side < 0 && value <= scaling->neutral))
+		valueScaled = (value - scaling->neutral) * scaling->max_gain;
 	else
-	{
-		if (min != neutral)
-			valueScaled = (float)(value - neutral) / (float)(neutral - min);
-		else
-			valueScaled = 0;
-	}
+		valueScaled = (value - scaling->neutral) * scaling->min_gain;
 
 	// Bound
 	if (valueScaled >  1.0f) valueScaled =  1.0f;
@@ -1176,21 +1238,6 @@ static uint32_t timeDifferenceMs(uint32_t start_time, uint32_t end_time) {
 		return (uint32_t)PIOS_THREAD_TIMEOUT_MAX - start_time + end_time + 1;
 }
 
-/**
- * @brief Determine if the manual input value is within acceptable limits
- * @returns return TRUE if so, otherwise return FALSE
- */
-bool validInputRange(int16_t min, int16_t max, uint16_t value, uint16_t offset)
-{
-	if (min > max)
-	{
-		int16_t tmp = min;
-		min = max;
-		max = tmp;
-	}
-	return (value >= min - offset && value <= max + offset);
-}
-
 /**
  * @brief Apply deadband to Roll/Pitch/Yaw channels
  */
@@ -1218,6 +1265,12 @@ static void manual_control_settings_updated(UAVObjEvent * ev)
 	settings_updated = true;
 }
 
+//! Update the stabilization settings the sticks are scaled with
+static void stabilization_settings_updated_cb(UAVObjEvent * ev)
+{
+	stabilization_settings_updated = true;
+}
+
 /**
  * Set the error code and alarm state
  * @param[in] error code
@@ -33,6 +33,30 @@
 
 int32_t OveroSyncInitialize(void);
 
+/**
+ * In snapshot mode every SPI packet starts with a frame of the objects that
+ * changed since the last one. The header is followed by the objects, each an
+ * overosync_snapshot_object followed by its data, then the CRC32 of the
+ * header and the objects. A gap in the sequence numbers means frames were
+ * replaced before the overo read them.
+ */
+#define OVEROSYNC_SNAPSHOT_SYNC 0x46534C54	/* "TLSF" */
+
+struct overosync_snapshot_header {
+	uint32_t sync;
+	uint32_t sequence;
+	uint32_t timestamp;		/* ms */
+	uint16_t length;		/* bytes of objects after the header */
+	uint8_t num_objects;
+	uint8_t reserved;
+} __attribute__((packed));
+
+struct overosync_snapshot_object {
+	uint32_t obj_id;
+	uint16_t inst_id;
+	uint16_t size;			/* bytes of data after this */
+} __attribute__((packed));
+
 #endif /* OVEROSYNC_H */
 
 /**
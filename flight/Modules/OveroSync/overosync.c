@@ -31,16 +31,38 @@
 #include "openpilot.h"
 #include "modulesettings.h"
 #include "overosync.h"
+#include "overosyncsettings.h"
 #include "overosyncstats.h"
 #include "systemstats.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
+#include "accels.h"
+#include "actuatorcommand.h"
+#include "actuatordesired.h"
+#include "attitudeactual.h"
+#include "baroaltitude.h"
+#include "flightstatus.h"
+#include "gpsposition.h"
+#include "gyros.h"
+#include "magnetometer.h"
+#include "manualcontrolcommand.h"
+#include "positionactual.h"
+#include "stabilizationdesired.h"
+#include "velocityactual.h"
+
 // Private constants
 #define MAX_QUEUE_SIZE   200
 #define STACK_SIZE_BYTES 512
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 
+//! Size of an SPI packet of pios_overo, a snapshot has to fit in one
+#define SNAPSHOT_FRAME_SIZE 1024
+#define SNAPSHOT_MAX_OBJECTS 16
+
+//! Events taken from the queue at once in stream mode
+#define STREAM_BATCH_SIZE 8
+
 // Private types
 
 // Private variables
@@ -48,11 +70,23 @@ static struct pios_queue *queue;
 static UAVTalkConnection uavTalkCon;
 static struct pios_thread *overoSyncTaskHandle;
 static bool module_enabled;
+static uint8_t mode;
+static uint32_t snapshot_period_ms;
+
+//! The flight state mirrored in snapshot mode, and which of it changed
+static UAVObjHandle snapshot_objects[SNAPSHOT_MAX_OBJECTS];
+static volatile bool snapshot_changed[SNAPSHOT_MAX_OBJECTS];
+static uint8_t num_snapshot_objects;
 
 // Private functions
 static void    overoSyncTask(void *parameters);
+static void    stream_updates(void);
+static void    send_snapshots(void);
+static void    update_stats(void);
 static int32_t pack_data(uint8_t * data, int32_t length);
 static void    register_object(UAVObjHandle obj);
+static void    register_snapshot_object(UAVObjHandle obj);
+static void    snapshot_object_updated(UAVObjEvent * ev);
 static void    send_settings(UAVObjHandle obj);
 
 // External variables
@@ -65,6 +99,13 @@ struct overosync {
 	uint32_t failed_objects;
 	uint32_t received_objects;
 	bool     sending_settings;
+
+	uint32_t last_stats_time;
+	uint32_t second_count;
+	uint8_t  last_connected;
+
+	uint32_t snapshot_sequence;
+	uint8_t  snapshot_frame[SNAPSHOT_FRAME_SIZE];
 };
 
 struct overosync *overosync;
@@ -91,9 +132,22 @@ int32_t OveroSyncInitialize(void)
 	if (!module_enabled)
 		return -1;
 
-	// Create object queues
-	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
-	
+	OveroSyncSettingsInitialize();
+	OveroSyncSettingsModeGet(&mode);
+
+	uint16_t snapshot_rate;
+	OveroSyncSettingsSnapshotRateGet(&snapshot_rate);
+	snapshot_period_ms = snapshot_rate > 0 ? 1000 / snapshot_rate : 0;
+	if (snapshot_period_ms == 0)
+		snapshot_period_ms = 1;
+
+	// Create object queues, snapshots only look at the objects when they are sent
+	if (mode == OVEROSYNCSETTINGS_MODE_STREAM) {
+		queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
+		if (queue == NULL)
+			return -1;
+	}
+
 	OveroSyncStatsInitialize();
 
 	// Initialise UAVTalk
@@ -119,9 +173,28 @@ int32_t OveroSyncStart(void)
 		return -1;
 
 	overosync->sent_bytes = 0;
-
-	// Process all registered objects and connect queue for updates
-	UAVObjIterate(&register_object);
+	overosync->snapshot_sequence = 0;
+
+	if (mode == OVEROSYNCSETTINGS_MODE_SNAPSHOT) {
+		// The state a co-processor flies with, objects that are not
+		// built into this firmware are left out
+		register_snapshot_object(FlightStatusHandle());
+		register_snapshot_object(AttitudeActualHandle());
+		register_snapshot_object(GyrosHandle());
+		register_snapshot_object(AccelsHandle());
+		register_snapshot_object(MagnetometerHandle());
+		register_snapshot_object(BaroAltitudeHandle());
+		register_snapshot_object(GPSPositionHandle());
+		register_snapshot_object(PositionActualHandle());
+		register_snapshot_object(VelocityActualHandle());
+		register_snapshot_object(ManualControlCommandHandle());
+		register_snapshot_object(StabilizationDesiredHandle());
+		register_snapshot_object(ActuatorDesiredHandle());
+		register_snapshot_object(ActuatorCommandHandle());
+	} else {
+		// Process all registered objects and connect queue for updates
+		UAVObjIterate(&register_object);
+	}
 	
 	// Start telemetry tasks
 	overoSyncTaskHandle = PIOS_Thread_Create(overoSyncTask, "OveroSync", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
@@ -145,6 +218,35 @@ static void register_object(UAVObjHandle obj)
 	UAVObjConnectQueue(obj, queue, eventMask);
 }
 
+/**
+ * Add an object to the snapshots and track when it changes
+ * \param[in] obj Object to add, NULL if it isn't built into this firmware
+ */
+static void register_snapshot_object(UAVObjHandle obj)
+{
+	if (obj == NULL || num_snapshot_objects >= SNAPSHOT_MAX_OBJECTS)
+		return;
+
+	snapshot_objects[num_snapshot_objects] = obj;
+	snapshot_changed[num_snapshot_objects] = true;
+	num_snapshot_objects++;
+
+	UAVObjConnectCallback(obj, snapshot_object_updated, EV_UPDATED | EV_UPDATED_MANUAL | EV_UNPACKED);
+}
+
+/**
+ * Mark an object for the next snapshot, runs in the task that updated it
+ */
+static void snapshot_object_updated(UAVObjEvent * ev)
+{
+	for (uint8_t i = 0; i < num_snapshot_objects; i++) {
+		if (snapshot_objects[i] == ev->obj) {
+			snapshot_changed[i] = true;
+			return;
+		}
+	}
+}
+
 /**
  * Register a new object, adds object to local list and connects the queue depending on the object's
  * telemetry settings.
@@ -168,70 +270,159 @@ static void send_settings(UAVObjHandle obj)
  */
 static void overoSyncTask(void *parameters)
 {
-	UAVObjEvent ev;
-
 	// Kick off SPI transfers (once one is completed another will automatically transmit)
 	overosync->sent_objects = 0;
 	overosync->failed_objects = 0;
 	overosync->received_objects = 0;
-	
-	uint32_t lastUpdateTime = PIOS_Thread_Systime();
-	uint32_t updateTime;
 
-	bool initialized = false;
-	uint8_t last_connected = OVEROSYNCSTATS_CONNECTED_FALSE;
+	overosync->last_stats_time = PIOS_Thread_Systime();
+	overosync->second_count = 0;
+	overosync->last_connected = OVEROSYNCSTATS_CONNECTED_FALSE;
+
+	// For the first seconds do not send updates to allow the
+	// overo to boot.  Then enable it and act normally.
+	while (PIOS_Thread_Systime() < 5000) {
+		if (mode == OVEROSYNCSETTINGS_MODE_STREAM) {
+			UAVObjEvent ev;
+			PIOS_Queue_Receive(queue, &ev, 100);
+		} else {
+			PIOS_Thread_Sleep(100);
+		}
+	}
+	PIOS_OVERO_Enable(pios_overo_id);
+
+	if (mode == OVEROSYNCSETTINGS_MODE_SNAPSHOT)
+		send_snapshots();
+	else
+		stream_updates();
+}
+
+/**
+ * Send every update of every object through UAVTalk
+ */
+static void stream_updates(void)
+{
+	static UAVObjEvent ev[STREAM_BATCH_SIZE];
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
+		// Wait for queue messages, taking the ones that piled up at once
+		uint16_t num = PIOS_Queue_ReceiveMany(queue, ev, STREAM_BATCH_SIZE, PIOS_QUEUE_TIMEOUT_MAX);
 
-			// For the first seconds do not send updates to allow the
-			// overo to boot.  Then enable it and act normally.
-			if (!initialized && PIOS_Thread_Systime() < 5000) {
+		for (uint16_t i = 0; i < num; i++) {
+			// Process event.  This calls transmitData
+			UAVTalkSendObjectTimestamped(uavTalkCon, ev[i].obj, ev[i].instId, false, 0);
+		}
+
+		if (num > 0) {
+			update_stats();
+
+			// TODO: Check the receive buffer
+		}
+	}
+}
+
+/**
+ * Send a frame of the objects that changed at a fixed rate, so the overo
+ * gets a consistent view of the flight state however bursty the updates are
+ */
+static void send_snapshots(void)
+{
+	uint8_t *frame = overosync->snapshot_frame;
+	uint32_t last_time = PIOS_Thread_Systime();
+
+	while (1) {
+		PIOS_Thread_Sleep_Until(&last_time, snapshot_period_ms);
+
+		struct overosync_snapshot_header header = {
+			.sync = OVEROSYNC_SNAPSHOT_SYNC,
+			.sequence = overosync->snapshot_sequence++,
+			.timestamp = PIOS_Thread_Systime(),
+		};
+
+		uint32_t offset = sizeof(header);
+		for (uint8_t i = 0; i < num_snapshot_objects; i++) {
+			if (!snapshot_changed[i])
 				continue;
-			} else if (!initialized) {
-				initialized = true;
-				PIOS_OVERO_Enable(pios_overo_id);
-			}
 
-			// Process event.  This calls transmitData
-			UAVTalkSendObjectTimestamped(uavTalkCon, ev.obj, ev.instId, false, 0);
-			
-			updateTime = PIOS_Thread_Systime();
-			if(((uint32_t) (updateTime - lastUpdateTime)) > 1000) {
-				// Update stats.  This will trigger a local send event too
-				OveroSyncStatsData syncStats;
-				syncStats.Send = overosync->sent_bytes;
-				syncStats.Connected = syncStats.Send > 500 ? OVEROSYNCSTATS_CONNECTED_TRUE : OVEROSYNCSTATS_CONNECTED_FALSE;
-				syncStats.DroppedUpdates = overosync->failed_objects;
-				syncStats.Packets = PIOS_OVERO_GetPacketCount(pios_overo_id);
-				OveroSyncStatsSet(&syncStats);
-				overosync->failed_objects = 0;
-				overosync->sent_bytes = 0;
-				lastUpdateTime = updateTime;
-
-				// When first connected, send all the settings.  Right now this
-				// will fail since all the settings will overfill the buffer and
-				if (last_connected == OVEROSYNCSTATS_CONNECTED_FALSE &&
-					syncStats.Connected == OVEROSYNCSTATS_CONNECTED_TRUE) {
-					UAVObjIterate(&send_settings);
-				}
-
-				// Because the previous code only happens on connection and the
-				// remote logging program doesn't send the settings to the log
-				// when arming starts we send all settings every thirty seconds
-				static uint32_t second_count = 0;
-				if (second_count ++ > 30) {
-					UAVObjIterate(&send_settings);
-					second_count = 0;
-				}
-				last_connected = syncStats.Connected;
+			UAVObjHandle obj = snapshot_objects[i];
+			struct overosync_snapshot_object object = {
+				.obj_id = UAVObjGetID(obj),
+				.inst_id = 0,
+				.size = UAVObjGetNumBytes(obj),
+			};
+
+			// Leave room for the CRC, what doesn't fit goes in the next frame
+			if (offset + sizeof(object) + object.size + sizeof(uint32_t) > SNAPSHOT_FRAME_SIZE) {
+				overosync->failed_objects++;
+				continue;
 			}
 
-			// TODO: Check the receive buffer
+			// Cleared first, an update while it is copied is sent again
+			snapshot_changed[i] = false;
+			memcpy(frame + offset, &object, sizeof(object));
+			UAVObjGetInstanceData(obj, 0, frame + offset + sizeof(object));
+			offset += sizeof(object) + object.size;
+			header.num_objects++;
+		}
+
+		header.length = offset - sizeof(header);
+		memcpy(frame, &header, sizeof(header));
+
+		uint32_t crc = PIOS_CRC32_updateCRC(0, frame, offset);
+		memcpy(frame + offset, &crc, sizeof(crc));
+		offset += sizeof(crc);
+
+		if (PIOS_OVERO_SetFrame(pios_overo_id, frame, offset) == 0) {
+			overosync->sent_bytes += offset;
+			overosync->sent_objects += header.num_objects;
 		}
+
+		update_stats();
+	}
+}
+
+/**
+ * Update the stats once a second and send the settings when the overo
+ * connects and every thirty seconds after
+ */
+static void update_stats(void)
+{
+	uint32_t updateTime = PIOS_Thread_Systime();
+	if(((uint32_t) (updateTime - overosync->last_stats_time)) <= 1000)
+		return;
+
+	// Update stats.  This will trigger a local send event too
+	OveroSyncStatsData syncStats;
+	OveroSyncStatsGet(&syncStats);
+	syncStats.Send = overosync->sent_bytes;
+	syncStats.Connected = syncStats.Send > 500 ? OVEROSYNCSTATS_CONNECTED_TRUE : OVEROSYNCSTATS_CONNECTED_FALSE;
+	syncStats.DroppedUpdates = overosync->failed_objects;
+	syncStats.Packets = PIOS_OVERO_GetPacketCount(pios_overo_id);
+	OveroSyncStatsSet(&syncStats);
+	overosync->failed_objects = 0;
+	overosync->sent_bytes = 0;
+	overosync->last_stats_time = updateTime;
+
+	// Snapshots only carry the flight state
+	if (mode == OVEROSYNCSETTINGS_MODE_SNAPSHOT)
+		return;
+
+	// When first connected, send all the settings.  Right now this
+	// will fail since all the settings will overfill the buffer and
+	if (overosync->last_connected == OVEROSYNCSTATS_CONNECTED_FALSE &&
+		syncStats.Connected == OVEROSYNCSTATS_CONNECTED_TRUE) {
+		UAVObjIterate(&send_settings);
+	}
+
+	// Because the previous code only happens on connection and the
+	// remote logging program doesn't send the settings to the log
+	// when arming starts we send all settings every thirty seconds
+	if (overosync->second_count ++ > 30) {
+		UAVObjIterate(&send_settings);
+		overosync->second_count = 0;
 	}
+	overosync->last_connected = syncStats.Connected;
 }
 
 /**
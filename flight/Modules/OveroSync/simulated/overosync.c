@@ -40,6 +40,7 @@
 // Private constants
 #define OVEROSYNC_PACKET_SIZE 1024
 #define MAX_QUEUE_SIZE   40
+#define BATCH_SIZE       8
 #define STACK_SIZE_BYTES 512
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 
@@ -157,7 +158,7 @@ static void registerObject(UAVObjHandle obj)
  */
 static void overoSyncTask(void *parameters)
 {
-	UAVObjEvent ev;
+	UAVObjEvent ev[BATCH_SIZE];
 
 	// Kick off SPI transfers (once one is completed another will automatically transmit)
 	overosync->transaction_done = true;
@@ -172,16 +173,19 @@ static void overoSyncTask(void *parameters)
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-		
-			// Check it will fit before packetizing
-			if ((overosync->write_pointer + UAVObjGetNumBytes(ev.obj) + 12) >=
-				sizeof(overosync->transactions[overosync->loading_transaction_id].tx_buffer)) {
-				overosync->failed_objects ++;
-			} else {
-				// Process event.  This calls transmitData
-				UAVTalkSendObject(uavTalkCon, ev.obj, ev.instId, false, 0);
+		// Wait for queue messages, taking the ones that piled up at once
+		uint16_t num = PIOS_Queue_ReceiveMany(queue, ev, BATCH_SIZE, PIOS_QUEUE_TIMEOUT_MAX);
+
+		if (num > 0) {
+			for (uint16_t i = 0; i < num; i++) {
+				// Check it will fit before packetizing
+				if ((overosync->write_pointer + UAVObjGetNumBytes(ev[i].obj) + 12) >=
+					sizeof(overosync->transactions[overosync->loading_transaction_id].tx_buffer)) {
+					overosync->failed_objects ++;
+				} else {
+					// Process event.  This calls transmitData
+					UAVTalkSendObject(uavTalkCon, ev[i].obj, ev[i].instId, false, 0);
+				}
 			}
 
 			updateTime = PIOS_Thread_Systime();
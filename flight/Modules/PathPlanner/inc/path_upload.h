@@ -0,0 +1,40 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup PathPlannerModule Path Planner Module
+ * @{ 
+ *
+ * @file       path_upload.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Receives a whole path from the GCS in one transfer
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#ifndef PATH_UPLOAD_H
+#define PATH_UPLOAD_H
+
+//! Start listening for WaypointUpload transfers
+int32_t pathplanner_upload_initialize();
+
+#endif /* PATH_UPLOAD_H */
+
+/**
+ * @}
+ * @}
+ */
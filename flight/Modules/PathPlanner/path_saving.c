@@ -37,56 +37,122 @@ extern uintptr_t pios_waypoints_settings_fs_id;
 /* this code the object id is used to indicate the path id and the */
 /* instance id is the waypoint number                              */
 
-/**
- * Save the in memory waypoints to the waypoint filesystem
- * @param[in] id The path id to save as
- */
-int32_t pathplanner_save_path(uint32_t path_id)
-{
+//! Walks the waypoints of a path for PIOS_FLASHFS_ObjSaveBatch()
+struct path_save {
+	uint32_t path_id;
+	uint16_t next;		// next waypoint to save
+	bool ended;		// the end of path marker has been handed out
 	WaypointData waypoint;
+};
+
+//! Collects a path for PIOS_FLASHFS_ObjLoadAll()
+struct path_load {
+	uint32_t path_id;
+	uint16_t num_instances;	// instances the path can be loaded into
+	int32_t end;		// lowest index of an end of path marker, -1 if none
+	int32_t last;		// highest index of the path found, -1 if none
+	WaypointData waypoint;
+};
 
-	if (WaypointHandle() == 0)
-		return -30; // leave room for flashfs error codes
-
-	uint16_t num_waypoints = WaypointGetNumInstances();
-	uint32_t  waypoint_size = WaypointGetNumBytes();
-	int32_t  erase_retval  = 0;
-	int32_t  last_save_id  = -1;
-	int32_t  retval        = 0;
-
-	// Save all elements
-	for (int32_t i = 0; i < num_waypoints && retval == 0; i++) {
-		WaypointInstGet(i, &waypoint);
+static int32_t saveNext(void *ctx, struct pios_flashfs_obj *obj)
+{
+	struct path_save *save = (struct path_save *) ctx;
 
-		// Stop saving when get to invalid waypoint.  Nothing after or including is valid
-		if (waypoint.Mode == WAYPOINT_MODE_INVALID)
-			break;
+	if (save->ended)
+		return 0;
 
-		retval = PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, path_id, i, (uint8_t *) &waypoint, waypoint_size);
-		last_save_id = i; // Track the last valid waypoint id
+	// Stop saving when get to invalid waypoint.  Nothing after or including is valid
+	if (save->next < WaypointGetNumInstances()) {
+		WaypointInstGet(save->next, &save->waypoint);
+	} else {
+		memset(&save->waypoint, 0, sizeof(save->waypoint));
+		save->waypoint.Mode = WAYPOINT_MODE_INVALID;
 	}
 
 	// Use an explicit indication of the end of path
-	waypoint.Mode = WAYPOINT_MODE_INVALID;
-	retval = PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, path_id, ++last_save_id,
-	                              (uint8_t *) &waypoint, waypoint_size);
-
-	// Check for any waypoints after the saved end of the path and erase them
-	for (int32_t i = last_save_id + 1; erase_retval == 0; i++) {
-		erase_retval = PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, path_id, i, (uint8_t *) &waypoint, waypoint_size);
-		if (erase_retval == 0) {
-			PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, path_id, i);
-		}
+	if (save->waypoint.Mode == WAYPOINT_MODE_INVALID)
+		save->ended = true;
+
+	obj->obj_id = save->path_id;
+	obj->obj_inst_id = save->next++;
+	obj->obj_size = sizeof(save->waypoint);
+	obj->obj_data = (uint8_t *) &save->waypoint;
+
+	return 1;
+}
+
+static void loadBuffer(void *ctx, struct pios_flashfs_obj *obj)
+{
+	struct path_load *load = (struct path_load *) ctx;
+
+	if (obj->obj_id != load->path_id)
+		return;
+
+	if (obj->obj_inst_id > load->last)
+		load->last = obj->obj_inst_id;
+
+	if (obj->obj_size == sizeof(load->waypoint))
+		obj->obj_data = (uint8_t *) &load->waypoint;
+}
+
+static void loadDone(void *ctx, const struct pios_flashfs_obj *obj)
+{
+	struct path_load *load = (struct path_load *) ctx;
+
+	if (load->waypoint.Mode == WAYPOINT_MODE_INVALID) {
+		if (load->end < 0 || obj->obj_inst_id < load->end)
+			load->end = obj->obj_inst_id;
+	} else if (obj->obj_inst_id < load->num_instances) {
+		// Announced together once the whole path is in
+		UAVObjSetInstanceDataDeferred(WaypointHandle(), obj->obj_inst_id, &load->waypoint);
 	}
+}
 
-	return retval;
+/**
+ * Save the in memory waypoints to the waypoint filesystem. They are
+ * written in one batch, so the stored path is either the old or the new one.
+ * @param[in] id The path id to save as
+ */
+int32_t pathplanner_save_path(uint32_t path_id)
+{
+	if (WaypointHandle() == 0)
+		return -30; // leave room for flashfs error codes
+
+	struct path_save save = {
+		.path_id = path_id,
+		.next    = 0,
+		.ended   = false,
+	};
+
+	int32_t retval = PIOS_FLASHFS_ObjSaveBatch(pios_waypoints_settings_fs_id, saveNext, &save);
+	if (retval != 0)
+		return retval;
+
+	// Find any waypoints after the saved end of the path and erase them
+	struct path_load load = {
+		.path_id       = path_id,
+		.num_instances = 0,
+		.end           = -1,
+		.last          = -1,
+	};
+	retval = PIOS_FLASHFS_ObjLoadAll(pios_waypoints_settings_fs_id, loadBuffer, loadDone, &load);
+	if (retval < 0)
+		return retval;
+
+	for (int32_t i = save.next; i <= load.last; i++)
+		PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, path_id, i);
+
+	return 0;
 }
 
 /**
- * Load a path from the waypoint filesystem into memory
+ * Load a path from the waypoint filesystem into memory. All of it is read
+ * in one pass over the filesystem and the waypoints are announced with
+ * a single update once they are all in.
  * @param[in] id The path id to load
  * @return -30 waypoint object not registered
  * @return -31 could not allocate waypoint in ram
+ * @return -3 the path has no end or a waypoint of it is missing
  * @return other indicates FlashFS error
  */
 int32_t pathplanner_load_path(uint32_t path_id)
@@ -96,41 +162,71 @@ int32_t pathplanner_load_path(uint32_t path_id)
 	if (WaypointHandle() == 0)
 		return -30; // leave room for flashfs error codes
 
-	uint32_t  waypoint_size = WaypointGetNumBytes();
-	int32_t  retval = 0;
+	struct path_load load = {
+		.path_id = path_id,
+	};
+	int32_t retval;
+
+	do {
+		// Any waypoint the path doesn't fill is past its end
+		load.num_instances = WaypointGetNumInstances();
+		for (uint16_t i = 0; i < load.num_instances; i++) {
+			WaypointInstGet(i, &waypoint);
+			waypoint.Mode = WAYPOINT_MODE_INVALID;
+			UAVObjSetInstanceDataDeferred(WaypointHandle(), i, &waypoint);
+		}
+		load.end = -1;
+		load.last = -1;
+
+		retval = PIOS_FLASHFS_ObjLoadAll(pios_waypoints_settings_fs_id, loadBuffer, loadDone, &load);
+		if (retval < 0)
+			break;
+		retval = 0;
 
-	int32_t i;
+		// The instances are created outside of the filesystem pass, then
+		// read again. Only needed when the path is longer than any before.
+		if (load.end <= load.num_instances)
+			break;
 
-	for (i = 0; retval == 0; i++) {
-		retval = PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, path_id, i, (uint8_t *) &waypoint, waypoint_size);
-		if (retval == 0) {
+		while (WaypointGetNumInstances() < load.end && retval == 0) {
+			int32_t new_instance_id = WaypointCreateInstance();
+			if (new_instance_id != WaypointGetNumInstances() - 1)
+				retval = -31;
+		}
+	} while (retval == 0);
 
-			// Indicates end of path
-			if (waypoint.Mode == WAYPOINT_MODE_INVALID)
-				break;
+	// The path ends at the first waypoint it did not fill
+	uint16_t num_instances = WaypointGetNumInstances();
+	uint16_t i;
+	for (i = 0; i < num_instances; i++) {
+		WaypointInstGet(i, &waypoint);
+		if (waypoint.Mode == WAYPOINT_MODE_INVALID)
+			break;
+	}
 
-			// Loaded waypoint locally, store in UAVO manager
-			if (i >= WaypointGetNumInstances()) {
-				int32_t new_instance_id = WaypointCreateInstance();
-				if (new_instance_id != i) {
-					retval = -31;
-					break;
-				}
-			}
+	if (retval == 0 && i != load.end)
+		retval = -3;
 
-			WaypointInstSet(i, &waypoint);
-		}
+	// Drop the instances a longer path left behind, their storage is kept
+	// for the next path that needs them. Instance 0 always stays.
+	if (retval == 0) {
+		while (num_instances > load.end && num_instances > 1 &&
+				UAVObjDeleteInstance(WaypointHandle()) == 0)
+			num_instances--;
 	}
 
 	// Set any remaining waypoints to INVALID to indicate they should not be used
-	// at this point i will be the index of the first waypoint that could not be
-	// loaded from flash.
-	for (; i <  WaypointGetNumInstances(); i++) {
+	for (; i < num_instances; i++) {
 		WaypointInstGet(i, &waypoint);
-		waypoint.Mode = WAYPOINT_MODE_INVALID;
-		WaypointInstSet(i, &waypoint);
+		if (waypoint.Mode != WAYPOINT_MODE_INVALID) {
+			waypoint.Mode = WAYPOINT_MODE_INVALID;
+			UAVObjSetInstanceDataDeferred(WaypointHandle(), i, &waypoint);
+		}
 	}
 
+	// One update for the whole path
+	UAVObjInstanceUpdated(WaypointHandle(), UAVOBJ_ALL_INSTANCES);
+
 	return retval;
 }
 
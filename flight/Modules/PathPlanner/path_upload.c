@@ -0,0 +1,214 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup PathPlannerModule Path Planner Module
+ * @{
+ *
+ * @file       path_upload.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Receives a whole path from the GCS in one transfer
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/* The GCS sends Begin with the number of waypoints, then Data chunks of up */
+/* to four waypoints without waiting for acks, then Commit with the CRC of  */
+/* them all. The chunks in flight use instances of their own, so none is    */
+/* overwritten before it is read. A chunk is only taken if it continues     */
+/* where the last one ended, WaypointUploadStatus.Received tells the GCS    */
+/* where to go on from. The waypoints are staged on flash as a path of      */
+/* their own, so the Waypoint instances only change once the whole path     */
+/* arrived intact.                                                          */
+
+#include "pios.h"
+#include "openpilot.h"
+#include "pios_flashfs.h"
+#include "path_saving.h"
+#include "path_upload.h"
+
+#include "waypoint.h"
+#include "waypointupload.h"
+#include "waypointuploadstatus.h"
+
+extern uintptr_t pios_waypoints_settings_fs_id;
+
+//! Path id the waypoints are received into, clear of the slots the GCS saves to
+#define STAGING_PATH_ID 0x00575000
+
+//! Like the flash operations of PathPlannerSettings
+#define MAX_SLOT 5
+
+// Private variables
+static WaypointUploadStatusData status;
+static uint32_t crc;
+static uint16_t count;
+static uint8_t slot;
+
+// Private functions
+static void uploadUpdated(UAVObjEvent * ev);
+static void receiveChunk(const WaypointUploadData *upload);
+static void commit(const WaypointUploadData *upload);
+static void fail(uint8_t error);
+
+/**
+ * Listen for transfers from the GCS
+ */
+int32_t pathplanner_upload_initialize()
+{
+	if (WaypointUploadInitialize() != 0 || WaypointUploadStatusInitialize() != 0)
+		return -1;
+
+	WaypointUploadStatusGet(&status);
+
+	// Only what the GCS sends, the status is what goes back
+	return UAVObjConnectCallback(WaypointUploadHandle(), uploadUpdated, EV_UNPACKED);
+}
+
+static void uploadUpdated(UAVObjEvent * ev)
+{
+	WaypointUploadData upload;
+	WaypointUploadInstGet(ev->instId, &upload);
+
+	if (upload.Command == WAYPOINTUPLOAD_COMMAND_BEGIN) {
+		status.Transfer = upload.Transfer;
+		status.State = WAYPOINTUPLOADSTATUS_STATE_RECEIVING;
+		status.Error = WAYPOINTUPLOADSTATUS_ERROR_NONE;
+		status.Received = 0;
+
+		count = upload.Count;
+		slot = upload.Slot;
+		crc = 0;
+
+		WaypointUploadStatusSet(&status);
+		return;
+	}
+
+	// Late packets of an earlier transfer
+	if (upload.Transfer != status.Transfer)
+		return;
+
+	switch (upload.Command) {
+	case WAYPOINTUPLOAD_COMMAND_DATA:
+		if (status.State == WAYPOINTUPLOADSTATUS_STATE_RECEIVING)
+			receiveChunk(&upload);
+
+		// Even chunks that were not taken get an answer, else the GCS
+		// waits for the timeout to go back
+		WaypointUploadStatusSet(&status);
+		break;
+	case WAYPOINTUPLOAD_COMMAND_COMMIT:
+		if (status.State == WAYPOINTUPLOADSTATUS_STATE_RECEIVING)
+			commit(&upload);
+
+		// Answer again, the GCS may have missed the first one
+		WaypointUploadStatusSet(&status);
+		break;
+	case WAYPOINTUPLOAD_COMMAND_ABORT:
+		status.State = WAYPOINTUPLOADSTATUS_STATE_IDLE;
+		WaypointUploadStatusSet(&status);
+		break;
+	}
+}
+
+/**
+ * Stage the waypoints of a chunk if it is the next one
+ */
+static void receiveChunk(const WaypointUploadData *upload)
+{
+	if (upload->Sequence != status.Received || upload->Count == 0 ||
+			upload->Count > WAYPOINTUPLOAD_MODE_NUMELEM)
+		return;
+
+	if (status.Received + upload->Count > count) {
+		fail(WAYPOINTUPLOADSTATUS_ERROR_SIZE);
+		return;
+	}
+
+	for (uint16_t i = 0; i < upload->Count; i++) {
+		// The CRC covers the waypoints as the GCS packed them
+		crc = PIOS_CRC32_updateCRC(crc, (const uint8_t *) &upload->North[i], sizeof(float));
+		crc = PIOS_CRC32_updateCRC(crc, (const uint8_t *) &upload->East[i], sizeof(float));
+		crc = PIOS_CRC32_updateCRC(crc, (const uint8_t *) &upload->Down[i], sizeof(float));
+		crc = PIOS_CRC32_updateCRC(crc, (const uint8_t *) &upload->Velocity[i], sizeof(float));
+		crc = PIOS_CRC32_updateCRC(crc, (const uint8_t *) &upload->ModeParameters[i], sizeof(float));
+		crc = PIOS_CRC32_updateCRC(crc, &upload->Mode[i], 1);
+
+		WaypointData waypoint = {
+			.Position = {upload->North[i], upload->East[i], upload->Down[i]},
+			.Velocity = upload->Velocity[i],
+			.Mode = upload->Mode[i],
+			.ModeParameters = upload->ModeParameters[i],
+		};
+
+		if (PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, STAGING_PATH_ID,
+				status.Received + i, (uint8_t *) &waypoint, WaypointGetNumBytes()) != 0) {
+			fail(WAYPOINTUPLOADSTATUS_ERROR_FLASH);
+			return;
+		}
+	}
+
+	status.Received += upload->Count;
+}
+
+/**
+ * Swap the staged path in for the Waypoint instances, all at once
+ */
+static void commit(const WaypointUploadData *upload)
+{
+	if (status.Received != count) {
+		fail(WAYPOINTUPLOADSTATUS_ERROR_SIZE);
+		return;
+	}
+
+	if (upload->Crc != crc) {
+		fail(WAYPOINTUPLOADSTATUS_ERROR_CRC);
+		return;
+	}
+
+	// The end of the path, anything staged after it is from a longer one
+	WaypointData waypoint;
+	memset(&waypoint, 0, sizeof(waypoint));
+	waypoint.Mode = WAYPOINT_MODE_INVALID;
+	if (PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, STAGING_PATH_ID,
+			count, (uint8_t *) &waypoint, WaypointGetNumBytes()) != 0) {
+		fail(WAYPOINTUPLOADSTATUS_ERROR_FLASH);
+		return;
+	}
+
+	if (pathplanner_load_path(STAGING_PATH_ID) != 0) {
+		fail(WAYPOINTUPLOADSTATUS_ERROR_FLASH);
+		return;
+	}
+
+	if (slot != 0 && slot <= MAX_SLOT && pathplanner_save_path(slot) != 0) {
+		fail(WAYPOINTUPLOADSTATUS_ERROR_FLASH);
+		return;
+	}
+
+	status.State = WAYPOINTUPLOADSTATUS_STATE_COMMITTED;
+}
+
+static void fail(uint8_t error)
+{
+	status.State = WAYPOINTUPLOADSTATUS_STATE_FAILED;
+	status.Error = error;
+}
+
+/**
+ * @}
+ * @}
+ */
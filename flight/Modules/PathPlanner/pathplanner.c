@@ -29,9 +29,11 @@
 #include "physical_constants.h"
 #include "paths.h"
 #include "path_saving.h"
+#include "path_upload.h"
 
 #include "flightstatus.h"
 #include "pathdesired.h"
+#include "pathlookahead.h"
 #include "pathplannersettings.h"
 #include "pathstatus.h"
 #include "positionactual.h"
@@ -60,6 +62,7 @@ static bool path_completed;
 // Private functions
 static void advanceWaypoint();
 static void activateWaypoint(int idx);
+static void publishLookahead(int idx);
 
 static void pathPlannerTask(void *parameters);
 static void settingsUpdated(UAVObjEvent * ev);
@@ -114,6 +117,10 @@ int32_t PathPlannerInitialize()
 		PathPlannerSettingsInitialize();
 		WaypointInitialize();
 		WaypointActiveInitialize();
+		PathLookaheadInitialize();
+
+		if (pathplanner_upload_initialize() != 0)
+			return -1;
 
 		// Create object queue
 		queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
@@ -406,6 +413,9 @@ static void activateWaypoint(int idx)
 		pathDesired.StartingVelocity = waypointPrev.Velocity;
 	}
 
+	// Before the segment itself, so the follower has both when it plans
+	publishLookahead(idx);
+
 	PathDesiredSet(&pathDesired);
 
 	// Invalidate any pending path status updates
@@ -414,6 +424,40 @@ static void activateWaypoint(int idx)
 	AlarmsClear(SYSTEMALARMS_ALARM_PATHPLANNER);
 }
 
+/**
+ * Tell the follower about the straight segments after a straight waypoint, so
+ * it can fly through the corners between them instead of stopping at each
+ */
+static void publishLookahead(int idx)
+{
+	PathLookaheadData lookahead;
+	memset(&lookahead, 0, sizeof(lookahead));
+	lookahead.Waypoint = idx;
+	lookahead.Truncated = PATHLOOKAHEAD_TRUNCATED_FALSE;
+
+	if (waypoint.Mode == WAYPOINT_MODE_VECTOR) {
+		for (int next = idx + 1; waypointValid(next); next++) {
+			WaypointData waypointNext;
+			WaypointInstGet(next, &waypointNext);
+
+			if (waypointNext.Mode != WAYPOINT_MODE_VECTOR)
+				break;
+
+			if (lookahead.Count == PATHLOOKAHEAD_NORTH_NUMELEM) {
+				lookahead.Truncated = PATHLOOKAHEAD_TRUNCATED_TRUE;
+				break;
+			}
+
+			lookahead.North[lookahead.Count] = waypointNext.Position[WAYPOINT_POSITION_NORTH];
+			lookahead.East[lookahead.Count] = waypointNext.Position[WAYPOINT_POSITION_EAST];
+			lookahead.Velocity[lookahead.Count] = waypointNext.Velocity;
+			lookahead.Count++;
+		}
+	}
+
+	PathLookaheadSet(&lookahead);
+}
+
 void settingsUpdated(UAVObjEvent * ev) {
 	uint8_t preprogrammedPath = pathPlannerSettings.PreprogrammedPath;
 	int32_t retval = 0;
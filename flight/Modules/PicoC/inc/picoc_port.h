@@ -62,6 +62,19 @@ void PlatformFree(void *ptr);
 size_t PlatformHeapSize();
 void PlatformDebug(const char *format, ...);
 int picoc(const char *source, size_t stack_size);
+int picoc_compile(const char *source, size_t stack_size, int32_t (*save)(const uint8_t *blob, uint32_t blob_size));
+int picoc_run_compiled(const uint8_t *blob, uint32_t blob_size, size_t stack_size);
+
+/* a compiled script starts with this header, the tokens follow it */
+#define PICOC_COMPILED_MAGIC 0x31544350		/* "PCT1" */
+struct picoc_compiled_header {
+	uint32_t magic;
+	uint32_t size;			/* bytes of tokens after the header */
+	uint8_t last_token;		/* TokenEndOfFunction of the compiler */
+	uint8_t long_size;
+	uint8_t fp_size;
+	uint8_t reserved;
+};
 
 /* get all picoc definitions */
 #include "picoc.h"
@@ -40,6 +40,7 @@
 #include "flightstatus.h"
 #include "modulesettings.h"
 #include "pios_thread.h"
+#include "misc_math.h"
 
 // Global variables
 extern uintptr_t pios_waypoints_settings_fs_id;	/* use the waypoint filesystem */
@@ -52,6 +53,7 @@ extern struct flashfs_logfs_cfg flashfs_waypoints_cfg;
 #define PICOC_STACKSIZE_MIN		(10*1024)
 #define PICOC_STACKSIZE_MAX		(128*1024)
 #define PICOC_SOURCE_FILE_TYPE	0X00704300		/* mark picoc sources with this ID */
+#define PICOC_COMPILED_FILE_TYPE	0X00704400		/* mark compiled picoc scripts with this ID */
 #define PICOC_SECTOR_SIZE		48				/* size of filesystem object (less than slot_size - sizeof(slot_header) */
 #define SOH	0x01	/* (^A) start of heading */
 #define STX	0x02	/* (^B) start of text */
@@ -67,6 +69,8 @@ static char *sourcebuffer;
 static uint32_t sourcebuffer_size;
 static PicoCSettingsData picocsettings;
 static PicoCStatusData picocstatus;
+static uint32_t compiled_size;		/* size of the compiled script in the source buffer, 0 for a source */
+static uint32_t compiled_file_id;
 
 // Private functions
 static void picocTask(void *parameters);
@@ -77,6 +81,9 @@ int32_t set_sector(uint16_t sector, char *buffer, uint32_t buffer_size);
 int32_t load_file(uint8_t file, char *buffer, uint32_t buffer_size);
 int32_t save_file(uint8_t file, char *buffer, uint32_t buffer_size);
 int32_t delete_file(uint8_t file);
+int32_t compile_file(uint8_t file, char *buffer, uint32_t buffer_size);
+int32_t load_compiled(uint8_t file, char *buffer, uint32_t buffer_size, uint32_t *size);
+static int32_t save_compiled(const uint8_t *blob, uint32_t blob_size);
 int32_t format_partition();
 
 /**
@@ -141,7 +148,7 @@ static int32_t picocInitialize(void)
 	}
 	return 0;
 }
-MODULE_INITCALL( picocInitialize, picocStart)
+MODULE_DEFERRED_INITCALL( picocInitialize, picocStart)
 
 /**
  * Main task. It does not return.
@@ -163,7 +170,11 @@ static void picocTask(void *parameters) {
 
 	// load boot file from flash
 	PicoCSettingsGet(&picocsettings);
-	picocstatus.CommandError = load_file(picocsettings.BootFileID, sourcebuffer, sourcebuffer_size);
+	if ((picocsettings.Source != PICOCSETTINGS_SOURCE_COMPILEDFILE) ||
+		(load_compiled(picocsettings.BootFileID, sourcebuffer, sourcebuffer_size, &compiled_size) != 0)) {
+		// no compiled script, fall back to the source
+		picocstatus.CommandError = load_file(picocsettings.BootFileID, sourcebuffer, sourcebuffer_size);
+	}
 	PicoCStatusCommandErrorSet(&picocstatus.CommandError);
 
 	while (1) {
@@ -178,7 +189,11 @@ static void picocTask(void *parameters) {
 				// external start request
 				picocstatus.ExitValue = 0;
 				PicoCStatusExitValueSet(&picocstatus.ExitValue);
-				picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
+				if (compiled_size) {
+					picocstatus.ExitValue = picoc_run_compiled((uint8_t *)sourcebuffer, compiled_size, picocsettings.PicoCStackSize);
+				} else {
+					picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
+				}
 				PicoCStatusExitValueSet(&picocstatus.ExitValue);
 				picocstatus.CommandError = 0;
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
@@ -186,6 +201,7 @@ static void picocTask(void *parameters) {
 				break;
 			case PICOCSTATUS_COMMAND_USARTMODE:
 				// handle commands via USART
+				compiled_size = 0;
 				picocstatus.CommandError = usart_cmd(sourcebuffer, sourcebuffer_size);
 				if (picocstatus.CommandError) {
 					picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
@@ -199,11 +215,13 @@ static void picocTask(void *parameters) {
 				break;
 			case PICOCSTATUS_COMMAND_SETSECTOR:
 				// fill buffer from uavo to selected sector
+				compiled_size = 0;
 				picocstatus.CommandError = set_sector(picocstatus.SectorID, sourcebuffer, sourcebuffer_size);
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
 				break;
 			case PICOCSTATUS_COMMAND_LOADFILE:
 				// fill buffer from flash file
+				compiled_size = 0;
 				picocstatus.CommandError = load_file(picocstatus.FileID, sourcebuffer, sourcebuffer_size);
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
 				break;
@@ -222,6 +240,11 @@ static void picocTask(void *parameters) {
 				picocstatus.CommandError = format_partition();
 				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
 				break;
+			case PICOCSTATUS_COMMAND_COMPILEFILE:
+				// compile buffer to flash file
+				picocstatus.CommandError = compiled_size ? -1 : compile_file(picocstatus.FileID, sourcebuffer, sourcebuffer_size);
+				picocstatus.Command = PICOCSTATUS_COMMAND_IDLE;
+				break;
 			default:
 				// unkown command
 				picocstatus.CommandError = -1;
@@ -272,6 +295,16 @@ static void picocTask(void *parameters) {
 				picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
 				started = true;
 				break;
+			case PICOCSETTINGS_SOURCE_COMPILEDFILE:
+				// start picoc with the compiled script, or the source if there was none.
+				if (compiled_size) {
+					picocstatus.ExitValue = picoc_run_compiled((uint8_t *)sourcebuffer, compiled_size, picocsettings.PicoCStackSize);
+				} else {
+					sourcebuffer[sourcebuffer_size - 1] = 0;
+					picocstatus.ExitValue = picoc(sourcebuffer, picocsettings.PicoCStackSize);
+				}
+				started = true;
+				break;
 			default:
 				picocstatus.ExitValue = 0;
 			}
@@ -471,9 +504,78 @@ int32_t delete_file(uint8_t file)
 {
 	uint32_t file_id = PICOC_SOURCE_FILE_TYPE + file;
 	int32_t retval = PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, file_id, 0);
+
+	// a compiled script must not outlive its source
+	PIOS_FLASHFS_ObjDelete(pios_waypoints_settings_fs_id, PICOC_COMPILED_FILE_TYPE + file, 0);
 	return retval;
 }
 
+/**
+ * compile the source in the buffer to a flash file
+ */
+int32_t compile_file(uint8_t file, char *buffer, uint32_t buffer_size)
+{
+	// terminate source for security.
+	buffer[buffer_size - 1] = 0;
+
+	compiled_file_id = PICOC_COMPILED_FILE_TYPE + file;
+	return picoc_compile(buffer, picocsettings.PicoCStackSize, save_compiled);
+}
+
+/**
+ * save a compiled script in sectors, called by picoc_compile()
+ */
+static int32_t save_compiled(const uint8_t *blob, uint32_t blob_size)
+{
+	uint8_t sector[PICOC_SECTOR_SIZE];
+
+	for (uint32_t i = 0; i < blob_size; i += PICOC_SECTOR_SIZE) {
+		uint32_t len = MIN(blob_size - i, PICOC_SECTOR_SIZE);
+		memset(sector, 0, PICOC_SECTOR_SIZE);
+		memcpy(sector, blob + i, len);
+
+		if (PIOS_FLASHFS_ObjSave(pios_waypoints_settings_fs_id, compiled_file_id, i / PICOC_SECTOR_SIZE, sector, PICOC_SECTOR_SIZE) != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * load a compiled script from flash
+ */
+int32_t load_compiled(uint8_t file, char *buffer, uint32_t buffer_size, uint32_t *size)
+{
+	uint32_t file_id = PICOC_COMPILED_FILE_TYPE + file;
+	struct picoc_compiled_header header;
+
+	*size = 0;
+	if (buffer_size < PICOC_SECTOR_SIZE) {
+		return -1;
+	}
+
+	// the header in the first sector tells how many follow
+	if (PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, file_id, 0, (uint8_t *)buffer, PICOC_SECTOR_SIZE) != 0) {
+		return -1;
+	}
+	memcpy(&header, buffer, sizeof(header));
+	if ((header.magic != PICOC_COMPILED_MAGIC) || (header.size > buffer_size - sizeof(header))) {
+		return -1;
+	}
+
+	uint32_t blob_size = sizeof(header) + header.size;
+	for (uint32_t i = PICOC_SECTOR_SIZE; i < blob_size; i += PICOC_SECTOR_SIZE) {
+		uint8_t sector[PICOC_SECTOR_SIZE];
+		if (PIOS_FLASHFS_ObjLoad(pios_waypoints_settings_fs_id, file_id, i / PICOC_SECTOR_SIZE, sector, PICOC_SECTOR_SIZE) != 0) {
+			return -1;
+		}
+		memcpy(buffer + i, sector, MIN(blob_size - i, PICOC_SECTOR_SIZE));
+	}
+
+	*size = blob_size;
+	return 0;
+}
+
 /**
  * format flash partition
  */
@@ -91,6 +91,220 @@ int picoc(const char * source, size_t stack_size)
 	return pc.PicocExitValue;
 }
 
+/**
+ * Compiled scripts are the tokens of the lexer with the identifiers and
+ * strings inline instead of pointers into the string table, so they can be
+ * stored. Running one only registers these strings again, the source text
+ * is never scanned.
+ */
+
+/* write the tokens in the stored format, or only count them with out = NULL */
+static uint32_t picoc_serialise_tokens(const unsigned char *tokens, uint8_t *out)
+{
+	enum LexToken token;
+	uint32_t size = 0;
+
+	do {
+		token = (enum LexToken)tokens[0];
+		int value_size = LexTokenSize(token);
+
+		if (out)
+			memcpy(out + size, tokens, TOKEN_DATA_OFFSET);
+		size += TOKEN_DATA_OFFSET;
+
+		if (token == TokenIdentifier || token == TokenStringConstant)
+		{	/* the registered string, with its length in front */
+			const char *str;
+			memcpy(&str, tokens + TOKEN_DATA_OFFSET, sizeof(str));
+			uint16_t len = strlen(str);
+			if (out)
+			{
+				memcpy(out + size, &len, sizeof(len));
+				memcpy(out + size + sizeof(len), str, len);
+			}
+			size += sizeof(len) + len;
+		}
+		else if (value_size > 0)
+		{
+			if (out)
+				memcpy(out + size, tokens + TOKEN_DATA_OFFSET, value_size);
+			size += value_size;
+		}
+
+		tokens += TOKEN_DATA_OFFSET + value_size;
+	} while (token != TokenEOF);
+
+	return size;
+}
+
+/* register a string of a stored token, string constants like the lexer does */
+static char *picoc_link_string(Picoc *pc, enum LexToken token, const char *str, int len)
+{
+	char *reg_str = TableStrRegister2(pc, str, len);
+
+	if (token == TokenStringConstant && VariableStringLiteralGet(pc, reg_str) == NULL)
+	{
+		struct Value *array_value = VariableAllocValueAndData(pc, NULL, 0, FALSE, NULL, TRUE);
+		array_value->Typ = pc->CharArrayType;
+		array_value->Val = (union AnyValue *)reg_str;
+		VariableStringLiteralDefine(pc, reg_str, array_value);
+	}
+
+	return reg_str;
+}
+
+/* turn stored tokens back into the ones of the lexer, or only count them
+ * with out = NULL. returns 0 if they are cut short or corrupt */
+static uint32_t picoc_link_tokens(Picoc *pc, const uint8_t *in, uint32_t in_size, unsigned char *out)
+{
+	uint32_t pos = 0;
+	uint32_t size = 0;
+
+	while (pos + TOKEN_DATA_OFFSET <= in_size)
+	{
+		enum LexToken token = (enum LexToken)in[pos];
+		if (token > TokenEndOfFunction)
+			return 0;
+
+		int value_size = LexTokenSize(token);
+		if (out)
+			memcpy(out + size, in + pos, TOKEN_DATA_OFFSET);
+		pos += TOKEN_DATA_OFFSET;
+
+		if (token == TokenIdentifier || token == TokenStringConstant)
+		{
+			uint16_t len;
+			if (pos + sizeof(len) > in_size)
+				return 0;
+			memcpy(&len, in + pos, sizeof(len));
+			pos += sizeof(len);
+
+			if (pos + len > in_size)
+				return 0;
+			if (out)
+			{
+				char *str = picoc_link_string(pc, token, (const char *)in + pos, len);
+				memcpy(out + size + TOKEN_DATA_OFFSET, &str, sizeof(str));
+			}
+			pos += len;
+		}
+		else if (value_size > 0)
+		{
+			if (pos + value_size > in_size)
+				return 0;
+			if (out)
+				memcpy(out + size + TOKEN_DATA_OFFSET, in + pos, value_size);
+			pos += value_size;
+		}
+
+		size += TOKEN_DATA_OFFSET + value_size;
+		if (token == TokenEOF)
+			return size;
+	}
+
+	return 0;
+}
+
+/**
+ * compile a script once, so it starts without scanning the source
+ * save gets the compiled script, it is only valid during the call
+ * returns 0 on success
+ */
+int picoc_compile(const char *source, size_t stack_size, int32_t (*save)(const uint8_t *blob, uint32_t blob_size))
+{
+	Picoc pc;
+	int retval = -1;
+	PicocInitialise(&pc, stack_size);
+
+	if (PicocPlatformSetExitPoint(&pc))
+	{	/* we get here, if the source could not be scanned */
+		PicocCleanup(&pc);
+		return -1;
+	}
+
+	void *tokens = LexAnalyse(&pc, TableStrRegister(&pc, "nofile"), source, strlen(source), NULL);
+
+	struct picoc_compiled_header header = {
+		.magic = PICOC_COMPILED_MAGIC,
+		.size = picoc_serialise_tokens(tokens, NULL),
+		.last_token = TokenEndOfFunction,
+		.long_size = sizeof(long),
+#ifndef NO_FP
+		.fp_size = sizeof(double),
+#endif
+	};
+
+	uint8_t *blob = HeapAllocStack(&pc, sizeof(header) + header.size);
+	if (blob != NULL)
+	{
+		memcpy(blob, &header, sizeof(header));
+		picoc_serialise_tokens(tokens, blob + sizeof(header));
+		retval = save(blob, sizeof(header) + header.size);
+	}
+
+	PicocCleanup(&pc);
+	return retval;
+}
+
+/**
+ * run a script compiled by picoc_compile()
+ * returns the exit() value
+ */
+int picoc_run_compiled(const uint8_t *blob, uint32_t blob_size, size_t stack_size)
+{
+	Picoc pc;
+	PicocInitialise(&pc, stack_size);
+
+	if (PicocPlatformSetExitPoint(&pc))
+	{	/* we get here, if an error occures or 'exit();' was called. */
+		PicocCleanup(&pc);
+		return pc.PicocExitValue;
+	}
+
+	struct picoc_compiled_header header;
+	if (blob_size < sizeof(header))
+		ProgramFailNoParser(&pc, "no compiled script");
+
+	memcpy(&header, blob, sizeof(header));
+#ifndef NO_FP
+	uint8_t fp_size = sizeof(double);
+#else
+	uint8_t fp_size = 0;
+#endif
+	if (header.magic != PICOC_COMPILED_MAGIC || header.last_token != TokenEndOfFunction ||
+		header.long_size != sizeof(long) || header.fp_size != fp_size)
+		ProgramFailNoParser(&pc, "script compiled by other firmware");
+
+	if (header.size > blob_size - sizeof(header))
+		ProgramFailNoParser(&pc, "compiled script cut short");
+
+	const uint8_t *in = blob + sizeof(header);
+	uint32_t size = picoc_link_tokens(&pc, in, header.size, NULL);
+	if (size == 0)
+		ProgramFailNoParser(&pc, "corrupt compiled script");
+
+	unsigned char *tokens = HeapAllocMem(&pc, size);
+	if (tokens == NULL)
+		ProgramFailNoParser(&pc, "out of memory");
+	picoc_link_tokens(&pc, in, header.size, tokens);
+
+	/* parse and run it like PicocParse() does with the tokens of a source */
+	struct ParseState Parser;
+	enum ParseResult Ok;
+	LexInitParser(&Parser, &pc, NULL, tokens, TableStrRegister(&pc, "compiled"), TRUE, FALSE);
+
+	do {
+		Ok = ParseStatement(&Parser, TRUE);
+	} while (Ok == ParseResultOk);
+
+	if (Ok == ParseResultError)
+		ProgramFail(&Parser, "parse error");
+
+	HeapFreeMem(&pc, tokens);
+	PicocCleanup(&pc);
+	return pc.PicocExitValue;
+}
+
 /**
  * PicoC platform depending system functions
  * normaly stored in platform_xxx.c
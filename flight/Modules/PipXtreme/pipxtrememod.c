@@ -109,6 +109,7 @@ static void systemTask(void *parameters)
 
     /* create all modules thread */
     MODULE_TASKCREATE_ALL;
+    MODULE_DEFERRED_ALL(PIOS_WDG_Clear);
 
     lastSysTime = PIOS_Thread_Systime();
 
@@ -152,6 +153,9 @@ static void systemTask(void *parameters)
 			rfm22bStatus.Timeouts = radio_stats.timeouts;
 			rfm22bStatus.RSSI = radio_stats.rssi;
 			rfm22bStatus.LinkQuality = radio_stats.link_quality;
+			rfm22bStatus.RemoteLinkQuality = radio_stats.remote_link_quality;
+			rfm22bStatus.DataRate = radio_stats.datarate;
+			rfm22bStatus.DataRateChanges = radio_stats.datarate_changes;
 			if (first_time) {
 				first_time = false;
 			} else {
@@ -63,12 +63,38 @@
 #define RETRY_TIMEOUT_MS  20
 #define EVENT_QUEUE_SIZE  10
 #define MAX_PORT_DELAY    200
-#define SERIAL_RX_BUF_LEN 100
 #define PPM_INPUT_TIMEOUT 100
 
+//! Frames up to this long are held back and forwarded whole, longer ones go through the parser
+#define FORWARD_BUF_LEN   128
+
+//! Raw serial bytes are passed on in blocks of up to this many
+#define SERIAL_BUF_LEN    32
+
 // ****************
 // Private types
 
+struct frame_forwarder_stats {
+	uint32_t rx_bytes;
+	uint32_t tx_bytes;
+	uint32_t tx_failures;
+	uint32_t sync_errors;
+	uint32_t crc_errors;
+};
+
+//! Splits the bytes of one port into UAVTalk frames
+struct frame_forwarder {
+	uint8_t buf[FORWARD_BUF_LEN];
+	uint16_t len;
+
+	//! Bytes of an oversized frame that still go to the parser
+	uint16_t parse_remaining;
+
+	// RadioComBridgeStats is updated with what was counted since it was last reported
+	struct frame_forwarder_stats stats;
+	struct frame_forwarder_stats reported;
+};
+
 typedef struct {
 	// The task handles.
 	struct pios_thread *telemetryTxTaskHandle;
@@ -86,8 +112,10 @@ typedef struct {
 	struct pios_queue *uavtalkEventQueue;
 	struct pios_queue *radioEventQueue;
 
-	// The raw serial Rx buffer
-	uint8_t serialRxBuf[SERIAL_RX_BUF_LEN];
+	// Frames from the GCS and from the radio. Without UAVTalk parsing the
+	// radio buffer takes the raw serial data for the radio instead.
+	struct frame_forwarder telemetryForwarder;
+	struct frame_forwarder radioForwarder;
 
 	// Error statistics.
 	uint32_t telemetryTxRetries;
@@ -111,12 +139,12 @@ static void radioRxTask(void *parameters);
 static void PPMInputTask(void *parameters);
 static int32_t UAVTalkSendHandler(uint8_t * buf, int32_t length);
 static int32_t RadioSendHandler(uint8_t * buf, int32_t length);
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
-				   UAVTalkConnection outConnectionHandle,
-				   uint8_t rxbyte);
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
-			       UAVTalkConnection outConnectionHandle,
-			       uint8_t rxbyte);
+static void ProcessTelemetryPacket(UAVTalkConnection inConnectionHandle,
+				   UAVTalkConnection outConnectionHandle);
+static void ProcessRadioPacket(UAVTalkConnection inConnectionHandle,
+			       UAVTalkConnection outConnectionHandle);
+static void forwardFrames(struct frame_forwarder *fwd, uint16_t received, bool from_radio);
+static bool isModemObject(uint32_t objId, bool from_radio);
 static void objectPersistenceUpdatedCb(UAVObjEvent * objEv);
 static void registerObject(UAVObjHandle obj);
 
@@ -224,6 +252,9 @@ static int32_t RadioComBridgeInitialize(void)
 
 	data->parseUAVTalk = true;
 
+	memset(&data->telemetryForwarder, 0, sizeof(data->telemetryForwarder));
+	memset(&data->radioForwarder, 0, sizeof(data->radioForwarder));
+
 	return 0;
 }
 
@@ -251,6 +282,22 @@ static void registerObject(UAVObjHandle obj)
 	UAVObjConnectQueue(obj, data->uavtalkEventQueue, EV_UPDATED_PERIODIC | EV_UPDATED_MANUAL | EV_UPDATE_REQ);
 }
 
+/**
+ * Get what a forwarder counted since the last call
+ */
+static void takeForwarderStats(struct frame_forwarder *fwd, struct frame_forwarder_stats *increment)
+{
+	struct frame_forwarder_stats now = fwd->stats;
+
+	increment->rx_bytes = now.rx_bytes - fwd->reported.rx_bytes;
+	increment->tx_bytes = now.tx_bytes - fwd->reported.tx_bytes;
+	increment->tx_failures = now.tx_failures - fwd->reported.tx_failures;
+	increment->sync_errors = now.sync_errors - fwd->reported.sync_errors;
+	increment->crc_errors = now.crc_errors - fwd->reported.crc_errors;
+
+	fwd->reported = now;
+}
+
 /**
  * Update telemetry statistics
  */
@@ -289,6 +336,24 @@ static void updateRadioComBridgeStats()
 	radioComBridgeStats.RadioRxBytes += radioUAVTalkStats.rxBytes;
 	radioComBridgeStats.RadioRxFailures += radioUAVTalkStats.rxErrors;
 
+	// Frames that were forwarded without the parser
+	struct frame_forwarder_stats telemetry;
+	struct frame_forwarder_stats radio;
+	takeForwarderStats(&data->telemetryForwarder, &telemetry);
+	takeForwarderStats(&data->radioForwarder, &radio);
+
+	radioComBridgeStats.TelemetryRxBytes += telemetry.rx_bytes;
+	radioComBridgeStats.TelemetryRxSyncErrors += telemetry.sync_errors;
+	radioComBridgeStats.TelemetryRxCrcErrors += telemetry.crc_errors;
+	radioComBridgeStats.RadioTxBytes += telemetry.tx_bytes;
+	radioComBridgeStats.RadioTxFailures += telemetry.tx_failures;
+
+	radioComBridgeStats.RadioRxBytes += radio.rx_bytes;
+	radioComBridgeStats.RadioRxSyncErrors += radio.sync_errors;
+	radioComBridgeStats.RadioRxCrcErrors += radio.crc_errors;
+	radioComBridgeStats.TelemetryTxBytes += radio.tx_bytes;
+	radioComBridgeStats.TelemetryTxFailures += radio.tx_failures;
+
 	// Update stats object data
 	RadioComBridgeStatsSet(&radioComBridgeStats);
 }
@@ -384,26 +449,26 @@ static void radioRxTask( __attribute__ ((unused))
 #ifdef PIOS_INCLUDE_WDG
 		PIOS_WDG_UpdateFlag(PIOS_WDG_RADIORX);
 #endif
-		if (PIOS_COM_RFM22B) {
-			uint8_t serial_data[1];
+		if (PIOS_COM_RFM22B && data->parseUAVTalk) {
+			// Receive straight behind the start of the frame already buffered
+			struct frame_forwarder *fwd = &data->radioForwarder;
+			uint16_t bytes_to_process =
+			    PIOS_COM_ReceiveBuffer(PIOS_COM_RFM22B,
+						   &fwd->buf[fwd->len],
+						   FORWARD_BUF_LEN - fwd->len,
+						   MAX_PORT_DELAY);
+			if (bytes_to_process > 0) {
+				forwardFrames(fwd, bytes_to_process, true);
+			}
+		} else if (PIOS_COM_RFM22B) {
+			uint8_t serial_data[SERIAL_BUF_LEN];
 			uint16_t bytes_to_process =
 			    PIOS_COM_ReceiveBuffer(PIOS_COM_RFM22B,
 						   serial_data,
 						   sizeof(serial_data),
 						   MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
-				if (data->parseUAVTalk) {
-					// Pass the data through the UAVTalk parser.
-					for (uint8_t i = 0;
-					     i < bytes_to_process; i++) {
-						ProcessRadioStream(data->
-								   radioUAVTalkCon,
-								   data->
-								   telemUAVTalkCon,
-								   serial_data
-								   [i]);
-					}
-				} else if (PIOS_COM_TELEMETRY) {
+				if (PIOS_COM_TELEMETRY) {
 					// Send the data straight to the telemetry port.
 					// Following call can fail with -2 error code (buffer full) or -3 error code (could not acquire send mutex)
 					// It is the caller responsibility to retry in such cases...
@@ -446,22 +511,15 @@ static void telemetryRxTask( __attribute__ ((unused))
 		}
 #endif /* PIOS_INCLUDE_USB */
 		if (inputPort) {
-			uint8_t serial_data[1];
+			struct frame_forwarder *fwd = &data->telemetryForwarder;
 			uint16_t bytes_to_process =
-			    PIOS_COM_ReceiveBuffer(inputPort, serial_data,
-						   sizeof(serial_data),
+			    PIOS_COM_ReceiveBuffer(inputPort,
+						   &fwd->buf[fwd->len],
+						   FORWARD_BUF_LEN - fwd->len,
 						   MAX_PORT_DELAY);
 			if (bytes_to_process > 0) {
 				PIOS_LED_Toggle(PIOS_LED_RX);
-				for (uint8_t i = 0; i < bytes_to_process;
-				     i++) {
-					ProcessTelemetryStream(data->
-							       telemUAVTalkCon,
-							       data->
-							       radioUAVTalkCon,
-							       serial_data
-							       [i]);
-				}
+				forwardFrames(fwd, bytes_to_process, false);
 			}
 		} else {
 			PIOS_Thread_Sleep(5);
@@ -514,9 +572,8 @@ static void serialRxTask( __attribute__ ((unused))
 			// Receive some data.
 			uint16_t bytes_to_process =
 			    PIOS_COM_ReceiveBuffer(inputPort,
-						   data->serialRxBuf,
-						   sizeof(data->
-							  serialRxBuf),
+						   data->radioForwarder.buf,
+						   sizeof(data->radioForwarder.buf),
 						   MAX_PORT_DELAY);
 
 			if (bytes_to_process > 0) {
@@ -529,7 +586,7 @@ static void serialRxTask( __attribute__ ((unused))
 					ret =
 					    PIOS_COM_SendBufferNonBlocking
 					    (PIOS_COM_RFM22B,
-					     data->serialRxBuf,
+					     data->radioForwarder.buf,
 					     bytes_to_process);
 				}
 			}
@@ -608,138 +665,268 @@ static int32_t RadioSendHandler(uint8_t * buf, int32_t length)
 
 #define MetaObjectId(x) (x+1)
 /**
- * @brief Process a byte of data received on the telemetry stream
+ * @brief Handle a packet completed on the telemetry stream
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the telemetry port
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the radio port.
- * @param[in] rxbyte  The received byte.
  */
-static void ProcessTelemetryStream(UAVTalkConnection inConnectionHandle,
-				   UAVTalkConnection outConnectionHandle,
-				   uint8_t rxbyte)
+static void ProcessTelemetryPacket(UAVTalkConnection inConnectionHandle,
+				   UAVTalkConnection outConnectionHandle)
 {
-	// Keep reading until we receive a completed packet.
-	UAVTalkRxState state =
-	    UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
-
-	if (state == UAVTALK_STATE_COMPLETE) {
-		// We only want to unpack certain telemetry objects
-		uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
-		switch (objId) {
-		case HWTAULINK_OBJID:
-		case RFM22BRECEIVER_OBJID:
-		case MetaObjectId(HWTAULINK_OBJID):
-		case MetaObjectId(RFM22BRECEIVER_OBJID):
-		case MetaObjectId(RFM22BSTATUS_OBJID):
-
-			// These objects are received here and only here
-			UAVTalkReceiveObject(inConnectionHandle);
-			break;
-
-		case OBJECTPERSISTENCE_OBJID:
-		case MetaObjectId(OBJECTPERSISTENCE_OBJID):
-			// Handle saving settings on modem
-			UAVTalkReceiveObject(inConnectionHandle);
-
-			ObjectPersistenceData objectPersistence;
-			ObjectPersistenceGet(&objectPersistence);
-			if (objectPersistence.ObjectID != HWTAULINK_OBJID &&
-				objectPersistence.ObjectID != MetaObjectId(HWTAULINK_OBJID)) {
-				// relay packet to remote modem except for requests to save
-				// the settings which happens locally
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			}
+	// We only want to unpack certain telemetry objects
+	uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
+	switch (objId) {
+	case HWTAULINK_OBJID:
+	case RFM22BRECEIVER_OBJID:
+	case MetaObjectId(HWTAULINK_OBJID):
+	case MetaObjectId(RFM22BRECEIVER_OBJID):
+	case MetaObjectId(RFM22BSTATUS_OBJID):
+
+		// These objects are received here and only here
+		UAVTalkReceiveObject(inConnectionHandle);
+		break;
+
+	case OBJECTPERSISTENCE_OBJID:
+	case MetaObjectId(OBJECTPERSISTENCE_OBJID):
+		// Handle saving settings on modem
+		UAVTalkReceiveObject(inConnectionHandle);
+
+		ObjectPersistenceData objectPersistence;
+		ObjectPersistenceGet(&objectPersistence);
+		if (objectPersistence.ObjectID != HWTAULINK_OBJID &&
+			objectPersistence.ObjectID != MetaObjectId(HWTAULINK_OBJID)) {
+			// relay packet to remote modem except for requests to save
+			// the settings which happens locally
+			UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+		}
 
-			break;
+		break;
 
-		case RFM22BSTATUS_OBJID:
-		{
-			uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
-			if (inst_id == 0) {
-				// dealing with local modem
-				UAVTalkReceiveObject(inConnectionHandle);
-			} else {
-				// for remote modem
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			}
-		}
-			break;
-		default:
-			// all other packets are transparently relayed to the remote modem
+	case RFM22BSTATUS_OBJID:
+	{
+		uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
+		if (inst_id == 0) {
+			// dealing with local modem
+			UAVTalkReceiveObject(inConnectionHandle);
+		} else {
+			// for remote modem
 			UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			break;
 		}
 	}
+		break;
+	default:
+		// all other packets are transparently relayed to the remote modem
+		UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+		break;
+	}
 }
 
 /**
- * @brief Process a byte of data received on the radio data stream.
+ * @brief Handle a packet completed on the radio data stream.
  *
  * @param[in] inConnectionHandle  The UAVTalk connection handle on the radio port.
  * @param[in] outConnectionHandle  The UAVTalk connection handle on the telemetry port.
- * @param[in] rxbyte  The received byte.
  */
-static void ProcessRadioStream(UAVTalkConnection inConnectionHandle,
-			       UAVTalkConnection outConnectionHandle,
-			       uint8_t rxbyte)
+static void ProcessRadioPacket(UAVTalkConnection inConnectionHandle,
+			       UAVTalkConnection outConnectionHandle)
 {
-	// Keep reading until we receive a completed packet.
-	UAVTalkRxState state =
-	    UAVTalkProcessInputStreamQuiet(inConnectionHandle, rxbyte);
-
-	if (state == UAVTALK_STATE_COMPLETE) {
-		// We only want to unpack certain objects from the remote modem
-		// Similarly we only want to relay certain objects to the telemetry port
-		uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
-		switch (objId) {
-		case HWTAULINK_OBJID:
-		case MetaObjectId(RFM22BSTATUS_OBJID):
-		case MetaObjectId(HWTAULINK_OBJID):
-			// Ignore object...
-			// These objects are shadowed by the modem and are not transmitted to the telemetry port
-			// - RFM22BSTATUS_OBJID : ground station will receive the OPLM link status instead
-			// - HWTAULINK_OBJID : ground station will read and write the OPLM settings instead
-			break;
-		case RFM22BRECEIVER_OBJID:
-		case MetaObjectId(RFM22BRECEIVER_OBJID):
-			// Receive object locally
-			// These objects are received by the modem and are not transmitted to the telemetry port
-			// - RFM22BRECEIVER_OBJID : sent periodically from flight controller, not needed to echo
-			// some objects will send back a response to the remote modem
+	// We only want to unpack certain objects from the remote modem
+	// Similarly we only want to relay certain objects to the telemetry port
+	uint32_t objId = UAVTalkGetPacketObjId(inConnectionHandle);
+	switch (objId) {
+	case HWTAULINK_OBJID:
+	case MetaObjectId(RFM22BSTATUS_OBJID):
+	case MetaObjectId(HWTAULINK_OBJID):
+		// Ignore object...
+		// These objects are shadowed by the modem and are not transmitted to the telemetry port
+		// - RFM22BSTATUS_OBJID : ground station will receive the OPLM link status instead
+		// - HWTAULINK_OBJID : ground station will read and write the OPLM settings instead
+		break;
+	case RFM22BRECEIVER_OBJID:
+	case MetaObjectId(RFM22BRECEIVER_OBJID):
+		// Receive object locally
+		// These objects are received by the modem and are not transmitted to the telemetry port
+		// - RFM22BRECEIVER_OBJID : sent periodically from flight controller, not needed to echo
+		// some objects will send back a response to the remote modem
+		UAVTalkReceiveObject(inConnectionHandle);
+		break;
+	case FLIGHTBATTERYSTATE_OBJID:
+	case FLIGHTSTATUS_OBJID:
+	case POSITIONACTUAL_OBJID:
+	case VELOCITYACTUAL_OBJID:
+	case BAROALTITUDE_OBJID:
+
+		// process the battery voltage locally for relaying to taranis
+		UAVTalkReceiveObject(inConnectionHandle);
+		UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+		break;
+	case RFM22BSTATUS_OBJID:
+	{
+		uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
+		if (inst_id == 0) {
+			// instance 0 is from modem. do not pass this version
+		} else {
+			// process the remote link state locally for relaying to taranis
 			UAVTalkReceiveObject(inConnectionHandle);
-			break;
-		case FLIGHTBATTERYSTATE_OBJID:
-		case FLIGHTSTATUS_OBJID:
-		case POSITIONACTUAL_OBJID:
-		case VELOCITYACTUAL_OBJID:
-		case BAROALTITUDE_OBJID:
 
-			// process the battery voltage locally for relaying to taranis
-			UAVTalkReceiveObject(inConnectionHandle);
+			// for remote modem
 			UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
-			break;
-		case RFM22BSTATUS_OBJID:
-		{
-			uint32_t inst_id = UAVTalkGetPacketInstId(inConnectionHandle);
-			if (inst_id == 0) {
-				// instance 0 is from modem. do not pass this version
-			} else {
-				// process the remote link state locally for relaying to taranis
-				UAVTalkReceiveObject(inConnectionHandle);
+		}
+
+	}
+		break;
+
+	default:
+		// all other packets are relayed to the telemetry port
+		UAVTalkRelayPacket(inConnectionHandle,
+				   outConnectionHandle);
+		break;
+	}
+}
 
-				// for remote modem
-				UAVTalkRelayPacket(inConnectionHandle, outConnectionHandle);
+/**
+ * @brief Hand bytes to the UAVTalk parser of the port they came from
+ */
+static void parseBytes(const uint8_t *buf, uint16_t len, bool from_radio)
+{
+	UAVTalkConnection in = from_radio ? data->radioUAVTalkCon : data->telemUAVTalkCon;
+	UAVTalkConnection out = from_radio ? data->telemUAVTalkCon : data->radioUAVTalkCon;
+
+	while (len > 0) {
+		uint16_t consumed;
+		UAVTalkRxState state = UAVTalkProcessInputBufferQuiet(in, buf, len, &consumed);
+		buf += consumed;
+		len -= consumed;
+
+		if (state == UAVTALK_STATE_COMPLETE) {
+			if (from_radio) {
+				ProcessRadioPacket(in, out);
+			} else {
+				ProcessTelemetryPacket(in, out);
 			}
+		}
+	}
+}
+
+/**
+ * @brief Split the received bytes into UAVTalk frames and pass them on.
+ *
+ * Complete frames with a good checksum are sent to the other port as they
+ * are, without being copied through the UAVTalk buffers. Only frames of the
+ * objects the modem handles itself and those too long for the buffer go
+ * through the parser.
+ *
+ * @param[in] fwd  The forwarder the bytes were received into
+ * @param[in] received  Number of bytes added behind fwd->len
+ * @param[in] from_radio  Whether the bytes came from the radio or the telemetry port
+ */
+static void forwardFrames(struct frame_forwarder *fwd, uint16_t received, bool from_radio)
+{
+	uint16_t pos = 0;
 
+	fwd->len += received;
+
+	while (pos < fwd->len) {
+		uint8_t *frame = &fwd->buf[pos];
+		uint16_t avail = fwd->len - pos;
+
+		// The rest of a long frame the parser takes as it arrives
+		if (fwd->parse_remaining > 0) {
+			uint16_t n = (avail < fwd->parse_remaining) ? avail : fwd->parse_remaining;
+			parseBytes(frame, n, from_radio);
+			fwd->parse_remaining -= n;
+			pos += n;
+			continue;
 		}
+
+		if (frame[0] != UAVTALK_SYNC_VAL) {
+			fwd->stats.sync_errors++;
+			fwd->stats.rx_bytes++;
+			pos++;
+			continue;
+		}
+
+		// Wait for the type and size
+		if (avail < 4) {
 			break;
+		}
 
-		default:
-			// all other packets are relayed to the telemetry port
-			UAVTalkRelayPacket(inConnectionHandle,
-					   outConnectionHandle);
+		uint8_t type = frame[1];
+		uint16_t size = frame[2] | (frame[3] << 8);
+
+		if ((type & UAVTALK_TYPE_MASK) != UAVTALK_TYPE_VER || size < UAVTALK_MIN_HEADER_LENGTH ||
+				size > UAVTALK_MAX_HEADER_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH) {
+			// Not a frame, look for the next sync byte
+			fwd->stats.sync_errors++;
+			fwd->stats.rx_bytes++;
+			pos++;
+			continue;
+		}
+
+		uint16_t frame_len = size + UAVTALK_CHECKSUM_LENGTH;
+		if (frame_len > FORWARD_BUF_LEN) {
+			fwd->parse_remaining = frame_len;
+			continue;
+		}
+
+		if (avail < frame_len) {
 			break;
 		}
+
+		if (PIOS_CRC_updateCRC(0, frame, size) != frame[size]) {
+			fwd->stats.crc_errors++;
+			fwd->stats.rx_bytes++;
+			pos++;
+			continue;
+		}
+
+		uint32_t objId = frame[4] | (frame[5] << 8) | (frame[6] << 16) | ((uint32_t)frame[7] << 24);
+		if (isModemObject(objId, from_radio)) {
+			parseBytes(frame, frame_len, from_radio);
+		} else {
+			int32_t ret = from_radio ?
+				UAVTalkSendHandler(frame, frame_len) :
+				RadioSendHandler(frame, frame_len);
+			fwd->stats.rx_bytes += frame_len;
+			if (ret == frame_len) {
+				fwd->stats.tx_bytes += frame_len;
+			} else {
+				fwd->stats.tx_failures++;
+			}
+		}
+		pos += frame_len;
+	}
+
+	// Keep the start of the next frame
+	fwd->len -= pos;
+	memmove(fwd->buf, &fwd->buf[pos], fwd->len);
+}
+
+/**
+ * @brief Whether ProcessTelemetryStream() or ProcessRadioStream() does
+ * more than relaying frames of this object
+ */
+static bool isModemObject(uint32_t objId, bool from_radio)
+{
+	switch (objId) {
+	case HWTAULINK_OBJID:
+	case RFM22BRECEIVER_OBJID:
+	case RFM22BSTATUS_OBJID:
+	case MetaObjectId(HWTAULINK_OBJID):
+	case MetaObjectId(RFM22BRECEIVER_OBJID):
+	case MetaObjectId(RFM22BSTATUS_OBJID):
+		return true;
+	case OBJECTPERSISTENCE_OBJID:
+	case MetaObjectId(OBJECTPERSISTENCE_OBJID):
+		return !from_radio;
+	case FLIGHTBATTERYSTATE_OBJID:
+	case FLIGHTSTATUS_OBJID:
+	case POSITIONACTUAL_OBJID:
+	case VELOCITYACTUAL_OBJID:
+	case BAROALTITUDE_OBJID:
+		return from_radio;
+	default:
+		return false;
 	}
 }
 
@@ -35,6 +35,11 @@
 #include "pios_thread.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "latencymonitor.h"
+#include "attitude_cache.h"
+#include "notch_filter.h"
+#include "mag_ellipsoid.h"
+#include "temp_comp_fit.h"
 
 #if defined(PIOS_INCLUDE_PX4FLOW)
 #include "pios_px4flow_priv.h"
@@ -46,8 +51,10 @@ extern uintptr_t external_i2c_adapter_id;
 #include "attitudeactual.h"
 #include "attitudesettings.h"
 #include "baroaltitude.h"
+#include "flightstatus.h"
 #include "gyros.h"
 #include "gyrosbias.h"
+#include "gyronotchsettings.h"
 #include "homelocation.h"
 #include "opticalflowsettings.h"
 #include "opticalflow.h"
@@ -56,6 +63,8 @@ extern uintptr_t external_i2c_adapter_id;
 #include "inssettings.h"
 #include "magnetometer.h"
 #include "magbias.h"
+#include "objectpersistence.h"
+#include "vibrationanalysisbands.h"
 #include "coordinate_conversions.h"
 
 // Private constants
@@ -63,8 +72,13 @@ extern uintptr_t external_i2c_adapter_id;
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
 #define SENSOR_PERIOD 6		// this allows sensor data to arrive as slow as 166Hz
 #define REQUIRED_GOOD_CYCLES 50
+#define SENSOR_MAX_BLOCK 16	// most samples merged into one update when a driver delivers a burst
 #define MAX_TIME_BETWEEN_VALID_BARO_DATAS_MS 100*1000  // we allow a pause time of 100 ms between two valid
                                                        // temperature/barometer dataa
+#define MAG_FIT_NORM 500.0f	// typical field length in mGau the fit is scaled by without a home location
+#define TEMP_FIT_MAX_RATE 10.0f	// deg/s, faster and the board is being moved rather than warming up
+#define TEMP_FIT_MIN_RANGE 10.0f	// deg C the sweep has to cover before coefficients are written
+#define TEMP_FIT_SETTLE_MS 120000	// no new bin for this long and the warm-up is over
 
 // Private types
 enum mag_calibration_algo {
@@ -72,27 +86,40 @@ enum mag_calibration_algo {
 	MAG_CALIBRATION_NORMALIZE_LENGTH
 };
 
+enum mag_fit_state {
+	MAG_FIT_OFF,
+	MAG_FIT_RUNNING,
+	MAG_FIT_SAVE,		//!< Calibration applied, stored once disarmed
+	MAG_FIT_DONE
+};
+
 // Private functions
 static void SensorsTask(void *parameters);
 static void settingsUpdatedCb(UAVObjEvent * objEv);
 
-static void update_accels(struct pios_sensor_accel_data *accel);
-static void update_gyros(struct pios_sensor_gyro_data *gyro);
-static void update_mags(struct pios_sensor_mag_data *mag);
-static void update_baro(struct pios_sensor_baro_data *baro);
+static void update_accels(const struct pios_sensor_accel_data *accel);
+static void update_gyros(const struct pios_sensor_gyro_data *gyro);
+static void update_notches(void);
+static void notchPeakUpdatedCb(UAVObjEvent * objEv);
+static void update_mags(const struct pios_sensor_mag_data *mag);
+static void update_baro(const struct pios_sensor_baro_data *baro);
 
 #if defined (PIOS_INCLUDE_OPTICALFLOW)
-static void update_optical_flow(struct pios_sensor_optical_flow_data *optical_flow);
+static void update_optical_flow(const struct pios_sensor_optical_flow_data *optical_flow);
 #endif /* PIOS_INCLUDE_OPTICALFLOW */
 
 #if defined (PIOS_INCLUDE_RANGEFINDER)
-static void update_rangefinder(struct pios_sensor_rangefinder_data *rangefinder);
+static void update_rangefinder(const struct pios_sensor_rangefinder_data *rangefinder);
 #endif /* PIOS_INCLUDE_RANGEFINDER */
 
 static void mag_calibration_prelemari(MagnetometerData *mag);
 static void mag_calibration_fix_length(MagnetometerData *mag);
+static void mag_calibration_fit(const struct pios_sensor_mag_data *mag);
+static void gyro_temp_calibration_fit(float temperature, const float gyros[3]);
 
 static void updateTemperatureComp(float temperature, float *temp_bias);
+static void merge_pending_gyros(struct pios_sensor_gyro_data *block);
+static void merge_pending_accels(struct pios_sensor_accel_data *block);
 
 // Private variables
 static struct pios_thread *sensorsTaskHandle;
@@ -115,6 +142,12 @@ static float z_accel_offset = 0;
 static float Rsb[3][3] = {{0}}; //! Rotation matrix that transforms from the body frame to the sensor board frame
 static int8_t rotate = 0;
 
+static GyroNotchSettingsData notchSettings;
+static struct notch_filter gyro_notch;
+static volatile bool notch_retune = false;
+static uint32_t last_gyro_time = 0;
+static float gyro_dt = 0;		//!< Smoothed time between gyro updates, the notches are designed for it
+
 #if defined (AQ32)
 // indicates whether the external mag works
 extern bool external_mag_fail;
@@ -122,6 +155,18 @@ extern bool external_mag_fail;
 //! Select the algorithm to try and null out the magnetometer bias error
 static enum mag_calibration_algo mag_calibration_algo = MAG_CALIBRATION_PRELEMARI;
 
+//! Onboard fit of the full magnetometer calibration
+static struct mag_ellipsoid mag_fit;
+static enum mag_fit_state mag_fit_state = MAG_FIT_OFF;
+static volatile bool mag_fit_enabled = false;
+
+//! Onboard fit of the gyro temperature compensation during warm-up
+static struct temp_comp_fit temp_fit;
+static bool temp_fit_running = false;
+static bool temp_fit_unsaved = false;
+static uint32_t temp_fit_last_bin = 0;
+static volatile bool temp_fit_enabled = false;
+
 /**
  * API for sensor fusion algorithms:
  * Configure(struct pios_queue *gyro, struct pios_queue *accel, struct pios_queue *mag, struct pios_queue *baro)
@@ -143,9 +188,12 @@ static int32_t SensorsInitialize(void)
 	BaroAltitudeInitialize();
 	MagnetometerInitialize();
 	MagBiasInitialize();
+	FlightStatusInitialize();
+	ObjectPersistenceInitialize();
 	AttitudeSettingsInitialize();
 	SensorSettingsInitialize();
 	INSSettingsInitialize();
+	GyroNotchSettingsInitialize();
 
 #if defined (PIOS_INCLUDE_OPTICALFLOW)
 	OpticalFlowSettingsInitialize();
@@ -167,22 +215,24 @@ static int32_t SensorsInitialize(void)
 		break;
 	}
 
-	if (PIOS_SENSORS_GetQueue(PIOS_SENSOR_OPTICAL_FLOW) != NULL ) {
+	if (PIOS_SENSORS_IsRegistered(PIOS_SENSOR_OPTICAL_FLOW) ) {
 		OpticalFlowInitialize();
 	}
 #endif /* PIOS_INCLUDE_OPTICALFLOW */
 
 #if defined (PIOS_INCLUDE_RANGEFINDER)
-	if (PIOS_SENSORS_GetQueue(PIOS_SENSOR_RANGEFINDER) != NULL ) {
+	if (PIOS_SENSORS_IsRegistered(PIOS_SENSOR_RANGEFINDER) ) {
 		RangefinderDistanceInitialize();
 	}
 #endif /* PIOS_INCLUDE_RANGEFINDER */
 
 	rotate = 0;
+	notch_filter_init(&gyro_notch);
 
 	AttitudeSettingsConnectCallback(&settingsUpdatedCb);
 	SensorSettingsConnectCallback(&settingsUpdatedCb);
 	INSSettingsConnectCallback(&settingsUpdatedCb);
+	GyroNotchSettingsConnectCallback(&settingsUpdatedCb);
 
 	return 0;
 }
@@ -194,14 +244,18 @@ static int32_t SensorsInitialize(void)
 static int32_t SensorsStart(void)
 {
 	// Start main task
-	sensorsTaskHandle = PIOS_Thread_Create(SensorsTask, "Sensors", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	sensorsTaskHandle = PIOS_Thread_Create_Fast(SensorsTask, "Sensors", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 	TaskMonitorAdd(TASKINFO_RUNNING_SENSORS, sensorsTaskHandle);
 	PIOS_WDG_RegisterFlag(PIOS_WDG_SENSORS);
 
+	// Only there when VibrationAnalysis runs in Bands mode
+	if (VibrationAnalysisBandsHandle() != NULL)
+		VibrationAnalysisBandsConnectCallback(&notchPeakUpdatedCb);
+
 	return 0;
 }
 
-MODULE_INITCALL(SensorsInitialize, SensorsStart);
+MODULE_CRITICAL_INITCALL(SensorsInitialize, SensorsStart);
 
 
 /**
@@ -238,37 +292,67 @@ static void SensorsTask(void *parameters)
 
 		uint32_t timeval = PIOS_DELAY_GetRaw();
 
+		// Samples from ring buffer backed sensors are used in place and
+		// only copied for sensors still registered with a queue
+		const struct pios_sensor_gyro_data *gyro_sample;
+		const struct pios_sensor_accel_data *accel_sample;
+		const struct pios_sensor_mag_data *mag_sample;
+		const struct pios_sensor_baro_data *baro_sample;
+
 		//Block on gyro data but nothing else
-		struct pios_queue *queue;
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_GYRO);
-		if (queue == NULL || PIOS_Queue_Receive(queue, &gyros, SENSOR_PERIOD) == false) {
+		gyro_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_GYRO, &gyros, SENSOR_PERIOD);
+		if (gyro_sample == NULL) {
 			good_runs = 0;
 			continue;
 		}
 
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_ACCEL);
-		if (queue == NULL || PIOS_Queue_Receive(queue, &accels, 0) == false) {
+#if defined(LATENCY_DIAGNOSTICS)
+		// Drivers that do not record their interrupt time are traced from here
+		uint32_t gyro_sample_time = PIOS_SENSORS_GetSampleTime(PIOS_SENSOR_GYRO);
+		LatencyMonitorStart(gyro_sample_time ? gyro_sample_time : timeval);
+#endif
+
+		// A driver running in FIFO mode hands over a burst of samples at
+		// once. Pass the whole block on as its mean so the consumers run
+		// once per block instead of once per sample.
+		gyros = *gyro_sample;
+		PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_GYRO);
+		merge_pending_gyros(&gyros);
+
+		// Drivers that do not stamp their samples are taken as read now
+		if (gyros.sample_time == 0)
+			gyros.sample_time = PIOS_DELAY_GetRaw();
+
+		accel_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_ACCEL, &accels, 0);
+		if (accel_sample == NULL) {
 			//If no new accels data is ready, reuse the latest sample
 			AccelsSet(&accelsData);
-		}
-		else
+		} else {
+			accels = *accel_sample;
+			PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_ACCEL);
+			merge_pending_accels(&accels);
+			if (accels.sample_time == 0)
+				accels.sample_time = PIOS_DELAY_GetRaw();
 			update_accels(&accels);
+		}
 
 		// Update gyros after the accels since the rest of the code expects
 		// the accels to be available first
 		update_gyros(&gyros);
 
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_MAG);
-		if (queue != NULL && PIOS_Queue_Receive(queue, &mags, 0) != false) {
-			update_mags(&mags);
+		mag_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_MAG, &mags, 0);
+		if (mag_sample != NULL) {
+			update_mags(mag_sample);
+			PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_MAG);
 		}
 
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_BARO);
-		if (queue != NULL) {
-			if (PIOS_Queue_Receive(queue, &baro, 0) != false) {
+		if (PIOS_SENSORS_IsRegistered(PIOS_SENSOR_BARO)) {
+			baro_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_BARO, &baro, 0);
+			if (baro_sample != NULL) {
 				// we can use the timeval because it contains the current time stamp (PIOS_DELAY_GetRaw())
 				last_baro_update_time = timeval;
-				update_baro(&baro);
+				update_baro(baro_sample);
+				PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_BARO);
 				AlarmsClear(SYSTEMALARMS_ALARM_TEMPBARO);
 
 			} else {
@@ -284,17 +368,21 @@ static void SensorsTask(void *parameters)
 
 #if defined(PIOS_INCLUDE_OPTICALFLOW)
 		struct pios_sensor_optical_flow_data optical_flow;
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_OPTICAL_FLOW);
-		if (queue != NULL && PIOS_Queue_Receive(queue, &optical_flow, 0) != false) {
-			update_optical_flow(&optical_flow);
+		const struct pios_sensor_optical_flow_data *optical_flow_sample;
+		optical_flow_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_OPTICAL_FLOW, &optical_flow, 0);
+		if (optical_flow_sample != NULL) {
+			update_optical_flow(optical_flow_sample);
+			PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_OPTICAL_FLOW);
 		}
 #endif /* PIOS_INCLUDE_OPTICALFLOW */
 
 #if defined(PIOS_INCLUDE_RANGEFINDER)
 		struct pios_sensor_rangefinder_data rangefinder;
-		queue = PIOS_SENSORS_GetQueue(PIOS_SENSOR_RANGEFINDER);
-		if (queue != NULL && PIOS_Queue_Receive(queue, &rangefinder, 0) != false) {
-			update_rangefinder(&rangefinder);
+		const struct pios_sensor_rangefinder_data *rangefinder_sample;
+		rangefinder_sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_RANGEFINDER, &rangefinder, 0);
+		if (rangefinder_sample != NULL) {
+			update_rangefinder(rangefinder_sample);
+			PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_RANGEFINDER);
 		}
 #endif /* PIOS_INCLUDE_RANGEFINDER */
 
@@ -318,11 +406,83 @@ static void SensorsTask(void *parameters)
 	}
 }
 
+/**
+ * @brief Average all gyro samples already waiting into a block
+ * @param[in,out] block holds the first sample and returns the block mean,
+ * stamped with the middle of the times the samples were taken
+ */
+static void merge_pending_gyros(struct pios_sensor_gyro_data *block)
+{
+	struct pios_sensor_gyro_data copy;
+	const struct pios_sensor_gyro_data *sample;
+	uint32_t count = 1;
+	uint32_t first_time = block->sample_time;
+	uint32_t last_time = first_time;
+
+	while (count < SENSOR_MAX_BLOCK &&
+			(sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_GYRO, &copy, 0)) != NULL) {
+		block->x += sample->x;
+		block->y += sample->y;
+		block->z += sample->z;
+		block->temperature += sample->temperature;
+		last_time = sample->sample_time;
+		PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_GYRO);
+		count++;
+	}
+
+	if (count > 1) {
+		float scale = 1.0f / count;
+		block->x *= scale;
+		block->y *= scale;
+		block->z *= scale;
+		block->temperature *= scale;
+
+		if (first_time != 0 && last_time != 0)
+			block->sample_time = first_time + (last_time - first_time) / 2;
+	}
+}
+
+/**
+ * @brief Average all accel samples already waiting into a block
+ * @param[in,out] block holds the first sample and returns the block mean,
+ * stamped with the middle of the times the samples were taken
+ */
+static void merge_pending_accels(struct pios_sensor_accel_data *block)
+{
+	struct pios_sensor_accel_data copy;
+	const struct pios_sensor_accel_data *sample;
+	uint32_t count = 1;
+	uint32_t first_time = block->sample_time;
+	uint32_t last_time = first_time;
+
+	while (count < SENSOR_MAX_BLOCK &&
+			(sample = PIOS_SENSORS_GetSample(PIOS_SENSOR_ACCEL, &copy, 0)) != NULL) {
+		block->x += sample->x;
+		block->y += sample->y;
+		block->z += sample->z;
+		block->temperature += sample->temperature;
+		last_time = sample->sample_time;
+		PIOS_SENSORS_ReleaseSample(PIOS_SENSOR_ACCEL);
+		count++;
+	}
+
+	if (count > 1) {
+		float scale = 1.0f / count;
+		block->x *= scale;
+		block->y *= scale;
+		block->z *= scale;
+		block->temperature *= scale;
+
+		if (first_time != 0 && last_time != 0)
+			block->sample_time = first_time + (last_time - first_time) / 2;
+	}
+}
+
 /**
  * @brief Apply calibration and rotation to the raw accel data
  * @param[in] accels The raw accel data
  */
-static void update_accels(struct pios_sensor_accel_data *accels)
+static void update_accels(const struct pios_sensor_accel_data *accels)
 {
 	// Average and scale the accels before rotation
 	float accels_out[3] = {
@@ -346,6 +506,7 @@ static void update_accels(struct pios_sensor_accel_data *accels)
 	accelsData.z += z_accel_offset;
 
 	accelsData.temperature = accels->temperature;
+	PIOS_SENSORS_SetUpdateTime(PIOS_SENSOR_ACCEL, accels->sample_time);
 	AccelsSet(&accelsData);
 }
 
@@ -353,7 +514,7 @@ static void update_accels(struct pios_sensor_accel_data *accels)
  * @brief Apply calibration and rotation to the raw gyro data
  * @param[in] gyros The raw gyro data
  */
-static void update_gyros(struct pios_sensor_gyro_data *gyros)
+static void update_gyros(const struct pios_sensor_gyro_data *gyros)
 {
 	// Scale the gyros
 	float gyros_out[3] = {
@@ -367,6 +528,7 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 
 	// Update the bias due to the temperature
 	updateTemperatureComp(gyrosData.temperature, gyro_temp_bias);
+	gyro_temp_calibration_fit(gyrosData.temperature, gyros_out);
 
 	// Apply temperature bias correction before the rotation
 	if (bias_correct_gyro) {
@@ -405,15 +567,92 @@ static void update_gyros(struct pios_sensor_gyro_data *gyros)
 		}
 	}
 
+	if (notchSettings.Enable == GYRONOTCHSETTINGS_ENABLE_TRUE) {
+		// Time the samples, not the task, so scheduling jitter does not
+		// detune the notches
+		float dT = PIOS_DELAY_DiffuS2(last_gyro_time, gyros->sample_time) * 1.0e-6f;
+		last_gyro_time = gyros->sample_time;
+
+		// Gaps after a bad run are not the gyro rate
+		if (dT < SENSOR_PERIOD * 1.0e-3f)
+			gyro_dt = (gyro_dt > 0) ? 0.99f * gyro_dt + 0.01f * dT : dT;
+	}
+
+	if (notch_retune)
+		update_notches();
+
+	float rates[3] = {gyrosData.x, gyrosData.y, gyrosData.z};
+	notch_filter_apply(&gyro_notch, rates);
+	gyrosData.x = rates[0];
+	gyrosData.y = rates[1];
+	gyrosData.z = rates[2];
+
+#if defined(LATENCY_DIAGNOSTICS)
+	LatencyMonitorMark(LATENCY_STAGE_SENSORS);
+#endif
+
+	PIOS_SENSORS_SetUpdateTime(PIOS_SENSOR_GYRO, gyros->sample_time);
 	GyrosSet(&gyrosData);
 }
 
+/**
+ * @brief Move the gyro notches onto the strongest vibration peak
+ *
+ * Called from the sensor task, so the filter never changes while it runs.
+ * Peaks that are too weak or out of range take the notches out.
+ */
+static void update_notches(void)
+{
+	notch_retune = false;
+
+	float notches[NOTCH_FILTER_MAX_STAGES];
+	uint8_t num_notches = 0;
+
+	if (notchSettings.Enable == GYRONOTCHSETTINGS_ENABLE_TRUE && notchSettings.Q > 0 &&
+			gyro_dt > 0 && VibrationAnalysisBandsHandle() != NULL) {
+		float frequency[VIBRATIONANALYSISBANDS_PEAKFREQUENCY_NUMELEM];
+		float amplitude[VIBRATIONANALYSISBANDS_PEAKAMPLITUDE_NUMELEM];
+		VibrationAnalysisBandsPeakFrequencyGet(frequency);
+		VibrationAnalysisBandsPeakAmplitudeGet(amplitude);
+
+		// Motor noise has the same frequency on every axis, one peak
+		// is enough for all of them
+		float peak = 0;
+		float strongest = notchSettings.MinAmplitude;
+		for (uint8_t i = 0; i < VIBRATIONANALYSISBANDS_PEAKFREQUENCY_NUMELEM; i++) {
+			if (amplitude[i] >= strongest && frequency[i] >= notchSettings.MinFrequency &&
+					frequency[i] <= notchSettings.MaxFrequency) {
+				strongest = amplitude[i];
+				peak = frequency[i];
+			}
+		}
+
+		if (peak > 0) {
+			for (uint8_t h = 1; h <= notchSettings.Harmonics && num_notches < NOTCH_FILTER_MAX_STAGES; h++)
+				notches[num_notches++] = h * peak;
+		}
+	}
+
+	if (num_notches == 0 || notch_filter_set(&gyro_notch, notches, num_notches, 1.0f / gyro_dt, notchSettings.Q) <= 0)
+		notch_filter_init(&gyro_notch);
+}
+
+/**
+ * Retune the notches from the sensor task when a new peak came in
+ */
+static void notchPeakUpdatedCb(UAVObjEvent * objEv)
+{
+	notch_retune = true;
+}
+
 /**
  * @brief Apply calibration and rotation to the raw mag data
  * @param[in] mag The raw mag data
  */
-static void update_mags(struct pios_sensor_mag_data *mag)
+static void update_mags(const struct pios_sensor_mag_data *mag)
 {
+	mag_calibration_fit(mag);
+
 	float mags[3] = {
 	    mag->x * mag_scale[0] - mag_bias[0],
 	    mag->y * mag_scale[1] - mag_bias[1],
@@ -455,7 +694,7 @@ static void update_mags(struct pios_sensor_mag_data *mag)
  * Update the baro uavo from the data from the baro queue
  * @param [in] baro raw baro data
  */
-static void update_baro(struct pios_sensor_baro_data *baro)
+static void update_baro(const struct pios_sensor_baro_data *baro)
 {
 	// Check for Nan or infinity
 	if (IS_NOT_FINITE(baro->altitude) || IS_NOT_FINITE(baro->temperature) || IS_NOT_FINITE(baro->pressure)) {
@@ -476,7 +715,7 @@ static void update_baro(struct pios_sensor_baro_data *baro)
  * @param [in] optical_flow raw optical flow data
  */
 #if defined (PIOS_INCLUDE_OPTICALFLOW)
-void update_optical_flow(struct pios_sensor_optical_flow_data *optical_flow)
+static void update_optical_flow(const struct pios_sensor_optical_flow_data *optical_flow)
 {
 	OpticalFlowData opticalFlow;
 
@@ -486,6 +725,10 @@ void update_optical_flow(struct pios_sensor_optical_flow_data *optical_flow)
 
 	opticalFlow.Quality = optical_flow->quality;
 
+	// Lets the INS compensate for the age of the flow
+	PIOS_SENSORS_SetUpdateTime(PIOS_SENSOR_OPTICAL_FLOW,
+		optical_flow->sample_time ? optical_flow->sample_time : PIOS_DELAY_GetRaw());
+
 	OpticalFlowSet(&opticalFlow);
 }
 #endif /* PIOS_INCLUDE_OPTICALFLOW */
@@ -495,7 +738,7 @@ void update_optical_flow(struct pios_sensor_optical_flow_data *optical_flow)
  * @param [in] rangefinder raw rangefinder data
  */
 #if defined (PIOS_INCLUDE_RANGEFINDER)
-static void update_rangefinder(struct pios_sensor_rangefinder_data *rangefinder)
+static void update_rangefinder(const struct pios_sensor_rangefinder_data *rangefinder)
 {
 	RangefinderDistanceData rangefinderAltitude;
 	RangefinderDistanceGet(&rangefinderAltitude);
@@ -615,28 +858,25 @@ static void mag_calibration_fix_length(MagnetometerData *mag)
 	HomeLocationData homeLocation;
 	HomeLocationGet(&homeLocation);
 	
-	AttitudeActualData attitude;
-	AttitudeActualGet(&attitude);
+	struct attitude_derived attitude;
+	AttitudeCacheGet(&attitude);
 	
 	const float Rxy = sqrtf(homeLocation.Be[0]*homeLocation.Be[0] + homeLocation.Be[1]*homeLocation.Be[1]);
 	const float Rz = homeLocation.Be[2];
 	
 	const float rate = insSettings.MagBiasNullingRate;
-	float R[3][3];
 	float B_e[3];
 	float xy[2];
 	float delta[3];
 	
-	// Get the rotation matrix
-	Quaternion2R(&attitude.q1, R);
-	
 	// Rotate the mag into the NED frame
+	float (*R)[3] = attitude.Rbe;
 	B_e[0] = R[0][0] * mag->x + R[1][0] * mag->y + R[2][0] * mag->z;
 	B_e[1] = R[0][1] * mag->x + R[1][1] * mag->y + R[2][1] * mag->z;
 	B_e[2] = R[0][2] * mag->x + R[1][2] * mag->y + R[2][2] * mag->z;
 	
-	float cy = cosf(attitude.Yaw * DEG2RAD);
-	float sy = sinf(attitude.Yaw * DEG2RAD);
+	float cy = attitude.heading[0];
+	float sy = attitude.heading[1];
 	
 	xy[0] =  cy * B_e[0] + sy * B_e[1];
 	xy[1] = -sy * B_e[0] + cy * B_e[1];
@@ -655,6 +895,159 @@ static void mag_calibration_fix_length(MagnetometerData *mag)
 	}
 }
 
+/**
+ * Fit the hard and soft iron calibration to the raw mag data while flying
+ * and write it to @ref SensorSettings once the fit is confident, so changing
+ * the airframe does not need a calibration from the GCS. The settings are
+ * applied straight away and saved to flash after disarming.
+ * @param[in] mag The raw mag data in the sensor frame
+ */
+static void mag_calibration_fit(const struct pios_sensor_mag_data *mag)
+{
+	if (!mag_fit_enabled) {
+		mag_fit_state = MAG_FIT_OFF;
+		return;
+	}
+
+	HomeLocationData homeLocation;
+
+	switch (mag_fit_state) {
+	case MAG_FIT_OFF:
+	{
+		HomeLocationGet(&homeLocation);
+		float norm = MAG_FIT_NORM;
+		if (homeLocation.Set == HOMELOCATION_SET_TRUE)
+			norm = sqrtf(homeLocation.Be[0] * homeLocation.Be[0] + homeLocation.Be[1] * homeLocation.Be[1] +
+			             homeLocation.Be[2] * homeLocation.Be[2]);
+
+		mag_ellipsoid_init(&mag_fit, norm);
+		mag_fit_state = MAG_FIT_RUNNING;
+	}
+		break;
+
+	case MAG_FIT_RUNNING:
+	{
+		const float raw[3] = {mag->x, mag->y, mag->z};
+		if (!mag_ellipsoid_add(&mag_fit, raw) || !mag_ellipsoid_converged(&mag_fit))
+			break;
+
+		// Scale to the field of the home location when there is one, so the
+		// length matches what the attitude estimation expects
+		HomeLocationGet(&homeLocation);
+		float length = 0;
+		if (homeLocation.Set == HOMELOCATION_SET_TRUE)
+			length = sqrtf(homeLocation.Be[0] * homeLocation.Be[0] + homeLocation.Be[1] * homeLocation.Be[1] +
+			               homeLocation.Be[2] * homeLocation.Be[2]);
+
+		float bias[3], scale[3];
+		if (!mag_ellipsoid_solve(&mag_fit, length, bias, scale)) {
+			// Converged on something that is not a believable calibration
+			mag_fit_state = MAG_FIT_OFF;
+			break;
+		}
+
+		SensorSettingsData sensorSettings;
+		SensorSettingsGet(&sensorSettings);
+		sensorSettings.MagBias[SENSORSETTINGS_MAGBIAS_X] = bias[0];
+		sensorSettings.MagBias[SENSORSETTINGS_MAGBIAS_Y] = bias[1];
+		sensorSettings.MagBias[SENSORSETTINGS_MAGBIAS_Z] = bias[2];
+		sensorSettings.MagScale[SENSORSETTINGS_MAGSCALE_X] = scale[0];
+		sensorSettings.MagScale[SENSORSETTINGS_MAGSCALE_Y] = scale[1];
+		sensorSettings.MagScale[SENSORSETTINGS_MAGSCALE_Z] = scale[2];
+		SensorSettingsSet(&sensorSettings);
+
+		mag_fit_state = MAG_FIT_SAVE;
+	}
+		break;
+
+	case MAG_FIT_SAVE:
+	{
+		// Writing flash stalls the CPU, so leave it to the system module
+		// and only once on the ground
+		uint8_t armed;
+		FlightStatusArmedGet(&armed);
+		if (armed != FLIGHTSTATUS_ARMED_DISARMED)
+			break;
+
+		ObjectPersistenceData objper;
+		ObjectPersistenceGet(&objper);
+		objper.Operation = OBJECTPERSISTENCE_OPERATION_SAVE;
+		objper.Selection = OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT;
+		objper.ObjectID = SENSORSETTINGS_OBJID;
+		objper.InstanceID = 0;
+		ObjectPersistenceSet(&objper);
+
+		mag_fit_state = MAG_FIT_DONE;
+	}
+		break;
+
+	case MAG_FIT_DONE:
+		break;
+	}
+}
+
+/**
+ * Bin the raw gyro rates of the still board by temperature while it warms up
+ * and fit the temperature compensation on board, so it needs no data streamed
+ * to the GCS. The coefficients are written to @ref SensorSettings each time
+ * the fit improves and saved once the temperature stopped rising.
+ * @param[in] temperature Gyro temperature
+ * @param[in] gyros Scaled gyro rates in the sensor frame without any bias correction
+ */
+static void gyro_temp_calibration_fit(float temperature, const float gyros[3])
+{
+	if (!temp_fit_enabled) {
+		temp_fit_running = false;
+		return;
+	}
+
+	if (!temp_fit_running) {
+		temp_comp_fit_init(&temp_fit);
+		temp_fit_running = true;
+		temp_fit_unsaved = false;
+		temp_fit_last_bin = PIOS_Thread_Systime();
+	}
+
+	// Only a board sitting still on the ground measures its bias
+	uint8_t armed;
+	FlightStatusArmedGet(&armed);
+	if (armed != FLIGHTSTATUS_ARMED_DISARMED)
+		return;
+
+	if (fabsf(gyros[0]) > TEMP_FIT_MAX_RATE || fabsf(gyros[1]) > TEMP_FIT_MAX_RATE ||
+	    fabsf(gyros[2]) > TEMP_FIT_MAX_RATE)
+		return;
+
+	if (temp_comp_fit_add(&temp_fit, temperature, gyros)) {
+		temp_fit_last_bin = PIOS_Thread_Systime();
+
+		float coeffs[3][TEMP_COMP_FIT_ORDER + 1];
+		if (temp_comp_fit_range(&temp_fit) >= TEMP_FIT_MIN_RANGE &&
+		    temp_comp_fit_solve(&temp_fit, coeffs)) {
+			SensorSettingsData sensorSettings;
+			SensorSettingsGet(&sensorSettings);
+			for (int i = 0; i <= TEMP_COMP_FIT_ORDER; i++) {
+				sensorSettings.XGyroTempCoeff[i] = coeffs[0][i];
+				sensorSettings.YGyroTempCoeff[i] = coeffs[1][i];
+				sensorSettings.ZGyroTempCoeff[i] = coeffs[2][i];
+			}
+			SensorSettingsSet(&sensorSettings);
+			temp_fit_unsaved = true;
+		}
+	} else if (temp_fit_unsaved &&
+	           PIOS_Thread_Systime() - temp_fit_last_bin > TEMP_FIT_SETTLE_MS) {
+		// Writing flash stalls the CPU, so leave it to the system module
+		ObjectPersistenceData objper;
+		ObjectPersistenceGet(&objper);
+		objper.Operation = OBJECTPERSISTENCE_OPERATION_SAVE;
+		objper.Selection = OBJECTPERSISTENCE_SELECTION_SINGLEOBJECT;
+		objper.ObjectID = SENSORSETTINGS_OBJID;
+		objper.InstanceID = 0;
+		ObjectPersistenceSet(&objper);
+		temp_fit_unsaved = false;
+	}
+}
+
 /**
  * Locally cache some variables from the AtttitudeSettings object
  */
@@ -663,6 +1056,8 @@ static void settingsUpdatedCb(UAVObjEvent * objEv)
 	SensorSettingsData sensorSettings;
 	SensorSettingsGet(&sensorSettings);
 	INSSettingsGet(&insSettings);
+	GyroNotchSettingsGet(&notchSettings);
+	notch_retune = true;
 	
 	mag_bias[0] = sensorSettings.MagBias[SENSORSETTINGS_MAGBIAS_X];
 	mag_bias[1] = sensorSettings.MagBias[SENSORSETTINGS_MAGBIAS_Y];
@@ -693,6 +1088,10 @@ static void settingsUpdatedCb(UAVObjEvent * objEv)
 	gyro_coeff_z[3] =  sensorSettings.ZGyroTempCoeff[3];
 	z_accel_offset  =  sensorSettings.ZAccelOffset;
 
+	// Turning the fit off stops it, turning it back on starts a new one
+	mag_fit_enabled = (insSettings.MagOnboardCalibration == INSSETTINGS_MAGONBOARDCALIBRATION_TRUE);
+	temp_fit_enabled = (insSettings.GyroTempOnboardCalibration == INSSETTINGS_GYROTEMPONBOARDCALIBRATION_TRUE);
+
 	// Zero out any adaptive tracking
 	MagBiasData magBias;
 	MagBiasGet(&magBias);
@@ -0,0 +1,44 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Sensors Sensor acquisition module
+ * @{
+ *
+ * @file       sensors_replay.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Feeds the sensor objects of a log to the simulation
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SENSORS_REPLAY_H
+#define SENSORS_REPLAY_H
+
+//! The replay uses stdio, which needs more stack than the models
+#define REPLAY_STACK_SIZE_BYTES 32768
+
+void SensorsReplay(const char *log_name, const char *output_name);
+
+#endif /* SENSORS_REPLAY_H */
+
+/**
+ * @}
+ * @}
+ */
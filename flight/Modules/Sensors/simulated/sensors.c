@@ -53,7 +53,10 @@
 #include "ratedesired.h"
 #include "systemsettings.h"
 
+#include "sensors_replay.h"
+
 #include "coordinate_conversions.h"
+#include "attitude_cache.h"
 
 // Private constants
 #define STACK_SIZE_BYTES 1540
@@ -113,14 +116,15 @@ int32_t SensorsInitialize(void)
 int32_t SensorsStart(void)
 {
 	// Start main task
-	sensorsTaskHandle = PIOS_Thread_Create(SensorsTask, "Sensors", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	size_t stack_bytes = PIOS_SYS_ReplayLog() != NULL ? REPLAY_STACK_SIZE_BYTES : STACK_SIZE_BYTES;
+	sensorsTaskHandle = PIOS_Thread_Create(SensorsTask, "Sensors", stack_bytes, NULL, TASK_PRIORITY);
 	TaskMonitorAdd(TASKINFO_RUNNING_SENSORS, sensorsTaskHandle);
 	PIOS_WDG_RegisterFlag(PIOS_WDG_SENSORS);
 
 	return 0;
 }
 
-MODULE_INITCALL(SensorsInitialize, SensorsStart)
+MODULE_CRITICAL_INITCALL(SensorsInitialize, SensorsStart)
 
 /**
  * Simulated sensor task.  Run a model of the airframe and produce sensor values
@@ -129,6 +133,10 @@ int sensors_count;
 static void SensorsTask(void *parameters)
 {
 	AlarmsClear(SYSTEMALARMS_ALARM_SENSORS);
+
+	// Sensors from a log instead of a model
+	if (PIOS_SYS_ReplayLog() != NULL)
+		SensorsReplay(PIOS_SYS_ReplayLog(), PIOS_SYS_ReplayOutput());
 	
 //	HomeLocationData homeLocation;
 //	HomeLocationGet(&homeLocation);
@@ -1157,8 +1165,8 @@ static void magOffsetEstimation(MagnetometerData *mag)
 	HomeLocationData homeLocation;
 	HomeLocationGet(&homeLocation);
 	
-	AttitudeActualData attitude;
-	AttitudeActualGet(&attitude);
+	struct attitude_derived attitude;
+	AttitudeCacheGet(&attitude);
 	
 	MagBiasData magBias;
 	MagBiasGet(&magBias);
@@ -1172,21 +1180,18 @@ static void magOffsetEstimation(MagnetometerData *mag)
 	const float Rz = homeLocation.Be[2];
 	
 	const float rate = 0.01;
-	float R[3][3];
 	float B_e[3];
 	float xy[2];
 	float delta[3];
 	
-	// Get the rotation matrix
-	Quaternion2R(&attitude.q1, R);
-	
 	// Rotate the mag into the NED frame
+	float (*R)[3] = attitude.Rbe;
 	B_e[0] = R[0][0] * mag->x + R[1][0] * mag->y + R[2][0] * mag->z;
 	B_e[1] = R[0][1] * mag->x + R[1][1] * mag->y + R[2][1] * mag->z;
 	B_e[2] = R[0][2] * mag->x + R[1][2] * mag->y + R[2][2] * mag->z;
 	
-	float cy = cosf(attitude.Yaw * DEG2RAD);
-	float sy = sinf(attitude.Yaw * DEG2RAD);
+	float cy = attitude.heading[0];
+	float sy = attitude.heading[1];
 
 	xy[0] =  cy * B_e[0] + sy * B_e[1];
 	xy[1] = -sy * B_e[0] + cy * B_e[1];
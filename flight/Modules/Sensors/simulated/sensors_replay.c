@@ -0,0 +1,256 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup Sensors Sensor acquisition module
+ * @{
+ *
+ * @file       sensors_replay.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Feeds the sensor objects of a log to the simulation
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * Instead of running a model, the sensor objects of a GCS log are unpacked
+ * at the time they were logged, so that the Attitude module estimates the
+ * flight again. Run in lockstep this happens as fast as the host can go
+ * and gives the same result every time.
+ *
+ * Everything the estimators publish is written to another GCS log, with
+ * the times of the input log, so both can be read with the same tools.
+ */
+
+#include "openpilot.h"
+#include "pios_thread.h"
+#include "uavtalk.h"
+#include "sensors_replay.h"
+
+#include "accels.h"
+#include "attitudeactual.h"
+#include "baroairspeed.h"
+#include "baroaltitude.h"
+#include "gpsposition.h"
+#include "gpsvelocity.h"
+#include "gyros.h"
+#include "gyrosbias.h"
+#include "homelocation.h"
+#include "insstate.h"
+#include "magnetometer.h"
+#include "positionactual.h"
+#include "velocityactual.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Private constants
+
+//! Lines of the log header, up to the "##" divider
+#define LOG_HEADER_MAX_LINES 10
+
+//! Larger chunks mean the log is out of sync, like for the GCS replay
+#define LOG_MAX_DATA_SIZE 0xFFFF
+
+//! Time left for the estimators to finish with the last sensor updates
+#define REPLAY_DRAIN_MS 100
+
+// Private variables
+static FILE *output;
+static UAVTalkConnection output_connection;
+
+//! Log time minus system time, so the output has the times of the input
+static uint32_t time_offset;
+
+static uint8_t data[LOG_MAX_DATA_SIZE];
+static char line[256];
+
+// Private functions
+static bool copyHeader(FILE *log);
+static bool isReplayed(uint32_t obj_id);
+static void connectEstimate(UAVObjHandle obj);
+static void estimateUpdated(UAVObjEvent *ev);
+static int32_t writeOutput(uint8_t *buf, int32_t length);
+
+/**
+ * Replays a GCS log and exits the simulation at its end
+ * @param[in] log_name The .tll log to read the sensors from
+ * @param[in] output_name Where the estimated states are written
+ */
+void SensorsReplay(const char *log_name, const char *output_name)
+{
+	FILE *log = fopen(log_name, "rb");
+	if (log == NULL) {
+		fprintf(stderr, "Unable to open %s\n", log_name);
+		exit(1);
+	}
+
+	output = fopen(output_name, "wb");
+	if (output == NULL) {
+		fprintf(stderr, "Unable to create %s\n", output_name);
+		exit(1);
+	}
+
+	if (!copyHeader(log)) {
+		fprintf(stderr, "%s is not a GCS log\n", log_name);
+		exit(1);
+	}
+
+	// Nothing is ever answered on the input
+	UAVTalkConnection input = UAVTalkInitialize(NULL);
+	output_connection = UAVTalkInitialize(writeOutput);
+	PIOS_Assert(input && output_connection);
+
+	connectEstimate(AttitudeActualHandle());
+	connectEstimate(PositionActualHandle());
+	connectEstimate(VelocityActualHandle());
+	connectEstimate(GyrosBiasHandle());
+	connectEstimate(INSStateHandle());
+
+	uint32_t replay_start = PIOS_Thread_Systime();
+	uint32_t log_start = 0;
+	bool first = true;
+	uint32_t updates = 0;
+
+	uint32_t timestamp;
+	int64_t size;
+	while (fread(&timestamp, sizeof(timestamp), 1, log) == 1 &&
+	       fread(&size, sizeof(size), 1, log) == 1) {
+		// Resync on the next byte like the GCS replay does
+		if (size < 0 || size > LOG_MAX_DATA_SIZE) {
+			fseek(log, 1 - (long)(sizeof(timestamp) + sizeof(size)), SEEK_CUR);
+			continue;
+		}
+
+		if (fread(data, 1, size, log) != (size_t)size)
+			break;
+
+		if (first) {
+			log_start = timestamp;
+			time_offset = log_start - replay_start;
+			first = false;
+		}
+
+		// Hold the packet back until its time in the log comes
+		int32_t wait = (int32_t)(replay_start + (timestamp - log_start) - PIOS_Thread_Systime());
+		if (wait > 0)
+			PIOS_Thread_Sleep(wait);
+
+		PIOS_WDG_UpdateFlag(PIOS_WDG_SENSORS);
+
+		for (int64_t i = 0; i < size; i++) {
+			if (UAVTalkProcessInputStreamQuiet(input, data[i]) == UAVTALK_STATE_COMPLETE &&
+			    isReplayed(UAVTalkGetPacketObjId(input))) {
+				UAVTalkReceiveObject(input);
+				updates++;
+			}
+		}
+	}
+
+	PIOS_Thread_Sleep(REPLAY_DRAIN_MS);
+
+	UAVTalkSetOutputStream(output_connection, NULL);
+	fclose(log);
+	fclose(output);
+
+	printf("\nReplayed %u sensor updates of %s into %s\n", updates, log_name, output_name);
+	exit(0);
+}
+
+/**
+ * Copies the header of the log, so the output is read with the same UAVO
+ * definitions. Logs without a header start with the first packet.
+ * @return false if the header has no end
+ */
+static bool copyHeader(FILE *log)
+{
+	if (fgets(line, sizeof(line), log) == NULL)
+		return false;
+
+	if (strcmp(line, "Tau Labs git hash:\n") != 0) {
+		rewind(log);
+		return true;
+	}
+
+	fputs(line, output);
+	for (int i = 0; i < LOG_HEADER_MAX_LINES; i++) {
+		if (fgets(line, sizeof(line), log) == NULL)
+			return false;
+
+		fputs(line, output);
+		if (strcmp(line, "##\n") == 0)
+			return true;
+	}
+
+	return false;
+}
+
+/**
+ * The sensors and what the flight controller knew about where it was,
+ * everything else comes from the simulation
+ */
+static bool isReplayed(uint32_t obj_id)
+{
+	switch (obj_id) {
+	case ACCELS_OBJID:
+	case BAROAIRSPEED_OBJID:
+	case BAROALTITUDE_OBJID:
+	case GPSPOSITION_OBJID:
+	case GPSVELOCITY_OBJID:
+	case GYROS_OBJID:
+	case HOMELOCATION_OBJID:
+	case MAGNETOMETER_OBJID:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void connectEstimate(UAVObjHandle obj)
+{
+	// Objects the attitude filter in use doesn't need are never created
+	if (obj != NULL)
+		UAVObjConnectCallback(obj, estimateUpdated, EV_UPDATED);
+}
+
+static void estimateUpdated(UAVObjEvent *ev)
+{
+	UAVTalkSendObject(output_connection, ev->obj, ev->instId, false, 0);
+}
+
+/**
+ * Writes a packet to the output with the GCS log header: the time in ms
+ * and the size of the data
+ */
+static int32_t writeOutput(uint8_t *buf, int32_t length)
+{
+	uint32_t timestamp = PIOS_Thread_Systime() + time_offset;
+	int64_t size = length;
+
+	fwrite(&timestamp, sizeof(timestamp), 1, output);
+	fwrite(&size, sizeof(size), 1, output);
+	fwrite(buf, 1, length, output);
+
+	return length;
+}
+
+/**
+ * @}
+ * @}
+ */
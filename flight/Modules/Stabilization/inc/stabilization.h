@@ -35,7 +35,17 @@
 
 enum {ROLL,PITCH,YAW,MAX_AXES};
 
+//! A control cycle in system identification mode, for the Autotune module
+struct stabilization_ident_sample {
+	float gyro[MAX_AXES];		//!< Gyros as the loop used them, deg/s
+	float actuator[MAX_AXES];	//!< ActuatorDesired roll, pitch and yaw
+	float dT;			//!< Time since the cycle before, s
+};
+
+struct pios_ringbuf;
+
 int32_t StabilizationInitialize();
+void stabilization_ident_connect(struct pios_ringbuf *samples);
 
 #endif /* STABILIZATION_H */
 
@@ -41,6 +41,7 @@
 #include "stabilization.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "pios_ringbuf.h"
 
 #include "accels.h"
 #include "actuatordesired.h"
@@ -61,10 +62,16 @@
 #include "coordinate_conversions.h"
 #include "pid.h"
 #include "misc_math.h"
+#include "latencymonitor.h"
+#include "blackbox.h"
 
 // Includes for various stabilization algorithms
 #include "virtualflybar.h"
 
+#if defined(MODULE_Actuator_BUILTIN)
+#include "actuator.h"
+#endif
+
 // Private constants
 #define MAX_QUEUE_SIZE 1
 
@@ -111,6 +118,7 @@ static MWRateSettingsData mwrate_settings;
 static StabilizationSettingsData settings;
 static TrimAnglesData trimAngles;
 static struct pios_queue *queue;
+static struct pios_ringbuf *ident_samples;
 float axis_lock_accum[3] = {0,0,0};
 uint8_t max_axis_lock = 0;
 uint8_t max_axislock_rate = 0;
@@ -121,11 +129,21 @@ float vbar_decay = 0.991f;
 float gyro_alpha = 0.6;
 struct pid pids[PID_MAX];
 
+//! The inner loop of an axis as set up by the outer loop
+struct rate_loop {
+	struct pid *pid;	//!< Rate controller, NULL to hold the outer loop output
+	float rate_desired;
+	float scale;		//!< Applied to the controller output
+	float offset;		//!< Added to the controller output
+};
+static struct rate_loop rate_loops[MAX_AXES];
+
 volatile bool gyro_filter_updated = false;
 
 // Private functions
 static void stabilizationTask(void* parameters);
 static void zero_pids(void);
+static void rate_loop_set(uint8_t axis, struct pid *pid, float rate_desired, float scale, float offset);
 static void calculate_pids(void);
 static void SettingsUpdatedCb(UAVObjEvent * ev);
 
@@ -142,13 +160,16 @@ int32_t StabilizationStart()
 	//	AttitudeActualConnectQueue(queue);
 	GyrosConnectQueue(queue);
 	
-	// Connect settings callback
-	MWRateSettingsConnectCallback(SettingsUpdatedCb);
-	StabilizationSettingsConnectCallback(SettingsUpdatedCb);
-	TrimAnglesSettingsConnectCallback(SettingsUpdatedCb);
+	// Connect settings callback, these must not wait behind slow callbacks
+	UAVObjConnectCallbackPriority(MWRateSettingsHandle(), SettingsUpdatedCb,
+			EV_MASK_ALL_UPDATES, 0, EV_PRIORITY_HIGH);
+	UAVObjConnectCallbackPriority(StabilizationSettingsHandle(), SettingsUpdatedCb,
+			EV_MASK_ALL_UPDATES, 0, EV_PRIORITY_HIGH);
+	UAVObjConnectCallbackPriority(TrimAnglesSettingsHandle(), SettingsUpdatedCb,
+			EV_MASK_ALL_UPDATES, 0, EV_PRIORITY_HIGH);
 
 	// Start main task
-	taskHandle = PIOS_Thread_Create(stabilizationTask, "Stabilization", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	taskHandle = PIOS_Thread_Create_Fast(stabilizationTask, "Stabilization", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
 	TaskMonitorAdd(TASKINFO_RUNNING_STABILIZATION, taskHandle);
 	PIOS_WDG_RegisterFlag(PIOS_WDG_STABILIZATION);
 	return 0;
@@ -172,7 +193,17 @@ int32_t StabilizationInitialize()
 	return 0;
 }
 
-MODULE_INITCALL(StabilizationInitialize, StabilizationStart);
+MODULE_CRITICAL_INITCALL(StabilizationInitialize, StabilizationStart);
+
+/**
+ * Hand the cycles run in system identification mode to a consumer
+ * @param[in] samples Ring of struct stabilization_ident_sample, the
+ *            stabilization task is its only producer
+ */
+void stabilization_ident_connect(struct pios_ringbuf *samples)
+{
+	ident_samples = samples;
+}
 
 /**
  * Module task
@@ -205,6 +236,14 @@ static void stabilizationTask(void* parameters)
 
 	float dT_filtered = 0;
 
+	// State of the outer loop between its runs
+	float outer_dT = 0;
+	uint8_t outer_count = 0;
+	bool error = false;
+
+	// A flag to track which stabilization mode each axis is in
+	uint8_t previous_mode[MAX_AXES] = {255,255,255};
+
 	// Main task loop
 	zero_pids();
 	while(1) {
@@ -218,8 +257,11 @@ static void stabilizationTask(void* parameters)
 			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_WARNING);
 			continue;
 		}
-		
-		calculate_pids();
+
+#if defined(BLACKBOX_CAPTURE) || defined(MODULE_Actuator_BUILTIN)
+		// Start of the gyro to actuator output latency measurement
+		uint32_t sample_time = PIOS_DELAY_GetRaw();
+#endif
 
 		float dT = PIOS_DELAY_DiffuS(timeval) * 1.0e-6f;
 		timeval = PIOS_DELAY_GetRaw();
@@ -254,521 +296,567 @@ static void stabilizationTask(void* parameters)
 			gyro_filter_updated = false;
 		}
 
-		FlightStatusGet(&flightStatus);
-		StabilizationDesiredGet(&stabDesired);
-		AttitudeActualGet(&attitudeActual);
 		GyrosGet(&gyrosData);
-		ActuatorDesiredGet(&actuatorDesired);
+
+		static float gyro_filtered[3];
+		gyro_filtered[0] = gyro_filtered[0] * gyro_alpha + gyrosData.x * (1 - gyro_alpha);
+		gyro_filtered[1] = gyro_filtered[1] * gyro_alpha + gyrosData.y * (1 - gyro_alpha);
+		gyro_filtered[2] = gyro_filtered[2] * gyro_alpha + gyrosData.z * (1 - gyro_alpha);
+
+		// The attitude and flight mode loop only runs every
+		// OuterLoopDivider gyro updates and sets up the rate loop, which
+		// runs on every gyro update
+		if (outer_count == 0)
+			outer_dT = 0;
+		outer_dT += dT;
+		bool outer_loop = ++outer_count >= settings.OuterLoopDivider;
+
+		if (outer_loop) {
+			outer_count = 0;
+			error = false;
+
+			calculate_pids();
+
+			FlightStatusGet(&flightStatus);
+			StabilizationDesiredGet(&stabDesired);
+			AttitudeActualGet(&attitudeActual);
+			ActuatorDesiredGet(&actuatorDesired);
 #if defined(RATEDESIRED_DIAGNOSTICS)
-		RateDesiredGet(&rateDesired);
+			RateDesiredGet(&rateDesired);
 #endif
 
-		struct TrimmedAttitudeSetpoint {
-			float Roll;
-			float Pitch;
-			float Yaw;
-		} trimmedAttitudeSetpoint;
+			struct TrimmedAttitudeSetpoint {
+				float Roll;
+				float Pitch;
+				float Yaw;
+			} trimmedAttitudeSetpoint;
 		
-		// Mux in level trim values, and saturate the trimmed attitude setpoint.
-		trimmedAttitudeSetpoint.Roll = bound_min_max(
-			stabDesired.Roll + trimAngles.Roll,
-			-settings.RollMax + trimAngles.Roll,
-			 settings.RollMax + trimAngles.Roll);
-		trimmedAttitudeSetpoint.Pitch = bound_min_max(
-			stabDesired.Pitch + trimAngles.Pitch,
-			-settings.PitchMax + trimAngles.Pitch,
-			 settings.PitchMax + trimAngles.Pitch);
-		trimmedAttitudeSetpoint.Yaw = stabDesired.Yaw;
-
-		// For horizon mode we need to compute the desire attitude from an unscaled value and apply the
-		// trim offset. Also track the stick with the most deflection to choose rate blending.
-		horizonRateFraction = 0.0f;
-		if (stabDesired.StabilizationMode[ROLL] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) {
+			// Mux in level trim values, and saturate the trimmed attitude setpoint.
 			trimmedAttitudeSetpoint.Roll = bound_min_max(
-				stabDesired.Roll * settings.RollMax + trimAngles.Roll,
+				stabDesired.Roll + trimAngles.Roll,
 				-settings.RollMax + trimAngles.Roll,
 				 settings.RollMax + trimAngles.Roll);
-			horizonRateFraction = fabsf(stabDesired.Roll);
-		}
-		if (stabDesired.StabilizationMode[PITCH] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) {
 			trimmedAttitudeSetpoint.Pitch = bound_min_max(
-				stabDesired.Pitch * settings.PitchMax + trimAngles.Pitch,
+				stabDesired.Pitch + trimAngles.Pitch,
 				-settings.PitchMax + trimAngles.Pitch,
 				 settings.PitchMax + trimAngles.Pitch);
-			horizonRateFraction = MAX(horizonRateFraction, fabsf(stabDesired.Pitch));
-		}
-		if (stabDesired.StabilizationMode[YAW] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) {
-			trimmedAttitudeSetpoint.Yaw = stabDesired.Yaw * settings.YawMax;
-			horizonRateFraction = MAX(horizonRateFraction, fabsf(stabDesired.Yaw));
-		}
+			trimmedAttitudeSetpoint.Yaw = stabDesired.Yaw;
+
+			// For horizon mode we need to compute the desire attitude from an unscaled value and apply the
+			// trim offset. Also track the stick with the most deflection to choose rate blending.
+			horizonRateFraction = 0.0f;
+			if (stabDesired.StabilizationMode[ROLL] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) {
+				trimmedAttitudeSetpoint.Roll = bound_min_max(
+					stabDesired.Roll * settings.RollMax + trimAngles.Roll,
+					-settings.RollMax + trimAngles.Roll,
+					 settings.RollMax + trimAngles.Roll);
+				horizonRateFraction = fabsf(stabDesired.Roll);
+			}
+			if (stabDesired.StabilizationMode[PITCH] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) {
+				trimmedAttitudeSetpoint.Pitch = bound_min_max(
+					stabDesired.Pitch * settings.PitchMax + trimAngles.Pitch,
+					-settings.PitchMax + trimAngles.Pitch,
+					 settings.PitchMax + trimAngles.Pitch);
+				horizonRateFraction = MAX(horizonRateFraction, fabsf(stabDesired.Pitch));
+			}
+			if (stabDesired.StabilizationMode[YAW] == STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON) {
+				trimmedAttitudeSetpoint.Yaw = stabDesired.Yaw * settings.YawMax;
+				horizonRateFraction = MAX(horizonRateFraction, fabsf(stabDesired.Yaw));
+			}
 
-		// For weak leveling mode the attitude setpoint is the trim value (drifts back towards "0")
-		if (stabDesired.StabilizationMode[ROLL] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) {
-			trimmedAttitudeSetpoint.Roll = trimAngles.Roll;
-		}
-		if (stabDesired.StabilizationMode[PITCH] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) {
-			trimmedAttitudeSetpoint.Pitch = trimAngles.Pitch;
-		}
-		if (stabDesired.StabilizationMode[YAW] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) {
-			trimmedAttitudeSetpoint.Yaw = 0;
-		}
+			// For weak leveling mode the attitude setpoint is the trim value (drifts back towards "0")
+			if (stabDesired.StabilizationMode[ROLL] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) {
+				trimmedAttitudeSetpoint.Roll = trimAngles.Roll;
+			}
+			if (stabDesired.StabilizationMode[PITCH] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) {
+				trimmedAttitudeSetpoint.Pitch = trimAngles.Pitch;
+			}
+			if (stabDesired.StabilizationMode[YAW] == STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING) {
+				trimmedAttitudeSetpoint.Yaw = 0;
+			}
 
-		// Note we divide by the maximum limit here so the fraction ranges from 0 to 1 depending on
-		// how much is requested.
-		horizonRateFraction = bound_sym(horizonRateFraction, HORIZON_MODE_MAX_BLEND) / HORIZON_MODE_MAX_BLEND;
+			// Note we divide by the maximum limit here so the fraction ranges from 0 to 1 depending on
+			// how much is requested.
+			horizonRateFraction = bound_sym(horizonRateFraction, HORIZON_MODE_MAX_BLEND) / HORIZON_MODE_MAX_BLEND;
 
-		// Calculate the errors in each axis. The local error is used in the following modes:
-		//  ATTITUDE, HORIZON, WEAKLEVELING
-		float local_attitude_error[3];
-		local_attitude_error[0] = trimmedAttitudeSetpoint.Roll - attitudeActual.Roll;
-		local_attitude_error[1] = trimmedAttitudeSetpoint.Pitch - attitudeActual.Pitch;
-		local_attitude_error[2] = trimmedAttitudeSetpoint.Yaw - attitudeActual.Yaw;
+			// Calculate the errors in each axis. The local error is used in the following modes:
+			//  ATTITUDE, HORIZON, WEAKLEVELING
+			float local_attitude_error[3];
+			local_attitude_error[0] = trimmedAttitudeSetpoint.Roll - attitudeActual.Roll;
+			local_attitude_error[1] = trimmedAttitudeSetpoint.Pitch - attitudeActual.Pitch;
+			local_attitude_error[2] = trimmedAttitudeSetpoint.Yaw - attitudeActual.Yaw;
 		
-		// Wrap yaw error to [-180,180]
-		local_attitude_error[2] = circular_modulus_deg(local_attitude_error[2]);
+			// Wrap yaw error to [-180,180]
+			local_attitude_error[2] = circular_modulus_deg(local_attitude_error[2]);
 
-		static float gyro_filtered[3];
-		gyro_filtered[0] = gyro_filtered[0] * gyro_alpha + gyrosData.x * (1 - gyro_alpha);
-		gyro_filtered[1] = gyro_filtered[1] * gyro_alpha + gyrosData.y * (1 - gyro_alpha);
-		gyro_filtered[2] = gyro_filtered[2] * gyro_alpha + gyrosData.z * (1 - gyro_alpha);
+			//Run the selected stabilization algorithm on each axis:
+			for(uint8_t i=0; i< MAX_AXES; i++)
+			{
+				// Check whether this axis mode needs to be reinitialized
+				bool reinit = (stabDesired.StabilizationMode[i] != previous_mode[i]);
+				// The unscaled input (-1,1)
+				float *raw_input = &stabDesired.Roll;
+				previous_mode[i] = stabDesired.StabilizationMode[i];
+				// Axes that do not set up the rate loop hold their output
+				rate_loops[i].pid = NULL;
+				// Apply the selected control law
+				switch(stabDesired.StabilizationMode[i])
+				{
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_RATE:
+						if(reinit)
+							pids[PID_GROUP_RATE + i].iAccumulator = 0;
 
-		// A flag to track which stabilization mode each axis is in
-		static uint8_t previous_mode[MAX_AXES] = {255,255,255};
-		bool error = false;
+						// Store to rate desired variable for storing to UAVO
+						rateDesiredAxis[i] = bound_sym(stabDesiredAxis[i], settings.ManualRate[i]);
 
-		//Run the selected stabilization algorithm on each axis:
-		for(uint8_t i=0; i< MAX_AXES; i++)
-		{
-			// Check whether this axis mode needs to be reinitialized
-			bool reinit = (stabDesired.StabilizationMode[i] != previous_mode[i]);
-			// The unscaled input (-1,1)
-			float *raw_input = &stabDesired.Roll;
-			previous_mode[i] = stabDesired.StabilizationMode[i];
-			// Apply the selected control law
-			switch(stabDesired.StabilizationMode[i])
-			{
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_RATE:
-					if(reinit)
-						pids[PID_GROUP_RATE + i].iAccumulator = 0;
+						// Compute the inner loop
+						rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, 0);
 
-					// Store to rate desired variable for storing to UAVO
-					rateDesiredAxis[i] = bound_sym(stabDesiredAxis[i], settings.ManualRate[i]);
+						break;
 
-					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
+				case STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS:
+						// this implementation is based on the Openpilot/Librepilot Acro+ flightmode
+						// and our existing rate & MWRate flightmodes
+						if(reinit)
+								pids[PID_GROUP_RATE + i].iAccumulator = 0;
 
-					break;
+						// The factor for gyro suppression / mixing raw stick input into the output; scaled by raw stick input
+						float factor = fabsf(raw_input[i]) * settings.AcroInsanityFactor / 100;
 
-			case STABILIZATIONDESIRED_STABILIZATIONMODE_ACROPLUS:
-					// this implementation is based on the Openpilot/Librepilot Acro+ flightmode
-					// and our existing rate & MWRate flightmodes
-					if(reinit)
-							pids[PID_GROUP_RATE + i].iAccumulator = 0;
+						// Store to rate desired variable for storing to UAVO
+						rateDesiredAxis[i] = bound_sym(raw_input[i] * settings.ManualRate[i], settings.ManualRate[i]);
 
-					// The factor for gyro suppression / mixing raw stick input into the output; scaled by raw stick input
-					float factor = fabsf(raw_input[i]) * settings.AcroInsanityFactor / 100;
+						// Zero integral for aggressive maneuvers, like it is done for MWRate
+						if ((i < 2 && fabsf(gyro_filtered[i]) > 150.0f) ||
+												(i == 0 && fabsf(raw_input[i]) > 0.2f)) {
+								pids[PID_GROUP_RATE + i].iAccumulator = 0;
+								pids[PID_GROUP_RATE + i].i = 0;
+								}
 
-					// Store to rate desired variable for storing to UAVO
-					rateDesiredAxis[i] = bound_sym(raw_input[i] * settings.ManualRate[i], settings.ManualRate[i]);
+						// Compute the inner loop, mixed with the raw stick input
+						rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f - factor, factor * raw_input[i]);
 
-					// Zero integral for aggressive maneuvers, like it is done for MWRate
-					if ((i < 2 && fabsf(gyro_filtered[i]) > 150.0f) ||
-											(i == 0 && fabsf(raw_input[i]) > 0.2f)) {
+						break;
+				case STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE:
+						if(reinit) {
+							pids[PID_GROUP_ATT + i].iAccumulator = 0;
 							pids[PID_GROUP_RATE + i].iAccumulator = 0;
-							pids[PID_GROUP_RATE + i].i = 0;
-							}
+						}
 
-					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i], rateDesiredAxis[i], gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] = factor * raw_input[i] + (1.0f - factor) * actuatorDesiredAxis[i];
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i], 1.0f);
+						// Compute the outer loop
+						rateDesiredAxis[i] = pid_apply(&pids[PID_GROUP_ATT + i], local_attitude_error[i], outer_dT);
+						rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.MaximumRate[i]);
 
-					break;
-			case STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE:
-					if(reinit) {
-						pids[PID_GROUP_ATT + i].iAccumulator = 0;
-						pids[PID_GROUP_RATE + i].iAccumulator = 0;
-					}
+						// Compute the inner loop
+						rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, 0);
 
-					// Compute the outer loop
-					rateDesiredAxis[i] = pid_apply(&pids[PID_GROUP_ATT + i], local_attitude_error[i], dT);
-					rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.MaximumRate[i]);
+						break;
 
-					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR:
+						// Store for debugging output
+						rateDesiredAxis[i] = stabDesiredAxis[i];
 
-					break;
+						// Run a virtual flybar stabilization algorithm on this axis
+						stabilization_virtual_flybar(gyro_filtered[i], rateDesiredAxis[i], &actuatorDesiredAxis[i], outer_dT, reinit, i, &pids[PID_GROUP_VBAR + i], &settings);
 
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_VIRTUALBAR:
-					// Store for debugging output
-					rateDesiredAxis[i] = stabDesiredAxis[i];
+						break;
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING:
+					{
+						if (reinit)
+							pids[PID_GROUP_RATE + i].iAccumulator = 0;
 
-					// Run a virtual flybar stabilization algorithm on this axis
-					stabilization_virtual_flybar(gyro_filtered[i], rateDesiredAxis[i], &actuatorDesiredAxis[i], dT, reinit, i, &pids[PID_GROUP_VBAR + i], &settings);
+						float weak_leveling = local_attitude_error[i] * weak_leveling_kp;
+						weak_leveling = bound_sym(weak_leveling, weak_leveling_max);
 
-					break;
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_WEAKLEVELING:
-				{
-					if (reinit)
-						pids[PID_GROUP_RATE + i].iAccumulator = 0;
+						// Compute desired rate as input biased towards leveling
+						rateDesiredAxis[i] = stabDesiredAxis[i] + weak_leveling;
+						rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, 0);
 
-					float weak_leveling = local_attitude_error[i] * weak_leveling_kp;
-					weak_leveling = bound_sym(weak_leveling, weak_leveling_max);
+						break;
+					}
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK:
+						if (reinit)
+							pids[PID_GROUP_RATE + i].iAccumulator = 0;
 
-					// Compute desired rate as input biased towards leveling
-					rateDesiredAxis[i] = stabDesiredAxis[i] + weak_leveling;
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
+						if (fabsf(stabDesiredAxis[i]) > max_axislock_rate) {
+							// While getting strong commands act like rate mode
+							rateDesiredAxis[i] = bound_sym(stabDesiredAxis[i], settings.ManualRate[i]);
 
-					break;
-				}
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_AXISLOCK:
-					if (reinit)
-						pids[PID_GROUP_RATE + i].iAccumulator = 0;
+							// Reset accumulator
+							axis_lock_accum[i] = 0;
+						} else {
+							// For weaker commands or no command simply lock (almost) on no gyro change
+							axis_lock_accum[i] += (stabDesiredAxis[i] - gyro_filtered[i]) * outer_dT;
+							axis_lock_accum[i] = bound_sym(axis_lock_accum[i], max_axis_lock);
 
-					if (fabsf(stabDesiredAxis[i]) > max_axislock_rate) {
-						// While getting strong commands act like rate mode
-						rateDesiredAxis[i] = bound_sym(stabDesiredAxis[i], settings.ManualRate[i]);
+							// Compute the inner loop
+							float tmpRateDesired = pid_apply(&pids[PID_GROUP_ATT + i], axis_lock_accum[i], outer_dT);
+							rateDesiredAxis[i] = bound_sym(tmpRateDesired, settings.MaximumRate[i]);
+						}
 
-						// Reset accumulator
-						axis_lock_accum[i] = 0;
-					} else {
-						// For weaker commands or no command simply lock (almost) on no gyro change
-						axis_lock_accum[i] += (stabDesiredAxis[i] - gyro_filtered[i]) * dT;
-						axis_lock_accum[i] = bound_sym(axis_lock_accum[i], max_axis_lock);
+						rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, 0);
 
-						// Compute the inner loop
-						float tmpRateDesired = pid_apply(&pids[PID_GROUP_ATT + i], axis_lock_accum[i], dT);
-						rateDesiredAxis[i] = bound_sym(tmpRateDesired, settings.MaximumRate[i]);
-					}
+						break;
 
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON:
+						if(reinit) {
+							pids[PID_GROUP_RATE + i].iAccumulator = 0;
+						}
 
-					break;
+						// Do not allow outer loop integral to wind up in this mode since the controller
+						// is often disengaged.
+						pids[PID_GROUP_ATT + i].iAccumulator = 0;
 
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_HORIZON:
-					if(reinit) {
-						pids[PID_GROUP_RATE + i].iAccumulator = 0;
-					}
+						// Compute the outer loop for the attitude control
+						float rateDesiredAttitude = pid_apply(&pids[PID_GROUP_ATT + i], local_attitude_error[i], outer_dT);
+						// Compute the desire rate for a rate control
+						float rateDesiredRate = raw_input[i] * settings.ManualRate[i];
 
-					// Do not allow outer loop integral to wind up in this mode since the controller
-					// is often disengaged.
-					pids[PID_GROUP_ATT + i].iAccumulator = 0;
+						// Blend from one rate to another. The maximum of all stick positions is used for the
+						// amount so that when one axis goes completely to rate the other one does too. This
+						// prevents doing flips while one axis tries to stay in attitude mode.
+						rateDesiredAxis[i] = rateDesiredAttitude * (1.0f-horizonRateFraction) + rateDesiredRate * horizonRateFraction;
+						rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.ManualRate[i]);
 
-					// Compute the outer loop for the attitude control
-					float rateDesiredAttitude = pid_apply(&pids[PID_GROUP_ATT + i], local_attitude_error[i], dT);
-					// Compute the desire rate for a rate control
-					float rateDesiredRate = raw_input[i] * settings.ManualRate[i];
+						// Compute the inner loop
+						rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, 0);
 
-					// Blend from one rate to another. The maximum of all stick positions is used for the
-					// amount so that when one axis goes completely to rate the other one does too. This
-					// prevents doing flips while one axis tries to stay in attitude mode.
-					rateDesiredAxis[i] = rateDesiredAttitude * (1.0f-horizonRateFraction) + rateDesiredRate * horizonRateFraction;
-					rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.ManualRate[i]);
+						break;
 
-					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE:
+					{
+						if(reinit) {
+							pids[PID_GROUP_MWR + i].iAccumulator = 0;
+						}
 
-					break;
+						/*
+						 Conversion from MultiWii PID settings to our units.
+							Kp = Kp_mw * 4 / 80 / 500
+							Kd = Kd_mw * looptime * 1e-6 * 4 * 3 / 32 / 500
+							Ki = Ki_mw * 4 / 125 / 64 / (looptime * 1e-6) / 500
+
+							These values will just be approximate and should help
+							you get started.
+						*/
+
+						// The unscaled input (-1,1) - note in MW this is from (-500,500)
+						float *raw_input = &stabDesired.Roll;
+
+						// dynamic PIDs are scaled both by throttle and stick position
+						float scale = (i == 0 || i == 1) ? mwrate_settings.RollPitchRate : mwrate_settings.YawRate;
+						float pid_scale = (100.0f - scale * fabsf(raw_input[i])) / 100.0f;
+						float dynP8 = pids[PID_GROUP_MWR + i].p * pid_scale;
+						float dynD8 = pids[PID_GROUP_MWR + i].d * pid_scale;
+						// these terms are used by the integral loop this proportional term is scaled by throttle (this is different than MW
+						// that does not apply scale 
+						float cfgP8 = pids[PID_GROUP_MWR + i].p;
+						float cfgI8 = pids[PID_GROUP_MWR + i].i;
+
+						// Dynamically adjust PID settings
+						struct pid mw_pid;
+						mw_pid.p = 0;      // use zero Kp here because of strange setpoint. applied later.
+						mw_pid.d = dynD8;
+						mw_pid.i = cfgI8;
+						mw_pid.iLim = pids[PID_GROUP_MWR + i].iLim;
+						mw_pid.iAccumulator = pids[PID_GROUP_MWR + i].iAccumulator;
+						mw_pid.lastErr = pids[PID_GROUP_MWR + i].lastErr;
+						mw_pid.lastDer = pids[PID_GROUP_MWR + i].lastDer;
+
+						// Zero integral for aggressive maneuvers
+	 					if ((i < 2 && fabsf(gyro_filtered[i]) > 150.0f) ||
+	 					    (i == 0 && fabsf(raw_input[i]) > 0.2f)) {
+							mw_pid.iAccumulator = 0;
+							mw_pid.i = 0;
+						}
 
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_MWRATE:
-				{
-					if(reinit) {
-						pids[PID_GROUP_MWR + i].iAccumulator = 0;
-					}
+						// Apply controller as if we want zero change, then add stick input afterwards
+						actuatorDesiredAxis[i] = pid_apply_setpoint(&mw_pid,  raw_input[i] / cfgP8,  gyro_filtered[i], outer_dT);
+						actuatorDesiredAxis[i] += raw_input[i];             // apply input
+						actuatorDesiredAxis[i] -= dynP8 * gyro_filtered[i]; // apply Kp term
+						actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
 
-					/*
-					 Conversion from MultiWii PID settings to our units.
-						Kp = Kp_mw * 4 / 80 / 500
-						Kd = Kd_mw * looptime * 1e-6 * 4 * 3 / 32 / 500
-						Ki = Ki_mw * 4 / 125 / 64 / (looptime * 1e-6) / 500
-
-						These values will just be approximate and should help
-						you get started.
-					*/
-
-					// The unscaled input (-1,1) - note in MW this is from (-500,500)
-					float *raw_input = &stabDesired.Roll;
-
-					// dynamic PIDs are scaled both by throttle and stick position
-					float scale = (i == 0 || i == 1) ? mwrate_settings.RollPitchRate : mwrate_settings.YawRate;
-					float pid_scale = (100.0f - scale * fabsf(raw_input[i])) / 100.0f;
-					float dynP8 = pids[PID_GROUP_MWR + i].p * pid_scale;
-					float dynD8 = pids[PID_GROUP_MWR + i].d * pid_scale;
-					// these terms are used by the integral loop this proportional term is scaled by throttle (this is different than MW
-					// that does not apply scale 
-					float cfgP8 = pids[PID_GROUP_MWR + i].p;
-					float cfgI8 = pids[PID_GROUP_MWR + i].i;
-
-					// Dynamically adjust PID settings
-					struct pid mw_pid;
-					mw_pid.p = 0;      // use zero Kp here because of strange setpoint. applied later.
-					mw_pid.d = dynD8;
-					mw_pid.i = cfgI8;
-					mw_pid.iLim = pids[PID_GROUP_MWR + i].iLim;
-					mw_pid.iAccumulator = pids[PID_GROUP_MWR + i].iAccumulator;
-					mw_pid.lastErr = pids[PID_GROUP_MWR + i].lastErr;
-					mw_pid.lastDer = pids[PID_GROUP_MWR + i].lastDer;
-
-					// Zero integral for aggressive maneuvers
- 					if ((i < 2 && fabsf(gyro_filtered[i]) > 150.0f) ||
- 					    (i == 0 && fabsf(raw_input[i]) > 0.2f)) {
-						mw_pid.iAccumulator = 0;
-						mw_pid.i = 0;
+						// Store PID accumulators for next cycle
+						pids[PID_GROUP_MWR + i].iAccumulator = mw_pid.iAccumulator;
+						pids[PID_GROUP_MWR + i].lastErr = mw_pid.lastErr;
+						pids[PID_GROUP_MWR + i].lastDer = mw_pid.lastDer;
 					}
+						break;
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT:
+						if(reinit) {
+							pids[PID_GROUP_ATT + i].iAccumulator = 0;
+							pids[PID_GROUP_RATE + i].iAccumulator = 0;
+						}
 
-					// Apply controller as if we want zero change, then add stick input afterwards
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&mw_pid,  raw_input[i] / cfgP8,  gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] += raw_input[i];             // apply input
-					actuatorDesiredAxis[i] -= dynP8 * gyro_filtered[i]; // apply Kp term
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
+						static uint32_t ident_iteration = 0;
+						static float ident_offsets[3] = {0};
+
+						if (PIOS_DELAY_DiffuS(system_ident_timeval) / 1000.0f > SYSTEM_IDENT_PERIOD && SystemIdentHandle()) {
+							ident_iteration++;
+							system_ident_timeval = PIOS_DELAY_GetRaw();
+
+							SystemIdentData systemIdent;
+							SystemIdentGet(&systemIdent);
+
+							const float SCALE_BIAS = 7.1f;
+							float roll_scale = expf(SCALE_BIAS - systemIdent.Beta[SYSTEMIDENT_BETA_ROLL]);
+							float pitch_scale = expf(SCALE_BIAS - systemIdent.Beta[SYSTEMIDENT_BETA_PITCH]);
+							float yaw_scale = expf(SCALE_BIAS - systemIdent.Beta[SYSTEMIDENT_BETA_YAW]);
+
+							if (roll_scale > 0.25f)
+								roll_scale = 0.25f;
+							if (pitch_scale > 0.25f)
+								pitch_scale = 0.25f;
+							if (yaw_scale > 0.25f)
+								yaw_scale = 0.25f;
+
+							switch(ident_iteration & 0x07) {
+								case 0:
+									ident_offsets[0] = 0;
+									ident_offsets[1] = 0;
+									ident_offsets[2] = yaw_scale;
+									break;
+								case 1:
+									ident_offsets[0] = roll_scale;
+									ident_offsets[1] = 0;
+									ident_offsets[2] = 0;
+									break;
+								case 2:
+									ident_offsets[0] = 0;
+									ident_offsets[1] = 0;
+									ident_offsets[2] = -yaw_scale;
+									break;
+								case 3:
+									ident_offsets[0] = -roll_scale;
+									ident_offsets[1] = 0;
+									ident_offsets[2] = 0;
+									break;
+								case 4:
+									ident_offsets[0] = 0;
+									ident_offsets[1] = 0;
+									ident_offsets[2] = yaw_scale;
+									break;
+								case 5:
+									ident_offsets[0] = 0;
+									ident_offsets[1] = pitch_scale;
+									ident_offsets[2] = 0;
+									break;
+								case 6:
+									ident_offsets[0] = 0;
+									ident_offsets[1] = 0;
+									ident_offsets[2] = -yaw_scale;
+									break;
+								case 7:
+									ident_offsets[0] = 0;
+									ident_offsets[1] = -pitch_scale;
+									ident_offsets[2] = 0;
+									break;
+							}
+						}
 
-					// Store PID accumulators for next cycle
-					pids[PID_GROUP_MWR + i].iAccumulator = mw_pid.iAccumulator;
-					pids[PID_GROUP_MWR + i].lastErr = mw_pid.lastErr;
-					pids[PID_GROUP_MWR + i].lastDer = mw_pid.lastDer;
-				}
-					break;
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT:
-					if(reinit) {
-						pids[PID_GROUP_ATT + i].iAccumulator = 0;
-						pids[PID_GROUP_RATE + i].iAccumulator = 0;
-					}
+						if (i == ROLL || i == PITCH) {
+							// Compute the outer loop
+							rateDesiredAxis[i] = pid_apply(&pids[PID_GROUP_ATT + i], local_attitude_error[i], outer_dT);
+							rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.MaximumRate[i]);
 
-					static uint32_t ident_iteration = 0;
-					static float ident_offsets[3] = {0};
-
-					if (PIOS_DELAY_DiffuS(system_ident_timeval) / 1000.0f > SYSTEM_IDENT_PERIOD && SystemIdentHandle()) {
-						ident_iteration++;
-						system_ident_timeval = PIOS_DELAY_GetRaw();
-
-						SystemIdentData systemIdent;
-						SystemIdentGet(&systemIdent);
-
-						const float SCALE_BIAS = 7.1f;
-						float roll_scale = expf(SCALE_BIAS - systemIdent.Beta[SYSTEMIDENT_BETA_ROLL]);
-						float pitch_scale = expf(SCALE_BIAS - systemIdent.Beta[SYSTEMIDENT_BETA_PITCH]);
-						float yaw_scale = expf(SCALE_BIAS - systemIdent.Beta[SYSTEMIDENT_BETA_YAW]);
-
-						if (roll_scale > 0.25f)
-							roll_scale = 0.25f;
-						if (pitch_scale > 0.25f)
-							pitch_scale = 0.25f;
-						if (yaw_scale > 0.25f)
-							yaw_scale = 0.25f;
-
-						switch(ident_iteration & 0x07) {
-							case 0:
-								ident_offsets[0] = 0;
-								ident_offsets[1] = 0;
-								ident_offsets[2] = yaw_scale;
-								break;
-							case 1:
-								ident_offsets[0] = roll_scale;
-								ident_offsets[1] = 0;
-								ident_offsets[2] = 0;
-								break;
-							case 2:
-								ident_offsets[0] = 0;
-								ident_offsets[1] = 0;
-								ident_offsets[2] = -yaw_scale;
-								break;
-							case 3:
-								ident_offsets[0] = -roll_scale;
-								ident_offsets[1] = 0;
-								ident_offsets[2] = 0;
-								break;
-							case 4:
-								ident_offsets[0] = 0;
-								ident_offsets[1] = 0;
-								ident_offsets[2] = yaw_scale;
-								break;
-							case 5:
-								ident_offsets[0] = 0;
-								ident_offsets[1] = pitch_scale;
-								ident_offsets[2] = 0;
-								break;
-							case 6:
-								ident_offsets[0] = 0;
-								ident_offsets[1] = 0;
-								ident_offsets[2] = -yaw_scale;
-								break;
-							case 7:
-								ident_offsets[0] = 0;
-								ident_offsets[1] = -pitch_scale;
-								ident_offsets[2] = 0;
-								break;
+							// Compute the inner loop
+							rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, ident_offsets[i]);
+						} else {
+							// Get the desired rate. yaw is always in rate mode in system ident.
+							rateDesiredAxis[i] = bound_sym(stabDesiredAxis[i], settings.ManualRate[i]);
+
+							// Compute the inner loop only for yaw
+							rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, ident_offsets[i]);
 						}
-					}
 
-					if (i == ROLL || i == PITCH) {
-						// Compute the outer loop
-						rateDesiredAxis[i] = pid_apply(&pids[PID_GROUP_ATT + i], local_attitude_error[i], dT);
-						rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.MaximumRate[i]);
+						break;
 
-						// Compute the inner loop
-						actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-						actuatorDesiredAxis[i] += ident_offsets[i];
-						actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
-					} else {
-						// Get the desired rate. yaw is always in rate mode in system ident.
-						rateDesiredAxis[i] = bound_sym(stabDesiredAxis[i], settings.ManualRate[i]);
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_COORDINATEDFLIGHT:
+						switch (i) {
+							case YAW:
+								if (reinit) {
+									pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
+									pids[PID_RATE_YAW].iAccumulator = 0;
+									axis_lock_accum[YAW] = 0;
+								}
 
-						// Compute the inner loop only for yaw
-						actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-						actuatorDesiredAxis[i] += ident_offsets[i];
-						actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);						
-					}
+								//If we are not in roll attitude mode, trigger an error
+								if (stabDesired.StabilizationMode[ROLL] != STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE)
+								{
+									error = true;
+									break ;
+								}
 
-					break;
+								if (fabsf(stabDesired.Yaw) < COORDINATED_FLIGHT_MAX_YAW_THRESHOLD) { //If yaw is within the deadband...
+									if (fabsf(stabDesired.Roll) > COORDINATED_FLIGHT_MIN_ROLL_THRESHOLD) { // We're requesting more roll than the threshold
+										float accelsDataY;
+										AccelsyGet(&accelsDataY);
 
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_COORDINATEDFLIGHT:
-					switch (i) {
-						case YAW:
-							if (reinit) {
-								pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
-								pids[PID_RATE_YAW].iAccumulator = 0;
-								axis_lock_accum[YAW] = 0;
-							}
+										//Reset integral if we have changed roll to opposite direction from rudder. This implies that we have changed desired turning direction.
+										if ((stabDesired.Roll > 0 && actuatorDesiredAxis[YAW] < 0) ||
+												(stabDesired.Roll < 0 && actuatorDesiredAxis[YAW] > 0)){
+											pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
+										}
 
-							//If we are not in roll attitude mode, trigger an error
-							if (stabDesired.StabilizationMode[ROLL] != STABILIZATIONDESIRED_STABILIZATIONMODE_ATTITUDE)
-							{
-								error = true;
-								break ;
-							}
+										// Coordinate flight can simply be seen as ensuring that there is no lateral acceleration in the
+										// body frame. As such, we use the (noisy) accelerometer data as our measurement. Ideally, at
+										// some point in the future we will estimate acceleration and then we can use the estimated value
+										// instead of the measured value.
+										float errorSlip = -accelsDataY;
 
-							if (fabsf(stabDesired.Yaw) < COORDINATED_FLIGHT_MAX_YAW_THRESHOLD) { //If yaw is within the deadband...
-								if (fabsf(stabDesired.Roll) > COORDINATED_FLIGHT_MIN_ROLL_THRESHOLD) { // We're requesting more roll than the threshold
-									float accelsDataY;
-									AccelsyGet(&accelsDataY);
+										float command = pid_apply(&pids[PID_COORDINATED_FLIGHT_YAW], errorSlip, outer_dT);
+										actuatorDesiredAxis[YAW] = bound_sym(command ,1.0);
 
-									//Reset integral if we have changed roll to opposite direction from rudder. This implies that we have changed desired turning direction.
-									if ((stabDesired.Roll > 0 && actuatorDesiredAxis[YAW] < 0) ||
-											(stabDesired.Roll < 0 && actuatorDesiredAxis[YAW] > 0)){
-										pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
-									}
+										// Reset axis-lock integrals
+										pids[PID_RATE_YAW].iAccumulator = 0;
+										axis_lock_accum[YAW] = 0;
+									} else if (fabsf(stabDesired.Roll) <= COORDINATED_FLIGHT_MIN_ROLL_THRESHOLD) { // We're requesting less roll than the threshold
+										// Axis lock on no gyro change
+										axis_lock_accum[YAW] += (0 - gyro_filtered[YAW]) * outer_dT;
+
+										rateDesiredAxis[YAW] = pid_apply(&pids[PID_ATT_YAW], axis_lock_accum[YAW], outer_dT);
+										rateDesiredAxis[YAW] = bound_sym(rateDesiredAxis[YAW], settings.MaximumRate[YAW]);
 
-									// Coordinate flight can simply be seen as ensuring that there is no lateral acceleration in the
-									// body frame. As such, we use the (noisy) accelerometer data as our measurement. Ideally, at
-									// some point in the future we will estimate acceleration and then we can use the estimated value
-									// instead of the measured value.
-									float errorSlip = -accelsDataY;
+										rate_loop_set(YAW, &pids[PID_RATE_YAW], rateDesiredAxis[YAW], 1.0f, 0);
 
-									float command = pid_apply(&pids[PID_COORDINATED_FLIGHT_YAW], errorSlip, dT);
-									actuatorDesiredAxis[YAW] = bound_sym(command ,1.0);
+										// Reset coordinated-flight integral
+										pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
+									}
+								} else { //... yaw is outside the deadband. Pass the manual input directly to the actuator.
+									actuatorDesiredAxis[YAW] = bound_sym(stabDesiredAxis[YAW], 1.0);
 
-									// Reset axis-lock integrals
+									// Reset all integrals
+									pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
 									pids[PID_RATE_YAW].iAccumulator = 0;
 									axis_lock_accum[YAW] = 0;
-								} else if (fabsf(stabDesired.Roll) <= COORDINATED_FLIGHT_MIN_ROLL_THRESHOLD) { // We're requesting less roll than the threshold
-									// Axis lock on no gyro change
-									axis_lock_accum[YAW] += (0 - gyro_filtered[YAW]) * dT;
+								}
+								break;
+							case ROLL:
+							case PITCH:
+							default:
+								//Coordinated Flight has no effect in these modes. Trigger a configuration error.
+								error = true;
+								break;
+						}
 
-									rateDesiredAxis[YAW] = pid_apply(&pids[PID_ATT_YAW], axis_lock_accum[YAW], dT);
-									rateDesiredAxis[YAW] = bound_sym(rateDesiredAxis[YAW], settings.MaximumRate[YAW]);
+						break;
 
-									actuatorDesiredAxis[YAW] = pid_apply_setpoint(&pids[PID_RATE_YAW],  rateDesiredAxis[YAW],  gyro_filtered[YAW], dT);
-									actuatorDesiredAxis[YAW] = bound_sym(actuatorDesiredAxis[YAW],1.0f);
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_POI:
+						// The sanity check enforces this is only selectable for Yaw
+						// for a gimbal you can select pitch too.
+						if(reinit) {
+							pids[PID_GROUP_ATT + i].iAccumulator = 0;
+							pids[PID_GROUP_RATE + i].iAccumulator = 0;
+						}
 
-									// Reset coordinated-flight integral
-									pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
+						float error;
+						float angle;
+						if (CameraDesiredHandle()) {
+							switch(i) {
+							case PITCH:
+								CameraDesiredDeclinationGet(&angle);
+								error = circular_modulus_deg(angle - attitudeActual.Pitch);
+								break;
+							case ROLL:
+							{
+								uint8_t roll_fraction = 0;
+#ifdef GIMBAL
+								if (BrushlessGimbalSettingsHandle()) {
+									BrushlessGimbalSettingsRollFractionGet(&roll_fraction);
 								}
-							} else { //... yaw is outside the deadband. Pass the manual input directly to the actuator.
-								actuatorDesiredAxis[YAW] = bound_sym(stabDesiredAxis[YAW], 1.0);
+#endif /* GIMBAL */
 
-								// Reset all integrals
-								pids[PID_COORDINATED_FLIGHT_YAW].iAccumulator = 0;
-								pids[PID_RATE_YAW].iAccumulator = 0;
-								axis_lock_accum[YAW] = 0;
+								// For ROLL POI mode we track the FC roll angle (scaled) to
+								// allow keeping some motion
+								CameraDesiredRollGet(&angle);
+								angle *= roll_fraction / 100.0f;
+								error = circular_modulus_deg(angle - attitudeActual.Roll);
+							}
+								break;
+							case YAW:
+								CameraDesiredBearingGet(&angle);
+								error = circular_modulus_deg(angle - attitudeActual.Yaw);
+								break;
+							default:
+								error = true;
 							}
-							break;
-						case ROLL:
-						case PITCH:
-						default:
-							//Coordinated Flight has no effect in these modes. Trigger a configuration error.
+						} else
 							error = true;
-							break;
-					}
 
-					break;
-
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_POI:
-					// The sanity check enforces this is only selectable for Yaw
-					// for a gimbal you can select pitch too.
-					if(reinit) {
-						pids[PID_GROUP_ATT + i].iAccumulator = 0;
-						pids[PID_GROUP_RATE + i].iAccumulator = 0;
-					}
+						// Compute the outer loop
+						rateDesiredAxis[i] = pid_apply(&pids[PID_GROUP_ATT + i], error, outer_dT);
+						rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.PoiMaximumRate[i]);
 
-					float error;
-					float angle;
-					if (CameraDesiredHandle()) {
-						switch(i) {
-						case PITCH:
-							CameraDesiredDeclinationGet(&angle);
-							error = circular_modulus_deg(angle - attitudeActual.Pitch);
-							break;
-						case ROLL:
-						{
-							uint8_t roll_fraction = 0;
-#ifdef GIMBAL
-							if (BrushlessGimbalSettingsHandle()) {
-								BrushlessGimbalSettingsRollFractionGet(&roll_fraction);
-							}
-#endif /* GIMBAL */
+						// Compute the inner loop
+						rate_loop_set(i, &pids[PID_GROUP_RATE + i], rateDesiredAxis[i], 1.0f, 0);
 
-							// For ROLL POI mode we track the FC roll angle (scaled) to
-							// allow keeping some motion
-							CameraDesiredRollGet(&angle);
-							angle *= roll_fraction / 100.0f;
-							error = circular_modulus_deg(angle - attitudeActual.Roll);
-						}
-							break;
-						case YAW:
-							CameraDesiredBearingGet(&angle);
-							error = circular_modulus_deg(angle - attitudeActual.Yaw);
-							break;
-						default:
-							error = true;
-						}
-					} else
+						break;
+					case STABILIZATIONDESIRED_STABILIZATIONMODE_NONE:
+						actuatorDesiredAxis[i] = bound_sym(stabDesiredAxis[i],1.0f);
+						break;
+					default:
 						error = true;
-
-					// Compute the outer loop
-					rateDesiredAxis[i] = pid_apply(&pids[PID_GROUP_ATT + i], error, dT);
-					rateDesiredAxis[i] = bound_sym(rateDesiredAxis[i], settings.PoiMaximumRate[i]);
-
-					// Compute the inner loop
-					actuatorDesiredAxis[i] = pid_apply_setpoint(&pids[PID_GROUP_RATE + i],  rateDesiredAxis[i],  gyro_filtered[i], dT);
-					actuatorDesiredAxis[i] = bound_sym(actuatorDesiredAxis[i],1.0f);
-
-					break;
-				case STABILIZATIONDESIRED_STABILIZATIONMODE_NONE:
-					actuatorDesiredAxis[i] = bound_sym(stabDesiredAxis[i],1.0f);
-					break;
-				default:
-					error = true;
-					break;
+						break;
+				}
 			}
-		}
 
-		if (settings.VbarPiroComp == STABILIZATIONSETTINGS_VBARPIROCOMP_TRUE)
-			stabilization_virtual_flybar_pirocomp(gyro_filtered[2], dT);
+			if (settings.VbarPiroComp == STABILIZATIONSETTINGS_VBARPIROCOMP_TRUE)
+				stabilization_virtual_flybar_pirocomp(gyro_filtered[2], outer_dT);
 
 #if defined(RATEDESIRED_DIAGNOSTICS)
-		RateDesiredSet(&rateDesired);
+			RateDesiredSet(&rateDesired);
 #endif
 
+			// Clear or set alarms.  Done like this to prevent toggling each cycle
+			// and hammering system alarms
+			if (error)
+				AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_ERROR);
+			else
+				AlarmsClear(SYSTEMALARMS_ALARM_STABILIZATION);
+		}
+
+		// Run the inner loop on every axis that set one up
+		for (uint8_t i = 0; i < MAX_AXES; i++) {
+			struct rate_loop *loop = &rate_loops[i];
+			if (loop->pid == NULL)
+				continue;
+
+			float command = pid_apply_setpoint(loop->pid, loop->rate_desired, gyro_filtered[i], dT);
+			actuatorDesiredAxis[i] = bound_sym(loop->scale * command + loop->offset, 1.0f);
+		}
+
+		// Every cycle of the identification goes to Autotune, which
+		// takes them in batches
+		if (ident_samples != NULL &&
+				stabDesired.StabilizationMode[ROLL] == STABILIZATIONDESIRED_STABILIZATIONMODE_SYSTEMIDENT) {
+			struct stabilization_ident_sample *sample = PIOS_Ringbuf_WriteClaim(ident_samples);
+			if (sample != NULL) {
+				sample->gyro[ROLL] = gyrosData.x;
+				sample->gyro[PITCH] = gyrosData.y;
+				sample->gyro[YAW] = gyrosData.z;
+				sample->actuator[ROLL] = actuatorDesiredAxis[ROLL];
+				sample->actuator[PITCH] = actuatorDesiredAxis[PITCH];
+				sample->actuator[YAW] = actuatorDesiredAxis[YAW];
+				sample->dT = dT;
+				PIOS_Ringbuf_WriteCommit(ident_samples);
+			}
+		}
+
 		// Save dT
 		actuatorDesired.UpdateTime = dT * 1000;
 		actuatorDesired.Throttle = stabDesired.Throttle;
 
 		if(flightStatus.FlightMode != FLIGHTSTATUS_FLIGHTMODE_MANUAL) {
+#if defined(BLACKBOX_CAPTURE)
+			BlackboxStabilization(sample_time, gyro_filtered, rateDesiredAxis,
+					&pids[PID_GROUP_RATE], actuatorDesiredAxis);
+#endif
+#if defined(LATENCY_DIAGNOSTICS)
+			LatencyMonitorMark(LATENCY_STAGE_STABILIZATION);
+#endif
+#if defined(MODULE_Actuator_BUILTIN)
+			// Output before the set so the actuator task knows it is done
+			actuator_fused_update(&actuatorDesired, sample_time);
+#endif
 			ActuatorDesiredSet(&actuatorDesired);
 		} else {
 			// Force all axes to reinitialize when engaged
@@ -783,17 +871,29 @@ static void stabilizationTask(void* parameters)
 			for(uint8_t i=0; i< MAX_AXES; i++)
 				previous_mode[i] = 255;
 		}
-
-		// Clear or set alarms.  Done like this to prevent toggling each cycle
-		// and hammering system alarms
-		if (error)
-			AlarmsSet(SYSTEMALARMS_ALARM_STABILIZATION,SYSTEMALARMS_ALARM_ERROR);
-		else
-			AlarmsClear(SYSTEMALARMS_ALARM_STABILIZATION);
 	}
 }
 
 
+/**
+ * Set up the inner loop of an axis, which runs on every gyro update
+ * until the next run of the outer loop
+ * @param[in] axis The axis
+ * @param[in] pid The rate controller
+ * @param[in] rate_desired The rate setpoint
+ * @param[in] scale Applied to the controller output
+ * @param[in] offset Added to the controller output
+ */
+static void rate_loop_set(uint8_t axis, struct pid *pid, float rate_desired, float scale, float offset)
+{
+	struct rate_loop *loop = &rate_loops[axis];
+
+	loop->pid = pid;
+	loop->rate_desired = rate_desired;
+	loop->scale = scale;
+	loop->offset = offset;
+}
+
 /**
  * Clear the accumulators and derivatives for all the axes
  */
@@ -30,6 +30,7 @@
  */
 
 #include "openpilot.h"
+#include "misc_math.h"
 #include "physical_constants.h"
 #include "pid.h"
 #include "stabilization.h"
@@ -79,8 +80,8 @@ int stabilization_virtual_flybar(float gyro, float command, float *output, float
  */
 int stabilization_virtual_flybar_pirocomp(float z_gyro, float dT)
 {
-	float cy = cosf(z_gyro * DEG2RAD * dT);
-	float sy = sinf(z_gyro * DEG2RAD * dT);
+	float cy, sy;
+	ctrl_sincosf(z_gyro * DEG2RAD * dT, &sy, &cy);
 
 	float vbar_pitch = cy * vbar_integral[1] - sy * vbar_integral[0];
 	float vbar_roll = sy * vbar_integral[1] + cy * vbar_integral[0];
@@ -32,6 +32,7 @@
 #include "openpilot.h"
 #include "systemmod.h"
 #include "sanitycheck.h"
+#include "boottiming.h"
 #include "objectpersistence.h"
 #include "flightstatus.h"
 #include "manualcontrolsettings.h"
@@ -43,8 +44,13 @@
 #include "taskinfo.h"
 #include "watchdogstatus.h"
 #include "taskmonitor.h"
+#include "latencymonitor.h"
+#include "memorystats.h"
+#include "mutexstats.h"
+#include "misc_math.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
+#include "pios_flashfs.h"
 
 //#define DEBUG_THIS_FILE
 
@@ -58,6 +64,7 @@
 #define SYSTEM_UPDATE_PERIOD_MS 1000
 #define LED_BLINK_RATE_HZ 5
 
+// Only used when the RTOS does not time the idle thread
 #ifndef IDLE_COUNTS_PER_SEC_AT_NO_LOAD
 #define IDLE_COUNTS_PER_SEC_AT_NO_LOAD 995998	// calibrated by running tests/test_cpuload.c
 											  // must be updated if the FreeRTOS or compiler
@@ -96,6 +103,12 @@ static void updateRfm22bStats();
 #if defined(WDG_STATS_DIAGNOSTICS)
 static void updateWDGstats();
 #endif
+#if defined(HEAP_DIAGNOSTICS)
+static void updateMemoryStats();
+#endif
+#if defined(MUTEX_DIAGNOSTICS)
+static void updateMutexStats();
+#endif
 /**
  * Create the module task.
  * \returns 0 on success or -1 if initialization failed
@@ -122,6 +135,7 @@ int32_t SystemModInitialize(void)
 	// Must registers objects here for system thread because ObjectManager started in OpenPilotInit
 	SystemSettingsInitialize();
 	SystemStatsInitialize();
+	BootTimingInitialize();
 	FlightStatusInitialize();
 	ObjectPersistenceInitialize();
 #if defined(DIAG_TASKS)
@@ -130,6 +144,16 @@ int32_t SystemModInitialize(void)
 #if defined(WDG_STATS_DIAGNOSTICS)
 	WatchdogStatusInitialize();
 #endif
+#if defined(HEAP_DIAGNOSTICS)
+	MemoryStatsInitialize();
+#endif
+#if defined(MUTEX_DIAGNOSTICS)
+	MutexStatsInitialize();
+#endif
+#if defined(LATENCY_DIAGNOSTICS)
+	if (LatencyMonitorInitialize() != 0)
+		return -1;
+#endif
 
 	objectPersistenceQueue = PIOS_Queue_Create(1, sizeof(UAVObjEvent));
 	if (objectPersistenceQueue == NULL)
@@ -146,8 +170,21 @@ MODULE_INITCALL(SystemModInitialize, 0)
  */
 static void systemTask(void *parameters)
 {
-	/* create all modules thread */
-	MODULE_TASKCREATE_ALL;
+	BootTimingData bootTiming;
+	bootTiming.Time[BOOTTIMING_TIME_MODULEINIT] = PIOS_DELAY_GetuS();
+
+	/* create all modules thread, the critical ones first */
+	MODULE_TASKCREATE_CLASS(MODULE_INIT_CRITICAL);
+	bootTiming.Time[BOOTTIMING_TIME_CRITICALSTART] = PIOS_DELAY_GetuS();
+
+	MODULE_TASKCREATE_CLASS(MODULE_INIT_NORMAL);
+	bootTiming.Time[BOOTTIMING_TIME_MODULESTART] = PIOS_DELAY_GetuS();
+
+	/* then bring up what isn't needed before arming while the rest runs */
+	MODULE_DEFERRED_ALL(PIOS_WDG_Clear);
+	bootTiming.Time[BOOTTIMING_TIME_DEFERREDSTART] = PIOS_DELAY_GetuS();
+
+	BootTimingSet(&bootTiming);
 
 	if (PIOS_heap_malloc_failed_p()) {
 		/* We failed to malloc during task creation,
@@ -207,6 +244,19 @@ static void systemTask(void *parameters)
 		TaskMonitorUpdateAll();
 #endif
 
+#if defined(HEAP_DIAGNOSTICS)
+		updateMemoryStats();
+#endif
+
+#if defined(MUTEX_DIAGNOSTICS)
+		updateMutexStats();
+#endif
+
+#if defined(LATENCY_DIAGNOSTICS)
+		// Publish the control loop latency of the last period
+		LatencyMonitorUpdateAll();
+#endif
+
 		// Flash the heartbeat LED
 #if defined(PIOS_LED_HEARTBEAT)
 		PIOS_LED_Toggle(PIOS_LED_HEARTBEAT);
@@ -227,6 +277,15 @@ static void systemTask(void *parameters)
 		FlightStatusData flightStatus;
 		FlightStatusGet(&flightStatus);
 
+#if defined(PIOS_INCLUDE_LOGFS_SETTINGS)
+		// Garbage collect the settings flash a little at a time while
+		// disarmed so that saving settings later doesn't stall on it
+		if (flightStatus.Armed == FLIGHTSTATUS_ARMED_DISARMED) {
+			extern uintptr_t pios_uavo_settings_fs_id;
+			PIOS_FLASHFS_Maintenance(pios_uavo_settings_fs_id);
+		}
+#endif
+
 		UAVObjEvent ev;
 		int delayTime = flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED ?
 			SYSTEM_UPDATE_PERIOD_MS / (LED_BLINK_RATE_HZ * 2) :
@@ -339,7 +398,7 @@ static void objectUpdatedCb(UAVObjEvent * ev)
 
 static void configurationUpdatedCb(UAVObjEvent * ev)
 {
-	configuration_check();
+	configuration_check_updated(ev->obj);
 }
 #endif
 
@@ -387,6 +446,9 @@ static void updateRfm22bStats() {
             rfm22bStatus.Timeouts    = radio_stats.timeouts;
             rfm22bStatus.RSSI        = radio_stats.rssi;
             rfm22bStatus.LinkQuality = radio_stats.link_quality;
+            rfm22bStatus.RemoteLinkQuality = radio_stats.remote_link_quality;
+            rfm22bStatus.DataRate = radio_stats.datarate;
+            rfm22bStatus.DataRateChanges = radio_stats.datarate_changes;
             if (first_time) {
                 first_time = false;
             } else {
@@ -473,8 +535,13 @@ static void updateStats()
 		idleCounter = 0;
 	}
 
+	uint32_t idle_ticks, total_ticks;
 	uint32_t now = PIOS_Thread_Systime();
-	if (now > lastTickCount) {
+	if (PIOS_Thread_Get_Idle_Time(&idle_ticks, &total_ticks)) {
+		// The scheduler timed the idle thread with the cycle counter
+		if (total_ticks > 0 && idle_ticks <= total_ticks)
+			stats.CPULoad = 100 - roundf(100.0f * idle_ticks / (float)total_ticks);
+	} else if (now > lastTickCount) {
 		float dT = (PIOS_Thread_Systime() - lastTickCount) / 1000.0f;
 
 		// In the case of a slightly miscalibrated max idle count, make sure CPULoad does
@@ -497,6 +564,77 @@ static void updateStats()
 	SystemStatsSet(&stats);
 }
 
+#if defined(HEAP_DIAGNOSTICS)
+DONT_BUILD_IF(MEMORYSTATS_MODULEHEAPUSED_NUMELEM != PIOS_HEAP_MAX_OWNERS, MemoryStatsModuleTags);
+
+/**
+ * Called periodically to update the heap usage statistics
+ */
+static void updateMemoryStats()
+{
+	static const enum pios_heap_region regions[] = {
+		[MEMORYSTATS_HEAPSIZE_STANDARD] = PIOS_HEAP_REGION_STANDARD,
+		[MEMORYSTATS_HEAPSIZE_FAST] = PIOS_HEAP_REGION_FAST,
+	};
+	MemoryStatsData memStats;
+
+	memset(&memStats, 0, sizeof(memStats));
+
+	for (uint32_t i = 0; i < NELEMENTS(regions); i++) {
+		struct pios_heap_stats heap;
+
+		if (!PIOS_heap_get_stats(regions[i], &heap))
+			continue;
+
+		memStats.HeapSize[i] = heap.size;
+		memStats.HeapUsed[i] = heap.used;
+		memStats.AlignmentPadding[i] = heap.pad_bytes;
+		memStats.Allocations[i] = MIN(heap.allocations, UINT16_MAX);
+		memStats.FailedAllocations[i] = MIN(heap.failed_allocations, UINT16_MAX);
+		memStats.LargestFailedRequest[i] = heap.largest_failed;
+	}
+
+	for (uint32_t i = 0; i < MEMORYSTATS_MODULEHEAPUSED_NUMELEM; i++)
+		memStats.ModuleHeapUsed[i] = PIOS_heap_get_owner_usage(i);
+
+#if !defined(ARCH_POSIX) && !defined(ARCH_WIN32)
+	// Owner tag n + 1 is the n-th entry of the initcall table
+	uint32_t i = 1;
+	for (initmodule_t *fn = __module_initcall_start;
+			fn < __module_initcall_end && i < MEMORYSTATS_MODULEINITCALL_NUMELEM; fn++, i++)
+		memStats.ModuleInitCall[i] = (uintptr_t)fn->fn_minit;
+#endif
+
+	MemoryStatsSet(&memStats);
+}
+#endif /* HEAP_DIAGNOSTICS */
+
+#if defined(MUTEX_DIAGNOSTICS)
+/**
+ * Called periodically to update the contention statistics of the shared locks
+ */
+static void updateMutexStats()
+{
+	struct pios_mutex_stats locks[MUTEXSTATS_ACQUISITIONS_NUMELEM];
+	MutexStatsData mutexStats;
+
+	memset(locks, 0, sizeof(locks));
+
+	UAVObjGetLockStats(&locks[MUTEXSTATS_ACQUISITIONS_OBJECTMANAGER]);
+	EventGetLockStats(&locks[MUTEXSTATS_ACQUISITIONS_EVENTDISPATCHER]);
+
+	for (uint32_t i = 0; i < MUTEXSTATS_ACQUISITIONS_NUMELEM; i++) {
+		mutexStats.Acquisitions[i] = locks[i].acquisitions;
+		mutexStats.ContendedWaits[i] = locks[i].contended;
+		mutexStats.MaxWaitTime[i] = locks[i].max_wait_us;
+	}
+
+	MutexStatsSet(&mutexStats);
+}
+#endif /* MUTEX_DIAGNOSTICS */
+
+DONT_BUILD_IF(SYSTEMSTATS_EVENTCALLBACKOVERFLOWS_NUMELEM != EV_PRIORITY_NUM, EventPriorityClasses);
+
 /**
  * Update system alarms
  */
@@ -547,18 +685,27 @@ static void updateSystemAlarms()
 	EventGetStats(&evStats);
 	UAVObjClearStats();
 	EventClearStats();
-	if (objStats.eventCallbackErrors > 0 || objStats.eventQueueErrors > 0  || evStats.eventErrors > 0) {
+	uint32_t callbackOverflows = 0;
+	for (uint8_t i = 0; i < EV_PRIORITY_NUM; i++)
+		callbackOverflows += evStats.callbackOverflows[i];
+	if (objStats.eventCallbackErrors > 0 || objStats.eventQueueErrors > 0  || evStats.eventErrors > 0 ||
+			callbackOverflows > 0) {
 		AlarmsSet(SYSTEMALARMS_ALARM_EVENTSYSTEM, SYSTEMALARMS_ALARM_WARNING);
 	} else {
 		AlarmsClear(SYSTEMALARMS_ALARM_EVENTSYSTEM);
 	}
 	
-	if (objStats.lastCallbackErrorID || objStats.lastQueueErrorID || evStats.lastErrorID) {
+	if (objStats.lastCallbackErrorID || objStats.lastQueueErrorID || evStats.lastErrorID ||
+			callbackOverflows > 0) {
 		SystemStatsData sysStats;
 		SystemStatsGet(&sysStats);
 		sysStats.EventSystemWarningID = evStats.lastErrorID;
 		sysStats.ObjectManagerCallbackID = objStats.lastCallbackErrorID;
 		sysStats.ObjectManagerQueueID = objStats.lastQueueErrorID;
+		for (uint8_t i = 0; i < EV_PRIORITY_NUM; i++) {
+			uint32_t total = sysStats.EventCallbackOverflows[i] + evStats.callbackOverflows[i];
+			sysStats.EventCallbackOverflows[i] = (total > UINT16_MAX) ? UINT16_MAX : total;
+		}
 		SystemStatsSet(&sysStats);
 	}
 		
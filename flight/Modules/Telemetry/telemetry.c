@@ -29,10 +29,12 @@
  */
 
 #include "openpilot.h"
+#include "flightstatus.h"
 #include "flighttelemetrystats.h"
 #include "gcstelemetrystats.h"
 #include "modulesettings.h"
 #include "sessionmanaging.h"
+#include "telemetrysnapshotsettings.h"
 #include "pios_thread.h"
 #include "pios_queue.h"
 
@@ -47,6 +49,18 @@
 #define STATS_UPDATE_PERIOD_MS 4000
 #define CONNECTION_TIMEOUT_MS 8000
 #define PAUSE_PERIODIC_UPDATE_TIMEOUT 6000
+// Room for a whole USB report, objects that arrive in one are unpacked from it
+#define RX_BUF_LEN 64
+
+// Adaptive rate control, periodic updates are slowed down by up to RATE_SCALE_MAX
+// when the transmit path spends more than RATE_CONGESTED_PERCENT of the stats
+// period blocked on the link, and sped up again once it is mostly idle.
+#define RATE_SCALE_MAX 8
+#define RATE_CONGESTED_PERCENT 50
+#define RATE_IDLE_PERCENT 20
+#define RATE_RECOVER_WINDOWS 2
+#define RATE_FAST_PERIOD_MS 200
+#define RATE_SLOW_PERIOD_MS 1000
 // Private types
 
 // Private variables
@@ -64,18 +78,31 @@ static struct pios_thread *telemetryTxTaskHandle;
 static struct pios_thread *telemetryRxTaskHandle;
 static uint32_t txErrors;
 static uint32_t txRetries;
+static uint32_t txBlockedMs;
+static uintptr_t reservedPort;
+static uint8_t *reservedSpace;
+static uint8_t rateScale;
+static uint8_t rateIdleWindows;
 static uint32_t timeOfLastObjectUpdate;
 static UAVTalkConnection uavTalkCon;
 static bool pausePeriodicUpdates;
 static uint32_t pausePeriodicUpdatesTime;
+static uint16_t snapshotSeqs[UAVTALK_SNAPSHOT_MAX_OBJECTS];
 // Private functions
 static void telemetryTxTask(void *parameters);
 static void telemetryRxTask(void *parameters);
 static int32_t transmitData(uint8_t * data, int32_t length);
+static uint8_t * reserveTxData(uint16_t length);
+static int32_t commitTxData(uint16_t length);
+static void flushTxData();
 static void registerObject(UAVObjHandle obj);
 static void updateObject(UAVObjHandle obj, int32_t eventType);
 static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs);
+static uint16_t scaledUpdatePeriod(UAVObjHandle obj, UAVObjMetadata * metadata);
+static void rescaleObject(UAVObjHandle obj);
+static void updateRateScale(bool connected, uint32_t errors);
 static void processObjEvent(UAVObjEvent * ev);
+static bool sendCompact(UAVObjEvent * ev, UAVObjMetadata * metadata);
 static void updateTelemetryStats();
 static void gcsTelemetryStatsUpdated();
 static void updateSettings();
@@ -83,6 +110,8 @@ static uintptr_t getComPort();
 static void session_managing_updated(UAVObjEvent * ev);
 static void update_object_instances(uint32_t obj_id, uint32_t inst_id);
 static void check_pause_periodic_updates_timeout();
+static void snapshotSettingsUpdated(UAVObjEvent * ev);
+static void sendSnapshot();
 
 /**
  * Initialise the telemetry module
@@ -135,10 +164,14 @@ int32_t TelemetryInitialize(void)
     
 	// Initialise UAVTalk
 	uavTalkCon = UAVTalkInitialize(&transmitData);
+	UAVTalkSetReserveStream(uavTalkCon, &reserveTxData, &commitTxData);
     
 	// Create periodic event that will be used to update the telemetry stats
 	txErrors = 0;
 	txRetries = 0;
+	txBlockedMs = 0;
+	rateScale = 1;
+	rateIdleWindows = 0;
 	UAVObjEvent ev;
 	memset(&ev, 0, sizeof(UAVObjEvent));
 	EventPeriodicQueueCreate(&ev, priorityQueue, STATS_UPDATE_PERIOD_MS);
@@ -149,6 +182,15 @@ int32_t TelemetryInitialize(void)
 	//register the new uavo instance callback function in the uavobjectmanager
 	UAVObjRegisterNewInstanceCB(update_object_instances);
 
+	// Snapshots are sent on a periodic event of the settings object itself
+	TelemetrySnapshotSettingsInitialize();
+	memset(&ev, 0, sizeof(UAVObjEvent));
+	ev.obj = TelemetrySnapshotSettingsHandle();
+	ev.event = EV_UPDATED_PERIODIC;
+	EventPeriodicQueueCreate(&ev, queue, 0);
+	TelemetrySnapshotSettingsConnectCallback(snapshotSettingsUpdated);
+	snapshotSettingsUpdated(NULL);
+
 	return 0;
 }
 
@@ -163,7 +205,7 @@ static void registerObject(UAVObjHandle obj)
 {
 	if (UAVObjIsMetaobject(obj)) {
 		/* Only connect change notifications for meta objects.  No periodic updates */
-		UAVObjConnectQueue(obj, priorityQueue, EV_MASK_ALL_UPDATES);
+		UAVObjConnectQueueCoalesced(obj, priorityQueue, EV_MASK_ALL_UPDATES, 0);
 		return;
 	} else {
 		UAVObjMetadata metadata;
@@ -214,17 +256,17 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
 	switch (updateMode) {
 	case UPDATEMODE_PERIODIC:
 		// Set update period
-		setUpdatePeriod(obj, metadata.telemetryUpdatePeriod);
+		setUpdatePeriod(obj, scaledUpdatePeriod(obj, &metadata));
 		// Connect queue
 		eventMask = EV_UPDATED_PERIODIC | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
-		UAVObjConnectQueue(obj, priorityQueue, eventMask);
+		UAVObjConnectQueueCoalesced(obj, priorityQueue, eventMask, 0);
 		break;
 	case UPDATEMODE_ONCHANGE:
 		// Set update period
 		setUpdatePeriod(obj, 0);
 		// Connect queue
 		eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
-		UAVObjConnectQueue(obj, priorityQueue, eventMask);
+		UAVObjConnectQueueCoalesced(obj, priorityQueue, eventMask, 0);
 		break;
 	case UPDATEMODE_THROTTLED:
 		if ((eventType == EV_UPDATED_PERIODIC) || (eventType == EV_NONE)) {
@@ -232,7 +274,7 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
 			eventMask = EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
 			// Set update period on initialization and metadata change
 			if (eventType == EV_NONE)
-				setUpdatePeriod(obj, metadata.telemetryUpdatePeriod);
+				setUpdatePeriod(obj, scaledUpdatePeriod(obj, &metadata));
 		} else {
 			eventMask = getEventMask(obj, priorityQueue);
 			if (eventMask & EV_UPDATED_PERIODIC) {
@@ -247,18 +289,31 @@ static void updateObject(UAVObjHandle obj, int32_t eventType)
 				eventMask = EV_UPDATED_PERIODIC | EV_UPDATED | EV_UPDATED_MANUAL | EV_UPDATE_REQ;
 			}
 		}
-		UAVObjConnectQueue(obj, priorityQueue, eventMask);
+		UAVObjConnectQueueCoalesced(obj, priorityQueue, eventMask, 0);
 		break;
 	case UPDATEMODE_MANUAL:
 		// Set update period
 		setUpdatePeriod(obj, 0);
 		// Connect queue
 		eventMask = EV_UPDATED_MANUAL | EV_UPDATE_REQ;
-		UAVObjConnectQueue(obj, priorityQueue, eventMask);
+		UAVObjConnectQueueCoalesced(obj, priorityQueue, eventMask, 0);
 		break;
 	}
 }
 
+/**
+ * Check if an update can be sent in a compact form. Only unacked periodic
+ * updates are bundled with other small objects or sent as deltas, the GCS
+ * applies deltas to its copy and every object is periodically refreshed
+ * in full.
+ */
+static bool sendCompact(UAVObjEvent * ev, UAVObjMetadata * metadata)
+{
+	return ev->event == EV_UPDATED_PERIODIC &&
+		!UAVObjGetTelemetryAcked(metadata) &&
+		ev->obj != FlightTelemetryStatsHandle();
+}
+
 /**
  * Processes queue events
  */
@@ -274,6 +329,8 @@ static void processObjEvent(UAVObjEvent * ev)
 		updateTelemetryStats();
 	} else if (ev->obj == GCSTelemetryStatsHandle()) {
 		gcsTelemetryStatsUpdated();
+	} else if (ev->obj == TelemetrySnapshotSettingsHandle() && ev->event == EV_UPDATED_PERIODIC) {
+		sendSnapshot();
 	} else {
 		FlightTelemetryStatsGet(&flightStats);
 		// Get object metadata
@@ -291,6 +348,8 @@ static void processObjEvent(UAVObjEvent * ev)
 			while (retries < MAX_RETRIES && success == -1) {
 				if((ev->obj !=FlightTelemetryStatsHandle()) && (ev->event == EV_UPDATED_PERIODIC) && pausePeriodicUpdates) {
 					success = 0;
+				} else if (sendCompact(ev, &metadata)) {
+					success = UAVTalkSendObjectBundled(uavTalkCon, ev->obj, ev->instId);
 				} else {
 					success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
 				}
@@ -325,6 +384,8 @@ static void processObjEvent(UAVObjEvent * ev)
 				while (retries < MAX_RETRIES && success == -1) {
 					if (pausePeriodicUpdates) {
 						success = 0;
+					} else if (sendCompact(ev, &metadata)) {
+						success = UAVTalkSendObjectBundled(uavTalkCon, ev->obj, ev->instId);
 					} else {
 						success = UAVTalkSendObject(uavTalkCon, ev->obj, ev->instId, UAVObjGetTelemetryAcked(&metadata), REQ_TIMEOUT_MS);	// call blocks until ack is received or timeout
 					}
@@ -358,11 +419,16 @@ static void telemetryTxTask(void *parameters)
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-			// Process event
-			processObjEvent(&ev);
+		// Send the bundled updates once there is nothing left to add
+		if (UAVObjQueueReceive(queue, &ev, 0) == false) {
+			flushTxData();
+			// Wait for queue message
+			if (UAVObjQueueReceive(queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == false)
+				continue;
 		}
+
+		// Process event
+		processObjEvent(&ev);
 	}
 }
 
@@ -376,11 +442,16 @@ static void telemetryTxPriTask(void *parameters)
 
 	// Loop forever
 	while (1) {
-		// Wait for queue message
-		if (PIOS_Queue_Receive(priorityQueue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == true) {
-			// Process event
-			processObjEvent(&ev);
+		// Send the bundled updates once there is nothing left to add
+		if (UAVObjQueueReceive(priorityQueue, &ev, 0) == false) {
+			flushTxData();
+			// Wait for queue message
+			if (UAVObjQueueReceive(priorityQueue, &ev, PIOS_QUEUE_TIMEOUT_MAX) == false)
+				continue;
 		}
+
+		// Process event
+		processObjEvent(&ev);
 	}
 }
 #endif
@@ -396,15 +467,13 @@ static void telemetryRxTask(void *parameters)
 		uintptr_t inputPort = getComPort();
 
 		if (inputPort) {
-			// Block until data are available
-			uint8_t serial_data[1];
+			// Block until data are available, then take all that came in
+			uint8_t serial_data[RX_BUF_LEN];
 			uint16_t bytes_to_process;
 
 			bytes_to_process = PIOS_COM_ReceiveBuffer(inputPort, serial_data, sizeof(serial_data), 500);
 			if (bytes_to_process > 0) {
-				for (uint8_t i = 0; i < bytes_to_process; i++) {
-					UAVTalkProcessInputStream(uavTalkCon,serial_data[i]);
-				}
+				UAVTalkProcessInputBuffer(uavTalkCon, serial_data, bytes_to_process);
 			}
 		} else {
 			PIOS_Thread_Sleep(5);
@@ -423,12 +492,70 @@ static int32_t transmitData(uint8_t * data, int32_t length)
 {
 	uintptr_t outputPort = getComPort();
 
-	if (outputPort)
-		return PIOS_COM_SendBuffer(outputPort, data, length);
+	if (outputPort) {
+		// Time spent waiting for room in the port buffer tells how
+		// close the link is to saturation
+		uint32_t start = PIOS_Thread_Systime();
+		int32_t rc = PIOS_COM_SendBuffer(outputPort, data, length);
+		txBlockedMs += PIOS_Thread_Systime() - start;
+
+		// Anything but periodic updates may be waited on by the GCS
+		if (!UAVTalkIsDeferrable(data, length))
+			PIOS_COM_FlushTx(outputPort);
+
+		return rc;
+	}
 
 	return -1;
 }
 
+/**
+ * Reserve room for a packet directly in the transmit buffer of the modem or
+ * USB port. Calls are serialized by the UAVTalk connection lock.
+ * \param[in] length Length of the packet
+ * \return pointer to the reserved room or NULL if the packet has to be sent
+ * through transmitData()
+ */
+static uint8_t * reserveTxData(uint16_t length)
+{
+	uintptr_t outputPort = getComPort();
+
+	if (!outputPort)
+		return NULL;
+
+	uint8_t *space = PIOS_COM_ReserveTx(outputPort, length);
+	if (space) {
+		reservedPort = outputPort;
+		reservedSpace = space;
+	}
+
+	return space;
+}
+
+/**
+ * Send a packet written into the room returned by reserveTxData()
+ * \param[in] length Length of the packet, zero to drop it
+ * \return number of bytes transmitted
+ */
+static int32_t commitTxData(uint16_t length)
+{
+	int32_t rc = PIOS_COM_CommitTx(reservedPort, length);
+
+	if (length > 0 && !UAVTalkIsDeferrable(reservedSpace, length))
+		PIOS_COM_FlushTx(reservedPort);
+
+	return rc;
+}
+
+/**
+ * Send the pending bundle and whatever the port holds back for a batch
+ */
+static void flushTxData()
+{
+	UAVTalkFlushBundle(uavTalkCon);
+	PIOS_COM_FlushTx(getComPort());
+}
+
 /**
  * Set update period of object (it must be already setup for periodic updates)
  * \param[in] obj The object to update
@@ -447,6 +574,93 @@ static int32_t setUpdatePeriod(UAVObjHandle obj, int32_t updatePeriodMs)
 	return EventPeriodicQueueUpdate(&ev, queue, updatePeriodMs);
 }
 
+/**
+ * Get the update period of an object for the current link capacity.
+ * Critical objects (acked ones, flight status, alarms and the telemetry
+ * stats) and slow ones are never scaled, fast ones give up the most.
+ * \param[in] obj The object
+ * \param[in] metadata The metadata of the object
+ * \return The update period in ms
+ */
+static uint16_t scaledUpdatePeriod(UAVObjHandle obj, UAVObjMetadata * metadata)
+{
+	uint16_t period = metadata->telemetryUpdatePeriod;
+	uint16_t scale = rateScale;
+
+	if (scale <= 1 || period == 0 || period >= RATE_SLOW_PERIOD_MS)
+		return period;
+
+	if (UAVObjGetTelemetryAcked(metadata) ||
+			obj == FlightStatusHandle() ||
+			obj == SystemAlarmsHandle() ||
+			obj == FlightTelemetryStatsHandle())
+		return period;
+
+	// Medium rate objects are slowed down half as much
+	if (period >= RATE_FAST_PERIOD_MS)
+		scale = (scale + 1) / 2;
+
+	return period * scale;
+}
+
+/**
+ * Apply the current rate scale to the periodic updates of an object
+ * \param[in] obj The object
+ */
+static void rescaleObject(UAVObjHandle obj)
+{
+	UAVObjMetadata metadata;
+	UAVObjUpdateMode updateMode;
+
+	if (UAVObjIsMetaobject(obj))
+		return;
+
+	UAVObjGetMetadata(obj, &metadata);
+	updateMode = UAVObjGetTelemetryUpdateMode(&metadata);
+
+	if ((updateMode == UPDATEMODE_PERIODIC) ||
+		(updateMode == UPDATEMODE_THROTTLED)) {
+		setUpdatePeriod(obj, scaledUpdatePeriod(obj, &metadata));
+	}
+}
+
+/**
+ * Adjust the periodic update rates to the achieved link throughput.
+ * Called once per stats period, doubles the update periods while the
+ * link is saturated and halves them again after it has been idle for a
+ * few periods.
+ * \param[in] connected True if the GCS is connected
+ * \param[in] errors Transmit failures during the last stats period
+ */
+static void updateRateScale(bool connected, uint32_t errors)
+{
+	uint32_t blockedPercent = txBlockedMs * 100 / STATS_UPDATE_PERIOD_MS;
+	uint8_t newScale = rateScale;
+
+	txBlockedMs = 0;
+
+	if (!connected) {
+		newScale = 1;
+		rateIdleWindows = 0;
+	} else if (errors > 0 || blockedPercent > RATE_CONGESTED_PERCENT) {
+		if (newScale < RATE_SCALE_MAX)
+			newScale *= 2;
+		rateIdleWindows = 0;
+	} else if (blockedPercent < RATE_IDLE_PERCENT && newScale > 1) {
+		if (++rateIdleWindows >= RATE_RECOVER_WINDOWS) {
+			newScale /= 2;
+			rateIdleWindows = 0;
+		}
+	} else {
+		rateIdleWindows = 0;
+	}
+
+	if (newScale != rateScale) {
+		rateScale = newScale;
+		UAVObjIterate(&rescaleObject);
+	}
+}
+
 /**
  * Called each time the GCS telemetry stats object is updated.
  * Trigger a flight telemetry stats update if a connection is not
@@ -490,6 +704,7 @@ static void updateTelemetryStats()
 		flightStats.RxFailures += utalkStats.rxErrors;
 		flightStats.TxFailures += txErrors;
 		flightStats.TxRetries += txRetries;
+		updateRateScale(true, txErrors);
 		txErrors = 0;
 		txRetries = 0;
 	} else {
@@ -498,6 +713,7 @@ static void updateTelemetryStats()
 		flightStats.RxFailures = 0;
 		flightStats.TxFailures = 0;
 		flightStats.TxRetries = 0;
+		updateRateScale(false, 0);
 		txErrors = 0;
 		txRetries = 0;
 	}
@@ -553,6 +769,44 @@ static void updateTelemetryStats()
 	}
 }
 
+/**
+ * Apply the snapshot period, the objects are looked up on every snapshot
+ */
+static void snapshotSettingsUpdated(UAVObjEvent * ev)
+{
+	uint16_t period;
+	TelemetrySnapshotSettingsPeriodGet(&period);
+
+	UAVObjEvent snapshotEv = {
+		.obj    = TelemetrySnapshotSettingsHandle(),
+		.instId = 0,
+		.event  = EV_UPDATED_PERIODIC,
+	};
+	EventPeriodicQueueUpdate(&snapshotEv, queue, period);
+}
+
+/**
+ * Send the objects of TelemetrySnapshotSettings as one snapshot, if any
+ * of them was updated since the last one
+ */
+static void sendSnapshot()
+{
+	uint32_t ids[TELEMETRYSNAPSHOTSETTINGS_OBJECTID_NUMELEM];
+	UAVObjHandle objs[UAVTALK_SNAPSHOT_MAX_OBJECTS];
+	uint8_t count = 0;
+
+	TelemetrySnapshotSettingsObjectIDGet(ids);
+
+	for (uint8_t i = 0; i < TELEMETRYSNAPSHOTSETTINGS_OBJECTID_NUMELEM && count < UAVTALK_SNAPSHOT_MAX_OBJECTS; i++) {
+		UAVObjHandle obj = ids[i] ? UAVObjGetByID(ids[i]) : NULL;
+		if (obj != NULL && UAVObjIsSingleInstance(obj) && !UAVObjIsMetaobject(obj))
+			objs[count++] = obj;
+	}
+
+	if (count > 0 && !pausePeriodicUpdates)
+		UAVTalkSendSnapshot(uavTalkCon, objs, count, snapshotSeqs);
+}
+
 /**
  * Update the telemetry settings, called on startup.
  * FIXME: This should be in the TelemetrySettings object. But objects
@@ -592,6 +846,10 @@ static void updateSettings()
 			PIOS_COM_ChangeBaud(PIOS_COM_TELEM_RF, 115200);
 			break;
 		}
+
+		uint8_t batch;
+		ModuleSettingsTelemetryTxBatchGet(&batch);
+		PIOS_COM_SetTxBatch(PIOS_COM_TELEM_RF, batch);
 	}
 }
 
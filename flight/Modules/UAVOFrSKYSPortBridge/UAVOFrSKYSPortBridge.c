@@ -34,7 +34,7 @@
  */
 
 #include "frsky_packing.h"
-#include "pios_thread.h"
+#include "telemetry_bridge.h"
 
 #include "baroaltitude.h"
 #include "flightbatterysettings.h"
@@ -95,17 +95,15 @@ static const uint8_t frsky_sensor_ids[] = {0x1b};
 
 #define FRSKY_SPORT_BAUDRATE                    57600
 
-#if defined(PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_FRSKY_SPORT_TELEMETRY_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 672
-#endif
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
-
 static bool module_enabled;
 static struct frsky_sport_telemetry *frsky;
 static int32_t uavoFrSKYSPortBridgeInitialize(void);
-static void uavoFrSKYSPortBridgeTask(void *parameters);
+static bool frsky_receive_byte(const struct telemetry_bridge_snapshot *snapshot, uint8_t b);
+
+static struct telemetry_bridge_encoder sport_encoder = {
+	.objects = TELEMETRY_BRIDGE_GPS_POSITION,
+	.receive = frsky_receive_byte,
+};
 
 /**
  * Scan for value item with the longest expired time and schedule it to send in next poll turn
@@ -150,9 +148,11 @@ static bool frsky_send_scheduled_item(void)
 
 /**
  * Process incoming bytes from FrSky S.PORT bus
+ * @param[in] snapshot objects read by the telemetry bridge
  * @param[in] b received byte
+ * @returns true, the bus is always listened to
  */
-static void frsky_receive_byte(uint8_t b)
+static bool frsky_receive_byte(const struct telemetry_bridge_snapshot *snapshot, uint8_t b)
 {
 	uint32_t i = 0;
 	switch (frsky->state) {
@@ -177,10 +177,9 @@ static void frsky_receive_byte(uint8_t b)
 		frsky->state = FRSKY_STATE_WAIT_POLL_REQUEST;
 		for (i = 0; i < sizeof(frsky_sensor_ids); i++) {
 			if (frsky_sensor_ids[i] == b) {
-				// get GPSPositionData once here to be more efficient, since
-				// GPS position data are very often used by encode() handlers
-				if (GPSPositionHandle() != NULL)
-					GPSPositionGet(&frsky->frsky_settings.gps_position);
+				// GPS position data are very often used by encode() handlers,
+				// so they come from the snapshot
+				frsky->frsky_settings.gps_position = snapshot->gps_position;
 				// send item previously scheduled
 				if (frsky_send_scheduled_item() && frsky->ignore_rx_chars)
 					frsky->state = FRSKY_STATE_WAIT_TX_DONE;
@@ -191,6 +190,8 @@ static void frsky_receive_byte(uint8_t b)
 		}
 		break;
 	}
+
+	return true;
 }
 
 /**
@@ -212,17 +213,10 @@ static int32_t uavoFrSKYSPortBridgeStart(void)
 		frsky->frsky_settings.batt_cell_count = frsky->frsky_settings.battery_settings.NbCells;
 	}
 	if (BaroAltitudeHandle() != NULL
-			&& PIOS_SENSORS_GetQueue(PIOS_SENSOR_BARO) != NULL)
+			&& PIOS_SENSORS_IsRegistered(PIOS_SENSOR_BARO))
 		frsky->frsky_settings.use_baro_sensor = true;
 
-	struct pios_thread *task;
-	task = PIOS_Thread_Create(
-			uavoFrSKYSPortBridgeTask, "uavoFrSKYSPortBridge",
-			STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-	TaskMonitorAdd(TASKINFO_RUNNING_UAVOFRSKYSPORTBRIDGE,
-			task);
-
-	return 0;
+	return telemetry_bridge_start();
 }
 
 /**
@@ -255,8 +249,9 @@ static int32_t uavoFrSKYSPortBridgeInitialize(void)
 			for (i = 0; i < NELEMENTS(frsky_value_items); i++)
 				frsky->item_last_triggered[i] = PIOS_DELAY_GetuS();
 			PIOS_COM_ChangeBaud(frsky->com, FRSKY_SPORT_BAUDRATE);
+			sport_encoder.com = frsky->com;
 			module_enabled = true;
-			return 0;
+			return telemetry_bridge_register(&sport_encoder);
 		}
 	}
 
@@ -264,21 +259,7 @@ static int32_t uavoFrSKYSPortBridgeInitialize(void)
 
 	return -1;
 }
-MODULE_INITCALL(uavoFrSKYSPortBridgeInitialize, uavoFrSKYSPortBridgeStart)
-
-/**
- * Main task routine
- * @param[in] parameters parameter given by PIOS_Thread_Create()
- */
-static void uavoFrSKYSPortBridgeTask(void *parameters)
-{
-	while (1) {
-		uint8_t b = 0;
-		uint16_t count = PIOS_COM_ReceiveBuffer(frsky->com, &b, 1, PIOS_QUEUE_TIMEOUT_MAX);
-		if (count)
-			frsky_receive_byte(b);
-	}
-}
+MODULE_DEFERRED_INITCALL(uavoFrSKYSPortBridgeInitialize, uavoFrSKYSPortBridgeStart)
 
 #endif //PIOS_INCLUDE_FRSKY_SPORT_TELEMETRY
 /**
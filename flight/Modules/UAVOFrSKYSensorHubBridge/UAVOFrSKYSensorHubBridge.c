@@ -33,23 +33,16 @@
 #include "physical_constants.h"
 #include "modulesettings.h"
 #include "flightbatterysettings.h"
-#include "flightbatterystate.h"
-#include "gpsposition.h"
-#include "airspeedactual.h"
-#include "baroaltitude.h"
-#include "homelocation.h"
 #include "accels.h"
-#include "flightstatus.h"
 #include "nedaccel.h"
 #include "velocityactual.h"
-#include "attitudeactual.h"
-#include "pios_thread.h"
+#include "telemetry_bridge.h"
 
 #if defined(PIOS_INCLUDE_FRSKY_SENSOR_HUB)
 // ****************
 // Private functions
 
-static void uavoFrSKYSensorHubBridgeTask(void *parameters);
+static void uavoFrSKYSensorHubBridgeSend(const struct telemetry_bridge_snapshot *snapshot);
 
 static uint16_t frsky_pack_altitude(
 		float altitude,
@@ -113,13 +106,6 @@ static bool frame_trigger(uint8_t frame_num);
 // ****************
 // Private constants
 
-#if defined(PIOS_FRSKY_SENSOR_HUB_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_FRSKY_SENSOR_HUB_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 672
-#endif
-
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
 #define TASK_RATE_HZ 10
 
 #define FRSKY_MAX_PACKET_LEN 106
@@ -179,15 +165,25 @@ static const uint8_t frsky_rates[] = {
 // Private variables
 
 static struct {
-	struct pios_thread *task_handle;
-
 	uint32_t frsky_port;
 
 	uint8_t frame_ticks[MAXSTREAMS];
 
+	FlightBatterySettingsData batSettings;
+	uint8_t last_armed;
+	float altitude_offset;
+
 	uint8_t serial_buf[FRSKY_MAX_PACKET_LEN];
 } *shub_global;
 
+static struct telemetry_bridge_encoder shub_encoder = {
+	.objects = TELEMETRY_BRIDGE_ATTITUDE | TELEMETRY_BRIDGE_GPS_POSITION |
+		TELEMETRY_BRIDGE_BATTERY | TELEMETRY_BRIDGE_FLIGHT_STATUS |
+		TELEMETRY_BRIDGE_BARO | TELEMETRY_BRIDGE_HOME_LOCATION,
+	.period_ms = 1000 / TASK_RATE_HZ,
+	.send = uavoFrSKYSensorHubBridgeSend,
+};
+
 /**
  * Start the module
  * \return -1 if start failed
@@ -196,13 +192,14 @@ static struct {
 static int32_t uavoFrSKYSensorHubBridgeStart(void)
 {
 	if (shub_global) {
-		// Start tasks
-		shub_global->task_handle = PIOS_Thread_Create(
-				uavoFrSKYSensorHubBridgeTask, "uavoFrSKYSensorHubBridge",
-				STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOFRSKYSBRIDGE,
-				shub_global->task_handle);
-		return 0;
+		if (FlightBatterySettingsHandle() != NULL )
+			FlightBatterySettingsGet(&shub_global->batSettings);
+		else {
+			shub_global->batSettings.VoltagePin = FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE;
+			shub_global->batSettings.CurrentPin = FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE;
+		}
+
+		return telemetry_bridge_start();
 	}
 	return -1;
 }
@@ -227,7 +224,9 @@ static int32_t uavoFrSKYSensorHubBridgeInitialize(void)
 			return -1;
 		}
 
+		memset(shub_global, 0, sizeof(*shub_global));
 		shub_global->frsky_port = frsky_port;
+		shub_global->last_armed = FLIGHTSTATUS_ARMED_DISARMED;
 
 		PIOS_COM_ChangeBaud(frsky_port, FRSKY_BAUD_RATE);
 
@@ -236,297 +235,230 @@ static int32_t uavoFrSKYSensorHubBridgeInitialize(void)
 				(TASK_RATE_HZ / frsky_rates[x]);
 		}
 
-		return 0;
+		return telemetry_bridge_register(&shub_encoder);
 	}
 
 
 	return -1;
 }
-MODULE_INITCALL(uavoFrSKYSensorHubBridgeInitialize, uavoFrSKYSensorHubBridgeStart)
+MODULE_DEFERRED_INITCALL(uavoFrSKYSensorHubBridgeInitialize, uavoFrSKYSensorHubBridgeStart)
 
 /**
- * Main task. It does not return.
+ * Called by the telemetry bridge at TASK_RATE_HZ
  */
-static void uavoFrSKYSensorHubBridgeTask(void *parameters)
+static void uavoFrSKYSensorHubBridgeSend(const struct telemetry_bridge_snapshot *snapshot)
 {
-	FlightBatterySettingsData batSettings;
-	FlightBatteryStateData batState;
-	GPSPositionData gpsPosData;
-	BaroAltitudeData baroAltitude;
-	FlightStatusData flightStatus;
+	const FlightBatterySettingsData *batSettings = &shub_global->batSettings;
+	const FlightBatteryStateData *batState = &snapshot->battery;
+	const GPSPositionData *gpsPosData = &snapshot->gps_position;
+	const FlightStatusData *flightStatus = &snapshot->flight_status;
 
 	float accX = 0, accY = 0, accZ = 0;
-
-	if (FlightBatterySettingsHandle() != NULL )
-		FlightBatterySettingsGet(&batSettings);
-	else {
-		batSettings.Capacity = 0;
-		batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_CURRENT] = 0;
-		batSettings.SensorCalibrationFactor[FLIGHTBATTERYSETTINGS_SENSORCALIBRATIONFACTOR_VOLTAGE] = 0;
-		batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_WARNING] = 0;
-		batSettings.VoltageThresholds[FLIGHTBATTERYSETTINGS_VOLTAGETHRESHOLDS_ALARM] = 0;
-		batSettings.NbCells = 0;
-		batSettings.VoltagePin = FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE;
-		batSettings.CurrentPin = FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE;
-	}
-
-	if (GPSPositionHandle() == NULL ) {
-		gpsPosData.Altitude = 0;
-		gpsPosData.GeoidSeparation = 0;
-		gpsPosData.Groundspeed = 0;
-		gpsPosData.HDOP = 0;
-		gpsPosData.Heading = 0;
-		gpsPosData.Latitude = 0;
-		gpsPosData.Longitude = 0;
-		gpsPosData.PDOP = 0;
-		gpsPosData.Satellites = 0;
-		gpsPosData.Status = 0;
-		gpsPosData.VDOP = 0;
-	}
-
-	if (FlightBatteryStateHandle() == NULL ) {
-		batState.AvgCurrent = 0;
-		batState.BoardSupplyVoltage = 0;
-		batState.ConsumedEnergy = 0;
-		batState.Current = 0;
-		batState.EstimatedFlightTime = 0;
-		batState.PeakCurrent = 0;
-		batState.Voltage = 0;
-	}
-
-	uint8_t last_armed = FLIGHTSTATUS_ARMED_DISARMED;
-	float altitude_offset = 0.0f;
-
 	uint16_t msg_length = 0;
-	uint32_t lastSysTime;
-
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
-
-	while (1) {
-		PIOS_Thread_Sleep_Until(&lastSysTime, 1000 / TASK_RATE_HZ);
-
-		if (frame_trigger(FRSKY_FRAME_VARIO)) {
-			msg_length = 0;
-
-			uint8_t accelDataSettings;
-			ModuleSettingsFrskyAccelDataGet(&accelDataSettings);
-			switch(accelDataSettings) {
-			case MODULESETTINGS_FRSKYACCELDATA_ACCELS: {
-				if (AccelsHandle() != NULL) {
-					AccelsxGet(&accX);
-					AccelsyGet(&accY);
-					AccelszGet(&accZ);
-				}
-				break;
+
+	if (frame_trigger(FRSKY_FRAME_VARIO)) {
+		msg_length = 0;
+
+		uint8_t accelDataSettings;
+		ModuleSettingsFrskyAccelDataGet(&accelDataSettings);
+		switch(accelDataSettings) {
+		case MODULESETTINGS_FRSKYACCELDATA_ACCELS: {
+			if (AccelsHandle() != NULL) {
+				AccelsxGet(&accX);
+				AccelsyGet(&accY);
+				AccelszGet(&accZ);
 			}
+			break;
+		}
 #ifndef SMALLF1
-			case MODULESETTINGS_FRSKYACCELDATA_NEDACCELS: {
-				if (NedAccelHandle() != NULL) {
-					NedAccelNorthGet(&accX);
-					NedAccelEastGet(&accY);
-					NedAccelDownGet(&accZ);
-				}
-				break;
+		case MODULESETTINGS_FRSKYACCELDATA_NEDACCELS: {
+			if (NedAccelHandle() != NULL) {
+				NedAccelNorthGet(&accX);
+				NedAccelEastGet(&accY);
+				NedAccelDownGet(&accZ);
 			}
-			case MODULESETTINGS_FRSKYACCELDATA_NEDVELOCITY: {
-				if (VelocityActualHandle() != NULL) {
-					VelocityActualNorthGet(&accX);
-					VelocityActualEastGet(&accY);
-					VelocityActualDownGet(&accZ);
-					accX *= GRAVITY / 10.0f;
-					accY *= GRAVITY / 10.0f;
-					accZ *= GRAVITY / 10.0f;
-				}
-				break;
+			break;
+		}
+		case MODULESETTINGS_FRSKYACCELDATA_NEDVELOCITY: {
+			if (VelocityActualHandle() != NULL) {
+				VelocityActualNorthGet(&accX);
+				VelocityActualEastGet(&accY);
+				VelocityActualDownGet(&accZ);
+				accX *= GRAVITY / 10.0f;
+				accY *= GRAVITY / 10.0f;
+				accZ *= GRAVITY / 10.0f;
 			}
+			break;
+		}
 #endif
-			case MODULESETTINGS_FRSKYACCELDATA_ATTITUDEANGLES: {
-				if (AttitudeActualHandle() != NULL) {
-					AttitudeActualRollGet(&accX);
-					AttitudeActualPitchGet(&accY);
-					AttitudeActualYawGet(&accZ);
-					accX *= GRAVITY / 10.0f;
-					accY *= GRAVITY / 10.0f;
-					accZ *= GRAVITY / 10.0f;
-				}
-				break;
-			}
+		case MODULESETTINGS_FRSKYACCELDATA_ATTITUDEANGLES: {
+			if (snapshot->valid & TELEMETRY_BRIDGE_ATTITUDE) {
+				accX = snapshot->attitude.Roll * GRAVITY / 10.0f;
+				accY = snapshot->attitude.Pitch * GRAVITY / 10.0f;
+				accZ = snapshot->attitude.Yaw * GRAVITY / 10.0f;
 			}
+			break;
+		}
+		}
 
-			msg_length += frsky_pack_accel(
-					accX,
-					accY,
-					accZ,
-					shub_global->serial_buf + msg_length);
+		msg_length += frsky_pack_accel(
+				accX,
+				accY,
+				accZ,
+				shub_global->serial_buf + msg_length);
 
-			if (BaroAltitudeHandle() != NULL)
-				BaroAltitudeGet(&baroAltitude);
+		// set altitude offset when arming
+		if ((flightStatus->Armed == FLIGHTSTATUS_ARMED_ARMING) ||
+				((shub_global->last_armed != FLIGHTSTATUS_ARMED_ARMED) && (flightStatus->Armed == FLIGHTSTATUS_ARMED_ARMED))) {
+			shub_global->altitude_offset = snapshot->baro.Altitude;
+		}
+		shub_global->last_armed = flightStatus->Armed;
 
-			FlightStatusGet(&flightStatus);
+		float altitude = snapshot->baro.Altitude - shub_global->altitude_offset;
+		msg_length += frsky_pack_altitude(
+				altitude,
+				shub_global->serial_buf + msg_length);
+
+		msg_length += frsky_pack_stop(shub_global->serial_buf + msg_length);
+
+		PIOS_COM_SendBuffer(shub_global->frsky_port,
+				shub_global->serial_buf, msg_length);
+	}
 
-			// set altitude offset when arming
-			if ((flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMING) ||
-					((last_armed != FLIGHTSTATUS_ARMED_ARMED) && (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED))) {
-				altitude_offset = baroAltitude.Altitude;
+	if (frame_trigger(FRSKY_FRAME_BATTERY)) {
+		msg_length = 0;
+
+		float voltage = 0.0f;
+		if (batSettings->VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
+			voltage = batState->Voltage;
+
+		float current = 0.0f;
+		if (batSettings->CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
+			current = batState->Current;
+
+		// As long as there is no voltage for each cell
+		// all cells will have the same voltage.
+		// Receiver will know number of cells.
+		if (batSettings->NbCells > 0) {
+			float cell_v = voltage / batSettings->NbCells;
+			for(uint8_t i = 0; i < batSettings->NbCells; ++i) {
+				msg_length += frsky_pack_cellvoltage(
+						i,
+						cell_v,
+						shub_global->serial_buf + msg_length);
 			}
-			last_armed = flightStatus.Armed;
+		}
 
-			float altitude = baroAltitude.Altitude - altitude_offset;
-			msg_length += frsky_pack_altitude(
-					altitude,
-					shub_global->serial_buf + msg_length);
+		msg_length += frsky_pack_fas(
+				voltage,
+				current,
+				shub_global->serial_buf + msg_length);
 
-			msg_length += frsky_pack_stop(shub_global->serial_buf + msg_length);
+		if (batSettings->Capacity > 0) {
+			float fuel = 1.0f - batState->ConsumedEnergy / batSettings->Capacity;
+			msg_length += frsky_pack_fuel(
+				fuel,
+				shub_global->serial_buf + msg_length);
+		}
+
+		msg_length += frsky_pack_stop(shub_global->serial_buf + msg_length);
 
-			PIOS_COM_SendBuffer(shub_global->frsky_port,
-					shub_global->serial_buf, msg_length);
+		PIOS_COM_SendBuffer(shub_global->frsky_port,
+				shub_global->serial_buf, msg_length);
+	}
+
+	if (frame_trigger(FRSKY_FRAME_GPS)) {
+		msg_length = 0;
+
+		/**
+		 * Encodes ARM status and flight mode number as RPM value
+		 * Since there is no RPM information in any UAVO available,
+		 * we will intentionally misuse this item to encode other useful information.
+		 * It will encode flight status as three-digit number as follow:
+		 * most left digit encodes arm status (200=armed, 100=disarmed)
+		 * two most right digits encode flight mode number (see FlightStatus UAVO FlightMode enum)
+		 * To work properly on Taranis, you have to set Blades to "60" in telemetry setting
+		 */
+		uint16_t status = 0;
+		float hdop, vdop;
+
+		status = (flightStatus->Armed == FLIGHTSTATUS_ARMED_ARMED) ? 200 : 100;
+		status += flightStatus->FlightMode;
+
+		msg_length += frsky_pack_rpm(status, shub_global->serial_buf + msg_length);
+
+		uint8_t hl_set = HOMELOCATION_SET_FALSE;
+
+		if (snapshot->valid & TELEMETRY_BRIDGE_HOME_LOCATION)
+			hl_set = snapshot->home_location.Set;
+
+		/**
+		 * Encode GPS status and visible satellites as T1 value
+		 * We will intentionally misuse this item to encode other useful information.
+		 * Right-most two digits encode visible satellite count, left-most digit has following meaning:
+		 * 1 - no GPS connected
+		 * 2 - no fix
+		 * 3 - 2D fix
+		 * 4 - 3D fix
+		 * 5 - 3D fix and HomeLocation is SET - should be safe for navigation
+		 */
+		switch (gpsPosData->Status) {
+		case GPSPOSITION_STATUS_NOGPS:
+		status = 100;
+			break;
+		case GPSPOSITION_STATUS_NOFIX:
+			status = 200;
+			break;
+		case GPSPOSITION_STATUS_FIX2D:
+			status = 300;
+			break;
+		case GPSPOSITION_STATUS_FIX3D:
+		case GPSPOSITION_STATUS_DIFF3D:
+			if (hl_set == HOMELOCATION_SET_TRUE)
+				status = 500;
+			else
+				status = 400;
+			break;
 		}
 
-		if (frame_trigger(FRSKY_FRAME_BATTERY)) {
-			msg_length = 0;
-
-			if (FlightBatteryStateHandle() != NULL)
-				FlightBatteryStateGet(&batState);
-
-			float voltage = 0.0f;
-			if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-				voltage = batState.Voltage;
-
-			float current = 0.0f;
-			if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
-				current = batState.Current;
-
-			// As long as there is no voltage for each cell
-			// all cells will have the same voltage.
-			// Receiver will know number of cells.
-			if (batSettings.NbCells > 0) {
-				float cell_v = voltage / batSettings.NbCells;
-				for(uint8_t i = 0; i < batSettings.NbCells; ++i) {
-					msg_length += frsky_pack_cellvoltage(
-							i,
-							cell_v,
-							shub_global->serial_buf + msg_length);
-				}
-			}
+		if (gpsPosData->Satellites > 0)
+			status += gpsPosData->Satellites;
 
-			msg_length += frsky_pack_fas(
-					voltage,
-					current,
-					shub_global->serial_buf + msg_length);
+		msg_length += frsky_pack_temperature_01((float)status, shub_global->serial_buf + msg_length);
 
-			if (batSettings.Capacity > 0) {
-				float fuel = 1.0f - batState.ConsumedEnergy / batSettings.Capacity;
-				msg_length += frsky_pack_fuel(
-					fuel,
-					shub_global->serial_buf + msg_length);
-			}
+		/**
+		 * Encode GPS HDOP and VDOP as T2 value
+		 * We will intentionally misuse this item to encode other useful information.
+		 * VDOP in the upper 16 bits, max 256 (2.56 * 100)
+		 * HDOP in the lower 16 bits, max 256 (2.56 * 100)
+		 */
+		hdop = gpsPosData->HDOP * 100.0f;
 
-			msg_length += frsky_pack_stop(shub_global->serial_buf + msg_length);
+		if (hdop > 255.0f)
+			hdop = 255.0f;
 
-			PIOS_COM_SendBuffer(shub_global->frsky_port,
-					shub_global->serial_buf, msg_length);
-		}
+		vdop = gpsPosData->VDOP * 100.0f;
 
-		if (frame_trigger(FRSKY_FRAME_GPS)) {
-			msg_length = 0;
-
-			/**
-			 * Encodes ARM status and flight mode number as RPM value
-			 * Since there is no RPM information in any UAVO available,
-			 * we will intentionally misuse this item to encode other useful information.
-			 * It will encode flight status as three-digit number as follow:
-			 * most left digit encodes arm status (200=armed, 100=disarmed)
-			 * two most right digits encode flight mode number (see FlightStatus UAVO FlightMode enum)
-			 * To work properly on Taranis, you have to set Blades to "60" in telemetry setting
-			 */
-			FlightStatusData flight_status;
-			FlightStatusGet(&flight_status);
-
-			uint16_t status = 0;
-			float hdop, vdop;
-
-			status = (flight_status.Armed == FLIGHTSTATUS_ARMED_ARMED) ? 200 : 100;
-			status += flight_status.FlightMode;
-
-			msg_length += frsky_pack_rpm(status, shub_global->serial_buf + msg_length);
-
-			uint8_t hl_set = HOMELOCATION_SET_FALSE;
-			
-			if (GPSPositionHandle() != NULL)
-				GPSPositionGet(&gpsPosData);
-
-			if (HomeLocationHandle() != NULL)
-				HomeLocationSetGet(&hl_set);
-        
-			/**
-			 * Encode GPS status and visible satellites as T1 value
-			 * We will intentionally misuse this item to encode other useful information.
-			 * Right-most two digits encode visible satellite count, left-most digit has following meaning:
-			 * 1 - no GPS connected
-			 * 2 - no fix
-			 * 3 - 2D fix
-			 * 4 - 3D fix
-			 * 5 - 3D fix and HomeLocation is SET - should be safe for navigation
-			 */
-			switch (gpsPosData.Status) {
-			case GPSPOSITION_STATUS_NOGPS:
-			status = 100;
-				break;
-			case GPSPOSITION_STATUS_NOFIX:
-				status = 200;
-				break;
-			case GPSPOSITION_STATUS_FIX2D:
-				status = 300;
-				break;
-			case GPSPOSITION_STATUS_FIX3D:
-			case GPSPOSITION_STATUS_DIFF3D:
-				if (hl_set == HOMELOCATION_SET_TRUE)
-					status = 500;
-				else
-					status = 400;
-				break;
-			}
-	
-			if (gpsPosData.Satellites > 0)
-				status += gpsPosData.Satellites;
-
-			msg_length += frsky_pack_temperature_01((float)status, shub_global->serial_buf + msg_length);
-			
-			/**
-			 * Encode GPS HDOP and VDOP as T2 value
-			 * We will intentionally misuse this item to encode other useful information.
-			 * VDOP in the upper 16 bits, max 256 (2.56 * 100)
-			 * HDOP in the lower 16 bits, max 256 (2.56 * 100)
-			 */
-			hdop = gpsPosData.HDOP * 100.0f;
-			
-			if (hdop > 255.0f)
-				hdop = 255.0f;
-			
-			vdop = gpsPosData.VDOP * 100.0f;
-			
-			if (vdop > 255.0f)
-				vdop = 255.0f;
-			
-			msg_length += frsky_pack_temperature_02((vdop * 256 + hdop), shub_global->serial_buf + msg_length);
-
-			if (gpsPosData.Status == GPSPOSITION_STATUS_FIX2D ||
-			    gpsPosData.Status == GPSPOSITION_STATUS_FIX3D) {
-				msg_length += frsky_pack_gps(
-						gpsPosData.Heading,
-						gpsPosData.Latitude,
-						gpsPosData.Longitude,
-						gpsPosData.Altitude,
-						gpsPosData.Groundspeed,
-						shub_global->serial_buf + msg_length);
-			}
+		if (vdop > 255.0f)
+			vdop = 255.0f;
 
-			msg_length += frsky_pack_stop(shub_global->serial_buf + msg_length);
+		msg_length += frsky_pack_temperature_02((vdop * 256 + hdop), shub_global->serial_buf + msg_length);
 
-			PIOS_COM_SendBuffer(shub_global->frsky_port,
-					shub_global->serial_buf, msg_length);
+		if (gpsPosData->Status == GPSPOSITION_STATUS_FIX2D ||
+		    gpsPosData->Status == GPSPOSITION_STATUS_FIX3D) {
+			msg_length += frsky_pack_gps(
+					gpsPosData->Heading,
+					gpsPosData->Latitude,
+					gpsPosData->Longitude,
+					gpsPosData->Altitude,
+					gpsPosData->Groundspeed,
+					shub_global->serial_buf + msg_length);
 		}
+
+		msg_length += frsky_pack_stop(shub_global->serial_buf + msg_length);
+
+		PIOS_COM_SendBuffer(shub_global->frsky_port,
+				shub_global->serial_buf, msg_length);
 	}
 }
 
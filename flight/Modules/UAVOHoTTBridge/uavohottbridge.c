@@ -111,7 +111,7 @@ static int32_t uavoHoTTBridgeInitialize(void)
 	}
 	return 0;
 }
-MODULE_INITCALL( uavoHoTTBridgeInitialize, uavoHoTTBridgeStart)
+MODULE_DEFERRED_INITCALL( uavoHoTTBridgeInitialize, uavoHoTTBridgeStart)
 
 /**
  * Main task. It does not return.
@@ -44,24 +44,11 @@
  */
 #include "openpilot.h"
 
-#include "accels.h"
-#include "airspeedactual.h"
-#include "attitudeactual.h"
-#include "baroaltitude.h"
-#include "flightstatus.h"
-#include "gpsposition.h"
-#include "flightbatterysettings.h"
-#include "flightbatterystate.h"
-#include "manualcontrolcommand.h"
 #include "modulesettings.h"
-#include "positionactual.h"
-
-#include "pios_thread.h"
+#include "telemetry_bridge.h"
 
 #if defined(PIOS_INCLUDE_LIGHTTELEMETRY)
 // Private constants
-#define STACK_SIZE_BYTES 600
-#define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 #define UPDATE_PERIOD 100
 
 #define LTM_GFRAME_SIZE 18
@@ -72,19 +59,27 @@
 
 // Private variables
 static bool module_enabled;
-static struct pios_thread *taskHandle;
 static uint32_t lighttelemetryPort;
 static uint8_t ltm_scheduler;
 static uint8_t ltm_slowrate;
 
 // Private functions
-static void uavoLighttelemetryBridgeTask(void *parameters);
+static void uavoLighttelemetryBridgeSend(const struct telemetry_bridge_snapshot *snapshot);
 static void updateSettings();
 
 static void send_LTM_Packet(uint8_t *LTPacket, uint8_t LTPacket_size);
-static void send_LTM_Gframe();
-static void send_LTM_Aframe();
-static void send_LTM_Sframe();
+static void send_LTM_Gframe(const struct telemetry_bridge_snapshot *snapshot);
+static void send_LTM_Aframe(const struct telemetry_bridge_snapshot *snapshot);
+static void send_LTM_Sframe(const struct telemetry_bridge_snapshot *snapshot);
+
+static struct telemetry_bridge_encoder ltm_encoder = {
+	.objects = TELEMETRY_BRIDGE_ATTITUDE | TELEMETRY_BRIDGE_GPS_POSITION |
+		TELEMETRY_BRIDGE_BATTERY | TELEMETRY_BRIDGE_FLIGHT_STATUS |
+		TELEMETRY_BRIDGE_BARO | TELEMETRY_BRIDGE_MANUAL_CONTROL |
+		TELEMETRY_BRIDGE_POSITION | TELEMETRY_BRIDGE_AIRSPEED,
+	.period_ms = UPDATE_PERIOD,
+	.send = uavoLighttelemetryBridgeSend,
+};
 
 
 /**
@@ -116,7 +111,7 @@ int32_t uavoLighttelemetryBridgeInitialize()
 		else 
 			ltm_slowrate = 0;
 
-		return 0;
+		return telemetry_bridge_register(&ltm_encoder);
 	}
 	
 	return -1;
@@ -129,51 +124,37 @@ int32_t uavoLighttelemetryBridgeInitialize()
 int32_t uavoLighttelemetryBridgeStart()
 {
 	if ( module_enabled )
-	{
-		taskHandle = PIOS_Thread_Create(uavoLighttelemetryBridgeTask, "uavoLighttelemetryBridge", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-		TaskMonitorAdd(TASKINFO_RUNNING_UAVOLIGHTTELEMETRYBRIDGE, taskHandle);
-		return 0;
-	}
+		return telemetry_bridge_start();
 	
 	return -1;
 }
 
-MODULE_INITCALL(uavoLighttelemetryBridgeInitialize, uavoLighttelemetryBridgeStart);
+MODULE_DEFERRED_INITCALL(uavoLighttelemetryBridgeInitialize, uavoLighttelemetryBridgeStart);
 
 
 /*#######################################################################
- * Module thread, should not return.
+ * Called by the telemetry bridge every UPDATE_PERIOD
  *#######################################################################
 */
 
-static void uavoLighttelemetryBridgeTask(void *parameters)
+static void uavoLighttelemetryBridgeSend(const struct telemetry_bridge_snapshot *snapshot)
 {
-	uint32_t lastSysTime;
-
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
-	while (1)
+	if (ltm_scheduler & 1) {	// is odd
+		send_LTM_Aframe(snapshot);
+	}
+	else						// is even
 	{
-
-		if (ltm_scheduler & 1) {	// is odd
-			send_LTM_Aframe();
-		}
-		else						// is even
-		{
-			if (ltm_slowrate == 0)
-				send_LTM_Aframe();
-				
-			if (ltm_scheduler % 4 == 0)
-				send_LTM_Sframe();
-			else 
-				send_LTM_Gframe();
-		}
-		ltm_scheduler++;
-		if (ltm_scheduler > 10)
-			ltm_scheduler = 1;
-		// Delay until it is time to read the next sample
-		PIOS_Thread_Sleep_Until(&lastSysTime, UPDATE_PERIOD);
+		if (ltm_slowrate == 0)
+			send_LTM_Aframe(snapshot);
+			
+		if (ltm_scheduler % 4 == 0)
+			send_LTM_Sframe(snapshot);
+		else 
+			send_LTM_Gframe(snapshot);
 	}
+	ltm_scheduler++;
+	if (ltm_scheduler > 10)
+		ltm_scheduler = 1;
 }
 
 /*#######################################################################
@@ -181,31 +162,24 @@ static void uavoLighttelemetryBridgeTask(void *parameters)
  *#######################################################################
 */
 //GPS packet
-static void send_LTM_Gframe() 
+static void send_LTM_Gframe(const struct telemetry_bridge_snapshot *snapshot) 
 {
-	GPSPositionData pdata;
-
-	if (GPSPositionHandle() != NULL)
-		GPSPositionGet(&pdata);
+	const GPSPositionData *pdata = &snapshot->gps_position;
 
-	int32_t lt_latitude = pdata.Latitude;
-	int32_t lt_longitude = pdata.Longitude;
-	uint8_t lt_groundspeed = (uint8_t)roundf(pdata.Groundspeed); //rounded m/s .
+	int32_t lt_latitude = pdata->Latitude;
+	int32_t lt_longitude = pdata->Longitude;
+	uint8_t lt_groundspeed = (uint8_t)roundf(pdata->Groundspeed); //rounded m/s .
 	int32_t lt_altitude = 0;
-	if (PositionActualHandle() != NULL) {
-		float altitude;
-		PositionActualDownGet(&altitude);
-		lt_altitude = (int32_t)roundf(altitude * -100.0f);
-	} else if (BaroAltitudeHandle() != NULL) {
-		float altitude;
-		BaroAltitudeAltitudeGet(&altitude);
-		lt_altitude = (int32_t)roundf(altitude * 100.0f); //Baro alt in cm.
-	} else if (GPSPositionHandle() != NULL) {
-		lt_altitude = (int32_t)roundf(pdata.Altitude * 100.0f); //GPS alt in cm.
+	if (snapshot->valid & TELEMETRY_BRIDGE_POSITION) {
+		lt_altitude = (int32_t)roundf(snapshot->position_down * -100.0f);
+	} else if (snapshot->valid & TELEMETRY_BRIDGE_BARO) {
+		lt_altitude = (int32_t)roundf(snapshot->baro.Altitude * 100.0f); //Baro alt in cm.
+	} else if (snapshot->valid & TELEMETRY_BRIDGE_GPS_POSITION) {
+		lt_altitude = (int32_t)roundf(pdata->Altitude * 100.0f); //GPS alt in cm.
 	}
 	
 	uint8_t lt_gpsfix;
-	switch (pdata.Status) {
+	switch (pdata->Status) {
 	case GPSPOSITION_STATUS_NOGPS:
 		lt_gpsfix = 0;
 		break;
@@ -223,7 +197,7 @@ static void send_LTM_Gframe()
 		break;
 	}
 	
-	uint8_t lt_gpssats = (int8_t)pdata.Satellites;
+	uint8_t lt_gpssats = (int8_t)pdata->Satellites;
 	//pack G frame	
 	uint8_t LTBuff[LTM_GFRAME_SIZE];
 	//G Frame: $T(2 bytes)G(1byte)LAT(cm,4 bytes)LON(cm,4bytes)SPEED(m/s,1bytes)ALT(cm,4bytes)SATS(6bits)FIX(2bits)CRC(xor,1byte)
@@ -252,14 +226,13 @@ static void send_LTM_Gframe()
 }
 
 //Attitude packet
-static void send_LTM_Aframe() 
+static void send_LTM_Aframe(const struct telemetry_bridge_snapshot *snapshot) 
 {
 	//prepare data
-	AttitudeActualData adata;
-	AttitudeActualGet(&adata);
-	int16_t lt_pitch   = (int16_t)(roundf(adata.Pitch));	//-180/180°
-	int16_t lt_roll	   = (int16_t)(roundf(adata.Roll));		//-180/180°
-	int16_t lt_heading = (int16_t)(roundf(adata.Yaw));		//-180/180°
+	const AttitudeActualData *adata = &snapshot->attitude;
+	int16_t lt_pitch   = (int16_t)(roundf(adata->Pitch));	//-180/180°
+	int16_t lt_roll	   = (int16_t)(roundf(adata->Roll));		//-180/180°
+	int16_t lt_heading = (int16_t)(roundf(adata->Yaw));		//-180/180°
 	//pack A frame	
 	uint8_t LTBuff[LTM_AFRAME_SIZE];
 	
@@ -280,7 +253,7 @@ static void send_LTM_Aframe()
 }
 
 //Sensors packet
-static void send_LTM_Sframe() 
+static void send_LTM_Sframe(const struct telemetry_bridge_snapshot *snapshot) 
 {
 	//prepare data
 	uint16_t lt_vbat = 0;
@@ -292,35 +265,26 @@ static void send_LTM_Sframe()
 	uint8_t	 lt_flightmode = 0;
 	
 	
-	if (FlightBatteryStateHandle() != NULL) {
-		FlightBatteryStateData sdata;
-		FlightBatteryStateGet(&sdata);
-		lt_vbat = (uint16_t)roundf(sdata.Voltage*1000);	  //Battery voltage in mv
-		lt_amp = (uint16_t)roundf(sdata.ConsumedEnergy);	  //mA consumed
+	if (snapshot->valid & TELEMETRY_BRIDGE_BATTERY) {
+		lt_vbat = (uint16_t)roundf(snapshot->battery.Voltage*1000);	  //Battery voltage in mv
+		lt_amp = (uint16_t)roundf(snapshot->battery.ConsumedEnergy);	  //mA consumed
 	}
-	if (ManualControlCommandHandle() != NULL) {
-		ManualControlCommandData mdata;
-		ManualControlCommandGet(&mdata);
-		lt_rssi = (uint8_t)mdata.Rssi;					  //RSSI in %
+	if (snapshot->valid & TELEMETRY_BRIDGE_MANUAL_CONTROL) {
+		lt_rssi = (uint8_t)snapshot->manual_control.Rssi;		  //RSSI in %
 	}
-	if (AirspeedActualHandle() != NULL) {
-		AirspeedActualData adata;
-		AirspeedActualGet (&adata);
-		lt_airspeed = (uint8_t)roundf(adata.TrueAirspeed);	  //Airspeed in m/s
-	} else if (GPSPositionHandle() != NULL) {
-		float groundspeed;
-		GPSPositionGroundspeedGet(&groundspeed);
-		lt_airspeed = (uint8_t)roundf(groundspeed);
+	if (snapshot->valid & TELEMETRY_BRIDGE_AIRSPEED) {
+		lt_airspeed = (uint8_t)roundf(snapshot->true_airspeed);	  //Airspeed in m/s
+	} else if (snapshot->valid & TELEMETRY_BRIDGE_GPS_POSITION) {
+		lt_airspeed = (uint8_t)roundf(snapshot->gps_position.Groundspeed);
 	}
 
-	FlightStatusData fdata;
-	FlightStatusGet(&fdata);
-	lt_arm = fdata.Armed;									  //Armed status
+	const FlightStatusData *fdata = &snapshot->flight_status;
+	lt_arm = fdata->Armed;									  //Armed status
 	if (lt_arm == 1)		//arming , we don't use this one
 		lt_arm = 0;		
 	else if (lt_arm == 2)  // armed
 		lt_arm = 1;
-	if (fdata.ControlSource == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
+	if (fdata->ControlSource == FLIGHTSTATUS_CONTROLSOURCE_FAILSAFE)
 		lt_failsafe = 1;
 	else
 		lt_failsafe = 0;
@@ -329,7 +293,7 @@ static void send_LTM_Sframe()
 	// 8: Altitude Hold, 9: Loiter/GPS Hold, 10: Auto/Waypoints, 11: Heading Hold / headFree, 
 	// 12: Circle, 13: RTH, 14: FollowMe, 15: LAND, 16:FlybyWireA, 17: FlybywireB, 18: Cruise, 19: Unknown
 
-	switch (fdata.FlightMode) {
+	switch (fdata->FlightMode) {
 	case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
 		lt_flightmode = 0; break;
 	case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
@@ -33,39 +33,16 @@
 #include "physical_constants.h"
 #include "modulesettings.h"
 #include "flightbatterysettings.h"
-#include "flightbatterystate.h"
-#include "gpsposition.h"
-#include "manualcontrolcommand.h"
 #include "accessorydesired.h"
-#include "attitudeactual.h"
-#include "airspeedactual.h"
-#include "actuatorsettings.h"
-#include "actuatordesired.h"
-#include "flightstatus.h"
-#include "systemstats.h"
 #include "systemalarms.h"
-#include "homelocation.h"
-#include "baroaltitude.h"
 #include "pios_thread.h"
 #include "pios_sensors.h"
-
-#include "baroaltitude.h"
-#include "flightbatterysettings.h"
-#include "flightbatterystate.h"
-#include "gpsposition.h"
-#include "modulesettings.h"
+#include "telemetry_bridge.h"
 
 #include "msplib.h"
 
 #if defined(PIOS_INCLUDE_MSP_BRIDGE)
 
-#if defined(PIOS_MSP_STACK_SIZE)
-#define STACK_SIZE_BYTES PIOS_MSP_STACK_SIZE
-#else
-#define STACK_SIZE_BYTES 768
-#endif
-#define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
-
 #define MAX_ALARM_LEN 30
 
 #define BOOT_DISPLAY_TIME_MS (10*1000)
@@ -74,7 +51,18 @@ static bool module_enabled;
 extern uintptr_t pios_com_msp_id;
 static struct msp_bridge *msp;
 static int32_t uavoMSPBridgeInitialize(void);
-static void uavoMSPBridgeTask(void *parameters);
+static bool uavoMSPBridgeReceive(const struct telemetry_bridge_snapshot *snapshot, uint8_t b);
+
+//! What the requests are answered from, while they are handled
+static const struct telemetry_bridge_snapshot *snap;
+
+static struct telemetry_bridge_encoder msp_encoder = {
+	.objects = TELEMETRY_BRIDGE_ATTITUDE | TELEMETRY_BRIDGE_GPS_POSITION |
+		TELEMETRY_BRIDGE_BATTERY | TELEMETRY_BRIDGE_FLIGHT_STATUS |
+		TELEMETRY_BRIDGE_BARO | TELEMETRY_BRIDGE_MANUAL_CONTROL |
+		TELEMETRY_BRIDGE_HOME_LOCATION,
+	.receive = uavoMSPBridgeReceive,
+};
 
 static void msp_send_attitude(struct msp_bridge *m)
 {
@@ -86,15 +74,13 @@ static void msp_send_attitude(struct msp_bridge *m)
 			int16_t h;
 		} att;
 	} data;
-	AttitudeActualData attActual;
-
-	AttitudeActualGet(&attActual);
+	const AttitudeActualData *attActual = &snap->attitude;
 
 	// Roll and Pitch are in 10ths of a degree.
-	data.att.x = attActual.Roll * 10;
-	data.att.y = attActual.Pitch * -10;
+	data.att.x = attActual->Roll * 10;
+	data.att.y = attActual->Pitch * -10;
 	// Yaw is just -180 -> 180
-	data.att.h = attActual.Yaw;
+	data.att.h = attActual->Yaw;
 
 	msp_send_response(m, MSP_ATTITUDE, data.buf, sizeof(data));
 }
@@ -115,27 +101,21 @@ static void msp_send_status(struct msp_bridge *m)
 	data.status.cycleTime = 0;
 	data.status.i2cErrors = 0;
 	
-	GPSPositionData gpsData = {};
-	
-	if (GPSPositionHandle() != NULL)
-		GPSPositionGet(&gpsData);
-	
 	data.status.sensors = (PIOS_SENSORS_IsRegistered(PIOS_SENSOR_ACCEL) ? MSP_SENSOR_ACC  : 0) |
 		(PIOS_SENSORS_IsRegistered(PIOS_SENSOR_BARO) ? MSP_SENSOR_BARO : 0) |
 		(PIOS_SENSORS_IsRegistered(PIOS_SENSOR_MAG) ? MSP_SENSOR_MAG : 0) |
-		(gpsData.Status != GPSPOSITION_STATUS_NOGPS ? MSP_SENSOR_GPS : 0);
+		(snap->gps_position.Status != GPSPOSITION_STATUS_NOGPS ? MSP_SENSOR_GPS : 0);
 	
 	data.status.flags = 0;
 	data.status.setting = 0;
 
-	if (FlightStatusHandle() != NULL) {
-		FlightStatusData flight_status;
-		FlightStatusGet(&flight_status);
+	if (snap->valid & TELEMETRY_BRIDGE_FLIGHT_STATUS) {
+		const FlightStatusData *flight_status = &snap->flight_status;
 
-		data.status.flags = flight_status.Armed == FLIGHTSTATUS_ARMED_ARMED;
+		data.status.flags = flight_status->Armed == FLIGHTSTATUS_ARMED_ARMED;
 
 		for (int i = 1; msp_boxes[i].mode != MSP_BOX_LAST; i++) {
-			if (flight_status.FlightMode == msp_boxes[i].tlmode) {
+			if (flight_status->FlightMode == msp_boxes[i].tlmode) {
 				data.status.flags |= (1 << i);
 			}
 		}
@@ -158,27 +138,24 @@ static void msp_send_analog(struct msp_bridge *m)
 	data.status.powerMeterSum = 0;
 
 	FlightBatterySettingsData batSettings = {};
-	FlightBatteryStateData batState = {};
+	const FlightBatteryStateData *batState = &snap->battery;
 
-	if (FlightBatteryStateHandle() != NULL)
-		FlightBatteryStateGet(&batState);
 	if (FlightBatterySettingsHandle() != NULL) {
 		FlightBatterySettingsGet(&batSettings);
 	}
 
 	if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-		data.status.vbat = (uint8_t)lroundf(batState.Voltage * 10);
+		data.status.vbat = (uint8_t)lroundf(batState->Voltage * 10);
 
 	if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE) {
-		data.status.current = lroundf(batState.Current * 100);
-		data.status.powerMeterSum = lroundf(batState.ConsumedEnergy);
+		data.status.current = lroundf(batState->Current * 100);
+		data.status.powerMeterSum = lroundf(batState->ConsumedEnergy);
 	}
 
-	ManualControlCommandData manualState;
-	ManualControlCommandGet(&manualState);
+	int16_t rssi = snap->manual_control.Rssi;
 
 	// MSP RSSI's range is 0-1023
-	data.status.rssi = (manualState.Rssi >= 0 && manualState.Rssi <= 100) ? manualState.Rssi * 10 : 0;
+	data.status.rssi = (rssi >= 0 && rssi <= 100) ? rssi * 10 : 0;
 
 	msp_send_response(m, MSP_ANALOG, data.buf, sizeof(data));
 }
@@ -203,17 +180,16 @@ static void msp_send_raw_gps(struct msp_bridge *m)
 		} __attribute__((packed)) raw_gps;
 	} data;
 	
-	GPSPositionData gps_data = {};
+	const GPSPositionData *gps_data = &snap->gps_position;
 	
-	if (GPSPositionHandle() != NULL) {
-		GPSPositionGet(&gps_data);
-		data.raw_gps.fix           = (gps_data.Status >= GPSPOSITION_STATUS_FIX2D ? 1 : 0);  // Data will display on OSD if 2D fix or better
-		data.raw_gps.num_sat       = gps_data.Satellites;
-		data.raw_gps.lat           = gps_data.Latitude;
-		data.raw_gps.lon           = gps_data.Longitude;
-		data.raw_gps.alt           = gps_data.Altitude;
-		data.raw_gps.speed         = gps_data.Groundspeed;
-		data.raw_gps.ground_course = gps_data.Heading * 10;
+	if (snap->valid & TELEMETRY_BRIDGE_GPS_POSITION) {
+		data.raw_gps.fix           = (gps_data->Status >= GPSPOSITION_STATUS_FIX2D ? 1 : 0);  // Data will display on OSD if 2D fix or better
+		data.raw_gps.num_sat       = gps_data->Satellites;
+		data.raw_gps.lat           = gps_data->Latitude;
+		data.raw_gps.lon           = gps_data->Longitude;
+		data.raw_gps.alt           = gps_data->Altitude;
+		data.raw_gps.speed         = gps_data->Groundspeed;
+		data.raw_gps.ground_course = gps_data->Heading * 10;
 	} else {
 		data.raw_gps.fix           = 0;  // Data won't display on OSD
 		data.raw_gps.num_sat       = 0;
@@ -238,31 +214,28 @@ static void msp_send_comp_gps(struct msp_bridge *m)
 		} __attribute__((packed)) comp_gps;
 	} data;
 	
-	GPSPositionData gps_data   = {};
-	HomeLocationData home_data = {};
+	const GPSPositionData *gps_data   = &snap->gps_position;
+	const HomeLocationData *home_data = &snap->home_location;
 	
-	if ((GPSPositionHandle() == NULL) || (HomeLocationHandle() == NULL)) {
+	if (!(snap->valid & TELEMETRY_BRIDGE_GPS_POSITION) || !(snap->valid & TELEMETRY_BRIDGE_HOME_LOCATION)) {
 		data.comp_gps.distance_to_home    = 0;
 		data.comp_gps.direction_to_home   = 0;
 		data.comp_gps.home_position_valid = 0;  // Home distance and direction will not display on OSD
 	} else {
-		GPSPositionGet(&gps_data);
-		HomeLocationGet(&home_data);
-		
-		if((gps_data.Status < GPSPOSITION_STATUS_FIX2D) || (home_data.Set == HOMELOCATION_SET_FALSE)) {
+		if((gps_data->Status < GPSPOSITION_STATUS_FIX2D) || (home_data->Set == HOMELOCATION_SET_FALSE)) {
 			data.comp_gps.distance_to_home    = 0;
 			data.comp_gps.direction_to_home   = 0;
 			data.comp_gps.home_position_valid = 0;  // Home distance and direction will not display on OSD
 		} else {
 			data.comp_gps.home_position_valid = 1;  // Home distance and direction will display on OSD
 			
-			int32_t delta_lon = (home_data.Longitude - gps_data.Longitude);  // degrees * 1e7
-			int32_t delta_lat = (home_data.Latitude  - gps_data.Latitude );  // degrees * 1e7
+			int32_t delta_lon = (home_data->Longitude - gps_data->Longitude);  // degrees * 1e7
+			int32_t delta_lat = (home_data->Latitude  - gps_data->Latitude );  // degrees * 1e7
 	
 			float delta_y = delta_lon * WGS84_RADIUS_EARTH_KM * DEG2RAD;  // KM * 1e7
 			float delta_x = delta_lat * WGS84_RADIUS_EARTH_KM * DEG2RAD;  // KM * 1e7
 	
-			delta_y *= cosf(home_data.Latitude * 1e-7f * (float)DEG2RAD);  // Latitude compression correction
+			delta_y *= cosf(home_data->Latitude * 1e-7f * (float)DEG2RAD);  // Latitude compression correction
 	
 			data.comp_gps.distance_to_home  = (uint16_t)(sqrtf(delta_x * delta_x + delta_y * delta_y) * 1e-4f);  // meters
 	
@@ -286,11 +259,7 @@ static void msp_send_altitude(struct msp_bridge *m)
 		} __attribute__((packed)) baro;
 	} data;
 
-	BaroAltitudeData baro;
-	if (BaroAltitudeHandle() != NULL)
-		BaroAltitudeGet(&baro);
-
-	data.baro.alt = (int32_t)roundf(baro.Altitude * 100.0f);
+	data.baro.alt = (int32_t)roundf(snap->baro.Altitude * 100.0f);
 
 	msp_send_response(m, MSP_ALTITUDE, data.buf, sizeof(data));
 }
@@ -314,8 +283,7 @@ static uint16_t msp_scale_rc_thr(float percent) {
 static void msp_send_channels(struct msp_bridge *m)
 {
 	AccessoryDesiredData acc0, acc1, acc2;
-	ManualControlCommandData manualState;
-	ManualControlCommandGet(&manualState);
+	const ManualControlCommandData *manualState = &snap->manual_control;
 	AccessoryDesiredInstGet(0, &acc0);
 	AccessoryDesiredInstGet(1, &acc1);
 	AccessoryDesiredInstGet(2, &acc2);
@@ -325,10 +293,10 @@ static void msp_send_channels(struct msp_bridge *m)
 		uint16_t channels[8];
 	} data = {
 		.channels = {
-			msp_scale_rc(manualState.Roll),
-			msp_scale_rc(manualState.Pitch * -1), // TL pitch is backwards
-			msp_scale_rc(manualState.Yaw),
-			msp_scale_rc_thr(manualState.Throttle),
+			msp_scale_rc(manualState->Roll),
+			msp_scale_rc(manualState->Pitch * -1), // TL pitch is backwards
+			msp_scale_rc(manualState->Yaw),
+			msp_scale_rc_thr(manualState->Throttle),
 			msp_scale_rc(acc0.AccessoryVal),
 			msp_scale_rc(acc1.AccessoryVal),
 			msp_scale_rc(acc2.AccessoryVal),
@@ -446,13 +414,7 @@ static int32_t uavoMSPBridgeStart(void)
 		return -1;
 	}
 
-	struct pios_thread *task = PIOS_Thread_Create(
-		uavoMSPBridgeTask, "uavoMSPBridge",
-		STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
-	TaskMonitorAdd(TASKINFO_RUNNING_UAVOMSPBRIDGE,
-			task);
-
-	return 0;
+	return telemetry_bridge_start();
 }
 
 static void setMSPSpeed(struct msp_bridge *m)
@@ -504,9 +466,10 @@ static int32_t uavoMSPBridgeInitialize(void)
 			setMSPSpeed(msp);
 			msp_set_request_cb(msp, msp_response_cb);
 
+			msp_encoder.com = msp->com;
 			module_enabled = true;
 
-			return 0;
+			return telemetry_bridge_register(&msp_encoder);
 		}
 
 	}
@@ -515,27 +478,18 @@ static int32_t uavoMSPBridgeInitialize(void)
 
 	return -1;
 }
-MODULE_INITCALL(uavoMSPBridgeInitialize, uavoMSPBridgeStart)
+MODULE_DEFERRED_INITCALL(uavoMSPBridgeInitialize, uavoMSPBridgeStart)
 
 /**
- * Main task routine
- * @param[in] parameters parameter given by PIOS_Thread_Create()
+ * Called by the telemetry bridge for every byte received
+ * @param[in] snapshot objects read by the telemetry bridge
+ * @param[in] b received byte
+ * @returns false when the MSP parser gave up, no more bytes are handed in then
  */
-static void uavoMSPBridgeTask(void *parameters)
+static bool uavoMSPBridgeReceive(const struct telemetry_bridge_snapshot *snapshot, uint8_t b)
 {
-	while (1) {
-		uint8_t b = 0;
-		uint16_t count = PIOS_COM_ReceiveBuffer(msp->com, &b, 1, PIOS_QUEUE_TIMEOUT_MAX);
-		if (count) {
-			if (!msp_receive_byte(msp, b)) {
-				// Returning is considered risky here as
-				// that's unusual and this is an edge case.
-				while (1) {
-					PIOS_Thread_Sleep(60*1000);
-				}
-			}
-		}
-	}
+	snap = snapshot;
+	return msp_receive_byte(msp, b);
 }
 
 #endif //PIOS_INCLUDE_MSP_BRIDGE
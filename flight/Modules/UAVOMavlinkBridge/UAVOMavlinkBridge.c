@@ -44,6 +44,7 @@
 #include "baroaltitude.h"
 #include "mavlink.h"
 #include "pios_thread.h"
+#include "pios_queue.h"
 
 #include "custom_types.h"
 
@@ -51,7 +52,12 @@
 // Private functions
 
 static void uavoMavlinkBridgeTask(void *parameters);
-static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
+static void send_extended_status();
+static void send_rc_channels();
+static void send_position();
+static void send_extra1();
+static void send_extra2();
+static void send_message(uint8_t msgid, const void *payload, uint8_t length, uint8_t crc_extra);
 
 // ****************
 // Private constants
@@ -63,18 +69,35 @@ static bool stream_trigger(enum MAV_DATA_STREAM stream_num);
 #endif
 
 #define TASK_PRIORITY               PIOS_THREAD_PRIO_LOW
-#define TASK_RATE_HZ				10
 
 static const uint8_t mav_rates[] =
-	 { [MAV_DATA_STREAM_RAW_SENSORS]=0x02, //2Hz
+	 { [MAV_DATA_STREAM_RAW_SENSORS]=0x00, //not sent
 	   [MAV_DATA_STREAM_EXTENDED_STATUS]=0x02, //2Hz
 	   [MAV_DATA_STREAM_RC_CHANNELS]=0x05, //5Hz
 	   [MAV_DATA_STREAM_POSITION]=0x02, //2Hz
-	   [MAV_DATA_STREAM_EXTRA1]=0x0A, //10Hz
+	   [MAV_DATA_STREAM_EXTRA1]=0x32, //50Hz
 	   [MAV_DATA_STREAM_EXTRA2]=0x02 }; //2Hz
 
 #define MAXSTREAMS sizeof(mav_rates)
 
+//! Links below 38400 baud can't carry the fast streams
+#define SLOW_LINK_MAX_RATE 10
+
+#define MAVLINK_SYSTEM_ID 0
+#define MAVLINK_COMPONENT_ID 200
+
+// CRC extras of the messages sent, as in their mavlink_msg_*_pack()
+#define MAVLINK_MSG_ID_HEARTBEAT_CRC_EXTRA          50
+#define MAVLINK_MSG_ID_SYS_STATUS_CRC_EXTRA         124
+#define MAVLINK_MSG_ID_GPS_RAW_INT_CRC_EXTRA        24
+#define MAVLINK_MSG_ID_ATTITUDE_CRC_EXTRA           39
+#define MAVLINK_MSG_ID_RC_CHANNELS_RAW_CRC_EXTRA    244
+#define MAVLINK_MSG_ID_GPS_GLOBAL_ORIGIN_CRC_EXTRA  39
+#define MAVLINK_MSG_ID_VFR_HUD_CRC_EXTRA            20
+
+#define SEND_MESSAGE(name, payload) \
+	send_message(MAVLINK_MSG_ID_##name, &(payload), MAVLINK_MSG_ID_##name##_LEN, MAVLINK_MSG_ID_##name##_CRC_EXTRA)
+
 // ****************
 // Private variables
 
@@ -84,12 +107,17 @@ static uint32_t mavlink_port;
 
 static bool module_enabled = false;
 
-static uint8_t * stream_ticks;
+static uint8_t max_rate = 0xFF;
 
-static mavlink_message_t mavMsg;
+//! One periodic event per stream, the stream is the instance id
+static struct pios_queue *stream_queue;
+
+static uint8_t tx_seq;
 
 static uint8_t * serial_buf;
 
+static FlightBatterySettingsData batSettings;
+
 static void updateSettings();
 
 /**
@@ -126,355 +154,364 @@ static int32_t uavoMavlinkBridgeInitialize(void) {
 		updateSettings();
 
 		serial_buf = PIOS_malloc(MAVLINK_MAX_PACKET_LEN);
-		stream_ticks = PIOS_malloc(MAXSTREAMS);
+		stream_queue = PIOS_Queue_Create(MAXSTREAMS, sizeof(UAVObjEvent));
+		if (serial_buf == NULL || stream_queue == NULL) {
+			module_enabled = false;
+			return -1;
+		}
+
+		// The event dispatcher keeps the deadlines of all streams
 		for (int x = 0; x < MAXSTREAMS; ++x) {
-			stream_ticks[x] = (TASK_RATE_HZ / mav_rates[x]);
+			uint8_t rate = mav_rates[x] < max_rate ? mav_rates[x] : max_rate;
+			if (rate == 0)
+				continue;
+
+			UAVObjEvent ev = {
+				.obj    = NULL,
+				.instId = x,
+				.event  = EV_UPDATED_PERIODIC,
+			};
+			EventPeriodicQueueCreate(&ev, stream_queue, 1000 / rate);
 		}
 	} else {
 		module_enabled = false;
 	}
 	return 0;
 }
-MODULE_INITCALL( uavoMavlinkBridgeInitialize, uavoMavlinkBridgeStart)
+MODULE_DEFERRED_INITCALL( uavoMavlinkBridgeInitialize, uavoMavlinkBridgeStart)
 
 /**
  * Main task. It does not return.
  */
 
 static void uavoMavlinkBridgeTask(void *parameters) {
-	uint16_t msg_length;
-	uint32_t lastSysTime;
-	// Main task loop
-	lastSysTime = PIOS_Thread_Systime();
-
-	FlightBatterySettingsData batSettings = {};
-
 	if (FlightBatterySettingsHandle() != NULL )
 		FlightBatterySettingsGet(&batSettings);
 
-	SystemStatsData systemStats;
-
 	while (1) {
-		PIOS_Thread_Sleep_Until(&lastSysTime, 1000 / TASK_RATE_HZ);
-
-		if (stream_trigger(MAV_DATA_STREAM_EXTENDED_STATUS)) {
-			FlightBatteryStateData batState = {};
-
-			if (FlightBatteryStateHandle() != NULL )
-				FlightBatteryStateGet(&batState);
-
-			SystemStatsGet(&systemStats);
-
-			int8_t battery_remaining = 0;
-			if (batSettings.Capacity != 0) {
-				if (batState.ConsumedEnergy < batSettings.Capacity) {
-					battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
-				}
-			}
-
-			uint16_t voltage = 0;
-			if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
-				voltage = lroundf(batState.Voltage * 1000);
-
-			uint16_t current = 0;
-			if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
-				current = lroundf(batState.Current * 100);
-
-			mavlink_msg_sys_status_pack(0, 200, &mavMsg,
-					// onboard_control_sensors_present Bitmask showing which onboard controllers and sensors are present. Value of 0: not present. Value of 1: present. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_enabled Bitmask showing which onboard controllers and sensors are enabled:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// onboard_control_sensors_health Bitmask showing which onboard controllers and sensors are operational or have an error:  Value of 0: not enabled. Value of 1: enabled. Indices: 0: 3D gyro, 1: 3D acc, 2: 3D mag, 3: absolute pressure, 4: differential pressure, 5: GPS, 6: optical flow, 7: computer vision position, 8: laser based position, 9: external ground-truth (Vicon or Leica). Controllers: 10: 3D angular rate control 11: attitude stabilization, 12: yaw position, 13: z/altitude control, 14: x/y position control, 15: motor outputs / control
-					0,
-					// load Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000) should be always below 1000
-					(uint16_t)systemStats.CPULoad * 10,
-					// voltage_battery Battery voltage, in millivolts (1 = 1 millivolt)
-					voltage,
-					// current_battery Battery current, in 10*milliamperes (1 = 10 milliampere), -1: autopilot does not measure the current
-					current,
-					// battery_remaining Remaining battery energy: (0%: 0, 100%: 100), -1: autopilot estimate the remaining battery
-					battery_remaining,
-					// drop_rate_comm Communication drops in percent, (0%: 0, 100%: 10'000), (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_comm Communication errors (UART, I2C, SPI, CAN), dropped packets on all links (packets that were corrupted on reception on the MAV)
-					0,
-					// errors_count1 Autopilot-specific errors
-					0,
-					// errors_count2 Autopilot-specific errors
-					0,
-					// errors_count3 Autopilot-specific errors
-					0,
-					// errors_count4 Autopilot-specific errors
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-		}
+		UAVObjEvent ev;
 
-		if (stream_trigger(MAV_DATA_STREAM_RC_CHANNELS)) {
-			ManualControlCommandData manualState;
-			FlightStatusData flightStatus;
-
-			ManualControlCommandGet(&manualState);
-			FlightStatusGet(&flightStatus);
-			SystemStatsGet(&systemStats);
-
-			//TODO connect with RSSI object and pass in last argument
-			mavlink_msg_rc_channels_raw_pack(0, 200, &mavMsg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// port Servo output port (set of 8 outputs = 1 port). Most MAVs will just use one, but this allows to encode more than 8 servos.
-					0,
-					// chan1_raw RC channel 1 value, in microseconds
-					manualState.Channel[0],
-					// chan2_raw RC channel 2 value, in microseconds
-					manualState.Channel[1],
-					// chan3_raw RC channel 3 value, in microseconds
-					manualState.Channel[2],
-					// chan4_raw RC channel 4 value, in microseconds
-					manualState.Channel[3],
-					// chan5_raw RC channel 5 value, in microseconds
-					manualState.Channel[4],
-					// chan6_raw RC channel 6 value, in microseconds
-					manualState.Channel[5],
-					// chan7_raw RC channel 7 value, in microseconds
-					manualState.Channel[6],
-					// chan8_raw RC channel 8 value, in microseconds
-					manualState.Channel[7],
-					// rssi Receive signal strength indicator, 0: 0%, 255: 100%
-					manualState.Rssi);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-		}
+		// Each stream is only woken when it is due
+		if (PIOS_Queue_Receive(stream_queue, &ev, PIOS_QUEUE_TIMEOUT_MAX) != true)
+			continue;
 
-		if (stream_trigger(MAV_DATA_STREAM_POSITION)) {
-			GPSPositionData gpsPosData = {};
-			HomeLocationData homeLocation = {};
-			SystemStatsGet(&systemStats);
-
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (HomeLocationHandle() != NULL )
-				HomeLocationGet(&homeLocation);
-			SystemStatsGet(&systemStats);
-
-			uint8_t gps_fix_type;
-			switch (gpsPosData.Status)
-			{
-			case GPSPOSITION_STATUS_NOGPS:
-				gps_fix_type = 0;
-				break;
-			case GPSPOSITION_STATUS_NOFIX:
-				gps_fix_type = 1;
-				break;
-			case GPSPOSITION_STATUS_FIX2D:
-				gps_fix_type = 2;
-				break;
-			case GPSPOSITION_STATUS_FIX3D:
-			case GPSPOSITION_STATUS_DIFF3D:
-				gps_fix_type = 3;
-				break;
-			default:
-				gps_fix_type = 0;
-				break;
-			}
-
-			mavlink_msg_gps_raw_int_pack(0, 200, &mavMsg,
-					// time_usec Timestamp (microseconds since UNIX epoch or microseconds since system boot)
-					(uint64_t)systemStats.FlightTime * 1000,
-					// fix_type 0-1: no fix, 2: 2D fix, 3: 3D fix. Some applications will not use the value of this field unless it is at least two, so always correctly fill in the fix.
-					gps_fix_type,
-					// lat Latitude in 1E7 degrees
-					gpsPosData.Latitude,
-					// lon Longitude in 1E7 degrees
-					gpsPosData.Longitude,
-					// alt Altitude in 1E3 meters (millimeters) above MSL
-					gpsPosData.Altitude * 1000,
-					// eph GPS HDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.HDOP * 100,
-					// epv GPS VDOP horizontal dilution of position in cm (m*100). If unknown, set to: 65535
-					gpsPosData.VDOP * 100,
-					// vel GPS ground speed (m/s * 100). If unknown, set to: 65535
-					gpsPosData.Groundspeed * 100,
-					// cog Course over ground (NOT heading, but direction of movement) in degrees * 100, 0.0..359.99 degrees. If unknown, set to: 65535
-					gpsPosData.Heading * 100,
-					// satellites_visible Number of satellites visible. If unknown, set to 255
-					gpsPosData.Satellites);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			mavlink_msg_gps_global_origin_pack(0, 200, &mavMsg,
-					// latitude Latitude (WGS84), expressed as * 1E7
-					homeLocation.Latitude,
-					// longitude Longitude (WGS84), expressed as * 1E7
-					homeLocation.Longitude,
-					// altitude Altitude(WGS84), expressed as * 1000
-					homeLocation.Altitude * 1000);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			//TODO add waypoint nav stuff
-			//wp_target_bearing
-			//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
-			//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
-			//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
-			//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
-			//mavlink_msg_nav_controller_output_pack
-			//wp_number
-			//mavlink_msg_mission_current_pack
+		switch (ev.instId) {
+		case MAV_DATA_STREAM_EXTENDED_STATUS:
+			send_extended_status();
+			break;
+		case MAV_DATA_STREAM_RC_CHANNELS:
+			send_rc_channels();
+			break;
+		case MAV_DATA_STREAM_POSITION:
+			send_position();
+			break;
+		case MAV_DATA_STREAM_EXTRA1:
+			send_extra1();
+			break;
+		case MAV_DATA_STREAM_EXTRA2:
+			send_extra2();
+			break;
 		}
+	}
+}
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA1)) {
-			AttitudeActualData attActual;
-			SystemStatsData systemStats;
-
-			AttitudeActualGet(&attActual);
-			SystemStatsGet(&systemStats);
-
-			mavlink_msg_attitude_pack(0, 200, &mavMsg,
-					// time_boot_ms Timestamp (milliseconds since system boot)
-					systemStats.FlightTime,
-					// roll Roll angle (rad)
-					attActual.Roll * DEG2RAD,
-					// pitch Pitch angle (rad)
-					attActual.Pitch * DEG2RAD,
-					// yaw Yaw angle (rad)
-					attActual.Yaw * DEG2RAD,
-					// rollspeed Roll angular speed (rad/s)
-					0,
-					// pitchspeed Pitch angular speed (rad/s)
-					0,
-					// yawspeed Yaw angular speed (rad/s)
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-		}
+static void send_extended_status()
+{
+	FlightBatteryStateData batState = {};
+	SystemStatsData systemStats;
+
+	if (FlightBatteryStateHandle() != NULL )
+		FlightBatteryStateGet(&batState);
+
+	SystemStatsGet(&systemStats);
 
-		if (stream_trigger(MAV_DATA_STREAM_EXTRA2)) {
-			ActuatorDesiredData actDesired;
-			AttitudeActualData attActual;
-			AirspeedActualData airspeedActual = {};
-			GPSPositionData gpsPosData = {};
-			BaroAltitudeData baroAltitude = {};
-			FlightStatusData flightStatus;
-
-			if (AirspeedActualHandle() != NULL )
-				AirspeedActualGet(&airspeedActual);
-			if (GPSPositionHandle() != NULL )
-				GPSPositionGet(&gpsPosData);
-			if (BaroAltitudeHandle() != NULL )
-				BaroAltitudeGet(&baroAltitude);
-			ActuatorDesiredGet(&actDesired);
-			AttitudeActualGet(&attActual);
-			FlightStatusGet(&flightStatus);
-
-			float altitude = 0;
-			if (BaroAltitudeHandle() != NULL)
-				altitude = baroAltitude.Altitude;
-			else if (GPSPositionHandle() != NULL)
-				altitude = gpsPosData.Altitude;
-
-			// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
-			int16_t heading = lroundf(attActual.Yaw);
-			if (heading < 0)
-				heading += 360;
-
-			mavlink_msg_vfr_hud_pack(0, 200, &mavMsg,
-					// airspeed Current airspeed in m/s
-					airspeedActual.TrueAirspeed,
-					// groundspeed Current ground speed in m/s
-					gpsPosData.Groundspeed,
-					// heading Current heading in degrees, in compass units (0..360, 0=north)
-					heading,
-					// throttle Current throttle setting in integer percent, 0 to 100
-					actDesired.Throttle * 100,
-					// alt Current altitude (MSL), in meters
-					altitude,
-					// climb Current climb rate in meters/second
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
-
-			uint8_t armed_mode = 0;
-			if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
-				armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
-
-			uint8_t custom_mode = CUSTOM_MODE_STAB;
-
-			switch (flightStatus.FlightMode) {
-				case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
-				case FLIGHTSTATUS_FLIGHTMODE_MWRATE:
-				case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
-				case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
-					/* Kinda a catch all */
-					custom_mode = CUSTOM_MODE_SPORT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ACRO:
-				case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
-					custom_mode = CUSTOM_MODE_ACRO;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
-				case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
-					/* May want these three to try and
-					 * infer based on roll axis */
-				case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
-					custom_mode = CUSTOM_MODE_STAB;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
-					custom_mode = CUSTOM_MODE_DRIFT;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
-					custom_mode = CUSTOM_MODE_ALTH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
-					custom_mode = CUSTOM_MODE_RTL;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
-				case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
-					custom_mode = CUSTOM_MODE_POSH;
-					break;
-				case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
-					custom_mode = CUSTOM_MODE_AUTO;
-					break;
-			}
-
-			mavlink_msg_heartbeat_pack(0, 200, &mavMsg,
-					// type Type of the MAV (quadrotor, helicopter, etc., up to 15 types, defined in MAV_TYPE ENUM)
-					MAV_TYPE_GENERIC,
-					// autopilot Autopilot type / class. defined in MAV_AUTOPILOT ENUM
-					MAV_AUTOPILOT_GENERIC,
-					// base_mode System mode bitfield, see MAV_MODE_FLAGS ENUM in mavlink/include/mavlink_types.h
-					armed_mode,
-					// custom_mode A bitfield for use for autopilot-specific flags.
-					custom_mode,
-					// system_status System status flag, see MAV_STATE ENUM
-					0);
-			msg_length = mavlink_msg_to_send_buffer(serial_buf, &mavMsg);
-			PIOS_COM_SendBuffer(mavlink_port, serial_buf, msg_length);
+	int8_t battery_remaining = 0;
+	if (batSettings.Capacity != 0) {
+		if (batState.ConsumedEnergy < batSettings.Capacity) {
+			battery_remaining = 100 - lroundf(batState.ConsumedEnergy / batSettings.Capacity * 100);
 		}
 	}
+
+	uint16_t voltage = 0;
+	if (batSettings.VoltagePin != FLIGHTBATTERYSETTINGS_VOLTAGEPIN_NONE)
+		voltage = lroundf(batState.Voltage * 1000);
+
+	uint16_t current = 0;
+	if (batSettings.CurrentPin != FLIGHTBATTERYSETTINGS_CURRENTPIN_NONE)
+		current = lroundf(batState.Current * 100);
+
+	// Sensors present, enabled and healthy, the drop rate and the
+	// error counters are not reported
+	mavlink_sys_status_t sys_status = {
+		// Maximum usage in percent of the mainloop time, (0%: 0, 100%: 1000)
+		.load = (uint16_t)systemStats.CPULoad * 10,
+		// Battery voltage, in millivolts
+		.voltage_battery = voltage,
+		// Battery current, in 10*milliamperes
+		.current_battery = current,
+		// Remaining battery energy: (0%: 0, 100%: 100)
+		.battery_remaining = battery_remaining,
+	};
+	SEND_MESSAGE(SYS_STATUS, sys_status);
 }
 
-static bool stream_trigger(enum MAV_DATA_STREAM stream_num) {
-	uint8_t rate = (uint8_t) mav_rates[stream_num];
+static void send_rc_channels()
+{
+	ManualControlCommandData manualState;
+	SystemStatsData systemStats;
 
-	if (rate == 0) {
-		return false;
+	ManualControlCommandGet(&manualState);
+	SystemStatsGet(&systemStats);
+
+	mavlink_rc_channels_raw_t rc_channels_raw = {
+		.time_boot_ms = systemStats.FlightTime,
+		// Servo output port (set of 8 outputs = 1 port)
+		.port = 0,
+		// RC channel values, in microseconds
+		.chan1_raw = manualState.Channel[0],
+		.chan2_raw = manualState.Channel[1],
+		.chan3_raw = manualState.Channel[2],
+		.chan4_raw = manualState.Channel[3],
+		.chan5_raw = manualState.Channel[4],
+		.chan6_raw = manualState.Channel[5],
+		.chan7_raw = manualState.Channel[6],
+		.chan8_raw = manualState.Channel[7],
+		// Receive signal strength indicator, 0: 0%, 255: 100%
+		.rssi = manualState.Rssi,
+	};
+	SEND_MESSAGE(RC_CHANNELS_RAW, rc_channels_raw);
+}
+
+static void send_position()
+{
+	GPSPositionData gpsPosData = {};
+	HomeLocationData homeLocation = {};
+	SystemStatsData systemStats;
+
+	if (GPSPositionHandle() != NULL )
+		GPSPositionGet(&gpsPosData);
+	if (HomeLocationHandle() != NULL )
+		HomeLocationGet(&homeLocation);
+	SystemStatsGet(&systemStats);
+
+	uint8_t gps_fix_type;
+	switch (gpsPosData.Status)
+	{
+	case GPSPOSITION_STATUS_NOGPS:
+		gps_fix_type = 0;
+		break;
+	case GPSPOSITION_STATUS_NOFIX:
+		gps_fix_type = 1;
+		break;
+	case GPSPOSITION_STATUS_FIX2D:
+		gps_fix_type = 2;
+		break;
+	case GPSPOSITION_STATUS_FIX3D:
+	case GPSPOSITION_STATUS_DIFF3D:
+		gps_fix_type = 3;
+		break;
+	default:
+		gps_fix_type = 0;
+		break;
 	}
 
-	if (stream_ticks[stream_num] == 0) {
-		// we're triggering now, setup the next trigger point
-		if (rate > TASK_RATE_HZ) {
-			rate = TASK_RATE_HZ;
-		}
-		stream_ticks[stream_num] = (TASK_RATE_HZ / rate);
-		return true;
+	mavlink_gps_raw_int_t gps_raw_int = {
+		// Timestamp (microseconds since system boot)
+		.time_usec = (uint64_t)systemStats.FlightTime * 1000,
+		// 0-1: no fix, 2: 2D fix, 3: 3D fix
+		.fix_type = gps_fix_type,
+		// Latitude and longitude in 1E7 degrees
+		.lat = gpsPosData.Latitude,
+		.lon = gpsPosData.Longitude,
+		// Altitude in 1E3 meters (millimeters) above MSL
+		.alt = gpsPosData.Altitude * 1000,
+		// GPS HDOP and VDOP in cm (m*100)
+		.eph = gpsPosData.HDOP * 100,
+		.epv = gpsPosData.VDOP * 100,
+		// GPS ground speed (m/s * 100)
+		.vel = gpsPosData.Groundspeed * 100,
+		// Course over ground in degrees * 100, 0.0..359.99 degrees
+		.cog = gpsPosData.Heading * 100,
+		.satellites_visible = gpsPosData.Satellites,
+	};
+	SEND_MESSAGE(GPS_RAW_INT, gps_raw_int);
+
+	mavlink_gps_global_origin_t gps_global_origin = {
+		// Latitude and longitude (WGS84), expressed as * 1E7
+		.latitude = homeLocation.Latitude,
+		.longitude = homeLocation.Longitude,
+		// Altitude(WGS84), expressed as * 1000
+		.altitude = homeLocation.Altitude * 1000,
+	};
+	SEND_MESSAGE(GPS_GLOBAL_ORIGIN, gps_global_origin);
+
+	//TODO add waypoint nav stuff
+	//wp_target_bearing
+	//wp_dist = mavlink_msg_nav_controller_output_get_wp_dist(&msg);
+	//alt_error = mavlink_msg_nav_controller_output_get_alt_error(&msg);
+	//aspd_error = mavlink_msg_nav_controller_output_get_aspd_error(&msg);
+	//xtrack_error = mavlink_msg_nav_controller_output_get_xtrack_error(&msg);
+	//mavlink_msg_nav_controller_output_pack
+	//wp_number
+	//mavlink_msg_mission_current_pack
+}
+
+static void send_extra1()
+{
+	AttitudeActualData attActual;
+	SystemStatsData systemStats;
+
+	AttitudeActualGet(&attActual);
+	SystemStatsGet(&systemStats);
+
+	mavlink_attitude_t attitude = {
+		.time_boot_ms = systemStats.FlightTime,
+		// Angles in rad, the angular speeds are not reported
+		.roll = attActual.Roll * DEG2RAD,
+		.pitch = attActual.Pitch * DEG2RAD,
+		.yaw = attActual.Yaw * DEG2RAD,
+	};
+	SEND_MESSAGE(ATTITUDE, attitude);
+}
+
+static void send_extra2()
+{
+	ActuatorDesiredData actDesired;
+	AttitudeActualData attActual;
+	AirspeedActualData airspeedActual = {};
+	GPSPositionData gpsPosData = {};
+	BaroAltitudeData baroAltitude = {};
+	FlightStatusData flightStatus;
+
+	if (AirspeedActualHandle() != NULL )
+		AirspeedActualGet(&airspeedActual);
+	if (GPSPositionHandle() != NULL )
+		GPSPositionGet(&gpsPosData);
+	if (BaroAltitudeHandle() != NULL )
+		BaroAltitudeGet(&baroAltitude);
+	ActuatorDesiredGet(&actDesired);
+	AttitudeActualGet(&attActual);
+	FlightStatusGet(&flightStatus);
+
+	float altitude = 0;
+	if (BaroAltitudeHandle() != NULL)
+		altitude = baroAltitude.Altitude;
+	else if (GPSPositionHandle() != NULL)
+		altitude = gpsPosData.Altitude;
+
+	// round attActual.Yaw to nearest int and transfer from (-180 ... 180) to (0 ... 360)
+	int16_t heading = lroundf(attActual.Yaw);
+	if (heading < 0)
+		heading += 360;
+
+	mavlink_vfr_hud_t vfr_hud = {
+		// Current airspeed and ground speed in m/s
+		.airspeed = airspeedActual.TrueAirspeed,
+		.groundspeed = gpsPosData.Groundspeed,
+		// Current heading in degrees, in compass units (0..360, 0=north)
+		.heading = heading,
+		// Current throttle setting in integer percent, 0 to 100
+		.throttle = actDesired.Throttle * 100,
+		// Current altitude (MSL), in meters
+		.alt = altitude,
+		// Current climb rate in meters/second
+		.climb = 0,
+	};
+	SEND_MESSAGE(VFR_HUD, vfr_hud);
+
+	uint8_t armed_mode = 0;
+	if (flightStatus.Armed == FLIGHTSTATUS_ARMED_ARMED)
+		armed_mode |= MAV_MODE_FLAG_SAFETY_ARMED;
+
+	uint8_t custom_mode = CUSTOM_MODE_STAB;
+
+	switch (flightStatus.FlightMode) {
+		case FLIGHTSTATUS_FLIGHTMODE_MANUAL:
+		case FLIGHTSTATUS_FLIGHTMODE_MWRATE:
+		case FLIGHTSTATUS_FLIGHTMODE_VIRTUALBAR:
+		case FLIGHTSTATUS_FLIGHTMODE_HORIZON:
+			/* Kinda a catch all */
+			custom_mode = CUSTOM_MODE_SPORT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ACRO:
+		case FLIGHTSTATUS_FLIGHTMODE_AXISLOCK:
+			custom_mode = CUSTOM_MODE_ACRO;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED1:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED2:
+		case FLIGHTSTATUS_FLIGHTMODE_STABILIZED3:
+			/* May want these three to try and
+			 * infer based on roll axis */
+		case FLIGHTSTATUS_FLIGHTMODE_LEVELING:
+			custom_mode = CUSTOM_MODE_STAB;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_AUTOTUNE:
+			custom_mode = CUSTOM_MODE_DRIFT;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_ALTITUDEHOLD:
+			custom_mode = CUSTOM_MODE_ALTH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_RETURNTOHOME:
+			custom_mode = CUSTOM_MODE_RTL;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_TABLETCONTROL:
+		case FLIGHTSTATUS_FLIGHTMODE_POSITIONHOLD:
+			custom_mode = CUSTOM_MODE_POSH;
+			break;
+		case FLIGHTSTATUS_FLIGHTMODE_PATHPLANNER:
+			custom_mode = CUSTOM_MODE_AUTO;
+			break;
 	}
 
-	// count down at 50Hz
-	stream_ticks[stream_num]--;
-	return false;
+	mavlink_heartbeat_t heartbeat = {
+		// Type of the MAV (quadrotor, helicopter, etc.)
+		.type = MAV_TYPE_GENERIC,
+		// Autopilot type / class
+		.autopilot = MAV_AUTOPILOT_GENERIC,
+		// System mode bitfield, see MAV_MODE_FLAGS ENUM
+		.base_mode = armed_mode,
+		// A bitfield for use for autopilot-specific flags
+		.custom_mode = custom_mode,
+		// System status flag, see MAV_STATE ENUM
+		.system_status = 0,
+		.mavlink_version = 3,
+	};
+	SEND_MESSAGE(HEARTBEAT, heartbeat);
+}
+
+/**
+ * Frame a message and send it. The frame is written straight into the
+ * transmit buffer of the port, only when there is no room in one piece
+ * it is assembled in serial_buf and copied.
+ * \param[in] payload The message struct, its fields are in wire order
+ * \param[in] length The length of the payload on the wire
+ */
+static void send_message(uint8_t msgid, const void *payload, uint8_t length, uint8_t crc_extra)
+{
+	uint16_t frame_length = length + MAVLINK_NUM_NON_PAYLOAD_BYTES;
+
+	uint8_t *frame = PIOS_COM_ReserveTx(mavlink_port, frame_length);
+	bool reserved = frame != NULL;
+	if (!reserved)
+		frame = serial_buf;
+
+	frame[0] = MAVLINK_STX;
+	frame[1] = length;
+	frame[2] = tx_seq++;
+	frame[3] = MAVLINK_SYSTEM_ID;
+	frame[4] = MAVLINK_COMPONENT_ID;
+	frame[5] = msgid;
+	memcpy(&frame[MAVLINK_NUM_HEADER_BYTES], payload, length);
+
+	uint16_t checksum = crc_calculate(&frame[1], MAVLINK_CORE_HEADER_LEN + length);
+	crc_accumulate(crc_extra, &checksum);
+	frame[MAVLINK_NUM_HEADER_BYTES + length] = (uint8_t)(checksum & 0xFF);
+	frame[MAVLINK_NUM_HEADER_BYTES + length + 1] = (uint8_t)(checksum >> 8);
+
+	if (reserved)
+		PIOS_COM_CommitTx(mavlink_port, frame_length);
+	else
+		PIOS_COM_SendBuffer(mavlink_port, frame, frame_length);
 }
 
 static void updateSettings()
@@ -509,6 +546,9 @@ static void updateSettings()
 			PIOS_COM_ChangeBaud(mavlink_port, 115200);
 			break;
 		}
+
+		if (speed < MODULESETTINGS_MAVLINKSPEED_38400)
+			max_rate = SLOW_LINK_MAX_RATE;
 	}
 }
 /**
@@ -273,7 +273,7 @@ static int32_t uavoTaranisInitialize(void)
 
 	return -1;
 }
-MODULE_INITCALL(uavoTaranisInitialize, uavoTaranisStart)
+MODULE_DEFERRED_INITCALL(uavoTaranisInitialize, uavoTaranisStart)
 
 /**
  * Main task. It does not return.
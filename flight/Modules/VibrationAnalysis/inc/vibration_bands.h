@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @{
+ *
+ * @file       vibration_bands.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Streaming vibration amplitude in a few frequency bands
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef VIBRATION_BANDS_H
+#define VIBRATION_BANDS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define VIBRATION_BANDS_MAX 8
+
+/**
+ * One axis. Each band is a complex resonator, a single bin of a DFT whose
+ * window decays exponentially, so it is updated on every sample with the
+ * same few floats whatever the resolution.
+ *
+ * The resonator of a band turns with the frequency of the vibration that
+ * drives it. Its phase advance over some samples gives the frequency of
+ * the strongest vibration, between the bands as well.
+ */
+struct vibration_bands {
+	uint8_t enabled;                        //!< Bit per band with a frequency below Nyquist
+	float sample_rate;                      //!< Hz
+	float gain;                             //!< From resonator output to amplitude
+
+	float coef_re[VIBRATION_BANDS_MAX];     //!< Decay times the rotation per sample
+	float coef_im[VIBRATION_BANDS_MAX];
+	float state_re[VIBRATION_BANDS_MAX];
+	float state_im[VIBRATION_BANDS_MAX];
+
+	uint16_t decimation;                    //!< Samples per peak update
+	uint16_t count;
+	uint8_t peak_band;
+	float last_re;                          //!< State of the peak band one sample before
+	float last_im;
+	float advance_re;                       //!< Sum of its phase advances
+	float advance_im;
+	float peak_frequency;                   //!< Hz
+	float peak_amplitude;
+};
+
+int32_t vibration_bands_init(struct vibration_bands *vb, const float *frequencies, uint8_t num_bands,
+		float sample_rate, float bandwidth, uint16_t decimation);
+bool vibration_bands_update(struct vibration_bands *vb, float sample);
+float vibration_bands_amplitude(const struct vibration_bands *vb, uint8_t band);
+
+#endif /* VIBRATION_BANDS_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VibrationAnalysisModule Vibration analysis module
+ * @{
+ *
+ * @file       vibration_bands.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Streaming vibration amplitude in a few frequency bands
+ *
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "vibration_bands.h"
+#include "physical_constants.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * Set up the bands of one axis
+ * @param[in] frequencies Centre of each band in Hz, 0 for bands not used
+ * @param[in] sample_rate Rate update is called at in Hz
+ * @param[in] bandwidth Width of each band in Hz, it also sets how fast the
+ *            amplitudes follow, the time constant is 1 / (pi bandwidth)
+ * @param[in] decimation Samples between updates of the peak
+ * @return 0 on success, -1 if the parameters make no sense
+ */
+int32_t vibration_bands_init(struct vibration_bands *vb, const float *frequencies, uint8_t num_bands,
+		float sample_rate, float bandwidth, uint16_t decimation)
+{
+	memset(vb, 0, sizeof(*vb));
+
+	if (num_bands > VIBRATION_BANDS_MAX || !(sample_rate > 0) || !(bandwidth > 0) || decimation == 0)
+		return -1;
+
+	// The -3 dB width of a resonator decaying by r per sample is about
+	// (1 - r) * sample_rate / pi
+	float r = expf(-PI * bandwidth / sample_rate);
+
+	vb->sample_rate = sample_rate;
+	vb->decimation = decimation;
+
+	// A tone of amplitude A puts A/2 at its positive frequency, which the
+	// resonator sums up to A/2 / (1 - r)
+	vb->gain = 2 * (1 - r);
+
+	for (uint8_t i = 0; i < num_bands; i++) {
+		if (!(frequencies[i] > 0) || frequencies[i] >= sample_rate / 2)
+			continue;
+
+		float w = 2 * PI * frequencies[i] / sample_rate;
+		vb->coef_re[i] = r * cosf(w);
+		vb->coef_im[i] = r * sinf(w);
+		vb->enabled |= 1 << i;
+	}
+
+	return 0;
+}
+
+/**
+ * Add a sample to all bands
+ * @param[in] sample Acceleration with the bias removed
+ * @return true when the peak was updated
+ */
+bool vibration_bands_update(struct vibration_bands *vb, float sample)
+{
+	for (uint8_t i = 0; i < VIBRATION_BANDS_MAX; i++) {
+		if (!(vb->enabled & (1 << i)))
+			continue;
+
+		float re = vb->state_re[i];
+		float im = vb->state_im[i];
+		vb->state_re[i] = vb->coef_re[i] * re - vb->coef_im[i] * im + sample;
+		vb->state_im[i] = vb->coef_re[i] * im + vb->coef_im[i] * re;
+	}
+
+	if (vb->enabled == 0)
+		return false;
+
+	// Phase advance of the peak band over the last sample, as the product
+	// with the conjugate of its last state. Summed as complex numbers so a
+	// single atan2 per update is enough.
+	uint8_t p = vb->peak_band;
+	float re = vb->state_re[p];
+	float im = vb->state_im[p];
+	vb->advance_re += re * vb->last_re + im * vb->last_im;
+	vb->advance_im += im * vb->last_re - re * vb->last_im;
+	vb->last_re = re;
+	vb->last_im = im;
+
+	if (++vb->count < vb->decimation)
+		return false;
+
+	vb->count = 0;
+
+	if (vb->advance_re != 0 || vb->advance_im != 0)
+		vb->peak_frequency = fabsf(atan2f(vb->advance_im, vb->advance_re)) * vb->sample_rate / (2 * PI);
+
+	// The band to follow until the next update
+	float max_power = -1;
+	for (uint8_t i = 0; i < VIBRATION_BANDS_MAX; i++) {
+		if (!(vb->enabled & (1 << i)))
+			continue;
+
+		float power = vb->state_re[i] * vb->state_re[i] + vb->state_im[i] * vb->state_im[i];
+		if (power > max_power) {
+			max_power = power;
+			vb->peak_band = i;
+		}
+	}
+
+	vb->peak_amplitude = vb->gain * sqrtf(max_power);
+	vb->last_re = vb->state_re[vb->peak_band];
+	vb->last_im = vb->state_im[vb->peak_band];
+	vb->advance_re = 0;
+	vb->advance_im = 0;
+
+	return true;
+}
+
+/**
+ * Amplitude of the vibration in a band
+ * @return The amplitude in the units of the samples, 0 for bands not used
+ */
+float vibration_bands_amplitude(const struct vibration_bands *vb, uint8_t band)
+{
+	if (band >= VIBRATION_BANDS_MAX || !(vb->enabled & (1 << band)))
+		return 0;
+
+	return vb->gain * sqrtf(vb->state_re[band] * vb->state_re[band] +
+			vb->state_im[band] * vb->state_im[band]);
+}
+
+/**
+ * @}
+ * @}
+ */
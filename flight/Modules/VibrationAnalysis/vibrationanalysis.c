@@ -35,6 +35,11 @@
  * This module executes on a timer trigger. When the module is
  * triggered it will update the data of VibrationAnalysiOutput, based on
  * the output of an FFT running on the accelerometer samples. 
+ *
+ * In the Bands mode there is no FFT. The amplitude in a few bands and the
+ * frequency of the strongest vibration are updated with every sample into
+ * @ref VibrationAnalysisBands, from a few hundred bytes whatever the
+ * resolution.
  */
 
 #include "openpilot.h"
@@ -45,8 +50,10 @@
 
 #include "accels.h"
 #include "modulesettings.h"
+#include "vibrationanalysisbands.h"
 #include "vibrationanalysisoutput.h"
 #include "vibrationanalysissettings.h"
+#include "vibration_bands.h"
 
 
 // Private constants
@@ -59,9 +66,12 @@
 																				  // but instead from the heap. Nonetheless, we 
 																				  // can know a priori how much RAM this module 
 																				  // will take.
+#define BANDS_STACK_SIZE_BYTES (200 + 484 + 160) // The bands are published from the stack
 #define TASK_PRIORITY PIOS_THREAD_PRIO_LOW
 #define SETTINGS_THROTTLING_MS 100
 
+#define BANDS_UPDATE_MS 100
+
 #define MAX_ACCEL_RANGE 16                          // Maximum accelerometer resolution in [g]
 #define FLOAT_TO_Q15 (32768/(MAX_ACCEL_RANGE*GRAVITY)) // This is the scaling constant that scales all input floats to +-
 
@@ -88,11 +98,18 @@ static struct VibrationAnalysis_data {
 	int16_t *accel_buffer_complex_z_q15;
 	
 	int16_t *fft_output;
+
+	//! In the Bands mode, one per axis instead of the FFT buffers
+	struct vibration_bands *bands;
+	uint16_t bands_sample_rate_ms;
 } *vtd;
 
 
 // Private functions
 static void VibrationAnalysisTask(void *parameters);
+static int32_t VibrationAnalysisStartBands(void);
+static void updateBands(float x, float y, float z, uint16_t sampleRate_ms);
+static void bandsSettingsUpdated(UAVObjEvent * ev);
 
 /**
  * Start the module, called on startup
@@ -103,6 +120,11 @@ static int32_t VibrationAnalysisStart(void)
 	if (!module_enabled)
 		return -1;
 
+	VibrationAnalysisSettingsModeOptions mode;
+	VibrationAnalysisSettingsModeGet(&mode);
+	if (mode == VIBRATIONANALYSISSETTINGS_MODE_BANDS)
+		return VibrationAnalysisStartBands();
+
 	//Get the FFT window size
 	uint16_t fft_window_size; // Make a local copy in order to check settings before allocating memory
 	uint8_t num_upscale_bits;
@@ -199,6 +221,40 @@ static int32_t VibrationAnalysisStart(void)
 	return 0;
 }
 
+/**
+ * Start the module without the FFT, only the bands are allocated
+ */
+static int32_t VibrationAnalysisStartBands(void)
+{
+	if (VibrationAnalysisBandsHandle() == NULL) {
+		module_enabled = false;
+		return -1;
+	}
+
+	vtd = (struct VibrationAnalysis_data *) PIOS_malloc(sizeof(struct VibrationAnalysis_data));
+	if (vtd == NULL) {
+		module_enabled = false;
+		return -1;
+	}
+
+	memset(vtd, 0, sizeof(struct VibrationAnalysis_data));
+	vtd->accels_static_bias_z=-GRAVITY; // [See note in definition of VibrationAnalysis_data structure]
+
+	vtd->bands = (struct vibration_bands *) PIOS_malloc(3 * sizeof(*vtd->bands));
+	if (vtd->bands == NULL) {
+		module_enabled = false;
+		return -1;
+	}
+
+	// Set up with the first sample
+	memset(vtd->bands, 0, 3 * sizeof(*vtd->bands));
+	VibrationAnalysisSettingsConnectCallback(bandsSettingsUpdated);
+
+	taskHandle = PIOS_Thread_Create(VibrationAnalysisTask, "VibrationAnalysis", BANDS_STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	TaskMonitorAdd(TASKINFO_RUNNING_VIBRATIONANALYSIS, taskHandle);
+	return 0;
+}
+
 
 /**
  * Initialise the module, called on startup
@@ -225,6 +281,12 @@ static int32_t VibrationAnalysisInitialize(void)
 	// Initialize UAVOs
 	VibrationAnalysisSettingsInitialize();
 	VibrationAnalysisOutputInitialize();
+
+	// Created here so other modules can connect to it when they start
+	uint8_t mode;
+	VibrationAnalysisSettingsModeGet(&mode);
+	if (mode == VIBRATIONANALYSISSETTINGS_MODE_BANDS)
+		VibrationAnalysisBandsInitialize();
 		
 	// Create object queue
 	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(UAVObjEvent));
@@ -257,7 +319,8 @@ static void VibrationAnalysisTask(void *parameters)
 	status = ARM_MATH_SUCCESS;
 	bool ifftFlag = false;
 	bool doBitReverse = 1;
-	status = arm_cfft_radix4_init_q15(&cfft_instance, vtd->fft_window_size, ifftFlag, doBitReverse);
+	if (vtd->bands == NULL)
+		status = arm_cfft_radix4_init_q15(&cfft_instance, vtd->fft_window_size, ifftFlag, doBitReverse);
 	
 	
 /** These values are useful for insight into the Fourier transform performed by this module.
@@ -332,6 +395,18 @@ static void VibrationAnalysisTask(void *parameters)
 		vtd->accels_static_bias_y = alpha*accels_avg_y + (1-alpha)*vtd->accels_static_bias_y;
 		vtd->accels_static_bias_z = alpha*accels_avg_z + (1-alpha)*vtd->accels_static_bias_z;
 		
+		if (vtd->bands != NULL) {
+			updateBands(accels_avg_x - vtd->accels_static_bias_x,
+					accels_avg_y - vtd->accels_static_bias_y,
+					accels_avg_z - vtd->accels_static_bias_z, sampleRate_ms);
+
+			vtd->accels_data_sum_x = 0;
+			vtd->accels_data_sum_y = 0;
+			vtd->accels_data_sum_z = 0;
+			vtd->accels_sum_count = 0;
+			continue;
+		}
+
 		// Add averaged values to the buffer, and remove DC bias. Only add real component, the
 		// complex component was already set to zero by a memset operation
 		vtd->accel_buffer_complex_x_q15[sample_count*2] = (accels_avg_x - vtd->accels_static_bias_x)*FLOAT_TO_Q15 + 0.5f; // Extra +0.5 rounds value when casting to int
@@ -422,6 +497,65 @@ static void VibrationAnalysisTask(void *parameters)
 	}
 }
 
+/**
+ * Set the bands up again with the next sample
+ */
+static void bandsSettingsUpdated(UAVObjEvent * ev)
+{
+	vtd->bands_sample_rate_ms = 0;
+}
+
+/**
+ * Add a sample to the bands of each axis, and publish them when the peaks
+ * were updated
+ */
+static void updateBands(float x, float y, float z, uint16_t sampleRate_ms)
+{
+	struct vibration_bands *bands = vtd->bands;
+
+	// The coefficients depend on the sample rate as well as the settings
+	if (sampleRate_ms != vtd->bands_sample_rate_ms) {
+		float frequencies[VIBRATIONANALYSISSETTINGS_BANDFREQUENCY_NUMELEM];
+		float bandwidth;
+		VibrationAnalysisSettingsBandFrequencyGet(frequencies);
+		VibrationAnalysisSettingsBandWidthGet(&bandwidth);
+
+		float sample_rate = 1000.0f / sampleRate_ms;
+		uint16_t decimation = BANDS_UPDATE_MS / sampleRate_ms;
+		decimation = decimation > 0 ? decimation : 1;
+
+		for (int i = 0; i < 3; i++)
+			vibration_bands_init(&bands[i], frequencies, VIBRATIONANALYSISSETTINGS_BANDFREQUENCY_NUMELEM,
+					sample_rate, bandwidth, decimation);
+
+		vtd->bands_sample_rate_ms = sampleRate_ms;
+	}
+
+	bool updated = vibration_bands_update(&bands[0], x);
+	vibration_bands_update(&bands[1], y);
+	vibration_bands_update(&bands[2], z);
+
+	// All axes are decimated alike
+	if (!updated)
+		return;
+
+	VibrationAnalysisBandsData data;
+	for (int i = 0; i < VIBRATIONANALYSISBANDS_X_NUMELEM; i++) {
+		data.x[i] = vibration_bands_amplitude(&bands[0], i);
+		data.y[i] = vibration_bands_amplitude(&bands[1], i);
+		data.z[i] = vibration_bands_amplitude(&bands[2], i);
+	}
+
+	data.PeakFrequency[VIBRATIONANALYSISBANDS_PEAKFREQUENCY_X] = bands[0].peak_frequency;
+	data.PeakFrequency[VIBRATIONANALYSISBANDS_PEAKFREQUENCY_Y] = bands[1].peak_frequency;
+	data.PeakFrequency[VIBRATIONANALYSISBANDS_PEAKFREQUENCY_Z] = bands[2].peak_frequency;
+	data.PeakAmplitude[VIBRATIONANALYSISBANDS_PEAKAMPLITUDE_X] = bands[0].peak_amplitude;
+	data.PeakAmplitude[VIBRATIONANALYSISBANDS_PEAKAMPLITUDE_Y] = bands[1].peak_amplitude;
+	data.PeakAmplitude[VIBRATIONANALYSISBANDS_PEAKAMPLITUDE_Z] = bands[2].peak_amplitude;
+
+	VibrationAnalysisBandsSet(&data);
+}
+
 /**
  * @}
  * @}
@@ -30,10 +30,12 @@
 #include "coordinate_conversions.h"
 #include "physical_constants.h"
 #include "misc_math.h"
+#include "attitude_cache.h"
 #include "paths.h"
 #include "pid.h"
 
 #include "vtol_follower_priv.h"
+#include "vtol_follower_lookahead.h"
 
 #include "acceldesired.h"
 #include "altitudeholdsettings.h"
@@ -41,6 +43,7 @@
 #include "attitudeactual.h"
 #include "loitercommand.h"
 #include "pathdesired.h"        // object that will be updated by the module
+#include "pathlookahead.h"
 #include "positionactual.h"
 #include "manualcontrolcommand.h"
 #include "flightstatus.h"
@@ -63,8 +66,20 @@ static float vtol_path_m=0, vtol_path_r=0, vtol_end_m=0, vtol_end_r=0;
 // Time constants converted to IIR parameter
 static float loiter_brakealpha=0.96f, loiter_errordecayalpha=0.88f;
 
+// Geometry of the path being followed, worked out again when it changes
+static struct path_segment vtol_path_segment;
+
+// Corner blends and speeds of the path, with the waypoint they were planned for
+DONT_BUILD_IF(PATHLOOKAHEAD_NORTH_NUMELEM > VTOL_LOOKAHEAD_MAX_NEXT, LookaheadSegments);
+static struct vtol_lookahead_limits lookahead_limits;
+static struct vtol_lookahead_plan lookahead_plan;
+static int16_t lookahead_waypoint = -1;
+static bool lookahead_stale = true;
+
 static int32_t vtol_follower_control_impl(const float dT,
 	const float *hold_pos_ned, float alt_rate, bool update_status);
+static void vtol_follower_plan_lookahead(const PathDesiredData *pathDesired,
+	const VelocityActualData *velocityActual);
 
 /**
  * Compute desired velocity to follow the desired path from the current location.
@@ -94,7 +109,21 @@ int32_t vtol_follower_control_path(const float dT, const PathDesiredData *pathDe
 		    velocityActual.East * guidanceSettings.PositionFeedforward,
 		positionActual.Down };
 
-	path_progress(pathDesired, cur_pos_ned, progress);
+	bool path_changed = path_segment_update(&vtol_path_segment, pathDesired);
+	path_segment_progress(&vtol_path_segment, cur_pos_ned, progress);
+
+	// Planned when the segment starts, or when the planner told what follows
+	if (guidanceSettings.PathLookahead == VTOLPATHFOLLOWERSETTINGS_PATHLOOKAHEAD_TRUE &&
+			pathDesired->Mode == PATHDESIRED_MODE_VECTOR) {
+		if (path_changed || lookahead_stale || lookahead_waypoint != pathDesired->Waypoint)
+			vtol_follower_plan_lookahead(pathDesired, &velocityActual);
+	} else {
+		vtol_lookahead_reset(&lookahead_plan);
+	}
+
+	// Carry on into the blend of the next corner instead of stopping at the end
+	const bool fly_on = lookahead_plan.valid && lookahead_plan.exit.valid &&
+		lookahead_plan.exit.speed > 0;
 
 	// Check if we have already completed this leg
 	bool current_leg_completed = 
@@ -112,7 +141,8 @@ int32_t vtol_follower_control_path(const float dT, const PathDesiredData *pathDe
 	const float downError = altitudeSetpoint - positionActual.Down;
 
 	// If leg is completed signal this
-	if (current_leg_completed || pathStatus.fractional_progress > 1.0f) {
+	const bool leg_done = current_leg_completed || pathStatus.fractional_progress > 1.0f;
+	if (leg_done) {
 		const bool criterion_altitude =
 			(downError > -guidanceSettings.WaypointAltitudeTol) ||
 			(!guidanceSettings.ThrottleControl);
@@ -132,15 +162,41 @@ int32_t vtol_follower_control_path(const float dT, const PathDesiredData *pathDe
 		}
 
 		// Wait here for new path segment
-		return vtol_follower_control_impl(dT, pathDesired->End,
-				0, false);
+		if (!fly_on)
+			return vtol_follower_control_impl(dT, pathDesired->End,
+					0, false);
 	}
 	
 	// Interpolate desired velocity and altitude along the path
 	float groundspeed = interpolate_value(progress->fractional_progress,
 	    pathDesired->StartingVelocity, pathDesired->EndingVelocity);
 
-	float error_speed = cubic_deadband(progress->error,
+	float path_direction[2] = { progress->path_direction[0], progress->path_direction[1] };
+	float correction_direction[2] = { progress->correction_direction[0], progress->correction_direction[1] };
+	float error = progress->error;
+
+	if (lookahead_plan.valid) {
+		const float along = progress->fractional_progress * lookahead_plan.length;
+
+		groundspeed = fminf(groundspeed, vtol_lookahead_speed(&lookahead_plan, along));
+
+		// In a blend the error is to the curve, across the direction along it
+		float point[2];
+		if (vtol_lookahead_blend(&lookahead_plan, along, point, path_direction)) {
+			float diff[2] = { point[0] - cur_pos_ned[0], point[1] - cur_pos_ned[1] };
+			float ahead = diff[0] * path_direction[0] + diff[1] * path_direction[1];
+			diff[0] -= ahead * path_direction[0];
+			diff[1] -= ahead * path_direction[1];
+
+			error = vectorn_magnitude(diff, 2);
+			if (error > 1e-6f) {
+				correction_direction[0] = diff[0] / error;
+				correction_direction[1] = diff[1] / error;
+			}
+		}
+	}
+
+	float error_speed = cubic_deadband(error,
 		guidanceSettings.PathDeadbandWidth,
 		guidanceSettings.PathDeadbandCenterGain,
 		vtol_path_m, vtol_path_r) *
@@ -148,11 +204,11 @@ int32_t vtol_follower_control_path(const float dT, const PathDesiredData *pathDe
 
 	/* Sum the desired path movement vector with the correction vector */
 	float commands_ned[3];
-	commands_ned[0] = progress->path_direction[0] * groundspeed +
-	    progress->correction_direction[0] * error_speed;
+	commands_ned[0] = path_direction[0] * groundspeed +
+	    correction_direction[0] * error_speed;
 	
-	commands_ned[1] = progress->path_direction[1] * groundspeed +
-	    progress->correction_direction[1] * error_speed;
+	commands_ned[1] = path_direction[1] * groundspeed +
+	    correction_direction[1] * error_speed;
 
 	/* Limit the total velocity based on the configured value. */
 	vector2_clip(commands_ned, guidanceSettings.HorizontalVelMax);
@@ -167,12 +223,56 @@ int32_t vtol_follower_control_path(const float dT, const PathDesiredData *pathDe
 	velocityDesired.Down = commands_ned[2];
 	VelocityDesiredSet(&velocityDesired);
 
-	pathStatus.Status = PATHSTATUS_STATUS_INPROGRESS;
-	PathStatusSet(&pathStatus);
+	// Flying on past the end the status is already set
+	if (!leg_done) {
+		pathStatus.Status = PATHSTATUS_STATUS_INPROGRESS;
+		PathStatusSet(&pathStatus);
+	}
 
 	return 0;
 }
 
+/**
+ * Plan the speeds and corner blends of the segment in PathDesired with the
+ * segments from PathLookahead that follow it
+ */
+static void vtol_follower_plan_lookahead(const PathDesiredData *pathDesired,
+	const VelocityActualData *velocityActual)
+{
+	float next[VTOL_LOOKAHEAD_MAX_NEXT][2];
+	float next_speed[VTOL_LOOKAHEAD_MAX_NEXT];
+	uint8_t num_next = 0;
+	bool truncated = false;
+
+	// Planned again each update until the segments for this one arrive
+	lookahead_waypoint = -1;
+	lookahead_stale = false;
+
+	if (PathLookaheadHandle() != NULL) {
+		PathLookaheadData lookahead;
+		PathLookaheadGet(&lookahead);
+
+		if (lookahead.Waypoint == pathDesired->Waypoint) {
+			num_next = MIN(lookahead.Count, PATHLOOKAHEAD_NORTH_NUMELEM);
+			for (uint8_t i = 0; i < num_next; i++) {
+				next[i][0] = lookahead.North[i];
+				next[i][1] = lookahead.East[i];
+				next_speed[i] = lookahead.Velocity[i];
+			}
+			truncated = lookahead.Truncated == PATHLOOKAHEAD_TRUNCATED_TRUE;
+			lookahead_waypoint = pathDesired->Waypoint;
+		}
+	}
+
+	// Not coming from a blend it speeds up from what it is doing
+	const float current_speed = velocityActual->North * vtol_path_segment.direction[0] +
+		velocityActual->East * vtol_path_segment.direction[1];
+
+	vtol_lookahead_plan(&lookahead_plan, pathDesired->Start, pathDesired->End,
+		fmaxf(pathDesired->StartingVelocity, pathDesired->EndingVelocity), current_speed,
+		next, next_speed, num_next, truncated, &lookahead_limits);
+}
+
 /**
  * Controller to maintain/seek a position and optionally descend.
  * @param[in] dT time since last eval
@@ -460,10 +560,12 @@ int32_t vtol_follower_control_attitude(float dT, const float *att_adj)
 	float eastCommand = accelDesired.East;
 
 	// Project the north and east acceleration signals into body frame
-	float yaw;
-	AttitudeActualYawGet(&yaw);
-	float forward_accel_desired =  northCommand * cosf(yaw * DEG2RAD) + eastCommand * sinf(yaw * DEG2RAD);
-	float right_accel_desired   = -northCommand * sinf(yaw * DEG2RAD) + eastCommand * cosf(yaw * DEG2RAD);
+	struct attitude_derived attitude;
+	AttitudeCacheGet(&attitude);
+	float cyaw = attitude.heading[0];
+	float syaw = attitude.heading[1];
+	float forward_accel_desired =  northCommand * cyaw + eastCommand * syaw;
+	float right_accel_desired   = -northCommand * syaw + eastCommand * cyaw;
 
 	StabilizationDesiredData stabDesired;
 
@@ -489,6 +591,7 @@ int32_t vtol_follower_control_attitude(float dT, const float *att_adj)
 	
 	// Various ways to control the yaw that are essentially manual passthrough. However, because we do not have a fine
 	// grained mechanism of manual setting the yaw as it normally would we need to duplicate that code here
+	float yaw;
 	switch(guidanceSettings.YawMode) {
 	case VTOLPATHFOLLOWERSETTINGS_YAWMODE_RATE:
 		/* This is awkward.  This allows the transmitter to control the yaw while flying navigation */
@@ -661,9 +764,10 @@ bool vtol_follower_control_loiter(float dT, float *hold_pos, float *att_adj,
 			velocityActual.East  * commands_ne[1];
 
 		if (parallel_sign > 0) {
-			float parallel_mag = sqrtf(
-				powf(velocityActual.North * commands_ne[0], 2) +
-				powf(velocityActual.East * commands_ne[1], 2));
+			float parallel_north = velocityActual.North * commands_ne[0];
+			float parallel_east = velocityActual.East * commands_ne[1];
+			float parallel_mag = sqrtf(parallel_north * parallel_north +
+				parallel_east * parallel_east);
 
 			target_vel += deadband_mag * parallel_mag;
 		}
@@ -747,6 +851,12 @@ void vtol_follower_control_settings_updated(UAVObjEvent * ev)
 	    guidanceSettings.PathDeadbandCenterGain,
 	    &vtol_path_m, &vtol_path_r);
 
+	lookahead_limits.corner_distance = guidanceSettings.CornerDistance;
+	lookahead_limits.corner_accel = guidanceSettings.CornerAccel;
+	lookahead_limits.accel = guidanceSettings.PathAccel;
+	lookahead_limits.jerk = guidanceSettings.PathJerk;
+	lookahead_stale = true;
+
 	// calculate the loiter time constants.
 	loiter_brakealpha = expf(-(guidanceSettings.UpdatePeriod / 1000.0f) / guidanceSettings.LoiterBrakingTimeConstant);
 	loiter_errordecayalpha = expf(-(guidanceSettings.UpdatePeriod / 1000.0f) / guidanceSettings.LoiterErrorDecayConstant);
@@ -0,0 +1,339 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VtolPathFollower VTOL path follower module
+ * @{
+ *
+ * @file       vtol_follower_lookahead.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Corner blends and speeds along straight paths
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/**
+ * Flying to each waypoint of a straight path and turning there wastes the
+ * time it takes to slow down and speed up again. Knowing the next segments
+ * the corners are cut along a curve instead, as fast as the sideways
+ * acceleration allows. Going backwards from the last segment known, each
+ * corner is only as fast as the vehicle can still slow down from for the
+ * ones after it.
+ *
+ * The speed changes are smoothstep ramps over the distance flown, so the
+ * acceleration starts and ends at zero. They are as long as a jerk limited
+ * change of speed would take, and never so short that the acceleration in
+ * their middle is above the limit.
+ */
+
+#include "vtol_follower_lookahead.h"
+
+#include <math.h>
+#include <string.h>
+
+//! Shorter segments have no direction to blend
+#define MIN_SEGMENT_LENGTH 0.01f
+
+//! Waypoints closer than this are taken to be the same, m
+#define SAME_POINT 0.01f
+
+static float smooth(float x)
+{
+	if (x <= 0)
+		return 0;
+	if (x >= 1)
+		return 1;
+	return x * x * (3 - 2 * x);
+}
+
+static bool same_point(const float *a, const float *b)
+{
+	return fabsf(a[0] - b[0]) < SAME_POINT && fabsf(a[1] - b[1]) < SAME_POINT;
+}
+
+static float segment_direction(const float *from, const float *to, float *direction)
+{
+	float n = to[0] - from[0];
+	float e = to[1] - from[1];
+	float length = sqrtf(n * n + e * e);
+
+	if (length >= MIN_SEGMENT_LENGTH) {
+		direction[0] = n / length;
+		direction[1] = e / length;
+	}
+
+	return length;
+}
+
+/**
+ * Distance to go smoothly from one speed to a higher one
+ */
+static float ramp_distance(float low, float high, const struct vtol_lookahead_limits *limits)
+{
+	float dv = high - low;
+	if (dv <= 0)
+		return 0;
+
+	const float a = limits->accel;
+	const float j = limits->jerk;
+
+	// Time of a jerk limited change, that only reaches full acceleration
+	// when the change is large enough
+	float t = (dv >= a * a / j) ? dv / a + a / j : 2 * sqrtf(dv / j);
+	float scurve = (low + high) / 2 * t;
+
+	// The ramp accelerates hardest in its middle, by 1.5 * dv / d * v
+	float ramp = 1.5f * high * dv / a;
+
+	return fmaxf(scurve, ramp);
+}
+
+/**
+ * Fastest way through a corner
+ * @param[in] in,out Directions of the segments before and after it
+ * @param[in] length_in,length_out Their lengths, the blend takes up to half
+ * @param[out] distance How far the blend reaches either side
+ * @return The speed, or INFINITY if the path goes straight on
+ */
+static float corner_speed(const float *in, const float *out, float length_in, float length_out,
+		const struct vtol_lookahead_limits *limits, float *distance)
+{
+	*distance = fminf(limits->corner_distance, fminf(length_in, length_out) / 2);
+
+	float c = fmaxf(fminf(in[0] * out[0] + in[1] * out[1], 1), -1);
+	float sin_half = sqrtf((1 - c) / 2);
+	float cos_half = sqrtf((1 + c) / 2);
+
+	// Straight on, nothing to blend
+	if (sin_half < 1e-3f) {
+		*distance = 0;
+		return INFINITY;
+	}
+
+	// Turning back, there is no curve to fly
+	if (cos_half < 0.05f || *distance <= 0) {
+		*distance = 0;
+		return 0;
+	}
+
+	// The curve is tightest in its middle, with a curvature of
+	// sin(angle / 2) / (distance * cos(angle / 2)^2)
+	return sqrtf(limits->corner_accel * *distance * cos_half * cos_half / sin_half);
+}
+
+/**
+ * No plan, the segment is flown as before
+ */
+void vtol_lookahead_reset(struct vtol_lookahead_plan *plan)
+{
+	memset(plan, 0, sizeof(*plan));
+}
+
+/**
+ * Plan the segment from start to end. If it goes on from the corner the plan
+ * before ended in, it starts with the rest of that blend. Planning the same
+ * segment again, for segments after it that became known, keeps its start.
+ * @param[in,out] plan The plan of the segment before, replaced by this one
+ * @param[in] top_speed The speed of the segment
+ * @param[in] current_speed How fast the vehicle goes, when it doesn't come
+ * from a blend
+ * @param[in] next_speed,next The segments after this one, their speeds and ends
+ * @param[in] truncated More segments follow the last one, so it must be
+ * possible to stop there
+ */
+void vtol_lookahead_plan(struct vtol_lookahead_plan *plan, const float *start, const float *end,
+		float top_speed, float current_speed,
+		const float (*next)[2], const float *next_speed, uint8_t num_next, bool truncated,
+		const struct vtol_lookahead_limits *limits)
+{
+	struct vtol_lookahead_corner entry = plan->entry;
+	bool continues = plan->valid && same_point(plan->start, start) && same_point(plan->end, end);
+
+	if (!continues) {
+		entry = plan->exit;
+		continues = plan->valid && entry.valid &&
+			same_point(entry.corner, start) && same_point(entry.next_end, end);
+	}
+
+	vtol_lookahead_reset(plan);
+
+	if (limits->accel <= 0 || limits->jerk <= 0 || limits->corner_accel <= 0 || top_speed <= 0)
+		return;
+
+	float direction[VTOL_LOOKAHEAD_MAX_NEXT + 1][2];
+	float length[VTOL_LOOKAHEAD_MAX_NEXT + 1];
+
+	length[0] = segment_direction(start, end, direction[0]);
+	if (length[0] < MIN_SEGMENT_LENGTH)
+		return;
+
+	plan->valid = true;
+	plan->start[0] = start[0];
+	plan->start[1] = start[1];
+	plan->end[0] = end[0];
+	plan->end[1] = end[1];
+	plan->direction[0] = direction[0][0];
+	plan->direction[1] = direction[0][1];
+	plan->length = length[0];
+	plan->top_speed = top_speed;
+
+	if (continues) {
+		plan->entry = entry;
+	} else {
+		plan->entry.speed = fmaxf(fminf(current_speed, top_speed), 0);
+	}
+
+	if (num_next > VTOL_LOOKAHEAD_MAX_NEXT) {
+		num_next = VTOL_LOOKAHEAD_MAX_NEXT;
+		truncated = true;
+	}
+
+	// Segments too short to have a direction end what can be blended
+	uint8_t n;
+	for (n = 0; n < num_next; n++) {
+		const float *from = (n == 0) ? end : next[n - 1];
+		length[n + 1] = segment_direction(from, next[n], direction[n + 1]);
+		if (length[n + 1] < MIN_SEGMENT_LENGTH) {
+			truncated = true;
+			break;
+		}
+	}
+
+	if (n > 0) {
+		// Corner k is at the end of segment k, the fastest each can be flown
+		float speed[VTOL_LOOKAHEAD_MAX_NEXT];
+		float distance[VTOL_LOOKAHEAD_MAX_NEXT];
+		for (uint8_t k = 0; k < n; k++) {
+			speed[k] = corner_speed(direction[k], direction[k + 1], length[k], length[k + 1],
+				limits, &distance[k]);
+			speed[k] = fminf(speed[k], fminf(k == 0 ? top_speed : next_speed[k - 1], next_speed[k]));
+		}
+
+		// Slow enough for each corner to slow down for the ones after it
+		float speed_after = truncated ? 0 : next_speed[n - 1];
+		float distance_after = 0;
+		for (int8_t k = n - 1; k >= 0; k--) {
+			float room = fmaxf(length[k + 1] - distance[k] - distance_after, 0);
+			speed[k] = fminf(speed[k], sqrtf(speed_after * speed_after + 2 * limits->accel * room));
+			speed_after = speed[k];
+			distance_after = distance[k];
+		}
+
+		plan->exit.valid = true;
+		plan->exit.corner[0] = end[0];
+		plan->exit.corner[1] = end[1];
+		plan->exit.in[0] = direction[0][0];
+		plan->exit.in[1] = direction[0][1];
+		plan->exit.out[0] = direction[1][0];
+		plan->exit.out[1] = direction[1][1];
+		plan->exit.distance = distance[0];
+		plan->exit.speed = speed[0];
+		plan->exit.next_end[0] = next[0][0];
+		plan->exit.next_end[1] = next[0][1];
+
+		plan->brake_distance = ramp_distance(plan->exit.speed, top_speed, limits);
+	}
+
+	plan->accel_distance = ramp_distance(plan->entry.speed, top_speed, limits);
+}
+
+/**
+ * The speed to fly at
+ * @param[in] along Distance from the start of the segment, m
+ */
+float vtol_lookahead_speed(const struct vtol_lookahead_plan *plan, float along)
+{
+	const float top = plan->top_speed;
+	float speed = top;
+
+	// Speeding up once through the blend at the start
+	if (plan->accel_distance > 0) {
+		float after_blend = along - (plan->entry.valid ? plan->entry.distance : 0);
+		speed = fminf(speed, plan->entry.speed +
+			(top - plan->entry.speed) * smooth(after_blend / plan->accel_distance));
+	}
+
+	// Slowing down for the blend at the end
+	if (plan->exit.valid) {
+		float before_blend = plan->length - along - plan->exit.distance;
+		if (plan->brake_distance > 0)
+			speed = fminf(speed, plan->exit.speed +
+				(top - plan->exit.speed) * smooth(before_blend / plan->brake_distance));
+		else if (before_blend <= 0)
+			speed = fminf(speed, plan->exit.speed);
+	}
+
+	return fmaxf(speed, fminf(top, VTOL_LOOKAHEAD_MIN_SPEED));
+}
+
+/**
+ * Point of the blend of a corner and the direction there
+ * @param[in] past Distance along the path past the corner, negative before it
+ */
+static void corner_point(const struct vtol_lookahead_corner *corner, float past,
+		float *point, float *tangent)
+{
+	const float d = corner->distance;
+	const float t = fmaxf(fminf(0.5f + 0.5f * past / d, 1), 0);
+
+	for (uint8_t i = 0; i < 2; i++) {
+		float before = corner->corner[i] - d * corner->in[i];
+		float after = corner->corner[i] + d * corner->out[i];
+
+		point[i] = (1 - t) * (1 - t) * before + 2 * t * (1 - t) * corner->corner[i] + t * t * after;
+		tangent[i] = (1 - t) * corner->in[i] + t * corner->out[i];
+	}
+
+	float norm = sqrtf(tangent[0] * tangent[0] + tangent[1] * tangent[1]);
+	if (norm > 1e-6f) {
+		tangent[0] /= norm;
+		tangent[1] /= norm;
+	} else {
+		tangent[0] = corner->out[0];
+		tangent[1] = corner->out[1];
+	}
+}
+
+/**
+ * Where to be on a blend, instead of on the straight segment
+ * @param[in] along Distance from the start of the segment, m
+ * @param[out] point The point of the blend to track
+ * @param[out] tangent The direction to fly there
+ * @return false outside of the blends
+ */
+bool vtol_lookahead_blend(const struct vtol_lookahead_plan *plan, float along,
+		float *point, float *tangent)
+{
+	// Past the end the blend goes on into the next segment
+	const struct vtol_lookahead_corner *exit = &plan->exit;
+	if (exit->valid && exit->distance > 0 && along - plan->length > -exit->distance) {
+		corner_point(exit, along - plan->length, point, tangent);
+		return true;
+	}
+
+	const struct vtol_lookahead_corner *entry = &plan->entry;
+	if (entry->valid && entry->distance > 0 && along < entry->distance) {
+		corner_point(entry, along, point, tangent);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,95 @@
+/**
+ ******************************************************************************
+ * @addtogroup TauLabsModules Tau Labs Modules
+ * @{
+ * @addtogroup VtolPathFollower VTOL path follower module
+ * @{
+ *
+ * @file       vtol_follower_lookahead.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Corner blends and speeds along straight paths
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef VTOL_FOLLOWER_LOOKAHEAD_H
+#define VTOL_FOLLOWER_LOOKAHEAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//! Segments after the current one that are planned for
+#define VTOL_LOOKAHEAD_MAX_NEXT 3
+
+//! Slowest the path is ever flown, so the end of a segment is always reached
+#define VTOL_LOOKAHEAD_MIN_SPEED 0.5f
+
+struct vtol_lookahead_limits {
+	float corner_distance;  //!< Longest blend either side of a corner, m
+	float corner_accel;     //!< Sideways acceleration in a blend, m/s^2
+	float accel;            //!< Along the path, m/s^2
+	float jerk;             //!< Along the path, m/s^3
+};
+
+/**
+ * The way to fly the corner at one end of a segment: along a quadratic
+ * Bezier curve from distance before the corner to distance after it, at
+ * the same speed all the way
+ */
+struct vtol_lookahead_corner {
+	bool valid;
+	float corner[2];
+	float in[2];            //!< Direction of the segment ending at the corner
+	float out[2];           //!< Direction of the segment starting there
+	float distance;         //!< m
+	float speed;            //!< m/s
+	float next_end[2];      //!< Where the segment after the corner ends
+};
+
+/**
+ * Speeds and blends of the segment being followed, planned once when it
+ * starts so each update only has to look them up
+ */
+struct vtol_lookahead_plan {
+	bool valid;
+	float start[2];
+	float end[2];
+	float direction[2];
+	float length;
+	float top_speed;
+
+	struct vtol_lookahead_corner entry;
+	struct vtol_lookahead_corner exit;
+
+	float accel_distance;   //!< From the entry blend to top speed, m
+	float brake_distance;   //!< From top speed to the exit blend, m
+};
+
+void vtol_lookahead_plan(struct vtol_lookahead_plan *plan, const float *start, const float *end,
+		float top_speed, float current_speed,
+		const float (*next)[2], const float *next_speed, uint8_t num_next, bool truncated,
+		const struct vtol_lookahead_limits *limits);
+void vtol_lookahead_reset(struct vtol_lookahead_plan *plan);
+float vtol_lookahead_speed(const struct vtol_lookahead_plan *plan, float along);
+bool vtol_lookahead_blend(const struct vtol_lookahead_plan *plan, float along,
+		float *point, float *tangent);
+
+#endif /* VTOL_FOLLOWER_LOOKAHEAD_H */
+
+/**
+ * @}
+ * @}
+ */
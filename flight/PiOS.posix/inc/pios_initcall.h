@@ -41,6 +41,13 @@
 
 
 typedef int32_t (*initcall_t)(void);
+
+enum module_init_class {
+	MODULE_INIT_NORMAL,
+	MODULE_INIT_CRITICAL,
+	MODULE_INIT_DEFERRED,
+};
+
 typedef struct {
 	initcall_t fn_minit;
 	initcall_t fn_tinit;
@@ -53,6 +60,8 @@ extern void InitModules();
 extern void StartModules();
 
 #define MODULE_INITCALL(ifn, sfn)
+#define MODULE_CRITICAL_INITCALL(ifn, sfn)
+#define MODULE_DEFERRED_INITCALL(ifn, sfn)
 
 #define MODULE_TASKCREATE_ALL { \
 	/* Start all module threads */ \
@@ -65,6 +74,14 @@ extern void StartModules();
 	/* Initialize the system thread */ \
 	SystemModInitialize();}
 
+/* The module lists don't have classes, all of them count as normal modules */
+#define MODULE_TASKCREATE_CLASS(cls) { \
+	if ((cls) == MODULE_INIT_NORMAL) \
+		StartModules(); \
+	}
+
+#define MODULE_DEFERRED_ALL(wdgfn)
+
 #endif	/* PIOS_INITCALL_H */
 
 /**
@@ -43,6 +43,12 @@ extern int32_t PIOS_SYS_SerialNumberGetBinary(uint8_t array[PIOS_SYS_SERIAL_NUM_
 extern int32_t PIOS_SYS_SerialNumberGet(char str[PIOS_SYS_SERIAL_NUM_ASCII_LEN+1]);
 
 extern void PIOS_SYS_Args(int argc, char *argv[]);
+extern bool PIOS_SYS_Lockstep(void);
+extern uint16_t PIOS_SYS_PortOffset(void);
+extern bool PIOS_SYS_UdpTelemetry(bool *sequence_numbers);
+extern const char *PIOS_SYS_ReplayLog(void);
+extern const char *PIOS_SYS_ReplayOutput(void);
+extern void PIOS_SYS_Idle(void);
 
 #endif /* PIOS_SYS_H */
 
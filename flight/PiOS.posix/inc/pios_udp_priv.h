@@ -38,35 +38,56 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <errno.h>
 #include "pios_thread.h"
+#include "pios_semaphore.h"
+
+/*
+ * Whatever is queued for sending when the tx thread runs goes out in one
+ * datagram, up to this size. Keep it below the path MTU so datagrams are
+ * not fragmented, over loopback it could be a lot larger.
+ */
+#if !defined(PIOS_UDP_MAX_DATAGRAM)
+#define PIOS_UDP_MAX_DATAGRAM 1400
+#endif
+
+/* Size of the sequence number in front of each datagram, if enabled */
+#define PIOS_UDP_SEQ_LEN 2
 
 struct pios_udp_cfg {
   const char * ip;
   uint16_t port;
+  /* Prefix each datagram with a 16 bit sequence number to count losses */
+  bool sequence_numbers;
 };
 
 typedef struct {
   const struct pios_udp_cfg * cfg;
   struct pios_thread *rxThread;
+  struct pios_thread *txThread;
+  struct pios_semaphore *txSem;
 
   int socket;
   struct sockaddr_in server;
   struct sockaddr_in client;
   uint32_t clientLength;
 
-  pthread_cond_t cond;
-  pthread_mutex_t mutex;
-
   pios_com_callback tx_out_cb;
   uintptr_t tx_out_context;
   pios_com_callback rx_in_cb;
   uintptr_t rx_in_context;
 
-  uint8_t rx_buffer[PIOS_UDP_RX_BUFFER_SIZE];
-  uint8_t tx_buffer[PIOS_UDP_RX_BUFFER_SIZE];
+  uint16_t tx_seq;
+  uint16_t rx_seq;
+  bool rx_synced;
+  uint32_t rx_lost;
+
+  uint8_t rx_buffer[PIOS_UDP_MAX_DATAGRAM];
+  uint8_t tx_buffer[PIOS_UDP_MAX_DATAGRAM];
 } pios_udp_dev;
 
 extern int32_t PIOS_UDP_Init(uintptr_t * udp_id, const struct pios_udp_cfg * cfg);
+extern uint32_t PIOS_UDP_GetLostDatagrams(uintptr_t udp_id);
 
 
 
@@ -79,6 +79,7 @@
 #include <pios_rcvr.h>
 #include <pios_reset.h>
 #include <pios_irq.h>
+#include <pios_trace.h>
 #include <pios_sensors.h>
 #include <pios_sim.h>
 #include <pios_flashfs.h>
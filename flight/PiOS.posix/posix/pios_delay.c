@@ -30,6 +30,7 @@
 
 /* Project Includes */
 #include "pios.h"
+#include "pios_thread.h"
 #include "time.h"
 
 #if defined(PIOS_INCLUDE_DELAY)
@@ -62,6 +63,10 @@ int32_t PIOS_DELAY_Init(void)
 */
 int32_t PIOS_DELAY_WaituS(uint32_t uS)
 {
+	// Simulated time doesn't pass while a task waits without blocking
+	if (PIOS_SYS_Lockstep())
+		return 0;
+
 	struct timespec wait,rest;
 	wait.tv_sec=0;
 	wait.tv_nsec=1000*uS;
@@ -86,6 +91,9 @@ int32_t PIOS_DELAY_WaituS(uint32_t uS)
 */
 int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 {
+	if (PIOS_SYS_Lockstep())
+		return 0;
+
 	struct timespec wait,rest;
 	wait.tv_sec=mS/1000;
 	wait.tv_nsec=(mS%1000)*1000000;
@@ -99,14 +107,37 @@ int32_t PIOS_DELAY_WaitmS(uint32_t mS)
 
 uint32_t PIOS_DELAY_GetRaw()
 {
+	// In lockstep the raw time is the simulated time in us, which only
+	// moves on with the system tick
+	if (PIOS_SYS_Lockstep())
+		return PIOS_Thread_Systime() * 1000;
+
 	uint32_t raw_us = clock();
 	return raw_us;
 }
 
+/**
+ * @brief Query the Delay timer for the current uS
+ * @return A microsecond value, the raw time already counts in us here
+ */
+uint32_t PIOS_DELAY_GetuS()
+{
+	return PIOS_DELAY_GetRaw();
+}
+
 uint32_t PIOS_DELAY_DiffuS(uint32_t ref)
 {
+	if (PIOS_SYS_Lockstep())
+		return PIOS_DELAY_GetRaw() - ref;
+
 	uint32_t diff_clock = clock() - ref;
 	uint32_t diff_us = diff_clock; // (CLOCKS_PER_SEC / 1000);
 	return diff_us;
 }
+
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+	// Raw times are in us on both clocks
+	return later - raw;
+}
 #endif
@@ -57,6 +57,8 @@ struct pios_gcsrcvr_dev {
 
 	uint8_t supv_timer;
 	bool Fresh;
+	uint8_t last_sequence;
+	uint32_t last_frame_time;
 };
 
 static struct pios_gcsrcvr_dev *global_gcsrcvr_dev;
@@ -71,6 +73,8 @@ static struct pios_gcsrcvr_dev *PIOS_gcsrcvr_alloc(void)
 
 	gcsrcvr_dev->magic = PIOS_GCSRCVR_DEV_MAGIC;
 	gcsrcvr_dev->Fresh = false;
+	gcsrcvr_dev->last_sequence = 0;
+	gcsrcvr_dev->last_frame_time = 0;
 	gcsrcvr_dev->supv_timer = 0;
 
 	/* The update callback cannot receive the device pointer, so set it in a global */
@@ -92,6 +96,8 @@ static struct pios_gcsrcvr_dev *PIOS_gcsrcvr_alloc(void)
 	gcsrcvr_dev = &pios_gcsrcvr_devs[pios_gcsrcvr_num_devs++];
 	gcsrcvr_dev->magic = PIOS_GCSRCVR_DEV_MAGIC;
 	gcsrcvr_dev->Fresh = false;
+	gcsrcvr_dev->last_sequence = 0;
+	gcsrcvr_dev->last_frame_time = 0;
 	gcsrcvr_dev->supv_timer = 0;
 
 	global_gcsrcvr_dev = gcsrcvr_dev;
@@ -104,7 +110,21 @@ static void gcsreceiver_updated(UAVObjEvent * ev)
 {
 	struct pios_gcsrcvr_dev *gcsrcvr_dev = global_gcsrcvr_dev;
 	if (ev->obj == GCSReceiverHandle()) {
-		GCSReceiverGet(&gcsreceiverdata);
+		GCSReceiverData frame;
+		GCSReceiverGet(&frame);
+
+		/* Drop duplicated and late frames of a counting sender, until it
+		 * has been quiet long enough to have restarted */
+		if (frame.Sequence != 0) {
+			bool synced = gcsrcvr_dev->last_frame_time != 0 &&
+				PIOS_DELAY_DiffuS(gcsrcvr_dev->last_frame_time) < PIOS_GCSRCVR_TIMEOUT_MS * 1000;
+			if (synced && (int8_t)(frame.Sequence - gcsrcvr_dev->last_sequence) <= 0)
+				return;
+			gcsrcvr_dev->last_sequence = frame.Sequence;
+			gcsrcvr_dev->last_frame_time = PIOS_DELAY_GetRaw();
+		}
+
+		gcsreceiverdata = frame;
 		gcsrcvr_dev->Fresh = true;
 	}
 }
@@ -47,6 +47,10 @@ bool PIOS_heap_malloc_failed_p(void)
 	return malloc_failed_flag;
 }
 
+static uint32_t heap_allocations;
+static uint32_t heap_failed_allocations;
+static uint32_t heap_largest_failed;
+
 void * PIOS_malloc(size_t size)
 {
 #if defined(PIOS_INCLUDE_FREERTOS)
@@ -57,8 +61,14 @@ void * PIOS_malloc(size_t size)
 #error "pios_heap requires either PIOS_INCLUDE_FREERTOS or PIOS_INCLUDE_CHIBIOS"
 #endif
 
-	if (buf == NULL)
+	if (buf == NULL) {
+		heap_failed_allocations++;
+		if (size > heap_largest_failed)
+			heap_largest_failed = size;
 		malloc_failed_hook();
+	} else {
+		heap_allocations++;
+	}
 
 	return buf;
 }
@@ -93,6 +103,31 @@ size_t PIOS_fastheap_get_free_size(void)
 	return 0;
 }
 
+/* The host heap has no fixed size, only the allocations are counted */
+bool PIOS_heap_get_stats(enum pios_heap_region region, struct pios_heap_stats *stats)
+{
+	if (region != PIOS_HEAP_REGION_STANDARD)
+		return false;
+
+	stats->size = 0;
+	stats->used = 0;
+	stats->allocations = heap_allocations;
+	stats->pad_bytes = 0;
+	stats->failed_allocations = heap_failed_allocations;
+	stats->largest_failed = heap_largest_failed;
+
+	return true;
+}
+
+void PIOS_heap_set_owner(uint8_t owner)
+{
+}
+
+size_t PIOS_heap_get_owner_usage(uint8_t owner)
+{
+	return 0;
+}
+
 /**
  * @}
  * @}
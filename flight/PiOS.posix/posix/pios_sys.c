@@ -35,15 +35,30 @@
 #endif /* !defined(_GNU_SOURCE) */
 
 #include "pios.h"
+#include "pios_thread.h"
 
 #if defined(PIOS_INCLUDE_SYS)
 
 static bool debug_fpe=false;
+static bool lockstep=false;
+static uint32_t run_time_ms=0;
+static uint16_t port_offset=0;
+static bool udp_telemetry=false;
+static bool udp_sequence_numbers=false;
+static const char *replay_log=NULL;
+static const char *replay_output="replay.tll";
 
 static void Usage(char *cmdName) {
-	printf( "usage: %s [-f]\n"
+	printf( "usage: %s [-f] [-l] [-t seconds] [-p offset] [-u|-U] [-r log] [-o output]\n"
 		"\n"
-		"\t-f\tEnables floating point exception trapping mode\n",
+		"\t-f\tEnables floating point exception trapping mode\n"
+		"\t-l\tRuns in lockstep, time only advances once all the tasks are idle\n"
+		"\t-t\tExits after running for this many (simulated) seconds\n"
+		"\t-p\tAdds this offset to the TCP and UDP ports, to run several side by side\n"
+		"\t-u\tServes telemetry over UDP instead of TCP, several frames per datagram\n"
+		"\t-U\tLike -u, with sequence numbers to count lost datagrams\n"
+		"\t-r\tReplays the sensors of this GCS log instead of simulating them\n"
+		"\t-o\tWhere a replay writes the estimated states (replay.tll)\n",
 		cmdName);
 
 	exit(1);
@@ -52,11 +67,34 @@ static void Usage(char *cmdName) {
 void PIOS_SYS_Args(int argc, char *argv[]) {
 	int opt;
 
-	while ((opt = getopt(argc, argv, "f")) != -1) {
+	while ((opt = getopt(argc, argv, "flt:p:uUr:o:")) != -1) {
 		switch (opt) {
 			case 'f':
 				debug_fpe=true;
 				break;
+			case 'l':
+				lockstep=true;
+				break;
+			case 't':
+				run_time_ms=atoi(optarg) * 1000;
+				if (run_time_ms == 0)
+					Usage(argv[0]);
+				break;
+			case 'p':
+				port_offset=atoi(optarg);
+				break;
+			case 'U':
+				udp_sequence_numbers=true;
+				/* fall through */
+			case 'u':
+				udp_telemetry=true;
+				break;
+			case 'r':
+				replay_log=optarg;
+				break;
+			case 'o':
+				replay_output=optarg;
+				break;
 			default:
 				Usage(argv[0]);
 				break;
@@ -75,6 +113,7 @@ void PIOS_SYS_Args(int argc, char *argv[]) {
 #include <stdlib.h>		/* printf */
 #include <signal.h>		/* sigaction */
 #include <fenv.h>		/* PE_* */
+#include <sys/time.h>		/* setitimer */
 static void sigint_handler(int signum, siginfo_t *siginfo, void *ucontext)
 {
 	printf("\nSIGINT received.  Shutting down\n");
@@ -117,6 +156,81 @@ void PIOS_SYS_Init(void)
 		exit(1);
 #endif
 	}
+
+	if (lockstep) {
+		// Stop the wall clock tick started by halInit(), the idle
+		// thread drives the system tick instead
+		struct itimerval stopped = { { 0, 0 }, { 0, 0 } };
+		rc = setitimer(ITIMER_REAL, &stopped, NULL);
+		assert(rc == 0);
+	}
+}
+
+/**
+* Whether the simulation runs in lockstep, with simulated time
+*/
+bool PIOS_SYS_Lockstep(void)
+{
+	return lockstep;
+}
+
+/**
+* The log to take the sensors from, or NULL to simulate them
+*/
+const char *PIOS_SYS_ReplayLog(void)
+{
+	return replay_log;
+}
+
+/**
+* Where a replay writes what was estimated from the logged sensors
+*/
+const char *PIOS_SYS_ReplayOutput(void)
+{
+	return replay_output;
+}
+
+/**
+* Whether telemetry is served over UDP rather than TCP
+* \param[out] sequence_numbers Whether datagrams carry sequence numbers
+*/
+bool PIOS_SYS_UdpTelemetry(bool *sequence_numbers)
+{
+	if (sequence_numbers)
+		*sequence_numbers = udp_sequence_numbers;
+
+	return udp_telemetry;
+}
+
+/**
+* Offset added to the ports of all the TCP and UDP devices
+*/
+uint16_t PIOS_SYS_PortOffset(void)
+{
+	return port_offset;
+}
+
+#if defined(PIOS_INCLUDE_CHIBIOS)
+extern void port_tick_signal_handler(int signo, siginfo_t *info, void *context);
+#endif
+
+/**
+* Called by the idle thread whenever all the tasks are blocked. In lockstep
+* this is the only place a system tick comes from, so every task gets to run
+* until it waits again before time moves on, and the simulation runs as fast
+* as the host can go. A task that never blocks stops the clock.
+*/
+void PIOS_SYS_Idle(void)
+{
+	if (run_time_ms != 0 && PIOS_Thread_Systime() >= run_time_ms) {
+		printf("\nRan for %u s.  Shutting down\n", run_time_ms / 1000);
+		exit(0);
+	}
+
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	if (lockstep)
+		port_tick_signal_handler(PORT_TIMER_SIGNAL, NULL, NULL);
+#endif
 }
 
 /**
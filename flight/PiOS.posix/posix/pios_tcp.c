@@ -208,7 +208,7 @@ int32_t PIOS_TCP_Init(uintptr_t *tcp_id, const struct pios_tcp_cfg * cfg)
 
 	tcp_dev->server.sin_family = AF_INET;
 	tcp_dev->server.sin_addr.s_addr = INADDR_ANY; //inet_addr(tcp_dev->cfg->ip);
-	tcp_dev->server.sin_port = htons(tcp_dev->cfg->port);
+	tcp_dev->server.sin_port = htons(tcp_dev->cfg->port + PIOS_SYS_PortOffset());
 
 	/* set socket options */
     int value = 1;
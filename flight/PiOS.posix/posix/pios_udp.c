@@ -4,7 +4,7 @@
  * @file       pios_udp.c   
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2010.
  * 	        Parts by Thorsten Klose (tk@midibox.org) (tk@midibox.org)
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014-2016
  * @brief      UDP commands. Inits UDPs, controls UDPs & Interupt handlers.
  * @see        The GNU Public License (GPL) Version 3
  * @defgroup   PIOS_UDP UDP Functions
@@ -33,13 +33,12 @@
 
 #if defined(PIOS_INCLUDE_UDP)
 
-#include <signal.h>
 #include <pios_udp_priv.h>
 #include "pios_thread.h"
 
 /* We need a list of UDP devices */
 
-#define PIOS_UDP_MAX_DEV 256
+#define PIOS_UDP_MAX_DEV 16
 static int8_t pios_udp_num_devices = 0;
 
 static pios_udp_dev pios_udp_devices[PIOS_UDP_MAX_DEV];
@@ -47,11 +46,11 @@ static pios_udp_dev pios_udp_devices[PIOS_UDP_MAX_DEV];
 
 
 /* Provide a COM driver */
-static void PIOS_UDP_ChangeBaud(uint32_t udp_id, uint32_t baud);
-static void PIOS_UDP_RegisterRxCallback(uint32_t udp_id, pios_com_callback rx_in_cb, uint32_t context);
-static void PIOS_UDP_RegisterTxCallback(uint32_t udp_id, pios_com_callback tx_out_cb, uint32_t context);
-static void PIOS_UDP_TxStart(uint32_t udp_id, uint16_t tx_bytes_avail);
-static void PIOS_UDP_RxStart(uint32_t udp_id, uint16_t rx_bytes_avail);
+static void PIOS_UDP_ChangeBaud(uintptr_t udp_id, uint32_t baud);
+static void PIOS_UDP_RegisterRxCallback(uintptr_t udp_id, pios_com_callback rx_in_cb, uintptr_t context);
+static void PIOS_UDP_RegisterTxCallback(uintptr_t udp_id, pios_com_callback tx_out_cb, uintptr_t context);
+static void PIOS_UDP_TxStart(uintptr_t udp_id, uint16_t tx_bytes_avail);
+static void PIOS_UDP_RxStart(uintptr_t udp_id, uint16_t rx_bytes_avail);
 
 const struct pios_com_driver pios_udp_com_driver = {
 	.set_baud   = PIOS_UDP_ChangeBaud,
@@ -62,67 +61,133 @@ const struct pios_com_driver pios_udp_com_driver = {
 };
 
 
-static pios_udp_dev * find_udp_dev_by_id (uint8_t udp)
+static pios_udp_dev * find_udp_dev_by_id(uintptr_t udp)
 {
-  if (udp >= pios_udp_num_devices) {
-    /* Undefined UDP port for this board (see pios_board.c) */
-	PIOS_Assert(0);
-    return NULL;
-  }
-
-  /* Get a handle for the device configuration */
-  return &(pios_udp_devices[udp]);
+	if (udp >= pios_udp_num_devices) {
+		/* Undefined UDP port for this board (see pios_board.c) */
+		PIOS_Assert(0);
+		return NULL;
+	}
+
+	/* Get a handle for the device configuration */
+	return &(pios_udp_devices[udp]);
 }
 
 /**
- * RxThread
+ * RxTask
  */
-void PIOS_UDP_RxThread(void * udp_dev_n)
+static void PIOS_UDP_RxTask(void *udp_dev_n)
 {
+	pios_udp_dev *udp_dev = (pios_udp_dev*)udp_dev_n;
+
+	/**
+	 * com devices never get closed except by application "reboot"
+	 */
+	while (1) {
+		/* Polling the fd has to be executed in thread suspended mode
+		 * to get a correct errno value. */
+		PIOS_Thread_Scheduler_Suspend();
+
+		socklen_t clientLength = sizeof(udp_dev->client);
+		int received = recvfrom(udp_dev->socket,
+				udp_dev->rx_buffer, sizeof(udp_dev->rx_buffer), 0,
+				(struct sockaddr *) &udp_dev->client, &clientLength);
+		int error = errno;
+
+		PIOS_Thread_Scheduler_Resume();
+
+		if (received < 0) {
+			if (error == EAGAIN || error == EWOULDBLOCK)
+				PIOS_Thread_Sleep(1);
+			continue;
+		}
+
+		/* Replies go to whoever sent to us last */
+		udp_dev->clientLength = clientLength;
+
+		uint8_t *data = udp_dev->rx_buffer;
 
-	/* needed because of FreeRTOS.posix scheduling */
-	sigset_t set;
-	sigfillset(&set);
-	sigprocmask(SIG_BLOCK, &set, NULL);
-
-	pios_udp_dev * udp_dev = (pios_udp_dev*) udp_dev_n;
-
-   /**
-	* com devices never get closed except by application "reboot"
-	* we also never give up our mutex except for waiting
-	*/
-   while(1) {
-
-		/**
-		 * receive 
-		 */
-		int received;
-		udp_dev->clientLength=sizeof(udp_dev->client);
-		if ((received = recvfrom(udp_dev->socket,
-				&udp_dev->rx_buffer,
-				PIOS_UDP_RX_BUFFER_SIZE,
-				0,
-				(struct sockaddr *) &udp_dev->client,
-				(socklen_t*)&udp_dev->clientLength)) >= 0)
-		{
-
-			/* copy received data to buffer if possible */
-			/* we do NOT buffer data locally. If the com buffer can't receive, data is discarded! */
-			/* (thats what the USART driver does too!) */
+		if (udp_dev->cfg->sequence_numbers) {
+			if (received < PIOS_UDP_SEQ_LEN)
+				continue;
+
+			uint16_t seq = data[0] | (data[1] << 8);
+			uint16_t skipped = seq - udp_dev->rx_seq;
+
+			/* Count the gap, going backwards means the sender restarted
+			 * or datagrams were reordered, so just follow it then */
+			if (udp_dev->rx_synced && skipped < 0x8000)
+				udp_dev->rx_lost += skipped;
+			udp_dev->rx_seq = seq + 1;
+			udp_dev->rx_synced = true;
+
+			data += PIOS_UDP_SEQ_LEN;
+			received -= PIOS_UDP_SEQ_LEN;
+		}
+
+		/* we do NOT buffer data locally. If the com buffer can't receive, data is discarded! */
+		/* (thats what the USART driver does too!) */
+		if (received > 0 && udp_dev->rx_in_cb) {
 			bool rx_need_yield = false;
-			if (udp_dev->rx_in_cb) {
-			  (void) (udp_dev->rx_in_cb)(udp_dev->rx_in_context, udp_dev->rx_buffer, received, NULL, &rx_need_yield);
-			}
+			(void) (udp_dev->rx_in_cb)(udp_dev->rx_in_context, data, received, NULL, &rx_need_yield);
+		}
+	}
+}
+
+/**
+ * TxTask
+ *
+ * Runs below the telemetry tasks, so by the time it gets to send all the
+ * frames they queued meanwhile are waiting and go out together in as few
+ * datagrams as possible instead of one send per frame.
+ */
+static void PIOS_UDP_TxTask(void *udp_dev_n)
+{
+	pios_udp_dev *udp_dev = (pios_udp_dev*)udp_dev_n;
 
-#if defined(PIOS_INCLUDE_FREERTOS)
-			if (rx_need_yield) {
-				taskYIELD();
+	uint16_t header_len = udp_dev->cfg->sequence_numbers ? PIOS_UDP_SEQ_LEN : 0;
+
+	while (1) {
+		PIOS_Semaphore_Take(udp_dev->txSem, PIOS_SEMAPHORE_TIMEOUT_MAX);
+
+		if (!udp_dev->tx_out_cb)
+			continue;
+
+		uint16_t length;
+		do {
+			uint16_t size = header_len;
+			bool tx_need_yield = false;
+
+			/* Fill the datagram from the com buffer, which may wrap */
+			while (size < sizeof(udp_dev->tx_buffer)) {
+				length = (udp_dev->tx_out_cb)(udp_dev->tx_out_context,
+						udp_dev->tx_buffer + size,
+						sizeof(udp_dev->tx_buffer) - size,
+						NULL, &tx_need_yield);
+				if (length == 0)
+					break;
+				size += length;
 			}
-#endif	/* PIOS_INCLUDE_FREERTOS */
 
-		}
+			if (size == header_len)
+				break;
 
+			if (header_len) {
+				udp_dev->tx_buffer[0] = udp_dev->tx_seq & 0xff;
+				udp_dev->tx_buffer[1] = udp_dev->tx_seq >> 8;
+				udp_dev->tx_seq++;
+			}
 
+			/* Nobody to send to until a client has sent something */
+			if (udp_dev->clientLength == 0)
+				continue;
+
+			PIOS_Thread_Scheduler_Suspend();
+			sendto(udp_dev->socket, udp_dev->tx_buffer, size, 0,
+					(struct sockaddr *) &udp_dev->client,
+					udp_dev->clientLength);
+			PIOS_Thread_Scheduler_Resume();
+		} while (length > 0);
 	}
 }
 
@@ -130,41 +195,81 @@ void PIOS_UDP_RxThread(void * udp_dev_n)
 /**
 * Open UDP socket
 */
-int32_t PIOS_UDP_Init(uint32_t * udp_id, const struct pios_udp_cfg * cfg)
+int32_t PIOS_UDP_Init(uintptr_t * udp_id, const struct pios_udp_cfg * cfg)
 {
+	if (pios_udp_num_devices >= PIOS_UDP_MAX_DEV)
+		return -1;
+
+	pios_udp_dev * udp_dev = &pios_udp_devices[pios_udp_num_devices];
+
+	pios_udp_num_devices++;
+
+
+	/* initialize */
+	udp_dev->rx_in_cb = NULL;
+	udp_dev->tx_out_cb = NULL;
+	udp_dev->cfg=cfg;
+	udp_dev->clientLength = 0;
+	udp_dev->tx_seq = 0;
+	udp_dev->rx_seq = 0;
+	udp_dev->rx_synced = false;
+	udp_dev->rx_lost = 0;
+
+	udp_dev->txSem = PIOS_Semaphore_Create();
+	if (udp_dev->txSem == NULL)
+		return -1;
+
+	/* assign socket */
+	udp_dev->socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
 
-  pios_udp_dev * udp_dev = &pios_udp_devices[pios_udp_num_devices];
+	int optval = 1;
 
-  pios_udp_num_devices++;
+	/* Allow reuse of address if you restart. */
+	setsockopt(udp_dev->socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
 
+	memset(&udp_dev->server,0,sizeof(udp_dev->server));
+	memset(&udp_dev->client,0,sizeof(udp_dev->client));
+	udp_dev->server.sin_family = AF_INET;
+	udp_dev->server.sin_addr.s_addr = inet_addr(udp_dev->cfg->ip);
+	udp_dev->server.sin_port = htons(udp_dev->cfg->port + PIOS_SYS_PortOffset());
+	int res= bind(udp_dev->socket, (struct sockaddr *)&udp_dev->server,sizeof(udp_dev->server));
+	if (res == -1) {
+		perror("Binding socket failed\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Set socket nonblocking, the rx task polls it */
+	int flags = fcntl(udp_dev->socket, F_GETFL, 0);
+	if (flags != -1)
+		fcntl(udp_dev->socket, F_SETFL, flags | O_NONBLOCK);
 
-  /* initialize */
-  udp_dev->rx_in_cb = NULL;
-  udp_dev->tx_out_cb = NULL;
-  udp_dev->cfg=cfg;
+	udp_dev->rxThread = PIOS_Thread_Create(
+			PIOS_UDP_RxTask, "pios_udp_rx", PIOS_THREAD_STACK_SIZE_MIN, udp_dev, PIOS_THREAD_PRIO_HIGHEST);
+	udp_dev->txThread = PIOS_Thread_Create(
+			PIOS_UDP_TxTask, "pios_udp_tx", PIOS_THREAD_STACK_SIZE_MIN, udp_dev, PIOS_THREAD_PRIO_LOW);
 
-  /* assign socket */
-  udp_dev->socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
-  memset(&udp_dev->server,0,sizeof(udp_dev->server));
-  memset(&udp_dev->client,0,sizeof(udp_dev->client));
-  udp_dev->server.sin_family = AF_INET;
-  udp_dev->server.sin_addr.s_addr = inet_addr(udp_dev->cfg->ip);
-  udp_dev->server.sin_port = htons(udp_dev->cfg->port);
-  int res= bind(udp_dev->socket, (struct sockaddr *)&udp_dev->server,sizeof(udp_dev->server));
+	printf("udp dev %i - socket %i opened - result %i\n",pios_udp_num_devices-1,udp_dev->socket,res);
 
-  /* Create transmit thread for this connection */
-  udp_dev->rxThread = PIOS_Thread_Create(
-		  PIOS_TCP_RxTask, "pios_udp_rx", PIOS_THREAD_STACK_SIZE_MIN, udp_dev, PIOS_THREAD_PRIO_NORMAL);
+	*udp_id = pios_udp_num_devices-1;
+
+	return res;
+}
 
-  printf("udp dev %i - socket %i opened - result %i\n",pios_udp_num_devices-1,udp_dev->socket,res);
+/**
+ * Number of received datagrams that never arrived, only counted with
+ * sequence numbers enabled
+ */
+uint32_t PIOS_UDP_GetLostDatagrams(uintptr_t udp_id)
+{
+	pios_udp_dev * udp_dev = find_udp_dev_by_id(udp_id);
 
-  *udp_id = pios_udp_num_devices-1;
+	PIOS_Assert(udp_dev);
 
-  return res;
+	return udp_dev->rx_lost;
 }
 
 
-void PIOS_UDP_ChangeBaud(uint32_t udp_id, uint32_t baud)
+void PIOS_UDP_ChangeBaud(uintptr_t udp_id, uint32_t baud)
 {
 	/**
 	 * doesn't apply!
@@ -172,7 +277,7 @@ void PIOS_UDP_ChangeBaud(uint32_t udp_id, uint32_t baud)
 }
 
 
-static void PIOS_UDP_RxStart(uint32_t udp_id, uint16_t rx_bytes_avail)
+static void PIOS_UDP_RxStart(uintptr_t udp_id, uint16_t rx_bytes_avail)
 {
 	/**
 	 * lazy!
@@ -180,39 +285,17 @@ static void PIOS_UDP_RxStart(uint32_t udp_id, uint16_t rx_bytes_avail)
 }
 
 
-static void PIOS_UDP_TxStart(uint32_t udp_id, uint16_t tx_bytes_avail)
+static void PIOS_UDP_TxStart(uintptr_t udp_id, uint16_t tx_bytes_avail)
 {
 	pios_udp_dev * udp_dev = find_udp_dev_by_id(udp_id);
 
 	PIOS_Assert(udp_dev);
 
-	int32_t length,len,rem;
-
-	/**
-	 * we send everything directly whenever notified of data to send (lazy!)
-	 */
-	if (udp_dev->tx_out_cb) {
-		while (tx_bytes_avail>0) {
-			bool tx_need_yield = false;
-			length = (udp_dev->tx_out_cb)(udp_dev->tx_out_context, udp_dev->tx_buffer, PIOS_UDP_RX_BUFFER_SIZE, NULL, &tx_need_yield);
-			rem = length;
-			while (rem>0) {
-				len = sendto(udp_dev->socket, udp_dev->tx_buffer+length-rem, rem, 0,
-						 (struct sockaddr *) &udp_dev->client,
-						 sizeof(udp_dev->client));
-				if (len<=0) {
-					rem=0;
-				} else {
-					rem -= len;
-				}
-			}
-			tx_bytes_avail -= length;
-		}
-	}
-
+	/* Sending is left to the tx task so frames get batched */
+	PIOS_Semaphore_Give(udp_dev->txSem);
 }
 
-static void PIOS_UDP_RegisterRxCallback(uint32_t udp_id, pios_com_callback rx_in_cb, uint32_t context)
+static void PIOS_UDP_RegisterRxCallback(uintptr_t udp_id, pios_com_callback rx_in_cb, uintptr_t context)
 {
 	pios_udp_dev * udp_dev = find_udp_dev_by_id(udp_id);
 
@@ -226,7 +309,7 @@ static void PIOS_UDP_RegisterRxCallback(uint32_t udp_id, pios_com_callback rx_in
 	udp_dev->rx_in_cb = rx_in_cb;
 }
 
-static void PIOS_UDP_RegisterTxCallback(uint32_t udp_id, pios_com_callback tx_out_cb, uint32_t context)
+static void PIOS_UDP_RegisterTxCallback(uintptr_t udp_id, pios_com_callback tx_out_cb, uintptr_t context)
 {
 	pios_udp_dev * udp_dev = find_udp_dev_by_id(udp_id);
 
@@ -240,8 +323,4 @@ static void PIOS_UDP_RegisterTxCallback(uint32_t udp_id, pios_com_callback tx_ou
 	udp_dev->tx_out_cb = tx_out_cb;
 }
 
-
-
-
-
 #endif
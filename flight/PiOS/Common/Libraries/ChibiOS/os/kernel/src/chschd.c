@@ -89,6 +89,9 @@ Thread *chSchReadyI(Thread *tp) {
               "chSchReadyI(), #1",
               "invalid state");
 
+#if defined(THREAD_READY_HOOK)
+  THREAD_READY_HOOK(tp);
+#endif
   tp->p_state = THD_STATE_READY;
   cp = (Thread *)&rlist.r_queue;
   do {
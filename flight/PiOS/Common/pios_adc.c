@@ -173,15 +173,13 @@ void PIOS_ADC_SetQueue(uintptr_t adc_id, struct pios_queue *data_queue)
 }
 
 /**
- * @brief Reads from an ADC channel
- * this is an abstraction of the lower devices
+ * @brief Finds the device an ADC channel belongs to
  * channels are sequentially added from the lower devices available pins
- * Warning this function is not as efficient as directly getting the device channel
- * in the order of initialization
- * \param[in] channel channel to read from
- * \return value of the channel or -1 if error
+ * \param[in] channel channel to look up
+ * \param[out] device_pin pin of the channel on its device
+ * \return the device or NULL if there is no such channel
  */
-int32_t PIOS_ADC_GetChannelRaw(uint32_t channel)
+static struct pios_adc_dev *PIOS_ADC_FindChannel(uint32_t channel, uint32_t *device_pin)
 {
 	uint32_t offset = 0;
 	for (uint8_t x = 0; x < sub_device_list.number_of_devices; ++x) {
@@ -192,12 +190,32 @@ int32_t PIOS_ADC_GetChannelRaw(uint32_t channel)
 		} else if (adc_dev->driver->number_of_channels) {
 			uint32_t num_channels_for_this_device = adc_dev->driver->number_of_channels(adc_dev->lower_id);
 			if (adc_dev->driver->get_pin && (channel < offset + num_channels_for_this_device)) {
-				return (adc_dev->driver->get_pin)(adc_dev->lower_id, channel - offset);
+				*device_pin = channel - offset;
+				return adc_dev;
 			} else
 				offset += num_channels_for_this_device;
 		}
 	}
-	return -1;
+	return NULL;
+}
+
+/**
+ * @brief Reads from an ADC channel
+ * this is an abstraction of the lower devices
+ * channels are sequentially added from the lower devices available pins
+ * Warning this function is not as efficient as directly getting the device channel
+ * in the order of initialization
+ * \param[in] channel channel to read from
+ * \return value of the channel or -1 if error
+ */
+int32_t PIOS_ADC_GetChannelRaw(uint32_t channel)
+{
+	uint32_t device_pin;
+	struct pios_adc_dev *adc_dev = PIOS_ADC_FindChannel(channel, &device_pin);
+	if (adc_dev == NULL)
+		return -1;
+
+	return (adc_dev->driver->get_pin)(adc_dev->lower_id, device_pin);
 }
 
 /**
@@ -211,21 +229,38 @@ int32_t PIOS_ADC_GetChannelRaw(uint32_t channel)
  */
 float PIOS_ADC_GetChannelVolt(uint32_t channel)
 {
-	uint32_t offset = 0;
-	for (uint8_t x = 0; x < sub_device_list.number_of_devices; ++x) {
-		struct pios_adc_dev * adc_dev = sub_device_list.sub_device_pointers[x];
-		if (!PIOS_ADC_validate(adc_dev)) {
-			PIOS_DEBUG_Assert(0);
-			continue;
-		} else if (adc_dev->driver->number_of_channels) {
-			uint32_t num_channels_for_this_device = adc_dev->driver->number_of_channels(adc_dev->lower_id);
-			if (adc_dev->driver->get_pin && (channel < offset + num_channels_for_this_device)) {
-				return (float)((adc_dev->driver->get_pin)(adc_dev->lower_id, channel - offset)) * (float)(adc_dev->driver->lsb_voltage)(adc_dev->lower_id);
-			} else
-				offset += num_channels_for_this_device;
-		}
-	}
-	return -1;
+	uint32_t device_pin;
+	struct pios_adc_dev *adc_dev = PIOS_ADC_FindChannel(channel, &device_pin);
+	if (adc_dev == NULL)
+		return -1;
+
+	float value;
+	if (adc_dev->driver->get_pin_precise)
+		value = (adc_dev->driver->get_pin_precise)(adc_dev->lower_id, device_pin);
+	else
+		value = (float)((adc_dev->driver->get_pin)(adc_dev->lower_id, device_pin));
+
+	return value * (float)(adc_dev->driver->lsb_voltage)(adc_dev->lower_id);
+}
+
+/**
+ * @brief Reads from an ADC channel in LSB, with the fraction below the LSB
+ * where the driver filters the samples
+ * channels are sequentially added from the lower devices available pins
+ * \param[in] channel channel to read from
+ * \return value of the channel or negative if error
+ */
+float PIOS_ADC_GetChannelPrecise(uint32_t channel)
+{
+	uint32_t device_pin;
+	struct pios_adc_dev *adc_dev = PIOS_ADC_FindChannel(channel, &device_pin);
+	if (adc_dev == NULL)
+		return -1;
+
+	if (adc_dev->driver->get_pin_precise)
+		return (adc_dev->driver->get_pin_precise)(adc_dev->lower_id, device_pin);
+
+	return (float)((adc_dev->driver->get_pin)(adc_dev->lower_id, device_pin));
 }
 /**
  * @}
@@ -89,7 +89,7 @@ static int32_t PIOS_ADXL345_ClaimBus()
 	if(PIOS_ADXL345_Validate(dev) != 0)
 		return -1;
 
-	if(PIOS_SPI_ClaimBus(dev->spi_id) != 0)
+	if(PIOS_SPI_ClaimBusPriority(dev->spi_id, PIOS_SPI_PRIORITY_REALTIME) != 0)
 		return -2;
 
 	PIOS_SPI_RC_PinSet(dev->spi_id, dev->slave_num, 0);
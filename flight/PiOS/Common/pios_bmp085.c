@@ -35,13 +35,9 @@
 
 #include "pios_bmp085_priv.h"
 #include "pios_semaphore.h"
-#include "pios_thread.h"
+#include "pios_sensor_sched.h"
 #include "pios_queue.h"
 
-/* Private constants */
-#define BMP085_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
-#define BMP085_TASK_STACK		512
-
 /* BMP085 Addresses */
 #define BMP085_I2C_ADDR       0x77
 #define BMP085_CALIB_ADDR     0xAA
@@ -59,7 +55,7 @@ static uint32_t B4, B7;
 /* Private methods */
 static int32_t PIOS_BMP085_Read(uint8_t address, uint8_t *buffer, uint8_t len);
 static int32_t PIOS_BMP085_WriteCommand(uint8_t address, uint8_t buffer);
-static void PIOS_BMP085_Task(void *parameters);
+static uint32_t PIOS_BMP085_Step(void *ctx);
 
 /* Private types */
 
@@ -74,10 +70,15 @@ enum conversion_type {
 	TEMPERATURE_CONV
 };
 
+enum bmp085_state {
+	BMP085_STATE_START,
+	BMP085_STATE_READ_TEMPERATURE,
+	BMP085_STATE_READ_PRESSURE
+};
+
 struct bmp085_dev {
 	const struct pios_bmp085_cfg *cfg;
 	uint32_t i2c_id;
-	struct pios_thread *task;
 	struct pios_queue *queue;
 
 	int64_t pressure_unscaled;
@@ -97,6 +98,8 @@ struct bmp085_dev {
 	enum conversion_type current_conversion_type;
 	enum pios_bmp085_osr oversampling;
 	uint32_t temperature_interleaving;
+	int32_t temp_press_interleave_count;
+	enum bmp085_state state;
 	int32_t bmp085_read_flag;
 	enum pios_bmp085_dev_magic magic;
 
@@ -185,9 +188,10 @@ int32_t PIOS_BMP085_Init(const struct pios_bmp085_cfg *cfg, int32_t i2c_device)
 	dev->MC  = (data[18] << 8) | data[19];
 	dev->MD  = (data[20] << 8) | data[21];
 
-	dev->task = PIOS_Thread_Create(
-		PIOS_BMP085_Task, "pios_bmp085", BMP085_TASK_STACK, NULL, BMP085_TASK_PRIORITY);
-	if (dev->task == NULL)
+	dev->temp_press_interleave_count = dev->temperature_interleaving;
+	dev->state = BMP085_STATE_START;
+
+	if (PIOS_SENSOR_SCHED_Register(PIOS_BMP085_Step, NULL, 0) < 0)
 		return -3;
 
 	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, dev->queue);
@@ -423,41 +427,58 @@ int32_t PIOS_BMP085_Test()
 
 	return 0;
 }
-static void PIOS_BMP085_Task(void *parameters)
+/**
+ * Advance the conversion state machine, called from the sensor thread
+ * \return ms until the next call
+ */
+static uint32_t PIOS_BMP085_Step(void *ctx)
 {
-	int32_t temp_press_interleave_count = dev->temperature_interleaving;
-	int32_t read_adc_result = 0;
+	switch (dev->state) {
+	case BMP085_STATE_START:
+		if (PIOS_Semaphore_Take(dev->busy, 0) != true)
+			return 1;
 
-	while (1) {
+		if (--dev->temp_press_interleave_count <= 0) {
+			dev->temp_press_interleave_count = dev->temperature_interleaving;
 
-		temp_press_interleave_count --;
-		if(temp_press_interleave_count <= 0)
-		{
 			// Update the temperature data
-			PIOS_BMP085_ClaimDevice();
 			PIOS_BMP085_StartADC(TEMPERATURE_CONV);
-			PIOS_Thread_Sleep(5);
-			read_adc_result = PIOS_BMP085_ReadADC();
-			PIOS_BMP085_ReleaseDevice();
-			temp_press_interleave_count = dev->temperature_interleaving;
+			dev->state = BMP085_STATE_READ_TEMPERATURE;
+			return 5;
 		}
+
+		PIOS_BMP085_StartADC(PRESSURE_CONV);
+		dev->state = BMP085_STATE_READ_PRESSURE;
+		return PIOS_BMP085_GetDelay();
+
+	case BMP085_STATE_READ_TEMPERATURE:
+		PIOS_BMP085_ReadADC();
+
 		// Update the pressure data
-		PIOS_BMP085_ClaimDevice();
 		PIOS_BMP085_StartADC(PRESSURE_CONV);
-		PIOS_Thread_Sleep(PIOS_BMP085_GetDelay());
-		read_adc_result = PIOS_BMP085_ReadADC();
-		PIOS_BMP085_ReleaseDevice();
+		dev->state = BMP085_STATE_READ_PRESSURE;
+		return PIOS_BMP085_GetDelay();
+
+	case BMP085_STATE_READ_PRESSURE:
+	default:
+		break;
+	}
 
+	int32_t read_adc_result = PIOS_BMP085_ReadADC();
+	PIOS_BMP085_ReleaseDevice();
+	dev->state = BMP085_STATE_START;
+
+	if (read_adc_result == 0) {
 		// Compute the altitude from the pressure and temperature and send it out
 		struct pios_sensor_baro_data data;
 		data.temperature = ((float) dev->temperature_unscaled) / 10.0f;
 		data.pressure = ((float) dev->pressure_unscaled) / 1000.0f;
 		data.altitude = 44330.0f * (1.0f - powf(data.pressure / BMP085_P0, (1.0f / 5.255f)));
 
-		if (read_adc_result == 0) {
-			PIOS_Queue_Send(dev->queue, (void*)&data, 0);
-		}
+		PIOS_Queue_Send(dev->queue, (void*)&data, 0);
 	}
+
+	return 0;
 }
 
 #endif /* PIOS_INCLUDE_BMP085 */
@@ -48,6 +48,11 @@ const uint32_t pios_can_message_stdid[PIOS_CAN_LAST] = {
 	[PIOS_CAN_POS] = 0x2B5,
 	[PIOS_CAN_VERT] = 0x2B6,
 	[PIOS_CAN_ALARM] = 0x2B7,
+	[PIOS_CAN_GPS_DOWN_HEADING] = 0x2B8,
+	[PIOS_CAN_SENSOR_MAG] = 0x2C0,
+	[PIOS_CAN_SENSOR_BARO] = 0x2C1,
+	[PIOS_CAN_SENSOR_AIRSPEED] = 0x2C2,
+	[PIOS_CAN_ESC_TELEMETRY] = 0x2D0,
 };
 
 //! Map between message IDs and structures
@@ -83,6 +88,16 @@ int32_t get_message_size(uint32_t msg_id) {
 		return sizeof(struct pios_can_vert);
 	case PIOS_CAN_ALARM:
 		return sizeof(struct pios_can_alarm_message);
+	case PIOS_CAN_GPS_DOWN_HEADING:
+		return sizeof(struct pios_can_gps_down_heading);
+	case PIOS_CAN_SENSOR_MAG:
+		return sizeof(struct pios_can_sensor_mag);
+	case PIOS_CAN_SENSOR_BARO:
+		return sizeof(struct pios_can_sensor_baro);
+	case PIOS_CAN_SENSOR_AIRSPEED:
+		return sizeof(struct pios_can_sensor_airspeed);
+	case PIOS_CAN_ESC_TELEMETRY:
+		return sizeof(struct pios_can_esc_telemetry);
 	default:
 		return -1;
 	}
@@ -62,6 +62,9 @@ struct pios_com_dev {
 	bool has_rx;
 	bool has_tx;
 
+	//! Transmission waits until this many bytes are queued, 0 sends at once
+	uint16_t tx_batch;
+
 	t_fifo_buffer rx;
 	t_fifo_buffer tx;
 };
@@ -87,6 +90,7 @@ static uint16_t PIOS_COM_TxOutCallback(uintptr_t context, uint8_t * buf, uint16_
 static uint16_t PIOS_COM_RxInCallback(uintptr_t context, uint8_t * buf, uint16_t buf_len, uint16_t * headroom, bool * need_yield);
 static void PIOS_COM_UnblockRx(struct pios_com_dev * com_dev, bool * need_yield);
 static void PIOS_COM_UnblockTx(struct pios_com_dev * com_dev, bool * need_yield);
+static void PIOS_COM_StartTx(struct pios_com_dev * com_dev, bool force);
 
 /**
   * Initialises COM layer
@@ -214,6 +218,21 @@ static uint16_t PIOS_COM_TxOutCallback(uintptr_t context, uint8_t * buf, uint16_
 	return (bytes_from_fifo);
 }
 
+/**
+ * Make sure the transmitter is running if there is enough data queued
+ * \param[in] force start it for any amount of queued data
+ */
+static void PIOS_COM_StartTx(struct pios_com_dev * com_dev, bool force)
+{
+	uint16_t used = fifoBuf_getUsed(&com_dev->tx);
+
+	if (used == 0 || !com_dev->driver->tx_start)
+		return;
+
+	if (force || used >= com_dev->tx_batch)
+		com_dev->driver->tx_start(com_dev->lower_id, used);
+}
+
 /**
 * Change the port speed without re-initializing
 * \param[in] port COM port
@@ -294,10 +313,7 @@ int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer,
 
 	if (bytes_into_fifo > 0) {
 		/* More data has been put in the tx buffer, make sure the tx is started */
-		if (com_dev->driver->tx_start) {
-			com_dev->driver->tx_start(com_dev->lower_id,
-						  fifoBuf_getUsed(&com_dev->tx));
-		}
+		PIOS_COM_StartTx(com_dev, false);
 	}
 
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
@@ -368,6 +384,129 @@ int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t le
 	return len;
 }
 
+/**
+* Reserve space in the transmit buffer so that a message can be written
+* into it directly. On success the port is locked until PIOS_COM_CommitTx()
+* is called, which must follow without blocking.
+* \param[in] port COM port
+* \param[in] len number of contiguous bytes needed
+* \return pointer to the reserved space
+* \return NULL if the port is not available, busy or has not enough
+*         contiguous space, the caller should fall back to PIOS_COM_SendBuffer()
+*/
+uint8_t * PIOS_COM_ReserveTx(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return NULL;
+	}
+
+	PIOS_Assert(com_dev->has_tx);
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	if (PIOS_Mutex_Lock(com_dev->sendbuffer_mtx, 0) != true) {
+		return NULL;
+	}
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	uint8_t *space = NULL;
+
+	/* A device that is down is handled by the copying path */
+	if (!com_dev->driver->available || com_dev->driver->available(com_dev->lower_id)) {
+		space = fifoBuf_reserve(&com_dev->tx, len);
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	if (space == NULL) {
+		PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+	}
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	return space;
+}
+
+/**
+* Send the data written to the space returned by PIOS_COM_ReserveTx()
+* and unlock the port
+* \param[in] port COM port
+* \param[in] len number of bytes written, may be less than reserved or zero
+* \return -1 if port not available
+* \return number of bytes transmitted on success
+*/
+int32_t PIOS_COM_CommitTx(uintptr_t com_id, uint16_t len)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev)) {
+		/* Undefined COM port for this board (see pios_board.c) */
+		return -1;
+	}
+
+	if (len > 0) {
+		fifoBuf_commit(&com_dev->tx, len);
+
+		/* More data has been put in the tx buffer, make sure the tx is started */
+		PIOS_COM_StartTx(com_dev, false);
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Mutex_Unlock(com_dev->sendbuffer_mtx);
+#endif /* defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	return len;
+}
+
+/**
+* Hold transmission until a number of bytes are queued, so they go out back
+* to back. This lets a link that packs the serial stream into radio packets,
+* like a Bluetooth LE bridge, fill its packets instead of sending a packet
+* for every message. The caller must use PIOS_COM_FlushTx() once it has
+* nothing more to send for a while.
+* \param[in] port COM port
+* \param[in] bytes number of bytes to hold for, 0 to send at once
+* \return -1 if port not available
+* \return 0 on success
+*/
+int32_t PIOS_COM_SetTxBatch(uintptr_t com_id, uint16_t bytes)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev) || !com_dev->has_tx) {
+		return -1;
+	}
+
+	/* A batch larger than the buffer would only be sent when it is full */
+	if (bytes > fifoBuf_getSize(&com_dev->tx) / 2) {
+		bytes = fifoBuf_getSize(&com_dev->tx) / 2;
+	}
+
+	com_dev->tx_batch = bytes;
+	PIOS_COM_StartTx(com_dev, false);
+
+	return 0;
+}
+
+/**
+* Start sending whatever is held back by PIOS_COM_SetTxBatch()
+* \param[in] port COM port
+* \return -1 if port not available
+* \return 0 on success
+*/
+int32_t PIOS_COM_FlushTx(uintptr_t com_id)
+{
+	struct pios_com_dev * com_dev = (struct pios_com_dev *)com_id;
+
+	if (!PIOS_COM_validate(com_dev) || !com_dev->has_tx) {
+		return -1;
+	}
+
+	PIOS_COM_StartTx(com_dev, true);
+
+	return 0;
+}
+
 /**
 * Sends a single character over given port
 * \param[in] port COM port
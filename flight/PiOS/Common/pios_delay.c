@@ -184,6 +184,18 @@ uint32_t PIOS_DELAY_DiffuS(uint32_t raw)
 	return diff / us_ticks;
 }
 
+/**
+ * @brief Subtract two raw times and convert to us.
+ * @param[in] raw The earlier raw time
+ * @param[in] later The later raw time
+ * @return Interval in us between the two
+ */
+uint32_t PIOS_DELAY_DiffuS2(uint32_t raw, uint32_t later)
+{
+	uint32_t diff = later - raw;
+	return diff / us_ticks;
+}
+
 #endif
 
 /**
@@ -32,6 +32,7 @@
 /* Project Includes */
 #include "pios.h"
 #include "pios_dsm_priv.h"
+#include "pios_semaphore.h"
 
 #if defined(PIOS_INCLUDE_DSM)
 
@@ -46,11 +47,13 @@ static uint16_t PIOS_DSM_RxInCallback(uintptr_t context,
 				      uint16_t buf_len,
 				      uint16_t *headroom,
 				      bool *need_yield);
+static struct pios_semaphore *PIOS_DSM_GetSemaphore(uintptr_t rcvr_id, uint8_t channel);
 static void PIOS_DSM_Supervisor(uintptr_t dsm_id);
 
 /* Local Variables */
 const struct pios_rcvr_driver pios_dsm_rcvr_driver = {
 	.read = PIOS_DSM_Get,
+	.get_semaphore = PIOS_DSM_GetSemaphore,
 };
 
 enum dsm_resolution {
@@ -79,6 +82,7 @@ struct pios_dsm_dev {
 	const struct pios_dsm_cfg *cfg;
 	struct pios_dsm_state state;
 	enum dsm_resolution resolution;
+	struct pios_semaphore *frame_sema;
 };
 
 /* Allocate DSM device descriptor */
@@ -90,6 +94,12 @@ static struct pios_dsm_dev *PIOS_DSM_Alloc(void)
 	if (!dsm_dev)
 		return NULL;
 
+	dsm_dev->frame_sema = PIOS_Semaphore_Create();
+	if (!dsm_dev->frame_sema) {
+		PIOS_free(dsm_dev);
+		return NULL;
+	}
+
 	dsm_dev->resolution = DSM_UNKNOWN;
 	dsm_dev->magic = PIOS_DSM_DEV_MAGIC;
 	return dsm_dev;
@@ -274,10 +284,15 @@ stream_error:
 	return -1;
 }
 
-/* Update decoder state processing input byte from the DSMx stream */
-static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
+/**
+ * Update decoder state processing input byte from the DSMx stream
+ * \return true when the byte completed a frame with good data
+ */
+static bool PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
 {
 	struct pios_dsm_state *state = &(dsm_dev->state);
+	bool complete = false;
+
 	if (state->frame_found) {
 		/* receiving the data frame */
 		if (state->byte_count < DSM_FRAME_LENGTH) {
@@ -285,15 +300,19 @@ static void PIOS_DSM_UpdateState(struct pios_dsm_dev *dsm_dev, uint8_t byte)
 			state->received_data[state->byte_count++] = byte;
 			if (state->byte_count == DSM_FRAME_LENGTH) {
 				/* full frame received - process and wait for new one */
-				if (!PIOS_DSM_UnrollChannels(dsm_dev))
+				if (!PIOS_DSM_UnrollChannels(dsm_dev)) {
 					/* data looking good */
 					state->failsafe_timer = 0;
+					complete = true;
+				}
 
 				/* prepare for the next frame */
 				state->frame_found = 0;
 			}
 		}
 	}
+
+	return complete;
 }
 
 /* Initialise DSM receiver interface */
@@ -377,9 +396,13 @@ static uint16_t PIOS_DSM_RxInCallback(uintptr_t context,
 	bool valid = PIOS_DSM_Validate(dsm_dev);
 	PIOS_Assert(valid);
 
+	*need_yield = false;
+
 	/* process byte(s) and clear receive timer */
 	for (uint8_t i = 0; i < buf_len; i++) {
-		PIOS_DSM_UpdateState(dsm_dev, buf[i]);
+		/* wake whoever waits for the channels right away */
+		if (PIOS_DSM_UpdateState(dsm_dev, buf[i]))
+			PIOS_Semaphore_Give_FromISR(dsm_dev->frame_sema, need_yield);
 		dsm_dev->state.receive_timer = 0;
 	}
 
@@ -387,9 +410,6 @@ static uint16_t PIOS_DSM_RxInCallback(uintptr_t context,
 	if (headroom)
 		*headroom = DSM_FRAME_LENGTH;
 
-	/* We never need a yield */
-	*need_yield = false;
-
 	/* Always indicate that all bytes were consumed */
 	return buf_len;
 }
@@ -416,6 +436,17 @@ static int32_t PIOS_DSM_Get(uintptr_t rcvr_id, uint8_t channel)
 	return dsm_dev->state.channel_data[channel];
 }
 
+/* All channels come with the same frames */
+static struct pios_semaphore *PIOS_DSM_GetSemaphore(uintptr_t rcvr_id, uint8_t channel)
+{
+	struct pios_dsm_dev *dsm_dev = (struct pios_dsm_dev *)rcvr_id;
+
+	if (!PIOS_DSM_Validate(dsm_dev))
+		return NULL;
+
+	return dsm_dev->frame_sema;
+}
+
 /**
  * Input data supervisor is called periodically and provides
  * two functions: frame syncing and failsafe triggering.
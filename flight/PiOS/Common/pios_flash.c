@@ -347,6 +347,39 @@ int32_t PIOS_FLASH_erase_range(uintptr_t partition_id, uint32_t start_offset, ui
 	return 0;
 }
 
+/**
+ * @brief Find the sector that holds an offset within the specified partition
+ * @param[in] partition_id opaque handle for a specific partition
+ * @param[in] partition_offset offset (in bytes) from beginning of partition
+ * @param[out] sector_offset offset of the beginning of the sector within the partition
+ * @param[out] sector_size size of the sector in bytes
+ * @return 0 if success or error code
+ * @retval -20 if partition_id is not a valid partition identifier
+ * @retval -22 if failed to find beginning of partition within the partition table
+ * @retval -23 if the offset is past the end of the partition
+ */
+int32_t PIOS_FLASH_get_sector_extents(uintptr_t partition_id, uint32_t partition_offset, uint32_t *sector_offset, uint32_t *sector_size)
+{
+	struct pios_flash_partition *partition = (struct pios_flash_partition *)partition_id;
+
+	if (!PIOS_FLASH_validate_partition(partition))
+		return -20;
+
+	struct pios_flash_sector_desc sector_desc;
+	if (!pios_flash_get_partition_first_sector(partition, &sector_desc))
+		return -22;
+
+	do {
+		if (partition_offset < sector_desc.partition_offset + sector_desc.sector_size) {
+			*sector_offset = sector_desc.partition_offset;
+			*sector_size   = sector_desc.sector_size;
+			return 0;
+		}
+	} while (pios_flash_get_partition_next_sector(partition, &sector_desc));
+
+	return -23;
+}
+
 /**
  * @brief Erase all of the flash sectors within this partition
  * @param[in] partition_id opaque handle for a specific partition
@@ -385,6 +418,74 @@ int32_t PIOS_FLASH_erase_partition(uintptr_t partition_id)
 	return 0;
 }
 
+/**
+ * @brief Check whether a sector reads back as erased
+ * @return true if every byte of the sector is 0xFF
+ */
+static bool pios_flash_sector_is_blank(const struct pios_flash_partition *partition, const struct pios_flash_sector_desc *sector_desc)
+{
+	uint32_t buf[32];
+
+	for (uint32_t offset = 0; offset < sector_desc->sector_size; offset += sizeof(buf)) {
+		uint16_t len = MIN(sizeof(buf), sector_desc->sector_size - offset);
+
+		if (partition->chip_desc->driver->read_data(*partition->chip_desc->chip_id,
+								sector_desc->chip_offset + offset,
+								(uint8_t *)buf,
+								len) != 0)
+			return false;
+
+		for (uint16_t i = 0; i < len / sizeof(buf[0]); i++) {
+			if (buf[i] != 0xFFFFFFFF)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Erase the flash sectors within this partition that are not already blank
+ * @param[in] partition_id opaque handle for a specific partition
+ * @return 0 if success or error code
+ * @retval -1 to -19 error code from underlying flash chip driver
+ * @retval -20 if partition_id is not a valid partition identifier
+ * @retval -21 if chip driver does not provide an erase_sector or read_data implementation
+ * @retval -22 if failed to find beginning of partition within the partition table
+ * @retval -23 if underlying chip driver failed to erase a sector
+ * @note Reading a sector is much faster than erasing it, so this saves most
+ * of the erase time when a smaller image replaces a larger one
+ * @note on failure, some of the sectors within the partition may have been erased
+ */
+int32_t PIOS_FLASH_erase_dirty_sectors(uintptr_t partition_id)
+{
+	struct pios_flash_partition *partition = (struct pios_flash_partition *)partition_id;
+
+	if (!PIOS_FLASH_validate_partition(partition))
+		return -20;
+
+	if (!partition->chip_desc->driver->erase_sector ||
+		!partition->chip_desc->driver->read_data)
+		return -21;
+
+	struct pios_flash_sector_desc sector_desc;
+	if (!pios_flash_get_partition_first_sector(partition, &sector_desc))
+		return -22;
+
+	do {
+		if (pios_flash_sector_is_blank(partition, &sector_desc))
+			continue;
+
+		if (partition->chip_desc->driver->erase_sector(*partition->chip_desc->chip_id,
+								sector_desc.sector,
+								sector_desc.chip_offset) != 0) {
+			return -23;
+		}
+	} while (pios_flash_get_partition_next_sector(partition, &sector_desc));
+
+	return 0;
+}
+
 /**
  * @brief Write a block of data at an offset within the specified partition
  * @param[in] partition_id opaque handle for a specific partition
@@ -469,6 +570,34 @@ int32_t PIOS_FLASH_read_data(uintptr_t partition_id, uint32_t partition_offset,
 						len);
 }
 
+/**
+ * @brief Get the address a block of the specified partition can be read at in place
+ * @note The contents change under the returned pointer with every erase or write
+ * of the block
+ * @param[in] partition_id opaque handle for a specific partition
+ * @param[in] partition_offset offset (in bytes) from beginning of partition of the block
+ * @param[in] len size of the block
+ * @return pointer to the block or NULL if the chip is not memory mapped
+ */
+const uint8_t *PIOS_FLASH_map_data(uintptr_t partition_id, uint32_t partition_offset, uint32_t len)
+{
+	struct pios_flash_partition *partition = (struct pios_flash_partition *)partition_id;
+
+	if (!PIOS_FLASH_validate_partition(partition))
+		return NULL;
+
+	if (!partition->chip_desc->driver->map_data)
+		return NULL;
+
+	/* Does the block extend past the end of the partition? */
+	if ((partition_offset + len) > partition->size)
+		return NULL;
+
+	return partition->chip_desc->driver->map_data(*partition->chip_desc->chip_id,
+						partition->chip_offset + partition_offset,
+						len);
+}
+
 #endif	/* PIOS_INCLUDE_FLASH */
 
 /**
@@ -56,6 +56,9 @@
 #define JEDEC_STATUS_SEC             0x40
 #define JEDEC_STATUS_SRP0            0x80
 
+/* Bytes read before checking if another device waits for the bus */
+#define JEDEC_READ_CHUNK             64
+
 enum pios_jedec_dev_magic {
 	PIOS_JEDEC_DEV_MAGIC = 0xcb55aa55,
 };
@@ -71,6 +74,8 @@ struct jedec_flash_dev {
 
 	const struct pios_flash_jedec_cfg *cfg;
 	struct pios_semaphore *transaction_lock;
+	/* A page program or erase was started and not waited for yet */
+	bool write_in_progress;
 	enum pios_jedec_dev_magic magic;
 };
 
@@ -84,6 +89,7 @@ static int32_t PIOS_Flash_Jedec_ClaimBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_ReleaseBus(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_WriteEnable(struct jedec_flash_dev *flash_dev);
 static int32_t PIOS_Flash_Jedec_Busy(struct jedec_flash_dev *flash_dev);
+static int32_t PIOS_Flash_Jedec_WaitReady(struct jedec_flash_dev *flash_dev);
 
 /**
  * @brief Allocate a new device
@@ -129,6 +135,7 @@ int32_t PIOS_Flash_Jedec_Init(uintptr_t *chip_id, uint32_t spi_id, uint32_t slav
 	flash_dev->spi_id = spi_id;
 	flash_dev->slave_num = slave_num;
 	flash_dev->cfg = cfg;
+	flash_dev->write_in_progress = false;
 
 	(void) PIOS_Flash_Jedec_ReadID(flash_dev);
 	if ((flash_dev->manufacturer != flash_dev->cfg->expect_manufacturer) ||
@@ -151,7 +158,7 @@ int32_t PIOS_Flash_Jedec_Init(uintptr_t *chip_id, uint32_t spi_id, uint32_t slav
  */
 static int32_t PIOS_Flash_Jedec_ClaimBus(struct jedec_flash_dev *flash_dev)
 {
-	if (PIOS_SPI_ClaimBus(flash_dev->spi_id) < 0)
+	if (PIOS_SPI_ClaimBusPriority(flash_dev->spi_id, PIOS_SPI_PRIORITY_BULK) < 0)
 		return -1;
 
 	PIOS_SPI_RC_PinSet(flash_dev->spi_id, flash_dev->slave_num, 0);
@@ -181,6 +188,41 @@ static int32_t PIOS_Flash_Jedec_Busy(struct jedec_flash_dev *flash_dev)
 	return status & JEDEC_STATUS_BUSY;
 }
 
+/**
+ * @brief Wait for the page program or erase started last to complete
+ *
+ * Writes and erases return as soon as the chip accepted the command, the
+ * caller prepares the next page while the chip programs the previous one.
+ * Every command that needs the chip idle has to call this first.
+ * @returns 0 if successful, -1 if unable to claim bus
+ */
+static int32_t PIOS_Flash_Jedec_WaitReady(struct jedec_flash_dev *flash_dev)
+{
+	if (!flash_dev->write_in_progress)
+		return 0;
+
+	// Keep polling when bus is busy too
+#if defined(FLASH_FREERTOS)
+	while (PIOS_Flash_Jedec_Busy(flash_dev) != 0) {
+		PIOS_Thread_Sleep(1);
+	}
+#else
+
+	// Query status this way to prevent accel chip locking us out
+	if (PIOS_Flash_Jedec_ClaimBus(flash_dev) < 0)
+		return -1;
+
+	PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS);
+	while (PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS) & JEDEC_STATUS_BUSY);
+
+	PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+
+#endif
+	flash_dev->write_in_progress = false;
+
+	return 0;
+}
+
 /**
  * @brief Execute the write enable instruction and returns the status
  * @returns 0 if successful, -1 if unable to claim bus
@@ -319,6 +361,9 @@ static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 		(chip_offset >>  0) & 0xff,
 	};
 
+	if (PIOS_Flash_Jedec_WaitReady(flash_dev) != 0)
+		return -1;
+
 	if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0)
 		return ret;
 
@@ -332,12 +377,8 @@ static int32_t PIOS_Flash_Jedec_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	PIOS_Flash_Jedec_ReleaseBus(flash_dev);
 
-	// Keep polling when bus is busy too
-	while (PIOS_Flash_Jedec_Busy(flash_dev) != 0) {
-#if defined(FLASH_FREERTOS)
-		PIOS_Thread_Sleep(1);
-#endif
-	}
+	// The erase completes in the background, see PIOS_Flash_Jedec_WaitReady()
+	flash_dev->write_in_progress = true;
 
 	return 0;
 }
@@ -376,6 +417,9 @@ static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t chip_id, uint32_t chip_offse
 	if (((chip_offset & 0xff) + len) > 0x100)
 		return -3;
 
+	if (PIOS_Flash_Jedec_WaitReady(flash_dev) != 0)
+		return -1;
+
 	if ((ret = PIOS_Flash_Jedec_WriteEnable(flash_dev)) != 0)
 		return ret;
 
@@ -396,23 +440,9 @@ static int32_t PIOS_Flash_Jedec_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	PIOS_Flash_Jedec_ReleaseBus(flash_dev);
 
-	// Keep polling when bus is busy too
-#if defined(FLASH_FREERTOS)
-	while (PIOS_Flash_Jedec_Busy(flash_dev) != 0) {
-		PIOS_Thread_Sleep(1);
-	}
-#else
-
-	// Query status this way to prevent accel chip locking us out
-	if (PIOS_Flash_Jedec_ClaimBus(flash_dev) < 0)
-		return -1;
-
-	PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS);
-	while (PIOS_SPI_TransferByte(flash_dev->spi_id, JEDEC_READ_STATUS) & JEDEC_STATUS_BUSY);
+	// The page programs in the background, see PIOS_Flash_Jedec_WaitReady()
+	flash_dev->write_in_progress = true;
 
-	PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-
-#endif
 	return 0;
 }
 
@@ -432,26 +462,47 @@ static int32_t PIOS_Flash_Jedec_ReadData(uintptr_t chip_id, uint32_t chip_offset
 	if (PIOS_Flash_Jedec_Validate(flash_dev) != 0)
 		return -1;
 
-	if (PIOS_Flash_Jedec_ClaimBus(flash_dev) == -1)
+	if (PIOS_Flash_Jedec_WaitReady(flash_dev) != 0)
 		return -1;
 
-	/* Execute read command and clock in address.  Keep CS asserted */
-	uint8_t out[] = {
-		JEDEC_READ_DATA,
-		(chip_offset >> 16) & 0xff,
-		(chip_offset >>  8) & 0xff,
-		(chip_offset >>  0) & 0xff,
-	};
-
-	if (PIOS_SPI_TransferBlock(flash_dev->spi_id,out,NULL,sizeof(out),NULL) < 0) {
-		PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-		return -2;
-	}
-
-	/* Copy the transfer data to the buffer */
-	if (PIOS_SPI_TransferBlock(flash_dev->spi_id,NULL,data,len,NULL) < 0) {
-		PIOS_Flash_Jedec_ReleaseBus(flash_dev);
-		return -3;
+	bool claimed = false;
+	while (len > 0) {
+		if (!claimed) {
+			if (PIOS_Flash_Jedec_ClaimBus(flash_dev) == -1)
+				return -1;
+			claimed = true;
+
+			/* Execute read command and clock in address.  Keep CS asserted */
+			uint8_t out[] = {
+				JEDEC_READ_DATA,
+				(chip_offset >> 16) & 0xff,
+				(chip_offset >>  8) & 0xff,
+				(chip_offset >>  0) & 0xff,
+			};
+
+			if (PIOS_SPI_TransferBlock(flash_dev->spi_id,out,NULL,sizeof(out),NULL) < 0) {
+				PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+				return -2;
+			}
+		}
+
+		uint16_t chunk = len > JEDEC_READ_CHUNK ? JEDEC_READ_CHUNK : len;
+
+		/* Copy the transfer data to the buffer */
+		if (PIOS_SPI_TransferBlock(flash_dev->spi_id,NULL,data,chunk,NULL) < 0) {
+			PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+			return -3;
+		}
+
+		data += chunk;
+		chip_offset += chunk;
+		len -= chunk;
+
+		/* Hand the bus over between chunks, the read restarts at the new address */
+		if (len > 0 && PIOS_SPI_BusContended(flash_dev->spi_id, PIOS_SPI_PRIORITY_BULK)) {
+			PIOS_Flash_Jedec_ReleaseBus(flash_dev);
+			claimed = false;
+		}
 	}
 
 	PIOS_Flash_Jedec_ReleaseBus(flash_dev);
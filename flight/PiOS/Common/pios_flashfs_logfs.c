@@ -32,9 +32,27 @@
 
 #include <stdbool.h>
 #include <stddef.h>		/* NULL */
+#include <string.h>		/* memset */
 
 #define MIN(x,y) ((x) < (y) ? (x) : (y))
 
+/*
+ * Upper bound on the number of entries in the RAM index of the active slots.
+ * Must be a power of 2, 0 disables the index and every lookup scans the log.
+ */
+#if !defined(PIOS_FLASHFS_LOGFS_MAX_INDEX)
+#if defined(SMALLF1)
+#define PIOS_FLASHFS_LOGFS_MAX_INDEX 0
+#else
+#define PIOS_FLASHFS_LOGFS_MAX_INDEX 128
+#endif
+#endif
+
+/* Number of active slots copied by each background garbage collection step */
+#if !defined(PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP)
+#define PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP 8
+#endif
+
 /*
  * Filesystem state data tracked in RAM
  */
@@ -43,6 +61,18 @@ enum pios_flashfs_logfs_dev_magic {
 	PIOS_FLASHFS_LOGFS_DEV_MAGIC = 0x94938201,
 };
 
+struct logfs_index_entry {
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint16_t slot_id;	/* 0 marks an unused entry, slot 0 is the arena header */
+};
+
+enum logfs_gc_state {
+	LOGFS_GC_IDLE,
+	LOGFS_GC_ERASE,		/* destination arena needs erasing and reserving */
+	LOGFS_GC_COPY,		/* active slots are being copied to the destination */
+};
+
 struct logfs_state {
 	enum pios_flashfs_logfs_dev_magic magic;
 	const struct flashfs_logfs_cfg *cfg;
@@ -59,6 +89,27 @@ struct logfs_state {
 	/* Underlying flash partition handle */
 	uintptr_t partition_id;
 	uint32_t partition_size;
+	const uint8_t *mapped;	/* the partition, when the CPU can read it in place */
+
+	/*
+	 * Open addressed hash of obj_id/obj_inst_id -> slot for every active
+	 * slot of the mounted arena.  It is rebuilt on each mount and is
+	 * marked invalid (falling back to scanning the log) if it overflows.
+	 */
+	struct logfs_index_entry *index;
+	uint16_t index_size;	/* power of 2 */
+	uint16_t index_used;
+	bool index_valid;
+
+	/*
+	 * Incremental garbage collection.  The destination arena stays
+	 * reserved until the very last step, so the active arena remains the
+	 * authoritative copy if power is lost part way through.
+	 */
+	enum logfs_gc_state gc_state;
+	uint8_t gc_arena_id;	 /* destination arena */
+	uint16_t gc_src_slot_id; /* next slot of the active arena to copy */
+	uint16_t gc_dst_slot_id; /* next free slot of the destination arena */
 };
 
 /*
@@ -78,6 +129,20 @@ static uintptr_t logfs_get_addr(const struct logfs_state *logfs, uint8_t arena_i
 		(slot_id  * logfs->cfg->slot_size));
 }
 
+/**
+ * @brief Read from the partition, straight out of memory if it is mapped
+ * @return 0 if success, < 0 on failure
+ */
+static int32_t logfs_read_data(const struct logfs_state *logfs, uintptr_t offset, uint8_t *data, uint16_t len)
+{
+	if (logfs->mapped) {
+		memcpy(data, logfs->mapped + offset, len);
+		return 0;
+	}
+
+	return PIOS_FLASH_read_data(logfs->partition_id, offset, data, len);
+}
+
 /*
  * The bits within these enum values must progress ONLY
  * from 1 -> 0 so that we can write later ones on top
@@ -152,7 +217,7 @@ static int32_t logfs_reserve_arena (const struct logfs_state *logfs, uint8_t are
 
 	/* Read in the current arena header */
 	struct arena_header arena_hdr;
-	if (PIOS_FLASH_read_data(logfs->partition_id,
+	if (logfs_read_data(logfs,
 					arena_addr,
 					(uint8_t *)&arena_hdr,
 					sizeof(arena_hdr)) != 0) {
@@ -207,7 +272,7 @@ static int32_t logfs_activate_arena(const struct logfs_state *logfs, uint8_t are
 
 	/* Make sure this arena has been previously erased */
 	struct arena_header arena_hdr;
-	if (PIOS_FLASH_read_data(logfs->partition_id,
+	if (logfs_read_data(logfs,
 					arena_addr,
 					(uint8_t *)&arena_hdr,
 					sizeof (arena_hdr)) != 0) {
@@ -248,7 +313,7 @@ static int32_t logfs_obsolete_arena(const struct logfs_state *logfs, uint8_t are
 
 	/* Make sure this arena was previously active */
 	struct arena_header arena_hdr;
-	if (PIOS_FLASH_read_data(logfs->partition_id,
+	if (logfs_read_data(logfs,
 					arena_addr,
 					(uint8_t *)&arena_hdr,
 					sizeof (arena_hdr)) != 0) {
@@ -290,7 +355,7 @@ static int32_t logfs_find_active_arena(const struct logfs_state *logfs)
 		uintptr_t arena_addr = logfs_get_addr (logfs, arena_id, 0);
 		/* Load the arena header */
 		struct arena_header arena_hdr;
-		if (PIOS_FLASH_read_data(logfs->partition_id,
+		if (logfs_read_data(logfs,
 						arena_addr,
 						(uint8_t *)&arena_hdr,
 						sizeof (arena_hdr)) != 0) {
@@ -352,7 +417,7 @@ static int32_t logfs_raw_copy_bytes (const struct logfs_state *logfs, uintptr_t
 		}
 
 		/* Read a block of data from source */
-		if (PIOS_FLASH_read_data(logfs->partition_id,
+		if (logfs_read_data(logfs,
 						src_addr,
 						data_block,
 						blk_size) != 0) {
@@ -398,6 +463,114 @@ static bool logfs_log_is_full(const struct logfs_state *logfs)
 	return (logfs->num_free_slots == 0);
 }
 
+/*
+ * RAM index of the active slots
+ */
+
+static bool logfs_index_usable(const struct logfs_state *logfs)
+{
+	return (logfs->index && logfs->index_valid);
+}
+
+static uint16_t logfs_index_hash(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint32_t hash = obj_id ^ (obj_inst_id * 0x9E3779B1);
+	hash ^= hash >> 16;
+
+	return (hash & (logfs->index_size - 1));
+}
+
+static void logfs_index_clear(struct logfs_state *logfs)
+{
+	if (!logfs->index)
+		return;
+
+	memset(logfs->index, 0, logfs->index_size * sizeof(*logfs->index));
+	logfs->index_used  = 0;
+	logfs->index_valid = true;
+}
+
+/**
+ * @brief Find the index entry for an object instance
+ * @return position of the entry in the index or -1 if it is not indexed
+ */
+static int32_t logfs_index_lookup(const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	uint16_t mask = logfs->index_size - 1;
+
+	/* The load limit guarantees that there is always an unused entry to stop at */
+	for (uint16_t i = logfs_index_hash(logfs, obj_id, obj_inst_id);
+	     logfs->index[i].slot_id != 0;
+	     i = (i + 1) & mask) {
+		if (logfs->index[i].obj_id == obj_id &&
+			logfs->index[i].obj_inst_id == obj_inst_id) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * @brief Record the active slot of an object instance
+ * @note An instance that is already indexed keeps its entry, this matches a
+ *       scan of the log which stops at the first active copy.
+ */
+static void logfs_index_insert(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+	if (!logfs_index_usable(logfs))
+		return;
+
+	if (logfs_index_lookup(logfs, obj_id, obj_inst_id) >= 0)
+		return;
+
+	/* Keep the load at or below 3/4 so probe sequences stay short */
+	if ((logfs->index_used + 1) * 4 > logfs->index_size * 3) {
+		logfs->index_valid = false;
+		return;
+	}
+
+	uint16_t mask = logfs->index_size - 1;
+	uint16_t i = logfs_index_hash(logfs, obj_id, obj_inst_id);
+	while (logfs->index[i].slot_id != 0)
+		i = (i + 1) & mask;
+
+	logfs->index[i].obj_id      = obj_id;
+	logfs->index[i].obj_inst_id = obj_inst_id;
+	logfs->index[i].slot_id     = slot_id;
+	logfs->index_used++;
+}
+
+static void logfs_index_remove(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (!logfs_index_usable(logfs))
+		return;
+
+	int32_t pos = logfs_index_lookup(logfs, obj_id, obj_inst_id);
+	if (pos < 0)
+		return;
+
+	/*
+	 * Shift the following entries of the probe sequence back into the
+	 * hole so lookups never need tombstones.  An entry may only move if
+	 * the hole lies between its home position and where it is now.
+	 */
+	uint16_t mask = logfs->index_size - 1;
+	uint16_t hole = pos;
+	for (uint16_t i = (hole + 1) & mask;
+	     logfs->index[i].slot_id != 0;
+	     i = (i + 1) & mask) {
+		uint16_t home = logfs_index_hash(logfs, logfs->index[i].obj_id, logfs->index[i].obj_inst_id);
+		if (((i - home) & mask) >= ((i - hole) & mask)) {
+			logfs->index[hole] = logfs->index[i];
+			hole = i;
+		}
+	}
+
+	logfs->index[hole].slot_id = 0;
+	logfs->index_used--;
+}
+
 static int32_t logfs_unmount_log(struct logfs_state *logfs)
 {
 	PIOS_Assert (logfs->mounted);
@@ -417,13 +590,15 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 	logfs->num_free_slots   = 0;
 	logfs->active_arena_id  = arena_id;
 
+	logfs_index_clear(logfs);
+
 	/* Scan the log to find out how full it is */
 	for (uint16_t slot_id = 1;
 	     slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
 	     slot_id++) {
 		struct slot_header slot_hdr;
 		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
-		if (PIOS_FLASH_read_data(logfs->partition_id,
+		if (logfs_read_data(logfs,
 						slot_addr,
 						(uint8_t *)&slot_hdr,
 						sizeof (slot_hdr)) != 0) {
@@ -443,6 +618,7 @@ static int32_t logfs_mount_log(struct logfs_state *logfs, uint8_t arena_id)
 			break;
 		case SLOT_STATE_ACTIVE:
 			logfs->num_active_slots++;
+			logfs_index_insert(logfs, slot_hdr.obj_id, slot_hdr.obj_inst_id, slot_id);
 			break;
 		case SLOT_STATE_RESERVED:
 		case SLOT_STATE_OBSOLETE:
@@ -476,6 +652,8 @@ static void PIOS_FLASHFS_Logfs_free(struct logfs_state *logfs)
 {
 	/* Invalidate the magic */
 	logfs->magic = ~PIOS_FLASHFS_LOGFS_DEV_MAGIC;
+	if (logfs->index)
+		PIOS_free(logfs->index);
 	PIOS_free(logfs);
 }
 
@@ -519,7 +697,24 @@ int32_t PIOS_FLASHFS_Logfs_Init(uintptr_t *fs_id, const struct flashfs_logfs_cfg
 	logfs->cfg            = cfg;	/* filesystem configuration */
 	logfs->partition_id   = partition_id; /* underlying partition */
 	logfs->partition_size = partition_size; /* size of underlying partition */
+	logfs->mapped         = PIOS_FLASH_map_data(partition_id, 0, partition_size);
 	logfs->mounted        = false;
+	logfs->gc_state       = LOGFS_GC_IDLE;
+
+	/* Size the index to the slots of one arena, within the configured bound */
+	logfs->index       = NULL;
+	logfs->index_size  = 0;
+	logfs->index_valid = false;
+	if (PIOS_FLASHFS_LOGFS_MAX_INDEX > 0) {
+		uint16_t num_slots  = cfg->arena_size / cfg->slot_size;
+		uint16_t index_size = 1;
+		while (index_size < num_slots && index_size * 2 <= PIOS_FLASHFS_LOGFS_MAX_INDEX)
+			index_size <<= 1;
+
+		logfs->index = (struct logfs_index_entry *)PIOS_malloc_no_dma(index_size * sizeof(*logfs->index));
+		if (logfs->index)
+			logfs->index_size = index_size;
+	}
 
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -1;
@@ -587,72 +782,171 @@ out_exit:
 	return rc;
 }
 
-/* NOTE: Must be called while holding the flash transaction lock */
-static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
-	PIOS_Assert (logfs->mounted);
+/*
+ * Should garbage collection be started ahead of the log filling up?
+ * Only when it reclaims a good share of the arena, collecting early must not
+ * make arenas get erased much more often than waiting for a full log would.
+ */
+static bool logfs_gc_wanted(const struct logfs_state *logfs)
+{
+	uint16_t num_slots   = (logfs->cfg->arena_size / logfs->cfg->slot_size) - 1;
+	uint16_t reclaimable = num_slots - logfs->num_active_slots - logfs->num_free_slots;
 
-	/* Source arena is the active arena */
-	uint8_t src_arena_id = logfs->active_arena_id;
+	return ((logfs->num_free_slots < num_slots / 4) &&
+		(reclaimable >= num_slots / 4));
+}
 
-	/* Compute destination arena */
-	uint8_t dst_arena_id = (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+/*
+ * Arena the active slots move to next.  Walk the arenas in turn so they all
+ * see the same number of erase cycles.
+ */
+static uint8_t logfs_next_arena(const struct logfs_state *logfs)
+{
+	return (logfs->active_arena_id + 1) % (logfs->partition_size / logfs->cfg->arena_size);
+}
+
+/*
+ * Make a completely written arena the active one, activating it is what
+ * commits its contents.
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_switch_arena(struct logfs_state *logfs, uint8_t arena_id)
+{
+	uint8_t src_arena_id = logfs->active_arena_id;
 
-	/* Erase destination arena */
-	if (logfs_erase_arena (logfs, dst_arena_id) != 0) {
+	/* Activate the destination arena */
+	if (logfs_activate_arena (logfs, arena_id) != 0)
 		return -1;
-	}
 
-	/* Reserve the destination arena so we can start filling it */
-	if (logfs_reserve_arena (logfs, dst_arena_id) != 0) {
-		/* Unable to reserve the arena */
+	/* Unmount the source arena */
+	if (logfs_unmount_log (logfs) != 0)
 		return -2;
+
+	/* Obsolete the source arena */
+	if (logfs_obsolete_arena (logfs, src_arena_id) != 0)
+		return -3;
+
+	/* Mount the new arena */
+	if (logfs_mount_log (logfs, arena_id) != 0)
+		return -4;
+
+	return 0;
+}
+
+static void logfs_gc_start(struct logfs_state *logfs)
+{
+	PIOS_Assert(logfs->gc_state == LOGFS_GC_IDLE);
+
+	logfs->gc_arena_id = logfs_next_arena(logfs);
+	logfs->gc_state    = LOGFS_GC_ERASE;
+}
+
+/**
+ * @brief Run one step of garbage collection
+ * @param[in] max_copies Maximum number of active slots to copy in this step
+ * @return 0 if success, < 0 on failure
+ * @note Steps are: erase and reserve the destination, copy the active slots
+ *       a few at a time, then switch over to the destination once the copy
+ *       has caught up with the end of the log.
+ * @note On failure the collection is abandoned and restarts from the erase.
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_gc_step(struct logfs_state *logfs, uint16_t max_copies)
+{
+	PIOS_Assert(logfs->mounted);
+
+	int32_t rc;
+
+	switch (logfs->gc_state) {
+	case LOGFS_GC_IDLE:
+		return 0;
+	case LOGFS_GC_ERASE:
+		/* Erase destination arena */
+		if (logfs_erase_arena(logfs, logfs->gc_arena_id) != 0) {
+			rc = -1;
+			goto out_abort;
+		}
+
+		/* Reserve the destination arena so we can start filling it */
+		if (logfs_reserve_arena(logfs, logfs->gc_arena_id) != 0) {
+			/* Unable to reserve the arena */
+			rc = -2;
+			goto out_abort;
+		}
+
+		logfs->gc_src_slot_id = 1;
+		logfs->gc_dst_slot_id = 1;
+		logfs->gc_state = LOGFS_GC_COPY;
+		return 0;
+	case LOGFS_GC_COPY:
+		break;
 	}
 
-	/* Copy active slots from active arena to destination arena */
-	uint16_t dst_slot_id = 1;
-	for (uint16_t src_slot_id = 1;
-	     src_slot_id < (logfs->cfg->arena_size / logfs->cfg->slot_size);
-	     src_slot_id++) {
+	/*
+	 * Copy active slots from active arena to destination arena.  Objects
+	 * saved since the collection started are appended to the active arena
+	 * and get picked up here as well.
+	 */
+	uint16_t end_slot_id = (logfs->cfg->arena_size / logfs->cfg->slot_size) - logfs->num_free_slots;
+	while (logfs->gc_src_slot_id < end_slot_id && max_copies > 0) {
 		struct slot_header slot_hdr;
-		uintptr_t src_addr = logfs_get_addr (logfs, src_arena_id, src_slot_id);
-		if (PIOS_FLASH_read_data(logfs->partition_id,
+		uintptr_t src_addr = logfs_get_addr (logfs, logfs->active_arena_id, logfs->gc_src_slot_id);
+		if (logfs_read_data(logfs,
 						src_addr,
 						(uint8_t *)&slot_hdr,
 						sizeof (slot_hdr)) != 0) {
-			return -3;
+			rc = -3;
+			goto out_abort;
 		}
 
 		if (slot_hdr.state == SLOT_STATE_ACTIVE) {
-			uintptr_t dst_addr = logfs_get_addr (logfs, dst_arena_id, dst_slot_id);
+			uintptr_t dst_addr = logfs_get_addr (logfs, logfs->gc_arena_id, logfs->gc_dst_slot_id);
 			if (logfs_raw_copy_bytes(logfs,
 							src_addr,
 							sizeof(slot_hdr) + slot_hdr.obj_size,
 							dst_addr) != 0) {
 				/* Failed to copy all bytes */
-				return -4;
+				rc = -4;
+				goto out_abort;
 			}
-			dst_slot_id++;
+			logfs->gc_dst_slot_id++;
+			max_copies--;
 		}
+		logfs->gc_src_slot_id++;
 	}
 
-	/* Activate the destination arena */
-	if (logfs_activate_arena (logfs, dst_arena_id) != 0) {
-		return -5;
+	if (logfs->gc_src_slot_id < end_slot_id) {
+		/* More slots left to copy in a later step */
+		return 0;
 	}
 
-	/* Unmount the source arena */
-	if (logfs_unmount_log (logfs) != 0) {
-		return -6;
+	rc = logfs_switch_arena(logfs, logfs->gc_arena_id);
+	if (rc != 0) {
+		rc -= 4;
+		goto out_abort;
 	}
 
-	/* Obsolete the source arena */
-	if (logfs_obsolete_arena (logfs, src_arena_id) != 0) {
-		return -7;
-	}
+	logfs->gc_state = LOGFS_GC_IDLE;
+	return 0;
 
-	/* Mount the new arena */
-	if (logfs_mount_log (logfs, dst_arena_id) != 0) {
-		return -8;
+out_abort:
+	logfs->gc_state = LOGFS_GC_IDLE;
+	return rc;
+}
+
+/*
+ * Finish any collection in progress (or run a whole new one) in one go.
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_garbage_collect (struct logfs_state *logfs) {
+	PIOS_Assert (logfs->mounted);
+
+	if (logfs->gc_state == LOGFS_GC_IDLE)
+		logfs_gc_start(logfs);
+
+	while (logfs->gc_state != LOGFS_GC_IDLE) {
+		if (logfs_gc_step(logfs, UINT16_MAX) != 0)
+			return -1;
 	}
 
 	return 0;
@@ -672,7 +966,7 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	     slot_id++) {
 		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
 
-		if (PIOS_FLASH_read_data(logfs->partition_id,
+		if (logfs_read_data(logfs,
 						slot_addr,
 						(uint8_t *)slot_hdr,
 						sizeof (*slot_hdr)) != 0) {
@@ -695,31 +989,125 @@ static int16_t logfs_object_find_next (const struct logfs_state *logfs, struct s
 	return -1;
 }
 
+/**
+ * @brief Find the active slot holding an object instance
+ * @return 0 if found, -1 if the object is not in the log, -2 on read errors
+ * @note Must be called while holding the flash transaction lock
+ */
+static int16_t logfs_object_find (const struct logfs_state *logfs, struct slot_header *slot_hdr, uint16_t *slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (!logfs_index_usable(logfs)) {
+		*slot_id = 0;
+		return logfs_object_find_next (logfs, slot_hdr, slot_id, obj_id, obj_inst_id);
+	}
+
+	int32_t pos = logfs_index_lookup(logfs, obj_id, obj_inst_id);
+	if (pos < 0) {
+		/* Every active slot is indexed, so the object is not in the log */
+		return -1;
+	}
+
+	uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, logfs->index[pos].slot_id);
+	if (logfs_read_data(logfs,
+					slot_addr,
+					(uint8_t *)slot_hdr,
+					sizeof (*slot_hdr)) != 0) {
+		return -2;
+	}
+
+	if (slot_hdr->state != SLOT_STATE_ACTIVE ||
+		slot_hdr->obj_id      != obj_id ||
+		slot_hdr->obj_inst_id != obj_inst_id) {
+		/* Index doesn't match the flash contents!  Something is broken. */
+		PIOS_DEBUG_Assert(0);
+		return -2;
+	}
+
+	*slot_id = logfs->index[pos].slot_id;
+	return 0;
+}
+
+/* NOTE: Must be called while holding the flash transaction lock */
+static int8_t logfs_obsolete_slot (const struct logfs_state *logfs, uint8_t arena_id, uint16_t slot_id, struct slot_header *slot_hdr)
+{
+	slot_hdr->state = SLOT_STATE_OBSOLETE;
+	uintptr_t slot_addr = logfs_get_addr (logfs, arena_id, slot_id);
+
+	if (PIOS_FLASH_write_data(logfs->partition_id,
+					slot_addr,
+					(uint8_t *)slot_hdr,
+					sizeof(*slot_hdr)) != 0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/*
+ * An object was obsoleted in the active arena after garbage collection had
+ * already copied it.  Obsolete the copy too or it would come back to life
+ * once the destination arena is mounted.
+ * NOTE: Must be called while holding the flash transaction lock
+ */
+static int8_t logfs_gc_obsolete_copy (const struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	for (uint16_t slot_id = 1; slot_id < logfs->gc_dst_slot_id; slot_id++) {
+		struct slot_header slot_hdr;
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->gc_arena_id, slot_id);
+		if (logfs_read_data(logfs,
+						slot_addr,
+						(uint8_t *)&slot_hdr,
+						sizeof (slot_hdr)) != 0) {
+			return -1;
+		}
+		if (slot_hdr.state == SLOT_STATE_ACTIVE &&
+			slot_hdr.obj_id      == obj_id &&
+			slot_hdr.obj_inst_id == obj_inst_id) {
+			return logfs_obsolete_slot (logfs, logfs->gc_arena_id, slot_id, &slot_hdr);
+		}
+	}
+
+	return 0;
+}
+
 /* NOTE: Must be called while holding the flash transaction lock */
-/* OPTIMIZE: could trust that there is at most one active version of every object and terminate the search when we find one */
 static int8_t logfs_delete_object (struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id)
 {
 	int8_t rc;
 
+	/* With the index there is only ever one active version to look for */
+	bool indexed = logfs_index_usable(logfs);
+
 	bool more = true;
 	uint16_t curr_slot_id = 0;
 	do {
 		struct slot_header slot_hdr;
-		switch (logfs_object_find_next (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id)) {
+		int16_t found = indexed ?
+			logfs_object_find (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id) :
+			logfs_object_find_next (logfs, &slot_hdr, &curr_slot_id, obj_id, obj_inst_id);
+		switch (found) {
 		case 0:
 			/* Found a matching slot.  Obsolete it. */
-			slot_hdr.state = SLOT_STATE_OBSOLETE;
-			uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, curr_slot_id);
-
-			if (PIOS_FLASH_write_data(logfs->partition_id,
-							slot_addr,
-							(uint8_t *)&slot_hdr,
-							sizeof(slot_hdr)) != 0) {
+			if (logfs_obsolete_slot (logfs, logfs->active_arena_id, curr_slot_id, &slot_hdr) != 0) {
 				rc = -2;
 				goto out_exit;
 			}
 			/* Object has been successfully obsoleted and is no longer active */
 			logfs->num_active_slots--;
+			logfs_index_remove(logfs, obj_id, obj_inst_id);
+
+			if (logfs->gc_state == LOGFS_GC_COPY &&
+				curr_slot_id < logfs->gc_src_slot_id) {
+				if (logfs_gc_obsolete_copy (logfs, obj_id, obj_inst_id) != 0) {
+					rc = -3;
+					goto out_exit;
+				}
+			}
+
+			if (indexed) {
+				more = false;
+				rc = 0;
+			}
 			break;
 		case -1:
 			/* Search completed, object not found */
@@ -758,7 +1146,7 @@ static int8_t logfs_reserve_free_slot (struct logfs_state *logfs, uint16_t *slot
 
 	uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, candidate_slot_id);
 
-	if (PIOS_FLASH_read_data(logfs->partition_id,
+	if (logfs_read_data(logfs,
 					slot_addr,
 					(uint8_t *)slot_hdr,
 					sizeof (*slot_hdr)) != 0) {
@@ -832,6 +1220,95 @@ static int8_t logfs_append_to_log (struct logfs_state *logfs, uint32_t obj_id, u
 
 	/* Object has been successfully written to the slot */
 	logfs->num_active_slots++;
+	logfs_index_insert(logfs, obj_id, obj_inst_id, free_slot_id);
+	return 0;
+}
+
+/*
+ * While a batch is written the index entries of the objects it holds point
+ * at their slot in the new arena, tagged with this bit.  Remounting rebuilds
+ * the index afterwards, whichever arena ends up active.
+ */
+#define LOGFS_BATCH_SLOT 0x8000
+
+static void logfs_batch_index(struct logfs_state *logfs, uint32_t obj_id, uint16_t obj_inst_id, uint16_t slot_id)
+{
+	if (!logfs_index_usable(logfs))
+		return;
+
+	int32_t pos = logfs_index_lookup(logfs, obj_id, obj_inst_id);
+	if (pos >= 0)
+		logfs->index[pos].slot_id = slot_id | LOGFS_BATCH_SLOT;
+	else
+		logfs_index_insert(logfs, obj_id, obj_inst_id, slot_id | LOGFS_BATCH_SLOT);
+}
+
+/**
+ * @brief Find an object instance among the slots a batch has written so far
+ * @param[in] arena_id Arena the batch is written to
+ * @param[in] end_slot_id First slot past the batch
+ * @return the slot holding the object, 0 if the batch doesn't have it, -1 on read errors
+ * @note Must be called while holding the flash transaction lock
+ */
+static int32_t logfs_batch_find(const struct logfs_state *logfs, uint8_t arena_id, uint16_t end_slot_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	if (logfs_index_usable(logfs)) {
+		int32_t pos = logfs_index_lookup(logfs, obj_id, obj_inst_id);
+		if (pos < 0 || !(logfs->index[pos].slot_id & LOGFS_BATCH_SLOT))
+			return 0;
+
+		return logfs->index[pos].slot_id & ~LOGFS_BATCH_SLOT;
+	}
+
+	for (uint16_t slot_id = 1; slot_id < end_slot_id; slot_id++) {
+		struct slot_header slot_hdr;
+		if (logfs_read_data(logfs,
+						logfs_get_addr (logfs, arena_id, slot_id),
+						(uint8_t *)&slot_hdr,
+						sizeof (slot_hdr)) != 0) {
+			return -1;
+		}
+		if (slot_hdr.state == SLOT_STATE_ACTIVE &&
+			slot_hdr.obj_id      == obj_id &&
+			slot_hdr.obj_inst_id == obj_inst_id) {
+			return slot_id;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Write one object of a batch to a slot of an arena that isn't mounted
+ * @note Must be called while holding the flash transaction lock
+ */
+static int8_t logfs_batch_write(const struct logfs_state *logfs, uint8_t arena_id, uint16_t slot_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t *obj_data, uint16_t obj_size)
+{
+	uintptr_t slot_addr = logfs_get_addr (logfs, arena_id, slot_id);
+
+	if (obj_size > 0) {
+		if (PIOS_FLASH_write_data(logfs->partition_id,
+						slot_addr + sizeof(struct slot_header),
+						obj_data,
+						obj_size) != 0) {
+			return -1;
+		}
+	}
+
+	/* The arena is only reserved, so the slot can go straight to active */
+	struct slot_header slot_hdr = {
+		.state       = SLOT_STATE_ACTIVE,
+		.obj_id      = obj_id,
+		.obj_inst_id = obj_inst_id,
+		.obj_size    = obj_size,
+	};
+	if (PIOS_FLASH_write_data(logfs->partition_id,
+					slot_addr,
+					(uint8_t *)&slot_hdr,
+					sizeof(slot_hdr)) != 0) {
+		return -2;
+	}
+
 	return 0;
 }
 
@@ -964,9 +1441,9 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	}
 
 	/* Find the object in the log */
-	uint16_t slot_id = 0;
+	uint16_t slot_id;
 	struct slot_header slot_hdr;
-	if (logfs_object_find_next (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
+	if (logfs_object_find (logfs, &slot_hdr, &slot_id, obj_id, obj_inst_id) != 0) {
 		/* Object does not exist in fs */
 		rc = -3;
 		goto out_end_trans;
@@ -982,7 +1459,7 @@ int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst
 	/* Read the contents of the object from the log */
 	if (obj_size > 0) {
 		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
-		if (PIOS_FLASH_read_data(logfs->partition_id,
+		if (logfs_read_data(logfs,
 						slot_addr + sizeof(slot_hdr),
 						(uint8_t *)obj_data,
 						obj_size) != 0) {
@@ -1002,6 +1479,260 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Saves a batch of object instances to the filesystem in one go
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] next Called for each object of the batch in turn
+ * @param[in] ctx Passed on to next
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if failed to prepare the arena the batch is written to
+ * @retval -4 if an object of the batch doesn't fit in a slot
+ * @retval -5 if the batch and the objects it leaves alone don't fit in an arena
+ * @retval -6 if writing the new arena failed
+ * @retval -7 if next aborted the batch
+ * @retval -8 if switching over to the new arena failed
+ * @note The batch is written to the next arena, followed by the active
+ *       objects it doesn't replace, and activating that arena commits all of
+ *       it at once.  Until then the old arena is untouched, so an error or
+ *       losing power part way leaves every object as it was before.
+ * @note This costs one arena erase however many objects the batch holds.
+ * @note An instance that appears twice in a batch keeps the later version.
+ */
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, pios_flashfs_batch_next next, void *ctx)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	/* The batch does the work of any collection in progress and takes its arena */
+	logfs->gc_state = LOGFS_GC_IDLE;
+
+	uint8_t dst_arena_id = logfs_next_arena(logfs);
+	uint16_t num_slots = logfs->cfg->arena_size / logfs->cfg->slot_size;
+
+	if (logfs_erase_arena(logfs, dst_arena_id) != 0 ||
+		logfs_reserve_arena(logfs, dst_arena_id) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	/* Write the new versions first */
+	uint16_t dst_slot_id = 1;
+	struct pios_flashfs_obj obj;
+	int32_t more;
+	while ((more = next(ctx, &obj)) > 0) {
+		if (obj.obj_size > (logfs->cfg->slot_size - sizeof(struct slot_header))) {
+			rc = -4;
+			goto out_restore;
+		}
+
+		if (dst_slot_id >= num_slots) {
+			rc = -5;
+			goto out_restore;
+		}
+
+		int32_t prev_slot_id = logfs_batch_find(logfs, dst_arena_id, dst_slot_id, obj.obj_id, obj.obj_inst_id);
+		if (prev_slot_id < 0) {
+			rc = -6;
+			goto out_restore;
+		}
+
+		if (logfs_batch_write(logfs, dst_arena_id, dst_slot_id,
+					obj.obj_id, obj.obj_inst_id, obj.obj_data, obj.obj_size) != 0) {
+			rc = -6;
+			goto out_restore;
+		}
+
+		if (prev_slot_id > 0) {
+			struct slot_header slot_hdr;
+			if (logfs_read_data(logfs,
+							logfs_get_addr (logfs, dst_arena_id, prev_slot_id),
+							(uint8_t *)&slot_hdr,
+							sizeof (slot_hdr)) != 0 ||
+				logfs_obsolete_slot(logfs, dst_arena_id, prev_slot_id, &slot_hdr) != 0) {
+				rc = -6;
+				goto out_restore;
+			}
+		}
+
+		logfs_batch_index(logfs, obj.obj_id, obj.obj_inst_id, dst_slot_id);
+		dst_slot_id++;
+	}
+
+	if (more < 0) {
+		rc = -7;
+		goto out_restore;
+	}
+
+	/* Then copy over the active objects the batch doesn't replace */
+	uint16_t batch_end_slot_id = dst_slot_id;
+	uint16_t end_slot_id = num_slots - logfs->num_free_slots;
+	for (uint16_t src_slot_id = 1; src_slot_id < end_slot_id; src_slot_id++) {
+		struct slot_header slot_hdr;
+		uintptr_t src_addr = logfs_get_addr (logfs, logfs->active_arena_id, src_slot_id);
+		if (logfs_read_data(logfs,
+						src_addr,
+						(uint8_t *)&slot_hdr,
+						sizeof (slot_hdr)) != 0) {
+			rc = -6;
+			goto out_restore;
+		}
+
+		if (slot_hdr.state != SLOT_STATE_ACTIVE)
+			continue;
+
+		int32_t batch_slot_id = logfs_batch_find(logfs, dst_arena_id, batch_end_slot_id,
+							slot_hdr.obj_id, slot_hdr.obj_inst_id);
+		if (batch_slot_id < 0) {
+			rc = -6;
+			goto out_restore;
+		}
+		if (batch_slot_id > 0) {
+			/* Replaced by the batch */
+			continue;
+		}
+
+		if (dst_slot_id >= num_slots) {
+			rc = -5;
+			goto out_restore;
+		}
+
+		if (logfs_raw_copy_bytes(logfs,
+						src_addr,
+						sizeof(slot_hdr) + slot_hdr.obj_size,
+						logfs_get_addr (logfs, dst_arena_id, dst_slot_id)) != 0) {
+			rc = -6;
+			goto out_restore;
+		}
+		dst_slot_id++;
+	}
+
+	/* Commit */
+	if (logfs_switch_arena(logfs, dst_arena_id) != 0) {
+		rc = -8;
+		goto out_end_trans;
+	}
+
+	rc = 0;
+	goto out_end_trans;
+
+out_restore:
+	/*
+	 * The new arena stays reserved, which mounting ignores, but the index
+	 * has to be rebuilt from the old one.
+	 */
+	logfs_unmount_log(logfs);
+	logfs_mount_log(logfs, logfs->active_arena_id);
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
+/**
+ * @brief Load every object instance in the filesystem in one pass
+ * @param[in] fs_id The filesystem to use for this action
+ * @param[in] buffer Called for each object found, sets obj_data to where it
+ *            is read to or leaves it NULL to skip the object
+ * @param[in] loaded Called once an object has been read
+ * @param[in] ctx Passed on to the callbacks
+ * @return number of objects loaded or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if reading from flash fails
+ * @note The callbacks run with the flash transaction held, they must not use
+ *       the filesystem themselves.
+ */
+int32_t PIOS_FLASHFS_ObjLoadAll(uintptr_t fs_id, pios_flashfs_load_buffer buffer, pios_flashfs_load_done loaded, void *ctx)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	/* The index has the slot of every active object, without it walk the log */
+	bool indexed = logfs_index_usable(logfs);
+	uint16_t end = indexed ? logfs->index_size :
+		(logfs->cfg->arena_size / logfs->cfg->slot_size) - logfs->num_free_slots;
+
+	int32_t num_loaded = 0;
+	for (uint16_t i = indexed ? 0 : 1; i < end; i++) {
+		uint16_t slot_id = indexed ? logfs->index[i].slot_id : i;
+		if (slot_id == 0)
+			continue;
+
+		struct slot_header slot_hdr;
+		uintptr_t slot_addr = logfs_get_addr (logfs, logfs->active_arena_id, slot_id);
+		if (logfs_read_data(logfs,
+						slot_addr,
+						(uint8_t *)&slot_hdr,
+						sizeof (slot_hdr)) != 0) {
+			rc = -3;
+			goto out_end_trans;
+		}
+
+		if (slot_hdr.state != SLOT_STATE_ACTIVE)
+			continue;
+
+		struct pios_flashfs_obj obj = {
+			.obj_id      = slot_hdr.obj_id,
+			.obj_inst_id = slot_hdr.obj_inst_id,
+			.obj_size    = slot_hdr.obj_size,
+			.obj_data    = NULL,
+			.obj_mapped  = logfs->mapped ?
+				logfs->mapped + slot_addr + sizeof(slot_hdr) : NULL,
+		};
+		buffer(ctx, &obj);
+		if (obj.obj_data == NULL)
+			continue;
+
+		/* Nothing to copy when the object is used in place */
+		if (obj.obj_size > 0 && obj.obj_data != obj.obj_mapped) {
+			if (logfs_read_data(logfs,
+							slot_addr + sizeof(slot_hdr),
+							obj.obj_data,
+							obj.obj_size) != 0) {
+				rc = -3;
+				goto out_end_trans;
+			}
+		}
+
+		loaded(ctx, &obj);
+		num_loaded++;
+	}
+
+	rc = num_loaded;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
 /**
  * @brief Delete one instance of an object from the filesystem
  * @param[in] fs_id The filesystem to use for this action
@@ -1068,6 +1799,9 @@ int32_t PIOS_FLASHFS_Format(uintptr_t fs_id)
 		logfs_unmount_log(logfs);
 	}
 
+	/* Any collection in progress is moot now */
+	logfs->gc_state = LOGFS_GC_IDLE;
+
 	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
 		rc = -2;
 		goto out_exit;
@@ -1100,6 +1834,66 @@ out_exit:
 	return rc;
 }
 
+/**
+ * @brief Do a bounded amount of garbage collection in the background
+ * @param[in] fs_id The filesystem to use for this action
+ * @return 0 if success or error code
+ * @retval -1 if fs_id is not a valid filesystem instance
+ * @retval -2 if failed to start transaction
+ * @retval -3 if the garbage collection step failed
+ * @note Each call either erases the next arena or copies up to
+ *       PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP slots into it.  Calling this
+ *       periodically keeps free slots in the log so that saving an object
+ *       does not have to run a whole collection itself.
+ * @note The erase step stalls flash access for as long as a sector erase
+ *       takes, callers should avoid running this from time critical code.
+ */
+int32_t PIOS_FLASHFS_Maintenance(uintptr_t fs_id)
+{
+	int32_t rc;
+
+	struct logfs_state *logfs = (struct logfs_state *)fs_id;
+
+	if (!PIOS_FLASHFS_Logfs_validate(logfs)) {
+		rc = -1;
+		goto out_exit;
+	}
+
+	if (!logfs->mounted ||
+		(logfs->gc_state == LOGFS_GC_IDLE && !logfs_gc_wanted(logfs))) {
+		/* Nothing to do, don't bother taking the flash */
+		rc = 0;
+		goto out_exit;
+	}
+
+	if (PIOS_FLASH_start_transaction(logfs->partition_id) != 0) {
+		rc = -2;
+		goto out_exit;
+	}
+
+	/* Check again now that nobody else can be changing the log */
+	if (logfs->gc_state == LOGFS_GC_IDLE) {
+		if (!logfs_gc_wanted(logfs)) {
+			rc = 0;
+			goto out_end_trans;
+		}
+		logfs_gc_start(logfs);
+	}
+
+	if (logfs_gc_step(logfs, PIOS_FLASHFS_LOGFS_GC_SLOTS_PER_STEP) != 0) {
+		rc = -3;
+		goto out_end_trans;
+	}
+
+	rc = 0;
+
+out_end_trans:
+	PIOS_FLASH_end_transaction(logfs->partition_id);
+
+out_exit:
+	return rc;
+}
+
 /**
  * @}
  * @}
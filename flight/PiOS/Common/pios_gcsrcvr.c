@@ -56,6 +56,8 @@ struct pios_gcsrcvr_dev {
 
 	uint8_t supv_timer;
 	bool Fresh;
+	bool synced;		/* A frame arrived in the last timeout, so last_sequence holds */
+	uint8_t last_sequence;
 };
 
 static struct pios_gcsrcvr_dev *global_gcsrcvr_dev;
@@ -74,6 +76,8 @@ static struct pios_gcsrcvr_dev *PIOS_gcsrcvr_alloc(void)
 
 	gcsrcvr_dev->magic = PIOS_GCSRCVR_DEV_MAGIC;
 	gcsrcvr_dev->Fresh = false;
+	gcsrcvr_dev->synced = false;
+	gcsrcvr_dev->last_sequence = 0;
 	gcsrcvr_dev->supv_timer = 0;
 
 	/* The update callback cannot receive the device pointer, so set it in a global */
@@ -86,7 +90,20 @@ static void gcsreceiver_updated(UAVObjEvent * ev)
 {
 	struct pios_gcsrcvr_dev *gcsrcvr_dev = global_gcsrcvr_dev;
 	if (ev->obj == GCSReceiverHandle()) {
-		GCSReceiverGet(&gcsreceiverdata);
+		GCSReceiverData frame;
+		GCSReceiverGet(&frame);
+
+		/* The stream is unacked, drop duplicated and late frames. Senders
+		 * that do not count leave the sequence at zero. */
+		if (frame.Sequence != 0) {
+			if (gcsrcvr_dev->synced &&
+			    (int8_t)(frame.Sequence - gcsrcvr_dev->last_sequence) <= 0)
+				return;
+			gcsrcvr_dev->last_sequence = frame.Sequence;
+			gcsrcvr_dev->synced = true;
+		}
+
+		gcsreceiverdata = frame;
 		gcsrcvr_dev->Fresh = true;
 	}
 }
@@ -150,10 +167,14 @@ static void PIOS_gcsrcvr_Supervisor(uintptr_t gcsrcvr_id) {
 	}
 	gcsrcvr_dev->supv_timer = 0;
 
-	if (!gcsrcvr_dev->Fresh)
+	if (!gcsrcvr_dev->Fresh) {
 		for (int32_t i = 0; i < GCSRECEIVER_CHANNEL_NUMELEM; i++)
 			gcsreceiverdata.Channel[i] = PIOS_RCVR_TIMEOUT;
 
+		/* Take any sequence from a restarted sender */
+		gcsrcvr_dev->synced = false;
+	}
+
 	gcsrcvr_dev->Fresh = false;
 }
 
@@ -690,6 +690,7 @@ void PIOS_HAL_ConfigureHID(HwSharedUSB_HIDPortOptions port_type,
  * @param[in] board_rev Target board revision
  * @param[in] max_power Maximum configured output power
  * @param[in] max_speed Maximum configured speed
+ * @param[in] speed_mode Fixed at max_speed or adapted to the link up to it
  * @param[in] openlrs_cfg Configuration for radio in openlrs mode
  * @param[in] rfm22b_cfg Configuration for radio in TauLink mode
  * @param[in] min_chan Minimum channel id.
@@ -701,6 +702,7 @@ void PIOS_HAL_ConfigureRFM22B(HwSharedRadioPortOptions radio_type,
 		uint8_t board_type, uint8_t board_rev,
 		HwSharedMaxRfPowerOptions max_power,
 		HwSharedMaxRfSpeedOptions max_speed,
+		HwSharedRfSpeedModeOptions speed_mode,
 		HwSharedRfBandOptions rf_band,
 		const struct pios_openlrs_cfg *openlrs_cfg,
 		const struct pios_rfm22b_cfg *rfm22b_cfg,
@@ -785,7 +787,8 @@ void PIOS_HAL_ConfigureRFM22B(HwSharedRadioPortOptions radio_type,
 		rfm22bstatus.LinkState = RFM22BSTATUS_LINKSTATE_ENABLED;
 
 		/* Set the radio configuration parameters. */
-		PIOS_RFM22B_Config(pios_rfm22b_id, max_speed, min_chan, max_chan, coord_id, is_oneway, ppm_mode, ppm_only);
+		PIOS_RFM22B_Config(pios_rfm22b_id, max_speed, min_chan, max_chan, coord_id, is_oneway, ppm_mode, ppm_only,
+				speed_mode == HWSHARED_RFSPEEDMODE_ADAPTIVE);
 
 		// XXX TODO: Factor these power switches out.
 		/* Set the modem Tx poer level */
@@ -60,8 +60,22 @@ struct pios_heap {
 	const uintptr_t start_addr;
 	uintptr_t end_addr;
 	uintptr_t free_addr;
+	uint32_t allocations;
+	uint32_t pad_bytes;
+	uint32_t failed_allocations;
+	uint32_t largest_failed;
 };
 
+#if defined(HEAP_DIAGNOSTICS)
+/*
+ * Bytes allocated by each owner tag.  The tag is global, so an allocation
+ * made by another thread while a module is being started is charged to
+ * that module as well.
+ */
+static uint8_t heap_owner;
+static uint32_t heap_owner_bytes[PIOS_HEAP_MAX_OWNERS];
+#endif	/* HEAP_DIAGNOSTICS */
+
 static bool is_ptr_in_heap_p(const struct pios_heap *heap, void *buf)
 {
 	uintptr_t buf_addr = (uintptr_t)buf;
@@ -84,6 +98,15 @@ static void * simple_malloc(struct pios_heap *heap, size_t size)
 	if (heap->free_addr + size <= heap->end_addr) {
 		buf = (void *)heap->free_addr;
 		heap->free_addr += size + align_pad;
+		heap->allocations++;
+		heap->pad_bytes += align_pad;
+#if defined(HEAP_DIAGNOSTICS)
+		heap_owner_bytes[heap_owner] += size + align_pad;
+#endif	/* HEAP_DIAGNOSTICS */
+	} else {
+		heap->failed_allocations++;
+		if (size > heap->largest_failed)
+			heap->largest_failed = size;
 	}
 
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
@@ -111,6 +134,18 @@ static void simple_extend_heap(struct pios_heap *heap, size_t bytes)
 	heap->end_addr += bytes;
 }
 
+static void simple_get_stats(struct pios_heap *heap, struct pios_heap_stats *stats)
+{
+	stats->size = heap->end_addr - heap->start_addr;
+	stats->used = heap->free_addr - heap->start_addr;
+	if (stats->used > stats->size)
+		stats->used = stats->size;
+	stats->allocations = heap->allocations;
+	stats->pad_bytes = heap->pad_bytes;
+	stats->failed_allocations = heap->failed_allocations;
+	stats->largest_failed = heap->largest_failed;
+}
+
 /*
  * Standard heap.  All memory in this heap is DMA-safe.
  * Note: Uses underlying FreeRTOS heap when available
@@ -229,6 +264,67 @@ size_t PIOS_fastheap_get_free_size(void)
 
 #endif // PIOS_INCLUDE_FASTHEAP
 
+/**
+ * Get the usage statistics of one heap region.  Nothing is ever freed, so the
+ * used size is also the high-water mark of the region.
+ * @param[in] region the heap region
+ * @param[out] stats the statistics
+ * @return true if the region exists on this target
+ */
+bool PIOS_heap_get_stats(enum pios_heap_region region, struct pios_heap_stats *stats)
+{
+	struct pios_heap *heap;
+
+	switch (region) {
+	case PIOS_HEAP_REGION_STANDARD:
+		heap = &pios_standard_heap;
+		break;
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	case PIOS_HEAP_REGION_FAST:
+		heap = &pios_nodma_heap;
+		break;
+#endif	/* PIOS_INCLUDE_FASTHEAP */
+	default:
+		return false;
+	}
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Scheduler_Suspend();
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	simple_get_stats(heap, stats);
+
+#if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
+	PIOS_Thread_Scheduler_Resume();
+#endif	/* PIOS_INCLUDE_FREERTOS || defined(PIOS_INCLUDE_CHIBIOS) */
+
+	return true;
+}
+
+/**
+ * Charge the following allocations to an owner tag, until the tag is
+ * changed again.  Tag 0 collects everything that isn't tagged.
+ */
+void PIOS_heap_set_owner(uint8_t owner)
+{
+#if defined(HEAP_DIAGNOSTICS)
+	heap_owner = (owner < PIOS_HEAP_MAX_OWNERS) ? owner : 0;
+#endif	/* HEAP_DIAGNOSTICS */
+}
+
+/**
+ * Get the bytes allocated from all heap regions while an owner tag was set
+ */
+size_t PIOS_heap_get_owner_usage(uint8_t owner)
+{
+#if defined(HEAP_DIAGNOSTICS)
+	if (owner < PIOS_HEAP_MAX_OWNERS)
+		return heap_owner_bytes[owner];
+#endif	/* HEAP_DIAGNOSTICS */
+
+	return 0;
+}
+
 void vPortInitialiseBlocks(void) __attribute__((alias ("PIOS_heap_initialize_blocks")));
 void PIOS_heap_initialize_blocks(void)
 {
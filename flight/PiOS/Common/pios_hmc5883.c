@@ -35,13 +35,10 @@
 
 #if defined(PIOS_INCLUDE_HMC5883)
 
-#include "pios_semaphore.h"
-#include "pios_thread.h"
+#include "pios_sensor_sched.h"
 #include "pios_queue.h"
 
 /* Private constants */
-#define HMC5883_TASK_PRIORITY        PIOS_THREAD_PRIO_HIGHEST
-#define HMC5883_TASK_STACK_BYTES     512
 #define PIOS_HMC5883_MAX_DOWNSAMPLE  1
 
 /* Global Variables */
@@ -55,8 +52,8 @@ struct hmc5883_dev {
 	uint32_t i2c_id;
 	const struct pios_hmc5883_cfg *cfg;
 	struct pios_queue *queue;
-	struct pios_thread *task;
-	struct pios_semaphore *data_ready_sema;
+	int32_t sched_id;
+	bool has_irq;
 	enum pios_hmc5883_dev_magic magic;
 	enum pios_hmc5883_orientation orientation;
 };
@@ -65,7 +62,7 @@ struct hmc5883_dev {
 static int32_t PIOS_HMC5883_Config(const struct pios_hmc5883_cfg * cfg);
 static int32_t PIOS_HMC5883_Read(uint8_t address, uint8_t * buffer, uint8_t len);
 static int32_t PIOS_HMC5883_Write(uint8_t address, uint8_t buffer);
-static void PIOS_HMC5883_Task(void *parameters);
+static uint32_t PIOS_HMC5883_Step(void *ctx);
 
 static struct hmc5883_dev *dev;
 
@@ -117,17 +114,16 @@ int32_t PIOS_HMC5883_Init(uint32_t i2c_id, const struct pios_hmc5883_cfg *cfg)
 
 	dev->cfg = cfg;
 	dev->i2c_id = i2c_id;
+	dev->sched_id = -1;
 	dev->orientation = cfg->Default_Orientation;
 
 	/* check if we are using an irq line */
 	if (cfg->exti_cfg != NULL) {
 		PIOS_EXTI_Init(cfg->exti_cfg);
-
-		dev->data_ready_sema = PIOS_Semaphore_Create();
-		PIOS_Assert(dev->data_ready_sema != NULL);
+		dev->has_irq = true;
 	}
 	else {
-		dev->data_ready_sema = NULL;
+		dev->has_irq = false;
 	}
 
 	if (PIOS_HMC5883_Config(cfg) != 0)
@@ -135,9 +131,9 @@ int32_t PIOS_HMC5883_Init(uint32_t i2c_id, const struct pios_hmc5883_cfg *cfg)
 
 	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, dev->queue);
 
-	dev->task = PIOS_Thread_Create(PIOS_HMC5883_Task, "pios_hmc5883", HMC5883_TASK_STACK_BYTES, NULL, HMC5883_TASK_PRIORITY);
-
-	PIOS_Assert(dev->task != NULL);
+	dev->sched_id = PIOS_SENSOR_SCHED_Register(PIOS_HMC5883_Step, NULL, 0);
+	if (dev->sched_id < 0)
+		return -3;
 
 	return 0;
 }
@@ -472,64 +468,47 @@ bool PIOS_HMC5883_IRQHandler(void)
 	if (PIOS_HMC5883_Validate(dev) != 0)
 		return false;
 
-	bool woken = false;
-	PIOS_Semaphore_Give_FromISR(dev->data_ready_sema, &woken);
-
-	return woken;
+	return PIOS_SENSOR_SCHED_Signal_FromISR(dev->sched_id);
 }
 
 /**
- * The HMC5883 task
+ * @brief Time between samples when not woken by the data ready interrupt
  */
-static void PIOS_HMC5883_Task(void *parameters)
+static uint32_t PIOS_HMC5883_GetSampleDelay(void)
 {
-	while (PIOS_HMC5883_Validate(dev) != 0) {
-		PIOS_Thread_Sleep(100);
-	}
-
-	uint32_t sample_delay;
-
 	switch (dev->cfg->M_ODR) {
 	case PIOS_HMC5883_ODR_0_75:
-		sample_delay = 1000 / 0.75f + 0.99999f;
-		break;
+		return 1000 / 0.75f + 0.99999f;
 	case PIOS_HMC5883_ODR_1_5:
-		sample_delay = 1000 / 1.5f + 0.99999f;
-		break;
+		return 1000 / 1.5f + 0.99999f;
 	case PIOS_HMC5883_ODR_3:
-		sample_delay = 1000 / 3.0f + 0.99999f;
-		break;
+		return 1000 / 3.0f + 0.99999f;
 	case PIOS_HMC5883_ODR_7_5:
-		sample_delay = 1000 / 7.5f + 0.99999f;
-		break;
+		return 1000 / 7.5f + 0.99999f;
 	case PIOS_HMC5883_ODR_15:
-		sample_delay = 1000 / 15.0f + 0.99999f;
-		break;
+		return 1000 / 15.0f + 0.99999f;
 	case PIOS_HMC5883_ODR_30:
-		sample_delay = 1000 / 30.0f + 0.99999f;
-		break;
+		return 1000 / 30.0f + 0.99999f;
 	case PIOS_HMC5883_ODR_75:
 	default:
-		sample_delay = 1000 / 75.0f + 0.99999f;
-		break;
+		return 1000 / 75.0f + 0.99999f;
 	}
+}
 
-	uint32_t now = PIOS_Thread_Systime();
+/**
+ * Read a sample, called from the sensor thread
+ * \return ms until the next read, or wait for the next interrupt
+ */
+static uint32_t PIOS_HMC5883_Step(void *ctx)
+{
+	struct pios_sensor_mag_data mag_data;
+	if (PIOS_HMC5883_ReadMag(&mag_data) == 0)
+		PIOS_Queue_Send(dev->queue, &mag_data, 0);
 
-	while (1) {
-		if ((dev->data_ready_sema != NULL) && (dev->cfg->Mode == PIOS_HMC5883_MODE_CONTINUOUS)) {
-			if (PIOS_Semaphore_Take(dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true) {
-				PIOS_Thread_Sleep(100);
-				continue;
-			}
-		} else {
-			PIOS_Thread_Sleep_Until(&now, sample_delay);
-		}
+	if (dev->has_irq && (dev->cfg->Mode == PIOS_HMC5883_MODE_CONTINUOUS))
+		return PIOS_SENSOR_SCHED_WAIT_EVENT;
 
-		struct pios_sensor_mag_data mag_data;
-		if (PIOS_HMC5883_ReadMag(&mag_data) == 0)
-			PIOS_Queue_Send(dev->queue, &mag_data, 0);
-	}
+	return PIOS_HMC5883_GetSampleDelay();
 }
 
 #endif /* PIOS_INCLUDE_HMC5883 */
@@ -34,13 +34,10 @@
 
 #if defined(PIOS_INCLUDE_HMC5983)
 
-#include "pios_semaphore.h"
-#include "pios_thread.h"
+#include "pios_sensor_sched.h"
 #include "pios_queue.h"
 
 /* Private constants */
-#define HMC5983_TASK_PRIORITY        PIOS_THREAD_PRIO_HIGHEST
-#define HMC5983_TASK_STACK_BYTES     512
 #define PIOS_HMC5983_MAX_DOWNSAMPLE  1
 
 /* Global Variables */
@@ -55,8 +52,7 @@ struct hmc5983_dev {
 	uint32_t slave_num;
 	const struct pios_hmc5983_cfg *cfg;
 	struct pios_queue *queue;
-	struct pios_thread *task;
-	struct pios_semaphore *data_ready_sema;
+	int32_t sched_id;
 	enum pios_hmc5983_dev_magic magic;
 };
 
@@ -66,7 +62,7 @@ static int32_t PIOS_HMC5983_ClaimBus(void);
 static int32_t PIOS_HMC5983_ReleaseBus(void);
 static int32_t PIOS_HMC5983_Read(uint8_t address, uint8_t *buffer, uint8_t len);
 static int32_t PIOS_HMC5983_Write(uint8_t address, uint8_t buffer);
-static void PIOS_HMC5983_Task(void *parameters);
+static uint32_t PIOS_HMC5983_Step(void *ctx);
 
 
 static struct hmc5983_dev *dev;
@@ -88,12 +84,6 @@ static struct hmc5983_dev *PIOS_HMC5983_alloc(void) {
 		return NULL;
 	}
 
-	hmc5983_dev->data_ready_sema = PIOS_Semaphore_Create();
-	if (hmc5983_dev->data_ready_sema == NULL) {
-		PIOS_free(hmc5983_dev);
-		return NULL;
-	}
-
 	return hmc5983_dev;
 }
 
@@ -125,6 +115,7 @@ int32_t PIOS_HMC5983_Init(uint32_t spi_id, uint32_t slave_num, const struct pios
 	dev->cfg = cfg;
 	dev->spi_id = spi_id;
 	dev->slave_num = slave_num;
+	dev->sched_id = -1;
 
 #ifdef PIOS_HMC5983_HAS_GPIOS
 	PIOS_EXTI_Init(cfg->exti_cfg);
@@ -135,9 +126,9 @@ int32_t PIOS_HMC5983_Init(uint32_t spi_id, uint32_t slave_num, const struct pios
 
 	PIOS_SENSORS_Register(PIOS_SENSOR_MAG, dev->queue);
 
-	dev->task = PIOS_Thread_Create(PIOS_HMC5983_Task, "pios_hmc5983", HMC5983_TASK_STACK_BYTES, NULL, HMC5983_TASK_PRIORITY);
-
-	PIOS_Assert(dev->task != NULL);
+	dev->sched_id = PIOS_SENSOR_SCHED_Register(PIOS_HMC5983_Step, NULL, PIOS_SENSOR_SCHED_WAIT_EVENT);
+	if (dev->sched_id < 0)
+		return -3;
 
 	return 0;
 }
@@ -520,32 +511,19 @@ bool PIOS_HMC5983_IRQHandler(void)
 	if (PIOS_HMC5983_Validate(dev) != 0)
 		return false;
 
-	bool woken = false;
-	PIOS_Semaphore_Give_FromISR(dev->data_ready_sema, &woken);
-
-	return woken;
+	return PIOS_SENSOR_SCHED_Signal_FromISR(dev->sched_id);
 }
 
 /**
- * The HMC5983 task
+ * Read a sample on the data ready interrupt, called from the sensor thread
  */
-static void PIOS_HMC5983_Task(void *parameters)
+static uint32_t PIOS_HMC5983_Step(void *ctx)
 {
-	while (1) {
-		if (PIOS_HMC5983_Validate(dev) != 0) {
-			PIOS_Thread_Sleep(100);
-			continue;
-		}
-
-		if (PIOS_Semaphore_Take(dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true) {
-			PIOS_Thread_Sleep(100);
-			continue;
-		}
-
-		struct pios_sensor_mag_data mag_data;
-		if (PIOS_HMC5983_ReadMag(&mag_data) == 0)
-			PIOS_Queue_Send(dev->queue, &mag_data, 0);
-	}
+	struct pios_sensor_mag_data mag_data;
+	if (PIOS_HMC5983_ReadMag(&mag_data) == 0)
+		PIOS_Queue_Send(dev->queue, &mag_data, 0);
+
+	return PIOS_SENSOR_SCHED_WAIT_EVENT;
 }
 
 #endif /* PIOS_INCLUDE_HMC5983 */
@@ -25,6 +25,7 @@
  */
 /* Project Includes */
 #include "pios_hsum_priv.h"
+#include "pios_semaphore.h"
 
 #if defined(PIOS_INCLUDE_HSUM)
 
@@ -94,11 +95,13 @@ static uint16_t PIOS_HSUM_RxInCallback(uintptr_t context,
 				       uint16_t buf_len,
 				       uint16_t *headroom,
 				       bool *need_yield);
+static struct pios_semaphore *PIOS_HSUM_GetSemaphore(uintptr_t rcvr_id, uint8_t channel);
 static void PIOS_HSUM_Supervisor(uintptr_t hsum_id);
 
 /* Local Variables */
 const struct pios_rcvr_driver pios_hsum_rcvr_driver = {
 	.read = PIOS_HSUM_Get,
+	.get_semaphore = PIOS_HSUM_GetSemaphore,
 };
 
 enum pios_hsum_dev_magic {
@@ -121,6 +124,7 @@ struct pios_hsum_dev {
 	const struct pios_hsum_cfg *cfg;
 	enum pios_hsum_proto proto;
 	struct pios_hsum_state state;
+	struct pios_semaphore *frame_sema;
 };
 
 /* Allocate HSUM device descriptor */
@@ -267,10 +271,15 @@ stream_error:
 	return -1;
 }
 
-/* Update decoder state processing input byte from the HoTT stream */
-static void PIOS_HSUM_UpdateState(struct pios_hsum_dev *hsum_dev, uint8_t byte)
+/**
+ * Update decoder state processing input byte from the HoTT stream
+ * \return true when the byte completed a frame with good data
+ */
+static bool PIOS_HSUM_UpdateState(struct pios_hsum_dev *hsum_dev, uint8_t byte)
 {
 	struct pios_hsum_state *state = &(hsum_dev->state);
+	bool complete = false;
+
 	if (state->frame_found) {
 		/* receiving the data frame */
 		if (state->byte_count < HSUM_MAX_FRAME_LENGTH) {
@@ -282,14 +291,18 @@ static void PIOS_HSUM_UpdateState(struct pios_hsum_dev *hsum_dev, uint8_t byte)
 			}
 			if (state->byte_count == state->frame_length) {
 				/* full frame received - process and wait for new one */
-				if (!PIOS_HSUM_UnrollChannels(hsum_dev))
+				if (!PIOS_HSUM_UnrollChannels(hsum_dev)) {
 					/* data looking good */
 					state->failsafe_timer = 0;
+					complete = true;
+				}
 				/* prepare for the next frame */
 				state->frame_found = 0;
 			}
 		}
 	}
+
+	return complete;
 }
 
 /* Initialise HoTT receiver interface */
@@ -310,6 +323,10 @@ int32_t PIOS_HSUM_Init(uintptr_t *hsum_id,
 	/* Bind the configuration to the device instance */
 	hsum_dev->proto = proto;
 
+	hsum_dev->frame_sema = PIOS_Semaphore_Create();
+	if (!hsum_dev->frame_sema)
+		return -1;
+
 	PIOS_HSUM_ResetState(hsum_dev);
 
 	*hsum_id = (uintptr_t)hsum_dev;
@@ -336,9 +353,13 @@ static uint16_t PIOS_HSUM_RxInCallback(uintptr_t context,
 	bool valid = PIOS_HSUM_Validate(hsum_dev);
 	PIOS_Assert(valid);
 
+	*need_yield = false;
+
 	/* process byte(s) and clear receive timer */
 	for (uint8_t i = 0; i < buf_len; i++) {
-		PIOS_HSUM_UpdateState(hsum_dev, buf[i]);
+		/* wake whoever waits for the channels right away */
+		if (PIOS_HSUM_UpdateState(hsum_dev, buf[i]))
+			PIOS_Semaphore_Give_FromISR(hsum_dev->frame_sema, need_yield);
 		hsum_dev->state.receive_timer = 0;
 	}
 
@@ -346,9 +367,6 @@ static uint16_t PIOS_HSUM_RxInCallback(uintptr_t context,
 	if (headroom)
 		*headroom = HSUM_MAX_FRAME_LENGTH;
 
-	/* We never need a yield */
-	*need_yield = false;
-
 	/* Always indicate that all bytes were consumed */
 	return buf_len;
 }
@@ -375,6 +393,17 @@ static int32_t PIOS_HSUM_Get(uintptr_t rcvr_id, uint8_t channel)
 	return hsum_dev->state.channel_data[channel];
 }
 
+/* All channels come with the same frame */
+static struct pios_semaphore *PIOS_HSUM_GetSemaphore(uintptr_t rcvr_id, uint8_t channel)
+{
+	struct pios_hsum_dev *hsum_dev = (struct pios_hsum_dev *)rcvr_id;
+
+	if (!PIOS_HSUM_Validate(hsum_dev))
+		return NULL;
+
+	return hsum_dev->frame_sema;
+}
+
 /**
  * Input data supervisor is called periodically and provides
  * two functions: frame syncing and failsafe triggering.
@@ -37,12 +37,7 @@
 
 #include "fifo_buffer.h"
 #include "pios_queue.h"
-#include "pios_semaphore.h"
-#include "pios_thread.h"
-
-/* Private constants */
-#define L3GD20_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
-#define L3GD20_TASK_STACK		484
+#include "pios_sensor_sched.h"
 
 /* Global Variables */
 enum pios_l3gd20_dev_magic {
@@ -61,8 +56,8 @@ struct l3gd20_dev {
 	enum pios_l3gd20_range range;
 	enum pios_l3gd20_dev_magic magic;
 	volatile bool configured;
-	struct pios_thread *threadp;
-	struct pios_semaphore *data_ready_sema;
+	int32_t sched_id;
+	volatile uint32_t irq_time;
 };
 
 struct pios_l3gd20_data {
@@ -84,7 +79,7 @@ static int32_t PIOS_L3GD20_GetReg(uint8_t address);
 static int32_t PIOS_L3GD20_ClaimBus();
 static int32_t PIOS_L3GD20_ReleaseBus();
 static int32_t PIOS_L3GD20_ReadGyros(struct pios_l3gd20_data *buffer);
-static void PIOS_L3GD20_Task(void *parameters);
+static uint32_t PIOS_L3GD20_Step(void *ctx);
 
 /* Local Variables */
 
@@ -110,12 +105,7 @@ static struct l3gd20_dev *PIOS_L3GD20_alloc(void)
 		return NULL;
 	}
 
-	l3gd20_dev->data_ready_sema = PIOS_Semaphore_Create();
-
-	if (l3gd20_dev->data_ready_sema == NULL) {
-		PIOS_free(l3gd20_dev);
-		return NULL;
-	}
+	l3gd20_dev->sched_id = -1;
 
 	return l3gd20_dev;
 }
@@ -157,9 +147,9 @@ int32_t PIOS_L3GD20_Init(uint32_t spi_id, uint32_t slave_num, const struct pios_
 	if(PIOS_L3GD20_Config(cfg) != 0)
 		return -2;
 
-	pios_l3gd20_dev->threadp = PIOS_Thread_Create(
-			PIOS_L3GD20_Task, "pios_l3gd20", L3GD20_TASK_STACK, NULL, L3GD20_TASK_PRIORITY);
-	PIOS_Assert(pios_l3gd20_dev->threadp != NULL);
+	pios_l3gd20_dev->sched_id = PIOS_SENSOR_SCHED_Register(PIOS_L3GD20_Step, NULL, PIOS_SENSOR_SCHED_WAIT_EVENT);
+	if (pios_l3gd20_dev->sched_id < 0)
+		return -1;
 
 	/* Set up EXTI */
 	PIOS_EXTI_Init(cfg->exti_cfg);
@@ -414,34 +404,32 @@ bool PIOS_L3GD20_IRQHandler(void)
 	if (PIOS_L3GD20_Validate(pios_l3gd20_dev) != 0)
 		return false;
 
-	bool woken = false;
+	pios_l3gd20_dev->irq_time = PIOS_DELAY_GetRaw();
 
-	PIOS_Semaphore_Give_FromISR(pios_l3gd20_dev->data_ready_sema, &woken);
-
-	return woken;
+	return PIOS_SENSOR_SCHED_Signal_FromISR(pios_l3gd20_dev->sched_id);
 }
 
-static void PIOS_L3GD20_Task(void *parameters)
+/**
+ * Read a sample on the data ready interrupt, called from the sensor thread
+ */
+static uint32_t PIOS_L3GD20_Step(void *ctx)
 {
-	while (1) {
-		// Wait for data ready interrupt
-		if (PIOS_Semaphore_Take(pios_l3gd20_dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
-			continue;
-
-		struct pios_l3gd20_data data;
-		PIOS_L3GD20_ReadGyros(&data);
-
-		// TODO: This reordering is specific to the FlyingF3 chip placement.  Whenever
-		// this code is used on another board add an orientation mapping to the configuration
-		struct pios_sensor_gyro_data normalized_data;
-		float scale = PIOS_L3GD20_GetScale();
-		normalized_data.y = data.gyro_x * scale;
-		normalized_data.x = data.gyro_y * scale;
-		normalized_data.z = -data.gyro_z * scale;
-		normalized_data.temperature = data.temperature;
-
-		PIOS_Queue_Send(pios_l3gd20_dev->queue, (void *)&normalized_data, 0);
-	}
+	struct pios_l3gd20_data data;
+	PIOS_L3GD20_ReadGyros(&data);
+
+	// TODO: This reordering is specific to the FlyingF3 chip placement.  Whenever
+	// this code is used on another board add an orientation mapping to the configuration
+	struct pios_sensor_gyro_data normalized_data;
+	float scale = PIOS_L3GD20_GetScale();
+	normalized_data.y = data.gyro_x * scale;
+	normalized_data.x = data.gyro_y * scale;
+	normalized_data.z = -data.gyro_z * scale;
+	normalized_data.temperature = data.temperature;
+	normalized_data.sample_time = pios_l3gd20_dev->irq_time;
+
+	PIOS_Queue_Send(pios_l3gd20_dev->queue, (void *)&normalized_data, 0);
+
+	return PIOS_SENSOR_SCHED_WAIT_EVENT;
 }
 
 #endif /* PIOS_INCLUDE_L3GD20 */
@@ -60,6 +60,7 @@ struct lsm303_dev {
 	struct pios_semaphore *data_ready_sema;
 	const struct pios_lsm303_cfg *cfg;
 	enum pios_lsm303_dev_magic magic;
+	volatile uint32_t irq_time;
 };
 
 //! Internal representation of unscaled accelerometer data
@@ -600,6 +601,8 @@ bool PIOS_LSM303_IRQHandler(void)
 	if (PIOS_LSM303_Validate(pios_lsm303_dev) != 0)
 		return false;
 
+	pios_lsm303_dev->irq_time = PIOS_DELAY_GetRaw();
+
 	bool woken = false;
 
 	PIOS_Semaphore_Give_FromISR(pios_lsm303_dev->data_ready_sema, &woken);
@@ -654,6 +657,7 @@ static void PIOS_LSM303_Task(void *parameters)
 
 			normalized_data.z = -data.accel_z * accel_scale;
 			normalized_data.temperature = 0;
+			normalized_data.sample_time = pios_lsm303_dev->irq_time;
 
 			PIOS_Queue_Send(pios_lsm303_dev->queue_accel, &normalized_data, 0);
 		}
@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ * @file       pios_mempool.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Mempool Fixed size block pool
+ * @{
+ * @brief Pool of equally sized memory blocks with constant time alloc and free
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "pios_mempool.h"
+
+/**
+ * @brief Create a pool and allocate all of its blocks from the heap
+ * @param[in] block_size Size of each block in bytes
+ * @param[in] num_blocks Number of blocks in the pool
+ * @returns instance of @p struct pios_mempool or NULL on failure
+ */
+struct pios_mempool *PIOS_Mempool_Create(size_t block_size, uint16_t num_blocks)
+{
+	if (block_size == 0 || PIOS_MEMPOOL_BLOCK_SIZE(block_size) > UINT16_MAX)
+		return NULL;
+
+	struct pios_mempool *mp = PIOS_malloc_no_dma(sizeof(*mp));
+	if (mp == NULL)
+		return NULL;
+
+	PIOS_Mempool_Init(mp, block_size);
+
+	if (num_blocks > 0) {
+		void *storage = PIOS_malloc_no_dma((size_t)mp->block_size * num_blocks);
+		if (storage == NULL) {
+			PIOS_free(mp);
+			return NULL;
+		}
+
+		PIOS_Mempool_Load(mp, storage, num_blocks);
+	}
+
+	mp->min_free = mp->num_free;
+
+	return mp;
+}
+
+/**
+ * @brief Initialize an empty pool in place
+ * @param[in] mp The pool
+ * @param[in] block_size Size of each block in bytes
+ */
+void PIOS_Mempool_Init(struct pios_mempool *mp, size_t block_size)
+{
+	mp->free_list = NULL;
+	mp->block_size = PIOS_MEMPOOL_BLOCK_SIZE(block_size);
+	mp->num_free = 0;
+	mp->min_free = 0;
+}
+
+/**
+ * @brief Add an array of blocks to the pool
+ * @param[in] mp The pool
+ * @param[in] storage Pointer aligned memory holding num_blocks blocks of
+ * PIOS_MEMPOOL_BLOCK_SIZE() bytes each
+ * @param[in] num_blocks Number of blocks in storage
+ */
+void PIOS_Mempool_Load(struct pios_mempool *mp, void *storage, uint16_t num_blocks)
+{
+	uint8_t *block = storage;
+
+	for (uint16_t i = 0; i < num_blocks; i++) {
+		PIOS_Mempool_Free(mp, block);
+		block += mp->block_size;
+	}
+}
+
+/**
+ * @brief Take a block from the pool
+ * @returns pointer to the block or NULL if the pool is empty
+ * @note Safe to call from interrupt context
+ */
+void *PIOS_Mempool_Alloc(struct pios_mempool *mp)
+{
+	PIOS_IRQ_Disable();
+
+	void **block = mp->free_list;
+	if (block != NULL) {
+		mp->free_list = *block;
+		mp->num_free--;
+		if (mp->num_free < mp->min_free)
+			mp->min_free = mp->num_free;
+	}
+
+	PIOS_IRQ_Enable();
+
+	return block;
+}
+
+/**
+ * @brief Give a block back to the pool
+ * @param[in] mp The pool
+ * @param[in] block A block of the pool's size, not necessarily one that was
+ * taken from this pool. Only its first word is used while it is free.
+ * @note Safe to call from interrupt context
+ */
+void PIOS_Mempool_Free(struct pios_mempool *mp, void *block)
+{
+	if (block == NULL)
+		return;
+
+	PIOS_IRQ_Disable();
+
+	*(void **)block = mp->free_list;
+	mp->free_list = block;
+	mp->num_free++;
+
+	PIOS_IRQ_Enable();
+}
+
+/**
+ * @brief Get the number of blocks available in the pool
+ */
+uint16_t PIOS_Mempool_GetFree(const struct pios_mempool *mp)
+{
+	return mp->num_free;
+}
+
+/**
+ * @brief Get the fewest blocks that were available since the pool was
+ * created, to size pools from the board configuration
+ */
+uint16_t PIOS_Mempool_GetMinFree(const struct pios_mempool *mp)
+{
+	return mp->min_free;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -35,14 +35,11 @@
 
 #if defined(PIOS_INCLUDE_MPU6000)
 
-#include "pios_queue.h"
+#include "pios_ringbuf.h"
 #include "physical_constants.h"
-#include "pios_semaphore.h"
-#include "pios_thread.h"
+#include "pios_sensor_sched.h"
 
 /* Private constants */
-#define MPU6000_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
-#define MPU6000_TASK_STACK		484
 
 #ifdef PIOS_MPU6000_SPI_HIGH_SPEED
 #define MPU6000_SPI_HIGH_SPEED              PIOS_MPU6000_SPI_HIGH_SPEED
@@ -57,42 +54,69 @@ enum pios_mpu6000_dev_magic {
     PIOS_MPU6000_DEV_MAGIC = 0x9da9b3ed,
 };
 
-#define PIOS_MPU6000_MAX_QUEUESIZE 2
+#define PIOS_MPU6000_MAX_RINGSIZE 2
+#define PIOS_MPU6000_MAX_FIFO_BURST 16
+#define MPU6000_FIFO_SIZE 1024
+
+//! Layout of one sample, both in the data registers and in a FIFO frame
+enum {
+	IDX_ACCEL_XOUT_H = 0,
+	IDX_ACCEL_XOUT_L,
+	IDX_ACCEL_YOUT_H,
+	IDX_ACCEL_YOUT_L,
+	IDX_ACCEL_ZOUT_H,
+	IDX_ACCEL_ZOUT_L,
+	IDX_TEMP_OUT_H,
+	IDX_TEMP_OUT_L,
+	IDX_GYRO_XOUT_H,
+	IDX_GYRO_XOUT_L,
+	IDX_GYRO_YOUT_H,
+	IDX_GYRO_YOUT_L,
+	IDX_GYRO_ZOUT_H,
+	IDX_GYRO_ZOUT_L,
+	MPU6000_SAMPLE_SIZE,
+};
 
 struct mpu6000_dev {
 	uint32_t spi_id;
 	uint32_t slave_num;
 	enum pios_mpu60x0_range gyro_range;
-	struct pios_queue *gyro_queue;
+	struct pios_ringbuf *gyro_ringbuf;
 #if defined(PIOS_MPU6000_ACCEL)
 	enum pios_mpu60x0_accel_range accel_range;
-	struct pios_queue *accel_queue;
+	struct pios_ringbuf *accel_ringbuf;
 #endif /* PIOS_MPU6000_ACCEL */
 	const struct pios_mpu60x0_cfg *cfg;
 	volatile bool configured;
 	enum pios_mpu6000_dev_magic magic;
 	enum pios_mpu60x0_filter filter;
-	struct pios_thread *threadp;
-	struct pios_semaphore *data_ready_sema;
+	int32_t sched_id;
+	uint8_t fifo_burst;
+	uint8_t fifo_irq_count;
+	uint16_t fifo_frames;
+	uint8_t *fifo_buf;
+	volatile uint32_t irq_time;		//!< PIOS_DELAY_GetRaw() time of the last serviced interrupt
+	volatile uint32_t sample_period;	//!< raw time between samples, measured over the interrupts
 };
 
 //! Global structure for this device device
 static struct mpu6000_dev *pios_mpu6000_dev;
 
 //! Private functions
-static struct mpu6000_dev *PIOS_MPU6000_alloc(void);
+static struct mpu6000_dev *PIOS_MPU6000_alloc(const struct pios_mpu60x0_cfg *cfg);
 static int32_t PIOS_MPU6000_Validate(struct mpu6000_dev *dev);
 static void PIOS_MPU6000_Config(const struct pios_mpu60x0_cfg *cfg);
 static int32_t PIOS_MPU6000_ClaimBus(bool lowspeed);
 static int32_t PIOS_MPU6000_ReleaseBus(bool lowspeed);
 static int32_t PIOS_MPU6000_SetReg(uint8_t address, uint8_t buffer);
 static int32_t PIOS_MPU6000_GetReg(uint8_t address);
-static void PIOS_MPU6000_Task(void *parameters);
+static void PIOS_MPU6000_ResetFifo(void);
+static uint32_t PIOS_MPU6000_Step(void *ctx);
 
 /**
  * @brief Allocate a new device
  */
-static struct mpu6000_dev *PIOS_MPU6000_alloc(void)
+static struct mpu6000_dev *PIOS_MPU6000_alloc(const struct pios_mpu60x0_cfg *cfg)
 {
 	struct mpu6000_dev *mpu6000_dev;
 
@@ -104,29 +128,55 @@ static struct mpu6000_dev *PIOS_MPU6000_alloc(void)
 
 	mpu6000_dev->configured = false;
 
+	mpu6000_dev->fifo_burst = cfg->fifo_burst_samples;
+	if (mpu6000_dev->fifo_burst > PIOS_MPU6000_MAX_FIFO_BURST)
+		mpu6000_dev->fifo_burst = PIOS_MPU6000_MAX_FIFO_BURST;
+	mpu6000_dev->fifo_irq_count = 0;
+	mpu6000_dev->fifo_frames = 0;
+	mpu6000_dev->fifo_buf = NULL;
+
+	uint16_t ringsize = PIOS_MPU6000_MAX_RINGSIZE;
+
+	if (mpu6000_dev->fifo_burst > 1) {
+		// Leave room for a second batch in case the task woke up late
+		mpu6000_dev->fifo_frames = 2 * mpu6000_dev->fifo_burst;
+		ringsize = mpu6000_dev->fifo_frames;
+	}
+
 #if defined(PIOS_MPU6000_ACCEL)
-	mpu6000_dev->accel_queue = PIOS_Queue_Create(PIOS_MPU6000_MAX_QUEUESIZE, sizeof(struct pios_sensor_accel_data));
+	mpu6000_dev->accel_ringbuf = PIOS_Ringbuf_Create(ringsize, sizeof(struct pios_sensor_accel_data));
 
-	if (mpu6000_dev->accel_queue == NULL) {
+	if (mpu6000_dev->accel_ringbuf == NULL) {
 		PIOS_free(mpu6000_dev);
 		return NULL;
 	}
 #endif /* PIOS_MPU6000_ACCEL */
 
-	mpu6000_dev->gyro_queue = PIOS_Queue_Create(PIOS_MPU6000_MAX_QUEUESIZE, sizeof(struct pios_sensor_gyro_data));
+	mpu6000_dev->gyro_ringbuf = PIOS_Ringbuf_Create(ringsize, sizeof(struct pios_sensor_gyro_data));
 
-	if (mpu6000_dev->gyro_queue == NULL) {
+	if (mpu6000_dev->gyro_ringbuf == NULL) {
+#if defined(PIOS_MPU6000_ACCEL)
+		PIOS_Ringbuf_Delete(mpu6000_dev->accel_ringbuf);
+#endif /* PIOS_MPU6000_ACCEL */
 		PIOS_free(mpu6000_dev);
 		return NULL;
 	}
 
-	mpu6000_dev->data_ready_sema = PIOS_Semaphore_Create();
-
-	if (mpu6000_dev->data_ready_sema == NULL) {
-		PIOS_free(mpu6000_dev);
-		return NULL;
+	if (mpu6000_dev->fifo_frames > 0) {
+		// Needs to be DMA capable memory
+		mpu6000_dev->fifo_buf = PIOS_malloc(mpu6000_dev->fifo_frames * PIOS_MPU60X0_FIFO_FRAME_SIZE);
+		if (mpu6000_dev->fifo_buf == NULL) {
+#if defined(PIOS_MPU6000_ACCEL)
+			PIOS_Ringbuf_Delete(mpu6000_dev->accel_ringbuf);
+#endif /* PIOS_MPU6000_ACCEL */
+			PIOS_Ringbuf_Delete(mpu6000_dev->gyro_ringbuf);
+			PIOS_free(mpu6000_dev);
+			return NULL;
+		}
 	}
 
+	mpu6000_dev->sched_id = -1;
+
 	return mpu6000_dev;
 }
 
@@ -154,7 +204,7 @@ static int32_t PIOS_MPU6000_Validate(struct mpu6000_dev *dev)
  */
 int32_t PIOS_MPU6000_Init(uint32_t spi_id, uint32_t slave_num, const struct pios_mpu60x0_cfg *cfg)
 {
-	pios_mpu6000_dev = PIOS_MPU6000_alloc();
+	pios_mpu6000_dev = PIOS_MPU6000_alloc(cfg);
 
 	if (pios_mpu6000_dev == NULL)
 		return -1;
@@ -168,18 +218,18 @@ int32_t PIOS_MPU6000_Init(uint32_t spi_id, uint32_t slave_num, const struct pios
 	PIOS_MPU6000_Config(cfg);
 	PIOS_SPI_SetClockSpeed(pios_mpu6000_dev->spi_id, MPU6000_SPI_HIGH_SPEED);
 
-	pios_mpu6000_dev->threadp = PIOS_Thread_Create(
-			PIOS_MPU6000_Task, "pios_mpu6000", MPU6000_TASK_STACK, NULL, MPU6000_TASK_PRIORITY);
-	PIOS_Assert(pios_mpu6000_dev->threadp != NULL);
+	pios_mpu6000_dev->sched_id = PIOS_SENSOR_SCHED_Register(PIOS_MPU6000_Step, NULL, PIOS_SENSOR_SCHED_WAIT_EVENT);
+	if (pios_mpu6000_dev->sched_id < 0)
+		return -1;
 
 	/* Set up EXTI line */
 	PIOS_EXTI_Init(cfg->exti_cfg);
 
 #if defined(PIOS_MPU6000_ACCEL)
-	PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, pios_mpu6000_dev->accel_queue);
+	PIOS_SENSORS_RegisterRingbuf(PIOS_SENSOR_ACCEL, pios_mpu6000_dev->accel_ringbuf);
 #endif /* PIOS_MPU6000_ACCEL */
 
-	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, pios_mpu6000_dev->gyro_queue);
+	PIOS_SENSORS_RegisterRingbuf(PIOS_SENSOR_GYRO, pios_mpu6000_dev->gyro_ringbuf);
 
 	return 0;
 }
@@ -296,9 +346,28 @@ static void PIOS_MPU6000_Config(const struct pios_mpu60x0_cfg *cfg)
 
 #endif /* PIOS_MPU6000_SIMPLE_INIT_SEQUENCE */
 
+	if (pios_mpu6000_dev->fifo_buf != NULL) {
+		// The FIFO frame has the same layout as the data registers as long
+		// as accel, temperature and gyro are all stored
+		PIOS_MPU6000_SetReg(PIOS_MPU60X0_FIFO_EN_REG, PIOS_MPU60X0_ACCEL_OUT | PIOS_MPU60X0_FIFO_TEMP_OUT |
+			PIOS_MPU60X0_FIFO_GYRO_X_OUT | PIOS_MPU60X0_FIFO_GYRO_Y_OUT | PIOS_MPU60X0_FIFO_GYRO_Z_OUT);
+		PIOS_MPU6000_ResetFifo();
+	}
+
 	pios_mpu6000_dev->configured = true;
 }
 
+/**
+ * @brief Flush the FIFO and (re)enable it
+ */
+static void PIOS_MPU6000_ResetFifo(void)
+{
+	const struct pios_mpu60x0_cfg *cfg = pios_mpu6000_dev->cfg;
+
+	PIOS_MPU6000_SetReg(PIOS_MPU60X0_USER_CTRL_REG, cfg->User_ctl | PIOS_MPU60X0_USERCTL_FIFO_RST);
+	PIOS_MPU6000_SetReg(PIOS_MPU60X0_USER_CTRL_REG, cfg->User_ctl | PIOS_MPU60X0_USERCTL_FIFO_EN);
+}
+
 /**
  * Set the gyro range and store it locally for scaling
  */
@@ -542,190 +611,294 @@ bool PIOS_MPU6000_IRQHandler(void)
 	if (PIOS_MPU6000_Validate(pios_mpu6000_dev) != 0)
 		return false;
 
-	bool woken = false;
+	// In FIFO mode the samples pile up in the chip, only wake the task
+	// once a full batch is waiting
+	if (pios_mpu6000_dev->fifo_burst > 1) {
+		if (++pios_mpu6000_dev->fifo_irq_count < pios_mpu6000_dev->fifo_burst)
+			return false;
 
-	PIOS_Semaphore_Give_FromISR(pios_mpu6000_dev->data_ready_sema, &woken);
+		pios_mpu6000_dev->fifo_irq_count = 0;
+	}
 
-	return woken;
-}
+	uint32_t now = PIOS_DELAY_GetRaw();
+	if (pios_mpu6000_dev->irq_time != 0)
+		pios_mpu6000_dev->sample_period = (now - pios_mpu6000_dev->irq_time) /
+				((pios_mpu6000_dev->fifo_burst > 1) ? pios_mpu6000_dev->fifo_burst : 1);
+	pios_mpu6000_dev->irq_time = now;
 
-static void PIOS_MPU6000_Task(void *parameters)
-{
-	while (1) {
-		//Wait for data ready interrupt
-		if (PIOS_Semaphore_Take(pios_mpu6000_dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
-			continue;
-
-		enum {
-		    IDX_SPI_DUMMY_BYTE = 0,
-		    IDX_ACCEL_XOUT_H,
-		    IDX_ACCEL_XOUT_L,
-		    IDX_ACCEL_YOUT_H,
-		    IDX_ACCEL_YOUT_L,
-		    IDX_ACCEL_ZOUT_H,
-		    IDX_ACCEL_ZOUT_L,
-		    IDX_TEMP_OUT_H,
-		    IDX_TEMP_OUT_L,
-		    IDX_GYRO_XOUT_H,
-		    IDX_GYRO_XOUT_L,
-		    IDX_GYRO_YOUT_H,
-		    IDX_GYRO_YOUT_L,
-		    IDX_GYRO_ZOUT_H,
-		    IDX_GYRO_ZOUT_L,
-		    BUFFER_SIZE,
-		};
-
-		uint8_t mpu6000_send_buf[BUFFER_SIZE] = { PIOS_MPU60X0_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-		uint8_t mpu6000_rec_buf[BUFFER_SIZE];
-
-		// claim bus in high speed mode
-		if (PIOS_MPU6000_ClaimBus(false) != 0)
-			continue;
-
-		if (PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, mpu6000_send_buf, mpu6000_rec_buf, sizeof(mpu6000_send_buf), NULL) < 0) {
-			PIOS_MPU6000_ReleaseBus(false);
-			continue;
-		}
+	PIOS_SENSORS_SetSampleTime(PIOS_SENSOR_GYRO, now);
 
-		PIOS_MPU6000_ReleaseBus(false);
+	return PIOS_SENSOR_SCHED_Signal_FromISR(pios_mpu6000_dev->sched_id);
+}
 
-		// Rotate the sensor to OP convention.  The datasheet defines X as towards the right
-		// and Y as forward.  OP convention transposes this.  Also the Z is defined negatively
-		// to our convention
+/**
+ * @brief Decode one accel/temp/gyro frame and publish it to the ring buffers
+ * @param[in] raw sample in register order starting at ACCEL_XOUT_H, as
+ * delivered both by a data register burst and by a FIFO frame
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time the sample was taken
+ */
+static void PIOS_MPU6000_PublishSample(const uint8_t *raw, uint32_t sample_time)
+{
+	// Rotate the sensor to OP convention.  The datasheet defines X as towards the right
+	// and Y as forward.  OP convention transposes this.  Also the Z is defined negatively
+	// to our convention
 
 #if defined(PIOS_MPU6000_ACCEL)
 
-		// Currently we only support rotations on top so switch X/Y accordingly
-		struct pios_sensor_accel_data accel_data;
-		struct pios_sensor_gyro_data gyro_data;
-
-		switch (pios_mpu6000_dev->cfg->orientation) {
-		case PIOS_MPU60X0_TOP_0DEG:
-			accel_data.y = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			accel_data.x = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.z  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		case PIOS_MPU60X0_TOP_90DEG:
-			accel_data.y = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			accel_data.x = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			gyro_data.y  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.z  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		case PIOS_MPU60X0_TOP_180DEG:
-			accel_data.y = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			accel_data.x = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			gyro_data.y  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.x  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.z  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		case PIOS_MPU60X0_TOP_270DEG:
-			accel_data.y = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			accel_data.x = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.x  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.z  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		case PIOS_MPU60X0_BOTTOM_0DEG:
-			accel_data.y = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			accel_data.x = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			gyro_data.y  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.z  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		case PIOS_MPU60X0_BOTTOM_90DEG:
-			accel_data.y = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			accel_data.x = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.x  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.z  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		case PIOS_MPU60X0_BOTTOM_180DEG:
-			accel_data.y = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			accel_data.x = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.x  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.z  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		case PIOS_MPU60X0_BOTTOM_270DEG:
-			accel_data.y = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_YOUT_L]);
-			accel_data.x = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_XOUT_L]);
-			gyro_data.y  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.z  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
-			accel_data.z = (int16_t)(mpu6000_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_ACCEL_ZOUT_L]);
-			break;
-		}
+	// Currently we only support rotations on top so switch X/Y accordingly
+	// Samples are decoded straight into the ring buffer slots. If the
+	// consumer has fallen behind the sample is decoded into a scratch
+	// copy and dropped.
+	struct pios_sensor_accel_data accel_drop;
+	struct pios_sensor_gyro_data gyro_drop;
+
+	struct pios_sensor_accel_data *accel_data = PIOS_Ringbuf_WriteClaim(pios_mpu6000_dev->accel_ringbuf);
+	struct pios_sensor_gyro_data *gyro_data = PIOS_Ringbuf_WriteClaim(pios_mpu6000_dev->gyro_ringbuf);
+
+	bool accel_claimed = accel_data != NULL;
+	bool gyro_claimed = gyro_data != NULL;
+
+	if (!accel_claimed)
+		accel_data = &accel_drop;
+	if (!gyro_claimed)
+		gyro_data = &gyro_drop;
+
+	switch (pios_mpu6000_dev->cfg->orientation) {
+	case PIOS_MPU60X0_TOP_0DEG:
+		accel_data->y = (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		accel_data->x = (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		gyro_data->y  = (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->x  = (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->z  = -1.0f * (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = -1.0f * (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	case PIOS_MPU60X0_TOP_90DEG:
+		accel_data->y = -1.0f * (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		accel_data->x = (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		gyro_data->y  = -1.0f * (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->x  = (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->z  = -1.0f * (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = -1.0f * (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	case PIOS_MPU60X0_TOP_180DEG:
+		accel_data->y = -1.0f * (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		accel_data->x = -1.0f * (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		gyro_data->y  = -1.0f * (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->x  = -1.0f * (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->z  = -1.0f * (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = -1.0f * (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	case PIOS_MPU60X0_TOP_270DEG:
+		accel_data->y = (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		accel_data->x = -1.0f * (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		gyro_data->y  = (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->x  = -1.0f * (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->z  = -1.0f * (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = -1.0f * (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	case PIOS_MPU60X0_BOTTOM_0DEG:
+		accel_data->y = -1.0f * (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		accel_data->x = (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		gyro_data->y  = -1.0f * (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->x  = (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->z  = (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	case PIOS_MPU60X0_BOTTOM_90DEG:
+		accel_data->y = (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		accel_data->x = -1.0f * (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		gyro_data->y  = (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->x  = -1.0f * (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->z  = (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	case PIOS_MPU60X0_BOTTOM_180DEG:
+		accel_data->y = (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		accel_data->x = -1.0f * (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		gyro_data->y  = (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->x  = -1.0f * (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->z  = (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	case PIOS_MPU60X0_BOTTOM_270DEG:
+		accel_data->y = -1.0f * (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+		accel_data->x = (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+		gyro_data->y  = -1.0f * (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->x  = (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->z  = (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+		accel_data->z = (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+		break;
+	}
 
 
-		int16_t raw_temp = (int16_t)(mpu6000_rec_buf[IDX_TEMP_OUT_H] << 8 | mpu6000_rec_buf[IDX_TEMP_OUT_L]);
-		float temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
+	int16_t raw_temp = (int16_t)(raw[IDX_TEMP_OUT_H] << 8 | raw[IDX_TEMP_OUT_L]);
+	float temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
 
-		// Apply sensor scaling
-		float accel_scale = PIOS_MPU6000_GetAccelScale();
-		accel_data.x *= accel_scale;
-		accel_data.y *= accel_scale;
-		accel_data.z *= accel_scale;
-		accel_data.temperature = temperature;
+	// Apply sensor scaling
+	float accel_scale = PIOS_MPU6000_GetAccelScale();
+	accel_data->x *= accel_scale;
+	accel_data->y *= accel_scale;
+	accel_data->z *= accel_scale;
+	accel_data->temperature = temperature;
+	accel_data->sample_time = sample_time;
 
-		float gyro_scale = PIOS_MPU6000_GetGyroScale();
-		gyro_data.x *= gyro_scale;
-		gyro_data.y *= gyro_scale;
-		gyro_data.z *= gyro_scale;
-		gyro_data.temperature = temperature;
+	float gyro_scale = PIOS_MPU6000_GetGyroScale();
+	gyro_data->x *= gyro_scale;
+	gyro_data->y *= gyro_scale;
+	gyro_data->z *= gyro_scale;
+	gyro_data->temperature = temperature;
+	gyro_data->sample_time = sample_time;
 
-		PIOS_Queue_Send(pios_mpu6000_dev->accel_queue, &accel_data, 0);
+	if (accel_claimed)
+		PIOS_Ringbuf_WriteCommit(pios_mpu6000_dev->accel_ringbuf);
 
-		PIOS_Queue_Send(pios_mpu6000_dev->gyro_queue, &gyro_data, 0);
+	if (gyro_claimed)
+		PIOS_Ringbuf_WriteCommit(pios_mpu6000_dev->gyro_ringbuf);
 
 #else
 
-		struct pios_sensor_gyro_data gyro_data;
-
-		switch (pios_mpu6000_dev->cfg->orientation) {
-		case PIOS_MPU60X0_TOP_0DEG:
-			gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			break;
-		case PIOS_MPU60X0_TOP_90DEG:
-			gyro_data.y  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.x  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			break;
-		case PIOS_MPU60X0_TOP_180DEG:
-			gyro_data.y  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			gyro_data.x  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			break;
-		case PIOS_MPU60X0_TOP_270DEG:
-			gyro_data.y  = (int16_t)(mpu6000_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_YOUT_L]);
-			gyro_data.x  = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_XOUT_L]);
-			break;
-		}
+	struct pios_sensor_gyro_data gyro_drop;
+	struct pios_sensor_gyro_data *gyro_data = PIOS_Ringbuf_WriteClaim(pios_mpu6000_dev->gyro_ringbuf);
 
-		gyro_data.z = -1.0f * (int16_t)(mpu6000_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu6000_rec_buf[IDX_GYRO_ZOUT_L]);
+	bool gyro_claimed = gyro_data != NULL;
 
-		int32_t raw_temp = (int16_t)(mpu6000_rec_buf[IDX_TEMP_OUT_H] << 8 | mpu6000_rec_buf[IDX_TEMP_OUT_L]);
-		float temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
+	if (!gyro_claimed)
+		gyro_data = &gyro_drop;
 
-		// Apply sensor scaling
-		float gyro_scale = PIOS_MPU6000_GetGyroScale();
-		gyro_data.x *= gyro_scale;
-		gyro_data.y *= gyro_scale;
-		gyro_data.z *= gyro_scale;
-		gyro_data.temperature = temperature;
+	switch (pios_mpu6000_dev->cfg->orientation) {
+	case PIOS_MPU60X0_TOP_0DEG:
+		gyro_data->y  = (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->x  = (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		break;
+	case PIOS_MPU60X0_TOP_90DEG:
+		gyro_data->y  = -1.0f * (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->x  = (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		break;
+	case PIOS_MPU60X0_TOP_180DEG:
+		gyro_data->y  = -1.0f * (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		gyro_data->x  = -1.0f * (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		break;
+	case PIOS_MPU60X0_TOP_270DEG:
+		gyro_data->y  = (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+		gyro_data->x  = -1.0f * (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+		break;
+	}
+
+	gyro_data->z = -1.0f * (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+
+	int32_t raw_temp = (int16_t)(raw[IDX_TEMP_OUT_H] << 8 | raw[IDX_TEMP_OUT_L]);
+	float temperature = 35.0f + ((float)raw_temp + 512.0f) / 340.0f;
 
-		PIOS_Queue_Send(pios_mpu6000_dev->gyro_queue, &gyro_data, 0);
+	// Apply sensor scaling
+	float gyro_scale = PIOS_MPU6000_GetGyroScale();
+	gyro_data->x *= gyro_scale;
+	gyro_data->y *= gyro_scale;
+	gyro_data->z *= gyro_scale;
+	gyro_data->temperature = temperature;
+	gyro_data->sample_time = sample_time;
+
+	if (gyro_claimed)
+		PIOS_Ringbuf_WriteCommit(pios_mpu6000_dev->gyro_ringbuf);
 
 #endif /* PIOS_MPU6000_ACCEL */
+}
+
+/**
+ * @brief Read a single sample straight from the data registers
+ */
+static void PIOS_MPU6000_ReadSample(void)
+{
+	uint8_t mpu6000_send_buf[1 + MPU6000_SAMPLE_SIZE] = { PIOS_MPU60X0_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	uint8_t mpu6000_rec_buf[1 + MPU6000_SAMPLE_SIZE];
+
+	// claim bus in high speed mode
+	if (PIOS_MPU6000_ClaimBus(false) != 0)
+		return;
+
+	if (PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, mpu6000_send_buf, mpu6000_rec_buf, sizeof(mpu6000_send_buf), NULL) < 0) {
+		PIOS_MPU6000_ReleaseBus(false);
+		return;
 	}
+
+	PIOS_MPU6000_ReleaseBus(false);
+
+	// skip the dummy byte clocked in while sending the register address
+	PIOS_MPU6000_PublishSample(&mpu6000_rec_buf[1], pios_mpu6000_dev->irq_time);
+}
+
+/**
+ * @brief Drain the samples queued up in the FIFO with a single block transfer
+ */
+static void PIOS_MPU6000_ReadFifo(void)
+{
+	if (PIOS_MPU6000_ClaimBus(false) != 0)
+		return;
+
+	// Take the interrupt time together with the count, any frame that
+	// landed after that interrupt is already part of the count
+	uint32_t irq_time = pios_mpu6000_dev->irq_time;
+	uint32_t sample_period = pios_mpu6000_dev->sample_period;
+	uint32_t count_time = PIOS_DELAY_GetRaw();
+
+	PIOS_SPI_TransferByte(pios_mpu6000_dev->spi_id, PIOS_MPU60X0_FIFO_CNT_MSB | 0x80);
+	uint16_t fifo_count = PIOS_SPI_TransferByte(pios_mpu6000_dev->spi_id, 0) << 8;
+	fifo_count |= PIOS_SPI_TransferByte(pios_mpu6000_dev->spi_id, 0);
+
+	PIOS_MPU6000_ReleaseBus(false);
+
+	// Once the FIFO has overflowed the frame boundaries are lost, so
+	// throw everything away and start over
+	if (fifo_count > MPU6000_FIFO_SIZE - PIOS_MPU60X0_FIFO_FRAME_SIZE) {
+		PIOS_MPU6000_ResetFifo();
+		return;
+	}
+
+	// Frames past the buffer size stay queued for the next pass, but
+	// still count when working out how old the ones read now are
+	uint16_t queued = fifo_count / PIOS_MPU60X0_FIFO_FRAME_SIZE;
+	uint16_t frames = queued;
+	if (frames > pios_mpu6000_dev->fifo_frames)
+		frames = pios_mpu6000_dev->fifo_frames;
+
+	if (frames == 0)
+		return;
+
+	if (PIOS_MPU6000_ClaimBus(false) != 0)
+		return;
+
+	// Reading the FIFO register repeatedly pops consecutive bytes, so the
+	// whole batch comes in with one (DMA) block transfer
+	PIOS_SPI_TransferByte(pios_mpu6000_dev->spi_id, PIOS_MPU60X0_FIFO_REG | 0x80);
+	if (PIOS_SPI_TransferBlock(pios_mpu6000_dev->spi_id, NULL, pios_mpu6000_dev->fifo_buf,
+			frames * PIOS_MPU60X0_FIFO_FRAME_SIZE, NULL) < 0) {
+		PIOS_MPU6000_ReleaseBus(false);
+		return;
+	}
+
+	PIOS_MPU6000_ReleaseBus(false);
+
+	// The newest queued frame is the last sample period boundary after the
+	// interrupt, the older ones are one sample period apart
+	uint32_t newest_time = irq_time;
+	if (sample_period != 0)
+		newest_time += sample_period * ((count_time - irq_time) / sample_period);
+
+	for (uint16_t i = 0; i < frames; i++)
+		PIOS_MPU6000_PublishSample(&pios_mpu6000_dev->fifo_buf[i * PIOS_MPU60X0_FIFO_FRAME_SIZE],
+				newest_time - sample_period * (queued - 1 - i));
+}
+
+/**
+ * Read the samples on the data ready interrupt, called from the sensor thread
+ */
+static uint32_t PIOS_MPU6000_Step(void *ctx)
+{
+	if (pios_mpu6000_dev->fifo_buf != NULL)
+		PIOS_MPU6000_ReadFifo();
+	else
+		PIOS_MPU6000_ReadSample();
+
+	return PIOS_SENSOR_SCHED_WAIT_EVENT;
 }
 
 #endif
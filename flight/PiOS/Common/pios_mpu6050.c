@@ -66,6 +66,7 @@ struct mpu6050_dev {
 	const struct pios_mpu60x0_cfg *cfg;
 	enum pios_mpu6050_dev_magic magic;
 	enum pios_mpu60x0_filter filter;
+	volatile uint32_t irq_time;
 };
 
 //! Global structure for this device device
@@ -584,6 +585,8 @@ bool PIOS_MPU6050_IRQHandler(void)
 	if (PIOS_MPU6050_Validate(pios_mpu6050_dev) != 0)
 		return false;
 
+	pios_mpu6050_dev->irq_time = PIOS_DELAY_GetRaw();
+
 	bool woken = false;
 
 	PIOS_Semaphore_Give_FromISR(pios_mpu6050_dev->data_ready_sema, &woken);
@@ -709,12 +712,14 @@ static void PIOS_MPU6050_Task(void *parameters)
 		accel_data.y *= accel_scale;
 		accel_data.z *= accel_scale;
 		accel_data.temperature = temperature;
+		accel_data.sample_time = pios_mpu6050_dev->irq_time;
 
 		float gyro_scale = PIOS_MPU6050_GetGyroScale();
 		gyro_data.x *= gyro_scale;
 		gyro_data.y *= gyro_scale;
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
+		gyro_data.sample_time = pios_mpu6050_dev->irq_time;
 
 		PIOS_Queue_Send(pios_mpu6050_dev->accel_queue, &accel_data, 0);
 
@@ -776,6 +781,7 @@ static void PIOS_MPU6050_Task(void *parameters)
 		gyro_data.y *= gyro_scale;
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
+		gyro_data.sample_time = pios_mpu6050_dev->irq_time;
 
 		PIOS_Queue_Send(pios_mpu6050_dev->gyro_queue, &gyro_data, 0);
 
@@ -76,6 +76,7 @@ struct mpu9150_dev {
 	const struct pios_mpu60x0_cfg * cfg;
 	enum pios_mpu60x0_filter filter;
 	enum pios_mpu9150_dev_magic magic;
+	volatile uint32_t irq_time;
 };
 
 //! Global structure for this device device
@@ -628,6 +629,8 @@ bool PIOS_MPU9150_IRQHandler(void)
 	if (PIOS_MPU9150_Validate(dev) != 0)
 		return false;
 
+	dev->irq_time = PIOS_DELAY_GetRaw();
+
 	bool woken = false;
 
 	PIOS_Semaphore_Give_FromISR(dev->data_ready_sema, &woken);
@@ -752,12 +755,14 @@ static void PIOS_MPU9150_Task(void *parameters)
 		accel_data.y *= accel_scale;
 		accel_data.z *= accel_scale;
 		accel_data.temperature = temperature;
+		accel_data.sample_time = dev->irq_time;
 
 		float gyro_scale = PIOS_MPU9150_GetGyroScale();
 		gyro_data.x *= gyro_scale;
 		gyro_data.y *= gyro_scale;
 		gyro_data.z *= gyro_scale;
 		gyro_data.temperature = temperature;
+		gyro_data.sample_time = dev->irq_time;
 
 		PIOS_Queue_Send(dev->accel_queue, &accel_data, 0);
 		PIOS_Queue_Send(dev->gyro_queue, &gyro_data, 0);
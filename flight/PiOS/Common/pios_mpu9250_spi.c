@@ -38,7 +38,7 @@
 #include "pios_mpu9250.h"
 #include "pios_semaphore.h"
 #include "pios_thread.h"
-#include "pios_queue.h"
+#include "pios_ringbuf.h"
 
 /* Private constants */
 #define MPU9250_TASK_PRIORITY    PIOS_THREAD_PRIO_HIGHEST
@@ -70,6 +70,42 @@
 #define AK8963_CNTL2_SRST                   0x01
 #define AK8963_MODE_CONTINUOUS_FAST_16B     0x16
 
+#define MPU9250_EXT_SENS_DATA_00_REG        0x49
+#define MPU9250_FIFO_SIZE                   512
+#define PIOS_MPU9250_MAX_FIFO_BURST         16
+
+//! Layout of one sample, both in the data registers and in a FIFO frame
+enum {
+	IDX_ACCEL_XOUT_H = 0,
+	IDX_ACCEL_XOUT_L,
+	IDX_ACCEL_YOUT_H,
+	IDX_ACCEL_YOUT_L,
+	IDX_ACCEL_ZOUT_H,
+	IDX_ACCEL_ZOUT_L,
+	IDX_TEMP_OUT_H,
+	IDX_TEMP_OUT_L,
+	IDX_GYRO_XOUT_H,
+	IDX_GYRO_XOUT_L,
+	IDX_GYRO_YOUT_H,
+	IDX_GYRO_YOUT_L,
+	IDX_GYRO_ZOUT_H,
+	IDX_GYRO_ZOUT_L,
+	MPU9250_SAMPLE_SIZE,
+};
+
+//! Layout of the AK8963 data mirrored into the external sensor registers
+enum {
+	IDX_MAG_ST1 = 0,
+	IDX_MAG_XOUT_L,
+	IDX_MAG_XOUT_H,
+	IDX_MAG_YOUT_L,
+	IDX_MAG_YOUT_H,
+	IDX_MAG_ZOUT_L,
+	IDX_MAG_ZOUT_H,
+	IDX_MAG_ST2,
+	MPU9250_MAG_SIZE,
+};
+
 /* Global Variables */
 
 enum pios_mpu9250_dev_magic {
@@ -81,15 +117,22 @@ struct mpu9250_dev {
 	uint32_t slave_num;
 	enum pios_mpu60x0_accel_range accel_range;
 	enum pios_mpu60x0_range gyro_range;
-	struct pios_queue *gyro_queue;
-	struct pios_queue *accel_queue;
-	struct pios_queue *mag_queue;
+	struct pios_ringbuf *gyro_ringbuf;
+	struct pios_ringbuf *accel_ringbuf;
+	struct pios_ringbuf *mag_ringbuf;
 	struct pios_thread *TaskHandle;
 	struct pios_semaphore *data_ready_sema;
 	const struct pios_mpu9250_cfg *cfg;
 	enum pios_mpu9250_gyro_filter gyro_filter;
 	enum pios_mpu9250_accel_filter accel_filter;
 	enum pios_mpu9250_dev_magic magic;
+	uint8_t fifo_burst;
+	volatile uint8_t irq_divider;
+	uint8_t irq_count;
+	uint16_t fifo_frames;
+	uint8_t *fifo_buf;
+	volatile uint32_t irq_time;		//!< PIOS_DELAY_GetRaw() time of the last serviced interrupt
+	volatile uint32_t sample_period;	//!< raw time between samples, measured over the interrupts
 };
 
 //! Global structure for this device device
@@ -103,6 +146,7 @@ static uint8_t PIOS_MPU9250_ReadReg(uint8_t reg);
 static int32_t PIOS_MPU9250_WriteReg(uint8_t reg, uint8_t data);
 static int32_t PIOS_MPU9250_ClaimBus(bool lowspeed);
 static int32_t PIOS_MPU9250_ReleaseBus(bool lowspeed);
+static void PIOS_MPU9250_ResetFifo(void);
 
 /**
  * @brief Allocate a new device
@@ -117,24 +161,53 @@ static struct mpu9250_dev *PIOS_MPU9250_alloc(const struct pios_mpu9250_cfg *cfg
 
 	mpu9250_dev->magic = PIOS_MPU9250_DEV_MAGIC;
 
-	mpu9250_dev->accel_queue = PIOS_Queue_Create(PIOS_MPU9250_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_accel_data));
-	if (mpu9250_dev->accel_queue == NULL) {
+	mpu9250_dev->fifo_burst = cfg->fifo_burst_samples;
+	if (mpu9250_dev->fifo_burst > PIOS_MPU9250_MAX_FIFO_BURST)
+		mpu9250_dev->fifo_burst = PIOS_MPU9250_MAX_FIFO_BURST;
+	mpu9250_dev->irq_divider = 1;
+	mpu9250_dev->irq_count = 0;
+	mpu9250_dev->fifo_frames = 0;
+	mpu9250_dev->fifo_buf = NULL;
+
+	uint16_t ringsize = PIOS_MPU9250_MAX_DOWNSAMPLE;
+
+	if (mpu9250_dev->fifo_burst > 1) {
+		// Leave room for a second batch in case the task woke up late
+		mpu9250_dev->fifo_frames = 2 * mpu9250_dev->fifo_burst;
+		ringsize = mpu9250_dev->fifo_frames;
+	}
+
+	mpu9250_dev->accel_ringbuf = PIOS_Ringbuf_Create(ringsize, sizeof(struct pios_sensor_accel_data));
+	if (mpu9250_dev->accel_ringbuf == NULL) {
 		PIOS_free(mpu9250_dev);
 		return NULL;
 	}
 
-	mpu9250_dev->gyro_queue = PIOS_Queue_Create(PIOS_MPU9250_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_gyro_data));
-	if (mpu9250_dev->gyro_queue == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
+	mpu9250_dev->gyro_ringbuf = PIOS_Ringbuf_Create(ringsize, sizeof(struct pios_sensor_gyro_data));
+	if (mpu9250_dev->gyro_ringbuf == NULL) {
+		PIOS_Ringbuf_Delete(mpu9250_dev->accel_ringbuf);
 		PIOS_free(mpu9250_dev);
 		return NULL;
 	}
 
 	if (cfg->use_magnetometer) {
-		mpu9250_dev->mag_queue = PIOS_Queue_Create(PIOS_MPU9250_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_mag_data));
-		if (mpu9250_dev->mag_queue == NULL) {
-			PIOS_Queue_Delete(dev->accel_queue);
-			PIOS_Queue_Delete(dev->gyro_queue);
+		mpu9250_dev->mag_ringbuf = PIOS_Ringbuf_Create(PIOS_MPU9250_MAX_DOWNSAMPLE, sizeof(struct pios_sensor_mag_data));
+		if (mpu9250_dev->mag_ringbuf == NULL) {
+			PIOS_Ringbuf_Delete(mpu9250_dev->accel_ringbuf);
+			PIOS_Ringbuf_Delete(mpu9250_dev->gyro_ringbuf);
+			PIOS_free(mpu9250_dev);
+			return NULL;
+		}
+	}
+
+	if (mpu9250_dev->fifo_frames > 0) {
+		// Needs to be DMA capable memory
+		mpu9250_dev->fifo_buf = PIOS_malloc(mpu9250_dev->fifo_frames * PIOS_MPU60X0_FIFO_FRAME_SIZE);
+		if (mpu9250_dev->fifo_buf == NULL) {
+			PIOS_Ringbuf_Delete(mpu9250_dev->accel_ringbuf);
+			PIOS_Ringbuf_Delete(mpu9250_dev->gyro_ringbuf);
+			if (cfg->use_magnetometer)
+				PIOS_Ringbuf_Delete(mpu9250_dev->mag_ringbuf);
 			PIOS_free(mpu9250_dev);
 			return NULL;
 		}
@@ -142,10 +215,12 @@ static struct mpu9250_dev *PIOS_MPU9250_alloc(const struct pios_mpu9250_cfg *cfg
 
 	mpu9250_dev->data_ready_sema = PIOS_Semaphore_Create();
 	if (mpu9250_dev->data_ready_sema == NULL) {
-		PIOS_Queue_Delete(dev->accel_queue);
-		PIOS_Queue_Delete(dev->gyro_queue);
+		PIOS_Ringbuf_Delete(mpu9250_dev->accel_ringbuf);
+		PIOS_Ringbuf_Delete(mpu9250_dev->gyro_ringbuf);
 		if (cfg->use_magnetometer)
-			PIOS_Queue_Delete(dev->mag_queue);
+			PIOS_Ringbuf_Delete(mpu9250_dev->mag_ringbuf);
+		if (mpu9250_dev->fifo_buf != NULL)
+			PIOS_free(mpu9250_dev->fifo_buf);
 		PIOS_free(mpu9250_dev);
 		return NULL;
 	}
@@ -386,9 +461,28 @@ static int32_t PIOS_MPU9250_Config(struct pios_mpu9250_cfg const *cfg)
 	// Interrupt enable
 	PIOS_MPU9250_WriteReg(PIOS_MPU60X0_INT_EN_REG, PIOS_MPU60X0_INTEN_DATA_RDY);
 
+	if (dev->fifo_buf != NULL) {
+		// The FIFO frame has the same layout as the data registers as long
+		// as accel, temperature and gyro are all stored
+		PIOS_MPU9250_WriteReg(PIOS_MPU60X0_FIFO_EN_REG, PIOS_MPU60X0_ACCEL_OUT | PIOS_MPU60X0_FIFO_TEMP_OUT |
+			PIOS_MPU60X0_FIFO_GYRO_X_OUT | PIOS_MPU60X0_FIFO_GYRO_Y_OUT | PIOS_MPU60X0_FIFO_GYRO_Z_OUT);
+		PIOS_MPU9250_ResetFifo();
+	}
+
 	return 0;
 }
 
+/**
+ * @brief Flush the FIFO and (re)enable it
+ */
+static void PIOS_MPU9250_ResetFifo(void)
+{
+	uint8_t user_ctl = PIOS_MPU60X0_USERCTL_DIS_I2C | PIOS_MPU60X0_USERCTL_I2C_MST_EN;
+
+	PIOS_MPU9250_WriteReg(PIOS_MPU60X0_USER_CTRL_REG, user_ctl | PIOS_MPU60X0_USERCTL_FIFO_RST);
+	PIOS_MPU9250_WriteReg(PIOS_MPU60X0_USER_CTRL_REG, user_ctl | PIOS_MPU60X0_USERCTL_FIFO_EN);
+}
+
 /**
  * @brief Initialize the MPU9250 9-axis sensor.
  * @return 0 for success, -1 for failure to allocate, -10 for failure to get irq
@@ -417,15 +511,19 @@ int32_t PIOS_MPU9250_SPI_Init(uint32_t spi_id, uint32_t slave_num, const struct
 		return -10;
 	}
 
+	// From now on only wake the task once a full batch is in the FIFO
+	if (dev->fifo_buf != NULL)
+		dev->irq_divider = dev->fifo_burst;
+
 	dev->TaskHandle = PIOS_Thread_Create(
 			PIOS_MPU9250_Task, "pios_mpu9250", MPU9250_TASK_STACK_BYTES, NULL, MPU9250_TASK_PRIORITY);
 	PIOS_Assert(dev->TaskHandle != NULL);
 
-	PIOS_SENSORS_Register(PIOS_SENSOR_ACCEL, dev->accel_queue);
-	PIOS_SENSORS_Register(PIOS_SENSOR_GYRO, dev->gyro_queue);
+	PIOS_SENSORS_RegisterRingbuf(PIOS_SENSOR_ACCEL, dev->accel_ringbuf);
+	PIOS_SENSORS_RegisterRingbuf(PIOS_SENSOR_GYRO, dev->gyro_ringbuf);
 
 	if (dev->cfg->use_magnetometer)
-		PIOS_SENSORS_Register(PIOS_SENSOR_MAG, dev->mag_queue);
+		PIOS_SENSORS_RegisterRingbuf(PIOS_SENSOR_MAG, dev->mag_ringbuf);
 
 	return 0;
 }
@@ -594,202 +692,317 @@ bool PIOS_MPU9250_IRQHandler(void)
 
 	bool need_yield = false;
 
+	if (++dev->irq_count < dev->irq_divider)
+		return false;
+
+	dev->irq_count = 0;
+
+	uint32_t now = PIOS_DELAY_GetRaw();
+	if (dev->irq_time != 0)
+		dev->sample_period = (now - dev->irq_time) / dev->irq_divider;
+	dev->irq_time = now;
+
+	PIOS_SENSORS_SetSampleTime(PIOS_SENSOR_GYRO, now);
+
 	PIOS_Semaphore_Give_FromISR(dev->data_ready_sema, &need_yield);
 
 	return need_yield;
 }
 
-static void PIOS_MPU9250_Task(void *parameters)
+/**
+ * @brief Decode one sample and publish it to the ring buffers
+ * @param[in] raw accel/temp/gyro in register order starting at ACCEL_XOUT_H,
+ * as delivered both by a data register burst and by a FIFO frame
+ * @param[in] mag AK8963 data starting at ST1 or NULL to skip the magnetometer
+ * @param[in] sample_time PIOS_DELAY_GetRaw() time the sample was taken
+ */
+static void PIOS_MPU9250_PublishSample(const uint8_t *raw, const uint8_t *mag, uint32_t sample_time)
 {
-	while (1) {
-		//Wait for data ready interrupt
-		if (PIOS_Semaphore_Take(dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
-			continue;
+	// Samples are decoded straight into the ring buffer slots. If the
+	// consumer has fallen behind the sample is decoded into a scratch
+	// copy and dropped.
+	struct pios_sensor_accel_data accel_drop;
+	struct pios_sensor_gyro_data gyro_drop;
+	struct pios_sensor_mag_data mag_drop;
+
+	struct pios_sensor_accel_data *accel_data = PIOS_Ringbuf_WriteClaim(dev->accel_ringbuf);
+	struct pios_sensor_gyro_data *gyro_data = PIOS_Ringbuf_WriteClaim(dev->gyro_ringbuf);
+	struct pios_sensor_mag_data *mag_data = NULL;
+
+	if (mag != NULL)
+		mag_data = PIOS_Ringbuf_WriteClaim(dev->mag_ringbuf);
+
+	bool accel_claimed = accel_data != NULL;
+	bool gyro_claimed = gyro_data != NULL;
+	bool mag_claimed = mag_data != NULL;
+
+	if (!accel_claimed)
+		accel_data = &accel_drop;
+	if (!gyro_claimed)
+		gyro_data = &gyro_drop;
+	if (!mag_claimed)
+		mag_data = &mag_drop;
+
+	float accel_x = (int16_t)(raw[IDX_ACCEL_XOUT_H] << 8 | raw[IDX_ACCEL_XOUT_L]);
+	float accel_y = (int16_t)(raw[IDX_ACCEL_YOUT_H] << 8 | raw[IDX_ACCEL_YOUT_L]);
+	float accel_z = (int16_t)(raw[IDX_ACCEL_ZOUT_H] << 8 | raw[IDX_ACCEL_ZOUT_L]);
+	float gyro_x = (int16_t)(raw[IDX_GYRO_XOUT_H] << 8 | raw[IDX_GYRO_XOUT_L]);
+	float gyro_y = (int16_t)(raw[IDX_GYRO_YOUT_H] << 8 | raw[IDX_GYRO_YOUT_L]);
+	float gyro_z = (int16_t)(raw[IDX_GYRO_ZOUT_H] << 8 | raw[IDX_GYRO_ZOUT_L]);
+	float mag_x = 0, mag_y = 0, mag_z = 0;
+	if (mag != NULL) {
+		mag_x = (int16_t)(mag[IDX_MAG_XOUT_H] << 8 | mag[IDX_MAG_XOUT_L]);
+		mag_y = (int16_t)(mag[IDX_MAG_YOUT_H] << 8 | mag[IDX_MAG_YOUT_L]);
+		mag_z = (int16_t)(mag[IDX_MAG_ZOUT_H] << 8 | mag[IDX_MAG_ZOUT_L]);
+	}
 
-		enum {
-			IDX_REG = 0,
-			IDX_ACCEL_XOUT_H,
-			IDX_ACCEL_XOUT_L,
-			IDX_ACCEL_YOUT_H,
-			IDX_ACCEL_YOUT_L,
-			IDX_ACCEL_ZOUT_H,
-			IDX_ACCEL_ZOUT_L,
-			IDX_TEMP_OUT_H,
-			IDX_TEMP_OUT_L,
-			IDX_GYRO_XOUT_H,
-			IDX_GYRO_XOUT_L,
-			IDX_GYRO_YOUT_H,
-			IDX_GYRO_YOUT_L,
-			IDX_GYRO_ZOUT_H,
-			IDX_GYRO_ZOUT_L,
-			IDX_MAG_ST1,
-			IDX_MAG_XOUT_L,
-			IDX_MAG_XOUT_H,
-			IDX_MAG_YOUT_L,
-			IDX_MAG_YOUT_H,
-			IDX_MAG_ZOUT_L,
-			IDX_MAG_ZOUT_H,
-			IDX_MAG_ST2,
-			BUFFER_SIZE,
-		};
-
-		uint8_t mpu9250_rec_buf[BUFFER_SIZE];
-		uint8_t mpu9250_tx_buf[BUFFER_SIZE] = {PIOS_MPU60X0_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0,
-				0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
-
-		uint8_t transfer_size = (dev->cfg->use_magnetometer) ? BUFFER_SIZE : BUFFER_SIZE - 8;
-		// claim bus in high speed mode
-		if (PIOS_MPU9250_ClaimBus(false) != 0)
-			continue;
+	// Rotate the sensor to TL convention.  The datasheet defines X as towards the right
+	// and Y as forward. TL convention transposes this.  Also the Z is defined negatively
+	// to our convention. This is true for accels and gyros. Magnetometer corresponds TL convention.
+	switch (dev->cfg->orientation) {
+	case PIOS_MPU9250_TOP_0DEG:
+		accel_data->y = accel_x;
+		accel_data->x = accel_y;
+		accel_data->z = -accel_z;
+		gyro_data->y  = gyro_x;
+		gyro_data->x  = gyro_y;
+		gyro_data->z  = -gyro_z;
+		mag_data->x   = mag_x;
+		mag_data->y   = mag_y;
+		mag_data->z   = mag_z;
+		break;
+	case PIOS_MPU9250_TOP_90DEG:
+		accel_data->y = -accel_y;
+		accel_data->x = accel_x;
+		accel_data->z = -accel_z;
+		gyro_data->y  = -gyro_y;
+		gyro_data->x  = gyro_x;
+		gyro_data->z  = -gyro_z;
+		mag_data->x   = -mag_y;
+		mag_data->y   = mag_x;
+		mag_data->z   = mag_z;
+		break;
+	case PIOS_MPU9250_TOP_180DEG:
+		accel_data->y = -accel_x;
+		accel_data->x = -accel_y;
+		accel_data->z = -accel_z;
+		gyro_data->y  = -gyro_x;
+		gyro_data->x  = -gyro_y;
+		gyro_data->z  = -gyro_z;
+		mag_data->x   = -mag_x;
+		mag_data->y   = -mag_y;
+		mag_data->z   = mag_z;
 
-		if (PIOS_SPI_TransferBlock(dev->spi_id, mpu9250_tx_buf, mpu9250_rec_buf, transfer_size, 0) < 0) {
-			PIOS_MPU9250_ReleaseBus(false);
-			continue;
+		break;
+	case PIOS_MPU9250_TOP_270DEG:
+		accel_data->y = accel_y;
+		accel_data->x = -accel_x;
+		accel_data->z = -accel_z;
+		gyro_data->y  = gyro_y;
+		gyro_data->x  = -gyro_x;
+		gyro_data->z  = -gyro_z;
+		mag_data->x   = mag_y;
+		mag_data->y   = -mag_x;
+		mag_data->z   = mag_z;
+		break;
+	case PIOS_MPU9250_BOTTOM_0DEG:
+		accel_data->y = -accel_x;
+		accel_data->x = accel_y;
+		accel_data->z = accel_z;
+		gyro_data->y  = -gyro_x;
+		gyro_data->x  = gyro_y;
+		gyro_data->z  = gyro_z;
+		mag_data->x   = mag_x;
+		mag_data->y   = -mag_y;
+		mag_data->z   = -mag_z;
+		break;
+
+	case PIOS_MPU9250_BOTTOM_90DEG:
+		accel_data->y = -accel_y;
+		accel_data->x = -accel_x;
+		accel_data->z = accel_z;
+		gyro_data->y  = -gyro_y;
+		gyro_data->x  = -gyro_x;
+		gyro_data->z  = gyro_z;
+		mag_data->x   = -mag_y;
+		mag_data->y   = -mag_x;
+		mag_data->z   = -mag_z;
+		break;
+
+	case PIOS_MPU9250_BOTTOM_180DEG:
+		accel_data->y = accel_x;
+		accel_data->x = -accel_y;
+		accel_data->z = accel_z;
+		gyro_data->y  = gyro_x;
+		gyro_data->x  = -gyro_y;
+		gyro_data->z  = gyro_z;
+		mag_data->x   = -mag_x;
+		mag_data->y   = mag_y;
+		mag_data->z   = -mag_z;
+		break;
+
+	case PIOS_MPU9250_BOTTOM_270DEG:
+		accel_data->y = accel_y;
+		accel_data->x = accel_x;
+		gyro_data->y  = gyro_y;
+		gyro_data->x  = gyro_x;
+		gyro_data->z  = gyro_z;
+		accel_data->z = accel_z;
+		mag_data->x   = mag_y;
+		mag_data->y   = mag_x;
+		mag_data->z   = -mag_z;
+		break;
+
+	}
+
+	int16_t raw_temp = (int16_t)(raw[IDX_TEMP_OUT_H] << 8 | raw[IDX_TEMP_OUT_L]);
+	float temperature = 21.0f + ((float)raw_temp) / 333.87f;
+
+	// Apply sensor scaling
+	float accel_scale = PIOS_MPU9250_GetAccelScale();
+	accel_data->x *= accel_scale;
+	accel_data->y *= accel_scale;
+	accel_data->z *= accel_scale;
+	accel_data->temperature = temperature;
+	accel_data->sample_time = sample_time;
+
+	float gyro_scale = PIOS_MPU9250_GetGyroScale();
+	gyro_data->x *= gyro_scale;
+	gyro_data->y *= gyro_scale;
+	gyro_data->z *= gyro_scale;
+	gyro_data->temperature = temperature;
+	gyro_data->sample_time = sample_time;
+
+	if (accel_claimed)
+		PIOS_Ringbuf_WriteCommit(dev->accel_ringbuf);
+	if (gyro_claimed)
+		PIOS_Ringbuf_WriteCommit(dev->gyro_ringbuf);
+
+	if (mag != NULL) {
+		uint8_t st1 = mag[IDX_MAG_ST1];
+		if (st1 & AK8963_ST1_DRDY) {
+			mag_data->x *= 1.5f;
+			mag_data->y *= 1.5f;
+			mag_data->z *= 1.5f;
+			if (mag_claimed)
+				PIOS_Ringbuf_WriteCommit(dev->mag_ringbuf);
 		}
+	}
+}
+
+/**
+ * @brief Read a single sample straight from the data registers
+ */
+static void PIOS_MPU9250_ReadSample(void)
+{
+	uint8_t mpu9250_rec_buf[1 + MPU9250_SAMPLE_SIZE + MPU9250_MAG_SIZE];
+	uint8_t mpu9250_tx_buf[1 + MPU9250_SAMPLE_SIZE + MPU9250_MAG_SIZE] = {PIOS_MPU60X0_ACCEL_X_OUT_MSB | 0x80, 0, 0, 0, 0, 0,
+			0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+	uint8_t transfer_size = (dev->cfg->use_magnetometer) ? sizeof(mpu9250_tx_buf) : sizeof(mpu9250_tx_buf) - MPU9250_MAG_SIZE;
+	// claim bus in high speed mode
+	if (PIOS_MPU9250_ClaimBus(false) != 0)
+		return;
 
+	if (PIOS_SPI_TransferBlock(dev->spi_id, mpu9250_tx_buf, mpu9250_rec_buf, transfer_size, 0) < 0) {
 		PIOS_MPU9250_ReleaseBus(false);
+		return;
+	}
 
-		struct pios_sensor_accel_data accel_data;
-		struct pios_sensor_gyro_data gyro_data;
-		struct pios_sensor_mag_data mag_data;
-
-		float accel_x = (int16_t)(mpu9250_rec_buf[IDX_ACCEL_XOUT_H] << 8 | mpu9250_rec_buf[IDX_ACCEL_XOUT_L]);
-		float accel_y = (int16_t)(mpu9250_rec_buf[IDX_ACCEL_YOUT_H] << 8 | mpu9250_rec_buf[IDX_ACCEL_YOUT_L]);
-		float accel_z = (int16_t)(mpu9250_rec_buf[IDX_ACCEL_ZOUT_H] << 8 | mpu9250_rec_buf[IDX_ACCEL_ZOUT_L]);
-		float gyro_x = (int16_t)(mpu9250_rec_buf[IDX_GYRO_XOUT_H] << 8 | mpu9250_rec_buf[IDX_GYRO_XOUT_L]);
-		float gyro_y = (int16_t)(mpu9250_rec_buf[IDX_GYRO_YOUT_H] << 8 | mpu9250_rec_buf[IDX_GYRO_YOUT_L]);
-		float gyro_z = (int16_t)(mpu9250_rec_buf[IDX_GYRO_ZOUT_H] << 8 | mpu9250_rec_buf[IDX_GYRO_ZOUT_L]);
-		float mag_x = (int16_t)(mpu9250_rec_buf[IDX_MAG_XOUT_H] << 8 | mpu9250_rec_buf[IDX_MAG_XOUT_L]);
-		float mag_y = (int16_t)(mpu9250_rec_buf[IDX_MAG_YOUT_H] << 8 | mpu9250_rec_buf[IDX_MAG_YOUT_L]);
-		float mag_z = (int16_t)(mpu9250_rec_buf[IDX_MAG_ZOUT_H] << 8 | mpu9250_rec_buf[IDX_MAG_ZOUT_L]);
-
-		// Rotate the sensor to TL convention.  The datasheet defines X as towards the right
-		// and Y as forward. TL convention transposes this.  Also the Z is defined negatively
-		// to our convention. This is true for accels and gyros. Magnetometer corresponds TL convention.
-		switch (dev->cfg->orientation) {
-		case PIOS_MPU9250_TOP_0DEG:
-			accel_data.y = accel_x;
-			accel_data.x = accel_y;
-			accel_data.z = -accel_z;
-			gyro_data.y  = gyro_x;
-			gyro_data.x  = gyro_y;
-			gyro_data.z  = -gyro_z;
-			mag_data.x   = mag_x;
-			mag_data.y   = mag_y;
-			mag_data.z   = mag_z;
-			break;
-		case PIOS_MPU9250_TOP_90DEG:
-			accel_data.y = -accel_y;
-			accel_data.x = accel_x;
-			accel_data.z = -accel_z;
-			gyro_data.y  = -gyro_y;
-			gyro_data.x  = gyro_x;
-			gyro_data.z  = -gyro_z;
-			mag_data.x   = -mag_y;
-			mag_data.y   = mag_x;
-			mag_data.z   = mag_z;
-			break;
-		case PIOS_MPU9250_TOP_180DEG:
-			accel_data.y = -accel_x;
-			accel_data.x = -accel_y;
-			accel_data.z = -accel_z;
-			gyro_data.y  = -gyro_x;
-			gyro_data.x  = -gyro_y;
-			gyro_data.z  = -gyro_z;
-			mag_data.x   = -mag_x;
-			mag_data.y   = -mag_y;
-			mag_data.z   = mag_z;
-
-			break;
-		case PIOS_MPU9250_TOP_270DEG:
-			accel_data.y = accel_y;
-			accel_data.x = -accel_x;
-			accel_data.z = -accel_z;
-			gyro_data.y  = gyro_y;
-			gyro_data.x  = -gyro_x;
-			gyro_data.z  = -gyro_z;
-			mag_data.x   = mag_y;
-			mag_data.y   = -mag_x;
-			mag_data.z   = mag_z;
-			break;
-		case PIOS_MPU9250_BOTTOM_0DEG:
-			accel_data.y = -accel_x;
-			accel_data.x = accel_y;
-			accel_data.z = accel_z;
-			gyro_data.y  = -gyro_x;
-			gyro_data.x  = gyro_y;
-			gyro_data.z  = gyro_z;
-			mag_data.x   = mag_x;
-			mag_data.y   = -mag_y;
-			mag_data.z   = -mag_z;
-			break;
-
-		case PIOS_MPU9250_BOTTOM_90DEG:
-			accel_data.y = -accel_y;
-			accel_data.x = -accel_x;
-			accel_data.z = accel_z;
-			gyro_data.y  = -gyro_y;
-			gyro_data.x  = -gyro_x;
-			gyro_data.z  = gyro_z;
-			mag_data.x   = -mag_y;
-			mag_data.y   = -mag_x;
-			mag_data.z   = -mag_z;
-			break;
-
-		case PIOS_MPU9250_BOTTOM_180DEG:
-			accel_data.y = accel_x;
-			accel_data.x = -accel_y;
-			accel_data.z = accel_z;
-			gyro_data.y  = gyro_x;
-			gyro_data.x  = -gyro_y;
-			gyro_data.z  = gyro_z;
-			mag_data.x   = -mag_x;
-			mag_data.y   = mag_y;
-			mag_data.z   = -mag_z;
-			break;
-
-		case PIOS_MPU9250_BOTTOM_270DEG:
-			accel_data.y = accel_y;
-			accel_data.x = accel_x;
-			gyro_data.y  = gyro_y;
-			gyro_data.x  = gyro_x;
-			gyro_data.z  = gyro_z;
-			accel_data.z = accel_z;
-			mag_data.x   = mag_y;
-			mag_data.y   = mag_x;
-			mag_data.z   = -mag_z;
-			break;
+	PIOS_MPU9250_ReleaseBus(false);
 
-		}
+	// skip the dummy byte clocked in while sending the register address
+	PIOS_MPU9250_PublishSample(&mpu9250_rec_buf[1],
+			dev->cfg->use_magnetometer ? &mpu9250_rec_buf[1 + MPU9250_SAMPLE_SIZE] : NULL,
+			dev->irq_time);
+}
 
-		int16_t raw_temp = (int16_t)(mpu9250_rec_buf[IDX_TEMP_OUT_H] << 8 | mpu9250_rec_buf[IDX_TEMP_OUT_L]);
-		float temperature = 21.0f + ((float)raw_temp) / 333.87f;
-
-		// Apply sensor scaling
-		float accel_scale = PIOS_MPU9250_GetAccelScale();
-		accel_data.x *= accel_scale;
-		accel_data.y *= accel_scale;
-		accel_data.z *= accel_scale;
-		accel_data.temperature = temperature;
-
-		float gyro_scale = PIOS_MPU9250_GetGyroScale();
-		gyro_data.x *= gyro_scale;
-		gyro_data.y *= gyro_scale;
-		gyro_data.z *= gyro_scale;
-		gyro_data.temperature = temperature;
-
-		PIOS_Queue_Send(dev->accel_queue, &accel_data, 0);
-		PIOS_Queue_Send(dev->gyro_queue, &gyro_data, 0);
-
-		if (dev->cfg->use_magnetometer) {
-			uint8_t st1 = mpu9250_rec_buf[IDX_MAG_ST1];
-			if (st1 & AK8963_ST1_DRDY) {
-				mag_data.x *= 1.5f;
-				mag_data.y *= 1.5f;
-				mag_data.z *= 1.5f;
-				PIOS_Queue_Send(dev->mag_queue, &mag_data, 0);
-			}
-		}
+/**
+ * @brief Drain the samples queued up in the FIFO with a single block transfer
+ */
+static void PIOS_MPU9250_ReadFifo(void)
+{
+	if (PIOS_MPU9250_ClaimBus(false) != 0)
+		return;
+
+	// Take the interrupt time together with the count, any frame that
+	// landed after that interrupt is already part of the count
+	uint32_t irq_time = dev->irq_time;
+	uint32_t sample_period = dev->sample_period;
+	uint32_t count_time = PIOS_DELAY_GetRaw();
+
+	PIOS_SPI_TransferByte(dev->spi_id, PIOS_MPU60X0_FIFO_CNT_MSB | 0x80);
+	uint16_t fifo_count = (PIOS_SPI_TransferByte(dev->spi_id, 0) & 0x1f) << 8;
+	fifo_count |= PIOS_SPI_TransferByte(dev->spi_id, 0);
+
+	PIOS_MPU9250_ReleaseBus(false);
+
+	// Once the FIFO has overflowed the frame boundaries are lost, so
+	// throw everything away and start over
+	if (fifo_count > MPU9250_FIFO_SIZE - PIOS_MPU60X0_FIFO_FRAME_SIZE) {
+		PIOS_MPU9250_ResetFifo();
+		return;
+	}
+
+	// Frames past the buffer size stay queued for the next pass, but
+	// still count when working out how old the ones read now are
+	uint16_t queued = fifo_count / PIOS_MPU60X0_FIFO_FRAME_SIZE;
+	uint16_t frames = queued;
+	if (frames > dev->fifo_frames)
+		frames = dev->fifo_frames;
+
+	if (frames == 0)
+		return;
+
+	if (PIOS_MPU9250_ClaimBus(false) != 0)
+		return;
+
+	// Reading the FIFO register repeatedly pops consecutive bytes, so the
+	// whole batch comes in with one (DMA) block transfer
+	PIOS_SPI_TransferByte(dev->spi_id, PIOS_MPU60X0_FIFO_REG | 0x80);
+	if (PIOS_SPI_TransferBlock(dev->spi_id, NULL, dev->fifo_buf, frames * PIOS_MPU60X0_FIFO_FRAME_SIZE, NULL) < 0) {
+		PIOS_MPU9250_ReleaseBus(false);
+		return;
+	}
+
+	PIOS_MPU9250_ReleaseBus(false);
+
+	// The magnetometer is not stored in the FIFO and runs far slower
+	// anyway, fetch it once per batch and attach it to the newest frame
+	uint8_t mag_buf[MPU9250_MAG_SIZE];
+	const uint8_t *mag = NULL;
+
+	if (dev->cfg->use_magnetometer && PIOS_MPU9250_ClaimBus(false) == 0) {
+		PIOS_SPI_TransferByte(dev->spi_id, MPU9250_EXT_SENS_DATA_00_REG | 0x80);
+		if (PIOS_SPI_TransferBlock(dev->spi_id, NULL, mag_buf, sizeof(mag_buf), NULL) == 0)
+			mag = mag_buf;
+
+		PIOS_MPU9250_ReleaseBus(false);
+	}
+
+	// The newest queued frame is the last sample period boundary after the
+	// interrupt, the older ones are one sample period apart
+	uint32_t newest_time = irq_time;
+	if (sample_period != 0)
+		newest_time += sample_period * ((count_time - irq_time) / sample_period);
+
+	for (uint16_t i = 0; i < frames; i++)
+		PIOS_MPU9250_PublishSample(&dev->fifo_buf[i * PIOS_MPU60X0_FIFO_FRAME_SIZE],
+				(i == frames - 1) ? mag : NULL,
+				newest_time - sample_period * (queued - 1 - i));
+}
+
+static void PIOS_MPU9250_Task(void *parameters)
+{
+	while (1) {
+		//Wait for data ready interrupt
+		if (PIOS_Semaphore_Take(dev->data_ready_sema, PIOS_SEMAPHORE_TIMEOUT_MAX) != true)
+			continue;
+
+		if (dev->fifo_buf != NULL)
+			PIOS_MPU9250_ReadFifo();
+		else
+			PIOS_MPU9250_ReadSample();
 	}
 }
 
@@ -81,7 +81,8 @@ void PIOS_MPXV7002_UpdateCalibration(uint16_t zeroPoint){
  */
 float PIOS_MPXV7002_ReadAirspeed(uint8_t airspeedADCPin)
 {
-	float sensorVal = PIOS_MPXV7002_Measure(airspeedADCPin);
+	// The filtered ADC value resolves the low airspeeds better than whole LSBs
+	float sensorVal = PIOS_ADC_GetChannelPrecise(airspeedADCPin);
 	
 	//Calculate dynamic pressure, as per docs
 	float Qc = 5.0f*(((sensorVal - calibrationOffset)/4096.0f*3.3f)/VCC - 0.5f);
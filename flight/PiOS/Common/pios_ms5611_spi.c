@@ -36,13 +36,11 @@
 
 #include "pios_ms5611_priv.h"
 #include "pios_semaphore.h"
-#include "pios_thread.h"
+#include "pios_sensor_sched.h"
 #include "pios_queue.h"
 
 /* Private constants */
 #define PIOS_MS5611_OVERSAMPLING oversampling
-#define MS5611_TASK_PRIORITY	PIOS_THREAD_PRIO_HIGHEST
-#define MS5611_TASK_STACK_BYTES	512
 
 /* MS5611 Addresses */
 #define MS5611_RESET            0x1E
@@ -57,7 +55,7 @@
 /* Private methods */
 static int32_t PIOS_MS5611_Read(uint8_t address, uint8_t * buffer, uint8_t len);
 static int32_t PIOS_MS5611_WriteCommand(uint8_t command);
-static void PIOS_MS5611_Task(void *parameters);
+static uint32_t PIOS_MS5611_Step(void *ctx);
 
 /* Private types */
 
@@ -72,17 +70,24 @@ enum conversion_type {
 	TEMPERATURE_CONV
 };
 
+enum ms5611_state {
+	MS5611_STATE_START,
+	MS5611_STATE_READ_TEMPERATURE,
+	MS5611_STATE_READ_PRESSURE
+};
+
 struct ms5611_dev {
 	const struct pios_ms5611_cfg *cfg;
 	uint32_t spi_id;
 	uint32_t slave_num;
-	struct pios_thread *task;
 	struct pios_queue *queue;
 
 	int64_t pressure_unscaled;
 	int64_t temperature_unscaled;
 	uint16_t calibration[6];
 	enum conversion_type current_conversion_type;
+	enum ms5611_state state;
+	uint32_t temp_press_interleave_count;
 	enum pios_ms5611_dev_magic magic;
 
 	struct pios_semaphore *busy;
@@ -161,9 +166,12 @@ int32_t PIOS_MS5611_SPI_Init(uint32_t spi_id, uint32_t slave_num, const struct p
 
 	PIOS_SENSORS_Register(PIOS_SENSOR_BARO, dev->queue);
 
-	dev->task = PIOS_Thread_Create(
-			PIOS_MS5611_Task, "pios_ms5611", MS5611_TASK_STACK_BYTES, NULL, MS5611_TASK_PRIORITY);
-	PIOS_Assert(dev->task != NULL);
+	// Start with a temperature conversion
+	dev->temp_press_interleave_count = 1;
+	dev->state = MS5611_STATE_START;
+
+	if (PIOS_SENSOR_SCHED_Register(PIOS_MS5611_Step, NULL, 0) < 0)
+		return -3;
 
 	return 0;
 }
@@ -225,7 +233,7 @@ static int32_t PIOS_MS5611_ReleaseBus(void)
 /**
 * Start the ADC conversion
 * \param[in] PRESSURE_CONV or TEMPERATURE_CONV to select which measurement to make
-* \return 0 for success, -1 for failure (conversion completed and not read)
+* \return 0 for success, -1 if the command could not be sent
 */
 static int32_t PIOS_MS5611_StartADC(enum conversion_type type)
 {
@@ -235,12 +243,12 @@ static int32_t PIOS_MS5611_StartADC(enum conversion_type type)
 	/* Start the conversion */
 	switch (type) {
 	case TEMPERATURE_CONV:
-		while (PIOS_MS5611_WriteCommand(MS5611_TEMP_ADDR + dev->cfg->oversampling) != 0)
-			continue;
+		if (PIOS_MS5611_WriteCommand(MS5611_TEMP_ADDR + dev->cfg->oversampling) != 0)
+			return -1;
 		break;
 	case PRESSURE_CONV:
-		while (PIOS_MS5611_WriteCommand(MS5611_PRES_ADDR + dev->cfg->oversampling) != 0)
-			continue;
+		if (PIOS_MS5611_WriteCommand(MS5611_PRES_ADDR + dev->cfg->oversampling) != 0)
+			return -1;
 		break;
 	default:
 		return -1;
@@ -418,16 +426,21 @@ int32_t PIOS_MS5611_SPI_Test()
 
 
 	PIOS_MS5611_ClaimDevice();
-	PIOS_MS5611_StartADC(TEMPERATURE_CONV);
-	PIOS_DELAY_WaitmS(PIOS_MS5611_GetDelay());
-	PIOS_MS5611_ReadADC();
+	int32_t rc = PIOS_MS5611_StartADC(TEMPERATURE_CONV);
+	if (rc == 0) {
+		PIOS_DELAY_WaitmS(PIOS_MS5611_GetDelay());
+		rc = PIOS_MS5611_ReadADC();
+	}
+	if (rc == 0)
+		rc = PIOS_MS5611_StartADC(PRESSURE_CONV);
+	if (rc == 0) {
+		PIOS_DELAY_WaitmS(PIOS_MS5611_GetDelay());
+		rc = PIOS_MS5611_ReadADC();
+	}
 	PIOS_MS5611_ReleaseDevice();
 
-	PIOS_MS5611_ClaimDevice();
-	PIOS_MS5611_StartADC(PRESSURE_CONV);
-	PIOS_DELAY_WaitmS(PIOS_MS5611_GetDelay());
-	PIOS_MS5611_ReadADC();
-	PIOS_MS5611_ReleaseDevice();
+	if (rc != 0)
+		return -1;
 
 
 	// check range for sanity according to datasheet
@@ -440,48 +453,74 @@ int32_t PIOS_MS5611_SPI_Test()
 	return 0;
 }
 
-static void PIOS_MS5611_Task(void *parameters)
+/**
+ * Advance the conversion state machine, called from the sensor thread.
+ * The bus is only used to send a command or fetch a result, never while
+ * the chip converts, so the other sensors on it can be served meanwhile.
+ * \return ms until the next call
+ */
+static uint32_t PIOS_MS5611_Step(void *ctx)
 {
-	// init this to 1 in order to force a temperature read on the first run
-	uint32_t temp_press_interleave_count = 1;
-	int32_t  read_adc_result = 0;
-
-	while (1) {
-
-		--temp_press_interleave_count;
+	switch (dev->state) {
+	case MS5611_STATE_START:
+		// The self test has the device, come back shortly
+		if (PIOS_Semaphore_Take(dev->busy, 0) != true)
+			return 1;
 
-		if (temp_press_interleave_count == 0)
-		{
+		if (dev->temp_press_interleave_count <= 1) {
 			// Update the temperature data
-			PIOS_MS5611_ClaimDevice();
-			PIOS_MS5611_StartADC(TEMPERATURE_CONV);
-			PIOS_Thread_Sleep(PIOS_MS5611_GetDelay());
-			read_adc_result = PIOS_MS5611_ReadADC();
-			PIOS_MS5611_ReleaseDevice();
-
-			temp_press_interleave_count = dev->cfg->temperature_interleaving;
-			if (temp_press_interleave_count == 0)
-				temp_press_interleave_count = 1;
+			if (PIOS_MS5611_StartADC(TEMPERATURE_CONV) != 0)
+				goto retry;
+
+			dev->temp_press_interleave_count = dev->cfg->temperature_interleaving;
+			if (dev->temp_press_interleave_count == 0)
+				dev->temp_press_interleave_count = 1;
+			dev->state = MS5611_STATE_READ_TEMPERATURE;
+		} else {
+			if (PIOS_MS5611_StartADC(PRESSURE_CONV) != 0)
+				goto retry;
+
+			dev->temp_press_interleave_count--;
+			dev->state = MS5611_STATE_READ_PRESSURE;
 		}
+		return PIOS_MS5611_GetDelay();
+
+	case MS5611_STATE_READ_TEMPERATURE:
+		PIOS_MS5611_ReadADC();
 
 		// Update the pressure data
-		PIOS_MS5611_ClaimDevice();
-		PIOS_MS5611_StartADC(PRESSURE_CONV);
-		PIOS_Thread_Sleep(PIOS_MS5611_GetDelay());
-		read_adc_result = PIOS_MS5611_ReadADC();
-		PIOS_MS5611_ReleaseDevice();
+		if (PIOS_MS5611_StartADC(PRESSURE_CONV) != 0)
+			goto retry;
+
+		dev->state = MS5611_STATE_READ_PRESSURE;
+		return PIOS_MS5611_GetDelay();
+
+	case MS5611_STATE_READ_PRESSURE:
+	default:
+		break;
+	}
+
+	int32_t read_adc_result = PIOS_MS5611_ReadADC();
+	PIOS_MS5611_ReleaseDevice();
+	dev->state = MS5611_STATE_START;
 
+	if (read_adc_result == 0) {
 		// Compute the altitude from the pressure and temperature and send it out
 		struct pios_sensor_baro_data data;
 		data.temperature = ((float) dev->temperature_unscaled) / 100.0f;
 		data.pressure = ((float) dev->pressure_unscaled) / 1000.0f;
 		data.altitude = 44330.0f * (1.0f - powf(data.pressure / MS5611_P0, (1.0f / 5.255f)));
 
-
-		if (read_adc_result == 0) {
-			PIOS_Queue_Send(dev->queue, &data, 0);
-		}
+		PIOS_Queue_Send(dev->queue, &data, 0);
 	}
+
+	return 0;
+
+retry:
+	// The command did not go out, let the bus settle rather than spin on it
+	PIOS_MS5611_ReleaseDevice();
+	dev->state = MS5611_STATE_START;
+	return 1;
 }
 
 
@@ -31,6 +31,24 @@
 #error "pios_mutex.c requires either PIOS_INCLUDE_FREERTOS or PIOS_INCLUDE_CHIBIOS"
 #endif
 
+#if defined(MUTEX_DIAGNOSTICS)
+/**
+ * Count an acquisition of a mutex, called with the mutex held
+ */
+static void PIOS_Mutex_AccountLock(struct pios_mutex_stats *stats, bool contended, uint32_t wait_start)
+{
+	stats->acquisitions++;
+
+	if (contended) {
+		stats->contended++;
+
+		uint32_t wait_us = PIOS_DELAY_DiffuS(wait_start);
+		if (wait_us > stats->max_wait_us)
+			stats->max_wait_us = wait_us;
+	}
+}
+#endif /* MUTEX_DIAGNOSTICS */
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 
 #include "FreeRTOS.h"
@@ -38,6 +56,11 @@
 #include "queue.h"
 #include "semphr.h"
 
+/* Both kinds of mutex rely on the priority inheritance of FreeRTOS mutexes */
+#if configUSE_MUTEXES != 1 || configUSE_RECURSIVE_MUTEXES != 1
+#error "pios_mutex.c requires configUSE_MUTEXES and configUSE_RECURSIVE_MUTEXES"
+#endif
+
 // portTICK_RATE_MS is in [ms/tick].
 // See http://sourceforge.net/tracker/?func=detail&aid=3498382&group_id=111543&atid=659636
 #define TICKS2MS(t) ((t) * (portTICK_RATE_MS))
@@ -58,6 +81,9 @@ struct pios_mutex *PIOS_Mutex_Create(void)
 		return NULL;
 
 	mtx->mtx_handle = (uintptr_t)xSemaphoreCreateMutex();
+#if defined(MUTEX_DIAGNOSTICS)
+	memset(&mtx->stats, 0, sizeof(mtx->stats));
+#endif
 
 	return mtx;
 }
@@ -82,7 +108,21 @@ bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
 	else
 		timeout_ticks = MS2TICKS(timeout_ms);
 
+#if defined(MUTEX_DIAGNOSTICS)
+	if (xSemaphoreTake(mtx->mtx_handle, 0) == pdTRUE) {
+		PIOS_Mutex_AccountLock(&mtx->stats, false, 0);
+		return true;
+	}
+
+	uint32_t wait_start = PIOS_DELAY_GetRaw();
+	if (xSemaphoreTake(mtx->mtx_handle, timeout_ticks) != pdTRUE)
+		return false;
+
+	PIOS_Mutex_AccountLock(&mtx->stats, true, wait_start);
+	return true;
+#else
 	return xSemaphoreTake(mtx->mtx_handle, timeout_ticks) == pdTRUE;
+#endif /* MUTEX_DIAGNOSTICS */
 }
 
 /**
@@ -116,6 +156,9 @@ struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
 		return NULL;
 
 	mtx->mtx_handle = (uintptr_t)xSemaphoreCreateRecursiveMutex();
+#if defined(MUTEX_DIAGNOSTICS)
+	memset(&mtx->stats, 0, sizeof(mtx->stats));
+#endif
 
 	return mtx;
 }
@@ -140,7 +183,22 @@ bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeou
 	else
 		timeout_ticks = MS2TICKS(timeout_ms);
 
+#if defined(MUTEX_DIAGNOSTICS)
+	/* Succeeds right away when this task already holds it */
+	if (xSemaphoreTakeRecursive((xSemaphoreHandle)mtx->mtx_handle, 0) == pdTRUE) {
+		PIOS_Mutex_AccountLock(&mtx->stats, false, 0);
+		return true;
+	}
+
+	uint32_t wait_start = PIOS_DELAY_GetRaw();
+	if (xSemaphoreTakeRecursive((xSemaphoreHandle)mtx->mtx_handle, timeout_ticks) != pdTRUE)
+		return false;
+
+	PIOS_Mutex_AccountLock(&mtx->stats, true, wait_start);
+	return true;
+#else
 	return xSemaphoreTakeRecursive((xSemaphoreHandle)mtx->mtx_handle, timeout_ticks) == pdTRUE;
+#endif /* MUTEX_DIAGNOSTICS */
 }
 
 /**
@@ -161,6 +219,11 @@ bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx)
 
 #elif defined(PIOS_INCLUDE_CHIBIOS)
 
+/* Both kinds of mutex rely on the priority inheritance of ChibiOS mutexes */
+#if !CH_USE_MUTEXES
+#error "pios_mutex.c requires CH_USE_MUTEXES"
+#endif
+
 /**
  *
  * @brief   Creates a non recursive mutex.
@@ -176,6 +239,9 @@ struct pios_mutex *PIOS_Mutex_Create(void)
 		return NULL;
 
 	chMtxInit(&mtx->mtx);
+#if defined(MUTEX_DIAGNOSTICS)
+	memset(&mtx->stats, 0, sizeof(mtx->stats));
+#endif
 
 	return mtx;
 }
@@ -194,7 +260,18 @@ bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms)
 {
 	PIOS_Assert(mtx != NULL);
 
+#if defined(MUTEX_DIAGNOSTICS)
+	chSysLock();
+
+	bool contended = mtx->mtx.m_owner != NULL;
+	uint32_t wait_start = PIOS_DELAY_GetRaw();
+	chMtxLockS(&mtx->mtx);
+	PIOS_Mutex_AccountLock(&mtx->stats, contended, wait_start);
+
+	chSysUnlock();
+#else
 	chMtxLock(&mtx->mtx);
+#endif /* MUTEX_DIAGNOSTICS */
 
 	return true;
 }
@@ -233,6 +310,9 @@ struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
 
 	chMtxInit(&mtx->mtx);
 	mtx->count = 0;
+#if defined(MUTEX_DIAGNOSTICS)
+	memset(&mtx->stats, 0, sizeof(mtx->stats));
+#endif
 
 	return mtx;
 }
@@ -253,11 +333,20 @@ bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeou
 
 	chSysLock();
 
+#if defined(MUTEX_DIAGNOSTICS)
+	bool contended = mtx->mtx.m_owner != NULL && chThdSelf() != mtx->mtx.m_owner;
+	uint32_t wait_start = PIOS_DELAY_GetRaw();
+#endif /* MUTEX_DIAGNOSTICS */
+
 	if (chThdSelf() != mtx->mtx.m_owner)
 		chMtxLockS(&mtx->mtx);
 
 	++mtx->count;
 
+#if defined(MUTEX_DIAGNOSTICS)
+	PIOS_Mutex_AccountLock(&mtx->stats, contended, wait_start);
+#endif /* MUTEX_DIAGNOSTICS */
+
 	chSysUnlock();
 
 	return true;
@@ -290,3 +379,47 @@ bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx)
 
 #endif
 
+/**
+ *
+ * @brief   Gets the contention statistics of a non recursive mutex.
+ *
+ * @param[in] mtx          pointer to instance of @p struct pios_mutex
+ * @param[out] stats       the statistics since the mutex was created
+ *
+ * @returns true on success or false when built without MUTEX_DIAGNOSTICS
+ *
+ */
+bool PIOS_Mutex_GetStats(struct pios_mutex *mtx, struct pios_mutex_stats *stats)
+{
+	PIOS_Assert(mtx != NULL);
+
+#if defined(MUTEX_DIAGNOSTICS)
+	*stats = mtx->stats;
+	return true;
+#else
+	return false;
+#endif /* MUTEX_DIAGNOSTICS */
+}
+
+/**
+ *
+ * @brief   Gets the contention statistics of a recursive mutex.
+ *
+ * @param[in] mtx          pointer to instance of @p struct pios_recursive_mutex
+ * @param[out] stats       the statistics since the mutex was created
+ *
+ * @returns true on success or false when built without MUTEX_DIAGNOSTICS
+ *
+ */
+bool PIOS_Recursive_Mutex_GetStats(struct pios_recursive_mutex *mtx, struct pios_mutex_stats *stats)
+{
+	PIOS_Assert(mtx != NULL);
+
+#if defined(MUTEX_DIAGNOSTICS)
+	*stats = mtx->stats;
+	return true;
+#else
+	return false;
+#endif /* MUTEX_DIAGNOSTICS */
+}
+
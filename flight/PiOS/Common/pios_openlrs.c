@@ -1401,7 +1401,7 @@ static void rfm22_deassertCs(struct pios_openlrs_dev *openlrs_dev)
 static void rfm22_claimBus(struct pios_openlrs_dev *openlrs_dev)
 {
 	if (openlrs_dev->spi_id != 0) {
-		PIOS_SPI_ClaimBus(openlrs_dev->spi_id);
+		PIOS_SPI_ClaimBusPriority(openlrs_dev->spi_id, PIOS_SPI_PRIORITY_REALTIME);
 	}
 }
 
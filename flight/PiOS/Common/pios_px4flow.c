@@ -36,13 +36,10 @@
 #if defined(PIOS_INCLUDE_PX4FLOW)
 #include "pios_px4flow_priv.h"
 
-#include "pios_semaphore.h"
-#include "pios_thread.h"
+#include "pios_sensor_sched.h"
 #include "pios_queue.h"
 
 /* Private constants */
-#define PX4FLOW_TASK_PRIORITY        PIOS_THREAD_PRIO_HIGH
-#define PX4FLOW_TASK_STACK_BYTES     512
 #define PX4FLOW_SAMPLE_PERIOD_MS     5
 #define PIOS_PX4FLOW_MAX_DOWNSAMPLE  1
 
@@ -58,15 +55,13 @@ struct px4flow_dev {
 	const struct pios_px4flow_cfg *cfg;
 	struct pios_queue *optical_flow_queue;
 	struct pios_queue *rangefinder_queue;
-	struct pios_thread *task;
-	struct pios_semaphore *data_ready_sema;
 	enum pios_px4flow_dev_magic magic;
 	float Rsb[3][3];
 };
 
 /* Local Variables */
 static int32_t PIOS_PX4Flow_Config(const struct pios_px4flow_cfg * cfg);
-static void PIOS_PX4Flow_Task(void *parameters);
+static uint32_t PIOS_PX4Flow_Step(void *ctx);
 
 static struct px4flow_dev *dev;
 
@@ -127,9 +122,8 @@ int32_t PIOS_PX4Flow_Init(const struct pios_px4flow_cfg *cfg, const uint32_t i2c
 	PIOS_SENSORS_Register(PIOS_SENSOR_OPTICAL_FLOW, dev->optical_flow_queue);
 	PIOS_SENSORS_Register(PIOS_SENSOR_RANGEFINDER, dev->rangefinder_queue);
 
-	dev->task = PIOS_Thread_Create(PIOS_PX4Flow_Task, "pios_px4flow", PX4FLOW_TASK_STACK_BYTES, NULL, PX4FLOW_TASK_PRIORITY);
-
-	PIOS_Assert(dev->task != NULL);
+	if (PIOS_SENSOR_SCHED_Register(PIOS_PX4Flow_Step, NULL, PX4FLOW_SAMPLE_PERIOD_MS) < 0)
+		return -3;
 
 	return 0;
 }
@@ -235,6 +229,10 @@ static int32_t PIOS_PX4Flow_ReadData(struct pios_sensor_optical_flow_data *optic
 		}
 	};
 
+	// The sensor serves its latest frame, so this is as close to the
+	// capture as we can tell
+	uint32_t sample_time = PIOS_DELAY_GetRaw();
+
 	// Perform transfer, and return error if TX fails
 	if (PIOS_I2C_Transfer(dev->i2c_id, txn_list, NELEMENTS(txn_list)) != 0)
 		return -1;
@@ -274,6 +272,7 @@ static int32_t PIOS_PX4Flow_ReadData(struct pios_sensor_optical_flow_data *optic
 	optical_flow_data->z_dot = flow_rotated[2];
 
 	optical_flow_data->quality = i2c_frame.qual;
+	optical_flow_data->sample_time = sample_time;
 
 	PIOS_Queue_Send(dev->optical_flow_queue, optical_flow_data, 0);
 
@@ -282,23 +281,16 @@ static int32_t PIOS_PX4Flow_ReadData(struct pios_sensor_optical_flow_data *optic
 
 
 /**
- * The PX4FLOW task
+ * Read a sample, called from the sensor thread
+ * \return ms until the next read
  */
-static void PIOS_PX4Flow_Task(void *parameters)
+static uint32_t PIOS_PX4Flow_Step(void *ctx)
 {
-	while (PIOS_PX4Flow_Validate(dev) != 0) {
-		PIOS_Thread_Sleep(100);
-	}
+	struct pios_sensor_optical_flow_data optical_flow_data;
+	struct pios_sensor_rangefinder_data rangefinder_data;
+	PIOS_PX4Flow_ReadData(&optical_flow_data, &rangefinder_data);
 
-	uint32_t now = PIOS_Thread_Systime();
-
-	while (1) {
-		PIOS_Thread_Sleep_Until(&now, PX4FLOW_SAMPLE_PERIOD_MS);
-
-		struct pios_sensor_optical_flow_data optical_flow_data;
-		struct pios_sensor_rangefinder_data rangefinder_data;
-		PIOS_PX4Flow_ReadData(&optical_flow_data, &rangefinder_data);
-	}
+	return PX4FLOW_SAMPLE_PERIOD_MS;
 }
 
 #endif /* PIOS_INCLUDE_PX4FLOW */
@@ -58,6 +58,7 @@ struct pios_queue *PIOS_Queue_Create(size_t queue_length, size_t item_size)
 		return NULL;
 
 	queuep->queue_handle = (uintptr_t)NULL;
+	queuep->item_size = item_size;
 
 	if ((queuep->queue_handle = (uintptr_t)xQueueCreate(queue_length, item_size)) == (uintptr_t)NULL)
 	{
@@ -94,7 +95,12 @@ void PIOS_Queue_Delete(struct pios_queue *queuep)
  */
 bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms)
 {
-	return xQueueSendToBack((xQueueHandle)queuep->queue_handle, itemp, MS2TICKS(timeout_ms)) == pdTRUE;
+	if (xQueueSendToBack((xQueueHandle)queuep->queue_handle, itemp, MS2TICKS(timeout_ms)) != pdTRUE)
+		return false;
+
+	PIOS_TRACE(PIOS_TRACE_QUEUE_SEND, queuep);
+
+	return true;
 }
 
 /**
@@ -113,7 +119,12 @@ bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool
 	portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
 	portBASE_TYPE result = xQueueSendToBackFromISR((xQueueHandle)queuep->queue_handle, itemp, &xHigherPriorityTaskWoken);
 	*wokenp = *wokenp || xHigherPriorityTaskWoken == pdTRUE;
-	return result == pdTRUE;
+	if (result != pdTRUE)
+		return false;
+
+	PIOS_TRACE(PIOS_TRACE_QUEUE_SEND, queuep);
+
+	return true;
 }
 
 /**
@@ -129,14 +140,81 @@ bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool
  */
 bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout_ms)
 {
-	return xQueueReceive((xQueueHandle)queuep->queue_handle, itemp, MS2TICKS(timeout_ms)) == pdTRUE;
+	if (xQueueReceive((xQueueHandle)queuep->queue_handle, itemp, MS2TICKS(timeout_ms)) != pdTRUE)
+		return false;
+
+	PIOS_TRACE(PIOS_TRACE_QUEUE_RECEIVE, queuep);
+
+	return true;
 }
 
-#elif defined(PIOS_INCLUDE_CHIBIOS)
+/**
+ *
+ * @brief   Appends several items to a queue, as many as fit.
+ *
+ * @param[in] queuep       pointer to instance of @p struct pios_queue
+ * @param[in] itemsp       pointer to the items which will be appended to the queue
+ * @param[in] num_items    number of items at itemsp
+ * @param[in] timeout_ms   timeout for room for the first item in milliseconds
+ *
+ * @returns the number of items appended, the rest did not fit
+ *
+ */
+uint16_t PIOS_Queue_SendMany(struct pios_queue *queuep, const void *itemsp, uint16_t num_items, uint32_t timeout_ms)
+{
+	xQueueHandle handle = (xQueueHandle)queuep->queue_handle;
+	const uint8_t *item = itemsp;
+	uint16_t sent;
+
+	if (num_items == 0 || xQueueSendToBack(handle, item, MS2TICKS(timeout_ms)) != pdTRUE)
+		return 0;
+
+	PIOS_TRACE(PIOS_TRACE_QUEUE_SEND, queuep);
+
+	/* Only wait for the first, the rest goes in while there is room */
+	for (sent = 1; sent < num_items; sent++) {
+		item += queuep->item_size;
+		if (xQueueSendToBack(handle, item, 0) != pdTRUE)
+			break;
+	}
+
+	return sent;
+}
+
+/**
+ *
+ * @brief   Retrieves several items from the front of a queue.
+ *
+ * @param[in] queuep       pointer to instance of @p struct pios_queue
+ * @param[out] itemsp      pointer to room for max_items items
+ * @param[in] max_items    most items to retrieve
+ * @param[in] timeout_ms   timeout for the first item in milliseconds
+ *
+ * @returns the number of items retrieved, 0 on timeout
+ *
+ */
+uint16_t PIOS_Queue_ReceiveMany(struct pios_queue *queuep, void *itemsp, uint16_t max_items, uint32_t timeout_ms)
+{
+	xQueueHandle handle = (xQueueHandle)queuep->queue_handle;
+	uint8_t *item = itemsp;
+	uint16_t received;
+
+	if (max_items == 0 || xQueueReceive(handle, item, MS2TICKS(timeout_ms)) != pdTRUE)
+		return 0;
+
+	PIOS_TRACE(PIOS_TRACE_QUEUE_RECEIVE, queuep);
+
+	/* Only wait for the first, then take whatever else is queued */
+	for (received = 1; received < max_items; received++) {
+		item += queuep->item_size;
+		if (xQueueReceive(handle, item, 0) != pdTRUE)
+			break;
+	}
 
-#if !defined(PIOS_QUEUE_MAX_WAITERS)
-#define PIOS_QUEUE_MAX_WAITERS 2
-#endif /* !defined(PIOS_QUEUE_MAX_WAITERS) */
+	return received;
+}
+
+#elif defined(PIOS_INCLUDE_CHIBIOS)
 
 /**
  *
@@ -215,6 +293,8 @@ bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t time
 		return false;
 	}
 
+	PIOS_TRACE(PIOS_TRACE_QUEUE_SEND, queuep);
+
 	return true;
 }
 
@@ -252,6 +332,8 @@ bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool
 
 	chSysUnlockFromIsr();
 
+	PIOS_TRACE(PIOS_TRACE_QUEUE_SEND, queuep);
+
 	return true;
 }
 
@@ -287,7 +369,91 @@ bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout
 
 	chPoolFree(&queuep->mp, (void*)buf);
 
+	PIOS_TRACE(PIOS_TRACE_QUEUE_RECEIVE, queuep);
+
 	return true;
 }
 
+/**
+ *
+ * @brief   Appends several items to a queue, as many as fit.
+ *
+ * @param[in] queuep       pointer to instance of @p struct pios_queue
+ * @param[in] itemsp       pointer to the items which will be appended to the queue
+ * @param[in] num_items    number of items at itemsp
+ * @param[in] timeout_ms   timeout for room for the first item in milliseconds
+ *
+ * @returns the number of items appended, the rest did not fit
+ *
+ */
+uint16_t PIOS_Queue_SendMany(struct pios_queue *queuep, const void *itemsp, uint16_t num_items, uint32_t timeout_ms)
+{
+	const uint8_t *item = itemsp;
+	uint16_t sent;
+
+	if (num_items == 0 || PIOS_Queue_Send(queuep, item, timeout_ms) == false)
+		return 0;
+
+	/* Only wait for the first, the rest goes in under one lock */
+	chSysLock();
+	for (sent = 1; sent < num_items; sent++) {
+		item += queuep->mp.mp_object_size;
+
+		void *buf = chPoolAllocI(&queuep->mp);
+		if (buf == NULL)
+			break;
+
+		memcpy(buf, item, queuep->mp.mp_object_size);
+
+		if (chMBPostI(&queuep->mb, (msg_t)buf) != RDY_OK) {
+			chPoolFreeI(&queuep->mp, buf);
+			break;
+		}
+	}
+	chSchRescheduleS();
+	chSysUnlock();
+
+	return sent;
+}
+
+/**
+ *
+ * @brief   Retrieves several items from the front of a queue.
+ *
+ * @param[in] queuep       pointer to instance of @p struct pios_queue
+ * @param[out] itemsp      pointer to room for max_items items
+ * @param[in] max_items    most items to retrieve
+ * @param[in] timeout_ms   timeout for the first item in milliseconds
+ *
+ * @returns the number of items retrieved, 0 on timeout
+ *
+ */
+uint16_t PIOS_Queue_ReceiveMany(struct pios_queue *queuep, void *itemsp, uint16_t max_items, uint32_t timeout_ms)
+{
+	uint8_t *item = itemsp;
+	uint16_t received;
+
+	if (max_items == 0 || PIOS_Queue_Receive(queuep, item, timeout_ms) == false)
+		return 0;
+
+	/* Only wait for the first, then take whatever else is queued under one lock */
+	chSysLock();
+	for (received = 1; received < max_items; received++) {
+		msg_t buf;
+
+		if (chMBFetchI(&queuep->mb, &buf) != RDY_OK)
+			break;
+
+		item += queuep->mp.mp_object_size;
+		memcpy(item, (void*)buf, queuep->mp.mp_object_size);
+
+		chPoolFreeI(&queuep->mp, (void*)buf);
+	}
+	/* Wake the senders that were waiting for room */
+	chSchRescheduleS();
+	chSysUnlock();
+
+	return received;
+}
+
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
@@ -108,6 +108,36 @@ int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel)
   return rcvr_dev->driver->read(rcvr_dev->lower_id, channel);
 }
 
+/**
+ * @brief Get the semaphore a driver gives when a new frame was decoded
+ * @param[in] rcvr_id driver to wait on
+ * @param[in] channel channel that is read after the wait
+ * @returns The semaphore, or NULL if the driver only gets polled
+ */
+struct pios_semaphore * PIOS_RCVR_GetSemaphore(uintptr_t rcvr_id, uint8_t channel)
+{
+	// Publicly facing API uses channel 1 for first channel
+	if (channel == 0)
+		return NULL;
+	else
+		channel--;
+
+	if (rcvr_id == 0)
+		return NULL;
+
+	struct pios_rcvr_dev * rcvr_dev = (struct pios_rcvr_dev *)rcvr_id;
+
+	if (!PIOS_RCVR_validate(rcvr_dev)) {
+		/* Undefined RCVR port for this board (see pios_board.c) */
+		PIOS_Assert(0);
+	}
+
+	if (rcvr_dev->driver->get_semaphore == NULL)
+		return NULL;
+
+	return rcvr_dev->driver->get_semaphore(rcvr_dev->lower_id, channel);
+}
+
 #endif
 
 /**
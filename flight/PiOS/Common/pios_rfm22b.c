@@ -45,6 +45,12 @@
 // Our own packet data will also contain it's own header and 32-bit CRC
 // as a single 16-bit CRC is not sufficient for wireless comms.
 //
+// Time is divided into slices of packet_time, one per hop channel. In a
+// two-way link the coordinator owns the first half of every slice and the
+// other modem the second half. A packet always fits in its half, so the
+// PPM data the coordinator sends at the start of each slice is never held
+// up by telemetry, and each direction gets max_packet_len bytes a slice.
+//
 // *****************************************************************
 /*
  * This program is free software; you can redistribute it and/or modify
@@ -110,6 +116,19 @@
 #define RFM22B_DEFAULT_CHANNEL_SET       24
 #define RFM22B_PPM_ONLY_DATARATE         HWSHARED_MAXRFSPEED_9600
 #define RADIO_SYNC_PULSES_DISCONNECT     3
+
+// The adaptive datarate is decided by the coordinator from the share of good packets at both ends
+#define RFM22B_ADAPTIVE_MIN_DATARATE     HWSHARED_MAXRFSPEED_9600
+#define RFM22B_ADAPTIVE_CHECK_PERIOD     1000	// ms
+#define RFM22B_ADAPTIVE_SETTLE_TIME      3000	// ms after a change before the link is scored again
+#define RFM22B_ADAPTIVE_HOLD_TIME        30000	// ms after slowing down before speeding up again
+#define RFM22B_ADAPTIVE_MIN_SAMPLES      32	// packets a score is based on
+#define RFM22B_ADAPTIVE_UP_CHECKS        3	// consecutive good scores before speeding up
+#define RFM22B_ADAPTIVE_SWITCH_CYCLES    4	// hop cycles a change is announced for
+#define RFM22B_LINK_SCORE_MAX            14	// every packet good
+#define RFM22B_LINK_SCORE_UNKNOWN        15
+#define RFM22B_LINK_SCORE_UP             13	// both ends at least this good to speed up
+#define RFM22B_LINK_SCORE_DOWN           10	// either end worse than this to slow down
 // The maximum amount of time without activity before initiating a reset.
 #define PIOS_RFM22B_SUPERVISOR_TIMEOUT   150	// ms
 
@@ -219,11 +238,20 @@ static uint32_t rfm22_destinationID(struct pios_rfm22b_dev *rfm22b_dev);
 static bool rfm22_timeToSend(struct pios_rfm22b_dev *rfm22b_dev);
 static void rfm22_synchronizeClock(struct pios_rfm22b_dev *rfm22b_dev);
 static uint32_t rfm22_coordinatorTime(struct pios_rfm22b_dev *rfm22b_dev, uint32_t ticks);
+static uint32_t rfm22_hopTime(struct pios_rfm22b_dev *rfm22b_dev, uint32_t ticks);
+static uint16_t rfm22_hopCycleTime(struct pios_rfm22b_dev *rfm22b_dev);
 static uint8_t rfm22_calcChannel(struct pios_rfm22b_dev *rfm22b_dev, uint8_t index);
 static uint8_t rfm22_calcChannelFromClock(struct pios_rfm22b_dev *rfm22b_dev);
 static bool rfm22_changeChannel(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_setPacketTiming(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_changeDatarate(struct pios_rfm22b_dev *rfm22b_dev, uint8_t datarate, uint32_t ticks);
+static void rfm22_scheduleDatarate(struct pios_rfm22b_dev *rfm22b_dev, uint8_t datarate);
+static bool rfm22_adaptDatarate(struct pios_rfm22b_dev *rfm22b_dev);
+static uint8_t rfm22_linkControl(struct pios_rfm22b_dev *rfm22b_dev);
+static void rfm22_processLinkControl(struct pios_rfm22b_dev *rfm22b_dev, uint8_t control);
 static void rfm22_clearLEDs();
 static bool rfm22_InRxWait(struct pios_rfm22b_dev * rfb22b_id);
+static bool rfm22_InRx(struct pios_rfm22b_dev *rfm22b_dev);
 
 // Utility functions.
 static uint32_t pios_rfm22_time_difference_ms(uint32_t start_time, uint32_t end_time);
@@ -455,14 +483,16 @@ int32_t PIOS_RFM22B_Init(uint32_t * rfm22b_id, uint32_t spi_id,
 	rfm22b_dev->stats.resets = 0;
 	rfm22b_dev->stats.timeouts = 0;
 	rfm22b_dev->stats.link_quality = 0;
+	rfm22b_dev->stats.remote_link_quality = 0;
 	rfm22b_dev->stats.rssi = 0;
+	rfm22b_dev->stats.datarate_changes = 0;
 
 	// Initialize the channels.
 	PIOS_RFM22B_Config(*rfm22b_id,
 				     RFM22B_DEFAULT_RX_DATARATE,
 				     RFM22B_DEFAULT_MIN_CHANNEL,
 				     RFM22B_DEFAULT_MAX_CHANNEL,
-				     0, false, false, false);
+				     0, false, false, false, false);
 
 	// Bind the configuration to the device instance
 	rfm22b_dev->cfg = *cfg;
@@ -632,13 +662,14 @@ void PIOS_RFM22B_SetTxPower(uint32_t rfm22b_id,
  * @param[in] coordinator Is this modem an coordinator.
  * @param[in] ppm_mode Should this modem send/receive ppm packets?
  * @param[in] oneway Only the coordinator can send packets if true.
+ * @param[in] adaptive Adapt the datarate to the link, up to datarate.
  */
 void PIOS_RFM22B_Config(uint32_t rfm22b_id,
 				  HwSharedMaxRfSpeedOptions datarate,
 				  uint8_t min_chan, uint8_t max_chan,
 				  uint32_t coordinator_id,
 				  bool oneway, bool ppm_mode,
-				  bool ppm_only)
+				  bool ppm_only, bool adaptive)
 {
 	struct pios_rfm22b_dev *rfm22b_dev = (struct pios_rfm22b_dev *)rfm22b_id;
 
@@ -668,9 +699,26 @@ void PIOS_RFM22B_Config(uint32_t rfm22b_id,
 		rfm22b_dev->datarate = datarate;
 	}
 
-	rfm22b_dev->packet_time = (ppm_mode ? packet_time_ppm[datarate] : packet_time[datarate]);
-	if (!rfm22b_dev->one_way_link)
-		rfm22b_dev->packet_time *= 2;  // double the time to allow a send and receive in each slice
+	// The slowest datarate telemetry is sent at along with PPM is the one above the PPM only datarate.
+	rfm22b_dev->min_datarate = ppm_mode ? RFM22B_PPM_ONLY_DATARATE + 1 : RFM22B_ADAPTIVE_MIN_DATARATE;
+	rfm22b_dev->max_datarate = datarate;
+	rfm22b_dev->adaptive = adaptive && !ppm_only && (datarate > rfm22b_dev->min_datarate);
+
+	// An adaptive link starts out slow and speeds up once both ends hear each other well.
+	if (rfm22b_dev->adaptive) {
+		rfm22b_dev->datarate = rfm22b_dev->min_datarate;
+	}
+	rfm22b_dev->datarate_switch_pending = false;
+	rfm22b_dev->datarate_check_ticks = PIOS_Thread_Systime() + RFM22B_ADAPTIVE_CHECK_PERIOD;
+	rfm22b_dev->datarate_hold_ticks = PIOS_Thread_Systime();
+	rfm22b_dev->datarate_good_checks = 0;
+	rfm22b_dev->link_rx_good = 0;
+	rfm22b_dev->link_rx_total = 0;
+	rfm22b_dev->link_score = RFM22B_LINK_SCORE_UNKNOWN;
+	rfm22b_dev->remote_link_score = RFM22B_LINK_SCORE_UNKNOWN;
+	rfm22b_dev->hop_epoch = 0;
+
+	rfm22_setPacketTiming(rfm22b_dev);
 
 	// Find the first N channels that meet the min/max criteria out of the random channel list.
 	uint32_t crc = 0;
@@ -681,6 +729,7 @@ void PIOS_RFM22B_Config(uint32_t rfm22b_id,
 		crc = PIOS_CRC_updateByte(rfm22b_dev->coordinatorID, CRC_INC);
 	}
 
+	// The channels of the slower datarates are the first ones of the fastest.
 	uint8_t num_found = 0;
 	while (num_found < num_channels[datarate]) {
 		crc = PIOS_CRC_updateByte(crc, CRC_INC);
@@ -695,11 +744,26 @@ void PIOS_RFM22B_Config(uint32_t rfm22b_id,
 			rfm22b_dev->channels[num_found++] = chan;
 		}
 	}
+}
+
+/**
+ * Set the slice time and the longest packet that fits in it from the datarate.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static void rfm22_setPacketTiming(struct pios_rfm22b_dev *rfm22b_dev)
+{
+	uint8_t datarate = rfm22b_dev->datarate;
+	bool ppm_mode = rfm22b_dev->ppm_send_mode || rfm22b_dev->ppm_recv_mode;
+
+	rfm22b_dev->packet_time = (ppm_mode ? packet_time_ppm[datarate] : packet_time[datarate]);
+	uint8_t tx_window = rfm22b_dev->packet_time;
+	if (!rfm22b_dev->one_way_link)
+		rfm22b_dev->packet_time *= 2;  // double the time to allow a send and receive in each slice
 
-	// Calculate the maximum packet length from the datarate.
+	// Calculate the maximum packet length that fits in our half of the slice.
 	float bytes_per_period =
-	    (float)data_rate[datarate] * (float)(rfm22b_dev->packet_time -
-						 2) / 9000;
+	    (float)data_rate[datarate] * (float)(tx_window - 2) / 9000;
 
 	rfm22b_dev->max_packet_len =
 	    bytes_per_period - TX_PREAMBLE_NIBBLES / 2 - SYNC_BYTES -
@@ -743,6 +807,13 @@ void PIOS_RFM22B_GetStats(uint32_t rfm22b_id, struct rfm22b_stats *stats)
 	// Calculate the current link quality
 	rfm22_calculateLinkQuality(rfm22b_dev);
 
+	rfm22b_dev->stats.datarate = data_rate[rfm22b_dev->datarate];
+	if (rfm22b_dev->remote_link_score > RFM22B_LINK_SCORE_MAX) {
+		rfm22b_dev->stats.remote_link_quality = 0;
+	} else {
+		rfm22b_dev->stats.remote_link_quality = rfm22b_dev->remote_link_score * 100 / RFM22B_LINK_SCORE_MAX;
+	}
+
 	// Return the stats.
 	memcpy(stats, &rfm22b_dev->stats, sizeof(rfm22b_dev->stats));
 }
@@ -1227,6 +1298,11 @@ static void pios_rfm22_task(void *parameters)
 			rfm22_process_event(rfm22b_dev, RADIO_EVENT_ERROR);
 		}
 
+		// Change the datarate when it's time to.
+		if (rfm22_adaptDatarate(rfm22b_dev)) {
+			rfm22_process_event(rfm22b_dev, RADIO_EVENT_RX_MODE);
+		}
+
 		// Change channels if necessary.
 		if (rfm22_changeChannel(rfm22b_dev)) {
 			rfm22_process_event(rfm22b_dev, RADIO_EVENT_RX_MODE);
@@ -1249,6 +1325,13 @@ static void pios_rfm22_task(void *parameters)
 			D4_LED_OFF;
 		}
 #endif
+		// Our half of the slice is ours alone, so anything still being received
+		// when it starts is noise or a packet that overran its own half. That
+		// is only known once the clock is synchronized to the coordinator.
+		if (time_to_send && rfm22_InRx(rfm22b_dev) &&
+		    (rfm22_isCoordinator(rfm22b_dev) || rfm22_isConnected(rfm22b_dev))) {
+			rfm22_process_event(rfm22b_dev, RADIO_EVENT_RX_MODE);
+		}
 		if (time_to_send && rfm22_InRxWait(rfm22b_dev)) {
 			rfm22_process_event(rfm22b_dev, RADIO_EVENT_TX_START);
 		} else if (time_to_send) {
@@ -1859,6 +1942,11 @@ static enum pios_radio_event radio_txStart(struct pios_rfm22b_dev
 		}
 	}
 
+	// Every packet of an adaptive link tells the other modem about the datarate.
+	if (radio_dev->adaptive) {
+		p[len++] = rfm22_linkControl(radio_dev);
+	}
+
 	// Append data from the com interface if applicable.
 	if (!radio_dev->ppm_only_mode && radio_dev->tx_out_cb) {
 		// Try to get some data to send
@@ -1961,12 +2049,12 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev
 
 		// Attempt to correct any errors in the packet.
 		if (data_len > 0) {
-			decode_data((unsigned char *)p, rx_len);
-			good_packet = check_syndrome() == 0;
+			decode_data(&radio_dev->rs_dec, (unsigned char *)p, rx_len);
+			good_packet = check_syndrome(&radio_dev->rs_dec) == 0;
 
 			// We have an error.  Try to correct it.
 			if (!good_packet &&
-			    (correct_errors_erasures((unsigned char *)p, rx_len, 0, 0) != 0)) {
+			    (correct_errors_erasures(&radio_dev->rs_dec, (unsigned char *)p, rx_len, 0, 0) != 0)) {
 				// We corrected it
 				corrected_packet = true;
 			}
@@ -2032,6 +2120,18 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev
 		}
 	}
 
+	// Take the link control byte off the front of the com data. Corrected
+	// packets still start with their PPM data here.
+	bool have_control = false;
+	uint8_t control = 0;
+	if (radio_dev->adaptive && (data_len > 0) &&
+	    (good_packet || (corrected_packet && !radio_dev->ppm_recv_mode))) {
+		have_control = true;
+		control = p[0];
+		p++;
+		data_len--;
+	}
+
 	// Set the packet status
 	if (good_packet) {
 		rfm22b_add_rx_status(radio_dev, RADIO_GOOD_RX_PACKET);
@@ -2067,6 +2167,13 @@ static enum pios_radio_event radio_receivePacket(struct pios_rfm22b_dev
 
 			rfm22_synchronizeClock(radio_dev);
 		}
+
+		// Datarate changes are only heard with a synchronized clock.
+		if (have_control &&
+		      radio_dev->rx_destination_id == rfm22_destinationID(radio_dev) &&
+		      (rfm22_isCoordinator(radio_dev) || rfm22_isConnected(radio_dev))) {
+			rfm22_processLinkControl(radio_dev, control);
+		}
 	}
 
 	return RADIO_EVENT_RX_COMPLETE;
@@ -2192,6 +2299,21 @@ static void rfm22b_add_rx_status(struct pios_rfm22b_dev *rfm22b_dev,
 
     rx_status_count++;
 
+	// Count what the adaptive datarate scores the link on
+	switch (status) {
+	case RADIO_GOOD_RX_PACKET:
+		rfm22b_dev->link_rx_good++;
+		rfm22b_dev->link_rx_total++;
+		break;
+	case RADIO_CORRECTED_RX_PACKET:
+	case RADIO_ERROR_RX_PACKET:
+	case RADIO_ERROR_RX_SYNC_MISSED:
+		rfm22b_dev->link_rx_total++;
+		break;
+	default:
+		break;
+	}
+
     // Keep the last element in the ring buffer padded to avoid rollover
     // errors counting the statistcs
     if ((rx_status_count % (RFM22B_RX_PACKET_STATS_LEN * 8)) == 0)
@@ -2244,14 +2366,16 @@ static void rfm22_synchronizeClock(struct pios_rfm22b_dev *rfm22b_dev)
 	uint32_t start_time = rfm22b_dev->packet_start_ticks;
 
 	// This packet was transmitted on channel 0, calculate the time delta that will force us to transmit on channel 0 at the time this packet started.
-	uint8_t num_chan = num_channels[rfm22b_dev->datarate];
-	uint16_t frequency_hop_cycle_time = rfm22b_dev->packet_time * num_chan;
+	uint16_t frequency_hop_cycle_time = rfm22_hopCycleTime(rfm22b_dev);
 	uint16_t time_delta = start_time % frequency_hop_cycle_time;
 
 	// Calculate the adjustment for the preamble
 	uint8_t offset = (uint8_t) ceilf(35000.0F / data_rate[rfm22b_dev->datarate]);
 
 	rfm22b_dev->time_delta = frequency_hop_cycle_time - time_delta + offset;
+
+	// Hop cycles now start at multiples of the cycle time again
+	rfm22b_dev->hop_epoch = 0;
 }
 
 /**
@@ -2269,6 +2393,28 @@ static uint32_t rfm22_coordinatorTime(struct pios_rfm22b_dev
 	return ticks + rfm22b_dev->time_delta;
 }
 
+/**
+ * Return the time since the frequency hopping sequence started, which
+ * it does again when the datarate changes.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] ticks  The local clock ticks
+ */
+static uint32_t rfm22_hopTime(struct pios_rfm22b_dev *rfm22b_dev, uint32_t ticks)
+{
+	return rfm22_coordinatorTime(rfm22b_dev, ticks) - rfm22b_dev->hop_epoch;
+}
+
+/**
+ * Return the time it takes to hop through all channels once.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static uint16_t rfm22_hopCycleTime(struct pios_rfm22b_dev *rfm22b_dev)
+{
+	return rfm22b_dev->packet_time * num_channels[rfm22b_dev->datarate];
+}
+
 /**
  * Return true if this modem is in the send interval, which allows the modem to initiate a transmit.
  *
@@ -2276,7 +2422,7 @@ static uint32_t rfm22_coordinatorTime(struct pios_rfm22b_dev
  */
 static bool rfm22_timeToSend(struct pios_rfm22b_dev *rfm22b_dev)
 {
-	uint32_t time = rfm22_coordinatorTime(rfm22b_dev, PIOS_Thread_Systime());
+	uint32_t time = rfm22_hopTime(rfm22b_dev, PIOS_Thread_Systime());
 	bool is_coordinator = rfm22_isCoordinator(rfm22b_dev);
 
 	// If this is a one-way link, only the coordinator can send.
@@ -2339,7 +2485,7 @@ static uint8_t rfm22_calcChannel(struct pios_rfm22b_dev *rfm22b_dev,
  */
 static uint8_t rfm22_calcChannelFromClock(struct pios_rfm22b_dev *rfm22b_dev)
 {
-	uint32_t time = rfm22_coordinatorTime(rfm22b_dev, PIOS_Thread_Systime());
+	uint32_t time = rfm22_hopTime(rfm22b_dev, PIOS_Thread_Systime());
 
 	// Divide time into slices based on the packet_time (determine from the data rate).
 	// Coordinator sends in the first half and the non-coordinator in the second half.
@@ -2366,6 +2512,194 @@ static bool rfm22_changeChannel(struct pios_rfm22b_dev *rfm22b_dev)
 	return rfm22_setFreqHopChannel(rfm22b_dev, channel_idx);
 }
 
+/*****************************************************************************
+* Adaptive Datarate Functions
+*****************************************************************************/
+
+/**
+ * Switch to another datarate, with the hopping sequence starting over at the given time.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] datarate  The new datarate
+ * @param[in] ticks  The local clock ticks the new hopping sequence starts at
+ */
+static void rfm22_changeDatarate(struct pios_rfm22b_dev *rfm22b_dev, uint8_t datarate, uint32_t ticks)
+{
+	rfm22b_dev->datarate = datarate;
+	rfm22_setPacketTiming(rfm22b_dev);
+	rfm22b_dev->hop_epoch = rfm22_coordinatorTime(rfm22b_dev, ticks);
+
+	// The link is scored again at the new datarate
+	rfm22b_dev->datarate_switch_pending = false;
+	rfm22b_dev->datarate_check_ticks = ticks + RFM22B_ADAPTIVE_SETTLE_TIME;
+	rfm22b_dev->datarate_good_checks = 0;
+	rfm22b_dev->link_rx_good = 0;
+	rfm22b_dev->link_rx_total = 0;
+	rfm22b_dev->link_score = RFM22B_LINK_SCORE_UNKNOWN;
+	rfm22b_dev->remote_link_score = RFM22B_LINK_SCORE_UNKNOWN;
+	rfm22b_dev->stats.datarate_changes++;
+
+	pios_rfm22_setDatarate(rfm22b_dev);
+}
+
+/**
+ * Change the datarate at the start of a later hop cycle. The coordinator
+ * announces the change in all packets until then.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] datarate  The new datarate
+ */
+static void rfm22_scheduleDatarate(struct pios_rfm22b_dev *rfm22b_dev, uint8_t datarate)
+{
+	uint32_t now = PIOS_Thread_Systime();
+	uint16_t cycle_time = rfm22_hopCycleTime(rfm22b_dev);
+	uint32_t cycle_start = now - (rfm22_hopTime(rfm22b_dev, now) % cycle_time);
+
+	rfm22b_dev->next_datarate = datarate;
+	rfm22b_dev->datarate_switch_ticks = cycle_start + RFM22B_ADAPTIVE_SWITCH_CYCLES * cycle_time;
+	rfm22b_dev->datarate_switch_pending = true;
+}
+
+/**
+ * Score the link and pick the datarate. Both modems fall back to the
+ * slowest datarate when they lose each other, the coordinator speeds the
+ * link up while both ends receive almost every packet and slows it down
+ * as soon as either end misses too many.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @return true if the datarate changed
+ */
+static bool rfm22_adaptDatarate(struct pios_rfm22b_dev *rfm22b_dev)
+{
+	if (!rfm22b_dev->adaptive) {
+		return false;
+	}
+
+	uint32_t now = PIOS_Thread_Systime();
+	uint8_t datarate = rfm22b_dev->datarate;
+
+	if (rfm22b_dev->datarate_switch_pending &&
+	    ((int32_t)(now - rfm22b_dev->datarate_switch_ticks) >= 0)) {
+		rfm22_changeDatarate(rfm22b_dev, rfm22b_dev->next_datarate, rfm22b_dev->datarate_switch_ticks);
+		return true;
+	}
+
+	if (!rfm22_isConnected(rfm22b_dev)) {
+		rfm22b_dev->datarate_switch_pending = false;
+		if (datarate != rfm22b_dev->min_datarate) {
+			rfm22_changeDatarate(rfm22b_dev, rfm22b_dev->min_datarate, now);
+			return true;
+		}
+		return false;
+	}
+
+	if ((int32_t)(now - rfm22b_dev->datarate_check_ticks) < 0) {
+		return false;
+	}
+	rfm22b_dev->datarate_check_ticks = now + RFM22B_ADAPTIVE_CHECK_PERIOD;
+
+	// Wait for enough packets to score the link on, a slow link with little traffic takes a few periods.
+	if (rfm22b_dev->link_rx_total < RFM22B_ADAPTIVE_MIN_SAMPLES) {
+		return false;
+	}
+	rfm22b_dev->link_score = RFM22B_LINK_SCORE_MAX * rfm22b_dev->link_rx_good / rfm22b_dev->link_rx_total;
+	rfm22b_dev->link_rx_good = 0;
+	rfm22b_dev->link_rx_total = 0;
+
+	// The coordinator decides for both ends.
+	if (!rfm22_isCoordinator(rfm22b_dev) || rfm22b_dev->datarate_switch_pending) {
+		return false;
+	}
+
+	uint8_t local = rfm22b_dev->link_score;
+	uint8_t remote = rfm22b_dev->remote_link_score;
+	bool remote_known = remote != RFM22B_LINK_SCORE_UNKNOWN;
+
+	if ((local < RFM22B_LINK_SCORE_DOWN) || (remote_known && (remote < RFM22B_LINK_SCORE_DOWN))) {
+		rfm22b_dev->datarate_good_checks = 0;
+		if (datarate > rfm22b_dev->min_datarate) {
+			rfm22_scheduleDatarate(rfm22b_dev, datarate - 1);
+			rfm22b_dev->datarate_hold_ticks = now + RFM22B_ADAPTIVE_HOLD_TIME;
+		}
+	} else if (remote_known && (local >= RFM22B_LINK_SCORE_UP) && (remote >= RFM22B_LINK_SCORE_UP)) {
+		if ((datarate < rfm22b_dev->max_datarate) &&
+		    ((int32_t)(now - rfm22b_dev->datarate_hold_ticks) >= 0) &&
+		    (++rfm22b_dev->datarate_good_checks >= RFM22B_ADAPTIVE_UP_CHECKS)) {
+			rfm22b_dev->datarate_good_checks = 0;
+			rfm22_scheduleDatarate(rfm22b_dev, datarate + 1);
+		}
+	} else {
+		rfm22b_dev->datarate_good_checks = 0;
+	}
+
+	return false;
+}
+
+/**
+ * Build the link control byte sent in front of the com data.
+ * From the coordinator it holds the datarate, which is the next one while
+ * a change is announced, and the hop cycles left until that change.
+ * From the other modem it holds its datarate and link score.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @return the link control byte
+ */
+static uint8_t rfm22_linkControl(struct pios_rfm22b_dev *rfm22b_dev)
+{
+	if (!rfm22_isCoordinator(rfm22b_dev)) {
+		return rfm22b_dev->datarate | (rfm22b_dev->link_score << 4);
+	}
+
+	if (!rfm22b_dev->datarate_switch_pending) {
+		return rfm22b_dev->datarate;
+	}
+
+	uint32_t now = PIOS_Thread_Systime();
+	uint16_t cycle_time = rfm22_hopCycleTime(rfm22b_dev);
+	uint32_t cycle_start = now - (rfm22_hopTime(rfm22b_dev, now) % cycle_time);
+	uint32_t cycles = (rfm22b_dev->datarate_switch_ticks - cycle_start) / cycle_time;
+	if (cycles == 0) {
+		cycles = 1;
+	} else if (cycles > 15) {
+		cycles = 15;
+	}
+
+	return rfm22b_dev->next_datarate | (cycles << 4);
+}
+
+/**
+ * Act on the link control byte of a packet from the other modem.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ * @param[in] control  The link control byte
+ */
+static void rfm22_processLinkControl(struct pios_rfm22b_dev *rfm22b_dev, uint8_t control)
+{
+	uint8_t datarate = control & 0x0F;
+
+	if (rfm22_isCoordinator(rfm22b_dev)) {
+		if (datarate == rfm22b_dev->datarate) {
+			rfm22b_dev->remote_link_score = control >> 4;
+		}
+		return;
+	}
+
+	// Count the announced hop cycles from the start of the one this packet was sent in.
+	uint8_t cycles = control >> 4;
+	if ((cycles == 0) || (datarate == rfm22b_dev->datarate) ||
+	    (datarate < rfm22b_dev->min_datarate) || (datarate > rfm22b_dev->max_datarate)) {
+		return;
+	}
+
+	uint32_t now = PIOS_Thread_Systime();
+	uint16_t cycle_time = rfm22_hopCycleTime(rfm22b_dev);
+	uint32_t cycle_start = now - (rfm22_hopTime(rfm22b_dev, now) % cycle_time);
+
+	rfm22b_dev->next_datarate = datarate;
+	rfm22b_dev->datarate_switch_ticks = cycle_start + cycles * cycle_time;
+	rfm22b_dev->datarate_switch_pending = true;
+}
+
 /*****************************************************************************
 * Error Handling Functions
 *****************************************************************************/
@@ -2515,6 +2849,17 @@ bool rfm22_InRxWait(struct pios_rfm22b_dev *rfm22b_dev)
 	return false;
 }
 
+/**
+ * Returns true if the modem is in the middle of receiving a packet.
+ *
+ * @param[in] rfm22b_dev  The device structure
+ */
+static bool rfm22_InRx(struct pios_rfm22b_dev *rfm22b_dev)
+{
+	return (rfm22b_dev->rfm22b_state == RFM22B_STATE_RX_WAIT_SYNC) ||
+	       (rfm22b_dev->rfm22b_state == RFM22B_STATE_RX_MODE);
+}
+
 /**
  * Turn off all of the LEDs
  */
@@ -2570,7 +2915,7 @@ static void rfm22_deassertCs(struct pios_rfm22b_dev *rfm22b_dev)
 static void rfm22_claimBus(struct pios_rfm22b_dev *rfm22b_dev)
 {
 	if (rfm22b_dev->spi_id != 0) {
-		PIOS_SPI_ClaimBus(rfm22b_dev->spi_id);
+		PIOS_SPI_ClaimBusPriority(rfm22b_dev->spi_id, PIOS_SPI_PRIORITY_REALTIME);
 	}
 }
 
@@ -0,0 +1,217 @@
+/**
+ ******************************************************************************
+ * @file       pios_ringbuf.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Ringbuf Single producer / single consumer ring buffer
+ * @{
+ * @brief Lock-free ring buffer of fixed size items accessed in place
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "pios_ringbuf.h"
+#include "pios_semaphore.h"
+
+//! Make sure the slot contents are visible before the index moves
+#define RINGBUF_BARRIER() __sync_synchronize()
+
+static inline uint16_t ringbuf_next(const struct pios_ringbuf *rb, uint16_t idx)
+{
+	idx++;
+	if (idx >= rb->num_slots)
+		idx = 0;
+
+	return idx;
+}
+
+/**
+ * @brief Create a ring buffer
+ * @param[in] length Number of items the ring can hold
+ * @param[in] item_size Size of each item in bytes
+ * @returns instance of @p struct pios_ringbuf or NULL on failure
+ */
+struct pios_ringbuf *PIOS_Ringbuf_Create(uint16_t length, uint16_t item_size)
+{
+	if (length == 0 || length == 0xffff || item_size == 0)
+		return NULL;
+
+	struct pios_ringbuf *rb = PIOS_malloc_no_dma(sizeof(*rb));
+	if (rb == NULL)
+		return NULL;
+
+	rb->item_size = item_size;
+	rb->num_slots = length + 1;
+	rb->head = 0;
+	rb->tail = 0;
+	rb->overruns = 0;
+
+	rb->items = PIOS_malloc_no_dma((size_t)rb->num_slots * item_size);
+	if (rb->items == NULL) {
+		PIOS_free(rb);
+		return NULL;
+	}
+
+	rb->data_ready = PIOS_Semaphore_Create();
+	if (rb->data_ready == NULL) {
+		PIOS_free(rb->items);
+		PIOS_free(rb);
+		return NULL;
+	}
+
+	return rb;
+}
+
+/**
+ * @brief Destroy a ring buffer
+ * @note The semaphore cannot be deleted through the PIOS abstraction and
+ * is leaked, which is fine for the init time error paths that call this.
+ */
+void PIOS_Ringbuf_Delete(struct pios_ringbuf *rb)
+{
+	PIOS_free(rb->items);
+	PIOS_free(rb);
+}
+
+/**
+ * @brief Claim the next free slot for the producer to fill in place
+ * @returns pointer to the slot or NULL when the ring is full. In the
+ * latter case the sample is counted as an overrun.
+ */
+void *PIOS_Ringbuf_WriteClaim(struct pios_ringbuf *rb)
+{
+	uint16_t head = rb->head;
+
+	if (ringbuf_next(rb, head) == rb->tail) {
+		rb->overruns++;
+		return NULL;
+	}
+
+	return &rb->items[(size_t)head * rb->item_size];
+}
+
+static void ringbuf_publish(struct pios_ringbuf *rb)
+{
+	RINGBUF_BARRIER();
+	rb->head = ringbuf_next(rb, rb->head);
+}
+
+/**
+ * @brief Publish the slot returned by the last @ref PIOS_Ringbuf_WriteClaim
+ * and wake the consumer
+ */
+void PIOS_Ringbuf_WriteCommit(struct pios_ringbuf *rb)
+{
+	ringbuf_publish(rb);
+	PIOS_Semaphore_Give(rb->data_ready);
+}
+
+/**
+ * @brief Publish the slot returned by the last @ref PIOS_Ringbuf_WriteClaim
+ * from interrupt context
+ * @param[out] woken set to true if a higher priority task was woken
+ */
+void PIOS_Ringbuf_WriteCommit_FromISR(struct pios_ringbuf *rb, bool *woken)
+{
+	ringbuf_publish(rb);
+	PIOS_Semaphore_Give_FromISR(rb->data_ready, woken);
+}
+
+/**
+ * @brief Get the oldest item without removing it
+ * @returns pointer to the item or NULL if the ring is empty. The pointer
+ * stays valid until @ref PIOS_Ringbuf_ReadRelease is called.
+ */
+const void *PIOS_Ringbuf_ReadPeek(struct pios_ringbuf *rb)
+{
+	uint16_t tail = rb->tail;
+
+	if (tail == rb->head)
+		return NULL;
+
+	RINGBUF_BARRIER();
+
+	return &rb->items[(size_t)tail * rb->item_size];
+}
+
+/**
+ * @brief Give the slot returned by @ref PIOS_Ringbuf_ReadPeek back to the
+ * producer
+ */
+void PIOS_Ringbuf_ReadRelease(struct pios_ringbuf *rb)
+{
+	uint16_t tail = rb->tail;
+
+	if (tail == rb->head)
+		return;
+
+	RINGBUF_BARRIER();
+	rb->tail = ringbuf_next(rb, tail);
+}
+
+/**
+ * @brief Block the consumer until an item is available
+ * @param[in] timeout_ms maximum time to wait in milliseconds
+ * @returns true if an item can be read, false on timeout
+ */
+bool PIOS_Ringbuf_Wait(struct pios_ringbuf *rb, uint32_t timeout_ms)
+{
+	if (rb->tail != rb->head)
+		return true;
+
+	/* The semaphore may still hold a wakeup for an item that was already
+	 * consumed.  Drain it and check again, anything committed after the
+	 * second check will give the semaphore again. */
+	PIOS_Semaphore_Take(rb->data_ready, 0);
+	if (rb->tail != rb->head)
+		return true;
+
+	if (timeout_ms == 0)
+		return false;
+
+	PIOS_Semaphore_Take(rb->data_ready, timeout_ms);
+
+	return rb->tail != rb->head;
+}
+
+/**
+ * @brief Get the number of items waiting to be read
+ */
+uint16_t PIOS_Ringbuf_GetUsed(const struct pios_ringbuf *rb)
+{
+	uint16_t head = rb->head;
+	uint16_t tail = rb->tail;
+
+	if (head >= tail)
+		return head - tail;
+
+	return rb->num_slots - tail + head;
+}
+
+/**
+ * @brief Get the number of items the producer had to drop
+ */
+uint32_t PIOS_Ringbuf_GetOverruns(const struct pios_ringbuf *rb)
+{
+	return rb->overruns;
+}
+
+/**
+  * @}
+  * @}
+  */
@@ -32,6 +32,7 @@
 /* Project Includes */
 #include "pios.h"
 #include "pios_sbus_priv.h"
+#include "pios_semaphore.h"
 
 #if defined(PIOS_INCLUDE_SBUS)
 
@@ -42,12 +43,14 @@ static uint16_t PIOS_SBus_RxInCallback(uintptr_t context,
 				       uint16_t buf_len,
 				       uint16_t *headroom,
 				       bool *need_yield);
+static struct pios_semaphore *PIOS_SBus_GetSemaphore(uintptr_t rcvr_id, uint8_t channel);
 static void PIOS_SBus_Supervisor(uintptr_t sbus_id);
 
 
 /* Local Variables */
 const struct pios_rcvr_driver pios_sbus_rcvr_driver = {
 	.read = PIOS_SBus_Get,
+	.get_semaphore = PIOS_SBus_GetSemaphore,
 };
 
 enum pios_sbus_dev_magic {
@@ -67,6 +70,7 @@ struct pios_sbus_dev {
 	enum pios_sbus_dev_magic magic;
 	const struct pios_sbus_cfg *cfg;
 	struct pios_sbus_state state;
+	struct pios_semaphore *frame_sema;
 };
 
 /* Allocate S.Bus device descriptor */
@@ -77,6 +81,12 @@ static struct pios_sbus_dev *PIOS_SBus_Alloc(void)
 	sbus_dev = (struct pios_sbus_dev *)PIOS_malloc(sizeof(*sbus_dev));
 	if (!sbus_dev) return(NULL);
 
+	sbus_dev->frame_sema = PIOS_Semaphore_Create();
+	if (!sbus_dev->frame_sema) {
+		PIOS_free(sbus_dev);
+		return(NULL);
+	}
+
 	sbus_dev->magic = PIOS_SBUS_DEV_MAGIC;
 	return(sbus_dev);
 }
@@ -207,12 +217,17 @@ static void PIOS_SBus_UnrollChannels(struct pios_sbus_state *state)
 	*d++ = (s[22] & SBUS_FLAG_DC2) ? SBUS_VALUE_MAX : SBUS_VALUE_MIN;
 }
 
-/* Update decoder state processing input byte from the S.Bus stream */
-static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
+/**
+ * Update decoder state processing input byte from the S.Bus stream
+ * \return true when the byte completed a frame
+ */
+static bool PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 {
+	bool complete = false;
+
 	/* should not process any data until new frame is found */
 	if (!state->frame_found)
-		return;
+		return false;
 
 	if (state->byte_count == 0) {
 		if (b != SBUS_SOF_BYTE) {
@@ -222,7 +237,7 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 			/* do not store the SOF byte */
 			state->byte_count++;
 		}
-		return;
+		return false;
 	}
 
 	/* do not store last frame byte as well */
@@ -244,6 +259,7 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 				PIOS_SBus_UnrollChannels(state);
 				state->failsafe_timer = 0;
 			}
+			complete = true;
 		} else {
 			/* discard whole frame */
 		}
@@ -251,6 +267,8 @@ static void PIOS_SBus_UpdateState(struct pios_sbus_state *state, uint8_t b)
 		/* prepare for the next frame */
 		state->frame_found = 0;
 	}
+
+	return complete;
 }
 
 /* Comm byte received callback */
@@ -267,9 +285,13 @@ static uint16_t PIOS_SBus_RxInCallback(uintptr_t context,
 
 	struct pios_sbus_state *state = &(sbus_dev->state);
 
+	*need_yield = false;
+
 	/* process byte(s) and clear receive timer */
 	for (uint8_t i = 0; i < buf_len; i++) {
-		PIOS_SBus_UpdateState(state, buf[i]);
+		/* wake whoever waits for the channels right away */
+		if (PIOS_SBus_UpdateState(state, buf[i]))
+			PIOS_Semaphore_Give_FromISR(sbus_dev->frame_sema, need_yield);
 		state->receive_timer = 0;
 	}
 
@@ -277,13 +299,21 @@ static uint16_t PIOS_SBus_RxInCallback(uintptr_t context,
 	if (headroom)
 		*headroom = SBUS_FRAME_LENGTH;
 
-	/* We never need a yield */
-	*need_yield = false;
-
 	/* Always indicate that all bytes were consumed */
 	return buf_len;
 }
 
+/* All channels come with the same frame */
+static struct pios_semaphore *PIOS_SBus_GetSemaphore(uintptr_t rcvr_id, uint8_t channel)
+{
+	struct pios_sbus_dev *sbus_dev = (struct pios_sbus_dev *)rcvr_id;
+
+	if (!PIOS_SBus_Validate(sbus_dev))
+		return NULL;
+
+	return sbus_dev->frame_sema;
+}
+
 /**
  * Input data supervisor is called periodically and provides
  * two functions: frame syncing and failsafe triggering.
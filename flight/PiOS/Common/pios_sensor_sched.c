@@ -0,0 +1,159 @@
+/**
+ ******************************************************************************
+ * @file       pios_sensor_sched.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Sensor_Sched Shared sensor driver thread
+ * @{
+ * @brief Runs the state machines of all the sensor drivers on one thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "pios_sensor_sched.h"
+#include "pios_semaphore.h"
+#include "pios_thread.h"
+
+#define SENSOR_SCHED_TASK_PRIORITY PIOS_THREAD_PRIO_HIGHEST
+
+struct sensor_sched_driver {
+	pios_sensor_sched_step_t step;
+	void *ctx;
+	uint32_t next_run;		/* systime of the next call unless waiting */
+	bool waiting;			/* only an event runs the step */
+	volatile bool pending;		/* set from the interrupt */
+};
+
+static struct sensor_sched_driver drivers[PIOS_SENSOR_SCHED_MAX_DRIVERS];
+static volatile uint8_t num_drivers;
+static struct pios_semaphore *wakeup;
+static struct pios_thread *task;
+
+static void PIOS_SENSOR_SCHED_Task(void *parameters);
+
+/**
+ * @brief Add a driver to the sensor thread, starting the thread if needed
+ * @param[in] step Called from the sensor thread to advance the driver
+ * @param[in] ctx Passed to each call of step
+ * @param[in] first_delay_ms When to call step for the first time, or
+ *            PIOS_SENSOR_SCHED_WAIT_EVENT to wait for the interrupt
+ * @returns the id to signal the driver with, negative on failure
+ */
+int32_t PIOS_SENSOR_SCHED_Register(pios_sensor_sched_step_t step, void *ctx, uint32_t first_delay_ms)
+{
+	if (step == NULL)
+		return -1;
+
+	if (num_drivers >= PIOS_SENSOR_SCHED_MAX_DRIVERS)
+		return -2;
+
+	if (wakeup == NULL) {
+		wakeup = PIOS_Semaphore_Create();
+		if (wakeup == NULL)
+			return -3;
+	}
+
+	struct sensor_sched_driver *drv = &drivers[num_drivers];
+	drv->step = step;
+	drv->ctx = ctx;
+	drv->pending = false;
+	drv->waiting = (first_delay_ms == PIOS_SENSOR_SCHED_WAIT_EVENT);
+	drv->next_run = PIOS_Thread_Systime() + (drv->waiting ? 0 : first_delay_ms);
+
+	/* Only make the entry visible to the thread once it is filled in */
+	__sync_synchronize();
+	int32_t driver_id = num_drivers++;
+
+	if (task == NULL) {
+		task = PIOS_Thread_Create(PIOS_SENSOR_SCHED_Task, "pios_sensors",
+				PIOS_SENSOR_SCHED_STACK_BYTES, NULL, SENSOR_SCHED_TASK_PRIORITY);
+		PIOS_Assert(task != NULL);
+	} else {
+		PIOS_Semaphore_Give(wakeup);
+	}
+
+	return driver_id;
+}
+
+/**
+ * @brief Have the step of a driver run as soon as possible
+ * @param[in] driver_id As returned by PIOS_SENSOR_SCHED_Register
+ * @returns true if a higher priority task was woken
+ */
+bool PIOS_SENSOR_SCHED_Signal_FromISR(int32_t driver_id)
+{
+	if (driver_id < 0 || driver_id >= num_drivers)
+		return false;
+
+	drivers[driver_id].pending = true;
+
+	bool woken = false;
+	PIOS_Semaphore_Give_FromISR(wakeup, &woken);
+
+	return woken;
+}
+
+/**
+ * The sensor thread. Runs every step that is due or signalled and then
+ * sleeps until the next one is due or an interrupt comes in.
+ */
+static void PIOS_SENSOR_SCHED_Task(void *parameters)
+{
+	while (1) {
+		uint32_t now = PIOS_Thread_Systime();
+		uint32_t timeout = PIOS_SEMAPHORE_TIMEOUT_MAX;
+
+		for (uint8_t i = 0; i < num_drivers; i++) {
+			struct sensor_sched_driver *drv = &drivers[i];
+
+			bool due = drv->pending ||
+				(!drv->waiting && (int32_t)(now - drv->next_run) >= 0);
+
+			if (due) {
+				drv->pending = false;
+
+				uint32_t delay = drv->step(drv->ctx);
+
+				drv->waiting = (delay == PIOS_SENSOR_SCHED_WAIT_EVENT);
+				if (!drv->waiting)
+					drv->next_run = now + delay;
+
+				/* The step took time, look again before sleeping */
+				now = PIOS_Thread_Systime();
+			}
+
+			if (drv->pending) {
+				timeout = 0;
+			} else if (!drv->waiting) {
+				int32_t left = drv->next_run - now;
+				if (left <= 0)
+					timeout = 0;
+				else if ((uint32_t)left < timeout)
+					timeout = left;
+			}
+		}
+
+		if (timeout > 0)
+			PIOS_Semaphore_Take(wakeup, timeout);
+	}
+}
+
+/**
+  * @}
+  * @}
+  */
@@ -36,13 +36,21 @@
 
 //! The list of queue handles
 static struct pios_queue *queues[PIOS_SENSOR_LAST];
+//! The list of ring buffers for sensors that deliver samples in place
+static struct pios_ringbuf *ringbufs[PIOS_SENSOR_LAST];
+//! Time of the interrupt behind the latest sample, for drivers that set it
+static volatile uint32_t sample_times[PIOS_SENSOR_LAST];
+//! Time the samples behind the latest published update were taken
+static volatile uint32_t update_times[PIOS_SENSOR_LAST];
 static int32_t max_gyro_rate;
 
 //! Initialize the sensors interface
 int32_t PIOS_SENSORS_Init()
 {
-	for (uint32_t i = 0; i < PIOS_SENSOR_LAST; i++)
+	for (uint32_t i = 0; i < PIOS_SENSOR_LAST; i++) {
 		queues[i] = NULL;
+		ringbufs[i] = NULL;
+	}
 
 	return 0;
 }
@@ -50,7 +58,7 @@ int32_t PIOS_SENSORS_Init()
 //! Register a sensor with the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue)
 {
-	if(queues[type] != NULL)
+	if(queues[type] != NULL || ringbufs[type] != NULL)
 		return -1;
 
 	queues[type] = queue;
@@ -58,13 +66,24 @@ int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *que
 	return 0;
 }
 
+//! Register a sensor that delivers samples through a ring buffer
+int32_t PIOS_SENSORS_RegisterRingbuf(enum pios_sensor_type type, struct pios_ringbuf *ringbuf)
+{
+	if(queues[type] != NULL || ringbufs[type] != NULL)
+		return -1;
+
+	ringbufs[type] = ringbuf;
+
+	return 0;
+}
+
 //! Checks if a sensor type is registered with the PIOS_SENSORS interface
 bool PIOS_SENSORS_IsRegistered(enum pios_sensor_type type)
 {
 	if(type >= PIOS_SENSOR_LAST)
 		return false;
 
-	if(queues[type] != NULL)
+	if(queues[type] != NULL || ringbufs[type] != NULL)
 		return true;
 
 	return false;
@@ -79,6 +98,108 @@ struct pios_queue *PIOS_SENSORS_GetQueue(enum pios_sensor_type type)
 	return queues[type];
 }
 
+//! Get the ring buffer for a sensor type
+struct pios_ringbuf *PIOS_SENSORS_GetRingbuf(enum pios_sensor_type type)
+{
+	if (type >= PIOS_SENSOR_LAST)
+		return NULL;
+
+	return ringbufs[type];
+}
+
+/**
+ * @brief Get the next sample for a sensor type
+ *
+ * Sensors registered with a ring buffer hand out a pointer to the sample in
+ * the ring without copying it. Sensors registered with a queue receive the
+ * sample into @p copy. Either way the sample must be given back with
+ * @ref PIOS_SENSORS_ReleaseSample once it has been used.
+ *
+ * @param[in] type The sensor type
+ * @param[out] copy Storage for the sample if the sensor uses a queue
+ * @param[in] timeout_ms How long to wait for a sample
+ * @returns pointer to the sample or NULL if none arrived in time
+ */
+const void *PIOS_SENSORS_GetSample(enum pios_sensor_type type, void *copy, uint32_t timeout_ms)
+{
+	if (type >= PIOS_SENSOR_LAST)
+		return NULL;
+
+	if (ringbufs[type] != NULL) {
+		if (!PIOS_Ringbuf_Wait(ringbufs[type], timeout_ms))
+			return NULL;
+		return PIOS_Ringbuf_ReadPeek(ringbufs[type]);
+	}
+
+	if (queues[type] != NULL && PIOS_Queue_Receive(queues[type], copy, timeout_ms))
+		return copy;
+
+	return NULL;
+}
+
+//! Release a sample obtained with PIOS_SENSORS_GetSample
+void PIOS_SENSORS_ReleaseSample(enum pios_sensor_type type)
+{
+	if (type >= PIOS_SENSOR_LAST)
+		return;
+
+	if (ringbufs[type] != NULL)
+		PIOS_Ringbuf_ReadRelease(ringbufs[type]);
+}
+
+/**
+ * @brief Record when the latest sample of a sensor was taken
+ *
+ * Called by drivers from their data ready interrupt so the latency of
+ * the control loop can be measured from the real sample time.
+ *
+ * @param[in] type The sensor type
+ * @param[in] raw_time PIOS_DELAY_GetRaw() time of the interrupt
+ */
+void PIOS_SENSORS_SetSampleTime(enum pios_sensor_type type, uint32_t raw_time)
+{
+	if (type >= PIOS_SENSOR_LAST)
+		return;
+
+	sample_times[type] = raw_time;
+}
+
+//! Get the time recorded with PIOS_SENSORS_SetSampleTime, zero if never set
+uint32_t PIOS_SENSORS_GetSampleTime(enum pios_sensor_type type)
+{
+	if (type >= PIOS_SENSOR_LAST)
+		return 0;
+
+	return sample_times[type];
+}
+
+/**
+ * @brief Record when the samples behind the latest update were taken
+ *
+ * Called by the sensors module before it publishes the data of a sensor,
+ * so the estimators integrate over the time between the samples instead
+ * of the time between their own runs.
+ *
+ * @param[in] type The sensor type
+ * @param[in] raw_time PIOS_DELAY_GetRaw() time of the samples
+ */
+void PIOS_SENSORS_SetUpdateTime(enum pios_sensor_type type, uint32_t raw_time)
+{
+	if (type >= PIOS_SENSOR_LAST)
+		return;
+
+	update_times[type] = raw_time;
+}
+
+//! Get the time recorded with PIOS_SENSORS_SetUpdateTime, zero if never set
+uint32_t PIOS_SENSORS_GetUpdateTime(enum pios_sensor_type type)
+{
+	if (type >= PIOS_SENSOR_LAST)
+		return 0;
+
+	return update_times[type];
+}
+
 //! Set the maximum gyro rate in deg/s
 void PIOS_SENSORS_SetMaxGyro(int32_t rate)
 {
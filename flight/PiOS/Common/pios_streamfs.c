@@ -968,7 +968,7 @@ static void PIOS_STREAMFS_TxStart(uintptr_t fs_id, uint16_t tx_bytes_avail)
 		if (bytes_to_write <= 0)
 			break;
 
-		if (streamfs_append_to_file (streamfs, streamfs->com_buffer, bytes_to_write) != 0) {
+		if (streamfs_append_to_file (streamfs, streamfs->com_buffer, bytes_to_write) < 0) {
 			goto out_end_trans;
 		}
 	}
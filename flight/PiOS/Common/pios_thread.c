@@ -74,6 +74,52 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	return thread;
 }
 
+/**
+ *
+ * @brief   Creates a thread with its stack in fast (not DMA-safe) memory.
+ *
+ * @note    Only for threads that never hand automatic variables to a DMA
+ *          driver, e.g. pure computation tasks like stabilization.
+ *
+ * @param[in] fp           pointer to thread function
+ * @param[in] namep        pointer to thread name
+ * @param[in] stack_bytes  stack size in bytes
+ * @param[in] argp         pointer to argument which will be passed to thread function
+ * @param[in] prio         thread priority
+ *
+ * @returns instance of @p struct pios_thread or NULL on failure
+ *
+ */
+struct pios_thread *PIOS_Thread_Create_Fast(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	struct pios_thread *thread = PIOS_malloc_no_dma(sizeof(struct pios_thread));
+
+	if (thread == NULL)
+		return NULL;
+
+	thread->task_handle = (uintptr_t)NULL;
+
+	portSTACK_TYPE *stackp = PIOS_malloc_no_dma(stack_bytes);
+	if (stackp == NULL)
+	{
+		PIOS_free(thread);
+		return NULL;
+	}
+
+	if (xTaskGenericCreate(fp, (signed char*)namep, stack_bytes / 4, argp, prio, (xTaskHandle*)&thread->task_handle, stackp, NULL) != pdPASS)
+	{
+		PIOS_free(stackp);
+		PIOS_free(thread);
+		return NULL;
+	}
+
+	return thread;
+#else
+	return PIOS_Thread_Create(fp, namep, stack_bytes, argp, prio);
+#endif /* defined(PIOS_INCLUDE_FASTHEAP) */
+}
+
 #if (INCLUDE_vTaskDelete == 1)
 /**
  *
@@ -181,6 +227,49 @@ uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp)
 #endif /* (INCLUDE_uxTaskGetRunTime == 1) */
 }
 
+/**
+ *
+ * @brief   Returns the number of times a thread was switched in.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ *
+ * @return always 0, FreeRTOS does not count context switches
+ *
+ */
+uint32_t PIOS_Thread_Get_Context_Switches(struct pios_thread *threadp)
+{
+	return 0;
+}
+
+/**
+ *
+ * @brief   Returns the longest time a thread waited to run after a wakeup.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ *
+ * @return always 0, FreeRTOS does not track the wakeup latency
+ *
+ */
+uint32_t PIOS_Thread_Get_Max_Latency(struct pios_thread *threadp)
+{
+	return 0;
+}
+
+/**
+ *
+ * @brief   Returns the time spent in the idle thread since the last call.
+ *
+ * @param[out] idle_ticks  counter ticks the idle thread ran
+ * @param[out] total_ticks counter ticks elapsed
+ *
+ * @return always false, FreeRTOS does not time the idle thread
+ *
+ */
+bool PIOS_Thread_Get_Idle_Time(uint32_t *idle_ticks, uint32_t *total_ticks)
+{
+	return false;
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
@@ -221,13 +310,15 @@ static uint32_t ceil_size(uint32_t size)
  * memory and return an address that has the requested size
  * or more with these constraints.
  */
-static uint8_t * align8_alloc(uint32_t size)
+static uint8_t * align8_alloc(uint32_t size, bool no_dma)
 {
 	// round size up to at nearest multiple of 8 + 4 bytes to guarantee
 	// sufficient size within. This is because PIOS_malloc only guarantees
 	// uintptr_t alignment which is 4 bytes.
 	size = size + sizeof(uintptr_t);
-	uint8_t *wap = PIOS_malloc(size);
+	uint8_t *wap = no_dma ? PIOS_malloc_no_dma(size) : PIOS_malloc(size);
+	if (wap == NULL)
+		return NULL;
 
 	// shift start point to nearest 8 byte boundary.
 	uint32_t pad = ((uint32_t) wap) % sizeof(stkalign_t);
@@ -236,20 +327,7 @@ static uint8_t * align8_alloc(uint32_t size)
 	return wap;
 }
 
-/**
- *
- * @brief   Creates a thread.
- *
- * @param[in] fp           pointer to thread function
- * @param[in] namep        pointer to thread name
- * @param[in] stack_bytes  stack size in bytes
- * @param[in] argp         pointer to argument which will be passed to thread function
- * @param[in] prio         thread priority
- *
- * @returns instance of @p struct pios_thread or NULL on failure
- *
- */
-struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+static struct pios_thread *thread_create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio, bool fast_stack)
 {
 	struct pios_thread *thread = PIOS_malloc_no_dma(sizeof(struct pios_thread));
 	if (thread == NULL)
@@ -263,7 +341,7 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 
 	// Use special functions to ensure ChibiOS stack requirements
 	stack_bytes = ceil_size(stack_bytes);
-	uint8_t *wap = align8_alloc(stack_bytes);
+	uint8_t *wap = align8_alloc(stack_bytes, fast_stack);
 	if (wap == NULL)
 	{
 		PIOS_free(thread);
@@ -285,6 +363,45 @@ struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, si
 	return thread;
 }
 
+/**
+ *
+ * @brief   Creates a thread.
+ *
+ * @param[in] fp           pointer to thread function
+ * @param[in] namep        pointer to thread name
+ * @param[in] stack_bytes  stack size in bytes
+ * @param[in] argp         pointer to argument which will be passed to thread function
+ * @param[in] prio         thread priority
+ *
+ * @returns instance of @p struct pios_thread or NULL on failure
+ *
+ */
+struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	return thread_create(fp, namep, stack_bytes, argp, prio, false);
+}
+
+/**
+ *
+ * @brief   Creates a thread with its stack in fast (not DMA-safe) memory.
+ *
+ * @note    Only for threads that never hand automatic variables to a DMA
+ *          driver, e.g. pure computation tasks like stabilization.
+ *
+ * @param[in] fp           pointer to thread function
+ * @param[in] namep        pointer to thread name
+ * @param[in] stack_bytes  stack size in bytes
+ * @param[in] argp         pointer to argument which will be passed to thread function
+ * @param[in] prio         thread priority
+ *
+ * @returns instance of @p struct pios_thread or NULL on failure
+ *
+ */
+struct pios_thread *PIOS_Thread_Create_Fast(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio)
+{
+	return thread_create(fp, namep, stack_bytes, argp, prio, true);
+}
+
 #if (CH_USE_WAITEXIT == TRUE)
 /**
  *
@@ -406,6 +523,84 @@ uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp)
 	return result;
 }
 
+/**
+ *
+ * @brief   Returns the number of times a thread was switched in since the
+ *          last call.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ *
+ * @return number of context switches into the thread
+ *
+ */
+uint32_t PIOS_Thread_Get_Context_Switches(struct pios_thread *threadp)
+{
+	chSysLock();
+
+	uint32_t result = threadp->threadp->switches;
+	threadp->threadp->switches = 0;
+
+	chSysUnlock();
+
+	return result;
+}
+
+/**
+ *
+ * @brief   Returns the longest time a thread waited to run after it was
+ *          woken up, since the last call.
+ *
+ * @param[in] threadp      pointer to instance of @p struct pios_thread
+ *
+ * @return latency in microseconds
+ *
+ */
+uint32_t PIOS_Thread_Get_Max_Latency(struct pios_thread *threadp)
+{
+	chSysLock();
+
+	halrtcnt_t ticks = threadp->threadp->ticks_max_latency;
+	threadp->threadp->ticks_max_latency = 0;
+
+	chSysUnlock();
+
+	return (uint64_t) ticks * 1000000 / halGetCounterFrequency();
+}
+
+/**
+ *
+ * @brief   Returns the time spent in the idle thread since the last call.
+ *
+ * The context switch hook times every thread with the cycle counter, so
+ * this is a measurement rather than a count of idle loops that has to be
+ * calibrated per target. The idle thread is not running while its caller
+ * is, so its total is up to date.
+ *
+ * @param[out] idle_ticks  counter ticks the idle thread ran
+ * @param[out] total_ticks counter ticks elapsed
+ *
+ * @return true
+ *
+ */
+bool PIOS_Thread_Get_Idle_Time(uint32_t *idle_ticks, uint32_t *total_ticks)
+{
+	static halrtcnt_t last_ticks;
+
+	chSysLock();
+
+	Thread *idle = chSysGetIdleThread();
+	halrtcnt_t now = halGetCounterValue();
+
+	*idle_ticks = idle->ticks_total;
+	*total_ticks = now - last_ticks;
+	idle->ticks_total = 0;
+	last_ticks = now;
+
+	chSysUnlock();
+
+	return true;
+}
+
 /**
  *
  * @brief   Suspends execution of all threads.
@@ -0,0 +1,163 @@
+/**
+ ******************************************************************************
+ * @file       pios_trace.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Trace Binary event trace
+ * @{
+ * @brief Records thread switches, interrupts and object events in RAM
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pios.h"
+#include "pios_trace.h"
+
+#if defined(PIOS_INCLUDE_TRACE)
+
+static struct pios_trace_record *records;
+static uint16_t num_records;
+static uint16_t head;		/* next record written */
+static uint16_t tail;		/* next record read */
+static uint32_t dropped;
+static uint16_t cycles_per_us;
+
+/**
+ * @brief Allocate the ring buffer and start recording
+ * @param[in] size Number of records in the ring, one less is buffered at most
+ * @returns 0 on success, negative on failure
+ */
+int32_t PIOS_TRACE_Init(uint16_t size)
+{
+	if (records != NULL)
+		return -1;
+
+	if (size < 2)
+		return -2;
+
+	struct pios_trace_record *buf = PIOS_malloc(size * sizeof(*buf));
+	if (buf == NULL)
+		return -3;
+
+	// The viewer converts cycles to time with this
+	uint32_t raw = PIOS_DELAY_GetRaw();
+	PIOS_DELAY_WaituS(1000);
+	uint32_t cycles = PIOS_DELAY_GetRaw() - raw;
+	cycles_per_us = (cycles + 500) / 1000;
+	if (cycles_per_us == 0)
+		cycles_per_us = 1;
+
+	num_records = size;
+	head = 0;
+	tail = 0;
+
+	/* Only start recording once the ring is set up */
+	__sync_synchronize();
+	records = buf;
+
+	return 0;
+}
+
+/**
+ * @brief Add an event to the ring, drop it if the ring is full
+ * @note Called from threads, interrupts and the kernel scheduler alike
+ * @param[in] event One of enum pios_trace_event
+ * @param[in] arg Meaning depends on the event
+ */
+void PIOS_TRACE_Record(uint8_t event, uint16_t arg)
+{
+	if (records == NULL)
+		return;
+
+	PIOS_IRQ_Disable();
+
+	uint16_t next = head + 1;
+	if (next >= num_records)
+		next = 0;
+
+	if (next == tail) {
+		dropped++;
+	} else {
+		/* Stamped inside the lock so the ring stays in time order */
+		records[head].cycles = PIOS_DELAY_GetRaw();
+		records[head].arg = arg;
+		records[head].event = event;
+		records[head].reserved = 0;
+		head = next;
+	}
+
+	PIOS_IRQ_Enable();
+}
+
+/**
+ * @brief Take the oldest events out of the ring
+ * @param[out] out Where to copy the events to, NULL to discard them
+ * @param[in] max_records Most events to take
+ * @returns the number of events taken
+ */
+uint16_t PIOS_TRACE_Read(struct pios_trace_record *out, uint16_t max_records)
+{
+	if (records == NULL)
+		return 0;
+
+	uint16_t count = 0;
+
+	/* A short copy at a time keeps the interrupts off only briefly */
+	while (count < max_records) {
+		PIOS_IRQ_Disable();
+
+		if (tail == head) {
+			PIOS_IRQ_Enable();
+			break;
+		}
+
+		if (out != NULL)
+			out[count] = records[tail];
+
+		if (++tail >= num_records)
+			tail = 0;
+
+		PIOS_IRQ_Enable();
+
+		count++;
+	}
+
+	return count;
+}
+
+/**
+ * @brief Number of events lost to a full ring since the start
+ */
+uint32_t PIOS_TRACE_Dropped(void)
+{
+	return dropped;
+}
+
+/**
+ * @brief Rate of the cycle counter the events are stamped with
+ */
+uint16_t PIOS_TRACE_CyclesPeruS(void)
+{
+	return cycles_per_us;
+}
+
+#endif /* PIOS_INCLUDE_TRACE */
+
+/**
+  * @}
+  * @}
+  */
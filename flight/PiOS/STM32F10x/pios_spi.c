@@ -39,6 +39,7 @@
 #if defined(PIOS_INCLUDE_SPI)
 
 #include <pios_spi_priv.h>
+#include "pios_thread.h"
 
 static bool PIOS_SPI_validate(struct pios_spi_dev *com_dev)
 {
@@ -72,6 +73,7 @@ int32_t PIOS_SPI_Init(uint32_t *spi_id, const struct pios_spi_cfg *cfg)
 	spi_dev->cfg = cfg;
 
 	spi_dev->busy = PIOS_Semaphore_Create();
+	memset((void *)spi_dev->waiting, 0, sizeof(spi_dev->waiting));
 
 	/* Disable callback function */
 	spi_dev->callback = NULL;
@@ -240,16 +242,69 @@ int32_t PIOS_SPI_SetClockSpeed(uint32_t spi_id, uint32_t spi_speed)
  * \return -1 if timeout before claiming semaphore
  */
 int32_t PIOS_SPI_ClaimBus(uint32_t spi_id)
+{
+	return PIOS_SPI_ClaimBusPriority(spi_id, PIOS_SPI_PRIORITY_NORMAL);
+}
+
+/**
+ * Claim the SPI bus semaphore for a class of users. While a claim of a higher
+ * class waits, the bus is handed on to it first.
+ * \param[in] spi SPI number (0 or 1)
+ * \param[in] priority The class of the caller
+ * \return 0 if no error
+ * \return -1 if timeout before claiming semaphore
+ */
+int32_t PIOS_SPI_ClaimBusPriority(uint32_t spi_id, enum pios_spi_priority priority)
 {
 	struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
 
 	bool valid = PIOS_SPI_validate(spi_dev);
 	PIOS_Assert(valid)
+	PIOS_Assert(priority < PIOS_SPI_PRIORITY_NUM)
 
-	if (PIOS_Semaphore_Take(spi_dev->busy, 65535) != true)
-		return -1;
+	PIOS_IRQ_Disable();
+	spi_dev->waiting[priority]++;
+	PIOS_IRQ_Enable();
 
-	return 0;
+	int32_t result = 0;
+	while (true) {
+		if (PIOS_Semaphore_Take(spi_dev->busy, 65535) != true) {
+			result = -1;
+			break;
+		}
+
+		if (!PIOS_SPI_BusContended(spi_id, priority))
+			break;
+
+		/* Give the higher class a chance to take it, whatever its task priority */
+		PIOS_Semaphore_Give(spi_dev->busy);
+		PIOS_Thread_Sleep(1);
+	}
+
+	PIOS_IRQ_Disable();
+	spi_dev->waiting[priority]--;
+	PIOS_IRQ_Enable();
+
+	return result;
+}
+
+/**
+ * Tells the holder of the bus whether a claim of a higher class is waiting,
+ * so that it can release the bus between parts of a long transfer
+ * \param[in] spi SPI number (0 or 1)
+ * \param[in] priority The class of the caller
+ * \return true if a higher class waits for the bus
+ */
+bool PIOS_SPI_BusContended(uint32_t spi_id, enum pios_spi_priority priority)
+{
+	struct pios_spi_dev *spi_dev = (struct pios_spi_dev *)spi_id;
+
+	for (uint32_t i = priority + 1; i < PIOS_SPI_PRIORITY_NUM; i++) {
+		if (spi_dev->waiting[i])
+			return true;
+	}
+
+	return false;
 }
 
 /**
@@ -556,6 +611,8 @@ void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
 	bool valid = PIOS_SPI_validate(spi_dev);
 	PIOS_Assert(valid)
 
+	PIOS_TRACE(PIOS_TRACE_ISR_ENTER, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_SPI, spi_dev->cfg->regs));
+
 	DMA_ClearFlag(spi_dev->cfg->dma.irq.flags);
 
 	/* Wait for the final bytes of the transfer to complete, including CRC byte(s). */
@@ -575,6 +632,8 @@ void PIOS_SPI_IRQ_Handler(uint32_t spi_id)
 		crc_val = SPI_GetCRC(spi_dev->cfg->regs, SPI_CRC_Rx);
 		spi_dev->callback(crc_ok, crc_val);
 	}
+
+	PIOS_TRACE(PIOS_TRACE_ISR_EXIT, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_SPI, spi_dev->cfg->regs));
 }
 
 #endif
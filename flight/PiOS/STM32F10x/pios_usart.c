@@ -265,6 +265,8 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
 
+	PIOS_TRACE(PIOS_TRACE_ISR_ENTER, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
+
 	/* Force read of dr after sr to make sure to clear error flags */
 	volatile uint16_t sr = usart_dev->cfg->regs->SR;
 	volatile uint8_t dr = usart_dev->cfg->regs->DR;
@@ -305,6 +307,8 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 		}
 	}
 
+	PIOS_TRACE(PIOS_TRACE_ISR_EXIT, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 	portEND_SWITCHING_ISR((rx_need_yield || tx_need_yield) ? pdTRUE : pdFALSE);
 #endif	/* PIOS_INCLUDE_FREERTOS */
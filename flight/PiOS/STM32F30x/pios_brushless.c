@@ -39,12 +39,16 @@
 /* Private Function Prototypes */
 static int32_t PIOS_Brushless_SetPhase(uint32_t channel, float phase_deg);
 static void PIOS_BRUSHLESS_Task(void* parameters);
+#if defined(PIOS_INCLUDE_DMA_CB_SUBSCRIBING_FUNCTION)
+static int32_t PIOS_Brushless_DMA_Init(void);
+#endif /* PIOS_INCLUDE_DMA_CB_SUBSCRIBING_FUNCTION */
 
 // Private variables
 static const struct pios_brushless_cfg * brushless_cfg;
 static struct pios_thread *taskHandle;
 
 #define NUM_BGC_CHANNELS 3
+#define PINS_PER_MOTOR 3
 #define STACK_SIZE_BYTES 400
 #define TASK_PRIORITY  PIOS_THREAD_PRIO_HIGHEST
 
@@ -98,6 +102,12 @@ int32_t PIOS_Brushless_Init(const struct pios_brushless_cfg * cfg)
 		}
 	}
 
+#if defined(PIOS_INCLUDE_DMA_CB_SUBSCRIBING_FUNCTION)
+	// Without a thread when the timers load the outputs themselves
+	if (PIOS_Brushless_DMA_Init() == 0)
+		return 0;
+#endif /* PIOS_INCLUDE_DMA_CB_SUBSCRIBING_FUNCTION */
+
 	// Start main task
 	taskHandle = PIOS_Thread_Create(
 			PIOS_BRUSHLESS_Task, "pios_brushless", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
@@ -202,19 +212,17 @@ int32_t PIOS_Brushless_Lock(bool lock)
  */
 static int32_t PIOS_Brushless_SetPhase(uint32_t channel, float phase_deg)
 {
-	const int32_t PIN_PER_MOTOR  = 3;
-
 	/* Make sure a valid channel */
 	if (channel >= NUM_BGC_CHANNELS)
 		return -1;
 
 	/* Check enough outputs are registered */
-	if (!brushless_cfg || (PIN_PER_MOTOR * (channel + 1)) > brushless_cfg->num_channels) {
+	if (!brushless_cfg || (PINS_PER_MOTOR * (channel + 1)) > brushless_cfg->num_channels) {
 		return -2;
 	}
 
 	// Get the first output index
-	for (int32_t idx = channel * PIN_PER_MOTOR; idx < (channel + 1) * PIN_PER_MOTOR; idx++) {
+	for (int32_t idx = channel * PINS_PER_MOTOR; idx < (channel + 1) * PINS_PER_MOTOR; idx++) {
 
 		// sin lookup expects between 0 and 360
 		while (phase_deg > 360)
@@ -245,6 +253,183 @@ static int32_t PIOS_Brushless_SetPhase(uint32_t channel, float phase_deg)
 	return 0;
 }
 
+#if defined(PIOS_INCLUDE_DMA_CB_SUBSCRIBING_FUNCTION)
+
+/*
+ * With a DMA channel for each motor the update event of its timer loads the
+ * three compare registers from a circular buffer that holds the outputs for
+ * the next PWM periods. Each time half of it has been sent the interrupt
+ * refills that half from a sine table, advancing the phase every PWM period
+ * instead of every millisecond, so the motors turn smoothly and no thread
+ * has to run at the highest priority.
+ */
+
+#define DMA_PERIODS      32                     /*! PWM periods in the buffer of a motor, refilled by halves */
+#define SINE_TABLE_BITS  10
+#define SINE_TABLE_LEN   (1 << SINE_TABLE_BITS)
+#define PHASE_PER_DEG    (4294967296.0f / 360.0f)
+#define PHASE_120_DEG    0x55555555
+
+static int16_t   sine_table[SINE_TABLE_LEN];           /*! sine in Q15 over a turn */
+static uint32_t *dma_buffers[NUM_BGC_CHANNELS];        /*! compare values, PINS_PER_MOTOR per period */
+static uint8_t   dma_slots[NUM_BGC_CHANNELS][PINS_PER_MOTOR]; /*! compare register of each pin */
+static uint32_t  dma_phases[NUM_BGC_CHANNELS];         /*! phase with 2^32 per turn */
+static float     dma_period_s;                         /*! length of a PWM period */
+
+/**
+ * Fill half of the buffer of a motor with the next PWM periods
+ * @param[in] channel The motor
+ * @param[out] periods Where in the buffer to start
+ */
+static void PIOS_Brushless_DMA_Fill(uint32_t channel, uint32_t *periods)
+{
+	// Same output as PIOS_Brushless_SetPhase, with the phase as an integer
+	int32_t step = 0;
+	uint32_t lag = 0;
+	if (!locked) {
+		step = (int32_t) (speeds[channel] * dma_period_s * PHASE_PER_DEG);
+		lag = (uint32_t) (int64_t) (phase_lag[channel] * PHASE_PER_DEG);
+	}
+
+	int32_t offset = scales[channel] * center;
+	int32_t amplitude = scales[channel] * scale;
+
+	for (uint32_t i = 0; i < DMA_PERIODS / 2; i++) {
+		dma_phases[channel] += step;
+
+		uint32_t phase = dma_phases[channel] + lag;
+		for (uint32_t pin = 0; pin < PINS_PER_MOTOR; pin++) {
+			int16_t sine = sine_table[phase >> (32 - SINE_TABLE_BITS)];
+			periods[dma_slots[channel][pin]] = offset + ((amplitude * sine) >> 15);
+			phase += PHASE_120_DEG;
+		}
+
+		periods += PINS_PER_MOTOR;
+	}
+}
+
+/**
+ * Refill the half of the buffer that was just sent
+ * @param[in] channel The motor
+ */
+static void PIOS_Brushless_DMA_Handler(uint32_t channel)
+{
+	const struct pios_brushless_dma *dma = &brushless_cfg->dma[channel];
+
+	if (DMA_GetFlagStatus(dma->full_flag)) {
+		DMA_ClearFlag(dma->full_flag);
+		PIOS_Brushless_DMA_Fill(channel, dma_buffers[channel] + DMA_PERIODS / 2 * PINS_PER_MOTOR);
+	} else if (DMA_GetFlagStatus(dma->half_flag)) {
+		DMA_ClearFlag(dma->half_flag);
+		PIOS_Brushless_DMA_Fill(channel, dma_buffers[channel]);
+	} else {
+		// Transfer error, nothing to refill
+		DMA_ClearFlag(dma->irq.flags);
+	}
+}
+
+static void PIOS_Brushless_DMA_Handler0(void)
+{
+	PIOS_Brushless_DMA_Handler(0);
+}
+
+static void PIOS_Brushless_DMA_Handler1(void)
+{
+	PIOS_Brushless_DMA_Handler(1);
+}
+
+static void PIOS_Brushless_DMA_Handler2(void)
+{
+	PIOS_Brushless_DMA_Handler(2);
+}
+
+static void (* const dma_handlers[NUM_BGC_CHANNELS])(void) = {
+	PIOS_Brushless_DMA_Handler0,
+	PIOS_Brushless_DMA_Handler1,
+	PIOS_Brushless_DMA_Handler2,
+};
+
+/**
+ * Start the DMA transfers of all motors
+ * @returns 0 if successful, negative if the configuration has no DMA for
+ * the motors or their pins are not on channels 1 to 3 of one timer
+ */
+static int32_t PIOS_Brushless_DMA_Init(void)
+{
+	const struct pios_brushless_cfg *cfg = brushless_cfg;
+	uint32_t num_motors = cfg->num_channels / PINS_PER_MOTOR;
+
+	if (cfg->dma == NULL || num_motors == 0 ||
+	    num_motors > NUM_BGC_CHANNELS || cfg->num_dma < num_motors)
+		return -1;
+
+	// The burst writes CCR1 to CCR3 of the timer of the motor
+	for (uint32_t motor = 0; motor < num_motors; motor++) {
+		const struct pios_tim_channel *chans = &cfg->channels[motor * PINS_PER_MOTOR];
+		uint8_t used = 0;
+
+		for (uint32_t pin = 0; pin < PINS_PER_MOTOR; pin++) {
+			uint8_t slot = chans[pin].timer_chan / (TIM_Channel_2 - TIM_Channel_1);
+			if (chans[pin].timer != chans[0].timer || slot >= PINS_PER_MOTOR || (used & (1 << slot)))
+				return -2;
+
+			used |= 1 << slot;
+			dma_slots[motor][pin] = slot;
+		}
+	}
+
+	for (uint32_t i = 0; i < SINE_TABLE_LEN; i++)
+		sine_table[i] = 32767 * sinf(i * (2 * PI / SINE_TABLE_LEN));
+
+	// TIM2 and TIM3 count at twice the APB1 clock
+	dma_period_s = (float) ((cfg->tim_base_init.TIM_Prescaler + 1) * (cfg->tim_base_init.TIM_Period + 1)) /
+		(PIOS_PERIPHERAL_APB1_CLOCK * 2);
+
+	for (uint32_t motor = 0; motor < num_motors; motor++) {
+		dma_buffers[motor] = PIOS_malloc(DMA_PERIODS * PINS_PER_MOTOR * sizeof(uint32_t));
+		if (dma_buffers[motor] == NULL)
+			return -3;
+	}
+
+	for (uint32_t motor = 0; motor < num_motors; motor++) {
+		const struct pios_brushless_dma *dma = &cfg->dma[motor];
+		TIM_TypeDef *timer = cfg->channels[motor * PINS_PER_MOTOR].timer;
+
+		PIOS_Brushless_DMA_Fill(motor, dma_buffers[motor]);
+		PIOS_Brushless_DMA_Fill(motor, dma_buffers[motor] + DMA_PERIODS / 2 * PINS_PER_MOTOR);
+
+		RCC_AHBPeriphClockCmd(dma->ahb_clk, ENABLE);
+
+		DMA_DeInit(dma->channel);
+		DMA_InitTypeDef dma_init;
+		DMA_StructInit(&dma_init);
+		dma_init.DMA_PeripheralBaseAddr = (uint32_t) &timer->DMAR;
+		dma_init.DMA_MemoryBaseAddr = (uint32_t) dma_buffers[motor];
+		dma_init.DMA_DIR = DMA_DIR_PeripheralDST;
+		dma_init.DMA_BufferSize = DMA_PERIODS * PINS_PER_MOTOR;
+		dma_init.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+		dma_init.DMA_MemoryInc = DMA_MemoryInc_Enable;
+		dma_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+		dma_init.DMA_MemoryDataSize = DMA_MemoryDataSize_Word;
+		dma_init.DMA_Mode = DMA_Mode_Circular;
+		dma_init.DMA_Priority = DMA_Priority_High;
+		dma_init.DMA_M2M = DMA_M2M_Disable;
+		DMA_Init(dma->channel, &dma_init);
+
+		PIOS_DMA_Install_Interrupt_handler(dma->channel, dma_handlers[motor]);
+		NVIC_Init((NVIC_InitTypeDef *) &dma->irq.init);
+		DMA_ITConfig(dma->channel, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+		TIM_DMAConfig(timer, TIM_DMABase_CCR1, TIM_DMABurstLength_3Transfers);
+		TIM_DMACmd(timer, TIM_DMA_Update, ENABLE);
+		DMA_Cmd(dma->channel, ENABLE);
+	}
+
+	return 0;
+}
+
+#endif /* PIOS_INCLUDE_DMA_CB_SUBSCRIBING_FUNCTION */
+
 /**
  * Called whenver the PWM output timer wraps around which is quite frequenct (e.g. 30khz) to
  * update the phase on the outputs based on the current rate
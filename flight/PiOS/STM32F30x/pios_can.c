@@ -69,6 +69,16 @@ struct pios_can_dev {
 // Local constants
 #define CAN_COM_ID      0x11
 #define MAX_SEND_LEN    8
+#define TX_QUEUE_LEN    16
+
+//! Data messages waiting for a free mailbox
+static CanTxMsg tx_queue[TX_QUEUE_LEN];
+static volatile uint8_t tx_queue_head;
+static volatile uint8_t tx_queue_tail;
+
+static void PIOS_CAN_UpdateFilters(void);
+static void PIOS_CAN_RxGeneric(void);
+static void PIOS_CAN_TxGeneric(void);
 
 void USB_HP_CAN1_TX_IRQHandler(void);
 
@@ -134,22 +144,15 @@ int32_t PIOS_CAN_Init(uintptr_t *can_id, const struct pios_can_cfg *cfg)
 	*can_id = (uintptr_t)can_dev;
 
 	CAN_DeInit(can_dev->cfg->regs);
-	CAN_Init(can_dev->cfg->regs, (CAN_InitTypeDef *)&can_dev->cfg->init);
 
-	/* CAN filter init */
-	CAN_FilterInitTypeDef CAN_FilterInitStructure;
-	// Banks 0..13 are assigned to CAN1 and 14..28 to CAN2
-	CAN_FilterInitStructure.CAN_FilterNumber = (can_dev->cfg->regs == CAN1) ? 0 : 14;
-	CAN_FilterInitStructure.CAN_FilterMode = CAN_FilterMode_IdMask;
-	CAN_FilterInitStructure.CAN_FilterScale = CAN_FilterScale_32bit;
-	CAN_FilterInitStructure.CAN_FilterIdHigh = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterIdLow = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterMaskIdHigh = 0x0000;
-	CAN_FilterInitStructure.CAN_FilterMaskIdLow = 0x0000;  
-	CAN_FilterInitStructure.CAN_FilterFIFOAssignment = 1;
+	// Mailboxes send in the order they were filled instead of by ID, which
+	// keeps the COM stream and bursts of data messages in order
+	CAN_InitTypeDef init = can_dev->cfg->init;
+	init.CAN_TXFP = ENABLE;
+	CAN_Init(can_dev->cfg->regs, &init);
 
-	CAN_FilterInitStructure.CAN_FilterActivation = ENABLE;
-	CAN_FilterInit(&CAN_FilterInitStructure);
+	/* Accept only the COM stream until message queues are registered */
+	PIOS_CAN_UpdateFilters();
 
 	// Enable the receiver IRQ
  	NVIC_Init((NVIC_InitTypeDef*) &can_dev->cfg->rx_irq.init);
@@ -184,8 +187,11 @@ static void PIOS_CAN_TxStart(uintptr_t can_id, uint16_t tx_bytes_avail)
 	PIOS_Assert(valid);
 
  	CAN_ITConfig(can_dev->cfg->regs, CAN_IT_TME, ENABLE);
-	
-	USB_HP_CAN1_TX_IRQHandler();
+
+	// Shares the transmit queue with the interrupt
+	PIOS_IRQ_Disable();
+	PIOS_CAN_TxGeneric();
+	PIOS_IRQ_Enable();
 }
 
 static void PIOS_CAN_RegisterRxCallback(uintptr_t can_id, pios_com_callback rx_in_cb, uintptr_t context)
@@ -218,30 +224,85 @@ static void PIOS_CAN_RegisterTxCallback(uintptr_t can_id, pios_com_callback tx_o
 	can_dev->tx_out_cb = tx_out_cb;
 }
 
-//! The mapping of message types to CAN BUS StdID
+//! The queues that receive each message type
 static struct pios_queue *pios_can_queues[PIOS_CAN_LAST];
 
+//! The shared queues of struct pios_can_frame that receive each message type
+static struct pios_queue *pios_can_routes[PIOS_CAN_LAST];
+
+/**
+ * Program the acceptance filters with the IDs that have a destination, so
+ * the other traffic on the bus never reaches a FIFO or raises an
+ * interrupt. Each filter bank holds a list of four standard IDs.
+ */
+static void PIOS_CAN_UpdateFilters(void)
+{
+	uint16_t std_ids[PIOS_CAN_LAST + 1];
+	uint32_t num_ids = 0;
+
+	std_ids[num_ids++] = CAN_COM_ID;
+	for (uint32_t msg_id = 0; msg_id < PIOS_CAN_LAST; msg_id++) {
+		if (pios_can_queues[msg_id] != NULL || pios_can_routes[msg_id] != NULL)
+			std_ids[num_ids++] = pios_can_message_stdid[msg_id];
+	}
+
+	CAN_FilterInitTypeDef CAN_FilterInitStructure;
+	CAN_FilterInitStructure.CAN_FilterNumber = 0;
+	CAN_FilterInitStructure.CAN_FilterMode = CAN_FilterMode_IdList;
+	CAN_FilterInitStructure.CAN_FilterScale = CAN_FilterScale_16bit;
+	CAN_FilterInitStructure.CAN_FilterFIFOAssignment = 1;
+	CAN_FilterInitStructure.CAN_FilterActivation = ENABLE;
+
+	for (uint32_t i = 0; i < num_ids; i += 4) {
+		// A bank that isn't full repeats its first ID
+		uint16_t list[4];
+		for (uint32_t j = 0; j < 4; j++)
+			list[j] = std_ids[(i + j < num_ids) ? i + j : i] << 5;
+
+		CAN_FilterInitStructure.CAN_FilterIdHigh = list[0];
+		CAN_FilterInitStructure.CAN_FilterIdLow = list[1];
+		CAN_FilterInitStructure.CAN_FilterMaskIdHigh = list[2];
+		CAN_FilterInitStructure.CAN_FilterMaskIdLow = list[3];
+		CAN_FilterInit(&CAN_FilterInitStructure);
+
+		CAN_FilterInitStructure.CAN_FilterNumber++;
+	}
+}
+
 /**
  * Process received CAN messages and push them out any corresponding
  * queues. Called from ISR.
  */
-static bool process_received_message(CanRxMsg message)
+static bool process_received_message(const CanRxMsg *message)
 {
 	// Look for a known message that matches this CAN StdId
 	uint32_t msg_id;
-	for (msg_id = 0; msg_id < PIOS_CAN_LAST && pios_can_message_stdid[msg_id] != message.StdId; msg_id++);
+	for (msg_id = 0; msg_id < PIOS_CAN_LAST && pios_can_message_stdid[msg_id] != message->StdId; msg_id++);
 
 	// If StdId is not one of the known messages, bail out
 	if (msg_id == PIOS_CAN_LAST)
 		return false;
 
+	bool woken = false;
+
+	// Shared queues get the message ID along with the data
+	struct pios_queue *route = pios_can_routes[msg_id];
+	if (route != NULL) {
+		struct pios_can_frame frame;
+		frame.msg_id = msg_id;
+		frame.len = message->DLC;
+		memcpy(frame.data, message->Data, sizeof(frame.data));
+
+		PIOS_Queue_Send_FromISR(route, &frame, &woken);
+		return woken;
+	}
+
 	// Get the queue for this message and send the data
 	struct pios_queue *queue = pios_can_queues[msg_id];
 	if (queue == NULL)
 		return false;
 
-	bool woken = false;
-	PIOS_Queue_Send_FromISR(queue, message.Data, &woken);
+	PIOS_Queue_Send_FromISR(queue, message->Data, &woken);
 
 	return woken;
 }
@@ -256,13 +317,17 @@ struct pios_queue * PIOS_CAN_RegisterMessageQueue(uintptr_t id, enum pios_can_me
 {
 	// Fetch the size of this message type or error if unknown
 	int32_t bytes = get_message_size(msg_id);
-	if (msg_id < 0)
+	if (bytes < 0)
 		return NULL;
 
 	// Return existing queue if created
 	if (pios_can_queues[msg_id] != NULL)
 		return pios_can_queues[msg_id];
 
+	// The message already goes to a shared queue
+	if (pios_can_routes[msg_id] != NULL)
+		return NULL;
+
 	// Create a queue that can manage the data message size
 	struct pios_queue *queue;
 	queue = PIOS_Queue_Create(2, bytes);
@@ -272,13 +337,37 @@ struct pios_queue * PIOS_CAN_RegisterMessageQueue(uintptr_t id, enum pios_can_me
 	// Store the queue handle for the driver
 	pios_can_queues[msg_id] = queue;
 
+	PIOS_CAN_UpdateFilters();
+
 	return queue;
 }
 
-// Map the specific IRQ handlers to the device handle
+/**
+ * Deliver a message type to a queue that can be shared with other
+ * message types, so a single thread can wait for all of them. The
+ * queue items are struct pios_can_frame.
+ * @param[in] id the CAN device ID
+ * @param[in] msg_id The message ID
+ * @param[in] frames The queue to deliver to
+ * @returns 0 if successful, negative otherwise
+ */
+int32_t PIOS_CAN_RouteMessage(uintptr_t id, enum pios_can_messages msg_id, struct pios_queue *frames)
+{
+	if (get_message_size(msg_id) < 0 || frames == NULL)
+		return -1;
 
-static void PIOS_CAN_RxGeneric(void);
-static void PIOS_CAN_TxGeneric(void);
+	// Each message type has a single destination
+	if (pios_can_queues[msg_id] != NULL || pios_can_routes[msg_id] != NULL)
+		return -2;
+
+	pios_can_routes[msg_id] = frames;
+
+	PIOS_CAN_UpdateFilters();
+
+	return 0;
+}
+
+// Map the specific IRQ handlers to the device handle
 
 void CAN1_RX1_IRQHandler(void)
 {
@@ -317,16 +406,23 @@ static void PIOS_CAN_RxGeneric(void)
 	bool valid = PIOS_CAN_validate(can_dev);
 	PIOS_Assert(valid);
 
-	CanRxMsg RxMessage;
-	CAN_Receive(CAN1, CAN_FIFO1, &RxMessage);
-
 	bool rx_need_yield = false;
-	if (RxMessage.StdId == CAN_COM_ID) {
-		if (can_dev->rx_in_cb) {
-			(void) (can_dev->rx_in_cb)(can_dev->rx_in_context, RxMessage.Data, RxMessage.DLC, NULL, &rx_need_yield);
+
+	// Empty the FIFO, several messages arrive back to back in a burst
+	while (CAN_MessagePending(CAN1, CAN_FIFO1) > 0) {
+		CanRxMsg RxMessage;
+		CAN_Receive(CAN1, CAN_FIFO1, &RxMessage);
+
+		bool woken = false;
+		if (RxMessage.StdId == CAN_COM_ID) {
+			if (can_dev->rx_in_cb) {
+				(void) (can_dev->rx_in_cb)(can_dev->rx_in_context, RxMessage.Data, RxMessage.DLC, NULL, &woken);
+			}
+		} else {
+			woken = process_received_message(&RxMessage);
 		}
-	} else {
-		rx_need_yield = process_received_message(RxMessage);
+
+		rx_need_yield |= woken;
 	}
 
 #if defined(PIOS_INCLUDE_FREERTOS)
@@ -346,27 +442,44 @@ static void PIOS_CAN_TxGeneric(void)
 	PIOS_Assert(valid);
 
 	bool tx_need_yield = false;
-	
-	if (can_dev->tx_out_cb) {
+	bool idle = false;
+
+	// Fill every empty mailbox, the data messages waiting go before the COM stream
+	while (can_dev->cfg->regs->TSR & CAN_TSR_TME) {
+		if (tx_queue_tail != tx_queue_head) {
+			CAN_Transmit(can_dev->cfg->regs, &tx_queue[tx_queue_tail]);
+			tx_queue_tail = (tx_queue_tail + 1) % TX_QUEUE_LEN;
+			continue;
+		}
+
+		if (!can_dev->tx_out_cb) {
+			idle = true;
+			break;
+		}
 
 		// Prepare CAN message structure
 		CanTxMsg msg;
 		msg.StdId = CAN_COM_ID;
 		msg.ExtId = 0;
 		msg.IDE = CAN_ID_STD;
-		msg.RTR = CAN_RTR_DATA;			
-		msg.DLC = (can_dev->tx_out_cb)(can_dev->tx_out_context, msg.Data, MAX_SEND_LEN, NULL, &tx_need_yield);
+		msg.RTR = CAN_RTR_DATA;
 
-		// Send message and get mailbox number
-		if (msg.DLC > 0) {
-			CAN_Transmit(can_dev->cfg->regs, &msg);
-		} else {
-			CAN_ITConfig(can_dev->cfg->regs, CAN_IT_TME, DISABLE);
+		bool woken = false;
+		msg.DLC = (can_dev->tx_out_cb)(can_dev->tx_out_context, msg.Data, MAX_SEND_LEN, NULL, &woken);
+		tx_need_yield |= woken;
+
+		if (msg.DLC == 0) {
+			idle = true;
+			break;
 		}
 
-		// TODO: deal with failure to send and keep the message to retransmit
+		CAN_Transmit(can_dev->cfg->regs, &msg);
 	}
-	
+
+	// Otherwise the next free mailbox calls again
+	if (idle)
+		CAN_ITConfig(can_dev->cfg->regs, CAN_IT_TME, DISABLE);
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 	portEND_SWITCHING_ISR(tx_need_yield ? pdTRUE : pdFALSE);
 #endif /* defined(PIOS_INCLUDE_FREERTOS) */
@@ -374,7 +487,9 @@ static void PIOS_CAN_TxGeneric(void)
 
 
 /**
- * PIOS_CAN_TxData transmits a data message with a specified ID
+ * PIOS_CAN_TxData transmits a data message with a specified ID. When all
+ * three mailboxes are busy the message waits in a queue that the transmit
+ * interrupt empties, so a burst of messages goes out back to back.
  * @param[in] id the CAN device ID
  * @param[in] msg_id The message ID (std ID < 0x7FF)
  * @param[in] data Pointer to data message
@@ -384,7 +499,7 @@ int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages msg_id, uint8_t *da
 {
 	// Fetch the size of this message type or error if unknown
 	int32_t bytes = get_message_size(msg_id);
-	if (msg_id < 0)
+	if (bytes < 0)
 		return -1;
 
 	// Look up the CAN BUS Standard ID for this message type
@@ -398,11 +513,28 @@ int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages msg_id, uint8_t *da
 	msg.RTR = CAN_RTR_DATA;
 	msg.DLC = (bytes > 8) ? 8 : bytes;
 	memcpy(msg.Data, data, msg.DLC);
-	CAN_Transmit(can_dev->cfg->regs, &msg);
 
-	return msg.DLC;
-}
+	bool queued = true;
+
+	PIOS_IRQ_Disable();
+
+	// Straight to a mailbox unless earlier messages are still waiting
+	if (tx_queue_tail != tx_queue_head ||
+	    CAN_Transmit(can_dev->cfg->regs, &msg) == CAN_TxStatus_NoMailBox) {
+		uint8_t next = (tx_queue_head + 1) % TX_QUEUE_LEN;
+		if (next != tx_queue_tail) {
+			tx_queue[tx_queue_head] = msg;
+			tx_queue_head = next;
+			CAN_ITConfig(can_dev->cfg->regs, CAN_IT_TME, ENABLE);
+		} else {
+			queued = false;
+		}
+	}
 
+	PIOS_IRQ_Enable();
+
+	return queued ? msg.DLC : -1;
+}
 
 #endif /* PIOS_INCLUDE_CAN */
 /**
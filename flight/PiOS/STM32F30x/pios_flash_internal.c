@@ -154,6 +154,17 @@ static int32_t PIOS_Flash_Internal_ReadData(uintptr_t chip_id, uint32_t chip_off
 	return 0;
 }
 
+static const uint8_t *PIOS_Flash_Internal_MapData(uintptr_t chip_id, uint32_t chip_offset, uint32_t len)
+{
+	struct pios_internal_flash_dev *flash_dev = (struct pios_internal_flash_dev *)chip_id;
+
+	if (!PIOS_Flash_Internal_Validate(flash_dev))
+		return NULL;
+
+	/* The flash is in the address space of the CPU */
+	return (const uint8_t *)(FLASH_BASE + chip_offset);
+}
+
 static int32_t PIOS_Flash_Internal_WriteData(uintptr_t chip_id, uint32_t chip_offset, const uint8_t *data, uint16_t len)
 {
 	PIOS_Assert(data);
@@ -197,6 +208,7 @@ const struct pios_flash_driver pios_internal_flash_driver = {
 	.erase_sector      = PIOS_Flash_Internal_EraseSector,
 	.write_data        = PIOS_Flash_Internal_WriteData,
 	.read_data         = PIOS_Flash_Internal_ReadData,
+	.map_data          = PIOS_Flash_Internal_MapData,
 };
 
 #endif	/* defined(PIOS_INCLUDE_FLASH_INTERNAL) */
@@ -43,6 +43,10 @@ static enum pwm_mode *output_channel_resolution;  // The clock rate for that tim
 #if defined(PIOS_INCLUDE_HPWM)
 enum SYNC_PWM {SYNC_PWM_FALSE, SYNC_PWM_TRUE};
 static enum SYNC_PWM *output_channel_mode;
+//! Compare value at which the last synchronous pulses of the timer end
+static uint32_t *output_channel_pulse_end;
+
+static uint32_t get_compare(const struct pios_tim_channel *chan);
 #endif
 
 /* Private constant definitions */
@@ -103,6 +107,12 @@ int32_t PIOS_Servo_Init(const struct pios_servo_cfg * cfg)
 		return -1;
 	}
 	memset(output_channel_mode, 0, servo_cfg->num_channels * sizeof(typeof(output_channel_mode)));
+
+	output_channel_pulse_end = PIOS_malloc(servo_cfg->num_channels * sizeof(*output_channel_pulse_end));
+	if (output_channel_pulse_end == NULL) {
+		return -1;
+	}
+	memset(output_channel_pulse_end, 0, servo_cfg->num_channels * sizeof(*output_channel_pulse_end));
 #endif
 
 	return 0;
@@ -151,6 +161,19 @@ void PIOS_Servo_SetMode(const uint16_t * speeds, const enum pwm_mode *pwm_mode,
 				clk_rate = PWM_MODE_1MHZ_RATE; // Default output timer frequency in hertz
 			} else if (pwm_mode[set] == PWM_MODE_12MHZ) {
 				clk_rate = PWM_MODE_12MHZ_RATE; // Default output timer frequency in hertz
+			} else {
+				// DShot needs the DMA burst of the F4, the outputs of this bank stay low
+				for (uint8_t j = 0; j < servo_cfg->num_channels; j++) {
+					if (chan->timer == servo_cfg->channels[j].timer) {
+#if defined(PIOS_INCLUDE_HPWM)
+						output_channel_mode[j] = SYNC_PWM_FALSE;
+						output_channel_resolution[j] = pwm_mode[set];
+#endif
+					}
+				}
+
+				set++;
+				continue;
 			}
 
 			if (speeds[set] == 0) {
@@ -184,6 +207,7 @@ void PIOS_Servo_SetMode(const uint16_t * speeds, const enum pwm_mode *pwm_mode,
 #if defined(PIOS_INCLUDE_HPWM)
 					/* save the frequency for these channels */
 					output_channel_mode[j] = (speeds[set] == 0) ? SYNC_PWM_TRUE : SYNC_PWM_FALSE;
+					output_channel_pulse_end[j] = 0;
 					output_channel_resolution[j] = pwm_mode[set];
 #endif
 				}
@@ -221,15 +245,14 @@ void PIOS_Servo_Set(uint8_t servo, float position)
 	case PWM_MODE_12MHZ:
 		us_to_count = PWM_MODE_12MHZ_RATE / 1000000;
 		break;
+	default:
+		/* No DShot on this port, keep the output low */
+		break;
 	}
 	position = position * us_to_count;
 
-	/* stop the timer in OneShot (Synchronous) mode */
-	if (output_channel_mode[servo] == SYNC_PWM_TRUE) {
-		TIM_Cmd(chan->timer, DISABLE);
-	}
-
-	/* Update the position */
+	/* Update the position. The compare registers are preloaded, so in */
+	/* OneShot (Synchronous) mode this only takes effect on PIOS_Servo_Update */
 	switch(chan->timer_chan) {
 		case TIM_Channel_1:
 			TIM_SetCompare1(chan->timer, position);
@@ -285,6 +308,11 @@ void PIOS_Servo_Set(uint8_t servo, uint16_t position)
 #if defined(PIOS_INCLUDE_HPWM)
 /**
 * Update the timer for HPWM/OneShot
+*
+* Generates an update event on every timer in synchronous mode, which loads
+* the compare values set since the last update and starts the pulses. The
+* timers keep running, a timer whose last pulses have not ended yet waits
+* for the next update.
 */
 void PIOS_Servo_Update()
 {
@@ -296,13 +324,56 @@ void PIOS_Servo_Update()
 		const struct pios_tim_channel * chan = &servo_cfg->channels[i];
 
 		/* Check for channels that are using synchronous output */
-		/* Look for a disabled timer using synchronous output */
-		if (!(chan->timer->CR1 & TIM_CR1_CEN)) {
-			/* enable it again and reinitialize it */
-			TIM_Cmd(chan->timer, ENABLE);
-			TIM_GenerateEvent(chan->timer, TIM_EventSource_Update);
+		if (output_channel_mode[i] != SYNC_PWM_TRUE) {
+			continue;
+		}
+
+		/* All channels of a timer share its mode, restart it only once */
+		bool first = true;
+		for (uint8_t j = 0; (j < i) && first; j++) {
+			first = (chan->timer != servo_cfg->channels[j].timer);
+		}
+
+		if (!first) {
+			continue;
+		}
+
+		/* A pulse still going out is not cut short, the next update has the new values */
+		if (TIM_GetCounter(chan->timer) < output_channel_pulse_end[i]) {
+			continue;
+		}
+
+		/* Load the compare values and start the pulses of all channels at once */
+		TIM_GenerateEvent(chan->timer, TIM_EventSource_Update);
+
+		uint32_t pulse_end = 0;
+		for (uint8_t j = i; j < servo_cfg->num_channels; j++) {
+			if (chan->timer == servo_cfg->channels[j].timer) {
+				pulse_end = MAX(pulse_end, get_compare(&servo_cfg->channels[j]));
+			}
 		}
+		output_channel_pulse_end[i] = pulse_end;
+	}
+}
+
+/**
+ * Reads the compare value of a channel, the preloaded one if it was changed
+ * since the last update event
+ */
+static uint32_t get_compare(const struct pios_tim_channel *chan)
+{
+	switch(chan->timer_chan) {
+		case TIM_Channel_1:
+			return TIM_GetCapture1(chan->timer);
+		case TIM_Channel_2:
+			return TIM_GetCapture2(chan->timer);
+		case TIM_Channel_3:
+			return TIM_GetCapture3(chan->timer);
+		case TIM_Channel_4:
+			return TIM_GetCapture4(chan->timer);
 	}
+
+	return 0;
 }
 
 #endif /* PIOS_INCLUDE_HPWM */
@@ -358,6 +358,8 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
+
+	PIOS_TRACE(PIOS_TRACE_ISR_ENTER, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
 	
 	/* Check if RXNE flag is set */
 	if (USART_GetITStatus(usart_dev->cfg->regs, USART_IT_RXNE)) {
@@ -396,6 +398,8 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 		++usart_dev->error_overruns;
 	}
 	
+	PIOS_TRACE(PIOS_TRACE_ISR_EXIT, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 	portEND_SWITCHING_ISR((rx_need_yield || tx_need_yield) ? pdTRUE : pdFALSE);
 #endif	/* defined(PIOS_INCLUDE_FREERTOS) */
@@ -44,6 +44,21 @@ struct pios_i2c_adapter_cfg {
 	struct stm32_gpio sda;
 	struct stm32_irq event;
 	struct stm32_irq error;
+
+	/* Reads of two bytes and more go through the rx stream when set */
+	const struct stm32_dma *dma;
+};
+
+/* Transfers waiting for the bus, the active one included */
+#ifndef PIOS_I2C_QUEUE_LEN
+#define PIOS_I2C_QUEUE_LEN 4
+#endif
+
+struct pios_i2c_request {
+	const struct pios_i2c_txn *txn_list;
+	uint32_t num_txns;
+	pios_i2c_callback callback;
+	void *context;
 };
 
 enum pios_i2c_adapter_magic {
@@ -66,6 +81,8 @@ enum i2c_adapter_state {
 	I2C_STATE_R_MORE_TXN_PRE_MIDDLE,
 	I2C_STATE_R_MORE_TXN_PRE_LAST,
 	I2C_STATE_R_MORE_TXN_POST_LAST,
+	I2C_STATE_R_MORE_TXN_DMA,
+	I2C_STATE_R_MORE_TXN_POST_DMA,
 
 	I2C_STATE_R_LAST_TXN_ADDR,
 	I2C_STATE_R_LAST_TXN_PRE_ONE,
@@ -73,6 +90,8 @@ enum i2c_adapter_state {
 	I2C_STATE_R_LAST_TXN_PRE_MIDDLE,
 	I2C_STATE_R_LAST_TXN_PRE_LAST,
 	I2C_STATE_R_LAST_TXN_POST_LAST,
+	I2C_STATE_R_LAST_TXN_DMA,
+	I2C_STATE_R_LAST_TXN_POST_DMA,
 
 	I2C_STATE_W_MORE_TXN_ADDR,
 	I2C_STATE_W_MORE_TXN_PRE_MIDDLE,
@@ -100,11 +119,13 @@ enum i2c_adapter_event {
 	I2C_EVENT_ADDR_SENT_LEN_EQ_1,
 	I2C_EVENT_ADDR_SENT_LEN_EQ_2,
 	I2C_EVENT_ADDR_SENT_LEN_GT_2,
+	I2C_EVENT_ADDR_SENT_DMA,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_0,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_1,
 	I2C_EVENT_TRANSFER_DONE_LEN_EQ_2,
 	I2C_EVENT_TRANSFER_DONE_LEN_GT_2,
 	I2C_EVENT_NACK,
+	I2C_EVENT_DMA_DONE,
 	I2C_EVENT_STOPPED,
 	I2C_EVENT_AUTO,
 	I2C_EVENT_NUM_EVENTS	/* Must be last */
@@ -137,6 +158,16 @@ struct pios_i2c_adapter {
 
 	bool bus_error;
 	bool nack;
+	bool use_dma;
+
+	struct pios_i2c_request queue[PIOS_I2C_QUEUE_LEN];
+	uint8_t queue_head;
+	uint8_t queue_count;
+	volatile bool busy;
+	uint32_t start_raw;
+
+	/* Result of the transfer PIOS_I2C_Transfer waits for */
+	int32_t blocking_result;
 
 	volatile enum i2c_adapter_state state;
 	const struct pios_i2c_txn *active_txn;
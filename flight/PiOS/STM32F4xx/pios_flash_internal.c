@@ -165,13 +165,26 @@ static int32_t PIOS_Flash_Internal_WriteData(uintptr_t chip_id, uint32_t chip_of
 	if (!PIOS_Flash_Internal_Validate(flash_dev))
 		return -1;
 
-	/* Write the data */
-	for (uint16_t i = 0; i < len; i++) {
-		FLASH_Status status;
-		/*
-		 * This is inefficient.  Should try to do word writes.
-		 * Not sure if word writes need to be aligned though.
-		 */
+	/*
+	 * Write the data. Sectors are erased with VoltageRange_3, which allows
+	 * programming a word at a time, but the words must be aligned so bytes
+	 * are used up to the first and after the last aligned word.
+	 */
+	uint16_t i = 0;
+	FLASH_Status status;
+
+	for (; i < len && ((chip_offset + i) & 3); i++) {
+		status = FLASH_ProgramByte(FLASH_BASE + chip_offset + i, data[i]);
+		PIOS_Assert(status == FLASH_COMPLETE);
+	}
+
+	for (; i + sizeof(uint32_t) <= len; i += sizeof(uint32_t)) {
+		uint32_t word = data[i] | data[i + 1] << 8 | data[i + 2] << 16 | (uint32_t)data[i + 3] << 24;
+		status = FLASH_ProgramWord(FLASH_BASE + chip_offset + i, word);
+		PIOS_Assert(status == FLASH_COMPLETE);
+	}
+
+	for (; i < len; i++) {
 		status = FLASH_ProgramByte(FLASH_BASE + chip_offset + i, data[i]);
 		PIOS_Assert(status == FLASH_COMPLETE);
 	}
@@ -194,6 +207,17 @@ static int32_t PIOS_Flash_Internal_ReadData(uintptr_t chip_id, uint32_t chip_off
 	return 0;
 }
 
+static const uint8_t *PIOS_Flash_Internal_MapData(uintptr_t chip_id, uint32_t chip_offset, uint32_t len)
+{
+	struct pios_internal_flash_dev *flash_dev = (struct pios_internal_flash_dev *)chip_id;
+
+	if (!PIOS_Flash_Internal_Validate(flash_dev))
+		return NULL;
+
+	/* The flash is in the address space of the CPU */
+	return (const uint8_t *)(FLASH_BASE + chip_offset);
+}
+
 /* Provide a flash driver to external drivers */
 const struct pios_flash_driver pios_internal_flash_driver = {
 	.start_transaction = PIOS_Flash_Internal_StartTransaction,
@@ -201,6 +225,7 @@ const struct pios_flash_driver pios_internal_flash_driver = {
 	.erase_sector      = PIOS_Flash_Internal_EraseSector,
 	.write_data        = PIOS_Flash_Internal_WriteData,
 	.read_data         = PIOS_Flash_Internal_ReadData,
+	.map_data          = PIOS_Flash_Internal_MapData,
 };
 
 #endif	/* defined(PIOS_INCLUDE_FLASH_INTERNAL) */
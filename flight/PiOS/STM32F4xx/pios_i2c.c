@@ -40,9 +40,16 @@
 
 #include <pios_i2c_priv.h>
 
+/* Longest a stop condition takes at the lowest bus speed */
+#define I2C_STOP_WAIT_US 100
+
 static void i2c_adapter_inject_event(struct pios_i2c_adapter *i2c_adapter, enum i2c_adapter_event event, bool *woken);
 static void i2c_adapter_fsm_init(struct pios_i2c_adapter *i2c_adapter);
 static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_start_next(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void i2c_adapter_complete(struct pios_i2c_adapter *i2c_adapter, int32_t result, bool *woken);
+static void i2c_adapter_dma_start(struct pios_i2c_adapter *i2c_adapter);
+static void i2c_adapter_dma_stop(struct pios_i2c_adapter *i2c_adapter);
 #if defined(PIOS_I2C_DIAGNOSTICS)
 static void i2c_adapter_log_fault(struct pios_i2c_adapter *i2c_adapter, enum pios_i2c_error_type type);
 #endif
@@ -59,6 +66,7 @@ static void go_r_more_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *
 static void go_r_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_more_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_more_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 
 static void go_r_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_last_txn_pre_one(struct pios_i2c_adapter *i2c_adapter, bool *woken);
@@ -66,6 +74,7 @@ static void go_r_last_txn_pre_first(struct pios_i2c_adapter *i2c_adapter, bool *
 static void go_r_last_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_last_txn_pre_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *woken);
+static void go_r_last_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 
 static void go_w_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken);
 static void go_w_more_txn_pre_middle(struct pios_i2c_adapter *i2c_adapter, bool *woken);
@@ -129,6 +138,7 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_MORE_TXN_PRE_ONE,
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
 			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_MORE_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_DMA] = I2C_STATE_R_MORE_TXN_DMA,
 			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
 		},
 	},
@@ -173,6 +183,24 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
 		},
 	},
+	[I2C_STATE_R_MORE_TXN_DMA] = {
+		.entry_fn = NULL,
+		.next_state = {
+			[I2C_EVENT_DMA_DONE] = I2C_STATE_R_MORE_TXN_POST_DMA,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_MORE_TXN_POST_DMA] = {
+		.entry_fn = go_r_more_txn_post_dma,
+		.next_state = {
+			[I2C_EVENT_R_MORE_TXN_STARTED] = I2C_STATE_R_MORE_TXN_ADDR,
+			[I2C_EVENT_W_MORE_TXN_STARTED] = I2C_STATE_W_MORE_TXN_ADDR,
+			[I2C_EVENT_R_LAST_TXN_STARTED] = I2C_STATE_R_LAST_TXN_ADDR,
+			[I2C_EVENT_W_LAST_TXN_STARTED] = I2C_STATE_W_LAST_TXN_ADDR,
+			[I2C_EVENT_NACK] = I2C_STATE_NACK,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
 
 	/*
 	 * Read with stop
@@ -183,6 +211,7 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_1] = I2C_STATE_R_LAST_TXN_PRE_ONE,
 			[I2C_EVENT_ADDR_SENT_LEN_EQ_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
 			[I2C_EVENT_ADDR_SENT_LEN_GT_2] = I2C_STATE_R_LAST_TXN_PRE_FIRST,
+			[I2C_EVENT_ADDR_SENT_DMA] = I2C_STATE_R_LAST_TXN_DMA,
 			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
 		},
 	},
@@ -222,6 +251,19 @@ static const struct i2c_adapter_transition i2c_adapter_transitions[I2C_STATE_NUM
 			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
 		},
 	},
+	[I2C_STATE_R_LAST_TXN_DMA] = {
+		.entry_fn = NULL,
+		.next_state = {
+			[I2C_EVENT_DMA_DONE] = I2C_STATE_R_LAST_TXN_POST_DMA,
+			[I2C_EVENT_BUS_ERROR] = I2C_STATE_BUS_ERROR,
+		},
+	},
+	[I2C_STATE_R_LAST_TXN_POST_DMA] = {
+		.entry_fn = go_r_last_txn_post_dma,
+		.next_state = {
+			[I2C_EVENT_AUTO] = I2C_STATE_STOPPED,
+		},
+	},
 
 	/*
 	 * Write with restart
@@ -309,6 +351,8 @@ static void go_nack(struct pios_i2c_adapter *i2c_adapter, bool *woken)
 {
 	i2c_adapter->nack = true;
 
+	i2c_adapter_dma_stop(i2c_adapter);
+
 	// setup handling of this byte
 	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, DISABLE);
 	I2C_GenerateSTART(i2c_adapter->cfg->regs, DISABLE);
@@ -326,8 +370,13 @@ static void go_stopped(struct pios_i2c_adapter *i2c_adapter, bool *woken)
 	// disable all irqs
 	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_EVT | I2C_IT_BUF | I2C_IT_ERR, DISABLE);
 
-	/* wake up blocked PIOS_I2C_Transfer() */
-	PIOS_Semaphore_Give_FromISR(i2c_adapter->sem_ready, woken);
+	/* tell the owner, and go on with the next transfer in the queue */
+	if (i2c_adapter->busy) {
+		int32_t result = i2c_adapter->bus_error ? -1 :
+				i2c_adapter->nack ? -3 :
+				0;
+		i2c_adapter_complete(i2c_adapter, result, woken);
+	}
 }
 
 static void go_starting(struct pios_i2c_adapter *i2c_adapter, bool *woken)
@@ -335,6 +384,7 @@ static void go_starting(struct pios_i2c_adapter *i2c_adapter, bool *woken)
 	// set up current txn byte pointers
 	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
 	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
+	i2c_adapter->use_dma = false;
 
 	// enabled interrupts
 	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_EVT | I2C_IT_ERR, ENABLE);
@@ -348,8 +398,13 @@ static void go_starting(struct pios_i2c_adapter *i2c_adapter, bool *woken)
  */
 static void go_r_more_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
 {
-	// enable buffer RxNE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, ENABLE);
+	if (i2c_adapter->cfg->dma && i2c_adapter->last_byte > i2c_adapter->active_byte) {
+		// the DMA takes the bytes once the address is acknowledged
+		i2c_adapter_dma_start(i2c_adapter);
+	} else {
+		// enable buffer RxNE
+		I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, ENABLE);
+	}
 
 	I2C_Send7bitAddress(i2c_adapter->cfg->regs, (i2c_adapter->active_txn->addr) << 1, I2C_Direction_Receiver);
 }
@@ -409,13 +464,34 @@ static void go_r_more_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *
 	I2C_GenerateSTART(i2c_adapter->cfg->regs, ENABLE);
 }
 
+static void go_r_more_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the DMA has taken all bytes of this txn, the last one was NACKed
+	i2c_adapter_dma_stop(i2c_adapter);
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+
+	// set up current txn byte pointers
+	i2c_adapter->active_byte = &(i2c_adapter->active_txn->buf[0]);
+	i2c_adapter->last_byte = &(i2c_adapter->active_txn->buf[i2c_adapter->active_txn->len - 1]);
+
+	// generate repeated START condition
+	I2C_GenerateSTART(i2c_adapter->cfg->regs, ENABLE);
+}
+
 /*
  * Read with stop
  */
 static void go_r_last_txn_addr(struct pios_i2c_adapter *i2c_adapter, bool *woken)
 {
-	// enable buffer RxNE
-	I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, ENABLE);
+	if (i2c_adapter->cfg->dma && i2c_adapter->last_byte > i2c_adapter->active_byte) {
+		// the DMA takes the bytes once the address is acknowledged
+		i2c_adapter_dma_start(i2c_adapter);
+	} else {
+		// enable buffer RxNE
+		I2C_ITConfig(i2c_adapter->cfg->regs, I2C_IT_BUF, ENABLE);
+	}
 
 	I2C_Send7bitAddress(i2c_adapter->cfg->regs, (i2c_adapter->active_txn->addr) << 1, I2C_Direction_Receiver);
 }
@@ -471,6 +547,18 @@ static void go_r_last_txn_post_last(struct pios_i2c_adapter *i2c_adapter, bool *
 	i2c_adapter->active_txn++;
 }
 
+static void go_r_last_txn_post_dma(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	// the DMA has taken all bytes of this txn, the last one was NACKed
+	i2c_adapter_dma_stop(i2c_adapter);
+
+	// generate a stop condition
+	I2C_GenerateSTOP(i2c_adapter->cfg->regs, ENABLE);
+
+	/* Move to the next transaction */
+	i2c_adapter->active_txn++;
+}
+
 
 /*
  * Write with restart
@@ -606,6 +694,8 @@ static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
 	uint8_t retry_count_clk = 0;
 	static const uint8_t MAX_I2C_RETRY_COUNT = 10;
 
+	i2c_adapter_dma_stop(i2c_adapter);
+
 	/* Reset the I2C block */
 	I2C_DeInit(i2c_adapter->cfg->regs);
 
@@ -695,6 +785,156 @@ static void i2c_adapter_reset_bus(struct pios_i2c_adapter *i2c_adapter)
 	}
 }
 
+/**
+ * Starts the transfer at the head of the queue unless one is still running.
+ * Called from the I2C interrupts or with the interrupts disabled.
+ */
+static void i2c_adapter_start_next(struct pios_i2c_adapter *i2c_adapter, bool *woken)
+{
+	if (i2c_adapter->busy || i2c_adapter->queue_count == 0)
+		return;
+
+	const struct pios_i2c_request *request = &i2c_adapter->queue[i2c_adapter->queue_head];
+
+	i2c_adapter->active_txn = &request->txn_list[0];
+	i2c_adapter->last_txn = &request->txn_list[request->num_txns - 1];
+	i2c_adapter->bus_error = false;
+	i2c_adapter->nack = false;
+	i2c_adapter->busy = true;
+	i2c_adapter->start_raw = PIOS_DELAY_GetRaw();
+
+	/* The stop condition of the last transfer has to be sent before the next start */
+	uint32_t retry_count = 0;
+	while ((i2c_adapter->cfg->regs->CR1 & I2C_CR1_STOP) && retry_count++ < I2C_STOP_WAIT_US)
+		PIOS_DELAY_WaituS(1);
+
+	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START, woken);
+}
+
+/**
+ * Takes the active transfer off the queue, calls back its owner and starts
+ * the next one
+ */
+static void i2c_adapter_complete(struct pios_i2c_adapter *i2c_adapter, int32_t result, bool *woken)
+{
+	struct pios_i2c_request request = i2c_adapter->queue[i2c_adapter->queue_head];
+
+	i2c_adapter->queue_head = (i2c_adapter->queue_head + 1) % PIOS_I2C_QUEUE_LEN;
+	i2c_adapter->queue_count--;
+	i2c_adapter->busy = false;
+
+	if (request.callback)
+		request.callback(result, request.context, woken);
+
+	i2c_adapter_start_next(i2c_adapter, woken);
+}
+
+/**
+ * Gives up on the active transfer when it has run for longer than the
+ * timeout, nothing else notices a bus that hangs. Call with the interrupts
+ * disabled.
+ */
+static void i2c_adapter_abort_stale(struct pios_i2c_adapter *i2c_adapter)
+{
+	if (!i2c_adapter->busy ||
+			PIOS_DELAY_DiffuS(i2c_adapter->start_raw) < i2c_adapter->cfg->transfer_timeout_ms * 1000)
+		return;
+
+#if defined(PIOS_I2C_DIAGNOSTICS)
+	i2c_adapter->i2c_timeout_counter++;
+#endif
+
+	i2c_adapter_fsm_init(i2c_adapter);
+
+	bool dummy = false;
+	i2c_adapter_complete(i2c_adapter, -2, &dummy);
+}
+
+/**
+ * Takes a transfer off the queue without calling back its owner, so none of
+ * its buffers are touched any more. Call with the interrupts disabled.
+ * \return false if the transfer was already done
+ */
+static bool i2c_adapter_cancel(struct pios_i2c_adapter *i2c_adapter, const struct pios_i2c_txn txn_list[])
+{
+	for (uint8_t i = 0; i < i2c_adapter->queue_count; i++) {
+		if (i2c_adapter->queue[(i2c_adapter->queue_head + i) % PIOS_I2C_QUEUE_LEN].txn_list != txn_list)
+			continue;
+
+		if (i == 0 && i2c_adapter->busy) {
+			i2c_adapter_fsm_init(i2c_adapter);
+			i2c_adapter->busy = false;
+		}
+
+		/* Close the gap, the order of the others stays */
+		for (uint8_t j = i; j + 1 < i2c_adapter->queue_count; j++) {
+			i2c_adapter->queue[(i2c_adapter->queue_head + j) % PIOS_I2C_QUEUE_LEN] =
+				i2c_adapter->queue[(i2c_adapter->queue_head + j + 1) % PIOS_I2C_QUEUE_LEN];
+		}
+		i2c_adapter->queue_count--;
+
+		bool dummy = false;
+		i2c_adapter_start_next(i2c_adapter, &dummy);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Clears the flags of a stream, it can't be enabled again while they are set
+ */
+static void i2c_adapter_dma_clear_flags(DMA_Stream_TypeDef *stream)
+{
+	static const uint8_t shifts[] = { 0, 6, 16, 22 };
+
+	DMA_TypeDef *dmax = ((uint32_t) stream < (uint32_t) DMA2) ? DMA1 : DMA2;
+	uint32_t index = ((uint32_t) stream - (uint32_t) dmax - 0x10) / 0x18;
+	uint32_t flags = 0x3D << shifts[index & 0x3];
+
+	if (index < 4)
+		dmax->LIFCR = flags;
+	else
+		dmax->HIFCR = flags;
+}
+
+/**
+ * Hands the bytes of the active read txn to the DMA. With the last transfer
+ * bit set the peripheral NACKs the final byte by itself.
+ */
+static void i2c_adapter_dma_start(struct pios_i2c_adapter *i2c_adapter)
+{
+	DMA_Stream_TypeDef *stream = i2c_adapter->cfg->dma->rx.channel;
+
+	i2c_adapter->use_dma = true;
+
+	i2c_adapter_dma_clear_flags(stream);
+	stream->M0AR = (uint32_t) i2c_adapter->active_byte;
+	DMA_SetCurrDataCounter(stream, i2c_adapter->last_byte - i2c_adapter->active_byte + 1);
+	DMA_ITConfig(stream, DMA_IT_TC, ENABLE);
+	DMA_Cmd(stream, ENABLE);
+
+	I2C_AcknowledgeConfig(i2c_adapter->cfg->regs, ENABLE);
+	I2C_DMALastTransferCmd(i2c_adapter->cfg->regs, ENABLE);
+	I2C_DMACmd(i2c_adapter->cfg->regs, ENABLE);
+}
+
+static void i2c_adapter_dma_stop(struct pios_i2c_adapter *i2c_adapter)
+{
+	if (!i2c_adapter->cfg->dma)
+		return;
+
+	DMA_Stream_TypeDef *stream = i2c_adapter->cfg->dma->rx.channel;
+
+	DMA_ITConfig(stream, DMA_IT_TC, DISABLE);
+	DMA_Cmd(stream, DISABLE);
+
+	I2C_DMACmd(i2c_adapter->cfg->regs, DISABLE);
+	I2C_DMALastTransferCmd(i2c_adapter->cfg->regs, DISABLE);
+
+	i2c_adapter->use_dma = false;
+}
+
 /**
  * Logs the last N state transitions and N IRQ events due to
  * an error condition
@@ -776,6 +1016,19 @@ int32_t PIOS_I2C_Init(uint32_t *i2c_id, const struct pios_i2c_adapter_cfg *cfg)
 	/* Initialize the state machine */
 	i2c_adapter_fsm_init(i2c_adapter);
 
+	/* The rx stream only changes its memory address and count from now on */
+	if (cfg->dma) {
+		DMA_InitTypeDef dma_init = cfg->dma->rx.init;
+		dma_init.DMA_PeripheralBaseAddr = (uint32_t) &cfg->regs->DR;
+		dma_init.DMA_Memory0BaseAddr = 0;
+		dma_init.DMA_BufferSize = 1;
+		dma_init.DMA_Mode = DMA_Mode_Normal;
+		DMA_DeInit(cfg->dma->rx.channel);
+		DMA_Init(cfg->dma->rx.channel, &dma_init);
+
+		NVIC_Init((NVIC_InitTypeDef *) &cfg->dma->irq.init);
+	}
+
 	*i2c_id = (uint32_t)i2c_adapter;
 
 	/* Configure and enable I2C interrupts */
@@ -802,7 +1055,7 @@ int32_t PIOS_I2C_CheckClear(uint32_t i2c_id)
 	if (PIOS_Mutex_Lock(i2c_adapter->lock, 0) == false)
 		return -1;
 
-	if (i2c_adapter->state != I2C_STATE_STOPPED) {
+	if (i2c_adapter->state != I2C_STATE_STOPPED || i2c_adapter->busy) {
 		PIOS_Mutex_Unlock(i2c_adapter->lock);
 		return -2;
 	}
@@ -818,6 +1071,16 @@ int32_t PIOS_I2C_CheckClear(uint32_t i2c_id)
 	return 0;
 }
 
+static void i2c_adapter_blocking_done(int32_t result, void *context, bool *woken)
+{
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)context;
+
+	i2c_adapter->blocking_result = result;
+
+	/* wake up blocked PIOS_I2C_Transfer() */
+	PIOS_Semaphore_Give_FromISR(i2c_adapter->sem_ready, woken);
+}
+
 int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns)
 {
 	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
@@ -829,43 +1092,82 @@ int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[],
 	if (PIOS_Mutex_Lock(i2c_adapter->lock, i2c_adapter->cfg->transfer_timeout_ms) == false)
 		return -2;
 
-	i2c_adapter->active_txn = &txn_list[0];
-	i2c_adapter->last_txn = &txn_list[num_txns - 1];
-	i2c_adapter->bus_error = false;
-	i2c_adapter->nack = false;
-
 	/* Make sure the done/ready semaphore is consumed before we start */
 	PIOS_Semaphore_Take(i2c_adapter->sem_ready, 0);
 
-	bool dummy = false;
-	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_START, &dummy);
-
-	/* Wait for the transfer to complete */
-	bool semaphore_success =
-		(PIOS_Semaphore_Take(i2c_adapter->sem_ready, i2c_adapter->cfg->transfer_timeout_ms) == true);
-
-	// handle fsm timeout
-	if (i2c_adapter->state != I2C_STATE_STOPPED) {
-		PIOS_IRQ_Disable();
-		i2c_adapter_fsm_init(i2c_adapter);
-		PIOS_IRQ_Enable();
-	}
+	int32_t result = PIOS_I2C_Transfer_Callback(i2c_id, txn_list, num_txns,
+			i2c_adapter_blocking_done, i2c_adapter);
+
+	if (result == 0) {
+		/* Wait for the transfer to complete */
+		bool semaphore_success =
+			(PIOS_Semaphore_Take(i2c_adapter->sem_ready, i2c_adapter->cfg->transfer_timeout_ms) == true);
+
+		// handle fsm timeout, the transfer may still be done just now
+		if (!semaphore_success) {
+			PIOS_IRQ_Disable();
+			if (!i2c_adapter_cancel(i2c_adapter, txn_list))
+				semaphore_success = true;
+			else
+				i2c_adapter_abort_stale(i2c_adapter);
+			PIOS_IRQ_Enable();
+		}
 
 #if defined(PIOS_I2C_DIAGNOSTICS)
-	if (!semaphore_success)
-		i2c_adapter->i2c_timeout_counter++;
+		if (!semaphore_success)
+			i2c_adapter->i2c_timeout_counter++;
 #endif
 
-	int32_t result = !semaphore_success ? -2 :
-			i2c_adapter->bus_error ? -1 :
-			i2c_adapter->nack ? -3 :
-			0;
+		result = !semaphore_success ? -2 : i2c_adapter->blocking_result;
+	}
 
 	PIOS_Mutex_Unlock(i2c_adapter->lock);
 
 	return result;
 }
 
+/**
+ * Queues a transfer and returns without waiting for it. Transfers of several
+ * drivers run back to back on the bus in the order they were queued.
+ * \param[in] txn_list The transactions, they and their buffers have to stay
+ * valid until the callback
+ * \param[in] callback Called with the result of the transfer
+ * \param[in] context Passed to the callback
+ * \return 0 if queued, -1 if the adapter or list is invalid, -2 if the queue is full
+ */
+int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, pios_i2c_callback callback, void *context)
+{
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+	bool valid = PIOS_I2C_validate(i2c_adapter);
+	if (!valid || num_txns == 0)
+		return -1;
+
+	PIOS_IRQ_Disable();
+
+	i2c_adapter_abort_stale(i2c_adapter);
+
+	if (i2c_adapter->queue_count >= PIOS_I2C_QUEUE_LEN) {
+		PIOS_IRQ_Enable();
+		return -2;
+	}
+
+	struct pios_i2c_request *request =
+		&i2c_adapter->queue[(i2c_adapter->queue_head + i2c_adapter->queue_count) % PIOS_I2C_QUEUE_LEN];
+	request->txn_list = txn_list;
+	request->num_txns = num_txns;
+	request->callback = callback;
+	request->context = context;
+	i2c_adapter->queue_count++;
+
+	bool dummy = false;
+	i2c_adapter_start_next(i2c_adapter, &dummy);
+
+	PIOS_IRQ_Enable();
+
+	return 0;
+}
+
 void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 {
 #if defined(PIOS_INCLUDE_CHIBIOS)
@@ -912,6 +1214,11 @@ void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id)
 		break;
 	case I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED:	/* EV6 */
 	case I2C_EVENT_MASTER_RECEIVER_MODE_SELECTED:	/* EV6 */
+		if (i2c_adapter->use_dma) {
+			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_DMA, &woken);
+			break;
+		}
+
 		switch (i2c_adapter->last_byte - i2c_adapter->active_byte + 1) {
 		case 0:
 			i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_ADDR_SENT_LEN_EQ_0, &woken);
@@ -1019,6 +1326,36 @@ void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id)
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
 }
 
+/**
+ * Handles the transfer complete interrupt of the rx stream, to be called
+ * from the IRQ handler of that stream in the board definitions
+ */
+void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id)
+{
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	CH_IRQ_PROLOGUE();
+#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+
+	struct pios_i2c_adapter *i2c_adapter = (struct pios_i2c_adapter *)i2c_id;
+
+	bool valid = PIOS_I2C_validate(i2c_adapter);
+	PIOS_Assert(valid)
+
+	bool woken = false;
+
+	DMA_ClearITPendingBit(i2c_adapter->cfg->dma->rx.channel, i2c_adapter->cfg->dma->irq.flags);
+
+	i2c_adapter_inject_event(i2c_adapter, I2C_EVENT_DMA_DONE, &woken);
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	portEND_SWITCHING_ISR(woken ? pdTRUE : pdFALSE);
+#endif /* defined(PIOS_INCLUDE_FREERTOS) */
+
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	CH_IRQ_EPILOGUE();
+#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+}
+
 #endif
 
 /**
@@ -30,9 +30,12 @@
 
 /*
  * @note This is a stripped-down ADC driver intended primarily for sampling
- * voltage and current values.  Samples are averaged over the period between
- * fetches so that relatively accurate measurements can be obtained without
- * forcing higher-level logic to poll aggressively.
+ * voltage and current values.  Each time the DMA fills a buffer the samples
+ * of every pin are averaged and run through a low-pass filter with a time
+ * constant of ADC_FILTER_TIME_MS, so all readers of a pin get the same
+ * filtered value at any rate, without computing anything themselves.  The
+ * filter keeps ADC_FILTER_FRAC_BITS below the LSB of the conversions, which
+ * PIOS_ADC_GetChannelPrecise() hands out.
  *
  * @todo This module needs more work to be more generally useful.  It should
  * almost certainly grow callback support so that e.g. voltage and current readings
@@ -53,6 +56,20 @@
 
 #include "pios_queue.h"
 
+// Private constants
+
+//! Cycles of a conversion, the sample time plus 12 for the 12 bit conversion
+#define ADC_CONVERSION_CYCLES (56 + 12)
+
+//! ADCCLK is PCLK2 divided by this
+#define ADC_PRESCALER 8
+
+//! Time constant of the low-pass filter behind the block averages
+#define ADC_FILTER_TIME_MS 10
+
+//! Bits of the filtered values below the LSB of the ADC
+#define ADC_FILTER_FRAC_BITS 8
+
 // Private types
 enum pios_adc_dev_magic {
 	PIOS_INTERNAL_ADC_DEV_MAGIC = 0x58375124,
@@ -69,6 +86,8 @@ struct pios_internal_adc_dev {
 	uint8_t dma_block_size;
 	uint16_t dma_half_buffer_size;
 	uint16_t max_samples;
+	uint8_t filter_shift;
+	volatile bool filter_primed;
 	enum pios_adc_dev_magic magic;
 };
 
@@ -87,22 +106,22 @@ static int32_t PIOS_INTERNAL_ADC_PinGet(uint32_t internal_adc_id, uint32_t pin);
 static uint8_t PIOS_INTERNAL_ADC_Number_of_Channels(uint32_t internal_adc_id);
 static bool PIOS_INTERNAL_ADC_Available(uint32_t adc_id, uint32_t device_pin);
 static float PIOS_INTERNAL_ADC_LSB_Voltage(uint32_t internal_adc_id);
+static float PIOS_INTERNAL_ADC_PinGetPrecise(uint32_t internal_adc_id, uint32_t pin);
 
 const struct pios_adc_driver pios_internal_adc_driver = {
                 .available      = PIOS_INTERNAL_ADC_Available,
                 .get_pin        = PIOS_INTERNAL_ADC_PinGet,
+                .get_pin_precise = PIOS_INTERNAL_ADC_PinGetPrecise,
                 .set_queue      = NULL,
                 .number_of_channels = PIOS_INTERNAL_ADC_Number_of_Channels,
                 .lsb_voltage = PIOS_INTERNAL_ADC_LSB_Voltage,
 };
 
-struct adc_accumulator {
-	uint32_t		accumulator;
-	uint32_t		count;
-};
+// Filter state of each pin, the filtered value in 1 / (1 << ADC_FILTER_FRAC_BITS) LSB
+// times 1 << filter_shift, so the filter doesn't lose the bits it shifts out
+static volatile uint32_t * filter_state;
 
 // Buffers to hold the ADC data
-static struct adc_accumulator * accumulator;
 static uint16_t * adc_raw_buffer_0;
 static uint16_t * adc_raw_buffer_1;
 
@@ -186,7 +205,7 @@ static void init_adc(void)
 	ADC_CommonInitTypeDef ADC_CommonInitStructure;
 	ADC_CommonStructInit(&ADC_CommonInitStructure);
 	ADC_CommonInitStructure.ADC_Mode				= ADC_Mode_Independent;
-	ADC_CommonInitStructure.ADC_Prescaler			= ADC_Prescaler_Div8;
+	ADC_CommonInitStructure.ADC_Prescaler			= ADC_Prescaler_Div8;	/* ADC_PRESCALER */
 	ADC_CommonInitStructure.ADC_DMAAccessMode		= ADC_DMAAccessMode_Disabled;
 	ADC_CommonInitStructure.ADC_TwoSamplingDelay	= ADC_TwoSamplingDelay_5Cycles;
 	ADC_CommonInit(&ADC_CommonInitStructure);
@@ -209,7 +228,7 @@ static void init_adc(void)
 		ADC_RegularChannelConfig(pios_adc_dev->cfg->adc_dev_master,
 				pios_adc_dev->cfg->adc_pins[i].adc_channel,
 				i+1,
-				ADC_SampleTime_56Cycles);		/* XXX this is totally arbitrary... */
+				ADC_SampleTime_56Cycles);		/* XXX this is totally arbitrary... (ADC_CONVERSION_CYCLES) */
 	}
 
 	ADC_DMARequestAfterLastTransferCmd(pios_adc_dev->cfg->adc_dev_master, ENABLE);
@@ -241,8 +260,8 @@ static struct pios_internal_adc_dev * PIOS_INTERNAL_ADC_Allocate(const struct pi
 	bool use_adc_2 = cfg->adc_dev_master == ADC2;
 	adc_dev->max_samples = (((cfg->adc_pin_count + use_adc_2) >> use_adc_2) << use_adc_2) * PIOS_ADC_MAX_OVERSAMPLING * 2;
 
-	accumulator = (struct adc_accumulator *)PIOS_malloc_no_dma(cfg->adc_pin_count * sizeof(struct adc_accumulator));
-	if (!accumulator) {
+	filter_state = (uint32_t *)PIOS_malloc_no_dma(cfg->adc_pin_count * sizeof(uint32_t));
+	if (!filter_state) {
 		PIOS_free(adc_dev);
 		return NULL;
 	}
@@ -250,14 +269,14 @@ static struct pios_internal_adc_dev * PIOS_INTERNAL_ADC_Allocate(const struct pi
 	adc_raw_buffer_0 = (uint16_t *)PIOS_malloc(adc_dev->max_samples * cfg->adc_pin_count * sizeof(uint16_t));
 	if (!adc_raw_buffer_0) {
 		PIOS_free(adc_dev);
-		PIOS_free(accumulator);
+		PIOS_free((void *)filter_state);
 		return NULL;
 	}
 
 	adc_raw_buffer_1 = (uint16_t *)PIOS_malloc(adc_dev->max_samples * cfg->adc_pin_count * sizeof(uint16_t));
 	if (!adc_raw_buffer_1) {
 		PIOS_free(adc_dev);
-		PIOS_free(accumulator);
+		PIOS_free((void *)filter_state);
 		PIOS_free(adc_raw_buffer_0);
 		return NULL;
 	}
@@ -277,8 +296,18 @@ int32_t PIOS_INTERNAL_ADC_Init(uint32_t * internal_adc_id, const struct pios_int
 	
 	pios_adc_dev->cfg = cfg;
 	pios_adc_dev->callback_function = NULL;
+	pios_adc_dev->filter_primed = false;
 
+	/* Largest shift that keeps the time constant of the filter, in buffers, below ADC_FILTER_TIME_MS */
+	RCC_ClocksTypeDef clocks;
+	RCC_GetClocksFreq(&clocks);
+	uint32_t buffers_per_s = clocks.PCLK2_Frequency / ADC_PRESCALER / ADC_CONVERSION_CYCLES /
+		(pios_adc_dev->max_samples * cfg->adc_pin_count);
+	uint32_t buffers_per_tau = buffers_per_s * ADC_FILTER_TIME_MS / 1000;
 
+	pios_adc_dev->filter_shift = 0;
+	while ((2u << pios_adc_dev->filter_shift) <= buffers_per_tau)
+		pios_adc_dev->filter_shift++;
 
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
 	pios_adc_dev->data_queue = NULL;
@@ -325,20 +354,45 @@ static int32_t PIOS_INTERNAL_ADC_PinGet(uint32_t internal_adc_id, uint32_t pin)
 		return -2;
 	}
 
-	if (accumulator[pin].accumulator <= 0) {
+	if (!pios_adc_dev->filter_primed) {
 		return -3;
 	}
 
-	/* return accumulated result and clear accumulator */
-	result = accumulator[pin].accumulator / (accumulator[pin].count ?: 1);
-	accumulator[pin].accumulator = result;
-	accumulator[pin].count = 1;
+	/* return the filtered value rounded to whole LSBs */
+	uint32_t value = filter_state[pin] >> pios_adc_dev->filter_shift;
+	result = (value + (1 << (ADC_FILTER_FRAC_BITS - 1))) >> ADC_FILTER_FRAC_BITS;
 
 	return result;
 #endif
 	return -1;
 }
 
+/**
+ * Returns the value of an ADC pin with the bits the filter gained below the LSB
+ * @param[in] pin number
+ * @return ADC pin value in LSB
+ * @return negative if the pin doesn't exist or no data was acquired yet
+ */
+static float PIOS_INTERNAL_ADC_PinGetPrecise(uint32_t internal_adc_id, uint32_t pin)
+{
+#if defined(PIOS_INCLUDE_ADC)
+	if (!PIOS_INTERNAL_ADC_validate(pios_adc_dev)) {
+		return -1;
+	}
+
+	if (pin >= pios_adc_dev->cfg->adc_pin_count) {
+		return -2;
+	}
+
+	if (!pios_adc_dev->filter_primed) {
+		return -3;
+	}
+
+	return filter_state[pin] * (1.0f / (1 << (ADC_FILTER_FRAC_BITS + pios_adc_dev->filter_shift)));
+#endif
+	return -1;
+}
+
 /**
  * @brief Set a callback function that is executed whenever
  * the ADC double buffer swaps 
@@ -390,33 +444,32 @@ void PIOS_ADC_SetFIRCoefficients(float * new_filter)
 }
 
 /**
- * @brief accumulate the data for each of the channels.
+ * @brief Average a buffer for each of the channels and filter the averages.
  */
 void accumulate(uint16_t *buffer, uint32_t count)
 {
 #if defined(PIOS_INCLUDE_ADC)
-	uint16_t	*sp = buffer;
 	if (!PIOS_INTERNAL_ADC_validate(pios_adc_dev)) {
 		return;
 	}
 
-	/*
-	 * Accumulate sampled values.
-	 */
-	while (count--) {
-		for (int i = 0; i < pios_adc_dev->cfg->adc_pin_count; i++) {
-			accumulator[i].accumulator += *sp++;
-			accumulator[i].count++;
-			/*
-			 * If the accumulator reaches half-full, rescale in order to
-			 * make more space.
-			 */
-			if (accumulator[i].accumulator >= (1 << 31)) {
-				accumulator[i].accumulator /= 2;
-				accumulator[i].count /= 2;
-			}
-		}
+	uint8_t pin_count = pios_adc_dev->cfg->adc_pin_count;
+
+	for (int i = 0; i < pin_count; i++) {
+		/* The samples of a pin are interleaved with the other pins */
+		uint32_t sum = 0;
+		for (uint32_t j = 0; j < count; j++)
+			sum += buffer[j * pin_count + i];
+
+		uint32_t average = (sum << ADC_FILTER_FRAC_BITS) / count;
+
+		if (pios_adc_dev->filter_primed)
+			filter_state[i] += average - (filter_state[i] >> pios_adc_dev->filter_shift);
+		else
+			filter_state[i] = average << pios_adc_dev->filter_shift;
 	}
+
+	pios_adc_dev->filter_primed = true;
 	
 #if defined(PIOS_INCLUDE_FREERTOS) || defined(PIOS_INCLUDE_CHIBIOS)
 	// XXX should do something with this
@@ -207,6 +207,30 @@ int32_t PIOS_OVERO_GetWrittenBytes(uintptr_t overo_id)
 	return overo_dev->writing_offset;
 }
 
+/**
+ * Replace the contents of the next packet with a whole frame. The frame goes
+ * out with the next transfer, a frame set before that is replaced by this one.
+ * \return 0 on success, -1 if the frame is larger than a packet
+ */
+int32_t PIOS_OVERO_SetFrame(uintptr_t overo_id, const uint8_t *frame, uint32_t len)
+{
+	struct pios_overo_dev * overo_dev = (struct pios_overo_dev *) overo_id;
+	PIOS_Assert(PIOS_OVERO_validate(overo_dev));
+
+	if (len > PACKET_SIZE)
+		return -1;
+
+	// The buffers swap at the end of each transfer, so the frame must not be
+	// split across them
+	PIOS_IRQ_Disable();
+	memcpy(&overo_dev->tx_buffer[overo_dev->writing_buffer][0], frame, len);
+	memset(&overo_dev->tx_buffer[overo_dev->writing_buffer][len], 0xFF, PACKET_SIZE - len);
+	overo_dev->writing_offset = PACKET_SIZE;
+	PIOS_IRQ_Enable();
+
+	return 0;
+}
+
 /**
  * Initialise a single Overo device
  */
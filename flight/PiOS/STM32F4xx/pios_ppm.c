@@ -8,7 +8,7 @@
  *
  * @file       pios_ppm.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2013-2016
  * @brief      PPM Input functions (STM32 dependent)
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -49,6 +49,12 @@ const struct pios_rcvr_driver pios_ppm_rcvr_driver = {
 #define PIOS_PPM_IN_MIN_CHANNEL_PULSE_US	750	// microseconds
 #define PIOS_PPM_IN_MAX_CHANNEL_PULSE_US	2250   // microseconds
 
+/* Edges captured by DMA are decoded on each RTC tick, so the buffer holds
+ * several ticks worth of them. Without edges for longer than the timer takes
+ * to wrap, the time since the last one is unknown. */
+#define PIOS_PPM_DMA_NUM_EDGES			32
+#define PIOS_PPM_DMA_MAX_IDLE_TICKS		(60000 / 1600)	// RTC ticks
+
 /* Local Variables */
 static TIM_ICInitTypeDef TIM_ICInitStructure;
 
@@ -76,6 +82,13 @@ struct pios_ppm_dev {
 	uint8_t supv_timer;
 	volatile bool Tracking;
 	volatile bool Fresh;
+
+	/* Only used when the edges are captured by DMA */
+	uint16_t DmaEdges[PIOS_PPM_DMA_NUM_EDGES];
+	uint16_t DmaTail;
+	uint16_t DmaIdleTicks;
+	bool DmaSeeded;
+	bool Dma;
 };
 
 static bool PIOS_PPM_validate(struct pios_ppm_dev * ppm_dev)
@@ -94,6 +107,9 @@ static struct pios_ppm_dev * PIOS_PPM_alloc(void)
 	return(ppm_dev);
 }
 
+static bool PIOS_PPM_dma_init(struct pios_ppm_dev * ppm_dev);
+static void PIOS_PPM_dma_decode(struct pios_ppm_dev * ppm_dev);
+static void PIOS_PPM_pulse(struct pios_ppm_dev * ppm_dev, uint32_t delta);
 static void PIOS_PPM_tim_overflow_cb (uintptr_t id, uintptr_t context, uint8_t channel, uint16_t count);
 static void PIOS_PPM_tim_edge_cb (uintptr_t id, uintptr_t context, uint8_t channel, uint16_t count);
 const static struct pios_tim_callbacks tim_callbacks = {
@@ -125,6 +141,7 @@ extern int32_t PIOS_PPM_Init(uintptr_t * ppm_id, const struct pios_ppm_cfg * cfg
 	ppm_dev->NumChannelCounter = 0;
 	ppm_dev->Tracking = false;
 	ppm_dev->Fresh = false;
+	ppm_dev->Dma = false;
 
 	for (uint8_t i = 0; i < PIOS_PPM_IN_MAX_NUM_CHANNELS; i++) {
 		/* Flush counter variables */
@@ -138,8 +155,10 @@ extern int32_t PIOS_PPM_Init(uintptr_t * ppm_id, const struct pios_ppm_cfg * cfg
 		return -1;
 	}
 
-	/* Configure the channels to be in capture/compare mode */
-	for (uint8_t i = 0; i < cfg->num_channels; i++) {
+	/* Configure the channels to be in capture/compare mode, unless the edges
+	 * are captured by DMA */
+	bool dma = PIOS_PPM_dma_init(ppm_dev);
+	for (uint8_t i = 0; i < cfg->num_channels && !dma; i++) {
 		const struct pios_tim_channel * chan = &cfg->channels[i];
 
 		/* Configure timer for input capture */
@@ -245,9 +264,129 @@ static void PIOS_PPM_tim_edge_cb (uintptr_t tim_id, uintptr_t context, uint8_t c
 	ppm_dev->CurrentTime += ppm_dev->LargeCounter;
 
 	/* Capture computation */		
-	ppm_dev->DeltaTime = ppm_dev->CurrentTime - ppm_dev->PreviousTime;
+	PIOS_PPM_pulse(ppm_dev, ppm_dev->CurrentTime - ppm_dev->PreviousTime);
 
 	ppm_dev->PreviousTime = ppm_dev->CurrentTime;
+}
+
+/**
+ * Set up DMA to capture the edges of the single PPM channel into a ring
+ * \return false if the board has no DMA for it or the timer doesn't count
+ * the full 16 bits, then the edges interrupt as before
+ */
+static bool PIOS_PPM_dma_init(struct pios_ppm_dev * ppm_dev)
+{
+	const struct pios_ppm_cfg * cfg = ppm_dev->cfg;
+
+	if (cfg->dma == NULL || cfg->num_channels != 1)
+		return false;
+
+	const struct pios_tim_channel * chan = &cfg->channels[0];
+
+	/* The time between two edges is the difference of their 16 bit counts */
+	if (chan->timer->ARR != 0xFFFF)
+		return false;
+
+	volatile uint32_t * ccr;
+	uint16_t request;
+	switch (chan->timer_chan) {
+	case TIM_Channel_1:
+		ccr = &chan->timer->CCR1;
+		request = TIM_DMA_CC1;
+		break;
+	case TIM_Channel_2:
+		ccr = &chan->timer->CCR2;
+		request = TIM_DMA_CC2;
+		break;
+	case TIM_Channel_3:
+		ccr = &chan->timer->CCR3;
+		request = TIM_DMA_CC3;
+		break;
+	case TIM_Channel_4:
+		ccr = &chan->timer->CCR4;
+		request = TIM_DMA_CC4;
+		break;
+	default:
+		return false;
+	}
+
+	TIM_ICInitTypeDef TIM_ICInitStructure = cfg->tim_ic_init;
+	TIM_ICInitStructure.TIM_Channel = chan->timer_chan;
+	TIM_ICInit(chan->timer, &TIM_ICInitStructure);
+
+	RCC_AHB1PeriphClockCmd(cfg->dma->ahb_clk, ENABLE);
+
+	DMA_Cmd(cfg->dma->stream, DISABLE);
+	DMA_InitTypeDef dma_init = {
+		.DMA_Channel = cfg->dma->channel,
+		.DMA_PeripheralBaseAddr = (uint32_t) ccr,
+		.DMA_Memory0BaseAddr = (uint32_t) ppm_dev->DmaEdges,
+		.DMA_DIR = DMA_DIR_PeripheralToMemory,
+		.DMA_BufferSize = PIOS_PPM_DMA_NUM_EDGES,
+		.DMA_PeripheralInc = DMA_PeripheralInc_Disable,
+		.DMA_MemoryInc = DMA_MemoryInc_Enable,
+		.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord,
+		.DMA_MemoryDataSize = DMA_MemoryDataSize_HalfWord,
+		.DMA_Mode = DMA_Mode_Circular,
+		.DMA_Priority = DMA_Priority_Medium,
+		.DMA_FIFOMode = DMA_FIFOMode_Disable,
+		.DMA_FIFOThreshold = DMA_FIFOThreshold_Full,
+		.DMA_MemoryBurst = DMA_MemoryBurst_Single,
+		.DMA_PeripheralBurst = DMA_PeripheralBurst_Single,
+	};
+	DMA_Init(cfg->dma->stream, &dma_init);
+	DMA_Cmd(cfg->dma->stream, ENABLE);
+
+	ppm_dev->DmaTail = 0;
+	ppm_dev->DmaIdleTicks = 0;
+	ppm_dev->DmaSeeded = false;
+	ppm_dev->Dma = true;
+
+	/* Only the DMA is requested, the edges no longer interrupt */
+	TIM_DMACmd(chan->timer, request, ENABLE);
+
+	return true;
+}
+
+/**
+ * Decode the edges the DMA captured since the last RTC tick
+ */
+static void PIOS_PPM_dma_decode(struct pios_ppm_dev * ppm_dev)
+{
+	uint16_t head = PIOS_PPM_DMA_NUM_EDGES - DMA_GetCurrDataCounter(ppm_dev->cfg->dma->stream);
+	if (head >= PIOS_PPM_DMA_NUM_EDGES)
+		head = 0;
+
+	if (head == ppm_dev->DmaTail) {
+		/* After the timer wrapped the next edge only starts over */
+		if (ppm_dev->DmaIdleTicks < PIOS_PPM_DMA_MAX_IDLE_TICKS)
+			ppm_dev->DmaIdleTicks++;
+		else
+			ppm_dev->DmaSeeded = false;
+		return;
+	}
+
+	ppm_dev->DmaIdleTicks = 0;
+
+	while (ppm_dev->DmaTail != head) {
+		uint16_t count = ppm_dev->DmaEdges[ppm_dev->DmaTail];
+		ppm_dev->DmaTail = (ppm_dev->DmaTail + 1) % PIOS_PPM_DMA_NUM_EDGES;
+
+		if (ppm_dev->DmaSeeded)
+			PIOS_PPM_pulse(ppm_dev, (uint16_t)(count - ppm_dev->PreviousTime));
+
+		ppm_dev->PreviousTime = count;
+		ppm_dev->DmaSeeded = true;
+	}
+}
+
+/**
+ * Take the time from one rising edge to the next into the frame
+ * \param[in] delta the time in us
+ */
+static void PIOS_PPM_pulse(struct pios_ppm_dev * ppm_dev, uint32_t delta)
+{
+	ppm_dev->DeltaTime = delta;
 
 	/* Sync pulse detection */
 	if (ppm_dev->DeltaTime > PIOS_PPM_IN_MIN_SYNC_PULSE_US) {
@@ -313,6 +452,9 @@ static void PIOS_PPM_Supervisor(uintptr_t ppm_id) {
 		return;
 	}
 
+	if (ppm_dev->Dma)
+		PIOS_PPM_dma_decode(ppm_dev);
+
 	/*
 	 * RTC runs at 625Hz so divide down the base rate so
 	 * that this loop runs at twice the period required
@@ -8,7 +8,7 @@
  *
  * @file       pios_servo.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014-2015
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2014-2016
  * @brief      RC Servo routines (STM32 dependent)
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -43,12 +43,78 @@ static enum pwm_mode *output_channel_resolution;  // The clock rate for that tim
 #if defined(PIOS_INCLUDE_HPWM)
 enum SYNC_PWM {SYNC_PWM_FALSE, SYNC_PWM_TRUE};
 static enum SYNC_PWM *output_channel_mode;
+//! Compare value at which the last synchronous pulses of the timer end
+static uint32_t *output_channel_pulse_end;
 #endif
 
 /* Private constant definitions */
 #define PWM_MODE_1MHZ_RATE   1000000
 #define PWM_MODE_12MHZ_RATE  12000000
 
+#if defined(PIOS_INCLUDE_HPWM)
+/* DShot frames are 11 bits of throttle, a telemetry request and a 4 bit */
+/* checksum. Values below 48 are commands to the ESC and never sent. */
+#define DSHOT_MIN_THROTTLE   48
+#define DSHOT_MAX_THROTTLE   2047
+#define DSHOT_FRAME_BITS     16
+
+/* Every bit is one timer period, a 1 is high for 3/4 of it, a 0 for 3/8 */
+#define DSHOT_COUNTS_PER_BIT 20
+#define DSHOT_BIT_1_COUNTS   14
+#define DSHOT_BIT_0_COUNTS   7
+
+/* The compare values are preloaded, so the low slots after the frame let */
+/* its last bit finish and keep the line low until the next one */
+#define DSHOT_FRAME_SLOTS    (DSHOT_FRAME_BITS + 2)
+#define DSHOT_MAX_CHANNELS   4
+
+#define DSHOT_DMA_FLAGS(n)   (DMA_FLAG_TCIF##n | DMA_FLAG_HTIF##n | DMA_FLAG_TEIF##n | \
+                              DMA_FLAG_DMEIF##n | DMA_FLAG_FEIF##n)
+
+/**
+ * The update request of each timer is wired to a fixed DMA stream, TIM9-TIM12
+ * have none. TIM4 and TIM5 share one, so only one of them can send DShot.
+ */
+struct dshot_dma {
+	TIM_TypeDef *timer;
+	DMA_Stream_TypeDef *stream;
+	uint32_t channel;
+	uint32_t flags;
+	uint32_t clock;
+};
+
+static const struct dshot_dma dshot_dmas[] = {
+	{ TIM1, DMA2_Stream5, DMA_Channel_6, DSHOT_DMA_FLAGS(5), RCC_AHB1Periph_DMA2 },
+	{ TIM2, DMA1_Stream1, DMA_Channel_3, DSHOT_DMA_FLAGS(1), RCC_AHB1Periph_DMA1 },
+	{ TIM3, DMA1_Stream2, DMA_Channel_5, DSHOT_DMA_FLAGS(2), RCC_AHB1Periph_DMA1 },
+	{ TIM4, DMA1_Stream6, DMA_Channel_2, DSHOT_DMA_FLAGS(6), RCC_AHB1Periph_DMA1 },
+	{ TIM5, DMA1_Stream6, DMA_Channel_6, DSHOT_DMA_FLAGS(6), RCC_AHB1Periph_DMA1 },
+	{ TIM8, DMA2_Stream1, DMA_Channel_7, DSHOT_DMA_FLAGS(1), RCC_AHB1Periph_DMA2 },
+};
+
+#define DSHOT_MAX_TIMERS NELEMENTS(dshot_dmas)
+
+/**
+ * On every update event the DMA writes the next slot of all compare
+ * registers of the timer in one burst, from CCR1 up to the last one used.
+ * A frame for all channels of the timer is one transfer.
+ */
+struct dshot_timer {
+	bool enabled;
+	uint8_t burst;
+	uint8_t used;
+	uint16_t values[DSHOT_MAX_CHANNELS];
+	uint32_t buffer[DSHOT_FRAME_SLOTS * DSHOT_MAX_CHANNELS];
+};
+
+static struct dshot_timer *dshot_timers[DSHOT_MAX_TIMERS];
+
+static bool dshot_start(TIM_TypeDef *timer);
+static void dshot_stop(TIM_TypeDef *timer);
+static void dshot_send(struct dshot_timer *dt, const struct dshot_dma *dma);
+static uint32_t get_compare(const struct pios_tim_channel *chan);
+#endif /* PIOS_INCLUDE_HPWM */
+
 /**
 * Initialise Servos
 */
@@ -103,6 +169,12 @@ int32_t PIOS_Servo_Init(const struct pios_servo_cfg * cfg)
 		return -1;
 	}
 	memset(output_channel_mode, 0, servo_cfg->num_channels * sizeof(typeof(output_channel_mode)));
+
+	output_channel_pulse_end = PIOS_malloc(servo_cfg->num_channels * sizeof(*output_channel_pulse_end));
+	if (output_channel_pulse_end == NULL) {
+		return -1;
+	}
+	memset(output_channel_pulse_end, 0, servo_cfg->num_channels * sizeof(*output_channel_pulse_end));
 #endif
 
 	return 0;
@@ -151,9 +223,28 @@ void PIOS_Servo_SetMode(const uint16_t * speeds, const enum pwm_mode *pwm_mode,
 				clk_rate = PWM_MODE_1MHZ_RATE; // Default output timer frequency in hertz
 			} else if (pwm_mode[set] == PWM_MODE_12MHZ) {
 				clk_rate = PWM_MODE_12MHZ_RATE; // Default output timer frequency in hertz
+#if defined(PIOS_INCLUDE_HPWM)
+			} else if (pwm_mode[set] == PWM_MODE_DSHOT150) {
+				clk_rate = 150000 * DSHOT_COUNTS_PER_BIT;
+			} else if (pwm_mode[set] == PWM_MODE_DSHOT300) {
+				clk_rate = 300000 * DSHOT_COUNTS_PER_BIT;
+			} else if (pwm_mode[set] == PWM_MODE_DSHOT600) {
+				clk_rate = 600000 * DSHOT_COUNTS_PER_BIT;
+#endif
+			} else {
+				// Unknown mode, leave this timer alone
+				set++;
+				continue;
 			}
 
-			if (speeds[set] == 0) {
+#if defined(PIOS_INCLUDE_HPWM)
+			dshot_stop(chan->timer);
+#endif
+
+			if (PIOS_SERVO_IS_DSHOT(pwm_mode[set])) {
+				// Frames are sent on PIOS_Servo_Update, the rate is that of the loop
+				TIM_TimeBaseStructure.TIM_Period = DSHOT_COUNTS_PER_BIT - 1;
+			} else if (speeds[set] == 0) {
 				// Use a maximally long period because we don't want pulses actually repeating
 				// without new data arriving.
 				TIM_TimeBaseStructure.TIM_Period = 0xFFFFFFFF;
@@ -177,12 +268,23 @@ void PIOS_Servo_SetMode(const uint16_t * speeds, const enum pwm_mode *pwm_mode,
 			// Configure this timer appropriately.
 			TIM_TimeBaseInit(chan->timer, &TIM_TimeBaseStructure);	
 
+#if defined(PIOS_INCLUDE_HPWM)
+			// DShot on a timer without a free DMA stream leaves its outputs low
+			if (PIOS_SERVO_IS_DSHOT(pwm_mode[set]) && !dshot_start(chan->timer)) {
+				TIM_SetCompare1(chan->timer, 0);
+				TIM_SetCompare2(chan->timer, 0);
+				TIM_SetCompare3(chan->timer, 0);
+				TIM_SetCompare4(chan->timer, 0);
+			}
+#endif
+
 			/* Configure frequency scaler for all channels that use the same timer */
 			for (uint8_t j=0; (j < servo_cfg->num_channels); j++) {
 				if (chan->timer == servo_cfg->channels[j].timer) {
 #if defined(PIOS_INCLUDE_HPWM)
 					/* save the frequency for these channels */
 					output_channel_mode[j] = (speeds[set] == 0) ? SYNC_PWM_TRUE : SYNC_PWM_FALSE;
+					output_channel_pulse_end[j] = 0;
 					output_channel_resolution[j] = pwm_mode[set];
 #endif
 				}
@@ -208,6 +310,18 @@ void PIOS_Servo_Set(uint8_t servo, float position)
 
 	const struct pios_tim_channel * chan = &servo_cfg->channels[servo];
 
+	/* For DShot the position is the throttle value of the frame */
+	if (PIOS_SERVO_IS_DSHOT(output_channel_resolution[servo])) {
+		for (uint8_t i = 0; i < DSHOT_MAX_TIMERS; i++) {
+			if (dshot_dmas[i].timer == chan->timer && dshot_timers[i] && dshot_timers[i]->enabled) {
+				uint16_t value = bound_min_max(position + 0.5f, 0, DSHOT_MAX_THROTTLE);
+				dshot_timers[i]->values[chan->timer_chan / TIM_Channel_2] =
+					(value < DSHOT_MIN_THROTTLE) ? 0 : value;
+			}
+		}
+		return;
+	}
+
 	/* recalculate the position value based on timer clock rate */
 	/* position is in us. Note: if the set of channel resolutions */
 	/* stop all being multiples of 1MHz we might need to refactor */
@@ -220,15 +334,14 @@ void PIOS_Servo_Set(uint8_t servo, float position)
 	case PWM_MODE_12MHZ:
 		us_to_count = PWM_MODE_12MHZ_RATE / 1000000;
 		break;
+	default:
+		/* DShot channels never get here */
+		break;
 	}
 	position = position * us_to_count;
 
-	/* stop the timer in OneShot (Synchronous) mode */
-	if (output_channel_mode[servo] == SYNC_PWM_TRUE) {
-		TIM_Cmd(chan->timer, DISABLE);
-	}
-
-	/* Update the position */
+	/* Update the position. The compare registers are preloaded, so in */
+	/* OneShot (Synchronous) mode this only takes effect on PIOS_Servo_Update */
 	switch(chan->timer_chan) {
 		case TIM_Channel_1:
 			TIM_SetCompare1(chan->timer, position);
@@ -284,6 +397,13 @@ void PIOS_Servo_Set(uint8_t servo, uint16_t position)
 #if defined(PIOS_INCLUDE_HPWM)
 /**
 * Update the timer for HPWM/OneShot
+*
+* Generates an update event on every timer in synchronous mode, which loads
+* the compare values set since the last update and starts the pulses. The
+* timers keep running, a timer whose last pulses have not ended yet waits
+* for the next update.
+*
+* Sends a frame on every timer in DShot mode.
 */
 void PIOS_Servo_Update()
 {
@@ -291,17 +411,200 @@ void PIOS_Servo_Update()
 		return;
 	}
 
+	for (uint8_t i = 0; i < DSHOT_MAX_TIMERS; i++) {
+		struct dshot_timer *dt = dshot_timers[i];
+		if (dt && dt->enabled) {
+			dshot_send(dt, &dshot_dmas[i]);
+		}
+	}
+
 	for (uint8_t i = 0; i < servo_cfg->num_channels; i++) {
 		const struct pios_tim_channel * chan = &servo_cfg->channels[i];
 
 		/* Check for channels that are using synchronous output */
-		/* Look for a disabled timer using synchronous output */
-		if (!(chan->timer->CR1 & TIM_CR1_CEN)) {
-			/* enable it again and reinitialize it */
-			TIM_Cmd(chan->timer, ENABLE);
-			TIM_GenerateEvent(chan->timer, TIM_EventSource_Update);
+		if (output_channel_mode[i] != SYNC_PWM_TRUE) {
+			continue;
+		}
+
+		/* All channels of a timer share its mode, restart it only once */
+		bool first = true;
+		for (uint8_t j = 0; (j < i) && first; j++) {
+			first = (chan->timer != servo_cfg->channels[j].timer);
+		}
+
+		if (!first) {
+			continue;
+		}
+
+		/* A pulse still going out is not cut short, the next update has the new values */
+		if (TIM_GetCounter(chan->timer) < output_channel_pulse_end[i]) {
+			continue;
+		}
+
+		/* Load the compare values and start the pulses of all channels at once */
+		TIM_GenerateEvent(chan->timer, TIM_EventSource_Update);
+
+		uint32_t pulse_end = 0;
+		for (uint8_t j = i; j < servo_cfg->num_channels; j++) {
+			if (chan->timer == servo_cfg->channels[j].timer) {
+				pulse_end = MAX(pulse_end, get_compare(&servo_cfg->channels[j]));
+			}
+		}
+		output_channel_pulse_end[i] = pulse_end;
+	}
+}
+
+/**
+ * Reads the compare value of a channel, the preloaded one if it was changed
+ * since the last update event
+ */
+static uint32_t get_compare(const struct pios_tim_channel *chan)
+{
+	switch(chan->timer_chan) {
+		case TIM_Channel_1:
+			return TIM_GetCapture1(chan->timer);
+		case TIM_Channel_2:
+			return TIM_GetCapture2(chan->timer);
+		case TIM_Channel_3:
+			return TIM_GetCapture3(chan->timer);
+		case TIM_Channel_4:
+			return TIM_GetCapture4(chan->timer);
+	}
+
+	return 0;
+}
+
+/**
+ * Finds the DMA stream of a timer
+ * \return its index in dshot_dmas or -1 if the timer has none
+ */
+static int8_t dshot_find(TIM_TypeDef *timer)
+{
+	for (uint8_t i = 0; i < DSHOT_MAX_TIMERS; i++) {
+		if (dshot_dmas[i].timer == timer) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/**
+ * Sets up the DMA burst of a timer for all its servo channels
+ * \return false if the timer has no DMA stream or another driver uses it
+ */
+static bool dshot_start(TIM_TypeDef *timer)
+{
+	int8_t idx = dshot_find(timer);
+	if (idx < 0) {
+		return false;
+	}
+
+	const struct dshot_dma *dma = &dshot_dmas[idx];
+	RCC_AHB1PeriphClockCmd(dma->clock, ENABLE);
+
+	/* Streams set up for another channel belong to another driver */
+	if ((dma->stream->CR & DMA_SxCR_EN) ||
+	    (dma->stream->CR != 0 && (dma->stream->CR & DMA_SxCR_CHSEL) != dma->channel)) {
+		return false;
+	}
+
+	if (dshot_timers[idx] == NULL) {
+		dshot_timers[idx] = PIOS_malloc(sizeof(struct dshot_timer));
+		if (dshot_timers[idx] == NULL) {
+			return false;
 		}
 	}
+
+	struct dshot_timer *dt = dshot_timers[idx];
+	memset(dt, 0, sizeof(*dt));
+
+	for (uint8_t i = 0; i < servo_cfg->num_channels; i++) {
+		const struct pios_tim_channel * chan = &servo_cfg->channels[i];
+		if (chan->timer == timer) {
+			uint8_t ccr = chan->timer_chan / TIM_Channel_2;
+			dt->used |= 1 << ccr;
+			dt->burst = MAX(dt->burst, ccr + 1);
+		}
+	}
+
+	DMA_InitTypeDef dma_init = {
+		.DMA_Channel = dma->channel,
+		.DMA_PeripheralBaseAddr = (uint32_t) &timer->DMAR,
+		.DMA_Memory0BaseAddr = (uint32_t) dt->buffer,
+		.DMA_DIR = DMA_DIR_MemoryToPeripheral,
+		.DMA_BufferSize = DSHOT_FRAME_SLOTS * dt->burst,
+		.DMA_PeripheralInc = DMA_PeripheralInc_Disable,
+		.DMA_MemoryInc = DMA_MemoryInc_Enable,
+		.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word,
+		.DMA_MemoryDataSize = DMA_MemoryDataSize_Word,
+		.DMA_Mode = DMA_Mode_Normal,
+		.DMA_Priority = DMA_Priority_High,
+		.DMA_FIFOMode = DMA_FIFOMode_Disable,
+		.DMA_FIFOThreshold = DMA_FIFOThreshold_Full,
+		.DMA_MemoryBurst = DMA_MemoryBurst_Single,
+		.DMA_PeripheralBurst = DMA_PeripheralBurst_Single,
+	};
+	DMA_Init(dma->stream, &dma_init);
+
+	/* The frame starts with the line low until the first update */
+	TIM_SetCompare1(timer, 0);
+	TIM_SetCompare2(timer, 0);
+	TIM_SetCompare3(timer, 0);
+	TIM_SetCompare4(timer, 0);
+
+	TIM_DMAConfig(timer, TIM_DMABase_CCR1, (dt->burst - 1) * TIM_DMABurstLength_2Transfers);
+	TIM_DMACmd(timer, TIM_DMA_Update, ENABLE);
+
+	dt->enabled = true;
+	return true;
+}
+
+/**
+ * Gives the DMA stream of a timer back, when it leaves DShot mode
+ */
+static void dshot_stop(TIM_TypeDef *timer)
+{
+	int8_t idx = dshot_find(timer);
+	if (idx < 0 || dshot_timers[idx] == NULL || !dshot_timers[idx]->enabled) {
+		return;
+	}
+
+	TIM_DMACmd(timer, TIM_DMA_Update, DISABLE);
+	DMA_DeInit(dshot_dmas[idx].stream);
+
+	dshot_timers[idx]->enabled = false;
+}
+
+/**
+ * Encodes the frames of all channels of a timer and starts their transfer
+ */
+static void dshot_send(struct dshot_timer *dt, const struct dshot_dma *dma)
+{
+	/* A frame still going out is not cut short, the next one has the new values */
+	if (DMA_GetCmdStatus(dma->stream) == ENABLE) {
+		return;
+	}
+
+	for (uint8_t ccr = 0; ccr < dt->burst; ccr++) {
+		if (!(dt->used & (1 << ccr))) {
+			continue;
+		}
+
+		/* No telemetry request, the checksum is the xor of the nibbles */
+		uint16_t packet = dt->values[ccr] << 1;
+		uint16_t frame = (packet << 4) | ((packet ^ (packet >> 4) ^ (packet >> 8)) & 0xF);
+
+		/* Most significant bit first */
+		for (uint8_t bit = 0; bit < DSHOT_FRAME_BITS; bit++) {
+			dt->buffer[bit * dt->burst + ccr] = (frame & (0x8000 >> bit)) ?
+				DSHOT_BIT_1_COUNTS : DSHOT_BIT_0_COUNTS;
+		}
+	}
+
+	DMA_ClearFlag(dma->stream, dma->flags);
+	DMA_SetCurrDataCounter(dma->stream, DSHOT_FRAME_SLOTS * dt->burst);
+	DMA_Cmd(dma->stream, ENABLE);
 }
 
 #endif /* PIOS_INCLUDE_HPWM */
@@ -8,7 +8,7 @@
  *
  * @file       pios_usart.c
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2014
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @brief      USART commands. Inits USARTs, controls USARTs & Interupt handlers. (STM32 dependent)
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -31,6 +31,11 @@
 
 /*
  * @todo This is virtually identical to the F1xx driver and should be merged.
+ *
+ * Ports with a DMA configuration receive into a circular buffer, which is
+ * handed to the COM layer when it is half or completely full and when the
+ * line goes idle. They send what the COM layer has in chunks, the end of
+ * each chunk is signalled by the transmission complete interrupt.
  */
 
 /* Project Includes */
@@ -59,6 +64,10 @@ const struct pios_com_driver pios_usart_com_driver = {
 	.bind_rx_cb = PIOS_USART_RegisterRxCallback,
 };
 
+/* Half of the RX buffer is received between interrupts */
+#define PIOS_USART_DMA_RX_BUFFER_SIZE 128
+#define PIOS_USART_DMA_TX_BUFFER_SIZE 64
+
 enum pios_usart_dev_magic {
 	PIOS_USART_DEV_MAGIC = 0x4152834A,
 };
@@ -71,6 +80,10 @@ struct pios_usart_dev {
 	uintptr_t rx_in_context;
 	pios_com_callback tx_out_cb;
 	uintptr_t tx_out_context;
+
+	uint8_t *dma_rx_buffer;
+	uint16_t dma_rx_pos;
+	uint8_t *dma_tx_buffer;
 };
 
 static bool PIOS_USART_validate(struct pios_usart_dev * usart_dev)
@@ -97,6 +110,9 @@ static struct pios_usart_dev * PIOS_USART_alloc(void)
  * each physical IRQ to a specific registered device instance.
  */
 static void PIOS_USART_generic_irq_handler(uintptr_t usart_id);
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev * usart_dev);
+static void PIOS_USART_DMA_RxDrain(struct pios_usart_dev * usart_dev, bool * need_yield);
+static void PIOS_USART_DMA_TxNext(struct pios_usart_dev * usart_dev, bool * need_yield);
 
 static uintptr_t PIOS_USART_1_id;
 void USART1_IRQHandler(void) __attribute__ ((alias ("PIOS_USART_1_irq_handler")));
@@ -250,8 +266,13 @@ int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg)
 		break;
 	}
 	NVIC_Init((NVIC_InitTypeDef *)&(usart_dev->cfg->irq.init));
-	USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
-	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE,  ENABLE);
+	if (usart_dev->cfg->dma) {
+		if (PIOS_USART_DMA_Init(usart_dev))
+			goto out_fail;
+	} else {
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE,  ENABLE);
+	}
 
 	// FIXME XXX Clear / reset uart here - sends NUL char else
 
@@ -271,6 +292,10 @@ static void PIOS_USART_RxStart(uintptr_t usart_id, uint16_t rx_bytes_avail)
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
 	
+	/* The DMA never stops receiving */
+	if (usart_dev->cfg->dma)
+		return;
+
 	USART_ITConfig(usart_dev->cfg->regs, USART_IT_RXNE, ENABLE);
 }
 static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail)
@@ -280,6 +305,13 @@ static void PIOS_USART_TxStart(uintptr_t usart_id, uint16_t tx_bytes_avail)
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
 	
+	/* The transmission complete flag stays set while idle, so the */
+	/* interrupt starts the first chunk right away */
+	if (usart_dev->cfg->dma) {
+		USART_ITConfig(usart_dev->cfg->regs, USART_IT_TC, ENABLE);
+		return;
+	}
+
 	USART_ITConfig(usart_dev->cfg->regs, USART_IT_TXE, ENABLE);
 }
 
@@ -343,7 +375,30 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 
 	bool valid = PIOS_USART_validate(usart_dev);
 	PIOS_Assert(valid);
+
+	PIOS_TRACE(PIOS_TRACE_ISR_ENTER, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
 	
+	if (usart_dev->cfg->dma) {
+		bool need_yield = false;
+		uint16_t sr = usart_dev->cfg->regs->SR;
+
+		/* Reading dr after sr clears the idle flag, the DMA has taken the last byte */
+		if (sr & USART_SR_IDLE) {
+			(void) usart_dev->cfg->regs->DR;
+			PIOS_USART_DMA_RxDrain(usart_dev, &need_yield);
+		}
+
+		if ((sr & USART_SR_TC) && (usart_dev->cfg->regs->CR1 & USART_CR1_TCIE))
+			PIOS_USART_DMA_TxNext(usart_dev, &need_yield);
+
+		PIOS_TRACE(PIOS_TRACE_ISR_EXIT, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+		portEND_SWITCHING_ISR(need_yield ? pdTRUE : pdFALSE);
+#endif	/* defined(PIOS_INCLUDE_FREERTOS) */
+		return;
+	}
+
 	/* Force read of dr after sr to make sure to clear error flags */
 	volatile uint16_t sr = usart_dev->cfg->regs->SR;
 	volatile uint8_t dr = usart_dev->cfg->regs->DR;
@@ -379,11 +434,192 @@ static void PIOS_USART_generic_irq_handler(uintptr_t usart_id)
 		}
 	}
 	
+	PIOS_TRACE(PIOS_TRACE_ISR_EXIT, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 	portEND_SWITCHING_ISR((rx_need_yield || tx_need_yield) ? pdTRUE : pdFALSE);
 #endif	/* defined(PIOS_INCLUDE_FREERTOS) */
 }
 
+/**
+ * Sets up the circular RX and the chunked TX transfers of a port
+ */
+static int32_t PIOS_USART_DMA_Init(struct pios_usart_dev * usart_dev)
+{
+	const struct stm32_dma * dma = usart_dev->cfg->dma;
+	USART_TypeDef * regs = usart_dev->cfg->regs;
+
+	usart_dev->dma_rx_buffer = PIOS_malloc(PIOS_USART_DMA_RX_BUFFER_SIZE);
+	usart_dev->dma_tx_buffer = PIOS_malloc(PIOS_USART_DMA_TX_BUFFER_SIZE);
+	if (!usart_dev->dma_rx_buffer || !usart_dev->dma_tx_buffer)
+		return -1;
+
+	DMA_InitTypeDef dma_init = dma->rx.init;
+	dma_init.DMA_PeripheralBaseAddr = (uint32_t) &regs->DR;
+	dma_init.DMA_Memory0BaseAddr = (uint32_t) usart_dev->dma_rx_buffer;
+	dma_init.DMA_BufferSize = PIOS_USART_DMA_RX_BUFFER_SIZE;
+	dma_init.DMA_Mode = DMA_Mode_Circular;
+	DMA_DeInit(dma->rx.channel);
+	DMA_Init(dma->rx.channel, &dma_init);
+
+	dma_init = dma->tx.init;
+	dma_init.DMA_PeripheralBaseAddr = (uint32_t) &regs->DR;
+	dma_init.DMA_Memory0BaseAddr = (uint32_t) usart_dev->dma_tx_buffer;
+	dma_init.DMA_BufferSize = PIOS_USART_DMA_TX_BUFFER_SIZE;
+	dma_init.DMA_Mode = DMA_Mode_Normal;
+	DMA_DeInit(dma->tx.channel);
+	DMA_Init(dma->tx.channel, &dma_init);
+
+	/* Continuous data never lets the line go idle, the buffer is also */
+	/* drained at half and at the end */
+	DMA_ITConfig(dma->rx.channel, DMA_IT_HT | DMA_IT_TC, ENABLE);
+	NVIC_Init((NVIC_InitTypeDef *)&dma->irq.init);
+
+	USART_DMACmd(regs, USART_DMAReq_Rx | USART_DMAReq_Tx, ENABLE);
+	DMA_Cmd(dma->rx.channel, ENABLE);
+
+	USART_ITConfig(regs, USART_IT_IDLE, ENABLE);
+
+	return 0;
+}
+
+/**
+ * Hands everything the DMA wrote since the last call to the COM layer.
+ * Bytes it has no room for are dropped, like in interrupt mode.
+ */
+static void PIOS_USART_DMA_RxDrain(struct pios_usart_dev * usart_dev, bool * need_yield)
+{
+	uint16_t head = PIOS_USART_DMA_RX_BUFFER_SIZE -
+		DMA_GetCurrDataCounter(usart_dev->cfg->dma->rx.channel);
+	if (head >= PIOS_USART_DMA_RX_BUFFER_SIZE)
+		head = 0;
+
+	uint16_t tail = usart_dev->dma_rx_pos;
+	if (head == tail)
+		return;
+
+	usart_dev->dma_rx_pos = head;
+
+	if (!usart_dev->rx_in_cb)
+		return;
+
+	/* Up to the end of the buffer first when the DMA has wrapped around */
+	if (head < tail) {
+		(void) (usart_dev->rx_in_cb)(usart_dev->rx_in_context, &usart_dev->dma_rx_buffer[tail],
+				PIOS_USART_DMA_RX_BUFFER_SIZE - tail, NULL, need_yield);
+		tail = 0;
+	}
+
+	if (head > tail) {
+		(void) (usart_dev->rx_in_cb)(usart_dev->rx_in_context, &usart_dev->dma_rx_buffer[tail],
+				head - tail, NULL, need_yield);
+	}
+}
+
+/**
+ * Clears the flags of a stream, it can't be enabled again while they are set
+ */
+static void PIOS_USART_DMA_ClearFlags(DMA_Stream_TypeDef * stream)
+{
+	static const uint8_t shifts[] = { 0, 6, 16, 22 };
+
+	DMA_TypeDef * dmax = ((uint32_t) stream < (uint32_t) DMA2) ? DMA1 : DMA2;
+	uint32_t index = ((uint32_t) stream - (uint32_t) dmax - 0x10) / 0x18;
+	uint32_t flags = 0x3D << shifts[index & 0x3];
+
+	if (index < 4)
+		dmax->LIFCR = flags;
+	else
+		dmax->HIFCR = flags;
+}
+
+/**
+ * Starts sending the next chunk of the COM layer, or stops when it has none.
+ * Called when the previous chunk has left the shift register.
+ */
+static void PIOS_USART_DMA_TxNext(struct pios_usart_dev * usart_dev, bool * need_yield)
+{
+	USART_TypeDef * regs = usart_dev->cfg->regs;
+	DMA_Stream_TypeDef * stream = usart_dev->cfg->dma->tx.channel;
+
+	USART_ClearFlag(regs, USART_FLAG_TC);
+
+	/* The DMA fell behind the shift register, it is still sending */
+	if (DMA_GetCmdStatus(stream) == ENABLE)
+		return;
+
+	uint16_t bytes_to_send = 0;
+	if (usart_dev->tx_out_cb) {
+		bytes_to_send = (usart_dev->tx_out_cb)(usart_dev->tx_out_context, usart_dev->dma_tx_buffer,
+				PIOS_USART_DMA_TX_BUFFER_SIZE, NULL, need_yield);
+	}
+
+	if (bytes_to_send == 0) {
+		USART_ITConfig(regs, USART_IT_TC, DISABLE);
+		return;
+	}
+
+	PIOS_USART_DMA_ClearFlags(stream);
+	DMA_SetCurrDataCounter(stream, bytes_to_send);
+	DMA_Cmd(stream, ENABLE);
+}
+
+/**
+ * Handles the half and full interrupts of the RX stream of a port, to be
+ * called from the IRQ handler of that stream in the board definitions
+ * \param[in] regs The USART of the port
+ */
+void PIOS_USART_DMA_IRQ_Handler(USART_TypeDef * regs)
+{
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	CH_IRQ_PROLOGUE();
+#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+
+	uintptr_t usart_id = 0;
+	switch ((uint32_t)regs) {
+	case (uint32_t)USART1:
+		usart_id = PIOS_USART_1_id;
+		break;
+	case (uint32_t)USART2:
+		usart_id = PIOS_USART_2_id;
+		break;
+	case (uint32_t)USART3:
+		usart_id = PIOS_USART_3_id;
+		break;
+	case (uint32_t)UART4:
+		usart_id = PIOS_USART_4_id;
+		break;
+	case (uint32_t)UART5:
+		usart_id = PIOS_USART_5_id;
+		break;
+	case (uint32_t)USART6:
+		usart_id = PIOS_USART_6_id;
+		break;
+	}
+
+	struct pios_usart_dev * usart_dev = (struct pios_usart_dev *)usart_id;
+
+	bool valid = PIOS_USART_validate(usart_dev);
+	PIOS_Assert(valid);
+
+	PIOS_TRACE(PIOS_TRACE_ISR_ENTER, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
+
+	DMA_ClearITPendingBit(usart_dev->cfg->dma->rx.channel, usart_dev->cfg->dma->irq.flags);
+
+	bool need_yield = false;
+	PIOS_USART_DMA_RxDrain(usart_dev, &need_yield);
+
+	PIOS_TRACE(PIOS_TRACE_ISR_EXIT, PIOS_TRACE_ISR_ID(PIOS_TRACE_ISR_USART, usart_dev->cfg->regs));
+
+#if defined(PIOS_INCLUDE_FREERTOS)
+	portEND_SWITCHING_ISR(need_yield ? pdTRUE : pdFALSE);
+#endif	/* defined(PIOS_INCLUDE_FREERTOS) */
+
+#if defined(PIOS_INCLUDE_CHIBIOS)
+	CH_IRQ_EPILOGUE();
+#endif /* defined(PIOS_INCLUDE_CHIBIOS) */
+}
+
 #endif
 
 /**
@@ -44,6 +44,9 @@
 #include "pios_usb_board_data.h" /* PIOS_BOARD_*_DATA_LENGTH */
 #include "pios_usbhook.h"	 /* PIOS_USBHOOK_* */
 
+/* Packets the core sends back to back in a single IN transfer */
+#define PIOS_USB_CDC_TX_PACKETS 4
+
 /* Implement COM layer driver API */
 static void PIOS_USB_CDC_RegisterTxCallback(uintptr_t usbcdc_id, pios_com_callback tx_out_cb, uintptr_t context);
 static void PIOS_USB_CDC_RegisterRxCallback(uintptr_t usbcdc_id, pios_com_callback rx_in_cb, uintptr_t context);
@@ -81,12 +84,14 @@ struct pios_usb_cdc_dev {
 	volatile bool rx_active;
 
 	/*
-	 * NOTE: This is -1 as somewhat of a hack.  It ensures that we always send packets
-	 * that are strictly < maxPacketSize for this interface which means we never have
-	 * to bother with zero length packets (ZLP).
+	 * Several packets go out in one transfer. A transfer that ends on a packet
+	 * boundary would need a zero length packet (ZLP) to end it, so its last byte
+	 * is held back in tx_held and goes first in the next transfer instead.
 	 */
-	uint8_t tx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH - 1] __attribute__ ((aligned(4)));
+	uint8_t tx_packet_buffer[PIOS_USB_BOARD_CDC_DATA_LENGTH * PIOS_USB_CDC_TX_PACKETS] __attribute__ ((aligned(4)));
 	volatile bool tx_active;
+	bool tx_held_valid;
+	uint8_t tx_held;
 
 	uint8_t ctrl_tx_packet_buffer[PIOS_USB_BOARD_CDC_MGMT_LENGTH] __attribute__ ((aligned(4)));
 
@@ -196,16 +201,31 @@ static bool PIOS_USB_CDC_SendData(struct pios_usb_cdc_dev * usb_cdc_dev)
 		return false;
 	}
 
+	/* The previous transfer is complete, the buffer can be refilled */
+	uint16_t held = 0;
+	if (usb_cdc_dev->tx_held_valid) {
+		usb_cdc_dev->tx_packet_buffer[0] = usb_cdc_dev->tx_held;
+		usb_cdc_dev->tx_held_valid = false;
+		held = 1;
+	}
+
 	bool need_yield = false;
-	bytes_to_tx = (usb_cdc_dev->tx_out_cb)(usb_cdc_dev->tx_out_context,
-					       usb_cdc_dev->tx_packet_buffer,
-					       sizeof(usb_cdc_dev->tx_packet_buffer),
+	bytes_to_tx = held + (usb_cdc_dev->tx_out_cb)(usb_cdc_dev->tx_out_context,
+					       usb_cdc_dev->tx_packet_buffer + held,
+					       sizeof(usb_cdc_dev->tx_packet_buffer) - held,
 					       NULL,
 					       &need_yield);
 	if (bytes_to_tx == 0) {
 		return false;
 	}
 
+	/* Never end a transfer with a full packet */
+	if ((bytes_to_tx % PIOS_USB_BOARD_CDC_DATA_LENGTH) == 0) {
+		bytes_to_tx--;
+		usb_cdc_dev->tx_held = usb_cdc_dev->tx_packet_buffer[bytes_to_tx];
+		usb_cdc_dev->tx_held_valid = true;
+	}
+
 	/* 
 	 * Mark this endpoint as being tx active _before_ actually transmitting
 	 * to make sure we don't race with the Tx completion interrupt
@@ -522,7 +542,7 @@ static void PIOS_USB_CDC_DATA_IF_Init(uintptr_t usb_cdc_id)
 
 	/* Register endpoint specific callbacks with the USBHOOK layer */
 	PIOS_USBHOOK_RegisterEpInCallback(usb_cdc_dev->cfg->data_tx_ep,
-					  sizeof(usb_cdc_dev->tx_packet_buffer),
+					  PIOS_USB_BOARD_CDC_DATA_LENGTH,
 					  PIOS_USB_CDC_DATA_EP_IN_Callback,
 					  (uintptr_t) usb_cdc_dev);
 	PIOS_USBHOOK_RegisterEpOutCallback(usb_cdc_dev->cfg->data_rx_ep,
@@ -545,6 +565,7 @@ static void PIOS_USB_CDC_DATA_IF_DeInit(uintptr_t usb_cdc_id)
 	usb_cdc_dev->rx_dropped = 0;
 	usb_cdc_dev->rx_oversize = 0;
 	usb_cdc_dev->tx_active = false;
+	usb_cdc_dev->tx_held_valid = false;
 	usb_cdc_dev->usb_data_if_enabled = false;
 
 	/* DeRegister endpoint specific callbacks with the USBHOOK layer */
@@ -45,6 +45,8 @@ struct pios_adc_driver {
 #endif
 	uint8_t (*number_of_channels)(uint32_t id);
 	float (*lsb_voltage)(uint32_t id);
+	//! Optional, the pin in LSB with the fraction gained by filtering
+	float (*get_pin_precise)(uint32_t id, uint32_t pin);
 };
 
 /* Public Functions */
@@ -55,6 +57,7 @@ extern void PIOS_ADC_SetQueue(uintptr_t adc_id, struct pios_queue *data_queue);
 #endif
 extern int32_t PIOS_ADC_GetChannelRaw(uint32_t channel);
 extern float PIOS_ADC_GetChannelVolt(uint32_t channel);
+extern float PIOS_ADC_GetChannelPrecise(uint32_t channel);
 #endif /* PIOS_ADC_H */
 
 /**
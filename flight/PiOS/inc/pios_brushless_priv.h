@@ -33,6 +33,15 @@
 #include <pios.h>
 #include <pios_tim_priv.h>
 
+//! DMA channel requested by the update event of the timer of a motor
+struct pios_brushless_dma {
+	uint32_t ahb_clk;
+	DMA_Channel_TypeDef *channel;
+	struct stm32_irq irq;
+	uint32_t half_flag;
+	uint32_t full_flag;
+};
+
 struct pios_brushless_cfg {
 	TIM_TimeBaseInitTypeDef tim_base_init;
 	TIM_OCInitTypeDef tim_oc_init;
@@ -41,6 +50,8 @@ struct pios_brushless_cfg {
 	const struct stm32_gpio enables[3];
 	const struct pios_tim_channel * channels;
 	uint8_t num_channels;
+	const struct pios_brushless_dma * dma;	/* one per motor, NULL to update the outputs from a thread */
+	uint8_t num_dma;
 };
 
 extern int32_t PIOS_Brushless_Init(const struct pios_brushless_cfg * cfg);
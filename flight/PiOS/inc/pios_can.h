@@ -50,12 +50,17 @@ enum pios_can_messages {
 	PIOS_CAN_POS = 12,
 	PIOS_CAN_VERT = 13, // carries smoothed altitude and climbrate
 	PIOS_CAN_ALARM = 14,
+	PIOS_CAN_GPS_DOWN_HEADING = 15,
+	PIOS_CAN_SENSOR_MAG = 16,
+	PIOS_CAN_SENSOR_BARO = 17,
+	PIOS_CAN_SENSOR_AIRSPEED = 18,
+	PIOS_CAN_ESC_TELEMETRY = 19,
 	PIOS_CAN_LAST
 };
 // Note: new messages must be defined in both
 //    pios_can_message_stdid
 //    get_message_size
-// in pios_can.c
+// in pios_can_common.c
 
 //! Message to tell gimbal the desired setpoint and FC state
 struct pios_can_gimbal_message {
@@ -142,12 +147,58 @@ struct pios_can_alarm_message {
 	uint8_t alarms[8];
 }  __attribute__((packed));
 
+//! Completes the GPS velocity and position of the other GPS messages
+struct pios_can_gps_down_heading {
+	float down;
+	float heading;
+}  __attribute__((packed));
+
+//! Magnetometer sample in mGa
+struct pios_can_sensor_mag {
+	int16_t x;
+	int16_t y;
+	int16_t z;
+	uint16_t reserved;
+}  __attribute__((packed));
+
+//! Barometer sample
+struct pios_can_sensor_baro {
+	float pressure;		// kPa
+	int16_t temperature;	// 0.01 deg C
+	uint16_t reserved;
+}  __attribute__((packed));
+
+//! Airspeed sample
+struct pios_can_sensor_airspeed {
+	float true_airspeed;
+	float calibrated_airspeed;
+}  __attribute__((packed));
+
+//! ESC telemetry, all ESCs share the message and tell themselves apart by index
+struct pios_can_esc_telemetry {
+	uint8_t index;
+	uint8_t temperature;	// deg C
+	uint16_t rpm;		// 10 rpm
+	uint16_t voltage;	// 10 mV
+	uint16_t current;	// 10 mA
+}  __attribute__((packed));
+
+//! A message routed to a queue shared by several message IDs
+struct pios_can_frame {
+	uint8_t msg_id;		// enum pios_can_messages
+	uint8_t len;
+	uint8_t data[8];
+};
+
 //! Transmit a data message with a particular message ID
 int32_t PIOS_CAN_TxData(uintptr_t id, enum pios_can_messages, uint8_t *data);
 
 //! Get a queue to receive messages of a particular message ID
 struct pios_queue * PIOS_CAN_RegisterMessageQueue(uintptr_t id, enum pios_can_messages msg_id);
 
+//! Route messages of a particular message ID to a queue of struct pios_can_frame
+int32_t PIOS_CAN_RouteMessage(uintptr_t id, enum pios_can_messages msg_id, struct pios_queue *frames);
+
 #endif /* PIOS_CAN_H */
 
 /**
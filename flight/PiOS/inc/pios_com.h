@@ -52,6 +52,10 @@ extern int32_t PIOS_COM_SendCharNonBlocking(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendChar(uintptr_t com_id, char c);
 extern int32_t PIOS_COM_SendBufferNonBlocking(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
 extern int32_t PIOS_COM_SendBuffer(uintptr_t com_id, const uint8_t *buffer, uint16_t len);
+extern uint8_t * PIOS_COM_ReserveTx(uintptr_t com_id, uint16_t len);
+extern int32_t PIOS_COM_CommitTx(uintptr_t com_id, uint16_t len);
+extern int32_t PIOS_COM_SetTxBatch(uintptr_t com_id, uint16_t bytes);
+extern int32_t PIOS_COM_FlushTx(uintptr_t com_id);
 extern int32_t PIOS_COM_SendStringNonBlocking(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendString(uintptr_t com_id, const char *str);
 extern int32_t PIOS_COM_SendFormattedStringNonBlocking(uintptr_t com_id, const char *format, ...);
@@ -29,9 +29,31 @@
 
 #include <stdint.h>
 
+/* One object instance of a batch operation */
+struct pios_flashfs_obj {
+	uint32_t obj_id;
+	uint16_t obj_inst_id;
+	uint16_t obj_size;
+	uint8_t *obj_data;
+	const uint8_t *obj_mapped;	/* the object in flash when it can be read in place, else NULL */
+};
+
+/* Fills in the next object to save, returns 1 if there is one, 0 at the end of the batch or < 0 to abort it */
+typedef int32_t (*pios_flashfs_batch_next)(void *ctx, struct pios_flashfs_obj *obj);
+/*
+ * Sets obj_data to where an object found in the filesystem is loaded to, or leaves it NULL to skip it.
+ * Setting it to obj_mapped hands the object to load_done in place, valid only until it returns.
+ */
+typedef void (*pios_flashfs_load_buffer)(void *ctx, struct pios_flashfs_obj *obj);
+/* Called once an object has been loaded */
+typedef void (*pios_flashfs_load_done)(void *ctx, const struct pios_flashfs_obj *obj);
+
 int32_t PIOS_FLASHFS_Format(uintptr_t fs_id);
 int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size);
 int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size);
 int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id);
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, pios_flashfs_batch_next next, void *ctx);
+int32_t PIOS_FLASHFS_ObjLoadAll(uintptr_t fs_id, pios_flashfs_load_buffer buffer, pios_flashfs_load_done loaded, void *ctx);
+int32_t PIOS_FLASHFS_Maintenance(uintptr_t fs_id);
 
 #endif	/* PIOS_FLASHFS_H_ */
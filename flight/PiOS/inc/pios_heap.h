@@ -29,6 +29,41 @@
 
 #include <stdlib.h>		/* size_t */
 #include <stdbool.h>		/* bool */
+#include <stdint.h>		/* uint32_t */
+
+/*
+ * Placement policy for the CCM RAM of the F4:
+ *  - PIOS_malloc() and plain statics stay in SRAM, every buffer that is
+ *    handed to a DMA controller must come from there.
+ *  - PIOS_malloc_no_dma() and statics marked PIOS_FAST_DATA go to CCM when
+ *    the target has it.  This is for data the CPU works on in its hot loops
+ *    (UAVObject storage, filter matrices, the stabilization, attitude and
+ *    sensors stacks), it is never contended by DMA traffic on the bus matrix.
+ * The .fast section is NOLOAD, so PIOS_FAST_DATA variables are not cleared
+ * at startup and have to be initialized explicitly before use.
+ */
+#if defined(STM32F4XX)
+#define PIOS_FAST_DATA __attribute__((section(".fast")))
+#else
+#define PIOS_FAST_DATA
+#endif
+
+enum pios_heap_region {
+	PIOS_HEAP_REGION_STANDARD,
+	PIOS_HEAP_REGION_FAST,
+};
+
+struct pios_heap_stats {
+	uint32_t size;
+	uint32_t used;
+	uint32_t allocations;
+	uint32_t pad_bytes;
+	uint32_t failed_allocations;
+	uint32_t largest_failed;
+};
+
+/* Number of owner tags allocations can be charged to, tag 0 is untagged */
+#define PIOS_HEAP_MAX_OWNERS 32
 
 extern bool PIOS_heap_malloc_failed_p(void);
 
@@ -42,4 +77,8 @@ extern size_t PIOS_fastheap_get_free_size(void);
 extern void PIOS_heap_initialize_blocks(void);
 extern void PIOS_heap_increase_size(size_t bytes);
 
+extern bool PIOS_heap_get_stats(enum pios_heap_region region, struct pios_heap_stats *stats);
+extern void PIOS_heap_set_owner(uint8_t owner);
+extern size_t PIOS_heap_get_owner_usage(uint8_t owner);
+
 #endif	/* PIOS_HEAP_H */
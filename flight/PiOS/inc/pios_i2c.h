@@ -46,12 +46,20 @@ struct pios_i2c_txn {
 	uint8_t *buf;
 };
 
+/**
+ * Called when a queued transfer is done, with the result PIOS_I2C_Transfer
+ * would have returned. Runs in the I2C interrupt, or with the interrupts
+ * disabled in the task that found the bus stuck.
+ */
+typedef void (*pios_i2c_callback)(int32_t result, void *context, bool *woken);
+
 /* Public Functions */
 extern int32_t PIOS_I2C_CheckClear(uint32_t i2c_id);
 extern int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns);
-extern int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, void *callback);
+extern int32_t PIOS_I2C_Transfer_Callback(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns, pios_i2c_callback callback, void *context);
 extern void PIOS_I2C_EV_IRQ_Handler(uint32_t i2c_id);
 extern void PIOS_I2C_ER_IRQ_Handler(uint32_t i2c_id);
+extern void PIOS_I2C_DMA_IRQ_Handler(uint32_t i2c_id);
 
 #endif /* PIOS_I2C_H */
 
@@ -44,9 +44,23 @@
  */
 
 typedef int32_t (*initcall_t)(void);
+
+/*
+ * When a module is brought up during boot.  Critical modules are initialized
+ * and started ahead of all others.  Deferred modules aren't needed before
+ * arming, they are initialized and started by the system task once the other
+ * modules run.  Nothing may look for their objects while initializing.
+ */
+enum module_init_class {
+	MODULE_INIT_NORMAL,
+	MODULE_INIT_CRITICAL,
+	MODULE_INIT_DEFERRED,
+};
+
 typedef struct {
 	initcall_t fn_minit;
 	initcall_t fn_tinit;
+	enum module_init_class init_class;
 } initmodule_t;
 
 /* Init module section */
@@ -64,23 +78,60 @@ extern initmodule_t __module_initcall_start[], __module_initcall_end[];
 	static initcall_t __initcall_##fn##id __attribute__((__used__)) \
 	__attribute__((__section__(".initcall" level ".init"))) = fn
 
-#define __define_module_initcall(level, ifn, sfn) \
+#define __define_module_initcall(level, ifn, sfn, cls) \
 	static initmodule_t __initcall_##fn __attribute__((__used__)) \
-	__attribute__((__section__(".initcall" level ".init"))) = { .fn_minit = ifn, .fn_tinit = sfn };
+	__attribute__((__section__(".initcall" level ".init"))) = { .fn_minit = ifn, .fn_tinit = sfn, .init_class = cls };
 
-#define MODULE_INITCALL(ifn, sfn)		__define_module_initcall("module", ifn, sfn)
+#define MODULE_INITCALL(ifn, sfn)		__define_module_initcall("module", ifn, sfn, MODULE_INIT_NORMAL)
+#define MODULE_CRITICAL_INITCALL(ifn, sfn)	__define_module_initcall("module", ifn, sfn, MODULE_INIT_CRITICAL)
+#define MODULE_DEFERRED_INITCALL(ifn, sfn)	__define_module_initcall("module", ifn, sfn, MODULE_INIT_DEFERRED)
 
-#define MODULE_INITIALISE_ALL(wdgfn)  { \
+/*
+ * With HEAP_DIAGNOSTICS the heap charges what a module allocates while it is
+ * initialized and started to that module, tagged by its position in the
+ * initcall table plus one.
+ */
+#if defined(HEAP_DIAGNOSTICS)
+#define MODULE_HEAP_OWNER(fn)	PIOS_heap_set_owner((fn) - __module_initcall_start + 1)
+#define MODULE_HEAP_NO_OWNER()	PIOS_heap_set_owner(0)
+#else
+#define MODULE_HEAP_OWNER(fn)
+#define MODULE_HEAP_NO_OWNER()
+#endif
+
+#define MODULE_INITIALISE_CLASS(cls, wdgfn)  { \
 		for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) { \
+			if (fn->init_class != (cls))			\
+				continue;				\
+			MODULE_HEAP_OWNER(fn);				\
 			if (fn->fn_minit)				\
 				(fn->fn_minit)();			\
+			MODULE_HEAP_NO_OWNER();				\
 			(wdgfn)();					\
 		}							\
 	}
 
-#define MODULE_TASKCREATE_ALL  { for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) \
-									if (fn->fn_tinit) \
-									   (fn->fn_tinit)(); }
+#define MODULE_TASKCREATE_CLASS(cls)  { for (initmodule_t *fn = __module_initcall_start; fn < __module_initcall_end; fn++) \
+									if (fn->init_class == (cls) && fn->fn_tinit) { \
+									   MODULE_HEAP_OWNER(fn); \
+									   (fn->fn_tinit)(); \
+									   MODULE_HEAP_NO_OWNER(); } }
+
+#define MODULE_INITIALISE_ALL(wdgfn)  { \
+		MODULE_INITIALISE_CLASS(MODULE_INIT_CRITICAL, wdgfn); \
+		MODULE_INITIALISE_CLASS(MODULE_INIT_NORMAL, wdgfn); \
+	}
+
+#define MODULE_TASKCREATE_ALL  { \
+		MODULE_TASKCREATE_CLASS(MODULE_INIT_CRITICAL); \
+		MODULE_TASKCREATE_CLASS(MODULE_INIT_NORMAL); \
+	}
+
+/* Initialize and start the deferred modules, run by the system task */
+#define MODULE_DEFERRED_ALL(wdgfn)  { \
+		MODULE_INITIALISE_CLASS(MODULE_INIT_DEFERRED, wdgfn); \
+		MODULE_TASKCREATE_CLASS(MODULE_INIT_DEFERRED); \
+	}
 
 #endif	/* PIOS_INITCALL_H */
 
@@ -0,0 +1,73 @@
+/**
+ ******************************************************************************
+ * @file       pios_mempool.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Mempool Fixed size block pool
+ * @{
+ * @brief Pool of equally sized memory blocks with constant time alloc and free
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_MEMPOOL_H_
+#define PIOS_MEMPOOL_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * The heap never frees anything, so memory that is allocated and released
+ * over and over at runtime has to come from a pool instead.  Free blocks are
+ * kept in a singly linked list threaded through the blocks themselves, so
+ * allocating and freeing are constant time and the pool needs no memory
+ * besides the blocks.  A block that was freed is only ever handed out again
+ * by the same pool, it never goes back to the heap.
+ *
+ * A pool is either created with all its blocks up front, or initialized empty
+ * and filled with blocks of the right size as they are freed, in which case
+ * it recycles memory that was allocated elsewhere.
+ */
+
+struct pios_mempool {
+	void *free_list;
+	uint16_t block_size;
+	volatile uint16_t num_free;
+	uint16_t min_free;		/* low-water mark of num_free since creation */
+};
+
+struct pios_mempool *PIOS_Mempool_Create(size_t block_size, uint16_t num_blocks);
+void PIOS_Mempool_Init(struct pios_mempool *mp, size_t block_size);
+void PIOS_Mempool_Load(struct pios_mempool *mp, void *storage, uint16_t num_blocks);
+
+void *PIOS_Mempool_Alloc(struct pios_mempool *mp);
+void PIOS_Mempool_Free(struct pios_mempool *mp, void *block);
+
+uint16_t PIOS_Mempool_GetFree(const struct pios_mempool *mp);
+uint16_t PIOS_Mempool_GetMinFree(const struct pios_mempool *mp);
+
+/* Block size the pool actually uses, callers loading storage need it */
+#define PIOS_MEMPOOL_BLOCK_SIZE(size) \
+	((((size) < sizeof(void *) ? sizeof(void *) : (size)) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+#endif /* PIOS_MEMPOOL_H_ */
+
+/**
+  * @}
+  * @}
+  */
@@ -83,6 +83,9 @@
 #define PIOS_MPU60X0_FIFO_GYRO_Z_OUT      0x10
 #define PIOS_MPU60X0_ACCEL_OUT            0x08
 
+/* Bytes per FIFO frame with accel, temperature and gyro enabled */
+#define PIOS_MPU60X0_FIFO_FRAME_SIZE      14
+
 /* Interrupt Configuration */
 #define PIOS_MPU60X0_INT_ACTL             0x80
 #define PIOS_MPU60X0_INT_OPEN             0x40
@@ -183,6 +186,7 @@ struct pios_mpu60x0_cfg {
 	enum pios_mpu60x0_filter default_filter;
 	enum pios_mpu60x0_orientation orientation;
 	uint8_t use_internal_mag;		/* Flag to indicate whether or not to use the internal mag on MPU9x50 devices */
+	uint8_t fifo_burst_samples;		/* Samples drained from the FIFO per wakeup, 0 or 1 reads the data registers directly */
 };
 
 #endif /* PIOS_MPU60X0_H */
@@ -76,6 +76,7 @@ struct pios_mpu9250_cfg {
 	enum pios_mpu9250_gyro_filter default_gyro_filter;
 	enum pios_mpu9250_accel_filter default_accel_filter;
 	enum pios_mpu9250_orientation orientation;
+	uint8_t fifo_burst_samples;		/* Samples drained from the FIFO per wakeup, 0 or 1 reads the data registers directly */
 };
 
 /* Public Functions */
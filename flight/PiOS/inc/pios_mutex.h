@@ -33,16 +33,34 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+/*
+ * Contention statistics of a mutex, only counted when built with
+ * MUTEX_DIAGNOSTICS. An acquisition is contended when another thread held
+ * the mutex, the wait is measured from then until the mutex is acquired.
+ */
+struct pios_mutex_stats
+{
+	uint32_t acquisitions;
+	uint32_t contended;
+	uint32_t max_wait_us;
+};
+
 #if defined(PIOS_INCLUDE_FREERTOS)
 
 struct pios_mutex
 {
 	uintptr_t mtx_handle;
+#if defined(MUTEX_DIAGNOSTICS)
+	struct pios_mutex_stats stats;
+#endif
 };
 
 struct pios_recursive_mutex
 {
 	uintptr_t mtx_handle;
+#if defined(MUTEX_DIAGNOSTICS)
+	struct pios_mutex_stats stats;
+#endif
 };
 
 #elif defined(PIOS_INCLUDE_CHIBIOS)
@@ -50,12 +68,18 @@ struct pios_recursive_mutex
 struct pios_mutex
 {
 	Mutex mtx;
+#if defined(MUTEX_DIAGNOSTICS)
+	struct pios_mutex_stats stats;
+#endif
 };
 
 struct pios_recursive_mutex
 {
 	Mutex mtx;
 	uint32_t count;
+#if defined(MUTEX_DIAGNOSTICS)
+	struct pios_mutex_stats stats;
+#endif
 };
 
 #endif /* defined(PIOS_INCLUDE_CHIBIOS) */
@@ -69,6 +93,9 @@ struct pios_recursive_mutex
  * - semaphore
  * - recursive mutex
  *
+ * A thread holding the mutex inherits the priority of the threads waiting
+ * for it, with both FreeRTOS and ChibiOS.
+ *
  * see FreeRTOS documentation for details: http://www.freertos.org/a00113.html
  * see ChibiOS documentation for details: http://chibios.sourceforge.net/html/group__synchronization.html
  */
@@ -76,6 +103,7 @@ struct pios_recursive_mutex
 struct pios_mutex *PIOS_Mutex_Create(void);
 bool PIOS_Mutex_Lock(struct pios_mutex *mtx, uint32_t timeout_ms);
 bool PIOS_Mutex_Unlock(struct pios_mutex *mtx);
+bool PIOS_Mutex_GetStats(struct pios_mutex *mtx, struct pios_mutex_stats *stats);
 
 /*
  * The following functions implement the concept of a recursive mutex usable
@@ -86,7 +114,8 @@ bool PIOS_Mutex_Unlock(struct pios_mutex *mtx);
  * - semaphore
  * - non-recursive mutex
  *
- * Note that this implementation doesn't prevent priority inversion.
+ * A thread holding the mutex inherits the priority of the threads waiting
+ * for it, with both FreeRTOS and ChibiOS.
  *
  * see FreeRTOS documentation for details: http://www.freertos.org/a00113.html
  * see ChibiOS documentation for details: http://chibios.sourceforge.net/html/group__synchronization.html
@@ -95,6 +124,7 @@ bool PIOS_Mutex_Unlock(struct pios_mutex *mtx);
 struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void);
 bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeout_ms);
 bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx);
+bool PIOS_Recursive_Mutex_GetStats(struct pios_recursive_mutex *mtx, struct pios_mutex_stats *stats);
 
 #endif /* PIOS_MUTEX_H_ */
 
@@ -35,6 +35,7 @@ extern int32_t PIOS_OVERO_GetPacketCount(uintptr_t overo_id);
 extern int32_t PIOS_OVERO_GetWrittenBytes(uintptr_t overo_id);
 extern int32_t PIOS_OVERO_Enable(uintptr_t overo_id);
 extern int32_t PIOS_OVERO_Disable(uintptr_t overo_id);
+extern int32_t PIOS_OVERO_SetFrame(uintptr_t overo_id, const uint8_t *frame, uint32_t len);
 
 #endif /* PIOS_OVERO_H */
 
@@ -8,6 +8,7 @@
  *
  * @file       pios_ppm_priv.h
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2010.
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
  * @brief      ppm private structures.
  * @see        The GNU Public License (GPL) Version 3
  *
@@ -34,10 +35,27 @@
 #include <pios.h>
 #include <pios_stm32.h>
 
+#if defined(STM32F4XX)
+/**
+ * The DMA stream the capture request of the PPM timer channel is wired to,
+ * see the DMA request mapping of the reference manual. It must not be used
+ * by any other driver of the board.
+ */
+struct pios_ppm_dma_cfg {
+	uint32_t ahb_clk;
+	DMA_Stream_TypeDef *stream;
+	uint32_t channel;
+};
+#endif
+
 struct pios_ppm_cfg {
 	TIM_ICInitTypeDef tim_ic_init;
 	const struct pios_tim_channel * channels;
 	uint8_t num_channels;
+#if defined(STM32F4XX)
+	//! Optional, the edges are captured by DMA instead of an interrupt each
+	const struct pios_ppm_dma_cfg * dma;
+#endif
 };
 
 extern const struct pios_rcvr_driver pios_ppm_rcvr_driver;
@@ -38,12 +38,22 @@
 struct pios_queue
 {
 	uintptr_t queue_handle;
+	size_t item_size;
 };
 
 #elif defined(PIOS_INCLUDE_CHIBIOS)
 
 #include "ch.h"
 
+/*
+ * Senders blocked on a full queue each hold an item of its memory pool, so
+ * every queue has this many items beyond its length. Boards with more
+ * tasks sending to one queue raise it in pios_config.h.
+ */
+#if !defined(PIOS_QUEUE_MAX_WAITERS)
+#define PIOS_QUEUE_MAX_WAITERS 2
+#endif /* !defined(PIOS_QUEUE_MAX_WAITERS) */
+
 struct pios_queue
 {
 	Mailbox mb;
@@ -68,6 +78,8 @@ void PIOS_Queue_Delete(struct pios_queue *queuep);
 bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms);
 bool PIOS_Queue_Send_FromISR(struct pios_queue *queuep, const void *itemp, bool *wokenp);
 bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout_ms);
+uint16_t PIOS_Queue_SendMany(struct pios_queue *queuep, const void *itemsp, uint16_t num_items, uint32_t timeout_ms);
+uint16_t PIOS_Queue_ReceiveMany(struct pios_queue *queuep, void *itemsp, uint16_t max_items, uint32_t timeout_ms);
 
 #endif /* PIOS_QUEUE_H_ */
 
@@ -31,13 +31,18 @@
 #ifndef PIOS_RCVR_H
 #define PIOS_RCVR_H
 
+struct pios_semaphore;
+
 struct pios_rcvr_driver {
 	void    (*init)(uintptr_t id);
 	int32_t (*read)(uintptr_t id, uint8_t channel);
+	//! Optional, given each time a whole frame was decoded
+	struct pios_semaphore * (*get_semaphore)(uintptr_t id, uint8_t channel);
 };
 
 /* Public Functions */
 extern int32_t PIOS_RCVR_Read(uintptr_t rcvr_id, uint8_t channel);
+extern struct pios_semaphore * PIOS_RCVR_GetSemaphore(uintptr_t rcvr_id, uint8_t channel);
 
 /*! Define error codes for PIOS_RCVR_Get */
 enum PIOS_RCVR_errors {
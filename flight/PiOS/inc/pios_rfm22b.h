@@ -78,9 +78,12 @@ struct rfm22b_stats {
 	uint8_t resets;
 	uint8_t timeouts;
 	uint8_t link_quality;
+	uint8_t remote_link_quality;
 	int8_t rssi;
 	int8_t afc_correction;
 	uint8_t link_state;
+	uint16_t datarate_changes;
+	uint32_t datarate;
 };
 
 /* Public Functions */
@@ -96,7 +99,8 @@ extern void PIOS_RFM22B_Config(uint32_t rfm22b_id,
 					 uint8_t min_chan,
 					 uint8_t max_chan,
 					 uint32_t coordinator_id, bool oneway,
-					 bool ppm_mode, bool ppm_only);
+					 bool ppm_mode, bool ppm_only,
+					 bool adaptive);
 extern uint32_t PIOS_RFM22B_DeviceID(uint32_t rfb22b_id);
 extern uint32_t PIOS_RFM22B_ModuleVersion(uint32_t rfb22b_id);
 extern void PIOS_RFM22B_GetStats(uint32_t rfm22b_id,
@@ -36,6 +36,7 @@
 #include <fifo_buffer.h>
 #include <uavobjectmanager.h>
 #include <rfm22bstatus.h>
+#include <ecc.h>
 #include "pios_rfm22b.h"
 #include "pios_rfm22b_regs.h"
 #include "pios_semaphore.h"
@@ -208,6 +209,26 @@ struct pios_rfm22b_dev {
 	// The RF datarate lookup index.
 	uint8_t datarate;
 
+	// Is the datarate adapted to the link between these bounds?
+	bool adaptive;
+	uint8_t min_datarate;
+	uint8_t max_datarate;
+	// A datarate change both modems make at the same hop cycle boundary
+	bool datarate_switch_pending;
+	uint8_t next_datarate;
+	uint32_t datarate_switch_ticks;
+	// When the link is looked at next, and when it may go faster again
+	uint32_t datarate_check_ticks;
+	uint32_t datarate_hold_ticks;
+	// Consecutive good looks at the link
+	uint8_t datarate_good_checks;
+	// Packets received since the link was last scored
+	uint16_t link_rx_good;
+	uint16_t link_rx_total;
+	// Share of good packets received here and at the other modem
+	uint8_t link_score;
+	uint8_t remote_link_score;
+
 	// The radio state machine state
 	enum pios_radio_state state;
 
@@ -271,6 +292,9 @@ struct pios_rfm22b_dev {
 	// Are we sending / receiving only PPM data?
 	bool ppm_only_mode;
 
+	// The Reed Solomon decoder state of this radio
+	struct rs_decoder rs_dec;
+
 	// The channel list
 	uint8_t channels[RFM22B_NUM_CHANNELS];
 	// The number of frequency hopping channels.
@@ -288,6 +312,8 @@ struct pios_rfm22b_dev {
 	uint32_t packet_start_ticks;
 	uint32_t tx_complete_ticks;
 	uint32_t time_delta;
+	// Coordinator time the frequency hopping sequence restarted at
+	uint32_t hop_epoch;
 
 	// Track when a packet is received in this slice
 	bool packet_received_slice;
@@ -0,0 +1,81 @@
+/**
+ ******************************************************************************
+ * @file       pios_ringbuf.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Ringbuf Single producer / single consumer ring buffer
+ * @{
+ * @brief Lock-free ring buffer of fixed size items accessed in place
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_RINGBUF_H_
+#define PIOS_RINGBUF_H_
+
+#define PIOS_RINGBUF_TIMEOUT_MAX 0xffffffff
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * The ring buffer is safe for exactly one producer (a driver task or ISR)
+ * and one consumer (usually the Sensors task) without any locking. The
+ * producer claims the next free slot, fills it in place and commits it.
+ * The consumer peeks at the oldest slot, uses it in place and releases it.
+ * No item is ever copied by the ring buffer itself.
+ *
+ * The head index is only written by the producer and the tail index only
+ * by the consumer, so a memory barrier between filling a slot and
+ * publishing the index is all that is needed.
+ */
+
+struct pios_semaphore;
+
+struct pios_ringbuf {
+	uint8_t *items;
+	uint16_t item_size;
+	uint16_t num_slots;		/* one slot is always kept empty */
+	volatile uint16_t head;		/* next slot to write, producer owned */
+	volatile uint16_t tail;		/* next slot to read, consumer owned */
+	volatile uint32_t overruns;	/* items dropped because the ring was full */
+	struct pios_semaphore *data_ready;
+};
+
+struct pios_ringbuf *PIOS_Ringbuf_Create(uint16_t length, uint16_t item_size);
+void PIOS_Ringbuf_Delete(struct pios_ringbuf *rb);
+
+/* Producer side */
+void *PIOS_Ringbuf_WriteClaim(struct pios_ringbuf *rb);
+void PIOS_Ringbuf_WriteCommit(struct pios_ringbuf *rb);
+void PIOS_Ringbuf_WriteCommit_FromISR(struct pios_ringbuf *rb, bool *woken);
+
+/* Consumer side */
+const void *PIOS_Ringbuf_ReadPeek(struct pios_ringbuf *rb);
+void PIOS_Ringbuf_ReadRelease(struct pios_ringbuf *rb);
+bool PIOS_Ringbuf_Wait(struct pios_ringbuf *rb, uint32_t timeout_ms);
+
+uint16_t PIOS_Ringbuf_GetUsed(const struct pios_ringbuf *rb);
+uint32_t PIOS_Ringbuf_GetOverruns(const struct pios_ringbuf *rb);
+
+#endif /* PIOS_RINGBUF_H_ */
+
+/**
+  * @}
+  * @}
+  */
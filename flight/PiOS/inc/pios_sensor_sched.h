@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @file       pios_sensor_sched.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Sensor_Sched Shared sensor driver thread
+ * @{
+ * @brief Runs the state machines of all the sensor drivers on one thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_SENSOR_SCHED_H_
+#define PIOS_SENSOR_SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Instead of a thread of its own, a driver registers a step function. The
+ * step does the work of one state of the driver, never sleeps and returns
+ * how many ms later it wants to be called again, or
+ * PIOS_SENSOR_SCHED_WAIT_EVENT to wait for its data ready interrupt. The
+ * interrupt handler calls PIOS_SENSOR_SCHED_Signal_FromISR to have the
+ * step run as soon as possible.
+ *
+ * All the steps share one stack, so it has to fit the deepest of them.
+ */
+
+#if !defined(PIOS_SENSOR_SCHED_MAX_DRIVERS)
+#define PIOS_SENSOR_SCHED_MAX_DRIVERS 6
+#endif
+
+#if !defined(PIOS_SENSOR_SCHED_STACK_BYTES)
+#define PIOS_SENSOR_SCHED_STACK_BYTES 600
+#endif
+
+#define PIOS_SENSOR_SCHED_WAIT_EVENT 0xffffffff
+
+typedef uint32_t (*pios_sensor_sched_step_t)(void *ctx);
+
+int32_t PIOS_SENSOR_SCHED_Register(pios_sensor_sched_step_t step, void *ctx, uint32_t first_delay_ms);
+bool PIOS_SENSOR_SCHED_Signal_FromISR(int32_t driver_id);
+
+#endif /* PIOS_SENSOR_SCHED_H_ */
+
+/**
+  * @}
+  * @}
+  */
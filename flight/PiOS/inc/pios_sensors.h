@@ -34,6 +34,7 @@
 #include "pios.h"
 #include "stdint.h"
 #include "pios_queue.h"
+#include "pios_ringbuf.h"
 
 //! Pios sensor structure for generic gyro data
 struct pios_sensor_gyro_data {
@@ -41,6 +42,7 @@ struct pios_sensor_gyro_data {
 	float y; 
 	float z;
 	float temperature;
+	uint32_t sample_time;	//!< PIOS_DELAY_GetRaw() time the sample was taken, from the data ready interrupt
 };
 
 //! Pios sensor structure for generic accel data
@@ -49,6 +51,7 @@ struct pios_sensor_accel_data {
 	float y; 
 	float z;
 	float temperature;
+	uint32_t sample_time;	//!< PIOS_DELAY_GetRaw() time the sample was taken, from the data ready interrupt
 };
 
 //! Pios sensor structure for generic mag data
@@ -65,6 +68,7 @@ struct pios_sensor_optical_flow_data {
 	float z_dot;
 
 	uint8_t quality;
+	uint32_t sample_time;	//!< PIOS_DELAY_GetRaw() time the sample was read from the sensor
 };
 
 //! Pios sensor structure for generic rangefinder data
@@ -98,12 +102,36 @@ int32_t PIOS_SENSORS_Init();
 //! Register a sensor with the PIOS_SENSORS interface
 int32_t PIOS_SENSORS_Register(enum pios_sensor_type type, struct pios_queue *queue);
 
+//! Register a sensor that delivers samples through a ring buffer
+int32_t PIOS_SENSORS_RegisterRingbuf(enum pios_sensor_type type, struct pios_ringbuf *ringbuf);
+
 //! Checks if a sensor type is registered with the PIOS_SENSORS interface
 bool PIOS_SENSORS_IsRegistered(enum pios_sensor_type type);
 
 //! Get the data queue for a sensor type
 struct pios_queue *PIOS_SENSORS_GetQueue(enum pios_sensor_type type);
 
+//! Get the ring buffer for a sensor type
+struct pios_ringbuf *PIOS_SENSORS_GetRingbuf(enum pios_sensor_type type);
+
+//! Get the next sample for a sensor type, in place when possible
+const void *PIOS_SENSORS_GetSample(enum pios_sensor_type type, void *copy, uint32_t timeout_ms);
+
+//! Release a sample obtained with PIOS_SENSORS_GetSample
+void PIOS_SENSORS_ReleaseSample(enum pios_sensor_type type);
+
+//! Record the PIOS_DELAY_GetRaw() time of the interrupt behind the latest sample
+void PIOS_SENSORS_SetSampleTime(enum pios_sensor_type type, uint32_t raw_time);
+
+//! Get the time recorded with PIOS_SENSORS_SetSampleTime, zero if never set
+uint32_t PIOS_SENSORS_GetSampleTime(enum pios_sensor_type type);
+
+//! Record the PIOS_DELAY_GetRaw() time the samples behind the latest update were taken
+void PIOS_SENSORS_SetUpdateTime(enum pios_sensor_type type, uint32_t raw_time);
+
+//! Get the time recorded with PIOS_SENSORS_SetUpdateTime, zero if never set
+uint32_t PIOS_SENSORS_GetUpdateTime(enum pios_sensor_type type);
+
 //! Set the maximum gyro rate in deg/s
 void PIOS_SENSORS_SetMaxGyro(int32_t rate);
 
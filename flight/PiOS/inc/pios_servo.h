@@ -31,7 +31,10 @@
 #ifndef PIOS_SERVO_H
 #define PIOS_SERVO_H
 
-enum pwm_mode {PWM_MODE_1MHZ, PWM_MODE_12MHZ};
+enum pwm_mode {PWM_MODE_1MHZ, PWM_MODE_12MHZ, PWM_MODE_DSHOT150, PWM_MODE_DSHOT300, PWM_MODE_DSHOT600};
+
+//! Digital ESC protocols, the position of a channel is its throttle value from 0 to 2047
+#define PIOS_SERVO_IS_DSHOT(mode) ((mode) >= PWM_MODE_DSHOT150)
 
 /* Public Functions */
 extern void PIOS_Servo_SetMode(const uint16_t * update_rates, const enum pwm_mode *pwm_mdoe, uint8_t banks);
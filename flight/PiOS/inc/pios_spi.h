@@ -42,6 +42,14 @@ typedef enum {
 	PIOS_SPI_PRESCALER_256 = 7
 } SPIPrescalerTypeDef;
 
+/* Classes of bus users, claims of a higher class waiting for the bus get it first */
+enum pios_spi_priority {
+	PIOS_SPI_PRIORITY_BULK,		/* Flash and other long transfers */
+	PIOS_SPI_PRIORITY_NORMAL,	/* Everything claiming with PIOS_SPI_ClaimBus() */
+	PIOS_SPI_PRIORITY_REALTIME,	/* Sensors and radios with deadlines */
+	PIOS_SPI_PRIORITY_NUM,
+};
+
 /* Public Functions */
 extern int32_t PIOS_SPI_SetClockSpeed(uint32_t spi_id, uint32_t speed);
 extern int32_t PIOS_SPI_RC_PinSet(uint32_t spi_id, uint32_t slave_id, uint8_t pin_value);
@@ -49,6 +57,8 @@ extern int32_t PIOS_SPI_TransferByte(uint32_t spi_id, uint8_t b);
 extern int32_t PIOS_SPI_TransferBlock(uint32_t spi_id, const uint8_t *send_buffer, uint8_t *receive_buffer, uint16_t len, void *callback);
 extern int32_t PIOS_SPI_Busy(uint32_t spi_id);
 extern int32_t PIOS_SPI_ClaimBus(uint32_t spi_id);
+extern int32_t PIOS_SPI_ClaimBusPriority(uint32_t spi_id, enum pios_spi_priority priority);
+extern bool    PIOS_SPI_BusContended(uint32_t spi_id, enum pios_spi_priority priority);
 extern int32_t PIOS_SPI_ClaimBusISR(uint32_t spi_id, bool* woken);
 extern int32_t PIOS_SPI_ReleaseBus(uint32_t spi_id);
 extern int32_t PIOS_SPI_ReleaseBusISR(uint32_t spi_id, bool* woken);
@@ -55,6 +55,7 @@ struct pios_spi_dev {
 	uint8_t tx_dummy_byte;
 	uint8_t rx_dummy_byte;
 	struct pios_semaphore *busy;
+	volatile uint8_t waiting[PIOS_SPI_PRIORITY_NUM];
 };
 
 extern int32_t PIOS_SPI_Init(uint32_t * spi_id, const struct pios_spi_cfg * cfg);
@@ -80,12 +80,16 @@ struct pios_thread
  */
 
 struct pios_thread *PIOS_Thread_Create(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio);
+struct pios_thread *PIOS_Thread_Create_Fast(void (*fp)(void *), const char *namep, size_t stack_bytes, void *argp, enum pios_thread_prio_e prio);
 void PIOS_Thread_Delete(struct pios_thread *threadp);
 uint32_t PIOS_Thread_Systime(void);
 void PIOS_Thread_Sleep(uint32_t time_ms);
 void PIOS_Thread_Sleep_Until(uint32_t *previous_ms, uint32_t increment_ms);
 uint32_t PIOS_Thread_Get_Stack_Usage(struct pios_thread *threadp);
 uint32_t PIOS_Thread_Get_Runtime(struct pios_thread *threadp);
+uint32_t PIOS_Thread_Get_Context_Switches(struct pios_thread *threadp);
+uint32_t PIOS_Thread_Get_Max_Latency(struct pios_thread *threadp);
+bool PIOS_Thread_Get_Idle_Time(uint32_t *idle_ticks, uint32_t *total_ticks);
 void PIOS_Thread_Scheduler_Suspend(void);
 void PIOS_Thread_Scheduler_Resume(void);
 
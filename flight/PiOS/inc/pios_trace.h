@@ -0,0 +1,90 @@
+/**
+ ******************************************************************************
+ * @file       pios_trace.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup PIOS PIOS Core hardware abstraction layer
+ * @{
+ * @addtogroup PIOS_Trace Binary event trace
+ * @{
+ * @brief Records thread switches, interrupts and object events in RAM
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PIOS_TRACE_H_
+#define PIOS_TRACE_H_
+
+#include <stdint.h>
+
+/*
+ * Every event is a type, a 16 bit argument and the cycle counter of
+ * PIOS_DELAY_GetRaw() at the time it happened. The events go to a ring
+ * buffer in RAM that the logging module drains into TraceBlock records of
+ * the compact log, python/tracelog.py turns those into a timeline.
+ *
+ * The hooks in the kernels, the interrupt handlers, the queues and the
+ * object manager only exist when the firmware is built with
+ * ENABLE_TRACE=YES, which defines PIOS_INCLUDE_TRACE.  Until
+ * PIOS_TRACE_Init() is called they cost a compare.
+ */
+
+enum pios_trace_event {
+	PIOS_TRACE_THREAD_IN = 1,	/* arg: low bits of the thread */
+	PIOS_TRACE_ISR_ENTER,		/* arg: PIOS_TRACE_ISR_ID() */
+	PIOS_TRACE_ISR_EXIT,		/* arg: PIOS_TRACE_ISR_ID() */
+	PIOS_TRACE_QUEUE_SEND,		/* arg: low bits of the queue */
+	PIOS_TRACE_QUEUE_RECEIVE,	/* arg: low bits of the queue */
+	PIOS_TRACE_UAVO_EVENT,		/* arg: event type << 8 | object index */
+	PIOS_TRACE_CALLBACK_ENTER,	/* arg: object index */
+	PIOS_TRACE_CALLBACK_EXIT,	/* arg: object index */
+	PIOS_TRACE_MARK,		/* arg: anything, in place of a GPIO toggle */
+};
+
+enum pios_trace_isr {
+	PIOS_TRACE_ISR_SPI = 1,
+	PIOS_TRACE_ISR_USART,
+	PIOS_TRACE_ISR_TIM,
+};
+
+//! Tells the instances of a peripheral apart by their 1 kB aligned base
+#define PIOS_TRACE_ISR_ID(source, base) \
+	(((source) << 8) | (((uintptr_t)(base) >> 10) & 0xFF))
+
+struct pios_trace_record {
+	uint32_t cycles;
+	uint16_t arg;
+	uint8_t event;
+	uint8_t reserved;
+};
+
+#if defined(PIOS_INCLUDE_TRACE)
+#define PIOS_TRACE(event, arg) PIOS_TRACE_Record((event), (uint16_t)(uintptr_t)(arg))
+#else
+#define PIOS_TRACE(event, arg) do { } while (0)
+#endif
+
+int32_t PIOS_TRACE_Init(uint16_t size);
+void PIOS_TRACE_Record(uint8_t event, uint16_t arg);
+uint16_t PIOS_TRACE_Read(struct pios_trace_record *records, uint16_t max_records);
+uint32_t PIOS_TRACE_Dropped(void);
+uint16_t PIOS_TRACE_CyclesPeruS(void);
+
+#endif /* PIOS_TRACE_H_ */
+
+/**
+  * @}
+  * @}
+  */
@@ -49,10 +49,12 @@ struct pios_usart_cfg {
 	bool tx_invert;
 	bool rxtx_swap;
 	bool single_wire;
+	const struct stm32_dma * dma;	/* Optional, F4 only: RX and TX in chunks instead of an interrupt per byte */
 };
 
 extern int32_t PIOS_USART_Init(uintptr_t * usart_id, const struct pios_usart_cfg * cfg);
 extern const struct pios_usart_cfg * PIOS_USART_GetConfig(uintptr_t usart_id);
+extern void PIOS_USART_DMA_IRQ_Handler(USART_TypeDef * regs);
 
 #endif /* PIOS_USART_PRIV_H */
 
@@ -75,6 +75,7 @@
 #include <pios_led.h>
 #include <pios_usart.h>
 #include <pios_irq.h>
+#include <pios_trace.h>
 #include <pios_adc.h>
 #include <pios_internal_adc.h>
 #include <pios_servo.h>
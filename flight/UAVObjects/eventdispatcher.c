@@ -49,7 +49,13 @@
 #endif /* PIOS_EVENTDISPATCHER_STACK_SIZE */
 
 #define TASK_PRIORITY PIOS_THREAD_PRIO_HIGH
+// Below the control loops, so that settings callbacks never run in the middle
+// of a loop iteration that uses those settings
+#define TASK_PRIORITY_HIGH PIOS_THREAD_PRIO_HIGH
+#define TASK_PRIORITY_LOW PIOS_THREAD_PRIO_LOW
 #define MAX_UPDATE_PERIOD_MS 1000
+#define CALLBACK_BATCH_SIZE 4
+#define HEAP_INITIAL_SIZE 16
 
 // Private types
 
@@ -70,22 +76,46 @@ struct PeriodicObjectListStruct {
 	EventCallbackInfo evInfo; /** Event callback information */
     uint16_t updatePeriodMs; /** Update period in ms or 0 if no periodic updates are needed */
     int32_t timeToNextUpdateMs; /** Time delay to the next update */
+    int16_t heapIndex; /** Position in the deadline heap or -1 if not scheduled */
     struct PeriodicObjectListStruct* next; /** Needed by linked list library (utlist.h) */
 };
 typedef struct PeriodicObjectListStruct PeriodicObjectList;
 
+/**
+ * Callback queue and task serving one priority class. The normal class
+ * also handles the periodic updates.
+ */
+struct EventWorker {
+	struct pios_queue *queue;
+	struct pios_thread *task;
+};
+
 // Private variables
 static PeriodicObjectList* objList;
-static struct pios_queue *queue;
-static struct pios_thread *eventTaskHandle;
+/*
+ * Binary min-heap of the scheduled entries ordered by their next deadline,
+ * so the next due update is always heap[0] and rescheduling is O(log n).
+ */
+static PeriodicObjectList** heap;
+static uint16_t heapSize;
+static uint16_t heapCapacity;
+static struct EventWorker workers[EV_PRIORITY_NUM];
 static struct pios_recursive_mutex *mutex;
 static EventStats stats;
 
 // Private functions
 static int32_t processPeriodicUpdates();
 static void eventTask();
+#if !defined(PIOS_EVENTDISPATCHER_SINGLE_TASK)
+static void callbackTask(void *parameters);
+#endif
+static void invokeCallback(EventCallbackInfo *evInfo);
 static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
 static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, struct pios_queue *queue, uint16_t periodMs);
+static int32_t heapSchedule(PeriodicObjectList* objEntry);
+static void heapRemove(PeriodicObjectList* objEntry);
+static void heapSiftUp(uint16_t idx);
+static void heapSiftDown(uint16_t idx);
 
 
 /**
@@ -96,6 +126,9 @@ int32_t EventDispatcherInitialize()
 {
 	// Initialize variables
 	objList = NULL;
+	heap = NULL;
+	heapSize = 0;
+	heapCapacity = 0;
 	memset(&stats, 0, sizeof(EventStats));
 
 	// Create mutex
@@ -104,10 +137,24 @@ int32_t EventDispatcherInitialize()
 		return -1;
 
 	// Create event queue
-	queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(EventCallbackInfo));
+	workers[EV_PRIORITY_NORMAL].queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(EventCallbackInfo));
 
 	// Create task
-	eventTaskHandle = PIOS_Thread_Create(eventTask, "event", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+	workers[EV_PRIORITY_NORMAL].task = PIOS_Thread_Create(eventTask, "event", STACK_SIZE_BYTES, NULL, TASK_PRIORITY);
+
+#if defined(PIOS_EVENTDISPATCHER_SINGLE_TASK)
+	// Not enough memory for more stacks, all classes share the normal task
+	workers[EV_PRIORITY_HIGH] = workers[EV_PRIORITY_NORMAL];
+	workers[EV_PRIORITY_LOW] = workers[EV_PRIORITY_NORMAL];
+#else
+	workers[EV_PRIORITY_HIGH].queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(EventCallbackInfo));
+	workers[EV_PRIORITY_HIGH].task = PIOS_Thread_Create(callbackTask, "eventhigh", STACK_SIZE_BYTES,
+			(void *) EV_PRIORITY_HIGH, TASK_PRIORITY_HIGH);
+
+	workers[EV_PRIORITY_LOW].queue = PIOS_Queue_Create(MAX_QUEUE_SIZE, sizeof(EventCallbackInfo));
+	workers[EV_PRIORITY_LOW].task = PIOS_Thread_Create(callbackTask, "eventlow", STACK_SIZE_BYTES,
+			(void *) EV_PRIORITY_LOW, TASK_PRIORITY_LOW);
+#endif
 
 	// Done
 	return 0;
@@ -134,6 +181,16 @@ void EventClearStats()
 	PIOS_Recursive_Mutex_Unlock(mutex);
 }
 
+/**
+ * Get the contention statistics of the event dispatcher lock
+ * @param[out] statsOut The statistics will be copied there
+ * @return false if the firmware is built without MUTEX_DIAGNOSTICS
+ */
+bool EventGetLockStats(struct pios_mutex_stats *statsOut)
+{
+	return PIOS_Recursive_Mutex_GetStats(mutex, statsOut);
+}
+
 /**
  * Dispatch an event by invoking the supplied callback. The function
  * returns imidiatelly, the callback is invoked from the event task.
@@ -142,17 +199,37 @@ void EventClearStats()
  * \return Success (0), failure (-1)
  */
 int32_t EventCallbackDispatch(UAVObjEvent* ev, UAVObjEventCallback cb)
+{
+	return EventCallbackDispatchPriority(ev, cb, EV_PRIORITY_NORMAL);
+}
+
+/**
+ * Dispatch an event by invoking the supplied callback from the event task
+ * of a priority class. The function returns immediately.
+ * \param[in] ev The event to be dispatched
+ * \param[in] cb The callback function
+ * \param[in] priority The priority class of the event task to use
+ * \return Success (0), failure (-1) if the queue of that class is full
+ */
+int32_t EventCallbackDispatchPriority(UAVObjEvent* ev, UAVObjEventCallback cb, UAVObjEventPriority priority)
 {
 	EventCallbackInfo evInfo;
+
+	if (priority >= EV_PRIORITY_NUM)
+		return -1;
+
 	// Initialize event callback information
 	memcpy(&evInfo.ev, ev, sizeof(UAVObjEvent));
 	evInfo.cb = cb;
 	evInfo.queue = 0;
 	// Push to queue
-	if (PIOS_Queue_Send(queue, &evInfo, 0) == true)
+	if (PIOS_Queue_Send(workers[priority].queue, &evInfo, 0) == true)
 		return 0;
-	else
-		return -1;
+
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	++stats.callbackOverflows[priority];
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return -1;
 }
 
 /**
@@ -240,6 +317,12 @@ static int32_t eventPeriodicCreate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 	objEntry->evInfo.queue = queue;
     objEntry->updatePeriodMs = periodMs;
     objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
+    objEntry->heapIndex = -1;
+    if (heapSchedule(objEntry) != 0) {
+		PIOS_free(objEntry);
+		PIOS_Recursive_Mutex_Unlock(mutex);
+		return -1;
+    }
     // Add to list
     LL_APPEND(objList, objEntry);
 	// Release lock
@@ -272,9 +355,10 @@ static int32_t eventPeriodicUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, stru
 			// Object found, update period
 			objEntry->updatePeriodMs = periodMs;
 			objEntry->timeToNextUpdateMs = randomize_int(periodMs); // avoid bunching of updates
+			int32_t ret = heapSchedule(objEntry);
 			// Release lock
 			PIOS_Recursive_Mutex_Unlock(mutex);
-			return 0;
+			return ret;
 		}
 	}
     // If this point is reached the object was not found
@@ -289,10 +373,11 @@ static void eventTask()
 {
 	int32_t timeToNextUpdateMs;
 	int32_t delayMs;
-	EventCallbackInfo evInfo;
+	// Static to stay off the small stack of this task, it only runs once
+	static EventCallbackInfo evInfo[CALLBACK_BATCH_SIZE];
 
 	/* Must do this in task context to ensure that TaskMonitor has already finished its init */
-	TaskMonitorAdd(TASKINFO_RUNNING_EVENTDISPATCHER, eventTaskHandle);
+	TaskMonitorAdd(TASKINFO_RUNNING_EVENTDISPATCHER, workers[EV_PRIORITY_NORMAL].task);
 
 	// Initialize time
 	timeToNextUpdateMs = PIOS_Thread_Systime();
@@ -307,13 +392,15 @@ static void eventTask()
 			delayMs = 0;
 		}
 
-		// Wait for queue message
-		if (PIOS_Queue_Receive(queue, &evInfo, delayMs) == true)
+		// Wait for queue messages, taking the ones that piled up at once
+		uint16_t num = PIOS_Queue_ReceiveMany(workers[EV_PRIORITY_NORMAL].queue,
+				evInfo, CALLBACK_BATCH_SIZE, delayMs);
+		for (uint16_t i = 0; i < num; i++)
 		{
 			// Invoke callback, if one
-			if (evInfo.cb != 0)
+			if (evInfo[i].cb != 0)
 			{
-				evInfo.cb(&evInfo.ev); // the function is expected to copy the event information
+				invokeCallback(&evInfo[i]);
 			}
 		}
 
@@ -325,62 +412,218 @@ static void eventTask()
 	}
 }
 
+#if !defined(PIOS_EVENTDISPATCHER_SINGLE_TASK)
 /**
- * Handle periodic updates for all objects.
- * \return The system time until the next update (in ms) or -1 if failed
+ * Callback task of the high and low priority classes, these only invoke
+ * dispatched callbacks and never run periodic updates.
+ */
+static void callbackTask(void *parameters)
+{
+	UAVObjEventPriority priority = (UAVObjEventPriority) (uintptr_t) parameters;
+	struct EventWorker *worker = &workers[priority];
+	EventCallbackInfo evInfo;
+
+	/* Must do this in task context to ensure that TaskMonitor has already finished its init */
+	TaskMonitorAdd((priority == EV_PRIORITY_HIGH) ?
+			TASKINFO_RUNNING_EVENTDISPATCHERHIGH : TASKINFO_RUNNING_EVENTDISPATCHERLOW,
+			worker->task);
+
+	while (1)
+	{
+		if (PIOS_Queue_Receive(worker->queue, &evInfo, PIOS_QUEUE_TIMEOUT_MAX) == true)
+		{
+			if (evInfo.cb != 0)
+			{
+				invokeCallback(&evInfo);
+			}
+		}
+	}
+}
+#endif /* PIOS_EVENTDISPATCHER_SINGLE_TASK */
+
+/**
+ * Invoke the callback of an event, it is marked in the event trace
+ */
+static void invokeCallback(EventCallbackInfo *evInfo)
+{
+#if defined(PIOS_INCLUDE_TRACE)
+	uint8_t index = evInfo->ev.obj ? UAVObjGetIndex(evInfo->ev.obj) : UAVOBJ_NO_INDEX;
+	PIOS_TRACE(PIOS_TRACE_CALLBACK_ENTER, index);
+#endif
+
+	evInfo->cb(&evInfo->ev); // the function is expected to copy the event information
+
+#if defined(PIOS_INCLUDE_TRACE)
+	PIOS_TRACE(PIOS_TRACE_CALLBACK_EXIT, index);
+#endif
+}
+
+/**
+ * Handle the periodic updates that are due.
+ * \return The system time of the next update (in ms)
  */
 static int32_t processPeriodicUpdates()
 {
 	PeriodicObjectList* objEntry;
 	int32_t timeNow;
-    int32_t timeToNextUpdate;
-    int32_t offset;
+	int32_t timeToNextUpdate;
+	int32_t offset;
 
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-    // Iterate through each object and update its timer, if zero then transmit object.
-    // Also calculate smallest delay to next update.
-    timeToNextUpdate = PIOS_Thread_Systime() + MAX_UPDATE_PERIOD_MS;
-    LL_FOREACH(objList, objEntry)
-    {
-        // If object is configured for periodic updates
-        if (objEntry->updatePeriodMs > 0)
-        {
-            // Check if time for the next update
-        	timeNow = PIOS_Thread_Systime();
-            if (objEntry->timeToNextUpdateMs <= timeNow)
-            {
-                // Reset timer
-            	offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
-            	objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
-    			// Invoke callback, if one
-    			if ( objEntry->evInfo.cb != 0)
-    			{
-    				objEntry->evInfo.cb(&objEntry->evInfo.ev); // the function is expected to copy the event information
-    			}
-    			// Push event to queue, if one
-    			if ( objEntry->evInfo.queue != 0)
-    			{
-    				if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
-    				{
-						if (objEntry->evInfo.ev.obj != NULL)
-							stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
-    					++stats.eventErrors;
-    				}
-    			}
-            }
-            // Update minimum delay
-            if (objEntry->timeToNextUpdateMs < timeToNextUpdate)
-            {
-            	timeToNextUpdate = objEntry->timeToNextUpdateMs;
-            }
-        }
-    }
+	// Pop due entries off the heap until the earliest one is in the future
+	timeNow = PIOS_Thread_Systime();
+	while (heapSize > 0 && heap[0]->timeToNextUpdateMs - timeNow <= 0)
+	{
+		objEntry = heap[0];
+
+		// Reschedule before invoking, a callback may change the period
+		offset = ( timeNow - objEntry->timeToNextUpdateMs ) % objEntry->updatePeriodMs;
+		objEntry->timeToNextUpdateMs = timeNow + objEntry->updatePeriodMs - offset;
+		heapSiftDown(0);
+
+		// Invoke callback, if one
+		if ( objEntry->evInfo.cb != 0)
+		{
+			invokeCallback(&objEntry->evInfo);
+		}
+		// Push event to queue, if one
+		if ( objEntry->evInfo.queue != 0)
+		{
+			if (PIOS_Queue_Send(objEntry->evInfo.queue, &objEntry->evInfo.ev, 0) != true ) // do not block if queue is full
+			{
+				if (objEntry->evInfo.ev.obj != NULL)
+					stats.lastErrorID = UAVObjGetID(objEntry->evInfo.ev.obj);
+				++stats.eventErrors;
+			}
+		}
+
+		timeNow = PIOS_Thread_Systime();
+	}
+
+	// The next deadline is at the top of the heap
+	timeToNextUpdate = timeNow + MAX_UPDATE_PERIOD_MS;
+	if (heapSize > 0 && heap[0]->timeToNextUpdateMs - timeToNextUpdate < 0)
+	{
+		timeToNextUpdate = heap[0]->timeToNextUpdateMs;
+	}
+
+	// Done
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return timeToNextUpdate;
+}
+
+/**
+ * Put an entry in the heap at its current deadline, or take it out if
+ * periodic updates are disabled. Must be called with the lock held.
+ * \return Success (0), failure (-1) if the heap could not grow
+ */
+static int32_t heapSchedule(PeriodicObjectList* objEntry)
+{
+	if (objEntry->updatePeriodMs == 0)
+	{
+		heapRemove(objEntry);
+		return 0;
+	}
+
+	if (objEntry->heapIndex >= 0)
+	{
+		// The deadline may have moved either way
+		heapSiftUp(objEntry->heapIndex);
+		heapSiftDown(objEntry->heapIndex);
+		return 0;
+	}
+
+	if (heapSize == heapCapacity)
+	{
+		uint16_t newCapacity = heapCapacity ? heapCapacity * 2 : HEAP_INITIAL_SIZE;
+		PeriodicObjectList** newHeap = PIOS_malloc_no_dma(newCapacity * sizeof(*newHeap));
+		if (newHeap == NULL)
+			return -1;
+		if (heap != NULL)
+		{
+			memcpy(newHeap, heap, heapSize * sizeof(*newHeap));
+			PIOS_free(heap);
+		}
+		heap = newHeap;
+		heapCapacity = newCapacity;
+	}
+
+	objEntry->heapIndex = heapSize;
+	heap[heapSize++] = objEntry;
+	heapSiftUp(objEntry->heapIndex);
+
+	return 0;
+}
+
+/**
+ * Take an entry out of the heap, if it is in it
+ */
+static void heapRemove(PeriodicObjectList* objEntry)
+{
+	int16_t idx = objEntry->heapIndex;
+
+	if (idx < 0)
+		return;
+
+	objEntry->heapIndex = -1;
+	heapSize--;
+	if (idx == heapSize)
+		return;
+
+	// Move the last entry into the hole and restore the heap order
+	heap[idx] = heap[heapSize];
+	heap[idx]->heapIndex = idx;
+	heapSiftUp(idx);
+	heapSiftDown(idx);
+}
+
+/**
+ * Move an entry towards the top while it is due before its parent
+ */
+static void heapSiftUp(uint16_t idx)
+{
+	PeriodicObjectList* objEntry = heap[idx];
+
+	while (idx > 0)
+	{
+		uint16_t parent = (idx - 1) / 2;
+		if (heap[parent]->timeToNextUpdateMs - objEntry->timeToNextUpdateMs <= 0)
+			break;
+		heap[idx] = heap[parent];
+		heap[idx]->heapIndex = idx;
+		idx = parent;
+	}
+
+	heap[idx] = objEntry;
+	objEntry->heapIndex = idx;
+}
+
+/**
+ * Move an entry towards the bottom while a child is due before it
+ */
+static void heapSiftDown(uint16_t idx)
+{
+	PeriodicObjectList* objEntry = heap[idx];
+
+	while (1)
+	{
+		uint16_t child = 2 * idx + 1;
+		if (child >= heapSize)
+			break;
+		if (child + 1 < heapSize &&
+				heap[child + 1]->timeToNextUpdateMs - heap[child]->timeToNextUpdateMs < 0)
+			child++;
+		if (objEntry->timeToNextUpdateMs - heap[child]->timeToNextUpdateMs <= 0)
+			break;
+		heap[idx] = heap[child];
+		heap[idx]->heapIndex = idx;
+		idx = child;
+	}
 
-    // Done
-    PIOS_Recursive_Mutex_Unlock(mutex);
-    return timeToNextUpdate;
+	heap[idx] = objEntry;
+	objEntry->heapIndex = idx;
 }
 
 /**
@@ -33,6 +33,7 @@
 #define EVENTDISPATCHER_H
 
 #include "pios_queue.h"
+#include "pios_mutex.h"
 
 // Public types
 /**
@@ -41,13 +42,16 @@
 typedef struct {
 	uint32_t lastErrorID;
 	uint32_t eventErrors;
+	uint32_t callbackOverflows[EV_PRIORITY_NUM]; /** Callbacks dropped because the queue of the class was full */
 } EventStats;
 
 // Public functions
 int32_t EventDispatcherInitialize();
 void EventGetStats(EventStats* statsOut);
 void EventClearStats();
+bool EventGetLockStats(struct pios_mutex_stats *statsOut);
 int32_t EventCallbackDispatch(UAVObjEvent* ev, UAVObjEventCallback cb);
+int32_t EventCallbackDispatchPriority(UAVObjEvent* ev, UAVObjEventCallback cb, UAVObjEventPriority priority);
 int32_t EventPeriodicCallbackCreate(UAVObjEvent* ev, UAVObjEventCallback cb, uint16_t periodMs);
 int32_t EventPeriodicCallbackUpdate(UAVObjEvent* ev, UAVObjEventCallback cb, uint16_t periodMs);
 int32_t EventPeriodicQueueCreate(UAVObjEvent* ev, struct pios_queue *queue, uint16_t periodMs);
@@ -32,9 +32,18 @@
 #define UAVOBJECTMANAGER_H
 
 #include "pios_queue.h"
+#include "pios_mutex.h"
 
 #define UAVOBJ_ALL_INSTANCES 0xFFFF
 #define UAVOBJ_MAX_INSTANCES 1000
+#define UAVOBJ_NO_INDEX 0xFF
+
+/*
+ * Single instance objects are split into up to UAVOBJ_DIRTY_CHUNKS equal
+ * chunks (the last one may be short) that are tracked for delta telemetry.
+ */
+#define UAVOBJ_DIRTY_CHUNKS 32
+#define UAVObjDirtyChunkSize(num_bytes) (((num_bytes) + UAVOBJ_DIRTY_CHUNKS - 1) / UAVOBJ_DIRTY_CHUNKS)
 
 /*
  * Shifts and masks used to read/write metadata flags.
@@ -126,6 +135,17 @@ typedef struct {
  */
 typedef void (*UAVObjEventCallback)(UAVObjEvent* ev);
 
+/**
+ * Priority class of an event callback. Each class is served by its own
+ * event dispatcher task so a slow callback cannot delay a more urgent one.
+ */
+typedef enum {
+	EV_PRIORITY_NORMAL = 0,
+	EV_PRIORITY_HIGH = 1,
+	EV_PRIORITY_LOW = 2,
+	EV_PRIORITY_NUM = 3
+} UAVObjEventPriority;
+
 /**
  * Callback used to initialize the object fields to their default values.
  */
@@ -147,19 +167,25 @@ void UAVObjRegisterNewInstanceCB(new_uavo_instance_cb_t callback);
 int32_t UAVObjInitialize();
 void UAVObjGetStats(UAVObjStats* statsOut);
 void UAVObjClearStats();
+bool UAVObjGetLockStats(struct pios_mutex_stats *statsOut);
 UAVObjHandle UAVObjRegister(uint32_t id,
-		int32_t isSingleInstance, int32_t isSettings, uint32_t numBytes, UAVObjInitializeCallback initCb);
+		int32_t isSingleInstance, int32_t isSettings, int32_t isSingleWriter,
+		uint32_t numBytes, UAVObjInitializeCallback initCb);
 UAVObjHandle UAVObjGetByID(uint32_t id);
 uint32_t UAVObjGetID(UAVObjHandle obj);
 uint32_t UAVObjGetNumBytes(UAVObjHandle obj);
 uint16_t UAVObjGetNumInstances(UAVObjHandle obj);
 UAVObjHandle UAVObjGetLinkedObj(UAVObjHandle obj);
 uint16_t UAVObjCreateInstance(UAVObjHandle obj_handle, UAVObjInitializeCallback initCb);
+int32_t UAVObjDeleteInstance(UAVObjHandle obj_handle);
 bool UAVObjIsSingleInstance(UAVObjHandle obj);
 bool UAVObjIsMetaobject(UAVObjHandle obj);
 bool UAVObjIsSettings(UAVObjHandle obj);
+uint32_t UAVObjTakeDirtyChunks(UAVObjHandle obj);
 int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId, const uint8_t* dataIn);
 int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t* dataOut);
+int32_t UAVObjPackMultiple(const UAVObjHandle obj_handles[], uint8_t count, uint8_t * const dataOut[], uint16_t seqOut[]);
+int32_t UAVObjUnpackMultiple(const UAVObjHandle obj_handles[], uint8_t count, const uint8_t * const dataIn[]);
 int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId);
 int32_t UAVObjDeleteById(uint32_t obj_id, uint16_t inst_id);
@@ -179,8 +205,11 @@ int32_t UAVObjGetData(UAVObjHandle obj_handle, void* dataOut);
 int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offset, uint32_t size);
 int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn);
 int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn, uint32_t offset, uint32_t size);
+int32_t UAVObjSetInstanceDataDeferred(UAVObjHandle obj_handle, uint16_t instId, const void* dataIn);
 int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId, void* dataOut);
 int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, void* dataOut, uint32_t offset, uint32_t size);
+int32_t UAVObjSetSingleDataField(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size);
+int32_t UAVObjGetSingleDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offset, uint32_t size);
 int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata* dataIn);
 int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata* dataOut);
 uint8_t UAVObjGetMetadataAccess(const UAVObjMetadata* dataOut);
@@ -200,8 +229,12 @@ int8_t UAVObjReadOnly(UAVObjHandle obj);
 int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue, uint8_t eventMask);
 int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue);
 int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle, struct pios_queue *queue, uint8_t eventMask, uint16_t interval);
+int32_t UAVObjConnectQueueCoalesced(UAVObjHandle obj_handle, struct pios_queue *queue, uint8_t eventMask, uint16_t interval);
+bool UAVObjQueueReceive(struct pios_queue *queue, UAVObjEvent *ev, uint32_t timeout_ms);
+uint16_t UAVObjQueueDropped(UAVObjHandle obj_handle, struct pios_queue *queue);
 int32_t UAVObjConnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask);
 int32_t UAVObjConnectCallbackThrottled(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask, uint16_t interval);
+int32_t UAVObjConnectCallbackPriority(UAVObjHandle obj_handle, UAVObjEventCallback cb, uint8_t eventMask, uint16_t interval, UAVObjEventPriority priority);
 int32_t UAVObjDisconnectCallback(UAVObjHandle obj_handle, UAVObjEventCallback cb);
 void UAVObjRequestUpdate(UAVObjHandle obj);
 void UAVObjRequestInstanceUpdate(UAVObjHandle obj_handle, uint16_t instId);
@@ -211,6 +244,7 @@ void UAVObjIterate(void (*iterator)(UAVObjHandle obj));
 int32_t getEventMask(UAVObjHandle obj_handle, struct pios_queue *queue);
 uint8_t UAVObjCount();
 uint32_t UAVObjIDByIndex(uint8_t index);
+uint8_t UAVObjGetIndex(UAVObjHandle obj_handle);
 
 #endif // UAVOBJECTMANAGER_H
 
@@ -36,6 +36,14 @@ void UAVObjectsInitializeAll();
 
 #define UAVOBJECTS_LARGEST $(SIZECALCULATION)
 
+/*
+ * Storage layout of the static UAVObject arena, only the objects built into
+ * this target get a slot. Each slot expands to
+ * UAVOBJ_ARENA_SLOT(objid, isSingleInstance, isSettings, isSingleWriter, numBytes)
+ */
+$(ARENASLOTS)
+#define UAVOBJ_ARENA_SLOTS$(ARENALIST)
+
 #endif /* UAVOBJECTSINIT_H */
 
 /**
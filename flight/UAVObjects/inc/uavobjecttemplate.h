@@ -38,6 +38,7 @@
 #ifndef $(NAMEUC)_H
 #define $(NAMEUC)_H
 
+#include <stddef.h>
 #include "pios_queue.h"
 #include "uavoversion.h"
 
@@ -47,6 +48,7 @@ $(PARENT_INCLUDES)
 #define $(NAMEUC)_OBJID $(OBJIDHEX)
 #define $(NAMEUC)_ISSINGLEINST $(ISSINGLEINST)
 #define $(NAMEUC)_ISSETTINGS $(ISSETTINGS)
+#define $(NAMEUC)_ISSINGLEWRITER $(ISSINGLEWRITER)
 #define $(NAMEUC)_NUMBYTES $(NUMBYTES)
 
 // Generic interface functions
@@ -65,9 +67,9 @@ $(DATAFIELDS)
  * @brief Populate a $(NAME)Data object
  * @param[out] dataOut 
  */
-static inline int32_t $(NAME)Get($(NAME)Data *dataOut) { return UAVObjGetData($(NAME)Handle(), dataOut); }
+static inline int32_t $(NAME)Get($(NAME)Data *dataOut) { return $(GETDATA); }
 
-static inline int32_t $(NAME)Set(const $(NAME)Data *dataIn) { return UAVObjSetData($(NAME)Handle(), dataIn); }
+static inline int32_t $(NAME)Set(const $(NAME)Data *dataIn) { return $(SETDATA); }
 
 static inline int32_t $(NAME)InstGet(uint16_t instId, $(NAME)Data *dataOut) { return UAVObjGetInstanceData($(NAME)Handle(), instId, dataOut); }
 
@@ -32,9 +32,11 @@
 #include "openpilot.h"
 #include "pios_struct_helper.h"
 #include "pios_heap.h"		/* PIOS_malloc_no_dma */
+#include "pios_mempool.h"
 #include "pios_mutex.h"
 #include "pios_queue.h"
 #include "misc_math.h"
+#include "uavobjectsinit.h"	/* UAVOBJ_ARENA_SLOTS */
 
 extern uintptr_t pios_uavo_settings_fs_id;
 
@@ -57,14 +59,25 @@ struct ObjectEventEntry {
 	UAVObjEventCallback       cb;
 	uint8_t                   hasThrottle : 1;
 	uint8_t                   eventMask : 7;
+	uint8_t                   priority : 2;
+	uint8_t                   coalesce : 1;
+	/* Instances with an update event sitting in the queue, see sendEvent() */
+	uint16_t                  pending;
 	struct ObjectEventEntry * next;
 };
 
+//! Events that are merged into one pending event on coalesced queues
+#define EV_MASK_COALESCED (EV_UNPACKED | EV_UPDATED)
+//! Instances from this one on are never coalesced
+#define UAVO_COALESCE_INSTANCES 16
+
 struct ObjectEventEntryThrottled {
 	struct ObjectEventEntry   entry; // MUST be first! So throttled entry can be interpreted as ObjectEventEntry
 
 	uint32_t                  due;
 	uint16_t                  interval;
+	/* Events lost because the queue was full, see UAVObjQueueDropped() */
+	uint16_t                  dropped;
 };
 
 /*
@@ -86,11 +99,17 @@ struct UAVOBase {
 	/* Let these objects be added to an event queue */
 	struct ObjectEventEntry * next_event;
 
+	/* Changed by every write of the instance data, see instanceWrite() */
+	volatile uint16_t seq;
+
 	/* Describe the type of object that follows this header */
 	struct UAVOInfo {
 		bool isMeta        : 1;
 		bool isSingle      : 1;
 		bool isSettings    : 1;
+		bool isSingleWriter : 1;
+		/* Loaded by UAVObjLoadSettings(), its event is still to be sent */
+		bool loadPending   : 1;
 	} flags;
 
 } __attribute__((packed));
@@ -112,12 +131,18 @@ struct UAVOData {
 	struct UAVOMeta   metaObj;
 	struct UAVOData * next;
 	uint16_t          instance_size;
+	/* Position in uavo_list, the index handed out by UAVObjIDByIndex() */
+	uint8_t           index;
 } __attribute__((packed));
 
 /* Augmented type for Single Instance Data UAVO */
 struct UAVOSingle {
 	struct UAVOData   uavo;
 
+	/* Chunks changed since the last UAVObjTakeDirtyChunks() */
+	uint32_t          dirty;
+	uint8_t           takes;
+
 	uint8_t           instance0[];
 	/* 
 	 * Additional space will be malloc'd here to hold the
@@ -135,11 +160,23 @@ struct UAVOMultiInst {
 	 */
 } __attribute__((packed));
 
+/*
+ * Storage of every instance after instance 0. Once the instance is deleted
+ * its storage is linked into the object's pool through the leading word,
+ * so the next pointer that a reader still walking the list may follow is
+ * left alone.
+ */
+struct UAVOMultiInstStorage {
+	void                 * pool_link;
+	struct UAVOMultiInst   inst;
+} __attribute__((packed));
+
 /* Augmented type for Multi Instance Data UAVO */
 struct UAVOMulti {
 	struct UAVOData        uavo;
 
 	uint16_t               num_instances;
+	struct pios_mempool  * free_instances;	/* storage of deleted instances */
 	struct UAVOMultiInst   instance0;
 	/*
 	 * Additional space will be malloc'd here to hold the
@@ -160,19 +197,117 @@ struct UAVOMulti {
 #define InstanceDataOffset(inst) ((void*)&(( (struct UAVOMultiInst*)inst )->instance))
 #define InstanceData(instance) (void*)instance
 
+/*
+ * Objects are also indexed by ID in an open addressing hash table so
+ * telemetry can look them up without scanning the list or taking the
+ * mutex. Objects are never removed, so a slot is written exactly once,
+ * after the object is fully initialized. The build passes the number of
+ * objects it links in, the table is sized for a load factor below 2/3.
+ */
+#if defined(UAVOBJ_NUM_OBJECTS)
+#define UAVO_HASH_SIZE (UAVOBJ_NUM_OBJECTS + UAVOBJ_NUM_OBJECTS / 2 + 1)
+#else
+#define UAVO_HASH_SIZE 257
+#endif
+
+#define UAVO_HASH_BARRIER() __sync_synchronize()
+
+/*
+ * Instance data is not protected by the global mutex, so a high priority
+ * task reading or writing one object never waits on a bulk settings load
+ * or an iteration over all objects. Each object has a sequence counter:
+ * a writer makes it odd, copies the data and makes it even again, all with
+ * the scheduler locked so writers of the same object never interleave.
+ * Readers copy without locking and retry if the counter was odd or has
+ * changed meanwhile, which only happens if a writer preempted the copy.
+ * Objects marked single writer in their definition keep two copies of
+ * the data instead; their only writer fills the spare copy and publishes
+ * it without locking the scheduler, and readers copy the published one.
+ * The global mutex still serializes changes to the object, instance and
+ * event lists; those are only ever appended to or unlinked, so sendEvent()
+ * and getInstance() can walk them without it.
+ */
+#define UAVO_SEQ_BARRIER() __sync_synchronize()
+
+//! Report every chunk as dirty once in this many UAVObjTakeDirtyChunks() calls
+#define UAVOBJ_DELTA_REFRESH 16
+
+/*
+ * When uavobjgenerator provides the layout, every object built into the
+ * target lives in one statically sized arena, hot sensor and state objects
+ * next to each other, instead of in separate heap blocks. Extra instances
+ * of multi instance objects come from a pool at the end of the arena and
+ * from the heap once that is used up. SMALLF1 targets only initialize a
+ * part of their objects, so there the heap remains the cheaper choice.
+ */
+#if defined(UAVOBJ_ARENA_SLOTS) && !defined(SMALLF1)
+#define UAVO_STATIC_ARENA
+#endif
+
+#if defined(UAVO_STATIC_ARENA)
+
+#if !defined(PIOS_UAVOBJECTS_INSTANCE_POOL)
+#define PIOS_UAVOBJECTS_INSTANCE_POOL 512
+#endif
+
+#define UAVO_ARENA_ALIGN(x) (((x) + 3) & ~3)
+#define UAVO_ARENA_SLOT_SIZE(single, settings, singlewriter, num_bytes) \
+	UAVO_ARENA_ALIGN((single) ? \
+		sizeof(struct UAVOSingle) + (num_bytes) * (((singlewriter) && !(settings)) ? 2 : 1) : \
+		sizeof(struct UAVOMulti) + (num_bytes))
+
+struct UAVOArenaSlot {
+	uint32_t id;
+	uint16_t size;
+};
+
+#define UAVOBJ_ARENA_SLOT(id, single, settings, singlewriter, num_bytes) \
+	+ UAVO_ARENA_SLOT_SIZE(single, settings, singlewriter, num_bytes)
+enum { UAVO_ARENA_OBJECTS_SIZE = 0 UAVOBJ_ARENA_SLOTS };
+#undef UAVOBJ_ARENA_SLOT
+
+#define UAVOBJ_ARENA_SLOT(id, single, settings, singlewriter, num_bytes) \
+	{ id, UAVO_ARENA_SLOT_SIZE(single, settings, singlewriter, num_bytes) },
+static const struct UAVOArenaSlot uavo_arena_layout[] = { UAVOBJ_ARENA_SLOTS };
+#undef UAVOBJ_ARENA_SLOT
+
+/* Never a DMA source, see the placement policy in pios_heap.h */
+static uint8_t uavo_arena[UAVO_ARENA_OBJECTS_SIZE + PIOS_UAVOBJECTS_INSTANCE_POOL] PIOS_FAST_DATA __attribute__((aligned(4)));
+static uint32_t uavo_arena_pool_used;
+
+#endif /* UAVO_STATIC_ARENA */
+
 // Private functions
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType event);
+static void *allocStorage(uint32_t id, uint32_t size);
+static struct UAVOData *findByIdLocked(uint32_t id);
+static void hashInsert(struct UAVOData *obj);
+static struct UAVOData *hashLookup(uint32_t id);
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId);
 static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId);
+static void instanceWrite(struct UAVOBase *obj, void *instData, uint32_t instSize,
+			const void *dataIn, uint32_t offset, uint32_t size);
+static int32_t setInstanceDataField(UAVObjHandle obj_handle, uint16_t instId,
+			const void *dataIn, uint32_t offset, uint32_t size);
+static void instanceWriteLocked(struct UAVOBase *obj, void *instData, uint32_t instSize,
+			const void *dataIn, uint32_t offset, uint32_t size);
+static void instanceRead(struct UAVOBase *obj, const void *instData, uint32_t instSize,
+			void *dataOut, uint32_t offset, uint32_t size);
+static uint32_t dirtyChunkMask(uint32_t instSize);
+static uint32_t changedChunks(const uint8_t *cur, const void *dataIn, uint32_t instSize,
+			uint32_t offset, uint32_t size);
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, uint8_t eventMask,
-			uint16_t interval);
+			uint16_t interval, UAVObjEventPriority priority, bool coalesce);
 static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb);
 
 // Private variables
 static struct UAVOData * uavo_list;
+static uint16_t uavo_count;
+static struct UAVOData * volatile uavo_hash[UAVO_HASH_SIZE];
+static volatile bool uavo_hash_overflow;
 static struct pios_recursive_mutex *mutex;
 static const UAVObjMetadata defMetadata = {
 	.flags = (ACCESS_READWRITE << UAVOBJ_ACCESS_SHIFT |
@@ -197,6 +332,8 @@ int32_t UAVObjInitialize()
 {
 	// Initialize variables
 	uavo_list = NULL;
+	memset((void *) uavo_hash, 0, sizeof(uavo_hash));
+	uavo_hash_overflow = false;
 
 	memset(&stats, 0, sizeof(UAVObjStats));
 
@@ -233,6 +370,16 @@ void UAVObjClearStats()
 	PIOS_Recursive_Mutex_Unlock(mutex);
 }
 
+/**
+ * Get the contention statistics of the object manager lock
+ * @param[out] statsOut The statistics will be copied there
+ * @return false if the firmware is built without MUTEX_DIAGNOSTICS
+ */
+bool UAVObjGetLockStats(struct pios_mutex_stats *statsOut)
+{
+	return PIOS_Recursive_Mutex_GetStats(mutex, statsOut);
+}
+
 /************************
  * Object Initialization
  ***********************/
@@ -250,13 +397,13 @@ static void UAVObjInitMetaData (struct UAVOMeta * obj_meta)
 	memset(&(obj_meta->instance0), 0, sizeof(obj_meta->instance0));
 }
 
-static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes)
+static struct UAVOData * UAVObjAllocSingle(uint32_t id, uint32_t num_bytes, uint8_t num_copies)
 {
 	/* Compute the complete size of the object, including the data for a single embedded instance */
-	uint32_t object_size = sizeof(struct UAVOSingle) + num_bytes;
+	uint32_t object_size = sizeof(struct UAVOSingle) + num_bytes * num_copies;
 
-	/* Allocate the object from the heap */
-	struct UAVOSingle * uavo_single = (struct UAVOSingle *) PIOS_malloc_no_dma(object_size);
+	/* Allocate the object from its arena slot or the heap */
+	struct UAVOSingle * uavo_single = (struct UAVOSingle *) allocStorage(id, object_size);
 	if (!uavo_single)
 		return (NULL);
 
@@ -266,20 +413,56 @@ static struct UAVOData * UAVObjAllocSingle(uint32_t num_bytes)
 	uavo_base->flags.isSingle = true;
 	uavo_base->next_event     = NULL;
 
+	/* Nothing has been sent yet so the first delta is the whole object */
+	uavo_single->dirty = dirtyChunkMask(num_bytes);
+	uavo_single->takes = 0;
+
 	/* Clear the instance data carried in the UAVO */
-	memset(&(uavo_single->instance0), 0, num_bytes);
+	memset(&(uavo_single->instance0), 0, num_bytes * num_copies);
 
 	/* Give back the generic UAVO part */
 	return (&(uavo_single->uavo));
 }
 
-static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
+/**
+ * Get the storage for an object from its arena slot, or for an extra
+ * instance from the arena pool, and fall back to the heap. Called with the
+ * mutex held.
+ * \param[in] id The object ID, 0 for an extra instance
+ * \param[in] size The number of bytes needed
+ */
+static void *allocStorage(uint32_t id, uint32_t size)
+{
+#if defined(UAVO_STATIC_ARENA)
+	if (id) {
+		uint32_t offset = 0;
+
+		for (uint32_t i = 0; i < NELEMENTS(uavo_arena_layout); i++) {
+			if (uavo_arena_layout[i].id == id) {
+				if (size <= uavo_arena_layout[i].size)
+					return &uavo_arena[offset];
+				break;
+			}
+			offset += uavo_arena_layout[i].size;
+		}
+	} else if (uavo_arena_pool_used + UAVO_ARENA_ALIGN(size) <= PIOS_UAVOBJECTS_INSTANCE_POOL) {
+		void *storage = &uavo_arena[UAVO_ARENA_OBJECTS_SIZE + uavo_arena_pool_used];
+
+		uavo_arena_pool_used += UAVO_ARENA_ALIGN(size);
+		return storage;
+	}
+#endif /* UAVO_STATIC_ARENA */
+
+	return PIOS_malloc_no_dma(size);
+}
+
+static struct UAVOData * UAVObjAllocMulti(uint32_t id, uint32_t num_bytes)
 {
 	/* Compute the complete size of the object, including the data for a single embedded instance */
 	uint32_t object_size = sizeof(struct UAVOMulti) + num_bytes;
 
-	/* Allocate the object from the heap */
-	struct UAVOMulti * uavo_multi = (struct UAVOMulti *) PIOS_malloc_no_dma(object_size);
+	/* Allocate the object from its arena slot or the heap */
+	struct UAVOMulti * uavo_multi = (struct UAVOMulti *) allocStorage(id, object_size);
 	if (!uavo_multi)
 		return (NULL);
 
@@ -291,6 +474,7 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
 
 	/* Set up the type-specific part of the UAVO */
 	uavo_multi->num_instances = 1;
+	uavo_multi->free_instances = NULL;
 
 	/* Clear the instance data carried in the UAVO */
 	uavo_multi->instance0.next = NULL;
@@ -309,6 +493,8 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
  * \param[in] id Unique object ID
  * \param[in] isSingleInstance Is this a single instance or multi-instance object
  * \param[in] isSettings Is this a settings object
+ * \param[in] isSingleWriter Is this object only ever written by one task,
+ *            only honoured for single instance objects that are not settings
  * \param[in] numBytes Number of bytes of object data (for one instance)
  * \param[in] initCb Default field and metadata initialization function
  * \return Object handle, or NULL if failure.
@@ -316,7 +502,7 @@ static struct UAVOData * UAVObjAllocMulti(uint32_t num_bytes)
  */
 UAVObjHandle UAVObjRegister(uint32_t id, 
 			int32_t isSingleInstance, int32_t isSettings,
-			uint32_t num_bytes,
+			int32_t isSingleWriter, uint32_t num_bytes,
 			UAVObjInitializeCallback initCb)
 {
 	struct UAVOData * uavo_data = NULL;
@@ -324,14 +510,18 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
 	/* Don't allow duplicate registrations */
-	if (UAVObjGetByID(id))
+	if (findByIdLocked(id) || findByIdLocked(id - 1))
 		goto unlock_exit;
 
 	/* Map the various flags to one of the UAVO types we understand */
-	if (isSingleInstance) {
-		uavo_data = UAVObjAllocSingle (num_bytes);
+	if (isSingleInstance && isSingleWriter && !isSettings) {
+		uavo_data = UAVObjAllocSingle (id, num_bytes, 2);
+		if (uavo_data)
+			uavo_data->base.flags.isSingleWriter = true;
+	} else if (isSingleInstance) {
+		uavo_data = UAVObjAllocSingle (id, num_bytes, 1);
 	} else {
-		uavo_data = UAVObjAllocMulti (num_bytes);
+		uavo_data = UAVObjAllocMulti (id, num_bytes);
 	}
 
 	if (!uavo_data)
@@ -348,6 +538,8 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	UAVObjInitMetaData (&uavo_data->metaObj);
 
 	/* Add the newly created object to the global list of objects */
+	uavo_data->index = (uavo_count < UAVOBJ_NO_INDEX) ? uavo_count : UAVOBJ_NO_INDEX;
+	uavo_count++;
 	LL_APPEND(uavo_list, uavo_data);
 
 	/* Initialize object fields and metadata to default values */
@@ -365,6 +557,9 @@ UAVObjHandle UAVObjRegister(uint32_t id,
 	UAVObjInstanceUpdated((UAVObjHandle) uavo_data, 0);
 	UAVObjInstanceUpdated((UAVObjHandle) &(uavo_data->metaObj), 0);
 
+	/* Only now make the object visible to UAVObjGetByID */
+	hashInsert(uavo_data);
+
 unlock_exit:
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return (UAVObjHandle) uavo_data;
@@ -377,27 +572,97 @@ unlock_exit:
  */
 UAVObjHandle UAVObjGetByID(uint32_t id)
 {
-	UAVObjHandle * found_obj = (UAVObjHandle *) NULL;
+	struct UAVOData *obj;
+
+	if (!uavo_hash_overflow) {
+		obj = hashLookup(id);
+		if (obj)
+			return (UAVObjHandle) obj;
+
+		// Meta objects have the ID of their parent plus one
+		obj = hashLookup(id - 1);
+		if (obj && MetaObjectId(obj->id) == id)
+			return (UAVObjHandle) &(obj->metaObj);
+
+		return (UAVObjHandle) NULL;
+	}
+
+	// More objects than the table can hold, fall back to the list
+	UAVObjHandle found_obj = (UAVObjHandle) NULL;
 
-	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	// Look for object
+	obj = findByIdLocked(id);
+	if (obj) {
+		found_obj = (UAVObjHandle) obj;
+	} else {
+		obj = findByIdLocked(id - 1);
+		if (obj)
+			found_obj = (UAVObjHandle) &(obj->metaObj);
+	}
+
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return found_obj;
+}
+
+/**
+ * Walk the object list for a data object, the mutex must be held
+ * \param[in] id The data object ID
+ * \return The object or NULL if not found.
+ */
+static struct UAVOData *findByIdLocked(uint32_t id)
+{
 	struct UAVOData * tmp_obj;
+
 	LL_FOREACH(uavo_list, tmp_obj) {
-		if (tmp_obj->id == id) {
-			found_obj = (UAVObjHandle *)tmp_obj;
-			goto unlock_exit;
-		}
-		if (MetaObjectId(tmp_obj->id) == id) {
-			found_obj = (UAVObjHandle *)&(tmp_obj->metaObj);
-			goto unlock_exit;
+		if (tmp_obj->id == id)
+			return tmp_obj;
+	}
+
+	return NULL;
+}
+
+/**
+ * Add a data object to the ID hash table, the mutex must be held
+ * \param[in] obj The fully initialized object
+ */
+static void hashInsert(struct UAVOData *obj)
+{
+	uint32_t slot = obj->id % UAVO_HASH_SIZE;
+
+	for (uint32_t i = 0; i < UAVO_HASH_SIZE; i++) {
+		if (uavo_hash[slot] == NULL) {
+			// Everything in the object must be visible before the slot
+			UAVO_HASH_BARRIER();
+			uavo_hash[slot] = obj;
+			return;
 		}
+		slot = (slot + 1) % UAVO_HASH_SIZE;
 	}
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return found_obj;
+	uavo_hash_overflow = true;
+}
+
+/**
+ * Find a data object in the ID hash table, safe without the mutex
+ * \param[in] id The data object ID
+ * \return The object or NULL if not found.
+ */
+static struct UAVOData *hashLookup(uint32_t id)
+{
+	uint32_t slot = id % UAVO_HASH_SIZE;
+
+	for (uint32_t i = 0; i < UAVO_HASH_SIZE; i++) {
+		struct UAVOData *obj = uavo_hash[slot];
+		if (obj == NULL)
+			return NULL;
+		if (obj->id == id)
+			return obj;
+		slot = (slot + 1) % UAVO_HASH_SIZE;
+	}
+
+	return NULL;
 }
 
 /**
@@ -534,6 +799,67 @@ unlock_exit:
 	return instId;
 }
 
+/**
+ * Delete the last instance of a multi instance object. Readers walk the
+ * instance list without the mutex and may still hold the instance, so its
+ * storage is not freed but kept by the object and reused for the next
+ * instance it creates.
+ * \param[in] obj The object handle
+ * \return 0 if success or -1 if failure (instance 0 can not be deleted)
+ */
+int32_t UAVObjDeleteInstance(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+	if (UAVObjIsMetaobject(obj_handle) || UAVObjIsSingleInstance(obj_handle)) {
+		return -1;
+	}
+
+	struct UAVOMulti *uavo_multi = (struct UAVOMulti *) obj_handle;
+	int32_t rc = -1;
+
+	// Lock
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (uavo_multi->num_instances <= 1) {
+		goto unlock_exit;
+	}
+
+	// The pool is only created for objects that ever delete an instance
+	if (uavo_multi->free_instances == NULL) {
+		uavo_multi->free_instances = PIOS_Mempool_Create(
+			sizeof(struct UAVOMultiInstStorage) + uavo_multi->uavo.instance_size, 0);
+		if (uavo_multi->free_instances == NULL) {
+			goto unlock_exit;
+		}
+	}
+
+	// Hide the instance from lookups before unlinking it
+	uavo_multi->num_instances--;
+	UAVO_SEQ_BARRIER();
+
+	struct UAVOMultiInst *prev = &uavo_multi->instance0;
+	while (prev->next->next != NULL) {
+		prev = prev->next;
+	}
+	struct UAVOMultiInst *instEntry = prev->next;
+	prev->next = NULL;
+	UAVO_SEQ_BARRIER();
+
+	PIOS_Mempool_Free(uavo_multi->free_instances,
+		container_of(instEntry, struct UAVOMultiInstStorage, inst));
+
+	if (newUavObjInstanceCB) {
+		newUavObjInstanceCB(uavo_multi->uavo.id, uavo_multi->num_instances);
+	}
+
+	rc = 0;
+
+unlock_exit:
+	PIOS_Recursive_Mutex_Unlock(mutex);
+
+	return rc;
+}
+
 /**
  * Does this object contains a single instance or multiple instances?
  * \param[in] obj The object handle
@@ -579,6 +905,41 @@ bool UAVObjIsSettings(UAVObjHandle obj_handle)
 	return uavo_base->flags.isSettings;
 }
 
+/**
+ * Get and clear the chunks of an object that changed since the last call.
+ * Every UAVOBJ_DELTA_REFRESH calls all chunks are reported so that a
+ * receiver which missed a delta catches up again. There must only be one
+ * caller per object, normally the telemetry module.
+ * \param[in] obj The object handle
+ * \return The mask of dirty chunks, all chunks for meta and multi instance objects
+ */
+uint32_t UAVObjTakeDirtyChunks(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+
+	/* Recover the common object header */
+	struct UAVOBase * uavo_base = (struct UAVOBase *) obj_handle;
+
+	if (uavo_base->flags.isMeta || !uavo_base->flags.isSingle)
+		return dirtyChunkMask(UAVObjGetNumBytes(obj_handle));
+
+	struct UAVOSingle * uavo_single = (struct UAVOSingle *) uavo_base;
+	uint32_t dirty;
+
+	/* Writers set bits with the scheduler locked, see instanceWrite() */
+	PIOS_Thread_Scheduler_Suspend();
+	dirty = uavo_single->dirty;
+	uavo_single->dirty = 0;
+	PIOS_Thread_Scheduler_Resume();
+
+	if (++uavo_single->takes >= UAVOBJ_DELTA_REFRESH) {
+		uavo_single->takes = 0;
+		dirty = dirtyChunkMask(uavo_single->uavo.instance_size);
+	}
+
+	return dirty;
+}
+
 /**
  * Unpack an object from a byte array
  * \param[in] obj The object handle
@@ -591,16 +952,12 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
 	if (UAVObjIsMetaobject(obj_handle)) {
 		if (instId != 0) {
-			goto unlock_exit;
+			return -1;
 		}
-		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), dataIn, MetaNumBytes);
+		instanceWrite((struct UAVOBase *)obj_handle, MetaDataPtr((struct UAVOMeta *)obj_handle),
+				MetaNumBytes, dataIn, 0, MetaNumBytes);
 	} else {
 		struct UAVOData *obj;
 		InstanceHandle instEntry;
@@ -613,66 +970,121 @@ int32_t UAVObjUnpack(UAVObjHandle obj_handle, uint16_t instId,
 
 		// If the instance does not exist create it and any other instances before it
 		if (instEntry == NULL) {
-			instEntry = createInstance(obj, instId);
+			PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+			instEntry = getInstance(obj, instId);
 			if (instEntry == NULL) {
-				goto unlock_exit;
+				instEntry = createInstance(obj, instId);
+			}
+			PIOS_Recursive_Mutex_Unlock(mutex);
+			if (instEntry == NULL) {
+				return -1;
 			}
 		}
 		// Set the data
-		memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
+		instanceWrite(&obj->base, InstanceData(instEntry), obj->instance_size,
+				dataIn, 0, obj->instance_size);
 	}
 
 	// Fire event
 	sendEvent((struct UAVOBase*)obj_handle, instId, EV_UNPACKED);
-	rc = 0;
+	return 0;
+}
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+/**
+ * Check all objects of a set are single instance data objects
+ * \param[in] written Whether the set is written, single writer objects
+ * have their own writer then
+ */
+static bool isDataSet(const UAVObjHandle obj_handles[], uint8_t count, bool written)
+{
+	for (uint8_t i = 0; i < count; i++) {
+		const struct UAVOBase *uavo_base = (const struct UAVOBase *) obj_handles[i];
+
+		if (uavo_base == NULL || uavo_base->flags.isMeta || !uavo_base->flags.isSingle)
+			return false;
+		if (written && uavo_base->flags.isSingleWriter)
+			return false;
+	}
+
+	return true;
 }
 
 /**
- * Pack an object to a byte array
- * \param[in] obj The object handle
- * \param[in] instId The instance ID
- * \param[out] dataOut The byte array
- * \return 0 if success or -1 if failure
+ * Copy several single instance objects as they were at one point in time,
+ * no update of any of them falls in between the copies. Writers only hold
+ * the scheduler for their memcpy, so the copies are made with it locked.
+ * \param[in] obj_handles The objects
+ * \param[in] count The number of objects
+ * \param[out] dataOut Where the data of each object goes
+ * \param[out] seqOut The update counter of each object, changes with every
+ * update of it; NULL if not needed
+ * \return 0 if success or -1 if one of them is not a single instance data object
  */
-int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
+int32_t UAVObjPackMultiple(const UAVObjHandle obj_handles[], uint8_t count,
+		uint8_t * const dataOut[], uint16_t seqOut[])
 {
-	PIOS_Assert(obj_handle);
+	if (!isDataSet(obj_handles, count, false))
+		return -1;
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	PIOS_Thread_Scheduler_Suspend();
+	for (uint8_t i = 0; i < count; i++) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handles[i];
 
-	int32_t rc = -1;
+		/* A single writer preempted in its write still publishes the old copy */
+		instanceRead(&obj->base, InstanceData(getInstance(obj, 0)), obj->instance_size,
+				dataOut[i], 0, obj->instance_size);
+		if (seqOut != NULL)
+			seqOut[i] = obj->base.seq & ~1;
+	}
+	PIOS_Thread_Scheduler_Resume();
 
-	if (UAVObjIsMetaobject(obj_handle)) {
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
-	} else {
-		struct UAVOData *obj;
-		InstanceHandle instEntry;
+	return 0;
+}
 
-		// Cast handle to object
-		obj = (struct UAVOData *) obj_handle;
+/**
+ * Unpack several single instance objects so that a reader using
+ * UAVObjPackMultiple() sees either none or all of them updated. The events
+ * are only sent once all of them are written.
+ * \param[in] obj_handles The objects
+ * \param[in] count The number of objects
+ * \param[in] dataIn The data of each object
+ * \return 0 if success or -1 if one of them is not a single instance data
+ * object or is single writer
+ */
+int32_t UAVObjUnpackMultiple(const UAVObjHandle obj_handles[], uint8_t count,
+		const uint8_t * const dataIn[])
+{
+	if (!isDataSet(obj_handles, count, true))
+		return -1;
 
-		// Get the instance
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-		// Pack data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
+	/* One lock for all, it does not nest on every RTOS */
+	PIOS_Thread_Scheduler_Suspend();
+	for (uint8_t i = 0; i < count; i++) {
+		struct UAVOData *obj = (struct UAVOData *) obj_handles[i];
+
+		instanceWriteLocked(&obj->base, InstanceData(getInstance(obj, 0)), obj->instance_size,
+				dataIn[i], 0, obj->instance_size);
 	}
+	PIOS_Thread_Scheduler_Resume();
 
-	rc = 0;
+	for (uint8_t i = 0; i < count; i++)
+		sendEvent((struct UAVOBase *) obj_handles[i], 0, EV_UNPACKED);
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return 0;
+}
+
+/**
+ * Pack an object to a byte array
+ * \param[in] obj The object handle
+ * \param[in] instId The instance ID
+ * \param[out] dataOut The byte array
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjPack(UAVObjHandle obj_handle, uint16_t instId, uint8_t * dataOut)
+{
+	PIOS_Assert(obj_handle);
+
+	return UAVObjGetInstanceData(obj_handle, instId, dataOut);
 }
 
 #if defined(PIOS_INCLUDE_FASTHEAP)
@@ -706,9 +1118,8 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 		// Save the object to the filesystem
 		int32_t rc;
 #if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(uavobj_save_trampoline,
-			MetaDataPtr((struct UAVOMeta *)obj_handle),
-			UAVObjGetNumBytes(obj_handle));
+		instanceRead((struct UAVOBase *)obj_handle, MetaDataPtr((struct UAVOMeta *)obj_handle),
+				MetaNumBytes, uavobj_save_trampoline, 0, MetaNumBytes);
 
 		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
 					UAVObjGetID(obj_handle),
@@ -726,6 +1137,10 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 		if (rc != 0)
 			return -1;
 	} else {
+		// The published copy of single writer objects moves around
+		if (((struct UAVOBase *)obj_handle)->flags.isSingleWriter)
+			return -1;
+
 		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
 
 		if (instEntry == NULL)
@@ -737,9 +1152,9 @@ int32_t UAVObjSave(UAVObjHandle obj_handle, uint16_t instId)
 		// Save the object to the filesystem
 		int32_t rc;
 #if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(uavobj_save_trampoline,
-			InstanceData(instEntry),
-			UAVObjGetNumBytes(obj_handle));
+		instanceRead((struct UAVOBase *)obj_handle, InstanceData(instEntry),
+				UAVObjGetNumBytes(obj_handle), uavobj_save_trampoline, 0,
+				UAVObjGetNumBytes(obj_handle));
 
 		rc = PIOS_FLASHFS_ObjSave(pios_uavo_settings_fs_id,
 					UAVObjGetID(obj_handle),
@@ -807,10 +1222,14 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 			return -1;
 
 #if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), uavobj_load_trampoline, UAVObjGetNumBytes(obj_handle));
+		instanceWrite((struct UAVOBase *)obj_handle, MetaDataPtr((struct UAVOMeta *)obj_handle),
+				MetaNumBytes, uavobj_load_trampoline, 0, MetaNumBytes);
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
 	} else {
+		// The published copy of single writer objects moves around
+		if (((struct UAVOBase *)obj_handle)->flags.isSingleWriter)
+			return -1;
 
 		InstanceHandle instEntry = getInstance( (struct UAVOData *)obj_handle, instId);
 
@@ -837,7 +1256,9 @@ int32_t UAVObjLoad(UAVObjHandle obj_handle, uint16_t instId)
 			return -1;
 
 #if defined(PIOS_INCLUDE_FASTHEAP)
-		memcpy(InstanceData(instEntry), uavobj_load_trampoline, UAVObjGetNumBytes(obj_handle));
+		instanceWrite((struct UAVOBase *)obj_handle, InstanceData(instEntry),
+				UAVObjGetNumBytes(obj_handle), uavobj_load_trampoline, 0,
+				UAVObjGetNumBytes(obj_handle));
 #endif  /* PIOS_INCLUDE_FASTHEAP */
 
 	}
@@ -859,41 +1280,109 @@ int32_t UAVObjDeleteById(uint32_t obj_id, uint16_t inst_id)
 	return 0;
 }
 
+/**
+ * Hand the settings objects to PIOS_FLASHFS_ObjSaveBatch() one at a time.
+ * @param[in,out] ctx The next object of uavo_list to look at
+ */
+static int32_t saveSettingsNext(void *ctx, struct pios_flashfs_obj *fs_obj)
+{
+	struct UAVOData **next_obj = (struct UAVOData **)ctx;
+	struct UAVOData *obj = *next_obj;
+
+	while (obj && !UAVObjIsSettings(obj))
+		obj = obj->next;
+
+	if (obj == NULL)
+		return 0;
+
+	*next_obj = obj->next;
+
+	InstanceHandle instEntry = getInstance(obj, 0);
+	if (instEntry == NULL || InstanceData(instEntry) == NULL)
+		return -1;
+
+	fs_obj->obj_id = UAVObjGetID(obj);
+	fs_obj->obj_inst_id = 0;
+	fs_obj->obj_size = UAVObjGetNumBytes(obj);
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	instanceRead(&obj->base, InstanceData(instEntry), fs_obj->obj_size,
+			uavobj_save_trampoline, 0, fs_obj->obj_size);
+	fs_obj->obj_data = uavobj_save_trampoline;
+#else /* PIOS_INCLUDE_FASTHEAP */
+	fs_obj->obj_data = InstanceData(instEntry);
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+
+	return 1;
+}
+
 /**
  * Save all settings objects to the SD card.
+ * They are written in one batch, so either all of them are saved or none.
  * @return 0 if success or -1 if failure
  */
 int32_t UAVObjSaveSettings()
 {
-	struct UAVOData *obj;
-
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	int32_t rc = -1;
+	struct UAVOData *next_obj = uavo_list;
+	int32_t rc = PIOS_FLASHFS_ObjSaveBatch(pios_uavo_settings_fs_id,
+				saveSettingsNext, &next_obj);
 
-	// Save all settings objects
-	LL_FOREACH(uavo_list, obj) {
-		// Check if this is a settings object
-		if (UAVObjIsSettings(obj)) {
-			// Save object
-			if (UAVObjSave((UAVObjHandle) obj, 0) ==
-				-1) {
-				goto unlock_exit;
-			}
-		}
-	}
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return (rc == 0) ? 0 : -1;
+}
 
-	rc = 0;
+/**
+ * Pick where PIOS_FLASHFS_ObjLoadAll() puts an object it found, only
+ * instance 0 of the registered settings objects is loaded.
+ * @param[out] ctx The object being loaded
+ */
+static void loadSettingsBuffer(void *ctx, struct pios_flashfs_obj *fs_obj)
+{
+	if (fs_obj->obj_inst_id != 0)
+		return;
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	struct UAVOData *obj = (struct UAVOData *) UAVObjGetByID(fs_obj->obj_id);
+	if (obj == NULL || UAVObjIsMetaobject(obj) || !UAVObjIsSettings(obj))
+		return;
+
+	if (UAVObjGetNumBytes(obj) != fs_obj->obj_size)
+		return;
+
+	InstanceHandle instEntry = getInstance(obj, 0);
+	if (instEntry == NULL)
+		return;
+
+	*(struct UAVOData **)ctx = obj;
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	// Flash the CPU reads in place needs no DMA safe copy
+	if (fs_obj->obj_mapped)
+		fs_obj->obj_data = (uint8_t *)fs_obj->obj_mapped;
+	else
+		fs_obj->obj_data = uavobj_load_trampoline;
+#else /* PIOS_INCLUDE_FASTHEAP */
+	fs_obj->obj_data = InstanceData(instEntry);
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+}
+
+static void loadSettingsDone(void *ctx, const struct pios_flashfs_obj *fs_obj)
+{
+	struct UAVOData *obj = *(struct UAVOData **)ctx;
+
+#if defined(PIOS_INCLUDE_FASTHEAP)
+	instanceWrite(&obj->base, InstanceData(getInstance(obj, 0)), fs_obj->obj_size,
+			fs_obj->obj_data, 0, fs_obj->obj_size);
+#endif  /* PIOS_INCLUDE_FASTHEAP */
+
+	obj->base.flags.loadPending = true;
 }
 
 /**
  * Load all settings objects from the SD card.
- * @return 0 if success or -1 if failure
+ * The filesystem is read in one pass, objects missing from it keep their
+ * current values.
+ * @return 0 if every settings object was loaded or -1 if failure
  */
 int32_t UAVObjLoadSettings()
 {
@@ -902,25 +1391,27 @@ int32_t UAVObjLoadSettings()
 	// Get lock
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 
-	int32_t rc = -1;
+	struct UAVOData *loading = NULL;
+	int32_t rc = PIOS_FLASHFS_ObjLoadAll(pios_uavo_settings_fs_id,
+				loadSettingsBuffer, loadSettingsDone, &loading);
+	if (rc >= 0)
+		rc = 0;
 
-	// Load all settings objects
+	// Send the events once the filesystem is free again, listeners may use it
 	LL_FOREACH(uavo_list, obj) {
-		// Check if this is a settings object
-		if (UAVObjIsSettings(obj)) {
-			// Load object
-			if (UAVObjLoad((UAVObjHandle) obj, 0) ==
-				-1) {
-				goto unlock_exit;
-			}
+		if (!UAVObjIsSettings(obj))
+			continue;
+
+		if (obj->base.flags.loadPending) {
+			obj->base.flags.loadPending = false;
+			sendEvent(&obj->base, 0, EV_UNPACKED);
+		} else {
+			rc = -1;
 		}
 	}
 
-	rc = 0;
-
-unlock_exit:
 	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return (rc == 0) ? 0 : -1;
 }
 
 /**
@@ -1086,55 +1577,20 @@ int32_t UAVObjGetDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offs
 	return UAVObjGetInstanceDataField(obj_handle, 0, dataOut, offset, size);
 }
 
-/**
- * Set the data of a specific object instance
- * \param[in] obj The object handle
- * \param[in] instId The object instance ID
- * \param[in] dataIn The object's data structure
- * \return 0 if success or -1 if failure
- */
-int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
-			const void *dataIn)
-{
-	PIOS_Assert(obj_handle);
-
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
-	if (UAVObjIsMetaobject(obj_handle)) {
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle), dataIn, MetaNumBytes);
-	} else {
-		struct UAVOData *obj;
-		InstanceHandle instEntry;
-
-		// Cast to object info
-		obj = (struct UAVOData *) obj_handle;
-
-		// Check access level
-		if (UAVObjReadOnly(obj_handle)) {
-			goto unlock_exit;
-		}
-		// Get instance information
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-		// Set data
-		memcpy(InstanceData(instEntry), dataIn, obj->instance_size);
-	}
-
-	// Fire event
-	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
-	rc = 0;
-
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+/**
+ * Set the data of a specific object instance
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] dataIn The object's data structure
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
+			const void *dataIn)
+{
+	PIOS_Assert(obj_handle);
+
+	return UAVObjSetInstanceDataField(obj_handle, instId, dataIn, 0,
+			UAVObjGetNumBytes(obj_handle));
 }
 
 /**
@@ -1148,24 +1604,49 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	if (setInstanceDataField(obj_handle, instId, dataIn, offset, size) != 0)
+		return -1;
 
-	int32_t rc = -1;
+	// Fire event
+	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
+	return 0;
+}
+
+/**
+ * Set the data of a specific object instance without sending an event.
+ * Meant for writing many instances in one go, which are then announced
+ * at once with UAVObjInstanceUpdated(obj, UAVOBJ_ALL_INSTANCES).
+ * \param[in] obj The object handle
+ * \param[in] instId The object instance ID
+ * \param[in] dataIn The object's data structure
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetInstanceDataDeferred(UAVObjHandle obj_handle, uint16_t instId,
+			const void *dataIn)
+{
+	PIOS_Assert(obj_handle);
+
+	return setInstanceDataField(obj_handle, instId, dataIn, 0,
+			UAVObjGetNumBytes(obj_handle));
+}
 
+static int32_t setInstanceDataField(UAVObjHandle obj_handle, uint16_t instId,
+			const void *dataIn, uint32_t offset, uint32_t size)
+{
 	if (UAVObjIsMetaobject(obj_handle)) {
 		// Get instance information
 		if (instId != 0) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		// Check for overrun
 		if ((size + offset) > MetaNumBytes) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		// Set data
-		memcpy(MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, dataIn, size);
+		instanceWrite((struct UAVOBase *)obj_handle, MetaDataPtr((struct UAVOMeta *)obj_handle),
+				MetaNumBytes, dataIn, offset, size);
 	} else {
 		struct UAVOData * obj;
 		InstanceHandle instEntry;
@@ -1175,32 +1656,26 @@ int32_t UAVObjSetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, con
 
 		// Check access level
 		if (UAVObjReadOnly(obj_handle)) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		// Get instance information
 		instEntry = getInstance(obj, instId);
 		if (instEntry == NULL) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		// Check for overrun
 		if ((size + offset) > obj->instance_size) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		// Set data
-		memcpy(InstanceData(instEntry) + offset, dataIn, size);
+		instanceWrite(&obj->base, InstanceData(instEntry), obj->instance_size,
+				dataIn, offset, size);
 	}
 
-
-	// Fire event
-	sendEvent((struct UAVOBase *)obj_handle, instId, EV_UPDATED);
-	rc = 0;
-
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return 0;
 }
 
 /**
@@ -1215,39 +1690,8 @@ int32_t UAVObjGetInstanceData(UAVObjHandle obj_handle, uint16_t instId,
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
-	if (UAVObjIsMetaobject(obj_handle)) {
-		// Get instance information
-		if (instId != 0) {
-			goto unlock_exit;
-		}
-		// Set data
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle), MetaNumBytes);
-	} else {
-		struct UAVOData *obj;
-		InstanceHandle instEntry;
-
-		// Cast to object info
-		obj = (struct UAVOData *) obj_handle;
-
-		// Get instance information
-		instEntry = getInstance(obj, instId);
-		if (instEntry == NULL) {
-			goto unlock_exit;
-		}
-		// Set data
-		memcpy(dataOut, InstanceData(instEntry), obj->instance_size);
-	}
-
-	rc = 0;
-
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+	return UAVObjGetInstanceDataField(obj_handle, instId, dataOut, 0,
+			UAVObjGetNumBytes(obj_handle));
 }
 
 /**
@@ -1261,24 +1705,19 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
-	int32_t rc = -1;
-
 	if (UAVObjIsMetaobject(obj_handle)) {
 		// Get instance information
 		if (instId != 0) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		// Check for overrun
 		if ((size + offset) > MetaNumBytes) {
-			goto unlock_exit;
+			return -1;
 		}
 
-		// Set data
-		memcpy(dataOut, MetaDataPtr((struct UAVOMeta *)obj_handle) + offset, size);
+		instanceRead((struct UAVOBase *)obj_handle, MetaDataPtr((struct UAVOMeta *)obj_handle),
+				MetaNumBytes, dataOut, offset, size);
 	} else {
 		struct UAVOData * obj;
 		InstanceHandle instEntry;
@@ -1289,23 +1728,74 @@ int32_t UAVObjGetInstanceDataField(UAVObjHandle obj_handle, uint16_t instId, voi
 		// Get instance information
 		instEntry = getInstance(obj, instId);
 		if (instEntry == NULL) {
-			goto unlock_exit;
+			return -1;
 		}
 
 		// Check for overrun
 		if ((size + offset) > obj->instance_size) {
-			goto unlock_exit;
+			return -1;
 		}
-		
-		// Set data
-		memcpy(dataOut, InstanceData(instEntry) + offset, size);
+
+		instanceRead(&obj->base, InstanceData(instEntry), obj->instance_size,
+				dataOut, offset, size);
 	}
 
-	rc = 0;
+	return 0;
+}
 
-unlock_exit:
-	PIOS_Recursive_Mutex_Unlock(mutex);
-	return rc;
+/**
+ * Set data of a single instance data object.  The generated accessors of
+ * these objects call this directly, their offset and size are compile time
+ * constants from the object's own data structure so only debug builds
+ * check them.
+ * \param[in] obj The object handle
+ * \param[in] dataIn The new data
+ * \param[in] offset Position of the data in the object's data structure
+ * \param[in] size Number of bytes to set
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjSetSingleDataField(UAVObjHandle obj_handle, const void* dataIn, uint32_t offset, uint32_t size)
+{
+	PIOS_Assert(obj_handle);
+
+	struct UAVOData *obj = (struct UAVOData *)obj_handle;
+
+	PIOS_DEBUG_Assert(obj->base.flags.isSingle && !obj->base.flags.isMeta);
+	PIOS_DEBUG_Assert((size + offset) <= obj->instance_size);
+
+	// Check access level
+	if (UAVObjGetAccess(LinkedMetaDataPtr(obj)) == ACCESS_READONLY) {
+		return -1;
+	}
+
+	instanceWrite(&obj->base, ObjSingleInstanceDataOffset(obj), obj->instance_size,
+			dataIn, offset, size);
+
+	// Fire event
+	sendEvent(&obj->base, 0, EV_UPDATED);
+	return 0;
+}
+
+/**
+ * Get data of a single instance data object, see UAVObjSetSingleDataField()
+ * \param[in] obj The object handle
+ * \param[out] dataOut Where the data goes
+ * \param[in] offset Position of the data in the object's data structure
+ * \param[in] size Number of bytes to get
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjGetSingleDataField(UAVObjHandle obj_handle, void* dataOut, uint32_t offset, uint32_t size)
+{
+	PIOS_Assert(obj_handle);
+
+	struct UAVOData *obj = (struct UAVOData *)obj_handle;
+
+	PIOS_DEBUG_Assert(obj->base.flags.isSingle && !obj->base.flags.isMeta);
+	PIOS_DEBUG_Assert((size + offset) <= obj->instance_size);
+
+	instanceRead(&obj->base, ObjSingleInstanceDataOffset(obj), obj->instance_size,
+			dataOut, offset, size);
+	return 0;
 }
 
 /**
@@ -1323,11 +1813,8 @@ int32_t UAVObjSetMetadata(UAVObjHandle obj_handle, const UAVObjMetadata * dataIn
 		return -1;
 	}
 
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	UAVObjSetData((UAVObjHandle) MetaObjectPtr((struct UAVOData *)obj_handle), dataIn);
 
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return 0;
 }
 
@@ -1341,9 +1828,6 @@ int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata * dataOut)
 {
 	PIOS_Assert(obj_handle);
 
-	// Lock
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-
 	// Get metadata
 	if (UAVObjIsMetaobject(obj_handle)) {
 		memcpy(dataOut, &defMetadata, sizeof(UAVObjMetadata));
@@ -1352,8 +1836,6 @@ int32_t UAVObjGetMetadata(UAVObjHandle obj_handle, UAVObjMetadata * dataOut)
 			dataOut);
 	}
 
-	// Unlock
-	PIOS_Recursive_Mutex_Unlock(mutex);
 	return 0;
 }
 
@@ -1518,11 +2000,90 @@ int32_t UAVObjConnectQueueThrottled(UAVObjHandle obj_handle,
 	PIOS_Assert(queue);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, queue, 0, eventMask, interval);
+	res = connectObj(obj_handle, queue, 0, eventMask, interval, EV_PRIORITY_NORMAL, false);
+	PIOS_Recursive_Mutex_Unlock(mutex);
+	return res;
+}
+
+/**
+ * Connect an event queue to the object like UAVObjConnectQueueThrottled(), but
+ * keep at most one EV_UPDATED or EV_UNPACKED event per instance in the queue.
+ * Further updates are dropped until the consumer takes the pending event out
+ * with UAVObjQueueReceive(), so it always reads the latest data and a slow
+ * consumer can not overflow the queue.
+ * \param[in] obj The object handle
+ * \param[in] queue The event queue, must be read with UAVObjQueueReceive()
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \param[in] interval The interval at which to throttle updates; 0 is unthrottled
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectQueueCoalesced(UAVObjHandle obj_handle,
+		struct pios_queue *queue, uint8_t eventMask, uint16_t interval)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(queue);
+	int32_t res;
+	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
+	res = connectObj(obj_handle, queue, 0, eventMask, interval, EV_PRIORITY_NORMAL, true);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
 
+/**
+ * Receive an event from a queue, marking it as no longer pending if the
+ * queue is connected with UAVObjConnectQueueCoalesced()
+ * \param[in] queue The event queue
+ * \param[out] ev The received event
+ * \param[in] timeout_ms Time to wait for an event
+ * \return true if an event was received
+ */
+bool UAVObjQueueReceive(struct pios_queue *queue, UAVObjEvent *ev, uint32_t timeout_ms)
+{
+	if (PIOS_Queue_Receive(queue, ev, timeout_ms) != true)
+		return false;
+
+	if (ev->obj == NULL || (ev->event & EV_MASK_COALESCED) == 0 ||
+			ev->instId >= UAVO_COALESCE_INSTANCES)
+		return true;
+
+	struct ObjectEventEntry *event;
+	LL_FOREACH(((struct UAVOBase *) ev->obj)->next_event, event) {
+		if (event->queue == queue && event->coalesce) {
+			PIOS_Thread_Scheduler_Suspend();
+			event->pending &= ~(1 << ev->instId);
+			PIOS_Thread_Scheduler_Resume();
+			break;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Get the number of events for the object that were lost because the queue
+ * was full.  Only throttled connections keep this count, it restarts when
+ * the connection is made or updated.
+ * \param[in] obj The object handle
+ * \param[in] queue The event queue
+ * \return the number of lost events, saturates at UINT16_MAX
+ */
+uint16_t UAVObjQueueDropped(UAVObjHandle obj_handle, struct pios_queue *queue)
+{
+	PIOS_Assert(obj_handle);
+	PIOS_Assert(queue);
+
+	struct ObjectEventEntry *event;
+	LL_FOREACH(((struct UAVOBase *) obj_handle)->next_event, event) {
+		if (event->queue == queue && event->cb == 0) {
+			if (event->hasThrottle)
+				return ((struct ObjectEventEntryThrottled *) event)->dropped;
+			break;
+		}
+	}
+
+	return 0;
+}
+
 int32_t UAVObjConnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue,
 		uint8_t eventMask) {
 	return UAVObjConnectQueueThrottled(obj_handle, queue, eventMask, 0);
@@ -1558,11 +2119,30 @@ int32_t UAVObjDisconnectQueue(UAVObjHandle obj_handle, struct pios_queue *queue)
  */
 int32_t UAVObjConnectCallbackThrottled(UAVObjHandle obj_handle, UAVObjEventCallback cb,
 			uint8_t eventMask, uint16_t interval)
+{
+	return UAVObjConnectCallbackPriority(obj_handle, cb, eventMask, interval,
+			EV_PRIORITY_NORMAL);
+}
+
+/**
+ * Connect an event callback to the object and run it from the event task of
+ * the given priority class. Reconnecting an already connected callback also
+ * moves it to the new priority class.
+ * \param[in] obj The object handle
+ * \param[in] cb The event callback
+ * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
+ * \param[in] interval The interval at which to throttle updates; 0 is unthrottled
+ * \param[in] priority The event dispatcher priority class the callback runs in
+ * \return 0 if success or -1 if failure
+ */
+int32_t UAVObjConnectCallbackPriority(UAVObjHandle obj_handle, UAVObjEventCallback cb,
+			uint8_t eventMask, uint16_t interval, UAVObjEventPriority priority)
 {
 	PIOS_Assert(obj_handle);
+	PIOS_Assert(priority < EV_PRIORITY_NUM);
 	int32_t res;
 	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
-	res = connectObj(obj_handle, 0, cb, eventMask, interval);
+	res = connectObj(obj_handle, 0, cb, eventMask, interval, priority, false);
 	PIOS_Recursive_Mutex_Unlock(mutex);
 	return res;
 }
@@ -1608,9 +2188,7 @@ void UAVObjRequestUpdate(UAVObjHandle obj_handle)
 void UAVObjRequestInstanceUpdate(UAVObjHandle obj_handle, uint16_t instId)
 {
 	PIOS_Assert(obj_handle);
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	sendEvent((struct UAVOBase *) obj_handle, instId, EV_UPDATE_REQ);
-	PIOS_Recursive_Mutex_Unlock(mutex);
 }
 
 /**
@@ -1630,9 +2208,7 @@ void UAVObjUpdated(UAVObjHandle obj_handle)
 void UAVObjInstanceUpdated(UAVObjHandle obj_handle, uint16_t instId)
 {
 	PIOS_Assert(obj_handle);
-	PIOS_Recursive_Mutex_Lock(mutex, PIOS_MUTEX_TIMEOUT_MAX);
 	sendEvent((struct UAVOBase *) obj_handle, instId, EV_UPDATED_MANUAL);
-	PIOS_Recursive_Mutex_Unlock(mutex);
 }
 
 /**
@@ -1660,6 +2236,7 @@ void UAVObjIterate(void (*iterator) (UAVObjHandle obj))
 
 /**
  * Send a triggered event to all event queues registered on the object.
+ * Does not need the mutex, entries are never freed while linked.
  */
 static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			UAVObjEventType triggered_event)
@@ -1671,6 +2248,8 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 		.instId = instId,
 	};
 
+	PIOS_TRACE(PIOS_TRACE_UAVO_EVENT, (triggered_event << 8) | UAVObjGetIndex(msg.obj));
+
 	// Go through each object and push the event message in the queue (if event is activated for the queue)
 	struct ObjectEventEntry *event;
 	LL_FOREACH(obj->next_event, event) {
@@ -1692,8 +2271,32 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 
 			// Send to queue if a valid queue is registered
 			if (event->queue) {
+				uint16_t coalesced = 0;
+				bool pending = false;
+
+				// Skip the event if an update for this instance is still queued
+				if (event->coalesce && (triggered_event & EV_MASK_COALESCED) &&
+						instId < UAVO_COALESCE_INSTANCES) {
+					coalesced = 1 << instId;
+					PIOS_Thread_Scheduler_Suspend();
+					pending = (event->pending & coalesced) != 0;
+					event->pending |= coalesced;
+					PIOS_Thread_Scheduler_Resume();
+				}
+
 				// will not block
-				if (PIOS_Queue_Send(event->queue, &msg, 0) != true) {
+				if (!pending && PIOS_Queue_Send(event->queue, &msg, 0) != true) {
+					if (coalesced) {
+						PIOS_Thread_Scheduler_Suspend();
+						event->pending &= ~coalesced;
+						PIOS_Thread_Scheduler_Resume();
+					}
+					if (event->hasThrottle) {
+						struct ObjectEventEntryThrottled *throtInfo =
+							(struct ObjectEventEntryThrottled *) event;
+						if (throtInfo->dropped < UINT16_MAX)
+							++throtInfo->dropped;
+					}
 					stats.lastQueueErrorID = UAVObjGetID(obj);
 					++stats.eventQueueErrors;
 				}
@@ -1702,7 +2305,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
 			// Invoke callback (from event task) if a valid one is registered
 			if (event->cb) {
 				// invoke callback from the event task, will not block
-				if (EventCallbackDispatch(&msg, event->cb) != 0) {
+				if (EventCallbackDispatchPriority(&msg, event->cb, event->priority) != 0) {
 					++stats.eventCallbackErrors;
 					stats.lastCallbackErrorID = UAVObjGetID(obj);
 				}
@@ -1718,6 +2321,7 @@ static int32_t sendEvent(struct UAVOBase * obj, uint16_t instId,
  */
 static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 {
+	struct UAVOMultiInstStorage *storage;
 	struct UAVOMultiInst *instEntry;
 
 	/* Don't allow more than one instance for single instance objects */
@@ -1743,12 +2347,22 @@ static InstanceHandle createInstance(struct UAVOData * obj, uint16_t instId)
 		}
 	}
 
-	/* Create the actual instance */
-	instEntry = (struct UAVOMultiInst *) PIOS_malloc_no_dma(sizeof(struct UAVOMultiInst)+obj->instance_size);
-	if (!instEntry)
+	/* Create the actual instance, in the storage of a deleted one if there is any */
+	storage = NULL;
+	if (((struct UAVOMulti*)obj)->free_instances)
+		storage = PIOS_Mempool_Alloc(((struct UAVOMulti*)obj)->free_instances);
+	if (!storage)
+		storage = (struct UAVOMultiInstStorage *) allocStorage(0, sizeof(struct UAVOMultiInstStorage)+obj->instance_size);
+	if (!storage)
 		return NULL;
+	instEntry = &storage->inst;
 	memset(InstanceDataOffset(instEntry), 0, obj->instance_size);
+	instEntry->next = NULL;
+
+	// Publish the cleared instance before readers can reach it
+	UAVO_SEQ_BARRIER();
 	LL_APPEND(( (struct UAVOMulti*)obj )->instance0.next, instEntry);
+	UAVO_SEQ_BARRIER();
 
 	( (struct UAVOMulti*)obj )->num_instances++;
 
@@ -1807,6 +2421,146 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
 	}
 }
 
+/**
+ * Copy data into an object instance. Single writer objects fill their
+ * spare copy and then publish it, all others copy in place with the
+ * scheduler locked so two writers of one object can not interleave.
+ * Chunks the write actually changes are marked dirty for delta telemetry.
+ * \param[in] obj The object the instance belongs to
+ * \param[in] instData The instance data (the first copy for single writer objects)
+ * \param[in] instSize The size of one copy of the instance data
+ */
+static void instanceWrite(struct UAVOBase *obj, void *instData, uint32_t instSize,
+			const void *dataIn, uint32_t offset, uint32_t size)
+{
+	uint8_t *data = (uint8_t *) instData;
+
+	if (obj->flags.isSingleWriter) {
+		uint16_t seq = obj->seq;
+		uint8_t *cur = data + ((seq >> 1) & 1) * instSize;
+		uint8_t *next = data + (((seq >> 1) + 1) & 1) * instSize;
+
+		/* Only single instance data objects are sent as deltas */
+		if (obj->flags.isSingle && !obj->flags.isMeta) {
+			uint32_t changed = changedChunks(cur, dataIn, instSize, offset, size);
+			if (changed) {
+				PIOS_Thread_Scheduler_Suspend();
+				((struct UAVOSingle *) obj)->dirty |= changed;
+				PIOS_Thread_Scheduler_Resume();
+			}
+		}
+
+		obj->seq = seq + 1;
+		UAVO_SEQ_BARRIER();
+		if (size != instSize)
+			memcpy(next, cur, instSize);
+		memcpy(next + offset, dataIn, size);
+		UAVO_SEQ_BARRIER();
+		obj->seq = seq + 2;
+		return;
+	}
+
+	PIOS_Thread_Scheduler_Suspend();
+	instanceWriteLocked(obj, instData, instSize, dataIn, offset, size);
+	PIOS_Thread_Scheduler_Resume();
+}
+
+/**
+ * Copy data in place into an instance of an object that is not single
+ * writer, the scheduler must be locked
+ */
+static void instanceWriteLocked(struct UAVOBase *obj, void *instData, uint32_t instSize,
+			const void *dataIn, uint32_t offset, uint32_t size)
+{
+	uint8_t *data = (uint8_t *) instData;
+
+	if (obj->flags.isSingle && !obj->flags.isMeta)
+		((struct UAVOSingle *) obj)->dirty |= changedChunks(data, dataIn, instSize, offset, size);
+
+	obj->seq++;
+	UAVO_SEQ_BARRIER();
+	memcpy(data + offset, dataIn, size);
+	UAVO_SEQ_BARRIER();
+	obj->seq++;
+}
+
+/**
+ * Get the mask with one bit set for every dirty chunk of an instance
+ */
+static uint32_t dirtyChunkMask(uint32_t instSize)
+{
+	if (instSize == 0)
+		return 0;
+
+	uint32_t chunk = UAVObjDirtyChunkSize(instSize);
+	uint32_t num_chunks = (instSize + chunk - 1) / chunk;
+
+	return (num_chunks >= UAVOBJ_DIRTY_CHUNKS) ? 0xFFFFFFFF : ((1UL << num_chunks) - 1);
+}
+
+/**
+ * Compare a write against the current instance data
+ * \param[in] cur The current instance data
+ * \param[in] dataIn The data about to be written at offset
+ * \return The mask of the chunks the write changes
+ */
+static uint32_t changedChunks(const uint8_t *cur, const void *dataIn, uint32_t instSize,
+			uint32_t offset, uint32_t size)
+{
+	const uint8_t *in = (const uint8_t *) dataIn;
+	uint32_t chunk = UAVObjDirtyChunkSize(instSize);
+	uint32_t end = offset + size;
+	uint32_t mask = 0;
+
+	for (uint32_t pos = offset; pos < end; ) {
+		uint32_t idx = pos / chunk;
+		uint32_t chunk_end = (idx + 1) * chunk;
+
+		if (chunk_end > end)
+			chunk_end = end;
+		if (memcmp(cur + pos, in + (pos - offset), chunk_end - pos))
+			mask |= 1UL << idx;
+		pos = chunk_end;
+	}
+
+	return mask;
+}
+
+/**
+ * Copy data out of an object instance without locking, again if a writer
+ * changed it meanwhile
+ * \param[in] obj The object the instance belongs to
+ * \param[in] instData The instance data (the first copy for single writer objects)
+ * \param[in] instSize The size of one copy of the instance data
+ */
+static void instanceRead(struct UAVOBase *obj, const void *instData, uint32_t instSize,
+			void *dataOut, uint32_t offset, uint32_t size)
+{
+	const uint8_t *data = (const uint8_t *) instData;
+	uint16_t seq;
+
+	if (obj->flags.isSingleWriter) {
+		/*
+		 * The published copy is only overwritten once a second write
+		 * starts, so a preempted writer never makes the reader wait.
+		 */
+		do {
+			seq = obj->seq;
+			UAVO_SEQ_BARRIER();
+			memcpy(dataOut, data + ((seq >> 1) & 1) * instSize + offset, size);
+			UAVO_SEQ_BARRIER();
+		} while ((uint16_t) (obj->seq - (seq & ~1)) > 2);
+		return;
+	}
+
+	do {
+		seq = obj->seq;
+		UAVO_SEQ_BARRIER();
+		memcpy(dataOut, data + offset, size);
+		UAVO_SEQ_BARRIER();
+	} while ((seq & 1) || obj->seq != seq);
+}
+
 /**
  * Connect an event queue to the object, if the queue is already connected then the event mask is only updated.
  * \param[in] obj The object handle
@@ -1814,11 +2568,13 @@ static InstanceHandle getInstance(struct UAVOData * obj, uint16_t instId)
  * \param[in] cb The event callback
  * \param[in] eventMask The event mask, if EV_MASK_ALL_UPDATES then all events are enabled (e.g. EV_UPDATED | EV_UPDATED_MANUAL)
  * \param[in] interval The interval at which to throttle updates; 0 is unthrottled
+ * \param[in] priority The event dispatcher priority class for callbacks
+ * \param[in] coalesce Keep at most one update event per instance in the queue
  * \return 0 if success or -1 if failure
  */
 static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 			UAVObjEventCallback cb, uint8_t eventMask,
-			uint16_t interval)
+			uint16_t interval, UAVObjEventPriority priority, bool coalesce)
 {
 	struct ObjectEventEntry *event;
 	struct ObjectEventEntryThrottled *throttled;
@@ -1828,8 +2584,10 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	obj = (struct UAVOBase *) obj_handle;
 	LL_FOREACH(obj->next_event, event) {
 		if (event->queue == queue && event->cb == cb) {
-			// Already connected, update event mask and throttling (if possible)
+			// Already connected, update event mask, priority and throttling (if possible)
 			event->eventMask = eventMask;
+			event->priority = priority;
+			event->coalesce = coalesce;
 			if (event->hasThrottle) {
 				if (interval == 0) {
 					event->hasThrottle = 0;
@@ -1837,6 +2595,7 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 				else {
 					throttled = (struct ObjectEventEntryThrottled *) event;
 					throttled->interval = interval;
+					throttled->dropped = 0;
 				}
 				return 0;
 			}
@@ -1869,6 +2628,9 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	event->queue = queue;
 	event->cb = cb;
 	event->eventMask = eventMask;
+	event->priority = priority;
+	event->coalesce = coalesce;
+	event->pending = 0;
 	event->hasThrottle = 0;
 
 	if (interval) {
@@ -1877,8 +2639,11 @@ static int32_t connectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 
 		throttled->interval = interval;
 		throttled->due = PIOS_Thread_Systime() + randomize_int(throttled->interval);
+		throttled->dropped = 0;
 	}
 
+	// Publish the entry before sendEvent() can reach it
+	UAVO_SEQ_BARRIER();
 	LL_APPEND(obj->next_event, event);
 
 	// Done
@@ -1903,8 +2668,8 @@ static int32_t disconnectObj(UAVObjHandle obj_handle, struct pios_queue *queue,
 	LL_FOREACH(obj->next_event, event) {
 		if ((event->queue == queue
 				&& event->cb == cb)) {
+			// Not freed, sendEvent() may be walking past it right now
 			LL_DELETE(obj->next_event, event);
-			PIOS_free(event);
 			return 0;
 		}
 	}
@@ -1988,6 +2753,24 @@ uint32_t UAVObjIDByIndex(uint8_t index)
 	return 0;
 }
 
+/**
+ * Get the index of an object, this is the inverse of UAVObjIDByIndex().
+ * Objects are only ever appended to the list so the index of an object
+ * does not change once it is registered.
+ * \param[in] obj_handle The object handle
+ * \return the index, or UAVOBJ_NO_INDEX for metaobjects and objects past
+ * the range of a byte
+ */
+uint8_t UAVObjGetIndex(UAVObjHandle obj_handle)
+{
+	PIOS_Assert(obj_handle);
+
+	if (UAVObjIsMetaobject(obj_handle))
+		return UAVOBJ_NO_INDEX;
+
+	return ((struct UAVOData *) obj_handle)->index;
+}
+
 /**
  * Registers a new UAVO instance created callback
  */
@@ -33,6 +33,9 @@
 
 // Public types
 typedef int32_t (*UAVTalkOutputStream)(uint8_t* data, int32_t length);
+//! Optional output path that lets packets be written in place into the output buffer
+typedef uint8_t* (*UAVTalkReserveStream)(uint16_t length);
+typedef int32_t (*UAVTalkCommitStream)(uint16_t length);
 
 //! Tracking statistics for a UAVTalk connection
 typedef struct {
@@ -48,20 +51,31 @@ typedef struct {
 
 typedef void* UAVTalkConnection;
 
+//! Most objects sent or applied together in one snapshot
+#define UAVTALK_SNAPSHOT_MAX_OBJECTS 8
+
 typedef enum {UAVTALK_STATE_ERROR=0, UAVTALK_STATE_SYNC, UAVTALK_STATE_TYPE, UAVTALK_STATE_SIZE, UAVTALK_STATE_OBJID, UAVTALK_STATE_INSTID, UAVTALK_STATE_TIMESTAMP, UAVTALK_STATE_DATA, UAVTALK_STATE_CS, UAVTALK_STATE_COMPLETE} UAVTalkRxState;
 
 // Public functions
 UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream);
 int32_t UAVTalkSetOutputStream(UAVTalkConnection connection, UAVTalkOutputStream outputStream);
 UAVTalkOutputStream UAVTalkGetOutputStream(UAVTalkConnection connection);
+int32_t UAVTalkSetReserveStream(UAVTalkConnection connection, UAVTalkReserveStream reserveStream, UAVTalkCommitStream commitStream);
 int32_t UAVTalkSendObject(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
 int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId, uint8_t acked, int32_t timeoutMs);
+int32_t UAVTalkSendObjectDelta(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
+int32_t UAVTalkSendObjectBundled(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
+int32_t UAVTalkFlushBundle(UAVTalkConnection connectionHandle);
+int32_t UAVTalkSendSnapshot(UAVTalkConnection connectionHandle, const UAVObjHandle objs[], uint8_t count, uint16_t seqs[]);
 int32_t UAVTalkSendObjectRequest(UAVTalkConnection connection, UAVObjHandle obj, uint16_t instId, int32_t timeoutMs);
 int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId);
 int32_t UAVTalkSendNack(UAVTalkConnection connectionHandle, uint32_t objId);
 int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_t len);
+bool UAVTalkIsDeferrable(const uint8_t *buf, uint16_t len);
 UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connection, uint8_t rxbyte);
 UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connection, uint8_t rxbyte);
+UAVTalkRxState UAVTalkProcessInputBufferQuiet(UAVTalkConnection connection, const uint8_t *buf, uint16_t len, uint16_t *consumed);
+int32_t UAVTalkProcessInputBuffer(UAVTalkConnection connection, const uint8_t *buf, uint16_t len);
 UAVTalkRxState UAVTalkRelayInputStream(UAVTalkConnection connectionHandle, uint8_t rxbyte);
 int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnection outConnectionHandle);
 int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle);
@@ -70,6 +84,7 @@ void UAVTalkResetStats(UAVTalkConnection connection);
 void UAVTalkGetLastTimestamp(UAVTalkConnection connection, uint16_t *timestamp);
 uint32_t UAVTalkGetPacketObjId(UAVTalkConnection connection);
 uint32_t UAVTalkGetPacketInstId(UAVTalkConnection connection);
+void UAVTalkGetLastSnapshot(UAVTalkConnection connection, uint32_t *version, uint32_t *timeMs);
 
 #endif // UAVTALK_H
 /**
@@ -57,12 +57,36 @@ typedef struct {
 } uavtalk_max_header;
 #define UAVTALK_MAX_HEADER_LENGTH       sizeof(uavtalk_max_header)
 
+//! Delta payloads start with the mask of the chunks that follow
+typedef uint32_t uavtalk_delta_mask;
+#define UAVTALK_DELTA_MASK_LENGTH       sizeof(uavtalk_delta_mask)
+
+//! Bundle payloads are a list of single instance objects, each behind this header
+typedef struct {
+	uint32_t objId;
+	uint8_t  size;
+} __attribute__((packed)) uavtalk_bundle_entry;
+#define UAVTALK_BUNDLE_ENTRY_LENGTH     sizeof(uavtalk_bundle_entry)
+
+//! Snapshot payloads start with the time their objects were copied, in ms,
+//! followed by the objects like in a bundle
+typedef uint32_t uavtalk_snapshot_time;
+#define UAVTALK_SNAPSHOT_TIME_LENGTH    sizeof(uavtalk_snapshot_time)
+
+//! Answers to UAVTALK_TYPE_OBJ_CRC requests carry the CRC32 of the packed instance
+typedef uint32_t uavtalk_obj_crc;
+#define UAVTALK_OBJ_CRC_LENGTH          sizeof(uavtalk_obj_crc)
+
 typedef uint8_t uavtalk_checksum;
 #define UAVTALK_CHECKSUM_LENGTH	        sizeof(uavtalk_checksum)
 #define UAVTALK_MAX_PAYLOAD_LENGTH      (UAVOBJECTS_LARGEST + 1)
 #define UAVTALK_MIN_PACKET_LENGTH       UAVTALK_MAX_HEADER_LENGTH + UAVTALK_CHECKSUM_LENGTH
 #define UAVTALK_MAX_PACKET_LENGTH       UAVTALK_MIN_PACKET_LENGTH + UAVTALK_MAX_PAYLOAD_LENGTH
 
+//! Larger objects are not worth bundling, they are sent on their own
+#define UAVTALK_BUNDLE_MAX_OBJECT       48
+#define UAVTALK_BUNDLE_MAX_PAYLOAD      ((UAVTALK_MAX_PAYLOAD_LENGTH - 1) < 160 ? (UAVTALK_MAX_PAYLOAD_LENGTH - 1) : 160)
+
 //! State information for the UAVTalk parser
 typedef struct {
     UAVObjHandle obj;
@@ -76,6 +100,7 @@ typedef struct {
     uint8_t cs;
 	uint16_t timestamp;
     int32_t rxCount;
+    const uint8_t *rxData;  // payload, in rxBuffer or still in the received block
     UAVTalkRxState state;
     uint16_t rxPacketLength;
 } UAVTalkInputProcessor;
@@ -84,6 +109,8 @@ typedef struct {
 typedef struct {
     uint8_t canari;
     UAVTalkOutputStream outStream;
+    UAVTalkReserveStream reserveStream;
+    UAVTalkCommitStream commitStream;
     struct pios_recursive_mutex *lock;
     struct pios_recursive_mutex *transLock;
     struct pios_semaphore *respSema;
@@ -94,6 +121,11 @@ typedef struct {
     uint8_t *rxBuffer;
     uint32_t txSize;
     uint8_t *txBuffer;
+    uint8_t *bundleBuffer;
+    uint16_t bundleLength;
+    uint32_t txSnapshotVersion;
+    uint32_t rxSnapshotVersion;
+    uint32_t rxSnapshotTime;
 } UAVTalkConnectionData;
 
 #define UAVTALK_CANARI         0xCA
@@ -108,8 +140,13 @@ typedef struct {
 #define UAVTALK_TYPE_OBJ_ACK   (UAVTALK_TYPE_VER | 0x02)
 #define UAVTALK_TYPE_ACK       (UAVTALK_TYPE_VER | 0x03)
 #define UAVTALK_TYPE_NACK      (UAVTALK_TYPE_VER | 0x04)
+#define UAVTALK_TYPE_OBJ_DELTA (UAVTALK_TYPE_VER | 0x05)
+#define UAVTALK_TYPE_OBJ_BUNDLE (UAVTALK_TYPE_VER | 0x06)
+#define UAVTALK_TYPE_OBJ_CRC   (UAVTALK_TYPE_VER | 0x07)
 #define UAVTALK_TYPE_OBJ_TS       (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ)
 #define UAVTALK_TYPE_OBJ_ACK_TS   (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_ACK)
+//! A bundle of objects copied at one time, the object id field is the version
+#define UAVTALK_TYPE_OBJ_SNAPSHOT (UAVTALK_TIMESTAMPED | UAVTALK_TYPE_OBJ_BUNDLE)
 
 //macros
 #define CHECKCONHANDLE(handle,variable,failcommand) \
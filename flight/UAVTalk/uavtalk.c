@@ -42,8 +42,15 @@
 static int32_t objectTransaction(UAVTalkConnectionData *connection, UAVObjHandle objectId, uint16_t instId, uint8_t type, int32_t timeout);
 static int32_t sendObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
 static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId, uint8_t type);
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static int32_t sendBundledObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static int32_t flushBundle(UAVTalkConnectionData *connection);
 static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId);
-static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length);
+static int32_t sendObjectCrc(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
+static void packObjectHeader(UAVObjHandle obj, uint8_t type, uint8_t *buf);
+static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, const uint8_t* data, int32_t length);
+static int32_t receiveBundle(const uint8_t* data, int32_t length);
+static int32_t receiveSnapshot(UAVTalkConnectionData *connection, uint32_t version, const uint8_t* data, int32_t length);
 static void updateAck(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId);
 
 /**
@@ -62,6 +69,8 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	connection->iproc.rxPacketLength = 0;
 	connection->iproc.state = UAVTALK_STATE_SYNC;
 	connection->outStream = outputStream;
+	connection->reserveStream = NULL;
+	connection->commitStream = NULL;
 	connection->lock = PIOS_Recursive_Mutex_Create();
 	PIOS_Assert(connection->lock != NULL);
 	connection->transLock = PIOS_Recursive_Mutex_Create();
@@ -69,8 +78,15 @@ UAVTalkConnection UAVTalkInitialize(UAVTalkOutputStream outputStream)
 	// allocate buffers
 	connection->rxBuffer = PIOS_malloc(UAVTALK_MAX_PACKET_LENGTH);
 	if (!connection->rxBuffer) return 0;
+	connection->iproc.rxData = connection->rxBuffer;
 	connection->txBuffer = PIOS_malloc(UAVTALK_MAX_PACKET_LENGTH);
 	if (!connection->txBuffer) return 0;
+	// the bundle buffer is only allocated once something is bundled
+	connection->bundleBuffer = NULL;
+	connection->bundleLength = 0;
+	connection->txSnapshotVersion = 0;
+	connection->rxSnapshotVersion = 0;
+	connection->rxSnapshotTime = 0;
 	connection->respSema = PIOS_Semaphore_Create();
 	PIOS_Semaphore_Take(connection->respSema, 0); // reset to zero
 	UAVTalkResetStats( (UAVTalkConnection) connection );
@@ -103,6 +119,30 @@ int32_t UAVTalkSetOutputStream(UAVTalkConnection connectionHandle, UAVTalkOutput
 
 }
 
+/**
+ * Set the functions used to write packets in place into the output buffer.
+ * When set, objects are serialized straight into the space returned by
+ * reserveStream and handed over with commitStream. If no space can be
+ * reserved the packet goes through the output stream as usual.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] reserveStream Returns room for a packet of the given length or NULL
+ * \param[in] commitStream Sends the given number of bytes written to the reserved room
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSetReserveStream(UAVTalkConnection connectionHandle, UAVTalkReserveStream reserveStream, UAVTalkCommitStream commitStream)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	connection->reserveStream = reserveStream;
+	connection->commitStream = commitStream;
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
 /**
  * Get current output stream
  * \param[in] connection UAVTalkConnection to be used
@@ -166,6 +206,20 @@ void UAVTalkGetLastTimestamp(UAVTalkConnection connectionHandle, uint16_t *times
 	*timestamp = iproc->timestamp;
 }
 
+/**
+ * Accessor method to get the version and the sender's time of the last
+ * snapshot applied, both 0 before the first one, so the age of offboard
+ * setpoints can be checked
+ */
+void UAVTalkGetLastSnapshot(UAVTalkConnection connectionHandle, uint32_t *version, uint32_t *timeMs)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return);
+
+	*version = connection->rxSnapshotVersion;
+	*timeMs = connection->rxSnapshotTime;
+}
+
 
 /**
  * Request an update for the specified object, on success the object data would have been
@@ -234,6 +288,187 @@ int32_t UAVTalkSendObjectTimestamped(UAVTalkConnection connectionHandle, UAVObjH
 	}
 }
 
+/**
+ * Send only the parts of an object that changed since its last delta.
+ * Objects for which a delta would not be smaller are sent in full, an
+ * unchanged object is sent as a delta without chunks so the receiver
+ * still sees the update. Deltas are never acked.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectDelta(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+    CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (instId == UAVOBJ_ALL_INSTANCES)
+		return -1;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t ret = sendDeltaObject(connection, obj, instId);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
+/**
+ * Add an unacked update of a small single instance object to the bundle of
+ * the connection, which carries several objects in one packet. The bundle
+ * is sent once it is full, before any other packet goes out and when
+ * UAVTalkFlushBundle() is called, so updates are never reordered. Objects
+ * that can not be bundled are sent with UAVTalkSendObjectDelta().
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object to send
+ * \param[in] instId The instance ID
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendObjectBundled(UAVTalkConnection connectionHandle, UAVObjHandle obj, uint16_t instId)
+{
+	UAVTalkConnectionData *connection;
+    CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (instId == UAVOBJ_ALL_INSTANCES)
+		return -1;
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t ret = sendBundledObject(connection, obj, instId);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
+/**
+ * Send the objects collected by UAVTalkSendObjectBundled(), if any.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+int32_t UAVTalkFlushBundle(UAVTalkConnection connectionHandle)
+{
+	UAVTalkConnectionData *connection;
+    CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+	int32_t ret = flushBundle(connection);
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return ret;
+}
+
+/**
+ * Send several single instance objects in one packet, all copied at the
+ * same time so the receiver gets a consistent view of them. Each snapshot
+ * sent on the connection has the next version, starting at 1.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] objs The objects, up to UAVTALK_SNAPSHOT_MAX_OBJECTS
+ * \param[in] count The number of objects
+ * \param[in,out] seqs The update counters of the objects in the last
+ * snapshot sent, nothing is sent if none of them was updated since.
+ * NULL to always send.
+ * \return 0 Success, also when nothing was updated
+ * \return -1 Failure
+ */
+int32_t UAVTalkSendSnapshot(UAVTalkConnection connectionHandle, const UAVObjHandle objs[], uint8_t count, uint16_t seqs[])
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	if (count == 0 || count > UAVTALK_SNAPSHOT_MAX_OBJECTS)
+		return -1;
+
+	// Place the objects in the packet before copying them all at once
+	uint8_t *data[UAVTALK_SNAPSHOT_MAX_OBJECTS];
+	int32_t length = UAVTALK_MIN_HEADER_LENGTH + UAVTALK_SNAPSHOT_TIME_LENGTH;
+	for (uint8_t i = 0; i < count; i++)
+	{
+		int32_t numBytes = UAVObjGetNumBytes(objs[i]);
+		if (numBytes > 0xFF)
+			return -1;
+
+		length += UAVTALK_BUNDLE_ENTRY_LENGTH + numBytes;
+		if (length - UAVTALK_MIN_HEADER_LENGTH >= UAVTALK_MAX_PAYLOAD_LENGTH)
+			return -1;
+	}
+
+	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+
+	if (!connection->outStream)
+	{
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		return -1;
+	}
+
+	flushBundle(connection);
+
+	uint8_t *buf = connection->txBuffer;
+	uint8_t *entry = &buf[UAVTALK_MIN_HEADER_LENGTH + UAVTALK_SNAPSHOT_TIME_LENGTH];
+	for (uint8_t i = 0; i < count; i++)
+	{
+		uint32_t objId = UAVObjGetID(objs[i]);
+		uint32_t numBytes = UAVObjGetNumBytes(objs[i]);
+		entry[0] = (uint8_t)(objId & 0xFF);
+		entry[1] = (uint8_t)((objId >> 8) & 0xFF);
+		entry[2] = (uint8_t)((objId >> 16) & 0xFF);
+		entry[3] = (uint8_t)((objId >> 24) & 0xFF);
+		entry[4] = (uint8_t)numBytes;
+		data[i] = &entry[UAVTALK_BUNDLE_ENTRY_LENGTH];
+		entry += UAVTALK_BUNDLE_ENTRY_LENGTH + numBytes;
+	}
+
+	uint16_t newSeqs[UAVTALK_SNAPSHOT_MAX_OBJECTS];
+	if (UAVObjPackMultiple(objs, count, data, newSeqs) < 0)
+	{
+		PIOS_Recursive_Mutex_Unlock(connection->lock);
+		return -1;
+	}
+	uint32_t time = PIOS_Thread_Systime();
+
+	if (seqs != NULL)
+	{
+		if (memcmp(seqs, newSeqs, count * sizeof(newSeqs[0])) == 0)
+		{
+			PIOS_Recursive_Mutex_Unlock(connection->lock);
+			return 0;
+		}
+		memcpy(seqs, newSeqs, count * sizeof(newSeqs[0]));
+	}
+
+	uint32_t version = ++connection->txSnapshotVersion;
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = UAVTALK_TYPE_OBJ_SNAPSHOT;
+	buf[2] = (uint8_t)(length & 0xFF);
+	buf[3] = (uint8_t)((length >> 8) & 0xFF);
+	buf[4] = (uint8_t)(version & 0xFF);
+	buf[5] = (uint8_t)((version >> 8) & 0xFF);
+	buf[6] = (uint8_t)((version >> 16) & 0xFF);
+	buf[7] = (uint8_t)((version >> 24) & 0xFF);
+	buf[8] = (uint8_t)(time & 0xFF);
+	buf[9] = (uint8_t)((time >> 8) & 0xFF);
+	buf[10] = (uint8_t)((time >> 16) & 0xFF);
+	buf[11] = (uint8_t)((time >> 24) & 0xFF);
+
+	// Calculate checksum
+	buf[length] = PIOS_CRC_updateCRC(0, buf, length);
+
+	uint16_t tx_msg_len = length+UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outStream)(buf, tx_msg_len);
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		connection->stats.txObjects += count;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += length - UAVTALK_MIN_HEADER_LENGTH;
+	}
+
+	PIOS_Recursive_Mutex_Unlock(connection->lock);
+
+	return 0;
+}
+
 /**
  * Execute the requested transaction on an object.
  * \param[in] connection UAVTalkConnection to be used
@@ -393,7 +628,29 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 			}
 			else
 			{
-				if (iproc->obj)
+				if (iproc->type == UAVTALK_TYPE_OBJ_BUNDLE || iproc->type == UAVTALK_TYPE_OBJ_SNAPSHOT)
+				{
+					// Bundles and snapshots carry the ids of their objects in the payload
+					iproc->obj = 0;
+					iproc->instanceLength = 0;
+					iproc->timestampLength = 0;
+					iproc->length = iproc->packet_size - iproc->rxPacketLength;
+				}
+				else if (iproc->obj && iproc->type == UAVTALK_TYPE_OBJ_DELTA)
+				{
+					// Deltas only carry the changed chunks of single instance objects
+					iproc->instanceLength = 0;
+					iproc->timestampLength = 0;
+					iproc->length = iproc->packet_size - iproc->rxPacketLength;
+				}
+				else if (iproc->obj && iproc->type == UAVTALK_TYPE_OBJ_CRC)
+				{
+					// Requests are empty, answers only carry the CRC
+					iproc->instanceLength = (UAVObjIsSingleInstance(iproc->obj) ? 0 : 2);
+					iproc->timestampLength = 0;
+					iproc->length = iproc->packet_size - iproc->rxPacketLength - iproc->instanceLength;
+				}
+				else if (iproc->obj)
 				{
 					iproc->length = UAVObjGetNumBytes(iproc->obj);
 					iproc->instanceLength = (UAVObjIsSingleInstance(iproc->obj) ? 0 : 2);
@@ -449,6 +706,7 @@ UAVTalkRxState UAVTalkProcessInputStreamQuiet(UAVTalkConnection connectionHandle
 					iproc->state = UAVTALK_STATE_CS;
 			}
 			iproc->rxCount = 0;
+			iproc->rxData = connection->rxBuffer;
 			
 			break;
 			
@@ -558,13 +816,109 @@ UAVTalkRxState UAVTalkProcessInputStream(UAVTalkConnection connectionHandle, uin
 		UAVTalkInputProcessor *iproc = &connection->iproc;
 
 		PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
-		receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
+		receiveObject(connection, iproc->type, iproc->objId, iproc->instId, iproc->rxData, iproc->length);
 		PIOS_Recursive_Mutex_Unlock(connection->lock);
 	}
 
 	return state;
 }
 
+/**
+ * Process a block of bytes from the telemetry stream, up to the end of the
+ * first packet that completes in it. The payload is checksummed in one go
+ * rather than a byte at a time. When the whole payload and its checksum are
+ * in the block the packet refers to it in place, so a completed packet must
+ * be received or relayed before buf is reused. Only packets spread over
+ * several blocks are gathered in the receive buffer.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] buf Received bytes
+ * \param[in] len Number of received bytes
+ * \param[out] consumed Number of bytes processed
+ * \return UAVTalkRxState after the last processed byte
+ */
+UAVTalkRxState UAVTalkProcessInputBufferQuiet(UAVTalkConnection connectionHandle, const uint8_t *buf, uint16_t len, uint16_t *consumed)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	UAVTalkRxState state = iproc->state;
+	uint16_t pos = 0;
+
+	while (pos < len)
+	{
+		if (iproc->state == UAVTALK_STATE_DATA)
+		{
+			// Take as much of the payload as has arrived
+			uint16_t n = iproc->length - iproc->rxCount;
+			if (n > len - pos)
+				n = len - pos;
+
+			// The checksum follows in this block, the object is unpacked
+			// straight from it once the checksum is good
+			if (iproc->rxCount == 0 && n < len - pos)
+				iproc->rxData = &buf[pos];
+			else
+				memcpy(&connection->rxBuffer[iproc->rxCount], &buf[pos], n);
+			iproc->cs = PIOS_CRC_updateCRC(iproc->cs, &buf[pos], n);
+			iproc->rxCount += n;
+			iproc->rxPacketLength += n;
+			connection->stats.rxBytes += n;
+			pos += n;
+
+			if (iproc->rxCount >= iproc->length)
+			{
+				iproc->state = UAVTALK_STATE_CS;
+				iproc->rxCount = 0;
+			}
+			state = iproc->state;
+			continue;
+		}
+
+		state = UAVTalkProcessInputStreamQuiet(connectionHandle, buf[pos++]);
+		if (state == UAVTALK_STATE_COMPLETE)
+			break;
+	}
+
+	*consumed = pos;
+	return state;
+}
+
+/**
+ * Process a block of bytes from the telemetry stream, receiving each
+ * object that completes in it.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] buf Received bytes
+ * \param[in] len Number of received bytes
+ * \return Number of packets completed, -1 on failure
+ */
+int32_t UAVTalkProcessInputBuffer(UAVTalkConnection connectionHandle, const uint8_t *buf, uint16_t len)
+{
+	UAVTalkConnectionData *connection;
+	CHECKCONHANDLE(connectionHandle,connection,return -1);
+
+	UAVTalkInputProcessor *iproc = &connection->iproc;
+	int32_t completed = 0;
+
+	while (len > 0)
+	{
+		uint16_t consumed;
+		UAVTalkRxState state = UAVTalkProcessInputBufferQuiet(connectionHandle, buf, len, &consumed);
+		buf += consumed;
+		len -= consumed;
+
+		if (state == UAVTALK_STATE_COMPLETE)
+		{
+			PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
+			receiveObject(connection, iproc->type, iproc->objId, iproc->instId, iproc->rxData, iproc->length);
+			PIOS_Recursive_Mutex_Unlock(connection->lock);
+			completed++;
+		}
+	}
+
+	return completed;
+}
+
 /**
  * Send a parsed packet received on one connection handle out on a different connection handle.
  * The packet must be in a complete state, meaning it is completed parsing.
@@ -621,8 +975,9 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
 		}
     }
 
-    // Add timestamp when the transaction type is appropriate
-    if (inIproc->type & UAVTALK_TIMESTAMPED) {
+    // Add timestamp when the transaction type is appropriate, snapshots
+    // carry their time in the payload
+    if (inIproc->obj && (inIproc->type & UAVTALK_TIMESTAMPED)) {
         uint32_t time = PIOS_Thread_Systime();
         outConnection->txBuffer[10] = (uint8_t)(time & 0xFF);
         outConnection->txBuffer[11] = (uint8_t)((time >> 8) & 0xFF);
@@ -631,7 +986,7 @@ int32_t UAVTalkRelayPacket(UAVTalkConnection inConnectionHandle, UAVTalkConnecti
 
     // Copy data (if any)
     if (inIproc->length > 0) {
-        memcpy(&outConnection->txBuffer[headerLength], inConnection->rxBuffer, inIproc->length);
+        memcpy(&outConnection->txBuffer[headerLength], inIproc->rxData, inIproc->length);
     }
 
     // Store the packet length
@@ -678,7 +1033,7 @@ int32_t UAVTalkReceiveObject(UAVTalkConnection connectionHandle)
         return -1;
     }
 
-    return receiveObject(connection, iproc->type, iproc->objId, iproc->instId, connection->rxBuffer, iproc->length);
+    return receiveObject(connection, iproc->type, iproc->objId, iproc->instId, iproc->rxData, iproc->length);
 }
 
 /**
@@ -759,7 +1114,7 @@ UAVTalkRxState UAVTalkRelayInputStream(UAVTalkConnection connectionHandle, uint8
 		}
 	
 		// Copy data (if any)
-		memcpy(&connection->txBuffer[dataOffset], connection->rxBuffer, iproc->length);
+		memcpy(&connection->txBuffer[dataOffset], iproc->rxData, iproc->length);
 	
 		// Store the packet length
 		connection->txBuffer[2] = (uint8_t)((dataOffset + iproc->length) & 0xFF);
@@ -799,6 +1154,177 @@ int32_t UAVTalkSendAck(UAVTalkConnection connectionHandle, UAVObjHandle obj, uin
 	return ret;
 }
 
+/**
+ * Send the dirty chunks of a single instance object through the telemetry
+ * link, or the whole object when that is not larger.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendDeltaObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	uint32_t mask = UAVObjTakeDirtyChunks(obj);
+	int32_t numBytes = UAVObjGetNumBytes(obj);
+	int32_t chunk = UAVObjDirtyChunkSize(numBytes);
+	int32_t length = 0;
+
+	if (!UAVObjIsSingleInstance(obj) || UAVObjIsMetaobject(obj))
+		return sendSingleObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
+
+	for (int32_t i = 0, pos = 0; pos < numBytes; i++, pos += chunk) {
+		if (mask & (1UL << i))
+			length += (pos + chunk > numBytes) ? numBytes - pos : chunk;
+	}
+	length += UAVTALK_DELTA_MASK_LENGTH;
+
+	if (length >= numBytes)
+		return sendSingleObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
+
+	if (!connection->outStream) return -1;
+
+	flushBundle(connection);
+
+	// data length inserted here below
+	packObjectHeader(obj, UAVTALK_TYPE_OBJ_DELTA, connection->txBuffer);
+	int32_t dataOffset = 8;
+
+	connection->txBuffer[dataOffset] = (uint8_t)(mask & 0xFF);
+	connection->txBuffer[dataOffset + 1] = (uint8_t)((mask >> 8) & 0xFF);
+	connection->txBuffer[dataOffset + 2] = (uint8_t)((mask >> 16) & 0xFF);
+	connection->txBuffer[dataOffset + 3] = (uint8_t)((mask >> 24) & 0xFF);
+
+	// Pack the whole object behind the mask and compact the dirty chunks down
+	uint8_t *chunks = &connection->txBuffer[dataOffset + UAVTALK_DELTA_MASK_LENGTH];
+	if (UAVObjPack(obj, instId, chunks) < 0)
+	{
+		return -1;
+	}
+
+	int32_t out = 0;
+	for (int32_t i = 0, pos = 0; pos < numBytes; i++, pos += chunk) {
+		if (mask & (1UL << i)) {
+			int32_t size = (pos + chunk > numBytes) ? numBytes - pos : chunk;
+			memmove(&chunks[out], &chunks[pos], size);
+			out += size;
+		}
+	}
+
+	// Store the packet length
+	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+
+	// Calculate checksum
+	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		++connection->stats.txObjects;
+		connection->stats.txBytes += tx_msg_len;
+		connection->stats.txObjectBytes += length;
+	}
+
+	return 0;
+}
+
+/**
+ * Add a single instance object to the bundle of the connection, sending
+ * the bundle first if the object does not fit in anymore. Objects that are
+ * not small enough to be bundled are sent as a delta.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle to send
+ * \param[in] instId The instance ID
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendBundledObject(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	int32_t numBytes = UAVObjGetNumBytes(obj);
+
+	if (!UAVObjIsSingleInstance(obj) || UAVObjIsMetaobject(obj) || numBytes > UAVTALK_BUNDLE_MAX_OBJECT ||
+			UAVTALK_BUNDLE_ENTRY_LENGTH + numBytes > UAVTALK_BUNDLE_MAX_PAYLOAD)
+		return sendDeltaObject(connection, obj, instId);
+
+	if (!connection->outStream) return -1;
+
+	if (connection->bundleBuffer == NULL)
+	{
+		connection->bundleBuffer = PIOS_malloc(UAVTALK_MIN_HEADER_LENGTH + UAVTALK_BUNDLE_MAX_PAYLOAD + UAVTALK_CHECKSUM_LENGTH);
+		if (connection->bundleBuffer == NULL)
+			return sendDeltaObject(connection, obj, instId);
+	}
+
+	// Send what is pending if there is no room left for this object
+	if (connection->bundleLength + UAVTALK_BUNDLE_ENTRY_LENGTH + numBytes > UAVTALK_BUNDLE_MAX_PAYLOAD)
+		flushBundle(connection);
+
+	uint8_t *entry = &connection->bundleBuffer[UAVTALK_MIN_HEADER_LENGTH + connection->bundleLength];
+	uint32_t objId = UAVObjGetID(obj);
+	entry[0] = (uint8_t)(objId & 0xFF);
+	entry[1] = (uint8_t)((objId >> 8) & 0xFF);
+	entry[2] = (uint8_t)((objId >> 16) & 0xFF);
+	entry[3] = (uint8_t)((objId >> 24) & 0xFF);
+	entry[4] = (uint8_t)numBytes;
+
+	if (UAVObjPack(obj, 0, &entry[UAVTALK_BUNDLE_ENTRY_LENGTH]) < 0)
+	{
+		return -1;
+	}
+
+	connection->bundleLength += UAVTALK_BUNDLE_ENTRY_LENGTH + numBytes;
+
+	// Update stats, the bytes are counted when the bundle is sent
+	++connection->stats.txObjects;
+	connection->stats.txObjectBytes += numBytes;
+
+	return 0;
+}
+
+/**
+ * Send the pending bundle of the connection as one packet.
+ * \param[in] connection UAVTalkConnection to be used
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t flushBundle(UAVTalkConnectionData *connection)
+{
+	if (connection->bundleLength == 0)
+		return 0;
+
+	if (!connection->outStream) return -1;
+
+	uint8_t *buf = connection->bundleBuffer;
+	int32_t length = UAVTALK_MIN_HEADER_LENGTH + connection->bundleLength;
+	connection->bundleLength = 0;
+
+	// The object id of the packet itself is unused
+	buf[0] = UAVTALK_SYNC_VAL;  // sync byte
+	buf[1] = UAVTALK_TYPE_OBJ_BUNDLE;
+	buf[2] = (uint8_t)(length & 0xFF);
+	buf[3] = (uint8_t)((length >> 8) & 0xFF);
+	buf[4] = 0;
+	buf[5] = 0;
+	buf[6] = 0;
+	buf[7] = 0;
+
+	// Calculate checksum
+	buf[length] = PIOS_CRC_updateCRC(0, buf, length);
+
+	uint16_t tx_msg_len = length+UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outStream)(buf, tx_msg_len);
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		connection->stats.txBytes += tx_msg_len;
+	}
+
+	return 0;
+}
+
 /**
  * Send a NACK through the telemetry link.
  * \param[in] connectionHandle UAVTalkConnection to be used
@@ -839,6 +1365,8 @@ int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_
 	// Lock
 	PIOS_Recursive_Mutex_Lock(connection->lock, PIOS_MUTEX_TIMEOUT_MAX);
 
+	flushBundle(connection);
+
 	// Output the buffer
 	int32_t rc = (*connection->outStream)(buf, len);
 
@@ -854,6 +1382,23 @@ int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_
 	return 0;
 }
 
+/**
+ * Check if a packet handed to the output stream only carries periodic
+ * updates, which can wait for more packets to go out with them. These are
+ * bundles and deltas, every other packet may be waited on by the other side.
+ * \param[in] buf The packet
+ * \param[in] len Length of the packet
+ * \return true if the packet does not need to be sent at once
+ */
+bool UAVTalkIsDeferrable(const uint8_t *buf, uint16_t len)
+{
+	if (len < UAVTALK_MIN_HEADER_LENGTH || buf[0] != UAVTALK_SYNC_VAL)
+		return false;
+
+	uint8_t type = buf[1];
+	return type == UAVTALK_TYPE_OBJ_BUNDLE || type == UAVTALK_TYPE_OBJ_DELTA;
+}
+
 /**
  * Receive an object. This function process objects received through the telemetry stream.
  * \param[in] connection UAVTalkConnection to be used
@@ -865,7 +1410,7 @@ int32_t UAVTalkSendBuf(UAVTalkConnection connectionHandle, uint8_t *buf, uint16_
  * \return 0 Success
  * \return -1 Failure
  */
-static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, uint8_t* data, int32_t length)
+static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, uint32_t objId, uint16_t instId, const uint8_t* data, int32_t length)
 {
 	UAVObjHandle obj;
 	int32_t ret = 0;
@@ -922,9 +1467,28 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 			else
 				sendObject(connection, obj, instId, UAVTALK_TYPE_OBJ);
 			break;
+		case UAVTALK_TYPE_OBJ_CRC:
+			// Answer with the CRC of the instance so the GCS can check its cached copy
+			if (length != 0)
+				ret = -1;
+			else if (obj == 0 || instId == UAVOBJ_ALL_INSTANCES)
+				sendNack(connection, objId);
+			else
+				ret = sendObjectCrc(connection, obj, instId);
+			break;
 		case UAVTALK_TYPE_NACK:
 			// Do nothing on flight side, let it time out.
 			break;
+		case UAVTALK_TYPE_OBJ_DELTA:
+			// Only sent by the flight side, relayed but never applied here
+			ret = -1;
+			break;
+		case UAVTALK_TYPE_OBJ_BUNDLE:
+			ret = receiveBundle(data, length);
+			break;
+		case UAVTALK_TYPE_OBJ_SNAPSHOT:
+			ret = receiveSnapshot(connection, objId, data, length);
+			break;
 		case UAVTALK_TYPE_ACK:
 			// All instances, not allowed for ACK messages
 			if (obj && (instId != UAVOBJ_ALL_INSTANCES))
@@ -944,6 +1508,102 @@ static int32_t receiveObject(UAVTalkConnectionData *connection, uint8_t type, ui
 	return ret;
 }
 
+/**
+ * Unpack all objects of a received bundle. Objects that are unknown or do
+ * not match the size of the local definition are skipped.
+ * \param[in] data The bundle payload
+ * \param[in] length Length of the payload
+ * \return 0 Success
+ * \return -1 Failure, at least one object was skipped
+ */
+static int32_t receiveBundle(const uint8_t* data, int32_t length)
+{
+	int32_t ret = 0;
+	int32_t pos = 0;
+
+	while (pos + (int32_t)UAVTALK_BUNDLE_ENTRY_LENGTH <= length)
+	{
+		uint32_t objId = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | ((uint32_t)data[pos + 3] << 24);
+		uint8_t size = data[pos + 4];
+		pos += UAVTALK_BUNDLE_ENTRY_LENGTH;
+
+		if (pos + size > length)
+			return -1;
+
+		UAVObjHandle obj = UAVObjGetByID(objId);
+		if (obj && UAVObjIsSingleInstance(obj) && UAVObjGetNumBytes(obj) == size)
+			UAVObjUnpack(obj, 0, &data[pos]);
+		else
+			ret = -1;
+
+		pos += size;
+	}
+
+	if (pos != length)
+		return -1;
+
+	return ret;
+}
+
+/**
+ * Apply a received snapshot, either all of its objects or none. Snapshots
+ * that are not newer than the last one applied are dropped, except for
+ * version 1 which a sender starts again with.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] version The version of the snapshot
+ * \param[in] data The snapshot payload
+ * \param[in] length Length of the payload
+ * \return 0 Success
+ * \return -1 Failure, nothing was applied
+ */
+static int32_t receiveSnapshot(UAVTalkConnectionData *connection, uint32_t version, const uint8_t* data, int32_t length)
+{
+	UAVObjHandle objs[UAVTALK_SNAPSHOT_MAX_OBJECTS];
+	const uint8_t *objData[UAVTALK_SNAPSHOT_MAX_OBJECTS];
+	uint8_t count = 0;
+
+	if (version != 1 && (int32_t)(version - connection->rxSnapshotVersion) <= 0)
+		return -1;
+
+	if (length < (int32_t)UAVTALK_SNAPSHOT_TIME_LENGTH)
+		return -1;
+
+	uint32_t time = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+	int32_t pos = UAVTALK_SNAPSHOT_TIME_LENGTH;
+
+	while (pos + (int32_t)UAVTALK_BUNDLE_ENTRY_LENGTH <= length)
+	{
+		uint32_t objId = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | ((uint32_t)data[pos + 3] << 24);
+		uint8_t size = data[pos + 4];
+		pos += UAVTALK_BUNDLE_ENTRY_LENGTH;
+
+		if (pos + size > length || count >= UAVTALK_SNAPSHOT_MAX_OBJECTS)
+			return -1;
+
+		UAVObjHandle obj = UAVObjGetByID(objId);
+		if (!obj || UAVObjGetNumBytes(obj) != size)
+			return -1;
+
+		objs[count] = obj;
+		objData[count] = &data[pos];
+		count++;
+
+		pos += size;
+	}
+
+	if (pos != length || count == 0)
+		return -1;
+
+	// Refuses multi instance and single writer objects
+	if (UAVObjUnpackMultiple(objs, count, objData) < 0)
+		return -1;
+
+	connection->rxSnapshotVersion = version;
+	connection->rxSnapshotTime = time;
+
+	return 0;
+}
+
 /**
  * Check if an ack is pending on an object and give response semaphore
  * \param[in] connection UAVTalkConnection to be used
@@ -1032,42 +1692,21 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 {
 	int32_t length;
 	int32_t dataOffset;
-	uint32_t objId;
+	uint8_t *txBuffer;
+	bool reserved = false;
 
 	if (!connection->outStream) return -1;
 
-	// Setup type and object id fields
-	objId = UAVObjGetID(obj);
-	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
-	connection->txBuffer[1] = type;
-	// data length inserted here below
-	connection->txBuffer[4] = (uint8_t)(objId & 0xFF);
-	connection->txBuffer[5] = (uint8_t)((objId >> 8) & 0xFF);
-	connection->txBuffer[6] = (uint8_t)((objId >> 16) & 0xFF);
-	connection->txBuffer[7] = (uint8_t)((objId >> 24) & 0xFF);
-	
-	// Setup instance ID if one is required
-	if (UAVObjIsSingleInstance(obj))
-	{
-		dataOffset = 8;
-	}
-	else
-	{
-		connection->txBuffer[8] = (uint8_t)(instId & 0xFF);
-		connection->txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
-		dataOffset = 10;
-	}
+	// Keep the order of updates, bundled ones go out first
+	flushBundle(connection);
 
-	// Add timestamp when the transaction type is appropriate
+	// Determine header and data length
+	dataOffset = UAVObjIsSingleInstance(obj) ? 8 : 10;
 	if (type & UAVTALK_TIMESTAMPED)
 	{
-		uint32_t time = PIOS_Thread_Systime();
-		connection->txBuffer[dataOffset] = (uint8_t)(time & 0xFF);
-		connection->txBuffer[dataOffset + 1] = (uint8_t)((time >> 8) & 0xFF);
 		dataOffset += 2;
 	}
-	
-	// Determine data length
+
 	if (type == UAVTALK_TYPE_OBJ_REQ || type == UAVTALK_TYPE_ACK)
 	{
 		length = 0;
@@ -1076,31 +1715,66 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	{
 		length = UAVObjGetNumBytes(obj);
 	}
-	
+
 	// Check length
 	if (length >= UAVTALK_MAX_PAYLOAD_LENGTH)
 	{
 		return -1;
 	}
-	
+
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+
+	// Build the packet in the output buffer when possible to save a copy
+	txBuffer = connection->txBuffer;
+	if (connection->reserveStream && connection->commitStream)
+	{
+		uint8_t *space = (*connection->reserveStream)(tx_msg_len);
+		if (space)
+		{
+			txBuffer = space;
+			reserved = true;
+		}
+	}
+
+	// Setup type and object id fields
+	packObjectHeader(obj, type, txBuffer);
+	txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+
+	// Setup instance ID if one is required
+	if (!UAVObjIsSingleInstance(obj))
+	{
+		txBuffer[8] = (uint8_t)(instId & 0xFF);
+		txBuffer[9] = (uint8_t)((instId >> 8) & 0xFF);
+	}
+
+	// Add timestamp when the transaction type is appropriate
+	if (type & UAVTALK_TIMESTAMPED)
+	{
+		uint32_t time = PIOS_Thread_Systime();
+		txBuffer[dataOffset - 2] = (uint8_t)(time & 0xFF);
+		txBuffer[dataOffset - 1] = (uint8_t)((time >> 8) & 0xFF);
+	}
+
 	// Copy data (if any)
 	if (length > 0)
 	{
-		if ( UAVObjPack(obj, instId, &connection->txBuffer[dataOffset]) < 0 )
+		if ( UAVObjPack(obj, instId, &txBuffer[dataOffset]) < 0 )
 		{
+			if (reserved)
+				(*connection->commitStream)(0);
 			return -1;
 		}
 	}
-	
-	// Store the packet length
-	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
-	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
-	
+
 	// Calculate checksum
-	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+	txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, txBuffer, dataOffset+length);
 
-	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
-	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+	int32_t rc;
+	if (reserved)
+		rc = (*connection->commitStream)(tx_msg_len);
+	else
+		rc = (*connection->outStream)(txBuffer, tx_msg_len);
 
 	if (rc == tx_msg_len) {
 		// Update stats
@@ -1113,6 +1787,23 @@ static int32_t sendSingleObject(UAVTalkConnectionData *connection, UAVObjHandle
 	return 0;
 }
 
+/**
+ * Fill in the sync, type and object id fields of a packet header.
+ * \param[in] obj Object handle to send
+ * \param[in] type Transaction type
+ * \param[out] buf Packet buffer
+ */
+static void packObjectHeader(UAVObjHandle obj, uint8_t type, uint8_t *buf)
+{
+	uint32_t objId = UAVObjGetID(obj);
+	buf[0] = UAVTALK_SYNC_VAL;
+	buf[1] = type;
+	buf[4] = (uint8_t)(objId & 0xFF);
+	buf[5] = (uint8_t)((objId >> 8) & 0xFF);
+	buf[6] = (uint8_t)((objId >> 16) & 0xFF);
+	buf[7] = (uint8_t)((objId >> 24) & 0xFF);
+}
+
 /**
  * Send a NACK through the telemetry link.
  * \param[in] connection UAVTalkConnection to be used
@@ -1126,6 +1817,8 @@ static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId)
 
 	if (!connection->outStream) return -1;
 
+	flushBundle(connection);
+
 	connection->txBuffer[0] = UAVTALK_SYNC_VAL;  // sync byte
 	connection->txBuffer[1] = UAVTALK_TYPE_NACK;
 	// data length inserted here below
@@ -1155,6 +1848,67 @@ static int32_t sendNack(UAVTalkConnectionData *connection, uint32_t objId)
 	return 0;
 }
 
+/**
+ * Send the CRC32 of an object instance through the telemetry link, this
+ * is the answer to a UAVTALK_TYPE_OBJ_CRC request.
+ * \param[in] connection UAVTalkConnection to be used
+ * \param[in] obj Object handle
+ * \param[in] instId The instance ID
+ * \return 0 Success
+ * \return -1 Failure
+ */
+static int32_t sendObjectCrc(UAVTalkConnectionData *connection, UAVObjHandle obj, uint16_t instId)
+{
+	int32_t dataOffset;
+	int32_t length = UAVObjGetNumBytes(obj);
+
+	if (!connection->outStream) return -1;
+
+	if (length >= UAVTALK_MAX_PAYLOAD_LENGTH)
+		return -1;
+
+	flushBundle(connection);
+
+	packObjectHeader(obj, UAVTALK_TYPE_OBJ_CRC, connection->txBuffer);
+	dataOffset = 8;
+	if (!UAVObjIsSingleInstance(obj))
+	{
+		connection->txBuffer[dataOffset] = (uint8_t)(instId & 0xFF);
+		connection->txBuffer[dataOffset + 1] = (uint8_t)((instId >> 8) & 0xFF);
+		dataOffset += 2;
+	}
+
+	// The instance is packed where the CRC goes and then replaced by it
+	uint8_t *data = &connection->txBuffer[dataOffset];
+	if (UAVObjPack(obj, instId, data) < 0)
+		return -1;
+
+	uint32_t crc = PIOS_CRC32_updateCRC(0, data, length);
+	data[0] = (uint8_t)(crc & 0xFF);
+	data[1] = (uint8_t)((crc >> 8) & 0xFF);
+	data[2] = (uint8_t)((crc >> 16) & 0xFF);
+	data[3] = (uint8_t)((crc >> 24) & 0xFF);
+	length = UAVTALK_OBJ_CRC_LENGTH;
+
+	// Store the packet length
+	connection->txBuffer[2] = (uint8_t)((dataOffset+length) & 0xFF);
+	connection->txBuffer[3] = (uint8_t)(((dataOffset+length) >> 8) & 0xFF);
+
+	// Calculate checksum
+	connection->txBuffer[dataOffset+length] = PIOS_CRC_updateCRC(0, connection->txBuffer, dataOffset+length);
+
+	uint16_t tx_msg_len = dataOffset+length+UAVTALK_CHECKSUM_LENGTH;
+	int32_t rc = (*connection->outStream)(connection->txBuffer, tx_msg_len);
+
+	if (rc == tx_msg_len) {
+		// Update stats
+		++connection->stats.txObjects;
+		connection->stats.txBytes += tx_msg_len;
+	}
+
+	return 0;
+}
+
 /**
  * @}
  * @}
@@ -0,0 +1,85 @@
+/**
+ ******************************************************************************
+ * @file       benchmark.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup Benchmarks
+ * @{
+ * @addtogroup Benchmarks
+ * @{
+ * @brief Minimal harness for host side micro-benchmarks
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdint.h>		/* uint*_t */
+
+/*
+ * A benchmark is a function that runs the operation being measured the
+ * given number of times:
+ *
+ *   BENCHMARK(pid_apply) {
+ *     for (uint32_t i = 0; i < iterations; i++)
+ *       benchmark_keep(pid_apply(&pid, err, dT));
+ *   }
+ *
+ * The runner picks the number of iterations, so that each timed run is long
+ * enough to measure, and reports the time per iteration of the fastest run in ns.
+ * Work done outside of the loop is counted too, so keep it small or leave
+ * it out of the time between benchmark_pause() and benchmark_resume().
+ */
+
+typedef void (*benchmark_function)(uint32_t iterations);
+
+class Benchmark {
+public:
+  Benchmark(const char *name, benchmark_function function);
+
+  const char *name;
+  benchmark_function function;
+  Benchmark *next;
+};
+
+#define BENCHMARK(name) \
+  static void benchmark_##name(uint32_t iterations); \
+  static Benchmark benchmark_##name##_registration(#name, benchmark_##name); \
+  static void benchmark_##name(uint32_t iterations)
+
+/* Stops and restarts the clock around setup that is not being measured */
+void benchmark_pause();
+void benchmark_resume();
+
+/* Keeps the compiler from dropping a result nobody looks at */
+template <typename T>
+inline void benchmark_keep(T const &value)
+{
+  asm volatile("" : : "r"(&value) : "memory");
+}
+
+/* Makes the compiler forget what it knows about memory, between iterations */
+inline void benchmark_clobber()
+{
+  asm volatile("" : : : "memory");
+}
+
+#endif /* BENCHMARK_H */
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,226 @@
+/**
+ ******************************************************************************
+ * @file       benchmark_main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup Benchmarks
+ * @{
+ * @addtogroup Benchmarks
+ * @{
+ * @brief Runs the registered benchmarks and compares them to a baseline
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "benchmark.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* strtod */
+#include <string.h>		/* strcmp */
+#include <time.h>		/* clock_gettime */
+
+#include <algorithm>		/* std::sort */
+#include <map>
+#include <string>
+#include <vector>
+
+/* Timed runs of each benchmark, the fastest is the one least disturbed by the rest of the system */
+#define BENCHMARK_RUNS 5
+
+static Benchmark *benchmarks = NULL;
+
+Benchmark::Benchmark(const char *name, benchmark_function function) :
+  name(name), function(function), next(benchmarks)
+{
+  benchmarks = this;
+}
+
+static double now_ns()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Time spent paused during the current run */
+static double paused_ns;
+static double paused_at;
+
+void benchmark_pause()
+{
+  paused_at = now_ns();
+}
+
+void benchmark_resume()
+{
+  paused_ns += now_ns() - paused_at;
+}
+
+static double time_ns(Benchmark *benchmark, uint32_t iterations)
+{
+  paused_ns = 0;
+
+  double start = now_ns();
+  benchmark->function(iterations);
+  return now_ns() - start - paused_ns;
+}
+
+/**
+ * Doubles the iterations until a run takes long enough that the clock
+ * resolution doesn't matter, then times a few runs of that length
+ */
+static double measure(Benchmark *benchmark, double run_ns)
+{
+  uint32_t iterations = 1;
+  double elapsed;
+
+  while ((elapsed = time_ns(benchmark, iterations)) < run_ns / 10 && iterations < (1U << 30))
+    iterations *= 2;
+
+  if (elapsed < run_ns)
+    iterations = (uint32_t)(iterations * run_ns / (elapsed > 0 ? elapsed : 1)) + 1;
+
+  std::vector<double> runs;
+  for (int i = 0; i < BENCHMARK_RUNS; i++)
+    runs.push_back(time_ns(benchmark, iterations) / iterations);
+
+  std::sort(runs.begin(), runs.end());
+  return runs[0];
+}
+
+/* The baseline is a list of lines "<benchmark> <ns/op>", # starts a comment */
+static void load_baseline(const char *file, std::map<std::string, double> &baseline)
+{
+  FILE *f = fopen(file, "r");
+  if (f == NULL)
+    return;
+
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    char name[200];
+    double ns;
+    if (line[0] != '#' && sscanf(line, "%199s %lf", name, &ns) == 2)
+      baseline[name] = ns;
+  }
+
+  fclose(f);
+}
+
+static bool save_baseline(const char *file, const std::map<std::string, double> &baseline)
+{
+  FILE *f = fopen(file, "w");
+  if (f == NULL)
+    return false;
+
+  fprintf(f, "# benchmark ns/op\n");
+  for (std::map<std::string, double>::const_iterator it = baseline.begin(); it != baseline.end(); ++it)
+    fprintf(f, "%s %.2f\n", it->first.c_str(), it->second);
+
+  fclose(f);
+  return true;
+}
+
+static void usage(const char *program)
+{
+  printf("Usage: %s [options]\n"
+         "  --filter=<text>        only run the benchmarks with text in their name\n"
+         "  --baseline=<file>      compare to the baseline, fail on regressions\n"
+         "  --save-baseline=<file> record the results as the new baseline\n"
+         "  --tolerance=<percent>  slowdown that counts as a regression (default 10)\n"
+         "  --min-time=<ms>        length of each timed run (default 50)\n",
+         program);
+}
+
+int main(int argc, char **argv)
+{
+  const char *filter = NULL;
+  const char *baseline_file = NULL;
+  const char *save_file = NULL;
+  double tolerance = 10;
+  double run_ns = 50e6;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "--filter=", 9) == 0) {
+      filter = argv[i] + 9;
+    } else if (strncmp(argv[i], "--baseline=", 11) == 0) {
+      baseline_file = argv[i] + 11;
+    } else if (strncmp(argv[i], "--save-baseline=", 16) == 0) {
+      save_file = argv[i] + 16;
+    } else if (strncmp(argv[i], "--tolerance=", 12) == 0) {
+      tolerance = strtod(argv[i] + 12, NULL);
+    } else if (strncmp(argv[i], "--min-time=", 11) == 0) {
+      run_ns = strtod(argv[i] + 11, NULL) * 1e6;
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+
+  /* Registration order is the reverse of the order in the file */
+  std::vector<Benchmark *> list;
+  for (Benchmark *b = benchmarks; b != NULL; b = b->next)
+    list.insert(list.begin(), b);
+
+  std::map<std::string, double> baseline;
+  if (baseline_file)
+    load_baseline(baseline_file, baseline);
+
+  std::map<std::string, double> results;
+  if (save_file)
+    load_baseline(save_file, results);
+
+  int regressions = 0;
+  for (size_t i = 0; i < list.size(); i++) {
+    Benchmark *b = list[i];
+    if (filter && strstr(b->name, filter) == NULL)
+      continue;
+
+    double ns = measure(b, run_ns);
+    results[b->name] = ns;
+    printf("%-48s %12.1f ns/op", b->name, ns);
+
+    std::map<std::string, double>::const_iterator base = baseline.find(b->name);
+    if (base != baseline.end() && base->second > 0) {
+      double change = (ns - base->second) * 100 / base->second;
+      printf(" %+7.1f%%", change);
+      if (change > tolerance) {
+        printf("  REGRESSION");
+        regressions++;
+      }
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  if (save_file) {
+    if (!save_baseline(save_file, results)) {
+      printf("Unable to write the baseline to %s\n", save_file);
+      return 2;
+    }
+    printf("Baseline saved to %s\n", save_file);
+  }
+
+  if (regressions > 0) {
+    printf("%d benchmark(s) more than %.0f%% slower than the baseline\n", regressions, tolerance);
+    return 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @}
+ * @}
+ */
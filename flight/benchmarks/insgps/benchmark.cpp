@@ -0,0 +1,98 @@
+/**
+ ******************************************************************************
+ * @file       benchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup Benchmarks
+ * @{
+ * @addtogroup Benchmarks
+ * @{
+ * @brief Benchmarks of the INS/GPS filters
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "benchmark.h"
+
+extern "C" {
+
+#include "insgps.h"		/* API of the filter being timed */
+
+}
+
+/* A vehicle sitting level, with the sensors at 500 Hz */
+static const float dT = 0.002f;
+static const float gyro[3] = { 0.001f, -0.002f, 0.0005f };
+static const float accel[3] = { 0.05f, -0.03f, -9.81f };
+static const float mag[3] = { 400.0f, 20.0f, 350.0f };
+static const float pos[3] = { 1.0f, -2.0f, -10.0f };
+static const float vel[3] = { 0.1f, 0.2f, -0.05f };
+static const float baro = 10.0f;
+
+static void init_filter()
+{
+  const float B[3] = { 400.0f, 20.0f, 350.0f };
+
+  INSGPSInit();
+  INSSetMagNorth(B);
+}
+
+BENCHMARK(INSStatePrediction) {
+  init_filter();
+  for (uint32_t i = 0; i < iterations; i++) {
+    INSStatePrediction(gyro, accel, dT);
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(INSCovariancePrediction) {
+  init_filter();
+  for (uint32_t i = 0; i < iterations; i++) {
+    INSCovariancePrediction(dT);
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(INSCorrection_full) {
+  init_filter();
+  for (uint32_t i = 0; i < iterations; i++) {
+    INSCorrection(mag, pos, vel, baro, FULL_SENSORS);
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(INSCorrection_baro) {
+  init_filter();
+  for (uint32_t i = 0; i < iterations; i++) {
+    INSCorrection(mag, pos, vel, baro, BARO_SENSOR);
+    benchmark_clobber();
+  }
+}
+
+/* One iteration of the attitude loop with all the sensors updated */
+BENCHMARK(INS_full_step) {
+  init_filter();
+  for (uint32_t i = 0; i < iterations; i++) {
+    INSStatePrediction(gyro, accel, dT);
+    INSCovariancePrediction(dT);
+    INSCorrection(mag, pos, vel, baro, FULL_SENSORS);
+    benchmark_clobber();
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,151 @@
+/**
+ ******************************************************************************
+ * @file       benchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup Benchmarks
+ * @{
+ * @addtogroup Benchmarks
+ * @{
+ * @brief Benchmarks of saving and loading settings objects with logfs
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "benchmark.h"
+
+#include <stdio.h>		/* fopen */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <unistd.h>		/* unlink */
+
+extern "C" {
+
+#include "pios_flash.h"		/* PIOS_FLASH_* API */
+
+#include "pios_flash_priv.h"	/* struct pios_flash_partition */
+
+extern const struct pios_flash_partition pios_flash_partition_table[];
+extern uint32_t pios_flash_partition_table_size;
+
+#include "pios_flash_posix_priv.h"
+
+extern uintptr_t pios_posix_flash_id;
+extern struct pios_flash_posix_cfg flash_config;
+
+#include "pios_flashfs_logfs_priv.h"
+
+extern struct flashfs_logfs_cfg flashfs_config_settings;
+
+#include "pios_flashfs.h"	/* PIOS_FLASHFS_* */
+
+}
+
+#define OBJ_SIZE 76
+
+/* Settings objects already in the filesystem when it is searched */
+#define NUM_OBJS 30
+
+static uint8_t obj[OBJ_SIZE];
+
+/* Creates an empty flash and mounts the settings partition */
+static uintptr_t mount()
+{
+  benchmark_pause();
+
+  FILE *theflash = fopen("theflash.bin", "w");
+  uint8_t sector[flash_config.size_of_sector];
+  memset(sector, 0xFF, sizeof(sector));
+  for (uint32_t i = 0; i < flash_config.size_of_flash / flash_config.size_of_sector; i++)
+    fwrite(sector, sizeof(sector), 1, theflash);
+  fclose(theflash);
+
+  for (uint32_t i = 0; i < sizeof(obj); i++)
+    obj[i] = 0x10 + (i % 10);
+
+  uintptr_t fs_id;
+  if (PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config) != 0)
+    abort();
+  PIOS_FLASH_register_partition_table(pios_flash_partition_table, pios_flash_partition_table_size);
+  if (PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS) != 0)
+    abort();
+
+  for (uint32_t i = 0; i < NUM_OBJS; i++)
+    PIOS_FLASHFS_ObjSave(fs_id, 0x10000000 + i, 0, obj, sizeof(obj));
+
+  benchmark_resume();
+  return fs_id;
+}
+
+static void unmount(uintptr_t fs_id)
+{
+  benchmark_pause();
+
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  unlink("theflash.bin");
+
+  benchmark_resume();
+}
+
+/* Saving the same object over and over, including the arena compaction that it causes */
+BENCHMARK(PIOS_FLASHFS_ObjSave_76) {
+  uintptr_t fs_id = mount();
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    obj[0] = i;
+    benchmark_keep(PIOS_FLASHFS_ObjSave(fs_id, 0x12345678, 0, obj, sizeof(obj)));
+  }
+
+  unmount(fs_id);
+}
+
+BENCHMARK(PIOS_FLASHFS_ObjLoad_76) {
+  uintptr_t fs_id = mount();
+
+  for (uint32_t i = 0; i < iterations; i++)
+    benchmark_keep(PIOS_FLASHFS_ObjLoad(fs_id, 0x10000000 + i % NUM_OBJS, 0, obj, sizeof(obj)));
+
+  unmount(fs_id);
+}
+
+/* Looking up an object that was never saved, like on the first boot */
+BENCHMARK(PIOS_FLASHFS_ObjLoad_missing) {
+  uintptr_t fs_id = mount();
+
+  for (uint32_t i = 0; i < iterations; i++)
+    benchmark_keep(PIOS_FLASHFS_ObjLoad(fs_id, 0x20000000, 0, obj, sizeof(obj)));
+
+  unmount(fs_id);
+}
+
+/* Mounting scans the arena for the active one and its next free slot */
+BENCHMARK(PIOS_FLASHFS_Logfs_Init) {
+  uintptr_t fs_id = mount();
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    if (PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS) != 0)
+      abort();
+  }
+
+  unmount(fs_id);
+}
+
+/**
+ * @}
+ * @}
+ */
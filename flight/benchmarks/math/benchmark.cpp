@@ -0,0 +1,200 @@
+/**
+ ******************************************************************************
+ * @file       benchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup Benchmarks
+ * @{
+ * @addtogroup Benchmarks
+ * @{
+ * @brief Benchmarks of the control math, coordinate conversions and CRCs
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "benchmark.h"
+
+#include <string.h>		/* memset */
+
+extern "C" {
+
+#include "pid.h"			/* pid_* */
+#include "coordinate_conversions.h"	/* RPY2Quaternion etc */
+#include "pios_crc.h"			/* PIOS_CRC_* */
+
+}
+
+static const float dT = 0.002f;
+
+/* Errors that change every iteration, so that nothing is hoisted out of the loop */
+static float error_at(uint32_t i)
+{
+  return 0.1f * (float)((int32_t)(i & 0xFF) - 128) / 128.0f;
+}
+
+BENCHMARK(pid_apply) {
+  struct pid pid;
+  pid_zero(&pid);
+  pid_configure(&pid, 0.003f, 0.002f, 0.00003f, 0.3f);
+
+  for (uint32_t i = 0; i < iterations; i++)
+    benchmark_keep(pid_apply(&pid, error_at(i), dT));
+}
+
+BENCHMARK(pid_apply_setpoint) {
+  struct pid pid;
+  pid_zero(&pid);
+  pid_configure(&pid, 0.003f, 0.002f, 0.00003f, 0.3f);
+
+  for (uint32_t i = 0; i < iterations; i++)
+    benchmark_keep(pid_apply_setpoint(&pid, error_at(i), 0.0f, dT));
+}
+
+BENCHMARK(RPY2Quaternion) {
+  float rpy[3] = { 10.0f, -5.0f, 170.0f };
+  float q[4];
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    rpy[2] += error_at(i);
+    RPY2Quaternion(rpy, q);
+    benchmark_keep(q);
+  }
+}
+
+BENCHMARK(Quaternion2RPY) {
+  float q[4] = { 0.7071f, 0.0f, 0.0f, 0.7071f };
+  float rpy[3];
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    q[1] = error_at(i);
+    Quaternion2RPY(q, rpy);
+    benchmark_keep(rpy);
+  }
+}
+
+BENCHMARK(Quaternion2R) {
+  float q[4] = { 0.7071f, 0.0f, 0.0f, 0.7071f };
+  float R[3][3];
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    q[1] = error_at(i);
+    Quaternion2R(q, R);
+    benchmark_keep(R);
+  }
+}
+
+BENCHMARK(R2Quaternion) {
+  float q[4] = { 0.7071f, 0.0f, 0.0f, 0.7071f };
+  float R[3][3];
+  Quaternion2R(q, R);
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    R[0][1] = error_at(i);
+    R2Quaternion(R, q);
+    benchmark_keep(q);
+  }
+}
+
+BENCHMARK(RneFromLLA) {
+  float LLA[3] = { 47.3f, 8.5f, 400.0f };
+  float Rne[3][3];
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    LLA[0] = 47.3f + error_at(i);
+    RneFromLLA(LLA, Rne);
+    benchmark_keep(Rne);
+  }
+}
+
+BENCHMARK(quat_mult) {
+  float q1[4] = { 0.7071f, 0.0f, 0.0f, 0.7071f };
+  const float q2[4] = { 0.9659f, 0.2588f, 0.0f, 0.0f };
+  float q[4];
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    q1[1] = error_at(i);
+    quat_mult(q1, q2, q);
+    benchmark_keep(q);
+  }
+}
+
+BENCHMARK(rot_mult) {
+  float R[3][3] = { { 1, 0, 0 }, { 0, 0.866f, -0.5f }, { 0, 0.5f, 0.866f } };
+  float v[3] = { 1.0f, 2.0f, 3.0f };
+  float out[3];
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    v[0] = error_at(i);
+    rot_mult(R, v, out, false);
+    benchmark_keep(out);
+  }
+}
+
+/* A long UAVTalk packet and a typical telemetry update */
+static uint8_t packet[256];
+
+static void fill_packet()
+{
+  for (uint32_t i = 0; i < sizeof(packet); i++)
+    packet[i] = (uint8_t)(i * 7 + 3);
+}
+
+BENCHMARK(PIOS_CRC_updateCRC_32) {
+  fill_packet();
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchmark_keep(PIOS_CRC_updateCRC(0, packet, 32));
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(PIOS_CRC_updateCRC_256) {
+  fill_packet();
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchmark_keep(PIOS_CRC_updateCRC(0, packet, sizeof(packet)));
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(PIOS_CRC_updateByte_256) {
+  fill_packet();
+  for (uint32_t i = 0; i < iterations; i++) {
+    uint8_t crc = 0;
+    for (uint32_t j = 0; j < sizeof(packet); j++)
+      crc = PIOS_CRC_updateByte(crc, packet[j]);
+    benchmark_keep(crc);
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(PIOS_CRC16_updateCRC_256) {
+  fill_packet();
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchmark_keep(PIOS_CRC16_updateCRC(0, packet, sizeof(packet)));
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(PIOS_CRC32_updateCRC_256) {
+  fill_packet();
+  for (uint32_t i = 0; i < iterations; i++) {
+    benchmark_keep(PIOS_CRC32_updateCRC(0, packet, sizeof(packet)));
+    benchmark_clobber();
+  }
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,8 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+/* Minimal environment for the math library benchmarks */
+#include <stdint.h>
+#include <stdbool.h>
+
+#endif /* OPENPILOT_H */
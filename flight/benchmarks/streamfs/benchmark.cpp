@@ -0,0 +1,148 @@
+/**
+ ******************************************************************************
+ * @file       benchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup Benchmarks
+ * @{
+ * @addtogroup Benchmarks
+ * @{
+ * @brief Benchmarks of streaming logs to flash with streamfs
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+
+#include "benchmark.h"
+
+#include <stdio.h>		/* fopen */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <unistd.h>		/* unlink */
+
+extern "C" {
+
+#include "pios_flash.h"		/* PIOS_FLASH_* API */
+
+#include "pios_flash_priv.h"	/* struct pios_flash_partition */
+
+extern const struct pios_flash_partition pios_flash_partition_table[];
+extern uint32_t pios_flash_partition_table_size;
+
+#include "pios_flash_posix_priv.h"
+
+extern uintptr_t pios_posix_flash_id;
+extern struct pios_flash_posix_cfg flash_config;
+
+#include "pios_streamfs_priv.h"
+#include "pios_streamfs.h"
+
+extern struct streamfs_cfg streamfs_settings;
+
+int32_t PIOS_STREAMFS_Testing_Write(uintptr_t fs_id, uint8_t *data, uint32_t len);
+int32_t PIOS_STREAMFS_Testing_Read(uintptr_t fs_id, uint8_t *data, uint32_t len);
+
+int32_t PIOS_DELAY_WaitmS(uint32_t mS) {
+  return mS;
+}
+
+}
+
+/* The size of the chunks the logging module hands over */
+#define CHUNK_SIZE 128
+
+static uint8_t chunk[CHUNK_SIZE];
+
+/* Creates an empty flash and mounts the partition */
+static uintptr_t mount()
+{
+  benchmark_pause();
+
+  FILE *theflash = fopen("theflash.bin", "w");
+  uint8_t sector[flash_config.size_of_sector];
+  memset(sector, 0xFF, sizeof(sector));
+  for (uint32_t i = 0; i < flash_config.size_of_flash / flash_config.size_of_sector; i++)
+    fwrite(sector, sizeof(sector), 1, theflash);
+  fclose(theflash);
+
+  for (uint32_t i = 0; i < sizeof(chunk); i++)
+    chunk[i] = i ^ 0x37;
+
+  uintptr_t fs_id;
+  if (PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config) != 0)
+    abort();
+  PIOS_FLASH_register_partition_table(pios_flash_partition_table, pios_flash_partition_table_size);
+  if (PIOS_STREAMFS_Init(&fs_id, &streamfs_settings, FLASH_PARTITION_LABEL_SETTINGS) != 0)
+    abort();
+
+  benchmark_resume();
+  return fs_id;
+}
+
+static void unmount(uintptr_t fs_id)
+{
+  benchmark_pause();
+
+  PIOS_STREAMFS_Destroy(fs_id);
+  PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  unlink("theflash.bin");
+
+  benchmark_resume();
+}
+
+/* Appending to a log, which erases the oldest arena whenever one fills up */
+BENCHMARK(PIOS_STREAMFS_Write_128) {
+  uintptr_t fs_id = mount();
+
+  if (PIOS_STREAMFS_OpenWrite(fs_id) != 0)
+    abort();
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    if (PIOS_STREAMFS_Testing_Write(fs_id, chunk, sizeof(chunk)) != 0)
+      abort();
+  }
+
+  PIOS_STREAMFS_Close(fs_id);
+  unmount(fs_id);
+}
+
+/* Reading a log back, from the start again whenever it runs out */
+BENCHMARK(PIOS_STREAMFS_Read_128) {
+  uintptr_t fs_id = mount();
+
+  benchmark_pause();
+  if (PIOS_STREAMFS_OpenWrite(fs_id) != 0)
+    abort();
+  for (uint32_t i = 0; i < 1000; i++)
+    PIOS_STREAMFS_Testing_Write(fs_id, chunk, sizeof(chunk));
+  PIOS_STREAMFS_Close(fs_id);
+  PIOS_STREAMFS_OpenRead(fs_id, 0);
+  benchmark_resume();
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    if (PIOS_STREAMFS_Testing_Read(fs_id, chunk, sizeof(chunk)) != sizeof(chunk)) {
+      PIOS_STREAMFS_Close(fs_id);
+      PIOS_STREAMFS_OpenRead(fs_id, 0);
+    }
+  }
+
+  PIOS_STREAMFS_Close(fs_id);
+  unmount(fs_id);
+}
+
+/**
+ * @}
+ * @}
+ */
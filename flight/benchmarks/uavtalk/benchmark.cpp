@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * @file       benchmark.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup Benchmarks
+ * @{
+ * @addtogroup Benchmarks
+ * @{
+ * @brief Benchmarks of the UAVTalk parser and packer
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "benchmark.h"
+
+#include <string.h>		/* memcpy */
+
+extern "C" {
+
+#include "openpilot.h"
+#include "uavobjects_bm.h"
+
+}
+
+/* Where the packets sent by UAVTalk end up */
+static uint8_t tx_buffer[UAVOBJECTS_LARGEST + 32];
+static int32_t tx_length;
+
+static int32_t output_stream(uint8_t *data, int32_t length)
+{
+  if (length > (int32_t)sizeof(tx_buffer))
+    return -1;
+
+  memcpy(tx_buffer, data, length);
+  tx_length = length;
+  return length;
+}
+
+static UAVTalkConnection connection()
+{
+  static UAVTalkConnection con;
+  if (!con)
+    con = UAVTalkInitialize(output_stream);
+  return con;
+}
+
+static void send(UAVObjHandle obj, uint32_t iterations)
+{
+  for (uint32_t i = 0; i < iterations; i++) {
+    ((struct bm_object *)obj)->data[0] = (uint8_t)i;
+    UAVTalkSendObject(connection(), obj, 0, 0, 0);
+    benchmark_clobber();
+  }
+}
+
+/* Each iteration parses one complete packet of the object */
+static void receive(UAVObjHandle obj, uint32_t iterations)
+{
+  UAVTalkSendObject(connection(), obj, 0, 0, 0);
+
+  uint8_t packet[sizeof(tx_buffer)];
+  int32_t length = tx_length;
+  memcpy(packet, tx_buffer, length);
+
+  for (uint32_t i = 0; i < iterations; i++) {
+    for (int32_t j = 0; j < length; j++)
+      UAVTalkProcessInputStream(connection(), packet[j]);
+    benchmark_clobber();
+  }
+}
+
+BENCHMARK(UAVTalkSendObject_28) {
+  send(UAVObjGetByID(BM_OBJ_SMALL_ID), iterations);
+}
+
+BENCHMARK(UAVTalkSendObject_200) {
+  send(UAVObjGetByID(BM_OBJ_LARGE_ID), iterations);
+}
+
+BENCHMARK(UAVTalkProcessInputStream_28) {
+  receive(UAVObjGetByID(BM_OBJ_SMALL_ID), iterations);
+}
+
+BENCHMARK(UAVTalkProcessInputStream_200) {
+  receive(UAVObjGetByID(BM_OBJ_LARGE_ID), iterations);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,17 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+/* Minimal environment for the UAVTalk benchmarks */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pios_heap.h"
+#include "pios_crc.h"
+#include "uavobjectmanager.h"
+#include "uavtalk.h"
+
+#define PIOS_Assert(x) if (!(x)) { abort(); }
+
+#endif /* OPENPILOT_H */
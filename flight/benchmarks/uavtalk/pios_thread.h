@@ -0,0 +1,9 @@
+#ifndef PIOS_THREAD_H
+#define PIOS_THREAD_H
+
+/* Only the system time is used by UAVTalk */
+#include <stdint.h>
+
+uint32_t PIOS_Thread_Systime(void);
+
+#endif /* PIOS_THREAD_H */
@@ -0,0 +1,67 @@
+/* A table of plain objects standing in for the UAVObject manager */
+#include <string.h>
+#include "uavobjectmanager.h"
+#include "uavobjects_bm.h"
+
+struct bm_object bm_objects[BM_NUM_OBJECTS] = {
+	{ .id = BM_OBJ_SMALL_ID, .num_bytes = BM_OBJ_SMALL_SIZE },
+	{ .id = BM_OBJ_LARGE_ID, .num_bytes = BM_OBJ_LARGE_SIZE },
+};
+
+UAVObjHandle UAVObjGetByID(uint32_t id)
+{
+	for (int i = 0; i < BM_NUM_OBJECTS; i++) {
+		if (bm_objects[i].id == id)
+			return &bm_objects[i];
+	}
+	return NULL;
+}
+
+uint32_t UAVObjGetID(UAVObjHandle obj)
+{
+	return ((struct bm_object *)obj)->id;
+}
+
+uint32_t UAVObjGetNumBytes(UAVObjHandle obj)
+{
+	return ((struct bm_object *)obj)->num_bytes;
+}
+
+uint16_t UAVObjGetNumInstances(UAVObjHandle obj)
+{
+	return 1;
+}
+
+bool UAVObjIsSingleInstance(UAVObjHandle obj)
+{
+	return true;
+}
+
+bool UAVObjIsMetaobject(UAVObjHandle obj)
+{
+	return false;
+}
+
+uint8_t UAVObjGetIndex(UAVObjHandle obj)
+{
+	return (struct bm_object *)obj - bm_objects;
+}
+
+uint32_t UAVObjTakeDirtyChunks(UAVObjHandle obj)
+{
+	return 0xFFFFFFFF;
+}
+
+int32_t UAVObjUnpack(UAVObjHandle obj, uint16_t instId, const uint8_t *dataIn)
+{
+	struct bm_object *o = obj;
+	memcpy(o->data, dataIn, o->num_bytes);
+	return 0;
+}
+
+int32_t UAVObjPack(UAVObjHandle obj, uint16_t instId, uint8_t *dataOut)
+{
+	struct bm_object *o = obj;
+	memcpy(dataOut, o->data, o->num_bytes);
+	return 0;
+}
@@ -0,0 +1,23 @@
+#ifndef UAVOBJECTS_BM_H
+#define UAVOBJECTS_BM_H
+
+#include <stdint.h>
+#include "uavobjectsinit.h"
+
+/* The size of AttitudeActual, and one close to the largest object */
+#define BM_OBJ_SMALL_ID   0x33DAD5E6
+#define BM_OBJ_SMALL_SIZE 28
+#define BM_OBJ_LARGE_ID   0x12345678
+#define BM_OBJ_LARGE_SIZE 200
+
+#define BM_NUM_OBJECTS 2
+
+struct bm_object {
+	uint32_t id;
+	uint32_t num_bytes;
+	uint8_t data[UAVOBJECTS_LARGEST];
+};
+
+extern struct bm_object bm_objects[BM_NUM_OBJECTS];
+
+#endif /* UAVOBJECTS_BM_H */
@@ -49,6 +49,9 @@ enum bl_commands {
 	BL_MSG_STATUS_REQ,
 	BL_MSG_STATUS_REP,
 	BL_MSG_WIPE_PARTITION,
+	BL_MSG_SECTOR_CRC_REQ,
+	BL_MSG_SECTOR_CRC_REP,
+	BL_MSG_WRITE_RANGE_START,
 
 	BL_MSG_WRITE_START = 0x27,
 };
@@ -118,6 +121,8 @@ struct bl_messages {
 #define BL_CAP_EXTENSION_MAGIC 0x3456
 			uint16_t cap_extension_magic;
 			uint32_t partition_sizes[10];
+#define BL_CAP_FLAG_SECTOR_CRC 0x01	/* Supports SECTOR_CRC and WRITE_RANGE_START */
+			uint8_t cap_flags;
 #endif	/* BL_INCLUDE_CAP_EXTENSIONS */
 		} cap_rep_specific;
 
@@ -149,6 +154,7 @@ struct bl_messages {
 			enum dfu_partition_label label;
 			uint8_t words_in_last_packet;
 			uint32_t expected_crc; /* only used in writes */
+			uint32_t partition_offset; /* only used in range writes */
 		} xfer_start;
 
 #define XFER_BYTES_PER_PACKET 56
@@ -170,6 +176,18 @@ struct bl_messages {
 			enum dfu_partition_label label;
 		} wipe_partition;
 
+		struct msg_sector_crc_req {
+			uint32_t partition_offset;
+			enum dfu_partition_label label;
+		} sector_crc_req;
+
+		struct msg_sector_crc_rep {
+			uint32_t sector_offset;
+			uint32_t sector_size; /* 0 past the end of the partition */
+			uint32_t crc;
+			enum dfu_partition_label label;
+		} sector_crc_rep;
+
 		uint8_t pad[62];
 	} __attribute__((aligned(1)))v;
 } __attribute__((packed));
@@ -263,7 +263,7 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 	/* Figure out if we need to erase the *selected* partition before writing to it */
 	if (partition_needs_erase) {
 		PIOS_FLASH_start_transaction(xfer->partition_id);
-		PIOS_FLASH_erase_partition(xfer->partition_id);
+		PIOS_FLASH_erase_dirty_sectors(xfer->partition_id);
 		PIOS_FLASH_end_transaction(xfer->partition_id);
 	}
 
@@ -275,6 +275,133 @@ bool bl_xfer_write_start(struct xfer_state * xfer, const struct msg_xfer_start *
 	return true;
 }
 
+/**
+ * Find the flash partition behind a label that can be written in ranges
+ * @param[out] partition_size bytes of the partition that can be written
+ */
+static bool bl_xfer_find_range_partition(enum dfu_partition_label label, uintptr_t *partition_id, uint32_t *partition_size)
+{
+	const struct pios_board_info * bdinfo = &pios_board_info_blob;
+	enum pios_flash_partition_labels flash_label;
+
+	switch (label) {
+	case DFU_PARTITION_FW:
+		flash_label = FLASH_PARTITION_LABEL_FW;
+		break;
+	case DFU_PARTITION_SETTINGS:
+		flash_label = FLASH_PARTITION_LABEL_SETTINGS;
+		break;
+	case DFU_PARTITION_WAYPOINTS:
+		flash_label = FLASH_PARTITION_LABEL_WAYPOINTS;
+		break;
+	case DFU_PARTITION_LOG:
+		flash_label = FLASH_PARTITION_LABEL_LOG;
+		break;
+	case DFU_PARTITION_OTA:
+		flash_label = FLASH_PARTITION_LABEL_OTA;
+		break;
+	default:
+		return false;
+	}
+
+	if (PIOS_FLASH_find_partition_id(flash_label, partition_id) != 0)
+		return false;
+
+	PIOS_FLASH_get_partition_size(*partition_id, partition_size);
+
+	/* don't allow overwriting descriptor */
+	if (label == DFU_PARTITION_FW)
+		*partition_size -= bdinfo->desc_size;
+
+	return true;
+}
+
+/**
+ * Reply with the CRC of the sector holding an offset, so the host can
+ * skip the sectors that already hold what it is about to write. The CRC
+ * stops at the end of the writable part of the partition, before the
+ * descriptor for the firmware.
+ */
+bool bl_xfer_send_sector_crc(const struct msg_sector_crc_req *sector_crc_req)
+{
+	struct bl_messages msg = {
+		.flags_command = BL_MSG_SECTOR_CRC_REP,
+		.v.sector_crc_rep = {
+			.label = sector_crc_req->label,
+		},
+	};
+
+	uintptr_t partition_id;
+	uint32_t partition_size;
+	uint32_t sector_offset;
+	uint32_t sector_size;
+	uint32_t offset = ntohl(sector_crc_req->partition_offset);
+
+	if (bl_xfer_find_range_partition(sector_crc_req->label, &partition_id, &partition_size) &&
+			offset < partition_size &&
+			PIOS_FLASH_get_sector_extents(partition_id, offset, &sector_offset, &sector_size) == 0) {
+		sector_size = MIN(sector_size, partition_size - sector_offset);
+
+		msg.v.sector_crc_rep.sector_offset = htonl(sector_offset);
+		msg.v.sector_crc_rep.sector_size   = htonl(sector_size);
+		msg.v.sector_crc_rep.crc           = htonl(bl_compute_partition_crc(partition_id, sector_offset, sector_size));
+	}
+
+	PIOS_COM_MSG_Send(PIOS_COM_TELEM_USB, (uint8_t *)&msg, sizeof(msg));
+
+	return true;
+}
+
+/**
+ * Start writing part of a partition. Only the sectors covering the range
+ * are erased, it has to start at the beginning of a sector and the CRC
+ * is checked over the range only.
+ */
+bool bl_xfer_write_range_start(struct xfer_state * xfer, const struct msg_xfer_start *xfer_start)
+{
+	/* Disable any previous transfer */
+	xfer->in_progress = false;
+
+	if (!bl_xfer_find_range_partition(xfer_start->label, &xfer->partition_id, &xfer->partition_size))
+		return false;
+
+	uint32_t offset = ntohl(xfer_start->partition_offset);
+	uint32_t bytes_to_xfer = (ntohl(xfer_start->packets_in_transfer) - 1) * XFER_BYTES_PER_PACKET +
+		xfer_start->words_in_last_packet * sizeof(uint32_t);
+
+	if (bytes_to_xfer == 0 || offset >= xfer->partition_size ||
+			bytes_to_xfer > xfer->partition_size - offset)
+		return false;
+
+	/* Erase every sector the range touches */
+	uint32_t sector_offset;
+	uint32_t sector_size;
+	if (PIOS_FLASH_get_sector_extents(xfer->partition_id, offset, &sector_offset, &sector_size) != 0 ||
+			sector_offset != offset)
+		return false;
+
+	PIOS_FLASH_start_transaction(xfer->partition_id);
+	while (sector_offset < offset + bytes_to_xfer) {
+		PIOS_FLASH_erase_range(xfer->partition_id, sector_offset, sector_size);
+
+		if (PIOS_FLASH_get_sector_extents(xfer->partition_id, sector_offset + sector_size,
+					&sector_offset, &sector_size) != 0)
+			break;
+	}
+	PIOS_FLASH_end_transaction(xfer->partition_id);
+
+	xfer->original_partition_offset = offset;
+	xfer->current_partition_offset  = offset;
+	xfer->crc                       = ntohl(xfer_start->expected_crc);
+	xfer->check_crc                 = true;
+	xfer->bytes_to_crc              = bytes_to_xfer;
+	xfer->bytes_to_xfer             = bytes_to_xfer;
+	xfer->next_packet_number        = 0;
+	xfer->in_progress               = true;
+
+	return true;
+}
+
 bool bl_xfer_write_cont(struct xfer_state * xfer, const struct msg_xfer_cont *xfer_cont)
 {
 	if (!xfer->in_progress) {
@@ -348,7 +475,7 @@ bool bl_xfer_wipe_partition(const struct msg_wipe_partition *wipe_partition)
 		return false;
 
 	PIOS_FLASH_start_transaction(partition_id);
-	PIOS_FLASH_erase_partition(partition_id);
+	PIOS_FLASH_erase_dirty_sectors(partition_id);
 	PIOS_FLASH_end_transaction(partition_id);
 
 	return true;
@@ -380,6 +507,7 @@ bool bl_xfer_send_capabilities_self(void)
 #if defined(BL_INCLUDE_CAP_EXTENSIONS)
 	/* Fill in capabilities extensions */
 	msg.v.cap_rep_specific.cap_extension_magic = BL_CAP_EXTENSION_MAGIC;
+	msg.v.cap_rep_specific.cap_flags = BL_CAP_FLAG_SECTOR_CRC;
 
 	uintptr_t partition_id;
 	uint32_t partition_size;
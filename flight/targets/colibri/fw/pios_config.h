@@ -39,6 +39,10 @@
 #define PIOS_INCLUDE_DELAY
 #define PIOS_INCLUDE_I2C
 #define WDG_STATS_DIAGNOSTICS
+//#define LATENCY_DIAGNOSTICS
+//#define HEAP_DIAGNOSTICS
+//#define MUTEX_DIAGNOSTICS
+#define BLACKBOX_CAPTURE
 #define PIOS_INCLUDE_IRQ
 #define PIOS_INCLUDE_LED
 #define PIOS_INCLUDE_IAP
@@ -70,6 +74,7 @@
 /* Com systems to include */
 #define PIOS_INCLUDE_COM
 #define PIOS_INCLUDE_COM_TELEM
+#define PIOS_COM_TELEM_USB_TX_BUF_LEN 513	/* Room for multi-packet USB transfers */
 #define PIOS_INCLUDE_TELEMETRY_RF
 #define PIOS_INCLUDE_COM_FLEXI
 #define PIOS_INCLUDE_MAVLINK
@@ -112,19 +117,6 @@
 #define CPULOAD_LIMIT_WARNING		80
 #define CPULOAD_LIMIT_CRITICAL		95
 
-/*
- * This has been calibrated 2014/03/01 using chibios @ fbd194c026098076bddd9e45
- * Calibration has been done by disabling the init task, breaking into debugger after
- * approximately after 60 seconds, then doing the following math:
- *
- * IDLE_COUNTS_PER_SEC_AT_NO_LOAD = (uint32_t)((double)idleCounter / xTickCount * 1000 + 0.5)
- *
- * This has to be redone every time the toolchain, toolchain flags or FreeRTOS
- * configuration like number of task priorities or similar changes.
- * A change in the cpu load calculation or the idle task handler will invalidate this as well.
- */
-#define IDLE_COUNTS_PER_SEC_AT_NO_LOAD (9873737)
-
 #endif /* PIOS_CONFIG_H */
 /**
  * @}
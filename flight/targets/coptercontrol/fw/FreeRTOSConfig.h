@@ -96,6 +96,12 @@ do {\
 #endif
 
 
+/* Record every task switch in the event trace */
+#if defined(PIOS_INCLUDE_TRACE)
+#include "pios_trace.h"
+#define traceTASK_SWITCHED_IN() PIOS_TRACE(PIOS_TRACE_THREAD_IN, pxCurrentTCB)
+#endif
+
 /**
   * @}
   */
@@ -111,6 +111,8 @@
 #define PIOS_EVENTDISPATCHER_STACK_SIZE 720
 #define PIOS_MAVLINK_STACK_SIZE         496
 #define PIOS_COMUSBBRIDGE_STACK_SIZE    480
+#define PIOS_SENSOR_SCHED_STACK_BYTES   484
+#define PIOS_SENSOR_SCHED_MAX_DRIVERS   1
 #define IDLE_COUNTS_PER_SEC_AT_NO_LOAD 1995998
 
 /* Buffer sizes */
@@ -137,6 +139,9 @@
 // This can't be too high to stop eventdispatcher thread overflowing
 #define PIOS_EVENTDISAPTCHER_QUEUE      10
 
+// No RAM for the extra priority class tasks, all callbacks share one task
+#define PIOS_EVENTDISPATCHER_SINGLE_TASK
+
 /* PIOS Initcall infrastructure */
 #define PIOS_INCLUDE_INITCALL
 
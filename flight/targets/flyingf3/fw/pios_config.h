@@ -39,6 +39,9 @@
 #define PIOS_INCLUDE_DELAY
 #define PIOS_INCLUDE_I2C
 #define WDG_STATS_DIAGNOSTICS
+//#define LATENCY_DIAGNOSTICS
+//#define HEAP_DIAGNOSTICS
+//#define MUTEX_DIAGNOSTICS
 #define PIOS_INCLUDE_IRQ
 #define PIOS_INCLUDE_LED
 #define PIOS_INCLUDE_IAP
@@ -112,19 +115,6 @@
 /* Task stack sizes */
 #define PIOS_EVENTDISPATCHER_STACK_SIZE	1024
 
-/*
- * This has been calibrated 2014/02/21 using chibios @ b89da8ac379646ac421bb65a209210e637bba223.
- * Calibration has been done by disabling the init task, breaking into debugger after
- * approximately after 60 seconds, then doing the following math:
- *
- * IDLE_COUNTS_PER_SEC_AT_NO_LOAD = (uint32_t)((double)idleCounter / xTickCount * 1000 + 0.5)
- *
- * This has to be redone every time the toolchain, toolchain flags or FreeRTOS
- * configuration like number of task priorities or similar changes.
- * A change in the cpu load calculation or the idle task handler will invalidate this as well.
- */
-#define IDLE_COUNTS_PER_SEC_AT_NO_LOAD (2175780)
-
 #endif /* PIOS_CONFIG_H */
 /**
  * @}
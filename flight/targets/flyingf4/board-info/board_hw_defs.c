@@ -1650,6 +1650,13 @@ const struct pios_pwm_cfg pios_pwm_with_ppm_cfg = {
  */
 #if defined(PIOS_INCLUDE_PPM)
 #include <pios_ppm_priv.h>
+/* TIM4_CH3 capture requests go to DMA1 Stream7 */
+static const struct pios_ppm_dma_cfg pios_ppm_dma_cfg = {
+	.ahb_clk = RCC_AHB1Periph_DMA1,
+	.stream = DMA1_Stream7,
+	.channel = DMA_Channel_2,
+};
+
 static const struct pios_ppm_cfg pios_ppm_cfg = {
 	.tim_ic_init = {
 		.TIM_ICPolarity = TIM_ICPolarity_Rising,
@@ -1661,6 +1668,7 @@ static const struct pios_ppm_cfg pios_ppm_cfg = {
 	/* Use only the first channel for ppm */
 	.channels = &pios_tim_rcvrport_all_channels[0],
 	.num_channels = 1,
+	.dma = &pios_ppm_dma_cfg,
 };
 
 #endif //PPM
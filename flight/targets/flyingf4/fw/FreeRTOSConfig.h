@@ -92,6 +92,12 @@ NVIC value of 255. */
 #define portGET_RUN_TIME_COUNTER_VALUE()		DWT->CYCCNT
 
 
+/* Record every task switch in the event trace */
+#if defined(PIOS_INCLUDE_TRACE)
+#include "pios_trace.h"
+#define traceTASK_SWITCHED_IN() PIOS_TRACE(PIOS_TRACE_THREAD_IN, pxCurrentTCB)
+#endif
+
 /**
   * @}
   */
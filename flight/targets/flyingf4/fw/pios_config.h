@@ -39,6 +39,9 @@
 #define PIOS_INCLUDE_DELAY
 #define PIOS_INCLUDE_I2C
 #define WDG_STATS_DIAGNOSTICS
+//#define LATENCY_DIAGNOSTICS
+//#define HEAP_DIAGNOSTICS
+//#define MUTEX_DIAGNOSTICS
 #define PIOS_INCLUDE_IRQ
 #define PIOS_INCLUDE_LED
 #define PIOS_INCLUDE_IAP
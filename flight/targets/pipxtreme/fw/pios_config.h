@@ -98,6 +98,9 @@
 // This can't be too high to stop eventdispatcher thread overflowing
 #define PIOS_EVENTDISAPTCHER_QUEUE      10
 
+// No RAM for the extra priority class tasks, all callbacks share one task
+#define PIOS_EVENTDISPATCHER_SINGLE_TASK
+
 /* PIOS Initcall infrastructure */
 #define PIOS_INCLUDE_INITCALL
 
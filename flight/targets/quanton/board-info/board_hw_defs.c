@@ -2128,6 +2128,13 @@ const struct pios_pwm_cfg pios_pwm_with_ppm_with_adc_cfg = {
 #if defined(PIOS_INCLUDE_PPM)
 #include <pios_ppm_priv.h>
 
+/* TIM1_CH3 capture requests go to DMA2 Stream6 */
+static const struct pios_ppm_dma_cfg pios_ppm_dma_cfg = {
+	.ahb_clk = RCC_AHB1Periph_DMA2,
+	.stream = DMA2_Stream6,
+	.channel = DMA_Channel_6,
+};
+
 static const struct pios_ppm_cfg pios_ppm_cfg = {
 	.tim_ic_init = {
 		.TIM_ICPolarity = TIM_ICPolarity_Rising,
@@ -2139,6 +2146,7 @@ static const struct pios_ppm_cfg pios_ppm_cfg = {
 	/* Use only the first channel for ppm */
 	.channels = &pios_tim_rcvrport_all_channels[0],
 	.num_channels = 1,
+	.dma = &pios_ppm_dma_cfg,
 };
 
 #endif //PPM
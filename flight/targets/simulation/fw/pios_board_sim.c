@@ -62,6 +62,12 @@ const struct pios_udp_cfg pios_udp_telem_cfg = {
 	.port = 9000,
 };
 
+const struct pios_udp_cfg pios_udp_telem_seq_cfg = {
+	.ip = "0.0.0.0",
+	.port = 9000,
+	.sequence_numbers = true,
+};
+
 const struct pios_tcp_cfg pios_tcp_gps_cfg = {
   .ip = "0.0.0.0",
   .port = 9001,
@@ -83,6 +89,7 @@ const struct pios_tcp_cfg pios_tcp_aux_cfg = {
 
 #define PIOS_COM_TELEM_RF_RX_BUF_LEN 384
 #define PIOS_COM_TELEM_RF_TX_BUF_LEN 384
+#define PIOS_COM_TELEM_UDP_TX_BUF_LEN (2 * PIOS_UDP_MAX_DATAGRAM)
 #define PIOS_COM_GPS_RX_BUF_LEN 96
 
 /**
@@ -170,37 +177,35 @@ void PIOS_Board_Init(void) {
 	 * test. */
 	HwSparkyInitialize();
 #if defined(PIOS_INCLUDE_COM)
-#if defined(PIOS_INCLUDE_TELEMETRY_RF) && 1
-	{
-		uintptr_t pios_tcp_telem_rf_id;
-		if (PIOS_TCP_Init(&pios_tcp_telem_rf_id, &pios_tcp_telem_cfg)) {
+#if defined(PIOS_INCLUDE_TELEMETRY_RF)
+	bool udp_sequence_numbers;
+	if (PIOS_SYS_UdpTelemetry(&udp_sequence_numbers)) {
+		uintptr_t pios_udp_telem_rf_id;
+		if (PIOS_UDP_Init(&pios_udp_telem_rf_id, udp_sequence_numbers ?
+				&pios_udp_telem_seq_cfg : &pios_udp_telem_cfg)) {
 			PIOS_Assert(0);
 		}
 
 		uint8_t * rx_buffer = (uint8_t *) PIOS_malloc(PIOS_COM_TELEM_RF_RX_BUF_LEN);
-		uint8_t * tx_buffer = (uint8_t *) PIOS_malloc(PIOS_COM_TELEM_RF_TX_BUF_LEN);
+		uint8_t * tx_buffer = (uint8_t *) PIOS_malloc(PIOS_COM_TELEM_UDP_TX_BUF_LEN);
 		PIOS_Assert(rx_buffer);
 		PIOS_Assert(tx_buffer);
-		if (PIOS_COM_Init(&pios_com_telem_rf_id, &pios_tcp_com_driver, pios_tcp_telem_rf_id,
+		if (PIOS_COM_Init(&pios_com_telem_rf_id, &pios_udp_com_driver, pios_udp_telem_rf_id,
 						  rx_buffer, PIOS_COM_TELEM_RF_RX_BUF_LEN,
-						  tx_buffer, PIOS_COM_TELEM_RF_TX_BUF_LEN)) {
+						  tx_buffer, PIOS_COM_TELEM_UDP_TX_BUF_LEN)) {
 			PIOS_Assert(0);
 		}
-	}
-#endif /* PIOS_INCLUDE_TELEMETRY_RF */
-
-#if defined(PIOS_INCLUDE_TELEMETRY_RF) && 0
-	{
-		uintptr_t pios_udp_telem_rf_id;
-		if (PIOS_UDP_Init(&pios_udp_telem_rf_id, &pios_udp_telem_cfg)) {
+	} else {
+		uintptr_t pios_tcp_telem_rf_id;
+		if (PIOS_TCP_Init(&pios_tcp_telem_rf_id, &pios_tcp_telem_cfg)) {
 			PIOS_Assert(0);
 		}
-		
+
 		uint8_t * rx_buffer = (uint8_t *) PIOS_malloc(PIOS_COM_TELEM_RF_RX_BUF_LEN);
 		uint8_t * tx_buffer = (uint8_t *) PIOS_malloc(PIOS_COM_TELEM_RF_TX_BUF_LEN);
 		PIOS_Assert(rx_buffer);
 		PIOS_Assert(tx_buffer);
-		if (PIOS_COM_Init(&pios_com_telem_rf_id, &pios_udp_com_driver, pios_udp_telem_rf_id,
+		if (PIOS_COM_Init(&pios_com_telem_rf_id, &pios_tcp_com_driver, pios_tcp_telem_rf_id,
 						  rx_buffer, PIOS_COM_TELEM_RF_RX_BUF_LEN,
 						  tx_buffer, PIOS_COM_TELEM_RF_TX_BUF_LEN)) {
 			PIOS_Assert(0);
@@ -78,8 +78,6 @@
 #define CPULOAD_LIMIT_WARNING		80
 #define CPULOAD_LIMIT_CRITICAL		95
 
-#define IDLE_COUNTS_PER_SEC_AT_NO_LOAD 9959
-
 // Enable POI tracking mode for camera stabilization
 #define CAMERASTAB_POI_MODE
 
@@ -778,7 +778,57 @@ bool get_external_flash(uint32_t board_revision)
 
 /*
  * MAIN USART
+ * Received and sent by DMA, telemetry and GPS run at high rates here
  */
+void PIOS_USART_main_dma_irq_handler(void);
+void DMA2_Stream2_IRQHandler(void) __attribute__((alias("PIOS_USART_main_dma_irq_handler")));
+static const struct stm32_dma pios_usart_main_dma_cfg = {
+	.irq = {
+		.flags   = (DMA_IT_TCIF2 | DMA_IT_HTIF2),
+		.init    = {
+			.NVIC_IRQChannel                   = DMA2_Stream2_IRQn,
+			.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_MID,
+			.NVIC_IRQChannelSubPriority        = 0,
+			.NVIC_IRQChannelCmd                = ENABLE,
+		},
+	},
+	.rx = {
+		.channel = DMA2_Stream2,
+		.init    = {
+			.DMA_Channel            = DMA_Channel_4,
+			.DMA_DIR                = DMA_DIR_PeripheralToMemory,
+			.DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+			.DMA_MemoryInc          = DMA_MemoryInc_Enable,
+			.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+			.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+			.DMA_Priority           = DMA_Priority_Medium,
+			.DMA_FIFOMode           = DMA_FIFOMode_Disable,
+			.DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+			.DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+		},
+	},
+	.tx = {
+		.channel = DMA2_Stream7,
+		.init    = {
+			.DMA_Channel            = DMA_Channel_4,
+			.DMA_DIR                = DMA_DIR_MemoryToPeripheral,
+			.DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+			.DMA_MemoryInc          = DMA_MemoryInc_Enable,
+			.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+			.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+			.DMA_Priority           = DMA_Priority_Medium,
+			.DMA_FIFOMode           = DMA_FIFOMode_Disable,
+			.DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+			.DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+		},
+	},
+};
+
+void PIOS_USART_main_dma_irq_handler(void)
+{
+	PIOS_USART_DMA_IRQ_Handler(USART1);
+}
+
 static const struct pios_usart_cfg pios_usart_main_cfg = {
 	.regs = USART1,
 	.remap = GPIO_AF_USART1,
@@ -818,6 +868,7 @@ static const struct pios_usart_cfg pios_usart_main_cfg = {
 			.GPIO_PuPd  = GPIO_PuPd_UP
 		},
 	},
+	.dma = &pios_usart_main_dma_cfg,
 };
 #endif /* PIOS_INCLUDE_COM_TELEM */
 
@@ -1183,6 +1234,35 @@ void I2C1_EV_IRQHandler()
     __attribute__ ((alias("PIOS_I2C_mag_pressure_adapter_ev_irq_handler")));
 void I2C1_ER_IRQHandler()
     __attribute__ ((alias("PIOS_I2C_mag_pressure_adapter_er_irq_handler")));
+void PIOS_I2C_mag_pressure_adapter_dma_irq_handler(void);
+void DMA1_Stream5_IRQHandler(void) __attribute__((alias("PIOS_I2C_mag_pressure_adapter_dma_irq_handler")));
+
+static const struct stm32_dma pios_i2c_mag_pressure_dma_cfg = {
+	.irq = {
+		.flags   = DMA_IT_TCIF5,
+		.init    = {
+			.NVIC_IRQChannel                   = DMA1_Stream5_IRQn,
+			.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_HIGHEST,
+			.NVIC_IRQChannelSubPriority        = 0,
+			.NVIC_IRQChannelCmd                = ENABLE,
+		},
+	},
+	.rx = {
+		.channel = DMA1_Stream5,
+		.init    = {
+			.DMA_Channel            = DMA_Channel_1,
+			.DMA_DIR                = DMA_DIR_PeripheralToMemory,
+			.DMA_PeripheralInc      = DMA_PeripheralInc_Disable,
+			.DMA_MemoryInc          = DMA_MemoryInc_Enable,
+			.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte,
+			.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte,
+			.DMA_Priority           = DMA_Priority_High,
+			.DMA_FIFOMode           = DMA_FIFOMode_Disable,
+			.DMA_MemoryBurst        = DMA_MemoryBurst_Single,
+			.DMA_PeripheralBurst    = DMA_PeripheralBurst_Single,
+		},
+	},
+};
 
 static const struct pios_i2c_adapter_cfg pios_i2c_mag_pressure_adapter_cfg = {
 	.regs = I2C1,
@@ -1234,6 +1314,7 @@ static const struct pios_i2c_adapter_cfg pios_i2c_mag_pressure_adapter_cfg = {
 			.NVIC_IRQChannelCmd = ENABLE,
 		},
 	},
+	.dma = &pios_i2c_mag_pressure_dma_cfg,
 };
 
 uint32_t pios_i2c_mag_pressure_adapter_id;
@@ -1249,6 +1330,12 @@ void PIOS_I2C_mag_pressure_adapter_er_irq_handler(void)
 	PIOS_I2C_ER_IRQ_Handler(pios_i2c_mag_pressure_adapter_id);
 }
 
+void PIOS_I2C_mag_pressure_adapter_dma_irq_handler(void)
+{
+	/* Call into the generic code to handle the IRQ for this specific device */
+	PIOS_I2C_DMA_IRQ_Handler(pios_i2c_mag_pressure_adapter_id);
+}
+
 
 void PIOS_I2C_flexiport_adapter_ev_irq_handler(void);
 void PIOS_I2C_flexiport_adapter_er_irq_handler(void);
@@ -443,6 +443,7 @@
 /*===========================================================================*/
 
 #include <stdint.h>
+#include "pios_trace.h"
 
 /**
  * @brief   Type of the realtime free counter value.
@@ -486,6 +487,9 @@ typedef uint32_t halrtcnt_t;
 #define THREAD_EXT_FIELDS                                                   \
   halrtcnt_t ticks_switched_in;                                             \
   halrtcnt_t ticks_total;                                                   \
+  halrtcnt_t ticks_ready;                                                   \
+  halrtcnt_t ticks_max_latency;                                             \
+  uint32_t switches;                                                        \
   /* Add threads custom fields here.*/
 #endif
 
@@ -498,6 +502,11 @@ typedef uint32_t halrtcnt_t;
  */
 #if !defined(THREAD_EXT_INIT_HOOK) || defined(__DOXYGEN__)
 #define THREAD_EXT_INIT_HOOK(tp) {                                          \
+  tp->ticks_switched_in = halGetCounterValue();                             \
+  tp->ticks_total = 0;                                                      \
+  tp->ticks_ready = 0;                                                      \
+  tp->ticks_max_latency = 0;                                                \
+  tp->switches = 0;                                                         \
   /* Add threads initialization code here.*/                                \
 }
 #endif
@@ -524,10 +533,31 @@ typedef uint32_t halrtcnt_t;
 #define THREAD_CONTEXT_SWITCH_HOOK(ntp, otp) {                              \
   ntp->ticks_switched_in = halGetCounterValue();                            \
   otp->ticks_total += ntp->ticks_switched_in - otp->ticks_switched_in;      \
+  ntp->switches++;                                                          \
+  PIOS_TRACE(PIOS_TRACE_THREAD_IN, ntp);                                    \
+  if (ntp->ticks_ready != 0) {                                              \
+    halrtcnt_t latency = ntp->ticks_switched_in - ntp->ticks_ready;         \
+    if (latency > ntp->ticks_max_latency)                                   \
+      ntp->ticks_max_latency = latency;                                     \
+    ntp->ticks_ready = 0;                                                   \
+  }                                                                         \
   /* System halt code here.*/                                               \
 }
 #endif
 
+/**
+ * @brief   Thread ready hook.
+ * @details This hook is invoked when a thread is inserted in the ready
+ *          list. Threads that were preempted are skipped so that only the
+ *          time from a wakeup to running is measured.
+ */
+#if !defined(THREAD_READY_HOOK) || defined(__DOXYGEN__)
+#define THREAD_READY_HOOK(tp) {                                             \
+  if (tp->p_state != THD_STATE_CURRENT)                                     \
+    tp->ticks_ready = halGetCounterValue() ? : 1;                           \
+}
+#endif
+
 /**
  * @brief   Idle Loop hook.
  * @details This hook is continuously invoked by the idle thread loop.
@@ -742,6 +742,41 @@ static const struct pios_tim_clock_cfg tim_3_brushless_cfg = {
 /* Brushless gimbal outputs */
 #include <pios_brushless_priv.h>
 
+/* The update events of TIM2 and TIM3 request DMA1 channels 2 and 3 */
+static const struct pios_brushless_dma pios_brushless_dma[] = {
+	{ // Motor 1 on TIM2
+		.ahb_clk = RCC_AHBPeriph_DMA1,
+		.channel = DMA1_Channel2,
+		.irq = {
+			.flags = (DMA1_FLAG_TC2 | DMA1_FLAG_TE2 | DMA1_FLAG_HT2 | DMA1_FLAG_GL2),
+			.init = {
+				.NVIC_IRQChannel                   = DMA1_Channel2_IRQn,
+				.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_HIGH,
+				.NVIC_IRQChannelSubPriority        = 0,
+				.NVIC_IRQChannelCmd                = ENABLE,
+			},
+		},
+		.half_flag = DMA1_FLAG_HT2,
+		.full_flag = DMA1_FLAG_TC2,
+	},
+	{ // Motor 2 on TIM3
+		.ahb_clk = RCC_AHBPeriph_DMA1,
+		.channel = DMA1_Channel3,
+		.irq = {
+			.flags = (DMA1_FLAG_TC3 | DMA1_FLAG_TE3 | DMA1_FLAG_HT3 | DMA1_FLAG_GL3),
+			.init = {
+				.NVIC_IRQChannel                   = DMA1_Channel3_IRQn,
+				.NVIC_IRQChannelPreemptionPriority = PIOS_IRQ_PRIO_HIGH,
+				.NVIC_IRQChannelSubPriority        = 0,
+				.NVIC_IRQChannelCmd                = ENABLE,
+			},
+		},
+		.half_flag = DMA1_FLAG_HT3,
+		.full_flag = DMA1_FLAG_TC3,
+	},
+};
+
+
 const struct pios_brushless_cfg pios_brushless_cfg = {
 	.tim_oc_init = {
 		.TIM_OCMode = TIM_OCMode_PWM1,
@@ -794,6 +829,8 @@ const struct pios_brushless_cfg pios_brushless_cfg = {
 	},
 	.channels = pios_tim_bgcport_v02_pins,
 	.num_channels = NELEMENTS(pios_tim_bgcport_v02_pins),
+	.dma = pios_brushless_dma,
+	.num_dma = NELEMENTS(pios_brushless_dma),
 };
 
 #endif
@@ -39,11 +39,15 @@
 #define PIOS_INCLUDE_I2C
 #define PIOS_INCLUDE_CAN
 #define WDG_STATS_DIAGNOSTICS
+//#define LATENCY_DIAGNOSTICS
+//#define HEAP_DIAGNOSTICS
+//#define MUTEX_DIAGNOSTICS
 #define PIOS_INCLUDE_IRQ
 #define PIOS_INCLUDE_LED
 #define PIOS_INCLUDE_IAP
 #define PIOS_INCLUDE_TIM
 #define PIOS_INCLUDE_BRUSHLESS
+#define PIOS_INCLUDE_DMA_CB_SUBSCRIBING_FUNCTION
 #define PIOS_INCLUDE_SYS
 #define PIOS_INCLUDE_USART
 #define PIOS_INCLUDE_USB
@@ -0,0 +1,272 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+
+#include "gtest/gtest.h"
+
+#include "autotunemodel.h"	/* API for the autotune solver */
+
+#include <functional>		/* std::function */
+#include <math.h>		/* exp, fabs */
+#include <stdlib.h>		/* rand */
+#include <thread>		/* std::thread */
+#include <vector>		/* std::vector */
+
+#define DT 0.002		/* 500 Hz log */
+#define SAMPLES 8000		/* 16 s of flight */
+#define BETA 10.0
+#define TAU 0.03
+#define DELAY 0.006
+
+#define SUBSTEPS 20		/* of the simulated airframe per log sample */
+
+/**
+ * Roll of the autotune flight. The airframe is the model of the solver,
+ * simulated much faster than the log. Each cycle samples the gyros and
+ * then holds its output until the next one, which adds half a cycle to
+ * the delay seen in the log. The output is a square wave on top of a weak
+ * rate loop that keeps the rate bounded, the gyros have some noise.
+ */
+static void flyAxis(double beta, double tau, double delay, std::vector<double> &output,
+		    std::vector<double> &gyro)
+{
+	const double h = DT / SUBSTEPS;
+	const double k = exp(beta);
+	const double lag = 1 - exp(-h / tau);
+	std::vector<double> pending((size_t) lround(delay / h), 0.0);
+
+	output.assign(SAMPLES, 0);
+	gyro.assign(SAMPLES, 0);
+
+	srand(42);
+	double rate = 0, filtered = 0, excitation = 0.1;
+	size_t step = 0;
+	for (size_t i = 0; i < SAMPLES; i++) {
+		gyro[i] = rate + (rand() / (double) RAND_MAX - 0.5);
+
+		if (rand() % 8 == 0)
+			excitation = -excitation;
+		output[i] = excitation - 0.002 * gyro[i];
+
+		for (int j = 0; j < SUBSTEPS; j++, step++) {
+			double delayed = pending[step % pending.size()];
+			pending[step % pending.size()] = output[i];
+
+			filtered += lag * (delayed - filtered);
+			rate += k * filtered * h;
+		}
+	}
+}
+
+/**
+ * The gains of the autotune page for a model without the delay, with its
+ * default sliders
+ */
+static AutotuneModel::Gains designGains(double beta, double tau, double &wn, double &tau_d)
+{
+	const double ghf = 0.01;
+	const double damp = 1.1;
+
+	wn = 1 / tau;
+	tau_d = 0;
+	for (int i = 0; i < 30; i++) {
+		tau_d = (2*damp*tau*wn - 1)/(4*tau*damp*damp*wn*wn - 2*damp*wn - tau*wn*wn + exp(beta)*ghf);
+		wn = (tau + tau_d) / (tau*tau_d) / (2 * damp + 2);
+	}
+
+	const double a = ((tau+tau_d) / tau / tau_d - 2 * damp * wn) / 20.0;
+	const double b = ((tau+tau_d) / tau / tau_d - 2 * damp * wn - a);
+	const double k = exp(beta);
+
+	AutotuneModel::Gains gains;
+	gains.ki = a * b * wn * wn * tau * tau_d / k;
+	gains.kp = tau * tau_d * ((a+b)*wn*wn + 2*a*b*damp*wn) / k - gains.ki*tau_d;
+	gains.kd = (tau * tau_d * (a*b + wn*wn + (a+b)*2*damp*wn) - 1) / k - gains.kp * tau_d;
+	return gains;
+}
+
+/**
+ * Runs the candidates on a few threads, like QtConcurrent does in the GCS
+ */
+static void threadedFor(int count, const std::function<void(int)> &body)
+{
+	const int threads = 4;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++) {
+		workers.push_back(std::thread([&body, count, t]() {
+			for (int i = t; i < count; i += threads)
+				body(i);
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); t++)
+		workers[t].join();
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class AutotuneIdentify : public testing::Test {
+protected:
+  virtual void SetUp() {
+    flyAxis(BETA, TAU, DELAY, output, gyro);
+  }
+
+  virtual void TearDown() {
+  }
+
+  std::vector<double> output;
+  std::vector<double> gyro;
+  std::vector<int> gaps;
+};
+
+TEST_F(AutotuneIdentify, FitsTheModel) {
+  AutotuneModel::Model model = AutotuneModel::identify(output, gyro, gaps, DT);
+
+  ASSERT_TRUE(model.valid);
+  EXPECT_NEAR(BETA, model.beta, 0.1);
+  EXPECT_NEAR(TAU, model.tau, 0.1 * TAU);
+  EXPECT_NEAR(DELAY + DT / 2, model.delay, 0.001);
+  EXPECT_LT(model.fitError, 0.05);
+  EXPECT_GT(model.coherence, 0.7);
+};
+
+TEST_F(AutotuneIdentify, SkipsGaps) {
+  // A stretch of the log that does not belong to the flight
+  for (size_t i = 3000; i < 3500; i++) {
+    output[i] = (rand() / (double) RAND_MAX - 0.5);
+    gyro[i] = 1000 * (rand() / (double) RAND_MAX - 0.5);
+  }
+  gaps.push_back(3000);
+  gaps.push_back(3500);
+
+  AutotuneModel::Model model = AutotuneModel::identify(output, gyro, gaps, DT);
+
+  ASSERT_TRUE(model.valid);
+  EXPECT_NEAR(BETA, model.beta, 0.1);
+  EXPECT_NEAR(TAU, model.tau, 0.1 * TAU);
+  EXPECT_NEAR(DELAY + DT / 2, model.delay, 0.001);
+};
+
+TEST_F(AutotuneIdentify, ThreadedIsTheSame) {
+  AutotuneModel::Model serial = AutotuneModel::identify(output, gyro, gaps, DT);
+  AutotuneModel::Model threaded = AutotuneModel::identify(output, gyro, gaps, DT, threadedFor);
+
+  ASSERT_TRUE(threaded.valid);
+  EXPECT_EQ(serial.beta, threaded.beta);
+  EXPECT_EQ(serial.tau, threaded.tau);
+  EXPECT_EQ(serial.delay, threaded.delay);
+  EXPECT_EQ(serial.fitError, threaded.fitError);
+};
+
+TEST_F(AutotuneIdentify, NotExcited) {
+  output.assign(output.size(), 0);
+  for (size_t i = 0; i < gyro.size(); i++)
+    gyro[i] = rand() / (double) RAND_MAX - 0.5;
+
+  EXPECT_FALSE(AutotuneModel::identify(output, gyro, gaps, DT).valid);
+};
+
+TEST_F(AutotuneIdentify, TooShort) {
+  output.resize(200);
+  gyro.resize(200);
+
+  EXPECT_FALSE(AutotuneModel::identify(output, gyro, gaps, DT).valid);
+};
+
+TEST_F(AutotuneIdentify, NoSampleTime) {
+  EXPECT_FALSE(AutotuneModel::identify(output, gyro, gaps, 0).valid);
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class AutotuneRefine : public testing::Test {
+protected:
+  virtual void SetUp() {
+    model.valid = true;
+    model.beta = BETA;
+    model.tau = TAU;
+    model.delay = DELAY;
+    model.fitError = 0;
+    model.coherence = 1;
+    initial = designGains(BETA, TAU, wn, tau_d);
+    cutoff = 1 / (2 * M_PI * tau_d);
+  }
+
+  virtual void TearDown() {
+  }
+
+  AutotuneModel::Model model;
+  AutotuneModel::Gains initial;
+  double wn;
+  double tau_d;
+  double cutoff;
+};
+
+TEST_F(AutotuneRefine, NoDelayKeepsTheGains) {
+  model.delay = 0;
+  AutotuneModel::Gains gains = AutotuneModel::refine(model, DT, initial, cutoff, 1, wn);
+
+  EXPECT_EQ(initial.kp, gains.kp);
+  EXPECT_EQ(initial.ki, gains.ki);
+  EXPECT_EQ(initial.kd, gains.kd);
+};
+
+TEST_F(AutotuneRefine, InvalidModelKeepsTheGains) {
+  model.valid = false;
+  AutotuneModel::Gains gains = AutotuneModel::refine(model, DT, initial, cutoff, 1, wn);
+
+  EXPECT_EQ(initial.kp, gains.kp);
+  EXPECT_EQ(initial.ki, gains.ki);
+  EXPECT_EQ(initial.kd, gains.kd);
+};
+
+TEST_F(AutotuneRefine, DelayChangesTheGains) {
+  model.delay = 0.01;
+  AutotuneModel::Gains gains = AutotuneModel::refine(model, DT, initial, cutoff, 1, wn);
+
+  EXPECT_FALSE(gains.kp == initial.kp && gains.ki == initial.ki && gains.kd == initial.kd);
+
+  // Within the multipliers searched, Kd is never raised
+  EXPECT_GE(gains.kp, 0.5 * initial.kp - 1e-12);
+  EXPECT_LE(gains.kp, 1.5 * initial.kp + 1e-12);
+  EXPECT_GE(gains.ki, 0.5 * initial.ki - 1e-12);
+  EXPECT_LE(gains.ki, 1.5 * initial.ki + 1e-12);
+  EXPECT_GE(gains.kd, 0.5 * initial.kd - 1e-12);
+  EXPECT_LE(gains.kd, initial.kd + 1e-12);
+};
+
+TEST_F(AutotuneRefine, ThreadedIsTheSame) {
+  AutotuneModel::Gains serial = AutotuneModel::refine(model, DT, initial, cutoff, 1, wn);
+  AutotuneModel::Gains threaded = AutotuneModel::refine(model, DT, initial, cutoff, 1, wn, threadedFor);
+
+  EXPECT_EQ(serial.kp, threaded.kp);
+  EXPECT_EQ(serial.ki, threaded.ki);
+  EXPECT_EQ(serial.kd, threaded.kd);
+};
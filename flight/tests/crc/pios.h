@@ -0,0 +1,8 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* Minimal PIOS environment for the CRC unit test */
+#include <stdint.h>
+#include <pios_crc.h>
+
+#endif /* PIOS_H */
@@ -0,0 +1,145 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "pios_crc.h"		/* API for the CRCs */
+
+}
+
+/* Bit at a time versions of the CRCs, to check the tables against */
+static uint8_t crc8_bitwise(uint8_t crc, const uint8_t *data, int32_t length)
+{
+  for (int32_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+static uint16_t crc16_bitwise(uint16_t crc, const uint8_t *data, int32_t length)
+{
+  for (int32_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x0001) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+  }
+  return crc;
+}
+
+static uint32_t crc32_bitwise(uint32_t crc, const uint8_t *data, int32_t length)
+{
+  for (int32_t i = 0; i < length; i++) {
+    crc ^= (uint32_t)data[i] << 24;
+    for (int bit = 0; bit < 8; bit++)
+      crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+  }
+  return crc;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class CRC : public testing::Test {
+protected:
+  virtual void SetUp() {
+    for (uint32_t i = 0; i < sizeof(buf); i++)
+      buf[i] = (uint8_t)(i * 151 + 17);
+  }
+
+  uint8_t buf[300];
+};
+
+TEST_F(CRC, CheckValues) {
+  const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+
+  EXPECT_EQ(0xF4, PIOS_CRC_updateCRC(0, check, sizeof(check)));
+  EXPECT_EQ(0x2189, PIOS_CRC16_updateCRC(0, check, sizeof(check)));
+  EXPECT_EQ(0x89A1897Fu, PIOS_CRC32_updateCRC(0, check, sizeof(check)));
+}
+
+TEST_F(CRC, EmptyBuffer) {
+  EXPECT_EQ(0x5A, PIOS_CRC_updateCRC(0x5A, buf, 0));
+  EXPECT_EQ(0x5AA5, PIOS_CRC16_updateCRC(0x5AA5, buf, 0));
+  EXPECT_EQ(0x5AA5C33Cu, PIOS_CRC32_updateCRC(0x5AA5C33C, buf, 0));
+}
+
+TEST_F(CRC, MatchesBitwise) {
+  // Every length and alignment, so that the tails of the sliced loops are covered
+  for (int32_t offset = 0; offset < 4; offset++) {
+    for (int32_t length = 0; length < 260; length++) {
+      const uint8_t *data = buf + offset;
+
+      EXPECT_EQ(crc8_bitwise(0, data, length), PIOS_CRC_updateCRC(0, data, length));
+      EXPECT_EQ(crc16_bitwise(0, data, length), PIOS_CRC16_updateCRC(0, data, length));
+      EXPECT_EQ(crc32_bitwise(0, data, length), PIOS_CRC32_updateCRC(0, data, length));
+    }
+  }
+}
+
+TEST_F(CRC, StartingValue) {
+  for (int32_t length = 0; length < 40; length++) {
+    EXPECT_EQ(crc8_bitwise(0xA7, buf, length), PIOS_CRC_updateCRC(0xA7, buf, length));
+    EXPECT_EQ(crc16_bitwise(0xBEEF, buf, length), PIOS_CRC16_updateCRC(0xBEEF, buf, length));
+    EXPECT_EQ(crc32_bitwise(0xDEADBEEF, buf, length), PIOS_CRC32_updateCRC(0xDEADBEEF, buf, length));
+  }
+}
+
+TEST_F(CRC, MatchesByteUpdates) {
+  // A packet checked in pieces, as UAVTalk does on receive, gives the same CRC
+  uint8_t crc8 = 0;
+  uint16_t crc16 = 0;
+  uint32_t crc32 = 0;
+  for (uint32_t i = 0; i < sizeof(buf); i++) {
+    crc8 = PIOS_CRC_updateByte(crc8, buf[i]);
+    crc16 = PIOS_CRC16_updateByte(crc16, buf[i]);
+    crc32 = PIOS_CRC32_updateByte(crc32, buf[i]);
+  }
+
+  EXPECT_EQ(crc8, PIOS_CRC_updateCRC(0, buf, sizeof(buf)));
+  EXPECT_EQ(crc16, PIOS_CRC16_updateCRC(0, buf, sizeof(buf)));
+  EXPECT_EQ(crc32, PIOS_CRC32_updateCRC(0, buf, sizeof(buf)));
+
+  EXPECT_EQ(crc8, PIOS_CRC_updateCRC(PIOS_CRC_updateCRC(0, buf, 7), buf + 7, sizeof(buf) - 7));
+  EXPECT_EQ(crc16, PIOS_CRC16_updateCRC(PIOS_CRC16_updateCRC(0, buf, 7), buf + 7, sizeof(buf) - 7));
+  EXPECT_EQ(crc32, PIOS_CRC32_updateCRC(PIOS_CRC32_updateCRC(0, buf, 7), buf + 7, sizeof(buf) - 7));
+}
+
+/**
+ * @}
+ * @}
+ */
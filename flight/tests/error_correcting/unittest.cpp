@@ -57,6 +57,8 @@ protected:
 
   virtual void TearDown() {
   }
+
+  struct rs_decoder dec;
 };
 
 TEST_F(EncodeDecode, EmptyEncode) {
@@ -81,8 +83,8 @@ TEST_F(EncodeDecode, CorrectEncode) {
 TEST_F(EncodeDecode, PassEncode) {
   unsigned char p[10] = {'a', 'b', 'c', 'd', 'e', 'f'};
   encode_data(p, 6, p);
-  decode_data(p, 6 + RS_ECC_NPARITY);
-  EXPECT_EQ(0, check_syndrome());
+  decode_data(&dec, p, 6 + RS_ECC_NPARITY);
+  EXPECT_EQ(0, check_syndrome(&dec));
 };
 
 TEST_F(EncodeDecode, Recover) {
@@ -94,13 +96,105 @@ TEST_F(EncodeDecode, Recover) {
   p2[4] = 30;
 
   // verify it flags the error
-  decode_data(p2, 6 + RS_ECC_NPARITY);
-  EXPECT_EQ(1, check_syndrome());
+  decode_data(&dec, p2, 6 + RS_ECC_NPARITY);
+  EXPECT_EQ(1, check_syndrome(&dec));
 
   // verify it is corrected
-  EXPECT_EQ(1, correct_errors_erasures(p2, 10, 0, 0));
+  EXPECT_EQ(1, correct_errors_erasures(&dec, p2, 10, 0, 0));
 
   for (int i = 0; i < 6; i++)
     EXPECT_EQ(p[i], p2[i]);
 
 };
+
+TEST_F(EncodeDecode, CleanPacketUntouched) {
+  unsigned char p[10] = {'a', 'b', 'c', 'd', 'e', 'f'};
+  encode_data(p, 6, p);
+  unsigned char p2[10];
+  memcpy(p2, p, sizeof(p));
+
+  // a zero syndrome is accepted without looking for errors
+  decode_data(&dec, p2, 10);
+  EXPECT_EQ(1, correct_errors_erasures(&dec, p2, 10, 0, 0));
+  EXPECT_EQ(0, memcmp(p, p2, sizeof(p)));
+};
+
+TEST_F(EncodeDecode, RecoverTwoErrors) {
+  unsigned char p[64 + RS_ECC_NPARITY];
+  for (int i = 0; i < 64; i++)
+    p[i] = i * 7 + 3;
+  encode_data(p, 64, p);
+
+  unsigned char p2[sizeof(p)];
+  memcpy(p2, p, sizeof(p));
+  p2[0] ^= 0x55;
+  p2[64 + 1] ^= 0x01;
+
+  decode_data(&dec, p2, sizeof(p2));
+  EXPECT_EQ(1, check_syndrome(&dec));
+  EXPECT_EQ(1, correct_errors_erasures(&dec, p2, sizeof(p2), 0, 0));
+  EXPECT_EQ(0, memcmp(p, p2, sizeof(p)));
+};
+
+TEST_F(EncodeDecode, RecoverErasures) {
+  unsigned char p[20 + RS_ECC_NPARITY];
+  for (int i = 0; i < 20; i++)
+    p[i] = 'A' + i;
+  encode_data(p, 20, p);
+
+  unsigned char p2[sizeof(p)];
+  memcpy(p2, p, sizeof(p));
+
+  // one unknown error and two erasures, located from the end
+  p2[2] ^= 0x35;
+  p2[16] = 0;
+  p2[18] = 0;
+  int erasures[2] = { (int)sizeof(p2) - 17, (int)sizeof(p2) - 19 };
+
+  decode_data(&dec, p2, sizeof(p2));
+  EXPECT_EQ(1, correct_errors_erasures(&dec, p2, sizeof(p2), 2, erasures));
+  EXPECT_EQ(0, memcmp(p, p2, sizeof(p)));
+};
+
+TEST_F(EncodeDecode, IndependentDecoders) {
+  unsigned char a[10] = {'a', 'b', 'c', 'd', 'e', 'f'};
+  unsigned char b[10] = {'u', 'v', 'w', 'x', 'y', 'z'};
+  encode_data(a, 6, a);
+  encode_data(b, 6, b);
+
+  unsigned char a2[10], b2[10];
+  memcpy(a2, a, sizeof(a));
+  memcpy(b2, b, sizeof(b));
+  a2[1] ^= 0x10;
+  b2[5] ^= 0x80;
+
+  // the syndrome of one link must survive decoding on another
+  struct rs_decoder dec_b;
+  decode_data(&dec, a2, 10);
+  decode_data(&dec_b, b2, 10);
+
+  EXPECT_EQ(1, correct_errors_erasures(&dec, a2, 10, 0, 0));
+  EXPECT_EQ(1, correct_errors_erasures(&dec_b, b2, 10, 0, 0));
+  EXPECT_EQ(0, memcmp(a, a2, sizeof(a)));
+  EXPECT_EQ(0, memcmp(b, b2, sizeof(b)));
+};
+
+TEST_F(EncodeDecode, TooManyErrorsNotMiscorrected) {
+  unsigned char p[10] = {'a', 'b', 'c', 'd', 'e', 'f'};
+  encode_data(p, 6, p);
+
+  // three errors are more than four parity bytes correct, the decoder
+  // must not claim a correction that leaves the packet wrong
+  unsigned char p2[10];
+  memcpy(p2, p, sizeof(p));
+  p2[0] ^= 0x01;
+  p2[3] ^= 0x22;
+  p2[7] ^= 0x43;
+
+  decode_data(&dec, p2, 10);
+  EXPECT_EQ(1, check_syndrome(&dec));
+  if (correct_errors_erasures(&dec, p2, 10, 0, 0)) {
+    decode_data(&dec, p2, 10);
+    EXPECT_EQ(0, check_syndrome(&dec));
+  }
+};
@@ -0,0 +1,235 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "fifo_buffer.h"	/* API for the fifo buffer */
+
+}
+
+#define FIFO_SIZE 16
+
+// To use a test fixture, derive a class from testing::Test.
+class FifoBuffer : public testing::Test {
+protected:
+  virtual void SetUp() {
+    memset(storage, 0, sizeof(storage));
+    fifoBuf_init(&fifo, storage, sizeof(storage));
+  }
+
+  virtual void TearDown() {
+  }
+
+  uint8_t storage[FIFO_SIZE];
+  t_fifo_buffer fifo;
+};
+
+TEST_F(FifoBuffer, PutGetRoundTrip) {
+  const uint8_t in[5] = { 1, 2, 3, 4, 5 };
+  uint8_t out[5];
+
+  EXPECT_EQ(FIFO_SIZE - 1, fifoBuf_getFree(&fifo));
+  EXPECT_EQ(5, fifoBuf_putData(&fifo, in, sizeof(in)));
+  EXPECT_EQ(5, fifoBuf_getUsed(&fifo));
+  EXPECT_EQ(5, fifoBuf_getData(&fifo, out, sizeof(out)));
+  EXPECT_EQ(0, memcmp(in, out, sizeof(in)));
+  EXPECT_EQ(0, fifoBuf_getUsed(&fifo));
+};
+
+TEST_F(FifoBuffer, ReserveIsInvisibleUntilCommit) {
+  uint8_t *space = fifoBuf_reserve(&fifo, 4);
+  ASSERT_TRUE(space != NULL);
+
+  memcpy(space, "abcd", 4);
+  EXPECT_EQ(0, fifoBuf_getUsed(&fifo));
+
+  fifoBuf_commit(&fifo, 4);
+  EXPECT_EQ(4, fifoBuf_getUsed(&fifo));
+
+  char out[4];
+  EXPECT_EQ(4, fifoBuf_getData(&fifo, out, sizeof(out)));
+  EXPECT_EQ(0, memcmp("abcd", out, 4));
+};
+
+TEST_F(FifoBuffer, CommitLessThanReserved) {
+  uint8_t *space = fifoBuf_reserve(&fifo, 8);
+  ASSERT_TRUE(space != NULL);
+
+  space[0] = 0x3c;
+  fifoBuf_commit(&fifo, 1);
+  EXPECT_EQ(1, fifoBuf_getUsed(&fifo));
+  EXPECT_EQ(0x3c, fifoBuf_getByte(&fifo));
+
+  // An empty commit releases the reservation without adding data
+  ASSERT_TRUE(fifoBuf_reserve(&fifo, 8) != NULL);
+  fifoBuf_commit(&fifo, 0);
+  EXPECT_EQ(0, fifoBuf_getUsed(&fifo));
+};
+
+TEST_F(FifoBuffer, ReserveMoreThanFree) {
+  EXPECT_TRUE(fifoBuf_reserve(&fifo, FIFO_SIZE) == NULL);
+  EXPECT_TRUE(fifoBuf_reserve(&fifo, FIFO_SIZE - 1) != NULL);
+
+  uint8_t fill[10] = { 0 };
+  fifoBuf_putData(&fifo, fill, sizeof(fill));
+  EXPECT_TRUE(fifoBuf_reserve(&fifo, 6) == NULL);
+  EXPECT_TRUE(fifoBuf_reserve(&fifo, 5) != NULL);
+};
+
+TEST_F(FifoBuffer, ReserveDoesNotWrap) {
+  uint8_t fill[12] = { 0 };
+  uint8_t out[12];
+
+  // Move the write position close to the end of the storage
+  fifoBuf_putData(&fifo, fill, sizeof(fill));
+  fifoBuf_getData(&fifo, out, sizeof(out));
+  EXPECT_EQ(FIFO_SIZE - 1, fifoBuf_getFree(&fifo));
+
+  // There is room, but only 4 contiguous bytes before the end
+  EXPECT_TRUE(fifoBuf_reserve(&fifo, 5) == NULL);
+
+  uint8_t *space = fifoBuf_reserve(&fifo, 4);
+  ASSERT_TRUE(space == &storage[12]);
+  memcpy(space, "wxyz", 4);
+  fifoBuf_commit(&fifo, 4);
+
+  // The write position wrapped to the start of the storage
+  EXPECT_TRUE(fifoBuf_reserve(&fifo, 8) == &storage[0]);
+
+  char check[4];
+  EXPECT_EQ(4, fifoBuf_getData(&fifo, check, sizeof(check)));
+  EXPECT_EQ(0, memcmp("wxyz", check, 4));
+};
+
+TEST_F(FifoBuffer, PeekContiguous) {
+  uint8_t *data;
+
+  EXPECT_EQ(0, fifoBuf_peekContiguous(&fifo, &data));
+
+  fifoBuf_putData(&fifo, "abcdef", 6);
+  EXPECT_EQ(6, fifoBuf_peekContiguous(&fifo, &data));
+  EXPECT_TRUE(data == &storage[0]);
+  EXPECT_EQ(0, memcmp("abcdef", data, 6));
+
+  // Peeking leaves the data in the buffer until it is removed
+  EXPECT_EQ(6, fifoBuf_getUsed(&fifo));
+  fifoBuf_removeData(&fifo, 2);
+  EXPECT_EQ(4, fifoBuf_peekContiguous(&fifo, &data));
+  EXPECT_EQ('c', data[0]);
+};
+
+TEST_F(FifoBuffer, PeekContiguousStopsAtEnd) {
+  uint8_t fill[12] = { 0 };
+  uint8_t *data;
+
+  fifoBuf_putData(&fifo, fill, sizeof(fill));
+  fifoBuf_removeData(&fifo, sizeof(fill));
+
+  // Wraps around, only the part before the end is contiguous
+  fifoBuf_putData(&fifo, "0123456789", 10);
+  EXPECT_EQ(4, fifoBuf_peekContiguous(&fifo, &data));
+  EXPECT_TRUE(data == &storage[12]);
+  EXPECT_EQ(0, memcmp("0123", data, 4));
+
+  fifoBuf_removeData(&fifo, 4);
+  EXPECT_EQ(6, fifoBuf_peekContiguous(&fifo, &data));
+  EXPECT_TRUE(data == &storage[0]);
+  EXPECT_EQ(0, memcmp("456789", data, 6));
+};
+
+TEST_F(FifoBuffer, ReserveContiguous) {
+  uint8_t *space;
+
+  // An empty buffer at the start keeps one byte free
+  EXPECT_EQ(FIFO_SIZE - 1, fifoBuf_reserveContiguous(&fifo, &space));
+  EXPECT_TRUE(space == &storage[0]);
+
+  fifoBuf_putData(&fifo, "abcdefgh", 8);
+  fifoBuf_removeData(&fifo, 4);
+
+  // Up to the end of the storage, the start is free but not contiguous
+  EXPECT_EQ(FIFO_SIZE - 8, fifoBuf_reserveContiguous(&fifo, &space));
+  EXPECT_TRUE(space == &storage[8]);
+  memset(space, 'x', FIFO_SIZE - 8);
+  fifoBuf_commit(&fifo, FIFO_SIZE - 8);
+
+  // Then up to the byte before the read position
+  EXPECT_EQ(3, fifoBuf_reserveContiguous(&fifo, &space));
+  EXPECT_TRUE(space == &storage[0]);
+  fifoBuf_commit(&fifo, 3);
+
+  EXPECT_EQ(0, fifoBuf_getFree(&fifo));
+  EXPECT_EQ(0, fifoBuf_reserveContiguous(&fifo, &space));
+};
+
+TEST_F(FifoBuffer, ContiguousStreaming) {
+  uint8_t in[100], out[100];
+  uint16_t put = 0, got = 0;
+
+  for (uint16_t i = 0; i < sizeof(in); i++)
+    in[i] = i * 3;
+
+  // Producer and consumer only ever touch the storage in place
+  while (got < sizeof(out)) {
+    uint8_t *p;
+    uint16_t n = fifoBuf_reserveContiguous(&fifo, &p);
+    if (n > 5)
+      n = 5;
+    if (n > sizeof(in) - put)
+      n = sizeof(in) - put;
+    memcpy(p, &in[put], n);
+    fifoBuf_commit(&fifo, n);
+    put += n;
+
+    n = fifoBuf_peekContiguous(&fifo, &p);
+    if (n > 3)
+      n = 3;
+    memcpy(&out[got], p, n);
+    fifoBuf_removeData(&fifo, n);
+    got += n;
+  }
+
+  EXPECT_EQ(0, memcmp(in, out, sizeof(in)));
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,149 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "geofence_index.h"	/* API for the polygon geofence index */
+
+}
+
+#include <math.h>		/* fabs() */
+
+// To use a test fixture, derive a class from testing::Test.
+class GeofenceIndex : public testing::Test {
+protected:
+  virtual void SetUp() {
+    geofence_index_clear(&idx);
+  }
+
+  virtual void TearDown() {
+  }
+
+  struct geofence_index idx;
+};
+
+// A 100 m square around home
+static const float square_north[] = { -50, -50, 50, 50 };
+static const float square_east[] = { -50, 50, 50, -50 };
+
+TEST_F(GeofenceIndex, Empty) {
+  geofence_index_build(&idx);
+
+  EXPECT_TRUE(geofence_index_valid(&idx));
+  EXPECT_FALSE(geofence_index_violated(&idx, 0, 0));
+  EXPECT_FALSE(geofence_index_violated(&idx, 10000, -10000));
+  EXPECT_EQ(20, geofence_index_distance(&idx, 0, 0, 20));
+};
+
+TEST_F(GeofenceIndex, KeepIn) {
+  ASSERT_EQ(0, geofence_index_add_polygon(&idx, GEOFENCE_KEEP_IN, square_north, square_east, 4));
+  geofence_index_build(&idx);
+  ASSERT_TRUE(geofence_index_valid(&idx));
+
+  EXPECT_FALSE(geofence_index_violated(&idx, 0, 0));
+  EXPECT_FALSE(geofence_index_violated(&idx, 49, -49));
+  EXPECT_TRUE(geofence_index_violated(&idx, 51, 0));
+  EXPECT_TRUE(geofence_index_violated(&idx, 0, -51));
+  EXPECT_TRUE(geofence_index_violated(&idx, -1000, 0));
+
+  EXPECT_NEAR(10, geofence_index_distance(&idx, 40, 0, 20), 1e-4);
+  EXPECT_NEAR(5, geofence_index_distance(&idx, 0, 55, 20), 1e-4);
+  EXPECT_NEAR(sqrtf(50), geofence_index_distance(&idx, 55, 55, 20), 1e-4);
+  EXPECT_EQ(20, geofence_index_distance(&idx, 0, 0, 20));
+};
+
+TEST_F(GeofenceIndex, KeepOut) {
+  ASSERT_EQ(0, geofence_index_add_polygon(&idx, GEOFENCE_KEEP_IN, square_north, square_east, 4));
+
+  // A triangle inside the square, given the other way around
+  const float north[] = { 10, 30, 10 };
+  const float east[] = { 10, 20, 30 };
+  ASSERT_EQ(0, geofence_index_add_polygon(&idx, GEOFENCE_KEEP_OUT, north, east, 3));
+  geofence_index_build(&idx);
+  ASSERT_TRUE(geofence_index_valid(&idx));
+
+  EXPECT_FALSE(geofence_index_violated(&idx, 0, 0));
+  EXPECT_TRUE(geofence_index_violated(&idx, 15, 20));
+  EXPECT_FALSE(geofence_index_violated(&idx, 15, 40));
+  EXPECT_TRUE(geofence_index_violated(&idx, 60, 20));
+};
+
+TEST_F(GeofenceIndex, ManyVertices) {
+  // A circle of 100 m radius with as many vertices as fit
+  float north[GEOFENCE_MAX_VERTICES];
+  float east[GEOFENCE_MAX_VERTICES];
+  for (int i = 0; i < GEOFENCE_MAX_VERTICES; i++) {
+    north[i] = 100 * cosf(2 * M_PI * i / GEOFENCE_MAX_VERTICES);
+    east[i] = 100 * sinf(2 * M_PI * i / GEOFENCE_MAX_VERTICES);
+  }
+
+  ASSERT_EQ(0, geofence_index_add_polygon(&idx, GEOFENCE_KEEP_IN, north, east, GEOFENCE_MAX_VERTICES));
+  EXPECT_EQ(-1, geofence_index_add_polygon(&idx, GEOFENCE_KEEP_OUT, square_north, square_east, 4));
+  geofence_index_build(&idx);
+  ASSERT_TRUE(geofence_index_valid(&idx));
+
+  // Each band only holds its share of the edges
+  EXPECT_GT(idx.num_bands, 1);
+  for (int b = 0; b < idx.num_bands; b++)
+    EXPECT_LE(idx.band_start[b + 1] - idx.band_start[b], 16);
+
+  for (float north = -120; north <= 120; north += 7) {
+    for (float east = -120; east <= 120; east += 7) {
+      float r = sqrtf(north * north + east * east);
+      if (fabs(r - 100) < 2)
+        continue;
+      EXPECT_EQ(r > 100, geofence_index_violated(&idx, north, east)) << north << " " << east;
+    }
+  }
+};
+
+TEST_F(GeofenceIndex, Invalid) {
+  const float line[] = { 0, 10 };
+  EXPECT_EQ(-1, geofence_index_add_polygon(&idx, GEOFENCE_KEEP_IN, line, line, 2));
+
+  ASSERT_EQ(0, geofence_index_add_polygon(&idx, GEOFENCE_KEEP_IN, square_north, square_east, 4));
+  EXPECT_FALSE(geofence_index_valid(&idx));
+
+  geofence_index_build(&idx);
+  EXPECT_TRUE(geofence_index_valid(&idx));
+
+  idx.band_edges[0] = GEOFENCE_MAX_VERTICES;
+  EXPECT_FALSE(geofence_index_valid(&idx));
+};
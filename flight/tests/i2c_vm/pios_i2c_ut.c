@@ -1,6 +1,29 @@
 #include "pios.h"
 
+/* The last transfer, for the tests to check */
+uint32_t i2c_ut_num_txns;
+uint16_t i2c_ut_addr[2];
+bool i2c_ut_write[2];
+uint32_t i2c_ut_len[2];
+uint8_t i2c_ut_written[8];
+
 int32_t PIOS_I2C_Transfer(uint32_t i2c_id, const struct pios_i2c_txn txn_list[], uint32_t num_txns)
 {
+	i2c_ut_num_txns = num_txns;
+
+	for (uint32_t i = 0; i < num_txns && i < NELEMENTS(i2c_ut_addr); i++) {
+		i2c_ut_addr[i] = txn_list[i].addr;
+		i2c_ut_write[i] = (txn_list[i].rw == PIOS_I2C_TXN_WRITE);
+		i2c_ut_len[i] = txn_list[i].len;
+
+		if (txn_list[i].rw == PIOS_I2C_TXN_WRITE) {
+			memcpy(i2c_ut_written, txn_list[i].buf, txn_list[i].len);
+		} else {
+			/* The device answers with the offsets of the bytes */
+			for (uint32_t j = 0; j < txn_list[i].len; j++)
+				txn_list[i].buf[j] = 0xA0 + j;
+		}
+	}
+
 	return 0;
 }
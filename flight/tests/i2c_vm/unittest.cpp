@@ -45,6 +45,13 @@ extern bool i2c_vm_run (const uint32_t * code, uint8_t code_len, uintptr_t i2c_a
 
 #include "i2cvm.h"		// uavo_data
 
+/* What the stub of PIOS_I2C_Transfer saw last */
+extern uint32_t i2c_ut_num_txns;
+extern uint16_t i2c_ut_addr[2];
+extern bool i2c_ut_write[2];
+extern uint32_t i2c_ut_len[2];
+extern uint8_t i2c_ut_written[8];
+
 }
 
 #define NELEMENTS(x) (sizeof(x) / sizeof(*x))
@@ -800,3 +807,69 @@ TEST_F(I2CVMTest, CleanReboot) {
 
   EXPECT_EQ(0, memcmp(ram2, uavo_data.ram, sizeof(ram)));
 }
+
+TEST_F(I2CVMTest, ReadRegIsOneTransfer) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_DEV_ADDR(0x1C),
+    I2C_VM_ASM_READ_REG_I2C(0x03, 2, 3),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+
+  /* Register address written, then read with a repeated start */
+  ASSERT_EQ(2U, i2c_ut_num_txns);
+  EXPECT_EQ(0x1C, i2c_ut_addr[0]);
+  EXPECT_TRUE(i2c_ut_write[0]);
+  EXPECT_EQ(1U, i2c_ut_len[0]);
+  EXPECT_EQ(0x03, i2c_ut_written[0]);
+  EXPECT_EQ(0x1C, i2c_ut_addr[1]);
+  EXPECT_FALSE(i2c_ut_write[1]);
+  EXPECT_EQ(3U, i2c_ut_len[1]);
+
+  const uint8_t ram[I2CVM_RAM_NUMELEMENTS] = {
+    0x00, 0x00, 0xA0, 0xA1, 0xA2, 0x00, 0x00, 0x00,
+  };
+
+  EXPECT_EQ(0, memcmp(ram, uavo_data.ram, sizeof(ram)));
+}
+
+TEST_F(I2CVMTest, ReadRegBadAddress) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_READ_REG_I2C(0x03, sizeof(uavo_data.ram) - 1, 2),
+  };
+
+  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+}
+
+TEST_F(I2CVMTest, WriteReg) {
+  const uint32_t program[] = {
+    I2C_VM_ASM_SET_DEV_ADDR(0x77),
+    I2C_VM_ASM_WRITE_REG_I2C(0xF4, 0x2E),
+    I2C_VM_ASM_SEND_UAVO(),
+  };
+
+  EXPECT_TRUE(i2c_vm_run (program, NELEMENTS(program), 0));
+
+  ASSERT_EQ(1U, i2c_ut_num_txns);
+  EXPECT_EQ(0x77, i2c_ut_addr[0]);
+  EXPECT_TRUE(i2c_ut_write[0]);
+  EXPECT_EQ(2U, i2c_ut_len[0]);
+  EXPECT_EQ(0xF4, i2c_ut_written[0]);
+  EXPECT_EQ(0x2E, i2c_ut_written[1]);
+
+  /* VM RAM is not touched */
+  const uint8_t ram[I2CVM_RAM_NUMELEMENTS] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  };
+
+  EXPECT_EQ(0, memcmp(ram, uavo_data.ram, sizeof(ram)));
+}
+
+TEST_F(I2CVMTest, OpCodePastHandlers) {
+  const uint32_t program[] = {
+    I2C_VM_ASM((I2C_VM_OP_WRITE_REG + 1), 0, 0, 0),
+  };
+
+  EXPECT_FALSE(i2c_vm_run (program, NELEMENTS(program), 0));
+}
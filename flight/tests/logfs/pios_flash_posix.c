@@ -2,6 +2,7 @@
 #include <stdio.h>		/* fopen/fread/fwrite/fseek */
 #include <assert.h>		/* assert */
 #include <string.h>		/* memset */
+#include <sys/mman.h>		/* mmap/munmap */
 
 #include <stdbool.h>
 #include "pios_heap.h"
@@ -17,6 +18,7 @@ struct flash_posix_dev {
 	const struct pios_flash_posix_cfg * cfg;
 	bool transaction_in_progress;
 	FILE * flash_file;
+	uint8_t * mapped;
 };
 
 static struct flash_posix_dev * PIOS_Flash_Posix_Alloc(void)
@@ -52,6 +54,15 @@ int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix
 		return -2;
 	}
 
+	flash_dev->mapped = NULL;
+	if (cfg->mapped) {
+		void * map = mmap(NULL, cfg->size_of_flash, PROT_READ, MAP_SHARED, fileno(flash_dev->flash_file), 0);
+		if (map == MAP_FAILED) {
+			return -3;
+		}
+		flash_dev->mapped = map;
+	}
+
 	*chip_id = (uintptr_t)flash_dev;
 
 	return 0;
@@ -61,6 +72,10 @@ void PIOS_Flash_Posix_Destroy(uintptr_t chip_id)
 {
 	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
 
+	if (flash_dev->mapped) {
+		munmap(flash_dev->mapped, flash_dev->cfg->size_of_flash);
+	}
+
 	fclose(flash_dev->flash_file);
 
 	free(flash_dev);
@@ -114,6 +129,9 @@ static int32_t PIOS_Flash_Posix_EraseSector(uintptr_t chip_id, uint32_t chip_sec
 
 	free(buf);
 
+	/* Make the erase visible through the mapping */
+	fflush(flash_dev->flash_file);
+
 	assert (s == flash_dev->cfg->size_of_sector);
 
 	return 0;
@@ -137,6 +155,9 @@ static int32_t PIOS_Flash_Posix_WriteData(uintptr_t chip_id, uint32_t chip_offse
 
 	assert (s == len);
 
+	/* Make the write visible through the mapping */
+	fflush(flash_dev->flash_file);
+
 	return 0;
 }
 
@@ -161,6 +182,19 @@ static int32_t PIOS_Flash_Posix_ReadData(uintptr_t chip_id, uint32_t chip_offset
 	return 0;
 }
 
+static const uint8_t * PIOS_Flash_Posix_MapData(uintptr_t chip_id, uint32_t chip_offset, uint32_t len)
+{
+	struct flash_posix_dev * flash_dev = (struct flash_posix_dev *)chip_id;
+
+	if (flash_dev->mapped == NULL) {
+		return NULL;
+	}
+
+	assert (chip_offset + len <= flash_dev->cfg->size_of_flash);
+
+	return flash_dev->mapped + chip_offset;
+}
+
 /* Provide a flash driver to external drivers */
 const struct pios_flash_driver pios_posix_flash_driver = {
 	.start_transaction = PIOS_Flash_Posix_StartTransaction,
@@ -168,5 +202,6 @@ const struct pios_flash_driver pios_posix_flash_driver = {
 	.erase_sector      = PIOS_Flash_Posix_EraseSector,
 	.write_data        = PIOS_Flash_Posix_WriteData,
 	.read_data         = PIOS_Flash_Posix_ReadData,
+	.map_data          = PIOS_Flash_Posix_MapData,
 };
 
@@ -1,8 +1,10 @@
 #include <stdint.h>
+#include <stdbool.h>
 
 struct pios_flash_posix_cfg {
 	uint32_t size_of_flash;
 	uint32_t size_of_sector;
+	bool mapped;		/* provide map_data like internal flash does */
 };
 
 int32_t PIOS_Flash_Posix_Init(uintptr_t * chip_id, const struct pios_flash_posix_cfg * cfg);
@@ -51,6 +51,7 @@ extern uint32_t pios_flash_partition_table_size;
 
 extern uintptr_t pios_posix_flash_id;
 extern struct pios_flash_posix_cfg flash_config;
+extern struct pios_flash_posix_cfg flash_config_mapped;
 
 #include "pios_flashfs_logfs_priv.h"
 
@@ -300,6 +301,66 @@ TEST_F(LogfsTestCooked, FillFilesystemAndGarbageCollect) {
   EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
 }
 
+TEST_F(LogfsTestCooked, IncrementalGarbageCollect) {
+  uint32_t num_slots = (flashfs_config_settings.arena_size / flashfs_config_settings.slot_size) - 1;
+
+  /* Nothing to collect yet */
+  EXPECT_EQ(0, PIOS_FLASHFS_Maintenance(fs_id));
+
+  /* Objects that must survive collection */
+  for (uint32_t i = 0; i < 40; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ0_ID, i, NULL, 0));
+  }
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ3_ID, 0, obj3, sizeof(obj3)));
+
+  /* Fill most of the rest of the log with obsolete versions of obj1 */
+  for (uint32_t i = 0; i < num_slots - 42 - num_slots / 8; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  }
+
+  /* Erase the destination and copy the first few instances of obj0 */
+  EXPECT_EQ(0, PIOS_FLASHFS_Maintenance(fs_id));
+  EXPECT_EQ(0, PIOS_FLASHFS_Maintenance(fs_id));
+
+  /* Change objects that were already copied and some that weren't */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ0_ID, 2));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ0_ID, 3, NULL, 0));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ2_ID, 0));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+  /* Run it to completion, then saves must have plenty of room again */
+  for (uint32_t i = 0; i < num_slots; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_Maintenance(fs_id));
+  }
+  for (uint32_t i = 0; i < num_slots / 2; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 1, obj1, sizeof(obj1)));
+  }
+
+  for (int pass = 0; pass < 2; pass++) {
+    for (uint32_t i = 0; i < 40; i++) {
+      EXPECT_EQ(i == 2 ? -3 : 0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ0_ID, i, NULL, 0));
+    }
+
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    unsigned char obj2_check[OBJ2_SIZE];
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+
+    unsigned char obj3_check[OBJ3_SIZE];
+    memset(obj3_check, 0, sizeof(obj3_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 0, obj3_check, sizeof(obj3_check)));
+    EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+
+    /* The same contents must be found after a remount rescans the log */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+}
+
 TEST_F(LogfsTestCooked, WriteManyVerify) {
   for (uint32_t i = 0; i < 10000; i++) {
     /* Write a collection of objects */
@@ -333,6 +394,184 @@ TEST_F(LogfsTestCooked, WriteManyVerify) {
   EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
 }
 
+/* Hands out a list of objects to PIOS_FLASHFS_ObjSaveBatch, aborting at abort_at if set */
+struct batch {
+  const struct pios_flashfs_obj *objs;
+  int num_objs;
+  int pos;
+  int abort_at;
+};
+
+static int32_t batch_next(void *ctx, struct pios_flashfs_obj *obj)
+{
+  struct batch *b = (struct batch *)ctx;
+
+  if (b->pos == b->abort_at)
+    return -1;
+  if (b->pos == b->num_objs)
+    return 0;
+
+  *obj = b->objs[b->pos++];
+  return 1;
+}
+
+/* Loads every instance of obj1 into its own buffer, skips everything else */
+struct load_all {
+  unsigned char obj1[4][OBJ1_SIZE];
+  int num_loaded[4];
+};
+
+static void load_all_buffer(void *ctx, struct pios_flashfs_obj *obj)
+{
+  struct load_all *l = (struct load_all *)ctx;
+
+  if (obj->obj_id == OBJ1_ID && obj->obj_inst_id < 4 && obj->obj_size == OBJ1_SIZE)
+    obj->obj_data = l->obj1[obj->obj_inst_id];
+}
+
+static void load_all_done(void *ctx, const struct pios_flashfs_obj *obj)
+{
+  struct load_all *l = (struct load_all *)ctx;
+
+  l->num_loaded[obj->obj_inst_id]++;
+}
+
+TEST_F(LogfsTestCooked, SaveBatchVerify) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+
+  /* Replaces obj1, adds obj3 and leaves obj2 alone */
+  struct pios_flashfs_obj objs[] = {
+    { OBJ1_ID, 0, OBJ1_SIZE, obj1_alt },
+    { OBJ3_ID, 0, OBJ3_SIZE, obj3 },
+    { OBJ0_ID, 0, 0, NULL },
+  };
+  struct batch b = { objs, 3, 0, -1 };
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, batch_next, &b));
+
+  for (int pass = 0; pass < 2; pass++) {
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+    unsigned char obj2_check[OBJ2_SIZE];
+    memset(obj2_check, 0, sizeof(obj2_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+    EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+
+    unsigned char obj3_check[OBJ3_SIZE];
+    memset(obj3_check, 0, sizeof(obj3_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ3_ID, 0, obj3_check, sizeof(obj3_check)));
+    EXPECT_EQ(0, memcmp(obj3, obj3_check, sizeof(obj3)));
+
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ0_ID, 0, NULL, 0));
+
+    /* The batch must be what a remount finds as well */
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+}
+
+TEST_F(LogfsTestCooked, SaveBatchTwiceKeepsLast) {
+  struct pios_flashfs_obj objs[] = {
+    { OBJ1_ID, 0, OBJ1_SIZE, obj1 },
+    { OBJ1_ID, 0, OBJ1_SIZE, obj1_alt },
+  };
+  struct batch b = { objs, 2, 0, -1 };
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, batch_next, &b));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+
+  /* Only one of them may be active */
+  struct load_all l;
+  memset(&l, 0, sizeof(l));
+  EXPECT_EQ(1, PIOS_FLASHFS_ObjLoadAll(fs_id, load_all_buffer, load_all_done, &l));
+}
+
+TEST_F(LogfsTestCooked, SaveBatchAbort) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+
+  struct pios_flashfs_obj objs[] = {
+    { OBJ2_ID, 0, OBJ2_SIZE, obj2 },
+    { OBJ1_ID, 0, OBJ1_SIZE, obj1_alt },
+  };
+  struct batch b = { objs, 2, 0, 1 };
+  EXPECT_EQ(-7, PIOS_FLASHFS_ObjSaveBatch(fs_id, batch_next, &b));
+
+  /* None of the batch made it, before or after a remount */
+  for (int pass = 0; pass < 2; pass++) {
+    unsigned char obj1_check[OBJ1_SIZE];
+    memset(obj1_check, 0, sizeof(obj1_check));
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+    EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+    unsigned char obj2_check[OBJ2_SIZE];
+    EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+
+  /* Saving still works after the abandoned arena */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  unsigned char obj2_check[OBJ2_SIZE];
+  memset(obj2_check, 0, sizeof(obj2_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, memcmp(obj2, obj2_check, sizeof(obj2)));
+}
+
+TEST_F(LogfsTestCooked, SaveBatchTooBig) {
+  uint32_t num_slots = (flashfs_config_settings.arena_size / flashfs_config_settings.slot_size) - 1;
+
+  for (uint32_t i = 0; i < num_slots; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ0_ID, i, NULL, 0));
+  }
+
+  /* A new object has no room next to the ones the batch leaves alone */
+  struct pios_flashfs_obj objs[] = {
+    { OBJ0_ID, 0, 0, NULL },
+    { OBJ2_ID, 0, OBJ2_SIZE, obj2 },
+  };
+  struct batch b = { objs, 2, 0, -1 };
+  EXPECT_EQ(-5, PIOS_FLASHFS_ObjSaveBatch(fs_id, batch_next, &b));
+
+  unsigned char obj2_check[OBJ2_SIZE];
+  EXPECT_EQ(-3, PIOS_FLASHFS_ObjLoad(fs_id, OBJ2_ID, 0, obj2_check, sizeof(obj2_check)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ0_ID, num_slots - 1, NULL, 0));
+
+  /* Replacing objects that are already there fits */
+  b.num_objs = 1;
+  b.pos = 0;
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSaveBatch(fs_id, batch_next, &b));
+  for (uint32_t i = 0; i < num_slots; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ0_ID, i, NULL, 0));
+  }
+}
+
+TEST_F(LogfsTestCooked, LoadAll) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 2, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ2_ID, 0, obj2, sizeof(obj2)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 2, obj1_alt, sizeof(obj1_alt)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 3, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjDelete(fs_id, OBJ1_ID, 3));
+
+  struct load_all l;
+  memset(&l, 0, sizeof(l));
+  EXPECT_EQ(2, PIOS_FLASHFS_ObjLoadAll(fs_id, load_all_buffer, load_all_done, &l));
+
+  EXPECT_EQ(1, l.num_loaded[0]);
+  EXPECT_EQ(0, l.num_loaded[1]);
+  EXPECT_EQ(1, l.num_loaded[2]);
+  EXPECT_EQ(0, l.num_loaded[3]);
+  EXPECT_EQ(0, memcmp(obj1, l.obj1[0], sizeof(obj1)));
+  EXPECT_EQ(0, memcmp(obj1_alt, l.obj1[2], sizeof(obj1_alt)));
+}
+
 class LogfsTestCookedMultiPart : public LogfsTestRaw {
 protected:
   virtual void SetUp() {
@@ -425,3 +664,75 @@ TEST_F(LogfsTestCookedMultiPart, WriteLarge) {
   memset(obj4_check, 0, sizeof(obj4_check));
   EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id_b, OBJ4_ID, 0, obj4_check, sizeof(obj4_check)));
 }
+
+class LogfsTestMapped : public LogfsTestRaw {
+protected:
+  virtual void SetUp() {
+    /* First, we need to set up the super fixture (LogfsTestRaw) */
+    LogfsTestRaw::SetUp();
+
+    /* The same flash, but readable in place like internal flash */
+    EXPECT_EQ(0, PIOS_Flash_Posix_Init(&pios_posix_flash_id, &flash_config_mapped));
+    EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+  }
+
+  virtual void TearDown() {
+    PIOS_FLASHFS_Logfs_Destroy(fs_id);
+    PIOS_Flash_Posix_Destroy(pios_posix_flash_id);
+  }
+
+  uintptr_t fs_id;
+};
+
+TEST_F(LogfsTestMapped, FillFilesystemAndGarbageCollect) {
+  for (uint32_t i = 0; i < (flashfs_config_settings.arena_size / flashfs_config_settings.slot_size) - 1; i++) {
+    EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, i, obj1, sizeof(obj1)));
+  }
+
+  /* Triggers gc, which copies the slots through the mapping */
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1_alt, sizeof(obj1_alt)));
+
+  /* The remount finds the new arena through the mapping as well */
+  PIOS_FLASHFS_Logfs_Destroy(fs_id);
+  EXPECT_EQ(0, PIOS_FLASHFS_Logfs_Init(&fs_id, &flashfs_config_settings, FLASH_PARTITION_LABEL_SETTINGS));
+
+  unsigned char obj1_check[OBJ1_SIZE];
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 1, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1, obj1_check, sizeof(obj1)));
+
+  memset(obj1_check, 0, sizeof(obj1_check));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjLoad(fs_id, OBJ1_ID, 0, obj1_check, sizeof(obj1_check)));
+  EXPECT_EQ(0, memcmp(obj1_alt, obj1_check, sizeof(obj1_alt)));
+}
+
+static void load_in_place_buffer(void * /* ctx */, struct pios_flashfs_obj *obj)
+{
+  obj->obj_data = (uint8_t *)obj->obj_mapped;
+}
+
+static void load_in_place_done(void *ctx, const struct pios_flashfs_obj *obj)
+{
+  struct load_all *l = (struct load_all *)ctx;
+
+  if (obj->obj_id == OBJ1_ID && obj->obj_inst_id < 4 && obj->obj_size == OBJ1_SIZE) {
+    memcpy(l->obj1[obj->obj_inst_id], obj->obj_data, OBJ1_SIZE);
+    l->num_loaded[obj->obj_inst_id]++;
+  }
+}
+
+TEST_F(LogfsTestMapped, LoadAllInPlace) {
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 0, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 2, obj1, sizeof(obj1)));
+  EXPECT_EQ(0, PIOS_FLASHFS_ObjSave(fs_id, OBJ1_ID, 2, obj1_alt, sizeof(obj1_alt)));
+
+  /* Every object is handed over in place */
+  struct load_all l;
+  memset(&l, 0, sizeof(l));
+  EXPECT_EQ(2, PIOS_FLASHFS_ObjLoadAll(fs_id, load_in_place_buffer, load_in_place_done, &l));
+
+  EXPECT_EQ(1, l.num_loaded[0]);
+  EXPECT_EQ(1, l.num_loaded[2]);
+  EXPECT_EQ(0, memcmp(obj1, l.obj1[0], sizeof(obj1)));
+  EXPECT_EQ(0, memcmp(obj1_alt, l.obj1[2], sizeof(obj1_alt)));
+}
@@ -28,6 +28,12 @@ const struct pios_flash_posix_cfg flash_config = {
 	.size_of_sector = FLASH_SECTOR_64KB,
 };
 
+const struct pios_flash_posix_cfg flash_config_mapped = {
+	.size_of_flash  = 3 * 1024 * 1024,
+	.size_of_sector = FLASH_SECTOR_64KB,
+	.mapped         = true,
+};
+
 static const struct pios_flash_sector_range posix_flash_sectors[] = {
 	{
 		.base_sector = 0,
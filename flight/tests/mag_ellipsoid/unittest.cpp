@@ -0,0 +1,159 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "mag_ellipsoid.h"	/* API for the magnetometer ellipsoid fit */
+
+}
+
+#include <math.h>		/* sinf() */
+
+#define FIELD 500.0f
+
+// To use a test fixture, derive a class from testing::Test.
+class MagEllipsoid : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+    mag_ellipsoid_init(&me, FIELD);
+    for (int i = 0; i < 3; i++) {
+      gain[i] = 1;
+      offset[i] = 0;
+    }
+    noise = 0;
+  }
+
+  virtual void TearDown() {
+  }
+
+  float uniform() {
+    return (float) rand() / RAND_MAX;
+  }
+
+  // Raw reading of a field along the unit vector dir through the distortion
+  void distort(const float dir[3], float raw[3]) {
+    for (int i = 0; i < 3; i++)
+      raw[i] = (dir[i] * FIELD + offset[i]) / gain[i] + noise * (uniform() - 0.5f);
+  }
+
+  // Feed n samples from random attitudes
+  void tumble(int n) {
+    for (int i = 0; i < n; i++) {
+      float z = 2 * uniform() - 1;
+      float az = 2 * M_PI * uniform();
+      float dir[3] = { sqrtf(1 - z * z) * cosf(az), sqrtf(1 - z * z) * sinf(az), z };
+      float raw[3];
+      distort(dir, raw);
+      mag_ellipsoid_add(&me, raw);
+    }
+  }
+
+  struct mag_ellipsoid me;
+  float gain[3];
+  float offset[3];
+  float noise;
+};
+
+TEST_F(MagEllipsoid, StartsAsSphere) {
+  float bias[3], scale[3];
+  ASSERT_TRUE(mag_ellipsoid_solve(&me, FIELD, bias, scale));
+  EXPECT_FALSE(mag_ellipsoid_converged(&me));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_FLOAT_EQ(0, bias[i]);
+    EXPECT_FLOAT_EQ(1, scale[i]);
+  }
+};
+
+TEST_F(MagEllipsoid, SkipsRepeatedSamples) {
+  const float raw[3] = { FIELD, 0, 0 };
+  EXPECT_TRUE(mag_ellipsoid_add(&me, raw));
+  EXPECT_FALSE(mag_ellipsoid_add(&me, raw));
+  EXPECT_EQ(1U, me.samples);
+
+  const float bad[3] = { NAN, 0, 0 };
+  EXPECT_FALSE(mag_ellipsoid_add(&me, bad));
+};
+
+TEST_F(MagEllipsoid, RecoversHardAndSoftIron) {
+  gain[0] = 0.8f; gain[1] = 1.1f; gain[2] = 1.3f;
+  offset[0] = 120; offset[1] = -60; offset[2] = 200;
+  noise = 10;
+
+  tumble(2000);
+  ASSERT_TRUE(mag_ellipsoid_converged(&me));
+
+  float bias[3], scale[3];
+  ASSERT_TRUE(mag_ellipsoid_solve(&me, FIELD, bias, scale));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR(gain[i], scale[i], 0.02f);
+    EXPECT_NEAR(offset[i], bias[i], 10);
+  }
+};
+
+TEST_F(MagEllipsoid, KeepsAverageLength) {
+  gain[0] = 0.5f; gain[1] = 0.5f; gain[2] = 0.5f;
+
+  tumble(2000);
+  ASSERT_TRUE(mag_ellipsoid_converged(&me));
+
+  float bias[3], scale[3];
+  ASSERT_TRUE(mag_ellipsoid_solve(&me, 0, bias, scale));
+  for (int i = 0; i < 3; i++) {
+    EXPECT_NEAR(1, scale[i], 0.01f);
+    EXPECT_NEAR(0, bias[i], 5);
+  }
+};
+
+TEST_F(MagEllipsoid, LevelTurnsDoNotConverge) {
+  offset[0] = 120; offset[1] = -60; offset[2] = 200;
+  noise = 10;
+
+  // Only turning in yaw never shows what the z axis does
+  for (int i = 0; i < 5000; i++) {
+    float az = 2 * M_PI * uniform();
+    float dir[3] = { 0.6f * cosf(az), 0.6f * sinf(az), 0.8f };
+    float raw[3];
+    distort(dir, raw);
+    mag_ellipsoid_add(&me, raw);
+  }
+
+  EXPECT_FALSE(mag_ellipsoid_converged(&me));
+};
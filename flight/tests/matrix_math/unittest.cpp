@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "matrix_math.h"	/* API for matrix_math functions */
+
+}
+
+#include <math.h>		/* fabs() */
+
+#define eps 1e-6f
+
+// To use a test fixture, derive a class from testing::Test.
+class MatrixMath : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(MatrixMath, MatrixMul) {
+  const float a[2][3] = { { 1, 2, 3 }, { 4, 5, 6 } };
+  const float b[3][2] = { { 7, 8 }, { 9, 10 }, { 11, 12 } };
+  float out[2][2];
+
+  matrix_mul(&a[0][0], &b[0][0], &out[0][0], 2, 3, 2);
+
+  EXPECT_NEAR(58.0f, out[0][0], eps);
+  EXPECT_NEAR(64.0f, out[0][1], eps);
+  EXPECT_NEAR(139.0f, out[1][0], eps);
+  EXPECT_NEAR(154.0f, out[1][1], eps);
+};
+
+TEST_F(MatrixMath, MatrixMulTrans) {
+  const float a[2][3] = { { 1, 2, 3 }, { 4, 5, 6 } };
+  const float b[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 1, 1, 1 } };
+  float out[2][3];
+
+  // b' is used, so each output is a dot product of two rows
+  matrix_mul_trans(&a[0][0], &b[0][0], &out[0][0], 2, 3, 3);
+
+  EXPECT_NEAR(1.0f, out[0][0], eps);
+  EXPECT_NEAR(2.0f, out[0][1], eps);
+  EXPECT_NEAR(6.0f, out[0][2], eps);
+  EXPECT_NEAR(4.0f, out[1][0], eps);
+  EXPECT_NEAR(5.0f, out[1][1], eps);
+  EXPECT_NEAR(15.0f, out[1][2], eps);
+};
+
+TEST_F(MatrixMath, SymRank1Sub) {
+  float P[3][3] = { { 4, 1, 2 }, { 1, 5, 3 }, { 2, 3, 6 } };
+  const float v[3] = { 1, 2, 3 };
+  const float k[3] = { 0.5f, 1.0f, 1.5f };
+
+  matrix_sym_rank1_sub(&P[0][0], k, v, 3);
+
+  // P - k * v' with k = v / 2
+  EXPECT_NEAR(3.5f, P[0][0], eps);
+  EXPECT_NEAR(0.0f, P[0][1], eps);
+  EXPECT_NEAR(0.5f, P[0][2], eps);
+  EXPECT_NEAR(3.0f, P[1][1], eps);
+  EXPECT_NEAR(0.0f, P[1][2], eps);
+  EXPECT_NEAR(1.5f, P[2][2], eps);
+
+  // The lower triangle is an exact mirror of the upper one
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < i; j++)
+      EXPECT_EQ(P[j][i], P[i][j]);
+};
+
+TEST_F(MatrixMath, VectorOps) {
+  float y[4] = { 1, 1, 1, 1 };
+  const float x[4] = { 1, 2, 3, 4 };
+  float out[4];
+
+  vector_axpy(y, x, 2.0f, 4);
+  EXPECT_NEAR(3.0f, y[0], eps);
+  EXPECT_NEAR(9.0f, y[3], eps);
+
+  vector_scale(out, x, -0.5f, 4);
+  EXPECT_NEAR(-0.5f, out[0], eps);
+  EXPECT_NEAR(-2.0f, out[3], eps);
+
+  // Scaling in place is allowed
+  vector_scale(y, y, 0.5f, 4);
+  EXPECT_NEAR(1.5f, y[0], eps);
+
+  EXPECT_NEAR(30.0f, vector_dot(x, x, 4), eps);
+  EXPECT_NEAR(0.0f, vector_dot(x, x, 0), eps);
+};
+
+/**
+ * @}
+ * @}
+ */
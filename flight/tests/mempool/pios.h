@@ -0,0 +1,14 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* Minimal PIOS environment for the memory pool unit test */
+#include <stdlib.h>
+
+#define PIOS_malloc_no_dma(size) malloc(size)
+#define PIOS_malloc(size) malloc(size)
+#define PIOS_free(ptr) free(ptr)
+
+#define PIOS_IRQ_Disable() do { } while (0)
+#define PIOS_IRQ_Enable() do { } while (0)
+
+#endif /* PIOS_H */
@@ -0,0 +1,129 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "pios_mempool.h"	/* API for the memory pool */
+
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class Mempool : public testing::Test {
+protected:
+  virtual void SetUp() {
+    mp = PIOS_Mempool_Create(10, 3);
+    ASSERT_TRUE(mp != NULL);
+  }
+
+  struct pios_mempool *mp;
+};
+
+TEST_F(Mempool, CreateInvalid) {
+  EXPECT_TRUE(PIOS_Mempool_Create(0, 4) == NULL);
+  EXPECT_TRUE(PIOS_Mempool_Create(100000, 4) == NULL);
+};
+
+TEST_F(Mempool, BlockSizeIsAligned) {
+  EXPECT_EQ(sizeof(void *), PIOS_MEMPOOL_BLOCK_SIZE(1));
+  EXPECT_EQ(0U, mp->block_size % sizeof(void *));
+  EXPECT_LE(10U, mp->block_size);
+};
+
+TEST_F(Mempool, FullOnCreate) {
+  EXPECT_EQ(3U, PIOS_Mempool_GetFree(mp));
+  EXPECT_EQ(3U, PIOS_Mempool_GetMinFree(mp));
+};
+
+TEST_F(Mempool, AllocUntilEmpty) {
+  void *blocks[3];
+
+  for (int i = 0; i < 3; i++) {
+    blocks[i] = PIOS_Mempool_Alloc(mp);
+    ASSERT_TRUE(blocks[i] != NULL);
+    memset(blocks[i], 0xa5, 10);
+  }
+
+  for (int i = 0; i < 3; i++)
+    for (int j = i + 1; j < 3; j++)
+      EXPECT_NE(blocks[i], blocks[j]);
+
+  EXPECT_TRUE(PIOS_Mempool_Alloc(mp) == NULL);
+  EXPECT_EQ(0U, PIOS_Mempool_GetFree(mp));
+  EXPECT_EQ(0U, PIOS_Mempool_GetMinFree(mp));
+};
+
+TEST_F(Mempool, FreedBlockIsReused) {
+  void *a = PIOS_Mempool_Alloc(mp);
+  void *b = PIOS_Mempool_Alloc(mp);
+  ASSERT_TRUE(a != NULL && b != NULL);
+
+  PIOS_Mempool_Free(mp, a);
+  EXPECT_EQ(2U, PIOS_Mempool_GetFree(mp));
+  EXPECT_EQ(1U, PIOS_Mempool_GetMinFree(mp));
+
+  // Last freed is first handed out again
+  EXPECT_EQ(a, PIOS_Mempool_Alloc(mp));
+
+  // Freeing NULL is harmless
+  PIOS_Mempool_Free(mp, NULL);
+  EXPECT_EQ(1U, PIOS_Mempool_GetFree(mp));
+};
+
+TEST(MempoolEmpty, RecyclesForeignBlocks) {
+  struct pios_mempool pool;
+  PIOS_Mempool_Init(&pool, 5);
+
+  EXPECT_EQ(0U, PIOS_Mempool_GetFree(&pool));
+  EXPECT_TRUE(PIOS_Mempool_Alloc(&pool) == NULL);
+
+  void *storage[4];
+  PIOS_Mempool_Load(&pool, storage, 4 * sizeof(void *) / PIOS_MEMPOOL_BLOCK_SIZE(5));
+  EXPECT_EQ(4 * sizeof(void *) / PIOS_MEMPOOL_BLOCK_SIZE(5), PIOS_Mempool_GetFree(&pool));
+
+  uint8_t *block;
+  while ((block = (uint8_t *) PIOS_Mempool_Alloc(&pool)) != NULL) {
+    EXPECT_GE(block, (uint8_t *) storage);
+    EXPECT_LT(block, (uint8_t *) storage + sizeof(storage));
+  }
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -351,3 +351,86 @@ TEST_F(LinearInterpolate, CollectiveCurve1to1) {
     EXPECT_NEAR(range_max, linear_interpolate(input, curve, curve_numpts, range_min, range_max), eps);
   }
 };
+
+// Test fixture for the bounded-error approximations
+class FastMath : public MiscMath {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+TEST_F(FastMath, Atan2AllQuadrants) {
+  float eps = 2e-5f;
+
+  // Around the circle at very different scales, through the axes and diagonals
+  for (int i = -720; i <= 720; ++i) {
+    double angle = i * M_PI / 720;
+    for (double r = 1e-3; r <= 1e3; r *= 10) {
+      float y = r * sin(angle);
+      float x = r * cos(angle);
+      EXPECT_NEAR(atan2((double) y, (double) x), fast_atan2f(y, x), eps);
+    }
+  }
+
+  EXPECT_EQ(0.0f, fast_atan2f(0.0f, 0.0f));
+  EXPECT_NEAR(M_PI_2, fast_atan2f(1.0f, 0.0f), eps);
+  EXPECT_NEAR(-M_PI_2, fast_atan2f(-1.0f, 0.0f), eps);
+  EXPECT_NEAR(M_PI, fast_atan2f(0.0f, -1.0f), eps);
+};
+
+TEST_F(FastMath, SinCosBounded) {
+  float eps = 1e-6f;
+
+  for (int i = -100000; i <= 100000; ++i) {
+    float x = i * 1e-3f;
+    float s, c;
+    fast_sincosf(x, &s, &c);
+    EXPECT_NEAR(sin((double) x), s, eps);
+    EXPECT_NEAR(cos((double) x), c, eps);
+  }
+};
+
+TEST_F(FastMath, SinCosQuadrantEdges) {
+  float eps = 1e-6f;
+
+  // Where the range reduction switches from one quadrant to the next
+  for (int k = -8; k <= 8; ++k) {
+    for (int d = -1; d <= 1; ++d) {
+      float x = k * (float) M_PI_4 + d * 1e-5f;
+      float s, c;
+      fast_sincosf(x, &s, &c);
+      EXPECT_NEAR(sin((double) x), s, eps);
+      EXPECT_NEAR(cos((double) x), c, eps);
+    }
+  }
+};
+
+TEST_F(FastMath, InvSqrtRelativeError) {
+  for (double x = 1e-6; x <= 1e6; x *= 1.01) {
+    double expected = 1 / sqrt((double)(float) x);
+    EXPECT_NEAR(expected, fast_invsqrtf(x), 1e-5 * expected);
+  }
+};
+
+TEST_F(FastMath, NormalizeVector) {
+  float eps = 1e-5f;
+
+  float q[4] = { 0.5f, -1.0f, 2.0f, 0.25f };
+  float expected = sqrtf(0.25f + 1.0f + 4.0f + 0.0625f);
+  EXPECT_NEAR(expected, vectorn_normalize(q, 4), eps * expected);
+  EXPECT_NEAR(1.0f, vectorn_magnitude(q, 4), eps);
+  EXPECT_NEAR(0.5f / expected, q[0], eps);
+  EXPECT_NEAR(2.0f / expected, q[2], eps);
+
+  // Nothing to scale, left as it is
+  float zero[3] = { 0.0f, 0.0f, 0.0f };
+  EXPECT_EQ(0.0f, vectorn_normalize(zero, 3));
+  EXPECT_EQ(0.0f, zero[0]);
+
+  float nan[2] = { NAN, 1.0f };
+  EXPECT_EQ(0.0f, vectorn_normalize(nan, 2));
+  EXPECT_EQ(1.0f, nan[1]);
+};
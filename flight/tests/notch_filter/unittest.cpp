@@ -0,0 +1,159 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "notch_filter.h"	/* API for the gyro notch filters */
+
+}
+
+#include <math.h>		/* sinf() */
+
+#define SAMPLE_RATE 1000.0f
+
+// To use a test fixture, derive a class from testing::Test.
+class NotchFilter : public testing::Test {
+protected:
+  virtual void SetUp() {
+    notch_filter_init(&nf);
+  }
+
+  virtual void TearDown() {
+  }
+
+  // Amplitude of a tone on the three axes after the filter settled
+  float response(float frequency) {
+    float peak = 0;
+    for (int i = 0; i < 2 * SAMPLE_RATE; i++) {
+      float x = sinf(2 * M_PI * frequency * i / SAMPLE_RATE);
+      float samples[3] = {x, -x, 2 * x};
+      notch_filter_apply(&nf, samples);
+
+      EXPECT_FLOAT_EQ(samples[0], -samples[1]);
+      if (i > SAMPLE_RATE && fabsf(samples[0]) > peak)
+        peak = fabsf(samples[0]);
+    }
+    return peak;
+  }
+
+  struct notch_filter nf;
+};
+
+TEST_F(NotchFilter, PassThrough) {
+  EXPECT_EQ(0, nf.stages);
+
+  float samples[3] = {1, -2, 3};
+  notch_filter_apply(&nf, samples);
+  EXPECT_EQ(1, samples[0]);
+  EXPECT_EQ(-2, samples[1]);
+  EXPECT_EQ(3, samples[2]);
+};
+
+TEST_F(NotchFilter, BadParameters) {
+  const float frequencies[] = { 100 };
+  ASSERT_EQ(1, notch_filter_set(&nf, frequencies, 1, SAMPLE_RATE, 3));
+
+  // Left as it was
+  EXPECT_EQ(-1, notch_filter_set(&nf, frequencies, 1, 0, 3));
+  EXPECT_EQ(-1, notch_filter_set(&nf, frequencies, 1, SAMPLE_RATE, 0));
+  EXPECT_EQ(1, nf.stages);
+};
+
+TEST_F(NotchFilter, SkipsAboveNyquist) {
+  const float frequencies[] = { 600, 0, 200, 300, 400, 450 };
+  EXPECT_EQ(NOTCH_FILTER_MAX_STAGES, notch_filter_set(&nf, frequencies, 6, SAMPLE_RATE, 3));
+
+  const float high[] = { 500, 800 };
+  EXPECT_EQ(0, notch_filter_set(&nf, high, 2, SAMPLE_RATE, 3));
+};
+
+TEST_F(NotchFilter, Notch) {
+  const float frequencies[] = { 150 };
+  ASSERT_EQ(1, notch_filter_set(&nf, frequencies, 1, SAMPLE_RATE, 3));
+
+  EXPECT_LT(response(150), 0.01f);
+  EXPECT_NEAR(1, response(10), 0.02f);
+  EXPECT_NEAR(1, response(400), 0.05f);
+
+  // About the -3 dB points for Q 3
+  EXPECT_NEAR(sqrtf(0.5f), response(150 * 1.18f), 0.1f);
+  EXPECT_NEAR(sqrtf(0.5f), response(150 / 1.18f), 0.1f);
+};
+
+TEST_F(NotchFilter, Harmonics) {
+  const float frequencies[] = { 120, 240 };
+  ASSERT_EQ(2, notch_filter_set(&nf, frequencies, 2, SAMPLE_RATE, 5));
+
+  EXPECT_LT(response(120), 0.01f);
+  EXPECT_LT(response(240), 0.01f);
+  EXPECT_NEAR(1, response(20), 0.05f);
+};
+
+TEST_F(NotchFilter, DCUnchanged) {
+  const float frequencies[] = { 120, 240, 360 };
+  ASSERT_EQ(3, notch_filter_set(&nf, frequencies, 3, SAMPLE_RATE, 2));
+
+  float samples[3];
+  for (int i = 0; i < 1000; i++) {
+    samples[0] = samples[1] = samples[2] = 5;
+    notch_filter_apply(&nf, samples);
+  }
+
+  EXPECT_NEAR(5, samples[0], 1e-3);
+  EXPECT_NEAR(5, samples[2], 1e-3);
+};
+
+TEST_F(NotchFilter, RetuneWithoutStep) {
+  const float frequencies[] = { 150 };
+  ASSERT_EQ(1, notch_filter_set(&nf, frequencies, 1, SAMPLE_RATE, 3));
+
+  float samples[3];
+  for (int i = 0; i < 1000; i++) {
+    samples[0] = samples[1] = samples[2] = 5;
+    notch_filter_apply(&nf, samples);
+  }
+
+  // Moving the notch keeps the state, a constant input stays constant
+  const float moved[] = { 160 };
+  ASSERT_EQ(1, notch_filter_set(&nf, moved, 1, SAMPLE_RATE, 3));
+  samples[0] = samples[1] = samples[2] = 5;
+  notch_filter_apply(&nf, samples);
+  EXPECT_NEAR(5, samples[0], 0.05);
+};
@@ -0,0 +1,13 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* Minimal PIOS environment for the ring buffer unit test */
+#define PIOS_INCLUDE_IRQ
+
+#include <stdlib.h>
+
+#define PIOS_malloc_no_dma(size) malloc(size)
+#define PIOS_malloc(size) malloc(size)
+#define PIOS_free(ptr) free(ptr)
+
+#endif /* PIOS_H */
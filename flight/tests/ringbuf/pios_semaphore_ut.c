@@ -0,0 +1,42 @@
+/* Single threaded stand-in for the PIOS semaphore used by the ring buffer */
+
+#include "pios.h"
+#include "pios_semaphore.h"
+
+struct pios_semaphore *PIOS_Semaphore_Create(void)
+{
+	struct pios_semaphore *sema = malloc(sizeof(*sema));
+
+	if (sema != NULL)
+		sema->sema_count = 0;
+
+	return sema;
+}
+
+bool PIOS_Semaphore_Take(struct pios_semaphore *sema, uint32_t timeout_ms)
+{
+	(void) timeout_ms;
+
+	if (sema->sema_count == 0)
+		return false;
+
+	sema->sema_count = 0;
+	return true;
+}
+
+bool PIOS_Semaphore_Give(struct pios_semaphore *sema)
+{
+	sema->sema_count = 1;
+	return true;
+}
+
+bool PIOS_Semaphore_Take_FromISR(struct pios_semaphore *sema, bool *woken)
+{
+	return PIOS_Semaphore_Take(sema, 0);
+}
+
+bool PIOS_Semaphore_Give_FromISR(struct pios_semaphore *sema, bool *woken)
+{
+	*woken = true;
+	return PIOS_Semaphore_Give(sema);
+}
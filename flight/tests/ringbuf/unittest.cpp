@@ -0,0 +1,160 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "pios_ringbuf.h"	/* API for the ring buffer */
+
+}
+
+struct sample {
+  uint32_t seq;
+  float value;
+};
+
+// To use a test fixture, derive a class from testing::Test.
+class Ringbuf : public testing::Test {
+protected:
+  virtual void SetUp() {
+    rb = PIOS_Ringbuf_Create(4, sizeof(struct sample));
+    ASSERT_TRUE(rb != NULL);
+  }
+
+  virtual void TearDown() {
+    PIOS_Ringbuf_Delete(rb);
+  }
+
+  bool push(uint32_t seq) {
+    struct sample *s = (struct sample *) PIOS_Ringbuf_WriteClaim(rb);
+    if (s == NULL)
+      return false;
+    s->seq = seq;
+    s->value = seq * 0.5f;
+    PIOS_Ringbuf_WriteCommit(rb);
+    return true;
+  }
+
+  struct pios_ringbuf *rb;
+};
+
+TEST_F(Ringbuf, CreateInvalid) {
+  EXPECT_TRUE(PIOS_Ringbuf_Create(0, 4) == NULL);
+  EXPECT_TRUE(PIOS_Ringbuf_Create(4, 0) == NULL);
+};
+
+TEST_F(Ringbuf, EmptyOnCreate) {
+  EXPECT_EQ(0U, PIOS_Ringbuf_GetUsed(rb));
+  EXPECT_TRUE(PIOS_Ringbuf_ReadPeek(rb) == NULL);
+  EXPECT_FALSE(PIOS_Ringbuf_Wait(rb, 0));
+  EXPECT_FALSE(PIOS_Ringbuf_Wait(rb, 10));
+};
+
+TEST_F(Ringbuf, ClaimWithoutCommitIsInvisible) {
+  ASSERT_TRUE(PIOS_Ringbuf_WriteClaim(rb) != NULL);
+  EXPECT_EQ(0U, PIOS_Ringbuf_GetUsed(rb));
+  EXPECT_TRUE(PIOS_Ringbuf_ReadPeek(rb) == NULL);
+};
+
+TEST_F(Ringbuf, InPlaceFifoOrder) {
+  for (uint32_t i = 0; i < 3; i++)
+    EXPECT_TRUE(push(i));
+
+  EXPECT_EQ(3U, PIOS_Ringbuf_GetUsed(rb));
+
+  for (uint32_t i = 0; i < 3; i++) {
+    EXPECT_TRUE(PIOS_Ringbuf_Wait(rb, 0));
+    const struct sample *s = (const struct sample *) PIOS_Ringbuf_ReadPeek(rb);
+    ASSERT_TRUE(s != NULL);
+    EXPECT_EQ(i, s->seq);
+    EXPECT_EQ(i * 0.5f, s->value);
+
+    // Peeking twice gives the same slot until it is released
+    EXPECT_EQ(s, PIOS_Ringbuf_ReadPeek(rb));
+    PIOS_Ringbuf_ReadRelease(rb);
+  }
+
+  EXPECT_EQ(0U, PIOS_Ringbuf_GetUsed(rb));
+  EXPECT_FALSE(PIOS_Ringbuf_Wait(rb, 0));
+};
+
+TEST_F(Ringbuf, OverrunDropsNewest) {
+  for (uint32_t i = 0; i < 4; i++)
+    EXPECT_TRUE(push(i));
+
+  EXPECT_FALSE(push(4));
+  EXPECT_FALSE(push(5));
+  EXPECT_EQ(2U, PIOS_Ringbuf_GetOverruns(rb));
+  EXPECT_EQ(4U, PIOS_Ringbuf_GetUsed(rb));
+
+  const struct sample *s = (const struct sample *) PIOS_Ringbuf_ReadPeek(rb);
+  ASSERT_TRUE(s != NULL);
+  EXPECT_EQ(0U, s->seq);
+};
+
+TEST_F(Ringbuf, WrapAround) {
+  uint32_t next_read = 0;
+
+  for (uint32_t i = 0; i < 100; i++) {
+    EXPECT_TRUE(push(i));
+
+    // Drain every third push so the indices wrap at varying fill levels
+    if (i % 3 == 2) {
+      while (PIOS_Ringbuf_Wait(rb, 0)) {
+        const struct sample *s = (const struct sample *) PIOS_Ringbuf_ReadPeek(rb);
+        ASSERT_TRUE(s != NULL);
+        EXPECT_EQ(next_read, s->seq);
+        next_read++;
+        PIOS_Ringbuf_ReadRelease(rb);
+      }
+    }
+  }
+
+  EXPECT_EQ(99U, next_read);
+  EXPECT_EQ(1U, PIOS_Ringbuf_GetUsed(rb));
+  EXPECT_EQ(0U, PIOS_Ringbuf_GetOverruns(rb));
+};
+
+TEST_F(Ringbuf, ReleaseOnEmptyIsHarmless) {
+  PIOS_Ringbuf_ReadRelease(rb);
+  EXPECT_EQ(0U, PIOS_Ringbuf_GetUsed(rb));
+  EXPECT_TRUE(push(7));
+  EXPECT_EQ(1U, PIOS_Ringbuf_GetUsed(rb));
+};
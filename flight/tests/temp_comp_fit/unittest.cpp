@@ -0,0 +1,138 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* rand */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "temp_comp_fit.h"	/* API for the gyro temperature fit */
+
+}
+
+#include <math.h>		/* sinf() */
+
+// To use a test fixture, derive a class from testing::Test.
+class TempCompFit : public testing::Test {
+protected:
+  virtual void SetUp() {
+    srand(1);
+    temp_comp_fit_init(&tf);
+  }
+
+  virtual void TearDown() {
+  }
+
+  float bias(int axis, float t) {
+    return poly[axis][0] + poly[axis][1] * t + poly[axis][2] * t * t + poly[axis][3] * t * t * t;
+  }
+
+  // Warm up slowly from t0 to t1 with some noise on the gyros
+  void sweep(float t0, float t1, int n) {
+    for (int i = 0; i < n; i++) {
+      float t = t0 + (t1 - t0) * i / n;
+      float gyro[3];
+      for (int axis = 0; axis < 3; axis++)
+        gyro[axis] = bias(axis, t) + 0.2f * ((float) rand() / RAND_MAX - 0.5f);
+      temp_comp_fit_add(&tf, t, gyro);
+    }
+  }
+
+  struct temp_comp_fit tf;
+  float poly[3][4];
+};
+
+TEST_F(TempCompFit, NeedsEnoughBins) {
+  float coeffs[3][4];
+  EXPECT_FALSE(temp_comp_fit_solve(&tf, coeffs));
+  EXPECT_EQ(0, temp_comp_fit_range(&tf));
+
+  memset(poly, 0, sizeof(poly));
+  sweep(20, 26, 10000);
+  EXPECT_FALSE(temp_comp_fit_solve(&tf, coeffs));
+  EXPECT_NEAR(4, temp_comp_fit_range(&tf), 0.5f);
+};
+
+TEST_F(TempCompFit, IgnoresOutOfRange) {
+  const float gyro[3] = { 1, 2, 3 };
+  EXPECT_FALSE(temp_comp_fit_add(&tf, -40, gyro));
+  EXPECT_FALSE(temp_comp_fit_add(&tf, 90, gyro));
+  EXPECT_FALSE(temp_comp_fit_add(&tf, NAN, gyro));
+  for (int i = 0; i < TEMP_COMP_FIT_BINS; i++)
+    EXPECT_EQ(0, tf.bins[i].count);
+};
+
+TEST_F(TempCompFit, RecoversCubic) {
+  const float p[3][4] = {
+    { 1.5f, -0.05f, 0.002f, -0.00003f },
+    { -2.0f, 0.1f, -0.001f, 0.0f },
+    { 0.3f, 0.0f, 0.0f, 0.00001f },
+  };
+  memcpy(poly, p, sizeof(poly));
+
+  sweep(15, 50, 100000);
+  EXPECT_NEAR(35, temp_comp_fit_range(&tf), 2);
+
+  float coeffs[3][4];
+  ASSERT_TRUE(temp_comp_fit_solve(&tf, coeffs));
+
+  // The coefficients trade off against each other, compare the curves
+  for (int axis = 0; axis < 3; axis++) {
+    for (float t = 15; t <= 50; t += 1) {
+      float fit = coeffs[axis][0] + coeffs[axis][1] * t + coeffs[axis][2] * t * t + coeffs[axis][3] * t * t * t;
+      EXPECT_NEAR(bias(axis, t), fit, 0.02f);
+    }
+  }
+};
+
+TEST_F(TempCompFit, LongDwellDoesNotDominate) {
+  memset(poly, 0, sizeof(poly));
+  poly[0][1] = 0.1f;
+
+  // Sit at one temperature for a long time with a slightly different bias,
+  // then sweep. The one bin must not pull the whole curve.
+  for (int i = 0; i < 60000; i++) {
+    const float gyro[3] = { 2.5f + 0.05f, 0, 0 };
+    temp_comp_fit_add(&tf, 25, gyro);
+  }
+  sweep(10, 50, 40000);
+
+  float coeffs[3][4];
+  ASSERT_TRUE(temp_comp_fit_solve(&tf, coeffs));
+  float fit = coeffs[0][0] + coeffs[0][1] * 45 + coeffs[0][2] * 45 * 45 + coeffs[0][3] * 45 * 45 * 45;
+  EXPECT_NEAR(4.5f, fit, 0.05f);
+};
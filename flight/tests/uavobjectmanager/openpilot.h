@@ -0,0 +1,16 @@
+#ifndef OPENPILOT_H
+#define OPENPILOT_H
+
+/* Minimal environment for the UAVObject manager unit test */
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pios.h"
+#include "pios_thread.h"
+#include "utlist.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+
+#endif /* OPENPILOT_H */
@@ -0,0 +1,19 @@
+#ifndef PIOS_H
+#define PIOS_H
+
+/* Minimal PIOS environment for the UAVObject manager unit test */
+#include <stdlib.h>
+
+#include "pios_heap.h"
+#include "pios_flashfs.h"
+
+#define PIOS_Assert(x) if (!(x)) { abort(); }
+#define PIOS_DEBUG_Assert(x) PIOS_Assert(x)
+
+#define PIOS_IRQ_Disable() do { } while (0)
+#define PIOS_IRQ_Enable() do { } while (0)
+
+#define PIOS_FAST_DATA
+#define PIOS_TRACE(event, value) do { } while (0)
+
+#endif /* PIOS_H */
@@ -0,0 +1,11 @@
+#ifndef PIOS_THREAD_H
+#define PIOS_THREAD_H
+
+/* The tests run on one thread, locking the scheduler does nothing */
+#include <stdint.h>
+
+void PIOS_Thread_Scheduler_Suspend(void);
+void PIOS_Thread_Scheduler_Resume(void);
+uint32_t PIOS_Thread_Systime(void);
+
+#endif /* PIOS_THREAD_H */
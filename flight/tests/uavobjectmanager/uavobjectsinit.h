@@ -0,0 +1,6 @@
+#ifndef UAVOBJECTSINIT_H
+#define UAVOBJECTSINIT_H
+
+/* No generated object layout, objects are allocated from the heap */
+
+#endif /* UAVOBJECTSINIT_H */
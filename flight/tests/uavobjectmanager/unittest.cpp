@@ -0,0 +1,193 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "openpilot.h"		/* API for the UAVObject manager */
+
+}
+
+#define MULTI_OBJ_ID  0x1234A000
+#define SINGLE_OBJ_ID 0x1234B000
+
+struct multi_data {
+  uint32_t value;
+  uint8_t  bytes[6];
+} __attribute__((packed));
+
+static uint32_t last_instances_id;
+static uint32_t last_instances;
+
+static void new_instances(uint32_t obj_id, uint32_t num_instances)
+{
+  last_instances_id = obj_id;
+  last_instances = num_instances;
+}
+
+// To use a test fixture, derive a class from testing::Test.
+class UAVObjManager : public testing::Test {
+protected:
+  virtual void SetUp() {
+    ASSERT_EQ(0, UAVObjInitialize());
+    UAVObjRegisterNewInstanceCB(new_instances);
+    last_instances_id = 0;
+    last_instances = 0;
+
+    multi = UAVObjRegister(MULTI_OBJ_ID, 0, 0, 0, sizeof(struct multi_data), NULL);
+    ASSERT_TRUE(multi != NULL);
+    single = UAVObjRegister(SINGLE_OBJ_ID, 1, 0, 0, sizeof(uint32_t), NULL);
+    ASSERT_TRUE(single != NULL);
+  }
+
+  void SetValue(uint16_t instId, uint32_t value) {
+    struct multi_data data;
+    memset(&data, 0, sizeof(data));
+    data.value = value;
+    memset(data.bytes, value & 0xff, sizeof(data.bytes));
+    ASSERT_EQ(0, UAVObjSetInstanceData(multi, instId, &data));
+  }
+
+  uint32_t GetValue(uint16_t instId) {
+    struct multi_data data;
+    EXPECT_EQ(0, UAVObjGetInstanceData(multi, instId, &data));
+    for (uint32_t i = 0; i < sizeof(data.bytes); i++)
+      EXPECT_EQ(data.value & 0xff, data.bytes[i]);
+    return data.value;
+  }
+
+  UAVObjHandle multi;
+  UAVObjHandle single;
+};
+
+TEST_F(UAVObjManager, CreateInstances) {
+  EXPECT_EQ(1U, UAVObjGetNumInstances(multi));
+  EXPECT_EQ(1U, UAVObjCreateInstance(multi, NULL));
+  EXPECT_EQ(2U, UAVObjCreateInstance(multi, NULL));
+  EXPECT_EQ(3U, UAVObjGetNumInstances(multi));
+  EXPECT_EQ((uint32_t) MULTI_OBJ_ID, last_instances_id);
+  EXPECT_EQ(3U, last_instances);
+
+  for (uint16_t i = 0; i < 3; i++)
+    SetValue(i, 0x100 + i);
+  for (uint16_t i = 0; i < 3; i++)
+    EXPECT_EQ(0x100U + i, GetValue(i));
+};
+
+TEST_F(UAVObjManager, DeleteRefused) {
+  // Instance 0 always stays
+  EXPECT_EQ(-1, UAVObjDeleteInstance(multi));
+  EXPECT_EQ(1U, UAVObjGetNumInstances(multi));
+
+  EXPECT_EQ(-1, UAVObjDeleteInstance(single));
+  EXPECT_EQ(-1, UAVObjDeleteInstance(UAVObjGetLinkedObj(multi)));
+};
+
+TEST_F(UAVObjManager, DeleteLastInstance) {
+  UAVObjCreateInstance(multi, NULL);
+  UAVObjCreateInstance(multi, NULL);
+  for (uint16_t i = 0; i < 3; i++)
+    SetValue(i, 0x200 + i);
+
+  EXPECT_EQ(0, UAVObjDeleteInstance(multi));
+  EXPECT_EQ(2U, UAVObjGetNumInstances(multi));
+  EXPECT_EQ((uint32_t) MULTI_OBJ_ID, last_instances_id);
+  EXPECT_EQ(2U, last_instances);
+
+  struct multi_data data;
+  EXPECT_EQ(-1, UAVObjGetInstanceData(multi, 2, &data));
+  EXPECT_EQ(-1, UAVObjSetInstanceData(multi, 2, &data));
+
+  // The remaining instances are untouched
+  EXPECT_EQ(0x200U, GetValue(0));
+  EXPECT_EQ(0x201U, GetValue(1));
+};
+
+TEST_F(UAVObjManager, DeleteThenRecreate) {
+  for (uint16_t i = 1; i < 4; i++)
+    EXPECT_EQ(i, UAVObjCreateInstance(multi, NULL));
+  for (uint16_t i = 0; i < 4; i++)
+    SetValue(i, 0x300 + i);
+
+  // Two deleted instances are both kept for reuse
+  EXPECT_EQ(0, UAVObjDeleteInstance(multi));
+  EXPECT_EQ(0, UAVObjDeleteInstance(multi));
+  EXPECT_EQ(2U, UAVObjGetNumInstances(multi));
+
+  // Recreated instances come back cleared, at the end of the list
+  EXPECT_EQ(2U, UAVObjCreateInstance(multi, NULL));
+  EXPECT_EQ(3U, UAVObjCreateInstance(multi, NULL));
+  EXPECT_EQ(4U, UAVObjGetNumInstances(multi));
+  EXPECT_EQ(4U, last_instances);
+  EXPECT_EQ(0U, GetValue(2));
+  EXPECT_EQ(0U, GetValue(3));
+
+  // And hold their own data independent of the others
+  SetValue(2, 0x402);
+  SetValue(3, 0x403);
+  EXPECT_EQ(0x300U, GetValue(0));
+  EXPECT_EQ(0x301U, GetValue(1));
+  EXPECT_EQ(0x402U, GetValue(2));
+  EXPECT_EQ(0x403U, GetValue(3));
+
+  // A further instance once the deleted ones are used up is new storage
+  EXPECT_EQ(4U, UAVObjCreateInstance(multi, NULL));
+  EXPECT_EQ(0U, GetValue(4));
+  EXPECT_EQ(0x403U, GetValue(3));
+};
+
+TEST_F(UAVObjManager, DeleteDownToFirst) {
+  for (uint16_t i = 1; i < 5; i++)
+    UAVObjCreateInstance(multi, NULL);
+  SetValue(0, 0x500);
+
+  while (UAVObjDeleteInstance(multi) == 0)
+    ;
+
+  EXPECT_EQ(1U, UAVObjGetNumInstances(multi));
+  EXPECT_EQ(1U, last_instances);
+  EXPECT_EQ(0x500U, GetValue(0));
+
+  EXPECT_EQ(1U, UAVObjCreateInstance(multi, NULL));
+  EXPECT_EQ(0U, GetValue(1));
+};
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,105 @@
+/* Single threaded stand-ins for the PIOS services the UAVObject manager uses */
+#include <stdlib.h>
+#include "pios_heap.h"
+#include "pios_flashfs.h"
+#include "pios_mutex.h"
+#include "pios_queue.h"
+#include "pios_thread.h"
+#include "uavobjectmanager.h"
+#include "eventdispatcher.h"
+
+/* Nothing ever waits on it, it only needs to be a valid handle */
+static uintptr_t dummy_handle;
+
+/* There is no settings filesystem, every access to it fails */
+uintptr_t pios_uavo_settings_fs_id;
+
+void *PIOS_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void *PIOS_malloc_no_dma(size_t size)
+{
+	return malloc(size);
+}
+
+void PIOS_free(void *buf)
+{
+	free(buf);
+}
+
+struct pios_recursive_mutex *PIOS_Recursive_Mutex_Create(void)
+{
+	return (struct pios_recursive_mutex *)&dummy_handle;
+}
+
+bool PIOS_Recursive_Mutex_Lock(struct pios_recursive_mutex *mtx, uint32_t timeout_ms)
+{
+	return true;
+}
+
+bool PIOS_Recursive_Mutex_Unlock(struct pios_recursive_mutex *mtx)
+{
+	return true;
+}
+
+bool PIOS_Recursive_Mutex_GetStats(struct pios_recursive_mutex *mtx, struct pios_mutex_stats *stats)
+{
+	return false;
+}
+
+bool PIOS_Queue_Send(struct pios_queue *queuep, const void *itemp, uint32_t timeout_ms)
+{
+	return false;
+}
+
+bool PIOS_Queue_Receive(struct pios_queue *queuep, void *itemp, uint32_t timeout_ms)
+{
+	return false;
+}
+
+void PIOS_Thread_Scheduler_Suspend(void)
+{
+}
+
+void PIOS_Thread_Scheduler_Resume(void)
+{
+}
+
+uint32_t PIOS_Thread_Systime(void)
+{
+	return 0;
+}
+
+/* Callbacks run right away instead of on the event dispatcher task */
+int32_t EventCallbackDispatchPriority(UAVObjEvent *ev, UAVObjEventCallback cb, UAVObjEventPriority priority)
+{
+	cb(ev);
+	return 0;
+}
+
+int32_t PIOS_FLASHFS_ObjSave(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjLoad(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id, uint8_t * obj_data, uint16_t obj_size)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjDelete(uintptr_t fs_id, uint32_t obj_id, uint16_t obj_inst_id)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjSaveBatch(uintptr_t fs_id, pios_flashfs_batch_next next, void *ctx)
+{
+	return -1;
+}
+
+int32_t PIOS_FLASHFS_ObjLoadAll(uintptr_t fs_id, pios_flashfs_load_buffer buffer, pios_flashfs_load_done loaded, void *ctx)
+{
+	return -1;
+}
@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "vibration_bands.h"	/* API for the streaming vibration bands */
+
+}
+
+#include <math.h>		/* sinf() */
+
+#define SAMPLE_RATE 200.0f
+
+// To use a test fixture, derive a class from testing::Test.
+class VibrationBands : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+
+  // Feed seconds of a tone, returns how often the peak was updated
+  int feed(float frequency, float amplitude, float seconds) {
+    int updates = 0;
+    int n = seconds * SAMPLE_RATE;
+    for (int i = 0; i < n; i++) {
+      float t = sample++ / SAMPLE_RATE;
+      if (vibration_bands_update(&vb, amplitude * sinf(2 * M_PI * frequency * t)))
+        updates++;
+    }
+    return updates;
+  }
+
+  struct vibration_bands vb;
+  uint32_t sample = 0;
+};
+
+static const float frequencies[] = { 10, 20, 30, 40, 50, 0, 120, 60 };
+
+TEST_F(VibrationBands, BadParameters) {
+  EXPECT_EQ(-1, vibration_bands_init(&vb, frequencies, VIBRATION_BANDS_MAX + 1, SAMPLE_RATE, 2, 10));
+  EXPECT_EQ(-1, vibration_bands_init(&vb, frequencies, 8, 0, 2, 10));
+  EXPECT_EQ(-1, vibration_bands_init(&vb, frequencies, 8, SAMPLE_RATE, 0, 10));
+  EXPECT_EQ(-1, vibration_bands_init(&vb, frequencies, 8, SAMPLE_RATE, 2, 0));
+};
+
+TEST_F(VibrationBands, DisabledBands) {
+  ASSERT_EQ(0, vibration_bands_init(&vb, frequencies, 8, SAMPLE_RATE, 2, 10));
+
+  // Not set and above Nyquist
+  EXPECT_EQ(0x9f, vb.enabled);
+
+  feed(50, 1, 2);
+  EXPECT_EQ(0, vibration_bands_amplitude(&vb, 5));
+  EXPECT_EQ(0, vibration_bands_amplitude(&vb, 6));
+  EXPECT_EQ(0, vibration_bands_amplitude(&vb, VIBRATION_BANDS_MAX));
+};
+
+TEST_F(VibrationBands, ToneOnBand) {
+  ASSERT_EQ(0, vibration_bands_init(&vb, frequencies, 5, SAMPLE_RATE, 2, 10));
+
+  // Many time constants of 1 / (pi 2 Hz)
+  EXPECT_EQ(400, feed(30, 3, 20));
+
+  EXPECT_NEAR(3, vibration_bands_amplitude(&vb, 2), 0.1);
+  EXPECT_LT(vibration_bands_amplitude(&vb, 0), 0.3);
+  EXPECT_LT(vibration_bands_amplitude(&vb, 4), 0.3);
+
+  EXPECT_EQ(2, vb.peak_band);
+  EXPECT_NEAR(30, vb.peak_frequency, 0.1);
+  EXPECT_NEAR(3, vb.peak_amplitude, 0.1);
+};
+
+TEST_F(VibrationBands, ToneBetweenBands) {
+  const float wide[] = { 10, 20, 30, 40 };
+  ASSERT_EQ(0, vibration_bands_init(&vb, wide, 4, SAMPLE_RATE, 8, 20));
+
+  feed(23, 1, 10);
+
+  // The closest band follows the tone, at its own frequency. The image
+  // of the tone at the negative frequency leaks into the wide band and
+  // pulls the estimate a little.
+  EXPECT_EQ(1, vb.peak_band);
+  EXPECT_NEAR(23, vb.peak_frequency, 1);
+  EXPECT_GT(vb.peak_amplitude, 0.3);
+  EXPECT_LT(vb.peak_amplitude, 1);
+};
+
+TEST_F(VibrationBands, Silence) {
+  ASSERT_EQ(0, vibration_bands_init(&vb, frequencies, 5, SAMPLE_RATE, 2, 10));
+
+  feed(30, 0, 5);
+
+  for (uint8_t i = 0; i < 5; i++)
+    EXPECT_EQ(0, vibration_bands_amplitude(&vb, i));
+  EXPECT_EQ(0, vb.peak_amplitude);
+};
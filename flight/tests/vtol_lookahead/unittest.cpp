@@ -0,0 +1,232 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+extern "C" {
+
+#include "vtol_follower_lookahead.h"	/* API for the corner blends */
+
+}
+
+#include <math.h>		/* fabs() */
+
+// To use a test fixture, derive a class from testing::Test.
+class VtolLookahead : public testing::Test {
+protected:
+  virtual void SetUp() {
+    vtol_lookahead_reset(&plan);
+    limits.corner_distance = 10;
+    limits.corner_accel = 2;
+    limits.accel = 1.5;
+    limits.jerk = 3;
+  }
+
+  virtual void TearDown() {
+  }
+
+  // Largest acceleration along the segment, flying the planned speeds
+  float maxAccel() {
+    float worst = 0;
+    const float step = 0.01;
+    for (float s = 0; s + step < plan.length; s += step) {
+      float v0 = vtol_lookahead_speed(&plan, s);
+      float v1 = vtol_lookahead_speed(&plan, s + step);
+      worst = fmaxf(worst, fabsf((v1 * v1 - v0 * v0) / (2 * step)));
+    }
+    return worst;
+  }
+
+  struct vtol_lookahead_plan plan;
+  struct vtol_lookahead_limits limits;
+};
+
+TEST_F(VtolLookahead, NoNextSegment) {
+  const float start[2] = {0, 0};
+  const float end[2] = {100, 0};
+
+  // Coming in at speed, nothing to plan for
+  vtol_lookahead_plan(&plan, start, end, 5, 5, NULL, NULL, 0, false, &limits);
+  EXPECT_TRUE(plan.valid);
+  EXPECT_FALSE(plan.exit.valid);
+  EXPECT_FLOAT_EQ(5, vtol_lookahead_speed(&plan, 0));
+  EXPECT_FLOAT_EQ(5, vtol_lookahead_speed(&plan, 100));
+
+  float point[2], tangent[2];
+  EXPECT_FALSE(vtol_lookahead_blend(&plan, 99, point, tangent));
+};
+
+TEST_F(VtolLookahead, StraightOn) {
+  const float start[2] = {0, 0};
+  const float end[2] = {100, 0};
+  const float next[1][2] = {{200, 0}};
+  const float next_speed[1] = {5};
+
+  vtol_lookahead_plan(&plan, start, end, 5, 5, next, next_speed, 1, false, &limits);
+  EXPECT_TRUE(plan.exit.valid);
+  EXPECT_FLOAT_EQ(5, plan.exit.speed);
+
+  for (float s = 0; s < 100; s += 1)
+    EXPECT_FLOAT_EQ(5, vtol_lookahead_speed(&plan, s));
+};
+
+TEST_F(VtolLookahead, RightAngle) {
+  const float start[2] = {0, 0};
+  const float end[2] = {100, 0};
+  const float next[1][2] = {{100, 100}};
+  const float next_speed[1] = {8};
+
+  vtol_lookahead_plan(&plan, start, end, 8, 8, next, next_speed, 1, false, &limits);
+  ASSERT_TRUE(plan.exit.valid);
+  EXPECT_FLOAT_EQ(10, plan.exit.distance);
+
+  // Tightest in the middle of the blend: 2 m/s^2 at a radius of 10 / sqrt(2)
+  float expected = sqrtf(2 * 10 * 0.5f / sqrtf(0.5f));
+  EXPECT_NEAR(expected, plan.exit.speed, 1e-4);
+
+  // Slowing down before the blend and keeping the speed through it
+  EXPECT_FLOAT_EQ(8, vtol_lookahead_speed(&plan, 10));
+  EXPECT_NEAR(expected, vtol_lookahead_speed(&plan, 90), 1e-4);
+  EXPECT_NEAR(expected, vtol_lookahead_speed(&plan, 100), 1e-4);
+  for (float s = 10; s < 100; s += 1)
+    EXPECT_LE(vtol_lookahead_speed(&plan, s + 1), vtol_lookahead_speed(&plan, s));
+
+  EXPECT_LE(maxAccel(), limits.accel * 1.01f);
+
+  // The blend leaves the segment where it starts and cuts the corner
+  float point[2], tangent[2];
+  EXPECT_FALSE(vtol_lookahead_blend(&plan, 89, point, tangent));
+  ASSERT_TRUE(vtol_lookahead_blend(&plan, 91, point, tangent));
+  EXPECT_NEAR(0, point[1], 0.05);
+  EXPECT_NEAR(1, tangent[0], 0.1);
+
+  ASSERT_TRUE(vtol_lookahead_blend(&plan, 100, point, tangent));
+  EXPECT_FLOAT_EQ(97.5, point[0]);
+  EXPECT_FLOAT_EQ(2.5, point[1]);
+  EXPECT_NEAR(sqrtf(0.5f), tangent[0], 1e-5);
+  EXPECT_NEAR(sqrtf(0.5f), tangent[1], 1e-5);
+
+  // Overshooting the end it goes on along the next segment
+  ASSERT_TRUE(vtol_lookahead_blend(&plan, 115, point, tangent));
+  EXPECT_FLOAT_EQ(100, point[0]);
+  EXPECT_FLOAT_EQ(10, point[1]);
+  EXPECT_FLOAT_EQ(1, tangent[1]);
+};
+
+TEST_F(VtolLookahead, NextSegmentStartsInTheBlend) {
+  const float a[2] = {0, 0};
+  const float b[2] = {100, 0};
+  const float c[2][2] = {{100, 100}, {0, 100}};
+  const float speed[2] = {8, 8};
+
+  vtol_lookahead_plan(&plan, a, b, 8, 8, c, speed, 2, false, &limits);
+  float exit_point[2], exit_tangent[2];
+  ASSERT_TRUE(vtol_lookahead_blend(&plan, plan.length, exit_point, exit_tangent));
+  float exit_speed = vtol_lookahead_speed(&plan, plan.length);
+
+  // The next segment begins where the blend of the last one left off
+  vtol_lookahead_plan(&plan, b, c[0], 8, 0, &c[1], &speed[1], 1, false, &limits);
+  ASSERT_TRUE(plan.entry.valid);
+
+  float point[2], tangent[2];
+  ASSERT_TRUE(vtol_lookahead_blend(&plan, 0, point, tangent));
+  EXPECT_FLOAT_EQ(exit_point[0], point[0]);
+  EXPECT_FLOAT_EQ(exit_point[1], point[1]);
+  EXPECT_FLOAT_EQ(exit_tangent[0], tangent[0]);
+  EXPECT_FLOAT_EQ(exit_tangent[1], tangent[1]);
+  EXPECT_FLOAT_EQ(exit_speed, vtol_lookahead_speed(&plan, 0));
+
+  EXPECT_LE(maxAccel(), limits.accel * 1.01f);
+
+  // Planning it again when the segments after it are known keeps the entry
+  vtol_lookahead_plan(&plan, b, c[0], 8, 0, NULL, NULL, 0, false, &limits);
+  EXPECT_TRUE(plan.entry.valid);
+  EXPECT_FALSE(plan.exit.valid);
+
+  // A segment that doesn't go on from there starts from the current speed
+  const float elsewhere[2] = {50, 50};
+  vtol_lookahead_plan(&plan, elsewhere, c[0], 8, 0, NULL, NULL, 0, false, &limits);
+  EXPECT_FALSE(plan.entry.valid);
+  EXPECT_FLOAT_EQ(VTOL_LOOKAHEAD_MIN_SPEED, vtol_lookahead_speed(&plan, 0));
+  EXPECT_FLOAT_EQ(8, vtol_lookahead_speed(&plan, plan.length));
+};
+
+TEST_F(VtolLookahead, SlowsDownForTruncatedPath) {
+  // Short straight segments with no end in sight, it must be possible to
+  // stop at the last one known
+  const float start[2] = {0, 0};
+  const float end[2] = {10, 0};
+  const float next[3][2] = {{20, 0}, {30, 0}, {40, 0}};
+  const float next_speed[3] = {15, 15, 15};
+
+  vtol_lookahead_plan(&plan, start, end, 15, 15, next, next_speed, 3, true, &limits);
+  ASSERT_TRUE(plan.exit.valid);
+  EXPECT_NEAR(sqrtf(2 * limits.accel * 30), plan.exit.speed, 1e-3);
+
+  // Knowing the path ends there at speed, it doesn't
+  vtol_lookahead_plan(&plan, start, end, 15, 15, next, next_speed, 3, false, &limits);
+  EXPECT_FLOAT_EQ(15, plan.exit.speed);
+};
+
+TEST_F(VtolLookahead, TurningBack) {
+  const float start[2] = {0, 0};
+  const float end[2] = {100, 0};
+  const float next[1][2] = {{0, 0}};
+  const float next_speed[1] = {5};
+
+  vtol_lookahead_plan(&plan, start, end, 5, 5, next, next_speed, 1, false, &limits);
+  ASSERT_TRUE(plan.exit.valid);
+  EXPECT_FLOAT_EQ(0, plan.exit.distance);
+  EXPECT_FLOAT_EQ(0, plan.exit.speed);
+
+  // Still slow enough to get to the end
+  EXPECT_FLOAT_EQ(VTOL_LOOKAHEAD_MIN_SPEED, vtol_lookahead_speed(&plan, 100));
+
+  float point[2], tangent[2];
+  EXPECT_FALSE(vtol_lookahead_blend(&plan, 100, point, tangent));
+};
+
+TEST_F(VtolLookahead, InvalidLimits) {
+  const float start[2] = {0, 0};
+  const float end[2] = {100, 0};
+
+  limits.jerk = 0;
+  vtol_lookahead_plan(&plan, start, end, 5, 5, NULL, NULL, 0, false, &limits);
+  EXPECT_FALSE(plan.valid);
+
+  limits.jerk = 3;
+  vtol_lookahead_plan(&plan, start, start, 5, 5, NULL, NULL, 0, false, &limits);
+  EXPECT_FALSE(plan.valid);
+};
@@ -0,0 +1,124 @@
+/**
+ ******************************************************************************
+ * @file       unittest.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup UnitTests
+ * @{
+ * @addtogroup UnitTests
+ * @{
+ * @brief Unit test
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+/*
+ * NOTE: This program uses the Google Test infrastructure to drive the unit test
+ *
+ * Main site for Google Test: http://code.google.com/p/googletest/
+ * Documentation and examples: http://code.google.com/p/googletest/wiki/Documentation
+ */
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>		/* printf */
+#include <stdlib.h>		/* abort */
+#include <string.h>		/* memset */
+#include <stdint.h>		/* uint*_t */
+
+extern "C" {
+
+#include "WorldMagModel.h"
+
+}
+
+#include <math.h>		/* fabs() */
+
+// To use a test fixture, derive a class from testing::Test.
+class WorldMagModel : public testing::Test {
+protected:
+  virtual void SetUp() {
+  }
+
+  virtual void TearDown() {
+  }
+};
+
+// Reference values of the model before its coefficients were cached
+TEST_F(WorldMagModel, ReferenceField) {
+  float eps = 0.01f;
+  float B[3];
+
+  EXPECT_EQ(0, WMM_GetMagVector(65.0f, -20.0f, 0.0f, 5, 5, 2012, B));
+  EXPECT_NEAR(123.2603f, B[0], eps);
+  EXPECT_NEAR(-32.1159f, B[1], eps);
+  EXPECT_NEAR(508.3526f, B[2], eps);
+
+  EXPECT_EQ(0, WMM_GetMagVector(0.0f, 0.0f, 0.0f, 5, 5, 2012, B));
+  EXPECT_NEAR(275.3018f, B[0], eps);
+  EXPECT_NEAR(-27.8981f, B[1], eps);
+  EXPECT_NEAR(-155.9767f, B[2], eps);
+
+  EXPECT_EQ(0, WMM_GetMagVector(-45.0f, 170.0f, 1000.0f, 5, 5, 2012, B));
+  EXPECT_NEAR(181.8336f, B[0], eps);
+  EXPECT_NEAR(81.9264f, B[1], eps);
+  EXPECT_NEAR(-553.5773f, B[2], eps);
+
+  // The secular variation over the years
+  EXPECT_EQ(0, WMM_GetMagVector(37.4f, -122.1f, 30.0f, 5, 5, 2012, B));
+  EXPECT_NEAR(228.9872f, B[0], eps);
+  EXPECT_NEAR(56.6731f, B[1], eps);
+  EXPECT_NEAR(425.1649f, B[2], eps);
+
+  EXPECT_EQ(0, WMM_GetMagVector(37.4f, -122.1f, 30.0f, 1, 1, 2015, B));
+  EXPECT_NEAR(228.0652f, B[0], eps);
+  EXPECT_NEAR(55.3964f, B[1], eps);
+  EXPECT_NEAR(422.8648f, B[2], eps);
+}
+
+TEST_F(WorldMagModel, CachedNearby) {
+  float B[3], B_near[3], B_far[3];
+
+  EXPECT_EQ(0, WMM_GetMagVector(37.4f, -122.1f, 30.0f, 5, 5, 2012, B));
+
+  // Close enough to be the same field
+  EXPECT_EQ(0, WMM_GetMagVector(37.41f, -122.09f, 80.0f, 5, 5, 2012, B_near));
+  EXPECT_EQ(B[0], B_near[0]);
+  EXPECT_EQ(B[1], B_near[1]);
+  EXPECT_EQ(B[2], B_near[2]);
+
+  // Far enough to evaluate it again
+  EXPECT_EQ(0, WMM_GetMagVector(38.4f, -122.1f, 30.0f, 5, 5, 2012, B_far));
+  EXPECT_NE(B[2], B_far[2]);
+
+  // As is another day
+  EXPECT_EQ(0, WMM_GetMagVector(38.4f, -122.1f, 30.0f, 1, 1, 2015, B));
+  EXPECT_NE(B[2], B_far[2]);
+}
+
+TEST_F(WorldMagModel, Errors) {
+  float B[3], B_again[3];
+
+  EXPECT_EQ(0, WMM_GetMagVector(65.0f, -20.0f, 0.0f, 5, 5, 2012, B));
+
+  EXPECT_GT(0, WMM_GetMagVector(95.0f, -20.0f, 0.0f, 5, 5, 2012, B_again));
+  EXPECT_GT(0, WMM_GetMagVector(65.0f, -200.0f, 0.0f, 5, 5, 2012, B_again));
+  EXPECT_GT(0, WMM_GetMagVector(65.0f, -20.0f, 0.0f, 13, 5, 2012, B_again));
+  EXPECT_GT(0, WMM_GetMagVector(65.0f, -20.0f, 0.0f, 2, 30, 2012, B_again));
+
+  // Failures don't touch the cache
+  EXPECT_EQ(0, WMM_GetMagVector(65.0f, -20.0f, 0.0f, 5, 5, 2012, B_again));
+  EXPECT_NEAR(B[2], B_again[2], 0.01f);
+}
@@ -1,6 +1,6 @@
 TEMPLATE = lib
 TARGET = ExtensionSystem
-QT += widgets
+QT += widgets concurrent
 DEFINES += EXTENSIONSYSTEM_LIBRARY
 include(../../taulabslibrary.pri)
 include(extensionsystem_dependencies.pri)
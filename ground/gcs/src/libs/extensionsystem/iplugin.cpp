@@ -52,7 +52,7 @@
 
     \section2 Main Tag
     The root tag is \c plugin. It has mandatory attributes \c name
-    and \c version, and an optional \c compatVersion.
+    and \c version, and optional \c compatVersion and \c lazy.
     \table
     \header
         \o Tag
@@ -81,6 +81,14 @@
            set to the same value as \c version. The compatibility version
            is used to resolve dependencies on this plugin. See
            \l {Dependencies}{Dependencies} for details.
+    \row
+        \o lazy
+        \o If \c {"true"}, the plugin is loaded and initialized only after
+           the other plugins are running and the main window is up. Optional.
+           It is ignored when a plugin that is not lazy depends on this one,
+           and plugins that depend on a lazy plugin are started with it.
+           Suits plugins that only add actions, not gadgets that a workspace
+           may restore at startup.
     \endtable
 
     \section2 Plugin-describing Tags
@@ -37,10 +37,13 @@
 
 #include <QtCore/QMetaProperty>
 #include <QtCore/QDir>
+#include <QtCore/QLibrary>
+#include <QtCore/QTimer>
 #include <QtCore/QTextStream>
 #include <QtCore/QWriteLocker>
 #include <QtDebug>
 #include <QMetaMethod>
+#include <QtConcurrent/QtConcurrentMap>
 
 #ifdef WITH_TESTS
 #include <QTest>
@@ -48,6 +51,9 @@
 
 typedef QList<ExtensionSystem::PluginSpec *> PluginSpecSet;
 
+// Lazy plugins start this long after the others, once the main window is up
+static const int DEFERRED_START_DELAY_MS = 500;
+
 enum { debugLeaks = 0 };
 
 /*!
@@ -383,6 +389,9 @@ void PluginManager::formatOptions(QTextStream &str, int optionIndentation, int d
     formatOption(str, QLatin1String(OptionsParser::NO_LOAD_OPTION),
                  QLatin1String("plugin"), QLatin1String("Do not load <plugin>"),
                  optionIndentation, descriptionIndentation);
+    formatOption(str, QLatin1String(OptionsParser::PROFILE_OPTION),
+                 QString(), QLatin1String("Print the time each plugin takes to start"),
+                 optionIndentation, descriptionIndentation);
 }
 
 /*!
@@ -422,6 +431,15 @@ void PluginManager::formatPluginVersions(QTextStream &str) const
     }
 }
 
+/*!
+    \fn void PluginManager::startDeferredPlugins()
+    \internal
+*/
+void PluginManager::startDeferredPlugins()
+{
+    d->startDeferredPlugins();
+}
+
 void PluginManager::startTests()
 {
 #ifdef WITH_TESTS
@@ -492,7 +510,7 @@ PluginSpecPrivate *PluginManagerPrivate::privateSpec(PluginSpec *spec)
     \internal
 */
 PluginManagerPrivate::PluginManagerPrivate(PluginManager *pluginManager)
-    : extension("xml"), q(pluginManager)
+    : extension("xml"), profiling(false), profileElapsedMs(0), q(pluginManager)
 {
 }
 
@@ -578,9 +596,76 @@ void PluginManagerPrivate::removeObject(QObject *obj)
 void PluginManagerPrivate::loadPlugins()
 {
     QList<PluginSpec *> queue = loadQueue();
+
+    // Lazy plugins are deferred, unless a plugin that is not deferred
+    // depends on them. Going from the dependent plugins to their
+    // dependencies, everything a deferred plugin depends on is either
+    // deferred too or started right away.
+    QSet<PluginSpec *> deferred;
+    foreach (PluginSpec *spec, queue) {
+        if (spec->isLazy())
+            deferred.insert(spec);
+    }
+    QListIterator<PluginSpec *> rit(queue);
+    rit.toBack();
+    while (rit.hasPrevious()) {
+        PluginSpec *spec = rit.previous();
+        if (deferred.contains(spec))
+            continue;
+        foreach (PluginSpec *depSpec, spec->dependencySpecs())
+            deferred.remove(depSpec);
+    }
+
+    QList<PluginSpec *> startQueue;
+    deferredSpecs.clear();
+    foreach (PluginSpec *spec, queue) {
+        if (deferred.contains(spec))
+            deferredSpecs.append(spec);
+        else
+            startQueue.append(spec);
+    }
+
+    startPlugins(startQueue);
+    profilingReport("<startup>");
+
+    emit q->pluginsChanged();
+    q->m_allPluginsLoaded=true;
+    emit q->pluginsLoadEnded();
+
+    if (!deferredSpecs.isEmpty())
+        QTimer::singleShot(DEFERRED_START_DELAY_MS, q, SLOT(startDeferredPlugins()));
+}
+
+/*!
+    \fn void PluginManagerPrivate::startDeferredPlugins()
+    \internal
+*/
+void PluginManagerPrivate::startDeferredPlugins()
+{
+    QList<PluginSpec *> queue = deferredSpecs;
+    deferredSpecs.clear();
+    if (queue.isEmpty())
+        return;
+
+    startPlugins(queue);
+    profilingReport("<deferred startup>");
+
+    emit q->pluginsChanged();
+}
+
+/*!
+    \fn void PluginManagerPrivate::startPlugins(const QList<PluginSpec *> &queue)
+    \internal
+*/
+void PluginManagerPrivate::startPlugins(const QList<PluginSpec *> &queue)
+{
+    preloadLibraries(queue);
+    profilingReport("<preload libraries>");
+
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Loading %1 plugin")).arg(spec->name()));
         loadPlugin(spec, PluginSpec::Loaded);
+        profilingReport("load", spec);
         if(spec->name() == "Core") {
             QObject::connect(spec->plugin(),SIGNAL(splashMessages(QString)), q, SIGNAL(splashMessages(QString)));
             QObject::connect(spec->plugin(),SIGNAL(showSplash()), q, SIGNAL(showSplash()));
@@ -591,15 +676,75 @@ void PluginManagerPrivate::loadPlugins()
     foreach (PluginSpec *spec, queue) {
         emit q->splashMessages(QString(QObject::tr("Initializing %1 plugin")).arg(spec->name()));
         loadPlugin(spec, PluginSpec::Initialized);
+        profilingReport("initialize", spec);
     }
     QListIterator<PluginSpec *> it(queue);
     it.toBack();
     while (it.hasPrevious()) {
-        loadPlugin(it.previous(), PluginSpec::Running);
+        PluginSpec *spec = it.previous();
+        loadPlugin(spec, PluginSpec::Running);
+        profilingReport("extensionsInitialized", spec);
     }
-    emit q->pluginsChanged();
-    q->m_allPluginsLoaded=true;
-    emit q->pluginsLoadEnded();
+}
+
+static void preloadLibrary(const QString &libName)
+{
+    // The library stays mapped when this goes out of scope, the plugin
+    // loader then finds it already resolved
+    QLibrary library(libName);
+    library.load();
+}
+
+/*!
+    \fn void PluginManagerPrivate::preloadLibraries(const QList<PluginSpec *> &queue)
+    \internal
+
+    Map the plugin libraries in parallel, which is where most of the time
+    of loading a plugin goes. Plugins are independent of each other at this
+    point, the dynamic linker resolves the libraries they link against.
+    Creating the plugin instances and initializing them stays in order in
+    the GUI thread, as they create widgets and depend on each other's objects.
+*/
+void PluginManagerPrivate::preloadLibraries(const QList<PluginSpec *> &queue)
+{
+    QStringList libNames;
+    foreach (PluginSpec *spec, queue) {
+        if (spec->state() == PluginSpec::Resolved && !spec->hasError())
+            libNames.append(spec->d->libraryName());
+    }
+    QtConcurrent::blockingMap(libNames, preloadLibrary);
+}
+
+/*!
+    \fn void PluginManagerPrivate::initProfiling()
+    \internal
+*/
+void PluginManagerPrivate::initProfiling()
+{
+    if (profiling)
+        return;
+    profiling = true;
+    profileTimer.start();
+    profileElapsedMs = 0;
+}
+
+/*!
+    \fn void PluginManagerPrivate::profilingReport(const char *what, const PluginSpec *spec)
+    \internal
+
+    Print the time since the last report and since profiling started.
+*/
+void PluginManagerPrivate::profilingReport(const char *what, const PluginSpec *spec)
+{
+    if (!profiling)
+        return;
+    const qint64 absoluteElapsedMs = profileTimer.elapsed();
+    const qint64 elapsedMs = absoluteElapsedMs - profileElapsedMs;
+    profileElapsedMs = absoluteElapsedMs;
+    if (spec)
+        qDebug("%-22s %-22s %8lldms (%8lldms)", what, qPrintable(spec->name()), elapsedMs, absoluteElapsedMs);
+    else
+        qDebug("%-45s %8lldms (%8lldms)", what, elapsedMs, absoluteElapsedMs);
 }
 
 /*!
@@ -124,6 +124,7 @@ signals:
     void showSplash();
 private slots:
     void startTests();
+    void startDeferredPlugins();
 
 private:
     Internal::PluginManagerPrivate *d;
@@ -31,6 +31,7 @@
 
 #include "pluginspec.h"
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QList>
 #include <QtCore/QSet>
 #include <QtCore/QStringList>
@@ -56,6 +57,7 @@ public:
 
     // Plugin operations
     void loadPlugins();
+    void startDeferredPlugins();
     void setPluginPaths(const QStringList &paths);
     QList<PluginSpec *> loadQueue();
     void loadPlugin(PluginSpec *spec, PluginSpec::State destState);
@@ -63,12 +65,20 @@ public:
 
     QList<PluginSpec *> pluginSpecs;
     QList<PluginSpec *> testSpecs;
+    QList<PluginSpec *> deferredSpecs;
     QStringList pluginPaths;
     QString extension;
     QList<QObject *> allObjects; // ### make this a QList<QPointer<QObject> > > ?
 
     QStringList arguments;
 
+    // Startup timing, enabled by the -profile option
+    void initProfiling();
+    void profilingReport(const char *what, const PluginSpec *spec = 0);
+    bool profiling;
+    QElapsedTimer profileTimer;
+    qint64 profileElapsedMs;
+
     // Look in argument descriptions of the specs for the option.
     PluginSpec *pluginForOption(const QString &option, bool *requiresArgument) const;
     PluginSpec *pluginByName(const QString &name) const;
@@ -80,6 +90,8 @@ private:
     PluginManager *q;
 
     void readPluginPaths();
+    void startPlugins(const QList<PluginSpec *> &queue);
+    void preloadLibraries(const QList<PluginSpec *> &queue);
     bool loadQueue(PluginSpec *spec,
             QList<PluginSpec *> &queue,
             QList<PluginSpec *> &circularityCheckQueue);
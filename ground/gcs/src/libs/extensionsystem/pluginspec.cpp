@@ -224,6 +224,16 @@ QString PluginSpec::url() const
     return d->url;
 }
 
+/*!
+    \fn bool PluginSpec::isLazy() const
+    True if the plugin is only started once the application is up, unless a plugin that
+    starts right away depends on it. This is valid after the PluginSpec::Read state is reached.
+*/
+bool PluginSpec::isLazy() const
+{
+    return d->lazy;
+}
+
 /*!
     \fn QList<PluginDependency> PluginSpec::dependencies() const
     The plugin dependencies. This is valid after the PluginSpec::Read state is reached.
@@ -363,6 +373,7 @@ namespace {
     const char * const PLUGIN_NAME = "name";
     const char * const PLUGIN_VERSION = "version";
     const char * const PLUGIN_COMPATVERSION = "compatVersion";
+    const char * const PLUGIN_LAZY = "lazy";
     const char * const VENDOR = "vendor";
     const char * const COPYRIGHT = "copyright";
     const char * const LICENSE = "license";
@@ -382,7 +393,8 @@ namespace {
     \internal
 */
 PluginSpecPrivate::PluginSpecPrivate(PluginSpec *spec)
-    : plugin(0),
+    : lazy(false),
+    plugin(0),
     state(PluginSpec::Invalid),
     hasError(false),
     q(spec)
@@ -506,6 +518,7 @@ void PluginSpecPrivate::readPluginSpec(QXmlStreamReader &reader)
     } else if (compatVersion.isEmpty()) {
         compatVersion = version;
     }
+    lazy = (reader.attributes().value(PLUGIN_LAZY) == QLatin1String("true"));
     while (!reader.atEnd()) {
         reader.readNext();
         switch (reader.tokenType()) {
@@ -747,20 +760,11 @@ bool PluginSpecPrivate::resolveDependencies(const QList<PluginSpec *> &specs)
 }
 
 /*!
-    \fn bool PluginSpecPrivate::loadLibrary()
+    \fn QString PluginSpecPrivate::libraryName() const
     \internal
 */
-bool PluginSpecPrivate::loadLibrary()
+QString PluginSpecPrivate::libraryName() const
 {
-    if (hasError)
-        return false;
-    if (state != PluginSpec::Resolved) {
-        if (state == PluginSpec::Loaded)
-            return true;
-        errorString = QCoreApplication::translate("PluginSpec", "Loading the library failed because state != Resolved");
-        hasError = true;
-        return false;
-    }
 #ifdef QT_NO_DEBUG
 
 #ifdef Q_OS_WIN
@@ -783,6 +787,26 @@ bool PluginSpecPrivate::loadLibrary()
 
 #endif
 
+    return libName;
+}
+
+/*!
+    \fn bool PluginSpecPrivate::loadLibrary()
+    \internal
+*/
+bool PluginSpecPrivate::loadLibrary()
+{
+    if (hasError)
+        return false;
+    if (state != PluginSpec::Resolved) {
+        if (state == PluginSpec::Loaded)
+            return true;
+        errorString = QCoreApplication::translate("PluginSpec", "Loading the library failed because state != Resolved");
+        hasError = true;
+        return false;
+    }
+
+    QString libName = libraryName();
     PluginLoader loader(libName);
     if (!loader.load()) {
         hasError = true;
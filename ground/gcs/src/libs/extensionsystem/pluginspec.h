@@ -77,6 +77,7 @@ public:
     QString license() const;
     QString description() const;
     QString url() const;
+    bool isLazy() const;
     QList<PluginDependency> dependencies() const;
 
     typedef QList<PluginArgumentDescription> PluginArgumentDescriptions;
@@ -52,6 +52,7 @@ public:
     bool read(const QString &fileName);
     bool provides(const QString &pluginName, const QString &version) const;
     bool resolveDependencies(const QList<PluginSpec *> &specs);
+    QString libraryName() const;
     bool loadLibrary();
     bool initializePlugin();
     bool initializeExtensions();
@@ -66,6 +67,7 @@ public:
     QString license;
     QString description;
     QString url;
+    bool lazy;
     QList<PluginDependency> dependencies;
 
     QString location;
@@ -125,5 +125,7 @@ $(INITFIELDS)
 	protected static final boolean ISSETTINGS = $(ISSETTINGS) > 0;
 	protected static int NUMBYTES = 0;
 
+	// Field positions for UAVObject.getField(int)
+$(FIELDINDICES)
 
 }
@@ -31,6 +31,8 @@
 namespace core {
     MemoryCache::MemoryCache()
     {
+        // Cost of a decoded tile is its size in bytes
+        decodedTiles.setMaxCost(64*1048576);
 
     }
 
@@ -58,4 +60,33 @@ namespace core {
         kiberCacheLock.unlock();
     }
 
+    QImage MemoryCache::GetDecodedTileFromMemoryCache(const RawTile &tile)
+    {
+        QMutexLocker locker(&decodedTilesLock);
+        QImage *image=decodedTiles.object(tile);
+        if(image==0)
+            return QImage();
+        return *image;
+    }
+    void MemoryCache::AddDecodedTileToMemoryCache(const RawTile &tile, const QImage &image)
+    {
+        if(image.isNull())
+            return;
+        QMutexLocker locker(&decodedTilesLock);
+        decodedTiles.insert(tile,new QImage(image),image.byteCount());
+#ifdef DEBUG_MEMORY_CACHE
+        qDebug()<<"Decoded tiles="<<decodedTiles.totalCost()<<" bytes in "<<decodedTiles.count()<<" tiles";
+#endif
+    }
+    void MemoryCache::setDecodedTileCacheCapacity(const int &megabytes)
+    {
+        QMutexLocker locker(&decodedTilesLock);
+        decodedTiles.setMaxCost(megabytes*1048576);
+    }
+    double MemoryCache::DecodedTileCacheSize()
+    {
+        QMutexLocker locker(&decodedTilesLock);
+        return decodedTiles.totalCost()/1048576.0;
+    }
+
 }
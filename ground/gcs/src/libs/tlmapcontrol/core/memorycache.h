@@ -32,6 +32,8 @@
 #include <QMutex>
 #include <QReadWriteLock>
 #include <QQueue>
+#include <QCache>
+#include <QImage>
 #include "kibertilecache.h"
 #include <QDebug>
 #include "debugheader.h"
@@ -45,6 +47,16 @@ namespace core {
         QByteArray GetTileFromMemoryCache(const RawTile &tile);
         void AddTileToMemoryCache(const RawTile &tile, const QByteArray &pic);
         QReadWriteLock kiberCacheLock;
+
+        // Decoded tiles, ready to paint. Least recently painted tiles are
+        // dropped first once the images exceed the capacity.
+        QImage GetDecodedTileFromMemoryCache(const RawTile &tile);
+        void AddDecodedTileToMemoryCache(const RawTile &tile, const QImage &image);
+        void setDecodedTileCacheCapacity(const int &megabytes);
+        double DecodedTileCacheSize();
+    private:
+        QCache<RawTile, QImage> decodedTiles;
+        QMutex decodedTilesLock;
     };
 
 
@@ -44,4 +44,12 @@ bool PureImageProxy::Save(const QByteArray &array, QPixmap &pic)
     pic=QPixmap::fromImage(QImage::fromData(array));
     return true;
 }
+//! Decodes a tile into the format that paints fastest. Safe to call from any thread.
+QImage PureImageProxy::Decode(const QByteArray &array)
+{
+    QImage image=QImage::fromData(array);
+    if(image.isNull())
+        return image;
+    return image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
 }
@@ -39,6 +39,7 @@ namespace core {
         PureImageProxy();
         static QPixmap FromStream(const QByteArray &array);
         static bool Save(const QByteArray &array,QPixmap &pic);
+        static QImage Decode(const QByteArray &array);
     };
 
 }
@@ -167,93 +167,131 @@ namespace core {
                 db.close();
                 return false;
             }
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
             db.close();
         }
         QSqlDatabase::removeDatabase(QLatin1String("CreateConn"));
         return true;
     }
+    PureImageCache::Connection::Connection(const QString &file, qlonglong id):file(file),name(QString::number(id)),getTile(0),insertTile(0),insertTileData(0)
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE",name);
+        db.setDatabaseName(file);
+        db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=1000");
+        if(!db.open())
+        {
+#ifdef DEBUG_PUREIMAGECACHE
+            qDebug()<<"Connection: Unable to open"<<file;
+#endif //DEBUG_PUREIMAGECACHE
+            return;
+        }
+        {
+            QSqlQuery query(db);
+            // Readers don't wait for the tiles being written, and caches created
+            // before the index don't scan the whole table for every tile
+            query.exec("PRAGMA journal_mode=WAL");
+            query.exec("PRAGMA synchronous=NORMAL");
+            query.exec("CREATE INDEX IF NOT EXISTS IndexOfTiles ON Tiles (X, Y, Zoom, Type)");
+        }
+        getTile=new QSqlQuery(db);
+        getTile->prepare("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=? AND Y=? AND Zoom=? AND Type=?)");
+        insertTile=new QSqlQuery(db);
+        insertTile->prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
+        insertTileData=new QSqlQuery(db);
+        insertTileData->prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
+    }
+    PureImageCache::Connection::~Connection()
+    {
+        delete getTile;
+        delete insertTile;
+        delete insertTileData;
+        db.close();
+        db=QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+    /**
+    * @brief Returns the connection of the calling thread to the current cache,
+    * opening it the first time. Must be called with the lock held.
+    */
+    PureImageCache::Connection *PureImageCache::connection()
+    {
+        QString db=gtilecache+"Data.qmdb";
+        Connection *cn=connections.localData();
+        if(cn && cn->file==db)
+            return cn;
+
+        // The cache was moved since this thread last used it
+        delete cn;
+        Mcounter.lock();
+        qlonglong id=++ConnCounter;
+        Mcounter.unlock();
+        cn=new Connection(db,id);
+        connections.setLocalData(cn);
+        return cn;
+    }
     bool PureImageCache::PutImageToCache(const QByteArray &tile, const MapType::Types &type,const Point &pos,const int &zoom)
+    {
+        QList<CacheItemQueue*> tiles;
+        CacheItemQueue item(type,pos,tile,zoom);
+        tiles.append(&item);
+        return PutImagesToCache(tiles);
+    }
+    /**
+    * @brief Writes the tiles in a single transaction
+    */
+    bool PureImageCache::PutImagesToCache(const QList<CacheItemQueue*> &tiles)
     {
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return false;
         lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"PutImageToCache Start:";//<<pos;
+        qDebug()<<"PutImagesToCache Start:"<<tiles.count();
 #endif //DEBUG_PUREIMAGECACHE
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        Connection *cn=connection();
+        if(!cn->db.isOpen())
         {
-            QSqlDatabase cn;
-            cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-            QString db=gtilecache+"Data.qmdb";
-            cn.setDatabaseName(db);
-            cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-            if(cn.open())
-            {
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO Tiles(X, Y, Zoom, Type,Date) VALUES(?, ?, ?, ?,?)");
-                    query.addBindValue(pos.X());
-                    query.addBindValue(pos.Y());
-                    query.addBindValue(zoom);
-
-                    query.addBindValue((int)type);
-                    query.addBindValue(QDateTime::currentDateTime().toString());
-                    query.exec();
-                }
-                {
-                    QSqlQuery query(cn);
-                    query.prepare("INSERT INTO TilesData(id, Tile) VALUES((SELECT last_insert_rowid()), ?)");
-                    query.addBindValue(tile);
-                    query.exec();
-                }
-                cn.close();
-            }
+            lock.unlock();
+            return false;
+        }
+        QString date=QDateTime::currentDateTime().toString();
+        cn->db.transaction();
+        foreach(CacheItemQueue *item,tiles)
+        {
+            cn->insertTile->bindValue(0,item->GetPosition().X());
+            cn->insertTile->bindValue(1,item->GetPosition().Y());
+            cn->insertTile->bindValue(2,item->GetZoom());
+            cn->insertTile->bindValue(3,(int)item->GetMapType());
+            cn->insertTile->bindValue(4,date);
+            if(!cn->insertTile->exec())
+                continue;
+            cn->insertTileData->bindValue(0,item->GetImg());
+            cn->insertTileData->exec();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
+        bool ret=cn->db.commit();
         lock.unlock();
-        return true;
+        return ret;
     }
     QByteArray PureImageCache::GetImageFromCache(MapType::Types type, Point pos, int zoom)
     {
-        lock.lockForRead();
         QByteArray ar;
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return ar;
-        QString dir=gtilecache;
-        Mcounter.lock();
-        qlonglong id=++ConnCounter;
-        Mcounter.unlock();
+        lock.lockForRead();
 #ifdef DEBUG_PUREIMAGECACHE
-        qDebug()<<"Cache dir="<<dir<<" Try to GET:"<<pos.X()+","+pos.Y();
+        qDebug()<<"Cache dir="<<gtilecache<<" Try to GET:"<<pos.X()+","+pos.Y();
 #endif //DEBUG_PUREIMAGECACHE
-
+        Connection *cn=connection();
+        if(cn->db.isOpen())
         {
-            QString db=dir+"Data.qmdb";
-            {
-                QSqlDatabase cn;
-
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT Tile FROM TilesData WHERE id = (SELECT id FROM Tiles WHERE X=%1 AND Y=%2 AND Zoom=%3 AND Type=%4)").arg(pos.X()).arg(pos.Y()).arg(zoom).arg((int) type));
-                        query.next();
-                        if(query.isValid())
-                        {
-                            ar=query.value(0).toByteArray();
-                        }
-                    }
-                    cn.close();
-                }
-            }
+            cn->getTile->bindValue(0,pos.X());
+            cn->getTile->bindValue(1,pos.Y());
+            cn->getTile->bindValue(2,zoom);
+            cn->getTile->bindValue(3,(int)type);
+            if(cn->getTile->exec() && cn->getTile->next())
+                ar=cn->getTile->value(0).toByteArray();
+            // Don't keep the read transaction open until the next tile
+            cn->getTile->finish();
         }
-        QSqlDatabase::removeDatabase(QString::number(id));
         lock.unlock();
         return ar;
     }
@@ -262,41 +300,30 @@ namespace core {
         if(gtilecache.isEmpty()|gtilecache.isNull())
             return;
         QList<long> add;
-        bool ret=true;
-        QString dir=gtilecache;
+        if(!QFileInfo(gtilecache+"Data.qmdb").exists())
+            return;
+        lock.lockForRead();
+        Connection *cn=connection();
+        if(cn->db.isOpen())
         {
-            QString db=dir+"Data.qmdb";
-            ret=QFileInfo(db).exists();
-            if(ret)
+            QSqlQuery query(cn->db);
+            query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
+            while(query.next())
             {
-                QSqlDatabase cn;
-                Mcounter.lock();
-                qlonglong id=++ConnCounter;
-                Mcounter.unlock();
-                cn = QSqlDatabase::addDatabase("QSQLITE",QString::number(id));
-                cn.setDatabaseName(db);
-                cn.setConnectOptions("QSQLITE_ENABLE_SHARED_CACHE");
-                if(cn.open())
-                {
-                    {
-                        QSqlQuery query(cn);
-                        query.exec(QString("SELECT id, X, Y, Zoom, Type, Date FROM Tiles"));
-                        while(query.next())
-                        {
-                            if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
-                                add.append(query.value(0).toLongLong());
-                        }
-                        foreach(long i,add)
-                        {
-                            query.exec(QString("DELETE FROM Tiles WHERE id = %1;").arg(i));
-                        }
-                    }
-
-                    cn.close();
-                }
-                QSqlDatabase::removeDatabase(QString::number(id));
+                if(QDateTime::fromString(query.value(5).toString()).daysTo(QDateTime::currentDateTime())>days)
+                    add.append(query.value(0).toLongLong());
             }
+            query.finish();
+            cn->db.transaction();
+            query.prepare("DELETE FROM Tiles WHERE id = ?");
+            foreach(long i,add)
+            {
+                query.bindValue(0,(qlonglong)i);
+                query.exec();
+            }
+            cn->db.commit();
         }
+        lock.unlock();
     }
     // PureImageCache::ExportMapDataToDB("C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data.qmdb","C:/Users/Xapo/Documents/mapcontrol/debug/mapscache/data2.qmdb");
     bool PureImageCache::ExportMapDataToDB(QString sourceFile, QString destFile)
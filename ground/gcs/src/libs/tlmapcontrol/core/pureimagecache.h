@@ -43,6 +43,8 @@
 #include <QList>
 #include <QMutex>
 #include <QReadWriteLock>
+#include <QThreadStorage>
+#include "cacheitemqueue.h"
 namespace core {
     class PureImageCache
     {
@@ -51,12 +53,33 @@ namespace core {
         PureImageCache();
         static bool CreateEmptyDB(const QString &file);
         bool PutImageToCache(const QByteArray &tile,const MapType::Types &type,const core::Point &pos, const int &zoom);
+        bool PutImagesToCache(const QList<CacheItemQueue*> &tiles);
         QByteArray GetImageFromCache(MapType::Types type, core::Point pos, int zoom);
         QString GtileCache();
         void setGtileCache(const QString &value);
         static bool ExportMapDataToDB(QString sourceFile, QString destFile);
         void deleteOlderTiles(int const& days);
     private:
+        /**
+        * @brief A connection to the cache database with its prepared statements.
+        * Connections can only be used by the thread that opened them, so each
+        * thread keeps its own until it exits.
+        */
+        class Connection
+        {
+        public:
+            Connection(const QString &file,qlonglong id);
+            ~Connection();
+            QString file;
+            QString name;
+            QSqlDatabase db;
+            QSqlQuery *getTile;
+            QSqlQuery *insertTile;
+            QSqlQuery *insertTileData;
+        };
+        Connection *connection();
+        QThreadStorage<Connection*> connections;
+
         QString gtilecache;
         QMutex Mcounter;
         QReadWriteLock lock;
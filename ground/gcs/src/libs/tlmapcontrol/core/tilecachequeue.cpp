@@ -29,6 +29,9 @@
 
 
 //#define DEBUG_TILECACHEQUEUE
+
+// Tiles written per transaction, so that readers are not kept waiting behind a long one
+#define MAX_TILES_PER_TRANSACTION 64
  
 namespace core {
 TileCacheQueue::TileCacheQueue()
@@ -80,21 +83,22 @@ void TileCacheQueue::run()
 #endif //DEBUG_TILECACHEQUEUE
     while(true)
     {
-        CacheItemQueue *task;
+        QList<CacheItemQueue*> tasks;
 #ifdef DEBUG_TILECACHEQUEUE
         qDebug()<<"Cache";
 #endif //DEBUG_TILECACHEQUEUE
-        if(tileCacheQueue.count()>0)
+        mutex.lock();
+        while(tileCacheQueue.count()>0 && tasks.count()<MAX_TILES_PER_TRANSACTION)
+            tasks.append(tileCacheQueue.dequeue());
+        mutex.unlock();
+        if(tasks.count()>0)
         {
-            mutex.lock();
-            task=tileCacheQueue.dequeue();
-            mutex.unlock();
 #ifdef DEBUG_TILECACHEQUEUE
-            qDebug()<<"Cache engine Put:"<<task->GetPosition().X()<<","<<task->GetPosition().Y();
+            qDebug()<<"Cache engine Put:"<<tasks.count();
 #endif //DEBUG_TILECACHEQUEUE
-            Cache::Instance()->ImageCache.PutImageToCache(task->GetImg(),task->GetMapType(),task->GetPosition(),task->GetZoom());
-            usleep(44);
-            delete task;
+            // Everything that queued up while the last batch was written goes in one transaction
+            Cache::Instance()->ImageCache.PutImagesToCache(tasks);
+            qDeleteAll(tasks);
         }
 
         else
@@ -0,0 +1,172 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      Memory mapped package of map tiles for use without internet
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "tilepack.h"
+#include <QtEndian>
+#include <QDebug>
+#include <string.h>
+
+namespace core {
+    static const char tilePackMagic[4]={'T','L','T','P'};
+
+    TilePack::TilePack():base(0),size(0),index(0),count(0)
+    {
+    }
+    TilePack::~TilePack()
+    {
+        if(base)
+            file.unmap(const_cast<uchar*>(base));
+    }
+    bool TilePack::Open(const QString &fileName)
+    {
+        file.setFileName(fileName);
+        if(!file.open(QIODevice::ReadOnly))
+            return false;
+        size=file.size();
+        if(size<HeaderSize)
+            return false;
+        base=file.map(0,size);
+        if(!base)
+            return false;
+
+        if(memcmp(base,tilePackMagic,sizeof(tilePackMagic))!=0 || qFromLittleEndian<quint32>(base+4)!=Version)
+        {
+            qDebug()<<"TilePack: not a tile package:"<<fileName;
+            return false;
+        }
+        count=qFromLittleEndian<quint32>(base+8);
+        quint64 indexOffset=qFromLittleEndian<quint64>(base+16);
+        if(indexOffset>(quint64)size || ((quint64)size-indexOffset)/IndexEntrySize<count)
+        {
+            qDebug()<<"TilePack: truncated index in"<<fileName;
+            count=0;
+            return false;
+        }
+        index=base+indexOffset;
+        return true;
+    }
+    QByteArray TilePack::GetImage(const MapType::Types &type,const core::Point &pos,const int &zoom)const
+    {
+        const quint32 key[4]={(quint32)type,(quint32)zoom,(quint32)pos.X(),(quint32)pos.Y()};
+        quint32 low=0;
+        quint32 high=count;
+        while(low<high)
+        {
+            quint32 mid=low+(high-low)/2;
+            const uchar *entry=index+(qint64)mid*IndexEntrySize;
+            int cmp=0;
+            for(int i=0;i<4 && cmp==0;++i)
+            {
+                quint32 field=qFromLittleEndian<quint32>(entry+4*i);
+                cmp=field<key[i]?-1:(field>key[i]?1:0);
+            }
+            if(cmp<0)
+                low=mid+1;
+            else if(cmp>0)
+                high=mid;
+            else
+            {
+                quint64 offset=qFromLittleEndian<quint64>(entry+16);
+                quint32 length=qFromLittleEndian<quint32>(entry+24);
+                if(offset>(quint64)size || length>(quint64)size-offset)
+                    return QByteArray();
+                return QByteArray((const char*)base+offset,length);
+            }
+        }
+        return QByteArray();
+    }
+
+    bool TilePackWriter::Entry::operator<(const Entry &other)const
+    {
+        if(type!=other.type)
+            return type<other.type;
+        if(zoom!=other.zoom)
+            return zoom<other.zoom;
+        if(x!=other.x)
+            return x<other.x;
+        return y<other.y;
+    }
+    bool TilePackWriter::Open(const QString &fileName)
+    {
+        entries.clear();
+        file.setFileName(fileName);
+        if(!file.open(QIODevice::WriteOnly|QIODevice::Truncate))
+            return false;
+        // The header is completed by Finish()
+        return file.write(QByteArray(TilePack::HeaderSize,0))==TilePack::HeaderSize;
+    }
+    bool TilePackWriter::AddImage(const MapType::Types &type,const core::Point &pos,const int &zoom,const QByteArray &image)
+    {
+        Entry entry;
+        entry.type=type;
+        entry.zoom=zoom;
+        entry.x=pos.X();
+        entry.y=pos.Y();
+        entry.offset=file.pos();
+        entry.length=image.size();
+        if(file.write(image)!=image.size())
+            return false;
+        entries.append(entry);
+        return true;
+    }
+    bool TilePackWriter::Finish()
+    {
+        qStableSort(entries);
+
+        QByteArray index;
+        index.reserve(entries.count()*TilePack::IndexEntrySize);
+        int unique=0;
+        for(int i=0;i<entries.count();++i)
+        {
+            const Entry &e=entries.at(i);
+            // A tile added twice is only indexed once
+            if(i>0 && !(entries.at(i-1)<e))
+                continue;
+            uchar raw[TilePack::IndexEntrySize];
+            qToLittleEndian<quint32>(e.type,raw);
+            qToLittleEndian<quint32>(e.zoom,raw+4);
+            qToLittleEndian<quint32>(e.x,raw+8);
+            qToLittleEndian<quint32>(e.y,raw+12);
+            qToLittleEndian<quint64>(e.offset,raw+16);
+            qToLittleEndian<quint32>(e.length,raw+24);
+            qToLittleEndian<quint32>(0,raw+28);
+            index.append((const char*)raw,sizeof(raw));
+            ++unique;
+        }
+
+        uchar header[TilePack::HeaderSize];
+        memcpy(header,tilePackMagic,sizeof(tilePackMagic));
+        qToLittleEndian<quint32>(TilePack::Version,header+4);
+        qToLittleEndian<quint32>(unique,header+8);
+        qToLittleEndian<quint32>(0,header+12);
+        qToLittleEndian<quint64>(file.pos(),header+16);
+
+        bool ok=file.write(index)==index.size();
+        ok=ok && file.seek(0) && file.write((const char*)header,sizeof(header))==(qint64)sizeof(header);
+        file.close();
+        return ok && file.error()==QFile::NoError;
+    }
+}
@@ -0,0 +1,96 @@
+/**
+******************************************************************************
+*
+* @file       tilepack.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      Memory mapped package of map tiles for use without internet
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TILEPACK_H
+#define TILEPACK_H
+
+#include <QFile>
+#include <QList>
+#include <QByteArray>
+#include "maptype.h"
+#include "point.h"
+
+namespace core {
+    /**
+    * @brief Read only package of map tiles in a single memory mapped file.
+    * Finding a tile is a binary search of the index and reading it a copy out
+    * of the mapping, with no database queries or locks, so any number of
+    * loader threads can read at once.
+    *
+    * The file is little endian and laid out as
+    *  - header: "TLTP", version, tile count, reserved, offset of the index
+    *  - the encoded tile images back to back
+    *  - index: type, zoom, x, y, offset and size of each image, sorted by
+    *    type, zoom, x and y
+    */
+    class TilePack
+    {
+    public:
+        TilePack();
+        ~TilePack();
+        bool Open(const QString &fileName);
+        QString FileName()const{return file.fileName();}
+        int Count()const{return count;}
+        QByteArray GetImage(const MapType::Types &type,const core::Point &pos,const int &zoom)const;
+
+        static const quint32 Version=1;
+        static const int HeaderSize=24;
+        static const int IndexEntrySize=32;
+    private:
+        QFile file;
+        const uchar *base;
+        qint64 size;
+        const uchar *index;
+        quint32 count;
+    };
+
+    /**
+    * @brief Writes a TilePack. The images are written as they are added, in
+    * any order, and only the index is kept until Finish() sorts and appends it.
+    */
+    class TilePackWriter
+    {
+    public:
+        bool Open(const QString &fileName);
+        bool AddImage(const MapType::Types &type,const core::Point &pos,const int &zoom,const QByteArray &image);
+        bool Finish();
+        int Count()const{return entries.count();}
+    private:
+        struct Entry
+        {
+            quint32 type;
+            quint32 zoom;
+            quint32 x;
+            quint32 y;
+            quint64 offset;
+            quint32 length;
+            bool operator<(const Entry &other)const;
+        };
+        QList<Entry> entries;
+        QFile file;
+    };
+}
+#endif // TILEPACK_H
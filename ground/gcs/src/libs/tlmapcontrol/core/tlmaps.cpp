@@ -30,6 +30,7 @@
 #include "utils/coordinateconversions.h"
 #include "QDebug"
 #include "QPainter"
+#include <QThreadStorage>
 
 //#define DEBUG_Q_TILES
 
@@ -58,6 +59,39 @@ namespace core {
     TLMaps::~TLMaps()
     {
         TileDBcacheQueue.wait();
+        qDeleteAll(retiredTilePacks);
+        delete tilePack.load();
+    }
+
+    /**
+     * @brief TLMaps::SetTilePack Serves tiles from an offline package before
+     * looking in the cache database or on the server
+     * @param file Package to use, or an empty string to stop using one
+     * @return Returns false if the package could not be opened
+     */
+    bool TLMaps::SetTilePack(const QString &file)
+    {
+        QMutexLocker locker(&tilePackProtect);
+        TilePack *pack=0;
+        if(!file.isEmpty())
+        {
+            pack=new TilePack;
+            if(!pack->Open(file))
+            {
+                delete pack;
+                return false;
+            }
+        }
+        TilePack *old=tilePack.fetchAndStoreOrdered(pack);
+        if(old)
+            retiredTilePacks.append(old);
+        return true;
+    }
+
+    QString TLMaps::TilePackFile()
+    {
+        TilePack *pack=tilePack.loadAcquire();
+        return pack?pack->FileName():QString();
     }
 
     /**
@@ -305,6 +339,24 @@ namespace core {
      */
     QByteArray TLMaps::GetImageFromServer(const MapType::Types &type,const Point &pos,const int &zoom)
     {
+        // One network manager per loader thread, so that consecutive tiles from a
+        // server reuse its kept alive connections instead of opening new ones
+        static QThreadStorage<QNetworkAccessManager *> networkManagers;
+
+        // The offline package needs no lock, look there first
+        TilePack *pack=tilePack.loadAcquire();
+        if(pack && type != MapType::UserImage)
+        {
+            QByteArray packed=pack->GetImage(type,pos,zoom);
+            if(!packed.isEmpty())
+            {
+                errorvars.lock();
+                ++diag.tilesFromPack;
+                errorvars.unlock();
+                return packed;
+            }
+        }
+
         QMutexLocker locker(&settingsProtect);
 #ifdef DEBUG_TIMINGS
         QTime time;
@@ -368,13 +420,13 @@ namespace core {
                     QEventLoop q;
                     QNetworkReply *reply;
                     QNetworkRequest qheader;
-                    QNetworkAccessManager network;
+                    if(!networkManagers.hasLocalData())
+                        networkManagers.setLocalData(new QNetworkAccessManager());
+                    QNetworkAccessManager *network=networkManagers.localData();
                     QTimer tT;
                     tT.setSingleShot(true);
-                    connect(&network, SIGNAL(finished(QNetworkReply*)),
-                            &q, SLOT(quit()));
                     connect(&tT, SIGNAL(timeout()), &q, SLOT(quit()));
-                    network.setProxy(Proxy);
+                    network->setProxy(Proxy);
     #ifdef DEBUG_GMAPS
                     qDebug()<<"Try Tile from the Internet";
     #endif //DEBUG_GMAPS
@@ -462,11 +514,18 @@ namespace core {
 #ifdef DEBUG_GMAPS
                     qDebug() << "qheader: " << qheader.url();
 #endif //DEBUG_GMAPS
-                    reply=network.get(qheader);
+                    // Only the request setup needs the settings, other loaders may
+                    // fetch their tiles while this one waits for the server
+                    locker.unlock();
+
+                    reply=network->get(qheader);
+                    connect(reply, SIGNAL(finished()), &q, SLOT(quit()));
                     tT.start(Timeout);
                     q.exec();
 
                     if(!tT.isActive()){
+                        reply->abort();
+                        reply->deleteLater();
                         errorvars.lock();
                         ++diag.timeouts;
                         errorvars.unlock();
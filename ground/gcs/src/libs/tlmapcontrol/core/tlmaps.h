@@ -41,6 +41,8 @@
 #include "alllayersoftype.h"
 #include "urlfactory.h"
 #include "diagnostics.h"
+#include "tilepack.h"
+#include <QAtomicPointer>
 
 #include "../internals/pureprojection.h"
 #include "../internals/projections/lks94projection.h"
@@ -74,6 +76,8 @@ namespace core {
         LanguageType::Types GetLanguage(){return Language;}//TODO
         AccessMode::Types GetAccessMode()const{return accessmode;}
         void setAccessMode(const AccessMode::Types& mode){accessmode=mode;}
+        bool SetTilePack(const QString &file);
+        QString TilePackFile();
         int RetryLoadTile;
         diagnostics GetDiagnostics();
         bool useMemoryCache;
@@ -89,6 +93,10 @@ namespace core {
         diagnostics diag;
         QMutex errorvars;
         QMutex settingsProtect;
+        // Readers take the pack without locking, so replaced packs stay mapped until exit
+        QAtomicPointer<TilePack> tilePack;
+        QList<TilePack*> retiredTilePacks;
+        QMutex tilePackProtect;
         quint8 lastZoom;
         int quadCoordRight;
         int quadCoordBottom;
@@ -68,11 +68,41 @@ namespace internals {
 
         LoadTask task;
 
+        // Same locking order as UpdateBounds()
+        MtileDrawingList.lock();
         MtileLoadQueue.lock();
         {
-            if(tileLoadQueue.count() > 0)
+            // Load the tile nearest the centre of the view first, and drop the
+            // ones a zoom change or a pan made obsolete while they waited
+            int nearest = -1;
+            qint64 nearestDistance = 0;
+            Point center = GetcenterTileXYLocation();
+            for(int i = tileLoadQueue.count() - 1; i >= 0; i--)
+            {
+                const LoadTask &candidate = tileLoadQueue.at(i);
+                if(candidate.Zoom != Zoom() || !tileDrawingList.contains(candidate.Pos))
+                {
+                    tileLoadQueue.removeAt(i);
+                    if(nearest > i)
+                        --nearest;
+                    MtileToload.lock();
+                    --tilesToload;
+                    MtileToload.unlock();
+                    continue;
+                }
+                qint64 dx = candidate.Pos.X() - center.X();
+                qint64 dy = candidate.Pos.Y() - center.Y();
+                qint64 distance = dx*dx + dy*dy;
+                if(nearest < 0 || distance <= nearestDistance)
+                {
+                    nearest = i;
+                    nearestDistance = distance;
+                }
+            }
+
+            if(nearest >= 0)
             {
-                task = tileLoadQueue.dequeue();
+                task = tileLoadQueue.takeAt(nearest);
                 {
 
                     last = (tileLoadQueue.count() == 0);
@@ -83,6 +113,7 @@ namespace internals {
             }
         }
         MtileLoadQueue.unlock();
+        MtileDrawingList.unlock();
 
         if(task.HasValue())
             if(loaderLimit.tryAcquire(1,TLMaps::Instance()->Timeout))
@@ -141,9 +172,14 @@ namespace internals {
 
                                 if(tileImage.length()!=0)
                                 {
+                                    // Decode here on the loader pool, so painting only has to blit
+                                    RawTile key(tl, task.Pos, task.Zoom);
+                                    TLMaps::Instance()->AddDecodedTileToMemoryCache(key, PureImageProxy::Decode(tileImage));
+
                                     Moverlays.lock();
                                     {
                                         t->Overlays.append(tileImage);
+                                        t->OverlayKeys.append(key);
 #ifdef DEBUG_CORE
                                         qDebug()<<"Core::run append tileImage:"<<tileImage.length()<<" to tile:"<<t->GetPos().ToString()<<" now has "<<t->Overlays.count()<<" overlays"<<" ID="<<debug;
 #endif //DEBUG_CORE
@@ -163,7 +199,8 @@ namespace internals {
                             while(++retry < TLMaps::Instance()->RetryLoadTile);
                         }
 
-                        if(t->Overlays.count() > 0)
+                        // The map may have zoomed away while the tile was fetched
+                        if(t->Overlays.count() > 0 && task.Zoom == Zoom())
                         {
                             Matrix.SetTileAt(task.Pos,t);
                             emit OnNeedInvalidation();
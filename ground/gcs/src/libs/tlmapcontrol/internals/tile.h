@@ -31,6 +31,7 @@
 #include "QList"
 #include <QImage>
 #include "../core/point.h"
+#include "../core/rawtile.h"
 #include <QMutex>
 #include <QDebug>
 #include "debugheader.h"
@@ -55,6 +56,8 @@ public:
     }
     bool HasValue(){return !(zoom==0);}
     QList<QByteArray> Overlays;
+    // Keys of the decoded Overlays in the shared memory cache, in the same order
+    QList<core::RawTile> OverlayKeys;
 protected:
 
     QMutex mutex;
@@ -149,6 +149,14 @@ public:
     */
     void SetTileMemorySize(int const& value){core::TLMaps::Instance()->TilesInMemory.setMemoryCacheCapacity(value);}
 
+    /**
+    * @brief  Sets the size of the memory for decoded tiles, shared by all maps
+    *
+    * @param  value size in Mb to use for decoded tiles
+    * @return
+    */
+    void SetDecodedTileMemorySize(int const& value){core::TLMaps::Instance()->setDecodedTileCacheCapacity(value);}
+
     /**
     * @brief Sets the location for the SQLite Database used for caching and the geocoding cache files
     *
@@ -176,6 +184,19 @@ public:
     * @return
     */
     void ExportMapDataToDB(QString const& sourceDB, QString const& destDB)const{core::PureImageCache::ExportMapDataToDB(sourceDB,destDB);}
+
+    /**
+    * @brief Serves tiles from an offline map package, made with TLMapWidget::ExportTilePack, before the cache DB and the server
+    *
+    * @param file the package, or an empty string to stop using one
+    * @return false if the package could not be opened
+    */
+    bool SetTilePack(QString const& file){return core::TLMaps::Instance()->SetTilePack(file);}
+
+    /**
+    * @brief Returns the offline map package in use, if any
+    */
+    QString TilePack(){return core::TLMaps::Instance()->TilePackFile();}
     /**
     * @brief Returns the location for the SQLite Database used for caching and the geocoding cache files
     *
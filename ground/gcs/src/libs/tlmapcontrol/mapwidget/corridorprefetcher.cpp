@@ -0,0 +1,121 @@
+/**
+******************************************************************************
+*
+* @file       corridorprefetcher.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      Downloads the tiles along the waypoint path ahead of a mission
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#include "corridorprefetcher.h"
+#include <QSet>
+#include <math.h>
+
+namespace mapcontrol
+{
+
+CorridorPrefetcher::CorridorPrefetcher(internals::Core *mapCore, QList<internals::PointLatLng> const& path, int const& padding, int const& zoomLevels):sleep(100),cancel(false)
+    {
+        type=mapCore->GetMapType();
+        int maxzoom=qMin(mapCore->Zoom()+qMax(zoomLevels,1)-1,mapCore->MaxZoom());
+        for(int zoom=mapCore->Zoom();zoom<=maxzoom;++zoom)
+        {
+            foreach(core::Point p,GetCorridorTileList(mapCore->Projection(),path,zoom,padding))
+            {
+                Tile tile;
+                tile.pos=p;
+                tile.zoom=zoom;
+                tiles.append(tile);
+            }
+        }
+    }
+
+    QList<core::Point> CorridorPrefetcher::GetCorridorTileList(internals::PureProjection *projection, QList<internals::PointLatLng> const& path, int const& zoom, int const& padding)
+    {
+        QList<core::Point> ret;
+        QSet<core::Point> added;
+        core::Size min=projection->GetTileMatrixMinXY(zoom);
+        core::Size max=projection->GetTileMatrixMaxXY(zoom);
+        // Half a tile per step, so that no tile the path crosses is stepped over
+        double step=projection->TileSize().Width()/2.0;
+
+        for(int i=0;i<path.count();++i)
+        {
+            core::Point from=projection->FromLatLngToPixel(path[i>0?i-1:i],zoom);
+            core::Point to=projection->FromLatLngToPixel(path[i],zoom);
+            double dx=to.X()-from.X();
+            double dy=to.Y()-from.Y();
+            int steps=qMax(1,(int)ceil(sqrt(dx*dx+dy*dy)/step));
+
+            for(int s=0;s<=steps;++s)
+            {
+                core::Point pixel(from.X()+(qint64)(dx*s/steps),from.Y()+(qint64)(dy*s/steps));
+                core::Point center=projection->FromPixelToTileXY(pixel);
+                for(qint64 x=center.X()-padding;x<=center.X()+padding;++x)
+                {
+                    for(qint64 y=center.Y()-padding;y<=center.Y()+padding;++y)
+                    {
+                        if(x<min.Width() || x>max.Width() || y<min.Height() || y>max.Height())
+                            continue;
+                        core::Point tile(x,y);
+                        if(added.contains(tile))
+                            continue;
+                        added.insert(tile);
+                        ret.append(tile);
+                    }
+                }
+            }
+        }
+        return ret;
+    }
+
+    void CorridorPrefetcher::run()
+    {
+        QVector<core::MapType::Types> types = TLMaps::Instance()->GetAllLayersOfType(type);
+        int all=tiles.count();
+        for(int i = 0; i < all; i++)
+        {
+            emit numberOfTilesChanged(all,i+1);
+            {
+                QMutexLocker locker(&mutex);
+                if(cancel)
+                    break;
+            }
+
+            bool fetched=false;
+            foreach(core::MapType::Types type,types)
+            {
+                // Tiles already in the cache cost neither a request nor the wait
+                if(!Cache::Instance()->ImageCache.GetImageFromCache(type,tiles[i].pos,tiles[i].zoom).isEmpty())
+                    continue;
+                TLMaps::Instance()->GetImageFromServer(type,tiles[i].pos,tiles[i].zoom);
+                fetched=true;
+            }
+            if(fetched)
+                QThread::msleep(sleep);
+        }
+    }
+
+    void CorridorPrefetcher::stopFetching()
+    {
+        QMutexLocker locker(&mutex);
+        cancel=true;
+    }
+}
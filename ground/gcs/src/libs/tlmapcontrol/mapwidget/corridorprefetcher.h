@@ -0,0 +1,78 @@
+/**
+******************************************************************************
+*
+* @file       corridorprefetcher.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      Downloads the tiles along the waypoint path ahead of a mission
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#ifndef CORRIDORPREFETCHER_H
+#define CORRIDORPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include "../internals/core.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+    * @brief Fetches the tiles within a few tiles of the path, from the current
+    * zoom level down to a few levels closer, into the tile cache. Unlike the
+    * MapRipper it runs unattended, and only costs a request for tiles that are
+    * not cached yet.
+    */
+    class TLMAPWIDGET_EXPORT CorridorPrefetcher:public QThread
+    {
+        Q_OBJECT
+    public:
+        /**
+        * @param path The waypoints in the order they are flown
+        * @param padding Tiles on either side of the path
+        * @param zoomLevels Levels to fetch, starting with the current one
+        */
+        CorridorPrefetcher(internals::Core *,QList<internals::PointLatLng> const& path,int const& padding=1,int const& zoomLevels=3);
+        void run();
+
+        /**
+        * @brief Returns the tiles within padding tiles of the path, in the order the path passes them
+        */
+        static QList<core::Point> GetCorridorTileList(internals::PureProjection *projection,QList<internals::PointLatLng> const& path,int const& zoom,int const& padding);
+    private:
+        struct Tile
+        {
+            core::Point pos;
+            int zoom;
+        };
+        QList<Tile> tiles;
+        core::MapType::Types type;
+        int sleep;
+        bool cancel;
+        QMutex mutex;
+
+    signals:
+        void numberOfTilesChanged(int const& total,int const& actual);
+
+    public slots:
+        void stopFetching();
+    };
+}
+#endif // CORRIDORPREFETCHER_H
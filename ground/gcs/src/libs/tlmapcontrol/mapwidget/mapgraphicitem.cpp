@@ -368,14 +368,26 @@ namespace mapcontrol
                             //lock(t.Overlays)
                             if(t!=0)
                             {
-                                foreach(QByteArray img,t->Overlays)
+                                for(int k = 0; k < t->Overlays.count(); k++)
                                 {
+                                    const QByteArray &img = t->Overlays.at(k);
                                     if(img.count()!=0)
                                     {
                                         if(!found)
                                             found = true;
                                         {
-                                            painter->drawPixmap(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height(),PureImageProxy::FromStream(img));
+                                            // Tiles are decoded by the loader, only decode here if the
+                                            // shared cache dropped this one since
+                                            QImage decoded;
+                                            if(k < t->OverlayKeys.count())
+                                                decoded = TLMaps::Instance()->GetDecodedTileFromMemoryCache(t->OverlayKeys.at(k));
+                                            if(decoded.isNull())
+                                            {
+                                                decoded = PureImageProxy::Decode(img);
+                                                if(k < t->OverlayKeys.count())
+                                                    TLMaps::Instance()->AddDecodedTileToMemoryCache(t->OverlayKeys.at(k), decoded);
+                                            }
+                                            painter->drawImage(QRectF(core->tileRect.X(),core->tileRect.Y(), core->tileRect.Width(), core->tileRect.Height()),decoded);
                                         }
                                     }
                                 }
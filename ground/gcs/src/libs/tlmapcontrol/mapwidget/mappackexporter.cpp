@@ -0,0 +1,114 @@
+/**
+******************************************************************************
+*
+* @file       mappackexporter.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      Writes the tiles of a selection of the map to an offline package
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "mappackexporter.h"
+#include <QMessageBox>
+
+namespace mapcontrol
+{
+
+MapPackExporter::MapPackExporter(internals::Core *core, const internals::RectLatLng &rect, QString const& file, int const& maxZoom):file(file),missing(0),failed(false),cancel(false),progressForm(0)
+    {
+        type=core->GetMapType();
+        int lastZoom=qMin(maxZoom,core->MaxZoom());
+        for(int zoom=core->Zoom();zoom<=lastZoom;++zoom)
+        {
+            foreach(core::Point p,core->Projection()->GetAreaTileList(rect,zoom,0))
+            {
+                Tile tile;
+                tile.pos=p;
+                tile.zoom=zoom;
+                tiles.append(tile);
+            }
+        }
+
+        progressForm=new MapRipForm;
+        connect(progressForm,SIGNAL(cancelRequest()),this,SLOT(stopExport()));
+        connect(this,SIGNAL(percentageChanged(int)),progressForm,SLOT(SetPercentage(int)));
+        connect(this,SIGNAL(numberOfTilesChanged(int,int)),progressForm,SLOT(SetNumberOfTiles(int,int)));
+        connect(this,SIGNAL(providerChanged(QString,int)),progressForm,SLOT(SetProvider(QString,int)));
+        connect(this,SIGNAL(finished()),this,SLOT(finish()));
+        progressForm->show();
+        this->start();
+    }
+
+    void MapPackExporter::run()
+    {
+        core::TilePackWriter writer;
+        if(!writer.Open(file))
+        {
+            failed=true;
+            return;
+        }
+
+        QVector<core::MapType::Types> types = TLMaps::Instance()->GetAllLayersOfType(type);
+        int all=tiles.count();
+        for(int i = 0; i < all; i++)
+        {
+            emit numberOfTilesChanged(all,i+1);
+            {
+                QMutexLocker locker(&mutex);
+                if(cancel)
+                    break;
+            }
+
+            foreach(core::MapType::Types type,types)
+            {
+                emit providerChanged(core::MapType::StrByType(type),tiles[i].zoom);
+                QByteArray img = TLMaps::Instance()->GetImageFromServer(type,tiles[i].pos,tiles[i].zoom);
+                if(img.isEmpty())
+                    ++missing;
+                else if(!writer.AddImage(type,tiles[i].pos,tiles[i].zoom,img))
+                {
+                    failed=true;
+                    return;
+                }
+            }
+            emit percentageChanged((int) ((i+1)*100/all));
+        }
+
+        failed=!writer.Finish();
+    }
+
+    void MapPackExporter::stopExport()
+    {
+        QMutexLocker locker(&mutex);
+        cancel=true;
+    }
+
+    void MapPackExporter::finish()
+    {
+        progressForm->close();
+        delete progressForm;
+        progressForm=0;
+
+        if(failed)
+            QMessageBox::warning(0,"Offline map package",QString("Could not write %1").arg(file));
+        else if(missing>0)
+            QMessageBox::information(0,"Offline map package",QString("%1 tiles could not be fetched and are missing from the package.").arg(missing));
+        this->deleteLater();
+    }
+}
@@ -0,0 +1,75 @@
+/**
+******************************************************************************
+*
+* @file       mappackexporter.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      Writes the tiles of a selection of the map to an offline package
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef MAPPACKEXPORTER_H
+#define MAPPACKEXPORTER_H
+
+#include <QThread>
+#include <QMutex>
+#include "../internals/core.h"
+#include "../core/tilepack.h"
+#include "mapripform.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+    * @brief Writes every tile of an area, from the current zoom level up to a
+    * maximum one, to a core::TilePack. Tiles come from the cache DB when they
+    * are there and from the server otherwise. Missing tiles are skipped.
+    */
+    class TLMAPWIDGET_EXPORT MapPackExporter:public QThread
+    {
+        Q_OBJECT
+    public:
+        MapPackExporter(internals::Core *,internals::RectLatLng const&,QString const& file,int const& maxZoom);
+        void run();
+    private:
+        struct Tile
+        {
+            core::Point pos;
+            int zoom;
+        };
+        QList<Tile> tiles;
+        core::MapType::Types type;
+        QString file;
+        int missing;
+        bool failed;
+        bool cancel;
+        MapRipForm *progressForm;
+        QMutex mutex;
+
+    signals:
+        void percentageChanged(int const& perc);
+        void numberOfTilesChanged(int const& total,int const& actual);
+        void providerChanged(QString const& prov,int const& zoom);
+
+    public slots:
+        void stopExport();
+        void finish();
+    };
+}
+#endif // MAPPACKEXPORTER_H
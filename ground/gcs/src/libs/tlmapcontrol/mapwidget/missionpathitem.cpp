@@ -0,0 +1,166 @@
+/**
+******************************************************************************
+*
+* @file       missionpathitem.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      A graphicsItem drawing all the straight legs of a mission
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "missionpathitem.h"
+#include <math.h>
+
+namespace mapcontrol
+{
+MissionPathItem::MissionPathItem(MapGraphicItem *map, QColor color) :
+    QGraphicsItem(map), my_map(map), myColor(color), rebuildPending(false)
+{
+    if(myColor==Qt::green)
+        this->setZValue(10);
+    else if(myColor==Qt::yellow)
+        this->setZValue(9);
+    else if(myColor==Qt::red)
+        this->setZValue(8);
+    connect(map,SIGNAL(childRefreshPosition()),this,SLOT(refreshLocations()));
+    connect(map,SIGNAL(childSetOpacity(qreal)),this,SLOT(setOpacitySlot(qreal)));
+}
+
+int MissionPathItem::type() const
+{
+    // Enable the use of qgraphicsitem_cast with this item.
+    return Type;
+}
+
+QRectF MissionPathItem::boundingRect() const
+{
+    return bounds;
+}
+
+QPainterPath MissionPathItem::shape() const
+{
+    QPainterPath path = arrowHeads;
+    path.addPath(lines);
+    return path;
+}
+
+void MissionPathItem::AddLeg(MapPointItem *from, MapPointItem *to)
+{
+    if(!from || !to || from==to)
+        return;
+    legs.append(qMakePair(from, to));
+    watch(from);
+    watch(to);
+    refreshLocations();
+}
+
+void MissionPathItem::watch(MapPointItem *point)
+{
+    if(watched.contains(point))
+        return;
+    watched.insert(point);
+    connect(point, SIGNAL(relativePositionChanged(QPointF, MapPointItem*)), this, SLOT(refreshLocations()));
+    connect(point, SIGNAL(absolutePositionChanged(internals::PointLatLng, float)), this, SLOT(refreshLocations()));
+    connect(point, SIGNAL(aboutToBeDeleted(MapPointItem*)), this, SLOT(pointdeleted(MapPointItem*)));
+}
+
+void MissionPathItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(option);
+    Q_UNUSED(widget);
+
+    QPen myPen;
+    myPen.setColor(myColor);
+    painter->setPen(myPen);
+    painter->setBrush(myColor);
+    painter->drawPath(arrowHeads);
+
+    if(myColor==Qt::red)
+        myPen.setWidth(3);
+    else if(myColor==Qt::yellow)
+        myPen.setWidth(2);
+    else if(myColor==Qt::green)
+        myPen.setWidth(1);
+    painter->setPen(myPen);
+    painter->setBrush(Qt::NoBrush);
+    painter->drawPath(lines);
+}
+
+void MissionPathItem::refreshLocations()
+{
+    if(rebuildPending)
+        return;
+    rebuildPending = true;
+    QMetaObject::invokeMethod(this, "rebuild", Qt::QueuedConnection);
+}
+
+void MissionPathItem::rebuild()
+{
+    rebuildPending = false;
+    qreal arrowSize = 10;
+
+    QPainterPath newLines;
+    QPainterPath newArrowHeads;
+    for(int i = 0; i < legs.count(); ++i)
+    {
+        QLineF line(legs[i].second->pos(), legs[i].first->pos());
+        newLines.moveTo(line.p1());
+        newLines.lineTo(line.p2());
+
+        // Same arrow as MapLine, in the middle of the leg
+        double angle = (fabs(line.length()) < 1e-3) ? 0 : ::acos(line.dx() / line.length());
+        if (line.dy() >= 0)
+            angle = (M_PI * 2) - angle;
+
+        QPointF arrowP1 = line.pointAt(0.5) + QPointF(sin(angle + M_PI / 3) * arrowSize,
+                                        cos(angle + M_PI / 3) * arrowSize);
+        QPointF arrowP2 = line.pointAt(0.5) + QPointF(sin(angle + M_PI - M_PI / 3) * arrowSize,
+                                        cos(angle + M_PI - M_PI / 3) * arrowSize);
+        QPolygonF arrowHead;
+        arrowHead << line.pointAt(0.5) << arrowP1 << arrowP2 << line.pointAt(0.5);
+        newArrowHeads.addPolygon(arrowHead);
+    }
+
+    prepareGeometryChange();
+    lines = newLines;
+    arrowHeads = newArrowHeads;
+    bounds = lines.boundingRect().united(arrowHeads.boundingRect()).adjusted(-3, -3, 3, 3);
+    update();
+}
+
+void MissionPathItem::pointdeleted(MapPointItem *point)
+{
+    for(int i = legs.count() - 1; i >= 0; --i)
+    {
+        if(legs[i].first == point || legs[i].second == point)
+            legs.removeAt(i);
+    }
+    watched.remove(point);
+    if(legs.isEmpty())
+        this->deleteLater();
+    else
+        refreshLocations();
+}
+
+void MissionPathItem::setOpacitySlot(qreal opacity)
+{
+    setOpacity(opacity);
+}
+
+}
@@ -0,0 +1,87 @@
+/**
+******************************************************************************
+*
+* @file       missionpathitem.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      A graphicsItem drawing all the straight legs of a mission
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef MISSIONPATHITEM_H
+#define MISSIONPATHITEM_H
+
+#include <QPainterPath>
+#include <QPair>
+#include <QSet>
+#include "mapgraphicitem.h"
+#include "mappointitem.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+
+/**
+ * @brief The MissionPathItem class draws many straight legs between map points, with
+ * the same arrows as a MapLine, as a single item. Moving points or the map only marks
+ * the path dirty, and it is rebuilt once from the event loop whatever the number of
+ * points that moved.
+ */
+class TLMAPWIDGET_EXPORT MissionPathItem : public QObject, public QGraphicsItem
+{
+    Q_OBJECT
+    Q_INTERFACES(QGraphicsItem)
+public:
+    enum { Type = UserType + 11 };
+    MissionPathItem(MapGraphicItem *map, QColor color=Qt::green);
+    int type() const;
+    QRectF boundingRect() const;
+    QPainterPath shape() const;
+    void setColor(const QColor &color)
+        { myColor = color; update(); }
+
+    /**
+     * @brief AddLeg Adds a line from one point to another
+     * @param from The start of the leg
+     * @param to The end of the leg, the arrow points to it
+     */
+    void AddLeg(MapPointItem *from, MapPointItem *to);
+protected:
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
+private:
+    void watch(MapPointItem *point);
+
+    MapGraphicItem * my_map;
+    QColor myColor;
+    QList<QPair<MapPointItem *, MapPointItem *> > legs;
+    QSet<MapPointItem *> watched;
+    QPainterPath lines;
+    QPainterPath arrowHeads;
+    QRectF bounds;
+    bool rebuildPending;
+public slots:
+    void refreshLocations();
+    void pointdeleted(MapPointItem *point);
+    void setOpacitySlot(qreal opacity);
+private slots:
+    void rebuild();
+};
+}
+
+#endif // MISSIONPATHITEM_H
@@ -136,6 +136,13 @@ namespace mapcontrol
         return ret;
     }
 
+    MissionPathItem * TLMapWidget::WPPathCreate(QColor color)
+    {
+        MissionPathItem* ret= new MissionPathItem(map,color);
+        ret->setOpacity(overlayOpacity);
+        return ret;
+    }
+
     /**
      * @brief TLMapWidget::WPCurveCreate Create a curve from one waypoint to another with specified radius
      * @param start The starting waypoint
@@ -485,6 +492,12 @@ namespace mapcontrol
                 MapCircle* ww=qgraphicsitem_cast<MapCircle*>(i);
                 if(ww)
                     ww->deleteLater();
+                else
+                {
+                    MissionPathItem* path=qgraphicsitem_cast<MissionPathItem*>(i);
+                    if(path)
+                        path->deleteLater();
+                }
             }
         }
     }
@@ -641,6 +654,44 @@ namespace mapcontrol
         new MapRipper(core,map->SelectedArea());
     }
 
+    void TLMapWidget::ExportTilePack(QString const& file, int const& maxZoom)
+    {
+        if(map->SelectedArea().IsEmpty())
+        {
+#ifdef Q_OS_DARWIN
+            QMessageBox::information(new QWidget(),"No valid selection","This exports map data for use without internet.\n\nPlease first select the area of the map to export with <COMMAND>+Left mouse click");
+#else
+            QMessageBox::information(new QWidget(),"No valid selection","This exports map data for use without internet.\n\nPlease first select the area of the map to export with <CTRL>+Left mouse click");
+#endif
+            return;
+        }
+        new MapPackExporter(core,map->SelectedArea(),file,maxZoom);
+    }
+
+    void TLMapWidget::PrefetchWPCorridor()
+    {
+        QMap<int,internals::PointLatLng> waypoints;
+        foreach(QGraphicsItem* i,map->childItems())
+        {
+            WayPointItem* w=qgraphicsitem_cast<WayPointItem*>(i);
+            if(w && w->Number()!=-1)
+                waypoints.insert(w->Number(),w->Coord());
+        }
+        if(waypoints.isEmpty())
+            return;
+
+        // The mission starts from home
+        QList<internals::PointLatLng> path=waypoints.values();
+        if(Home)
+            path.prepend(Home->Coord());
+
+        if(prefetcher)
+            prefetcher->stopFetching();
+        prefetcher=new CorridorPrefetcher(core,path);
+        connect(prefetcher,SIGNAL(finished()),prefetcher,SLOT(deleteLater()));
+        prefetcher->start(QThread::LowPriority);
+    }
+
     void TLMapWidget::setSelectedWP(QList<WayPointItem * >list)
     {
         this->scene()->clearSelection();
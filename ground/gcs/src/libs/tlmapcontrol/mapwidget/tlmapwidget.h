@@ -41,12 +41,16 @@
 #include "gpsitem.h"
 #include "homeitem.h"
 #include "mapripper.h"
+#include "corridorprefetcher.h"
+#include "mappackexporter.h"
 #include "mapline.h"
+#include "missionpathitem.h"
 #include "mapcircle.h"
 #include "waypointcurve.h"
 #include "waypointitem.h"
 #include "../core/corecommon.h"
 #include <QGraphicsView>
+#include <QPointer>
 
 namespace mapcontrol
 {
@@ -372,6 +376,8 @@ namespace mapcontrol
         MapLine *WPLineCreate(WayPointItem *from,WayPointItem *to, QColor color);
         //! Create a line from home to a waypoint item
         MapLine *WPLineCreate(HomeItem *from,WayPointItem *to, QColor color);
+        //! Create an empty item drawing many lines between map points at once, for large missions
+        MissionPathItem *WPPathCreate(QColor color);
         //! Create a curve from one waypoint item to another with a given radius
         WayPointCurve *WPCurveCreate(WayPointItem *start, WayPointItem *dest, double radius, bool clockwise, QColor color);
         //! Create a circle around a waypoint with the radius specified by the distance to another waypoint
@@ -407,6 +413,7 @@ namespace mapcontrol
         qreal overlayOpacity;
 
         QGraphicsTextItem *windspeedTxt;
+        QPointer<CorridorPrefetcher> prefetcher;
 
     private slots:
         void diagRefresh();
@@ -523,6 +530,16 @@ namespace mapcontrol
         * @brief Ripps the current selection to the DB
         */
         void RipMap();
+        /**
+        * @brief Fetches the tiles along the waypoint path into the DB, in the background
+        */
+        void PrefetchWPCorridor();
+        /**
+        * @brief Writes the tiles of the current selection, from the current zoom up to maxZoom, to an offline package
+        *
+        * @param file the package to write, see Configuration::SetTilePack
+        */
+        void ExportTilePack(QString const& file,int const& maxZoom);
         void OnSelectionChanged();
 
     };
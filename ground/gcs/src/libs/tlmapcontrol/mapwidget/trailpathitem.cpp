@@ -0,0 +1,178 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.cpp
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      A graphicsItem drawing a whole trail as one path
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#include "trailpathitem.h"
+#include "../internals/pureprojection.h"
+#include <QDateTime>
+#include <QGraphicsSceneHoverEvent>
+
+namespace mapcontrol
+{
+    TrailPathItem::TrailPathItem(MapGraphicItem *map, QColor pointColor, QColor lineColor, int capacity):QGraphicsItem(map),m_map(map),
+        m_pointColor(pointColor),m_lineColor(lineColor),points(qMax(capacity,2)),head(0),count(0),minspacing(1),showpoints(true),showline(true)
+    {
+        setAcceptHoverEvents(true);
+        connect(map,SIGNAL(childRefreshPosition()),this,SLOT(RefreshPos()));
+    }
+
+    void TrailPathItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+    {
+        Q_UNUSED(option);
+        Q_UNUSED(widget);
+
+        if(local.isEmpty())
+            return;
+
+        if(showline && local.size()>1)
+        {
+            QPen pen(m_lineColor);
+            pen.setCosmetic(true);
+            painter->setPen(pen);
+            painter->drawPolyline(local);
+        }
+        if(showpoints)
+        {
+            QPen pen(m_pointColor);
+            pen.setWidth(4);
+            pen.setCapStyle(Qt::RoundCap);
+            pen.setCosmetic(true);
+            painter->setPen(pen);
+            painter->drawPoints(local);
+        }
+    }
+
+    QRectF TrailPathItem::boundingRect()const
+    {
+        return bounds;
+    }
+
+    int TrailPathItem::type()const
+    {
+        return Type;
+    }
+
+    void TrailPathItem::AddPoint(internals::PointLatLng const& coord, int const& altitude)
+    {
+        TrailPoint p;
+        p.coord=coord;
+        p.altitude=altitude;
+        p.time=QDateTime::currentMSecsSinceEpoch();
+
+        if(count>0)
+        {
+            int last=(head+count-1)%points.size();
+            if(internals::PureProjection::DistanceBetweenLatLng(points[last].coord,coord)*1000<minspacing)
+            {
+                points[last]=p;
+                local.last()=toLocal(coord);
+                updateBounds();
+                return;
+            }
+        }
+
+        if(count==points.size())
+        {
+            points[head]=p;
+            head=(head+1)%points.size();
+            local.remove(0);
+        }
+        else
+        {
+            points[(head+count)%points.size()]=p;
+            ++count;
+        }
+        local.append(toLocal(coord));
+        updateBounds();
+    }
+
+    void TrailPathItem::Clear()
+    {
+        head=0;
+        count=0;
+        local.clear();
+        updateBounds();
+    }
+
+    void TrailPathItem::SetShowPoints(bool const& value)
+    {
+        showpoints=value;
+        setVisible(showpoints||showline);
+        update();
+    }
+
+    void TrailPathItem::SetShowLine(bool const& value)
+    {
+        showline=value;
+        setVisible(showpoints||showline);
+        update();
+    }
+
+    void TrailPathItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event)
+    {
+        // Trail dots used to be separate items with their own tooltips, find the one under the mouse
+        int nearest=-1;
+        qreal best=4*4;
+        for(int i=0;i<local.size();++i)
+        {
+            QPointF d=local[i]-event->pos();
+            qreal dist=d.x()*d.x()+d.y()*d.y();
+            if(dist<=best)
+            {
+                best=dist;
+                nearest=i;
+            }
+        }
+        if(nearest<0 || !showpoints)
+        {
+            setToolTip(QString());
+            return;
+        }
+        const TrailPoint &p=at(nearest);
+        QString coord_str = " " + QString::number(p.coord.Lat(), 'f', 6) + "   " + QString::number(p.coord.Lng(), 'f', 6);
+        setToolTip(QString(tr("Position:")+"%1\n"+tr("Altitude:")+"%2\n"+tr("Time:")+"%3").arg(coord_str).arg(QString::number(p.altitude)).arg(QDateTime::fromMSecsSinceEpoch(p.time).toString()));
+    }
+
+    QPointF TrailPathItem::toLocal(internals::PointLatLng const& coord)const
+    {
+        core::Point p=m_map->FromLatLngToLocal(coord);
+        return QPointF(p.X(),p.Y());
+    }
+
+    void TrailPathItem::updateBounds()
+    {
+        prepareGeometryChange();
+        // Leave room for the dots, which are 4 pixels wide at any zoom
+        bounds=local.isEmpty()?QRectF():local.boundingRect().adjusted(-3,-3,3,3);
+    }
+
+    void TrailPathItem::RefreshPos()
+    {
+        local.resize(count);
+        for(int i=0;i<count;++i)
+            local[i]=toLocal(at(i).coord);
+        updateBounds();
+    }
+}
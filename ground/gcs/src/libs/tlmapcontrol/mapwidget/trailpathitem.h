@@ -0,0 +1,116 @@
+/**
+******************************************************************************
+*
+* @file       trailpathitem.h
+* @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+* @brief      A graphicsItem drawing a whole trail as one path
+* @see        The GNU Public License (GPL) Version 3
+* @defgroup   TLMapWidget
+* @{
+*
+*****************************************************************************/
+/*
+* This program is free software; you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation; either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful, but
+* WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+* or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+* for more details.
+*
+* You should have received a copy of the GNU General Public License along
+* with this program; if not, write to the Free Software Foundation, Inc.,
+* 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+*/
+#ifndef TRAILPATHITEM_H
+#define TRAILPATHITEM_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QObject>
+#include <QVector>
+#include <QPolygonF>
+#include "../internals/pointlatlng.h"
+#include "mapgraphicitem.h"
+#include "../core/corecommon.h"
+
+namespace mapcontrol
+{
+    /**
+    * @brief The TrailPathItem class holds the trail of a vehicle in a ring buffer and
+    * draws it as a single item, the line as one polyline and the dots as one point set.
+    * When the buffer is full the oldest points are dropped, and a point closer than
+    * MinSpacing() to the previous one replaces it instead of being added.
+    */
+    class TLMAPWIDGET_EXPORT TrailPathItem:public QObject,public QGraphicsItem
+    {
+        Q_OBJECT
+        Q_INTERFACES(QGraphicsItem)
+    public:
+        enum { Type = UserType + 10 };
+        enum { DEFAULT_CAPACITY = 10000 };
+        TrailPathItem(MapGraphicItem * map, QColor pointColor=Qt::green, QColor lineColor=Qt::red, int capacity=DEFAULT_CAPACITY);
+        void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                    QWidget *widget);
+        QRectF boundingRect() const;
+        int type() const;
+
+        /**
+        * @brief Adds a point at the end of the trail
+        *
+        * @param coord the position of the point
+        * @param altitude the altitude shown in the tooltip of the point
+        */
+        void AddPoint(internals::PointLatLng const& coord, int const& altitude);
+
+        /**
+        * @brief Deletes all the trail points
+        */
+        void Clear();
+
+        /**
+        * @brief Returns the number of points in the trail
+        */
+        int Count()const{return count;}
+
+        /**
+        * @brief Sets the distance in meters below which a new point replaces the last one
+        */
+        void SetMinSpacing(double const& meters){minspacing=meters;}
+        double MinSpacing()const{return minspacing;}
+
+        void SetShowPoints(bool const& value);
+        void SetShowLine(bool const& value);
+    protected:
+        void hoverMoveEvent(QGraphicsSceneHoverEvent *event);
+    private:
+        struct TrailPoint
+        {
+            internals::PointLatLng coord;
+            int altitude;
+            qint64 time;
+        };
+        const TrailPoint &at(int i)const{return points[(head+i)%points.size()];}
+        QPointF toLocal(internals::PointLatLng const& coord)const;
+        void updateBounds();
+
+        MapGraphicItem * m_map;
+        QColor m_pointColor;
+        QColor m_lineColor;
+        //! Ring buffer of the trail, oldest point at head
+        QVector<TrailPoint> points;
+        int head;
+        int count;
+        //! The trail in map coordinates, oldest point first
+        QPolygonF local;
+        QRectF bounds;
+        double minspacing;
+        bool showpoints;
+        bool showline;
+    public slots:
+        void RefreshPos();
+    };
+}
+#endif // TRAILPATHITEM_H
@@ -13,8 +13,12 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     mapwidget/homeitem.cpp \
     mapwidget/mapripform.cpp \
     mapwidget/mapripper.cpp \
+    mapwidget/corridorprefetcher.cpp \
+    mapwidget/mappackexporter.cpp \
     mapwidget/traillineitem.cpp \
     mapwidget/mapline.cpp \
+    mapwidget/missionpathitem.cpp \
+    mapwidget/trailpathitem.cpp \
     mapwidget/mapcircle.cpp \
     mapwidget/waypointcurve.cpp \
     mapwidget/tlmapwidget.cpp \
@@ -34,6 +38,7 @@ SOURCES += mapwidget/mapgraphicitem.cpp \
     core/kibertilecache.cpp \
     core/diagnostics.cpp \
     core/tlmaps.cpp \
+    core/tilepack.cpp \
     internals/core.cpp \
     internals/rectangle.cpp \
     internals/tile.cpp \
@@ -65,8 +70,12 @@ HEADERS += mapwidget/mapgraphicitem.h \
     mapwidget/homeitem.h \
     mapwidget/mapripform.h \
     mapwidget/mapripper.h \
+    mapwidget/corridorprefetcher.h \
+    mapwidget/mappackexporter.h \
     mapwidget/traillineitem.h \
     mapwidget/mapline.h \
+    mapwidget/missionpathitem.h \
+    mapwidget/trailpathitem.h \
     mapwidget/mapcircle.h \
     mapwidget/waypointcurve.h \
     mapwidget/tlmapwidget.h \
@@ -90,6 +99,7 @@ HEADERS += mapwidget/mapgraphicitem.h \
     core/debugheader.h \
     core/diagnostics.h \
     core/tlmaps.h \
+    core/tilepack.h \
     internals/core.h \
     internals/mousewheelzoomtype.h \
     internals/rectangle.h \
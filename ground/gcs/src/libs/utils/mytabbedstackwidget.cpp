@@ -106,6 +106,21 @@ void MyTabbedStackWidget::removeTab(int index)
     delete item;
 }
 
+/**
+ * Swap the widget of a tab, keeping its icon and label. The old widget is deleted.
+ */
+void MyTabbedStackWidget::replaceTab(int index, QWidget *tab)
+{
+    QWidget *old = m_stackWidget->widget(index);
+    bool current = (m_stackWidget->currentIndex() == index);
+    tab->setContentsMargins(0, 0, 0, 0);
+    m_stackWidget->insertWidget(index, tab);
+    if (current)
+        m_stackWidget->setCurrentIndex(index);
+    m_stackWidget->removeWidget(old);
+    delete old;
+}
+
 int MyTabbedStackWidget::currentIndex() const
 {
     return m_listWidget->currentRow();
@@ -47,6 +47,7 @@ public:
 
     void insertTab(int index, QWidget *tab, const QIcon &icon, const QString &label);
     void removeTab(int index);
+    void replaceTab(int index, QWidget *tab);
     void setIconSize(int size) { m_listWidget->setIconSize(QSize(size, size)); }
 
     int currentIndex() const;
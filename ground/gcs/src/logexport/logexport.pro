@@ -0,0 +1,31 @@
+include(../../gcs.pri)
+QT += core network concurrent
+QT -= gui
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = logexport
+TEMPLATE = app
+DESTDIR = $$GCS_APP_PATH
+macx {
+DESTDIR = $$GCS_BIN_PATH
+}
+
+# The exporter links the UAVObjects and UAVTalk plugins like a library
+LIBS += -L$$GCS_PLUGIN_PATH/TauLabs
+INCLUDEPATH *= $$GCS_SOURCE_TREE/src/plugins
+include(../plugins/uavtalk/uavtalk.pri)
+
+linux-* {
+    QMAKE_RPATHDIR += \$\$ORIGIN/../$$GCS_LIBRARY_BASENAME/taulabs
+    QMAKE_RPATHDIR += \$\$ORIGIN/../$$GCS_LIBRARY_BASENAME/taulabs/plugins/TauLabs
+    GCS_PLUGIN_RPATH = $$join(QMAKE_RPATHDIR, ":")
+    QMAKE_LFLAGS += -Wl,-z,origin \'-Wl,-rpath,$${GCS_PLUGIN_RPATH}\'
+    QMAKE_RPATHDIR =
+}
+
+SOURCES += main.cpp \
+    logexporter.cpp
+
+HEADERS += logexporter.h
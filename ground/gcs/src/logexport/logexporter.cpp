@@ -0,0 +1,233 @@
+/**
+ ******************************************************************************
+ * @file       logexporter.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup logexport
+ * @{
+ * @addtogroup
+ * @{
+ * @brief Converts Tau Labs logs to one CSV file per object
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logexporter.h"
+#include <uavtalk/uavtalk.h>
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrent>
+#include <functional>
+#include <QDebug>
+
+//! Size of the header in front of every packet: timestamp and data size
+#define LOG_PACKET_HEADER_SIZE (sizeof(quint32) + sizeof(qint64))
+
+//! Size of the record header in a column: timestamp and instance
+#define RECORD_HEADER_SIZE (sizeof(quint32) + sizeof(quint16))
+
+LogExporter::LogExporter(UAVObjectManager *objMngr, const QStringList &objects) :
+    objMngr(objMngr),
+    objects(objects),
+    currentTime(0),
+    numUpdates(0)
+{
+    foreach (QVector<UAVDataObject*> list, objMngr->getDataObjectsVector()) {
+        foreach (UAVDataObject *obj, list)
+            connectObject(obj);
+    }
+
+    // Instances of multi instance objects are created by UAVTalk as they arrive
+    connect(objMngr, SIGNAL(newInstance(UAVObject*)), this, SLOT(newInstance(UAVObject*)));
+}
+
+void LogExporter::connectObject(UAVObject *obj)
+{
+    if (!objects.isEmpty() && !objects.contains(obj->getName(), Qt::CaseInsensitive))
+        return;
+
+    connect(obj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(objectUnpacked(UAVObject*)));
+}
+
+void LogExporter::newInstance(UAVObject *obj)
+{
+    connectObject(obj);
+}
+
+/**
+ * Append the object as it was just unpacked to its column
+ */
+void LogExporter::objectUnpacked(UAVObject *obj)
+{
+    QHash<quint32, Column>::iterator it = columns.find(obj->getObjID());
+    if (it == columns.end()) {
+        Column column;
+        column.type = qobject_cast<UAVDataObject*>(objMngr->getObject(obj->getObjID()));
+        column.count = 0;
+        it = columns.insert(obj->getObjID(), column);
+    }
+
+    quint32 numBytes = obj->getNumBytes();
+    quint16 instId = obj->getInstID();
+    QByteArray &records = it->records;
+    int offset = records.size();
+
+    records.resize(offset + RECORD_HEADER_SIZE + numBytes);
+    char *record = records.data() + offset;
+    memcpy(record, &currentTime, sizeof(currentTime));
+    memcpy(record + sizeof(currentTime), &instId, sizeof(instId));
+    obj->pack((quint8 *) record + RECORD_HEADER_SIZE);
+
+    it->count++;
+    numUpdates++;
+}
+
+/**
+ * Decode a log, the file is mapped and every packet is handed to the
+ * parser where it is.
+ * @return false if the log cannot be read
+ */
+bool LogExporter::read(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Unable to open" << fileName;
+        return false;
+    }
+
+    // Skip the header, logs without one start with the first packet
+    if (file.readLine().startsWith("Tau Labs git hash")) {
+        qDebug() << "Log made with" << file.readLine().trimmed();
+        int cnt = 0;
+        while (file.readLine() != "##\n" && cnt < 10 && !file.atEnd())
+            cnt++;
+        if (cnt >= 10 || file.atEnd())
+            file.seek(0);
+    } else {
+        file.seek(0);
+    }
+
+    qint64 pos = file.pos();
+    qint64 size = file.size();
+    const uchar *log = file.map(0, size);
+    if (log == NULL) {
+        qCritical() << "Unable to map" << fileName;
+        return false;
+    }
+
+    QBuffer dummy;
+    UAVTalk uavTalk(&dummy, objMngr);
+
+    while (pos + (qint64) LOG_PACKET_HEADER_SIZE <= size) {
+        qint64 dataSize;
+        memcpy(&currentTime, log + pos, sizeof(currentTime));
+        memcpy(&dataSize, log + pos + sizeof(currentTime), sizeof(dataSize));
+
+        // Resync on the next byte like the replay does
+        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0) {
+            pos++;
+            continue;
+        }
+
+        pos += LOG_PACKET_HEADER_SIZE;
+        if (pos + dataSize > size)
+            break;
+
+        uavTalk.processInputBuffer(log + pos, dataSize);
+        pos += dataSize;
+    }
+
+    file.unmap((uchar *) log);
+
+    return true;
+}
+
+/**
+ * Write one CSV file per object, with one row per update
+ */
+bool LogExporter::writeColumn(const Column &column, const QString &outputDir)
+{
+    // A private instance to unpack into, created in this thread so that
+    // its update signals are not queued to the main thread
+    UAVDataObject *obj = column.type->clone(0);
+
+    QFile out(QDir(outputDir).filePath(obj->getName() + ".csv"));
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qCritical() << "Unable to write" << out.fileName();
+        delete obj;
+        return false;
+    }
+
+    QTextStream stream(&out);
+    QList<UAVObjectField*> fields = obj->getFields();
+
+    // Column names follow the Field-Element convention of the scope
+    stream << "Time,Instance";
+    foreach (UAVObjectField *field, fields) {
+        if (field->getNumElements() == 1) {
+            stream << "," << field->getName();
+        } else {
+            foreach (QString element, field->getElementNames())
+                stream << "," << field->getName() << "-" << element;
+        }
+    }
+    stream << "\n";
+
+    quint32 recordSize = RECORD_HEADER_SIZE + obj->getNumBytes();
+    const char *record = column.records.constData();
+    for (quint32 i = 0; i < column.count; i++, record += recordSize) {
+        quint32 time;
+        quint16 instId;
+        memcpy(&time, record, sizeof(time));
+        memcpy(&instId, record + sizeof(time), sizeof(instId));
+        obj->unpack((const quint8 *) record + RECORD_HEADER_SIZE);
+
+        stream << time << "," << instId;
+        foreach (UAVObjectField *field, fields) {
+            for (quint32 n = 0; n < field->getNumElements(); n++)
+                stream << "," << field->getValue(n).toString();
+        }
+        stream << "\n";
+    }
+
+    delete obj;
+    return stream.status() == QTextStream::Ok;
+}
+
+/**
+ * Format all the objects seen in the log, in parallel
+ * @return false if any of the files could not be written
+ */
+bool LogExporter::write(const QString &outputDir)
+{
+    if (!QDir().mkpath(outputDir)) {
+        qCritical() << "Unable to create" << outputDir;
+        return false;
+    }
+
+    QList<bool> results = QtConcurrent::blockingMapped(columns.values(),
+        std::function<bool(const Column &)>([this, outputDir](const Column &column) {
+            return writeColumn(column, outputDir);
+        }));
+
+    return !results.contains(false);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @file       logexporter.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup logexport
+ * @{
+ * @addtogroup
+ * @{
+ * @brief Converts Tau Labs logs to one CSV file per object
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGEXPORTER_H
+#define LOGEXPORTER_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include "uavobjectmanager.h"
+#include "uavdataobject.h"
+
+/**
+ * The log is decoded in a single pass with the GCS UAVTalk parser. Every
+ * update only appends the raw object data to a column of its object, the
+ * columns are then formatted to CSV in parallel, one object per thread.
+ */
+class LogExporter : public QObject
+{
+    Q_OBJECT
+public:
+    LogExporter(UAVObjectManager *objMngr, const QStringList &objects);
+
+    bool read(const QString &fileName);
+    bool write(const QString &outputDir);
+
+    //! Number of object updates read from the log
+    quint32 updates() const { return numUpdates; }
+
+private slots:
+    void newInstance(UAVObject *obj);
+    void objectUnpacked(UAVObject *obj);
+
+private:
+    /**
+     * The updates of one object, each record is the timestamp (quint32),
+     * the instance (quint16) and the packed object data.
+     */
+    struct Column {
+        UAVDataObject *type;
+        QByteArray records;
+        quint32 count;
+    };
+
+    bool writeColumn(const Column &column, const QString &outputDir);
+    void connectObject(UAVObject *obj);
+
+    UAVObjectManager *objMngr;
+    QStringList objects;
+    QHash<quint32, Column> columns;
+    quint32 currentTime;
+    quint32 numUpdates;
+};
+
+#endif // LOGEXPORTER_H
@@ -0,0 +1,78 @@
+/**
+ ******************************************************************************
+ * @file       main.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup logexport
+ * @{
+ * @addtogroup
+ * @{
+ * @brief Command line exporter of Tau Labs logs
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logexporter.h"
+#include "uavobjectsinit.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QDebug>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Converts Tau Labs logs (.tll) to one CSV file per object");
+    parser.addHelpOption();
+    parser.addPositionalArgument("log", "Log file to convert");
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+        "Directory for the CSV files, defaults to the log name without extension", "dir");
+    parser.addOption(outputOption);
+    QCommandLineOption objectsOption(QStringList() << "objects",
+        "Comma separated list of the objects to export, all by default", "names");
+    parser.addOption(objectsOption);
+    parser.process(a);
+
+    if (parser.positionalArguments().size() != 1)
+        parser.showHelp(-1);
+
+    QString fileName = parser.positionalArguments().at(0);
+    QString outputDir = parser.value(outputOption);
+    if (outputDir.isEmpty()) {
+        QFileInfo info(fileName);
+        outputDir = info.path() + "/" + info.completeBaseName();
+    }
+    QStringList objects;
+    if (parser.isSet(objectsOption))
+        objects = parser.value(objectsOption).split(",", QString::SkipEmptyParts);
+
+    UAVObjectManager objMngr;
+    UAVObjectsInitialize(&objMngr);
+
+    LogExporter exporter(&objMngr, objects);
+    if (!exporter.read(fileName))
+        return 1;
+
+    qDebug() << "Read" << exporter.updates() << "updates";
+
+    return exporter.write(outputDir) ? 0 : 1;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,170 @@
+/**
+ ******************************************************************************
+ *
+ * @file       autotunelogfit.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ConfigPlugin Config Plugin
+ * @{
+ * @brief Fits the rate response of roll and pitch to a blackbox log and
+ * tunes the rate loop against the fitted model
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "autotunelogfit.h"
+#include "blackboxframe.h"
+#include <uavtalk/uavtalk.h>
+#include <QtConcurrent>
+#include <QtEndian>
+#include <algorithm>
+
+// UAVTalk object frames, as logged by the board or by the GCS
+static const quint8 SYNC_VAL = 0x3C;
+static const quint8 TYPE_OBJ = 0x20;
+static const quint8 TYPE_TIMESTAMPED = 0x80;
+static const int HEADER_LENGTH = 8;
+static const int TIMESTAMP_LENGTH = 2;
+
+//! A sample further than this many sample times from the last starts a new run
+static const double GAP_SAMPLES = 3;
+
+//! Fewer frames than this are not worth fitting
+static const int MIN_FRAMES = 256;
+
+AutotuneLogFit::AutotuneLogFit() :
+    dt(0)
+{
+}
+
+/**
+ * @brief AutotuneLogFit::load read the BlackboxFrame updates of a log
+ * @param log a log downloaded from the board or recorded by the GCS, frames
+ * are found by their checksum so both work
+ * @return true if there were enough frames to fit
+ */
+bool AutotuneLogFit::load(const QByteArray &log)
+{
+    const quint8 *data = (const quint8 *) log.constData();
+    const int size = log.size();
+
+    QVector<quint32> times;
+    for (int i = 0; i < 2; i++) {
+        gyro[i].clear();
+        output[i].clear();
+    }
+    gaps.clear();
+    dt = 0;
+
+    int pos = 0;
+    while (pos + HEADER_LENGTH <= size) {
+        const quint8 type = data[pos + 1];
+        if (data[pos] != SYNC_VAL || (type & ~TYPE_TIMESTAMPED) != TYPE_OBJ) {
+            pos++;
+            continue;
+        }
+
+        const int timestamp = (type & TYPE_TIMESTAMPED) ? TIMESTAMP_LENGTH : 0;
+        const int length = qFromLittleEndian<quint16>(&data[pos + 2]);
+        const quint32 objId = qFromLittleEndian<quint32>(&data[pos + 4]);
+        if (objId != BlackboxFrame::OBJID ||
+                length != (int) (HEADER_LENGTH + timestamp + BlackboxFrame::NUMBYTES) ||
+                pos + length + 1 > size ||
+                UAVTalk::frameCrc(&data[pos], length) != data[pos + length]) {
+            pos++;
+            continue;
+        }
+
+        BlackboxFrame::DataFields frame;
+        memcpy(&frame, &data[pos + HEADER_LENGTH + timestamp], sizeof(frame));
+        times.append(frame.Time);
+        for (int i = 0; i < 2; i++) {
+            gyro[i].push_back(frame.Gyro[i] / 10.0);
+            output[i].push_back(frame.Output[i] / 10000.0);
+        }
+
+        pos += length + 1;
+    }
+
+    if (times.size() < MIN_FRAMES)
+        return false;
+
+    // The frames are logged every so many control cycles, the median
+    // interval is that whatever the gaps
+    QVector<quint32> intervals(times.size() - 1);
+    for (int i = 1; i < times.size(); i++)
+        intervals[i - 1] = times[i] - times[i - 1];
+    std::nth_element(intervals.begin(), intervals.begin() + intervals.size() / 2, intervals.end());
+    quint32 median = intervals[intervals.size() / 2];
+    if (median == 0)
+        return false;
+    dt = median * 1e-6;
+
+    for (int i = 1; i < times.size(); i++) {
+        quint32 interval = times[i] - times[i - 1];
+        if (interval == 0 || interval > GAP_SAMPLES * median)
+            gaps.push_back(i);
+    }
+
+    return true;
+}
+
+/**
+ * Run the candidates of the searches on all cores
+ */
+static void concurrentFor(int count, const std::function<void(int)> &body)
+{
+    QVector<int> indexes(count);
+    for (int i = 0; i < count; i++)
+        indexes[i] = i;
+
+    QtConcurrent::blockingMap(indexes, std::function<void(int &)>([&body](int &i) {
+        body(i);
+    }));
+}
+
+/**
+ * @brief AutotuneLogFit::identify fit the model of one axis
+ * @param axis 0 for roll, 1 for pitch
+ * @return the model, not valid if the axis was not excited enough
+ */
+AutotuneLogFit::Model AutotuneLogFit::identify(int axis) const
+{
+    if (axis < 0 || axis > 1) {
+        Model model = { false, 0, 0, 0, 0, 0 };
+        return model;
+    }
+
+    return AutotuneModel::identify(output[axis], gyro[axis], gaps, dt, concurrentFor);
+}
+
+/**
+ * @brief AutotuneLogFit::refine search around the computed gains, see
+ * AutotuneModel::refine()
+ */
+AutotuneLogFit::Gains AutotuneLogFit::refine(const Model &model, double dt, const Gains &initial,
+                                             double derivativeCutoff, double derivativeGamma,
+                                             double wn)
+{
+    return AutotuneModel::refine(model, dt, initial, derivativeCutoff, derivativeGamma, wn,
+                                 concurrentFor);
+}
+
+/**
+ * @}
+ * @}
+ */
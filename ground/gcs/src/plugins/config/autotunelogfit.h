@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ *
+ * @file       autotunelogfit.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ConfigPlugin Config Plugin
+ * @{
+ * @brief Fits the rate response of roll and pitch to a blackbox log and
+ * tunes the rate loop against the fitted model
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef AUTOTUNELOGFIT_H
+#define AUTOTUNELOGFIT_H
+
+#include "autotunemodel.h"
+#include <QByteArray>
+#include <vector>
+
+/**
+ * The board logs BlackboxFrame at the rate of the stabilization loop, so a
+ * log of an autotune flight has the gyros and the output of every control
+ * cycle rather than the few values SystemIdent reports. Each axis is fitted
+ * with AutotuneModel, whose searches run their candidates on all cores.
+ */
+class AutotuneLogFit
+{
+public:
+    typedef AutotuneModel::Model Model;
+    typedef AutotuneModel::Gains Gains;
+
+    AutotuneLogFit();
+
+    bool load(const QByteArray &log);
+    int numSamples() const { return gyro[0].size(); }
+    double sampleTime() const { return dt; }
+    Model identify(int axis) const;
+
+    static Gains refine(const Model &model, double dt, const Gains &initial,
+                        double derivativeCutoff, double derivativeGamma,
+                        double wn);
+
+private:
+    double dt;
+    std::vector<double> gyro[2];    //!< deg/s
+    std::vector<double> output[2];  //!< -1 to 1
+    std::vector<int> gaps;          //!< Indexes of samples that follow a gap
+};
+
+#endif // AUTOTUNELOGFIT_H
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,432 @@
+/**
+ ******************************************************************************
+ *
+ * @file       autotunemodel.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ConfigPlugin Config Plugin
+ * @{
+ * @brief Fits the rate response of an axis and tunes the rate loop against
+ * the fitted model
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "autotunemodel.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+typedef std::complex<double> Complex;
+
+static const double PI = 3.14159265358979323846;
+
+//! Length of the segments the spectra are averaged over
+static const double WELCH_WINDOW_S = 2.0;
+static const int MIN_WELCH_LENGTH = 64;
+static const int MIN_SEGMENTS = 4;
+
+//! Range of the response that is fitted
+static const double FIT_MIN_HZ = 2;
+static const double FIT_MAX_HZ = 80;
+static const double MIN_COHERENCE = 0.3;
+static const int MIN_BINS = 8;
+
+//! Coarse grid of the model, then a fine grid around its best point
+static const double TAU_MIN = 0.005;
+static const double TAU_MAX = 0.25;
+static const int TAU_STEPS = 48;
+static const double DELAY_MAX = 0.03;
+static const double DELAY_STEP = 0.0005;
+static const int FINE_STEPS = 11;
+
+//! The rate loop is simulated at the log rate, within these bounds
+static const double MIN_SIM_DT = 0.0005;
+static const double MAX_SIM_DT = 0.004;
+
+//! Length of the simulated step, in 1 / wn
+static const double STEP_LENGTH_WN = 20;
+static const double DIVERGED = 100;
+
+//! Multipliers of the computed gains that are simulated. Kd is never
+//! raised, the noise slider already chose how much of it there can be.
+static const double GAIN_MIN = 0.5;
+static const double GAIN_MAX = 1.5;
+static const double KD_MAX = 1.0;
+static const double GAIN_STEP = 0.1;
+
+namespace {
+struct Bin {
+    double w;           //!< rad/s
+    Complex response;   //!< Gyro over output
+    double weight;
+    double coherence;
+};
+
+struct Candidate {
+    double tau;
+    double delay;
+};
+
+struct Fit {
+    double cost;
+    double k;
+};
+}
+
+/**
+ * @brief AutotuneModel::serialFor runs the candidates one after the other
+ */
+void AutotuneModel::serialFor(int count, const std::function<void(int)> &body)
+{
+    for (int i = 0; i < count; i++)
+        body(i);
+}
+
+/**
+ * Radix 2 FFT in place, the size has to be a power of two
+ */
+static void fft(std::vector<Complex> &x)
+{
+    const int n = x.size();
+
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+            std::swap(x[i], x[j]);
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        const Complex step = std::polar(1.0, -2 * PI / len);
+        for (int i = 0; i < n; i += len) {
+            Complex w(1);
+            for (int k = 0; k < len / 2; k++) {
+                Complex a = x[i + k];
+                Complex b = x[i + k + len / 2] * w;
+                x[i + k] = a + b;
+                x[i + k + len / 2] = a - b;
+                w *= step;
+            }
+        }
+    }
+}
+
+/**
+ * Fit the model with a real gain, which is found in closed form, for one
+ * point of the grid. The error is relative to the measured response so
+ * the high frequencies count as much as the low ones.
+ */
+static Fit fitPoint(const std::vector<Bin> &bins, const Candidate &candidate)
+{
+    double num = 0, den = 0;
+    std::vector<Complex> ratio(bins.size());
+    for (size_t i = 0; i < bins.size(); i++) {
+        const Complex s(0, bins[i].w);
+        const Complex model = std::exp(-s * candidate.delay) / (s * (candidate.tau * s + 1.0));
+        ratio[i] = model / bins[i].response;
+        num += bins[i].weight * ratio[i].real();
+        den += bins[i].weight * std::norm(ratio[i]);
+    }
+
+    Fit fit;
+    fit.k = num / den;
+    if (!(fit.k > 0)) {
+        fit.cost = std::numeric_limits<double>::infinity();
+        return fit;
+    }
+
+    double cost = 0, weights = 0;
+    for (size_t i = 0; i < bins.size(); i++) {
+        cost += bins[i].weight * std::norm(1.0 - fit.k * ratio[i]);
+        weights += bins[i].weight;
+    }
+    fit.cost = cost / weights;
+
+    return fit;
+}
+
+/**
+ * Fit every candidate
+ * @return the index of the best one
+ */
+static int bestFit(const std::vector<Bin> &bins, const std::vector<Candidate> &candidates,
+                   const AutotuneModel::ParallelFor &parallelFor, std::vector<Fit> &fits)
+{
+    fits.resize(candidates.size());
+    parallelFor(candidates.size(), [&](int i) {
+        fits[i] = fitPoint(bins, candidates[i]);
+    });
+
+    int best = 0;
+    for (size_t i = 1; i < fits.size(); i++) {
+        if (fits[i].cost < fits[best].cost)
+            best = i;
+    }
+
+    return best;
+}
+
+/**
+ * @brief AutotuneModel::identify fit the model of one axis
+ * @param output the output of the rate loop, -1 to 1
+ * @param gyro the rate of the axis in deg/s, sampled with the output
+ * @param gaps indexes of the samples that follow a gap in the log, in order
+ * @param dt the sample time
+ * @param parallelFor runs the points of the grids
+ * @return the model, not valid if the axis was not excited enough
+ */
+AutotuneModel::Model AutotuneModel::identify(const std::vector<double> &output,
+                                             const std::vector<double> &gyro,
+                                             const std::vector<int> &gaps, double dt,
+                                             const ParallelFor &parallelFor)
+{
+    Model model = { false, 0, 0, 0, 0, 0 };
+    if (!(dt > 0) || output.size() != gyro.size())
+        return model;
+
+    const std::vector<double> &u = output;
+    const std::vector<double> &y = gyro;
+    const int n = u.size();
+
+    int m = MIN_WELCH_LENGTH;
+    while (m * 2 * MIN_SEGMENTS <= n && m * 2 * dt <= WELCH_WINDOW_S)
+        m *= 2;
+    if (m * MIN_SEGMENTS > n)
+        return model;
+
+    std::vector<double> window(m);
+    for (int i = 0; i < m; i++)
+        window[i] = 0.5 - 0.5 * cos(2 * PI * i / m);
+
+    // Welch estimate of the spectra, over half overlapping segments that
+    // have no gap in them
+    std::vector<double> suu(m / 2 + 1, 0), syy(m / 2 + 1, 0);
+    std::vector<Complex> suy(m / 2 + 1, 0);
+    std::vector<Complex> fu(m), fy(m);
+    int segments = 0;
+    int start = 0;
+    while (start + m <= n) {
+        std::vector<int>::const_iterator gap = std::upper_bound(gaps.begin(), gaps.end(), start);
+        if (gap != gaps.end() && *gap < start + m) {
+            start = *gap;
+            continue;
+        }
+
+        double meanU = 0, meanY = 0;
+        for (int i = 0; i < m; i++) {
+            meanU += u[start + i];
+            meanY += y[start + i];
+        }
+        meanU /= m;
+        meanY /= m;
+
+        for (int i = 0; i < m; i++) {
+            fu[i] = (u[start + i] - meanU) * window[i];
+            fy[i] = (y[start + i] - meanY) * window[i];
+        }
+        fft(fu);
+        fft(fy);
+
+        for (int k = 0; k <= m / 2; k++) {
+            suu[k] += std::norm(fu[k]);
+            syy[k] += std::norm(fy[k]);
+            suy[k] += std::conj(fu[k]) * fy[k];
+        }
+
+        segments++;
+        start += m / 2;
+    }
+
+    if (segments < MIN_SEGMENTS)
+        return model;
+
+    // The bins the output explains most of the gyros in
+    const double resolution = 1 / (m * dt);
+    const int firstBin = std::max((int) ceil(FIT_MIN_HZ / resolution), 1);
+    const int lastBin = std::min((int) floor(std::min(FIT_MAX_HZ, 0.4 / dt) / resolution), m / 2);
+    std::vector<Bin> bins;
+    double coherence = 0;
+    for (int k = firstBin; k <= lastBin; k++) {
+        if (suu[k] <= 0 || syy[k] <= 0)
+            continue;
+
+        Bin bin;
+        bin.coherence = std::norm(suy[k]) / (suu[k] * syy[k]);
+        if (bin.coherence < MIN_COHERENCE)
+            continue;
+
+        bin.w = 2 * PI * k * resolution;
+        bin.response = suy[k] / suu[k];
+        bin.weight = bin.coherence * bin.coherence;
+        bins.push_back(bin);
+        coherence += bin.coherence;
+    }
+
+    if ((int) bins.size() < MIN_BINS)
+        return model;
+
+    std::vector<Candidate> candidates;
+    std::vector<Fit> fits;
+    const int delaySteps = lround(DELAY_MAX / DELAY_STEP);
+    const double tauRatio = pow(TAU_MAX / TAU_MIN, 1.0 / (TAU_STEPS - 1));
+    for (int i = 0; i < TAU_STEPS; i++) {
+        for (int j = 0; j <= delaySteps; j++) {
+            Candidate candidate = { TAU_MIN * pow(tauRatio, i), j * DELAY_STEP };
+            candidates.push_back(candidate);
+        }
+    }
+
+    // Between the neighbours of the best point of the coarse grid
+    const Candidate coarse = candidates[bestFit(bins, candidates, parallelFor, fits)];
+    candidates.clear();
+    candidates.push_back(coarse);
+    for (int i = 0; i < FINE_STEPS; i++) {
+        for (int j = 0; j < FINE_STEPS; j++) {
+            const double x = 2.0 * i / (FINE_STEPS - 1) - 1;
+            const double d = 2.0 * j / (FINE_STEPS - 1) - 1;
+            Candidate candidate = { coarse.tau * pow(tauRatio, x), std::max(0.0, coarse.delay + d * DELAY_STEP) };
+            candidates.push_back(candidate);
+        }
+    }
+
+    const int best = bestFit(bins, candidates, parallelFor, fits);
+    if (!(fits[best].cost < std::numeric_limits<double>::infinity()))
+        return model;
+
+    model.valid = true;
+    model.beta = log(fits[best].k);
+    model.tau = candidates[best].tau;
+    model.delay = candidates[best].delay;
+    model.fitError = fits[best].cost;
+    model.coherence = coherence / bins.size();
+
+    return model;
+}
+
+/**
+ * Simulate a unit step of the rate setpoint, with the rate loop of the
+ * board on the fitted model. It is linear so the size of the step does
+ * not matter.
+ * @param[out] rates the response, one sample per step
+ * @return false if the loop diverged
+ */
+static bool stepResponse(const AutotuneModel::Model &model, double delay, double h,
+                         const AutotuneModel::Gains &gains, double derivTau, double gamma,
+                         std::vector<double> &rates)
+{
+    const double k = exp(model.beta);
+    const double lag = 1 - exp(-h / model.tau);
+
+    // Outputs waiting for the delay to pass
+    std::vector<double> pending(lround(delay / h) + 1, 0.0);
+
+    double rate = 0, filtered = 0;
+    double integral = 0, lastErr = 0, lastDer = 0;
+    const double setpoint = 1;
+    for (size_t i = 0; i < rates.size(); i++) {
+        // As pid_apply_setpoint() does it
+        double err = setpoint - rate;
+        integral += err * gains.ki * h;
+        double diff = (gamma * setpoint - rate) - lastErr;
+        lastErr = gamma * setpoint - rate;
+        double dterm = lastDer + h / (h + derivTau) * (diff * gains.kd / h - lastDer);
+        lastDer = dterm;
+        pending[i % pending.size()] = err * gains.kp + integral + dterm;
+
+        filtered += lag * (pending[(i + 1) % pending.size()] - filtered);
+        rate += k * filtered * h;
+
+        if (!(fabs(rate) < DIVERGED))
+            return false;
+        rates[i] = rate;
+    }
+
+    return true;
+}
+
+/**
+ * @brief AutotuneModel::refine search around the computed gains
+ * @param model the fitted axis
+ * @param dt the sample time of the log
+ * @param initial gains computed from the model without its delay
+ * @param derivativeCutoff StabilizationSettings.DerivativeCutoff in Hz
+ * @param derivativeGamma StabilizationSettings.DerivativeGamma
+ * @param wn natural frequency the gains were computed for, rad/s
+ * @param parallelFor runs the simulations of the candidates
+ * @return the gains whose step response with the delay is closest to the
+ * response the computed gains were meant to have, which is theirs without
+ * the delay. The initial gains if none is closer.
+ */
+AutotuneModel::Gains AutotuneModel::refine(const Model &model, double dt, const Gains &initial,
+                                           double derivativeCutoff, double derivativeGamma,
+                                           double wn, const ParallelFor &parallelFor)
+{
+    if (!model.valid || !(wn > 0) || !(derivativeCutoff > 0))
+        return initial;
+
+    const double h = std::min(std::max(dt, MIN_SIM_DT), MAX_SIM_DT);
+    const double derivTau = 1 / (2 * PI * derivativeCutoff);
+
+    std::vector<double> designed((size_t) ceil(STEP_LENGTH_WN / wn / h));
+    if (!stepResponse(model, 0, h, initial, derivTau, derivativeGamma, designed))
+        return initial;
+
+    std::vector<Gains> candidates;
+    candidates.push_back(initial);
+    const int steps = lround((GAIN_MAX - GAIN_MIN) / GAIN_STEP);
+    for (int p = 0; p <= steps; p++) {
+        for (int i = 0; i <= steps; i++) {
+            for (int d = 0; GAIN_MIN + d * GAIN_STEP <= KD_MAX + GAIN_STEP / 2; d++) {
+                Gains gains = { initial.kp * (GAIN_MIN + p * GAIN_STEP),
+                                initial.ki * (GAIN_MIN + i * GAIN_STEP),
+                                initial.kd * (GAIN_MIN + d * GAIN_STEP) };
+                candidates.push_back(gains);
+            }
+        }
+    }
+
+    std::vector<double> costs(candidates.size());
+    parallelFor(candidates.size(), [&](int c) {
+        std::vector<double> rates(designed.size());
+        if (!stepResponse(model, model.delay, h, candidates[c], derivTau, derivativeGamma, rates)) {
+            costs[c] = std::numeric_limits<double>::infinity();
+            return;
+        }
+
+        double cost = 0;
+        for (size_t i = 0; i < rates.size(); i++)
+            cost += (rates[i] - designed[i]) * (rates[i] - designed[i]);
+        costs[c] = cost / rates.size();
+    });
+
+    int best = 0;
+    for (size_t i = 1; i < costs.size(); i++) {
+        if (costs[i] < costs[best])
+            best = i;
+    }
+
+    return candidates[best];
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ *
+ * @file       autotunemodel.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ConfigPlugin Config Plugin
+ * @{
+ * @brief Fits the rate response of an axis and tunes the rate loop against
+ * the fitted model
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef AUTOTUNEMODEL_H
+#define AUTOTUNEMODEL_H
+
+#include <functional>
+#include <vector>
+
+/**
+ * The same model as the onboard filter, K e^(-sL) / (s (tau s + 1)), with
+ * the delay as well, fitted to the frequency response of one axis. The
+ * gains computed from it are then refined by simulating the rate loop on
+ * the fitted model. This has no Qt in it so that the unit tests build it,
+ * AutotuneLogFit reads the log and runs the candidates on all cores.
+ */
+class AutotuneModel
+{
+public:
+    //! One fitted axis
+    struct Model {
+        bool valid;
+        double beta;        //!< ln K, like SystemIdent.Beta
+        double tau;         //!< s
+        double delay;       //!< s, from the output to the gyros
+        double fitError;    //!< Weighted relative error of the response, 0 is a perfect fit
+        double coherence;   //!< Mean coherence of the bins fitted, low when the axis was not excited
+    };
+
+    struct Gains {
+        double kp;
+        double ki;
+        double kd;
+    };
+
+    //! Calls body for 0 to count - 1, in any order and from any thread
+    typedef std::function<void(int count, const std::function<void(int)> &body)> ParallelFor;
+
+    static void serialFor(int count, const std::function<void(int)> &body);
+
+    static Model identify(const std::vector<double> &output, const std::vector<double> &gyro,
+                          const std::vector<int> &gaps, double dt,
+                          const ParallelFor &parallelFor = serialFor);
+
+    static Gains refine(const Model &model, double dt, const Gains &initial,
+                        double derivativeCutoff, double derivativeGamma, double wn,
+                        const ParallelFor &parallelFor = serialFor);
+};
+
+#endif // AUTOTUNEMODEL_H
+
+/**
+ * @}
+ * @}
+ */
@@ -47,10 +47,7 @@
 #include "trimanglessettings.h"
 #include "flighttelemetrystats.h"
 
-#include <Eigen/Core>
-#include <Eigen/Cholesky>
-#include <Eigen/SVD>
-#include <Eigen/QR>
+#include <cmath>
 #include <cstdlib>
 
 #define META_OPERATIONS_TIMEOUT 5000
@@ -67,7 +64,8 @@ public:
 enum calibrationSuccessMessages{
     CALIBRATION_SUCCESS,
     ACCELEROMETER_FAILED,
-    MAGNETOMETER_FAILED
+    MAGNETOMETER_FAILED,
+    TEMP_CAL_FAILED
 };
 
 #define sign(x) ((x < 0) ? -1 : 1)
@@ -359,6 +357,10 @@ void Calibration::dataUpdated(UAVObject * obj) {
                 if (calibrateMags == true) {
                     magCalibrationResults = QString(tr("Magnetometer bias, in [mG]: x=%1, y=%2, z=%3\n")).arg(sensorSettingsData.MagBias[SensorSettings::MAGBIAS_X], -9).arg(sensorSettingsData.MagBias[SensorSettings::MAGBIAS_Y], -9).arg(sensorSettingsData.MagBias[SensorSettings::MAGBIAS_Z], -9) +
                                             QString(tr("Magnetometer scale, in [-]: x=%4, y=%5, z=%6")).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_X], -9).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_Y], -9).arg(sensorSettingsData.MagScale[SensorSettings::MAGSCALE_Z], -9);
+
+                    double bias[3], radius[3], error;
+                    if (magFit.solve(bias, radius, &error))
+                        magCalibrationResults += QString(tr("\nMagnetometer field fit error: %1%")).arg(error * 100, 0, 'f', 1);
                 }
 
                 // Emit SIGNAL containing calibration success message
@@ -391,7 +393,7 @@ void Calibration::dataUpdated(UAVObject * obj) {
             if (ret == CALIBRATION_SUCCESS) {
                 emit showTempCalMessage(tr("Temperature compensation calibration succeeded"));
             } else {
-                emit showTempCalMessage(tr("Temperature compensation calibration succeeded"));
+                emit showTempCalMessage(tr("Temperature compensation calibration failed"));
             }
         }
     }
@@ -473,9 +475,7 @@ void Calibration::timeout()
  * @brief Calibration::doStartLeveling Called by UI to start collecting data to calculate level
  */
 void Calibration::doStartOrientation() {
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
+    clearStats(accel_stats);
 
     calibration_state = YAW_ORIENTATION;
 
@@ -512,13 +512,9 @@ void Calibration::doStartNoBiasLeveling()
  * @brief Calibration::doStartLeveling Called by UI to start collecting data to calculate level
  */
 void Calibration::doStartLeveling() {
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
-    gyro_accum_x.clear();
-    gyro_accum_y.clear();
-    gyro_accum_z.clear();
-    gyro_accum_temp.clear();
+    clearStats(accel_stats);
+    clearStats(gyro_stats);
+    gyro_temp_stats.clear();
 
     // Disable gyro bias correction to see raw data
     AttitudeSettings *attitudeSettings = AttitudeSettings::GetInstance(getObjectManager());
@@ -607,12 +603,10 @@ void Calibration::doStartSixPoint()
     sensorSettings->setData(sensorSettingsData);
 
     // Clear the accumulators
-    accel_accum_x.clear();
-    accel_accum_y.clear();
-    accel_accum_z.clear();
-    mag_accum_x.clear();
-    mag_accum_y.clear();
-    mag_accum_z.clear();
+    clearStats(accel_stats);
+    clearStats(mag_stats);
+    magFit.clear();
+    emit sixPointFitChanged(-1);
 
     // TODO: Document why the thread needs to wait 100ms.
     Thread::usleep(100000);
@@ -725,6 +719,8 @@ void Calibration::doStartTempCal()
     gyro_accum_y.clear();
     gyro_accum_z.clear();
     gyro_accum_temp.clear();
+    gyro_temp_stats.clear();
+    tempFit.clear();
 
     // Disable gyro sensor bias correction to see raw data
     AttitudeSettings *attitudeSettings = AttitudeSettings::GetInstance(getObjectManager());
@@ -776,7 +772,8 @@ void Calibration::doAcceptTempCal()
         timer.stop();
         disconnect(&timer,SIGNAL(timeout()),this,SLOT(timeout()));
 
-        computeTempCal();
+        if (computeTempCal() != CALIBRATION_SUCCESS)
+            emit showTempCalMessage(tr("Not enough temperature calibration data"));
     }
 }
 
@@ -834,16 +831,16 @@ bool Calibration::storeYawOrientationMeasurement(UAVObject *obj)
     // Accumulate samples until we have _at least_ NUM_SENSOR_UPDATES_YAW_ORIENTATION samples
     if(obj->getObjID() == Accels::OBJID) {
         Accels::DataFields accelsData = accels->getData();
-        accel_accum_x.append(accelsData.x);
-        accel_accum_y.append(accelsData.y);
-        accel_accum_z.append(accelsData.z);
+        accel_stats[0].add(accelsData.x);
+        accel_stats[1].add(accelsData.y);
+        accel_stats[2].add(accelsData.z);
     }
 
     // update the progress indicator
-    emit yawOrientationProgressChanged((double)accel_accum_x.size() / NUM_SENSOR_UPDATES_YAW_ORIENTATION * 100);
+    emit yawOrientationProgressChanged((double)accel_stats[0].count() / NUM_SENSOR_UPDATES_YAW_ORIENTATION * 100);
 
     // If we have enough samples, then stop sampling and compute the biases
-    if (accel_accum_x.size() >= NUM_SENSOR_UPDATES_YAW_ORIENTATION) {
+    if (accel_stats[0].count() >= NUM_SENSOR_UPDATES_YAW_ORIENTATION) {
         timer.stop();
         disconnect(&timer,SIGNAL(timeout()),this,SLOT(timeout()));
 
@@ -852,7 +849,7 @@ bool Calibration::storeYawOrientationMeasurement(UAVObject *obj)
         AttitudeSettings::DataFields attitudeSettingsData = attitudeSettings->getData();
 
         // Use sensor data without rotation, as it has already been rotated on-board.
-        double a_body[3] = { listMean(accel_accum_x), listMean(accel_accum_y), listMean(accel_accum_z) };
+        double a_body[3] = { accel_stats[0].mean(), accel_stats[1].mean(), accel_stats[2].mean() };
 
         // Temporary variable
         double psi;
@@ -893,36 +890,36 @@ bool Calibration::storeLevelingMeasurement(UAVObject *obj) {
     // Accumulate samples until we have _at least_ NUM_SENSOR_UPDATES_LEVELING samples
     if(obj->getObjID() == Accels::OBJID) {
         Accels::DataFields accelsData = accels->getData();
-        accel_accum_x.append(accelsData.x);
-        accel_accum_y.append(accelsData.y);
-        accel_accum_z.append(accelsData.z);
+        accel_stats[0].add(accelsData.x);
+        accel_stats[1].add(accelsData.y);
+        accel_stats[2].add(accelsData.z);
     } else if (obj->getObjID() == Gyros::OBJID) {
         Gyros::DataFields gyrosData = gyros->getData();
-        gyro_accum_x.append(gyrosData.x);
-        gyro_accum_y.append(gyrosData.y);
-        gyro_accum_z.append(gyrosData.z);
-        gyro_accum_temp.append(gyrosData.temperature);
+        gyro_stats[0].add(gyrosData.x);
+        gyro_stats[1].add(gyrosData.y);
+        gyro_stats[2].add(gyrosData.z);
+        gyro_temp_stats.add(gyrosData.temperature);
     }
 
     // update the progress indicator
-    emit levelingProgressChanged((float) qMin(accel_accum_x.size(),  gyro_accum_x.size()) / NUM_SENSOR_UPDATES_LEVELING * 100);
+    emit levelingProgressChanged((float) qMin(accel_stats[0].count(),  gyro_stats[0].count()) / NUM_SENSOR_UPDATES_LEVELING * 100);
 
     // If we have enough samples, then stop sampling and compute the biases
-    if (accel_accum_x.size() >= NUM_SENSOR_UPDATES_LEVELING && gyro_accum_x.size() >= NUM_SENSOR_UPDATES_LEVELING) {
+    if (accel_stats[0].count() >= NUM_SENSOR_UPDATES_LEVELING && gyro_stats[0].count() >= NUM_SENSOR_UPDATES_LEVELING) {
         timer.stop();
         disconnect(&timer,SIGNAL(timeout()),this,SLOT(timeout()));
 
-        float x_gyro_bias = listMean(gyro_accum_x);
-        float y_gyro_bias = listMean(gyro_accum_y);
-        float z_gyro_bias = listMean(gyro_accum_z);
-        float temp = listMean(gyro_accum_temp);
+        float x_gyro_bias = gyro_stats[0].mean();
+        float y_gyro_bias = gyro_stats[1].mean();
+        float z_gyro_bias = gyro_stats[2].mean();
+        float temp = gyro_temp_stats.mean();
 
         // Get the existing attitude settings
         AttitudeSettings::DataFields attitudeSettingsData = AttitudeSettings::GetInstance(getObjectManager())->getData();
         SensorSettings::DataFields sensorSettingsData = SensorSettings::GetInstance(getObjectManager())->getData();
 
         // Inverse rotation of sensor data, from body frame into sensor frame
-        double a_body[3] = { listMean(accel_accum_x), listMean(accel_accum_y), listMean(accel_accum_z) };
+        double a_body[3] = { accel_stats[0].mean(), accel_stats[1].mean(), accel_stats[2].mean() };
         double a_sensor[3]; //! Store the sensor data without any rotation
         double Rsb[3][3];  // The initial body-frame to sensor-frame rotation
         double rpy[3] = { attitudeSettingsData.BoardRotation[AttitudeSettings::BOARDROTATION_ROLL] * DEG2RAD / 100.0,
@@ -1021,9 +1018,9 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
         Q_ASSERT(accels);
         Accels::DataFields accelsData = accels->getData();
 
-        accel_accum_x.append(accelsData.x);
-        accel_accum_y.append(accelsData.y);
-        accel_accum_z.append(accelsData.z);
+        accel_stats[0].add(accelsData.x);
+        accel_stats[1].add(accelsData.y);
+        accel_stats[2].add(accelsData.z);
     }
 
     if( calibrateMags && obj->getObjID() == Magnetometer::OBJID) {
@@ -1031,53 +1028,60 @@ bool Calibration::storeSixPointMeasurement(UAVObject * obj, int position)
         Q_ASSERT(mag);
         Magnetometer::DataFields magData = mag->getData();
 
-        mag_accum_x.append(magData.x);
-        mag_accum_y.append(magData.y);
-        mag_accum_z.append(magData.z);
+        mag_stats[0].add(magData.x);
+        mag_stats[1].add(magData.y);
+        mag_stats[2].add(magData.z);
+
+        // Fit the ellipsoid in the sensor frame, as the final calibration is
+        double mag_body[3] = {magData.x, magData.y, magData.z};
+        double mag_sensor[3];
+        rotate_vector(boardRotationMatrix, mag_body, mag_sensor, false);
+        magFit.add(mag_sensor[0], mag_sensor[1], mag_sensor[2]);
+
+        if ((magFit.count() % 10) == 0) {
+            double bias[3], radius[3], error;
+            emit sixPointFitChanged(magFit.solve(bias, radius, &error) ? error : -1);
+        }
     }
 
     // Update progress bar
     float progress_percentage;
     if(calibrateAccels && !calibrateMags)
-        progress_percentage = (float) accel_accum_x.size() / NUM_SENSOR_UPDATES_SIX_POINT * 100;
+        progress_percentage = (float) accel_stats[0].count() / NUM_SENSOR_UPDATES_SIX_POINT * 100;
     else if(!calibrateAccels && calibrateMags)
-        progress_percentage = (float) mag_accum_x.size() / NUM_SENSOR_UPDATES_SIX_POINT * 100;
+        progress_percentage = (float) mag_stats[0].count() / NUM_SENSOR_UPDATES_SIX_POINT * 100;
     else
-        progress_percentage = fminf(mag_accum_x.size(), accel_accum_x.size()) / NUM_SENSOR_UPDATES_SIX_POINT * 100;
+        progress_percentage = fminf(mag_stats[0].count(), accel_stats[0].count()) / NUM_SENSOR_UPDATES_SIX_POINT * 100;
     emit sixPointProgressChanged(progress_percentage);
 
     // If enough data is collected, average it for this position
-    if((!calibrateAccels || accel_accum_x.size() >= NUM_SENSOR_UPDATES_SIX_POINT) &&
-            (!calibrateMags || mag_accum_x.size() >= NUM_SENSOR_UPDATES_SIX_POINT)) {
+    if((!calibrateAccels || accel_stats[0].count() >= NUM_SENSOR_UPDATES_SIX_POINT) &&
+            (!calibrateMags || mag_stats[0].count() >= NUM_SENSOR_UPDATES_SIX_POINT)) {
 
         // Store the average accelerometer value in that position
         if (calibrateAccels) {
             // undo the board rotation that has been applied to the sensor values
-            double accel_body[3] = {listMean(accel_accum_x), listMean(accel_accum_y), listMean(accel_accum_z)};
+            double accel_body[3] = {accel_stats[0].mean(), accel_stats[1].mean(), accel_stats[2].mean()};
             double accel_sensor[3];
             rotate_vector(boardRotationMatrix, accel_body, accel_sensor, false);
 
             accel_data_x[position] = accel_sensor[0];
             accel_data_y[position] = accel_sensor[1];
             accel_data_z[position] = accel_sensor[2];
-            accel_accum_x.clear();
-            accel_accum_y.clear();
-            accel_accum_z.clear();
+            clearStats(accel_stats);
         }
 
         // Store the average magnetometer value in that position
         if (calibrateMags) {
             // undo the board rotation that has been applied to the sensor values
-            double mag_body[3] = {listMean(mag_accum_x), listMean(mag_accum_y), listMean(mag_accum_z)};
+            double mag_body[3] = {mag_stats[0].mean(), mag_stats[1].mean(), mag_stats[2].mean()};
             double mag_sensor[3];
             rotate_vector(boardRotationMatrix, mag_body, mag_sensor, false);
 
             mag_data_x[position] = mag_sensor[0];
             mag_data_y[position] = mag_sensor[1];
             mag_data_z[position] = mag_sensor[2];
-            mag_accum_x.clear();
-            mag_accum_y.clear();
-            mag_accum_z.clear();
+            clearStats(mag_stats);
         }
 
         // Indicate all data collected for this position
@@ -1118,12 +1122,14 @@ bool Calibration::storeTempCalMeasurement(UAVObject * obj)
         gyro_accum_y.append(gyros_sensor[1]);
         gyro_accum_z.append(gyros_sensor[2]);
         gyro_accum_temp.append(gyrosData.temperature);
+        gyro_temp_stats.add(gyrosData.temperature);
+        tempFit.add(gyrosData.temperature, gyros_sensor[0], gyros_sensor[1], gyros_sensor[2]);
     }
 
-    double range = listMax(gyro_accum_temp) - listMin(gyro_accum_temp);
+    double range = gyro_temp_stats.max() - gyro_temp_stats.min();
     emit tempCalProgressChanged((float) range / MIN_TEMPERATURE_RANGE * 100);
 
-    if ((gyro_accum_temp.size() % 10) == 0) {
+    if ((gyro_temp_stats.count() % 10) == 0) {
         updateTempCompCalibrationDisplay();
     }
 
@@ -1140,46 +1146,27 @@ bool Calibration::storeTempCalMeasurement(UAVObject * obj)
  */
 void Calibration::updateTempCompCalibrationDisplay()
 {
-    unsigned int n_samples = gyro_accum_temp.size();
-
-    // Construct the matrix of temperature.
-    Eigen::Matrix<double, Eigen::Dynamic, 4> X(n_samples, 4);
-
-    // And the matrix of gyro samples.
-    Eigen::Matrix<double, Eigen::Dynamic, 3> Y(n_samples, 3);
-
-    for (unsigned i = 0; i < n_samples; ++i) {
-        X(i,0) = 1;
-        X(i,1) = gyro_accum_temp[i];
-        X(i,2) = pow(gyro_accum_temp[i],2);
-        X(i,3) = pow(gyro_accum_temp[i],3);
-        Y(i,0) = gyro_accum_x[i];
-        Y(i,1) = gyro_accum_y[i];
-        Y(i,2) = gyro_accum_z[i];
-    }
-
-    // Solve Y = X * B
-
-    Eigen::Matrix<double, 4, 3> result;
-    // Use the cholesky-based Penrose pseudoinverse method.
-    (X.transpose() * X).ldlt().solve(X.transpose()*Y, &result);
+    // Solve Y = X * B from the normal equations accumulated so far
+    double coeffs[3][4];
+    if (!tempFit.solve(coeffs))
+        return;
 
     QList<double> xCoeffs, yCoeffs, zCoeffs;
     xCoeffs.clear();
-    xCoeffs.append(result(0,0));
-    xCoeffs.append(result(1,0));
-    xCoeffs.append(result(2,0));
-    xCoeffs.append(result(3,0));
+    xCoeffs.append(coeffs[0][0]);
+    xCoeffs.append(coeffs[0][1]);
+    xCoeffs.append(coeffs[0][2]);
+    xCoeffs.append(coeffs[0][3]);
     yCoeffs.clear();
-    yCoeffs.append(result(0,1));
-    yCoeffs.append(result(1,1));
-    yCoeffs.append(result(2,1));
-    yCoeffs.append(result(3,1));
+    yCoeffs.append(coeffs[1][0]);
+    yCoeffs.append(coeffs[1][1]);
+    yCoeffs.append(coeffs[1][2]);
+    yCoeffs.append(coeffs[1][3]);
     zCoeffs.clear();
-    zCoeffs.append(result(0,2));
-    zCoeffs.append(result(1,2));
-    zCoeffs.append(result(2,2));
-    zCoeffs.append(result(3,2));
+    zCoeffs.append(coeffs[2][0]);
+    zCoeffs.append(coeffs[2][1]);
+    zCoeffs.append(coeffs[2][2]);
+    zCoeffs.append(coeffs[2][3]);
 
     if (xCurve != NULL)
         xCurve->plotData(gyro_accum_temp, gyro_accum_x, xCoeffs);
@@ -1208,71 +1195,53 @@ int Calibration::computeTempCal()
     attitudeSettings->setData(attitudeSettingsData);
     attitudeSettings->updated();
 
-    unsigned int n_samples = gyro_accum_temp.size();
-
-    // Construct the matrix of temperature.
-    Eigen::Matrix<double, Eigen::Dynamic, 4> X(n_samples, 4);
-
-    // And the matrix of gyro samples.
-    Eigen::Matrix<double, Eigen::Dynamic, 3> Y(n_samples, 3);
-
-    for (unsigned i = 0; i < n_samples; ++i) {
-        X(i,0) = 1;
-        X(i,1) = gyro_accum_temp[i];
-        X(i,2) = pow(gyro_accum_temp[i],2);
-        X(i,3) = pow(gyro_accum_temp[i],3);
-        Y(i,0) = gyro_accum_x[i];
-        Y(i,1) = gyro_accum_y[i];
-        Y(i,2) = gyro_accum_z[i];
+    // Solve Y = X * B from the normal equations accumulated so far
+    double coeffs[3][4];
+    if (!tempFit.solve(coeffs)) {
+        emit tempCalProgressChanged(0);
+        return TEMP_CAL_FAILED;
     }
 
-    // Solve Y = X * B
-
-    Eigen::Matrix<double, 4, 3> result;
-    // Use the cholesky-based Penrose pseudoinverse method.
-    (X.transpose() * X).ldlt().solve(X.transpose()*Y, &result);
-
-    //qDebug() << "Solution" << result;
     qDebug() << "Solution: ";
-    qDebug() << "[" << result(0,0) << " " << result(0,1) << " " << result(0,2) << "]";
-    qDebug() << "[" << result(1,0) << " " << result(1,1) << " " << result(1,2) << "]";
-    qDebug() << "[" << result(2,0) << " " << result(2,1) << " " << result(2,2) << "]";
-    qDebug() << "[" << result(3,0) << " " << result(3,1) << " " << result(3,2) << "]";
+    qDebug() << "[" << coeffs[0][0] << " " << coeffs[1][0] << " " << coeffs[2][0] << "]";
+    qDebug() << "[" << coeffs[0][1] << " " << coeffs[1][1] << " " << coeffs[2][1] << "]";
+    qDebug() << "[" << coeffs[0][2] << " " << coeffs[1][2] << " " << coeffs[2][2] << "]";
+    qDebug() << "[" << coeffs[0][3] << " " << coeffs[1][3] << " " << coeffs[2][3] << "]";
 
     // Store the results
     SensorSettings * sensorSettings = SensorSettings::GetInstance(getObjectManager());
     Q_ASSERT(sensorSettings);
     SensorSettings::DataFields sensorSettingsData = sensorSettings->getData();
-    sensorSettingsData.XGyroTempCoeff[0] = result(0,0);
-    sensorSettingsData.XGyroTempCoeff[1] = result(1,0);
-    sensorSettingsData.XGyroTempCoeff[2] = result(2,0);
-    sensorSettingsData.XGyroTempCoeff[3] = result(3,0);
-    sensorSettingsData.YGyroTempCoeff[0] = result(0,1);
-    sensorSettingsData.YGyroTempCoeff[1] = result(1,1);
-    sensorSettingsData.YGyroTempCoeff[2] = result(2,1);
-    sensorSettingsData.YGyroTempCoeff[3] = result(3,1);
-    sensorSettingsData.ZGyroTempCoeff[0] = result(0,2);
-    sensorSettingsData.ZGyroTempCoeff[1] = result(1,2);
-    sensorSettingsData.ZGyroTempCoeff[2] = result(2,2);
-    sensorSettingsData.ZGyroTempCoeff[3] = result(3,2);
+    sensorSettingsData.XGyroTempCoeff[0] = coeffs[0][0];
+    sensorSettingsData.XGyroTempCoeff[1] = coeffs[0][1];
+    sensorSettingsData.XGyroTempCoeff[2] = coeffs[0][2];
+    sensorSettingsData.XGyroTempCoeff[3] = coeffs[0][3];
+    sensorSettingsData.YGyroTempCoeff[0] = coeffs[1][0];
+    sensorSettingsData.YGyroTempCoeff[1] = coeffs[1][1];
+    sensorSettingsData.YGyroTempCoeff[2] = coeffs[1][2];
+    sensorSettingsData.YGyroTempCoeff[3] = coeffs[1][3];
+    sensorSettingsData.ZGyroTempCoeff[0] = coeffs[2][0];
+    sensorSettingsData.ZGyroTempCoeff[1] = coeffs[2][1];
+    sensorSettingsData.ZGyroTempCoeff[2] = coeffs[2][2];
+    sensorSettingsData.ZGyroTempCoeff[3] = coeffs[2][3];
     sensorSettings->setData(sensorSettingsData);
 
     QList<double> xCoeffs, yCoeffs, zCoeffs;
     xCoeffs.clear();
-    xCoeffs.append(result(0,0));
-    xCoeffs.append(result(1,0));
-    xCoeffs.append(result(2,0));
-    xCoeffs.append(result(3,0));
+    xCoeffs.append(coeffs[0][0]);
+    xCoeffs.append(coeffs[0][1]);
+    xCoeffs.append(coeffs[0][2]);
+    xCoeffs.append(coeffs[0][3]);
     yCoeffs.clear();
-    yCoeffs.append(result(0,1));
-    yCoeffs.append(result(1,1));
-    yCoeffs.append(result(2,1));
-    yCoeffs.append(result(3,1));
+    yCoeffs.append(coeffs[1][0]);
+    yCoeffs.append(coeffs[1][1]);
+    yCoeffs.append(coeffs[1][2]);
+    yCoeffs.append(coeffs[1][3]);
     zCoeffs.clear();
-    zCoeffs.append(result(0,2));
-    zCoeffs.append(result(1,2));
-    zCoeffs.append(result(2,2));
-    zCoeffs.append(result(3,2));
+    zCoeffs.append(coeffs[2][0]);
+    zCoeffs.append(coeffs[2][1]);
+    zCoeffs.append(coeffs[2][2]);
+    zCoeffs.append(coeffs[2][3]);
 
     if (xCurve != NULL)
         xCurve->plotData(gyro_accum_temp, gyro_accum_x, xCoeffs);
@@ -1312,42 +1281,13 @@ UAVObjectUtilManager* Calibration::getObjectUtilManager() {
 }
 
 /**
- * Utility function which calculates the Mean value of a list of values
- * @param list list of double values
- * @returns Mean value of the list of parameter values
- */
-double Calibration::listMean(QList<double> list)
-{
-    double accum = 0;
-    for(int i = 0; i < list.size(); i++)
-        accum += list[i];
-    return accum / list.size();
-}
-
-/**
- * Utility function which calculates the Mean value of a list of values
- * @param list list of double values
- * @returns Mean value of the list of parameter values
- */
-double Calibration::listMin(QList<double> list)
-{
-    double min = list[0];
-    for(int i = 0; i < list.size(); i++)
-        min = qMin(min, list[i]);
-    return min;
-}
-
-/**
- * Utility function which calculates the Mean value of a list of values
- * @param list list of double values
- * @returns Mean value of the list of parameter values
+ * Utility function which clears the statistics of all three axes of a sensor
+ * @param stats the statistics of the x, y and z axes
  */
-double Calibration::listMax(QList<double> list)
+void Calibration::clearStats(RunningStats stats[3])
 {
-    double max = list[0];
-    for(int i = 0; i < list.size(); i++)
-        max = qMax(max, list[i]);
-    return max;
+    for (int i = 0; i < 3; i++)
+        stats[i].clear();
 }
 
 /**
@@ -29,6 +29,7 @@
 #include <extensionsystem/pluginmanager.h>
 #include <uavobject.h>
 #include <tempcompcurve.h>
+#include "calibrationfit.h"
 
 #include <QObject>
 #include <QTimer>
@@ -138,6 +139,9 @@ signals:
     //! Indicate what the progress is for six point collection
     void sixPointProgressChanged(int);
 
+    //! Indicate the RMS error of the magnetometer ellipsoid fit so far, negative if there is no fit yet
+    void sixPointFitChanged(double error);
+
     //! Show an instruction or message from temperature calibration
     void showTempCalMessage(QString message);
 
@@ -186,16 +190,22 @@ private:
     //! List of optimized metadata rates
     QMap<QString, UAVObject::Metadata> slowedDownMetaDataList;
 
+    RunningStats gyro_stats[3];
+    RunningStats gyro_temp_stats;
+    RunningStats accel_stats[3];
+    RunningStats mag_stats[3];
+
+    //! Raw temperature calibration samples, only kept to plot them
     QList<double> gyro_accum_x;
     QList<double> gyro_accum_y;
     QList<double> gyro_accum_z;
     QList<double> gyro_accum_temp;
-    QList<double> accel_accum_x;
-    QList<double> accel_accum_y;
-    QList<double> accel_accum_z;
-    QList<double> mag_accum_x;
-    QList<double> mag_accum_y;
-    QList<double> mag_accum_z;
+
+    //! Fit of the gyro bias over temperature, updated with every sample
+    CubicFit tempFit;
+
+    //! Fit of the magnetometer ellipsoid over all six point samples
+    EllipsoidFit magFit;
 
     double gyro_data_x[6], gyro_data_y[6], gyro_data_z[6];
     double accel_data_x[6], accel_data_y[6], accel_data_z[6];
@@ -245,18 +255,12 @@ protected:
     //! Compute a rotation matrix from a set of euler angles
     void Euler2R(double rpy[3], double Rbe[3][3]);
 
-    //! Compute the mean value of a list
-    static double listMean(QList<double> list);
-
-    //! Compute the min value of a list
-    static double listMin(QList<double> list);
-
-    //! Compute the max value of a list
-    static double listMax(QList<double> list);
-
     //! Reset sensor settings to pre-calibration values
     void resetSensorCalibrationToOriginalValues();
 
+    //! Clear the statistics of a three axis sensor
+    static void clearStats(RunningStats stats[3]);
+
     //! Store a sample for temperature compensation
     bool storeTempCalMeasurement(UAVObject *obj);
 
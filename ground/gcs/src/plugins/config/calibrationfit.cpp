@@ -0,0 +1,137 @@
+/**
+ ******************************************************************************
+ *
+ * @file       calibrationfit.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Streaming statistics and least squares fits for calibration
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "calibrationfit.h"
+
+#include <Eigen/Core>
+#include <Eigen/Cholesky>
+#include <cmath>
+#include <cstring>
+
+void EllipsoidFit::clear()
+{
+    n = 0;
+    memset(ata, 0, sizeof(ata));
+    memset(atb, 0, sizeof(atb));
+}
+
+/**
+ * Add a sample to the fit of a x^2 + b y^2 + c z^2 + d x + e y + f z = 1
+ */
+void EllipsoidFit::add(double x, double y, double z)
+{
+    const double phi[NUM_PARAMS] = { x * x, y * y, z * z, x, y, z };
+
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        for (int j = i; j < NUM_PARAMS; j++)
+            ata[i][j] += phi[i] * phi[j];
+        atb[i] += phi[i];
+    }
+    n++;
+}
+
+bool EllipsoidFit::solve(double bias[3], double radius[3], double *error) const
+{
+    if (n < NUM_PARAMS)
+        return false;
+
+    Eigen::Matrix<double, NUM_PARAMS, NUM_PARAMS> A;
+    Eigen::Matrix<double, NUM_PARAMS, 1> b;
+    for (int i = 0; i < NUM_PARAMS; i++) {
+        for (int j = i; j < NUM_PARAMS; j++)
+            A(i, j) = A(j, i) = ata[i][j];
+        b(i) = atb[i];
+    }
+
+    Eigen::Matrix<double, NUM_PARAMS, 1> p;
+    if (!A.ldlt().solve(b, &p))
+        return false;
+
+    // Complete the squares: a (x - x0)^2 + b (y - y0)^2 + c (z - z0)^2 = g
+    double g = 1;
+    for (int i = 0; i < 3; i++) {
+        // Also rejects NaN from a degenerate set of samples
+        if (!(p(i) > 0))
+            return false;
+        bias[i] = -p(i + 3) / (2 * p(i));
+        g += p(i) * bias[i] * bias[i];
+    }
+    for (int i = 0; i < 3; i++)
+        radius[i] = sqrt(g / p(i));
+
+    if (error) {
+        // Sum of the squared residuals straight from the normal equations,
+        // the residual is about twice the relative distance to the surface
+        double ss = p.dot(A * p) - 2 * p.dot(b) + n;
+        *error = ss > 0 ? sqrt(ss / n) / 2 : 0;
+    }
+
+    return true;
+}
+
+void CubicFit::clear()
+{
+    n = 0;
+    memset(xtx, 0, sizeof(xtx));
+    memset(xty, 0, sizeof(xty));
+}
+
+void CubicFit::add(double t, double x, double y, double z)
+{
+    const double phi[4] = { 1, t, t * t, t * t * t };
+    const double out[3] = { x, y, z };
+
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++)
+            xtx[i][j] += phi[i] * phi[j];
+        for (int k = 0; k < 3; k++)
+            xty[i][k] += phi[i] * out[k];
+    }
+    n++;
+}
+
+bool CubicFit::solve(double coeffs[3][4]) const
+{
+    if (n < 4)
+        return false;
+
+    Eigen::Matrix<double, 4, 4> XtX;
+    Eigen::Matrix<double, 4, 3> XtY;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++)
+            XtX(i, j) = xtx[i][j];
+        for (int k = 0; k < 3; k++)
+            XtY(i, k) = xty[i][k];
+    }
+
+    // Use the cholesky-based Penrose pseudoinverse method.
+    Eigen::Matrix<double, 4, 3> result;
+    if (!XtX.ldlt().solve(XtY, &result))
+        return false;
+
+    for (int k = 0; k < 3; k++)
+        for (int i = 0; i < 4; i++)
+            coeffs[k][i] = result(i, k);
+
+    return true;
+}
@@ -0,0 +1,119 @@
+/**
+ ******************************************************************************
+ *
+ * @file       calibrationfit.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Streaming statistics and least squares fits for calibration
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef CALIBRATIONFIT_H
+#define CALIBRATIONFIT_H
+
+/**
+ * @brief Mean, variance and range of a stream of samples in constant memory.
+ * Uses Welford's update so the variance stays accurate over long runs.
+ */
+class RunningStats
+{
+public:
+    RunningStats() { clear(); }
+
+    void clear() { n = 0; m = 0; s = 0; lo = 0; hi = 0; }
+
+    void add(double x)
+    {
+        n++;
+        double d = x - m;
+        m += d / n;
+        s += d * (x - m);
+        if (n == 1 || x < lo)
+            lo = x;
+        if (n == 1 || x > hi)
+            hi = x;
+    }
+
+    int count() const { return n; }
+    double mean() const { return m; }
+    double variance() const { return n > 1 ? s / (n - 1) : 0; }
+    double min() const { return lo; }
+    double max() const { return hi; }
+
+private:
+    int n;
+    double m;
+    double s;
+    double lo;
+    double hi;
+};
+
+/**
+ * @brief Least squares fit of an axis aligned ellipsoid to a stream of 3D
+ * samples, for a sensor measuring a constant field.  Only the normal
+ * equations are kept, so the fit can be solved after every sample.
+ */
+class EllipsoidFit
+{
+public:
+    EllipsoidFit() { clear(); }
+
+    void clear();
+    void add(double x, double y, double z);
+    int count() const { return n; }
+
+    /**
+     * @brief Solve the fit
+     * @param[out] bias center of the ellipsoid
+     * @param[out] radius radius of the ellipsoid along each axis
+     * @param[out] error RMS relative distance of the samples to the ellipsoid, may be NULL
+     * @return false if there are not enough samples or they do not describe an ellipsoid
+     */
+    bool solve(double bias[3], double radius[3], double *error = 0) const;
+
+private:
+    static const int NUM_PARAMS = 6;
+    int n;
+    double ata[NUM_PARAMS][NUM_PARAMS];
+    double atb[NUM_PARAMS];
+};
+
+/**
+ * @brief Least squares fit of a cubic in one input for three outputs at once,
+ * as used for the temperature compensation of the gyros.
+ */
+class CubicFit
+{
+public:
+    CubicFit() { clear(); }
+
+    void clear();
+    void add(double t, double x, double y, double z);
+    int count() const { return n; }
+
+    /**
+     * @brief Solve the fit
+     * @param[out] coeffs the coefficients of each output, constant term first
+     * @return false if there are not enough samples
+     */
+    bool solve(double coeffs[3][4]) const;
+
+private:
+    int n;
+    double xtx[4][4];
+    double xty[4][3];
+};
+
+#endif // CALIBRATIONFIT_H
@@ -3,7 +3,7 @@ TARGET = Config
 DEFINES += CONFIG_LIBRARY
 DEFINES += QWT_DLL
 
-QT += svg
+QT += svg concurrent
 
 include(config_dependencies.pri)
 LIBS *= -l$$qtLibraryName(Qwt)
@@ -14,6 +14,7 @@ OTHER_FILES += Config.pluginspec \
     Config.json
 
 HEADERS += calibration.h \
+    calibrationfit.h \
     configplugin.h \
     configgadgetconfiguration.h \
     configgadgetwidget.h \
@@ -40,6 +41,8 @@ HEADERS += calibration.h \
     mixercurve.h \
     dblspindelegate.h \
     configautotunewidget.h \
+    autotunelogfit.h \
+    autotunemodel.h \
     hwfieldselector.h \
     tempcompcurve.h \
     textbubbleslider.h \
@@ -49,6 +52,7 @@ HEADERS += calibration.h \
     expocurve.h
 
 SOURCES += calibration.cpp \
+    calibrationfit.cpp \
     configplugin.cpp \
     configgadgetconfiguration.cpp \
     configgadgetwidget.cpp \
@@ -73,6 +77,8 @@ SOURCES += calibration.cpp \
     mixercurve.cpp \
     dblspindelegate.cpp \
     configautotunewidget.cpp \
+    autotunelogfit.cpp \
+    autotunemodel.cpp \
     hwfieldselector.cpp \
     tempcompcurve.cpp \
     textbubbleslider.cpp \
@@ -150,6 +150,7 @@ ConfigAttitudeWidget::ConfigAttitudeWidget(QWidget *parent) :
     connect(&calibration, SIGNAL(showTempCalMessage(QString)), m_ui->tempCalMessage, SLOT(setText(QString)));
     connect(&calibration, SIGNAL(sixPointProgressChanged(int)), m_ui->sixPointProgress, SLOT(setValue(int)));
     connect(&calibration, SIGNAL(showSixPointMessage(QString)), m_ui->sixPointCalibInstructions, SLOT(setText(QString)));
+    connect(&calibration, SIGNAL(sixPointFitChanged(double)), this, SLOT(sixPointFitChanged(double)));
     connect(&calibration, SIGNAL(updatePlane(int)), this, SLOT(displayPlane(int)));
 
     // Let the calibration gadget control some control enables
@@ -198,6 +199,18 @@ void ConfigAttitudeWidget::resizeEvent(QResizeEvent *event)
     m_ui->sixPointHelp->fitInView(paperplane,Qt::KeepAspectRatio);
 }
 
+/**
+  Show the magnetometer ellipsoid fit error next to the six point progress, so
+  a poor fit from nearby iron is visible before all positions are collected
+  */
+void ConfigAttitudeWidget::sixPointFitChanged(double error)
+{
+    if (error < 0)
+        m_ui->sixPointProgress->setFormat("%p%");
+    else
+        m_ui->sixPointProgress->setFormat(tr("%p% (field fit error %1%)").arg(error * 100, 0, 'f', 1));
+}
+
 /**
   Rotate the paper plane
   */
@@ -82,6 +82,9 @@ private slots:
     //! Display the plane in various positions
     void displayPlane(int i);
 
+    //! Show the quality of the magnetometer fit with the six point progress
+    void sixPointFitChanged(double error);
+
     // Slots for measuring the sensor noise
     void do_SetDirty();
     void configureSixPoint();
@@ -11,6 +11,10 @@
 #include <QDesktopServices>
 #include <QUrl>
 #include <QList>
+#include <QApplication>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
 #include "systemident.h"
 #include "stabilizationsettings.h"
 #include "modulesettings.h"
@@ -23,7 +27,8 @@
 #define FORUM_SHARING_THREAD    268
 
 ConfigAutotuneWidget::ConfigAutotuneWidget(QWidget *parent) :
-    ConfigTaskWidget(parent)
+    ConfigTaskWidget(parent),
+    useLogFit(false)
 {
     m_autotune = new Ui_AutotuneWidget();
     m_autotune->setupUi(this);
@@ -45,13 +50,15 @@ ConfigAutotuneWidget::ConfigAutotuneWidget(QWidget *parent) :
 
     addWidget(m_autotune->enableAutoTune);
 
-    connect(systemIdent, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(recomputeStabilization()));
+    connect(systemIdent, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(onSystemIdentUpdated()));
 
     // Connect the apply button for the stabilization settings
     connect(m_autotune->useComputedValues, SIGNAL(pressed()), this, SLOT(saveStabilization()));
 
     connect(m_autotune->shareDataPB, SIGNAL(pressed()),this, SLOT(onShareData()));
 
+    connect(m_autotune->tuneFromLog, SIGNAL(pressed()), this, SLOT(onTuneFromLog()));
+
     setNotMandatory(systemIdent->getName());
 }
 
@@ -67,11 +74,7 @@ void ConfigAutotuneWidget::saveStabilization()
 
     // Check the settings are reasonable, or if not have the
     // user confirm they want to continue.
-    SystemIdent *systemIdent = SystemIdent::GetInstance(getObjectManager());
-    Q_ASSERT(systemIdent);
-    if(!systemIdent)
-        return;
-    if (approveSettings(systemIdent->getData()) == false)
+    if (approveSettings(identData()) == false)
         return;
 
     // Make sure to recompute in case the other stab settings changed since
@@ -83,6 +86,91 @@ void ConfigAutotuneWidget::saveStabilization()
     stabilizationSettings->updated();
 }
 
+/**
+ * @brief ConfigAutotuneWidget::identData
+ * @return the values the gains are computed from, those of the log when one
+ * was fitted
+ */
+SystemIdent::DataFields ConfigAutotuneWidget::identData()
+{
+    SystemIdent *systemIdent = SystemIdent::GetInstance(getObjectManager());
+    Q_ASSERT(systemIdent);
+    SystemIdent::DataFields data = systemIdent->getData();
+
+    if (useLogFit) {
+        data.Beta[SystemIdent::BETA_ROLL] = logModels[0].beta;
+        data.Beta[SystemIdent::BETA_PITCH] = logModels[1].beta;
+
+        // Like the filter on the board, one time constant for both axes,
+        // the slowest
+        data.Tau = log(qMax(logModels[0].tau, logModels[1].tau));
+    }
+
+    return data;
+}
+
+/**
+ * Fit roll and pitch to the blackbox frames of a log, the gains are then
+ * computed from the fit until the board sends new SystemIdent values
+ */
+void ConfigAutotuneWidget::onTuneFromLog()
+{
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open a log of an autotune flight"),
+                                                    QString(), tr("Tau Labs Log (*.tll)"));
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, tr("Tune from log"), tr("Unable to open %0").arg(fileName));
+        return;
+    }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    AutotuneLogFit fit;
+    bool loaded = fit.load(file.readAll());
+    AutotuneLogFit::Model models[2];
+    for (int i = 0; loaded && i < 2; i++)
+        models[i] = fit.identify(i);
+    QApplication::restoreOverrideCursor();
+
+    if (!loaded) {
+        QMessageBox::warning(this, tr("Tune from log"),
+                             tr("The log has too few BlackboxFrame updates. Enable the blackbox "
+                                "in the logging settings before the autotune flight."));
+        return;
+    }
+
+    if (!models[0].valid || !models[1].valid) {
+        QMessageBox::warning(this, tr("Tune from log"),
+                             tr("Roll and pitch were not excited enough in this log to fit their response."));
+        return;
+    }
+
+    logFit = fit;
+    logModels[0] = models[0];
+    logModels[1] = models[1];
+    useLogFit = true;
+
+    m_autotune->logFitStatus->setText(
+                tr("%0: delay %1 / %2 ms, fit error %3 / %4 %")
+                .arg(QFileInfo(fileName).fileName())
+                .arg(models[0].delay * 1000, 0, 'f', 1).arg(models[1].delay * 1000, 0, 'f', 1)
+                .arg(models[0].fitError * 100, 0, 'f', 1).arg(models[1].fitError * 100, 0, 'f', 1));
+
+    recomputeStabilization();
+}
+
+/**
+ * New values from the board replace those of a log
+ */
+void ConfigAutotuneWidget::onSystemIdentUpdated()
+{
+    useLogFit = false;
+    m_autotune->logFitStatus->clear();
+    recomputeStabilization();
+}
+
 void ConfigAutotuneWidget::onShareData()
 {
     forumInteractionForm = new Utils::ForumInteractionForm(this);
@@ -257,17 +345,12 @@ bool ConfigAutotuneWidget::approveSettings(
   */
 void ConfigAutotuneWidget::recomputeStabilization()
 {
-    SystemIdent *systemIdent = SystemIdent::GetInstance(getObjectManager());
-    Q_ASSERT(systemIdent);
-    if(!systemIdent)
-        return;
-
     StabilizationSettings *stabilizationSettings = StabilizationSettings::GetInstance(getObjectManager());
     Q_ASSERT(stabilizationSettings);
     if(!stabilizationSettings)
         return;
 
-    SystemIdent::DataFields systemIdentData = systemIdent->getData();
+    SystemIdent::DataFields systemIdentData = identData();
     stabSettings = stabilizationSettings->getData();
 
     // These three parameters define the desired response properties
@@ -311,6 +394,8 @@ void ConfigAutotuneWidget::recomputeStabilization()
     const double zeta_o = 1.3;
     const double kp_o = 1 / 4.0 / (zeta_o * zeta_o) / (1/wn);
 
+    stabSettings.DerivativeCutoff = 1 / (2*M_PI*tau_d);
+
     // For now just run over roll and pitch
     for (int i = 0; i < 2; i++) {
         double beta = exp(systemIdentData.Beta[i]);
@@ -319,6 +404,17 @@ void ConfigAutotuneWidget::recomputeStabilization()
         double kp = tau * tau_d * ((a+b)*wn*wn + 2*a*b*damp*wn) / beta - ki*tau_d;
         double kd = (tau * tau_d * (a*b + wn*wn + (a+b)*2*damp*wn) - 1) / beta - kp * tau_d;
 
+        // The model of the log has the delay as well, the gains are
+        // adjusted to get the response above in spite of it
+        if (useLogFit) {
+            AutotuneLogFit::Gains gains = { kp, ki, kd };
+            gains = AutotuneLogFit::refine(logModels[i], logFit.sampleTime(), gains,
+                                           stabSettings.DerivativeCutoff, stabSettings.DerivativeGamma, wn);
+            kp = gains.kp;
+            ki = gains.ki;
+            kd = gains.kd;
+        }
+
         switch(i) {
         case 0: // Roll
             stabSettings.RollRatePID[StabilizationSettings::ROLLRATEPID_KP] = kp;
@@ -336,7 +432,6 @@ void ConfigAutotuneWidget::recomputeStabilization()
             break;
         }
     }
-    stabSettings.DerivativeCutoff = 1 / (2*M_PI*tau_d);
 
     // Display these computed settings
     m_autotune->rollRateKp->setText(QString::number(stabSettings.RollRatePID[StabilizationSettings::ROLLRATEPID_KP]));
@@ -348,8 +443,8 @@ void ConfigAutotuneWidget::recomputeStabilization()
     m_autotune->lblOuterKp->setText(QString::number(stabSettings.RollPI[StabilizationSettings::ROLLPI_KP]));
 
     m_autotune->derivativeCutoff->setText(QString::number(stabSettings.DerivativeCutoff));
-    m_autotune->rollTau->setText(QString::number(tau,'g',3));
-    m_autotune->pitchTau->setText(QString::number(tau,'g',3));
+    m_autotune->rollTau->setText(QString::number(useLogFit ? logModels[0].tau : tau,'g',3));
+    m_autotune->pitchTau->setText(QString::number(useLogFit ? logModels[1].tau : tau,'g',3));
     m_autotune->wn->setText(QString::number(wn / 2 / M_PI, 'f', 1));
     m_autotune->lblDamp->setText(QString::number(damp, 'g', 2));
     m_autotune->lblNoise->setText(QString::number(ghf * 100, 'g', 2) + " %");
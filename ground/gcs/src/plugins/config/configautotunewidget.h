@@ -34,6 +34,7 @@
 #include "uavobject.h"
 #include "stabilizationsettings.h"
 #include "systemident.h"
+#include "autotunelogfit.h"
 #include <QWidget>
 #include <QTimer>
 #include "utils/foruminteractionform.h"
@@ -49,6 +50,12 @@ private:
     StabilizationSettings::DataFields stabSettings;
     UAVObjectUtilManager* utilMngr;
 
+    //! Models fitted to a log, used instead of SystemIdent while set
+    bool useLogFit;
+    AutotuneLogFit logFit;
+    AutotuneLogFit::Model logModels[2];
+
+    SystemIdent::DataFields identData();
     bool approveSettings(SystemIdent::DataFields systemIdentData);
     Utils::ForumInteractionForm *forumInteractionForm;
 signals:
@@ -60,6 +67,8 @@ private slots:
     void recomputeStabilization();
     void saveStabilization();
     void onShareData();
+    void onTuneFromLog();
+    void onSystemIdentUpdated();
     void onForumInteractionSet(int value);
 };
 
@@ -74,57 +74,60 @@ ConfigGadgetWidget::ConfigGadgetWidget(QWidget *parent) : QWidget(parent)
     icon = new QIcon();
     icon->addFile(":/configgadget/images/vehicle_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/vehicle_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigVehicleTypeWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::aircraft, qwd, *icon, QString("Vehicle"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/input_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/input_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigInputWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::input, qwd, *icon, QString("Input"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/output_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/output_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigOutputWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::output, qwd, *icon, QString("Output"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/ins_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/ins_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigAttitudeWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::sensors, qwd, *icon, QString("Attitude"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/stabilization_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/stabilization_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigStabilizationWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::stabilization, qwd, *icon, QString("Stabilization"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/modules_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/modules_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigModuleWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::modules, qwd, *icon, QString("Modules"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/autotune_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/autotune_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigAutotuneWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::autotune, qwd, *icon, QString("Autotune"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/camstab_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/camstab_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigCameraStabilizationWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::camerastabilization, qwd, *icon, QString("Camera Stab"));
 
     icon = new QIcon();
     icon->addFile(":/configgadget/images/txpid_normal.png", QSize(), QIcon::Normal, QIcon::Off);
     icon->addFile(":/configgadget/images/txpid_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigTxPIDWidget(this);
+    qwd = new QWidget(this);
     ftw->insertTab(ConfigGadgetWidget::txpid, qwd, *icon, QString("TxPID"));
 
+    // Only the hardware tab is built now, the others are built when first shown
+    loadedTabs.insert(ConfigGadgetWidget::hardware);
+
     ftw->setCurrentIndex(ConfigGadgetWidget::hardware);
     // *********************
     // Listen to autopilot connection events
@@ -148,8 +151,65 @@ ConfigGadgetWidget::~ConfigGadgetWidget()
     // TODO: properly delete all the tabs in ftw before exiting
 }
 
+/**
+ * Create the configuration widget of a tab
+ * @param index the tab, one of @ref widgetTabs
+ * @return the widget or NULL for the tabs that are not built here
+ */
+QWidget *ConfigGadgetWidget::createTab(int index)
+{
+    switch (index) {
+    case aircraft:
+        return new ConfigVehicleTypeWidget(this);
+    case input:
+        return new ConfigInputWidget(this);
+    case output:
+        return new ConfigOutputWidget(this);
+    case sensors:
+        return new ConfigAttitudeWidget(this);
+    case stabilization:
+        return new ConfigStabilizationWidget(this);
+    case modules:
+        return new ConfigModuleWidget(this);
+    case autotune:
+        return new ConfigAutotuneWidget(this);
+    case camerastabilization:
+        return new ConfigCameraStabilizationWidget(this);
+    case txpid:
+        return new ConfigTxPIDWidget(this);
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * Build the widget of a tab the first time it is needed. Building all the
+ * tabs up front binds hundreds of fields that nobody may look at, and they
+ * all refresh when the settings arrive after connecting.
+ * @param index the tab, one of @ref widgetTabs
+ */
+void ConfigGadgetWidget::loadTab(int index)
+{
+    if (loadedTabs.contains(index))
+        return;
+
+    QWidget *qwd = createTab(index);
+    if (qwd == NULL)
+        return;
+    loadedTabs.insert(index);
+    ftw->replaceTab(index, qwd);
+
+    // The widget missed the connection, bring it up to date with the board
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    TelemetryManager* telMngr = pm->getObject<TelemetryManager>();
+    ConfigTaskWidget *wid = qobject_cast<ConfigTaskWidget *>(qwd);
+    if (wid && telMngr->isConnected())
+        wid->onAutopilotConnect();
+}
+
 void ConfigGadgetWidget::startInputWizard()
 {
+    loadTab(ConfigGadgetWidget::input);
     ftw->setCurrentIndex(ConfigGadgetWidget::input);
     ConfigInputWidget* inputWidget = dynamic_cast<ConfigInputWidget*>(ftw->getWidget(ConfigGadgetWidget::input));
     Q_ASSERT(inputWidget);
@@ -213,23 +273,22 @@ void ConfigGadgetWidget::onAutopilotConnect() {
         ftw->setCurrentIndex(ConfigGadgetWidget::hardware);
     }
 
-    //! Remove and recreate the attitude widget to refresh board capabilities
-    ftw->removeTab(ConfigGadgetWidget::sensors);
-    icon = new QIcon();
-    icon->addFile(":/configgadget/images/ins_normal.png", QSize(), QIcon::Normal, QIcon::Off);
-    icon->addFile(":/configgadget/images/ins_selected.png", QSize(), QIcon::Selected, QIcon::Off);
-    qwd = new ConfigAttitudeWidget(this);
-    ftw->insertTab(ConfigGadgetWidget::sensors, qwd, *icon, QString("Attitude"));
+    //! Recreate the attitude widget to refresh board capabilities, next time it is shown
+    if (loadedTabs.remove(ConfigGadgetWidget::sensors)) {
+        ftw->replaceTab(ConfigGadgetWidget::sensors, new QWidget(this));
+        if (ftw->currentIndex() == ConfigGadgetWidget::sensors)
+            loadTab(ConfigGadgetWidget::sensors);
+    }
 
     emit autopilotConnected();
 }
 
 void ConfigGadgetWidget::tabAboutToChange(int i, bool * proceed)
 {
-    Q_UNUSED(i);
     *proceed = true;
     ConfigTaskWidget * wid = qobject_cast<ConfigTaskWidget *>(ftw->currentWidget());
     if(!wid) {
+        loadTab(i);
         return;
     }
 
@@ -247,4 +306,7 @@ void ConfigGadgetWidget::tabAboutToChange(int i, bool * proceed)
             wid->setDirty(false);
         }
     }
+
+    if(*proceed)
+        loadTab(i);
 }
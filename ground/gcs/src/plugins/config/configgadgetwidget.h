@@ -34,6 +34,7 @@
 #include "objectpersistence.h"
 #include <QWidget>
 #include <QList>
+#include <QSet>
 #include <QTextBrowser>
 #include "utils/pathutils.h"
 #include <QMessageBox>
@@ -63,6 +64,12 @@ signals:
 protected:
         void resizeEvent(QResizeEvent * event);
         MyTabbedStackWidget *ftw;
+
+private:
+        QWidget *createTab(int index);
+        void loadTab(int index);
+        //! Tabs whose widget has been built, the others hold a placeholder
+        QSet<int> loadedTabs;
 };
 
 #endif // CONFIGGADGETWIDGET_H
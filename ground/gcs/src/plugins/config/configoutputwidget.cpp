@@ -528,7 +528,12 @@ void ConfigOutputWidget::refreshWidgetRanges()
                 if (timerRes == ActuatorSettings::TIMERPWMRESOLUTION_12MHZ)
                     timerPeriodUs = timerPeriodUs / 12;
 
-                if (timerFreq != 0)
+                if (timerRes == ActuatorSettings::TIMERPWMRESOLUTION_DSHOT150 ||
+                        timerRes == ActuatorSettings::TIMERPWMRESOLUTION_DSHOT300 ||
+                        timerRes == ActuatorSettings::TIMERPWMRESOLUTION_DSHOT600) {
+                    // Digital ESCs take a throttle value instead of a pulse width
+                    maxPulseWidth = 2047;
+                } else if (timerFreq != 0)
                 {
                     maxPulseWidth = 1000000 / timerFreq;
 
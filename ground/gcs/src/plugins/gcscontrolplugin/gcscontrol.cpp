@@ -35,13 +35,17 @@
 #define CHANNEL_MAX     2000
 #define CHANNEL_NEUTRAL 1500
 #define CHANNEL_MIN     1000
+
+// The flight side fails safe when no new frame arrives for PIOS_GCSRCVR_TIMEOUT_MS
+#define STREAM_PERIOD_MS 20
 bool GCSControl::firstInstance = true;
 
-GCSControl::GCSControl():hasControl(false)
+GCSControl::GCSControl():telMngr(NULL), sequence(0), hasControl(false)
 {
     Q_ASSERT(firstInstance);//There should only be one instance of this class
     firstInstance = false;
-    receiverActivity.setInterval(100);
+    receiverActivity.setInterval(STREAM_PERIOD_MS);
+    receiverActivity.setTimerType(Qt::PreciseTimer);
     connect(&receiverActivity,SIGNAL(timeout()),this,SLOT(receiverActivitySlot()));
 }
 
@@ -56,6 +60,9 @@ void GCSControl::extensionsInitialized()
 
     m_gcsReceiver = GCSReceiver::GetInstance(objMngr);
     Q_ASSERT(m_gcsReceiver);
+
+    telMngr = pm->getObject<TelemetryManager>();
+    Q_ASSERT(telMngr);
 }
 
 GCSControl::~GCSControl()
@@ -142,6 +149,7 @@ bool GCSControl::beginGCSControl()
     hasControl = true;
     for(quint8 x = 0; x < GCSReceiver::CHANNEL_NUMELEM; ++x)
         setChannel(x,0);
+    receiverActivitySlot();
     receiverActivity.start();
     return true;
 }
@@ -169,7 +177,6 @@ bool GCSControl::setFlightMode(ManualControlSettings::FlightModePositionOptions
     manControlSettingsUAVO->setFlightModePosition(0,flightMode);
     manControlSettingsUAVO->updated();
     m_gcsReceiver->setChannel(ManualControlSettings::CHANNELGROUPS_FLIGHTMODE,CHANNEL_MIN);
-    m_gcsReceiver->updated();
     return true;
 }
 
@@ -202,8 +209,8 @@ bool GCSControl::setChannel(quint8 channel, float value)
         pwmValue = (value * (float)(CHANNEL_MAX - CHANNEL_NEUTRAL)) + (float)CHANNEL_NEUTRAL;
     else
         pwmValue = (value * (float)(CHANNEL_NEUTRAL - CHANNEL_MIN)) + (float)CHANNEL_NEUTRAL;
+    // Goes out with the next frame of the stream
     m_gcsReceiver->setChannel(channel,pwmValue);
-    m_gcsReceiver->updated();
     return true;
 }
 
@@ -212,8 +219,19 @@ void GCSControl::objectsUpdated(UAVObject *obj)
     qDebug()<< "GCSControl::objectsUpdated" <<"Object"<<obj->getName()<<"changed outside this class";
 }
 
+/**
+ * @brief GCSControl::receiverActivitySlot Sends the next frame of the control stream.
+ * The frames are unacked and skip the telemetry queue, so a burst of settings
+ * traffic does not delay them. The flight side drops frames that arrive out of
+ * order by their sequence number, zero is left for senders that do not count.
+ */
 void GCSControl::receiverActivitySlot()
 {
-    if(m_gcsReceiver)
-        m_gcsReceiver->updated();
+    if(!m_gcsReceiver || !telMngr)
+        return;
+
+    if(++sequence == 0)
+        sequence = 1;
+    m_gcsReceiver->setSequence(sequence);
+    telMngr->streamObject(m_gcsReceiver);
 }
@@ -33,6 +33,7 @@
 #include "manualcontrolsettings.h"
 #include "uavobjectmanager.h"
 #include "gcsreceiver.h"
+#include "uavtalk/telemetrymanager.h"
 #include "extensionsystem/pluginmanager.h"
 #include "QTimer"
 #include "gcscontrolgadgetfactory.h"
@@ -63,11 +64,13 @@ public slots:
 private:
     ManualControlSettings *manControlSettingsUAVO;
     GCSReceiver *m_gcsReceiver;
+    TelemetryManager *telMngr;
+    quint8 sequence;
     static bool firstInstance;
     ManualControlSettings::DataFields dataBackup;
     ManualControlSettings::Metadata metaBackup;
     bool hasControl;
-    QTimer receiverActivity;
+    QTimer receiverActivity;   //!< Streams the GCSReceiver frames at a fixed rate
 
     GCSControlGadgetFactory *mf;
 private slots:
@@ -4,6 +4,7 @@ TEMPLATE = lib
 include(../../taulabsgcsplugin.pri)
 include(../../plugins/coreplugin/coreplugin.pri)
 include(../../plugins/uavobjectutil/uavobjectutil.pri)
+include(../../plugins/uavtalk/uavtalk.pri)
 
 DEFINES += GCSCONTROL_LIBRARY
 
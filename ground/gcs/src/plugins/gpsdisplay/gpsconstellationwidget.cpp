@@ -63,12 +63,17 @@ GpsConstellationWidget::GpsConstellationWidget(QWidget *parent) : QGraphicsView(
     scene->setSceneRect(world->boundingRect());
     setScene(scene);
 
+    redrawTimer.setSingleShot(true);
+    redrawTimer.setInterval(REDRAW_PERIOD_MS);
+    connect(&redrawTimer, SIGNAL(timeout()), this, SLOT(redrawSats()));
+
     // Now create 'maxSatellites' satellite icons which we will move around on the map:
     for (int i = 0; i < MAX_SATELLITES; i++) {
         satellites[i][0] = 0;
         satellites[i][1] = 0;
         satellites[i][2] = 0;
         satellites[i][3] = 0;
+        dirty[i] = false;
 
         satIcons[i] = new QGraphicsSvgItem(world);
         satIcons[i]->setSharedRenderer(renderer);
@@ -97,6 +102,7 @@ void GpsConstellationWidget::showEvent(QShowEvent *event)
     // widget is shown, otherwise it cannot compute its values and
     // the result is usually a ahrsbargraph that is way too small.
     fitInView(world, Qt::KeepAspectRatio);
+    redrawSats();
     // Scale, can't use fitInView since that doesn't work until we're shown.
  //   qreal factor = height()/world->boundingRect().height();
 //    world->setScale(factor);
@@ -112,17 +118,52 @@ void GpsConstellationWidget::resizeEvent(QResizeEvent* event)
 
 void GpsConstellationWidget::updateSat(int index, int prn, int elevation, int azimuth, int snr)
 {
-    if (index >= MAX_SATELLITES) {
+    if (index < 0 || index >= MAX_SATELLITES) {
         // A bit of error checking never hurts.
         return;
     }
 
+    if (satellites[index][0] == prn && satellites[index][1] == elevation &&
+        satellites[index][2] == azimuth && satellites[index][3] == snr) {
+        return;
+    }
+
     // TODO: add range checking
     satellites[index][0] = prn;
     satellites[index][1] = elevation;
     satellites[index][2] = azimuth;
     satellites[index][3] = snr;
 
+    // The parsers send every satellite on each update, so only note the
+    // change here and draw all of them together on the next tick
+    dirty[index] = true;
+    if (!redrawTimer.isActive()) {
+        redrawTimer.start();
+    }
+}
+
+void GpsConstellationWidget::redrawSats()
+{
+    // Hidden changes are drawn by showEvent
+    if (!isVisible()) {
+        return;
+    }
+
+    for (int index = 0; index < MAX_SATELLITES; index++) {
+        if (dirty[index]) {
+            drawSat(index);
+            dirty[index] = false;
+        }
+    }
+}
+
+void GpsConstellationWidget::drawSat(int index)
+{
+    const int prn = satellites[index][0];
+    const int elevation = satellites[index][1];
+    const int azimuth = satellites[index][2];
+    const int snr = satellites[index][3];
+
     if (prn && elevation >= 0) {
         QPointF opd = polarToCoord(elevation,azimuth);
         opd += QPointF(-satIcons[index]->boundingRect().center().x(),
@@ -29,6 +29,7 @@
 #define GPSCONSTELLATIONWIDGET_H_
 
 #include <QGraphicsView>
+#include <QTimer>
 #include <QtSvg/QSvgRenderer>
 #include <QtSvg/QGraphicsSvgItem>
 
@@ -46,10 +47,15 @@ public slots:
 
 
 private slots:
+   void redrawSats();
 
 private:
    static const int MAX_SATELLITES = 32;
+   //! Satellite updates are drawn together at most this often
+   static const int REDRAW_PERIOD_MS = 200;
    int satellites[MAX_SATELLITES][4];
+   bool dirty[MAX_SATELLITES];
+   QTimer redrawTimer;
    QGraphicsScene *scene;
    QSvgRenderer *renderer;
    QGraphicsSvgItem* world;
@@ -57,6 +63,7 @@ private:
    QGraphicsSimpleTextItem* satTexts[MAX_SATELLITES];
 
    QPointF polarToCoord(int elevation, int azimuth);
+   void drawSat(int index);
 
 protected:
     void showEvent(QShowEvent *event);
@@ -6,12 +6,17 @@ GpsSnrWidget::GpsSnrWidget(QWidget *parent) :
     scene = new QGraphicsScene(this);
     setScene(scene);
 
+    redrawTimer.setSingleShot(true);
+    redrawTimer.setInterval(REDRAW_PERIOD_MS);
+    connect(&redrawTimer, SIGNAL(timeout()), this, SLOT(redrawSats()));
+
     // Now create 'maxSatellites' satellite icons which we will move around on the map:
     for (int i = 0; i < MAX_SATELLITES; i++) {
         satellites[i][0] = 0;
         satellites[i][1] = 0;
         satellites[i][2] = 0;
         satellites[i][3] = 0;
+        dirty[i] = false;
 
         boxes[i] = new QGraphicsRectItem();
         boxes[i]->setBrush(QColor("Green"));
@@ -40,6 +45,7 @@ void GpsSnrWidget::showEvent(QShowEvent *event) {
     scene->setSceneRect(0,0, this->viewport()->width(), this->viewport()->height());
     for(int index = 0 ;index < MAX_SATELLITES ; index++) {
         drawSat(index);
+        dirty[index] = false;
     }
 }
 
@@ -52,18 +58,41 @@ void GpsSnrWidget::resizeEvent(QResizeEvent* event) {
 }
 
 void GpsSnrWidget::updateSat(int index, int prn, int elevation, int azimuth, int snr) {
-    if (index >= MAX_SATELLITES) {
+    if (index < 0 || index >= MAX_SATELLITES) {
         // A bit of error checking never hurts.
         return;
     }
 
+    // Only the PRN and SNR are drawn
+    const bool changed = satellites[index][0] != prn || satellites[index][3] != snr;
+
     // TODO: add range checking
     satellites[index][0] = prn;
     satellites[index][1] = elevation;
     satellites[index][2] = azimuth;
     satellites[index][3] = snr;
 
-    drawSat(index);
+    // Draw all the changes together on the next tick
+    if (changed) {
+        dirty[index] = true;
+        if (!redrawTimer.isActive()) {
+            redrawTimer.start();
+        }
+    }
+}
+
+void GpsSnrWidget::redrawSats() {
+    // Hidden changes are drawn by showEvent
+    if (!isVisible()) {
+        return;
+    }
+
+    for(int index = 0 ;index < MAX_SATELLITES ; index++) {
+        if (dirty[index]) {
+            drawSat(index);
+            dirty[index] = false;
+        }
+    }
 }
 
 void GpsSnrWidget::drawSat(int index) {
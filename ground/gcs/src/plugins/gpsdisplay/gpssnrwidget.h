@@ -3,6 +3,7 @@
 
 #include <QGraphicsView>
 #include <QGraphicsRectItem>
+#include <QTimer>
 
 class GpsSnrWidget : public QGraphicsView {
     Q_OBJECT
@@ -15,9 +16,16 @@ signals:
 public slots:
     void updateSat(int index, int prn, int elevation, int azimuth, int snr);
 
+private slots:
+    void redrawSats();
+
 private:
     static const int MAX_SATELLITES = 32;
+    //! Satellite updates are drawn together at most this often
+    static const int REDRAW_PERIOD_MS = 200;
     int satellites[MAX_SATELLITES][4];
+    bool dirty[MAX_SATELLITES];
+    QTimer redrawTimer;
     QGraphicsScene *scene;
     QGraphicsRectItem *boxes[MAX_SATELLITES];
     QGraphicsSimpleTextItem *satTexts[MAX_SATELLITES];
@@ -30,10 +30,7 @@
 #include <iostream>
 #include <math.h>
 #include <QDebug>
-#include <QStringList>
-#include <QWidget>
-#include <QVBoxLayout>
-#include <QPushButton>
+#include <string.h>
 
 // Message Codes
 #define NMEA_NODATA    0       // No data. Packet not available, bad, or not decoded
@@ -67,8 +64,10 @@
  */
 NMEAParser::NMEAParser(QObject *parent) : GPSParser(parent)
 {
-    bufferInit(&gpsRxBuffer, (unsigned char *)gpsRxData, 512);
+    gpsRxLength   = 0;
     gpsRxOverflow = 0;
+    numUpdates    = 0;
+    numErrors     = 0;
 }
 
 NMEAParser::~NMEAParser()
@@ -79,13 +78,81 @@ NMEAParser::~NMEAParser()
  */
 void NMEAParser::processInputStream(char c)
 {
-    if (!bufferAddToEnd(&gpsRxBuffer, c)) {
-        // no space in buffer
-        // count overflow
-        gpsRxOverflow++;
-        return;
+    processInputStream(&c, 1);
+}
+
+/**
+ * Append a block of received data and process the complete sentences in it
+ */
+void NMEAParser::processInputStream(const char *data, int length)
+{
+    while (length > 0) {
+        int n = qMin(length, (int)sizeof(gpsRxData) - gpsRxLength);
+        memcpy(&gpsRxData[gpsRxLength], data, n);
+        gpsRxLength += n;
+        data   += n;
+        length -= n;
+
+        nmeaScan();
+
+        if (gpsRxLength >= (int)sizeof(gpsRxData)) {
+            // if we found no packet, and the buffer is full
+            // we're logjammed, flush entire buffer
+            gpsRxOverflow++;
+            gpsRxLength = 0;
+        }
     }
-    nmeaProcess(&gpsRxBuffer);
+}
+
+/**
+ * Find the complete sentences in the receive buffer, process them and
+ * move what is left of an incomplete one to the front
+ */
+void NMEAParser::nmeaScan()
+{
+    const char *end = gpsRxData + gpsRxLength;
+    const char *pos = gpsRxData;
+
+    while (pos < end) {
+        // look for a start of NMEA packet
+        const char *start = (const char *)memchr(pos, '$', end - pos);
+        if (start == NULL) {
+            pos = end;
+            break;
+        }
+        pos = start;
+
+        // look for end of NMEA packet <CR><LF>
+        const char *cr = start + 1;
+        while ((cr = (const char *)memchr(cr, '\r', end - cr)) != NULL) {
+            if (cr + 1 < end && cr[1] == '\n') {
+                break;
+            }
+            cr++;
+        }
+        if (cr == NULL || cr + 1 >= end) {
+            // wait for the rest of the packet
+            break;
+        }
+
+        // copy packet without the '$' to NmeaPacket. Although NMEA strings
+        // should be 80 characters or less, receive buffer errors can generate
+        // erroneous packets. Protect against packet buffer overflow
+        int len = qMin((int)(cr - start - 1), NMEA_BUFFERSIZE - 1);
+        memcpy(NmeaPacket, start + 1, len);
+        NmeaPacket[len] = 0;
+        pos = cr + 2;
+
+        // DEBUG
+                        #ifdef NMEA_DEBUG_PKT
+        qDebug() << NmeaPacket;
+                        #endif
+        emit packet(QString(NmeaPacket));
+        nmeaProcess(NmeaPacket);
+    }
+
+    gpsRxLength = end - pos;
+    memmove(gpsRxData, pos, gpsRxLength);
 }
 
 
@@ -100,7 +167,7 @@ char NMEAParser::nmeaChecksum(char *gps_buffer)
     char checksum = 0;
     char checksum_received = 0;
 
-    for (int x = 0; x < NMEA_BUFFERSIZE; x++) {
+    for (int x = 0; x < NMEA_BUFFERSIZE && gps_buffer[x]; x++) {
         if (gps_buffer[x] == '*') {
             // Parsing received checksum...
             checksum_received = strtol(&gps_buffer[x + 1], NULL, 16);
@@ -122,7 +189,7 @@ char NMEAParser::nmeaChecksum(char *gps_buffer)
 
 void NMEAParser::nmeaTerminateAtChecksum(char *gps_buffer)
 {
-    for (int x = 0; x < NMEA_BUFFERSIZE; x++) {
+    for (int x = 0; x < NMEA_BUFFERSIZE && gps_buffer[x]; x++) {
         if (gps_buffer[x] == '*') {
             gps_buffer[x] = 0;
             break;
@@ -131,116 +198,100 @@ void NMEAParser::nmeaTerminateAtChecksum(char *gps_buffer)
 }
 
 /**
- * Prosesses NMEA sentences
- * \param[in] cBuffer for prosessed nmea sentences
- * \return Message code for found packet
- * \return 0xFF NO packet found
+ * Split a sentence at the commas in place. Fields past the end of the
+ * sentence are set to an empty string so they can be read like missing ones.
+ * \param[in] packet nmea sentence, terminated at the checksum
+ * \param[out] fields pointers to the start of each field
+ * \return Number of fields in the sentence
  */
-quint8 NMEAParser::nmeaProcess(cBuffer *rxBuffer)
+int NMEAParser::nmeaTokenize(char *packet, const char *fields[NMEA_MAX_FIELDS])
 {
-    quint8 foundpacket = NMEA_NODATA;
-    quint8 startFlag   = false;
-    // u08 data;
-    quint16 i, j;
-
-    // process the receive buffer
-    // go through buffer looking for packets
-    while (rxBuffer->datalength) {
-        // look for a start of NMEA packet
-        if (bufferGetAtIndex(rxBuffer, 0) == '$') {
-            // found start
-            startFlag = true;
-            // when start is found, we leave it intact in the receive buffer
-            // in case the full NMEA string is not completely received.  The
-            // start will be detected in the next nmeaProcess iteration.
-
-            // done looking for start
-            break;
-        } else {
-            bufferGetFromFront(rxBuffer);
+    int count = 0;
+
+    fields[count++] = packet;
+    for (char *p = packet; *p && count < NMEA_MAX_FIELDS; p++) {
+        if (*p == ',') {
+            *p = 0;
+            fields[count++] = p + 1;
         }
     }
+    for (int i = count; i < NMEA_MAX_FIELDS; i++) {
+        fields[i] = "";
+    }
+    return count;
+}
 
-    // if we detected a start, look for end of packet
-    if (startFlag) {
-        for (i = 1; i < (rxBuffer->datalength) - 1; i++) {
-            // check for end of NMEA packet <CR><LF>
-            if ((bufferGetAtIndex(rxBuffer, i) == '\r') && (bufferGetAtIndex(rxBuffer, i + 1) == '\n')) {
-                // have a packet end
-                // dump initial '$'
-                bufferGetFromFront(rxBuffer);
-                // copy packet to NmeaPacket
-                for (j = 0; j < (i - 1); j++) {
-                    // although NMEA strings should be 80 characters or less,
-                    // receive buffer errors can generate erroneous packets.
-                    // Protect against packet buffer overflow
-                    if (j < (NMEA_BUFFERSIZE - 1)) {
-                        NmeaPacket[j] = bufferGetFromFront(rxBuffer);
-                    } else {
-                        bufferGetFromFront(rxBuffer);
-                    }
-                }
-                // null terminate it
-                if (j < (NMEA_BUFFERSIZE - 1)) {
-                    NmeaPacket[j] = 0;
-                } else {
-                    NmeaPacket[NMEA_BUFFERSIZE - 1] = 0;
-                }
-                // dump <CR><LF> from rxBuffer
-                bufferGetFromFront(rxBuffer);
-                bufferGetFromFront(rxBuffer);
-                // DEBUG
-                                #ifdef NMEA_DEBUG_PKT
-                qDebug() << NmeaPacket;
-                                #endif
-                emit packet(QString(NmeaPacket));
-                // found a packet
-                // done with this processing session
-                foundpacket = NMEA_UNKNOWN;
-                break;
-            }
+/**
+ * Parse a decimal number of a field. Unlike strtod this does not depend
+ * on the locale the GCS runs in.
+ */
+double NMEAParser::nmeaParseDouble(const char *field)
+{
+    bool negative = false;
+    double value  = 0;
+    double scale  = 1;
+
+    if (*field == '-' || *field == '+') {
+        negative = (*field == '-');
+        field++;
+    }
+    for (; *field >= '0' && *field <= '9'; field++) {
+        value = value * 10 + (*field - '0');
+    }
+    if (*field == '.') {
+        for (field++; *field >= '0' && *field <= '9'; field++) {
+            scale /= 10;
+            value += (*field - '0') * scale;
         }
     }
+    return negative ? -value : value;
+}
 
-    if (foundpacket) {
-        // check message type and process appropriately
-        if (!strncmp(NmeaPacket, "GPGGA", 5)) {
-            // process packet of this type
-            nmeaProcessGPGGA(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPGGA;
-        } else if (!strncmp(NmeaPacket, "GPVTG", 5)) {
-            // process packet of this type
-            nmeaProcessGPVTG(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPVTG;
-        } else if (!strncmp(NmeaPacket, "GPGSA", 5)) {
-            // process packet of this type
-            nmeaProcessGPGSA(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPGSA;
-        } else if (!strncmp(NmeaPacket, "GPRMC", 5)) {
-            // process packet of this type
-            nmeaProcessGPRMC(NmeaPacket);
-            // report packet type
-            foundpacket = NMEA_GPRMC;
-        } else if (!strncmp(NmeaPacket, "GPGSV", 5)) {
-            // Process packet of this type
-            nmeaProcessGPGSV(NmeaPacket);
-            // rerpot packet type
-            foundpacket = NMEA_GPGSV;
-        } else if (!strncmp(NmeaPacket, "GPZDA", 5)) {
-            // Process packet of this type
-            nmeaProcessGPZDA(NmeaPacket);
-            // rerpot packet type
-            foundpacket = NMEA_GPZDA;
-        }
-    } else if (rxBuffer->datalength >= rxBuffer->size) {
-        // if we found no packet, and the buffer is full
-        // we're logjammed, flush entire buffer
-        bufferFlush(rxBuffer);
+int NMEAParser::nmeaParseInt(const char *field)
+{
+    return (int)nmeaParseDouble(field);
+}
+
+/**
+ * Prosesses a NMEA sentence
+ * \param[in] Buffer with the sentence without the leading '$'
+ * \return Message code for found packet
+ */
+quint8 NMEAParser::nmeaProcess(char *packet)
+{
+    // check message type and process appropriately
+    if (!strncmp(packet, "GPGGA", 5)) {
+        // process packet of this type
+        nmeaProcessGPGGA(packet);
+        // report packet type
+        return NMEA_GPGGA;
+    } else if (!strncmp(packet, "GPVTG", 5)) {
+        // process packet of this type
+        nmeaProcessGPVTG(packet);
+        // report packet type
+        return NMEA_GPVTG;
+    } else if (!strncmp(packet, "GPGSA", 5)) {
+        // process packet of this type
+        nmeaProcessGPGSA(packet);
+        // report packet type
+        return NMEA_GPGSA;
+    } else if (!strncmp(packet, "GPRMC", 5)) {
+        // process packet of this type
+        nmeaProcessGPRMC(packet);
+        // report packet type
+        return NMEA_GPRMC;
+    } else if (!strncmp(packet, "GPGSV", 5)) {
+        // Process packet of this type
+        nmeaProcessGPGSV(packet);
+        // rerpot packet type
+        return NMEA_GPGSV;
+    } else if (!strncmp(packet, "GPZDA", 5)) {
+        // Process packet of this type
+        nmeaProcessGPZDA(packet);
+        // rerpot packet type
+        return NMEA_GPZDA;
     }
-    return foundpacket;
+    return NMEA_UNKNOWN;
 }
 
 /**
@@ -261,22 +312,22 @@ void NMEAParser::nmeaProcessGPGSV(char *packet)
     }
     nmeaTerminateAtChecksum(packet);
 
-    QString nmeaString(packet);
-    QStringList tokenslist = nmeaString.split(",");
+    const char *fields[NMEA_MAX_FIELDS];
+    int numFields = nmeaTokenize(packet, fields);
 
 
     // Officially there should be a max of three sentences (12 sats), some gps receivers do more..
 
-    const int sentence_total = tokenslist.at(1).toInt(); // Number of sentences for full data
-    const int sentence_index = tokenslist.at(2).toInt(); // sentence x of y
+    const int sentence_total = nmeaParseInt(fields[1]); // Number of sentences for full data
+    const int sentence_index = nmeaParseInt(fields[2]); // sentence x of y
 
-    int sats = (tokenslist.size() - 4) / 4;
+    int sats = (numFields - 4) / 4;
     for (int sat = 0; sat < sats; sat++) {
         int base          = 4 + sat * 4;
-        const int id      = tokenslist.at(base + 0).toInt(); // Satellite PRN number
-        const int elv     = tokenslist.at(base + 1).toInt(); // Elevation, degrees
-        const int azimuth = tokenslist.at(base + 2).toInt(); // Azimuth, degrees
-        const int sig     = tokenslist.at(base + 3).toInt(); // SNR - higher is better
+        const int id      = nmeaParseInt(fields[base + 0]); // Satellite PRN number
+        const int elv     = nmeaParseInt(fields[base + 1]); // Elevation, degrees
+        const int azimuth = nmeaParseInt(fields[base + 2]); // Azimuth, degrees
+        const int sig     = nmeaParseInt(fields[base + 3]); // SNR - higher is better
         const int index   = (sentence_index - 1) * 4 + sat;
         emit satellite(index, id, elv, azimuth, sig);
     }
@@ -309,33 +360,33 @@ void NMEAParser::nmeaProcessGPGGA(char *packet)
     }
     nmeaTerminateAtChecksum(packet);
 
-    QString nmeaString(packet);
-    QStringList tokenslist = nmeaString.split(",");
-    GpsData.GPStime  = tokenslist.at(1).toDouble();
-    GpsData.Latitude = tokenslist.at(2).toDouble();
+    const char *fields[NMEA_MAX_FIELDS];
+    nmeaTokenize(packet, fields);
+    GpsData.GPStime  = nmeaParseDouble(fields[1]);
+    GpsData.Latitude = nmeaParseDouble(fields[2]);
     int deg    = (int)GpsData.Latitude / 100;
     double min = ((GpsData.Latitude) - (deg * 100)) / 60.0;
     GpsData.Latitude = deg + min;
     // next field: N/S indicator
     // correct latitute for N/S
-    if (tokenslist.at(3).contains("S")) {
+    if (strchr(fields[3], 'S')) {
         GpsData.Latitude = -GpsData.Latitude;
     }
 
-    GpsData.Longitude = tokenslist.at(4).toDouble();
+    GpsData.Longitude = nmeaParseDouble(fields[4]);
     deg = (int)GpsData.Longitude / 100;
     min = ((GpsData.Longitude) - (deg * 100)) / 60.0;
     GpsData.Longitude = deg + min;
     // next field: E/W indicator
     // correct latitute for E/W
-    if (tokenslist.at(5).contains("W")) {
+    if (strchr(fields[5], 'W')) {
         GpsData.Longitude = -GpsData.Longitude;
     }
 
-    GpsData.SV = tokenslist.at(7).toInt();
+    GpsData.SV = nmeaParseInt(fields[7]);
 
-    GpsData.Altitude = tokenslist.at(9).toDouble();
-    GpsData.GeoidSeparation = tokenslist.at(11).toDouble();
+    GpsData.Altitude = nmeaParseDouble(fields[9]);
+    GpsData.GeoidSeparation = nmeaParseDouble(fields[11]);
     emit position(GpsData.Latitude, GpsData.Longitude, GpsData.Altitude);
     emit sv(GpsData.SV);
     emit datetime(GpsData.GPSdate, GpsData.GPStime);
@@ -359,13 +410,13 @@ void NMEAParser::nmeaProcessGPRMC(char *packet)
     }
     nmeaTerminateAtChecksum(packet);
 
-    QString nmeaString(packet);
-    QStringList tokenslist = nmeaString.split(",");
-    GpsData.GPStime     = tokenslist.at(1).toDouble();
-    GpsData.Groundspeed = tokenslist.at(7).toDouble();
+    const char *fields[NMEA_MAX_FIELDS];
+    nmeaTokenize(packet, fields);
+    GpsData.GPStime     = nmeaParseDouble(fields[1]);
+    GpsData.Groundspeed = nmeaParseDouble(fields[7]);
     GpsData.Groundspeed = GpsData.Groundspeed * 0.51444;
-    GpsData.Heading     = tokenslist.at(8).toDouble();
-    GpsData.GPSdate     = tokenslist.at(9).toDouble();
+    GpsData.Heading     = nmeaParseDouble(fields[8]);
+    GpsData.GPSdate     = nmeaParseDouble(fields[9]);
     emit datetime(GpsData.GPSdate, GpsData.GPStime);
     emit speedheading(GpsData.Groundspeed, GpsData.Heading);
 }
@@ -389,11 +440,11 @@ void NMEAParser::nmeaProcessGPVTG(char *packet)
     }
     nmeaTerminateAtChecksum(packet);
 
-    QString nmeaString(packet);
-    QStringList tokenslist = nmeaString.split(",");
+    const char *fields[NMEA_MAX_FIELDS];
+    nmeaTokenize(packet, fields);
 
-    GpsData.Heading     = tokenslist.at(1).toDouble();
-    GpsData.Groundspeed = tokenslist.at(7).toDouble();
+    GpsData.Heading     = nmeaParseDouble(fields[1]);
+    GpsData.Groundspeed = nmeaParseDouble(fields[7]);
     GpsData.Groundspeed = GpsData.Groundspeed / 3.6;
     emit speedheading(GpsData.Groundspeed, GpsData.Heading);
 }
@@ -416,20 +467,20 @@ void NMEAParser::nmeaProcessGPGSA(char *packet)
     }
     nmeaTerminateAtChecksum(packet);
 
-    QString nmeaString(packet);
-    QStringList tokenslist = nmeaString.split(",");
+    const char *fields[NMEA_MAX_FIELDS];
+    nmeaTokenize(packet, fields);
 
     // M=Manual, forced to operate in 2D or 3D
     // A=Automatic, 3D/2D
-    QString fixmodeValue = tokenslist.at(1);
-    if (fixmodeValue == "A") {
+    const char *fixmodeValue = fields[1];
+    if (!strcmp(fixmodeValue, "A")) {
         emit fixmode(QString("Auto"));
-    } else if (fixmodeValue == "B") {
+    } else if (!strcmp(fixmodeValue, "B")) {
         emit fixmode(QString("Manual"));
     }
 
     // Mode: 1=Fix not available, 2=2D, 3=3D
-    int fixtypeValue = tokenslist.at(2).toInt();
+    int fixtypeValue = nmeaParseInt(fields[2]);
     if (fixtypeValue == 1) {
         emit fixtype(QString("NoFix"));
     } else if (fixtypeValue == 2) {
@@ -441,9 +492,9 @@ void NMEAParser::nmeaProcessGPGSA(char *packet)
     // 3-14 = IDs of SVs used in position fix (null for unused fields)
     QList<int> svList;
     for (int pos = 0; pos < 12; pos++) {
-        QString sv = tokenslist.at(3 + pos);
-        if (!sv.isEmpty()) {
-            svList.append(sv.toInt());
+        const char *sv = fields[3 + pos];
+        if (*sv) {
+            svList.append(nmeaParseInt(sv));
         }
     }
     emit fixSVs(svList);
@@ -451,9 +502,9 @@ void NMEAParser::nmeaProcessGPGSA(char *packet)
     // 15   = PDOP
     // 16   = HDOP
     // 17   = VDOP
-    GpsData.PDOP = tokenslist.at(15).toDouble();
-    GpsData.HDOP = tokenslist.at(16).toDouble();
-    GpsData.VDOP = tokenslist.at(17).toDouble();
+    GpsData.PDOP = nmeaParseDouble(fields[15]);
+    GpsData.HDOP = nmeaParseDouble(fields[16]);
+    GpsData.VDOP = nmeaParseDouble(fields[17]);
     emit dop(GpsData.HDOP, GpsData.VDOP, GpsData.PDOP);
 }
 
@@ -475,13 +526,13 @@ void NMEAParser::nmeaProcessGPZDA(char *packet)
     }
     nmeaTerminateAtChecksum(packet);
 
-    QString nmeaString(packet);
-    QStringList tokenslist = nmeaString.split(",");
+    const char *fields[NMEA_MAX_FIELDS];
+    nmeaTokenize(packet, fields);
 
-    GpsData.GPStime = tokenslist.at(1).toDouble();
-    int day   = tokenslist.at(2).toInt();
-    int month = tokenslist.at(3).toInt();
-    int year  = tokenslist.at(4).toInt();
+    GpsData.GPStime = nmeaParseDouble(fields[1]);
+    int day   = nmeaParseInt(fields[2]);
+    int month = nmeaParseInt(fields[3]);
+    int year  = nmeaParseInt(fields[4]);
     GpsData.GPSdate = day * 10000 + month * 100 + (year - 2000);
     emit datetime(GpsData.GPSdate, GpsData.GPStime);
 }
@@ -31,11 +31,11 @@
 #include <QObject>
 #include <QtCore>
 #include <qglobal.h>
-#include "buffer.h"
 #include "gpsparser.h"
 
 // constants/macros/typdefs
 #define NMEA_BUFFERSIZE		128
+#define NMEA_MAX_FIELDS		32
 
 typedef struct struct_GpsData
 {
@@ -63,10 +63,14 @@ public:
    NMEAParser(QObject *parent = 0);
    ~NMEAParser();
    void processInputStream(char c);
+   void processInputStream(const char *data, int length);
    char* nmeaGetPacketBuffer(void);
    char nmeaChecksum(char* gps_buffer);
    void nmeaTerminateAtChecksum(char* gps_buffer);
-   quint8 nmeaProcess(cBuffer* rxBuffer);
+   int nmeaTokenize(char *packet, const char *fields[NMEA_MAX_FIELDS]);
+   static double nmeaParseDouble(const char *field);
+   static int nmeaParseInt(const char *field);
+   quint8 nmeaProcess(char* packet);
    void nmeaProcessGPGGA(char* packet);
    void nmeaProcessGPRMC(char* packet);
    void nmeaProcessGPVTG(char* packet);
@@ -74,13 +78,16 @@ public:
    void nmeaProcessGPGSV(char* packet);
    void nmeaProcessGPZDA(char* packet);
    GpsData_t GpsData;
-   cBuffer gpsRxBuffer;
    char gpsRxData[512];
+   int gpsRxLength;
    char NmeaPacket[NMEA_BUFFERSIZE];
    quint32 numUpdates;
    quint32 numErrors;
    qint32 gpsRxOverflow;
 
+private:
+   void nmeaScan();
+
 };
 
 #endif // NMEAPARSER_H
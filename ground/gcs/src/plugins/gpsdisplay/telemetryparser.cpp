@@ -53,8 +53,13 @@ TelemetryParser::TelemetryParser(QObject *parent) : GPSParser(parent)
         qDebug() << "Error: Object is unknown (GPSTime).";
     }
 
+    satPRN = satElevation = satAzimuth = satSNR = NULL;
     gpsObj = dynamic_cast<UAVDataObject*>(objManager->getObject("GPSSatellites"));
     if (gpsObj != NULL) {
+        satPRN = gpsObj->getField(QString("PRN"));
+        satElevation = gpsObj->getField(QString("Elevation"));
+        satAzimuth = gpsObj->getField(QString("Azimuth"));
+        satSNR = gpsObj->getField(QString("SNR"));
         connect(gpsObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateSats(UAVObject*)));
     }
 
@@ -107,19 +112,17 @@ void TelemetryParser::updateTime( UAVObject* object1) {
 /**
   Updates the satellite constellation.
 
-  Not really optimized for now, we should only send updates for the stas
-  which have changed instead of updating everything... That said, Qt is supposed
-  to be able to optimize redraws anyway.
+  Every satellite is sent, the widgets skip the ones that did not change
+  and redraw the others together on their own tick.
   */
 void TelemetryParser::updateSats( UAVObject* object1) {
-    UAVObjectField* prn = object1->getField(QString("PRN"));
-    UAVObjectField* elevation = object1->getField(QString("Elevation"));
-    UAVObjectField* azimuth = object1->getField(QString("Azimuth"));
-    UAVObjectField* snr = object1->getField(QString("SNR"));
-
-    for (unsigned int i=0;i< prn->getNumElements();i++) {
-        emit satellite(i,prn->getValue(i).toInt(),elevation->getValue(i).toInt(),
-                       azimuth->getValue(i).toInt(), snr->getValue(i).toInt());
+    Q_UNUSED(object1);
+    if (satPRN == NULL || satElevation == NULL || satAzimuth == NULL || satSNR == NULL)
+        return;
+
+    for (unsigned int i=0;i< satPRN->getNumElements();i++) {
+        emit satellite(i,satPRN->getValue(i).toInt(),satElevation->getValue(i).toInt(),
+                       satAzimuth->getValue(i).toInt(), satSNR->getValue(i).toInt());
     }
 
 }
@@ -50,6 +50,12 @@ public slots:
    void updateTime(UAVObject* object1);
    void updateSats(UAVObject* object1);
 
+private:
+   //! Fields of GPSSatellites, looked up once
+   UAVObjectField *satPRN;
+   UAVObjectField *satElevation;
+   UAVObjectField *satAzimuth;
+   UAVObjectField *satSNR;
 };
 
 #endif // TELEMETRYPARSER_H
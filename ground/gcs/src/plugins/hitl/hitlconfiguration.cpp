@@ -68,6 +68,8 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings* qSettings, QObj
     settings.airspeedActualEnabled= false;
     settings.airspeedActualRate  = 100;
 
+    settings.bundleSensors       = false;
+    settings.stepSync            = false;
 
     // if a saved configuration exists load it, and overwrite defaults
     if (qSettings != 0) {
@@ -124,6 +126,9 @@ HITLConfiguration::HITLConfiguration(QString classId, QSettings* qSettings, QObj
 
         settings.airspeedActualEnabled=qSettings->value("airspeedActualEnabled").toBool();
         settings.airspeedActualRate  = qSettings->value("airspeedActualRate").toInt();
+
+        settings.bundleSensors       = qSettings->value("bundleSensors").toBool();
+        settings.stepSync            = qSettings->value("stepSync").toBool();
     }
 }
 
@@ -174,5 +179,8 @@ void HITLConfiguration::saveConfig(QSettings* qSettings) const {
 
     qSettings->setValue("airspeedActualEnabled", settings.airspeedActualEnabled);
     qSettings->setValue("airspeedActualRate", settings.airspeedActualRate);
+
+    qSettings->setValue("bundleSensors", settings.bundleSensors);
+    qSettings->setValue("stepSync", settings.stepSync);
 }
 
@@ -86,6 +86,8 @@ QWidget *HITLOptionsPage::createPage(QWidget *parent)
 
     m_optionsPage->startSim->setChecked(config->Settings().startSim);
     m_optionsPage->noiseCheckBox->setChecked(config->Settings().addNoise);
+    m_optionsPage->bundleSensorsCheckBox->setChecked(config->Settings().bundleSensors);
+    m_optionsPage->stepSyncCheckBox->setChecked(config->Settings().stepSync);
 
     m_optionsPage->hostAddress->setText(config->Settings().hostAddress);
     m_optionsPage->remoteAddress->setText(config->Settings().remoteAddress);
@@ -168,6 +170,9 @@ void HITLOptionsPage::apply()
     settings.airspeedActualEnabled=m_optionsPage->airspeedActualCheckbox->isChecked();
     settings.airspeedActualRate=m_optionsPage->airspeedRateSpinbox->value();
 
+    settings.bundleSensors = m_optionsPage->bundleSensorsCheckBox->isChecked();
+    settings.stepSync = m_optionsPage->stepSyncCheckBox->isChecked();
+
     //Write settings to file
     config->setSimulatorSettings(settings);
 }
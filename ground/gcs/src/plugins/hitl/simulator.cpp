@@ -51,6 +51,10 @@ Simulator::Simulator(const SimulatorSettings& params) :
 	simTimer(NULL),
 	name("")
 {
+	// Every step has to reach the board at once to keep in sync with it
+	if (settings.stepSync)
+		settings.bundleSensors = true;
+
 	// move to thread
 	moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
         connect(this, SIGNAL(myStart()), this, SLOT(onStart()),Qt::QueuedConnection);
@@ -165,7 +169,7 @@ void Simulator::onStart()
     groundTruth = GroundTruth::GetInstance(objManager);
 
     // Listen to autopilot connection events
-    TelemetryManager* telMngr = pm->getObject<TelemetryManager>();
+    telMngr = pm->getObject<TelemetryManager>();
     connect(telMngr, SIGNAL(connected()), this, SLOT(onAutopilotConnect()));
     connect(telMngr, SIGNAL(disconnected()), this, SLOT(onAutopilotDisconnect()));
 
@@ -185,11 +189,17 @@ void Simulator::onStart()
 
 	connect(inSocket, SIGNAL(readyRead()), this, SLOT(receiveUpdate()),Qt::DirectConnection);
 
-	// Setup transmit timer
+	// Setup transmit timer, or step the simulator whenever the flight
+	// controller answers the last sensor update
 	txTimer = new QTimer();
 	connect(txTimer, SIGNAL(timeout()), this, SLOT(transmitUpdate()),Qt::DirectConnection);
 	txTimer->setInterval(updatePeriod);
-	txTimer->start();
+	if (settings.stepSync) {
+		UAVObject* input = (settings.simulatorId == "ASimRC") ? (UAVObject*) actCommand : (UAVObject*) actDesired;
+		connect(input, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(transmitUpdate()),Qt::DirectConnection);
+	} else {
+		txTimer->start();
+	}
 	// Setup simulator connection timer
 	simTimer = new QTimer();
 	connect(simTimer, SIGNAL(timeout()), this, SLOT(onSimulatorConnectionTimeout()),Qt::DirectConnection);
@@ -360,11 +370,16 @@ void Simulator::setupOutputObject(UAVObject* obj, quint32 updatePeriod)
     // Fetch value from QMap
     UAVObject::Metadata mdata = metaDataList.value(obj->getName());
 
-    // Update GCS-side metadata
+    // Update GCS-side metadata, bundled objects are only sent by updateUAVOs()
     UAVObject::SetGcsAccess(mdata, UAVObject::ACCESS_READWRITE);
     UAVObject::SetGcsTelemetryAcked(mdata, false);
-    UAVObject::SetGcsTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_THROTTLED);
-    mdata.gcsTelemetryUpdatePeriod = updatePeriod;
+    if (settings.bundleSensors) {
+        UAVObject::SetGcsTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
+        mdata.gcsTelemetryUpdatePeriod = 0;
+    } else {
+        UAVObject::SetGcsTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_THROTTLED);
+        mdata.gcsTelemetryUpdatePeriod = updatePeriod;
+    }
 
     // Update flight-side metadata
     UAVObject::SetFlightAccess(mdata, UAVObject::ACCESS_READONLY);
@@ -397,6 +412,24 @@ void Simulator::onSimulatorConnectionTimeout()
 }
 
 
+/**
+ * @brief Simulator::isDue Throttles an update to its period on the wall clock. When
+ * stepping in sync with the flight controller every step carries all the updates.
+ * @param last Time of the last update, moved on by one period when it is due
+ */
+bool Simulator::isDue(QTime& last, int period, const QTime& now)
+{
+    if (settings.stepSync)
+        return true;
+
+    if (last.msecsTo(now) < period)
+        return false;
+
+    last = last.addMSecs(period);
+    return true;
+}
+
+
 void Simulator::resetInitialHomePosition(){
     homePositionSet=false;
 }
@@ -406,6 +439,9 @@ void Simulator::updateUAVOs(Output2Hardware out){
 
     QTime currentTime = QTime::currentTime();
 
+    // Objects to send in bundles at the end
+    QList<UAVObject*> updated;
+
     Noise noise;
     HitlNoiseGeneration noiseSource;
 
@@ -507,6 +543,7 @@ void Simulator::updateUAVOs(Output2Hardware out){
 
         //Set UAVO
         attActual->setData(attActualData);
+        updated.append(attActual);
         /*****************************************/
     } else if (settings.attActCalc) {
         // calculate RPY with code from Attitude module
@@ -626,12 +663,13 @@ void Simulator::updateUAVOs(Output2Hardware out){
 
         //Set UAVO
         attActual->setData(attActualData);
+        updated.append(attActual);
         /*****************************************/
     }
 
     /*******************************/
     if (settings.gcsReceiverEnabled) {
-        if (gcsRcvrTime.msecsTo(currentTime) >= settings.minOutputPeriod) {
+        if (isDue(gcsRcvrTime, settings.minOutputPeriod, currentTime)) {
             GCSReceiver::DataFields gcsRcvrData;
             memset(&gcsRcvrData, 0, sizeof(GCSReceiver::DataFields));
 
@@ -640,17 +678,14 @@ void Simulator::updateUAVOs(Output2Hardware out){
             }
 
             gcsReceiver->setData(gcsRcvrData);
-
-            gcsRcvrTime=gcsRcvrTime.addMSecs(settings.minOutputPeriod);
-
+            updated.append(gcsReceiver);
         }
     }
 
 
     /*******************************/
     if (settings.gpsPositionEnabled) {
-        if (gpsPosTime.msecsTo(currentTime) >= settings.gpsPosRate) {
-            qDebug()<< " GPS time:" << gpsPosTime << ", currentTime: " << currentTime  << ", difference: "  << gpsPosTime.msecsTo(currentTime);
+        if (isDue(gpsPosTime, settings.gpsPosRate, currentTime)) {
             // Update GPS Position objects
             GPSPosition::DataFields gpsPosData;
             memset(&gpsPosData, 0, sizeof(GPSPosition::DataFields));
@@ -675,14 +710,13 @@ void Simulator::updateUAVOs(Output2Hardware out){
             gpsVelData.Down = out.velDown + noise.gpsVelData.Down;
 
             gpsVel->setData(gpsVelData);
-
-            gpsPosTime=gpsPosTime.addMSecs(settings.gpsPosRate);
+            updated << gpsPos << gpsVel;
         }
     }
 
     // Update PositionActual.{North,East,Down} && VelocityActual.{North,East,Down}
     if (settings.groundTruthEnabled) {
-        if (groundTruthTime.msecsTo(currentTime) >= settings.groundTruthRate) {
+        if (isDue(groundTruthTime, settings.groundTruthRate, currentTime)) {
             VelocityActual::DataFields velocityActualData;
             memset(&velocityActualData, 0, sizeof(VelocityActual::DataFields));
             velocityActualData.North = out.velNorth + noise.velocityActualData.North;
@@ -697,8 +731,7 @@ void Simulator::updateUAVOs(Output2Hardware out){
             positionActualData.East = (out.dstE-initE) + noise.positionActualData.East;
             positionActualData.Down = (out.dstD/*-initD*/) + noise.positionActualData.Down;
             posActual->setData(positionActualData);
-
-            groundTruthTime=groundTruthTime.addMSecs(settings.groundTruthRate);
+            updated << velActual << posActual;
         }
     }
 
@@ -727,22 +760,21 @@ void Simulator::updateUAVOs(Output2Hardware out){
     /*******************************/
     // Update BaroAltitude object
     if (settings.baroAltitudeEnabled){
-        if (baroAltTime.msecsTo(currentTime) >= settings.baroAltRate) {
+        if (isDue(baroAltTime, settings.baroAltRate, currentTime)) {
         BaroAltitude::DataFields baroAltData;
         memset(&baroAltData, 0, sizeof(BaroAltitude::DataFields));
         baroAltData.Altitude = out.altitude + noise.baroAltData.Altitude;
         baroAltData.Temperature = out.temperature + noise.baroAltData.Temperature;
         baroAltData.Pressure = out.pressure + noise.baroAltData.Pressure;
         baroAlt->setData(baroAltData);
-
-        baroAltTime=baroAltTime.addMSecs(settings.baroAltRate);
+        updated.append(baroAlt);
         }
     }
 
     /*******************************/
     // Update AirspeedActual object
     if (settings.airspeedActualEnabled){
-        if (airspeedActualTime.msecsTo(currentTime) >= settings.airspeedActualRate) {
+        if (isDue(airspeedActualTime, settings.airspeedActualRate, currentTime)) {
         AirspeedActual::DataFields airspeedActualData;
         memset(&airspeedActualData, 0, sizeof(AirspeedActual::DataFields));
         airspeedActualData.CalibratedAirspeed = out.calibratedAirspeed + noise.airspeedActual.CalibratedAirspeed;
@@ -750,15 +782,14 @@ void Simulator::updateUAVOs(Output2Hardware out){
         airspeedActualData.alpha=out.angleOfAttack;
         airspeedActualData.beta=out.angleOfSlip;
         airspeedActual->setData(airspeedActualData);
-
-        airspeedActualTime=airspeedActualTime.addMSecs(settings.airspeedActualRate);
+        updated.append(airspeedActual);
         }
     }
 
     /*******************************/
     // Update raw attitude sensors
     if (settings.attRawEnabled) {
-        if (attRawTime.msecsTo(currentTime) >= settings.attRawRate) {
+        if (isDue(attRawTime, settings.attRawRate, currentTime)) {
             //Update gyroscope sensor data
             Gyros::DataFields gyroData;
             memset(&gyroData, 0, sizeof(Gyros::DataFields));
@@ -774,10 +805,13 @@ void Simulator::updateUAVOs(Output2Hardware out){
             accelData.y = out.accY + noise.accelData.y;
             accelData.z = out.accZ + noise.accelData.z;
             accels->setData(accelData);
-
-            attRawTime=attRawTime.addMSecs(settings.attRawRate);
+            updated << gyros << accels;
         }
     }
+
+    // One packet to the board instead of one per object through the telemetry
+    if (settings.bundleSensors && !updated.isEmpty())
+        telMngr->sendObjectBundle(updated);
 }
 
 /**
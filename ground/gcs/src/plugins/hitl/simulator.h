@@ -161,6 +161,9 @@ typedef struct _CONNECTION
     bool airspeedActualEnabled;
     quint16 airspeedActualRate;
 
+    bool bundleSensors;
+    bool stepSync;
+
 } SimulatorSettings;
 
 
@@ -296,6 +299,7 @@ protected:
     GCSTelemetryStats* telStats;
     GCSReceiver* gcsReceiver;
     GroundTruth* groundTruth;
+    TelemetryManager* telMngr;
 
     SimulatorSettings settings;
 
@@ -329,6 +333,7 @@ private:
     static QStringList instances;
     //QList<QScopedPointer<UAVDataObject> > requiredUAVObjects;
     void setupOutputObject(UAVObject* obj, quint32 updatePeriod);
+    bool isDue(QTime& last, int period, const QTime& now);
     void setupInputObject(UAVObject* obj, quint32 updatePeriod);
     void setupUAVObjects();
     UAVObjectUtilManager* getObjectUtilManager();
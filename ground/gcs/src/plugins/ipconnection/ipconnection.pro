@@ -8,11 +8,13 @@ HEADERS += ipconnectionplugin.h \
     ipconnectionconfiguration.h \
     ipconnectionoptionspage.h \
     ipconnection_internal.h \
-    ipdevice.h
+    ipdevice.h \
+    udpbatchdevice.h
 SOURCES += ipconnectionplugin.cpp \
     ipconnectionconfiguration.cpp \
     ipconnectionoptionspage.cpp \
-    ipdevice.cpp
+    ipdevice.cpp \
+    udpbatchdevice.cpp
 FORMS += ipconnectionoptionspage.ui
 RESOURCES += 
 DEFINES += IPconnection_LIBRARY
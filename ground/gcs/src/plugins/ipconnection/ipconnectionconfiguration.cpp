@@ -32,7 +32,8 @@ IPconnectionConfiguration::IPconnectionConfiguration(QString classId, QSettings*
     IUAVGadgetConfiguration(classId, parent),
     m_HostName("127.0.0.1"),
     m_Port(1000),
-    m_UseTCP(1)
+    m_UseTCP(1),
+    m_UseSequenceNumbers(0)
 {
     Q_UNUSED(qSettings);
 
@@ -49,6 +50,7 @@ IUAVGadgetConfiguration *IPconnectionConfiguration::clone()
     m->m_Port = m_Port;
     m->m_HostName = m_HostName;
     m->m_UseTCP = m_UseTCP;
+    m->m_UseSequenceNumbers = m_UseSequenceNumbers;
     return m;
 }
 
@@ -60,6 +62,7 @@ void IPconnectionConfiguration::saveConfig(QSettings* qSettings) const {
    qSettings->setValue("port", m_Port);
    qSettings->setValue("hostName", m_HostName);
    qSettings->setValue("useTCP", m_UseTCP);
+   qSettings->setValue("useSequenceNumbers", m_UseSequenceNumbers);
 }
 
 void IPconnectionConfiguration::savesettings() const
@@ -71,6 +74,7 @@ void IPconnectionConfiguration::savesettings() const
         settings->setValue(QLatin1String("HostName"), m_HostName);
         settings->setValue(QLatin1String("Port"), m_Port);
         settings->setValue(QLatin1String("UseTCP"), m_UseTCP);
+        settings->setValue(QLatin1String("UseSequenceNumbers"), m_UseSequenceNumbers);
         settings->endArray();
         settings->endGroup();
 }
@@ -85,6 +89,7 @@ void IPconnectionConfiguration::restoresettings()
         m_HostName = (settings->value(QLatin1String("HostName"), tr("")).toString());
         m_Port = (settings->value(QLatin1String("Port"), tr("")).toInt());
         m_UseTCP = (settings->value(QLatin1String("UseTCP"), tr("")).toInt());
+        m_UseSequenceNumbers = (settings->value(QLatin1String("UseSequenceNumbers"), 0).toInt());
         settings->endArray();
         settings->endGroup();
 
@@ -40,6 +40,7 @@ Q_OBJECT
 Q_PROPERTY(QString HostName READ HostName WRITE setHostName)
 Q_PROPERTY(int Port READ Port WRITE setPort)
 Q_PROPERTY(int UseTCP READ UseTCP WRITE setUseTCP)
+Q_PROPERTY(int UseSequenceNumbers READ UseSequenceNumbers WRITE setUseSequenceNumbers)
 
 public:
     explicit IPconnectionConfiguration(QString classId, QSettings* qSettings = 0, QObject *parent = 0);
@@ -55,17 +56,20 @@ public:
     QString HostName() const { return m_HostName; }
     int Port() const { return m_Port; }
     int UseTCP() const { return m_UseTCP; }
+    int UseSequenceNumbers() const { return m_UseSequenceNumbers; }
 
 
 public slots:
     void setHostName(QString HostName) { m_HostName = HostName; }
     void setPort(int Port) { m_Port = Port; }
     void setUseTCP(int UseTCP) { m_UseTCP = UseTCP; }
+    void setUseSequenceNumbers(int UseSequenceNumbers) { m_UseSequenceNumbers = UseSequenceNumbers; }
 
 private:
     QString m_HostName;
     int m_Port;
     int m_UseTCP;
+    int m_UseSequenceNumbers;
     QSettings* settings;
 
 
@@ -58,6 +58,7 @@ QWidget *IPconnectionOptionsPage::createPage(QWidget *parent)
     m_page->HostName->setText(m_config->HostName());
     m_page->UseTCP->setChecked(m_config->UseTCP()?true:false);
     m_page->UseUDP->setChecked(m_config->UseTCP()?false:true);
+    m_page->UseSequenceNumbers->setChecked(m_config->UseSequenceNumbers()?true:false);
 
     return w;
 }
@@ -67,6 +68,7 @@ void IPconnectionOptionsPage::apply()
     m_config->setPort(m_page->Port->value());
     m_config->setHostName(m_page->HostName->text());
     m_config->setUseTCP(m_page->UseTCP->isChecked()?1:0);
+    m_config->setUseSequenceNumbers(m_page->UseSequenceNumbers->isChecked()?1:0);
     m_config->savesettings();
 
     emit availableDevChanged();
@@ -33,6 +33,7 @@
 #include <extensionsystem/pluginmanager.h>
 #include <coreplugin/icore.h>
 #include "ipconnection_internal.h"
+#include "udpbatchdevice.h"
 
 #include <QtCore/QtPlugin>
 #include <QMainWindow>
@@ -52,16 +53,16 @@ QWaitCondition openDeviceWait;
 QWaitCondition closeDeviceWait;
 //QReadWriteLock dummyLock;
 QMutex ipConMutex;
-QAbstractSocket *ret;
+QIODevice *ret;
 
 IPConnection::IPConnection(IPconnectionConnection *connection) : QObject()
 {
     moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
 
-    QObject::connect(connection, SIGNAL(CreateSocket(QString,int,bool)),
-                     this, SLOT(onOpenDevice(QString,int,bool)));
-    QObject::connect(connection, SIGNAL(CloseSocket(QAbstractSocket*)),
-                     this, SLOT(onCloseDevice(QAbstractSocket*)));
+    QObject::connect(connection, SIGNAL(CreateSocket(QString,int,bool,bool)),
+                     this, SLOT(onOpenDevice(QString,int,bool,bool)));
+    QObject::connect(connection, SIGNAL(CloseSocket(QIODevice*)),
+                     this, SLOT(onCloseDevice(QIODevice*)));
 }
 
 /*IPConnection::~IPConnection()
@@ -69,7 +70,7 @@ IPConnection::IPConnection(IPconnectionConnection *connection) : QObject()
 
 }*/
 
-void IPConnection::onOpenDevice(QString HostName, int Port, bool UseTCP)
+void IPConnection::onOpenDevice(QString HostName, int Port, bool UseTCP, bool UseSequenceNumbers)
 {
     QAbstractSocket *ipSocket;
     const int Timeout = 5 * 1000;
@@ -101,7 +102,15 @@ void IPConnection::onOpenDevice(QString HostName, int Port, bool UseTCP)
 
         //in blocking mode so we wait for the connection to succeed
         if (ipSocket->waitForConnected(Timeout)) {
-            ret = ipSocket;
+            if (UseTCP) {
+                ret = ipSocket;
+            } else {
+                // Pack the UAVTalk frames into as few datagrams as possible
+                UdpBatchDevice *udpDevice = new UdpBatchDevice(
+                            static_cast<QUdpSocket *>(ipSocket), UseSequenceNumbers, this);
+                udpDevice->open(QIODevice::ReadWrite);
+                ret = udpDevice;
+            }
             openDeviceWait.wakeAll();
             ipConMutex.unlock();
             return;
@@ -116,7 +125,7 @@ void IPConnection::onOpenDevice(QString HostName, int Port, bool UseTCP)
     ipConMutex.unlock();
 }
 
-void IPConnection::onCloseDevice(QAbstractSocket *ipSocket)
+void IPConnection::onCloseDevice(QIODevice *ipSocket)
 {
     ipConMutex.lock();
     ipSocket->close ();
@@ -206,7 +215,7 @@ QIODevice *IPconnectionConnection::openDevice(Core::IDevice *deviceName)
     }
 
     ipConMutex.lock();
-    emit CreateSocket(HostName, Port, UseTCP);
+    emit CreateSocket(HostName, Port, UseTCP, m_config->UseSequenceNumbers());
     openDeviceWait.wait(&ipConMutex);
     ipConMutex.unlock();
     ipSocket = ret;
@@ -38,6 +38,7 @@
 
 
 class QAbstractSocket;
+class QIODevice;
 class QTcpSocket;
 class QUdpSocket;
 
@@ -71,11 +72,11 @@ protected slots:
     void onEnumerationChanged();
 
 signals: //For the benefit of IPConnection
-    void CreateSocket(QString HostName, int Port, bool UseTCP);
-    void CloseSocket(QAbstractSocket *socket);
+    void CreateSocket(QString HostName, int Port, bool UseTCP, bool UseSequenceNumbers);
+    void CloseSocket(QIODevice *socket);
 
 private:
-       QAbstractSocket *ipSocket;
+       QIODevice *ipSocket;
        IPconnectionConfiguration *m_config;
        IPconnectionOptionsPage *m_optionspage;
        IPDevice dev;
@@ -0,0 +1,195 @@
+/**
+ ******************************************************************************
+ *
+ * @file       udpbatchdevice.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup IPConnPlugin IP Telemetry Plugin
+ * @{
+ * @brief UDP telemetry that packs several UAVTalk frames per datagram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "udpbatchdevice.h"
+
+#include <QtNetwork/QUdpSocket>
+#include <QMutexLocker>
+#include <QDebug>
+
+//largest datagram sent, below the ethernet MTU so it is never fragmented
+static const int MAX_DATAGRAM = 1400;
+
+//size of the optional sequence number in front of each datagram
+static const int SEQ_LENGTH = 2;
+
+UdpBatchDevice::UdpBatchDevice(QUdpSocket *socket, bool sequenceNumbers, QObject *parent)
+    : QIODevice(parent),
+      m_socket(socket),
+      m_sequenceNumbers(sequenceNumbers),
+      m_flushPending(false),
+      m_txSeq(0),
+      m_rxSeq(0),
+      m_rxSynced(false),
+      m_rxLost(0)
+{
+    m_socket->setParent(this);
+    m_txBuffer.reserve(MAX_DATAGRAM);
+
+    connect(m_socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+}
+
+UdpBatchDevice::~UdpBatchDevice()
+{
+}
+
+void UdpBatchDevice::close()
+{
+    flush();
+
+    if (m_sequenceNumbers)
+        qDebug() << "UDP telemetry: lost" << m_rxLost << "datagrams";
+
+    m_socket->close();
+    QIODevice::close();
+}
+
+qint64 UdpBatchDevice::bytesAvailable() const
+{
+    QMutexLocker lock(&m_rxMutex);
+    return m_rxBuffer.size() + QIODevice::bytesAvailable();
+}
+
+qint64 UdpBatchDevice::bytesToWrite() const
+{
+    QMutexLocker lock(&m_txMutex);
+    return qMax(0, m_txBuffer.size() - headerLength()) + QIODevice::bytesToWrite();
+}
+
+int UdpBatchDevice::headerLength() const
+{
+    return m_sequenceNumbers ? SEQ_LENGTH : 0;
+}
+
+qint64 UdpBatchDevice::readData(char *data, qint64 maxSize)
+{
+    QMutexLocker lock(&m_rxMutex);
+
+    int size = qMin((qint64) m_rxBuffer.size(), maxSize);
+    memcpy(data, m_rxBuffer.constData(), size);
+    m_rxBuffer.remove(0, size);
+
+    return size;
+}
+
+/**
+ * Queue data for the next datagram. The first write after a send schedules
+ * a flush from the event loop, so everything written until then shares a
+ * datagram without holding anything back for longer than that.
+ */
+qint64 UdpBatchDevice::writeData(const char *data, qint64 maxSize)
+{
+    QMutexLocker lock(&m_txMutex);
+
+    qint64 written = 0;
+    while (written < maxSize) {
+        if (m_txBuffer.isEmpty())
+            m_txBuffer.fill(0, headerLength());
+
+        int size = qMin(maxSize - written, (qint64) (MAX_DATAGRAM - m_txBuffer.size()));
+        m_txBuffer.append(data + written, size);
+        written += size;
+
+        if (m_txBuffer.size() >= MAX_DATAGRAM)
+            flushLocked();
+    }
+
+    if (!m_flushPending && !m_txBuffer.isEmpty()) {
+        m_flushPending = true;
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+    }
+
+    return written;
+}
+
+//! Send whatever has been written so far
+void UdpBatchDevice::flush()
+{
+    QMutexLocker lock(&m_txMutex);
+
+    m_flushPending = false;
+    flushLocked();
+}
+
+void UdpBatchDevice::flushLocked()
+{
+    int payload = m_txBuffer.size() - headerLength();
+    if (payload <= 0)
+        return;
+
+    if (m_sequenceNumbers) {
+        m_txBuffer[0] = (char) (m_txSeq & 0xff);
+        m_txBuffer[1] = (char) (m_txSeq >> 8);
+        m_txSeq++;
+    }
+
+    if (m_socket->write(m_txBuffer) < 0)
+        qDebug() << "UDP telemetry: send failed" << m_socket->errorString();
+
+    m_txBuffer.clear();
+
+    emit bytesWritten(payload);
+}
+
+void UdpBatchDevice::onReadyRead()
+{
+    bool received = false;
+
+    while (m_socket->hasPendingDatagrams()) {
+        QByteArray datagram;
+        datagram.resize(m_socket->pendingDatagramSize());
+        qint64 size = m_socket->readDatagram(datagram.data(), datagram.size());
+        if (size <= headerLength())
+            continue;
+
+        int offset = 0;
+        if (m_sequenceNumbers) {
+            quint16 seq = (quint8) datagram[0] | ((quint8) datagram[1] << 8);
+            quint16 skipped = seq - m_rxSeq;
+
+            // Count the gap, going backwards means the sender restarted
+            // or datagrams were reordered, so just follow it then
+            if (m_rxSynced && skipped < 0x8000)
+                m_rxLost += skipped;
+            m_rxSeq = seq + 1;
+            m_rxSynced = true;
+            offset = SEQ_LENGTH;
+        }
+
+        QMutexLocker lock(&m_rxMutex);
+        m_rxBuffer.append(datagram.constData() + offset, size - offset);
+        received = true;
+    }
+
+    if (received)
+        emit readyRead();
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ *
+ * @file       udpbatchdevice.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup IPConnPlugin IP Telemetry Plugin
+ * @{
+ * @brief UDP telemetry that packs several UAVTalk frames per datagram
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UDPBATCHDEVICE_H
+#define UDPBATCHDEVICE_H
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QMutex>
+
+class QUdpSocket;
+
+/**
+*   Wraps a connected UDP socket. Every write used to go out as its own
+*   datagram, one per UAVTalk frame. Writes are now collected and sent
+*   together once control returns to the socket's event loop, or as soon as
+*   a datagram is full. Optionally each datagram starts with a 16 bit
+*   sequence number so the receiver can count what got lost, matching the
+*   UDP telemetry of the simulator (pios_udp.c).
+*/
+class UdpBatchDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    UdpBatchDevice(QUdpSocket *socket, bool sequenceNumbers, QObject *parent = 0);
+    virtual ~UdpBatchDevice();
+
+    virtual void close();
+    virtual bool isSequential() const { return true; }
+    virtual qint64 bytesAvailable() const;
+    virtual qint64 bytesToWrite() const;
+
+    //! Datagrams that never arrived, only counted with sequence numbers
+    quint32 lostDatagrams() const { return m_rxLost; }
+
+public slots:
+    void flush();
+
+protected:
+    virtual qint64 readData(char *data, qint64 maxSize);
+    virtual qint64 writeData(const char *data, qint64 maxSize);
+
+private slots:
+    void onReadyRead();
+
+private:
+    void flushLocked();
+    int headerLength() const;
+
+    QUdpSocket *m_socket;
+    bool m_sequenceNumbers;
+
+    QByteArray m_txBuffer;
+    mutable QMutex m_txMutex;
+    bool m_flushPending;
+    quint16 m_txSeq;
+
+    QByteArray m_rxBuffer;
+    mutable QMutex m_rxMutex;
+    quint16 m_rxSeq;
+    bool m_rxSynced;
+    quint32 m_rxLost;
+};
+
+#endif // UDPBATCHDEVICE_H
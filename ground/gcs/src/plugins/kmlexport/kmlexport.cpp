@@ -28,6 +28,8 @@
 #include <QMessageBox>
 #include <QTextStream>
 #include <QtGlobal>
+#include <QTemporaryFile>
+#include <QPair>
 
 #include <coreplugin/coreconstants.h>
 #include "utils/coordinateconversions.h"
@@ -45,10 +47,21 @@ const double ColorMap_Jet[256][3] = COLORMAP_JET;
 #define maxVelocity 20 // Vehicle velocity which corresponds to maximum color in color map. This shouldn't be hardcoded
 #define numberOfWallAxes 5 // Number of wall axes to plot. This shouldn't be hardcoded
 #define wallAxesSeparation 20 // Wall axes separation height in [m]. This shouldn't be hardcoded
+#define numberOfVelocityStyles 32 // Number of shared styles the track colors are quantized to
+#define defaultSegmentDuration 300 // Length of the exported time segments in [s]
+#define overviewToleranceFactor 10 // The zoomed out overview is simplified this many times coarser than the track
+#define detailMinLodPixels 256 // Size in pixels a segment must cover on screen before its detailed track is drawn
+#define regionMargin 0.0005 // Padding of the segment regions in [deg], so that hovering still covers some pixels
 
 
 KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName) :
-    outputFileName(outputKmlFileName)
+    outputFileName(outputKmlFileName),
+    kmlOutput(NULL),
+    timeStamp(0),
+    lastPlacemarkTime(0),
+    simplificationTolerance(1.0),
+    segmentDuration(defaultSegmentDuration * 1000),
+    segmentCount(0)
 {
     logFile.setFileName(inputLogFileName);
 
@@ -78,40 +91,31 @@ KmlExport::KmlExport(QString inputLogFileName, QString outputKmlFileName) :
 
     // Get the factory singleton to create KML elements.
     factory = KmlFactory::GetFactory();
+}
 
-    // Create <Document>
-    document = factory->CreateDocument();
-
-    // Create folders
-    timestampFolder = factory->CreateFolder();
-    timestampFolder->set_name("Arrows");
-
-    trackFolder = factory->CreateFolder();
-    trackFolder->set_name("Track");
-
-    // Create custom styles. Add as document's first elements
-    StyleMapPtr styleCBS = createCustomBalloonStyle();
-    document->add_styleselector(styleCBS);
-
-    StylePtr styleGT = createGroundTrackStyle();
-    document->add_styleselector(styleGT);
-
-    StyleMapPtr wallAxesStyle = createWallAxesStyle();
-    document->add_styleselector(wallAxesStyle);
 
-    // Create an array of lines which will make the wall axes.
-    for (int i=0; i<numberOfWallAxes; i++){
-        CoordinatesPtr coordinates = factory->CreateCoordinates();
-        wallAxes.append(coordinates);
-    }
+KmlExport::~KmlExport()
+{
+    delete kmlOutput;
 }
 
 
 /**
  * @brief KmlExport::exportToKML Triggers logfile export to KML.
+ *
+ * The document is written while the log is parsed, one time segment at a
+ * time, so memory use does not grow with the length of the log. A KMZ is
+ * compressed from a temporary KML file once the document is complete.
  */
 bool KmlExport::exportToKML()
 {
+    QString suffix = QFileInfo(outputFileName).suffix().toLower();
+    if (suffix != "kml" && suffix != "kmz") {
+        qDebug() << "Write failed. Invalid file name:" << outputFileName;
+        QMessageBox::critical(new QWidget(),"Write failed", "Failed to write file. Invalid filename");
+        return false;
+    }
+
     bool ret = open();
     if (!ret) {
         qDebug () << "Logfile failed to open during KML export";
@@ -125,84 +129,87 @@ bool KmlExport::exportToKML()
         return false;
     }
 
-    // Call parser.
-    parseLogFile();
-
-    // Add track to <Document>
-    document->add_feature(trackFolder);
-
-    // Add timespans to <Document>
-    document->add_feature(timestampFolder);
-
-    // Add ground track to <Document>
-    {
-        LineStringPtr linestring = factory->CreateLineString();
-        linestring->set_extrude(false); // Do not extrude to ground
-        linestring->set_altitudemode(kmldom::ALTITUDEMODE_CLAMPTOGROUND);
-        linestring->set_coordinates(wallAxes[0]);
-
-        MultiGeometryPtr multiGeometry = factory->CreateMultiGeometry();
-        multiGeometry->add_geometry(linestring);
-
-        PlacemarkPtr placemark = factory->CreatePlacemark();
-        placemark->set_geometry(multiGeometry);
-        placemark->set_styleurl("#ts_2_tb");
-        placemark->set_name("Ground track");
-
-        document->add_feature(placemark);
+    QFile *outputFile;
+    if (suffix == "kmz")
+        outputFile = new QTemporaryFile();
+    else
+        outputFile = new QFile(outputFileName);
+    delete kmlOutput;
+    kmlOutput = outputFile;
+
+    if (!outputFile->open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qDebug() << "KML write failed: " << outputFileName;
+        QMessageBox::critical(new QWidget(),"KML write failed", "Failed to write KML file.");
+        stopExport();
+        return false;
     }
 
-    // Add wall axes to <Document>
-    FolderPtr folder = factory->CreateFolder();
-    for (int i=0; i<numberOfWallAxes; i++) {
-        LineStringPtr linestring = factory->CreateLineString();
-        linestring->set_extrude(false); // Do not extrude to ground
-        linestring->set_altitudemode(kmldom::ALTITUDEMODE_ABSOLUTE);
-        linestring->set_coordinates(wallAxes[i]);
-
-        MultiGeometryPtr multiGeometry = factory->CreateMultiGeometry();
-        multiGeometry->add_geometry(linestring);
+    exportStartTime = QDateTime::currentDateTimeUtc(); // FIXME: Make this a function of the true time, preferably gotten from the GPS
+    lastPlacemarkTime = 0;
+    segmentCount = 0;
+    segment.clear();
+
+    // Write the document header and the shared styles
+    writeText("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+              "<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n"
+              "<Document>\n");
+    writeElement(createCustomBalloonStyle());
+    writeElement(createGroundTrackStyle());
+    writeElement(createWallAxesStyle());
+    for (int i=0; i<numberOfVelocityStyles; i++)
+        writeElement(createVelocityStyle(i));
+
+    // Call parser. Segments are written out as they fill up.
+    parseLogFile();
+    writeSegment();
 
-        PlacemarkPtr placemark = factory->CreatePlacemark();
-        placemark->set_geometry(multiGeometry);
-        placemark->set_styleurl("#ts_1_tb");
+    writeText("</Document>\n</kml>\n");
 
-        folder->add_feature(placemark);
-        folder->set_name("Wall axes");
+    if (outputFile->error() != QFile::NoError) {
+        qDebug() << "KML write failed: " << outputFileName << outputFile->errorString();
+        QMessageBox::critical(new QWidget(),"KML write failed", "Failed to write KML file.");
+        return false;
     }
-    document->add_feature(folder);
-
-    // Create <kml> and give it <Document>.
-    KmlPtr kml = factory->CreateKml();
-    kml->set_feature(document);  // kml takes ownership.
-
-    // Serialize to XML
-    std::string kml_data = kmldom::SerializePretty(kml);
 
     // Save to file
-    if (QFileInfo(outputFileName).suffix().toLower() == "kmz") {
+    if (suffix == "kmz") {
+        outputFile->seek(0);
+        QByteArray kmlData = outputFile->readAll();
+        std::string kml_data(kmlData.constData(), kmlData.size());
+        kmlData.clear();
+
         if (!kmlengine::KmzFile::WriteKmz(outputFileName.toStdString().c_str(), kml_data)) {
             qDebug() << "KMZ write failed: " << outputFileName;
             QMessageBox::critical(new QWidget(),"KMZ write failed", "Failed to write KMZ file.");
             return false;
         }
-    } else if (QFileInfo(outputFileName).suffix().toLower() == "kml") {
-        if (!kmlbase::File::WriteStringToFile(kml_data, outputFileName.toStdString())) {
-            qDebug() << "KML write failed: " << outputFileName;
-            QMessageBox::critical(new QWidget(),"KML write failed", "Failed to write KML file.");
-            return false;
-        }
-    } else {
-        qDebug() << "Write failed. Invalid file name:" << outputFileName;
-        QMessageBox::critical(new QWidget(),"Write failed", "Failed to write file. Invalid filename");
-        return false;
     }
 
+    outputFile->close();
 
     return true;
 }
 
 
+/**
+ * @brief KmlExport::writeElement Serializes a KML element and appends it to the output
+ */
+void KmlExport::writeElement(const ElementPtr &element)
+{
+    std::string xml = kmldom::SerializePretty(element);
+    kmlOutput->write(xml.data(), xml.size());
+}
+
+
+/**
+ * @brief KmlExport::writeText Appends raw markup to the output
+ */
+void KmlExport::writeText(const QString &text)
+{
+    kmlOutput->write(text.toUtf8());
+}
+
+
 /**
  * @brief KmlExport::open Opens the logfile and ensures it's sane
  * @return returns true if the logfile is successfully opened, returns false otherwise.
@@ -373,9 +380,7 @@ void KmlExport::parseLogFile()
 
         // Parse the packet. This operation passes the data to the kmlTalk object, which internally parses the data
         // and then emits objectUpdated(UAVObject *) signals. These signals are connected to in the KmlExport constructor.
-        for (int i=0; i < dataBuffer.size(); i++) {
-            kmlTalk->processInputByte(dataBuffer[i]);
-        }
+        kmlTalk->processInputBuffer((const quint8*)dataBuffer.constData(), dataBuffer.size());
 
         timeStampIdx++;
     }
@@ -592,40 +597,30 @@ StyleMapPtr KmlExport::createWallAxesStyle()
 
 
 /**
- * @brief KmlExport::CreateLineStringPlacemark Adds a line segment which is colored according to the
- * vehicle's speed.
- * @param startPoint Beginning point along line
- * @param endPoint End point point along line
- * @return Returns the placemark containing the line segment
+ * @brief KmlExport::createVelocityStyle Creates one of the shared styles the
+ * track segments are colored with, according to the vehicle's speed.
+ * @param bin Index of the style, from 0 for standing still to
+ * numberOfVelocityStyles-1 for maxVelocity and faster
+ * @return Returns the style map
  */
-PlacemarkPtr KmlExport::CreateLineStringPlacemark(const LLAVCoordinates &startPoint, const LLAVCoordinates &endPoint, quint32 newPlacemarkTime)
+StyleMapPtr KmlExport::createVelocityStyle(int bin)
 {
-    CoordinatesPtr coordinates = factory->CreateCoordinates();
-    coordinates->add_latlngalt(startPoint.latitude, startPoint.longitude, startPoint.altitude);
-    coordinates->add_latlngalt(endPoint.latitude,   endPoint.longitude,   endPoint.altitude);
-
-    LineStringPtr linestring = factory->CreateLineString();
-    linestring->set_extrude(true); // Extrude to ground
-    linestring->set_altitudemode(kmldom::ALTITUDEMODE_ABSOLUTE);
-    linestring->set_coordinates(coordinates);
+    double velocity = bin * (double) maxVelocity / (numberOfVelocityStyles - 1);
 
     StyleMapPtr styleMap = factory->CreateStyleMap();
 
-
     // Add custom balloon style (gets rid of "Directions to here...")
     // https://groups.google.com/forum/?fromgroups#!topic/kml-support-getting-started/2CqF9oiynRY
     BalloonStylePtr balloonStyle = factory->CreateBalloonStyle();
     balloonStyle->set_text("$[description]");
 
     {
-        double currentVelocity = (startPoint.groundspeed + endPoint.groundspeed)/2;
-
         // Set the linestyle. The color is a function of speed.
         LineStylePtr lineStyle = factory->CreateLineStyle();
-        lineStyle->set_color(mapVelocity2Color(currentVelocity));
+        lineStyle->set_color(mapVelocity2Color(velocity));
 
         PolyStylePtr polyStyle = factory->CreatePolyStyle();
-        polyStyle->set_color(mapVelocity2Color(currentVelocity, 100));
+        polyStyle->set_color(mapVelocity2Color(velocity, 100));
 
         // Link the style to the icon
         StylePtr style = factory->CreateStyle();
@@ -641,14 +636,12 @@ PlacemarkPtr KmlExport::CreateLineStringPlacemark(const LLAVCoordinates &startPo
     }
 
     {
-        double currentVelocity = (startPoint.groundspeed + endPoint.groundspeed)/2;
-
         // Set the linestyle. The color is a function of speed.
         LineStylePtr lineStyle = factory->CreateLineStyle();
-        lineStyle->set_color(mapVelocity2Color(currentVelocity));
+        lineStyle->set_color(mapVelocity2Color(velocity));
 
         PolyStylePtr polyStyle = factory->CreatePolyStyle();
-        polyStyle->set_color(mapVelocity2Color(currentVelocity, 100));
+        polyStyle->set_color(mapVelocity2Color(velocity, 100));
         polyStyle->set_fill(false);
 
         // Link the style to the icon
@@ -664,27 +657,48 @@ PlacemarkPtr KmlExport::CreateLineStringPlacemark(const LLAVCoordinates &startPo
         styleMap->add_pair(pair);
     }
 
+    styleMap->set_id(QString("velocity_%1").arg(bin).toStdString());
+
+    return styleMap;
+}
+
+
+/**
+ * @brief KmlExport::CreateLineStringPlacemark Adds a line segment which is colored according to the
+ * vehicle's speed.
+ * @param startPoint Beginning point along line
+ * @param endPoint End point point along line
+ * @return Returns the placemark containing the line segment
+ */
+PlacemarkPtr KmlExport::CreateLineStringPlacemark(const TrackSample &startPoint, const TrackSample &endPoint)
+{
+    CoordinatesPtr coordinates = factory->CreateCoordinates();
+    coordinates->add_latlngalt(startPoint.point.latitude, startPoint.point.longitude, startPoint.point.altitude);
+    coordinates->add_latlngalt(endPoint.point.latitude,   endPoint.point.longitude,   endPoint.point.altitude);
+
+    LineStringPtr linestring = factory->CreateLineString();
+    linestring->set_extrude(true); // Extrude to ground
+    linestring->set_altitudemode(kmldom::ALTITUDEMODE_ABSOLUTE);
+    linestring->set_coordinates(coordinates);
+
+    // Pick the shared style closest to the average speed
+    double currentVelocity = (startPoint.point.groundspeed + endPoint.point.groundspeed)/2;
+    int bin = round(fmin(fabs(currentVelocity/maxVelocity), 1) * (numberOfVelocityStyles - 1));
+
     PlacemarkPtr placemark = factory->CreatePlacemark();
     placemark->set_geometry(linestring);
-    placemark->set_styleselector(styleMap);
+    placemark->set_styleurl(QString("#velocity_%1").arg(bin).toStdString());
     placemark->set_visibility(true);
 
-    // Create the timespan
-    TimeSpanPtr timeSpan = factory->CreateTimeSpan();
-    QDateTime startTime = QDateTime::currentDateTimeUtc().addMSecs(newPlacemarkTime); // FIXME: Make this a function of the true time, preferably gotten from the GPS
-    QDateTime endTime = QDateTime::currentDateTimeUtc().addMSecs(newPlacemarkTime);
-    timeSpan->set_begin(startTime.toString(dateTimeFormat).toStdString());
-    timeSpan->set_end(endTime.toString(dateTimeFormat).toStdString());
-
     // Set the name
-    QDateTime trackTime = QDateTime::currentDateTimeUtc().addMSecs(newPlacemarkTime); // FIXME: Make it a function of the realtime preferably gotten from the GPS
+    QDateTime trackTime = exportStartTime.addMSecs(endPoint.timeStamp);
     placemark->set_name(trackTime.toString(dateTimeFormat).toStdString());
 
     // Add a nice description to the track placemark
-    placemark->set_description(informationString.toStdString());
+    placemark->set_description(informationString(endPoint).toStdString());
 
     // Set the timespan
-    placemark->set_timeprimitive(timeSpan);
+    placemark->set_timeprimitive(createTimeSpan(startPoint.timeStamp, endPoint.timeStamp));
 
     return placemark;
 }
@@ -694,16 +708,15 @@ PlacemarkPtr KmlExport::CreateLineStringPlacemark(const LLAVCoordinates &startPo
  * @brief KmlExport::createTimespanPlacemark Creates a timespan placemark, which allows the
  * trajectory to be played forward in time. The placemark also contains pertinent data about
  * the vehicle's state at that timespan
- * @param timestampPoint
+ * @param sample
  * @param lastPlacemarkTime
- * @param newPlacemarkTime
  * @return Returns the placemark containing the timespan
  */
-PlacemarkPtr KmlExport::createTimespanPlacemark(const LLAVCoordinates &timestampPoint, quint32 lastPlacemarkTime, quint32 newPlacemarkTime)
+PlacemarkPtr KmlExport::createTimespanPlacemark(const TrackSample &sample, quint32 lastPlacemarkTime)
 {
     // Create coordinates
     CoordinatesPtr coordinates = factory->CreateCoordinates();
-    coordinates->add_latlngalt(timestampPoint.latitude, timestampPoint.longitude, timestampPoint.altitude);
+    coordinates->add_latlngalt(sample.point.latitude, sample.point.longitude, sample.point.altitude);
 
     // Create point, using previous coordinates
     PointPtr point = factory->CreatePoint();
@@ -711,23 +724,14 @@ PlacemarkPtr KmlExport::createTimespanPlacemark(const LLAVCoordinates &timestamp
     point->set_altitudemode(kmldom::ALTITUDEMODE_ABSOLUTE);
     point->set_coordinates(coordinates);
 
-    // Create the timespan
-    TimeSpanPtr timeSpan = factory->CreateTimeSpan();
-    QDateTime startTime = QDateTime::currentDateTimeUtc().addMSecs(lastPlacemarkTime); // FIXME: Make it a function of the realtime preferably gotten from the GPS
-    QDateTime endTime = QDateTime::currentDateTimeUtc().addMSecs(newPlacemarkTime);
-    timeSpan->set_begin(startTime.toString(dateTimeFormat).toStdString());
-    timeSpan->set_end(endTime.toString(dateTimeFormat).toStdString());
-
     // Create an icon style. This arrow icon will be rotated and colored to represent velocity
-    AttitudeActual::DataFields attitudeActualData = attitudeActual->getData();
-    AirspeedActual::DataFields airspeedActualData = airspeedActual->getData();
     IconStylePtr iconStyle = factory->CreateIconStyle();
-    iconStyle->set_color(mapVelocity2Color(airspeedActualData.CalibratedAirspeed));
-    iconStyle->set_heading(attitudeActualData.Yaw + 180); //Adding 180 degrees because the arrow art points down, i.e. south.
+    iconStyle->set_color(mapVelocity2Color(sample.airspeed));
+    iconStyle->set_heading(sample.yaw + 180); //Adding 180 degrees because the arrow art points down, i.e. south.
 
     // Create a line style. This defines the style for the "legs" connecting the points to the ground.
     LineStylePtr lineStyle = factory->CreateLineStyle();
-    lineStyle->set_color(mapVelocity2Color(timestampPoint.groundspeed));
+    lineStyle->set_color(mapVelocity2Color(sample.point.groundspeed));
 
     // Link the style to the icon
     StylePtr style = factory->CreateStyle();
@@ -737,8 +741,8 @@ PlacemarkPtr KmlExport::createTimespanPlacemark(const LLAVCoordinates &timestamp
     // Generate the placemark with all above attributes
     PlacemarkPtr placemark = factory->CreatePlacemark();
     placemark->set_geometry(point);
-    placemark->set_timeprimitive(timeSpan);
-    placemark->set_name(QString("%1").arg(timeStamp / 1000.0).toStdString());
+    placemark->set_timeprimitive(createTimeSpan(lastPlacemarkTime, sample.timeStamp));
+    placemark->set_name(QString("%1").arg(sample.timeStamp / 1000.0).toStdString());
     placemark->set_visibility(true);
 
     // Set the placemark to use the custom rotated arrow style
@@ -746,12 +750,283 @@ PlacemarkPtr KmlExport::createTimespanPlacemark(const LLAVCoordinates &timestamp
     placemark->set_styleselector(style);
 
     // Add a nice description to the placemark
-    placemark->set_description(informationString.toStdString());
+    placemark->set_description(informationString(sample).toStdString());
 
     return placemark;
 }
 
 
+/**
+ * @brief KmlExport::createTimeSpan Creates a timespan between two log times
+ * @param startTime Log time in [ms] at which the span begins
+ * @param endTime Log time in [ms] at which the span ends
+ */
+TimeSpanPtr KmlExport::createTimeSpan(quint32 startTime, quint32 endTime)
+{
+    TimeSpanPtr timeSpan = factory->CreateTimeSpan();
+    timeSpan->set_begin(exportStartTime.addMSecs(startTime).toString(dateTimeFormat).toStdString());
+    timeSpan->set_end(exportStartTime.addMSecs(endTime).toString(dateTimeFormat).toStdString());
+
+    return timeSpan;
+}
+
+
+/**
+ * @brief KmlExport::createRegion Creates a region bounding a part of the track,
+ * so that Google Earth only draws what is in view and large enough to matter
+ * @param samples Track the region bounds
+ * @param minLodPixels Smallest size on screen at which the region is drawn
+ * @param maxLodPixels Largest size on screen at which the region is drawn, -1 for no limit
+ */
+RegionPtr KmlExport::createRegion(const QVector<TrackSample> &samples, int minLodPixels, int maxLodPixels)
+{
+    double north = -90, south = 90, east = -180, west = 180;
+    double minAltitude = samples.first().point.altitude;
+    double maxAltitude = minAltitude;
+
+    foreach (const TrackSample &sample, samples) {
+        north = qMax(north, sample.point.latitude);
+        south = qMin(south, sample.point.latitude);
+        east = qMax(east, sample.point.longitude);
+        west = qMin(west, sample.point.longitude);
+        minAltitude = qMin(minAltitude, sample.point.altitude);
+        maxAltitude = qMax(maxAltitude, sample.point.altitude);
+    }
+
+    LatLonAltBoxPtr box = factory->CreateLatLonAltBox();
+    box->set_north(qMin(north + regionMargin, 90.0));
+    box->set_south(qMax(south - regionMargin, -90.0));
+    box->set_east(qMin(east + regionMargin, 180.0));
+    box->set_west(qMax(west - regionMargin, -180.0));
+    box->set_minaltitude(minAltitude);
+    box->set_maxaltitude(maxAltitude);
+    box->set_altitudemode(kmldom::ALTITUDEMODE_ABSOLUTE);
+
+    LodPtr lod = factory->CreateLod();
+    lod->set_minlodpixels(minLodPixels);
+    lod->set_maxlodpixels(maxLodPixels);
+
+    RegionPtr region = factory->CreateRegion();
+    region->set_latlonaltbox(box);
+    region->set_lod(lod);
+
+    return region;
+}
+
+
+/**
+ * @brief KmlExport::informationString Describes the vehicle state at a sample
+ */
+QString KmlExport::informationString(const TrackSample &sample)
+{
+    return QString("Latitude: %1 deg\nLongitude: %2 deg\nAltitude: %3 m\nAirspeed: %4 m/s\nGroundspeed: %5 m/s\n").arg(sample.point.latitude)
+            .arg(sample.point.longitude).arg(sample.point.altitude).arg(sample.airspeed).arg(sample.point.groundspeed);
+}
+
+
+/**
+ * @brief KmlExport::simplifyTrack Simplifies a track with the Douglas-Peucker algorithm
+ * @param samples Track to simplify
+ * @param tolerance Largest distance in [m] a dropped sample may lie from the simplified track
+ * @return Returns the indices of the kept samples in order. The first and last
+ * samples are always kept, and all of them are when the tolerance is 0.
+ */
+QVector<int> KmlExport::simplifyTrack(const QVector<TrackSample> &samples, double tolerance)
+{
+    const int n = samples.size();
+    QVector<int> kept;
+
+    if (tolerance <= 0 || n < 3) {
+        for (int i=0; i<n; i++)
+            kept.append(i);
+        return kept;
+    }
+
+    // Project onto a local flat earth, which is accurate enough over one segment
+    const double metersPerDegree = 111319.5;
+    const double cosLatitude = cos(samples[0].point.latitude * M_PI / 180.0);
+    QVector<double> x(n), y(n), z(n);
+    for (int i=0; i<n; i++) {
+        x[i] = (samples[i].point.longitude - samples[0].point.longitude) * metersPerDegree * cosLatitude;
+        y[i] = (samples[i].point.latitude - samples[0].point.latitude) * metersPerDegree;
+        z[i] = samples[i].point.altitude;
+    }
+
+    QVector<bool> keep(n, false);
+    keep[0] = true;
+    keep[n-1] = true;
+
+    // Split ranges from an explicit stack, long flights would nest too deep to recurse
+    QVector<QPair<int, int> > ranges;
+    ranges.append(qMakePair(0, n-1));
+
+    while (!ranges.isEmpty()) {
+        int first = ranges.last().first;
+        int last = ranges.last().second;
+        ranges.pop_back();
+
+        double dx = x[last] - x[first];
+        double dy = y[last] - y[first];
+        double dz = z[last] - z[first];
+        double length2 = dx*dx + dy*dy + dz*dz;
+
+        int farthest = -1;
+        double farthestDistance2 = tolerance * tolerance;
+
+        for (int i=first+1; i<last; i++) {
+            double px = x[i] - x[first];
+            double py = y[i] - y[first];
+            double pz = z[i] - z[first];
+
+            // Distance to the closest point of the line segment
+            if (length2 > 0) {
+                double t = qBound(0.0, (px*dx + py*dy + pz*dz) / length2, 1.0);
+                px -= t * dx;
+                py -= t * dy;
+                pz -= t * dz;
+            }
+
+            double distance2 = px*px + py*py + pz*pz;
+            if (distance2 > farthestDistance2) {
+                farthestDistance2 = distance2;
+                farthest = i;
+            }
+        }
+
+        if (farthest >= 0) {
+            keep[farthest] = true;
+            ranges.append(qMakePair(first, farthest));
+            ranges.append(qMakePair(farthest, last));
+        }
+    }
+
+    for (int i=0; i<n; i++) {
+        if (keep[i])
+            kept.append(i);
+    }
+
+    return kept;
+}
+
+
+/**
+ * @brief KmlExport::writeSegment Writes the current time segment to the output
+ * and starts the next one where it ended.
+ *
+ * Each segment is a folder with its time span, holding a coarse overview that is
+ * drawn while the segment is small on screen and the simplified track, which is
+ * only loaded once the segment is close enough to need it.
+ */
+void KmlExport::writeSegment()
+{
+    // Nothing to draw with a single point
+    if (segment.size() < 2)
+        return;
+
+    segmentCount++;
+
+    writeText(QString("<Folder>\n<name>Segment %1 (%2 - %3 s)</name>\n").arg(segmentCount)
+              .arg(segment.first().timeStamp / 1000.0).arg(segment.last().timeStamp / 1000.0));
+    writeElement(createTimeSpan(segment.first().timeStamp, segment.last().timeStamp));
+
+    writeTrackFolder("Overview", segment,
+                     simplifyTrack(segment, qMax(simplificationTolerance, 1.0) * overviewToleranceFactor), false);
+    writeTrackFolder("Track", segment, simplifyTrack(segment, simplificationTolerance), true);
+
+    writeText("</Folder>\n");
+
+    // The next segment continues from the last point of this one
+    TrackSample lastSample = segment.last();
+    segment.clear();
+    segment.append(lastSample);
+}
+
+
+/**
+ * @brief KmlExport::writeTrackFolder Writes one level of detail of a segment
+ * @param name Name of the folder
+ * @param samples All samples of the segment
+ * @param kept Indices of the samples left after simplification
+ * @param detailed True for the close up level, which adds the ground track,
+ * the wall axes and the timestamp arrows
+ */
+void KmlExport::writeTrackFolder(const QString &name, const QVector<TrackSample> &samples, const QVector<int> &kept, bool detailed)
+{
+    writeText(QString("<Folder>\n<name>%1</name>\n").arg(name));
+    if (detailed)
+        writeElement(createRegion(samples, detailMinLodPixels, -1));
+    else
+        writeElement(createRegion(samples, 0, detailMinLodPixels));
+
+    // Colored track
+    for (int i=1; i<kept.size(); i++)
+        writeElement(CreateLineStringPlacemark(samples[kept[i-1]], samples[kept[i]]));
+
+    if (detailed) {
+        // Create an array of lines which will make the wall axes. The lowest
+        // one doubles as the ground track.
+        QVector<CoordinatesPtr> wallAxes;
+        for (int i=0; i<numberOfWallAxes; i++)
+            wallAxes.append(factory->CreateCoordinates());
+
+        foreach (int idx, kept) {
+            for (int i=0; i<numberOfWallAxes; i++)
+                wallAxes[i]->add_latlngalt(samples[idx].point.latitude, samples[idx].point.longitude, i*wallAxesSeparation + homeLocationData.Altitude);
+        }
+
+        // Ground track
+        {
+            LineStringPtr linestring = factory->CreateLineString();
+            linestring->set_extrude(false); // Do not extrude to ground
+            linestring->set_altitudemode(kmldom::ALTITUDEMODE_CLAMPTOGROUND);
+            linestring->set_coordinates(wallAxes[0]);
+
+            MultiGeometryPtr multiGeometry = factory->CreateMultiGeometry();
+            multiGeometry->add_geometry(linestring);
+
+            PlacemarkPtr placemark = factory->CreatePlacemark();
+            placemark->set_geometry(multiGeometry);
+            placemark->set_styleurl("#ts_2_tb");
+            placemark->set_name("Ground track");
+
+            writeElement(placemark);
+        }
+
+        // Wall axes
+        FolderPtr folder = factory->CreateFolder();
+        folder->set_name("Wall axes");
+        for (int i=0; i<numberOfWallAxes; i++) {
+            LineStringPtr linestring = factory->CreateLineString();
+            linestring->set_extrude(false); // Do not extrude to ground
+            linestring->set_altitudemode(kmldom::ALTITUDEMODE_ABSOLUTE);
+            linestring->set_coordinates(wallAxes[i]);
+
+            MultiGeometryPtr multiGeometry = factory->CreateMultiGeometry();
+            multiGeometry->add_geometry(linestring);
+
+            PlacemarkPtr placemark = factory->CreatePlacemark();
+            placemark->set_geometry(multiGeometry);
+            placemark->set_styleurl("#ts_1_tb");
+
+            folder->add_feature(placemark);
+        }
+        writeElement(folder);
+
+        // Every 2 seconds generate a time stamp
+        writeText("<Folder>\n<name>Arrows</name>\n");
+        foreach (const TrackSample &sample, samples) {
+            if (sample.timeStamp - lastPlacemarkTime > 2000) {
+                writeElement(createTimespanPlacemark(sample, lastPlacemarkTime));
+                lastPlacemarkTime = sample.timeStamp;
+            }
+        }
+        writeText("</Folder>\n");
+    }
+
+    writeText("</Folder>\n");
+}
+
+
 /**
  * @brief KmlExport::mapVelocity2Color Maps a velocity magnitude onto a color.
  * @param velocity Vehicle velocity in [m/s]
@@ -806,47 +1081,17 @@ void KmlExport::positionActualUpdated(UAVObject *obj)
     newPoint.altitude = LLA[2];
     newPoint.groundspeed = sqrt(velocityActualData.North*velocityActualData.North + velocityActualData.East*velocityActualData.East);
 
-    // Update UAV info string
-    informationString.clear();
-    informationString.append(QString("Latitude: %1 deg\nLongitude: %2 deg\nAltitude: %3 m\nAirspeed: %4 m/s\nGroundspeed: %5 m/s\n").arg(newPoint.latitude)
-                             .arg(newPoint.longitude).arg(newPoint.altitude).arg(airspeedActualData.CalibratedAirspeed).arg(newPoint.groundspeed));
-
-    // In case this is the first time through, copy data and exit
-    static bool firstPoint;
-
-    if (firstPoint == false) {
-        oldPoint.latitude = newPoint.latitude;
-        oldPoint.longitude = newPoint.longitude;
-        oldPoint.altitude = newPoint.altitude;
-        oldPoint.groundspeed = newPoint.groundspeed;
-
-        firstPoint = true;
-        return;
-    }
-
-    // Create wall axes
-    for (int i=0; i<numberOfWallAxes; i++){
-        wallAxes[i]->add_latlngalt(newPoint.latitude, newPoint.longitude, i*wallAxesSeparation + homeLocationData.Altitude);
-    }
-
-    // Create colored tracks and add to the KML document
-    PlacemarkPtr newPlacemark = CreateLineStringPlacemark(oldPoint, newPoint, timeStamp);
-    trackFolder->add_feature(newPlacemark);
-
-    // Every 2 seconds generate a time stamp
-    if (timeStamp - lastPlacemarkTime > 2000) {
-
-        PlacemarkPtr newPlacemarkTimestamp = createTimespanPlacemark(newPoint, lastPlacemarkTime, timeStamp);
-        timestampFolder->add_feature(newPlacemarkTimestamp);
-        lastPlacemarkTime = timeStamp;
-    }
+    TrackSample sample;
+    sample.point = newPoint;
+    sample.timeStamp = timeStamp;
+    sample.airspeed = airspeedActualData.CalibratedAirspeed;
+    sample.yaw = attitudeActual->getData().Yaw;
 
-    // Copy newPoint to oldPoint
-    oldPoint.latitude = newPoint.latitude;
-    oldPoint.longitude = newPoint.longitude;
-    oldPoint.altitude = newPoint.altitude;
-    oldPoint.groundspeed = newPoint.groundspeed;
+    // Write out the segment once it spans its full duration
+    if (!segment.isEmpty() && timeStamp - segment.first().timeStamp >= segmentDuration)
+        writeSegment();
 
+    segment.append(sample);
 }
 
 void KmlExport::homeLocationUpdated(UAVObject *obj)
@@ -33,6 +33,8 @@
 #include <QTimer>
 #include <QDebug>
 #include <QBuffer>
+#include <QDateTime>
+#include <QVector>
 #include <math.h>
 
 #include "kml/base/file.h"
@@ -60,6 +62,15 @@ struct LLAVCoordinates
     double groundspeed; //in [m/s]
 };
 
+// One exported position along with the vehicle state shown in its balloon
+struct TrackSample
+{
+    LLAVCoordinates point;
+    quint32 timeStamp;  //in [ms] since the start of the log
+    double airspeed;    //in [m/s]
+    double yaw;         //in [deg]
+};
+
 /**
  * @class KmlExport generates a KML file showing the flight path from a UAVTalk
  * log path that is viewable in Google Earth.
@@ -69,6 +80,7 @@ class KmlExport : public QObject
     Q_OBJECT
 public:
     explicit KmlExport(QString inputFileName, QString outputFileName);
+    ~KmlExport();
     qint64 bytesAvailable() const;
     qint64 bytesToWrite() { return logFile.bytesToWrite(); }
     bool open();
@@ -78,6 +90,13 @@ public:
     bool stopExport();
     bool exportToKML();
 
+    //! Largest distance in [m] a dropped sample may lie from the exported track. 0 keeps every sample.
+    void setSimplificationTolerance(double meters) { simplificationTolerance = meters; }
+    //! Length in [s] of the time segments the track is split into
+    void setSegmentDuration(quint32 seconds) { segmentDuration = seconds * 1000; }
+
+    static QVector<int> simplifyTrack(const QVector<TrackSample> &samples, double tolerance);
+
 private slots:
     void gpsPositionUpdated(UAVObject *);
     void homeLocationUpdated(UAVObject *);
@@ -107,25 +126,34 @@ private:
     GPSPosition::DataFields gpsPositionData;
     HomeLocation::DataFields homeLocationData;
 
-    DocumentPtr document;
-    FolderPtr trackFolder;
-    FolderPtr timestampFolder;
     KmlFactory *factory;
 
     QString outputFileName;
-    LLAVCoordinates oldPoint;
+    QIODevice *kmlOutput;
     quint32 timeStamp;
     quint32 lastPlacemarkTime;
-    QString informationString;
-    QVector<CoordinatesPtr> wallAxes;
+    QDateTime exportStartTime;
     static QString dateTimeFormat;
 
+    double simplificationTolerance;
+    quint32 segmentDuration;
+    QVector<TrackSample> segment;
+    int segmentCount;
+
     void parseLogFile();
+    void writeElement(const ElementPtr &element);
+    void writeText(const QString &text);
+    void writeSegment();
+    void writeTrackFolder(const QString &name, const QVector<TrackSample> &samples, const QVector<int> &kept, bool detailed);
+    RegionPtr createRegion(const QVector<TrackSample> &samples, int minLodPixels, int maxLodPixels);
+    TimeSpanPtr createTimeSpan(quint32 startTime, quint32 endTime);
+    QString informationString(const TrackSample &sample);
     StylePtr createGroundTrackStyle();
     StyleMapPtr createWallAxesStyle();
     StyleMapPtr createCustomBalloonStyle();
-    PlacemarkPtr CreateLineStringPlacemark(const LLAVCoordinates &startPoint, const LLAVCoordinates &endPoint, quint32 newPlacemarkTime);
-    PlacemarkPtr createTimespanPlacemark(const LLAVCoordinates &point, quint32 lastPlacemarkTime, quint32 newPlacemarkTime);
+    StyleMapPtr createVelocityStyle(int bin);
+    PlacemarkPtr CreateLineStringPlacemark(const TrackSample &startPoint, const TrackSample &endPoint);
+    PlacemarkPtr createTimespanPlacemark(const TrackSample &sample, quint32 lastPlacemarkTime);
 
     kmlbase::Color32 mapVelocity2Color(double velocity, quint8 alpha = 255);
 };
@@ -30,6 +30,7 @@
 #include <QStringList>
 #include <QDir>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QList>
 #include <QMessageBox>
 #include <QWriteLocker>
@@ -117,8 +118,17 @@ void KmlExportPlugin::exportToKML()
         }
     }
 
+    // Get the track simplification tolerance. Long logs are unwieldy in Google Earth with every sample.
+    bool ok;
+    double tolerance = QInputDialog::getDouble(NULL, tr("Track simplification"),
+                                               tr("Largest deviation from the logged track [m] (0 keeps every sample):"),
+                                               1.0, 0, 100, 1, &ok);
+    if (!ok)
+        return;
+
     // Create kmlExport instance, and trigger export
     KmlExport kmlExport(inputFileName, localizedOutputFileName);
+    kmlExport.setSimplificationTolerance(tolerance);
     kmlExport.exportToKML();
 }
 
@@ -0,0 +1,155 @@
+/**
+ ******************************************************************************
+ *
+ * @file       compactlog.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @brief      Decoder for the compact format of onboard logs
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "compactlog.h"
+#include "uavtalk.h"
+
+#include <QHash>
+#include <QtEndian>
+#include <string.h>
+
+// Layout of the compact format, must match flight/Modules/Logging/logging.c
+static const char COMPACT_MARKER[] = "##compact\n";
+static const int COMPACT_MARKER_SEARCH = 1024;
+static const quint8 COMPACT_TIME = 0xFF;
+// Blackbox frames use the code 0xFE and trace blocks 0xFD, the table describes
+// them as BlackboxFrame and TraceBlock
+static const quint8 COMPACT_MULTI_INSTANCE = 0x01;
+static const int COMPACT_ENTRY_LENGTH = 8;
+
+// Timestamped frames as UAVTalkSendObjectTimestamped() writes them
+static const quint8 SYNC_VAL = 0x3C;
+static const quint8 TYPE_OBJ_TS = 0x80 | 0x20;
+static const int HEADER_LENGTH = 8;
+static const int TIMESTAMP_LENGTH = 2;
+
+namespace {
+struct CompactEntry
+{
+    quint32 objId;
+    quint16 size;
+    bool multiInstance;
+};
+}
+
+/**
+ * @brief CompactLog::isCompact check for the marker that follows the text header
+ */
+bool CompactLog::isCompact(const QByteArray &log)
+{
+    int pos = log.indexOf(COMPACT_MARKER);
+    return pos >= 0 && pos < COMPACT_MARKER_SEARCH;
+}
+
+/**
+ * @brief CompactLog::toUAVTalk convert a compact log
+ * @param log the log as read from the board
+ * @return the same log with timestamped UAVTalk frames, logs that are not
+ * compact are returned unchanged. Records of unknown codes are skipped.
+ */
+QByteArray CompactLog::toUAVTalk(const QByteArray &log)
+{
+    if (!isCompact(log))
+        return log;
+
+    int markerPos = log.indexOf(COMPACT_MARKER);
+    const quint8 *data = (const quint8 *) log.constData();
+    int size = log.size();
+    int pos = markerPos + strlen(COMPACT_MARKER);
+
+    // The text header is kept as it is
+    QByteArray out = log.left(markerPos);
+    out.reserve(size * 3);
+
+    QHash<quint8, CompactEntry> table;
+    while (pos < size && data[pos] != COMPACT_TIME) {
+        if (pos + COMPACT_ENTRY_LENGTH > size)
+            return out;
+        CompactEntry entry;
+        entry.objId = qFromLittleEndian<quint32>(&data[pos + 1]);
+        entry.size = qFromLittleEndian<quint16>(&data[pos + 5]);
+        entry.multiInstance = data[pos + 7] & COMPACT_MULTI_INSTANCE;
+        table.insert(data[pos], entry);
+        pos += COMPACT_ENTRY_LENGTH;
+    }
+    pos++;
+
+    quint32 time = 0;
+    quint8 frame[HEADER_LENGTH + 2 + TIMESTAMP_LENGTH];
+    while (pos < size) {
+        quint8 code = data[pos];
+
+        if (code == COMPACT_TIME) {
+            if (pos + 5 > size)
+                break;
+            time = qFromLittleEndian<quint32>(&data[pos + 1]);
+            pos += 5;
+            continue;
+        }
+
+        if (!table.contains(code)) {
+            // Corrupted, look for the next record that makes sense
+            pos++;
+            continue;
+        }
+
+        const CompactEntry &entry = table[code];
+        int recordHeader = entry.multiInstance ? 4 : 2;
+        if (pos + recordHeader + entry.size > size)
+            break;
+        time += data[pos + 1];
+
+        // Header, instance and timestamp, then the data and the checksum
+        int frameHeader = HEADER_LENGTH;
+        frame[0] = SYNC_VAL;
+        frame[1] = TYPE_OBJ_TS;
+        qToLittleEndian<quint32>(entry.objId, &frame[4]);
+        if (entry.multiInstance) {
+            frame[frameHeader++] = data[pos + 2];
+            frame[frameHeader++] = data[pos + 3];
+        }
+        qToLittleEndian<quint16>(time & 0xFFFF, &frame[frameHeader]);
+        frameHeader += TIMESTAMP_LENGTH;
+        qToLittleEndian<quint16>(frameHeader + entry.size, &frame[2]);
+
+        QByteArray packet((const char *) frame, frameHeader);
+        packet.append((const char *) &data[pos + recordHeader], entry.size);
+        packet.append((char) UAVTalk::frameCrc((const quint8 *) packet.constData(), packet.size()));
+        out.append(packet);
+
+        pos += recordHeader + entry.size;
+    }
+
+    return out;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,52 @@
+/**
+ ******************************************************************************
+ *
+ * @file       compactlog.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @brief      Decoder for the compact format of onboard logs
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef COMPACTLOG_H
+#define COMPACTLOG_H
+
+#include <QByteArray>
+
+/**
+ * Onboard logs can be written in a compact format that replaces the
+ * UAVTalk framing of every sample with a one byte object code and a one
+ * byte time difference, see flight/Modules/Logging/logging.c. This turns
+ * them back into timestamped UAVTalk, the format the log tools read.
+ */
+class CompactLog
+{
+public:
+    static bool isCompact(const QByteArray &log);
+    static QByteArray toUAVTalk(const QByteArray &log);
+};
+
+#endif // COMPACTLOG_H
+
+/**
+ * @}
+ * @}
+ */
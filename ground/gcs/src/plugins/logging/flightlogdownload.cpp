@@ -34,11 +34,21 @@
 #include <extensionsystem/pluginmanager.h>
 
 #include "loggingstats.h"
+#include "compactlog.h"
 
 #include <QDateTime>
 #include <QFile>
 #include <QFileDialog>
 #include <QDebug>
+#include <climits>
+
+//! Period of the acknowledgements while streaming, a period without any
+//! sector asks for the missing ones again
+#define STREAM_ACK_PERIOD_MS 100
+//! Acknowledge after this many sectors, half of the window of the board
+#define STREAM_ACK_SECTORS 4
+//! Firmware that does not stream sends nothing, use sector requests then
+#define STREAM_START_TIMEOUT_MS 1000
 
 FlightLogDownload::FlightLogDownload(QWidget *parent) :
     QDialog(parent),
@@ -52,6 +62,15 @@ FlightLogDownload::FlightLogDownload(QWidget *parent) :
     UAVObjectManager *uavoManager = pm->getObject<UAVObjectManager>();
     loggingStats = LoggingStats::GetInstance(uavoManager);
     Q_ASSERT(loggingStats);
+    streamAck = LoggingStreamAck::GetInstance(uavoManager);
+    Q_ASSERT(streamAck);
+
+    // Sectors come in as instances of LoggingStream, the ones beyond the
+    // first are created when they are received for the first time
+    foreach (UAVObject *obj, uavoManager->getObjectInstancesVector(LoggingStream::OBJID))
+        connect(obj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(sectorReceived(UAVObject*)));
+    connect(uavoManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newInstance(UAVObject*)));
+    connect(&streamTimer, SIGNAL(timeout()), this, SLOT(streamTimeout()));
 
     connect(ui->fileNameButton, SIGNAL(clicked()), this, SLOT(getFilename()));
     connect(ui->saveButton, SIGNAL(clicked()), this, SLOT(startDownload()));
@@ -98,6 +117,18 @@ void FlightLogDownload::updateReceived()
         return;
     case DL_COMPLETE:
         return;
+    case DL_STREAMING:
+        if (logging.Operation == LoggingStats::OPERATION_ERROR) {
+            streamTimer.stop();
+            dl_state = DL_IDLE;
+
+            UAVObject::Metadata mdata = loggingStats->getMetadata();
+            UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
+            loggingStats->setMetadata(mdata);
+
+            ui->lb_operationStatus->setText("Download error.");
+        }
+        return;
     case DL_DOWNLOADING:
         break;
     }
@@ -117,21 +148,9 @@ void FlightLogDownload::updateReceived()
         ui->lb_operationStatus->setText("Downloading...");
         break;
     case LoggingStats::OPERATION_COMPLETE:
-    {
         log.append((char *) logging.FileSector, LoggingStats::FILESECTOR_NUMELEM);
-
-        dl_state = DL_IDLE;
-
-        mdata = loggingStats->getMetadata();
-        UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
-        loggingStats->setMetadata(mdata);
-
-        logFile->write(log);
-        logFile->close();
-
-        ui->lb_operationStatus->setText("Download complete.");
+        finishDownload();
         break;
-    }
     case LoggingStats::OPERATION_ERROR:
         dl_state = DL_IDLE;
 
@@ -176,15 +195,159 @@ void FlightLogDownload::startDownload()
     UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_ONCHANGE);
     loggingStats->setMetadata(mdata);
 
-    qDebug() << "Download file id: " << file_id;
+    qDebug() << "Stream file id: " << file_id;
+    streamSectors.clear();
+    nextSector = 0;
+    lastSector = UINT_MAX;
+    ackedSector = 0;
+    streamProgress = false;
+    streamStarted = false;
+    streamTimer.start(STREAM_START_TIMEOUT_MS);
+
+    dl_state = DL_STREAMING;
+    logging.Operation = LoggingStats::OPERATION_STREAM;
+    logging.FileRequest = file_id;
+    loggingStats->setData(logging);
+    loggingStats->updated();
+    ui->lb_operationStatus->setText("Downloading...");
+}
+
+/**
+ * @brief FlightLogDownload::startSectorDownload fetch the file one sector
+ * at a time for firmware that can not stream it
+ */
+void FlightLogDownload::startSectorDownload()
+{
+    LoggingStats::DataFields logging = loggingStats->getData();
+
+    qDebug() << "Download file id: " << logging.FileRequest;
     dl_state = DL_DOWNLOADING;
     logging.Operation = LoggingStats::OPERATION_DOWNLOAD;
-    logging.FileRequest = file_id;
     logging.FileSectorNum = 0;
     loggingStats->setData(logging);
     loggingStats->updated();
 }
 
+/**
+ * @brief FlightLogDownload::finishDownload write the file and restore the
+ * update mode of LoggingStats
+ */
+void FlightLogDownload::finishDownload()
+{
+    streamTimer.stop();
+    dl_state = DL_IDLE;
+
+    UAVObject::Metadata mdata = loggingStats->getMetadata();
+    UAVObject::SetFlightTelemetryUpdateMode(mdata, UAVObject::UPDATEMODE_MANUAL);
+    loggingStats->setMetadata(mdata);
+
+    // Compact logs are stored as UAVTalk so that the log tools can read them
+    logFile->write(CompactLog::toUAVTalk(log));
+    logFile->close();
+
+    ui->lb_operationStatus->setText("Download complete.");
+}
+
+void FlightLogDownload::newInstance(UAVObject *obj)
+{
+    if (obj->getObjID() == LoggingStream::OBJID)
+        connect(obj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(sectorReceived(UAVObject*)));
+}
+
+/**
+ * @brief FlightLogDownload::sectorReceived store a streamed sector. Sectors
+ * that arrive ahead of a lost one are held back until the gap is filled.
+ */
+void FlightLogDownload::sectorReceived(UAVObject *obj)
+{
+    if (dl_state != DL_STREAMING)
+        return;
+
+    LoggingStream *stream = qobject_cast<LoggingStream *>(obj);
+    if (stream == NULL)
+        return;
+
+    LoggingStream::DataFields sector = stream->getData();
+    if (sector.SectorNum < nextSector || streamSectors.contains(sector.SectorNum))
+        return;
+
+    if (!streamStarted) {
+        streamStarted = true;
+        streamTimer.start(STREAM_ACK_PERIOD_MS);
+    }
+    streamProgress = true;
+
+    int length = qMin((int) sector.Length, (int) LoggingStream::DATA_NUMELEM);
+    if (length < (int) LoggingStream::DATA_NUMELEM)
+        lastSector = sector.SectorNum;
+    streamSectors.insert(sector.SectorNum, QByteArray((const char *) sector.Data, length));
+
+    // Append everything that is contiguous now
+    while (!streamSectors.isEmpty() && streamSectors.firstKey() == nextSector) {
+        log.append(streamSectors.take(nextSector));
+        nextSector++;
+    }
+    ui->sectorLabel->setText(QString::number(nextSector));
+
+    if (lastSector != UINT_MAX && nextSector > lastSector) {
+        // The board closes the file once it sees this
+        sendStreamAck(false);
+        finishDownload();
+    } else if (nextSector - ackedSector >= STREAM_ACK_SECTORS || !streamSectors.isEmpty()) {
+        sendStreamAck(false);
+    }
+}
+
+/**
+ * @brief FlightLogDownload::sendStreamAck tell the board which sectors
+ * arrived and which ones have to be sent again
+ * @param timeout when nothing arrived for a while all the missing sectors
+ * are asked for, otherwise only the gaps before the last received one
+ */
+void FlightLogDownload::sendStreamAck(bool timeout)
+{
+    LoggingStreamAck::DataFields ack;
+    ack.NextSector = nextSector;
+    ack.Resend = 0;
+
+    quint32 highest = streamSectors.isEmpty() ? nextSector : streamSectors.lastKey();
+    for (quint32 i = 0; i < 32; i++) {
+        quint32 sector = nextSector + i;
+        if (lastSector != UINT_MAX && sector > lastSector)
+            break;
+        if (!timeout && sector >= highest)
+            break;
+        if (!streamSectors.contains(sector))
+            ack.Resend |= (1u << i);
+    }
+
+    streamAck->setData(ack);
+    streamAck->updated();
+    ackedSector = nextSector;
+}
+
+/**
+ * @brief FlightLogDownload::streamTimeout fall back to sector requests when
+ * the board does not stream and ask for lost sectors when the stream stalls
+ */
+void FlightLogDownload::streamTimeout()
+{
+    if (dl_state != DL_STREAMING) {
+        streamTimer.stop();
+        return;
+    }
+
+    if (!streamStarted) {
+        streamTimer.stop();
+        startSectorDownload();
+        return;
+    }
+
+    if (!streamProgress)
+        sendStreamAck(true);
+    streamProgress = false;
+}
+
 /**
  * @}
  * @}
@@ -32,7 +32,11 @@
 #include <QDialog>
 #include <QByteArray>
 #include <QFile>
+#include <QMap>
+#include <QTimer>
 #include "loggingstats.h"
+#include "loggingstream.h"
+#include "loggingstreamack.h"
 
 namespace Ui {
 class FlightLogDownload;
@@ -50,13 +54,30 @@ private slots:
     void updateReceived();
     void startDownload();
     void getFilename();
+    void newInstance(UAVObject *obj);
+    void sectorReceived(UAVObject *obj);
+    void streamTimeout();
 
 private:
+    void sendStreamAck(bool timeout);
+    void finishDownload();
+    void startSectorDownload();
+
     LoggingStats *loggingStats;
+    LoggingStreamAck *streamAck;
     QByteArray log;
     QFile *logFile;
 
-    enum LOG_DL_STATE {DL_IDLE, DL_DOWNLOADING, DL_COMPLETE} dl_state;
+    //! Sectors received ahead of a lost one
+    QMap<quint32, QByteArray> streamSectors;
+    quint32 nextSector;
+    quint32 lastSector;
+    quint32 ackedSector;
+    bool streamProgress;
+    bool streamStarted;
+    QTimer streamTimer;
+
+    enum LOG_DL_STATE {DL_IDLE, DL_DOWNLOADING, DL_STREAMING, DL_COMPLETE} dl_state;
 
     Ui::FlightLogDownload *ui;
 };
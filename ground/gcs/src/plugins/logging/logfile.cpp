@@ -29,16 +29,134 @@
 #include <QDebug>
 #include <QtGlobal>
 #include <QTextStream>
- #include <QMessageBox>
+#include <QMessageBox>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
 
 // autogenerated version info string. MUST GO BEFORE coreconstants.h INCLUDE
 #include "../../../../../build/ground/gcs/gcsversioninfo.h"
 
 #include <coreplugin/coreconstants.h>
 
+//! Size of the header in front of every packet: timestamp and data size
+#define LOG_PACKET_HEADER_SIZE (sizeof(quint32) + sizeof(qint64))
+
+//! "TLLI" in little endian, also rejects indexes written on another endianness
+static const quint32 LOG_INDEX_MAGIC = 0x494c4c54;
+static const quint32 LOG_INDEX_VERSION = 1;
+
+//! Number of packets indexed before they are published to the replay
+#define LOG_INDEX_BATCH 1024
+
+LogIndexThread::LogIndexThread(const QString &fileName, qint64 bodyStart) :
+    m_fileName(fileName),
+    m_bodyStart(bodyStart),
+    m_running(true),
+    m_nonSequential(false)
+{
+}
+
+int LogIndexThread::getEntries(QVector<LogIndexEntry> &entries, int from)
+{
+    QMutexLocker lock(&m_entriesMtx);
+
+    if (from >= m_entries.size())
+        return 0;
+
+    int count = m_entries.size() - from;
+    entries.reserve(entries.size() + count);
+    for (int i = from; i < m_entries.size(); i++)
+        entries.append(m_entries.at(i));
+
+    return count;
+}
+
+/**
+ * Scan the log with a file handle of its own, then save the index next to
+ * the log so the next replay of the same file does not need to scan it.
+ */
+void LogIndexThread::run()
+{
+    QFile log(m_fileName);
+    if (!log.open(QIODevice::ReadOnly))
+        return;
+
+    log.seek(m_bodyStart);
+
+    QVector<LogIndexEntry> batch;
+    quint32 lastTimeStamp = 0;
+
+    while (m_running && !log.atEnd()) {
+        qint64 pos = log.pos();
+        quint32 timeStamp;
+        qint64 dataSize;
+
+        if (log.read((char *) &timeStamp, sizeof(timeStamp)) != sizeof(timeStamp) ||
+                log.read((char *) &dataSize, sizeof(dataSize)) != sizeof(dataSize))
+            break;
+
+        //Check if dataSize sync bytes are correct.
+        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
+        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0) {
+            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(pos, 0, 16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000, 0, 16) << ", but expected 0x""00"".";
+            log.seek(pos + 1);
+            continue;
+        }
+
+        // A packet cut short at the end of the file is not replayed
+        if (pos + (qint64) LOG_PACKET_HEADER_SIZE + dataSize > log.size())
+            break;
+
+        //Check if timestamps are sequential.
+        if (!batch.isEmpty() || !m_entries.isEmpty()) {
+            if (timeStamp < lastTimeStamp) {
+                qDebug() << "Timestamp: " << lastTimeStamp << " " << timeStamp;
+                m_nonSequential = true;
+            }
+        }
+        lastTimeStamp = timeStamp;
+
+        LogIndexEntry entry = { timeStamp, (quint32) pos };
+        batch.append(entry);
+        if (batch.size() >= LOG_INDEX_BATCH) {
+            QMutexLocker lock(&m_entriesMtx);
+            m_entries += batch;
+            batch.clear();
+        }
+
+        log.seek(pos + LOG_PACKET_HEADER_SIZE + dataSize);
+    }
+
+    {
+        QMutexLocker lock(&m_entriesMtx);
+        m_entries += batch;
+    }
+
+    // Only this thread changes the entries, they can be saved without the lock
+    if (!m_running || m_entries.isEmpty())
+        return;
+
+    // The index is only an optimization, failing to save it is not an error
+    QSaveFile out(m_fileName + ".idx");
+    if (!out.open(QIODevice::WriteOnly))
+        return;
+
+    LogIndexHeader header = { LOG_INDEX_MAGIC, LOG_INDEX_VERSION, (quint64) log.size(),
+                              (quint64) m_bodyStart, (quint32) m_entries.size(), 0 };
+    out.write((const char *) &header, sizeof(header));
+    out.write((const char *) m_entries.constData(), m_entries.size() * sizeof(LogIndexEntry));
+    out.commit();
+}
+
 LogFile::LogFile(QObject *parent) :
     QIODevice(parent),
-    timestampBufferIdx(0)
+    mappedIndex(NULL),
+    mappedCount(0),
+    indexThread(NULL),
+    logMap(NULL),
+    logSize(0),
+    bodyStart(0)
 {
     connect(&timer, SIGNAL(timeout()), this, SLOT(timerFired()));
 }
@@ -124,6 +242,8 @@ bool LogFile::open(OpenMode mode) {
             file.seek(0);
         }
 
+        bodyStart = file.pos();
+
     }
     else
     {
@@ -144,6 +264,27 @@ void LogFile::close()
 
     if (timer.isActive())
         timer.stop();
+
+    if (indexThread) {
+        indexThread->stop();
+        indexThread->wait();
+        delete indexThread;
+        indexThread = NULL;
+    }
+    builtIndex.clear();
+
+    if (mappedIndex) {
+        indexFile.unmap((uchar *) mappedIndex - sizeof(LogIndexHeader));
+        mappedIndex = NULL;
+        mappedCount = 0;
+    }
+    indexFile.close();
+
+    if (logMap) {
+        file.unmap((uchar *) logMap);
+        logMap = NULL;
+    }
+
     file.close();
     QIODevice::close();
 }
@@ -177,63 +318,109 @@ qint64 LogFile::bytesAvailable() const
     return dataBuffer.size();
 }
 
-void LogFile::timerFired()
+/**
+ * Read from the log, out of the mapping when there is one
+ */
+bool LogFile::readAt(qint64 pos, void *data, qint64 size)
 {
-    qint64 dataSize;
+    if (pos < 0 || pos + size > logSize)
+        return false;
 
-    if(file.bytesAvailable() > 4)
-    {
+    if (logMap) {
+        memcpy(data, logMap + pos, size);
+        return true;
+    }
 
-        int time;
-        time = myTime.elapsed();
+    return file.seek(pos) && file.read((char *) data, size) == size;
+}
 
-        //Read packets
-        while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
-        {
-            lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+/**
+ * Hand the packets of one timer tick to the listeners. A decoder connected
+ * to replayFrames() gets them in place, otherwise they are queued for the
+ * QIODevice interface.
+ */
+void LogFile::deliverFrames(const QVector<QByteArray> &frames)
+{
+    if (frames.isEmpty())
+        return;
 
-            file.seek(lastTimeStampPos+sizeof(lastTimeStamp));
+    if (receivers(SIGNAL(replayFrames(QVector<QByteArray>))) > 0) {
+        emit replayFrames(frames);
+        return;
+    }
 
-            file.read((char *) &dataSize, sizeof(dataSize));
+    mutex.lock();
+    foreach (const QByteArray &frame, frames)
+        dataBuffer.append(frame);
+    mutex.unlock();
+    emit readyRead();
+}
 
-            if (dataSize<1 || dataSize>(1024*1024)) {
-                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
-                stopReplay();
-                return;
-            }
-            if(file.bytesAvailable() < dataSize) {
-                stopReplay();
-                return;
-            }
+void LogFile::timerFired()
+{
+    QVector<QByteArray> frames;
+    bool finished = false;
 
-            mutex.lock();
-            dataBuffer.append(file.read(dataSize));
-            mutex.unlock();
-            emit readyRead();
+    int time;
+    time = myTime.elapsed();
 
-            if(file.bytesAvailable() < 4) {
-                stopReplay();
-                return;
-            }
+    //Read packets
+    while ((lastPlayTime + ((time - lastPlayTimeOffset)* playbackSpeed) > (lastTimeStamp-firstTimestamp)))
+    {
+        lastPlayTime += ((time - lastPlayTimeOffset)* playbackSpeed);
+        lastPlayTimeOffset = time;
+
+        qint64 dataSize = 0;
+        qint64 dataPos = lastTimeStampPos + LOG_PACKET_HEADER_SIZE;
+        readAt(lastTimeStampPos + sizeof(lastTimeStamp), &dataSize, sizeof(dataSize));
 
-            lastTimeStampPos = timestampPos[timestampBufferIdx];
-            lastTimeStamp = timestampBuffer[timestampBufferIdx];
-            timestampBufferIdx++;
+        if (dataSize<1 || dataSize>(1024*1024)) {
+            // Resume at the next packet the index resynchronized on
+            const LogIndexEntry *next = findByPos(lastTimeStampPos);
+            if (next == NULL) {
+                qDebug() << "Error: Logfile corrupted! Unlikely packet size: " << dataSize << "\n";
+                finished = true;
+                break;
+            }
+            lastTimeStampPos = next->pos;
+            lastTimeStamp = next->timestamp;
+            continue;
+        }
+        if (dataPos + dataSize > logSize) {
+            finished = true;
+            break;
+        }
 
-            lastPlayTimeOffset = time;
-            time = myTime.elapsed();
+        if (logMap) {
+            frames.append(QByteArray::fromRawData((const char *) logMap + dataPos, dataSize));
+        } else {
+            file.seek(dataPos);
+            frames.append(file.read(dataSize));
+        }
 
+        // Packets are back to back, the next one starts right after this one
+        lastTimeStampPos = dataPos + dataSize;
+        if (!readAt(lastTimeStampPos, &lastTimeStamp, sizeof(lastTimeStamp))) {
+            finished = true;
+            break;
         }
-    } else {
-        stopReplay();
+
+        time = myTime.elapsed();
     }
 
+    deliverFrames(frames);
+
+    if (finished)
+        stopReplay();
 }
 
+/**
+ * Start replaying the log. Packets are read sequentially out of the mapped
+ * file and handed to the decoder without copying them. The index is
+ * only needed to seek and to skip over corrupted data. It is loaded from
+ * the sidecar file when that matches the log, otherwise it is built in
+ * the background while the replay is already running.
+ */
 bool LogFile::startReplay() {
     dataBuffer.clear();
     myTime.restart();
@@ -241,49 +428,18 @@ bool LogFile::startReplay() {
     lastPlayTime = 0;
     playbackSpeed = 1;
 
-    //Read all log timestamps into array
-    timestampBuffer.clear(); //Save beginning of log for later use
-    timestampPos.clear();
-    quint64 logFileStartIdx = file.pos();
-    timestampBufferIdx = 0;
-    lastTimeStamp = 0;
-
-    while (!file.atEnd()){
-        qint64 dataSize;
-
-        //Get time stamp position
-        timestampPos.append(file.pos());
-
-        //Read timestamp and logfile packet size
-        file.read((char *) &lastTimeStamp, sizeof(lastTimeStamp));
-        file.read((char *) &dataSize, sizeof(dataSize));
-
-        //Check if dataSize sync bytes are correct.
-        //TODO: LIKELY AS NOT, THIS WILL FAIL TO RESYNC BECAUSE THERE IS TOO LITTLE INFORMATION IN THE STRING OF SIX 0x00
-        if ((dataSize & 0xFFFFFFFFFFFF0000)!=0){
-            qDebug() << "Wrong sync byte. At file location 0x"  << QString("%1").arg(file.pos(),0,16) << "Got 0x" << QString("%1").arg(dataSize & 0xFFFFFFFFFFFF0000,0,16) << ", but expected 0x""00"".";
-            file.seek(timestampPos.last()+1);
-            timestampPos.pop_back();
-            continue;
-        }
-
-        //Check if timestamps are sequential.
-        if (!timestampBuffer.isEmpty() && lastTimeStamp < timestampBuffer.last()){
-            QMessageBox msgBox;
-            msgBox.setText("Corrupted file.");
-            msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
-            msgBox.exec();
-
-            qDebug() << "Timestamp: " << timestampBuffer.last() << " " << lastTimeStamp;
-        }
+    // Packets are read straight out of the mapping, with plain reads as a fallback
+    logSize = file.size();
+    logMap = file.map(0, logSize);
+    if (logMap == NULL)
+        qDebug() << "Could not map " << file.fileName() << ", replaying from plain reads";
 
-        timestampBuffer.append(lastTimeStamp);
-
-        file.seek(timestampPos.last()+sizeof(lastTimeStamp)+sizeof(dataSize)+dataSize);
-    }
+    lastTimeStampPos = bodyStart;
+    lastTimeStamp = 0;
 
-    //Check if any timestamps were successfully read
-    if (timestampBuffer.size() == 0){
+    //Check if there is at least one packet in the log
+    if (bodyStart + (qint64) LOG_PACKET_HEADER_SIZE > logSize ||
+            !readAt(bodyStart, &lastTimeStamp, sizeof(lastTimeStamp))){
         QMessageBox msgBox;
         msgBox.setText("Empty logfile.");
         msgBox.setInformativeText("No log data can be found.");
@@ -292,13 +448,13 @@ bool LogFile::startReplay() {
         stopReplay();
         return false;
     }
+    firstTimestamp = lastTimeStamp;
 
-    //Reset to log beginning.
-    file.seek(logFileStartIdx+sizeof(lastTimeStamp));
-    lastTimeStampPos = timestampPos[0];
-    lastTimeStamp = timestampBuffer[0];
-    firstTimestamp = timestampBuffer[0];
-    timestampBufferIdx = 1;
+    if (!loadIndex()) {
+        indexThread = new LogIndexThread(file.fileName(), bodyStart);
+        connect(indexThread, SIGNAL(finished()), this, SLOT(indexFinished()));
+        indexThread->start(QThread::LowPriority);
+    }
 
     timer.setInterval(10);
     timer.start();
@@ -323,22 +479,143 @@ void LogFile::resumeReplay()
     timer.start();
 }
 
+/**
+ * Map the sidecar index of the log if it exists and still describes it
+ * @return true if the index can be used
+ */
+bool LogFile::loadIndex()
+{
+    indexFile.setFileName(file.fileName() + ".idx");
+
+    QFileInfo logInfo(file);
+    QFileInfo indexInfo(indexFile);
+    if (!indexInfo.exists() || indexInfo.lastModified() < logInfo.lastModified())
+        return false;
+
+    if (!indexFile.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 size = indexFile.size();
+    uchar *map = NULL;
+    if (size > (qint64) sizeof(LogIndexHeader))
+        map = indexFile.map(0, size);
+    if (map == NULL) {
+        indexFile.close();
+        return false;
+    }
+
+    const LogIndexHeader *header = (const LogIndexHeader *) map;
+    if (header->magic != LOG_INDEX_MAGIC || header->version != LOG_INDEX_VERSION ||
+            header->logSize != (quint64) file.size() || header->bodyStart != (quint64) bodyStart ||
+            header->count == 0 ||
+            size != (qint64) (sizeof(LogIndexHeader) + header->count * sizeof(LogIndexEntry))) {
+        qDebug() << "Ignoring stale log index " << indexFile.fileName();
+        indexFile.unmap(map);
+        indexFile.close();
+        return false;
+    }
+
+    mappedIndex = (const LogIndexEntry *) (map + sizeof(LogIndexHeader));
+    mappedCount = header->count;
+
+    return true;
+}
+
+/**
+ * Pick up the entries the background indexer found since the last call
+ */
+void LogFile::syncIndex()
+{
+    if (indexThread)
+        indexThread->getEntries(builtIndex, builtIndex.size());
+}
+
+void LogFile::indexRange(const LogIndexEntry **begin, const LogIndexEntry **end)
+{
+    if (mappedIndex) {
+        *begin = mappedIndex;
+        *end = mappedIndex + mappedCount;
+    } else {
+        syncIndex();
+        *begin = builtIndex.constData();
+        *end = *begin + builtIndex.size();
+    }
+}
+
+/**
+ * Find the first packet at or after a timestamp
+ * @return the packet, the last indexed one if the timestamp is past the
+ * indexed part of the log or NULL if nothing is indexed yet
+ */
+const LogIndexEntry *LogFile::findByTime(quint32 timestamp)
+{
+    const LogIndexEntry *begin, *end;
+    indexRange(&begin, &end);
+
+    if (begin == end)
+        return NULL;
+
+    const LogIndexEntry *entry = std::lower_bound(begin, end, timestamp,
+        [](const LogIndexEntry &e, quint32 t) { return e.timestamp < t; });
+
+    return entry == end ? end - 1 : entry;
+}
+
+/**
+ * Find the first indexed packet after a file position
+ * @return the packet or NULL if there is none indexed (yet)
+ */
+const LogIndexEntry *LogFile::findByPos(quint32 pos)
+{
+    const LogIndexEntry *begin, *end;
+    indexRange(&begin, &end);
+
+    const LogIndexEntry *entry = std::upper_bound(begin, end, pos,
+        [](quint32 p, const LogIndexEntry &e) { return p < e.pos; });
+
+    return entry == end ? NULL : entry;
+}
+
+void LogFile::indexFinished()
+{
+    if (sender() != indexThread)
+        return;
+
+    syncIndex();
+    bool nonSequential = indexThread->nonSequential();
+
+    indexThread->wait();
+    delete indexThread;
+    indexThread = NULL;
+
+    if (nonSequential) {
+        QMessageBox msgBox;
+        msgBox.setText("Corrupted file.");
+        msgBox.setInformativeText("Timestamps are not sequential. Playback may have unexpected behavior"); //<--TODO: add hyperlink to webpage with better description.
+        msgBox.exec();
+    }
+}
+
 /**
  * @brief LogFile::setReplayTime, sets the playback time
- * @param val, the time in
+ * @param val, the time in seconds
+ *
+ * While the index is still being built only the part of the log indexed so
+ * far can be reached, later times jump to the last indexed packet.
  */
 void LogFile::setReplayTime(double val)
 {
-    quint32 tmpIdx=0;
-    while(timestampBuffer[tmpIdx++] <= val*1000 && tmpIdx <= timestampBufferIdx){
+    const LogIndexEntry *entry = findByTime(val*1000);
+    if (entry == NULL) {
+        qDebug() << "Log index not available yet, cannot seek to" << val*1000;
+        return;
     }
 
-    lastTimeStampPos=timestampPos[tmpIdx];
-    lastTimeStamp=timestampBuffer[tmpIdx];
-    timestampBufferIdx=tmpIdx;
+    lastTimeStampPos=entry->pos;
+    lastTimeStamp=entry->timestamp;
 
     lastPlayTimeOffset = myTime.elapsed();
-    lastPlayTime=lastTimeStamp;
+    lastPlayTime=lastTimeStamp-firstTimestamp;
 
     qDebug() << "Replaying at: " << lastTimeStamp << ", but requestion at" << val*1000;
 }
@@ -34,9 +34,66 @@
 #include <QMutexLocker>
 #include <QDebug>
 #include <QBuffer>
+#include <QThread>
+#include <QVector>
 #include "uavobjectmanager.h"
 #include <math.h>
 
+/**
+ * One packet of a log: its timestamp and the file offset of its header.
+ * The index of a log is an array of these in file order.
+ */
+struct LogIndexEntry {
+    quint32 timestamp;
+    quint32 pos;
+};
+
+/**
+ * Header of the sidecar index (<logfile>.idx), followed by count entries.
+ * The index is only used if the size and body offset of the log match.
+ */
+struct LogIndexHeader {
+    quint32 magic;
+    quint32 version;
+    quint64 logSize;
+    quint64 bodyStart;
+    quint32 count;
+    quint32 reserved;
+};
+
+/**
+ * Builds the index of a log in the background so that replay can start
+ * before the whole file has been scanned. Entries are published as they
+ * are found and the sidecar index is written once the scan completes.
+ */
+class LogIndexThread : public QThread
+{
+public:
+    LogIndexThread(const QString &fileName, qint64 bodyStart);
+
+    void stop() { m_running = false; }
+
+    /** Copy the entries indexed so far after the given one, returns the number copied */
+    int getEntries(QVector<LogIndexEntry> &entries, int from);
+
+    /** true if the scan found timestamps going backwards */
+    bool nonSequential() const { return m_nonSequential; }
+
+protected:
+    void run();
+
+    QString m_fileName;
+    qint64 m_bodyStart;
+
+    QVector<LogIndexEntry> m_entries;
+
+    /** A mutex to protect the entries */
+    QMutex m_entriesMtx;
+
+    volatile bool m_running;
+    bool m_nonSequential;
+};
+
 class LogFile : public QIODevice
 {
     Q_OBJECT
@@ -48,6 +105,8 @@ public:
     void setFileName(QString name) { file.setFileName(name); }
     void close();
     qint64 writeData(const char * data, qint64 dataSize);
+    //! Append records that are already in the log format, unlike writeData() which frames a packet
+    qint64 writeRecords(const char * data, qint64 size) { return file.write(data, size); }
     qint64 readData(char * data, qint64 maxlen);
 
     bool startReplay();
@@ -61,9 +120,12 @@ public slots:
 
 protected slots:
     void timerFired();
+    void indexFinished();
 
 signals:
     void readReady();
+    //! Packets due for replay, they point into the log and are only valid during the call
+    void replayFrames(const QVector<QByteArray> &frames);
     void replayStarted();
     void replayFinished();
 
@@ -81,9 +143,28 @@ protected:
     double playbackSpeed;
 
 private:
-    QList<quint32> timestampBuffer;
-    QList<quint32> timestampPos;
-    quint32 timestampBufferIdx;
+    bool readAt(qint64 pos, void *data, qint64 size);
+    void deliverFrames(const QVector<QByteArray> &frames);
+    bool loadIndex();
+    void syncIndex();
+    void indexRange(const LogIndexEntry **begin, const LogIndexEntry **end);
+    const LogIndexEntry *findByTime(quint32 timestamp);
+    const LogIndexEntry *findByPos(quint32 pos);
+
+    //! Sidecar index, memory mapped when valid
+    QFile indexFile;
+    const LogIndexEntry *mappedIndex;
+    quint32 mappedCount;
+
+    //! Index being built in the background when there is no valid sidecar
+    LogIndexThread *indexThread;
+    QVector<LogIndexEntry> builtIndex;
+
+    //! The whole log mapped for replay, NULL if it could not be mapped
+    const uchar *logMap;
+    qint64 logSize;
+
+    qint64 bodyStart;
     quint32 lastTimeStampPos;
     quint32 firstTimestamp;
 };
@@ -0,0 +1,118 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logframequeue.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Queue between the telemetry thread and the log writer
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "logframequeue.h"
+#include "logfile.h"
+
+#include <string.h>
+
+/**
+ * @param sizeLog2 The ring holds 2^sizeLog2 bytes, 4 MiB by default
+ * which is well over a minute of a fast telemetry link
+ */
+LogFrameQueue::LogFrameQueue(int sizeLog2) :
+    buffer(1 << sizeLog2, 0),
+    mask((1u << sizeLog2) - 1),
+    head(0),
+    tail(0),
+    dropped(0)
+{
+    clock.start();
+}
+
+void LogFrameQueue::start()
+{
+    head.store(0);
+    tail.store(0);
+    dropped.store(0);
+    clock.restart();
+}
+
+/**
+ * Copy into the ring at a free running position, wrapping as needed
+ */
+void LogFrameQueue::copyIn(quint32 pos, const void *data, quint32 length)
+{
+    quint32 offset = pos & mask;
+    quint32 first = qMin(length, (quint32)buffer.size() - offset);
+
+    memcpy(buffer.data() + offset, data, first);
+    memcpy(buffer.data(), (const char *)data + first, length - first);
+}
+
+/**
+ * Append a frame as a log record. The record only becomes visible to the
+ * writer once it is complete.
+ */
+void LogFrameQueue::frame(const quint8* data, qint32 length)
+{
+    quint32 timeStamp = clock.elapsed();
+    qint64 dataSize = length;
+
+    quint32 h = head.load();
+    quint32 t = tail.loadAcquire();
+    quint32 needed = sizeof(timeStamp) + sizeof(dataSize) + length;
+
+    if (needed > (quint32)buffer.size() - (h - t)) {
+        dropped.ref();
+        return;
+    }
+
+    copyIn(h, &timeStamp, sizeof(timeStamp));
+    copyIn(h + sizeof(timeStamp), &dataSize, sizeof(dataSize));
+    copyIn(h + sizeof(timeStamp) + sizeof(dataSize), data, length);
+
+    head.storeRelease(h + needed);
+}
+
+qint64 LogFrameQueue::drain(LogFile *log)
+{
+    quint32 h = head.loadAcquire();
+    quint32 t = tail.load();
+    quint32 length = h - t;
+
+    if (length == 0)
+        return 0;
+
+    // At most two writes, before and after the wrap
+    quint32 offset = t & mask;
+    quint32 first = qMin(length, (quint32)buffer.size() - offset);
+
+    log->writeRecords(buffer.constData() + offset, first);
+    if (first < length)
+        log->writeRecords(buffer.constData(), length - first);
+
+    tail.storeRelease(h);
+
+    return length;
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,77 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logframequeue.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Queue between the telemetry thread and the log writer
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup   Logging
+ * @{
+ *
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGFRAMEQUEUE_H
+#define LOGFRAMEQUEUE_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <uavtalk/uavtalk.h>
+
+class LogFile;
+
+/**
+ * Single producer, single consumer ring of log records. The telemetry
+ * thread appends each frame as a complete record (32 bit timestamp,
+ * 64 bit length, frame) without taking a lock, and the log writer
+ * hands the records to the file in as few writes as the wrap allows.
+ * Records that do not fit are dropped and counted, never waited for.
+ */
+class LogFrameQueue : public UAVTalkFrameSink
+{
+public:
+    explicit LogFrameQueue(int sizeLog2 = 22);
+
+    //! Restart the clock of the timestamps and empty the queue, not while frames come in
+    void start();
+
+    //! Called by the telemetry thread
+    void frame(const quint8* data, qint32 length);
+
+    //! Called by the writer, writes everything queued so far and returns the number of bytes
+    qint64 drain(LogFile *log);
+
+    quint32 droppedFrames() const { return dropped.load(); }
+
+private:
+    void copyIn(quint32 pos, const void *data, quint32 length);
+
+    QByteArray buffer;
+    quint32 mask;
+    QAtomicInt head;       //!< written by the producer only
+    QAtomicInt tail;       //!< written by the consumer only
+    QAtomicInt dropped;
+    QElapsedTimer clock;
+};
+
+#endif // LOGFRAMEQUEUE_H
+
+/**
+ * @}
+ * @}
+ */
@@ -41,11 +41,12 @@
 #include <QFileDialog>
 #include <QList>
 #include <QErrorMessage>
-#include <QWriteLocker>
+#include <QTimer>
 
 #include <extensionsystem/pluginmanager.h>
 #include <QKeySequence>
 #include "uavobjectmanager.h"
+#include "uavtalk/telemetrymanager.h"
 
 
 LoggingConnection::LoggingConnection()
@@ -128,6 +129,7 @@ QString LoggingConnection::shortName()
 LoggingThread::~LoggingThread()
 {
     stopLogging();
+    wait();
 }
 
 /**
@@ -142,52 +144,43 @@ bool LoggingThread::openFile(QString file, LoggingPlugin * parent)
     if (!logFile.open(QIODevice::WriteOnly)) {
         return false;
     }
+    frames.start();
+
+    // Frames queue up from here on until the thread writes them
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+    TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
+    if (telMngr)
+        telMngr->setFrameSink(&frames);
 
-    uavTalk = new UAVTalk(&logFile, objManager);
     connect(parent,SIGNAL(stopLoggingSignal()),this,SLOT(stopLogging()));
 
     return true;
 };
 
 /**
-  * Logs an object update to the file.  Data format is the
-  * timestamp as a 32 bit uint counting ms from start of
-  * file writing (flight time will be embedded in stream),
-  * then object packet size, then the packed UAVObject.
+  * Writes the frames queued by the telemetry since the last call.  Data
+  * format is the timestamp as a 32 bit uint counting ms from start of
+  * file writing (flight time will be embedded in stream), then the
+  * packet size, then the UAVTalk packet as it went over the link.
   */
-void LoggingThread::objectUpdated(UAVObject * obj)
+void LoggingThread::writeFrames()
 {
-    QWriteLocker locker(&lock);
-    if(!uavTalk->sendObject(obj,false,false) )
-        qDebug() << "Error logging " << obj->getName();
-};
+    frames.drain(&logFile);
+}
 
 /**
-  * Connect signals from all the objects updates to the write routine then
-  * run event loop
+  * Write the frames that the telemetry copies into the queue out in
+  * large blocks from the event loop
   */
 void LoggingThread::run()
 {
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
-    QVector< QVector<UAVObject*> > list = objManager->getObjectsVector();
-    QVector< QVector<UAVObject*> >::const_iterator i;
-    QVector<UAVObject*>::const_iterator j;
-    int objects = 0;
-
-    const QVector< QVector<UAVObject*> >::iterator iEnd = list.end();
-    for (i = list.constBegin(); i != iEnd; ++i)
-    {
-        QVector<UAVObject*>::const_iterator jEnd = (*i).constEnd();
-        for (j = (*i).constBegin(); j != jEnd; ++j)
-        {
-            connect(*j, SIGNAL(objectUpdated(UAVObject*)), (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)));
-            objects++;
-        }
-    }
+    // The timer lives in this thread, so the writes are done here too
+    QTimer writeTimer;
+    connect(&writeTimer, SIGNAL(timeout()), this, SLOT(writeFrames()), Qt::DirectConnection);
+    writeTimer.start(WRITE_PERIOD_MS);
 
     GCSTelemetryStats* gcsStatsObj = GCSTelemetryStats::GetInstance(objManager);
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
@@ -201,36 +194,29 @@ void LoggingThread::run()
 
 
     exec();
+
+    writeTimer.stop();
+    writeFrames();
+    if (frames.droppedFrames() > 0)
+        qDebug() << "Logging: dropped" << frames.droppedFrames() << "frames";
+
+    logFile.close();
+    qDebug() << "File closed";
 }
 
 
 /**
-  * Pass this command to the correct thread then close the file
+  * Stop the telemetry from queueing frames, the thread writes what is left
+  * and closes the file once its event loop ends
   */
 void LoggingThread::stopLogging()
 {
-    QWriteLocker locker(&lock);
-
-    // Disconnect all objects we registered with:
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
-
-    QVector< QVector<UAVObject*> > list = objManager->getObjectsVector();
-    QVector< QVector<UAVObject*> >::const_iterator i;
-    QVector<UAVObject*>::const_iterator j;
+    TelemetryManager *telMngr = pm->getObject<TelemetryManager>();
 
-    const QVector< QVector<UAVObject*> >::iterator iEnd = list.end();
-    for (i = list.constBegin(); i != iEnd; ++i)
-    {
-        QVector<UAVObject*>::const_iterator jEnd = (*i).constEnd();
-        for (j = (*i).constBegin(); j != jEnd; ++j)
-        {
-            disconnect(*j, SIGNAL(objectUpdated(UAVObject*)), (LoggingThread*) this, SLOT(objectUpdated(UAVObject*)));
-        }
-    }
+    if (telMngr)
+        telMngr->setFrameSink(NULL);
 
-    logFile.close();
-    qDebug() << "File closed";
     quit();
 }
 
@@ -37,10 +37,10 @@
 #include "loggingdevice.h"
 #include <uavtalk/uavtalk.h>
 #include <logfile.h>
+#include "logframequeue.h"
 
 #include <QThread>
 #include <QQueue>
-#include <QReadWriteLock>
 
 class LoggingPlugin;
 class LoggingGadgetFactory;
@@ -91,7 +91,7 @@ public:
     bool openFile(QString file, LoggingPlugin * parent);
 
 private slots:
-    void objectUpdated(UAVObject * obj);
+    void writeFrames();
     void transactionCompleted(UAVObject* obj, bool success);
 
 public slots:
@@ -99,11 +99,13 @@ public slots:
 
 protected:
     void run();
-    QReadWriteLock lock;
     LogFile logFile;
-    UAVTalk * uavTalk;
+    LogFrameQueue frames;
 
 private:
+    //! How often the queued frames are written to the file
+    static const int WRITE_PERIOD_MS = 250;
+
     QQueue<UAVDataObject*> queue;
 
     void retrieveSettings();
@@ -32,13 +32,13 @@ ModelViewGadgetConfiguration::ModelViewGadgetConfiguration(QString classId, QSet
     IUAVGadgetConfiguration(classId, parent),
     m_acFilename("../share/taulabs/models/planes/Easystar/EasyStar.3ds"),
     m_bgFilename(""),
-    m_enableVbo(false)
+    m_enableVbo(true)
 {
     // if a saved configuration exists load it
     if (qSettings != 0) {
         QString modelFile = qSettings->value("acFilename").toString();
         QString bgFile    = qSettings->value("bgFilename").toString();
-        m_enableVbo  = qSettings->value("enableVbo").toBool();
+        m_enableVbo  = qSettings->value("enableVbo", true).toBool();
         m_acFilename = Utils::PathUtils().InsertDataPath(modelFile);
         m_bgFilename = Utils::PathUtils().InsertDataPath(bgFile);
     }
@@ -49,7 +49,7 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     , m_GlView()
     , m_MoverController()
     , m_ModelBoundingBox()
-    , m_MotionTimer()
+    , m_AttitudeSubscription(NULL)
     , acFilename(fallbackAcFilename)
     , bgFilename(fallbackBgFilename)
     , vboEnable(false)
@@ -74,7 +74,11 @@ ModelViewGadgetWidget::ModelViewGadgetWidget(QWidget *parent)
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
     attState = AttitudeActual::GetInstance(objManager);
 
-    connect(&m_MotionTimer, SIGNAL(timeout()), this, SLOT(updateAttitude()));
+    // Redraw on the display schedule rather than for every attitude update
+    m_AttitudeSubscription = objManager->subscribe(QList<UAVObject*>() << attState,
+                                                   UAVObjectSubscription::DEFAULT_RATE_HZ, this);
+    connect(m_AttitudeSubscription, SIGNAL(objectsUpdated(QList<UAVObject*>)),
+            this, SLOT(attitudeUpdated(QList<UAVObject*>)));
 }
 
 ModelViewGadgetWidget::~ModelViewGadgetWidget()
@@ -131,7 +135,6 @@ void ModelViewGadgetWidget::initializeGL()
     // Enable antialiasing
     glEnable(GL_MULTISAMPLE);
 
-    m_MotionTimer.start(100);
     setFocusPolicy(Qt::StrongFocus); // keyboard capture for camera switching
 }
 
@@ -207,6 +210,10 @@ void ModelViewGadgetWidget::CreateScene()
             QFile aircraft(acFilename);
             m_World = GLC_Factory::instance()->createWorldFromFile(aircraft);
             m_ModelBoundingBox = m_World.boundingBox();
+            // Keep the meshes in VBOs and draw the coarser levels of detail
+            // of models that have them when they are small on screen
+            m_World.collection()->setVboUsage(vboEnable);
+            m_World.collection()->setLodUsage(true, &m_GlView);
             m_GlView.reframe(m_ModelBoundingBox); // center 3D model in the scene
         } else {
             qDebug() << "ModelView: aircraft file not found:" << acFilename;
@@ -234,7 +241,6 @@ void ModelViewGadgetWidget::mousePressEvent(QMouseEvent *e)
 
     switch (e->button()) {
     case (Qt::LeftButton):
-        m_MotionTimer.stop();
         m_MoverController.setActiveMover(GLC_MoverController::TurnTable, userInput);
         updateGL();
         break;
@@ -269,8 +275,7 @@ void ModelViewGadgetWidget::mouseReleaseEvent(QMouseEvent *)
         return;
     }
     m_MoverController.setNoMover();
-    m_MotionTimer.start();
-    updateGL();
+    updateAttitude();
 }
 
 void ModelViewGadgetWidget::keyPressEvent(QKeyEvent *e) // switch between camera
@@ -353,5 +358,22 @@ void ModelViewGadgetWidget::updateAttitude()
     GLC_Matrix4x4 rootObjectRotation(m0.data());
     rootObject->structInstance()->setMatrix(rootObjectRotation);
     rootObject->updateChildrenAbsoluteMatrix();
-    updateGL();
+
+    // Schedule a repaint rather than rendering right away, Qt merges it with
+    // pending ones and skips it altogether while the gadget is hidden
+    update();
+}
+
+/**
+ * Called at most once per display frame when the attitude changed
+ */
+void ModelViewGadgetWidget::attitudeUpdated(const QList<UAVObject*> &objs)
+{
+    Q_UNUSED(objs);
+
+    // The model is left alone while the user turns the view
+    if (m_MoverController.hasActiveMover()) {
+        return;
+    }
+    updateAttitude();
 }
@@ -29,7 +29,6 @@
 #define MODELVIEWGADGETWIDGET_H_
 
 #include <QGLWidget>
-#include <QTimer>
 
 #include "glc_factory.h"
 #include "viewport/glc_viewport.h"
@@ -74,6 +73,7 @@ private:
 //////////////////////////////////////////////////////////////////////
 private slots:
     void updateAttitude();
+    void attitudeUpdated(const QList<UAVObject*> &objs);
 
 private:
     GLC_Factory *m_pFactory;
@@ -82,8 +82,8 @@ private:
     GLC_Viewport m_GlView;
     GLC_MoverController m_MoverController;
     GLC_BoundingBox m_ModelBoundingBox;
-    // ! The timer used for motion
-    QTimer m_MotionTimer;
+    // ! Delivers attitude updates at most once per display frame
+    UAVObjectSubscription *m_AttitudeSubscription;
 
     QString acFilename;
     QString bgFilename;
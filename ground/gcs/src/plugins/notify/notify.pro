@@ -11,14 +11,16 @@ HEADERS += notifyplugin.h \
     notifyitemdelegate.h \
     notifytablemodel.h \
     notificationitem.h \
-    notifylogging.h
+    notifylogging.h \
+    notifyaudio.h
 
 SOURCES += notifyplugin.cpp \  
     notifypluginoptionspage.cpp \
     notifyitemdelegate.cpp \
     notifytablemodel.cpp \
     notificationitem.cpp \
-    notifylogging.cpp
+    notifylogging.cpp \
+    notifyaudio.cpp
  
 OTHER_FILES += NotifyPlugin.pluginspec\
     NotifyPlugin.json
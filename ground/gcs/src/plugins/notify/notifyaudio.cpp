@@ -0,0 +1,174 @@
+/**
+ ******************************************************************************
+ *
+ * @file       notifyaudio.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Plays the sound sequences of the notifications
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup NotifyPlugin Notification plugin
+ * @{
+ * @brief A plugin to provide notifications of events in GCS
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "notifyaudio.h"
+#include "notifylogging.h"
+#include <QFile>
+#include <QtEndian>
+
+NotifyAudio::NotifyAudio(QObject *parent) : QObject(parent),
+    output(NULL),
+    playing(false)
+{
+}
+
+/**
+ * Read the format and samples of a PCM wav file
+ */
+bool NotifyAudio::readWav(const QString &file, Snippet &snippet)
+{
+    QFile wav(file);
+    if (!wav.open(QIODevice::ReadOnly))
+        return false;
+
+    const QByteArray data = wav.readAll();
+    if (data.size() < 12 || !data.startsWith("RIFF") || data.mid(8, 4) != "WAVE")
+        return false;
+
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    bool haveFormat = false;
+    int pos = 12;
+    while (pos + 8 <= data.size()) {
+        const QByteArray id = data.mid(pos, 4);
+        const int size = qFromLittleEndian<quint32>(p + pos + 4);
+        const int body = pos + 8;
+        if (size < 0 || body + size > data.size())
+            break;
+
+        if (id == "fmt " && size >= 16) {
+            // Only uncompressed PCM is handled
+            if (qFromLittleEndian<quint16>(p + body) != 1)
+                return false;
+            const int bits = qFromLittleEndian<quint16>(p + body + 14);
+            snippet.format.setCodec("audio/pcm");
+            snippet.format.setChannelCount(qFromLittleEndian<quint16>(p + body + 2));
+            snippet.format.setSampleRate(qFromLittleEndian<quint32>(p + body + 4));
+            snippet.format.setSampleSize(bits);
+            snippet.format.setByteOrder(QAudioFormat::LittleEndian);
+            snippet.format.setSampleType(bits == 8 ? QAudioFormat::UnSignedInt : QAudioFormat::SignedInt);
+            haveFormat = true;
+        } else if (id == "data" && haveFormat) {
+            snippet.samples = data.mid(body, size);
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        pos = body + size + (size & 1);
+    }
+    return false;
+}
+
+/**
+ * Get the decoded samples of a file, reading it the first time
+ * @return NULL if the file can not be played
+ */
+const NotifyAudio::Snippet *NotifyAudio::snippet(const QString &file)
+{
+    QHash<QString, Snippet>::iterator it = cache.find(file);
+    if (it == cache.end()) {
+        Snippet s;
+        if (!readWav(file, s)) {
+            qNotifyDebug() << "Can not play sound file" << file;
+            s = Snippet();
+        }
+        // Failures are cached too so the file is not read on every alarm
+        it = cache.insert(file, s);
+    }
+    return it->format.isValid() ? &*it : NULL;
+}
+
+/**
+ * Play the files one after the other, replacing what is playing now
+ */
+void NotifyAudio::play(const QStringList &files)
+{
+    // Stopping the output reports a state change, which is not the end of
+    // the new sequence
+    playing = false;
+    if (output)
+        output->stop();
+    buffer.close();
+
+    sequence.clear();
+    QAudioFormat format;
+    foreach (const QString &file, files) {
+        const Snippet *s = snippet(file);
+        if (s == NULL)
+            continue;
+        if (!format.isValid()) {
+            format = s->format;
+        } else if (s->format != format) {
+            qNotifyDebug() << "Skipping" << file << "its format differs from the rest of the sequence";
+            continue;
+        }
+        sequence.append(s->samples);
+    }
+
+    if (sequence.isEmpty()) {
+        emit finished();
+        return;
+    }
+
+    if (output && output->format() != format) {
+        delete output;
+        output = NULL;
+    }
+    if (output == NULL) {
+        output = new QAudioOutput(format, this);
+        connect(output, SIGNAL(stateChanged(QAudio::State)), this, SLOT(onStateChanged(QAudio::State)));
+    }
+
+    buffer.setBuffer(&sequence);
+    buffer.open(QIODevice::ReadOnly);
+    playing = true;
+    output->start(&buffer);
+}
+
+void NotifyAudio::stop()
+{
+    playing = false;
+    if (output)
+        output->stop();
+    buffer.close();
+}
+
+void NotifyAudio::onStateChanged(QAudio::State state)
+{
+    if (!playing)
+        return;
+
+    // Idle means all of the buffer was played, stopped that the device failed
+    if (state == QAudio::IdleState || state == QAudio::StoppedState) {
+        playing = false;
+        output->stop();
+        buffer.close();
+        emit finished();
+    }
+}
@@ -0,0 +1,79 @@
+/**
+ ******************************************************************************
+ *
+ * @file       notifyaudio.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Plays the sound sequences of the notifications
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup NotifyPlugin Notification plugin
+ * @{
+ * @brief A plugin to provide notifications of events in GCS
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef NOTIFYAUDIO_H
+#define NOTIFYAUDIO_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QBuffer>
+#include <QAudioFormat>
+#include <QAudioOutput>
+
+/**
+ * Plays the sounds of a notification one after the other. It is meant to
+ * live in its own thread so that loading the files and feeding the audio
+ * device never stalls the GUI. Each file is decoded once and kept as PCM,
+ * a sequence is played by concatenating the cached samples.
+ */
+class NotifyAudio : public QObject
+{
+    Q_OBJECT
+public:
+    explicit NotifyAudio(QObject *parent = 0);
+
+public slots:
+    void play(const QStringList &files);
+    void stop();
+
+signals:
+    //! Emitted when the sequence passed to play() has been played or dropped
+    void finished();
+
+private slots:
+    void onStateChanged(QAudio::State state);
+
+private:
+    struct Snippet {
+        QAudioFormat format;
+        QByteArray samples;
+    };
+
+    const Snippet *snippet(const QString &file);
+    static bool readWav(const QString &file, Snippet &snippet);
+
+    QHash<QString, Snippet> cache;
+    QAudioOutput *output;
+    QBuffer buffer;
+    QByteArray sequence;
+    bool playing;
+};
+
+#endif // NOTIFYAUDIO_H
@@ -32,6 +32,7 @@
 #include "notificationitem.h"
 #include "notifypluginoptionspage.h"
 #include "notifylogging.h"
+#include "notifyaudio.h"
 #include <coreplugin/icore.h>
 #include <QDebug>
 #include <QtPlugin>
@@ -46,16 +47,32 @@ static const QString VERSION = "1.0.0";
 //#define DEBUG_NOTIFIES
 
 
-SoundNotifyPlugin::SoundNotifyPlugin()
+SoundNotifyPlugin::SoundNotifyPlugin() :
+    audio(NULL),
+    audioBusy(false)
 {
-    phonon.mo = NULL;
 }
 
 SoundNotifyPlugin::~SoundNotifyPlugin()
 {
     Core::ICore::instance()->saveSettings(this);
-    if (phonon.mo != NULL)
-        delete phonon.mo;
+    // The player is deleted by the thread when it finishes
+    audioThread.quit();
+    audioThread.wait();
+}
+
+/**
+ * Create the player in the audio thread
+ */
+void SoundNotifyPlugin::startAudio()
+{
+    audio = new NotifyAudio;
+    audio->moveToThread(&audioThread);
+    connect(&audioThread, SIGNAL(finished()), audio, SLOT(deleteLater()));
+    connect(this, SIGNAL(playSounds(QStringList)), audio, SLOT(play(QStringList)));
+    connect(this, SIGNAL(stopSounds()), audio, SLOT(stop()));
+    connect(audio, SIGNAL(finished()), this, SLOT(on_audioFinished()));
+    audioThread.start();
 }
 
 bool SoundNotifyPlugin::initialize(const QStringList& args, QString *errMsg)
@@ -177,10 +194,9 @@ void SoundNotifyPlugin::connectNotifications()
         if (obj != NULL)
             disconnect(obj,SIGNAL(objectUpdated(UAVObject*)),this,SLOT(on_arrived_Notification(UAVObject*)));
     }
-    if (phonon.mo != NULL) {
-        delete phonon.mo;
-        phonon.mo = NULL;
-    }
+    emit stopSounds();
+    audioBusy = false;
+    _nowPlayingNotification = NULL;
 
     if (!enableSound) return;
 
@@ -217,11 +233,8 @@ void SoundNotifyPlugin::connectNotifications()
     }
 
     if (_notificationList.isEmpty()) return;
-    // set notification message to current event
-    phonon.mo = new QMediaPlayer;
-    phonon.firstPlay = true;
-    connect(phonon.mo, SIGNAL(stateChanged(QMediaPlayer::State)),
-        this, SLOT(stateChanged(QMediaPlayer::State)));
+    if (audio == NULL)
+        startAudio();
 }
 
 void SoundNotifyPlugin::on_arrived_Notification(UAVObject *object)
@@ -303,31 +316,22 @@ void SoundNotifyPlugin::on_expiredTimer_Notification()
     }
 }
 
-void SoundNotifyPlugin::stateChanged(QMediaPlayer::State newstate)
+void SoundNotifyPlugin::on_audioFinished()
 {
-    //qNotifyDebug() << "File length (ms): " << phonon.mo->totalTime();
-
-#ifndef Q_OS_WIN
-    // This is a hack to force Linux to wait until the end of the
-    // wav file before moving to the next in the queue.
-    // I wish I did not have to go through a #define, but I did not
-    // manage to make this work on both platforms any other way!
-#endif
-    if ((newstate == QMediaPlayer::PausedState) || (newstate == QMediaPlayer::StoppedState)) {
-        qNotifyDebug() << "New State: " << QVariant(newstate).toString();
-
-        // assignment to NULL needed to detect that palying is finished
-        // it's useful in repeat timer handler, where we can detect
-        // that notification has not overlap with itself
-        _nowPlayingNotification = NULL;
-
-        if (!_pendingNotifications.isEmpty())
-        {
-            NotificationItem* notification = _pendingNotifications.takeFirst();
-            qNotifyDebug_if(notification) << "play audioFree - " << notification->toString();
-            playNotification(notification);
-            qNotifyDebug()<<"end playNotification";
-        }
+    qNotifyDebug() << "audio finished";
+    audioBusy = false;
+
+    // assignment to NULL needed to detect that palying is finished
+    // it's useful in repeat timer handler, where we can detect
+    // that notification has not overlap with itself
+    _nowPlayingNotification = NULL;
+
+    if (!_pendingNotifications.isEmpty())
+    {
+        NotificationItem* notification = _pendingNotifications.takeFirst();
+        qNotifyDebug_if(notification) << "play audioFree - " << notification->toString();
+        playNotification(notification);
+        qNotifyDebug()<<"end playNotification";
     }
 }
 
@@ -429,6 +433,17 @@ void SoundNotifyPlugin::checkNotificationRule(NotificationItem* notification, UA
                 && (_nowPlayingNotification != notification)) {
             notification->stopTimer();
 
+            // Only the latest state of a field is worth announcing, so
+            // it replaces whatever is still waiting for the same field
+            foreach (NotificationItem* pending, _pendingNotifications) {
+                if (pending->getDataObject() == notification->getDataObject() &&
+                        pending->getObjectField() == notification->getObjectField()) {
+                    qNotifyDebug() << "replace pending - " << pending->toString();
+                    pending->stopExpireTimer();
+                    _pendingNotifications.removeOne(pending);
+                }
+            }
+
             qNotifyDebug() << "add to pending list - " << notification->toString();
             // if audio is busy, start expiration timer
             //ms = (notification->getExpiredTimeout()[in sec])*1000
@@ -443,19 +458,14 @@ void SoundNotifyPlugin::checkNotificationRule(NotificationItem* notification, UA
 
 bool SoundNotifyPlugin::playNotification(NotificationItem* notification)
 {
-    playlist = new QMediaPlaylist;
     if(!notification)
         return false;
 
-    // Check: race condition, if phonon.mo got deleted don't go further
-    if (phonon.mo == NULL)
+    // Check: sound is disabled or nothing is configured
+    if (audio == NULL)
         return false;
 
-    //qNotifyDebug() << "Phonon State: " << phonon.mo->state();
-
-    if ((phonon.mo->state()==QMediaPlayer::PausedState)
-        || (phonon.mo->state()==QMediaPlayer::StoppedState)
-            || phonon.firstPlay)
+    if (!audioBusy)
     {
         _nowPlayingNotification = notification;
         notification->stopExpireTimer();
@@ -490,17 +500,9 @@ bool SoundNotifyPlugin::playNotification(NotificationItem* notification)
                         this, SLOT(on_timerRepeated_Notification()), Qt::UniqueConnection);
             }
         }
-        phonon.mo->stop();
         qNotifyDebug() << "play: " << notification->toString();
-        foreach (QString item, notification->toSoundList()) {
-            playlist->addMedia(QUrl::fromLocalFile(item));
-        }
-        qNotifyDebug()<<"begin play";
-        phonon.mo->setPlaylist(playlist);
-        phonon.mo->play();
-        qNotifyDebug()<<"end play";
-        phonon.firstPlay = false; // On Linux, you sometimes have to nudge Phonon to play 1 time before
-                                  // the state is not "Loading" anymore.
+        audioBusy = true;
+        emit playSounds(notification->toSoundList());
         return true;
 
     }
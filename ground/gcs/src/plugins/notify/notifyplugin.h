@@ -38,16 +38,10 @@
 #include "notificationitem.h"
 
 #include <QSettings>
-#include <QMediaPlayer>
-#include <QMediaPlaylist>
+#include <QThread>
 
 class NotifyPluginOptionsPage;
-
-typedef struct {
-	QMediaPlayer* mo;
-	NotificationItem* notify;
-	bool firstPlay;
-} PhononObject, *pPhononObject;
+class NotifyAudio;
 
 
 class SoundNotifyPlugin : public Core::IConfigurablePlugin
@@ -76,6 +70,11 @@ private:
 
     bool playNotification(NotificationItem* notification);
     void checkNotificationRule(NotificationItem* notification, UAVObject* object);
+    void startAudio();
+
+signals:
+    void playSounds(const QStringList &files);
+    void stopSounds();
 
 private slots:
 
@@ -87,7 +86,7 @@ private slots:
     void on_arrived_Notification(UAVObject *object);
     void on_timerRepeated_Notification(void);
     void on_expiredTimer_Notification(void);
-    void stateChanged(QMediaPlayer::State newstate);
+    void on_audioFinished();
 
 private:
     bool enableSound;
@@ -100,10 +99,13 @@ private:
     NotificationItem currentNotification;
     NotificationItem* _nowPlayingNotification;
 
-    PhononObject phonon;
+    //! Sounds are decoded and played in their own thread
+    QThread audioThread;
+    NotifyAudio *audio;
+    bool audioBusy;
+
     NotifyPluginOptionsPage* mop;
     TelemetryManager* telMngr;
-    QMediaPlaylist *playlist;
 }; 
 
 #endif // SOUNDNOTIFYPLUGIN_H
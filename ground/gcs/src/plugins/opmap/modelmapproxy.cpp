@@ -29,7 +29,7 @@
 #include "modelmapproxy.h"
 #include "../pathplanner/waypointdialog.h"
 
-ModelMapProxy::ModelMapProxy(QObject *parent,TLMapWidget *map, FlightDataModel *model,QItemSelectionModel * selectionModel):QObject(parent),myMap(map),model(model),selection(selectionModel)
+ModelMapProxy::ModelMapProxy(QObject *parent,TLMapWidget *map, FlightDataModel *model,QItemSelectionModel * selectionModel):QObject(parent),missionPath(NULL),myMap(map),model(model),selection(selectionModel)
 {
     connect(model,SIGNAL(rowsInserted(const QModelIndex&,int,int)),this,SLOT(rowsInserted(const QModelIndex&,int,int)));
     connect(model,SIGNAL(rowsRemoved(const QModelIndex&,int,int)),this,SLOT(rowsRemoved(const QModelIndex&,int,int)));
@@ -131,7 +131,7 @@ void ModelMapProxy::createOverlay(WayPointItem *from, WayPointItem *to,
     switch(type)
     {
     case OVERLAY_LINE:
-        myMap->WPLineCreate(from,to,color);
+        missionPath->AddLeg(from,to);
         break;
     case OVERLAY_CIRCLE_RIGHT:
         myMap->WPCircleCreate(to,from,true,color);
@@ -165,7 +165,7 @@ void ModelMapProxy::createOverlay(WayPointItem *from, HomeItem *to, ModelMapProx
     switch(type)
     {
     case OVERLAY_LINE:
-        myMap->WPLineCreate(to,from,color);
+        missionPath->AddLeg(to,from);
         break;
     case OVERLAY_CIRCLE_RIGHT:
         myMap->WPCircleCreate(to,from,true,color);
@@ -186,8 +186,10 @@ void ModelMapProxy::createOverlay(WayPointItem *from, HomeItem *to, ModelMapProx
 void ModelMapProxy::refreshOverlays()
 {
     myMap->deleteAllOverlays();
+    missionPath = NULL;
     if(model->rowCount()<1)
         return;
+    missionPath = myMap->WPPathCreate(Qt::green);
     WayPointItem *wp_current = NULL;
     WayPointItem *wp_next = NULL;
     overlayType wp_next_overlay;
@@ -84,6 +84,8 @@ private:
     overlayType overlayTranslate(int type);
     void createOverlay(WayPointItem *from, WayPointItem * to, overlayType type, QColor color, double radius);
     void createOverlay(WayPointItem *from, HomeItem *to, ModelMapProxy::overlayType type, QColor color);
+    //! Straight legs of the current mission, drawn as one item
+    MissionPathItem *missionPath;
     TLMapWidget * myMap;
     FlightDataModel *model;
     void refreshOverlays();
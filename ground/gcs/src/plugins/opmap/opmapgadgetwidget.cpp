@@ -29,6 +29,8 @@
 #include "opmapgadgetwidget.h"
 #include "ui_opmap_widget.h"
 #include <QInputDialog>
+#include <QFileDialog>
+#include <QMessageBox>
 #include <QApplication>
 #include <QHBoxLayout>
 #include <QVBoxLayout>
@@ -382,6 +384,10 @@ void OPMapGadgetWidget::contextMenuEvent(QContextMenuEvent *event)
     contextMenu.addAction(reloadAct);
     contextMenu.addSeparator();
     contextMenu.addAction(ripAct);
+    contextMenu.addAction(prefetchPathAct);
+    prefetchPathAct->setEnabled(m_map->WPPresent());
+    contextMenu.addAction(exportPackAct);
+    contextMenu.addAction(usePackAct);
     contextMenu.addSeparator();
 
     QMenu maxUpdateRateSubMenu(tr("&Max Update Rate ") + "(" + QString::number(m_maxUpdateRate) + " ms)", this);
@@ -1258,6 +1264,18 @@ void OPMapGadgetWidget::createActions()
     ripAct->setStatusTip(tr("Rip the map tiles"));
     connect(ripAct, SIGNAL(triggered()), this, SLOT(onRipAct_triggered()));
 
+    prefetchPathAct = new QAction(tr("&Prefetch map along path"), this);
+    prefetchPathAct->setStatusTip(tr("Download the map tiles along the waypoint path ahead of the mission"));
+    connect(prefetchPathAct, SIGNAL(triggered()), this, SLOT(onPrefetchPathAct_triggered()));
+
+    exportPackAct = new QAction(tr("&Export offline map package..."), this);
+    exportPackAct->setStatusTip(tr("Write the map tiles of the selected area to a package for use without internet"));
+    connect(exportPackAct, SIGNAL(triggered()), this, SLOT(onExportPackAct_triggered()));
+
+    usePackAct = new QAction(tr("&Use offline map package..."), this);
+    usePackAct->setStatusTip(tr("Read map tiles from an offline map package before the cache and the internet"));
+    connect(usePackAct, SIGNAL(triggered()), this, SLOT(onUsePackAct_triggered()));
+
     copyMouseLatLonToClipAct = new QAction(tr("Mouse latitude and longitude"), this);
     copyMouseLatLonToClipAct->setStatusTip(tr("Copy the mouse latitude and longitude to the clipboard"));
     connect(copyMouseLatLonToClipAct, SIGNAL(triggered()), this, SLOT(onCopyMouseLatLonToClipAct_triggered()));
@@ -1550,6 +1568,41 @@ void OPMapGadgetWidget::onRipAct_triggered()
     m_map->RipMap();
 }
 
+void OPMapGadgetWidget::onPrefetchPathAct_triggered()
+{
+    m_map->PrefetchWPCorridor();
+}
+
+void OPMapGadgetWidget::onExportPackAct_triggered()
+{
+    QString file = QFileDialog::getSaveFileName(this, tr("Export offline map package"), QString(), tr("Map packages (*.tlpack)"));
+    if (file.isEmpty())
+        return;
+    if (!file.endsWith(".tlpack"))
+        file += ".tlpack";
+
+    bool ok;
+    int zoom = (int)m_map->ZoomTotal();
+    int maxZoom = QInputDialog::getInt(this, tr("Export offline map package"), tr("Highest zoom level to export:"),
+                                       qMin(zoom + 3, m_map->MaxZoom()), zoom, m_map->MaxZoom(), 1, &ok);
+    if (!ok)
+        return;
+
+    m_map->ExportTilePack(file, maxZoom);
+}
+
+void OPMapGadgetWidget::onUsePackAct_triggered()
+{
+    QString file = QFileDialog::getOpenFileName(this, tr("Use offline map package"), m_map->configuration->TilePack(), tr("Map packages (*.tlpack)"));
+    if (file.isEmpty())
+        return;
+
+    if (!m_map->configuration->SetTilePack(file))
+        QMessageBox::warning(this, tr("Offline map package"), tr("%1 is not a valid offline map package.").arg(file));
+    else
+        m_map->ReloadMap();
+}
+
 void OPMapGadgetWidget::onCopyMouseLatLonToClipAct_triggered()
 {
     QClipboard *clipboard = QApplication::clipboard();
@@ -175,6 +175,9 @@ private slots:
     */
     void onReloadAct_triggered();
     void onRipAct_triggered();
+    void onPrefetchPathAct_triggered();
+    void onExportPackAct_triggered();
+    void onUsePackAct_triggered();
     void onCopyMouseLatLonToClipAct_triggered();
     void onCopyMouseLatToClipAct_triggered();
     void onCopyMouseLonToClipAct_triggered();
@@ -250,6 +253,9 @@ private:
     QAction *closeAct2;
     QAction *reloadAct;
     QAction *ripAct;
+    QAction *prefetchPathAct;
+    QAction *exportPackAct;
+    QAction *usePackAct;
 	QAction *copyMouseLatLonToClipAct;
     QAction *copyMouseLatToClipAct;
     QAction *copyMouseLonToClipAct;
@@ -9,7 +9,8 @@ include(osg.pri)
 include(osgearth.pri)
 
 HEADERS += osgearthviewplugin.h \
-    osgviewerwidget.h
+    osgviewerwidget.h \
+    tileprefetcher.h
 HEADERS += osgearthviewgadget.h
 HEADERS += osgearthviewwidget.h
 HEADERS += osgearthviewgadgetfactory.h
@@ -17,7 +18,8 @@ HEADERS += osgearthviewgadgetconfiguration.h
 HEADERS += osgearthviewgadgetoptionspage.h
 
 SOURCES += osgearthviewplugin.cpp \
-    osgviewerwidget.cpp
+    osgviewerwidget.cpp \
+    tileprefetcher.cpp
 SOURCES += osgearthviewgadget.cpp
 SOURCES += osgearthviewwidget.cpp
 SOURCES += osgearthviewgadgetfactory.cpp
@@ -102,6 +102,7 @@ using namespace osgEarth::Annotation;
 #include "homelocation.h"
 #include "positionactual.h"
 #include "systemsettings.h"
+#include "velocityactual.h"
 
 using namespace Utils;
 
@@ -111,7 +112,17 @@ using namespace Utils;
 #define AIRPLANE_TEXTURE ":/osgearthview/models/easystar_texture.jpg"
 #define OSGEARTH_FILE ":/osgearthview/models/world.earth"
 
-OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent)
+//! Frame period, the scene only changes on the coalesced telemetry tick
+#define RENDER_PERIOD_MS 16
+
+//! Threads of the database pager loading the terrain, and of those the ones on http
+#define PAGER_THREADS 4
+#define PAGER_HTTP_THREADS 2
+
+OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent),
+    vehicleSubscription(NULL),
+    prefetcher(NULL),
+    vehicleMoved(false)
 {
     setThreadingModel(osgViewer::ViewerBase::CullThreadPerCameraDrawThreadPerContext);
     setAttribute(Qt::WA_PaintOnScreen, true);
@@ -145,6 +156,18 @@ OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent)
     SystemSettings *systemSettingsObj = SystemSettings::GetInstance(objMngr);
     connect(systemSettingsObj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateAirframe(UAVObject*)));
 
+    // Pose updates are taken on the display schedule, not per telemetry update
+    vehicleSubscription = objMngr->subscribe(QList<UAVObject*>() << PositionActual::GetInstance(objMngr)
+                                             << VelocityActual::GetInstance(objMngr)
+                                             << AttitudeActual::GetInstance(objMngr)
+                                             << HomeLocation::GetInstance(objMngr),
+                                             UAVObjectSubscription::DEFAULT_RATE_HZ, this);
+    connect(vehicleSubscription, SIGNAL(objectsUpdated(QList<UAVObject*>)),
+            this, SLOT(vehicleUpdated(QList<UAVObject*>)));
+
+    prefetcher = new TilePrefetcher(mapNode->getMap(), this);
+    prefetcher->start(QThread::LowPriority);
+
     root->addChild(uavPos);
 
     osgUtil::Optimizer optimizer;
@@ -157,14 +180,17 @@ OsgViewerWidget::OsgViewerWidget(QWidget *parent) : QWidget(parent)
     viewWidget->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     layout()->addWidget(viewWidget);
 
+    // Keeps drawing while the pager merges tiles, even with no telemetry
     connect( &_timer, SIGNAL(timeout()), this, SLOT(update()) );
-    _timer.start( 10 );
+    _timer.start( RENDER_PERIOD_MS );
 
 
 }
 
 OsgViewerWidget::~OsgViewerWidget()
 {
+    if (prefetcher)
+        prefetcher->stop();
 }
 
 QWidget* OsgViewerWidget::createViewWidget( osg::Camera* camera, osg::Node* scene )
@@ -177,6 +203,7 @@ QWidget* OsgViewerWidget::createViewWidget( osg::Camera* camera, osg::Node* scen
     view->setSceneData( scene );
     view->addEventHandler( new osgViewer::StatsHandler );
     view->getDatabasePager()->setDoPreCompile( true );
+    view->getDatabasePager()->setUpThreads( PAGER_THREADS, PAGER_HTTP_THREADS );
 
     manip = new EarthManipulator();
     view->setCameraManipulator( manip );
@@ -298,9 +325,13 @@ osg::Node* OsgViewerWidget::createAirplane()
     return model;
 }
 
-void OsgViewerWidget::paintEvent( QPaintEvent* event )
+/**
+ * @brief OsgViewerWidget::vehicleUpdated Called on the coalesced update tick
+ * when the pose of the UAV changed, the next frame picks it up
+ */
+void OsgViewerWidget::vehicleUpdated(const QList<UAVObject*> &objs)
 {
-    Q_UNUSED(event);
+    Q_UNUSED(objs);
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager * objMngr = pm->getObject<UAVObjectManager>();
 
@@ -308,20 +339,13 @@ void OsgViewerWidget::paintEvent( QPaintEvent* event )
     PositionActual::DataFields positionActual = positionActualObj->getData();
     double NED[3] = {positionActual.North, positionActual.East, positionActual.Down};
 
-    bool positionActualUpdate = true;
-    if(positionActualUpdate) {
-        HomeLocation *homeLocationObj = HomeLocation::GetInstance(objMngr);
-        HomeLocation::DataFields homeLocation = homeLocationObj->getData();
-        double homeLLA[3] = {homeLocation.Latitude / 10.0e6, homeLocation.Longitude / 10.0e6, homeLocation.Altitude};
-
-        double LLA[3];
-        CoordinateConversions().NED2LLA_HomeLLA(homeLLA, NED, LLA);
-        uavPos->getLocator()->setPosition( osg::Vec3d(LLA[1], LLA[0], LLA[2]) );  // Note this takes longtitude first
-    } else {
-        GPSPosition *gpsPosObj = GPSPosition::GetInstance(objMngr);
-        GPSPosition::DataFields gpsPos = gpsPosObj->getData();
-        uavPos->getLocator()->setPosition( osg::Vec3d(gpsPos.Longitude / 10.0e6, gpsPos.Latitude / 10.0e6, gpsPos.Altitude));
-    }
+    HomeLocation *homeLocationObj = HomeLocation::GetInstance(objMngr);
+    HomeLocation::DataFields homeLocation = homeLocationObj->getData();
+    double homeLLA[3] = {homeLocation.Latitude / 10.0e6, homeLocation.Longitude / 10.0e6, homeLocation.Altitude};
+
+    double LLA[3];
+    CoordinateConversions().NED2LLA_HomeLLA(homeLLA, NED, LLA);
+    vehiclePosition = osg::Vec3d(LLA[1], LLA[0], LLA[2]);  // Note this takes longtitude first
 
     // Set the attitude (reverse the attitude)
     AttitudeActual *attitudeActualObj = AttitudeActual::GetInstance(objMngr);
@@ -333,9 +357,23 @@ void OsgViewerWidget::paintEvent( QPaintEvent* event )
     osg::Vec3d axis;
     quat.getRotate(angle,axis);
     quat.makeRotate(angle, osg::Vec3d(axis[1],axis[0],-axis[2]));
-    osg::Matrixd rot = osg::Matrixd::rotate(quat);
+    vehicleAttitude = osg::Matrixd::rotate(quat);
+
+    vehicleMoved = true;
 
-    uavAttitudeAndScale->setMatrix(rot);
+    VelocityActual::DataFields velocityActual = VelocityActual::GetInstance(objMngr)->getData();
+    prefetcher->predict(LLA[1], LLA[0], velocityActual.North, velocityActual.East);
+}
+
+void OsgViewerWidget::paintEvent( QPaintEvent* event )
+{
+    Q_UNUSED(event);
+
+    if (vehicleMoved) {
+        uavPos->getLocator()->setPosition(vehiclePosition);
+        uavAttitudeAndScale->setMatrix(vehicleAttitude);
+        vehicleMoved = false;
+    }
 
     frame();
 }
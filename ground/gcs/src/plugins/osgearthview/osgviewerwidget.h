@@ -33,6 +33,8 @@
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
 #include "uavobject.h"
+#include "uavobjectsubscription.h"
+#include "tileprefetcher.h"
 
 #include <QTimer>
 
@@ -97,6 +99,9 @@ protected slots:
     //! Update the airframe image based on the model type
     void updateAirframe(UAVObject *obj);
 
+    //! Store the pose of the UAV for the next frame and move the prefetch track
+    void vehicleUpdated(const QList<UAVObject*> &objs);
+
 protected:
     void paintEvent(QPaintEvent *event);
 
@@ -116,6 +121,12 @@ private: /* Private variables */
     osg::MatrixTransform *rotateModelNED;
     osg::MatrixTransform* uavAttitudeAndScale;
     osgEarth::MapNode* mapNode;
+
+    UAVObjectSubscription *vehicleSubscription;
+    TilePrefetcher *prefetcher;
+    bool vehicleMoved;
+    osg::Vec3d vehiclePosition;
+    osg::Matrixd vehicleAttitude;
 };
 
 
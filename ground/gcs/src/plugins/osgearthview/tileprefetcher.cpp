@@ -0,0 +1,148 @@
+/********************************************************************************
+ * @file       tileprefetcher.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup OSGEarthViewPluging OSG Earth View plugin to visualize UAV in 3D
+ * @{
+ * @brief Loads the terrain tiles ahead of the UAV in the background
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "tileprefetcher.h"
+
+#include <cmath>
+
+#include <osgEarth/ImageLayer>
+#include <osgEarth/ElevationLayer>
+#include <osgEarth/TileKey>
+
+//! Levels of detail seen from the tethered camera, roughly 5 km down to 300 m tiles
+#define MIN_LEVEL 13
+#define MAX_LEVEL 17
+
+//! Forget the requested tiles past this many, the cache keeps them anyway
+#define MAX_FETCHED 4096
+
+#define EARTH_RADIUS 6378137.0
+
+//! Seconds ahead of the UAV to fetch along its track
+static const double horizons[] = { 0, 5, 10, 20, 30 };
+
+TilePrefetcher::TilePrefetcher(osgEarth::Map *map, QObject *parent) :
+    QThread(parent),
+    map(map),
+    pending(false),
+    stopping(false),
+    longitude(0),
+    latitude(0),
+    velNorth(0),
+    velEast(0)
+{
+}
+
+TilePrefetcher::~TilePrefetcher()
+{
+    stop();
+}
+
+/**
+ * @brief TilePrefetcher::predict Replaces the track to prefetch, any request
+ * the thread has not picked up yet is dropped
+ */
+void TilePrefetcher::predict(double longitude, double latitude, double velNorth, double velEast)
+{
+    QMutexLocker locker(&lock);
+    this->longitude = longitude;
+    this->latitude = latitude;
+    this->velNorth = velNorth;
+    this->velEast = velEast;
+    pending = true;
+    wake.wakeOne();
+}
+
+void TilePrefetcher::stop()
+{
+    lock.lock();
+    stopping = true;
+    wake.wakeOne();
+    lock.unlock();
+
+    wait();
+}
+
+void TilePrefetcher::run()
+{
+    forever {
+        lock.lock();
+        while (!pending && !stopping)
+            wake.wait(&lock);
+        if (stopping) {
+            lock.unlock();
+            return;
+        }
+        double lon = longitude;
+        double lat = latitude;
+        double vn = velNorth;
+        double ve = velEast;
+        pending = false;
+        lock.unlock();
+
+        double metersPerDegLat = EARTH_RADIUS * M_PI / 180.0;
+        double metersPerDegLon = metersPerDegLat * qMax(cos(lat * M_PI / 180.0), 0.01);
+
+        for (unsigned int i = 0; i < sizeof(horizons) / sizeof(horizons[0]); i++) {
+            fetch(lon + ve * horizons[i] / metersPerDegLon, lat + vn * horizons[i] / metersPerDegLat);
+
+            // Give up on this track once a newer one came in
+            QMutexLocker locker(&lock);
+            if (pending || stopping)
+                break;
+        }
+    }
+}
+
+/**
+ * @brief TilePrefetcher::fetch Creates the tiles of every layer over a point,
+ * which goes through the layer cache like the pager does
+ */
+void TilePrefetcher::fetch(double longitude, double latitude)
+{
+    osgEarth::ImageLayerVector imageLayers;
+    map->getImageLayers(imageLayers);
+    osgEarth::ElevationLayerVector elevationLayers;
+    map->getElevationLayers(elevationLayers);
+
+    for (unsigned int level = MIN_LEVEL; level <= MAX_LEVEL; level++) {
+        osgEarth::TileKey key = map->getProfile()->createTileKey(longitude, latitude, level);
+        if (!key.valid())
+            continue;
+
+        QString name = QString::fromStdString(key.str());
+        if (fetched.contains(name))
+            continue;
+        if (fetched.size() >= MAX_FETCHED)
+            fetched.clear();
+        fetched.insert(name);
+
+        for (osgEarth::ImageLayerVector::iterator i = imageLayers.begin(); i != imageLayers.end(); ++i)
+            (*i)->createImage(key);
+        for (osgEarth::ElevationLayerVector::iterator i = elevationLayers.begin(); i != elevationLayers.end(); ++i)
+            (*i)->createHeightField(key);
+    }
+}
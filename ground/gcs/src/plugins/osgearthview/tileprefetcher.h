@@ -0,0 +1,77 @@
+/********************************************************************************
+ * @file       tileprefetcher.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ *
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup OSGEarthViewPluging OSG Earth View plugin to visualize UAV in 3D
+ * @{
+ * @brief Loads the terrain tiles ahead of the UAV in the background
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef TILEPREFETCHER_H
+#define TILEPREFETCHER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSet>
+#include <QString>
+
+#include <osgEarth/Map>
+
+/**
+ * Requests the imagery and elevation tiles along the predicted track of the
+ * UAV from its own thread, so they are in the cache of the earth file by the
+ * time the database pager asks for them and the render thread never waits on
+ * the network.
+ */
+class TilePrefetcher : public QThread
+{
+    Q_OBJECT
+public:
+    explicit TilePrefetcher(osgEarth::Map *map, QObject *parent = 0);
+    ~TilePrefetcher();
+
+    //! Set the position (degrees, longitude first) and NED velocity (m/s) to predict from
+    void predict(double longitude, double latitude, double velNorth, double velEast);
+
+    void stop();
+
+protected:
+    void run();
+
+private:
+    void fetch(double longitude, double latitude);
+
+    osg::ref_ptr<osgEarth::Map> map;
+
+    QMutex lock;
+    QWaitCondition wake;
+    bool pending;
+    bool stopping;
+    double longitude;
+    double latitude;
+    double velNorth;
+    double velEast;
+
+    //! Tiles already requested, only touched by the thread
+    QSet<QString> fetched;
+};
+
+#endif // TILEPREFETCHER_H
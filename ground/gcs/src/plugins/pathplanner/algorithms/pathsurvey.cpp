@@ -0,0 +1,454 @@
+/**
+ ******************************************************************************
+ * @file       pathsurvey.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Path Planner Pluggin
+ * @{
+ * @brief Algorithm to cover the area of a path with survey lines
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <QInputDialog>
+#include <algorithms/pathsurvey.h>
+#include <waypoint.h>
+
+//! Lines closer than this are not worth flying, m
+#define MIN_SPACING 0.5
+
+PathSurvey::PathSurvey(QObject *parent) : IPathAlgorithm(parent)
+{
+    footprint_width = 30;
+    overlap = 20;
+}
+
+/**
+ * Ask for the camera footprint and the overlap of the lines
+ * @param[in] callingUi the QWidget that called this algorithm
+ * @return true for success, false for failure
+ */
+bool PathSurvey::configure(QWidget *callingUi)
+{
+    bool ok;
+    footprint_width = QInputDialog::getDouble(callingUi, tr("Survey the area of the path"),
+                                      tr("Width the camera sees across the lines in m:"),
+                                      footprint_width, 1, 10000, 1, &ok);
+    if (!ok)
+        return false;
+
+    overlap = QInputDialog::getDouble(callingUi, tr("Survey the area of the path"),
+                                      tr("Overlap of neighbouring lines in %:"),
+                                      overlap, 0, 90, 0, &ok);
+
+    return ok;
+}
+
+/**
+ * The waypoints are the corners of the area, so there must be an area
+ * @param[in] model the flight model to validate
+ * @param[out] err an error message for the user for invalid paths
+ * @return true for valid path, false for invalid
+ */
+bool PathSurvey::verifyPath(FlightDataModel *model, QString &err)
+{
+    if (model->rowCount() < 3) {
+        err = tr("The waypoints must outline the area to survey, at least three are needed");
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Replace the waypoints of the path, which outline the area, with the survey
+ * lines. Altitude and velocity are those of the first waypoint.
+ * @param model the flight model to process and update
+ * @return true for success, false for failure
+ */
+bool PathSurvey::processPath(FlightDataModel *model)
+{
+    const double spacing = footprint_width * (1 - overlap / 100);
+    if (spacing < MIN_SPACING)
+        return false;
+
+    QVector<Point> polygon;
+    for (int wpIdx = 0; wpIdx < model->rowCount(); wpIdx++) {
+        Point p;
+        p.x = model->data(model->index(wpIdx, FlightDataModel::NED_NORTH)).toDouble();
+        p.y = model->data(model->index(wpIdx, FlightDataModel::NED_EAST)).toDouble();
+        polygon.append(p);
+    }
+
+    const double down = model->data(model->index(0, FlightDataModel::NED_DOWN)).toDouble();
+    const float velocity = model->data(model->index(0, FlightDataModel::VELOCITY)).toFloat();
+
+    // Work in a frame where the lines run along x, north and east are
+    // x * u + y * w with w to the right of u
+    Point u = sweepDirection(polygon);
+    Point w = {-u.y, u.x};
+
+    QVector<Point> rotated;
+    foreach (const Point &p, polygon) {
+        Point r = {p.x * u.x + p.y * u.y, p.x * w.x + p.y * w.y};
+        rotated.append(r);
+    }
+
+    // Offline the path starts at home like for the fillets
+    Point home = {0, 0};
+    QVector<Point> route = orderCells(decompose(rotated, spacing), home);
+    if (route.isEmpty())
+        return false;
+
+    FlightDataModel *new_model = new FlightDataModel(this);
+    new_model->insertRows(0, route.size());
+
+    for (int i = 0; i < route.size(); i++) {
+        const Point &r = route.at(i);
+        new_model->setData(new_model->index(i, FlightDataModel::NED_NORTH), r.x * u.x + r.y * w.x);
+        new_model->setData(new_model->index(i, FlightDataModel::NED_EAST), r.x * u.y + r.y * w.y);
+        new_model->setData(new_model->index(i, FlightDataModel::NED_DOWN), down);
+        new_model->setData(new_model->index(i, FlightDataModel::VELOCITY), velocity);
+        new_model->setData(new_model->index(i, FlightDataModel::MODE_PARAMS), 0);
+        new_model->setData(new_model->index(i, FlightDataModel::MODE), Waypoint::MODE_VECTOR);
+    }
+
+    model->replaceData(new_model);
+    delete new_model;
+
+    return true;
+}
+
+//! Cross product of b - o and c - o, positive if c is left of the line o to b
+static double cross(const PathSurvey::Point &o, const PathSurvey::Point &b, const PathSurvey::Point &c)
+{
+    return (b.x - o.x) * (c.y - o.y) - (b.y - o.y) * (c.x - o.x);
+}
+
+static bool lessXY(const PathSurvey::Point &a, const PathSurvey::Point &b)
+{
+    return a.x < b.x || (a.x == b.x && a.y < b.y);
+}
+
+/**
+ * The fewest lines cover the polygon when they run parallel to the side of its
+ * convex hull across which the hull is narrowest, and that side is always one
+ * of the hull edges.
+ * @param[in] polygon The corners of the area
+ * @return Unit vector along the lines
+ */
+PathSurvey::Point PathSurvey::sweepDirection(const QVector<Point> &polygon)
+{
+    // Convex hull by the monotone chain
+    QVector<Point> sorted = polygon;
+    std::sort(sorted.begin(), sorted.end(), lessXY);
+
+    QVector<Point> hull;
+    for (int pass = 0; pass < 2; pass++) {
+        int chain_start = hull.size();
+        for (int i = 0; i < sorted.size(); i++) {
+            const Point &p = sorted.at(pass == 0 ? i : sorted.size() - 1 - i);
+            while (hull.size() >= chain_start + 2 &&
+                   cross(hull.at(hull.size() - 2), hull.last(), p) <= 0)
+                hull.removeLast();
+            hull.append(p);
+        }
+        // The last point of a chain is the first of the other
+        hull.removeLast();
+    }
+
+    Point best = {1, 0};
+    double best_width = DBL_MAX;
+
+    for (int i = 0; i < hull.size(); i++) {
+        const Point &a = hull.at(i);
+        const Point &b = hull.at((i + 1) % hull.size());
+        double length = hypot(b.x - a.x, b.y - a.y);
+        if (length < 1e-6)
+            continue;
+
+        Point dir = {(b.x - a.x) / length, (b.y - a.y) / length};
+
+        // The hull is left of each of its edges
+        double width = 0;
+        foreach (const Point &p, hull)
+            width = std::max(width, cross(a, b, p) / length);
+
+        if (width < best_width) {
+            best_width = width;
+            best = dir;
+        }
+    }
+
+    return best;
+}
+
+namespace {
+
+//! An edge of the polygon crossing the lines from ylo up to yhi
+struct SweepEdge {
+    double ylo;
+    double yhi;
+    double xlo;   //!< x at ylo
+    double slope; //!< dx / dy
+};
+
+bool lowerEdge(const SweepEdge &a, const SweepEdge &b)
+{
+    return a.ylo < b.ylo;
+}
+
+}
+
+/**
+ * Cut the polygon along evenly spaced lines of constant y. The edges are sorted
+ * by where they start, so each line only intersects the edges it crosses. Where
+ * a segment of a line overlaps exactly one of the line before, and no other
+ * segment overlaps that one, the two are in the same cell. Everywhere else the
+ * polygon splits or merges and a new cell is started.
+ * @param[in] polygon The corners of the area, in either order around
+ * @param[in] spacing Distance between the lines
+ * @return The cells, their segments in order of increasing y
+ */
+QVector<PathSurvey::Cell> PathSurvey::decompose(const QVector<Point> &polygon, double spacing)
+{
+    QVector<Cell> cells;
+    if (polygon.size() < 3 || spacing <= 0)
+        return cells;
+
+    double ymin = DBL_MAX;
+    double ymax = -DBL_MAX;
+    QVector<SweepEdge> edges;
+    for (int i = 0; i < polygon.size(); i++) {
+        const Point &a = polygon.at(i);
+        const Point &b = polygon.at((i + 1) % polygon.size());
+        ymin = std::min(ymin, a.y);
+        ymax = std::max(ymax, a.y);
+
+        // Edges along the lines don't cross them
+        if (a.y == b.y)
+            continue;
+
+        const Point &lo = a.y < b.y ? a : b;
+        const Point &hi = a.y < b.y ? b : a;
+        SweepEdge e = {lo.y, hi.y, lo.x, (hi.x - lo.x) / (hi.y - lo.y)};
+        edges.append(e);
+    }
+    std::sort(edges.begin(), edges.end(), lowerEdge);
+
+    // Center the lines on the area, a footprint is half a spacing either side
+    int num_lines = std::max(1, (int) ceil((ymax - ymin) / spacing));
+    double y0 = ymin + ((ymax - ymin) - (num_lines - 1) * spacing) / 2;
+
+    QVector<int> active;
+    int next_edge = 0;
+
+    QVector<Segment> previous;
+    QVector<int> previous_cell;
+
+    for (int line = 0; line < num_lines; line++) {
+        double y = y0 + line * spacing;
+
+        // An edge covers ylo <= y < yhi, so a line through a corner crosses
+        // the polygon once for each time it enters or leaves
+        while (next_edge < edges.size() && edges.at(next_edge).ylo <= y)
+            active.append(next_edge++);
+        for (int i = active.size() - 1; i >= 0; i--) {
+            if (edges.at(active.at(i)).yhi <= y)
+                active.remove(i);
+        }
+
+        QVector<double> crossings;
+        foreach (int i, active) {
+            const SweepEdge &e = edges.at(i);
+            crossings.append(e.xlo + (y - e.ylo) * e.slope);
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        QVector<Segment> current;
+        for (int i = 0; i + 1 < crossings.size(); i += 2) {
+            if (crossings.at(i + 1) - crossings.at(i) < 1e-6)
+                continue;
+            Segment s = {y, crossings.at(i), crossings.at(i + 1)};
+            current.append(s);
+        }
+
+        // Both lists are sorted, so the overlaps are found in one pass
+        QVector<int> previous_overlaps(previous.size(), 0);
+        QVector<int> current_overlaps(current.size(), 0);
+        QVector<int> match(current.size(), -1);
+        for (int i = 0, j = 0; i < previous.size() && j < current.size();) {
+            if (previous.at(i).x0 < current.at(j).x1 && current.at(j).x0 < previous.at(i).x1) {
+                previous_overlaps[i]++;
+                current_overlaps[j]++;
+                match[j] = i;
+            }
+
+            if (previous.at(i).x1 < current.at(j).x1)
+                i++;
+            else
+                j++;
+        }
+
+        QVector<int> current_cell(current.size());
+        for (int j = 0; j < current.size(); j++) {
+            if (current_overlaps.at(j) == 1 && previous_overlaps.at(match.at(j)) == 1) {
+                current_cell[j] = previous_cell.at(match.at(j));
+            } else {
+                current_cell[j] = cells.size();
+                cells.append(Cell());
+            }
+            cells[current_cell.at(j)].append(current.at(j));
+        }
+
+        previous = current;
+        previous_cell = current_cell;
+    }
+
+    return cells;
+}
+
+namespace {
+
+/**
+ * One of the four ways to fly a cell: from its first or its last segment, and
+ * starting at either end of that one
+ */
+struct CellWay {
+    static const int NUM_WAYS = 4;
+
+    static bool reversed(int way)   { return way & 1; }
+    static bool from_right(int way) { return way & 2; }
+
+    static PathSurvey::Point entry(const PathSurvey::Cell &cell, int way)
+    {
+        const PathSurvey::Segment &s = reversed(way) ? cell.last() : cell.first();
+        PathSurvey::Point p = {from_right(way) ? s.x1 : s.x0, s.y};
+        return p;
+    }
+
+    static PathSurvey::Point exit(const PathSurvey::Cell &cell, int way)
+    {
+        const PathSurvey::Segment &s = reversed(way) ? cell.first() : cell.last();
+
+        // Every segment changes the side, an odd number of them ends across
+        bool right = from_right(way) != (cell.size() % 2 == 1);
+        PathSurvey::Point p = {right ? s.x1 : s.x0, s.y};
+        return p;
+    }
+};
+
+double distance(const PathSurvey::Point &a, const PathSurvey::Point &b)
+{
+    return hypot(a.x - b.x, a.y - b.y);
+}
+
+}
+
+/**
+ * Decide in which order and which way to fly the cells. Each step flies to the
+ * nearest end of the cells left, and then the way each cell is flown is chosen
+ * again for the shortest transits with that order overall. The transits are
+ * straight and may cut over the outside of concave areas.
+ * @param[in] cells The cells to fly
+ * @param[in] start Where the vehicle comes from
+ * @return The ends of the segments in order
+ */
+QVector<PathSurvey::Point> PathSurvey::orderCells(const QVector<Cell> &cells, Point start)
+{
+    QVector<Point> route;
+    if (cells.isEmpty())
+        return route;
+
+    // Nearest neighbour order
+    QVector<int> order;
+    QVector<bool> done(cells.size(), false);
+    Point position = start;
+    for (int n = 0; n < cells.size(); n++) {
+        int best_cell = -1;
+        int best_way = 0;
+        double best_distance = DBL_MAX;
+
+        for (int c = 0; c < cells.size(); c++) {
+            if (done.at(c))
+                continue;
+            for (int way = 0; way < CellWay::NUM_WAYS; way++) {
+                double d = distance(position, CellWay::entry(cells.at(c), way));
+                if (d < best_distance) {
+                    best_distance = d;
+                    best_cell = c;
+                    best_way = way;
+                }
+            }
+        }
+
+        done[best_cell] = true;
+        order.append(best_cell);
+        position = CellWay::exit(cells.at(best_cell), best_way);
+    }
+
+    // With the order fixed the best ways follow from the shortest way to
+    // have flown each cell, trying all ways of the cell before
+    QVector<double> cost(cells.size() * CellWay::NUM_WAYS);
+    QVector<int> from(cells.size() * CellWay::NUM_WAYS, 0);
+    for (int way = 0; way < CellWay::NUM_WAYS; way++)
+        cost[way] = distance(start, CellWay::entry(cells.at(order.first()), way));
+
+    for (int n = 1; n < order.size(); n++) {
+        const Cell &previous = cells.at(order.at(n - 1));
+        const Cell &cell = cells.at(order.at(n));
+
+        for (int way = 0; way < CellWay::NUM_WAYS; way++) {
+            double best = DBL_MAX;
+            for (int previous_way = 0; previous_way < CellWay::NUM_WAYS; previous_way++) {
+                double c = cost.at((n - 1) * CellWay::NUM_WAYS + previous_way) +
+                        distance(CellWay::exit(previous, previous_way), CellWay::entry(cell, way));
+                if (c < best) {
+                    best = c;
+                    from[n * CellWay::NUM_WAYS + way] = previous_way;
+                }
+            }
+            cost[n * CellWay::NUM_WAYS + way] = best;
+        }
+    }
+
+    QVector<int> ways(order.size());
+    int last = (order.size() - 1) * CellWay::NUM_WAYS;
+    ways[order.size() - 1] = std::min_element(cost.begin() + last, cost.begin() + last + CellWay::NUM_WAYS) -
+            (cost.begin() + last);
+    for (int n = order.size() - 1; n > 0; n--)
+        ways[n - 1] = from.at(n * CellWay::NUM_WAYS + ways.at(n));
+
+    // Back and forth through each cell
+    for (int n = 0; n < order.size(); n++) {
+        const Cell &cell = cells.at(order.at(n));
+        bool right = CellWay::from_right(ways.at(n));
+
+        for (int i = 0; i < cell.size(); i++) {
+            const Segment &s = cell.at(CellWay::reversed(ways.at(n)) ? cell.size() - 1 - i : i);
+            Point a = {right ? s.x1 : s.x0, s.y};
+            Point b = {right ? s.x0 : s.x1, s.y};
+            route.append(a);
+            route.append(b);
+            right = !right;
+        }
+    }
+
+    return route;
+}
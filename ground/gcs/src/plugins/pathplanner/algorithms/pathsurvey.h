@@ -0,0 +1,104 @@
+/**
+ ******************************************************************************
+ * @file       pathsurvey.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @brief      Algorithm to cover the area of a path with survey lines
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup Path Planner Algorithms
+ * @{
+ * @brief Abstact algorithm that can be run on a path
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef PATHSURVEY_H
+#define PATHSURVEY_H
+
+#include <QVector>
+#include <ipathalgorithm.h>
+
+/**
+ * Replaces a path by lawnmower lines that cover the polygon its waypoints
+ * outline. The polygon is split into cells that each can be covered by
+ * going back and forth (a boustrophedon decomposition), and the cells are
+ * flown in the order and direction that keeps the transits between them
+ * short.
+ */
+class PATHPLANNER_EXPORT PathSurvey : public IPathAlgorithm
+{
+    Q_OBJECT
+
+public:
+
+    explicit PathSurvey(QObject *parent = 0);
+
+    /**
+     * Verify the path is valid to run through this algorithm
+     * @param[in] model the flight model to validate
+     * @param[out] err an error message for the user for invalid paths
+     * @return true for valid path, false for invalid
+     */
+    virtual bool verifyPath(FlightDataModel *model, QString &err);
+
+    /**
+     * Process the flight path according to the algorithm
+     * @param model the flight model to process and update
+     * @return true for success, false for failure
+     */
+    virtual bool processPath(FlightDataModel *model);
+
+    /**
+     * Present a UI to configure options for the algorithm
+     * @param callingUi the QWidget that called this algorithm
+     * @return true for success, false for failure
+     */
+    virtual bool configure(QWidget *callingUi = 0);
+
+    //! A point in m, north and east or along and across the lines
+    struct Point {
+        double x;
+        double y;
+    };
+
+    //! Part of a survey line inside the polygon, from x0 to x1 at y
+    struct Segment {
+        double y;
+        double x0;
+        double x1;
+    };
+
+    //! Segments of successive lines that are flown back and forth
+    typedef QVector<Segment> Cell;
+
+private:
+
+    //! Width of the ground the camera sees, across the lines
+    double footprint_width;
+
+    //! Overlap of neighbouring lines in percent
+    double overlap;
+
+    //! Split a polygon into cells along lines of constant y spacing apart
+    static QVector<Cell> decompose(const QVector<Point> &polygon, double spacing);
+
+    //! Direction of the lines that needs the fewest of them
+    static Point sweepDirection(const QVector<Point> &polygon);
+
+    //! The points to fly through, taking the cells in a good order
+    static QVector<Point> orderCells(const QVector<Cell> &cells, Point start);
+};
+
+#endif // PATHSURVEY_H
@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file       flightdatamodel.cpp
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2015
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
  * @addtogroup GCSPlugins GCS Plugins
  * @{
@@ -831,14 +831,16 @@ bool FlightDataModel::setNED(int index, struct FlightDataModel::NED NED)
 bool FlightDataModel::replaceData(FlightDataModel *newModel)
 {
     // Delete existing data
-    removeRows(0,rowCount());
-
-    for (int i = 0; i < newModel->rowCount(); i++) {
-        insertRow(i);
-        for (int j = 0; j < newModel->columnCount(); j++) {
-            // Use Qt::UserRole to make sure the mode is fetched numerically
-            setData(index(i,j), newModel->data(newModel->index(i, j), Qt::UserRole));
-        }
+    if (rowCount() > 0)
+        removeRows(0,rowCount());
+
+    // Copy all the rows at once. Setting them a field at a time makes the map
+    // redraw the whole path for every one, which takes ages for long paths.
+    if (newModel->rowCount() > 0) {
+        beginInsertRows(QModelIndex(), 0, newModel->rowCount() - 1);
+        foreach (PathPlanData *row, newModel->dataStorage)
+            dataStorage.append(new PathPlanData(*row));
+        endInsertRows();
     }
 
     fixupValidationErrors();
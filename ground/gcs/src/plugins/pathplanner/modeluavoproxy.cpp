@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file       modeluavproxy.cpp
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
  * @addtogroup GCSPlugins GCS Plugins
  * @{
@@ -26,6 +26,7 @@
  */
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QEventLoop>
 #include <QTimer>
 #include "modeluavoproxy.h"
@@ -35,6 +36,26 @@
 #include "utils/coordinateconversions.h"
 #include "homelocation.h"
 
+//! Waypoints in each WaypointUpload chunk
+static const int UPLOAD_CHUNK = WaypointUpload::MODE_NUMELEM;
+//! Chunks sent before waiting for the board, each has its own instance
+static const int UPLOAD_WINDOW = 4;
+//! How long to wait for the board to answer
+static const int UPLOAD_TIMEOUT_MS = 1000;
+static const int UPLOAD_RETRIES = 5;
+
+//! The CRC32 of PIOS_CRC32_updateCRC() on the board
+static quint32 updateCrc32(quint32 crc, const void *data, int length)
+{
+    const quint8 *bytes = static_cast<const quint8 *>(data);
+    for (int i = 0; i < length; i++) {
+        crc ^= (quint32)bytes[i] << 24;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+    }
+    return crc;
+}
+
 //! Initialize the model uavo proxy
 ModelUavoProxy::ModelUavoProxy(QObject *parent, FlightDataModel *model):QObject(parent),myModel(model)
 {
@@ -44,6 +65,14 @@ ModelUavoProxy::ModelUavoProxy(QObject *parent, FlightDataModel *model):QObject(
     Q_ASSERT(objManager != NULL);
     waypointObj = Waypoint::GetInstance(objManager);
     Q_ASSERT(waypointObj != NULL);
+
+    uploadTransfer = 0;
+    uploadStatusArrived = false;
+    WaypointUploadStatus *status = WaypointUploadStatus::GetInstance(objManager);
+    if (status != NULL) {
+        uploadStatus = status->getData();
+        connect(status, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(uploadStatusUpdated(UAVObject*)));
+    }
 }
 
 /**
@@ -65,9 +94,20 @@ bool ModelUavoProxy::modelToObjects()
     wp->setMetadata(meta);
 
     double homeLLA[3];
-    double NED[3];
-    double LLA[3];
     getHomeLocation(homeLLA);
+
+    QList<Waypoint::DataFields> waypoints;
+    for (int x = 0; x < myModel->rowCount(); x++)
+        waypoints.append(rowToWaypoint(x, homeLLA));
+
+    // Boards that answer the WaypointUpload get the whole path in one transfer
+    bool supported;
+    bool uploaded = bulkUpload(waypoints, &supported);
+    if (supported) {
+        wp->setMetadata(initialMeta);
+        return uploaded;
+    }
+
     bool newInstance;
 
     // Get the number of existing waypoints
@@ -100,21 +140,7 @@ bool ModelUavoProxy::modelToObjects()
         }
 
         Q_ASSERT(wp);
-        Waypoint::DataFields waypoint = wp->getData();
-
-        // Convert from LLA to NED for sending to the model
-        LLA[0] = myModel->data(myModel->index(x,FlightDataModel::LATPOSITION)).toDouble();
-        LLA[1] = myModel->data(myModel->index(x,FlightDataModel::LNGPOSITION)).toDouble();
-        LLA[2] = myModel->data(myModel->index(x,FlightDataModel::ALTITUDE)).toDouble();
-        Utils::CoordinateConversions().LLA2NED_HomeLLA(LLA, homeLLA, NED);
-
-        // Fetch the data from the internal model
-        waypoint.Velocity=myModel->data(myModel->index(x,FlightDataModel::VELOCITY)).toFloat();
-        waypoint.Position[Waypoint::POSITION_NORTH] = NED[0];
-        waypoint.Position[Waypoint::POSITION_EAST]  = NED[1];
-        waypoint.Position[Waypoint::POSITION_DOWN]  = NED[2];
-        waypoint.Mode = myModel->data(myModel->index(x,FlightDataModel::MODE), Qt::UserRole).toInt();
-        waypoint.ModeParameters = myModel->data(myModel->index(x,FlightDataModel::MODE_PARAMS)).toFloat();
+        Waypoint::DataFields waypoint = waypoints[x];
 
         if (robustUpdate(waypoint, x)) {
             qDebug() << "Successfully updated";
@@ -155,6 +181,278 @@ bool ModelUavoProxy::modelToObjects()
     return true;
 }
 
+/**
+ * @brief rowToWaypoint Convert a row of the model to a waypoint
+ * @param row The row of the model
+ * @param homeLLA The home location the waypoint is relative to
+ * @return The waypoint
+ */
+Waypoint::DataFields ModelUavoProxy::rowToWaypoint(int row, double *homeLLA)
+{
+    Waypoint::DataFields waypoint;
+    double NED[3];
+    double LLA[3];
+
+    // Convert from LLA to NED for sending to the model
+    LLA[0] = myModel->data(myModel->index(row,FlightDataModel::LATPOSITION)).toDouble();
+    LLA[1] = myModel->data(myModel->index(row,FlightDataModel::LNGPOSITION)).toDouble();
+    LLA[2] = myModel->data(myModel->index(row,FlightDataModel::ALTITUDE)).toDouble();
+    Utils::CoordinateConversions().LLA2NED_HomeLLA(LLA, homeLLA, NED);
+
+    // Fetch the data from the internal model
+    waypoint.Velocity=myModel->data(myModel->index(row,FlightDataModel::VELOCITY)).toFloat();
+    waypoint.Position[Waypoint::POSITION_NORTH] = NED[0];
+    waypoint.Position[Waypoint::POSITION_EAST]  = NED[1];
+    waypoint.Position[Waypoint::POSITION_DOWN]  = NED[2];
+    waypoint.Mode = myModel->data(myModel->index(row,FlightDataModel::MODE), Qt::UserRole).toInt();
+    waypoint.ModeParameters = myModel->data(myModel->index(row,FlightDataModel::MODE_PARAMS)).toFloat();
+
+    return waypoint;
+}
+
+/**
+ * @brief bulkUpload Send the whole path in one WaypointUpload transfer
+ *
+ * Chunks of waypoints are sent a window at a time without acks. The board
+ * only takes them in order and reports how many it has, so lost chunks are
+ * sent again from there. The path replaces the waypoints on the board at
+ * once when the CRC of all of them matches.
+ * @param waypoints The path
+ * @param[out] supported False if the board never answered, so it should be
+ * uploaded a waypoint at a time
+ * @return True if the board has the path
+ */
+bool ModelUavoProxy::bulkUpload(const QList<Waypoint::DataFields> &waypoints, bool *supported)
+{
+    *supported = false;
+
+    if (WaypointUploadStatus::GetInstance(objManager) == NULL || uploadInstance(0) == NULL)
+        return false;
+
+    const int total = waypoints.size();
+    uploadTransfer = uploadStatus.Transfer + 1;
+
+    WaypointUpload::DataFields upload = uploadInstance(0)->getData();
+    upload.Transfer = uploadTransfer;
+
+    // Start the transfer
+    upload.Command = WaypointUpload::COMMAND_BEGIN;
+    upload.Slot = 0;
+    upload.Sequence = 0;
+    upload.Count = total;
+    upload.Crc = 0;
+
+    bool started = false;
+    for (int i = 0; i < UPLOAD_RETRIES && !started; i++) {
+        sendUpload(0, upload);
+        started = waitForUploadStatus(UPLOAD_TIMEOUT_MS) &&
+                uploadStatus.State == WaypointUploadStatus::STATE_RECEIVING &&
+                uploadStatus.Received == 0;
+    }
+
+    if (!started)
+        return false;
+
+    *supported = true;
+
+    // The CRC of the waypoints as they are packed into the chunks
+    quint32 crc = 0;
+    for (int i = 0; i < total; i++) {
+        const Waypoint::DataFields &waypoint = waypoints[i];
+        quint8 mode = waypoint.Mode;
+        crc = updateCrc32(crc, &waypoint.Position[Waypoint::POSITION_NORTH], sizeof(float));
+        crc = updateCrc32(crc, &waypoint.Position[Waypoint::POSITION_EAST], sizeof(float));
+        crc = updateCrc32(crc, &waypoint.Position[Waypoint::POSITION_DOWN], sizeof(float));
+        crc = updateCrc32(crc, &waypoint.Velocity, sizeof(float));
+        crc = updateCrc32(crc, &waypoint.ModeParameters, sizeof(float));
+        crc = updateCrc32(crc, &mode, 1);
+    }
+
+    int received = 0;
+    int next = 0;
+    int stalls = 0;
+    int unchanged = 0;
+    upload.Command = WaypointUpload::COMMAND_DATA;
+
+    while (received < total) {
+        // Fill the window
+        while (next < total && next < received + UPLOAD_WINDOW * UPLOAD_CHUNK) {
+            int count = qMin(UPLOAD_CHUNK, total - next);
+            upload.Sequence = next;
+            upload.Count = count;
+            for (int i = 0; i < count; i++) {
+                const Waypoint::DataFields &waypoint = waypoints[next + i];
+                upload.North[i] = waypoint.Position[Waypoint::POSITION_NORTH];
+                upload.East[i] = waypoint.Position[Waypoint::POSITION_EAST];
+                upload.Down[i] = waypoint.Position[Waypoint::POSITION_DOWN];
+                upload.Velocity[i] = waypoint.Velocity;
+                upload.ModeParameters[i] = waypoint.ModeParameters;
+                upload.Mode[i] = waypoint.Mode;
+            }
+            sendUpload((next / UPLOAD_CHUNK) % UPLOAD_WINDOW, upload);
+            next += count;
+        }
+
+        if (!waitForUploadStatus(UPLOAD_TIMEOUT_MS)) {
+            if (++stalls > UPLOAD_RETRIES)
+                break;
+
+            // Everything after what arrived is sent again
+            next = received;
+            unchanged = 0;
+            continue;
+        }
+
+        if (uploadStatus.State != WaypointUploadStatus::STATE_RECEIVING)
+            break;
+
+        if (uploadStatus.Received > received) {
+            received = uploadStatus.Received;
+            stalls = 0;
+            unchanged = 0;
+            emit sendPathPlanToUavProgress(100 * received / (total + 1));
+        } else if (uploadStatus.Received == received && next > received) {
+            // All the chunks after a lost one were answered without being taken
+            int outstanding = (next - received + UPLOAD_CHUNK - 1) / UPLOAD_CHUNK;
+            if (++unchanged >= outstanding) {
+                next = received;
+                unchanged = 0;
+            }
+        }
+    }
+
+    if (received < total) {
+        qDebug() << "Waypoint upload stopped at" << received << "of" << total;
+        abortUpload(upload);
+        return false;
+    }
+
+    // Swap the path in
+    upload.Command = WaypointUpload::COMMAND_COMMIT;
+    upload.Sequence = 0;
+    upload.Count = total;
+    upload.Crc = crc;
+
+    bool committed = false;
+    for (int i = 0; i < UPLOAD_RETRIES && !committed; i++) {
+        sendUpload(0, upload);
+
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < UPLOAD_TIMEOUT_MS &&
+               waitForUploadStatus(UPLOAD_TIMEOUT_MS - timer.elapsed())) {
+            if (uploadStatus.State == WaypointUploadStatus::STATE_FAILED) {
+                qDebug() << "Waypoint upload failed with error" << uploadStatus.Error;
+                return false;
+            }
+            if (uploadStatus.State == WaypointUploadStatus::STATE_COMMITTED) {
+                committed = true;
+                break;
+            }
+        }
+    }
+
+    if (!committed) {
+        abortUpload(upload);
+        return false;
+    }
+
+    // The board now has these, without sending them again
+    int instances = Waypoint::getNumInstances(objManager);
+    for (int x = 0; x < qMax(total, instances); x++) {
+        Waypoint *wp = Waypoint::GetInstance(objManager, x);
+        if (wp == NULL) {
+            wp = new Waypoint;
+            wp->initialize(x, wp->getMetaObject());
+            objManager->registerObject(wp);
+        }
+
+        if (x < total) {
+            wp->setData(waypoints[x]);
+        } else {
+            Waypoint::DataFields waypoint = wp->getData();
+            waypoint.Mode = Waypoint::MODE_INVALID;
+            wp->setData(waypoint);
+        }
+    }
+
+    emit sendPathPlanToUavProgress(100);
+    return true;
+}
+
+/**
+ * @brief uploadInstance Get an instance of the WaypointUpload, creating it if needed
+ */
+WaypointUpload *ModelUavoProxy::uploadInstance(int instance)
+{
+    WaypointUpload *upload = WaypointUpload::GetInstance(objManager, instance);
+    if (upload == NULL) {
+        upload = new WaypointUpload;
+        upload->initialize(instance, upload->getMetaObject());
+        objManager->registerObject(upload);
+    }
+    return upload;
+}
+
+/**
+ * @brief sendUpload Send a chunk or command of the transfer
+ */
+void ModelUavoProxy::sendUpload(int instance, const WaypointUpload::DataFields &data)
+{
+    WaypointUpload *upload = uploadInstance(instance);
+    upload->setData(data);
+    upload->updated();
+}
+
+/**
+ * @brief abortUpload Tell the board to drop what it received
+ */
+void ModelUavoProxy::abortUpload(WaypointUpload::DataFields upload)
+{
+    upload.Command = WaypointUpload::COMMAND_ABORT;
+    sendUpload(0, upload);
+}
+
+/**
+ * @brief waitForUploadStatus Wait for the board to report on the current transfer
+ * @param timeoutMs How long to wait
+ * @return True if a status arrived
+ */
+bool ModelUavoProxy::waitForUploadStatus(int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while (timer.elapsed() < timeoutMs) {
+        uploadStatusArrived = false;
+
+        QEventLoop loop;
+        QTimer::singleShot(timeoutMs - timer.elapsed(), &loop, SLOT(quit()));
+        connect(this, SIGNAL(uploadStatusReceived()), &loop, SLOT(quit()));
+        loop.exec();
+
+        // Answers to an earlier transfer are waited past
+        if (uploadStatusArrived && uploadStatus.Transfer == uploadTransfer)
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief uploadStatusUpdated Keep the last status the board sent
+ */
+void ModelUavoProxy::uploadStatusUpdated(UAVObject *obj)
+{
+    WaypointUploadStatus *status = qobject_cast<WaypointUploadStatus *>(obj);
+    if (status == NULL)
+        return;
+
+    uploadStatus = status->getData();
+    uploadStatusArrived = true;
+    emit uploadStatusReceived();
+}
+
 /**
  * @brief robustUpdate Upload a waypoint and check for an ACK or retry.
  * @param data The data to set
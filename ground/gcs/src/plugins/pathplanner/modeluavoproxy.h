@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file       modeluavproxy.h
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @author     The OpenPilot Team, http://www.openpilot.org Copyright (C) 2012.
  * @addtogroup GCSPlugins GCS Plugins
  * @{
@@ -31,6 +31,8 @@
 #include "flightdatamodel.h"
 #include "modeluavoproxy.h"
 #include "waypoint.h"
+#include "waypointupload.h"
+#include "waypointuploadstatus.h"
 
 class ModelUavoProxy:public QObject
 {
@@ -45,6 +47,16 @@ private:
     //! Fetch the home LLA position
     bool getHomeLocation(double *homeLLA);
 
+    //! Convert a row of the model to a waypoint
+    Waypoint::DataFields rowToWaypoint(int row, double *homeLLA);
+
+    //! Send the whole path in one transfer
+    bool bulkUpload(const QList<Waypoint::DataFields> &waypoints, bool *supported);
+    WaypointUpload *uploadInstance(int instance);
+    void sendUpload(int instance, const WaypointUpload::DataFields &data);
+    void abortUpload(WaypointUpload::DataFields upload);
+    bool waitForUploadStatus(int timeoutMs);
+
 public slots:
     //! Cast from the internal representation to the UAVOs
     bool modelToObjects();
@@ -55,9 +67,13 @@ public slots:
     //! Whenever a waypoint transaction is completed
     void waypointTransactionCompleted(UAVObject *, bool);
 
+    //! Whenever the board reports on a bulk upload
+    void uploadStatusUpdated(UAVObject *);
+
 signals:
     void waypointTransactionSucceeded();
     void waypointTransactionFailed();
+    void uploadStatusReceived();
     void sendPathPlanToUavProgress(int percent);
 private:
     UAVObjectManager *objManager;
@@ -67,6 +83,11 @@ private:
     //! Track if each waypoint was updated
     QMap<int, bool>  waypointTransactionResult;
 
+    //! The bulk upload in progress and what the board last said about it
+    quint8 uploadTransfer;
+    WaypointUploadStatus::DataFields uploadStatus;
+    bool uploadStatusArrived;
+
 };
 
 #endif // ModelUavoProxy_H
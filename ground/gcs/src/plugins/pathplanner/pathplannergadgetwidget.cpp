@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file       pathplannergadgetwidget.cpp
- * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2013
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2012-2016
  * @addtogroup GCSPlugins GCS Plugins
  * @{
  * @addtogroup PathPlannerGadgetPlugin Path Planner Gadget Plugin
@@ -34,8 +34,10 @@
 #include <QTextEdit>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QMessageBox>
 
 #include "algorithms/pathfillet.h"
+#include "algorithms/pathsurvey.h"
 #include "extensionsystem/pluginmanager.h"
 
 PathPlannerGadgetWidget::PathPlannerGadgetWidget(QWidget *parent) : QLabel(parent), prevModel(NULL)
@@ -160,32 +162,52 @@ void PathPlannerGadgetWidget::on_tbFetchFromUAV_clicked()
  */
 void PathPlannerGadgetWidget::on_tbFilletPath_clicked()
 {
-    // Create a copy of the model before filleting
+    runAlgorithm(new PathFillet(this));
+}
+
+/**
+ * @brief PathPlannerGadgetWidget::on_tbFilletPath_clicked Apply fillets to the current path
+ */
+void PathPlannerGadgetWidget::on_tbUnfilletPath_clicked()
+{
+    if (prevModel)
+        model->replaceData(prevModel);
+}
+
+/**
+ * @brief PathPlannerGadgetWidget::on_tbSurveyPath_clicked Cover the area the path outlines
+ */
+void PathPlannerGadgetWidget::on_tbSurveyPath_clicked()
+{
+    runAlgorithm(new PathSurvey(this));
+}
+
+/**
+ * @brief PathPlannerGadgetWidget::runAlgorithm Process the path, the path before can be restored
+ * @param algo The algorithm to run, deleted when done
+ */
+void PathPlannerGadgetWidget::runAlgorithm(IPathAlgorithm *algo)
+{
+    // Create a copy of the model before processing
     if (!prevModel)
         prevModel = new FlightDataModel(this);
     Q_ASSERT(prevModel);
     if (prevModel)
         prevModel->replaceData(model);
 
-    IPathAlgorithm * algo = new PathFillet(this);
     // Only process is successfully configured and the verification of the model succeeds
     QString err;
-    if(algo->configure(this) && algo->verifyPath(model, err)) {
-        // If unsuccessful delete the cached model
-        if (!algo->processPath(model)) {
+    if (algo->configure(this)) {
+        if (!algo->verifyPath(model, err)) {
+            QMessageBox::information(this, tr("Unable to process the path"), err);
+        } else if (!algo->processPath(model)) {
+            // If unsuccessful delete the cached model
             delete prevModel;
             prevModel = NULL;
         }
     }
-}
 
-/**
- * @brief PathPlannerGadgetWidget::on_tbFilletPath_clicked Apply fillets to the current path
- */
-void PathPlannerGadgetWidget::on_tbUnfilletPath_clicked()
-{
-    if (prevModel)
-        model->replaceData(prevModel);
+    delete algo;
 }
 
 void PathPlannerGadgetWidget::on_waypointSendProgress(int value)
@@ -32,6 +32,7 @@
 #include <QItemSelectionModel>
 #include "flightdatamodel.h"
 #include "modeluavoproxy.h"
+#include "ipathalgorithm.h"
 
 class Ui_PathPlanner;
 
@@ -67,6 +68,9 @@ private slots:
     //! Restore path before filleting
     void on_tbUnfilletPath_clicked();
 
+    //! Replace the outline of an area with survey lines
+    void on_tbSurveyPath_clicked();
+
     void on_waypointSendProgress(int);
 private:
     Ui_PathPlanner  *ui;
@@ -77,6 +81,9 @@ private:
     //! Store previous models for rolling back changes
     FlightDataModel *prevModel;
     void enableButtons(bool);
+
+    //! Run an algorithm on the path, keeping the path before it
+    void runAlgorithm(IPathAlgorithm *algo);
 signals:
     void sendPathPlanToUAV();
     void receivePathPlanFromUAV();
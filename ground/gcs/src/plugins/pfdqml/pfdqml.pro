@@ -14,7 +14,8 @@ HEADERS += \
     pfdqmlgadgetwidget.h \
     pfdqmlgadgetfactory.h \
     pfdqmlgadgetconfiguration.h \
-    pfdqmlgadgetoptionspage.h
+    pfdqmlgadgetoptionspage.h \
+    pfdqmlpropertybridge.h
 
 SOURCES += \
     pfdqmlplugin.cpp \
@@ -22,7 +23,8 @@ SOURCES += \
     pfdqmlgadgetfactory.cpp \
     pfdqmlgadgetwidget.cpp \
     pfdqmlgadgetconfiguration.cpp \
-    pfdqmlgadgetoptionspage.cpp
+    pfdqmlgadgetoptionspage.cpp \
+    pfdqmlpropertybridge.cpp
 
 OTHER_FILES += PfdQml.pluginspec \
     PfdQml.json
@@ -17,7 +17,8 @@
 #include "pfdqmlgadgetwidget.h"
 #include "extensionsystem/pluginmanager.h"
 #include "uavobjectmanager.h"
-#include "uavobject.h"
+#include "uavdataobject.h"
+#include "pfdqmlpropertybridge.h"
 #include "utils/svgimageprovider.h"
 #include <QDebug>
 #include <QSvgRenderer>
@@ -54,6 +55,8 @@ PfdQmlGadgetWidget::PfdQmlGadgetWidget(QWindow *parent) :
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     m_objManager = pm->getObject<UAVObjectManager>();
 
+    m_propertyBridge = new PfdQmlPropertyBridge(this);
+
     foreach (const QString &objectName, objectsToExport) {
         exportUAVOInstance(objectName, 0);
     }
@@ -69,15 +72,15 @@ PfdQmlGadgetWidget::~PfdQmlGadgetWidget()
 
 /**
  * @brief PfdQmlGadgetWidget::exportUAVOInstance Makes the UAVO available inside the QML. This works via the Q_PROPERTY()
- * values in the UAVO synthetic-headers
+ * values in the UAVO synthetic-headers. QML gets the copy kept by the property bridge, which follows the UAVO once per frame.
  * @param objectName UAVObject name
  * @param instId Instance ID
  */
 void PfdQmlGadgetWidget::exportUAVOInstance(const QString &objectName, int instId)
 {
-    UAVObject* object = m_objManager->getObject(objectName, instId);
+    UAVDataObject* object = dynamic_cast<UAVDataObject*>(m_objManager->getObject(objectName, instId));
     if (object)
-        engine()->rootContext()->setContextProperty(objectName, object);
+        engine()->rootContext()->setContextProperty(objectName, m_propertyBridge->mirror(object));
     else
         qWarning() << "[PFDQML] Failed to load object" << objectName;
 }
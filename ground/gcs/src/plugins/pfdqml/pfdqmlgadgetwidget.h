@@ -21,6 +21,7 @@
 #include <QtQuick/QQuickView>
 
 class UAVObjectManager;
+class PfdQmlPropertyBridge;
 
 class PfdQmlGadgetWidget : public QQuickView
 {
@@ -42,6 +43,7 @@ private:
     QString m_qmlFileName;
 
     UAVObjectManager *m_objManager;
+    PfdQmlPropertyBridge *m_propertyBridge;
     void exportUAVOInstance(const QString &objectName, int instId);
     void resetUAVOExport(const QString &objectName, int instId);
 };
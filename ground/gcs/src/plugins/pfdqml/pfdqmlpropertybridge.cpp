@@ -0,0 +1,91 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "pfdqmlpropertybridge.h"
+#include "uavdataobject.h"
+#include <QtQuick/QQuickWindow>
+
+PfdQmlPropertyBridge::PfdQmlPropertyBridge(QQuickWindow *window) :
+    QObject(window),
+    m_window(window),
+    m_frameRequested(false)
+{
+    // Emitted in the GUI thread before every frame, whichever render loop is used
+    connect(m_window, SIGNAL(afterAnimating()), this, SLOT(flush()));
+}
+
+PfdQmlPropertyBridge::~PfdQmlPropertyBridge()
+{
+    qDeleteAll(m_mirrors);
+}
+
+/**
+ * @brief PfdQmlPropertyBridge::mirror Creates the copy QML binds to, the
+ * same copy is returned for an object that is exported again
+ */
+QObject *PfdQmlPropertyBridge::mirror(UAVDataObject *object)
+{
+    UAVDataObject *copy = m_mirrors.value(object);
+    if (copy)
+        return copy;
+
+    // The copy is not registered anywhere, nothing but QML ever sees it
+    copy = object->dirtyClone();
+    m_mirrors.insert(object, copy);
+    connect(object, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)));
+
+    m_dirty.insert(object);
+    flush();
+
+    return copy;
+}
+
+/**
+ * @brief PfdQmlPropertyBridge::objectUpdated Only remembers the object, and
+ * asks for a frame if none is coming yet
+ */
+void PfdQmlPropertyBridge::objectUpdated(UAVObject *object)
+{
+    m_dirty.insert(object);
+
+    if (!m_frameRequested) {
+        m_frameRequested = true;
+        m_window->update();
+    }
+}
+
+/**
+ * @brief PfdQmlPropertyBridge::flush Copies the latest values of the objects
+ * updated since the last frame. The copies emit their notifications as they
+ * are unpacked, so the bindings are evaluated once, with the values of this
+ * frame.
+ */
+void PfdQmlPropertyBridge::flush()
+{
+    m_frameRequested = false;
+
+    foreach (UAVObject *object, m_dirty) {
+        UAVDataObject *copy = m_mirrors.value(object);
+        if (!copy)
+            continue;
+
+        m_buffer.resize(object->getNumBytes());
+        object->pack(m_buffer.data());
+        copy->unpack(m_buffer.constData());
+    }
+
+    m_dirty.clear();
+}
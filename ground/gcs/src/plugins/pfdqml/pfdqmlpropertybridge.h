@@ -0,0 +1,59 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PFDQMLPROPERTYBRIDGE_H_
+#define PFDQMLPROPERTYBRIDGE_H_
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+class QQuickWindow;
+class UAVObject;
+class UAVDataObject;
+
+/**
+ * @brief The PfdQmlPropertyBridge class Stands between the UAVOs and the QML
+ * bindings of a view. QML binds to a private copy of each exported object,
+ * the copies are refreshed from the live objects once per frame, right before
+ * the scene is synchronized. However often an object is updated, its
+ * properties change at most once per frame, and all of them together.
+ */
+class PfdQmlPropertyBridge : public QObject
+{
+    Q_OBJECT
+
+public:
+    PfdQmlPropertyBridge(QQuickWindow *window);
+    ~PfdQmlPropertyBridge();
+
+    //! Returns the copy of the object to hand to QML
+    QObject *mirror(UAVDataObject *object);
+
+private slots:
+    void objectUpdated(UAVObject *object);
+    void flush();
+
+private:
+    QQuickWindow *m_window;
+    QHash<UAVObject*, UAVDataObject*> m_mirrors;
+    QSet<UAVObject*> m_dirty;
+    QVector<quint8> m_buffer;
+    bool m_frameRequested;
+};
+
+#endif /* PFDQMLPROPERTYBRIDGE_H_ */
@@ -201,10 +201,22 @@ void PicoCGadgetWidget::on_tbSendToUAVROM_clicked()
 
     // check command status after execution
     if ((pcStatus->getCommand() == PicoCStatus::COMMAND_IDLE) && (pcStatus->getCommandError() == 0)) {
-        QMessageBox::information(0,
-                              tr("PicoC UAV ROM"),
-                              tr("Save to UAV ROM finished."),
-                              QMessageBox::Ok);
+        // compile the saved script, so the UAV can start it without parsing the source
+        pcStatus->setCommand(PicoCStatus::COMMAND_COMPILEFILE);
+        pcStatus->updated();
+        waitForExecution();
+
+        if ((pcStatus->getCommand() == PicoCStatus::COMMAND_IDLE) && (pcStatus->getCommandError() == 0)) {
+            QMessageBox::information(0,
+                                  tr("PicoC UAV ROM"),
+                                  tr("Save to UAV ROM finished."),
+                                  QMessageBox::Ok);
+        } else {
+            QMessageBox::warning(0,
+                                  tr("PicoC UAV ROM"),
+                                  tr("Saved to UAV ROM, but compiling on the UAV failed."),
+                                  QMessageBox::Ok);
+        }
     } else {
         QMessageBox::critical(0,
                               tr("PicoC UAV ROM"),
@@ -223,6 +223,7 @@ KML {
     plugin_gcscontrolplugin.subdir = gcscontrolplugin
     plugin_gcscontrolplugin.depends = plugin_coreplugin
     plugin_gcscontrolplugin.depends += plugin_uavobjects
+    plugin_gcscontrolplugin.depends += plugin_uavtalk
     SUBDIRS += plugin_gcscontrolplugin
 }
 
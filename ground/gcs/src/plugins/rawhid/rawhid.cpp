@@ -34,7 +34,8 @@
 #include <QtGlobal>
 #include <QList>
 #include <QMutexLocker>
-#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QSemaphore>
 
 class IConnection;
 
@@ -42,13 +43,150 @@ class IConnection;
 static const int READ_TIMEOUT = 200;
 static const int READ_SIZE = 64;
 
+//reports already queued by the OS are read together before readyRead is emitted
+static const int READ_BATCH = 32;
+
 static const int WRITE_TIMEOUT = 1000;
 static const int WRITE_SIZE = 64;
 
 static const int WRITE_RETRIES = 3;
 
+//ring sizes in bytes, must be powers of two
+static const int READ_RING_SIZE = 32768;
+static const int WRITE_RING_SIZE = 32768;
+
+
+// *********************************************************************************
+
+/**
+*   Single producer, single consumer byte ring between a HID thread and the
+*   QIODevice side. Only the producer moves the head and only the consumer
+*   moves the tail, so neither side takes a lock to pass data. Both indices
+*   run over twice the size so a full ring can be told from an empty one.
+*/
+class RawHIDRing
+{
+public:
+    RawHIDRing(int size);
+    ~RawHIDRing();
+
+    /** Number of bytes in the ring, callable from either side */
+    int used() const;
+
+    /** Producer: copy in as much of data as fits, return the bytes taken */
+    int write(const char *data, int size);
+
+    /** Consumer: copy out up to size bytes without removing them */
+    int peek(char *data, int size) const;
+
+    /** Consumer: remove size bytes that were peeked */
+    void consume(int size);
+
+    /** Consumer: wait until there is data, false on timeout */
+    bool waitForData(int timeout);
+
+    /** Producer: wait until the consumer frees some space, false on timeout */
+    bool waitForSpace(int timeout);
+
+    /** Wake up both sides, e.g. to shut down a thread */
+    void wakeAll();
+
+private:
+    char *m_buffer;
+    const int m_size;
+    QAtomicInt m_head;
+    QAtomicInt m_tail;
+    QSemaphore m_dataAdded;
+    QSemaphore m_spaceFreed;
+};
+
+RawHIDRing::RawHIDRing(int size)
+    : m_buffer(new char[size]),
+      m_size(size),
+      m_head(0),
+      m_tail(0)
+{
+    Q_ASSERT((size & (size - 1)) == 0);
+}
+
+RawHIDRing::~RawHIDRing()
+{
+    delete[] m_buffer;
+}
+
+int RawHIDRing::used() const
+{
+    return (m_head.loadAcquire() - m_tail.loadAcquire()) & (2 * m_size - 1);
+}
+
+int RawHIDRing::write(const char *data, int size)
+{
+    int head = m_head.load();
+
+    size = qMin(size, m_size - used());
+    if (size <= 0)
+        return 0;
+
+    int start = head & (m_size - 1);
+    int first = qMin(size, m_size - start);
+    memcpy(&m_buffer[start], data, first);
+    memcpy(&m_buffer[0], data + first, size - first);
+
+    m_head.storeRelease((head + size) & (2 * m_size - 1));
+    m_dataAdded.release();
+
+    return size;
+}
+
+int RawHIDRing::peek(char *data, int size) const
+{
+    int tail = m_tail.load();
+
+    size = qMin(size, used());
+    if (size <= 0)
+        return 0;
+
+    int start = tail & (m_size - 1);
+    int first = qMin(size, m_size - start);
+    memcpy(data, &m_buffer[start], first);
+    memcpy(data + first, &m_buffer[0], size - first);
 
+    return size;
+}
+
+void RawHIDRing::consume(int size)
+{
+    if (size <= 0)
+        return;
+
+    m_tail.storeRelease((m_tail.load() + size) & (2 * m_size - 1));
+    m_spaceFreed.release();
+}
+
+bool RawHIDRing::waitForData(int timeout)
+{
+    // The semaphore counts every write, stale counts only cause another check
+    while (used() == 0) {
+        if (!m_dataAdded.tryAcquire(1, timeout))
+            return used() > 0;
+    }
+    return true;
+}
+
+bool RawHIDRing::waitForSpace(int timeout)
+{
+    while (used() == m_size) {
+        if (!m_spaceFreed.tryAcquire(1, timeout))
+            return used() < m_size;
+    }
+    return true;
+}
 
+void RawHIDRing::wakeAll()
+{
+    m_dataAdded.release();
+    m_spaceFreed.release();
+}
 
 // *********************************************************************************
 
@@ -67,17 +205,13 @@ public:
     /** return the bytes buffered */
     qint64 getBytesAvailable();
 
-    void stop() { m_running = false; }
+    void stop();
 
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-    a circular buffer but it's good enough and very simple */
-    QByteArray m_readBuffer;
-
-    /** A mutex to protect read buffer */
-    QMutex m_readBufMtx;
+    /** Reports read from the device, waiting for readData() */
+    RawHIDRing m_readRing;
 
     RawHID *m_hid;
 
@@ -109,15 +243,8 @@ public:
 protected:
     void run();
 
-    /** QByteArray might not be the most efficient way to implement
-    a circular buffer but it's good enough and very simple */
-    QByteArray m_writeBuffer;
-
-    /** A mutex to protect read buffer */
-    QMutex m_writeBufMtx;
-
-    /** Synchronize task with data arival */
-    QWaitCondition m_newDataToWrite;
+    /** Data from writeData(), waiting to be sent to the device */
+    RawHIDRing m_writeRing;
 
     RawHID *m_hid;
 
@@ -129,7 +256,8 @@ protected:
 // *********************************************************************************
 
 RawHIDReadThread::RawHIDReadThread(RawHID *hid)
-    : m_hid(hid),
+    : m_readRing(READ_RING_SIZE),
+      m_hid(hid),
       m_handle(hid->m_handle),
       m_running(true)
 {
@@ -147,8 +275,8 @@ void RawHIDReadThread::run()
 {
     while(m_running)
     {
-        //here we use a temporary buffer so we don't need to lock
-        //the mutex while we are reading from the device
+        //here we use a temporary buffer so the ring is only touched
+        //once a report has arrived
 
         // Want to read in regular chunks that match the packet size the device
         // is using.  In this case it is 64 bytes (the interrupt packet limit)
@@ -160,12 +288,34 @@ void RawHIDReadThread::run()
 
         if(ret > 0) //read some data
         {
-            QMutexLocker lock(&m_readBufMtx);
-            // Note: Preprocess the USB packets in this OS independent code
-            // First byte is report ID, second byte is the number of valid bytes
-            m_readBuffer.append((char *) &buffer[2], buffer[1]);
+            // During a burst the rest is collected without waiting, so the
+            // parser gets it in one go rather than a signal per report
+            for (int i = 0; i < READ_BATCH && ret > 0; i++) {
+                // Note: Preprocess the USB packets in this OS independent code
+                // First byte is report ID, second byte is the number of valid bytes
+                const char *data = (const char *) &buffer[2];
+                int size = qMin((int) buffer[1], READ_SIZE - 2);
+
+                // If the parser falls behind wait for it rather than drop
+                // data, the OS keeps queueing reports meanwhile
+                while (size > 0 && m_running) {
+                    int written = m_readRing.write(data, size);
+                    data += written;
+                    size -= written;
+                    if (size > 0) {
+                        emit m_hid->readyRead();
+                        m_readRing.waitForSpace(READ_TIMEOUT);
+                    }
+                }
+
+                if (i + 1 < READ_BATCH)
+                    ret = hid_read_timeout(m_hid->m_handle, buffer, READ_SIZE, 0);
+            }
 
             emit m_hid->readyRead();
+
+            if (ret < 0)
+                m_running = false;
         }
         else if(ret == 0) //nothing read
         {
@@ -178,28 +328,31 @@ void RawHIDReadThread::run()
     }
 }
 
-int RawHIDReadThread::getReadData(char *data, int size)
+//! Tell the thread to stop and make sure it does not wait for the reader
+void RawHIDReadThread::stop()
 {
-    QMutexLocker lock(&m_readBufMtx);
-
-    size = qMin(size, m_readBuffer.size());
+    m_running = false;
+    m_readRing.wakeAll();
+}
 
-    memcpy(data, m_readBuffer.constData(), size);
-    m_readBuffer.remove(0, size);
+int RawHIDReadThread::getReadData(char *data, int size)
+{
+    size = m_readRing.peek(data, size);
+    m_readRing.consume(size);
 
     return size;
 }
 
 qint64 RawHIDReadThread::getBytesAvailable()
 {
-    QMutexLocker lock(&m_readBufMtx);
-    return m_readBuffer.size();
+    return m_readRing.used();
 }
 
 // *********************************************************************************
 
 RawHIDWriteThread::RawHIDWriteThread(RawHID *hid)
-    : m_hid(hid),
+    : m_writeRing(WRITE_RING_SIZE),
+      m_hid(hid),
       m_handle(hid->m_handle),
       m_running(true)
 {
@@ -219,41 +372,29 @@ void RawHIDWriteThread::run()
     while(m_running)
     {
         unsigned char buffer[WRITE_SIZE] = {0};
-        int size;
 
-        {
-            QMutexLocker lock(&m_writeBufMtx);
-            size = qMin(WRITE_SIZE-2, m_writeBuffer.size());
-            while(size <= 0)
-            {
-                //wait on new data to write condition, the timeout
-                //enable the thread to shutdown properly
-                m_newDataToWrite.wait(&m_writeBufMtx, 200);
-                if(!m_running)
-                    return;
+        //wait for new data to write, stop() wakes the thread up to
+        //shut down
+        if (!m_writeRing.waitForData(WRITE_TIMEOUT))
+            continue;
+        if(!m_running)
+            return;
 
-                size = m_writeBuffer.size();
-            }
+        //NOTE: data size is limited to 2 bytes less than the
+        //usb packet size (64 bytes for interrupt) to make room
+        //for the reportID and valid data length
+        int size = m_writeRing.peek((char *) &buffer[2], WRITE_SIZE-2);
+        buffer[1] = size; //valid data length
+        buffer[0] = 2;    //reportID
 
-            //NOTE: data size is limited to 2 bytes less than the
-            //usb packet size (64 bytes for interrupt) to make room
-            //for the reportID and valid data length
-            size = qMin(WRITE_SIZE-2, m_writeBuffer.size());
-            memcpy(&buffer[2], m_writeBuffer.constData(), size);
-            buffer[1] = size; //valid data length
-            buffer[0] = 2;    //reportID
-        }
-
-        // must hold lock through the send to know how much was sent
         int ret = hid_write(m_hid->m_handle, buffer, WRITE_SIZE);
 
         if(ret > 0)
         {
-            //only remove the size actually written to the device            
-            QMutexLocker lock(&m_writeBufMtx);
-            m_writeBuffer.remove(0, size);
+            //only remove the data once it was written to the device
+            m_writeRing.consume(size);
 
-            emit m_hid->bytesWritten(ret - 2);
+            emit m_hid->bytesWritten(size);
         }
         else if(ret == -110) // timeout
         {
@@ -285,22 +426,26 @@ void RawHIDWriteThread::run()
 void RawHIDWriteThread::stop()
 {
     m_running = false;
-    m_newDataToWrite.wakeOne();
+    m_writeRing.wakeAll();
 }
 
 int RawHIDWriteThread::pushDataToWrite(const char *data, int size)
 {
-    QMutexLocker lock(&m_writeBufMtx);
-
-    m_writeBuffer.append(data, size);
-    m_newDataToWrite.wakeOne(); //signal that new data arrived
+    //the ring wakes the thread up, if it is full wait for the device
+    //to take some data rather than drop it
+    int written = 0;
+    while (written < size && m_running) {
+        written += m_writeRing.write(data + written, size - written);
+        if (written < size && !m_writeRing.waitForSpace(WRITE_TIMEOUT))
+            break;
+    }
 
-    return size;
+    return written;
 }
 
 qint64 RawHIDWriteThread::getBytesToWrite()
 {
-    return m_writeBuffer.size();
+    return m_writeRing.used();
 }
 
 // *********************************************************************************
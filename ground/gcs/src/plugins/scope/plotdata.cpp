@@ -41,7 +41,6 @@
  * @param p_uavFieldName The plotted UAVO field name
  */
 Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
-    yDataHistory(0),
     dataUpdated(false)
 {
     uavObjectName = p_uavObject;
@@ -61,13 +60,9 @@ Plot2dData::Plot2dData(QString p_uavObject, QString p_uavFieldName):
 
     xData = new QVector<double>();
     yData = new QVector<double>();
-    yDataHistory = new QVector<double>();
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     yMinimum = 0;
     yMaximum = 120;
 
@@ -106,9 +101,6 @@ Plot3dData::Plot3dData(QString p_uavObject, QString p_uavFieldName):
 
     scalePower = 0;
     meanSamples = 1;
-    meanSum = 0.0f;
-    correctionSum = 0.0f;
-    correctionCount = 0;
     xMinimum = 0;
     xMaximum = 16;
     yMinimum = 0;
@@ -124,8 +116,6 @@ Plot2dData::~Plot2dData()
         delete xData;
     if (yData != NULL)
         delete yData;
-    if (yDataHistory != NULL)
-        delete yDataHistory;
 }
 
 
@@ -145,23 +135,58 @@ Plot3dData::~Plot3dData()
 
 
 /**
- * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
- * @param obj UAVO
- * @param field UAVO field
- * @param haveSubField TRUE if UAVO has subfield. FALSE if not.
- * @param uavSubFieldName UAVO subfield, if it exists
- * @return
+ * @brief PlotData::resolveField Looks up the plotted field and element of the UAVO once,
+ * when the scope is configured
+ * @param obj UAVO instance the plot was configured with
+ * @return TRUE if the UAVO has the field. FALSE if not.
+ */
+bool PlotData::resolveField(UAVObject* obj)
+{
+    uavObject = obj;
+    uavObjectId = obj->getObjID();
+    uavField = obj->getField(uavFieldName);
+    fieldIndex = obj->getFields().indexOf(uavField);
+    elementIndex = 0;
+
+    if (uavField == NULL)
+        return false;
+
+    if (haveSubField) {
+        elementIndex = uavField->getElementNames().indexOf(uavSubFieldName);
+        if (elementIndex < 0) {
+            elementIndex = 0;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief PlotData::fieldOf Gets the plotted field of an instance of the plotted UAVO
+ * @param obj UAVO with new data
+ * @return The field, or NULL if obj is not the plotted UAVO
  */
-double PlotData::valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName)
+UAVObjectField* PlotData::fieldOf(UAVObject* obj)
 {
-    Q_UNUSED(obj);
-    QVariant value;
+    if (obj == uavObject)
+        return uavField;
+
+    // Other instances of the same UAVO share the field layout
+    if (uavField == NULL || obj->getObjID() != uavObjectId)
+        return NULL;
 
-    if(haveSubField){
-        int indexOfSubField = field->getElementNames().indexOf(QRegExp(uavSubFieldName, Qt::CaseSensitive, QRegExp::FixedString));
-        value = field->getValue(indexOfSubField);
-    }else
-        value = field->getValue();
+    return obj->getFields().value(fieldIndex, NULL);
+}
 
-    return value.toDouble();
+
+/**
+ * @brief valueAsDouble Fetch the value from the UAVO and return it as a double
+ * @param field UAVO field, as returned by fieldOf()
+ * @return
+ */
+double PlotData::valueAsDouble(UAVObjectField* field)
+{
+    return field->getDouble(elementIndex);
 }
@@ -46,7 +46,11 @@ class PlotData : public QObject
 {
     Q_OBJECT
 public:
-    double valueAsDouble(UAVObject* obj, UAVObjectField* field, bool haveSubField, QString uavSubFieldName);
+    PlotData() : uavObject(NULL), uavObjectId(0), uavField(NULL), fieldIndex(-1), elementIndex(0) {}
+
+    bool resolveField(UAVObject* obj);
+    UAVObjectField* fieldOf(UAVObject* obj);
+    double valueAsDouble(UAVObjectField* field);
 
     //Setter functions
     void setXMinimum(double val){xMinimum=val;}
@@ -56,7 +60,7 @@ public:
     void setXWindowSize(double val){m_xWindowSize=val;}
     void setScalePower(int val){scalePower = val;}
     void setMeanSamples(int val){meanSamples = val;}
-    void setMathFunction(QString val){mathFunction = val;}
+    virtual void setMathFunction(QString val){mathFunction = val;}
 
     //Getter functions
     double getXMinimum(){return xMinimum;}
@@ -69,6 +73,7 @@ public:
     QString getUavoFieldName(){return uavFieldName;}
     QString getUavoSubFieldName(){return uavSubFieldName;}
     bool getHaveSubFieldFlag(){return haveSubField;}
+    quint32 getUavoId(){return uavObjectId;}
 
     int getScalePower(){return scalePower;}
     int getMeanSamples(){return meanSamples;}
@@ -102,13 +107,16 @@ protected:
     QString uavSubFieldName;
     bool haveSubField;
 
+    // Resolved once by resolveField(), so that appending doesn't look up names
+    UAVObject* uavObject;
+    quint32 uavObjectId;
+    UAVObjectField* uavField;
+    int fieldIndex;
+    int elementIndex;
+
     int scalePower; //This is the power to which each value must be raised
     unsigned int meanSamples;
     QString mathFunction;
-    double meanSum;
-
-    double correctionSum;
-    int correctionCount;
 
 private:
 
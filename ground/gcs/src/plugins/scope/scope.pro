@@ -1,5 +1,5 @@
 TEMPLATE = lib
-QT+=widgets
+QT+=widgets opengl
 TARGET = ScopeGadget
 DEFINES += SCOPE_LIBRARY
 DEFINES += QWT_DLL
@@ -10,6 +10,13 @@ HEADERS += scopeplugin.h \
     scopes2d/histogramplotdata.h \
     scopes2d/histogramscopeconfig.h \
     scopes2d/scatterplotdata.h \
+    scopes2d/plotseriesbuffer.h \
+    scopes2d/windowstatistics.h \
+    scopes2d/spectrumestimator.h \
+    scopes2d/spectrumplotdata.h \
+    scopes2d/spectrumscopeconfig.h \
+    scopes2d/seriespyramid.h \
+    scopes2d/logseriesloader.h \
     scopes2d/scatterplotscopeconfig.h \
     scopes3d/spectrogramplotdata.h \
     scopes3d/spectrogramscopeconfig.h \
@@ -24,11 +31,19 @@ HEADERS += scopegadgetoptionspage.h
 HEADERS += scopegadgetconfiguration.h
 HEADERS += scopegadget.h
 HEADERS += scopegadgetwidget.h
+HEADERS += scopereplotscheduler.h
 HEADERS += scopegadgetfactory.h
 SOURCES += scopeplugin.cpp \
     scopes2d/histogramplotdata.cpp \
     scopes2d/histogramscopeconfig.cpp \
     scopes2d/scatterplotdata.cpp \
+    scopes2d/plotseriesbuffer.cpp \
+    scopes2d/windowstatistics.cpp \
+    scopes2d/spectrumestimator.cpp \
+    scopes2d/spectrumplotdata.cpp \
+    scopes2d/spectrumscopeconfig.cpp \
+    scopes2d/seriespyramid.cpp \
+    scopes2d/logseriesloader.cpp \
     scopes2d/scatterplotscopeconfig.cpp \
     scopes3d/spectrogramplotdata.cpp \
     scopes3d/spectrogramscopeconfig.cpp \
@@ -38,6 +53,7 @@ SOURCES += scopegadgetconfiguration.cpp
 SOURCES += scopegadget.cpp
 SOURCES += scopegadgetfactory.cpp
 SOURCES += scopegadgetwidget.cpp
+SOURCES += scopereplotscheduler.cpp
 OTHER_FILES += ScopeGadget.pluginspec \
     ScopeGadget.json
 FORMS += scopegadgetoptionspage.ui
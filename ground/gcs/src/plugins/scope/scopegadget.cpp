@@ -54,6 +54,7 @@ void ScopeGadget::loadConfiguration(IUAVGadgetConfiguration* config)
 
     scopeGadgetWidget->clearPlotWidget();
     scopeGadgetWidget->setScopeName(config->name());
+    scopeGadgetWidget->setOpenGLCanvas(sgConfig->getScope()->getOpenGL());
 
     sgConfig->getScope()->loadConfiguration(scopeGadgetWidget);
 }
@@ -28,6 +28,7 @@
 
 #include "scopes2d/scatterplotscopeconfig.h"
 #include "scopes2d/histogramscopeconfig.h"
+#include "scopes2d/spectrumscopeconfig.h"
 #include "scopes3d/spectrogramscopeconfig.h"
 #include "scopegadgetconfiguration.h"
 
@@ -64,6 +65,10 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings* q
                 m_scope = new HistogramScopeConfig(qSettings);
                 break;
                 }
+            case Scopes2dConfig::SPECTRUM: {
+                m_scope = new SpectrumScopeConfig(qSettings);
+                break;
+                }
             case Scopes2dConfig::SCATTERPLOT2D:
             default: {
                 m_scope = new Scatterplot2dScopeConfig(qSettings);
@@ -96,6 +101,7 @@ ScopeGadgetConfiguration::ScopeGadgetConfiguration(QString classId, QSettings* q
             }
         }
         m_scope->setRefreshInterval(refreshInterval);
+        m_scope->setOpenGL(qSettings->value("openGL", false).toBool());
     }
     else{
         // Default config is just a simple 2D scatterplot
@@ -121,6 +127,10 @@ void ScopeGadgetConfiguration::applyGuiConfiguration(Ui::ScopeGadgetOptionsPage
             m_scope = new HistogramScopeConfig(options_page);
             break;
             }
+        case Scopes2dConfig::SPECTRUM: {
+            m_scope = new SpectrumScopeConfig(options_page);
+            break;
+            }
         case Scopes2dConfig::SCATTERPLOT2D:
         default: {
             m_scope = new Scatterplot2dScopeConfig(options_page);
@@ -142,6 +152,7 @@ void ScopeGadgetConfiguration::applyGuiConfiguration(Ui::ScopeGadgetOptionsPage
     }
 
     m_scope->setRefreshInterval(refreshInterval);
+    m_scope->setOpenGL(options_page->chkOpenGL->isChecked());
 }
 
 
@@ -161,6 +172,7 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
 {
     ScopeGadgetConfiguration *m = new ScopeGadgetConfiguration(this->classId());
     m->m_scope=this->getScope()->cloneScope(m_scope);
+    m->m_scope->setOpenGL(m_scope->getOpenGL());
 
     return m;
 }
@@ -173,6 +185,7 @@ IUAVGadgetConfiguration *ScopeGadgetConfiguration::clone()
 void ScopeGadgetConfiguration::saveConfig(QSettings* qSettings) const {
     qSettings->setValue("plotDimensions", m_scope->getScopeDimensions());
     qSettings->setValue("refreshInterval", m_scope->getRefreshInterval());
+    qSettings->setValue("openGL", m_scope->getOpenGL());
 
     m_scope->saveConfiguration(qSettings);
 }
@@ -37,6 +37,7 @@
 
 #include "scopes2d/histogramscopeconfig.h"
 #include "scopes2d/scatterplotscopeconfig.h"
+#include "scopes2d/spectrumscopeconfig.h"
 #include "scopes3d/spectrogramscopeconfig.h"
 
 #include <qpalette.h>
@@ -71,11 +72,21 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
     // Set up 2D plots tab
     options_page->cmb2dPlotType->addItem("Scatter plot", Scopes2dConfig::SCATTERPLOT2D);
     options_page->cmb2dPlotType->addItem("Histogram", Scopes2dConfig::HISTOGRAM);
+    options_page->cmb2dPlotType->addItem("Spectrum", Scopes2dConfig::SPECTRUM);
 
     // Set up x-axis combo box
     options_page->cmbXAxisScatterplot2d->addItem("Series", Scatterplot2dScopeConfig::SERIES2D);
     options_page->cmbXAxisScatterplot2d->addItem("Time series", Scatterplot2dScopeConfig::TIMESERIES2D);
 
+    // Set up spectrum combo boxes
+    for (int fftSize = 64; fftSize <= 4096; fftSize *= 2)
+        options_page->cmbSpectrumFftSize->addItem(QString::number(fftSize) + " samples", fftSize);
+    options_page->cmbSpectrumFftSize->setCurrentIndex(options_page->cmbSpectrumFftSize->findData(256));
+    options_page->cmbSpectrumScale->addItem("Amplitude", SpectrumEstimator::AMPLITUDE);
+    options_page->cmbSpectrumScale->addItem("PSD", SpectrumEstimator::PSD);
+    options_page->cmbSpectrumScale->addItem("PSD (dB)", SpectrumEstimator::PSD_DB);
+    options_page->cmbSpectrumScale->setCurrentIndex(options_page->cmbSpectrumScale->findData(SpectrumEstimator::PSD_DB));
+
 
     // Set up 3D plots tab
     options_page->cmb3dPlotType->addItem("Spectrogram", Scopes3dConfig::SPECTROGRAM);
@@ -122,7 +133,8 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
     }
 
     QStringList mathFunctions;
-    mathFunctions << "None" << "Boxcar average" << "Standard deviation";
+    mathFunctions << "None" << "Boxcar average" << "Standard deviation"
+                  << "Median" << "5th percentile" << "95th percentile";
 
     options_page->mathFunctionComboBox->addItems(mathFunctions);
     options_page->cmbMathFunctionSpectrogram->addItems(mathFunctions);
@@ -176,8 +188,10 @@ QWidget* ScopeGadgetOptionsPage::createPage(QWidget *parent)
     connect(options_page->lst2dCurves, SIGNAL(itemClicked(QListWidgetItem *)), this, SLOT(on_lst2dItem_clicked(QListWidgetItem *)));
 
     // Configuration the GUI elements to reflect the scope settings
-    if(m_config)
+    if(m_config) {
         m_config->getScope()->setGuiConfiguration(options_page);
+        options_page->chkOpenGL->setChecked(m_config->getScope()->getOpenGL());
+    }
 
     // Cascading update on the UI elements
     emit on_cmb2dPlotType_currentIndexChanged(options_page->cmb2dPlotType->currentText());
@@ -639,6 +653,9 @@ void ScopeGadgetOptionsPage::on_cmb2dPlotType_currentIndexChanged(QString curren
         options_page->spnMaxNumBins->setSuffix(" bins");
         options_page->sw2dXAxis->setCurrentWidget(options_page->sw2dHistogramStack);
     }
+    else if (currentText == "Spectrum"){
+        options_page->sw2dXAxis->setCurrentWidget(options_page->sw2dSpectrumStack);
+    }
 }
 
 
@@ -32,6 +32,9 @@
 
 #include "scopegadgetwidget.h"
 #include "scopegadgetconfiguration.h"
+#include "scopereplotscheduler.h"
+#include "scopes2d/logseriesloader.h"
+#include "scopes2d/scatterplotdata.h"
 
 #include "utils/stylehelper.h"
 #include "uavtalk/telemetrymanager.h"
@@ -43,6 +46,10 @@
 
 #include "qwt/src/qwt_legend.h"
 #include "qwt/src/qwt_legend_label.h"
+#include "qwt/src/qwt_plot_canvas.h"
+#include "qwt/src/qwt_plot_curve.h"
+#include "qwt/src/qwt_plot_glcanvas.h"
+#include "qwt/src/qwt_plot_panner.h"
 #include "qwt/src/qwt_scale_widget.h"
 
 #include <iostream>
@@ -59,23 +66,23 @@
 #include <QAction>
 #include <QClipboard>
 #include <QApplication>
-
-QTimer *ScopeGadgetWidget::replotTimer=0;
+#include <QFileDialog>
+#include <QMessageBox>
 
 ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
     m_refreshInterval(50), // Arbitrary 50ms refresh timer
     m_scope(0),
-    m_xWindowSize(60) // This is an arbitrary 1 minute window
+    m_xWindowSize(60), // This is an arbitrary 1 minute window
+    m_replotPending(false),
+    m_logLoader(0)
 {
     m_grid = new QwtPlotGrid;
 
     setMouseTracking(true);
 //	canvas()->setMouseTracking(true);
 
-    //Set up the timer that replots data. Only set up one timer for entire class.
-    if (replotTimer == NULL)
-        replotTimer = new QTimer();
-    connect(replotTimer, SIGNAL(timeout()), this, SLOT(replotNewData()));
+    // The scheduler decides when the scope replots, alongside the other scopes
+    ScopeReplotScheduler::instance()->addScope(this);
 
     // Listen to telemetry connection/disconnection events, no point in
     // running the scopes if we are not connected and not replaying logs.
@@ -93,6 +100,12 @@ ScopeGadgetWidget::ScopeGadgetWidget(QWidget *parent) : QwtPlot(parent),
  */
 ScopeGadgetWidget::~ScopeGadgetWidget()
 {
+    ScopeReplotScheduler::instance()->removeScope(this);
+
+    // Waits for a log that is still loading
+    delete m_logLoader;
+    qDeleteAll(m_loadingCurves);
+
     // Get the object to de-monitor
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
@@ -123,6 +136,21 @@ void ScopeGadgetWidget::popUpMenu(const QPoint &mousePosition)
     connect(action, SIGNAL(triggered(bool)), this, SLOT(copyToClipboardAsImage()));
     menu.addSeparator();
 
+    // Add log items to menu, only time series can show a log
+    bool haveTimeSeries = false;
+    foreach(PlotData* plotData, m_dataSources.values()) {
+        if (dynamic_cast<TimeSeriesPlotData*>(plotData))
+            haveTimeSeries = true;
+    }
+    action = menu.addAction(tr("Load Log..."));
+    action->setEnabled((haveTimeSeries || inLogMode()) && m_logLoader == NULL);
+    connect(action, SIGNAL(triggered(bool)), this, SLOT(loadLog()));
+    if (inLogMode()) {
+        action = menu.addAction(tr("Show Live Data"));
+        connect(action, SIGNAL(triggered(bool)), this, SLOT(showLiveData()));
+    }
+    menu.addSeparator();
+
     // Add options dialog to clipboard
     action = menu.addAction(tr("Options..."));
     connect(action, SIGNAL(triggered(bool)), this, SLOT(showOptionDialog()));
@@ -171,6 +199,135 @@ void ScopeGadgetWidget::showOptionDialog()
 }
 
 
+/**
+ * @brief ScopeGadgetWidget::loadLog Reads the fields of the time series plots out of a log, in the background
+ */
+void ScopeGadgetWidget::loadLog()
+{
+    if (m_logLoader != NULL)
+        return;
+
+    QString fileName = QFileDialog::getOpenFileName(this, tr("Open file"), QString(""), tr("Tau Labs Log (*.tll)"));
+    if (fileName.isEmpty())
+        return;
+
+    // The log curves look like the plots they stand in for
+    QList<LogSeriesRequest> requests;
+    if (inLogMode()) {
+        requests = m_logRequests;
+        foreach (QwtPlotCurve *logCurve, m_logCurves) {
+            QwtPlotCurve *curve = new QwtPlotCurve(logCurve->title());
+            curve->setPen(logCurve->pen());
+            m_loadingCurves.append(curve);
+        }
+    } else {
+        foreach (PlotData* plotData, m_dataSources.values()) {
+            TimeSeriesPlotData *timeSeries = dynamic_cast<TimeSeriesPlotData*>(plotData);
+            if (timeSeries == NULL)
+                continue;
+
+            LogSeriesRequest request;
+            request.uavObjectName = timeSeries->getUavoName();
+            request.uavFieldName = timeSeries->getUavoFieldName();
+            if (timeSeries->getHaveSubFieldFlag())
+                request.uavSubFieldName = timeSeries->getUavoSubFieldName();
+            request.scalePower = timeSeries->getScalePower();
+            request.mathFunction = timeSeries->getMathFunction();
+            request.meanSamples = timeSeries->getMeanSamples();
+            requests.append(request);
+
+            QwtPlotCurve *curve = new QwtPlotCurve(timeSeries->getCurve()->title());
+            curve->setPen(timeSeries->getCurve()->pen());
+            m_loadingCurves.append(curve);
+        }
+    }
+    m_logRequests = requests;
+
+    m_logLoader = new LogSeriesLoader(fileName, requests);
+    connect(m_logLoader, SIGNAL(finished()), this, SLOT(logLoaded()));
+    setCursor(Qt::BusyCursor);
+    m_logLoader->start(QThread::LowPriority);
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::logLoaded Replaces the live plots with the curves of the log
+ */
+void ScopeGadgetWidget::logLoaded()
+{
+    LogSeriesLoader *loader = m_logLoader;
+    m_logLoader = NULL;
+    unsetCursor();
+
+    if (loader == NULL)
+        return;
+
+    if (!loader->succeeded()) {
+        qDeleteAll(m_loadingCurves);
+        m_loadingCurves.clear();
+        QMessageBox::warning(this, tr("Load Log"), tr("Unable to read %1").arg(loader->fileName()));
+        loader->deleteLater();
+        return;
+    }
+
+    clearPlotWidget();
+    m_grid->attach(this);
+
+    // Qwt passes the visible range to the curves so they pick their level
+    int maxPoints = 2 * qMax(canvas()->width(), 1);
+    for (int i = 0; i < m_loadingCurves.size(); i++) {
+        SeriesPyramid *series = loader->takeSeries(i);
+        if (series == NULL)
+            series = new SeriesPyramid(QVector<QPointF>());
+        series->setMaxPoints(maxPoints);
+
+        QwtPlotCurve *curve = m_loadingCurves.at(i);
+        curve->setItemInterest(QwtPlotItem::ScaleInterest, true);
+        curve->setData(series);
+        curve->attach(this);
+        m_logCurves.append(curve);
+    }
+    m_loadingCurves.clear();
+    loader->deleteLater();
+
+    // Seconds since the log started, dragging pans along it
+    setAxisScaleDraw(QwtPlot::xBottom, new QwtScaleDraw());
+    setAxisAutoScale(QwtPlot::xBottom, true);
+    setAxisAutoScale(QwtPlot::yLeft, true);
+    m_logPanner = new QwtPlotPanner(canvas());
+    m_logPanner->setOrientations(Qt::Horizontal);
+
+    replot();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::showLiveData Goes back from a log to the configured plots
+ */
+void ScopeGadgetWidget::showLiveData()
+{
+    if (m_scope == NULL)
+        return;
+
+    clearPlotWidget();
+    m_scope->loadConfiguration(this);
+    replot();
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::deleteLogCurves Removes the curves of a log
+ */
+void ScopeGadgetWidget::deleteLogCurves()
+{
+    // The curves delete their series
+    qDeleteAll(m_logCurves);
+    m_logCurves.clear();
+
+    delete m_logPanner;
+}
+
+
 /**
  * @brief ScopeGadgetWidget::mousePressEvent Pass mouse press event to QwtPlot
  * @param e
@@ -210,6 +367,12 @@ void ScopeGadgetWidget::mouseDoubleClickEvent(QMouseEvent *e)
     //On double-click, reset plot zoom
     setAxisAutoScale(QwtPlot::yLeft, true);
 
+    //A log is not replotted by the scheduler, show all of it right away
+    if (inLogMode()) {
+        setAxisAutoScale(QwtPlot::xBottom, true);
+        replot();
+    }
+
     update();
 
     QwtPlot::mouseDoubleClickEvent(e);
@@ -232,6 +395,22 @@ void ScopeGadgetWidget::mouseMoveEvent(QMouseEvent *e)
  */
 void ScopeGadgetWidget::wheelEvent(QWheelEvent *e)
 {
+    //On a log, zoom in time about the mouse instead. The curves pick the overview level that fits.
+    if (inLogMode()) {
+        QwtInterval xInterval=axisInterval(QwtPlot::xBottom);
+        if (xInterval.minValue() != xInterval.maxValue()) {
+            double zoomLine=invTransform(QwtPlot::xBottom, canvas()->mapFrom(this, e->pos()).x());
+            double zoomScale=e->delta()<0 ? 1.25 : 1/1.25;
+
+            setAxisScale(QwtPlot::xBottom,
+                         (xInterval.minValue()-zoomLine)*zoomScale+zoomLine,
+                         (xInterval.maxValue()-zoomLine)*zoomScale+zoomLine );
+            replot();
+        }
+        QwtPlot::wheelEvent(e);
+        return;
+    }
+
     //Change zoom on scroll wheel event
     QwtInterval yInterval=axisInterval(QwtPlot::yLeft);
     if (yInterval.minValue() != yInterval.maxValue()) //Make sure that the two values are never the same. Sometimes axisInterval returns (0,0)
@@ -268,11 +447,7 @@ void ScopeGadgetWidget::wheelEvent(QWheelEvent *e)
  */
 void ScopeGadgetWidget::startPlotting()
 {
-    if (!replotTimer)
-        return;
-
-    if (!replotTimer->isActive())
-        replotTimer->start(m_refreshInterval);
+    ScopeReplotScheduler::instance()->setRunning(this, true);
 }
 
 
@@ -281,10 +456,7 @@ void ScopeGadgetWidget::startPlotting()
  */
 void ScopeGadgetWidget::stopPlotting()
 {
-    if (!replotTimer)
-        return;
-
-    replotTimer->stop();
+    ScopeReplotScheduler::instance()->setRunning(this, false);
 }
 
 
@@ -364,10 +536,13 @@ void ScopeGadgetWidget::showCurve(const QVariant & itemInfo, bool on, int index)
  */
 void ScopeGadgetWidget::uavObjectReceived(UAVObject* obj)
 {
-    foreach(PlotData* plotdData, m_dataSources.values()) {
+    // Only the plots of this UAVO need to look at it
+    foreach(PlotData* plotdData, m_objectDataSources.value(obj->getObjID())) {
         bool ret = plotdData->append(obj);
-        if (ret)
+        if (ret) {
             plotdData->setUpdatedFlagToTrue();
+            m_replotPending = true;
+        }
     }
 }
 
@@ -383,6 +558,7 @@ void ScopeGadgetWidget::replotNewData()
         return;
 
     QMutexLocker locker(&mutex);
+    m_replotPending = false;
 
     // Update the data in the scopes
     foreach(PlotData* plotData, m_dataSources.values())
@@ -411,7 +587,10 @@ void ScopeGadgetWidget::clearPlotWidget()
 
         // Clear the data
         m_dataSources.clear();
+        m_objectDataSources.clear();
     }
+
+    deleteLogCurves();
 }
 
 
@@ -457,6 +636,39 @@ void ScopeGadgetWidget::showEvent(QShowEvent *event)
 }
 
 
+/**
+ * @brief ScopeGadgetWidget::setOpenGLCanvas Chooses between painting the plot with OpenGL or on the CPU
+ * @param enable TRUE for an OpenGL canvas, FALSE for the regular raster canvas
+ */
+void ScopeGadgetWidget::setOpenGLCanvas(bool enable)
+{
+    bool isOpenGL = qobject_cast<QwtPlotGLCanvas*>(canvas()) != NULL;
+    if (enable == isOpenGL)
+        return;
+
+    // QwtPlot deletes the old canvas
+    if (enable) {
+        QwtPlotGLCanvas *glCanvas = new QwtPlotGLCanvas(this);
+        glCanvas->setFrameStyle(QFrame::NoFrame);
+        setCanvas(glCanvas);
+    } else {
+        setCanvas(new QwtPlotCanvas(this));
+    }
+}
+
+
+/**
+ * @brief ScopeGadgetWidget::insertDataSources Keeps the plot for replotting and routes the updates of its UAVO to it
+ * @param stringVal Plot name
+ * @param dataVal Plot data, with its field already resolved
+ */
+void ScopeGadgetWidget::insertDataSources(QString stringVal, PlotData* dataVal)
+{
+    m_dataSources.insert(stringVal, dataVal);
+    m_objectDataSources[dataVal->getUavoId()].append(dataVal);
+}
+
+
 /**
  * @brief ScopeGadgetWidget::connectUAVO Connects UAVO update signal, but only if it hasn't yet been connected
  * @param obj
@@ -477,15 +689,10 @@ void ScopeGadgetWidget::connectUAVO(UAVDataObject* obj){
  */
 void ScopeGadgetWidget::startTimer(int refreshInterval){
     m_refreshInterval = refreshInterval;
+    ScopeReplotScheduler::instance()->setRefreshInterval(this, refreshInterval);
 
-    // Only start the timer if we are already connected
+    // Only start plotting if we are already connected
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
-    if (cm->getCurrentConnection() && replotTimer)
-    {
-        if (!replotTimer->isActive())
-            replotTimer->start(refreshInterval);
-        else
-            replotTimer->setInterval(refreshInterval);
-
-    }
+    if (cm->getCurrentConnection())
+        startPlotting();
 }
@@ -35,6 +35,8 @@
 
 class ScopeConfig;
 class UAVDataObject;
+class QwtPlotCurve;
+class QwtPlotPanner;
 
 #include "qwt/src/qwt.h"
 #include "qwt/src/qwt_legend.h"
@@ -45,11 +47,14 @@ class UAVDataObject;
 
 #include "uavobject.h"
 #include "plotdata.h"
+#include "scopes2d/logseriesloader.h"
 
 #include <QTimer>
 #include <QTime>
 #include <QVector>
+#include <QHash>
 #include <QMutex>
+#include <QPointer>
 
 /*!
   \brief This class is used to render the time values on the horizontal axis for the
@@ -85,8 +90,9 @@ public:
 
     void setScope(ScopeConfig *val){m_scope = val;}
     QMap<QString, PlotData*> getDataSources(){return m_dataSources;}
-    void insertDataSources(QString stringVal, PlotData* dataVal){m_dataSources.insert(stringVal, dataVal);}
+    void insertDataSources(QString stringVal, PlotData* dataVal);
 
+    void setOpenGLCanvas(bool enable);
     void addLegend();
     void deleteLegend();
     void clearPlotWidget();
@@ -95,6 +101,9 @@ public:
     QwtLegend *m_legend;
     void setScopeName(QString val) {scopeName = val;}
 
+    //! Visible, and new data came in since the last replot
+    bool needsReplot() {return m_replotPending && isVisible() && m_scope != NULL && !inLogMode();}
+
 protected:
     void mousePressEvent(QMouseEvent *e);
     void mouseReleaseEvent(QMouseEvent *e);
@@ -113,16 +122,32 @@ private slots:
     void clearPlot();
     void copyToClipboardAsImage();
     void showOptionDialog();
+    void loadLog();
+    void logLoaded();
+    void showLiveData();
 
 private:
+    friend class ScopeReplotScheduler;
+
+    //! Showing the curves of a log instead of the live data
+    bool inLogMode() {return !m_logCurves.isEmpty();}
+    void deleteLogCurves();
+
     QMutex mutex;
     int m_refreshInterval;
     ScopeConfig *m_scope;
     QMap<QString, PlotData*> m_dataSources;
+    QHash<quint32, QList<PlotData*> > m_objectDataSources; //!< The same plots, by the ID of the UAVO they show
     double m_xWindowSize;
-    static QTimer *replotTimer;
     QList<QString> m_connectedUAVObjects;
     QString scopeName;
+    bool m_replotPending;
+
+    LogSeriesLoader *m_logLoader;
+    QList<LogSeriesRequest> m_logRequests;  //!< What the log curves show, to load another log
+    QList<QwtPlotCurve*> m_loadingCurves;  //!< The log curves, until the loader is done
+    QList<QwtPlotCurve*> m_logCurves;
+    QPointer<QwtPlotPanner> m_logPanner;   //!< Owned by the canvas
 };
 
 
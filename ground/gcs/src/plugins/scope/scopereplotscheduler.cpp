@@ -0,0 +1,175 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopereplotscheduler.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Shares the GUI thread's replot time between the scope gadgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopereplotscheduler.h"
+#include "scopegadgetwidget.h"
+
+// Time between two frames, about 60 frames per second
+#define FRAME_INTERVAL_MS 16
+
+// Once a frame has spent this long replotting, the remaining scopes wait for the next one
+#define FRAME_BUDGET_MS 8
+
+// No scope spends more than this share of its time painting
+#define MAX_PAINT_SHARE 0.25
+
+// Weight of the latest replot in the average paint time
+#define PAINT_TIME_FILTER 0.2
+
+
+ScopeReplotScheduler::ScopeReplotScheduler() :
+    m_nextScope(0)
+{
+    m_clock.start();
+
+    m_frameTimer.setInterval(FRAME_INTERVAL_MS);
+    connect(&m_frameTimer, SIGNAL(timeout()), this, SLOT(frame()));
+}
+
+
+/**
+ * @brief ScopeReplotScheduler::instance The scheduler shared by all the scope gadgets
+ */
+ScopeReplotScheduler *ScopeReplotScheduler::instance()
+{
+    static ScopeReplotScheduler *scheduler = NULL;
+
+    if (scheduler == NULL)
+        scheduler = new ScopeReplotScheduler();
+
+    return scheduler;
+}
+
+
+void ScopeReplotScheduler::addScope(ScopeGadgetWidget *scope)
+{
+    if (find(scope))
+        return;
+
+    ScheduledScope scheduled;
+    scheduled.scope = scope;
+    scheduled.refreshInterval = 50;
+    scheduled.running = false;
+    scheduled.nextReplot = 0;
+    scheduled.paintTime = 0;
+    m_scopes.append(scheduled);
+}
+
+
+void ScopeReplotScheduler::removeScope(ScopeGadgetWidget *scope)
+{
+    for (int i = 0; i < m_scopes.size(); i++) {
+        if (m_scopes.at(i).scope == scope) {
+            m_scopes.removeAt(i);
+            break;
+        }
+    }
+
+    if (m_nextScope >= m_scopes.size())
+        m_nextScope = 0;
+
+    updateTimer();
+}
+
+
+void ScopeReplotScheduler::setRefreshInterval(ScopeGadgetWidget *scope, int refreshInterval)
+{
+    ScheduledScope *scheduled = find(scope);
+    if (scheduled)
+        scheduled->refreshInterval = qMax(refreshInterval, 0);
+}
+
+
+void ScopeReplotScheduler::setRunning(ScopeGadgetWidget *scope, bool running)
+{
+    ScheduledScope *scheduled = find(scope);
+    if (scheduled == NULL)
+        return;
+
+    scheduled->running = running;
+    updateTimer();
+}
+
+
+/**
+ * @brief ScopeReplotScheduler::frame Replots the scopes that are due, until the frame budget is spent
+ */
+void ScopeReplotScheduler::frame()
+{
+    qint64 frameStart = m_clock.elapsed();
+    int count = m_scopes.size();
+
+    for (int i = 0; i < count; i++) {
+        if (m_clock.elapsed() - frameStart >= FRAME_BUDGET_MS)
+            break;
+
+        int index = (m_nextScope + i) % count;
+        ScheduledScope &scheduled = m_scopes[index];
+
+        qint64 now = m_clock.elapsed();
+        if (!scheduled.running || now < scheduled.nextReplot || !scheduled.scope->needsReplot())
+            continue;
+
+        QElapsedTimer paintTimer;
+        paintTimer.start();
+        scheduled.scope->replotNewData();
+        double paintTime = paintTimer.nsecsElapsed() / 1e6;
+
+        // Slow scopes back off, so that they can't starve the rest of the GUI
+        scheduled.paintTime += PAINT_TIME_FILTER * (paintTime - scheduled.paintTime);
+        scheduled.nextReplot = now + qMax((double) scheduled.refreshInterval, scheduled.paintTime / MAX_PAINT_SHARE);
+
+        m_nextScope = (index + 1) % count;
+    }
+}
+
+
+ScopeReplotScheduler::ScheduledScope *ScopeReplotScheduler::find(ScopeGadgetWidget *scope)
+{
+    for (int i = 0; i < m_scopes.size(); i++) {
+        if (m_scopes.at(i).scope == scope)
+            return &m_scopes[i];
+    }
+
+    return NULL;
+}
+
+
+/**
+ * @brief ScopeReplotScheduler::updateTimer Only wakes up for frames while some scope is running
+ */
+void ScopeReplotScheduler::updateTimer()
+{
+    bool anyRunning = false;
+    foreach (const ScheduledScope &scheduled, m_scopes)
+        anyRunning |= scheduled.running;
+
+    if (anyRunning && !m_frameTimer.isActive())
+        m_frameTimer.start();
+    else if (!anyRunning && m_frameTimer.isActive())
+        m_frameTimer.stop();
+}
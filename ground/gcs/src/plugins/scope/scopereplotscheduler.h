@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ *
+ * @file       scopereplotscheduler.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Shares the GUI thread's replot time between the scope gadgets
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SCOPEREPLOTSCHEDULER_H
+#define SCOPEREPLOTSCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+class ScopeGadgetWidget;
+
+
+/**
+ * @brief The ScopeReplotScheduler class Decides which scope gadget replots on
+ * each frame.
+ *
+ * A scope is only replotted when it is visible, has received data since its
+ * last replot and its refresh interval has gone by. Scopes that take long
+ * to paint get a longer interval, so that no scope spends more than a fixed
+ * share of the GUI thread painting. Each frame replots scopes in turn until
+ * its time budget is spent, and the next frame carries on with the scope
+ * after the last one replotted.
+ */
+class ScopeReplotScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    static ScopeReplotScheduler *instance();
+
+    void addScope(ScopeGadgetWidget *scope);
+    void removeScope(ScopeGadgetWidget *scope);
+
+    //! Sets the shortest time between two replots of a scope, in ms
+    void setRefreshInterval(ScopeGadgetWidget *scope, int refreshInterval);
+
+    //! Scopes are only replotted while they are running
+    void setRunning(ScopeGadgetWidget *scope, bool running);
+
+private slots:
+    void frame();
+
+private:
+    struct ScheduledScope {
+        ScopeGadgetWidget *scope;
+        int refreshInterval;    //!< Requested time between replots, in ms
+        bool running;
+        qint64 nextReplot;      //!< Earliest time of the next replot, in ms on the clock
+        double paintTime;       //!< Average time a replot takes, in ms
+    };
+
+    ScopeReplotScheduler();
+
+    ScheduledScope *find(ScopeGadgetWidget *scope);
+    void updateTimer();
+
+    QTimer m_frameTimer;
+    QElapsedTimer m_clock;
+    QList<ScheduledScope> m_scopes;
+    int m_nextScope;    //!< Where the next frame starts looking for a scope to replot
+};
+
+#endif // SCOPEREPLOTSCHEDULER_H
@@ -255,6 +255,10 @@ void HistogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWidge
             return;
         }
 
+        // Resolve the field now, so that new data doesn't have to be looked up by name
+        if (!histogramData->resolveField(obj))
+            qDebug() << "Field " << histogramData->getUavoFieldName() << " is missing from " << histogramData->getUavoName();
+
         //Get the units
         QString units = getUavObjectFieldUnits(histogramData->getUavoName(), histogramData->getUavoFieldName());
 
@@ -0,0 +1,252 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logseriesloader.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Reads the plotted fields out of a GCS log, off the GUI thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/logseriesloader.h"
+#include "scopes2d/windowstatistics.h"
+
+#include "extensionsystem/pluginmanager.h"
+#include "uavobjectmanager.h"
+#include "uavdataobject.h"
+#include "uavtalk/uavtalk.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QDebug>
+#include <math.h>
+
+//! Size of the header in front of every packet: timestamp and data size
+#define LOG_PACKET_HEADER_SIZE (sizeof(quint32) + sizeof(qint64))
+
+
+/**
+ * @brief LogSeriesLoader::LogSeriesLoader
+ * @param fileName The .tll log to read
+ * @param requests The curves to read from it
+ */
+LogSeriesLoader::LogSeriesLoader(const QString &fileName, const QList<LogSeriesRequest> &requests, QObject *parent) :
+    QThread(parent),
+    m_fileName(fileName),
+    m_requests(requests),
+    m_currentTime(0),
+    m_running(true),
+    m_succeeded(false)
+{
+    // The object types are looked up here, in the GUI thread. All of them are
+    // unpacked into so that UAVTalk stays in sync over objects nobody plots.
+    ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+    UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+
+    foreach (QVector<UAVDataObject*> list, objManager->getDataObjectsVector()) {
+        if (!list.isEmpty())
+            m_types.append(list.first());
+    }
+}
+
+
+LogSeriesLoader::~LogSeriesLoader()
+{
+    stop();
+    wait();
+
+    qDeleteAll(m_series);
+}
+
+
+SeriesPyramid *LogSeriesLoader::takeSeries(int i)
+{
+    if (i < 0 || i >= m_series.size())
+        return NULL;
+
+    SeriesPyramid *series = m_series.at(i);
+    m_series[i] = NULL;
+    return series;
+}
+
+
+void LogSeriesLoader::run()
+{
+    // The objects the log is unpacked into belong to this thread
+    UAVObjectManager objManager;
+    connect(&objManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newInstance(UAVObject*)), Qt::DirectConnection);
+
+    foreach (UAVDataObject *type, m_types)
+        objManager.registerObject(type->dirtyClone());
+
+    for (int i = 0; i < m_requests.size(); i++) {
+        UAVObject *obj = objManager.getObject(m_requests.at(i).uavObjectName);
+        if (obj == NULL) {
+            qDebug() << "In scope gadget, UAVObject" << m_requests.at(i).uavObjectName << "is missing";
+            continue;
+        }
+
+        if (!addTarget(i, obj)) {
+            qDebug() << "In scope gadget, field" << m_requests.at(i).uavFieldName << "of UAVObject" << m_requests.at(i).uavObjectName << "is missing";
+            continue;
+        }
+
+        // Only the plotted objects need to tell when they are unpacked
+        connect(obj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(objectUnpacked(UAVObject*)),
+                (Qt::ConnectionType) (Qt::DirectConnection | Qt::UniqueConnection));
+    }
+
+    m_samples.fill(QVector<QPointF>(), m_requests.size());
+    bool ok = decode(&objManager);
+
+    foreach (QVector<UAVObject*> list, objManager.getObjectsVector())
+        qDeleteAll(list);
+
+    if (!ok || !m_running)
+        return;
+
+    // The scope math runs over the whole series, like it does live
+    for (int i = 0; i < m_requests.size(); i++) {
+        QVector<QPointF> &samples = m_samples[i];
+
+        WindowStatistics statistics;
+        double quantile;
+        statistics.setStatistic(WindowStatistics::fromMathFunction(m_requests.at(i).mathFunction, &quantile), quantile);
+        statistics.setWindow(m_requests.at(i).meanSamples);
+        if (statistics.statistic() != WindowStatistics::NONE) {
+            for (int j = 0; j < samples.size(); j++)
+                samples[j].ry() = statistics.append(samples.at(j).y());
+        }
+
+        m_series.append(new SeriesPyramid(samples));
+        samples.clear();
+    }
+
+    m_succeeded = true;
+}
+
+
+/**
+ * @brief LogSeriesLoader::addTarget Resolves the field and element of a request once
+ * @return false if the UAVO has no such field or element
+ */
+bool LogSeriesLoader::addTarget(int request, UAVObject *obj)
+{
+    const LogSeriesRequest &r = m_requests.at(request);
+
+    UAVObjectField *field = obj->getField(r.uavFieldName);
+    if (field == NULL)
+        return false;
+
+    Target target;
+    target.request = request;
+    target.fieldIndex = obj->getFields().indexOf(field);
+    target.elementIndex = 0;
+    target.scale = pow(10, r.scalePower);
+
+    if (!r.uavSubFieldName.isEmpty()) {
+        target.elementIndex = field->getElementNames().indexOf(r.uavSubFieldName);
+        if (target.elementIndex < 0)
+            return false;
+    }
+
+    m_targets[obj->getObjID()].append(target);
+    return true;
+}
+
+
+/**
+ * @brief LogSeriesLoader::newInstance Instances of multi instance objects are created by UAVTalk as they arrive
+ */
+void LogSeriesLoader::newInstance(UAVObject *obj)
+{
+    if (m_targets.contains(obj->getObjID()))
+        connect(obj, SIGNAL(objectUnpacked(UAVObject*)), this, SLOT(objectUnpacked(UAVObject*)), Qt::DirectConnection);
+}
+
+
+void LogSeriesLoader::objectUnpacked(UAVObject *obj)
+{
+    double time = m_currentTime / 1000.0;
+
+    foreach (const Target &target, m_targets.value(obj->getObjID())) {
+        UAVObjectField *field = obj->getFields().value(target.fieldIndex, NULL);
+        if (field)
+            m_samples[target.request].append(QPointF(time, field->getDouble(target.elementIndex) * target.scale));
+    }
+}
+
+
+/**
+ * @brief LogSeriesLoader::decode Hands every packet of the log to the parser where it is in the mapping
+ * @return false if the log cannot be read
+ */
+bool LogSeriesLoader::decode(UAVObjectManager *objManager)
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "In scope gadget, unable to open" << m_fileName;
+        return false;
+    }
+
+    // Skip the header, logs without one start with the first packet
+    if (file.readLine().startsWith("Tau Labs git hash")) {
+        int cnt = 0;
+        while (file.readLine() != "##\n" && cnt < 10 && !file.atEnd())
+            cnt++;
+        if (cnt >= 10 || file.atEnd())
+            file.seek(0);
+    } else {
+        file.seek(0);
+    }
+
+    qint64 pos = file.pos();
+    qint64 size = file.size();
+    const uchar *log = file.map(0, size);
+    if (log == NULL) {
+        qDebug() << "In scope gadget, unable to map" << m_fileName;
+        return false;
+    }
+
+    QBuffer dummy;
+    UAVTalk uavTalk(&dummy, objManager);
+
+    while (m_running && pos + (qint64) LOG_PACKET_HEADER_SIZE <= size) {
+        qint64 dataSize;
+        memcpy(&m_currentTime, log + pos, sizeof(m_currentTime));
+        memcpy(&dataSize, log + pos + sizeof(m_currentTime), sizeof(dataSize));
+
+        // Resync on the next byte like the replay does
+        if ((dataSize & 0xFFFFFFFFFFFF0000) != 0) {
+            pos++;
+            continue;
+        }
+
+        pos += LOG_PACKET_HEADER_SIZE;
+        if (pos + dataSize > size)
+            break;
+
+        uavTalk.processInputBuffer(log + pos, dataSize);
+        pos += dataSize;
+    }
+
+    file.unmap((uchar *) log);
+    return true;
+}
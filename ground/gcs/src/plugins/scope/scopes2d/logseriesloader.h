@@ -0,0 +1,111 @@
+/**
+ ******************************************************************************
+ *
+ * @file       logseriesloader.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Reads the plotted fields out of a GCS log, off the GUI thread
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef LOGSERIESLOADER_H
+#define LOGSERIESLOADER_H
+
+#include "scopes2d/seriespyramid.h"
+#include "uavobject.h"
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+class UAVDataObject;
+class UAVObjectManager;
+
+
+/**
+ * @brief The LogSeriesRequest struct One curve to read from the log
+ */
+struct LogSeriesRequest {
+    QString uavObjectName;
+    QString uavFieldName;
+    QString uavSubFieldName; //!< Empty for fields with a single element
+    int scalePower;
+    QString mathFunction;
+    int meanSamples;
+};
+
+
+/**
+ * @brief The LogSeriesLoader class Decodes a whole .tll log in one pass and
+ * builds a SeriesPyramid for every requested curve.
+ *
+ * The thread has its own object manager with a copy of every UAVO type,
+ * created in the thread so that their update signals are delivered
+ * right away. The log is memory mapped and each packet is handed to UAVTalk
+ * where it lies, the same way logexport reads logs. The x values are the
+ * log timestamps in seconds.
+ */
+class LogSeriesLoader : public QThread
+{
+    Q_OBJECT
+public:
+    LogSeriesLoader(const QString &fileName, const QList<LogSeriesRequest> &requests, QObject *parent = 0);
+    ~LogSeriesLoader();
+
+    QString fileName() const { return m_fileName; }
+    bool succeeded() const { return m_succeeded; }
+
+    //! The series of request i once the thread finished, the caller owns it
+    SeriesPyramid *takeSeries(int i);
+
+    void stop() { m_running = false; }
+
+protected:
+    void run();
+
+private slots:
+    void newInstance(UAVObject *obj);
+    void objectUnpacked(UAVObject *obj);
+
+private:
+    struct Target {
+        int request;
+        int fieldIndex;
+        int elementIndex;
+        double scale;
+    };
+
+    bool addTarget(int request, UAVObject *obj);
+    bool decode(UAVObjectManager *objManager);
+
+    QString m_fileName;
+    QList<LogSeriesRequest> m_requests;
+    QList<UAVDataObject *> m_types;             //!< The first GCS instance of every UAVO
+    QHash<quint32, QList<Target> > m_targets;   //!< The requests, by the ID of the UAVO they read
+    QVector<QVector<QPointF> > m_samples;
+    QList<SeriesPyramid *> m_series;
+    quint32 m_currentTime;
+    volatile bool m_running;
+    bool m_succeeded;
+};
+
+#endif // LOGSERIESLOADER_H
@@ -0,0 +1,214 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotseriesbuffer.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Ring buffer storage for the scope curves, read by Qwt in place
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/plotseriesbuffer.h"
+
+#include <math.h>
+
+
+/**
+ * @brief PlotSeriesBuffer::PlotSeriesBuffer
+ * @param capacity Number of samples to keep when overwriting, otherwise the initial allocation
+ * @param overwrite Drop the oldest sample once capacity samples are stored
+ */
+PlotSeriesBuffer::PlotSeriesBuffer(int capacity, bool overwrite) :
+    m_samples(capacity),
+    m_resolution(0),
+    m_xOrigin(0),
+    m_capacity(qMax(capacity, 1)),
+    m_overwrite(overwrite)
+{
+}
+
+
+/**
+ * @brief PlotSeriesBuffer::append Adds a sample after the newest one
+ */
+void PlotSeriesBuffer::append(const QPointF &sample)
+{
+    if (m_overwrite && m_samples.size() >= m_capacity)
+        removeFirst();
+
+    m_samples.append(sample);
+    addToBuckets(sample);
+}
+
+
+/**
+ * @brief PlotSeriesBuffer::removeBefore Drops all the samples older than x
+ */
+void PlotSeriesBuffer::removeBefore(double x)
+{
+    while (!m_samples.isEmpty() && m_samples.first().x() < x)
+        removeFirst();
+}
+
+
+void PlotSeriesBuffer::clear()
+{
+    m_samples.clear();
+    m_buckets.clear();
+}
+
+
+/**
+ * @brief PlotSeriesBuffer::setCapacity Sets the number of samples kept by an overwriting buffer
+ */
+void PlotSeriesBuffer::setCapacity(int capacity)
+{
+    m_capacity = qMax(capacity, 1);
+
+    if (m_overwrite) {
+        while (m_samples.size() > m_capacity)
+            removeFirst();
+    }
+}
+
+
+/**
+ * @brief PlotSeriesBuffer::setResolution Sets the x interval that is reduced to its min and max
+ * @param xDelta Width of the interval, usually the x span of one pixel. 0 disables decimation.
+ */
+void PlotSeriesBuffer::setResolution(double xDelta)
+{
+    if (xDelta == m_resolution)
+        return;
+
+    m_resolution = xDelta;
+    rebuildBuckets();
+}
+
+
+size_t PlotSeriesBuffer::size() const
+{
+    if (decimated())
+        return m_buckets.size() * 2;
+
+    return m_samples.size();
+}
+
+
+QPointF PlotSeriesBuffer::sample(size_t i) const
+{
+    QPointF point;
+
+    if (decimated()) {
+        // Emit the min and max of each interval in the order they happened
+        const Bucket &bucket = m_buckets.at(i / 2);
+        bool minFirst = bucket.min.x() <= bucket.max.x();
+        point = ((i % 2 == 0) == minFirst) ? bucket.min : bucket.max;
+    } else {
+        point = m_samples.at(i);
+    }
+
+    point.rx() -= m_xOrigin;
+    return point;
+}
+
+
+/**
+ * @brief PlotSeriesBuffer::boundingRect Bounds of what Qwt gets to draw
+ * @note The cost is proportional to size(), which is bounded by the decimation
+ */
+QRectF PlotSeriesBuffer::boundingRect() const
+{
+    size_t n = size();
+    if (n == 0)
+        return QRectF(0.0, 0.0, -1.0, -1.0);
+
+    QPointF point = sample(0);
+    double minX = point.x(), maxX = point.x();
+    double minY = point.y(), maxY = point.y();
+    for (size_t i = 1; i < n; i++) {
+        point = sample(i);
+        minX = qMin(minX, point.x());
+        maxX = qMax(maxX, point.x());
+        minY = qMin(minY, point.y());
+        maxY = qMax(maxY, point.y());
+    }
+
+    return QRectF(minX, minY, maxX - minX, maxY - minY);
+}
+
+
+/**
+ * @brief PlotSeriesBuffer::removeFirst Drops the oldest sample
+ * @note The min and max of the oldest interval are not recomputed when only
+ * some of its samples are gone, that interval is at the edge of the window.
+ */
+void PlotSeriesBuffer::removeFirst()
+{
+    m_samples.removeFirst();
+
+    if (m_buckets.isEmpty())
+        return;
+
+    if (--m_buckets.first().count == 0)
+        m_buckets.removeFirst();
+}
+
+
+void PlotSeriesBuffer::addToBuckets(const QPointF &sample)
+{
+    if (m_resolution <= 0)
+        return;
+
+    double interval = floor(sample.x() / m_resolution);
+    if (m_buckets.isEmpty() || interval > m_buckets.last().interval) {
+        Bucket bucket;
+        bucket.interval = interval;
+        bucket.min = sample;
+        bucket.max = sample;
+        bucket.count = 1;
+        m_buckets.append(bucket);
+        return;
+    }
+
+    Bucket &bucket = m_buckets.last();
+    if (sample.y() < bucket.min.y())
+        bucket.min = sample;
+    if (sample.y() >= bucket.max.y())
+        bucket.max = sample;
+    bucket.count++;
+}
+
+
+void PlotSeriesBuffer::rebuildBuckets()
+{
+    m_buckets.clear();
+    for (int i = 0; i < m_samples.size(); i++)
+        addToBuckets(m_samples.at(i));
+}
+
+
+/**
+ * @brief PlotSeriesBuffer::decimated Only worth it when intervals hold more than two samples on average
+ */
+bool PlotSeriesBuffer::decimated() const
+{
+    return m_resolution > 0 && m_samples.size() > m_buckets.size() * 2;
+}
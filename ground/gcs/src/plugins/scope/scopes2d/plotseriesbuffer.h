@@ -0,0 +1,152 @@
+/**
+ ******************************************************************************
+ *
+ * @file       plotseriesbuffer.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Ring buffer storage for the scope curves, read by Qwt in place
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef PLOTSERIESBUFFER_H
+#define PLOTSERIESBUFFER_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+
+/**
+ * @brief The RingBuffer class A FIFO on top of a QVector. Appending and
+ * dropping the oldest element are O(1). It doubles its capacity when an
+ * element is appended while it is full.
+ */
+template <typename T>
+class RingBuffer
+{
+public:
+    RingBuffer(int capacity = 16) :
+        m_data(qMax(capacity, 1)), m_head(0), m_count(0) {}
+
+    int size() const { return m_count; }
+    bool isEmpty() const { return m_count == 0; }
+    int capacity() const { return m_data.size(); }
+
+    //! Element i, counting from the oldest one
+    const T &at(int i) const { return m_data.at((m_head + i) % m_data.size()); }
+    const T &first() const { return at(0); }
+    const T &last() const { return at(m_count - 1); }
+    T &first() { return m_data[m_head]; }
+    T &last() { return m_data[(m_head + m_count - 1) % m_data.size()]; }
+
+    void append(const T &val)
+    {
+        if (m_count == m_data.size())
+            grow();
+        m_data[(m_head + m_count) % m_data.size()] = val;
+        m_count++;
+    }
+
+    void removeFirst()
+    {
+        if (m_count == 0)
+            return;
+        m_head = (m_head + 1) % m_data.size();
+        m_count--;
+    }
+
+    void clear() { m_head = 0; m_count = 0; }
+
+private:
+    void grow()
+    {
+        QVector<T> data(m_data.size() * 2);
+        for (int i = 0; i < m_count; i++)
+            data[i] = at(i);
+        m_data = data;
+        m_head = 0;
+    }
+
+    QVector<T> m_data;
+    int m_head;
+    int m_count;
+};
+
+
+/**
+ * @brief The PlotSeriesBuffer class Sample storage for one scope curve.
+ *
+ * QwtPlotCurve reads the samples straight out of the ring buffer instead of
+ * getting a copy on every replot. The samples must be appended in increasing
+ * x order. With overwrite set the buffer keeps at most capacity samples and
+ * drops the oldest one for each new one, otherwise it grows as needed and
+ * the owner drops old samples with removeBefore().
+ *
+ * Alongside the raw samples the buffer keeps the minimum and maximum of
+ * every x interval of the configured resolution (normally one pixel). When
+ * there are more samples than that it hands Qwt only those two points per
+ * interval, so drawing costs the same whatever the window length.
+ */
+class PlotSeriesBuffer : public QwtSeriesData<QPointF>
+{
+public:
+    PlotSeriesBuffer(int capacity, bool overwrite);
+
+    void append(const QPointF &sample);
+    void removeBefore(double x);
+    void clear();
+
+    void setCapacity(int capacity);
+    void setResolution(double xDelta);
+    void setXOrigin(double x) { m_xOrigin = x; }
+
+    int count() const { return m_samples.size(); }
+    const QPointF &first() const { return m_samples.first(); }
+    const QPointF &last() const { return m_samples.last(); }
+
+    // QwtSeriesData interface
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    struct Bucket {
+        double interval; //!< floor(x / resolution) of the samples in it
+        QPointF min;
+        QPointF max;
+        int count;
+    };
+
+    void removeFirst();
+    void addToBuckets(const QPointF &sample);
+    void rebuildBuckets();
+    bool decimated() const;
+
+    RingBuffer<QPointF> m_samples;
+    RingBuffer<Bucket> m_buckets;
+    double m_resolution;
+    double m_xOrigin;
+    int m_capacity;
+    bool m_overwrite;
+};
+
+#endif // PLOTSERIESBUFFER_H
@@ -39,6 +39,48 @@
 #include "qwt/src/qwt_plot_curve.h"
 
 
+/**
+ * @brief ScatterplotData::setMathFunction Resolves the math function once, so that appending doesn't compare strings
+ */
+void ScatterplotData::setMathFunction(QString val)
+{
+    Plot2dData::setMathFunction(val);
+
+    double quantile;
+    WindowStatistics::Statistic statistic = WindowStatistics::fromMathFunction(val, &quantile);
+    statistics.setStatistic(statistic, quantile);
+}
+
+
+/**
+ * @brief ScatterplotData::applyMath Runs the math function over the last meanSamples values
+ * @return The value to plot
+ */
+double ScatterplotData::applyMath(double value)
+{
+    if (statistics.statistic() == WindowStatistics::NONE)
+        return value;
+
+    statistics.setWindow(meanSamples);
+    return statistics.append(value);
+}
+
+
+/**
+ * @brief ScatterplotData::updateCurve Lets the curve know its samples changed
+ * @param scopeGadgetWidget
+ * @param xWindow Span of the x axis, it is decimated down to about two samples per pixel
+ */
+void ScatterplotData::updateCurve(ScopeGadgetWidget *scopeGadgetWidget, double xWindow)
+{
+    int pixels = scopeGadgetWidget->canvas()->width();
+    samples->setResolution(pixels > 0 ? xWindow / pixels : 0);
+
+    if (readAndResetUpdatedFlag() == true)
+        curve->itemChanged();
+}
+
+
 /**
  * @brief Scatterplot2dScopeConfig::plotNewData Update plot with new data
  * @param scopeGadgetWidget
@@ -47,11 +89,9 @@ void TimeSeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeCon
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
     //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    updateCurve(scopeGadgetWidget, m_xWindowSize);
 
     QDateTime NOW = QDateTime::currentDateTime();
     double toTime = NOW.toTime_t();
@@ -69,11 +109,9 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
 {
     Q_UNUSED(plot2dData);
     Q_UNUSED(scopeConfig);
-    Q_UNUSED(scopeGadgetWidget);
 
     //Plot new data
-    if (readAndResetUpdatedFlag() == true)
-        curve->setSamples(*xData, *yData);
+    updateCurve(scopeGadgetWidget, m_xWindowSize);
 }
 
 
@@ -84,61 +122,24 @@ void SeriesPlotData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig,
  */
 bool SeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the front
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            if (yData->size() > getXWindowSize()) { //If new data overflows the window, remove old data...
-                yData->pop_front();
-            } else //...otherwise, add a new y point at position xData
-                xData->insert(xData->size(), xData->size());
-
-            return true;
-        }
+    //Get the field of interest
+    UAVObjectField* field = fieldOf(obj);
+
+    if (field) {
+
+        double currentValue = valueAsDouble(field) * pow(10, scalePower);
+
+        //Perform scope math, if necessary
+        currentValue = applyMath(currentValue);
+
+        //The ring buffer drops the oldest point once the window is full...
+        samples->setCapacity(getXWindowSize());
+        samples->append(QPointF(sampleCount++, currentValue));
+
+        //...and the plot shows it at x = 0
+        samples->setXOrigin(samples->first().x());
+
+        return true;
     }
 
     return false;
@@ -152,60 +153,23 @@ bool SeriesPlotData::append(UAVObject* obj)
  */
 bool TimeSeriesPlotData::append(UAVObject* obj)
 {
-    if (uavObjectName == obj->getName()) {
-        //Get the field of interest
-        UAVObjectField* field =  obj->getField(uavFieldName);
-
-        if (field) {
-            QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
-            double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
-
-            //Perform scope math, if necessary
-            if (mathFunction  == "Boxcar average" || mathFunction  == "Standard deviation"){
-                //Put the new value at the back
-                yDataHistory->append( currentValue );
-
-                // calculate average value
-                meanSum += currentValue;
-                if(yDataHistory->size() > (int)meanSamples) {
-                    meanSum -= yDataHistory->first();
-                    yDataHistory->pop_front();
-                }
-                // make sure to correct the sum every meanSamples steps to prevent it
-                // from running away due to floating point rounding errors
-                correctionSum+=currentValue;
-                if (++correctionCount >= (int)meanSamples) {
-                    meanSum = correctionSum;
-                    correctionSum = 0.0f;
-                    correctionCount = 0;
-                }
-
-                double boxcarAvg=meanSum/yDataHistory->size();
-
-                if ( mathFunction  == "Standard deviation" ){
-                    //Calculate square of sample standard deviation, with Bessel's correction
-                    double stdSum=0;
-                    for (int i=0; i < yDataHistory->size(); i++){
-                        stdSum+= pow(yDataHistory->at(i)- boxcarAvg,2)/(meanSamples-1);
-                    }
-                    yData->append(sqrt(stdSum));
-                }
-                else  {
-                    yData->append(boxcarAvg);
-                }
-            }
-            else{
-                yData->append( currentValue );
-            }
-
-            double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
-            xData->append(valueX);
-
-            //Remove stale data
-            removeStaleData();
-
-            return true;
-        }
+    //Get the field of interest
+    UAVObjectField* field = fieldOf(obj);
+
+    if (field) {
+        QDateTime NOW = QDateTime::currentDateTime(); //THINK ABOUT REIMPLEMENTING THIS TO SHOW UAVO TIME, NOT SYSTEM TIME
+        double currentValue = valueAsDouble(field) * pow(10, scalePower);
+
+        //Perform scope math, if necessary
+        currentValue = applyMath(currentValue);
+
+        double valueX = NOW.toTime_t() + NOW.time().msec() / 1000.0;
+        samples->append(QPointF(valueX, currentValue));
+
+        //Remove stale data
+        removeStaleData();
+
+        return true;
     }
 
     return false;
@@ -217,22 +181,10 @@ bool TimeSeriesPlotData::append(UAVObject* obj)
  */
 void TimeSeriesPlotData::removeStaleData()
 {
-    double newestValue;
-    double oldestValue;
-
-    while (1) {
-        if (xData->size() == 0)
-            break;
+    if (samples->count() == 0)
+        return;
 
-        newestValue = xData->last();
-        oldestValue = xData->first();
-
-        if (newestValue - oldestValue > getXWindowSize()) {
-            yData->pop_front();
-            xData->pop_front();
-        } else
-            break;
-    }
+    samples->removeBefore(samples->last().x() - getXWindowSize());
 }
 
 
@@ -262,6 +214,6 @@ void ScatterplotData::deletePlots(PlotData *scatterplotData)
  */
 void ScatterplotData::clearPlots()
 {
-    yData->clear();
-    xData->clear();
+    samples->clear();
+    statistics.clear();
 }
@@ -29,6 +29,8 @@
 #define SCATTERPLOTDATA_H
 
 #include "scopes2d/plotdata2d.h"
+#include "scopes2d/plotseriesbuffer.h"
+#include "scopes2d/windowstatistics.h"
 #include "uavobject.h"
 #include "qwt/src/qwt_plot_curve.h"
 
@@ -44,17 +46,26 @@ class ScatterplotData : public Plot2dData
 {
     Q_OBJECT
 public:
-    ScatterplotData(QString uavObject, QString uavField):
-        Plot2dData(uavObject, uavField){curve = 0;}
-    ~ScatterplotData(){}
+    ScatterplotData(QString uavObject, QString uavField, PlotSeriesBuffer *buffer):
+        Plot2dData(uavObject, uavField), samples(buffer) {curve = 0;}
+    ~ScatterplotData(){if (!curve) delete samples;}
 
     virtual void deletePlots(PlotData *);
     void clearPlots();
 
-    void setCurve(QwtPlotCurve *val){curve = val;}
+    virtual void setMathFunction(QString val);
+
+    //! The curve takes ownership of the samples and reads them in place
+    void setCurve(QwtPlotCurve *val){curve = val; curve->setData(samples);}
+    QwtPlotCurve *getCurve(){return curve;}
 
 protected:
+    double applyMath(double value);
+    void updateCurve(ScopeGadgetWidget *scopeGadgetWidget, double xWindow);
+
     QwtPlotCurve* curve;
+    PlotSeriesBuffer* samples;
+    WindowStatistics statistics;
 };
 
 
@@ -68,7 +79,9 @@ class SeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     SeriesPlotData(QString uavObject, QString uavField)
-            : ScatterplotData(uavObject, uavField) {}
+            : ScatterplotData(uavObject, uavField, new PlotSeriesBuffer(1, true)) {
+        sampleCount = 0;
+    }
     ~SeriesPlotData() {}
 
     /*!
@@ -82,6 +95,9 @@ public:
       */
     virtual void removeStaleData(){}
     virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
+
+private:
+    quint64 sampleCount;
 };
 
 
@@ -94,7 +110,7 @@ class TimeSeriesPlotData : public ScatterplotData
     Q_OBJECT
 public:
     TimeSeriesPlotData(QString uavObject, QString uavField)
-            : ScatterplotData(uavObject, uavField) {
+            : ScatterplotData(uavObject, uavField, new PlotSeriesBuffer(1024, false)) {
         scalePower = 1;
     }
     ~TimeSeriesPlotData() {
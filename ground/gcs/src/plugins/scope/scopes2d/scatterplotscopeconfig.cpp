@@ -260,6 +260,10 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
             return;
         }
 
+        // Resolve the field now, so that new data doesn't have to be looked up by name
+        if (!scatterplotData->resolveField(obj))
+            qDebug() << "Field " << scatterplotData->getUavoFieldName() << " is missing from " << scatterplotData->getUavoName();
+
         //Get the units
         QString units = getUavObjectFieldUnits(scatterplotData->getUavoName(), scatterplotData->getUavoFieldName());
 
@@ -279,6 +283,15 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         else if (plotCurveConfig->mathFunction == "Standard deviation"){
             curveNameScaledMath = curveNameScaled + " (std)";
         }
+        else if (plotCurveConfig->mathFunction == "Median"){
+            curveNameScaledMath = curveNameScaled + " (median)";
+        }
+        else if (plotCurveConfig->mathFunction == "5th percentile"){
+            curveNameScaledMath = curveNameScaled + " (p5)";
+        }
+        else if (plotCurveConfig->mathFunction == "95th percentile"){
+            curveNameScaledMath = curveNameScaled + " (p95)";
+        }
         else
         {
             //Shouldn't be able to get here. Perhaps a new math function was added without
@@ -292,7 +305,6 @@ void Scatterplot2dScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetW
         //Create the curve plot
         QwtPlotCurve* plotCurve = new QwtPlotCurve(curveNameScaledMath);
         plotCurve->setPen(QPen(QBrush(QColor(color), Qt::SolidPattern), (qreal)1, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
-        plotCurve->setSamples(*(scatterplotData->getXData()), *(scatterplotData->getYData()));
         plotCurve->attach(scopeGadgetWidget);
         scatterplotData->setCurve(plotCurve);
 
@@ -61,7 +61,8 @@ public:
         NO2DPLOT, //Signifies that there is no 2D plot configured
         SCATTERPLOT2D,
         HISTOGRAM,
-        POLARPLOT
+        POLARPLOT,
+        SPECTRUM
     };
 
     virtual int getScopeDimensions(){return PLOT2D;}
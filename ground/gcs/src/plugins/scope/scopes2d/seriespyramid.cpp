@@ -0,0 +1,197 @@
+/**
+ ******************************************************************************
+ *
+ * @file       seriespyramid.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Multi-resolution min/max overview of a long series, read by Qwt in place
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/seriespyramid.h"
+
+#include <algorithm>
+
+
+static bool xLessThan(const QPointF &a, const QPointF &b)
+{
+    return a.x() < b.x();
+}
+
+
+SeriesPyramid::SeriesPyramid(const QVector<QPointF> &samples) :
+    m_samples(samples),
+    m_maxPoints(4096),
+    m_x0(0),
+    m_x1(0),
+    m_level(0),
+    m_first(0),
+    m_count(0)
+{
+    // Updates from different instances can come out of order, std::stable_sort
+    // keeps the ones with the same time in the order they were logged
+    for (int i = 1; i < m_samples.size(); i++) {
+        if (m_samples.at(i).x() < m_samples.at(i - 1).x()) {
+            std::stable_sort(m_samples.begin(), m_samples.end(), xLessThan);
+            break;
+        }
+    }
+
+    build();
+    select(0, m_samples.size() - 1);
+}
+
+
+void SeriesPyramid::setMaxPoints(int points)
+{
+    m_maxPoints = qMax(points, 2);
+
+    if (m_x1 > m_x0)
+        setRectOfInterest(QRectF(m_x0, 0, m_x1 - m_x0, 0));
+    else
+        select(0, m_samples.size() - 1);
+}
+
+
+/**
+ * @brief SeriesPyramid::setRectOfInterest Called by Qwt with the visible area before it draws
+ */
+void SeriesPyramid::setRectOfInterest(const QRectF &rect)
+{
+    m_x0 = qMin(rect.left(), rect.right());
+    m_x1 = qMax(rect.left(), rect.right());
+
+    if (m_samples.isEmpty() || !(m_x1 > m_x0)) {
+        select(0, m_samples.size() - 1);
+        return;
+    }
+
+    // One sample on either side too, so that the line reaches the edges
+    QPointF x0(m_x0, 0), x1(m_x1, 0);
+    int first = std::lower_bound(m_samples.constBegin(), m_samples.constEnd(), x0, xLessThan) - m_samples.constBegin();
+    int last = std::upper_bound(m_samples.constBegin(), m_samples.constEnd(), x1, xLessThan) - m_samples.constBegin();
+
+    select(qMax(first - 1, 0), qMin(last, m_samples.size() - 1));
+}
+
+
+size_t SeriesPyramid::size() const
+{
+    return m_level == 0 ? m_count : m_count * 2;
+}
+
+
+QPointF SeriesPyramid::sample(size_t i) const
+{
+    if (m_level == 0)
+        return m_samples.at(m_first + i);
+
+    // Emit the min and max of each bucket in the order they happened
+    const Bucket &bucket = m_levels.at(m_level - 1).at(m_first + i / 2);
+    bool minFirst = bucket.min.x() <= bucket.max.x();
+    return ((i % 2 == 0) == minFirst) ? bucket.min : bucket.max;
+}
+
+
+/**
+ * @brief SeriesPyramid::boundingRect Bounds of the whole series, whatever is selected
+ */
+QRectF SeriesPyramid::boundingRect() const
+{
+    return m_bounds;
+}
+
+
+/**
+ * @brief SeriesPyramid::build Computes all the levels, each from the one below
+ */
+void SeriesPyramid::build()
+{
+    m_levels.clear();
+
+    if (m_samples.isEmpty()) {
+        m_bounds = QRectF(0.0, 0.0, -1.0, -1.0);
+        return;
+    }
+
+    QVector<Bucket> level((m_samples.size() + FANOUT - 1) / FANOUT);
+    for (int i = 0; i < level.size(); i++) {
+        Bucket &bucket = level[i];
+        int end = qMin((i + 1) * FANOUT, m_samples.size());
+        bucket.min = bucket.max = m_samples.at(i * FANOUT);
+        for (int j = i * FANOUT + 1; j < end; j++) {
+            const QPointF &point = m_samples.at(j);
+            if (point.y() < bucket.min.y())
+                bucket.min = point;
+            if (point.y() >= bucket.max.y())
+                bucket.max = point;
+        }
+    }
+    m_levels.append(level);
+
+    while (m_levels.last().size() > 1) {
+        const QVector<Bucket> &below = m_levels.last();
+        QVector<Bucket> above((below.size() + FANOUT - 1) / FANOUT);
+        for (int i = 0; i < above.size(); i++) {
+            Bucket &bucket = above[i];
+            int end = qMin((i + 1) * FANOUT, below.size());
+            bucket = below.at(i * FANOUT);
+            for (int j = i * FANOUT + 1; j < end; j++) {
+                const Bucket &child = below.at(j);
+                if (child.min.y() < bucket.min.y())
+                    bucket.min = child.min;
+                if (child.max.y() >= bucket.max.y())
+                    bucket.max = child.max;
+            }
+        }
+        m_levels.append(above);
+    }
+
+    const Bucket &top = m_levels.last().first();
+    double minX = m_samples.first().x();
+    double maxX = m_samples.last().x();
+    m_bounds = QRectF(minX, top.min.y(), maxX - minX, top.max.y() - top.min.y());
+}
+
+
+/**
+ * @brief SeriesPyramid::select Picks the finest level that draws samples first to last in at most m_maxPoints
+ */
+void SeriesPyramid::select(int first, int last)
+{
+    m_level = 0;
+    m_first = first;
+    m_count = last - first + 1;
+
+    if (m_count <= 0) {
+        m_first = 0;
+        m_count = 0;
+        return;
+    }
+
+    int span = 1;
+    while (size() > (size_t)m_maxPoints && m_level < m_levels.size()) {
+        m_level++;
+        span *= FANOUT;
+        m_first = first / span;
+        m_count = last / span - m_first + 1;
+    }
+}
+
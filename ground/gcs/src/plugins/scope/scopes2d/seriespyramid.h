@@ -0,0 +1,93 @@
+/**
+ ******************************************************************************
+ *
+ * @file       seriespyramid.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Multi-resolution min/max overview of a long series, read by Qwt in place
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SERIESPYRAMID_H
+#define SERIESPYRAMID_H
+
+#include "qwt/src/qwt_series_data.h"
+
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+
+/**
+ * @brief The SeriesPyramid class Sample storage for a whole recorded series,
+ * such as one field of a flight log.
+ *
+ * Next to the raw samples it keeps levels of overviews. Each element of
+ * level k holds the minimum and maximum of FANOUT^k consecutive samples, so
+ * all the levels together take about a seventh of the raw samples. Before a
+ * replot Qwt tells the curve which x range is shown, and the pyramid picks
+ * the finest level that still fits in the configured number of points. A
+ * zoom or pan then costs a binary search plus the points that get drawn,
+ * however long the series is.
+ */
+class SeriesPyramid : public QwtSeriesData<QPointF>
+{
+public:
+    //! The samples are sorted by x when they are not already
+    SeriesPyramid(const QVector<QPointF> &samples);
+
+    //! Largest number of points handed to Qwt, about two per pixel
+    void setMaxPoints(int points);
+
+    int count() const { return m_samples.size(); }
+    int levelCount() const { return m_levels.size() + 1; }
+    int selectedLevel() const { return m_level; }
+
+    // QwtSeriesData interface
+    virtual void setRectOfInterest(const QRectF &rect);
+    virtual size_t size() const;
+    virtual QPointF sample(size_t i) const;
+    virtual QRectF boundingRect() const;
+
+private:
+    static const int FANOUT = 8;
+
+    struct Bucket {
+        QPointF min;
+        QPointF max;
+    };
+
+    void build();
+    void select(int first, int last);
+
+    QVector<QPointF> m_samples;
+    QVector<QVector<Bucket> > m_levels; //!< m_levels[k - 1] is level k
+    QRectF m_bounds;
+    int m_maxPoints;
+
+    // What Qwt currently gets to draw
+    double m_x0;
+    double m_x1;
+    int m_level;
+    int m_first;
+    int m_count;
+};
+
+#endif // SERIESPYRAMID_H
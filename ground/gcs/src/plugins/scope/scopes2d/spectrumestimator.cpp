@@ -0,0 +1,192 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumestimator.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Welch spectrum estimate for the spectrum scope
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/spectrumestimator.h"
+
+#include <math.h>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+
+SpectrumEstimator::SpectrumEstimator(int fftSize, int averages, Scale scale) :
+    m_fftSize(2),
+    m_averages(qMax(averages, 1)),
+    m_scale(scale),
+    m_periodograms(qMax(averages, 1)),
+    m_sinceResync(0),
+    m_sampleRate(0)
+{
+    while (m_fftSize < fftSize)
+        m_fftSize *= 2;
+
+    int bits = 0;
+    while ((1 << bits) < m_fftSize)
+        bits++;
+
+    // Periodic Hann window, so that overlapping frames add up evenly
+    m_window.resize(m_fftSize);
+    m_windowSum = 0;
+    m_windowPower = 0;
+    for (int i = 0; i < m_fftSize; i++) {
+        m_window[i] = 0.5 - 0.5 * cos(2 * M_PI * i / m_fftSize);
+        m_windowSum += m_window[i];
+        m_windowPower += m_window[i] * m_window[i];
+    }
+
+    m_twiddles.resize(m_fftSize / 2);
+    for (int i = 0; i < m_fftSize / 2; i++)
+        m_twiddles[i] = std::polar(1.0, -2 * M_PI * i / m_fftSize);
+
+    m_bitReversed.resize(m_fftSize);
+    for (int i = 0; i < m_fftSize; i++) {
+        int reversed = 0;
+        for (int bit = 0; bit < bits; bit++)
+            if (i & (1 << bit))
+                reversed |= 1 << (bits - 1 - bit);
+        m_bitReversed[i] = reversed;
+    }
+
+    m_powerSum.fill(0, m_fftSize / 2 + 1);
+}
+
+
+void SpectrumEstimator::addFrame(const QVector<double> &frame, double sampleRate)
+{
+    if (frame.size() != m_fftSize || sampleRate <= 0)
+        return;
+
+    // The mean would leak into the lowest bins through the window
+    double mean = 0;
+    for (int i = 0; i < m_fftSize; i++)
+        mean += frame.at(i);
+    mean /= m_fftSize;
+
+    QVector<std::complex<double> > data(m_fftSize);
+    for (int i = 0; i < m_fftSize; i++)
+        data[m_bitReversed.at(i)] = (frame.at(i) - mean) * m_window.at(i);
+    transform(data);
+
+    QVector<double> power(m_fftSize / 2 + 1);
+    for (int k = 0; k < power.size(); k++)
+        power[k] = std::norm(data.at(k));
+
+    if (m_periodograms.size() >= m_averages) {
+        const QVector<double> &oldest = m_periodograms.first();
+        for (int k = 0; k < power.size(); k++)
+            m_powerSum[k] -= oldest.at(k);
+        m_periodograms.removeFirst();
+    }
+    m_periodograms.append(power);
+    for (int k = 0; k < power.size(); k++)
+        m_powerSum[k] += power.at(k);
+
+    // Once per averaging length, start again from the periodograms themselves
+    if (++m_sinceResync >= m_averages)
+        resyncPowerSum();
+
+    m_sampleRate = sampleRate;
+}
+
+
+QVector<QPointF> SpectrumEstimator::spectrum() const
+{
+    QVector<QPointF> points;
+
+    int count = m_periodograms.size();
+    if (count == 0)
+        return points;
+
+    points.resize(m_powerSum.size());
+    for (int k = 0; k < m_powerSum.size(); k++) {
+        double power = qMax(m_powerSum.at(k), 0.0) / count;
+
+        // Fold the negative frequencies onto the positive ones
+        bool folded = k > 0 && k < m_fftSize / 2;
+
+        double value;
+        switch (m_scale) {
+        case AMPLITUDE:
+            value = sqrt(power) * (folded ? 2 : 1) / m_windowSum;
+            break;
+        case PSD_DB:
+            value = 10 * log10(qMax(power * (folded ? 2 : 1) / (m_sampleRate * m_windowPower), 1e-30));
+            break;
+        case PSD:
+        default:
+            value = power * (folded ? 2 : 1) / (m_sampleRate * m_windowPower);
+            break;
+        }
+
+        points[k] = QPointF(k * m_sampleRate / m_fftSize, value);
+    }
+
+    return points;
+}
+
+
+void SpectrumEstimator::clear()
+{
+    m_periodograms.clear();
+    m_powerSum.fill(0);
+    m_sinceResync = 0;
+    m_sampleRate = 0;
+}
+
+
+/**
+ * @brief SpectrumEstimator::transform In place radix-2 FFT of data given in bit reversed order
+ */
+void SpectrumEstimator::transform(QVector<std::complex<double> > &data) const
+{
+    for (int length = 2; length <= m_fftSize; length *= 2) {
+        int half = length / 2;
+        int step = m_fftSize / length;
+        for (int start = 0; start < m_fftSize; start += length) {
+            for (int i = 0; i < half; i++) {
+                std::complex<double> even = data.at(start + i);
+                std::complex<double> odd = data.at(start + i + half) * m_twiddles.at(i * step);
+                data[start + i] = even + odd;
+                data[start + i + half] = even - odd;
+            }
+        }
+    }
+}
+
+
+void SpectrumEstimator::resyncPowerSum()
+{
+    m_sinceResync = 0;
+
+    m_powerSum.fill(0);
+    for (int i = 0; i < m_periodograms.size(); i++) {
+        const QVector<double> &power = m_periodograms.at(i);
+        for (int k = 0; k < power.size(); k++)
+            m_powerSum[k] += power.at(k);
+    }
+}
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumestimator.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Welch spectrum estimate for the spectrum scope
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPECTRUMESTIMATOR_H
+#define SPECTRUMESTIMATOR_H
+
+#include "scopes2d/plotseriesbuffer.h"
+
+#include <QPointF>
+#include <QVector>
+
+#include <complex>
+
+
+/**
+ * @brief The SpectrumEstimator class Averages the spectra of the last few
+ * frames of a signal (Welch's method).
+ *
+ * Each frame has its mean removed, is multiplied by a Hann window and goes
+ * through a radix-2 FFT. The power of the last N frames is averaged and
+ * scaled to a one-sided amplitude spectrum or power spectral density.
+ */
+class SpectrumEstimator
+{
+public:
+    enum Scale {
+        AMPLITUDE,  //!< Amplitude of a sine at each frequency, in the units of the signal
+        PSD,        //!< Power spectral density, in units^2/Hz
+        PSD_DB      //!< Power spectral density, in dB relative to 1 unit^2/Hz
+    };
+
+    //! \param fftSize Samples per frame, rounded up to a power of two
+    SpectrumEstimator(int fftSize, int averages, Scale scale);
+
+    int fftSize() const { return m_fftSize; }
+
+    /*!
+      \brief Adds the spectrum of one frame to the average
+      \param frame fftSize() consecutive samples
+      \param sampleRate Rate the samples were taken at, in Hz
+      */
+    void addFrame(const QVector<double> &frame, double sampleRate);
+
+    //! The averaged spectrum, one point per frequency bin from 0 to half the sample rate
+    QVector<QPointF> spectrum() const;
+    void clear();
+
+private:
+    void transform(QVector<std::complex<double> > &data) const;
+    void resyncPowerSum();
+
+    int m_fftSize;
+    int m_averages;
+    Scale m_scale;
+
+    QVector<double> m_window;
+    double m_windowSum;     //!< Sum of the window, scales amplitudes
+    double m_windowPower;   //!< Sum of the squared window, scales densities
+    QVector<std::complex<double> > m_twiddles;
+    QVector<int> m_bitReversed;
+
+    RingBuffer<QVector<double> > m_periodograms; //!< |X(k)|^2 of the frames being averaged
+    QVector<double> m_powerSum;
+    int m_sinceResync;
+    double m_sampleRate;
+};
+
+#endif // SPECTRUMESTIMATOR_H
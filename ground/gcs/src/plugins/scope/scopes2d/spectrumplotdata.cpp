@@ -0,0 +1,188 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumplotdata.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QDebug>
+#include <QDateTime>
+#include <math.h>
+
+#include "scopes2d/spectrumplotdata.h"
+#include "scopegadgetwidget.h"
+
+#include "qwt/src/qwt.h"
+#include "qwt/src/qwt_plot.h"
+#include "qwt/src/qwt_plot_curve.h"
+
+// Frames are dropped rather than queued behind a worker that can't keep up
+#define MAX_FRAMES_IN_FLIGHT 4
+
+
+/**
+ * @brief SpectrumWorker::processFrame Adds a frame to the average and sends back the new spectrum
+ */
+void SpectrumWorker::processFrame(QVector<double> frame, double sampleRate)
+{
+    estimator.addFrame(frame, sampleRate);
+    emit spectrumReady(estimator.spectrum());
+}
+
+
+void SpectrumWorker::reset()
+{
+    estimator.clear();
+}
+
+
+/**
+ * @brief SpectrumData::SpectrumData
+ * @param uavObject
+ * @param uavField
+ * @param fftSize Samples per FFT, rounded up to a power of two
+ * @param overlap Percentage of each frame that is shared with the next one
+ * @param averages Number of spectra averaged together
+ * @param scale Units of the plotted spectrum
+ */
+SpectrumData::SpectrumData(QString uavObject, QString uavField, int fftSize, int overlap, int averages, SpectrumEstimator::Scale scale) :
+    Plot2dData(uavObject, uavField),
+    curve(0),
+    worker(0),
+    framesInFlight(0),
+    spectrumUpdated(false)
+{
+    qRegisterMetaType<QVector<double> >("QVector<double>");
+    qRegisterMetaType<QVector<QPointF> >("QVector<QPointF>");
+
+    worker = new SpectrumWorker(fftSize, averages, scale);
+    this->fftSize = worker->fftSize();
+    hopSize = qMax(1, this->fftSize * (100 - qBound(0, overlap, 90)) / 100);
+
+    worker->moveToThread(&workerThread);
+    connect(this, SIGNAL(frameReady(QVector<double>,double)), worker, SLOT(processFrame(QVector<double>,double)));
+    connect(worker, SIGNAL(spectrumReady(QVector<QPointF>)), this, SLOT(spectrumReady(QVector<QPointF>)));
+    workerThread.start(QThread::LowPriority);
+}
+
+
+SpectrumData::~SpectrumData()
+{
+    workerThread.quit();
+    workerThread.wait();
+    delete worker;
+}
+
+
+/**
+ * @brief SpectrumData::append Appends data to the current frame, and hands the frame to the worker once it is full
+ * @param obj UAVO with new data
+ * @return
+ */
+bool SpectrumData::append(UAVObject* obj)
+{
+    //Get the field of interest
+    UAVObjectField* field = fieldOf(obj);
+
+    if (field) {
+        double currentValue = valueAsDouble(field) * pow(10, scalePower);
+
+        frame.append(currentValue);
+        frameTimes.append(QDateTime::currentMSecsSinceEpoch() / 1000.0);
+
+        if (frame.size() >= fftSize) {
+            // Samples that arrived all at once say nothing about the sample rate
+            double duration = frameTimes.last() - frameTimes.first();
+            if (duration > 0 && framesInFlight < MAX_FRAMES_IN_FLIGHT) {
+                framesInFlight++;
+                emit frameReady(frame, (fftSize - 1) / duration);
+            }
+
+            // Keep the overlap for the next frame
+            frame.remove(0, hopSize);
+            frameTimes.remove(0, hopSize);
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+
+/**
+ * @brief SpectrumData::spectrumReady Keeps the latest spectrum from the worker until the next replot
+ */
+void SpectrumData::spectrumReady(QVector<QPointF> spectrum)
+{
+    framesInFlight--;
+
+    this->spectrum = spectrum;
+    spectrumUpdated = true;
+}
+
+
+/**
+ * @brief SpectrumData::plotNewData Update plot with new data
+ * @param scopeGadgetWidget
+ */
+void SpectrumData::plotNewData(PlotData *plot2dData, ScopeConfig *scopeConfig, ScopeGadgetWidget *scopeGadgetWidget)
+{
+    Q_UNUSED(plot2dData);
+    Q_UNUSED(scopeConfig);
+    Q_UNUSED(scopeGadgetWidget);
+
+    if (!spectrumUpdated)
+        return;
+
+    spectrumUpdated = false;
+    curve->setSamples(spectrum);
+}
+
+
+/**
+ * @brief SpectrumData::deletePlots Delete all plot data
+ */
+void SpectrumData::deletePlots(PlotData *spectrumData)
+{
+    curve->detach();
+
+    delete curve;
+    delete spectrumData;
+}
+
+
+/**
+ * @brief SpectrumData::clearPlots Clear all plot data
+ */
+void SpectrumData::clearPlots()
+{
+    frame.clear();
+    frameTimes.clear();
+
+    spectrum.clear();
+    spectrumUpdated = true;
+
+    // Queued behind the frames already handed over
+    QMetaObject::invokeMethod(worker, "reset", Qt::QueuedConnection);
+}
@@ -0,0 +1,111 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumplotdata.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPECTRUMPLOTDATA_H
+#define SPECTRUMPLOTDATA_H
+
+#include "scopes2d/plotdata2d.h"
+#include "scopes2d/spectrumestimator.h"
+#include "uavobject.h"
+#include "qwt/src/qwt_plot_curve.h"
+
+#include <QThread>
+#include <QVector>
+
+
+/**
+ * @brief The SpectrumWorker class Runs the FFTs of one spectrum curve, off the GUI thread
+ */
+class SpectrumWorker : public QObject
+{
+    Q_OBJECT
+public:
+    SpectrumWorker(int fftSize, int averages, SpectrumEstimator::Scale scale) :
+        estimator(fftSize, averages, scale) {}
+
+    int fftSize() const { return estimator.fftSize(); }
+
+public slots:
+    void processFrame(QVector<double> frame, double sampleRate);
+    void reset();
+
+signals:
+    //! Emitted once for every frame, with the average over the last frames
+    void spectrumReady(QVector<QPointF> spectrum);
+
+private:
+    SpectrumEstimator estimator;
+};
+
+
+/**
+ * @brief The SpectrumData class Cuts the samples of one UAVO field into
+ * overlapping frames and plots the averaged spectrum the worker computes
+ * from them.
+ *
+ * UAVOs don't carry a sample time, so the sample rate of each frame is
+ * estimated from the time its samples arrived at.
+ */
+class SpectrumData : public Plot2dData
+{
+    Q_OBJECT
+public:
+    SpectrumData(QString uavObject, QString uavField, int fftSize, int overlap, int averages, SpectrumEstimator::Scale scale);
+    ~SpectrumData();
+
+    bool append(UAVObject* obj);
+
+    virtual void removeStaleData(){}
+    virtual void plotNewData(PlotData *, ScopeConfig *, ScopeGadgetWidget *);
+    virtual void deletePlots(PlotData *);
+    void clearPlots();
+
+    void setCurve(QwtPlotCurve *val){curve = val;}
+
+signals:
+    void frameReady(QVector<double> frame, double sampleRate);
+
+private slots:
+    void spectrumReady(QVector<QPointF> spectrum);
+
+private:
+    QwtPlotCurve *curve;
+
+    QThread workerThread;
+    SpectrumWorker *worker;
+    int framesInFlight; //!< Frames handed to the worker whose spectrum hasn't come back yet
+
+    int fftSize;
+    int hopSize;        //!< New samples between the starts of two frames
+    QVector<double> frame;
+    QVector<double> frameTimes;
+
+    QVector<QPointF> spectrum;
+    bool spectrumUpdated;
+};
+
+#endif // SPECTRUMPLOTDATA_H
@@ -0,0 +1,424 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumscopeconfig.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "spectrumplotdata.h"
+#include "scopes2d/spectrumscopeconfig.h"
+#include "scopegadgetoptionspage.h"
+
+#include "coreplugin/icore.h"
+#include "coreplugin/connectionmanager.h"
+
+
+/**
+ * @brief SpectrumScopeConfig::SpectrumScopeConfig Default constructor
+ */
+SpectrumScopeConfig::SpectrumScopeConfig()
+{
+    fftSize = 256;
+    overlap = 50;
+    averages = 8;
+    spectrumScale = SpectrumEstimator::PSD_DB;
+    m_refreshInterval = 50;
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::SpectrumScopeConfig Constructor using the XML settings
+ * @param qSettings settings XML object
+ */
+SpectrumScopeConfig::SpectrumScopeConfig(QSettings *qSettings)
+{
+    fftSize       = qSettings->value("fftSize", 256).toInt();
+    overlap       = qSettings->value("overlap", 50).toInt();
+    averages      = qSettings->value("averages", 8).toInt();
+    spectrumScale = (SpectrumEstimator::Scale) qSettings->value("spectrumScale", SpectrumEstimator::PSD_DB).toUInt();
+    m_refreshInterval = 50;
+
+    int dataSourceCount = qSettings->value("dataSourceCount").toInt();
+    for(int i = 0; i < dataSourceCount; i++)
+    {
+        // Start reading XML block
+        qSettings->beginGroup(QString("spectrumDataSource") + QString().number(i));
+
+        Plot2dCurveConfiguration *plotCurveConf = new Plot2dCurveConfiguration();
+
+        plotCurveConf->uavObjectName = qSettings->value("uavObject").toString();
+        plotCurveConf->uavFieldName  = qSettings->value("uavField").toString();
+        plotCurveConf->color         = qSettings->value("color").value<QRgb>();
+        plotCurveConf->yScalePower   = qSettings->value("yScalePower").toInt();
+        plotCurveConf->mathFunction  = qSettings->value("mathFunction").toString();
+        plotCurveConf->yMeanSamples  = qSettings->value("yMeanSamples").toUInt();
+
+        //Stop reading XML block
+        qSettings->endGroup();
+
+        m_spectrumSourceConfigs.append(plotCurveConf);
+    }
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::SpectrumScopeConfig Constructor using the GUI settings
+ * @param options_page GUI settings preference pane
+ */
+SpectrumScopeConfig::SpectrumScopeConfig(Ui::ScopeGadgetOptionsPage *options_page)
+{
+    bool parseOK = false;
+
+    fftSize = options_page->cmbSpectrumFftSize->itemData(options_page->cmbSpectrumFftSize->currentIndex()).toInt(&parseOK);
+    if(!parseOK)
+        fftSize = 256;
+    overlap = options_page->spnSpectrumOverlap->value();
+    averages = options_page->spnSpectrumAverages->value();
+    spectrumScale = (SpectrumEstimator::Scale) options_page->cmbSpectrumScale->itemData(options_page->cmbSpectrumScale->currentIndex()).toUInt();
+    m_refreshInterval = 50;
+
+    //For each y-data source in the list
+    for(int iIndex = 0; iIndex < options_page->lst2dCurves->count();iIndex++) {
+        QListWidgetItem* listItem = options_page->lst2dCurves->item(iIndex);
+
+        //Store some additional data for the plot curve on the list item
+        Plot2dCurveConfiguration* newPlotCurveConfigs = new Plot2dCurveConfiguration();
+        newPlotCurveConfigs->uavObjectName = listItem->data(Qt::UserRole + ScopeGadgetOptionsPage::UR_UAVOBJECT).toString();
+        newPlotCurveConfigs->uavFieldName  = listItem->data(Qt::UserRole + ScopeGadgetOptionsPage::UR_UAVFIELD).toString();
+        newPlotCurveConfigs->yScalePower  = listItem->data(Qt::UserRole + ScopeGadgetOptionsPage::UR_SCALE).toInt(&parseOK);
+        if(!parseOK)
+            newPlotCurveConfigs->yScalePower = 0;
+
+        QVariant varColor  = listItem->data(Qt::UserRole + ScopeGadgetOptionsPage::UR_COLOR);
+        int rgb = varColor.toInt(&parseOK);
+        if(!parseOK)
+            newPlotCurveConfigs->color = QColor(Qt::black).rgb();
+        else
+            newPlotCurveConfigs->color = (QRgb)rgb;
+
+        newPlotCurveConfigs->yMeanSamples = listItem->data(Qt::UserRole + ScopeGadgetOptionsPage::UR_MEAN).toUInt(&parseOK);
+        if(!parseOK)
+            newPlotCurveConfigs->yMeanSamples = 1;
+
+        newPlotCurveConfigs->mathFunction  = listItem->data(Qt::UserRole + ScopeGadgetOptionsPage::UR_MATHFUNCTION).toString();
+
+        m_spectrumSourceConfigs.append(newPlotCurveConfigs);
+    }
+}
+
+
+SpectrumScopeConfig::~SpectrumScopeConfig()
+{
+
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::cloneScope Clones scope from existing GUI configuration
+ * @param originalScope
+ * @return
+ */
+ScopeConfig* SpectrumScopeConfig::cloneScope(ScopeConfig *originalScope)
+{
+    SpectrumScopeConfig *originalSpectrumScopeConfig = (SpectrumScopeConfig*) originalScope;
+    SpectrumScopeConfig *cloneObj = new SpectrumScopeConfig();
+
+    cloneObj->fftSize = originalSpectrumScopeConfig->fftSize;
+    cloneObj->overlap = originalSpectrumScopeConfig->overlap;
+    cloneObj->averages = originalSpectrumScopeConfig->averages;
+    cloneObj->spectrumScale = originalSpectrumScopeConfig->spectrumScale;
+    cloneObj->m_refreshInterval = originalSpectrumScopeConfig->m_refreshInterval;
+
+    foreach (Plot2dCurveConfiguration *currentSpectrumSourceConf, originalSpectrumScopeConfig->m_spectrumSourceConfigs)
+    {
+        Plot2dCurveConfiguration *newSpectrumSourceConf = new Plot2dCurveConfiguration();
+
+        newSpectrumSourceConf->uavObjectName = currentSpectrumSourceConf->uavObjectName;
+        newSpectrumSourceConf->uavFieldName  = currentSpectrumSourceConf->uavFieldName;
+        newSpectrumSourceConf->color         = currentSpectrumSourceConf->color;
+        newSpectrumSourceConf->yScalePower   = currentSpectrumSourceConf->yScalePower;
+        newSpectrumSourceConf->yMeanSamples  = currentSpectrumSourceConf->yMeanSamples;
+        newSpectrumSourceConf->mathFunction  = currentSpectrumSourceConf->mathFunction;
+
+        cloneObj->m_spectrumSourceConfigs.append(newSpectrumSourceConf);
+    }
+
+    return cloneObj;
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::saveConfiguration Saves configuration to XML file
+ * @param qSettings
+ */
+void SpectrumScopeConfig::saveConfiguration(QSettings* qSettings)
+{
+    //Start writing new XML block
+    qSettings->beginGroup(QString("plot2d"));
+
+    qSettings->setValue("plot2dType", SPECTRUM);
+    qSettings->setValue("fftSize", fftSize);
+    qSettings->setValue("overlap", overlap);
+    qSettings->setValue("averages", averages);
+    qSettings->setValue("spectrumScale", spectrumScale);
+
+    int dataSourceCount = m_spectrumSourceConfigs.size();
+    qSettings->setValue("dataSourceCount", dataSourceCount);
+
+    // For each curve source in the plot
+    for(int i = 0; i < dataSourceCount; i++)
+    {
+        Plot2dCurveConfiguration *plotCurveConf = m_spectrumSourceConfigs.at(i);
+        qSettings->beginGroup(QString("spectrumDataSource") + QString().number(i));
+
+        qSettings->setValue("uavObject",  plotCurveConf->uavObjectName);
+        qSettings->setValue("uavField",  plotCurveConf->uavFieldName);
+        qSettings->setValue("color",  plotCurveConf->color);
+        qSettings->setValue("mathFunction",  plotCurveConf->mathFunction);
+        qSettings->setValue("yScalePower",  plotCurveConf->yScalePower);
+        qSettings->setValue("yMeanSamples",  plotCurveConf->yMeanSamples);
+
+        //Stop writing XML blocks
+        qSettings->endGroup();
+    }
+
+    //Stop writing XML block
+    qSettings->endGroup();
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::replaceSpectrumDataSource Replaces the list of spectrum data sources
+ * @param spectrumSourceConfigs
+ */
+void SpectrumScopeConfig::replaceSpectrumDataSource(QList<Plot2dCurveConfiguration*> spectrumSourceConfigs)
+{
+    m_spectrumSourceConfigs.clear();
+    m_spectrumSourceConfigs.append(spectrumSourceConfigs);
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::loadConfiguration loads the plot configuration into the scope gadget widget
+ * @param scopeGadgetWidget
+ */
+void SpectrumScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWidget)
+{
+    preparePlot(scopeGadgetWidget);
+    scopeGadgetWidget->setScope(this);
+    scopeGadgetWidget->startTimer(m_refreshInterval);
+
+    // Configure each data source
+    foreach (Plot2dCurveConfiguration* spectrumDataSourceConfig, m_spectrumSourceConfigs)
+    {
+        QRgb color = spectrumDataSourceConfig->color;
+
+        // The math functions work on the time series, the spectrum is taken from the raw samples
+        SpectrumData* spectrumData = new SpectrumData(spectrumDataSourceConfig->uavObjectName, spectrumDataSourceConfig->uavFieldName,
+                                                      fftSize, overlap, averages, spectrumScale);
+        spectrumData->setScalePower(spectrumDataSourceConfig->yScalePower);
+
+        //Generate the curve name
+        QString curveName = (spectrumData->getUavoName()) + "." + (spectrumData->getUavoFieldName());
+        if(spectrumData->getHaveSubFieldFlag())
+            curveName = curveName.append("." + spectrumData->getUavoSubFieldName());
+
+        //Get the uav object
+        ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
+        UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
+        UAVDataObject* obj = dynamic_cast<UAVDataObject*>(objManager->getObject((spectrumData->getUavoName())));
+        if(!obj) {
+            qDebug() << "Object " << spectrumData->getUavoName() << " is missing";
+            delete spectrumData;
+            return;
+        }
+
+        // Resolve the field now, so that new data doesn't have to be looked up by name
+        if (!spectrumData->resolveField(obj))
+            qDebug() << "Field " << spectrumData->getUavoFieldName() << " is missing from " << spectrumData->getUavoName();
+
+        //Get the units
+        QString units = getUavObjectFieldUnits(spectrumData->getUavoName(), spectrumData->getUavoFieldName());
+        if(spectrumDataSourceConfig->yScalePower != 0)
+            units = "x10^" + QString::number(spectrumDataSourceConfig->yScalePower) + " " + units;
+
+        //Generate name with the spectrum units appended
+        QString curveNameScaled;
+        switch (spectrumScale) {
+        case SpectrumEstimator::AMPLITUDE:
+            curveNameScaled = curveName + "(" + units + ")";
+            break;
+        case SpectrumEstimator::PSD:
+            curveNameScaled = curveName + "((" + units + ")^2/Hz)";
+            break;
+        case SpectrumEstimator::PSD_DB:
+        default:
+            curveNameScaled = curveName + "(dB " + units + "^2/Hz)";
+            break;
+        }
+
+        while(scopeGadgetWidget->getDataSources().keys().contains(curveNameScaled))
+            curveNameScaled=curveNameScaled+"*";
+
+        //Create the curve plot
+        QwtPlotCurve* plotCurve = new QwtPlotCurve(curveNameScaled);
+        plotCurve->setPen(QPen(QBrush(QColor(color), Qt::SolidPattern), (qreal)1, Qt::SolidLine, Qt::SquareCap, Qt::BevelJoin));
+        plotCurve->attach(scopeGadgetWidget);
+        spectrumData->setCurve(plotCurve);
+
+        //Keep the curve details for later
+        scopeGadgetWidget->insertDataSources(curveNameScaled, spectrumData);
+
+        // Connect the UAVO
+        scopeGadgetWidget->connectUAVO(obj);
+    }
+    mutex.lock();
+    scopeGadgetWidget->replot();
+    mutex.unlock();
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::setGuiConfiguration Set the GUI elements based on values from the XML settings file
+ * @param options_page
+ */
+void SpectrumScopeConfig::setGuiConfiguration(Ui::ScopeGadgetOptionsPage *options_page)
+{
+    //Set the tab widget to 2D
+    options_page->tabWidget2d3d->setCurrentWidget(options_page->tabPlot2d);
+
+    //Set the plot type
+    options_page->cmb2dPlotType->setCurrentIndex(options_page->cmb2dPlotType->findData(SPECTRUM));
+
+    options_page->cmbSpectrumFftSize->setCurrentIndex(options_page->cmbSpectrumFftSize->findData(fftSize));
+    options_page->spnSpectrumOverlap->setValue(overlap);
+    options_page->spnSpectrumAverages->setValue(averages);
+    options_page->cmbSpectrumScale->setCurrentIndex(options_page->cmbSpectrumScale->findData(spectrumScale));
+
+    //add the configured 2D curves
+    options_page->lst2dCurves->clear();  //Clear list first
+
+    foreach (Plot2dCurveConfiguration* dataSource, m_spectrumSourceConfigs) {
+        QString uavObjectName = dataSource->uavObjectName;
+        QString uavFieldName = dataSource->uavFieldName;
+        int scale = dataSource->yScalePower;
+        unsigned int mean = dataSource->yMeanSamples;
+        QString mathFunction = dataSource->mathFunction;
+        QVariant varColor = dataSource->color;
+
+        QString listItemDisplayText = uavObjectName + "." + uavFieldName; // Generate the name
+        options_page->lst2dCurves->addItem(listItemDisplayText);  // Add the name to the list
+        int itemIdx = options_page->lst2dCurves->count() - 1; // Get the index number for the new value
+        QListWidgetItem *listWidgetItem = options_page->lst2dCurves->item(itemIdx); //Find the widget item
+
+        bool parseOK = false;
+        QRgb rgbColor;
+
+        if(uavObjectName!="")
+        {
+            //Set the properties of the newly added list item
+            listItemDisplayText = uavObjectName + "." + uavFieldName;
+            rgbColor = (QRgb)varColor.toInt(&parseOK);
+            if(!parseOK)
+                rgbColor = qRgb(255,0,0);
+        }
+        else{
+            listItemDisplayText = "New graph";
+            rgbColor = qRgb(255,0,0);
+        }
+
+        QColor color = QColor( rgbColor );
+        listWidgetItem->setText(listItemDisplayText);
+        listWidgetItem->setTextColor( color );
+
+        //Store some additional data for the plot curve on the list item
+        listWidgetItem->setData(Qt::UserRole + ScopeGadgetOptionsPage::UR_UAVOBJECT, QVariant(uavObjectName));
+        listWidgetItem->setData(Qt::UserRole + ScopeGadgetOptionsPage::UR_UAVFIELD, QVariant(uavFieldName));
+        listWidgetItem->setData(Qt::UserRole + ScopeGadgetOptionsPage::UR_SCALE, QVariant(scale));
+        listWidgetItem->setData(Qt::UserRole + ScopeGadgetOptionsPage::UR_COLOR, varColor);
+        listWidgetItem->setData(Qt::UserRole + ScopeGadgetOptionsPage::UR_MEAN, QVariant(mean));
+        listWidgetItem->setData(Qt::UserRole + ScopeGadgetOptionsPage::UR_MATHFUNCTION, QVariant(mathFunction));
+
+        //Select the row with the new name
+        options_page->lst2dCurves->setCurrentRow(itemIdx);
+    }
+
+    //Select row 1st row in list
+    options_page->lst2dCurves->setCurrentRow(0, QItemSelectionModel::ClearAndSelect);
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::preparePlot Prepares the Qwt plot colors and axes
+ * @param scopeGadgetWidget
+ */
+void SpectrumScopeConfig::preparePlot(ScopeGadgetWidget *scopeGadgetWidget)
+{
+    scopeGadgetWidget->setMinimumSize(64, 64);
+    scopeGadgetWidget->setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
+
+    scopeGadgetWidget->setCanvasBackground(QColor(64, 64, 64));
+
+    //Add grid lines
+    scopeGadgetWidget->m_grid->enableX( true );
+    scopeGadgetWidget->m_grid->enableY( true );
+    scopeGadgetWidget->m_grid->enableXMin( false );
+    scopeGadgetWidget->m_grid->enableYMin( false );
+    scopeGadgetWidget->m_grid->setMajorPen(QPen(Qt::gray, 0, Qt::DashLine));
+    scopeGadgetWidget->m_grid->setMinorPen(QPen(Qt::lightGray, 0, Qt::DotLine));
+    scopeGadgetWidget->m_grid->setPen(QPen(Qt::darkGray, 1, Qt::DotLine));
+    scopeGadgetWidget->m_grid->attach(scopeGadgetWidget);
+
+    // Add the legend
+    scopeGadgetWidget->addLegend();
+
+    // Configure axes
+    configureAxes(scopeGadgetWidget);
+}
+
+
+/**
+ * @brief SpectrumScopeConfig::configureAxes Configure the axes. The x axis is the frequency, in Hz.
+ * @param scopeGadgetWidget
+ */
+void SpectrumScopeConfig::configureAxes(ScopeGadgetWidget *scopeGadgetWidget)
+{
+    // Configure axes
+    scopeGadgetWidget->setAxisScaleDraw(QwtPlot::xBottom, new QwtScaleDraw());
+    scopeGadgetWidget->setAxisAutoScale(QwtPlot::xBottom, true);
+    scopeGadgetWidget->setAxisAutoScale(QwtPlot::yLeft, true);
+    scopeGadgetWidget->setAxisLabelRotation(QwtPlot::xBottom, 0.0);
+    scopeGadgetWidget->setAxisLabelAlignment(QwtPlot::xBottom, Qt::AlignLeft | Qt::AlignBottom);
+    scopeGadgetWidget->axisWidget( QwtPlot::yRight )->setColorBarEnabled( false );
+    scopeGadgetWidget->enableAxis( QwtPlot::yRight, false );
+
+    // Reduce the gap between the scope canvas and the axis scale
+    QwtScaleWidget *scaleWidget = scopeGadgetWidget->axisWidget(QwtPlot::xBottom);
+    scaleWidget->setMargin(0);
+
+    // Reduce the axis font size
+    QFont fnt(scopeGadgetWidget->axisFont(QwtPlot::xBottom));
+    fnt.setPointSize(7);
+    scopeGadgetWidget->setAxisFont(QwtPlot::xBottom, fnt);	// x-axis
+    scopeGadgetWidget->setAxisFont(QwtPlot::yLeft, fnt);	// y-axis
+}
@@ -0,0 +1,86 @@
+/**
+ ******************************************************************************
+ *
+ * @file       spectrumscopeconfig.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief The scope Gadget, graphically plots the states of UAVObjects
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SPECTRUMSCOPECONFIG_H
+#define SPECTRUMSCOPECONFIG_H
+
+#include "scopes2d/scopes2dconfig.h"
+#include "scopes2d/spectrumestimator.h"
+
+
+/**
+ * @brief The SpectrumScopeConfig class The spectrum scope configuration. It
+ * plots the averaged frequency spectrum of each data source, computed in the
+ * GCS from the raw samples.
+ */
+class SpectrumScopeConfig : public Scopes2dConfig
+{
+    Q_OBJECT
+public:
+    SpectrumScopeConfig();
+    SpectrumScopeConfig(QSettings *qSettings);
+    SpectrumScopeConfig(Ui::ScopeGadgetOptionsPage *options_page);
+    ~SpectrumScopeConfig();
+
+    virtual void saveConfiguration(QSettings* qSettings);
+
+    QList<Plot2dCurveConfiguration*> getSpectrumDataSource(){return m_spectrumSourceConfigs;}
+    void addSpectrumDataSource(Plot2dCurveConfiguration* value){m_spectrumSourceConfigs.append(value);}
+    void replaceSpectrumDataSource(QList<Plot2dCurveConfiguration*> spectrumSourceConfigs);
+
+    //Getter functions
+    virtual int getScopeType(){return (int) SPECTRUM;}
+    int getFftSize(){return fftSize;}
+    int getOverlap(){return overlap;}
+    int getAverages(){return averages;}
+    SpectrumEstimator::Scale getSpectrumScale(){return spectrumScale;}
+    virtual QList<Plot2dCurveConfiguration*> getDataSourceConfigs(){return m_spectrumSourceConfigs;}
+
+    //Setter functions
+    void setFftSize(int val){fftSize = val;}
+    void setOverlap(int val){overlap = val;}
+    void setAverages(int val){averages = val;}
+    void setSpectrumScale(SpectrumEstimator::Scale val){spectrumScale = val;}
+
+    virtual ScopeConfig* cloneScope(ScopeConfig *spectrumScopeConfig);
+
+    virtual void setGuiConfiguration(Ui::ScopeGadgetOptionsPage *options_page);
+
+    virtual void loadConfiguration(ScopeGadgetWidget *scopeGadgetWidget);
+    virtual void preparePlot(ScopeGadgetWidget *);
+    void configureAxes(ScopeGadgetWidget *);
+
+private:
+    int fftSize;    //Samples per FFT
+    int overlap;    //Percentage of each FFT frame shared with the next one
+    int averages;   //Number of spectra averaged together
+    SpectrumEstimator::Scale spectrumScale;
+
+    QList<Plot2dCurveConfiguration*> m_spectrumSourceConfigs;
+};
+
+#endif // SPECTRUMSCOPECONFIG_H
@@ -0,0 +1,285 @@
+/**
+ ******************************************************************************
+ *
+ * @file       windowstatistics.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sliding window statistics for the scope math functions
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "scopes2d/windowstatistics.h"
+
+#include <QtNumeric>
+
+#include <math.h>
+
+
+WindowStatistics::WindowStatistics() :
+    m_statistic(NONE),
+    m_windowSize(1),
+    m_quantile(0.5)
+{
+    clear();
+}
+
+
+/**
+ * @brief WindowStatistics::fromMathFunction Resolves the math function chosen in the scope configuration
+ */
+WindowStatistics::Statistic WindowStatistics::fromMathFunction(const QString &mathFunction, double *quantile)
+{
+    *quantile = 0.5;
+
+    if (mathFunction == "Boxcar average")
+        return MEAN;
+    if (mathFunction == "Standard deviation")
+        return STANDARD_DEVIATION;
+    if (mathFunction == "Median")
+        return QUANTILE;
+    if (mathFunction == "5th percentile") {
+        *quantile = 0.05;
+        return QUANTILE;
+    }
+    if (mathFunction == "95th percentile") {
+        *quantile = 0.95;
+        return QUANTILE;
+    }
+
+    return NONE;
+}
+
+
+void WindowStatistics::setStatistic(Statistic statistic, double quantile)
+{
+    m_statistic = statistic;
+    m_quantile = qMin(qMax(quantile, 0.0), 1.0);
+    clear();
+}
+
+
+void WindowStatistics::setWindow(int samples)
+{
+    samples = qMax(samples, 1);
+    if (samples == m_windowSize)
+        return;
+
+    m_windowSize = samples;
+    clear();
+}
+
+
+double WindowStatistics::append(double value)
+{
+    // A NaN would never leave the heaps or the running sums
+    if (m_statistic == NONE || qIsNaN(value))
+        return value;
+
+    m_window.append(value);
+    if (m_statistic == QUANTILE)
+        addQuantile(value);
+    else
+        addMoments(value);
+
+    if (m_window.size() > m_windowSize) {
+        double oldest = m_window.first();
+        m_window.removeFirst();
+        if (m_statistic == QUANTILE)
+            removeQuantile(oldest);
+        else
+            removeMoments(oldest);
+    }
+
+    switch (m_statistic) {
+    case MEAN:
+        return m_mean;
+    case STANDARD_DEVIATION:
+        // Sample standard deviation, with Bessel's correction
+        return m_count > 1 ? sqrt(m_m2 / (m_count - 1)) : 0;
+    case QUANTILE:
+        rebalanceQuantile();
+        return quantileValue();
+    case NONE:
+        break;
+    }
+
+    return value;
+}
+
+
+void WindowStatistics::clear()
+{
+    m_window.clear();
+
+    m_count = 0;
+    m_mean = 0;
+    m_m2 = 0;
+    m_sinceResync = 0;
+
+    m_lower = std::priority_queue<double>();
+    m_upper = std::priority_queue<double, std::vector<double>, std::greater<double> >();
+    m_removed.clear();
+    m_lowerCount = 0;
+    m_upperCount = 0;
+}
+
+
+void WindowStatistics::addMoments(double value)
+{
+    m_count++;
+    double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+}
+
+
+void WindowStatistics::removeMoments(double value)
+{
+    m_count--;
+    if (m_count == 0) {
+        m_mean = 0;
+        m_m2 = 0;
+        return;
+    }
+
+    double oldMean = m_mean;
+    m_mean -= (value - oldMean) / m_count;
+    m_m2 -= (value - oldMean) * (value - m_mean);
+    if (m_m2 < 0)
+        m_m2 = 0;
+
+    // Once per window length, start again from the samples themselves
+    if (++m_sinceResync >= m_windowSize)
+        resyncMoments();
+}
+
+
+void WindowStatistics::resyncMoments()
+{
+    m_sinceResync = 0;
+
+    double sum = 0;
+    for (int i = 0; i < m_window.size(); i++)
+        sum += m_window.at(i);
+    m_count = m_window.size();
+    m_mean = m_count > 0 ? sum / m_count : 0;
+
+    m_m2 = 0;
+    for (int i = 0; i < m_window.size(); i++) {
+        double delta = m_window.at(i) - m_mean;
+        m_m2 += delta * delta;
+    }
+}
+
+
+/**
+ * @brief WindowStatistics::addQuantile Everything in m_lower is <= everything in m_upper
+ */
+void WindowStatistics::addQuantile(double value)
+{
+    if (m_lowerCount == 0 || value <= m_lower.top()) {
+        m_lower.push(value);
+        m_lowerCount++;
+    } else {
+        m_upper.push(value);
+        m_upperCount++;
+    }
+}
+
+
+void WindowStatistics::removeQuantile(double value)
+{
+    // The tops are always live samples, which tells which heap holds this one
+    if (m_lowerCount > 0 && value <= m_lower.top())
+        m_lowerCount--;
+    else
+        m_upperCount--;
+    m_removed[value]++;
+
+    pruneQuantile();
+
+    // Don't let samples that already left pile up under the tops forever
+    if (m_lower.size() + m_upper.size() > 2 * (size_t)m_windowSize + 16)
+        rebuildQuantile();
+}
+
+
+/**
+ * @brief WindowStatistics::rebalanceQuantile Moves samples across so that the
+ * top of m_lower is the requested quantile (lower nearest rank)
+ */
+void WindowStatistics::rebalanceQuantile()
+{
+    int count = m_lowerCount + m_upperCount;
+    int target = count > 0 ? (int)floor(m_quantile * (count - 1)) + 1 : 0;
+
+    while (m_lowerCount > target) {
+        m_upper.push(m_lower.top());
+        m_lower.pop();
+        m_lowerCount--;
+        m_upperCount++;
+        pruneQuantile();
+    }
+    while (m_lowerCount < target) {
+        m_lower.push(m_upper.top());
+        m_upper.pop();
+        m_upperCount--;
+        m_lowerCount++;
+        pruneQuantile();
+    }
+}
+
+
+void WindowStatistics::pruneQuantile()
+{
+    QHash<double, int>::iterator it;
+
+    while (!m_lower.empty() && (it = m_removed.find(m_lower.top())) != m_removed.end()) {
+        if (--it.value() == 0)
+            m_removed.erase(it);
+        m_lower.pop();
+    }
+    while (!m_upper.empty() && (it = m_removed.find(m_upper.top())) != m_removed.end()) {
+        if (--it.value() == 0)
+            m_removed.erase(it);
+        m_upper.pop();
+    }
+}
+
+
+void WindowStatistics::rebuildQuantile()
+{
+    m_lower = std::priority_queue<double>();
+    m_upper = std::priority_queue<double, std::vector<double>, std::greater<double> >();
+    m_removed.clear();
+    m_lowerCount = 0;
+    m_upperCount = 0;
+
+    for (int i = 0; i < m_window.size(); i++) {
+        addQuantile(m_window.at(i));
+        rebalanceQuantile();
+    }
+}
+
+
+double WindowStatistics::quantileValue() const
+{
+    return m_lowerCount > 0 ? m_lower.top() : 0;
+}
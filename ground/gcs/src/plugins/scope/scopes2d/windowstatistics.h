@@ -0,0 +1,109 @@
+/**
+ ******************************************************************************
+ *
+ * @file       windowstatistics.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup ScopePlugin Scope Gadget Plugin
+ * @{
+ * @brief Sliding window statistics for the scope math functions
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef WINDOWSTATISTICS_H
+#define WINDOWSTATISTICS_H
+
+#include "scopes2d/plotseriesbuffer.h"
+
+#include <QHash>
+#include <QString>
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+
+/**
+ * @brief The WindowStatistics class Computes one statistic over the last
+ * N samples, updating it as each sample comes in and the oldest one leaves.
+ *
+ * The mean and standard deviation use Welford's running update, O(1) per
+ * sample. They are recomputed from the window once every N samples so that
+ * rounding errors can't accumulate. Quantiles (the median and percentiles)
+ * use a max-heap of the lower part of the window and a min-heap of the
+ * upper part, O(log N) per sample. Samples leaving the window are only
+ * dropped from a heap when they reach its top.
+ */
+class WindowStatistics
+{
+public:
+    enum Statistic {
+        NONE,
+        MEAN,
+        STANDARD_DEVIATION,
+        QUANTILE
+    };
+
+    WindowStatistics();
+
+    /*!
+      \brief Maps a scope math function name to a statistic
+      \param quantile Where the quantile for QUANTILE functions is written
+      */
+    static Statistic fromMathFunction(const QString &mathFunction, double *quantile);
+
+    void setStatistic(Statistic statistic, double quantile = 0.5);
+    void setWindow(int samples);
+    Statistic statistic() const { return m_statistic; }
+
+    //! Adds a sample and returns the statistic over the window that ends with it
+    double append(double value);
+    void clear();
+
+private:
+    void addMoments(double value);
+    void removeMoments(double value);
+    void resyncMoments();
+
+    void addQuantile(double value);
+    void removeQuantile(double value);
+    void rebalanceQuantile();
+    void pruneQuantile();
+    void rebuildQuantile();
+    double quantileValue() const;
+
+    Statistic m_statistic;
+    int m_windowSize;
+    RingBuffer<double> m_window;
+
+    // Moments of the window
+    int m_count;
+    double m_mean;
+    double m_m2;
+    int m_sinceResync;
+
+    // Quantile of the window
+    double m_quantile;
+    std::priority_queue<double> m_lower;
+    std::priority_queue<double, std::vector<double>, std::greater<double> > m_upper;
+    QHash<double, int> m_removed; //!< Samples that left the window but are still in a heap
+    int m_lowerCount;   //!< Samples of the window in m_lower
+    int m_upperCount;   //!< Samples of the window in m_upper
+};
+
+#endif // WINDOWSTATISTICS_H
@@ -135,7 +135,7 @@ bool SpectrogramData::append(UAVObject* multiObj)
     QDateTime NOW = QDateTime::currentDateTime(); //TODO: Upgrade this to show UAVO time and not system time
 
     // Check to make sure it's the correct UAVO
-    if (uavObjectName == multiObj->getName()) {
+    if (multiObj->getObjID() == uavObjectId) {
 
         // Only run on UAVOs that have multiple instances
         if (multiObj->isSingleInstance())
@@ -151,7 +151,7 @@ bool SpectrogramData::append(UAVObject* multiObj)
 
 
         // Get list of object instances
-        QVector<UAVObject*> list = objManager->getObjectInstancesVector(multiObj->getName());
+        QVector<UAVObject*> list = objManager->getObjectInstancesVector(uavObjectId);
 
         // Remove a row's worth of data.
         unsigned int spectrogramWidth = list.size();
@@ -168,15 +168,15 @@ bool SpectrogramData::append(UAVObject* multiObj)
         QVector<double> values;
 
         timeDataHistory->append(NOW.toTime_t() + NOW.time().msec() / 1000.0);
-        UAVObjectField* multiField =  multiObj->getField(uavFieldName);
+        UAVObjectField* multiField = fieldOf(multiObj);
         Q_ASSERT(multiField);
         if (multiField ) {
 
             // Get the field of interest
             foreach (UAVObject *obj, list) {
-                UAVObjectField* field =  obj->getField(uavFieldName);
+                UAVObjectField* field = fieldOf(obj);
 
-                double currentValue = valueAsDouble(obj, field, haveSubField, uavSubFieldName) * pow(10, scalePower);
+                double currentValue = valueAsDouble(field) * pow(10, scalePower);
 
                 double vecVal = currentValue;
                 //Normally some math would go here, modifying vecVal before appending it to values
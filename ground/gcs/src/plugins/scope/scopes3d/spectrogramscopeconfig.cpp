@@ -247,6 +247,10 @@ void SpectrogramScopeConfig::loadConfiguration(ScopeGadgetWidget *scopeGadgetWid
         return;
     }
 
+    // Resolve the field now, so that new data doesn't have to be looked up by name
+    if (!spectrogramData->resolveField(obj))
+        qDebug() << "Field " << spectrogramData->getUavoFieldName() << " is missing from " << spectrogramData->getUavoName();
+
     //Get the units
     QString units = getUavObjectFieldUnits(spectrogramData->getUavoName(), spectrogramData->getUavoFieldName());
 
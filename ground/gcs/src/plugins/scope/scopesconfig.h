@@ -57,6 +57,8 @@ class ScopeConfig : public QObject
 {
     Q_OBJECT
 public:
+    ScopeConfig() : m_openGL(false) {}
+
     virtual int getScopeDimensions() = 0;
     virtual void saveConfiguration(QSettings *qSettings) = 0;
     virtual int getScopeType() = 0;
@@ -65,6 +67,8 @@ public:
 
     int getRefreshInterval(){return m_refreshInterval;}
     void setRefreshInterval(int val){m_refreshInterval = val;}
+    bool getOpenGL(){return m_openGL;}
+    void setOpenGL(bool val){m_openGL = val;}
 
     virtual void preparePlot(ScopeGadgetWidget *) = 0;
     virtual ScopeConfig* cloneScope(ScopeConfig *histogramSourceConfigs) = 0;
@@ -72,6 +76,7 @@ public:
 protected:
     int m_refreshInterval; //The interval to replot the curve widget. The data buffer is refresh as the data comes in.
     PlotDimensions m_plotDimensions;
+    bool m_openGL; //Paint the plot on an OpenGL canvas
 
     QMutex mutex;
     QString getUavObjectFieldUnits(QString uavObjectName, QString uavObjectFieldName)
@@ -56,8 +56,11 @@ SystemHealthGadgetWidget::SystemHealthGadgetWidget(QWidget *parent) : QGraphicsV
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
     UAVObjectManager *objManager = pm->getObject<UAVObjectManager>();
 
+    // Redrawing the scene is expensive, so repaint at most once per frame
     SystemAlarms* obj = SystemAlarms::GetInstance(objManager);
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(updateAlarms(UAVObject*)));
+    UAVObjectSubscription* sub = objManager->subscribe(QList<UAVObject*>() << obj,
+                                                       UAVObjectSubscription::DEFAULT_RATE_HZ, this);
+    connect(sub, SIGNAL(objectsUpdated(QList<UAVObject*>)), this, SLOT(alarmsUpdated(QList<UAVObject*>)));
 
     // Listen to autopilot connection events
     TelemetryManager* telMngr = pm->getObject<TelemetryManager>();
@@ -83,41 +86,65 @@ void SystemHealthGadgetWidget::onAutopilotDisconnect()
     nolink->setVisible(true);
 }
 
+void SystemHealthGadgetWidget::alarmsUpdated(const QList<UAVObject*> &objs)
+{
+    updateAlarms(objs.first());
+}
+
+/**
+  * Remove the alarm indicators, they are created again on the next update
+  */
+void SystemHealthGadgetWidget::clearAlarms()
+{
+    foreach (QGraphicsSvgItem *item, alarmItems) {
+        delete item;
+    }
+    alarmItems.clear();
+    alarmValues.clear();
+}
+
 void SystemHealthGadgetWidget::updateAlarms(UAVObject* systemAlarm)
 {
     static QList<QString> warningClean;
-    // This code does not know anything about alarms beforehand, and
-    // I found no efficient way to locate items inside the scene by
-    // name, so it's just as simple to reset the scene:
-    // And add the one with the right name.
-    QGraphicsScene *m_scene = scene();
-    foreach ( QGraphicsItem* item ,background->childItems()){
-        m_scene->removeItem(item);
-        delete item; // removeItem does _not_ delete the item.
-    }
 
     UAVObjectField *field = systemAlarm->getField("Alarm");
     Q_ASSERT(field);
     if (field == NULL)
         return;
 
+    // SystemAlarms is sent often while the alarms rarely change, so only
+    // the indicators of the alarms that changed are touched. Each keeps
+    // its rendering cached, so the others are just composited again.
     for (uint i = 0; i < field->getNumElements(); ++i) {
         QString element = field->getElementNames()[i];
         QString value = field->getValue(i).toString();
+
+        QMap<QString, QString>::iterator last = alarmValues.find(element);
+        if (last != alarmValues.end() && *last == value)
+            continue;
+        alarmValues.insert(element, value);
+
         if (m_renderer->elementExists(element)) {
-            QMatrix blockMatrix = m_renderer->matrixForElement(element);
-            qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
-            qreal startY = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).y();
             QString element2 = element + "-" + value;
+            QGraphicsSvgItem *ind = alarmItems.value(element);
             if (m_renderer->elementExists(element2)) {
-                QGraphicsSvgItem *ind = new QGraphicsSvgItem();
-                ind->setSharedRenderer(m_renderer);
+                if (ind == NULL) {
+                    QMatrix blockMatrix = m_renderer->matrixForElement(element);
+                    qreal startX = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).x();
+                    qreal startY = blockMatrix.mapRect(m_renderer->boundsOnElement(element)).y();
+                    ind = new QGraphicsSvgItem();
+                    ind->setSharedRenderer(m_renderer);
+                    ind->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+                    ind->setParentItem(background);
+                    QTransform matrix;
+                    matrix.translate(startX,startY);
+                    ind->setTransform(matrix,false);
+                    alarmItems.insert(element, ind);
+                }
                 ind->setElementId(element2);
-                ind->setParentItem(background);
-                QTransform matrix;
-                matrix.translate(startX,startY);
-                ind->setTransform(matrix,false);
             } else {
+                delete ind;
+                alarmItems.remove(element);
                 if ((value.compare("Uninitialised") != 0) && !warningClean.contains(element2))
                 {
                     qDebug() << "[SystemHealth] Warning: The SystemHealth SVG does not contain a graphical element for the " << element2 << " alarm.";
@@ -141,16 +168,19 @@ void SystemHealthGadgetWidget::setSystemFile(QString dfn)
 {
     setBackgroundBrush(QBrush(Utils::StyleHelper::baseColor()));
    if (QFile::exists(dfn)) {
+       clearAlarms();
        m_renderer->load(dfn);
        if(m_renderer->isValid()) {
            fgenabled = false;
            background->setSharedRenderer(m_renderer);
            background->setElementId("background");
+           background->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
 
            if (m_renderer->elementExists("foreground")) {
                foreground->setSharedRenderer(m_renderer);
                foreground->setElementId("foreground");
                foreground->setZValue(99);
+               foreground->setCacheMode(QGraphicsItem::DeviceCoordinateCache);
                fgenabled = true;
            }
            if (m_renderer->elementExists("nolink")) {
@@ -56,7 +56,7 @@ protected:
    void mousePressEvent ( QMouseEvent * event );
 
 private slots:
-   void updateAlarms(UAVObject *systemAlarm); // Called by the systemalarms UAVObject
+   void alarmsUpdated(const QList<UAVObject*> &objs); // Called by the systemalarms subscription
    void onAutopilotConnect();
    void onAutopilotDisconnect();
 
@@ -69,8 +69,14 @@ private:
                    // Simple flag to skip rendering if the
    bool fgenabled; // layer does not exist.
 
+   //! Indicator and last value of each alarm, by element name
+   QMap<QString, QGraphicsSvgItem*> alarmItems;
+   QMap<QString, QString> alarmValues;
+
    void showAlarmDescriptionForItemId(const QString itemId, const QPoint& location);
    void showAllAlarmDescriptions(const QPoint &location);
    QString getAlarmDescriptionFileName(const QString itemId);
+   void updateAlarms(UAVObject *systemAlarm);
+   void clearAlarms();
 };
 #endif /* SYSTEMHEALTHGADGETWIDGET_H_ */
@@ -45,6 +45,9 @@
 #include <QPushButton>
 #include <QFileInfo>
 #include <QInputDialog>
+#include <QMultiMap>
+#include <QBrush>
+#include <QColor>
 
 #include "extensionsystem/pluginmanager.h"
 #include "utils/xmlconfig.h"
@@ -57,6 +60,14 @@
 #include <coreplugin/generalsettings.h>
 #include <QMenu>
 
+// UAVTalk framing of an object update: sync, type, size, object ID and
+// checksum, plus the instance ID of multi instance objects
+static const int UAVTALK_FRAME_OVERHEAD = 9;
+static const int UAVTALK_INSTID_LENGTH = 2;
+
+// Fitting a schedule to the link leaves room for acks and retransmissions
+static const double LINK_FIT_MARGIN = 0.9;
+
 TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent) : QWidget(parent)
 {
     m_telemetryeditor = new Ui_TelemetryScheduler();
@@ -97,6 +108,7 @@ TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent)
     connect(m_telemetryeditor->bnSaveSchedule, SIGNAL(clicked()), this, SLOT(saveSchedule()));
     connect(m_telemetryeditor->bnAddTelemetryColumn, SIGNAL(clicked()), this, SLOT(addTelemetryColumn()));
     connect(m_telemetryeditor->bnRemoveTelemetryColumn, SIGNAL(clicked()), this, SLOT(removeTelemetryColumn()));
+    connect(m_telemetryeditor->bnFitToLink, SIGNAL(clicked()), this, SLOT(fitScheduleToLink()));
     connect(schedulerModel, SIGNAL(itemChanged(QStandardItem *)), this, SLOT(dataModel_itemChanged(QStandardItem *)));
     connect(telemetryScheduleView->horizontalHeader(), SIGNAL(sectionDoubleClicked(int)), this, SLOT(changeHorizontalHeader(int)));
     connect(telemetryScheduleView->verticalHeader(), SIGNAL(sectionDoubleClicked(int)), this, SLOT(changeVerticalHeader(int)));
@@ -174,6 +186,17 @@ TelemetrySchedulerGadgetWidget::TelemetrySchedulerGadgetWidget(QWidget *parent)
     // Populate combobox
     m_telemetryeditor->cmbScheduleList->addItem("");
     m_telemetryeditor->cmbScheduleList->addItems(columnHeaders);
+
+    // Links to check the schedules against, with their capacity in bytes/s.
+    // Serial links take 10 bits per byte, the half duplex radios share their
+    // air rate between both directions.
+    m_telemetryeditor->cmbLinkSpeed->addItem(tr("Not set"), 0);
+    foreach (int baud, QList<int>() << 9600 << 19200 << 38400 << 57600 << 115200)
+        m_telemetryeditor->cmbLinkSpeed->addItem(tr("Serial %1 baud").arg(baud), baud / 10);
+    foreach (int bps, QList<int>() << 9600 << 19200 << 32000 << 64000 << 100000 << 192000)
+        m_telemetryeditor->cmbLinkSpeed->addItem(tr("RFM22B %1 bps").arg(bps), bps / 16);
+    connect(m_telemetryeditor->cmbLinkSpeed, SIGNAL(currentIndexChanged(int)), this, SLOT(onLinkSpeedChanged(int)));
+
     onHideNotPresent(true);
 }
 
@@ -245,35 +268,97 @@ void TelemetrySchedulerGadgetWidget::dataModel_itemChanged(QStandardItem *item)
 void TelemetrySchedulerGadgetWidget::dataModel_itemChanged(int col)
 {
     // Update the speed estimate
-    double bandwidthRequired_bps = 0;
+    double bandwidthRequired_Bps = 0;
     for (int i=1; i<schedulerModel->rowCount(); i++){
-        // Get UAVO size
-        QString uavObjectName = schedulerModel->verticalHeaderItem(i)->text();
-        UAVObject *obj = objManager->getObject(uavObjectName);
-        UAVDataObject *dobj = dynamic_cast<UAVDataObject*>(obj);
-        if(dobj && m_telemetryeditor->hideNotPresent->isChecked() && (!dobj->getIsPresentOnHardware()))
+        if (!isRowCounted(i))
             continue;
-        Q_ASSERT(obj);
-        quint16 size = obj->getNumBytes();
 
-        // Get UAVO speed
-        QModelIndex index = schedulerModel->index(i, col, QModelIndex());
-        double updatePeriod_s;
-        if (schedulerModel->data(index).isValid() && stripMs(schedulerModel->data(index)) >= 0)
-            updatePeriod_s = stripMs(schedulerModel->data(index)) / 1000.0;
-        else
-            updatePeriod_s = defaultMdata.value(obj->getName().append("Meta")).flightTelemetryUpdatePeriod / 1000.0;
+        int updatePeriod_ms = rowUpdatePeriod_ms(i, col);
+        if (updatePeriod_ms > 0)
+            bandwidthRequired_Bps += rowUpdateBytes(i) * 1000.0 / updatePeriod_ms;
+    }
 
-        double updateFrequency_Hz = updatePeriod_s > 0 ? 1.0 / updatePeriod_s : 0;
+    QStandardItemModel *bandwidthModel = telemetryScheduleView->getFrozenModel();
+    QModelIndex index = bandwidthModel->index(0, col, QModelIndex());
+
+    // Compare it to the link, if one is set
+    double capacity_Bps = linkCapacity_Bps();
+    if (capacity_Bps > 0) {
+        double usage = bandwidthRequired_Bps / capacity_Bps;
+        bandwidthModel->setData(index, QString("%1B/s (%2%)").arg(lround(bandwidthRequired_Bps)).arg(lround(usage * 100)));
+
+        QColor color = QColor(Qt::green).lighter(160);
+        if (usage > 1)
+            color = QColor(Qt::red).lighter(160);
+        else if (usage > LINK_FIT_MARGIN)
+            color = QColor(Qt::yellow).lighter(130);
+        bandwidthModel->setData(index, QBrush(color), Qt::BackgroundRole);
+    } else {
+        bandwidthModel->setData(index, QString("%1B/s").arg(lround(bandwidthRequired_Bps)));
+        bandwidthModel->setData(index, QVariant(), Qt::BackgroundRole);
+    }
+}
 
-        // Accumulate bandwidth
-        bandwidthRequired_bps += updateFrequency_Hz * size;
+/**
+ * @brief Recalculates the bandwidth of all columns against the newly selected link
+ */
+void TelemetrySchedulerGadgetWidget::onLinkSpeedChanged(int)
+{
+    for(int x = 0; x < schedulerModel->columnCount(); ++x)
+    {
+        dataModel_itemChanged(x);
+    }
+}
+
+/**
+ * @brief Fits the selected schedule in the link. The link is shared out by
+ * max-min fairness: an object that needs less than an equal share of the
+ * bandwidth left keeps its period, the others are each slowed down to an
+ * equal share. So the small status objects keep their rate, and it is the
+ * large and fast streams that give way.
+ */
+void TelemetrySchedulerGadgetWidget::fitScheduleToLink()
+{
+    double capacity_Bps = linkCapacity_Bps() * LINK_FIT_MARGIN;
+    if (capacity_Bps <= 0)
+    {
+        QMessageBox::warning(this, tr("No link selected"), tr("Please select the telemetry link and retry"), QMessageBox::Ok);
+        return;
+    }
+
+    int col = selectedScheduleColumn();
+    if (col < 2)
+    {
+        QMessageBox::warning(this, tr("No Schedule selected"), tr("Please select a schedule other than Default and Current on the dropbox and retry"), QMessageBox::Ok);
+        return;
     }
 
-    QModelIndex index = telemetryScheduleView->getFrozenModel()->index(0, col, QModelIndex());
-    telemetryScheduleView->getFrozenModel()->setData(index, QString("%1B/s").arg(lround(bandwidthRequired_bps)));
+    // Order the periodic objects by the bandwidth they take
+    QMultiMap<double, int> rowsByBandwidth;
+    for (int i=1; i<schedulerModel->rowCount(); i++){
+        if (!isRowCounted(i))
+            continue;
+
+        int updatePeriod_ms = rowUpdatePeriod_ms(i, col);
+        if (updatePeriod_ms > 0)
+            rowsByBandwidth.insert(rowUpdateBytes(i) * 1000.0 / updatePeriod_ms, i);
+    }
+
+    double bandwidthLeft_Bps = capacity_Bps;
+    int rowsLeft = rowsByBandwidth.size();
+    for (QMultiMap<double, int>::const_iterator it = rowsByBandwidth.constBegin(); it != rowsByBandwidth.constEnd(); ++it, --rowsLeft)
+    {
+        double share_Bps = bandwidthLeft_Bps / rowsLeft;
+        if (it.key() <= share_Bps) {
+            bandwidthLeft_Bps -= it.key();
+            continue;
+        }
 
-    // TODO: Set color as function of available speed
+        int updatePeriod_ms = qMin(65535, (int)ceil(rowUpdateBytes(it.value()) * 1000.0 / share_Bps));
+        QModelIndex index = schedulerModel->index(it.value(), col, QModelIndex());
+        schedulerModel->setData(index, QString("%1ms").arg(updatePeriod_ms));
+        bandwidthLeft_Bps -= share_Bps;
+    }
 }
 
 
@@ -819,6 +904,73 @@ int TelemetrySchedulerGadgetWidget::stripMs(QVariant rate_ms)
     return rate_ms.toString().replace(QString("ms"), QString("")).toUInt();
 }
 
+/**
+ * @brief TelemetrySchedulerGadgetWidget::selectedScheduleColumn
+ * @return the column of the schedule selected in the dropbox, -1 if none is
+ */
+int TelemetrySchedulerGadgetWidget::selectedScheduleColumn()
+{
+    if (m_telemetryeditor->cmbScheduleList->currentText().isEmpty())
+        return -1;
+
+    for (int j=0; j<schedulerModel->columnCount(); j++){
+        if (schedulerModel->horizontalHeaderItem(j)->text() == m_telemetryeditor->cmbScheduleList->currentText())
+            return j;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief TelemetrySchedulerGadgetWidget::isRowCounted
+ * @return false if the object of the row is hidden because the board does not have it
+ */
+bool TelemetrySchedulerGadgetWidget::isRowCounted(int row)
+{
+    UAVObject *obj = objManager->getObject(schedulerModel->verticalHeaderItem(row)->text());
+    UAVDataObject *dobj = dynamic_cast<UAVDataObject*>(obj);
+    return !(dobj && m_telemetryeditor->hideNotPresent->isChecked() && (!dobj->getIsPresentOnHardware()));
+}
+
+/**
+ * @brief TelemetrySchedulerGadgetWidget::rowUpdateBytes
+ * @return the bytes sent over the link for one update of all instances of the object of a row
+ */
+int TelemetrySchedulerGadgetWidget::rowUpdateBytes(int row)
+{
+    UAVObject *obj = objManager->getObject(schedulerModel->verticalHeaderItem(row)->text());
+    Q_ASSERT(obj);
+
+    int frameBytes = obj->getNumBytes() + UAVTALK_FRAME_OVERHEAD;
+    if (!obj->isSingleInstance())
+        frameBytes += UAVTALK_INSTID_LENGTH;
+
+    return frameBytes * qMax(1, objManager->getNumInstances(obj->getObjID()));
+}
+
+/**
+ * @brief TelemetrySchedulerGadgetWidget::rowUpdatePeriod_ms
+ * @return the update period of a row in a column, the default one if the cell is blank
+ */
+int TelemetrySchedulerGadgetWidget::rowUpdatePeriod_ms(int row, int col)
+{
+    QModelIndex index = schedulerModel->index(row, col, QModelIndex());
+    if (schedulerModel->data(index).isValid() && stripMs(schedulerModel->data(index)) >= 0)
+        return stripMs(schedulerModel->data(index));
+
+    QString uavObjectName = schedulerModel->verticalHeaderItem(row)->text();
+    return defaultMdata.value(uavObjectName.append("Meta")).flightTelemetryUpdatePeriod;
+}
+
+/**
+ * @brief TelemetrySchedulerGadgetWidget::linkCapacity_Bps
+ * @return the capacity of the selected link in bytes/s, 0 if none is selected
+ */
+double TelemetrySchedulerGadgetWidget::linkCapacity_Bps()
+{
+    return m_telemetryeditor->cmbLinkSpeed->itemData(m_telemetryeditor->cmbLinkSpeed->currentIndex()).toDouble();
+}
+
 /**
  * @brief TelemetrySchedulerGadgetWidget::getObjectManager Utility function to get a pointer to the object manager
  * @return pointer to the UAVObjectManager
@@ -76,8 +76,16 @@ private slots:
     void customMenuRequested(QPoint pos);
     void uavoPresentOnHardwareChanged(UAVDataObject*);
     void onHideNotPresent(bool);
+    void onLinkSpeedChanged(int);
+    //! Slow down the selected schedule until it fits in the link
+    void fitScheduleToLink();
 private:
     int stripMs(QVariant rate_ms);
+    int selectedScheduleColumn();
+    bool isRowCounted(int row);
+    int rowUpdateBytes(int row);
+    int rowUpdatePeriod_ms(int row, int col);
+    double linkCapacity_Bps();
     QList<UAVMetaObject *> metaObjectsToSave;
     void importTelemetryConfiguration(const QString& fileName);
     UAVObjectUtilManager *getObjectUtilManager();
@@ -89,6 +89,9 @@ public:
         return m_enumOptions.at(index);
     }
     void apply() {
+        // Only edited values are written back, the others may be out of date
+        if (!changed())
+            return;
         int value = data(dataColumn).toInt();
         if (value == -1) {
             qDebug() << "Warning, UAVO browser field is outside range. This should never happen!";
@@ -211,6 +214,8 @@ public:
         TreeItem::setData(value, column);
     }
     void apply() {
+        if (!changed())
+            return;
         switch (m_field->getType()) {
         case UAVObjectField::INT8:
         case UAVObjectField::INT16:
@@ -270,6 +275,8 @@ public:
         TreeItem::setData(value, column);
     }
     void apply() {
+        if (!changed())
+            return;
         m_field->setValue(data(dataColumn).toDouble(), m_index);
         setChanged(false);
     }
@@ -53,10 +53,10 @@ bool HighLightManager::add(TreeItem *itemToAdd)
     // Lock to ensure thread safety
     QMutexLocker locker(&m_listMutex);
 
-    // Check so that the item isn't already in the list
+    // Check so that the item isn't already in the set
     if(!m_itemsList.contains(itemToAdd))
     {
-        m_itemsList.append(itemToAdd);
+        m_itemsList.insert(itemToAdd);
         return true;
     }
     return false;
@@ -72,7 +72,7 @@ bool HighLightManager::remove(TreeItem *itemToRemove)
     QMutexLocker locker(&m_listMutex);
 
     // Remove item and return result
-    return m_itemsList.removeOne(itemToRemove);
+    return m_itemsList.remove(itemToRemove);
 }
 
 /*
@@ -86,8 +86,8 @@ void HighLightManager::checkItemsExpired()
     // Lock to ensure thread safety
     QMutexLocker locker(&m_listMutex);
 
-    // Get a mutable iterator for the list
-    QMutableLinkedListIterator<TreeItem*> iter(m_itemsList);
+    // Get a mutable iterator for the set
+    QMutableSetIterator<TreeItem*> iter(m_itemsList);
 
     // Loop over all items, check if they expired.
     while(iter.hasNext())
@@ -105,6 +105,7 @@ void HighLightManager::checkItemsExpired()
 }
 
 int TreeItem::m_highlightTimeMs = 500;
+bool TreeItem::m_quietUpdate = false;
 QTime* TreeItem::m_currentTime = NULL;
 
 TreeItem::TreeItem(const QList<QVariant> &data, TreeItem *parent) :
@@ -114,7 +115,8 @@ TreeItem::TreeItem(const QList<QVariant> &data, TreeItem *parent) :
         m_parent(parent),
         m_highlight(false),
         m_changed(false),
-        m_updated(false)
+        m_updated(false),
+        m_expanded(false)
 {
 }
 
@@ -124,7 +126,8 @@ TreeItem::TreeItem(const QVariant &data, TreeItem *parent) :
         m_parent(parent),
         m_highlight(false),
         m_changed(false),
-        m_updated(false)
+        m_updated(false),
+        m_expanded(false)
 {
     m_data << data << "" << "";
 }
@@ -186,6 +189,9 @@ void TreeItem::setData(QVariant value, int column)
 }
 
 void TreeItem::update() {
+    // Hidden children catch up in refresh() when they are shown
+    if (!m_expanded)
+        return;
     foreach(TreeItem *child, treeChildren())
         child->update();
 }
@@ -195,12 +201,38 @@ void TreeItem::apply() {
         child->apply();
 }
 
+/*
+ * Whether the item is in a visible row, that is all its parents are expanded.
+ */
+bool TreeItem::isShown() const
+{
+    // The root is never shown itself, its children always are
+    for (TreeItem *item = m_parent; item && item->m_parent; item = item->m_parent) {
+        if (!item->m_expanded)
+            return false;
+    }
+    return true;
+}
+
+/*
+ * Brings the values below an item up to date without highlighting them,
+ * as they changed while nobody could see them.
+ */
+void TreeItem::refresh()
+{
+    m_quietUpdate = true;
+    update();
+    m_quietUpdate = false;
+}
+
 /*
  * Called after a value has changed to trigger highlightning of tree item.
  */
 void TreeItem::setHighlight(bool highlight) {
-    m_highlight = highlight;
     m_changed = false;
+    if (m_quietUpdate)
+        return;
+    m_highlight = highlight;
     if (highlight) {
         // Update the expires timestamp
         if (m_currentTime != NULL)
@@ -34,7 +34,7 @@
 #include "uavmetaobject.h"
 #include "uavobjectfield.h"
 #include <QtCore/QList>
-#include <QtCore/QLinkedList>
+#include <QtCore/QSet>
 #include <QtCore/QMap>
 #include <QtCore/QVariant>
 #include <QtCore/QTime>
@@ -81,8 +81,8 @@ private:
     // The timer checking highlight expiration.
     QTimer m_expirationTimer;
 
-    // The list holding all items due to be updated.
-    QLinkedList<TreeItem*> m_itemsList;
+    // The set holding all items due to be updated.
+    QSet<TreeItem*> m_itemsList;
 
     //Mutex to lock when accessing list.
     QMutex m_listMutex;
@@ -133,6 +133,12 @@ public:
     virtual void update();
     virtual void apply();
 
+    // The children of an item are only kept up to date while it is expanded
+    inline bool isExpanded() const { return m_expanded; }
+    inline void setExpanded(bool expanded) { m_expanded = expanded; }
+    bool isShown() const;
+    void refresh();
+
     inline bool highlighted() { return m_highlight; }
     void setHighlight(bool highlight);
     static void setHighlightTime(int time) { m_highlightTimeMs = time; }
@@ -189,9 +195,12 @@ private:
     bool m_highlight;
     bool m_changed;
     bool m_updated;
+    bool m_expanded;
     QTime m_highlightExpires;
     HighLightManager* m_highlightManager;
     static int m_highlightTimeMs;
+    // Set while refresh() catches up on values, which are not highlighted
+    static bool m_quietUpdate;
     // This is the timestamp to compare with
     static QTime *m_currentTime;
 public:
@@ -235,16 +244,21 @@ class ObjectTreeItem : public TreeItem
 Q_OBJECT
 public:
     ObjectTreeItem(const QList<QVariant> &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_fieldsPending(false) { }
     ObjectTreeItem(const QVariant &data, TreeItem *parent = 0) :
-            TreeItem(data, parent), m_obj(0) { }
+            TreeItem(data, parent), m_obj(0), m_fieldsPending(false) { }
     virtual void setObject(UAVObject *obj) {
         m_obj = obj; setDescription(obj->getDescription());
     }
     inline UAVObject *object() { return m_obj; }
 
+    // The field items are created by the model when the object is first expanded
+    inline bool fieldsPending() { return m_fieldsPending; }
+    inline void setFieldsPending(bool pending) { m_fieldsPending = pending; }
+
 private:
     UAVObject *m_obj;
+    bool m_fieldsPending;
 };
 
 class MetaObjectTreeItem : public ObjectTreeItem
@@ -273,6 +287,8 @@ public:
         }
     }
     virtual void update() {
+        if (!isExpanded())
+            return;
         foreach(TreeItem *child, treeChildren()) {
             MetaObjectTreeItem *metaChild = dynamic_cast<MetaObjectTreeItem*>(child);
             if (!metaChild)
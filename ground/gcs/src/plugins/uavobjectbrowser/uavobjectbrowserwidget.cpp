@@ -86,6 +86,9 @@ void UAVObjectBrowserWidget::onTreeItemExpanded(QModelIndex currentProxyIndex)
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
+    // Creates the fields on the first expansion, and keeps them up to date from now on
+    m_model->setExpanded(currentIndex, true);
+
     //Check if current tree index is the child of the top tree item
     if (top)
     {
@@ -146,6 +149,9 @@ void UAVObjectBrowserWidget::onTreeItemCollapsed(QModelIndex currentProxyIndex)
     TreeItem *item = static_cast<TreeItem*>(currentIndex.internalPointer());
     TopTreeItem *top = dynamic_cast<TopTreeItem*>(item->parent());
 
+    // Hidden fields are no longer updated
+    m_model->setExpanded(currentIndex, false);
+
     //Check if current tree index is the child of the top tree item
     if (top)
     {
@@ -698,22 +704,10 @@ void UAVOBrowserTreeView::onTimeout_updateView()
  */
 void UAVOBrowserTreeView::updateView(const QModelIndex &topLeftProxy, const QModelIndex &bottomRightProxy)
 {
+    Q_UNUSED(topLeftProxy);
     Q_UNUSED(bottomRightProxy);
 
-    // First static_cast from *void to a tree item pointer. This is safe because we know all the indices are tree items
-    QModelIndex topLeftModel = proxyModel->mapToSource(topLeftProxy);
-    TreeItem *treeItemPtr = static_cast<TreeItem*>(topLeftModel.internalPointer());
-
-    // Second, do a dynamic_cast in order to detect if this tree item is a data object
-    DataObjectTreeItem *dataObjectTreeItemPtr = dynamic_cast<DataObjectTreeItem*>(treeItemPtr);
-
-    if (dataObjectTreeItemPtr == NULL) {
-        // Do nothing. These QModelIndices are generated by the highlight manager for individual
-        // UAVO fields, which are both updated when updating that UAVO's branch of the settings or
-        // dynamic data tree.
-        return;
-    }
-
+    // The model reports each frame's changes in batches, any of them is worth a repaint
     m_updateTreeViewFlag = true;
 }
 
@@ -738,6 +732,9 @@ TreeSortFilterProxyModel::TreeSortFilterProxyModel(QObject *p) :
     QSortFilterProxyModel(p)
 {
     Q_ASSERT(p);
+
+    // The filter only looks at the names, changing values can't change what it accepts
+    setDynamicSortFilter(false);
 }
 
 /**
@@ -785,6 +782,15 @@ bool TreeSortFilterProxyModel::hasAcceptedChildren(int source_row, const QModelI
         return false;
     }
 
+    // Fields that are not created yet can match too
+    const UAVObjectTreeModel *model = qobject_cast<const UAVObjectTreeModel*>(sourceModel());
+    if (model) {
+        foreach (QString name, model->pendingFieldNames(item)) {
+            if (name.contains(filterRegExp()))
+                return true;
+        }
+    }
+
     //check if there are children
     int childCount = item.model()->rowCount(item);
     if (childCount == 0)
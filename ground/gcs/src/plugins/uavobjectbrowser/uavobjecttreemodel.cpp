@@ -55,6 +55,7 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     m_hideNotPresent(false),
     m_categorize(true),
     m_highlightManager(NULL),
+    m_updateSubscription(NULL),
     isInitialized(false)
 {
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
@@ -66,6 +67,11 @@ UAVObjectTreeModel::UAVObjectTreeModel(QObject *parent, bool useScientificNotati
     m_currentTimeTimer.start(lrint(fmax(m_recentlyUpdatedTimeout / 10.0f, 10))); // Update the timer 10 times faster than the time
                                                                                  // out. In any case, never go faster than 10ms.
     TreeItem::setHighlightTime(m_recentlyUpdatedTimeout);
+
+    // Changed rows are reported to the view at most once per display frame
+    m_dataChangedTimer.setSingleShot(true);
+    m_dataChangedTimer.setInterval(1000 / UAVObjectSubscription::DEFAULT_RATE_HZ);
+    connect(&m_dataChangedTimer, SIGNAL(timeout()), this, SLOT(emitDataChanged()));
 }
 
 UAVObjectTreeModel::~UAVObjectTreeModel()
@@ -92,11 +98,17 @@ void UAVObjectTreeModel::setupModelData(UAVObjectManager *objManager, bool categ
         disconnect(objManager, SIGNAL(newInstance(UAVObject*)), this, SLOT(newObject(UAVObject*)));
         disconnect(objManager, SIGNAL(instanceRemoved(UAVObject*)), this, SLOT(instanceRemove(UAVObject*)));
         delete m_highlightManager;
+        delete m_updateSubscription;
+        m_changedItems.clear();
         int count = m_rootItem->childCount();
         beginRemoveRows(index(m_rootItem), 0, count);
         delete m_rootItem;
         endRemoveRows();
     }
+    // Collect updates of all objects in the tree and refresh them once per frame
+    m_updateSubscription = objManager->subscribe(QList<UAVObject*>(), UAVObjectSubscription::DEFAULT_RATE_HZ, this);
+    connect(m_updateSubscription, SIGNAL(objectsUpdated(QList<UAVObject*>)), this, SLOT(highlightUpdatedObjects(QList<UAVObject*>)));
+
     // Create highlight manager, let it run every 300 ms.
     m_highlightManager = new HighLightManager(300, &m_currentTime);
     QList<QVariant> rootData;
@@ -144,6 +156,8 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
     if(!dobj)
         return;
 
+    m_updateSubscription->removeObject(obj);
+
     TopTreeItem *root = dobj->isSettings() ? m_settingsTree : m_nonSettingsTree;
 
     ObjectTreeItem* existing = root->findDataObjectTreeItemByObjectId(obj->getObjID());
@@ -153,6 +167,8 @@ void UAVObjectTreeModel::instanceRemove(UAVObject *obj)
             InstanceTreeItem *inst = dynamic_cast<InstanceTreeItem*>(item);
             if(inst && inst->object() == obj)
             {
+                // Don't report rows that are about to go away
+                emitDataChanged();
                 inst->parent()->removeChild(inst);
                 inst->deleteLater();
             }
@@ -210,25 +226,19 @@ TreeItem* UAVObjectTreeModel::createCategoryItems(QStringList categoryPath, Tree
 
 MetaObjectTreeItem* UAVObjectTreeModel::addMetaObject(UAVMetaObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
+    m_updateSubscription->addObject(obj);
     MetaObjectTreeItem *meta = new MetaObjectTreeItem(obj, tr("Meta Data"));
 
     meta->setHighlightManager(m_highlightManager);
     connect(meta, SIGNAL(updateHighlight(TreeItem*)), this, SLOT(updateHighlight(TreeItem*)));
-    foreach (UAVObjectField *field, obj->getFields()) {
-        if (field->getNumElements() > 1) {
-            addArrayField(field, meta);
-        } else {
-            addSingleField(0, field, meta);
-        }
-    }
+    meta->setFieldsPending(true);
     parent->appendChild(meta);
     return meta;
 }
 
 void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
 {
-    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(highlightUpdatedObject(UAVObject*)));
+    m_updateSubscription->addObject(obj);
     TreeItem *item;
     DataObjectTreeItem *p = static_cast<DataObjectTreeItem*>(parent);
     if (obj->isSingleInstance()) {
@@ -250,18 +260,40 @@ void UAVObjectTreeModel::addInstance(UAVObject *obj, TreeItem *parent)
         // Inform the model that the row addition is complete
         endInsertRows();
     }
-    foreach (UAVObjectField *field, obj->getFields()) {
+    static_cast<ObjectTreeItem*>(item)->setFieldsPending(true);
+    UAVDataObject * dobj = dynamic_cast<UAVDataObject *>(obj);
+    if(dobj)
+    {
+        connect(dobj, SIGNAL(presentOnHardwareChanged(UAVDataObject*)), this, SLOT(presentOnHardwareChangedCB(UAVDataObject*)), Qt::UniqueConnection);
+    }
+}
+
+/**
+ * @brief Creates the field items of an object, the first time it is expanded
+ */
+void UAVObjectTreeModel::addFields(ObjectTreeItem *item)
+{
+    if (!item->fieldsPending())
+        return;
+    item->setFieldsPending(false);
+
+    UAVObject *obj = item->object();
+    if (!obj)
+        return;
+
+    QList<UAVObjectField*> fields = obj->getFields();
+    if (fields.isEmpty())
+        return;
+
+    beginInsertRows(index(item), item->childCount(), item->childCount() + fields.count() - 1);
+    foreach (UAVObjectField *field, fields) {
         if (field->getNumElements() > 1) {
             addArrayField(field, item);
         } else {
             addSingleField(0, field, item);
         }
     }
-    UAVDataObject * dobj = dynamic_cast<UAVDataObject *>(obj);
-    if(dobj)
-    {
-        connect(dobj, SIGNAL(presentOnHardwareChanged(UAVDataObject*)), this, SLOT(presentOnHardwareChangedCB(UAVDataObject*)), Qt::UniqueConnection);
-    }
+    endInsertRows();
 }
 
 void UAVObjectTreeModel::addArrayField(UAVObjectField *field, TreeItem *parent)
@@ -345,16 +377,7 @@ QModelIndex UAVObjectTreeModel::index(TreeItem *item)
     if (item->parent() == 0)
         return QModelIndex();
 
-    QModelIndex root = index(item->parent());
-
-    for (int i = 0; i < rowCount(root); ++i) {
-        QModelIndex childIndex = index(i, 0, root);
-        TreeItem *child = static_cast<TreeItem*>(childIndex.internalPointer());
-        if (child == item)
-            return childIndex;
-    }
-    Q_ASSERT(false);
-    return QModelIndex();
+    return createIndex(item->row(), 0, item);
 }
 
 QModelIndex UAVObjectTreeModel::parent(const QModelIndex &index) const
@@ -384,6 +407,72 @@ int UAVObjectTreeModel::rowCount(const QModelIndex &parent) const
     return parentItem->childCount();
 }
 
+bool UAVObjectTreeModel::hasChildren(const QModelIndex &parent) const
+{
+    if (canFetchMore(parent))
+        return true;
+
+    return QAbstractItemModel::hasChildren(parent);
+}
+
+bool UAVObjectTreeModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (!parent.isValid() || parent.column() > 0)
+        return false;
+
+    ObjectTreeItem *item = dynamic_cast<ObjectTreeItem*>(static_cast<TreeItem*>(parent.internalPointer()));
+    return item && item->fieldsPending() && item->object();
+}
+
+void UAVObjectTreeModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    addFields(static_cast<ObjectTreeItem*>(static_cast<TreeItem*>(parent.internalPointer())));
+}
+
+/**
+ * @brief The names the rows of the fields not created yet would have, so that the search can find them
+ */
+QStringList UAVObjectTreeModel::pendingFieldNames(const QModelIndex &index) const
+{
+    QStringList names;
+    if (!canFetchMore(index))
+        return names;
+
+    ObjectTreeItem *item = static_cast<ObjectTreeItem*>(static_cast<TreeItem*>(index.internalPointer()));
+    foreach (UAVObjectField *field, item->object()->getFields()) {
+        names.append(field->getName());
+        if (field->getNumElements() > 1) {
+            foreach (QString element, field->getElementNames())
+                names.append(QString("[%1]").arg(element));
+        }
+    }
+    return names;
+}
+
+/**
+ * @brief Called by the view, only the values of expanded items are kept up to date
+ */
+void UAVObjectTreeModel::setExpanded(const QModelIndex &index, bool expanded)
+{
+    if (!index.isValid())
+        return;
+
+    TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
+    item->setExpanded(expanded);
+    if (!expanded)
+        return;
+
+    ObjectTreeItem *objItem = dynamic_cast<ObjectTreeItem*>(item);
+    if (objItem)
+        addFields(objItem);
+
+    // Catch up on what changed while the children were hidden
+    item->refresh();
+}
+
 int UAVObjectTreeModel::columnCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
@@ -514,20 +603,27 @@ QVariant UAVObjectTreeModel::headerData(int section, Qt::Orientation orientation
     return QVariant();
 }
 
-void UAVObjectTreeModel::highlightUpdatedObject(UAVObject *obj)
+/**
+ * @brief Refresh the tree items of the objects updated during the last frame
+ * @param objs the updated objects, each one is listed once
+ */
+void UAVObjectTreeModel::highlightUpdatedObjects(const QList<UAVObject*> &objs)
 {
-    Q_ASSERT(obj);
-    ObjectTreeItem *item = findObjectTreeItem(obj);
-    Q_ASSERT(item);
-    if(!m_onlyHighlightChangedValues){
-        item->setHighlight(true);
-    }
-    item->update();
-    if(!m_onlyHighlightChangedValues){
-        QModelIndex itemIndex = index(item);
-        Q_ASSERT(itemIndex != QModelIndex());
-        emit dataChanged(itemIndex, itemIndex);
+    foreach (UAVObject *obj, objs) {
+        Q_ASSERT(obj);
+        ObjectTreeItem *item = findObjectTreeItem(obj);
+        Q_ASSERT(item);
+        if(!m_onlyHighlightChangedValues){
+            item->setHighlight(true);
+        }
+
+        // Fields in rows nobody can see are read when they are shown
+        if (item->isShown())
+            item->update();
     }
+
+    // This is already once per frame, no need to wait for the timer
+    emitDataChanged();
 }
 
 ObjectTreeItem* UAVObjectTreeModel::findObjectTreeItem(UAVObject *object)
@@ -562,9 +658,40 @@ MetaObjectTreeItem* UAVObjectTreeModel::findMetaObjectTreeItem(UAVMetaObject *ob
 
 void UAVObjectTreeModel::updateHighlight(TreeItem *item)
 {
-    QModelIndex itemIndex = index(item);
-    Q_ASSERT(itemIndex != QModelIndex());
-    emit dataChanged(itemIndex, itemIndex.sibling(itemIndex.row(), TreeItem::dataColumn));
+    m_changedItems.insert(item);
+    if (!m_dataChangedTimer.isActive())
+        m_dataChangedTimer.start();
+}
+
+/**
+ * @brief Reports the rows changed since the last batch, one range per parent, skipping hidden rows
+ */
+void UAVObjectTreeModel::emitDataChanged()
+{
+    m_dataChangedTimer.stop();
+
+    QHash<TreeItem*, QPair<int, int> > ranges;
+    foreach (TreeItem *item, m_changedItems) {
+        TreeItem *parent = item->parent();
+        if (!parent || !item->isShown())
+            continue;
+
+        int row = item->row();
+        QHash<TreeItem*, QPair<int, int> >::iterator it = ranges.find(parent);
+        if (it == ranges.end()) {
+            ranges.insert(parent, qMakePair(row, row));
+        } else {
+            it->first = qMin(it->first, row);
+            it->second = qMax(it->second, row);
+        }
+    }
+    m_changedItems.clear();
+
+    for (QHash<TreeItem*, QPair<int, int> >::const_iterator it = ranges.constBegin(); it != ranges.constEnd(); ++it) {
+        TreeItem *parent = it.key();
+        emit dataChanged(createIndex(it->first, 0, parent->getChild(it->first)),
+                         createIndex(it->second, TreeItem::dataColumn, parent->getChild(it->second)));
+    }
 }
 
 
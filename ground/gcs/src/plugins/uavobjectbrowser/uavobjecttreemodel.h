@@ -33,6 +33,8 @@
 #include <QAbstractItemModel>
 #include <QtCore/QMap>
 #include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
 #include <QColor>
 
 class TopTreeItem;
@@ -43,6 +45,7 @@ class UAVDataObject;
 class UAVMetaObject;
 class UAVObjectField;
 class UAVObjectManager;
+class UAVObjectSubscription;
 class QSignalMapper;
 class QTimer;
 
@@ -64,6 +67,14 @@ public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
     int columnCount(const QModelIndex &parent = QModelIndex()) const;
 
+    // The fields of an object are only created once it is expanded
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+    bool canFetchMore(const QModelIndex &parent) const;
+    void fetchMore(const QModelIndex &parent);
+    QStringList pendingFieldNames(const QModelIndex &index) const;
+
+    void setExpanded(const QModelIndex &index, bool expanded);
+
     TopTreeItem* getSettingsTree(){return m_settingsTree;}
     TopTreeItem* getNonSettingsTree(){return m_nonSettingsTree;}
 
@@ -88,8 +99,9 @@ public slots:
     void initializeModel(bool categorize = true, bool useScientificFloatNotation = true);
     void instanceRemove(UAVObject*);
 private slots:
-    void highlightUpdatedObject(UAVObject *obj);
+    void highlightUpdatedObjects(const QList<UAVObject*> &objs);
     void updateHighlight(TreeItem*);
+    void emitDataChanged();
     void updateCurrentTime();
     void presentOnHardwareChangedCB(UAVDataObject*);
 
@@ -101,6 +113,7 @@ private:
     void addArrayField(UAVObjectField *field, TreeItem *parent);
     void addSingleField(int index, UAVObjectField *field, TreeItem *parent);
     void addInstance(UAVObject *obj, TreeItem *parent);
+    void addFields(ObjectTreeItem *item);
 
     TreeItem *createCategoryItems(QStringList categoryPath, TreeItem *root);
 
@@ -125,8 +138,13 @@ private:
     QTimer m_currentTimeTimer;
     QTime m_currentTime;
     UAVObjectManager *objManager;
+    // Delivers object updates at most once per display frame
+    UAVObjectSubscription *m_updateSubscription;
     // Highlight manager to handle highlighting of tree items.
     HighLightManager *m_highlightManager;
+    // Items to report in the next batch of dataChanged() signals
+    QSet<TreeItem*> m_changedItems;
+    QTimer m_dataChangedTimer;
     QMutex mutex;
     bool isInitialized;
 };
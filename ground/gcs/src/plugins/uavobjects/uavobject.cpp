@@ -29,6 +29,7 @@
 #include "uavobject.h"
 #include <QtEndian>
 #include <QDebug>
+#include <QThread>
 
 // Constants
 #define UAVOBJ_ACCESS_SHIFT 0
@@ -273,6 +274,46 @@ UAVObjectField* UAVObject::getField(const QString& name)
 qint32 UAVObject::pack(quint8* dataOut)
 {
     QMutexLocker locker(mutex);
+    packData(dataOut);
+    return numBytes;
+}
+
+/**
+ * Unpack the object data from a byte array
+ *
+ * When this is called from another thread than the one owning the object,
+ * which is the case for the telemetry thread, the update signals are not
+ * emitted right away. Instead a single notification is queued to the owning
+ * thread and all unpacks until it runs are coalesced into it, so a fast
+ * link can not flood the GUI event loop.
+ * @returns The number of bytes copied
+ */
+qint32 UAVObject::unpack(const quint8* dataIn)
+{
+    QMutexLocker locker(mutex);
+    unpackData(dataIn);
+
+    if (QThread::currentThread() != thread())
+    {
+        if (unpackPending.fetchAndStoreOrdered(1) == 0)
+        {
+            QMetaObject::invokeMethod(this, "emitUnpacked", Qt::QueuedConnection);
+        }
+        return numBytes;
+    }
+
+    emit objectUnpacked(this); // trigger object updated event
+    emit objectUpdated(this);
+
+    return numBytes;
+}
+
+/**
+ * Pack the data field by field, called with the mutex held. Generated
+ * objects know their layout and copy it in one go instead.
+ */
+void UAVObject::packData(quint8* dataOut)
+{
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -280,16 +321,14 @@ qint32 UAVObject::pack(quint8* dataOut)
         field->pack(&dataOut[offset]);
         offset += field->getNumBytes();
     }
-    return numBytes;
 }
 
 /**
- * Unpack the object data from a byte array
- * @returns The number of bytes copied
+ * Unpack the data field by field, called with the mutex held. Generated
+ * objects know their layout and copy it in one go instead.
  */
-qint32 UAVObject::unpack(const quint8* dataIn)
+void UAVObject::unpackData(const quint8* dataIn)
 {
-    QMutexLocker locker(mutex);
     qint32 offset = 0;
     for (QList<UAVObjectField*>::iterator iter = fields.begin(); iter != fields.end(); ++iter)
     {
@@ -297,10 +336,36 @@ qint32 UAVObject::unpack(const quint8* dataIn)
         field->unpack(&dataIn[offset]);
         offset += field->getNumBytes();
     }
+}
+
+/**
+ * Reverse the byte order of count elements of size bytes each
+ */
+void UAVObject::swapElements(quint8* elements, quint32 size, quint32 count)
+{
+    for (quint32 n = 0; n < count; ++n)
+    {
+        quint8* element = &elements[n*size];
+        for (quint32 m = 0; m < size/2; ++m)
+        {
+            quint8 tmp = element[m];
+            element[m] = element[size - 1 - m];
+            element[size - 1 - m] = tmp;
+        }
+    }
+}
+
+/**
+ * Emit the update signals for the unpacks coalesced by unpack(), in the
+ * thread owning the object
+ */
+void UAVObject::emitUnpacked()
+{
+    // Unpacks from now on need another notification
+    unpackPending.fetchAndStoreOrdered(0);
+
     emit objectUnpacked(this); // trigger object updated event
     emit objectUpdated(this);
-
-    return numBytes;
 }
 
 /**
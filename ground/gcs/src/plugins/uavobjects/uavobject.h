@@ -34,6 +34,7 @@
 #include <QObject>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QAtomicInt>
 #include <QString>
 #include <QList>
 #include <QFile>
@@ -230,6 +231,7 @@ signals:
 
 private slots:
     void fieldUpdated(UAVObjectField* field);
+    void emitUnpacked();
 
 protected:
     quint32 objID;
@@ -240,9 +242,13 @@ protected:
     QString category;
     quint32 numBytes;
     QMutex* mutex;
+    QAtomicInt unpackPending;
     quint8* data;
     QList<UAVObjectField*> fields;
     void initializeFields(QList<UAVObjectField*>& fields, quint8* data, quint32 numBytes);
+    virtual void packData(quint8* dataOut);
+    virtual void unpackData(const quint8* dataIn);
+    static void swapElements(quint8* elements, quint32 size, quint32 count);
     void setDescription(const QString& description);
     void setCategory(const QString& category);
 
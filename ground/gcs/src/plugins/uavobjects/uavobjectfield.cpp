@@ -29,6 +29,7 @@
 #include "uavobjectfield.h"
 #include <QtEndian>
 #include <QDebug>
+#include <QVector>
 
 UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options, const QList<int>& indices, const QString &limits, const QString &description)
 {
@@ -39,16 +40,46 @@ UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldT
         elementNames.append(QString("%1").arg(n));
     }
     // Initialize
-    constructorInitialize(name, units, type, elementNames, options, indices, limits, description);
+    constructorInitialize(DescriptorPtr(new Descriptor(name, units, type, elementNames, options, indices, limits, description)));
 
 }
 
 UAVObjectField::UAVObjectField(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int>& indices, const QString &limits, const QString &description)
 {
-    constructorInitialize(name, units, type, elementNames, options, indices, limits, description);
+    constructorInitialize(DescriptorPtr(new Descriptor(name, units, type, elementNames, options, indices, limits, description)));
 }
 
-void UAVObjectField::constructorInitialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int>& indices, const QString &limits, const QString &description)
+/**
+ * Create a field of an object instance from the descriptor that all the
+ * instances of the object share
+ */
+UAVObjectField::UAVObjectField(const DescriptorPtr& descriptor)
+{
+    constructorInitialize(descriptor);
+}
+
+void UAVObjectField::constructorInitialize(const DescriptorPtr& descriptor)
+{
+    desc = descriptor;
+    type = desc->type;
+    numElements = desc->numElements;
+    numBytesPerElement = desc->numBytesPerElement;
+    offset = 0;
+    data = NULL;
+    obj = NULL;
+}
+
+UAVObjectField::Descriptor::Descriptor(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int>& indices, const QString &limits, const QString &description) :
+    Descriptor(name, units, type, elementNames, options, indices, NULL, 0, NULL, description)
+{
+    limitsInitialize(limits);
+}
+
+/**
+ * Create a descriptor with limits that the generator already parsed, so
+ * that nothing has to be parsed when the objects are created
+ */
+UAVObjectField::Descriptor::Descriptor(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int>& indices, const LimitRule* limitRules, int numLimitRules, const double* limitValues, const QString &description)
 {
     // Copy params
     this->name = name;
@@ -57,9 +88,6 @@ void UAVObjectField::constructorInitialize(const QString& name, const QString& u
     this->options = options;
     this->indices = indices;
     this->numElements = elementNames.length();
-    this->offset = 0;
-    this->data = NULL;
-    this->obj = NULL;
     this->elementNames = elementNames;
     this->description = description;
     // Set field size
@@ -91,7 +119,7 @@ void UAVObjectField::constructorInitialize(const QString& name, const QString& u
         break;
     case BITFIELD:
         numBytesPerElement = sizeof(quint8);
-        this->options = QStringList() << tr("0") << tr("1");
+        this->options = QStringList() << UAVObjectField::tr("0") << UAVObjectField::tr("1");
         this->indices = QList<int>() << 0 << 1;
         break;
     case STRING:
@@ -100,10 +128,48 @@ void UAVObjectField::constructorInitialize(const QString& name, const QString& u
     default:
         numBytesPerElement = 0;
     }
-    limitsInitialize(limits);
+    limitsInitialize(limitRules, numLimitRules, limitValues);
+}
+
+void UAVObjectField::Descriptor::limitsInitialize(const LimitRule* rules, int numRules, const double* values)
+{
+    for (int n = 0; n < numRules; ++n)
+    {
+        const LimitRule &rule = rules[n];
+        LimitStruct lstruc;
+        lstruc.type = rule.type;
+        lstruc.board = rule.board;
+        for (int m = rule.first; m < rule.first + rule.count; ++m)
+        {
+            switch (type)
+            {
+            case UINT8:
+            case UINT16:
+            case UINT32:
+            case BITFIELD:
+                lstruc.values.append((quint32)values[m]);
+                break;
+            case INT8:
+            case INT16:
+            case INT32:
+                lstruc.values.append((qint32)values[m]);
+                break;
+            case FLOAT32:
+                lstruc.values.append((float)values[m]);
+                break;
+            case ENUM:
+                lstruc.values.append(options.value((int)values[m]));
+                lstruc.optionIndices.append((int)values[m]);
+                break;
+            default:
+                lstruc.values.append(QVariant());
+            }
+        }
+        elementLimits[rule.element].append(lstruc);
+    }
 }
 
-void UAVObjectField::limitsInitialize(const QString &limits)
+void UAVObjectField::Descriptor::limitsInitialize(const QString &limits)
 {
     /// format
     /// (TY)->type (EQ-equal;NE-not equal;BE-between;BI-bigger;SM-smaller)
@@ -171,6 +237,7 @@ void UAVObjectField::limitsInitialize(const QString &limits)
                         break;
                     case ENUM:
                         lstruc.values.append((QString)value);
+                        lstruc.optionIndices.append(options.indexOf(value));
                         break;
                     case STRING:
                         lstruc.values.append((QString)value);
@@ -200,10 +267,10 @@ void UAVObjectField::limitsInitialize(const QString &limits)
 
 bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
 {
-    if(!elementLimits.keys().contains(index))
+    if(!desc->elementLimits.contains(index))
         return true;
 
-    foreach(const LimitStruct &struc,elementLimits.value(index))
+    foreach(const LimitStruct &struc,desc->elementLimits.value(index))
     {
         if((struc.board!=board) && board!=0 && struc.board!=0)
             continue;
@@ -294,11 +361,11 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
         case BETWEEN:
             if(struc.values.length()<2)
             {
-                qDebug()<<__FUNCTION__<<"between limit with less than 1 pair, aborting; field:"<<name;
+                qDebug()<<__FUNCTION__<<"between limit with less than 1 pair, aborting; field:"<<desc->name;
                 return true;
             }
             if(struc.values.length()>2)
-                qDebug()<<__FUNCTION__<<"between limit with more than 1 pair, using first; field"<<name;
+                qDebug()<<__FUNCTION__<<"between limit with more than 1 pair, using first; field"<<desc->name;
             switch (type)
             {
             case INT8:
@@ -320,7 +387,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
 		    // OK, I think this is OK with parents.  Because we'll
 		    // consider the limit to mean "as ordered in this object".
 		    // So no need to map to underlying types.  
-                    if(!(options.indexOf(var.toString())>=options.indexOf(struc.values.at(0).toString()) && options.indexOf(var.toString())<=options.indexOf(struc.values.at(1).toString())))
+                    if(!(desc->options.indexOf(var.toString())>=struc.optionIndices.at(0) && desc->options.indexOf(var.toString())<=struc.optionIndices.at(1)))
                         return false;
                 return true;
                 break;
@@ -339,11 +406,11 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
         case BIGGER:
             if(struc.values.length()<1)
             {
-                qDebug()<<__FUNCTION__<<"BIGGER limit with less than 1 value, aborting; field:"<<name;
+                qDebug()<<__FUNCTION__<<"BIGGER limit with less than 1 value, aborting; field:"<<desc->name;
                 return true;
             }
             if(struc.values.length()>1)
-                qDebug()<<__FUNCTION__<<"BIGGER limit with more than 1 value, using first; field"<<name;
+                qDebug()<<__FUNCTION__<<"BIGGER limit with more than 1 value, using first; field"<<desc->name;
             switch (type)
             {
             case INT8:
@@ -362,7 +429,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
                 return true;
                 break;
             case ENUM:
-                    if(!(options.indexOf(var.toString())>=options.indexOf(struc.values.at(0).toString())))
+                    if(!(desc->options.indexOf(var.toString())>=struc.optionIndices.at(0)))
                         return false;
                 return true;
                 break;
@@ -397,7 +464,7 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
                 return true;
                 break;
             case ENUM:
-                    if(!(options.indexOf(var.toString())<=options.indexOf(struc.values.at(0).toString())))
+                    if(!(desc->options.indexOf(var.toString())<=struc.optionIndices.at(0)))
                         return false;
                 return true;
                 break;
@@ -419,9 +486,9 @@ bool UAVObjectField::isWithinLimits(QVariant var,quint32 index, int board)
 
 QVariant UAVObjectField::getMaxLimit(quint32 index,int board)
 {
-    if(!elementLimits.keys().contains(index))
+    if(!desc->elementLimits.contains(index))
         return QVariant();
-    foreach(const LimitStruct &struc,elementLimits.value(index))
+    foreach(const LimitStruct &struc,desc->elementLimits.value(index))
     {
         if((struc.board!=board) && board!=0 && struc.board!=0)
             continue;
@@ -448,9 +515,9 @@ QVariant UAVObjectField::getMaxLimit(quint32 index,int board)
 }
 QVariant UAVObjectField::getMinLimit(quint32 index, int board)
 {
-    if(!elementLimits.keys().contains(index))
+    if(!desc->elementLimits.contains(index))
         return QVariant();
-    foreach(LimitStruct struc,elementLimits.value(index))
+    foreach(LimitStruct struc,desc->elementLimits.value(index))
     {
         if((struc.board!=board) && board!=0 && struc.board!=0)
             return QVariant();
@@ -519,7 +586,7 @@ QString UAVObjectField::getTypeAsString()
 
 QStringList UAVObjectField::getElementNames()
 {
-    return elementNames;
+    return desc->elementNames;
 }
 
 UAVObject* UAVObjectField::getObject()
@@ -543,17 +610,17 @@ void UAVObjectField::clear()
 
 QString UAVObjectField::getName()
 {
-    return name;
+    return desc->name;
 }
 
 QString UAVObjectField::getUnits()
 {
-    return units;
+    return desc->units;
 }
 
 QStringList UAVObjectField::getOptions()
 {
-    return options;
+    return desc->options;
 }
 
 quint32 UAVObjectField::getNumElements()
@@ -582,12 +649,18 @@ quint32 UAVObjectField::getNumBytes()
 QString UAVObjectField::toString()
 {
     QString sout;
-    sout.append ( QString("%1: [ ").arg(name) );
+    sout.append ( QString("%1: [ ").arg(desc->name) );
+    QVector<double> values(numElements);
+    if (getDoubles(values.data(), numElements) != numElements)
+    {
+        for (unsigned int n = 0; n < numElements; ++n)
+            values[n] = getDouble(n);
+    }
     for (unsigned int n = 0; n < numElements; ++n)
     {
-        sout.append( QString("%1 ").arg(getDouble(n)) );
+        sout.append( QString("%1 ").arg(values[n]) );
     }
-    sout.append( QString("] %1\n").arg(units) );
+    sout.append( QString("] %1\n").arg(desc->units) );
     return sout;
 }
 
@@ -885,9 +958,9 @@ QVariant UAVObjectField::getValue(quint32 index)
         quint8 tmpenum;
         memcpy(&tmpenum, &data[offset + numBytesPerElement*index], numBytesPerElement);
 	// Too slow?
-	for (int i = 0; i < indices.length(); i++) {
-	    if (tmpenum == indices[i]) {
-		return QVariant( options[i] );
+	for (int i = 0; i < desc->indices.length(); i++) {
+	    if (tmpenum == desc->indices[i]) {
+		return QVariant( desc->options[i] );
 	    }
 	}
 
@@ -942,7 +1015,7 @@ bool UAVObjectField::checkValue(const QVariant& value, quint32 index)
             break;
         case ENUM:
         {
-            qint8 tmpenum = options.indexOf( value.toString() );
+            qint8 tmpenum = desc->options.indexOf( value.toString() );
             return ((tmpenum < 0) ? false : true);
             break;
         }
@@ -1014,10 +1087,10 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
         }
         case ENUM:
         {
-            qint8 tmpenum = options.indexOf( value.toString() );
+            qint8 tmpenum = desc->options.indexOf( value.toString() );
             Q_ASSERT(tmpenum >= 0); // To catch any programming errors where we set invalid values
 
-	    tmpenum = indices[tmpenum];
+	    tmpenum = desc->indices[tmpenum];
 
             memcpy(&data[offset + numBytesPerElement*index], &tmpenum, numBytesPerElement);
             break;
@@ -1046,9 +1119,124 @@ void UAVObjectField::setValue(const QVariant& value, quint32 index)
     }
 }
 
+/**
+ * Get an element as a double. Numeric fields are read directly, without
+ * going through a QVariant.
+ */
 double UAVObjectField::getDouble(quint32 index)
 {
-    return getValue(index).toDouble();
+    if (type == ENUM || type == STRING)
+        return getValue(index).toDouble();
+
+    QMutexLocker locker(obj->getMutex());
+    if ( index >= numElements )
+    {
+        return 0;
+    }
+    return elementAsDouble(index);
+}
+
+/**
+ * Read consecutive elements of a numeric field into an array, taking the
+ * object lock only once.
+ * @param out Destination, must have room for count values
+ * @param count Number of elements to read
+ * @param first Index of the first element to read
+ * @return Number of elements read, 0 for enum and string fields
+ */
+quint32 UAVObjectField::getDoubles(double* out, quint32 count, quint32 first)
+{
+    if (type == ENUM || type == STRING)
+        return 0;
+
+    QMutexLocker locker(obj->getMutex());
+    if ( first >= numElements )
+    {
+        return 0;
+    }
+    count = qMin(count, numElements - first);
+    for (quint32 n = 0; n < count; ++n)
+    {
+        out[n] = elementAsDouble(first + n);
+    }
+    return count;
+}
+
+/**
+ * Copy consecutive elements of a float field into an array, taking the
+ * object lock only once.
+ * @param out Destination, must have room for count values
+ * @param count Number of elements to read
+ * @param first Index of the first element to read
+ * @return Number of elements read, 0 if this is not a float field
+ */
+quint32 UAVObjectField::getFloats(float* out, quint32 count, quint32 first)
+{
+    if (type != FLOAT32)
+        return 0;
+
+    QMutexLocker locker(obj->getMutex());
+    if ( first >= numElements )
+    {
+        return 0;
+    }
+    count = qMin(count, numElements - first);
+    memcpy(out, &data[offset + numBytesPerElement*first], numBytesPerElement*count);
+    return count;
+}
+
+/**
+ * Decode a numeric element, the object lock must be held and the index valid.
+ */
+double UAVObjectField::elementAsDouble(quint32 index)
+{
+    const quint8* element = &data[offset + numBytesPerElement*index];
+
+    switch (type)
+    {
+    case INT8:
+    {
+        qint8 tmpint8;
+        memcpy(&tmpint8, element, sizeof(tmpint8));
+        return tmpint8;
+    }
+    case INT16:
+    {
+        qint16 tmpint16;
+        memcpy(&tmpint16, element, sizeof(tmpint16));
+        return tmpint16;
+    }
+    case INT32:
+    {
+        qint32 tmpint32;
+        memcpy(&tmpint32, element, sizeof(tmpint32));
+        return tmpint32;
+    }
+    case UINT8:
+        return *element;
+    case UINT16:
+    {
+        quint16 tmpuint16;
+        memcpy(&tmpuint16, element, sizeof(tmpuint16));
+        return tmpuint16;
+    }
+    case UINT32:
+    {
+        quint32 tmpuint32;
+        memcpy(&tmpuint32, element, sizeof(tmpuint32));
+        return tmpuint32;
+    }
+    case FLOAT32:
+    {
+        float tmpfloat;
+        memcpy(&tmpfloat, element, sizeof(tmpfloat));
+        return tmpfloat;
+    }
+    case BITFIELD:
+        return (data[offset + numBytesPerElement*(index/8)] >> (index % 8)) & 1;
+    default:
+        return 0;
+    }
 }
 
 void UAVObjectField::setDouble(double value, quint32 index)
@@ -1058,5 +1246,5 @@ void UAVObjectField::setDouble(double value, quint32 index)
 
 QString UAVObjectField::getDescription()
 {
-    return description;
+    return desc->description;
 }
@@ -34,6 +34,7 @@
 #include <QVariant>
 #include <QList>
 #include <QMap>
+#include <QSharedPointer>
 
 class UAVObject;
 
@@ -48,11 +49,56 @@ public:
     {
         LimitType type;
         QList<QVariant> values;
+        // For enum fields, the positions of the values in the options
+        QList<int> optionIndices;
         int board;
     } LimitStruct;
 
+    /**
+     * A limit rule of one element, as the generator parses it from the
+     * object definition. Its values are count entries of a value table
+     * starting at first; for enum fields they are option positions.
+     */
+    typedef struct
+    {
+        quint32 element;
+        int board;
+        LimitType type;
+        int first;
+        int count;
+    } LimitRule;
+
+    /**
+     * What all instances of an object have in common for a field: the names,
+     * options and parsed limits. Generated objects create the descriptors
+     * of their fields once and share them between the instances.
+     */
+    class UAVOBJECTS_EXPORT Descriptor
+    {
+    public:
+        Descriptor(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int>& indices, const QString& limits=QString(), const QString& description=QString());
+        Descriptor(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int>& indices, const LimitRule* limitRules, int numLimitRules, const double* limitValues, const QString& description=QString());
+
+        QString name;
+        QString units;
+        FieldType type;
+        QStringList elementNames;
+        QList<int> indices;
+        QStringList options;
+        quint32 numElements;
+        quint32 numBytesPerElement;
+        QMap<quint32, QList<LimitStruct> > elementLimits;
+        QString description;
+
+    private:
+        void limitsInitialize(const QString &limits);
+        void limitsInitialize(const LimitRule* rules, int numRules, const double* values);
+    };
+    typedef QSharedPointer<const Descriptor> DescriptorPtr;
+
     UAVObjectField(const QString& name, const QString& units, FieldType type, quint32 numElements, const QStringList& options, const QList<int>& indices, const QString& limits=QString(), const QString& description=QString());
     UAVObjectField(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int>& indices, const QString& limits=QString(), const QString& description=QString());
+    UAVObjectField(const DescriptorPtr& descriptor);
     void initialize(quint8* data, quint32 dataOffset, UAVObject* obj);
     UAVObject* getObject();
     FieldType getType();
@@ -69,6 +115,8 @@ public:
     void setValue(const QVariant& data, quint32 index = 0);
     double getDouble(quint32 index = 0);
     void setDouble(double value, quint32 index = 0);
+    quint32 getDoubles(double* out, quint32 count, quint32 first = 0);
+    quint32 getFloats(float* out, quint32 count, quint32 first = 0);
     quint32 getDataOffset();
     quint32 getNumBytes();
     bool isNumeric();
@@ -83,22 +131,17 @@ signals:
     void fieldUpdated(UAVObjectField* field);
 
 protected:
-    QString name;
-    QString units;
+    DescriptorPtr desc;
+    // Copied from the descriptor for the pack and get paths
     FieldType type;
-    QStringList elementNames;
-    QList<int> indices;
-    QStringList options;
     quint32 numElements;
     quint32 numBytesPerElement;
     quint32 offset;
     quint8* data;
     UAVObject* obj;
-    QMap<quint32, QList<LimitStruct> > elementLimits;
-    QString description;
     void clear();
-    void constructorInitialize(const QString& name, const QString& units, FieldType type, const QStringList& elementNames, const QStringList& options, const QList<int> &indices, const QString &limits, const QString &description);
-    void limitsInitialize(const QString &limits);
+    void constructorInitialize(const DescriptorPtr& descriptor);
+    double elementAsDouble(quint32 index);
 
 
 };
@@ -32,7 +32,9 @@
 /**
  * Constructor
  */
-UAVObjectManager::UAVObjectManager()
+UAVObjectManager::UAVObjectManager() :
+    generation(0),
+    cacheGeneration(0)
 {
     mutex = new QMutex(QMutex::Recursive);
 }
@@ -76,18 +78,20 @@ bool UAVObjectManager::registerObject(UAVDataObject* obj)
                 QMap<quint32,UAVObject*> ppp;
                 ppp.insert(instidx,cobj);
                 objects[objID].insert(instidx,cobj);
+                updateIndex(objID);
                 getObject(cobj->getObjID())->emitNewInstance(cobj);//TODO??
                 emit newInstance(cobj);
             }
         }
         else if (obj->getInstID() == 0)
-            obj->initialize(objects.value(objID).last()->getObjID() + 1, mobj);
+            obj->initialize(objects.value(objID).last()->getInstID() + 1, mobj);
         else
         {
             return false;
         }
         // Add the actual object instance in the list
         objects[objID].insert(obj->getInstID(),obj);
+        updateIndex(objID);
         getObject(objID)->emitNewInstance(obj);
         emit newInstance(obj);
         return true;
@@ -128,9 +132,36 @@ bool UAVObjectManager::unRegisterObject(UAVDataObject* obj)
         emit instanceRemoved(objects.value(objID).value(x));
         objects[objID].remove(x);
     }
+    updateIndex(objID);
     return true;
 }
 
+/**
+ * Get the registration generation. It changes whenever an object or instance
+ * is added or removed, callers keeping their own object lists can compare it
+ * to know when they have to refresh them.
+ */
+quint32 UAVObjectManager::getGeneration()
+{
+    QMutexLocker locker(mutex);
+    return generation;
+}
+
+/**
+ * Create a coalesced update subscription for a set of objects, see
+ * UAVObjectSubscription. The subscription is deleted along with its parent.
+ * @param objs Objects to watch, more can be added to the subscription later
+ * @param rateHz Maximum notification rate, typically the display frame rate
+ * @param parent Owner of the subscription, normally the consuming widget
+ */
+UAVObjectSubscription* UAVObjectManager::subscribe(const QList<UAVObject*>& objs, int rateHz, QObject* parent)
+{
+    UAVObjectSubscription* sub = new UAVObjectSubscription(rateHz, parent);
+    foreach (UAVObject* obj, objs)
+        sub->addObject(obj);
+    return sub;
+}
+
 void UAVObjectManager::addObject(UAVObject* obj)
 {
     // Add to list
@@ -138,11 +169,83 @@ void UAVObjectManager::addObject(UAVObject* obj)
     list.insert(obj->getInstID(),obj);
     objects.insert(obj->getObjID(),list);
 
-    objectsByName.insert(obj->getName(), list);
+    idsByName.insert(obj->getName(), obj->getObjID());
+    updateIndex(obj->getObjID());
 
     emit newObject(obj);
 }
 
+/**
+ * Rebuild the lookup entry of an object after its instances changed, the
+ * mutex must be held.
+ */
+void UAVObjectManager::updateIndex(quint32 objId)
+{
+    ++generation;
+
+    if (objects.value(objId).isEmpty())
+    {
+        instancesById.remove(objId);
+        return;
+    }
+
+    const ObjectMap &map = objects[objId];
+    QVector<UAVObject*> &instances = instancesById[objId];
+    // Registration fills the gaps between instances, so the vector is dense
+    instances.fill(NULL, map.lastKey() + 1);
+    for (ObjectMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it)
+        instances[it.key()] = it.value();
+}
+
+/**
+ * Rebuild the vectors returned by the get*Vector() functions if objects were
+ * registered since they were last built, the mutex must be held.
+ */
+void UAVObjectManager::updateCaches()
+{
+    if (cacheGeneration == generation)
+        return;
+
+    objectsVectorCache.clear();
+    dataObjectsVectorCache.clear();
+    metaObjectsVectorCache.clear();
+
+    foreach (const ObjectMap &map, objects)
+    {
+        if (map.isEmpty())
+            continue;
+
+        objectsVectorCache.append(map.values().toVector());
+
+        if (qobject_cast<UAVDataObject*>(map.first()))
+        {
+            QVector<UAVDataObject*> vec;
+            vec.reserve(map.count());
+            foreach (UAVObject* o, map)
+            {
+                UAVDataObject* dobj = qobject_cast<UAVDataObject*>(o);
+                if (dobj)
+                    vec.append(dobj);
+            }
+            dataObjectsVectorCache.append(vec);
+        }
+        else if (qobject_cast<UAVMetaObject*>(map.first()))
+        {
+            QVector<UAVMetaObject*> vec;
+            vec.reserve(map.count());
+            foreach (UAVObject* o, map)
+            {
+                UAVMetaObject* mobj = qobject_cast<UAVMetaObject*>(o);
+                if (mobj)
+                    vec.append(mobj);
+            }
+            metaObjectsVectorCache.append(vec);
+        }
+    }
+
+    cacheGeneration = generation;
+}
+
 /**
  * Get all objects. A two dimentional QVector is returned. Objects are grouped by
  * instances of the same object type.
@@ -150,13 +253,8 @@ void UAVObjectManager::addObject(UAVObject* obj)
 QVector< QVector<UAVObject*> > UAVObjectManager::getObjectsVector()
 {
     QMutexLocker locker(mutex);
-    QVector< QVector<UAVObject*> > vector;
-    foreach (const ObjectMap &map,objects.values())
-    {
-        QVector<UAVObject*> vec = map.values().toVector();
-        vector.append(vec);
-    }
-    return vector;
+    updateCaches();
+    return objectsVectorCache;
 }
 
 QHash<quint32, QMap<quint32, UAVObject *> > UAVObjectManager::getObjects()
@@ -170,23 +268,8 @@ QHash<quint32, QMap<quint32, UAVObject *> > UAVObjectManager::getObjects()
 QVector< QVector<UAVDataObject*> > UAVObjectManager::getDataObjectsVector()
 {
     QMutexLocker locker(mutex);
-    QVector< QVector<UAVDataObject*> > vector;
-    foreach (const ObjectMap &map,objects.values())
-    {
-        UAVDataObject* obj = dynamic_cast<UAVDataObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVDataObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(o);
-                if(dobj)
-                    vec.append(dobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+    updateCaches();
+    return dataObjectsVectorCache;
 }
 
 /**
@@ -195,23 +278,8 @@ QVector< QVector<UAVDataObject*> > UAVObjectManager::getDataObjectsVector()
 QVector <QVector<UAVMetaObject*> > UAVObjectManager::getMetaObjectsVector()
 {
     QMutexLocker locker(mutex);
-    QVector< QVector<UAVMetaObject*> > vector;
-    foreach(const ObjectMap &map,objects.values())
-    {
-        UAVMetaObject* obj = dynamic_cast<UAVMetaObject*>(map.first());
-        if(obj!=NULL)
-        {
-            QVector<UAVMetaObject*> vec;
-            foreach(UAVObject* o,map)
-            {
-                UAVMetaObject* mobj = dynamic_cast<UAVMetaObject*>(o);
-                if(mobj)
-                    vec.append(mobj);
-            }
-            vector.append(vec);
-        }
-     }
-    return vector;
+    updateCaches();
+    return metaObjectsVectorCache;
 }
 
 /**
@@ -240,15 +308,16 @@ UAVObject* UAVObjectManager::getObject(const QString& name, quint32 objId, quint
     QMutexLocker locker(mutex);
     if(name != NULL)
     {
-        if (objectsByName.contains(name)) {
-            return objectsByName.value(name).value(instId);
-        }
+        QHash<QString, quint32>::const_iterator id = idsByName.constFind(name);
+        if (id == idsByName.constEnd())
+            return NULL;
+        objId = id.value();
+    }
 
+    QHash<quint32, QVector<UAVObject*> >::const_iterator it = instancesById.constFind(objId);
+    if (it == instancesById.constEnd() || instId >= (quint32)it.value().size())
         return NULL;
-    }
-    else if(objects.contains(objId))
-        return objects.value(objId).value(instId);
-    return NULL;
+    return it.value().at(instId);
 }
 
 /**
@@ -275,15 +344,12 @@ QVector<UAVObject*> UAVObjectManager::getObjectInstancesVector(const QString* na
     QMutexLocker locker(mutex);
     if(name != NULL)
     {
-        foreach(const ObjectMap &map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.values().toVector();
-        }
+        QHash<QString, quint32>::const_iterator id = idsByName.constFind(*name);
+        if (id == idsByName.constEnd())
+            return QVector<UAVObject*>();
+        objId = id.value();
     }
-    else if(objects.contains(objId))
-        return objects.value(objId).values().toVector();
-    return  QVector<UAVObject*>();
+    return instancesById.value(objId);
 }
 
 /**
@@ -310,13 +376,14 @@ qint32 UAVObjectManager::getNumInstances(const QString* name, quint32 objId)
     QMutexLocker locker(mutex);
     if(name != NULL)
     {
-        foreach(const ObjectMap &map,objects)
-        {
-            if(map.first()->getName().compare(name) == 0)
-                return map.count();
-        }
+        QHash<QString, quint32>::const_iterator id = idsByName.constFind(*name);
+        if (id == idsByName.constEnd())
+            return -1;
+        objId = id.value();
     }
-    else if(objects.contains(objId))
-        return objects.value(objId).count();
-    return -1;
+
+    QHash<quint32, QVector<UAVObject*> >::const_iterator it = instancesById.constFind(objId);
+    if (it == instancesById.constEnd())
+        return -1;
+    return it.value().size();
 }
@@ -33,6 +33,7 @@
 #include "uavobject.h"
 #include "uavdataobject.h"
 #include "uavmetaobject.h"
+#include "uavobjectsubscription.h"
 #include <QMutex>
 #include <QMutexLocker>
 #include <QVector>
@@ -58,6 +59,8 @@ public:
     qint32 getNumInstances(const QString& name);
     qint32 getNumInstances(quint32 objId);    
     bool unRegisterObject(UAVDataObject *obj);
+    quint32 getGeneration();
+    UAVObjectSubscription* subscribe(const QList<UAVObject*>& objs, int rateHz, QObject* parent);
 signals:
     void newObject(UAVObject* obj);
     void newInstance(UAVObject* obj);
@@ -65,10 +68,20 @@ signals:
 private:
     static const quint32 MAX_INSTANCES = 1000;
     QHash<quint32, QMap<quint32,UAVObject*> > objects;
-    QHash<QString, QMap<quint32,UAVObject*> > objectsByName;
+    // Lookup index, the instances of each object are stored by instance ID
+    QHash<quint32, QVector<UAVObject*> > instancesById;
+    QHash<QString, quint32> idsByName;
+    // Bumped on every (un)registration, the cached vectors are rebuilt when it changes
+    quint32 generation;
+    quint32 cacheGeneration;
+    QVector< QVector<UAVObject*> > objectsVectorCache;
+    QVector< QVector<UAVDataObject*> > dataObjectsVectorCache;
+    QVector< QVector<UAVMetaObject*> > metaObjectsVectorCache;
     QMutex* mutex;
 
     void addObject(UAVObject* obj);
+    void updateIndex(quint32 objId);
+    void updateCaches();
     UAVObject* getObject(const QString& name, quint32 objId, quint32 instId);
     QVector<UAVObject*> getObjectInstancesVector(const QString* name, quint32 objId);
     qint32 getNumInstances(const QString* name, quint32 objId);
@@ -0,0 +1,437 @@
+/**
+ ******************************************************************************
+ *
+ * @file       LogConvertMex.c
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ *
+ * @note       This is an automatically generated file.
+ *             DO NOT modify manually.
+ *
+ * @brief      MEX parser of GCS logs for LogConvert.m
+ *
+ * Build it in MATLAB next to LogConvert.m, which then uses it instead of
+ * parsing the log in interpreted code. It is C99:
+ *
+ *   mex CFLAGS='$$CFLAGS -std=c99' LogConvertMex.c
+ *
+ *   objects = LogConvertMex(buffer)
+ *
+ * takes the body of a GCS log after the header lines as a uint8 vector and
+ * returns a struct with one field per object. Each of them is a struct
+ * like LogConvert.m makes: timestamp and instanceID as 1xN rows, fields
+ * with one element as 1xN rows and the others as elements x N matrices,
+ * all double. LogConvertMex() with no arguments returns the UAVO hash the
+ * parser was generated from.
+ *
+ * The log is scanned twice, once to count the updates of each object and
+ * once to fill the arrays, which are allocated in between at their final
+ * size.
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "mex.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char uavo_hash[] = "${UAVOSHA1TXT}";
+
+/* Framing of the log and of UAVTalk */
+#define LOG_HEADER_LENGTH   12	/* timestamp(4), packet size(8) */
+#define SYNC_VAL            0x3C
+#define TYPE_MASK           0x78
+#define TYPE_VER            0x20
+#define TYPE_OBJ            0x00
+#define TYPE_OBJ_ACK        0x02
+#define TYPE_OBJ_DELTA      0x05
+#define TYPE_OBJ_BUNDLE     0x06
+#define TYPE_OBJ_SNAPSHOT   0x86
+#define MIN_HEADER_LENGTH   8	/* sync(1), type(1), size(2), object ID(4) */
+#define CHECKSUM_LENGTH     1
+#define MAX_PACKET_LENGTH   (12 + 256 + CHECKSUM_LENGTH)
+#define DELTA_MASK_LENGTH   4
+#define DELTA_CHUNKS        32
+#define BUNDLE_ENTRY_LENGTH 5
+#define SNAPSHOT_TIME_LENGTH 4
+#define MAX_OBJECT_BYTES    256
+
+enum field_type {
+	FIELD_INT8, FIELD_INT16, FIELD_INT32,
+	FIELD_UINT8, FIELD_UINT16, FIELD_UINT32,
+	FIELD_FLOAT, FIELD_ENUM,
+};
+
+struct mex_field {
+	const char *name;
+	enum field_type type;
+	int elements;
+};
+
+struct mex_object {
+	uint32_t id;
+	const char *name;
+	bool single;
+	int num_bytes;
+	const struct mex_field *fields;
+	int num_fields;
+};
+
+$(MEXFIELDTABLES)
+static const struct mex_object objects[] = {
+$(MEXOBJECTTABLE)};
+
+#define NUM_OBJECTS (sizeof(objects) / sizeof(objects[0]))
+
+struct object_state {
+	size_t count;		/* updates found in the counting pass */
+	size_t row;		/* next update to fill */
+	double *timestamp;
+	double *instance;
+	double **columns;
+	bool have_last;		/* last has the object, to apply deltas to */
+	uint8_t last[MAX_OBJECT_BYTES];
+};
+
+static struct object_state state[NUM_OBJECTS];
+static size_t sorted[NUM_OBJECTS];
+static bool sorted_ready;
+static size_t unknown_objects;
+
+static uint16_t get_u16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static uint32_t get_u32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+static int compare_ids(const void *a, const void *b)
+{
+	uint32_t ia = objects[*(const size_t *)a].id;
+	uint32_t ib = objects[*(const size_t *)b].id;
+
+	return (ia > ib) - (ia < ib);
+}
+
+/* Binary search of the object table, returns NUM_OBJECTS if unknown */
+static size_t find_object(uint32_t id)
+{
+	size_t lo = 0, hi = NUM_OBJECTS;
+
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+		uint32_t mid_id = objects[sorted[mid]].id;
+
+		if (mid_id == id)
+			return sorted[mid];
+		if (mid_id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NUM_OBJECTS;
+}
+
+static double field_value(enum field_type type, const uint8_t *p)
+{
+	switch (type) {
+	case FIELD_INT8:
+		return (int8_t)p[0];
+	case FIELD_INT16:
+		return (int16_t)get_u16(p);
+	case FIELD_INT32:
+		return (int32_t)get_u32(p);
+	case FIELD_UINT16:
+		return get_u16(p);
+	case FIELD_UINT32:
+		return get_u32(p);
+	case FIELD_FLOAT:
+	{
+		uint32_t bits = get_u32(p);
+		float f;
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+	case FIELD_UINT8:
+	case FIELD_ENUM:
+	default:
+		return p[0];
+	}
+}
+
+static const int field_type_size[] = { 1, 2, 4, 1, 2, 4, 4, 1 };
+
+/* Count an update, or store it when the arrays exist */
+static void add_update(size_t idx, double timestamp, uint16_t instance, const uint8_t *data, bool fill)
+{
+	const struct mex_object *obj = &objects[idx];
+	struct object_state *st = &state[idx];
+
+	if (obj->single) {
+		memcpy(st->last, data, obj->num_bytes);
+		st->have_last = true;
+	}
+
+	if (!fill) {
+		st->count++;
+		return;
+	}
+
+	if (st->row >= st->count)
+		return;
+
+	size_t row = st->row++;
+	st->timestamp[row] = timestamp;
+	if (!obj->single)
+		st->instance[row] = instance;
+
+	for (int f = 0; f < obj->num_fields; f++) {
+		const struct mex_field *field = &obj->fields[f];
+		double *column = st->columns[f] + row * field->elements;
+		int size = field_type_size[field->type];
+
+		for (int e = 0; e < field->elements; e++) {
+			column[e] = field_value(field->type, data);
+			data += size;
+		}
+	}
+}
+
+/* The objects of a bundle, unknown ones are skipped */
+static void parse_bundle(const uint8_t *data, int length, double timestamp, bool fill)
+{
+	int pos = 0;
+
+	while (pos + BUNDLE_ENTRY_LENGTH <= length) {
+		uint32_t id = get_u32(data + pos);
+		int size = data[pos + 4];
+		pos += BUNDLE_ENTRY_LENGTH;
+
+		if (pos + size > length)
+			return;
+
+		size_t idx = find_object(id);
+		if (idx < NUM_OBJECTS && objects[idx].single && objects[idx].num_bytes == size)
+			add_update(idx, timestamp, 0, data + pos, fill);
+
+		pos += size;
+	}
+}
+
+/* Merge the changed chunks of a delta into the last data of the object */
+static bool apply_delta(size_t idx, const uint8_t *delta, int length, uint8_t *out)
+{
+	const struct mex_object *obj = &objects[idx];
+	struct object_state *st = &state[idx];
+
+	if (!st->have_last || length < DELTA_MASK_LENGTH)
+		return false;
+
+	int chunk = (obj->num_bytes + DELTA_CHUNKS - 1) / DELTA_CHUNKS;
+	uint32_t mask = get_u32(delta);
+	int pos = DELTA_MASK_LENGTH;
+
+	memcpy(out, st->last, obj->num_bytes);
+	for (int start = 0, i = 0; start < obj->num_bytes; start += chunk, i++) {
+		int size = (start + chunk > obj->num_bytes) ? obj->num_bytes - start : chunk;
+
+		if (mask & (1u << i)) {
+			if (pos + size > length)
+				return false;
+			memcpy(out + start, delta + pos, size);
+			pos += size;
+		}
+	}
+
+	return pos == length;
+}
+
+static void parse_packet(const uint8_t *packet, int length, double timestamp, bool fill)
+{
+	uint8_t type = packet[1];
+
+	if ((type & TYPE_MASK) != TYPE_VER)
+		return;
+	type &= ~TYPE_MASK;
+
+	const uint8_t *data = packet + MIN_HEADER_LENGTH;
+	int data_length = length - MIN_HEADER_LENGTH;
+
+	if (type == TYPE_OBJ_BUNDLE) {
+		parse_bundle(data, data_length, timestamp, fill);
+		return;
+	}
+
+	if (type == TYPE_OBJ_SNAPSHOT) {
+		if (data_length >= SNAPSHOT_TIME_LENGTH)
+			parse_bundle(data + SNAPSHOT_TIME_LENGTH, data_length - SNAPSHOT_TIME_LENGTH, timestamp, fill);
+		return;
+	}
+
+	if (type != TYPE_OBJ && type != TYPE_OBJ_ACK && type != TYPE_OBJ_DELTA)
+		return;
+
+	size_t idx = find_object(get_u32(packet + 4));
+	if (idx == NUM_OBJECTS) {
+		if (!fill)
+			unknown_objects++;
+		return;
+	}
+
+	const struct mex_object *obj = &objects[idx];
+
+	if (type == TYPE_OBJ_DELTA && obj->single) {
+		uint8_t merged[MAX_OBJECT_BYTES];
+
+		if (apply_delta(idx, data, data_length, merged))
+			add_update(idx, timestamp, 0, merged, fill);
+		return;
+	}
+
+	uint16_t instance = 0;
+	if (!obj->single) {
+		if (data_length < 2)
+			return;
+		instance = get_u16(data);
+		data += 2;
+		data_length -= 2;
+	}
+
+	if (data_length == obj->num_bytes)
+		add_update(idx, timestamp, instance, data, fill);
+}
+
+/* One pass over the log, records that do not frame a packet are skipped a byte at a time */
+static void scan_log(const uint8_t *buf, size_t length, bool fill)
+{
+	size_t pos = 0;
+	uint32_t last_timestamp = 0;
+	double timestamp_base = 0;
+
+	for (size_t i = 0; i < NUM_OBJECTS; i++)
+		state[i].have_last = false;
+
+	while (pos + LOG_HEADER_LENGTH + MIN_HEADER_LENGTH + CHECKSUM_LENGTH <= length) {
+		const uint8_t *record = buf + pos;
+		const uint8_t *packet = record + LOG_HEADER_LENGTH;
+		uint32_t size_lo = get_u32(record + 4);
+		uint32_t size_hi = get_u32(record + 8);
+
+		if (packet[0] != SYNC_VAL || size_hi != 0 ||
+				size_lo < MIN_HEADER_LENGTH + CHECKSUM_LENGTH || size_lo > MAX_PACKET_LENGTH ||
+				size_lo > length - pos - LOG_HEADER_LENGTH ||
+				(uint32_t)get_u16(packet + 2) + CHECKSUM_LENGTH != size_lo) {
+			pos++;
+			continue;
+		}
+
+		uint32_t timestamp = get_u32(record);
+		if (timestamp < last_timestamp)
+			timestamp_base += 4294967296.0;
+		last_timestamp = timestamp;
+
+		parse_packet(packet, size_lo - CHECKSUM_LENGTH, timestamp + timestamp_base, fill);
+
+		pos += LOG_HEADER_LENGTH + size_lo;
+	}
+}
+
+/* The struct LogConvert.m makes for one object, with room for all its updates */
+static mxArray *create_object(size_t idx)
+{
+	const struct mex_object *obj = &objects[idx];
+	struct object_state *st = &state[idx];
+	int extra = obj->single ? 1 : 2;
+	const char **names = mxMalloc((obj->num_fields + extra) * sizeof(*names));
+
+	names[0] = "timestamp";
+	if (!obj->single)
+		names[1] = "instanceID";
+	for (int f = 0; f < obj->num_fields; f++)
+		names[extra + f] = obj->fields[f].name;
+
+	mxArray *s = mxCreateStructMatrix(1, 1, obj->num_fields + extra, names);
+	mxFree(names);
+
+	mxArray *a = mxCreateDoubleMatrix(1, st->count, mxREAL);
+	st->timestamp = mxGetPr(a);
+	mxSetFieldByNumber(s, 0, 0, a);
+
+	if (!obj->single) {
+		a = mxCreateDoubleMatrix(1, st->count, mxREAL);
+		st->instance = mxGetPr(a);
+		mxSetFieldByNumber(s, 0, 1, a);
+	}
+
+	st->columns = mxMalloc(obj->num_fields * sizeof(*st->columns));
+	for (int f = 0; f < obj->num_fields; f++) {
+		a = mxCreateDoubleMatrix(obj->fields[f].elements, st->count, mxREAL);
+		st->columns[f] = mxGetPr(a);
+		mxSetFieldByNumber(s, 0, extra + f, a);
+	}
+
+	return s;
+}
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+	(void)nlhs;
+
+	if (nrhs == 0) {
+		plhs[0] = mxCreateString(uavo_hash);
+		return;
+	}
+
+	if (nrhs != 1 || !mxIsUint8(prhs[0]))
+		mexErrMsgTxt("Usage: objects = LogConvertMex(uint8 log body)");
+
+	if (!sorted_ready) {
+		for (size_t i = 0; i < NUM_OBJECTS; i++)
+			sorted[i] = i;
+		qsort(sorted, NUM_OBJECTS, sizeof(sorted[0]), compare_ids);
+		sorted_ready = true;
+	}
+
+	const uint8_t *buf = (const uint8_t *)mxGetData(prhs[0]);
+	size_t length = mxGetNumberOfElements(prhs[0]);
+
+	for (size_t i = 0; i < NUM_OBJECTS; i++) {
+		state[i].count = 0;
+		state[i].row = 0;
+	}
+	unknown_objects = 0;
+
+	scan_log(buf, length, false);
+
+	const char **names = mxMalloc(NUM_OBJECTS * sizeof(*names));
+	for (size_t i = 0; i < NUM_OBJECTS; i++)
+		names[i] = objects[i].name;
+	plhs[0] = mxCreateStructMatrix(1, 1, NUM_OBJECTS, names);
+	mxFree(names);
+
+	for (size_t i = 0; i < NUM_OBJECTS; i++)
+		mxSetFieldByNumber(plhs[0], 0, i, create_object(i));
+
+	scan_log(buf, length, true);
+
+	for (size_t i = 0; i < NUM_OBJECTS; i++) {
+		mxFree(state[i].columns);
+		state[i].columns = NULL;
+	}
+
+	if (unknown_objects > 0)
+		mexPrintf("%lu updates of unknown objects skipped\n", (unsigned long)unknown_objects);
+}
@@ -8,6 +8,7 @@ HEADERS += uavobjects_global.h \
     uavobject.h \
     uavmetaobject.h \
     uavobjectmanager.h \
+    uavobjectsubscription.h \
     uavdataobject.h \
     uavobjectfield.h \
     uavobjectsinit.h \
@@ -16,6 +17,7 @@ HEADERS += uavobjects_global.h \
 SOURCES += uavobject.cpp \
     uavmetaobject.cpp \
     uavobjectmanager.cpp \
+    uavobjectsubscription.cpp \
     uavdataobject.cpp \
     uavobjectfield.cpp \
     uavobjectsplugin.cpp
@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectsubscription.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#include "uavobjectsubscription.h"
+
+/**
+ * Constructor
+ * @param rateHz Maximum notification rate, usually the display frame rate
+ * @param parent Owner of the subscription
+ */
+UAVObjectSubscription::UAVObjectSubscription(int rateHz, QObject *parent) :
+    QObject(parent)
+{
+    timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(tick()));
+    setRate(rateHz);
+}
+
+UAVObjectSubscription::~UAVObjectSubscription()
+{
+}
+
+/**
+ * Start watching an object. Adding an object twice has no effect.
+ */
+void UAVObjectSubscription::addObject(UAVObject *obj)
+{
+    if (obj == NULL || watched.contains(obj))
+        return;
+
+    watched.insert(obj);
+    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)));
+    connect(obj, SIGNAL(destroyed(QObject*)), this, SLOT(objectDestroyed(QObject*)));
+}
+
+/**
+ * Stop watching an object and drop any update pending for it.
+ */
+void UAVObjectSubscription::removeObject(UAVObject *obj)
+{
+    if (!watched.remove(obj))
+        return;
+
+    disconnect(obj, 0, this, 0);
+    if (changed.remove(obj))
+        changedOrder.removeOne(obj);
+}
+
+/**
+ * Change the notification rate, a rate of zero or less uses the default.
+ */
+void UAVObjectSubscription::setRate(int rateHz)
+{
+    if (rateHz <= 0)
+        rateHz = DEFAULT_RATE_HZ;
+
+    timer->start(1000 / rateHz);
+}
+
+int UAVObjectSubscription::getRate() const
+{
+    return 1000 / timer->interval();
+}
+
+/**
+ * Remember that an object changed, only the first update in a tick is recorded.
+ */
+void UAVObjectSubscription::objectUpdated(UAVObject *obj)
+{
+    if (changed.contains(obj))
+        return;
+
+    changed.insert(obj);
+    changedOrder.append(obj);
+}
+
+/**
+ * Forget about objects that are deleted while watched.
+ */
+void UAVObjectSubscription::objectDestroyed(QObject *obj)
+{
+    // Only the pointer value is needed here, the object is already gone
+    UAVObject *uavo = static_cast<UAVObject*>(obj);
+
+    watched.remove(uavo);
+    if (changed.remove(uavo))
+        changedOrder.removeOne(uavo);
+}
+
+/**
+ * Deliver the objects that changed since the last tick, in the order of
+ * their first update.
+ */
+void UAVObjectSubscription::tick()
+{
+    if (changedOrder.isEmpty())
+        return;
+
+    QList<UAVObject*> objs;
+    objs.swap(changedOrder);
+    changed.clear();
+
+    emit objectsUpdated(objs);
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ *
+ * @file       uavobjectsubscription.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @see        The GNU Public License (GPL) Version 3
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVObjectsPlugin UAVObjects Plugin
+ * @{
+ * @brief      The UAVUObjects GCS plugin
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+#ifndef UAVOBJECTSUBSCRIPTION_H
+#define UAVOBJECTSUBSCRIPTION_H
+
+#include "uavobjects_global.h"
+#include "uavobject.h"
+#include <QObject>
+#include <QList>
+#include <QSet>
+#include <QTimer>
+
+/**
+ * Coalesced update notifications for display code.
+ *
+ * Instead of running a slot for every objectUpdated() of every object it
+ * watches, a subscriber gets one objectsUpdated() per frame tick carrying
+ * the objects that changed since the previous tick.  Each object appears at
+ * most once per tick however often it was updated in between.  Nothing is
+ * emitted on ticks where no watched object changed.
+ */
+class UAVOBJECTS_EXPORT UAVObjectSubscription: public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int DEFAULT_RATE_HZ = 30;
+
+    UAVObjectSubscription(int rateHz = DEFAULT_RATE_HZ, QObject *parent = 0);
+    ~UAVObjectSubscription();
+    void addObject(UAVObject *obj);
+    void removeObject(UAVObject *obj);
+    void setRate(int rateHz);
+    int getRate() const;
+
+signals:
+    void objectsUpdated(const QList<UAVObject*> &objs);
+
+private slots:
+    void objectUpdated(UAVObject *obj);
+    void objectDestroyed(QObject *obj);
+    void tick();
+
+private:
+    QTimer *timer;
+    QSet<UAVObject*> watched;
+    QSet<UAVObject*> changed;
+    QList<UAVObject*> changedOrder;
+};
+
+#endif // UAVOBJECTSUBSCRIPTION_H
@@ -44,9 +44,11 @@ $(FIELDDESCRIPTIONS_STRINGS)};
  */
 $(NAME)::$(NAME)(): UAVDataObject(OBJID, ISSINGLEINST, ISSETTINGS, NAME)
 {
-    // Create fields
+    // Create fields, their descriptors are shared by all instances
+    static const QList<UAVObjectField::DescriptorPtr> descriptors = createFieldDescriptors();
     QList<UAVObjectField*> fields;
-$(FIELDSINIT)
+    foreach (const UAVObjectField::DescriptorPtr &descriptor, descriptors)
+        fields.append(new UAVObjectField(descriptor));
     // Initialize object
     initializeFields(fields, (quint8*)&data, NUMBYTES);
     // Set the default field values
@@ -61,6 +63,16 @@ $(FIELDSINIT)
             SLOT(emitNotifications()));
 }
 
+/**
+ * Create the descriptors of the fields, once for all instances
+ */
+QList<UAVObjectField::DescriptorPtr> $(NAME)::createFieldDescriptors()
+{
+    QList<UAVObjectField::DescriptorPtr> descriptors;
+$(FIELDSINIT)
+    return descriptors;
+}
+
 /**
  * Get the default metadata for this object
  */
@@ -90,6 +102,41 @@ void $(NAME)::setDefaultFieldValues()
 $(INITFIELDS)
 }
 
+/**
+ * Pack the data, DataFields has the layout of the packed object so this is
+ * a copy and, on big endian hosts, a byte swap
+ */
+void $(NAME)::packData(quint8* dataOut)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    DataFields out = data;
+    swapData(out);
+    memcpy(dataOut, &out, NUMBYTES);
+#else
+    memcpy(dataOut, &data, NUMBYTES);
+#endif
+}
+
+/**
+ * Unpack the data, the counterpart of packData()
+ */
+void $(NAME)::unpackData(const quint8* dataIn)
+{
+    memcpy(&data, dataIn, NUMBYTES);
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    swapData(data);
+#endif
+}
+
+/**
+ * Convert the multi byte fields between host and little endian order
+ */
+void $(NAME)::swapData(DataFields& swapped)
+{
+    Q_UNUSED(swapped);
+$(DATASWAP)
+}
+
 /**
  * Get the object data fields
  */
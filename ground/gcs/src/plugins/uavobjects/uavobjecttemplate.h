@@ -99,6 +99,10 @@ private:
     DataFields data;
 
     void setDefaultFieldValues();
+    static QList<UAVObjectField::DescriptorPtr> createFieldDescriptors();
+    void packData(quint8* dataOut);
+    void unpackData(const quint8* dataIn);
+    static void swapData(DataFields& swapped);
 
 };
 
@@ -8,6 +8,9 @@ function [] = LogConvert(varargin)
 % To process Overo files call with
 % LogConvert(path_to_file, true)
 %
+% GCS logs are parsed much faster once the generated LogConvertMex.c
+% next to this file is compiled, see the instructions at its top.
+%
 % Tau Labs (C) 2012-2013
 
 %% Define indices and arrays of structures to hold data
@@ -96,6 +99,18 @@ end
 
 buffer=fread(fid,Inf,'uchar=>uchar');
 
+% Let the MEX parser do the whole log, if it is built from the same UAVOs
+useMex = ~overo && exist('LogConvertMex', 'file') == 3;
+if useMex && ~strcmp(LogConvertMex(), UAVO_HASH)
+	warning('LogConvertMex was built from other UAVOs, not using it.'); %#ok<WNTAG>
+	useMex = false;
+end
+if useMex
+	mexObjects = LogConvertMex(buffer);
+$(MEXCOPYCODE)
+	clear mexObjects;
+end
+
 
 bufferIdx=1;
 
@@ -121,7 +136,7 @@ end
 timestampAccumulator = 0;
 lastTimestamp = 0;
 
-while bufferIdx < (length(buffer) - 20)
+while ~useMex && bufferIdx < (length(buffer) - 20)
 	%% Read message header
 	% get sync field (0x3C, 1 byte)
 	if ~overo
@@ -277,12 +292,14 @@ end
 %% Clean Up and Save mat file
 fclose(fid);
 
+if ~useMex
 %% Prune vectors
 $(CLEANUPCODE)
 
 
 %% Perform typecasting on vectors
 $(ALLOCATIONCODE)
+end
 
 %% Save data to file
 if strcmpi(outputType,'mat')
@@ -34,7 +34,7 @@
 /**
  * Constructor
  */
-ConfigTaskWidget::ConfigTaskWidget(QWidget *parent) : QWidget(parent),currentBoard(0),isConnected(false),allowWidgetUpdates(true),smartsave(NULL),dirty(false),outOfLimitsStyle("background-color: rgb(255, 0, 0);"),timeOut(NULL)
+ConfigTaskWidget::ConfigTaskWidget(QWidget *parent) : QWidget(parent),currentBoard(0),isConnected(false),allowWidgetUpdates(true),smartsave(NULL),dirty(false),outOfLimitsStyle("background-color: rgb(255, 0, 0);"),timeOut(NULL),refreshPending(false)
 {
     pm = ExtensionSystem::PluginManager::instance();
     objManager = pm->getObject<UAVObjectManager>();
@@ -46,6 +46,10 @@ ConfigTaskWidget::ConfigTaskWidget(QWidget *parent) : QWidget(parent),currentBoa
     connect(telMngr, SIGNAL(disconnected()), this, SIGNAL(autoPilotDisconnected()),Qt::UniqueConnection);
     UAVSettingsImportExportFactory * importexportplugin =  pm->getObject<UAVSettingsImportExportFactory>();
     connect(importexportplugin,SIGNAL(importAboutToBegin()),this,SLOT(invalidateObjects()));
+    objectUpdatesSubscription = new UAVObjectSubscription(UAVObjectSubscription::DEFAULT_RATE_HZ, this);
+    connect(objectUpdatesSubscription, SIGNAL(objectsUpdated(QList<UAVObject*>)), this, SLOT(refreshUpdatedObjects(QList<UAVObject*>)));
+    // Subclasses override showEvent() without calling it, so catch the show through a filter
+    installEventFilter(this);
 }
 
 /**
@@ -185,7 +189,7 @@ void ConfigTaskWidget::addUAVObjectToWidgetRelation(QString object, QString fiel
         Q_ASSERT(obj);
         objectUpdates.insert(obj,true);
         connect(obj, SIGNAL(objectUpdated(UAVObject*)),this, SLOT(objectUpdated(UAVObject*)));
-        connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(refreshWidgetsValues(UAVObject*)), Qt::UniqueConnection);
+        objectUpdatesSubscription->addObject(obj);
         UAVDataObject *dobj = dynamic_cast<UAVDataObject *>(obj);
         if(dobj)
         {
@@ -594,10 +598,6 @@ bool ConfigTaskWidget::isAutopilotConnected()
 void ConfigTaskWidget::disableObjUpdates()
 {
     allowWidgetUpdates = false;
-    foreach(objectToWidget * obj,objOfInterest)
-    {
-        if(obj->object)disconnect(obj->object, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(refreshWidgetsValues(UAVObject*)));
-    }
 }
 /**
  * SLOT function used to enable widget contents changes when related object field changes
@@ -605,11 +605,6 @@ void ConfigTaskWidget::disableObjUpdates()
 void ConfigTaskWidget::enableObjUpdates()
 {
     allowWidgetUpdates = true;
-    foreach(objectToWidget * obj,objOfInterest)
-    {
-        if(obj->object)
-            connect(obj->object, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(refreshWidgetsValues(UAVObject*)), Qt::UniqueConnection);
-    }
 }
 /**
  * Called when an uav object is updated
@@ -619,6 +614,28 @@ void ConfigTaskWidget::objectUpdated(UAVObject *obj)
 {
     objectUpdates[obj]=true;
 }
+/**
+ * Refreshes the widgets of the objects updated during the last frame. When
+ * several objects arrived together, as after connecting or loading settings,
+ * all the widgets are refreshed once instead of once per object. Nothing is
+ * refreshed while the widget is hidden, that is done when it is shown again.
+ * @param objs the objects updated since the last refresh
+ */
+void ConfigTaskWidget::refreshUpdatedObjects(const QList<UAVObject *> &objs)
+{
+    if (!allowWidgetUpdates)
+        return;
+
+    if (!isVisible()) {
+        refreshPending = true;
+        return;
+    }
+
+    if (objs.count() == 1)
+        refreshWidgetsValues(objs.first());
+    else
+        refreshWidgetsValues();
+}
 /**
  * Checks if all objects added to the pool have already been updated
  * @return true if all objects added to the pool have already been updated
@@ -1396,6 +1413,12 @@ void ConfigTaskWidget::disableMouseWheelEvents()
 }
 
 bool ConfigTaskWidget::eventFilter( QObject * obj, QEvent * evt ) {
+    if ( obj == this && evt->type() == QEvent::Show && refreshPending )
+    {
+        refreshPending = false;
+        if ( allowWidgetUpdates )
+            refreshWidgetsValues();
+    }
     //Filter all wheel events, and ignore them
     if ( evt->type() == QEvent::Wheel &&
          (qobject_cast<QAbstractSpinBox*>( obj ) ||
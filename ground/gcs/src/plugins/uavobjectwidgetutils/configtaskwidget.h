@@ -34,6 +34,7 @@
 #include "uavobjectmanager.h"
 #include "uavobject.h"
 #include "uavobjectutilmanager.h"
+#include "uavobjectsubscription.h"
 #include <QQueue>
 #include <QWidget>
 #include <QList>
@@ -177,6 +178,7 @@ private slots:
     void defaultButtonClicked();
     void reloadButtonClicked();
     void doRefreshHiddenObjects(UAVDataObject*);
+    void refreshUpdatedObjects(const QList<UAVObject*> &objs);
 private:
     int currentBoard;
     bool isConnected;
@@ -200,6 +202,10 @@ private:
     void loadWidgetLimits(QWidget *widget, UAVObjectField *field, int index, bool hasLimits, double sclale);
     QString outOfLimitsStyle;
     QTimer * timeOut;
+    //! Coalesces the updates of all the objects of interest into one refresh per frame
+    UAVObjectSubscription *objectUpdatesSubscription;
+    //! Objects were updated while the widget was hidden, refresh when it is shown
+    bool refreshPending;
 protected slots:
     virtual void disableObjUpdates();
     virtual void enableObjUpdates();
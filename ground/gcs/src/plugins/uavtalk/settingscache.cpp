@@ -0,0 +1,165 @@
+/**
+ ******************************************************************************
+ *
+ * @file       settingscache.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief On disk copy of the settings of the boards seen so far
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "settingscache.h"
+#include "uavtalk.h"
+#include "uavdataobject.h"
+#include "uavmetaobject.h"
+#include "utils/pathutils.h"
+#include <QDir>
+#include <QSettings>
+
+SettingsCache::SettingsCache()
+{
+}
+
+/**
+ * Read the cached objects of a board
+ * \param[in] boardSerial CPU serial of the board
+ */
+void SettingsCache::load(const QByteArray& boardSerial)
+{
+    clear();
+    if (boardSerial.isEmpty())
+    {
+        return;
+    }
+    serial = boardSerial;
+
+    QSettings file(fileName(), QSettings::IniFormat);
+    foreach (QString key, file.childKeys())
+    {
+        bool ok;
+        quint32 objId = key.toUInt(&ok, 16);
+        if (ok)
+        {
+            objects.insert(objId, file.value(key).toByteArray());
+        }
+    }
+}
+
+/**
+ * Replace the cached objects of the current board with the actual values
+ * \param[in] list Objects retrieved from the board, the ones that can not
+ * be cached are skipped
+ */
+void SettingsCache::save(const QList<UAVObject*>& list)
+{
+    if (!isLoaded())
+    {
+        return;
+    }
+
+    objects.clear();
+    foreach (UAVObject* obj, list)
+    {
+        if (!isCacheable(obj))
+        {
+            continue;
+        }
+        QByteArray data(obj->getNumBytes(), 0);
+        if (obj->pack((quint8*)data.data()) > 0)
+        {
+            objects.insert(obj->getObjID(), data);
+        }
+    }
+
+    QDir().mkpath(QFileInfo(fileName()).absolutePath());
+    QSettings file(fileName(), QSettings::IniFormat);
+    file.clear();
+    QHash<quint32, QByteArray>::const_iterator i;
+    for (i = objects.constBegin(); i != objects.constEnd(); ++i)
+    {
+        file.setValue(QString::number(i.key(), 16), i.value());
+    }
+}
+
+/**
+ * Forget the current board
+ */
+void SettingsCache::clear()
+{
+    serial.clear();
+    objects.clear();
+}
+
+/**
+ * Settings and metadata only change when told to, that makes them worth
+ * caching. Multiple instance objects are left to the normal retrieval.
+ */
+bool SettingsCache::isCacheable(UAVObject* obj)
+{
+    if (!obj->isSingleInstance())
+    {
+        return false;
+    }
+    if (dynamic_cast<UAVMetaObject*>(obj) != NULL)
+    {
+        return true;
+    }
+    UAVDataObject* dobj = dynamic_cast<UAVDataObject*>(obj);
+    return dobj != NULL && dobj->isSettings();
+}
+
+bool SettingsCache::contains(UAVObject* obj) const
+{
+    QHash<quint32, QByteArray>::const_iterator i = objects.constFind(obj->getObjID());
+    return i != objects.constEnd() && i.value().size() == (int)obj->getNumBytes();
+}
+
+/**
+ * The CRC of the cached copy as the board computes it
+ */
+quint32 SettingsCache::getCrc(UAVObject* obj) const
+{
+    QByteArray data = objects.value(obj->getObjID());
+    return UAVTalk::objectCrc((const quint8*)data.constData(), data.size());
+}
+
+/**
+ * Load the cached copy into the object as if it came from the board
+ * \return true on success
+ */
+bool SettingsCache::restore(UAVObject* obj) const
+{
+    if (!contains(obj))
+    {
+        return false;
+    }
+    return obj->unpack((const quint8*)objects.value(obj->getObjID()).constData()) > 0;
+}
+
+QString SettingsCache::fileName() const
+{
+    return Utils::PathUtils().GetStoragePath() + "settingscache" + QDir::separator() +
+            QString(serial.toHex()) + ".ini";
+}
+
+/**
+ * @}
+ * @}
+ */
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ *
+ * @file       settingscache.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief On disk copy of the settings of the boards seen so far
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef SETTINGSCACHE_H
+#define SETTINGSCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include "uavobjectmanager.h"
+
+/**
+ * Keeps the packed settings and metadata objects of a board, keyed by the
+ * CPU serial of the board and the object id. The id changes with the
+ * definition of an object so entries never outlive the definition they
+ * were packed with. Cached values are only used after the board confirmed
+ * them with a CRC, see UAVTalk::sendObjectCrcRequest().
+ */
+class SettingsCache
+{
+public:
+    SettingsCache();
+
+    void load(const QByteArray& boardSerial);
+    void save(const QList<UAVObject*>& objects);
+    void clear();
+    bool isLoaded() const { return !serial.isEmpty(); }
+
+    static bool isCacheable(UAVObject* obj);
+    bool contains(UAVObject* obj) const;
+    quint32 getCrc(UAVObject* obj) const;
+    bool restore(UAVObject* obj) const;
+
+private:
+    QString fileName() const;
+
+    QByteArray serial;
+    QHash<quint32, QByteArray> objects;
+};
+
+#endif // SETTINGSCACHE_H
+
+/**
+ * @}
+ * @}
+ */
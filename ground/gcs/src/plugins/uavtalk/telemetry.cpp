@@ -94,6 +94,7 @@ Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
     // Listen to transaction completions
     connect(utalk, SIGNAL(ackReceived(UAVObject*)), this, SLOT(transactionSuccess(UAVObject*)));
     connect(utalk, SIGNAL(nackReceived(UAVObject*)), this, SLOT(transactionFailure(UAVObject*)));
+    connect(utalk, SIGNAL(crcReceived(UAVObject*,quint32)), this, SIGNAL(objectCrcReceived(UAVObject*,quint32)));
     // Get GCS stats object
     gcsStatsObj = GCSTelemetryStats::GetInstance(objMngr);
     // Setup and start the periodic timer
@@ -106,6 +107,15 @@ Telemetry::Telemetry(UAVTalk* utalk, UAVObjectManager* objMngr)
     txRetries = 0;
 }
 
+/**
+ * Ask the board for the CRC of an object instance, the answer comes with
+ * objectCrcReceived(). There are no retries, old firmware never answers.
+ */
+bool Telemetry::requestObjectCrc(UAVObject* obj)
+{
+    return utalk->sendObjectCrcRequest(obj);
+}
+
 Telemetry::~Telemetry()
 {
     for (QMap<TransactionKey, ObjectTransactionInfo*>::iterator itr = transMap.begin(); itr != transMap.end(); ++itr) {
@@ -79,9 +79,11 @@ public:
     ~Telemetry();
     TelemetryStats getStats();
     void resetStats();
+    bool requestObjectCrc(UAVObject* obj);
     void transactionTimeout(ObjectTransactionInfo *info);
 
 signals:
+    void objectCrcReceived(UAVObject* obj, quint32 crc);
 
 private:
     // Constants
@@ -31,13 +31,23 @@
 #include <coreplugin/icore.h>
 #include <coreplugin/threadmanager.h>
 
-TelemetryManager::TelemetryManager() :
+/**
+ * @brief TelemetryManager::TelemetryManager Creates the telemetry of a link
+ * @param objMngr The objects of the vehicle on the link, NULL for the global
+ * object manager of the connection manager link
+ * @param thread Thread running the link, NULL for the real time thread
+ */
+TelemetryManager::TelemetryManager(UAVObjectManager* objMngr, QThread* thread) :
+    objMngr(objMngr),
+    primary(objMngr == NULL),
+    utalk(NULL),
+    frameSink(NULL),
     autopilotConnected(false)
 {
-    moveToThread(Core::ICore::instance()->threadManager()->getRealTimeThread());
-    // Get UAVObjectManager instance
+    moveToThread(thread ? thread : Core::ICore::instance()->threadManager()->getRealTimeThread());
     ExtensionSystem::PluginManager* pm = ExtensionSystem::PluginManager::instance();
-    objMngr = pm->getObject<UAVObjectManager>();
+    if (primary)
+        this->objMngr = pm->getObject<UAVObjectManager>();
 
     // connect to start stop signals
     connect(this, SIGNAL(myStart()), this, SLOT(onStart()),Qt::QueuedConnection);
@@ -56,6 +66,55 @@ bool TelemetryManager::isConnected()
     return autopilotConnected;
 }
 
+/**
+ * @brief TelemetryManager::sendObjectBundle Sends objects in bundles, bypassing the
+ * update modes of the telemetry. Only to be called from the telemetry thread.
+ * @return false if not connected or a packet was not sent
+ */
+bool TelemetryManager::sendObjectBundle(const QList<UAVObject*>& objs)
+{
+    if (!autopilotConnected || utalk == NULL)
+        return false;
+
+    return utalk->sendObjectBundle(objs);
+}
+
+/**
+ * @brief TelemetryManager::streamObject Sends the current data of an object unacked
+ * from the telemetry thread, ahead of the transaction queue of the telemetry and
+ * regardless of its update mode. For control streams where a late frame is worth
+ * less than a lost one. Can be called from any thread.
+ * @return false if not connected
+ */
+bool TelemetryManager::streamObject(UAVObject* obj)
+{
+    if (!autopilotConnected)
+        return false;
+
+    QMetaObject::invokeMethod(this, "onStreamObject", Qt::QueuedConnection, Q_ARG(UAVObject*, obj));
+    return true;
+}
+
+void TelemetryManager::onStreamObject(UAVObject* obj)
+{
+    if (autopilotConnected && utalk != NULL)
+        utalk->sendObject(obj, false, false);
+}
+
+/**
+ * @brief TelemetryManager::setFrameSink Gives the sink a copy of the object frames
+ * of this and all later connections. Can be called from any thread.
+ * @param sink The sink, NULL to stop. The previous sink is not called anymore once
+ * this returns.
+ */
+void TelemetryManager::setFrameSink(UAVTalkFrameSink* sink)
+{
+    QMutexLocker locker(&frameSinkMutex);
+    frameSink = sink;
+    if (utalk)
+        utalk->setFrameSink(sink);
+}
+
 void TelemetryManager::start(QIODevice *dev)
 {
     device=dev;
@@ -64,9 +123,12 @@ void TelemetryManager::start(QIODevice *dev)
 
 void TelemetryManager::onStart()
 {
+    frameSinkMutex.lock();
     utalk = new UAVTalk(device, objMngr);
+    utalk->setFrameSink(frameSink);
+    frameSinkMutex.unlock();
     telemetry = new Telemetry(utalk, objMngr);
-    telemetryMon = new TelemetryMonitor(objMngr, telemetry, sessions);
+    telemetryMon = new TelemetryMonitor(objMngr, telemetry, sessions, primary);
     connect(telemetryMon, SIGNAL(connected()), this, SLOT(onConnect()));
     connect(telemetryMon, SIGNAL(disconnected()), this, SLOT(onDisconnect()));
 }
@@ -83,7 +145,10 @@ void TelemetryManager::onStop()
     sessions = telemetryMon->savedSessions();
     delete telemetryMon;
     delete telemetry;
+    frameSinkMutex.lock();
     delete utalk;
+    utalk = NULL;
+    frameSinkMutex.unlock();
     onDisconnect();
 }
 
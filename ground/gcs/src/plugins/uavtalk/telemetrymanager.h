@@ -38,18 +38,23 @@
 #include "uavobjectmanager.h"
 #include <QIODevice>
 #include <QObject>
+#include <QMutex>
+#include <QThread>
 
 class UAVTALK_EXPORT TelemetryManager: public QObject
 {
     Q_OBJECT
 
 public:
-    TelemetryManager();
+    TelemetryManager(UAVObjectManager* objMngr = NULL, QThread* thread = NULL);
     ~TelemetryManager();
 
     void start(QIODevice *dev);
     void stop();
     bool isConnected();
+    bool sendObjectBundle(const QList<UAVObject*>& objs);
+    bool streamObject(UAVObject* obj);
+    void setFrameSink(UAVTalkFrameSink* sink);
 
 signals:
     void connected();
@@ -63,12 +68,16 @@ private slots:
     void onStart();
     void onStop();
     void onGeneralSettingsChanged();
+    void onStreamObject(UAVObject* obj);
 private:
     UAVObjectManager* objMngr;
+    bool primary;
     UAVTalk* utalk;
     Telemetry* telemetry;
     TelemetryMonitor* telemetryMon;
     QIODevice *device;
+    QMutex frameSinkMutex;
+    UAVTalkFrameSink* frameSink;
     bool autopilotConnected;
     QHash<quint16, QList<TelemetryMonitor::objStruc> > sessions;
     Core::Internal::GeneralSettings *settings;
@@ -44,6 +44,13 @@
 #define OBJECT_RETRIEVE_TIMEOUT             5000
 //IAP object is very important, retry if not able to get it the first time
 #define IAP_OBJECT_RETRIES                  3
+//Number of object requests kept outstanding while retrieving objects, this keeps
+//the link busy instead of waiting a round trip per object. The smallest boards
+//only buffer 32 bytes of incoming telemetry while they answer, that is three requests.
+#define OBJECT_RETRIEVE_WINDOW              3
+//Time to wait for the CRC of a cached settings object before asking for the object
+//itself, firmware without support for CRC requests does not answer at all
+#define CRC_RETRIEVE_TIMEOUT                1000
 
 #ifdef TELEMETRYMONITOR_DEBUG
   #define TELEMETRYMONITOR_QXTLOG_DEBUG(...) qDebug()<<__VA_ARGS__
@@ -53,13 +60,17 @@
 
 /**
  * Constructor
+ * @param primary Whether this is the link of the connection manager, which
+ * shows its state and rates. The links of other vehicles are not shown there.
  */
-TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QHash<quint16, QList<objStruc> > sessions) :
+TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QHash<quint16, QList<objStruc> > sessions, bool primary) :
     connectionStatus(CON_DISCONNECTED),
     objMngr(objMngr),
     tel(tel),
     numberOfObjects(0),
     retries(0),
+    crcSupported(true),
+    crcAnswered(false),
     isManaged(true),
     sessions(sessions)
 {
@@ -83,18 +94,24 @@ TelemetryMonitor::TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QH
     sessionRetrieveTimeout->setSingleShot(true);
     objectRetrieveTimeout = new QTimer(this);
     objectRetrieveTimeout->setSingleShot(true);
+    crcRetrieveTimeout = new QTimer(this);
+    crcRetrieveTimeout->setSingleShot(true);
     sessionInitialRetrieveTimeout = new QTimer(this);
     sessionInitialRetrieveTimeout->setSingleShot(true);
     connect(statsTimer, SIGNAL(timeout()), this, SLOT(processStatsUpdates()));
     connect(sessionRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionRetrieveTimeoutCB()));
     connect(sessionInitialRetrieveTimeout,SIGNAL(timeout()),this,SLOT(sessionInitialRetrieveTimeoutCB()));
     connect(objectRetrieveTimeout,SIGNAL(timeout()),this,SLOT(objectRetrieveTimeoutCB()));
+    connect(crcRetrieveTimeout,SIGNAL(timeout()),this,SLOT(crcRetrieveTimeoutCB()));
+    connect(tel,SIGNAL(objectCrcReceived(UAVObject*,quint32)),this,SLOT(objectCrcReceived(UAVObject*,quint32)));
     statsTimer->start(STATS_CONNECT_PERIOD_MS);
 
-    Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
-    connect(this,SIGNAL(connected()),cm,SLOT(telemetryConnected()));
-    connect(this,SIGNAL(disconnected()),cm,SLOT(telemetryDisconnected()));
-    connect(this,SIGNAL(telemetryUpdated(double,double)),cm,SLOT(telemetryUpdated(double,double)));
+    if (primary) {
+        Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
+        connect(this,SIGNAL(connected()),cm,SLOT(telemetryConnected()));
+        connect(this,SIGNAL(disconnected()),cm,SLOT(telemetryDisconnected()));
+        connect(this,SIGNAL(telemetryUpdated(double,double)),cm,SLOT(telemetryUpdated(double,double)));
+    }
     connect(sessionObj,SIGNAL(objectUnpacked(UAVObject*)),this,SLOT(sessionObjUnpackedCB(UAVObject*)));
     connect(objMngr,SIGNAL(newInstance(UAVObject*)),this,SLOT(newInstanceSlot(UAVObject*)));
 
@@ -131,6 +148,10 @@ void TelemetryMonitor::startRetrievingObjects()
     connectionStatus = CON_RETRIEVING_OBJECTS;
     // Get all objects, add metaobjects, settings and data objects with OnChange update mode to the queue
     queue.clear();
+    pending.clear();
+    crcPending.clear();
+    settingsCache.clear();
+    crcAnswered = false;
     retries = 0;
     objectRetrieveTimeout->start(OBJECT_RETRIEVE_TIMEOUT);
     foreach(UAVObjectManager::ObjectMap map, objMngr->getObjects().values())
@@ -169,6 +190,13 @@ void TelemetryMonitor::startRetrievingObjects()
             }
         }
     }
+    // The board serial selects the settings cache, get it before anything else
+    UAVObject* iapObj = FirmwareIAPObj::GetInstance(objMngr);
+    if (queue.removeOne(iapObj))
+    {
+        queue.prepend(iapObj);
+    }
+    retrieved = queue;
     // Start retrieving
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString(tr("Starting to retrieve meta and settings objects from the autopilot (%1 objects)"))
                                   .arg( queue.length()));
@@ -230,12 +258,36 @@ void TelemetryMonitor::changeObjectInstances(quint32 objID, quint32 instID, bool
 }
 
 /**
- * Retrieve the next object in the queue
+ * Retrieve the next objects in the queue, up to OBJECT_RETRIEVE_WINDOW
+ * requests are outstanding at any time. Objects found in the settings cache
+ * of the board are only checked by CRC.
  */
 void TelemetryMonitor::retrieveNextObject()
 {
-    // If queue is empty return
-    if ( queue.isEmpty() )
+    UAVObject* iapObj = FirmwareIAPObj::GetInstance(objMngr);
+    while ( !queue.isEmpty() && pending.count() < OBJECT_RETRIEVE_WINDOW && !pending.contains(iapObj) )
+    {
+        // Get next object from the queue
+        UAVObject* obj = queue.dequeue();
+        pending.insert(obj);
+        if (crcSupported && SettingsCache::isCacheable(obj) && settingsCache.contains(obj))
+        {
+            TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 requesting CRC of %1 from board").arg(Q_FUNC_INFO).arg(obj->getName()));
+            crcPending.insert(obj);
+            tel->requestObjectCrc(obj);
+            crcRetrieveTimeout->start(CRC_RETRIEVE_TIMEOUT);
+            continue;
+        }
+        // Connect to object
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 requestiong %1 from board INSTID:%2").arg(Q_FUNC_INFO).arg(obj->getName()).arg(obj->getInstID()));
+        connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)), Qt::UniqueConnection);
+        // Request update, a failure to queue it completes the transaction right away
+        obj->requestUpdateAllInstances();
+    }
+
+    // Done once the queue is empty and all the answers are in, this can be
+    // reached again from a nested completion
+    if ( queue.isEmpty() && pending.isEmpty() && connectionStatus == CON_RETRIEVING_OBJECTS )
     {
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 Object retrieval completed").arg(Q_FUNC_INFO));
         if(isManaged)
@@ -255,19 +307,13 @@ void TelemetryMonitor::retrieveNextObject()
             uavo->setIsPresentOnHardware(true);
         }
         delayedUpdate.clear();
+        settingsCache.save(retrieved);
+        retrieved.clear();
         emit connected();
         sessionRetrieveTimeout->stop();
         sessionInitialRetrieveTimeout->stop();
         objectRetrieveTimeout->stop();
-        return;
     }
-    // Get next object from the queue
-    UAVObject* obj = queue.dequeue();
-    // Connect to object
-    TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 requestiong %1 from board INSTID:%2").arg(Q_FUNC_INFO).arg(obj->getName()).arg(obj->getInstID()));
-    connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)));
-    // Request update
-    obj->requestUpdateAllInstances();
 }
 
 /**
@@ -278,17 +324,85 @@ void TelemetryMonitor::transactionCompleted(UAVObject* obj, bool success)
     TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 received %1 OBJID:%2 result:%3").arg(Q_FUNC_INFO).arg(obj->getName()).arg(obj->getObjID()).arg(success));
     Q_UNUSED(success);
     QMutexLocker locker(mutex);
-    if(obj->getObjID() == FirmwareIAPObj::OBJID)
+    if(obj->getObjID() == FirmwareIAPObj::OBJID && pending.contains(obj))
     {
         if(!success && (retries < IAP_OBJECT_RETRIES))
         {
+            // Keep it outstanding until the retry completes
             ++retries;
             obj->requestUpdate();
+            return;
         }
     }
     // Disconnect from sending object
     obj->disconnect(this);
-    // Process next object if telemetry is still available
+    // Answers to an earlier, abandoned retrieval are of no interest
+    if (!pending.remove(obj))
+    {
+        return;
+    }
+    if (obj->getObjID() == FirmwareIAPObj::OBJID && success)
+    {
+        FirmwareIAPObj::DataFields iapData = FirmwareIAPObj::GetInstance(objMngr)->getData();
+        QByteArray serial;
+        for (unsigned int i = 0; i < FirmwareIAPObj::CPUSERIAL_NUMELEM; i++)
+            serial.append(iapData.CPUSerial[i]);
+        settingsCache.load(serial);
+    }
+    continueRetrieving();
+}
+
+/**
+ * Called when the board answered a CRC request for a cached object, a match
+ * restores the cached value, anything else asks for the object itself
+ */
+void TelemetryMonitor::objectCrcReceived(UAVObject* obj, quint32 crc)
+{
+    QMutexLocker locker(mutex);
+    if (!crcPending.remove(obj))
+    {
+        return;
+    }
+    crcAnswered = true;
+    if (crcPending.isEmpty())
+    {
+        crcRetrieveTimeout->stop();
+    }
+    if (crc == settingsCache.getCrc(obj) && settingsCache.restore(obj))
+    {
+        TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 %1 restored from the settings cache").arg(Q_FUNC_INFO).arg(obj->getName()));
+        pending.remove(obj);
+        continueRetrieving();
+        return;
+    }
+    connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)), Qt::UniqueConnection);
+    obj->requestUpdateAllInstances();
+}
+
+/**
+ * Ask for the objects whose CRC did not come back, when no CRC came back at all
+ * the board does not know CRC requests and the cache is not used anymore
+ */
+void TelemetryMonitor::crcRetrieveTimeoutCB()
+{
+    QMutexLocker locker(mutex);
+    if (!crcAnswered)
+    {
+        crcSupported = false;
+    }
+    foreach (UAVObject* obj, crcPending)
+    {
+        connect(obj, SIGNAL(transactionCompleted(UAVObject*,bool)), this, SLOT(transactionCompleted(UAVObject*,bool)), Qt::UniqueConnection);
+        obj->requestUpdateAllInstances();
+    }
+    crcPending.clear();
+}
+
+/**
+ * Process the next objects if telemetry is still available
+ */
+void TelemetryMonitor::continueRetrieving()
+{
     GCSTelemetryStats::DataFields gcsStats = gcsStatsObj->getData();
     if ( gcsStats.Status == GCSTelemetryStats::STATUS_CONNECTED )
     {
@@ -299,7 +413,11 @@ void TelemetryMonitor::transactionCompleted(UAVObject* obj, bool success)
     {
         TELEMETRYMONITOR_QXTLOG_DEBUG(QString("%0 connection lost while retrieving objects, stopped object retrievel").arg(Q_FUNC_INFO));
         queue.clear();
+        pending.clear();
+        crcPending.clear();
+        retrieved.clear();
         objectRetrieveTimeout->stop();
+        crcRetrieveTimeout->stop();
         sessionRetrieveTimeout->stop();
         sessionInitialRetrieveTimeout->stop();
         connectionStatus = CON_DISCONNECTED;
@@ -31,6 +31,7 @@
 
 #include <QObject>
 #include <QQueue>
+#include <QSet>
 #include <QTimer>
 #include <QTime>
 #include <QMutex>
@@ -41,6 +42,7 @@
 #include "systemstats.h"
 #include "telemetry.h"
 #include "sessionmanaging.h"
+#include "settingscache.h"
 #include <coreplugin/generalsettings.h>
 #include <extensionsystem/pluginmanager.h>
 
@@ -55,7 +57,7 @@ public:
         quint32 instID;
     };
 
-    TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QHash<quint16, QList<objStruc> > sessions);
+    TelemetryMonitor(UAVObjectManager* objMngr, Telemetry* tel, QHash<quint16, QList<objStruc> > sessions, bool primary = true);
     ~TelemetryMonitor();
     QHash<quint16, QList<objStruc> > savedSessions() {return sessions;}
 signals:
@@ -68,9 +70,11 @@ public slots:
     void processStatsUpdates();
     void flightStatsUpdated(UAVObject* obj);
     void checkSessionObjNacked(UAVObject*, bool, bool);
+    void objectCrcReceived(UAVObject* obj, quint32 crc);
 private slots:
     void sessionObjUnpackedCB(UAVObject*obj);
     void objectRetrieveTimeoutCB();
+    void crcRetrieveTimeoutCB();
     void sessionRetrieveTimeoutCB();
     void sessionInitialRetrieveTimeoutCB();
     void saveSession();
@@ -85,6 +89,12 @@ private:
     UAVObjectManager* objMngr;
     Telemetry* tel;
     QQueue<UAVObject*> queue;
+    QSet<UAVObject*> pending;
+    QSet<UAVObject*> crcPending;
+    QList<UAVObject*> retrieved;
+    SettingsCache settingsCache;
+    bool crcSupported;
+    bool crcAnswered;
     GCSTelemetryStats* gcsStatsObj;
     FlightTelemetryStats* flightStatsObj;
     QTimer* statsTimer;
@@ -96,12 +106,14 @@ private:
     quint16 sessionID;
     quint8 numberOfObjects;
     QTimer* objectRetrieveTimeout;
+    QTimer* crcRetrieveTimeout;
     QTimer* sessionRetrieveTimeout;
     QTimer* sessionInitialRetrieveTimeout;
     int retries;
     void changeObjectInstances(quint32 objID, quint32 instID, bool delayed);
     void startSessionRetrieving(UAVObject *session);
     void sessionFallback();
+    void continueRetrieving();
     bool isManaged;
     QHash<quint16, QList<objStruc> > sessions;
     int sessionObjRetries;
@@ -71,15 +71,26 @@ UAVTalk::UAVTalk(QIODevice* iodev, UAVObjectManager* objMngr)
 
     rxState = STATE_SYNC;
     rxPacketLength = 0;
+    frameSink = NULL;
 
     mutex = new QMutex(QMutex::Recursive);
 
     memset(&stats, 0, sizeof(ComStats));
 
     connect(io, SIGNAL(readyRead()), this, SLOT(processInputStream()));
+
+    // Log replays hand over whole frames that point into the mapped log
+    // file instead of going through readAll(). The call blocks until they
+    // are decoded so the frames stay valid while they are parsed.
+    if (io->metaObject()->indexOfSignal("replayFrames(QVector<QByteArray>)") >= 0) {
+        qRegisterMetaType<QVector<QByteArray> >("QVector<QByteArray>");
+        connect(io, SIGNAL(replayFrames(QVector<QByteArray>)), this, SLOT(processInputFrames(QVector<QByteArray>)),
+                io->thread() == thread() ? Qt::DirectConnection : Qt::BlockingQueuedConnection);
+    }
+    // Command line tools use UAVTalk without a plugin manager or settings
     ExtensionSystem::PluginManager *pm = ExtensionSystem::PluginManager::instance();
-    Core::Internal::GeneralSettings * settings=pm->getObject<Core::Internal::GeneralSettings>();
-    useUDPMirror=settings->useUDPMirror();
+    Core::Internal::GeneralSettings * settings = pm ? pm->getObject<Core::Internal::GeneralSettings>() : NULL;
+    useUDPMirror = settings ? settings->useUDPMirror() : false;
     UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Use UDP:%0").arg(useUDPMirror));
     if(useUDPMirror)
     {
@@ -109,6 +120,38 @@ void UAVTalk::resetStats()
     memset(&stats, 0, sizeof(ComStats));
 }
 
+/**
+ * Hand a copy of every object frame that is received or sent to a sink
+ * \param[in] sink The sink, NULL to stop. Once this returns the previous
+ * sink is no longer called.
+ */
+void UAVTalk::setFrameSink(UAVTalkFrameSink* sink)
+{
+    QMutexLocker locker(mutex);
+    frameSink = sink;
+}
+
+/**
+ * Pass a complete frame to the frame sink if it carries object data
+ * \param[in] frame The frame including the checksum
+ * \param[in] length Length of the frame
+ */
+void UAVTalk::tapFrame(const quint8* frame, qint32 length)
+{
+    if (frameSink == NULL)
+    {
+        return;
+    }
+
+    quint8 type = frame[1];
+    if (type != TYPE_OBJ && type != TYPE_OBJ_ACK && type != TYPE_OBJ_DELTA && type != TYPE_OBJ_BUNDLE)
+    {
+        return;
+    }
+
+    frameSink->frame(frame, length);
+}
+
 /**
  * Get the statistics counters
  */
@@ -123,17 +166,155 @@ UAVTalk::ComStats UAVTalk::getStats()
  */
 void UAVTalk::processInputStream()
 {
-    quint8 tmp;
-
     if (io && io->isReadable()) {
         while (io->bytesAvailable() > 0)
         {
-            io->read((char*)&tmp, 1);
-            processInputByte(tmp);
+            QByteArray data = io->readAll();
+            processInputBuffer((const quint8*)data.constData(), data.size());
+        }
+    }
+}
+
+/**
+ * Called with complete frames by devices that replay from memory
+ */
+void UAVTalk::processInputFrames(const QVector<QByteArray> &frames)
+{
+    foreach (const QByteArray &frame, frames)
+        processInputBuffer((const quint8*)frame.constData(), frame.size());
+}
+
+/**
+ * Process a block of bytes from the telemetry stream. Garbage between
+ * packets is skipped with memchr() and packets that are complete in the
+ * block are parsed in place, only packets split across blocks go through
+ * the byte state machine.
+ * \param[in] data Received bytes
+ * \param[in] length Number of bytes
+ */
+void UAVTalk::processInputBuffer(const quint8* data, qint32 length)
+{
+    const quint8* end = data + length;
+
+    while (data < end)
+    {
+        if (rxState == STATE_SYNC)
+        {
+            // Skip everything up to the next sync byte in one go
+            const quint8* sync = (const quint8*)memchr(data, SYNC_VAL, end - data);
+            if (sync == NULL)
+            {
+                stats.rxBytes += end - data;
+                return;
+            }
+            stats.rxBytes += sync - data;
+            data = sync;
+
+            qint32 used = processFrame(data, end - data);
+            if (used > 0)
+            {
+                data += used;
+                continue;
+            }
         }
+
+        processInputByte(*data++);
     }
 }
 
+/**
+ * Parse a packet that starts at the beginning of a buffer in one go.
+ * \param[in] frame Received bytes starting with a sync byte
+ * \param[in] length Number of bytes available
+ * \return The length of the packet, or 0 if it is not complete in the buffer
+ * or not a valid update of a known object. Those cases are left to
+ * processInputByte(), which also takes care of resyncing and NACKs.
+ */
+qint32 UAVTalk::processFrame(const quint8* frame, qint32 length)
+{
+    if (length < MIN_HEADER_LENGTH + CHECKSUM_LENGTH)
+    {
+        return 0;
+    }
+
+    quint8 type = frame[1];
+    qint32 size = qFromLittleEndian<quint16>(frame + 2);
+    quint32 objId = qFromLittleEndian<quint32>(frame + 4);
+
+    if ((type & TYPE_MASK) != TYPE_VER || size < MIN_HEADER_LENGTH ||
+            size > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH || size + CHECKSUM_LENGTH > length)
+    {
+        return 0;
+    }
+
+    // Determine the header and data length like the state machine does
+    qint32 headerLength = MIN_HEADER_LENGTH;
+    quint16 instId = 0;
+    qint32 dataLength;
+    if (type == TYPE_OBJ_BUNDLE)
+    {
+        dataLength = size - headerLength;
+    }
+    else
+    {
+        UAVObject *obj = objMngr->getObject(objId);
+        if (obj == NULL)
+        {
+            return 0;
+        }
+
+        if (!obj->isSingleInstance())
+        {
+            if (size < MAX_HEADER_LENGTH)
+            {
+                return 0;
+            }
+            instId = qFromLittleEndian<quint16>(frame + MIN_HEADER_LENGTH);
+            headerLength = MAX_HEADER_LENGTH;
+        }
+
+        if (type == TYPE_OBJ_REQ || type == TYPE_ACK || type == TYPE_NACK)
+        {
+            dataLength = 0;
+        }
+        else if ((type == TYPE_OBJ_DELTA && obj->isSingleInstance()) || type == TYPE_OBJ_CRC)
+        {
+            dataLength = size - headerLength;
+        }
+        else
+        {
+            dataLength = obj->getNumBytes();
+        }
+    }
+
+    if (dataLength >= MAX_PAYLOAD_LENGTH || headerLength + dataLength != size)
+    {
+        return 0;
+    }
+
+    // Check the CRC over the whole packet at once
+    if (updateCRC(0, frame, size) != frame[size])
+    {
+        return 0;
+    }
+
+    memcpy(rxBuffer, frame + headerLength, dataLength);
+    stats.rxBytes += size + CHECKSUM_LENGTH;
+
+    mutex->lock();
+        receiveObject(type, objId, instId, rxBuffer, dataLength);
+        tapFrame(frame, size + CHECKSUM_LENGTH);
+        if(useUDPMirror)
+        {
+            udpSocketTx->writeDatagram((const char*)frame, size + CHECKSUM_LENGTH, QHostAddress::LocalHost, udpSocketRx->localPort());
+        }
+        stats.rxObjectBytes += dataLength;
+        stats.rxObjects++;
+    mutex->unlock();
+
+    return size + CHECKSUM_LENGTH;
+}
+
 void UAVTalk::dummyUDPRead()
 {
     QUdpSocket *socket=qobject_cast<QUdpSocket*>(sender());
@@ -158,6 +339,95 @@ bool UAVTalk::sendObjectRequest(UAVObject* obj, bool allInstances)
     return objectTransaction(obj, TYPE_OBJ_REQ, allInstances);
 }
 
+/**
+ * Send several objects as bundles, with as many objects in each packet as
+ * fit. Objects that can't be bundled are sent on their own, after the
+ * bundles.
+ * \param[in] objs Objects to send, unacked
+ * \return Success (true), Failure (false) if any packet was not sent
+ */
+bool UAVTalk::sendObjectBundle(const QList<UAVObject*>& objs)
+{
+    QMutexLocker locker(mutex);
+
+    quint8 buffer[MIN_HEADER_LENGTH + BUNDLE_MAX_PAYLOAD + CHECKSUM_LENGTH];
+    QList<UAVObject*> single;
+    qint32 length = 0;
+    bool ok = true;
+
+    foreach (UAVObject* obj, objs)
+    {
+        qint32 numBytes = obj->getNumBytes();
+        if (!obj->isSingleInstance() || numBytes > BUNDLE_MAX_OBJECT)
+        {
+            single.append(obj);
+            continue;
+        }
+
+        if (length + BUNDLE_ENTRY_LENGTH + numBytes > BUNDLE_MAX_PAYLOAD)
+        {
+            ok &= transmitBundle(buffer, length);
+            length = 0;
+        }
+
+        quint8* entry = &buffer[MIN_HEADER_LENGTH + length];
+        qToLittleEndian<quint32>(obj->getObjID(), entry);
+        entry[4] = numBytes;
+        if (!obj->pack(entry + BUNDLE_ENTRY_LENGTH))
+        {
+            ok = false;
+            continue;
+        }
+        length += BUNDLE_ENTRY_LENGTH + numBytes;
+    }
+
+    if (length > 0)
+    {
+        ok &= transmitBundle(buffer, length);
+    }
+
+    foreach (UAVObject* obj, single)
+    {
+        ok &= objectTransaction(obj, TYPE_OBJ, false);
+    }
+
+    return ok;
+}
+
+/**
+ * Ask the remote end for the CRC of an object instance, the answer is
+ * signalled with crcReceived(). Boards that do not support this don't
+ * answer at all, so the caller needs its own timeout.
+ * \param[in] obj Object instance to check
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::sendObjectCrcRequest(UAVObject* obj)
+{
+    QMutexLocker locker(mutex);
+    return transmitSingleObject(obj, TYPE_OBJ_CRC, false);
+}
+
+/**
+ * Compute the CRC the remote end uses for packed object data, this is
+ * the CRC32 with polynomial 0x04C11DB7 of PIOS_CRC32_updateCRC()
+ * \param[in] data Packed object data
+ * \param[in] length Number of bytes
+ * \return The CRC
+ */
+quint32 UAVTalk::objectCrc(const quint8* data, qint32 length)
+{
+    quint32 crc = 0;
+    for (qint32 i = 0; i < length; ++i)
+    {
+        crc ^= (quint32)data[i] << 24;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : (crc << 1);
+        }
+    }
+    return crc;
+}
+
 /**
  * Send the specified object through the telemetry link.
  * \param[in] obj Object to send
@@ -211,7 +481,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
 
     rxPacketLength++;   // update packet byte count
 
-    if(useUDPMirror)
+    if(useUDPMirror || frameSink)
         rxDataArray.append(rxbyte);
 
     // Receive state machine
@@ -230,7 +500,7 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
 
             rxPacketLength = 1;
 
-            if(useUDPMirror)
+            if(useUDPMirror || frameSink)
             {
                 rxDataArray.clear();
                 rxDataArray.append(rxbyte);
@@ -302,6 +572,24 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
 
             // Search for object, if not found reset state machine
             rxObjId = (qint32)qFromLittleEndian<quint32>(rxTmpBuffer);
+            if (rxType == TYPE_OBJ_BUNDLE)
+            {
+                // Bundles carry the ids of their objects in the payload, see updateObjectBundle()
+                rxLength = packetSize - rxPacketLength;
+                if (rxLength >= MAX_PAYLOAD_LENGTH)
+                {
+                    stats.rxErrors++;
+                    rxState = STATE_SYNC;
+                    UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Sync (oversize)");
+                    break;
+                }
+
+                rxState = (rxLength > 0) ? STATE_DATA : STATE_CS;
+                UAVTALK_QXTLOG_DEBUG("UAVTalk: ObjID->Data (bundle)");
+                rxInstId = 0;
+                rxCount = 0;
+                break;
+            }
             {
                 UAVObject *rxObj = objMngr->getObject(rxObjId);
                 if (rxObj == NULL && rxType != TYPE_OBJ_REQ)
@@ -327,6 +615,16 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
                 {
                     rxLength = 0;
                 }
+                else if (rxType == TYPE_OBJ_DELTA && rxObj->isSingleInstance())
+                {
+                    // Deltas only carry the changed chunks, see updateObjectDelta()
+                    rxLength = packetSize - rxPacketLength;
+                }
+                else if (rxType == TYPE_OBJ_CRC)
+                {
+                    // Answers to sendObjectCrcRequest() only carry the CRC
+                    rxLength = packetSize - rxPacketLength - (rxObj->isSingleInstance() ? 0 : 2);
+                }
                 else
                 {
                     rxLength = rxObj->getNumBytes();
@@ -445,6 +743,11 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
 
             mutex->lock();
                 receiveObject(rxType, rxObjId, rxInstId, rxBuffer, rxLength);
+                // The sink may have been set in the middle of the packet
+                if (rxDataArray.size() == rxPacketLength)
+                {
+                    tapFrame((const quint8*)rxDataArray.constData(), rxDataArray.size());
+                }
                 if(useUDPMirror)
                 {
                     udpSocketTx->writeDatagram(rxDataArray,QHostAddress::LocalHost,udpSocketRx->localPort());
@@ -478,7 +781,6 @@ bool UAVTalk::processInputByte(quint8 rxbyte)
  */
 bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length)
 {
-    Q_UNUSED(length);
     UAVObject* obj = NULL;
     bool error = false;
     bool allInstances =  (instId == ALL_INSTANCES);
@@ -502,6 +804,32 @@ bool UAVTalk::receiveObject(quint8 type, quint32 objId, quint16 instId, quint8*
             error = true;
         }
         break;
+    case TYPE_OBJ_DELTA: // We have received the changed parts of an object
+        obj = updateObjectDelta(objId, data, length);
+        if (obj == NULL)
+        {
+            UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Received an invalid UAVObject delta OBJID:%0").arg(QString(QString("0x") + QString::number(objId, 16).toUpper())));
+            error = true;
+        }
+        break;
+    case TYPE_OBJ_CRC: // We have received the CRC of an object we asked for
+        obj = objMngr->getObject(objId, instId);
+        if (obj != NULL && length == OBJ_CRC_LENGTH)
+        {
+            emit crcReceived(obj, qFromLittleEndian<quint32>(data));
+        }
+        else
+        {
+            error = true;
+        }
+        break;
+    case TYPE_OBJ_BUNDLE: // We have received several small objects in one packet
+        if (!updateObjectBundle(data, length))
+        {
+            UAVTALK_QXTLOG_DEBUG(QString("[uavtalk.cpp  ] Received a UAVObject bundle with unknown or invalid objects"));
+            error = true;
+        }
+        break;
     case TYPE_OBJ_ACK: // We have received an object and are asked for an ACK
         // All instances, not allowed for OBJ_ACK messages
         if (!allInstances)
@@ -637,6 +965,88 @@ UAVObject* UAVTalk::updateObject(quint32 objId, quint16 instId, quint8* data)
     }
 }
 
+/**
+ * Apply a delta to a single instance object. The payload is a mask of the
+ * chunks that changed followed by those chunks, with the object split into
+ * chunks the same way as the flight side uavobjectmanager does.
+ * \param[in] objId Object ID
+ * \param[in] data The delta payload
+ * \param[in] length Length of the delta payload
+ * \return The updated object or NULL if the delta does not match it
+ */
+UAVObject* UAVTalk::updateObjectDelta(quint32 objId, quint8* data, qint32 length)
+{
+    UAVObject* obj = objMngr->getObject(objId);
+    if (obj == NULL || !obj->isSingleInstance() || length < DELTA_MASK_LENGTH)
+    {
+        return NULL;
+    }
+
+    qint32 numBytes = obj->getNumBytes();
+    qint32 chunk = (numBytes + DELTA_CHUNKS - 1) / DELTA_CHUNKS;
+    quint32 mask = qFromLittleEndian<quint32>(data);
+    QByteArray merged(numBytes, 0);
+    obj->pack((quint8*)merged.data());
+
+    qint32 in = DELTA_MASK_LENGTH;
+    for (qint32 i = 0, pos = 0; pos < numBytes; ++i, pos += chunk)
+    {
+        if (mask & (1u << i))
+        {
+            qint32 size = qMin(chunk, numBytes - pos);
+            if (in + size > length)
+            {
+                return NULL;
+            }
+            memcpy(merged.data() + pos, data + in, size);
+            in += size;
+        }
+    }
+    if (in != length)
+    {
+        return NULL;
+    }
+
+    obj->unpack((const quint8*)merged.constData());
+    return obj;
+}
+
+/**
+ * Unpack the objects of a bundle. Every object in the payload follows its
+ * ID and its size, so objects that are not known here can be skipped.
+ * \param[in] data The bundle payload
+ * \param[in] length Length of the bundle payload
+ * \return Success (true), Failure (false) if the bundle is malformed or an object was skipped
+ */
+bool UAVTalk::updateObjectBundle(quint8* data, qint32 length)
+{
+    bool ok = true;
+    qint32 pos = 0;
+
+    while (pos + BUNDLE_ENTRY_LENGTH <= length)
+    {
+        quint32 objId = qFromLittleEndian<quint32>(data + pos);
+        qint32 size = data[pos + 4];
+        pos += BUNDLE_ENTRY_LENGTH;
+        if (pos + size > length)
+        {
+            return false;
+        }
+
+        UAVObject* obj = objMngr->getObject(objId);
+        if (obj != NULL && obj->isSingleInstance() && (qint32)obj->getNumBytes() == size)
+        {
+            obj->unpack(data + pos);
+        }
+        else
+        {
+            ok = false;
+        }
+        pos += size;
+    }
+
+    return ok && pos == length;
+}
 
 /**
  * Send an object through the telemetry link.
@@ -738,12 +1148,13 @@ bool UAVTalk::transmitNack(quint32 objId)
 
 
 /**
- * Send an object through the telemetry link.
+ * Build the frame for an object without sending it
  * \param[in] obj Object handle to send
  * \param[in] type Transaction type
- * \return Success (true), Failure (false)
+ * \param[out] buffer At least MAX_PACKET_LENGTH bytes for the frame
+ * \return Length of the frame, or -1 if the object does not fit
  */
-bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances)
+qint32 UAVTalk::packFrame(UAVObject* obj, quint8 type, bool allInstances, quint8* buffer)
 {
     qint32 length;
     qint32 dataOffset;
@@ -753,9 +1164,9 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
 
     // Setup type and object id fields
     objId = obj->getObjID();
-    txBuffer[0] = SYNC_VAL;
-    txBuffer[1] = type;
-    qToLittleEndian<quint32>(objId, &txBuffer[4]);
+    buffer[0] = SYNC_VAL;
+    buffer[1] = type;
+    qToLittleEndian<quint32>(objId, &buffer[4]);
 
     // Setup instance ID if one is required
     if ( obj->isSingleInstance() )
@@ -767,18 +1178,18 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
         // Check if all instances are requested
         if (allInstances)
         {
-            qToLittleEndian<quint16>(allInstId, &txBuffer[8]);
+            qToLittleEndian<quint16>(allInstId, &buffer[8]);
         }
         else
         {
             instId = obj->getInstID();
-            qToLittleEndian<quint16>(instId, &txBuffer[8]);
+            qToLittleEndian<quint16>(instId, &buffer[8]);
         }
         dataOffset = 10;
     }
 
     // Determine data length
-    if (type == TYPE_OBJ_REQ || type == TYPE_ACK)
+    if (type == TYPE_OBJ_REQ || type == TYPE_ACK || type == TYPE_OBJ_CRC)
     {
         length = 0;
     }
@@ -790,30 +1201,65 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
     // Check length
     if (length >= MAX_PAYLOAD_LENGTH)
     {
-        return false;
+        return -1;
     }
 
     // Copy data (if any)
     if (length > 0)
     {
-        if ( !obj->pack(&txBuffer[dataOffset]) )
+        if ( !obj->pack(&buffer[dataOffset]) )
         {
-            return false;
+            return -1;
         }
     }
 
-    qToLittleEndian<quint16>(dataOffset + length, &txBuffer[2]);
+    qToLittleEndian<quint16>(dataOffset + length, &buffer[2]);
 
     // Calculate checksum
-    txBuffer[dataOffset+length] = updateCRC(0, txBuffer, dataOffset + length);
+    buffer[dataOffset+length] = frameCrc(buffer, dataOffset + length);
+
+    return dataOffset + length + CHECKSUM_LENGTH;
+}
+
+/**
+ * Build an object update frame once, so it can be written to several
+ * links without packing the object for each of them
+ * \param[in] obj Object handle to send
+ * \return The frame, empty on failure
+ */
+QByteArray UAVTalk::encodeObject(UAVObject* obj)
+{
+    quint8 buffer[MAX_PACKET_LENGTH];
+    qint32 length = packFrame(obj, TYPE_OBJ, false, buffer);
+    if (length < 0)
+        return QByteArray();
+    return QByteArray((const char*)buffer, length);
+}
+
+/**
+ * Send an object through the telemetry link.
+ * \param[in] obj Object handle to send
+ * \param[in] type Transaction type
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances)
+{
+    qint32 packetLength = packFrame(obj, type, allInstances, txBuffer);
+    if (packetLength < 0)
+    {
+        return false;
+    }
+    qint32 length = packetLength - CHECKSUM_LENGTH -
+            (obj->isSingleInstance() ? MIN_HEADER_LENGTH : MAX_HEADER_LENGTH);
 
     // Send buffer, check that the transmit backlog does not grow above limit
     if (!io.isNull() && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
     {
-        io->write((const char*)txBuffer, dataOffset+length+CHECKSUM_LENGTH);
+        io->write((const char*)txBuffer, packetLength);
+        tapFrame(txBuffer, packetLength);
         if(useUDPMirror)
         {
-            udpSocketRx->writeDatagram((const char*)txBuffer,dataOffset+length+CHECKSUM_LENGTH,QHostAddress::LocalHost,udpSocketTx->localPort());
+            udpSocketRx->writeDatagram((const char*)txBuffer,packetLength,QHostAddress::LocalHost,udpSocketTx->localPort());
         }
     }
     else
@@ -824,13 +1270,51 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
 
     // Update stats
     ++stats.txObjects;
-    stats.txBytes += dataOffset+length+CHECKSUM_LENGTH;
+    stats.txBytes += packetLength;
     stats.txObjectBytes += length;
 
     // Done
     return true;
 }
 
+/**
+ * Send a bundle whose payload is already in the buffer
+ * \param[in] buffer The packet, with the payload after the header
+ * \param[in] length Length of the payload
+ * \return Success (true), Failure (false)
+ */
+bool UAVTalk::transmitBundle(quint8* buffer, qint32 length)
+{
+    // The object ID of a bundle is not used
+    buffer[0] = SYNC_VAL;
+    buffer[1] = TYPE_OBJ_BUNDLE;
+    qToLittleEndian<quint16>(MIN_HEADER_LENGTH + length, &buffer[2]);
+    qToLittleEndian<quint32>(0, &buffer[4]);
+    buffer[MIN_HEADER_LENGTH + length] = updateCRC(0, buffer, MIN_HEADER_LENGTH + length);
+
+    qint32 packetLength = MIN_HEADER_LENGTH + length + CHECKSUM_LENGTH;
+    if (!io.isNull() && io->isWritable() && io->bytesToWrite() < TX_BUFFER_SIZE )
+    {
+        io->write((const char*)buffer, packetLength);
+        tapFrame(buffer, packetLength);
+        if(useUDPMirror)
+        {
+            udpSocketRx->writeDatagram((const char*)buffer,packetLength,QHostAddress::LocalHost,udpSocketTx->localPort());
+        }
+    }
+    else
+    {
+        ++stats.txErrors;
+        return false;
+    }
+
+    ++stats.txObjects;
+    stats.txBytes += packetLength;
+    stats.txObjectBytes += length;
+
+    return true;
+}
+
 /**
  * Update the crc value with new data.
  *
@@ -849,6 +1333,19 @@ bool UAVTalk::transmitSingleObject(UAVObject* obj, quint8 type, bool allInstance
  * \param length   Number of bytes in the \a data buffer.
  * \return         The updated crc value.
  */
+/**
+ * Checksum of a whole frame, for code that writes UAVTalk streams itself
+ * \param[in] data The frame without the checksum
+ * \param[in] length Length of the frame
+ */
+quint8 UAVTalk::frameCrc(const quint8* data, qint32 length)
+{
+    quint8 crc = 0;
+    while (length--)
+        crc = crc_table[crc ^ *data++];
+    return crc;
+}
+
 quint8 UAVTalk::updateCRC(quint8 crc, const quint8 data)
 {
     return crc_table[crc ^ data];
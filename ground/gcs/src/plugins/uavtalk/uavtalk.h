@@ -38,6 +38,17 @@
 #include "uavtalk_global.h"
 #include <QtNetwork/QUdpSocket>
 
+/**
+ * Gets a copy of the object frames exchanged with the vehicle, e.g. to
+ * log them. Called with the UAVTalk mutex held, so it must not block.
+ */
+class UAVTALK_EXPORT UAVTalkFrameSink
+{
+public:
+    virtual ~UAVTalkFrameSink() {}
+    virtual void frame(const quint8* data, qint32 length) = 0;
+};
+
 class UAVTALK_EXPORT UAVTalk: public QObject
 {
     Q_OBJECT
@@ -58,19 +69,28 @@ public:
     ~UAVTalk();
     bool sendObject(UAVObject* obj, bool acked, bool allInstances);
     bool sendObjectRequest(UAVObject* obj, bool allInstances);
+    bool sendObjectBundle(const QList<UAVObject*>& objs);
+    bool sendObjectCrcRequest(UAVObject* obj);
+    static quint32 objectCrc(const quint8* data, qint32 length);
+    static quint8 frameCrc(const quint8* data, qint32 length);
+    static QByteArray encodeObject(UAVObject* obj);
     ComStats getStats();
     void resetStats();
 
     bool processInputByte(quint8 rxbyte);
+    void processInputBuffer(const quint8* data, qint32 length);
+    void setFrameSink(UAVTalkFrameSink* sink);
 
 signals:
     // The only signals we send to the upper level are when we
     // either receive an ACK or a NACK for a request.
     void ackReceived(UAVObject* obj);
     void nackReceived(UAVObject* obj);
+    void crcReceived(UAVObject* obj, quint32 crc);
 
 private slots:
     void processInputStream(void);
+    void processInputFrames(const QVector<QByteArray> &frames);
     void dummyUDPRead();
 
 protected:
@@ -83,6 +103,15 @@ protected:
     static const int TYPE_OBJ_ACK = (TYPE_VER | 0x02);
     static const int TYPE_ACK = (TYPE_VER | 0x03);
     static const int TYPE_NACK = (TYPE_VER | 0x04);
+    static const int TYPE_OBJ_DELTA = (TYPE_VER | 0x05);
+    static const int DELTA_MASK_LENGTH = 4;
+    static const int DELTA_CHUNKS = 32;
+    static const int TYPE_OBJ_BUNDLE = (TYPE_VER | 0x06);
+    static const int BUNDLE_ENTRY_LENGTH = 5;
+    static const int BUNDLE_MAX_OBJECT = 48; // the same limits as the flight side
+    static const int BUNDLE_MAX_PAYLOAD = 160;
+    static const int TYPE_OBJ_CRC = (TYPE_VER | 0x07);
+    static const int OBJ_CRC_LENGTH = 4;
 
     static const int MIN_HEADER_LENGTH = 8; // sync(1), type (1), size(2), object ID(4)
     static const int MAX_HEADER_LENGTH = 10; // sync(1), type (1), size(2), object ID (4), instance ID(2, not used in single objects)
@@ -126,14 +155,21 @@ protected:
     QUdpSocket * udpSocketTx;
     QUdpSocket * udpSocketRx;
     QByteArray rxDataArray;
+    UAVTalkFrameSink* frameSink;
 
     // Methods
     bool objectTransaction(UAVObject* obj, quint8 type, bool allInstances);
+    qint32 processFrame(const quint8* frame, qint32 length);
     virtual bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
     UAVObject* updateObject(quint32 objId, quint16 instId, quint8* data);
+    UAVObject* updateObjectDelta(quint32 objId, quint8* data, qint32 length);
+    bool updateObjectBundle(quint8* data, qint32 length);
     bool transmitNack(quint32 objId);
     bool transmitObject(UAVObject* obj, quint8 type, bool allInstances);
     bool transmitSingleObject(UAVObject* obj, quint8 type, bool allInstances);
+    static qint32 packFrame(UAVObject* obj, quint8 type, bool allInstances, quint8* buffer);
+    bool transmitBundle(quint8* buffer, qint32 length);
+    void tapFrame(const quint8* frame, qint32 length);
     quint8 updateCRC(quint8 crc, const quint8 data);
     quint8 updateCRC(quint8 crc, const quint8* data, qint32 length);
 };
@@ -1,4 +1,5 @@
 QT += network
+QT += serialport
 QT += widgets
 TEMPLATE = lib
 TARGET = UAVTalk
@@ -9,12 +10,16 @@ HEADERS += uavtalk.h \
     telemetrymonitor.h \
     telemetrymanager.h \
     uavtalk_global.h \
-    telemetry.h
+    telemetry.h \
+    settingscache.h \
+    vehiclemanager.h
 SOURCES += uavtalk.cpp \
     uavtalkplugin.cpp \
     telemetrymonitor.cpp \
     telemetrymanager.cpp \
-    telemetry.cpp
+    telemetry.cpp \
+    settingscache.cpp \
+    vehiclemanager.cpp
 DEFINES += UAVTALK_LIBRARY
 OTHER_FILES += UAVTalk.pluginspec \
     UAVTalk.json
\ No newline at end of file
@@ -43,6 +43,16 @@ UAVTalkPlugin::~UAVTalkPlugin()
   */
 void UAVTalkPlugin::extensionsInitialized()
 {
+    // Once the gadgets are there to hear about them
+    foreach (QString vehicle, vehicleArgs) {
+        QString name = vehicle.section('=', 0, 0);
+        QString address = vehicle.section('=', 1);
+        if (address.isEmpty()) {
+            name = vehicle;
+            address = vehicle;
+        }
+        vehicleMngr->openVehicle(name, address);
+    }
 }
 
 /**
@@ -51,8 +61,13 @@ void UAVTalkPlugin::extensionsInitialized()
 bool UAVTalkPlugin::initialize(const QStringList & arguments, QString * errorString)
 {
     // Done
-    Q_UNUSED(arguments);
     Q_UNUSED(errorString);
+
+    for (int i = 0; i + 1 < arguments.length(); i++) {
+        if (arguments.at(i) == "-vehicle")
+            vehicleArgs.append(arguments.at(++i));
+    }
+
     // Get UAVObjectManager instance
     ExtensionSystem::PluginManager* pm = ExtensionSystem::PluginManager::instance();
     objMngr = pm->getObject<UAVObjectManager>();
@@ -61,6 +76,10 @@ bool UAVTalkPlugin::initialize(const QStringList & arguments, QString * errorStr
     telMngr = new TelemetryManager();
     addAutoReleasedObject(telMngr);
 
+    // Sessions with the other vehicles, each with its own objects
+    vehicleMngr = new VehicleManager();
+    addAutoReleasedObject(vehicleMngr);
+
     // Connect to connection manager so we get notified when the user connect to his device
     Core::ConnectionManager *cm = Core::ICore::instance()->connectionManager();
     QObject::connect(cm, SIGNAL(deviceConnected(QIODevice *)),
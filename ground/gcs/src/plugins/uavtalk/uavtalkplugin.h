@@ -34,6 +34,7 @@
 #include "telemetry.h"
 #include "uavtalk.h"
 #include "telemetrymanager.h"
+#include "vehiclemanager.h"
 #include "uavobjectmanager.h"
 
 class UAVTALK_EXPORT UAVTalkPlugin: public ExtensionSystem::IPlugin
@@ -56,6 +57,8 @@ protected slots:
 private:
     UAVObjectManager* objMngr;
     TelemetryManager* telMngr;
+    VehicleManager* vehicleMngr;
+    QStringList vehicleArgs;
 };
 
 #endif // UAVTALKPLUGIN_H
@@ -0,0 +1,218 @@
+/**
+ ******************************************************************************
+ *
+ * @file       vehiclemanager.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Telemetry sessions with several vehicles at once
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include "vehiclemanager.h"
+#include "uavobjects/uavobjectsinit.h"
+#include <extensionsystem/pluginmanager.h>
+#include <QDebug>
+#include <QTcpSocket>
+#include <QtSerialPort/QSerialPort>
+
+//! Time to wait for a TCP link to a vehicle to open
+#define CONNECT_TIMEOUT_MS 5000
+
+VehicleSession::VehicleSession(const QString &name, QIODevice *device, QObject *parent) :
+    QObject(parent),
+    m_name(name),
+    m_device(device)
+{
+    m_objMngr = new UAVObjectManager();
+    UAVObjectsInitialize(m_objMngr);
+
+    m_thread.setObjectName(QString("Vehicle %0").arg(name));
+    m_thread.start();
+
+    // The link is serviced from the thread of the session, like the
+    // connection manager link is from the real time thread
+    m_device->moveToThread(&m_thread);
+
+    m_telMngr = new TelemetryManager(m_objMngr, &m_thread);
+    connect(m_telMngr, SIGNAL(connected()), this, SIGNAL(connected()));
+    connect(m_telMngr, SIGNAL(disconnected()), this, SIGNAL(disconnected()));
+    m_telMngr->start(m_device);
+}
+
+VehicleSession::~VehicleSession()
+{
+    // Stop the telemetry in its thread before the thread goes away
+    QMetaObject::invokeMethod(m_telMngr, "onStop", Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+
+    delete m_telMngr;
+    m_device->close();
+    delete m_device;
+
+    QList<UAVObject*> objs;
+    foreach (UAVObjectManager::ObjectMap map, m_objMngr->getObjects())
+        objs.append(map.values());
+    delete m_objMngr;
+    qDeleteAll(objs);
+}
+
+VehicleManager::VehicleManager(QObject *parent) :
+    QObject(parent),
+    m_nextId(PRIMARY_VEHICLE + 1),
+    m_selected(PRIMARY_VEHICLE)
+{
+}
+
+VehicleManager::~VehicleManager()
+{
+    qDeleteAll(m_sessions);
+}
+
+/**
+ * @brief VehicleManager::addVehicle Starts a session with a vehicle
+ * @param name Shown to tell the vehicles apart
+ * @param device An open link to the vehicle, the session takes ownership
+ * @return The id of the vehicle
+ */
+int VehicleManager::addVehicle(const QString &name, QIODevice *device)
+{
+    int id = m_nextId++;
+    m_sessions.insert(id, new VehicleSession(name, device));
+    emit vehicleAdded(id);
+    return id;
+}
+
+/**
+ * @brief VehicleManager::openVehicle Opens a link and starts a session on it
+ * @param address host:port for TCP, or serial:port[@baudrate]
+ * @return The id of the vehicle, -1 if the link could not be opened
+ */
+int VehicleManager::openVehicle(const QString &name, const QString &address)
+{
+    QIODevice *device = NULL;
+
+    if (address.startsWith("serial:")) {
+        QStringList parts = address.mid(7).split('@');
+        QSerialPort *port = new QSerialPort(parts.at(0));
+        if (port->open(QIODevice::ReadWrite)
+                && port->setBaudRate(parts.length() > 1 ? parts.at(1).toInt() : 57600)
+                && port->setDataBits(QSerialPort::Data8)
+                && port->setParity(QSerialPort::NoParity)
+                && port->setStopBits(QSerialPort::OneStop)
+                && port->setFlowControl(QSerialPort::NoFlowControl)) {
+            device = port;
+        } else {
+            delete port;
+        }
+    } else {
+        int sep = address.lastIndexOf(':');
+        QTcpSocket *socket = new QTcpSocket();
+        socket->connectToHost(address.left(sep), address.mid(sep + 1).toUShort());
+        if (sep > 0 && socket->waitForConnected(CONNECT_TIMEOUT_MS)) {
+            device = socket;
+        } else {
+            delete socket;
+        }
+    }
+
+    if (device == NULL) {
+        qWarning() << "Could not open the link to vehicle" << name << "at" << address;
+        return -1;
+    }
+
+    return addVehicle(name, device);
+}
+
+void VehicleManager::removeVehicle(int id)
+{
+    VehicleSession *session = m_sessions.value(id);
+    if (session == NULL)
+        return;
+
+    if (m_selected == id)
+        setSelectedVehicle(PRIMARY_VEHICLE);
+
+    // Gadgets drop their objects of the vehicle before they are deleted
+    emit vehicleRemoved(id);
+    m_sessions.remove(id);
+    delete session;
+}
+
+QList<int> VehicleManager::getVehicles() const
+{
+    return QList<int>() << PRIMARY_VEHICLE << m_sessions.keys();
+}
+
+QString VehicleManager::getVehicleName(int id) const
+{
+    if (id == PRIMARY_VEHICLE)
+        return tr("Connected vehicle");
+
+    VehicleSession *session = m_sessions.value(id);
+    return session ? session->name() : QString();
+}
+
+/**
+ * @brief VehicleManager::getObjectManager The objects of a vehicle
+ * @return The global object manager for the primary vehicle, NULL for an
+ * unknown id
+ */
+UAVObjectManager* VehicleManager::getObjectManager(int id) const
+{
+    if (id == PRIMARY_VEHICLE)
+        return ExtensionSystem::PluginManager::instance()->getObject<UAVObjectManager>();
+
+    VehicleSession *session = m_sessions.value(id);
+    return session ? session->objectManager() : NULL;
+}
+
+TelemetryManager* VehicleManager::getTelemetryManager(int id) const
+{
+    if (id == PRIMARY_VEHICLE)
+        return ExtensionSystem::PluginManager::instance()->getObject<TelemetryManager>();
+
+    VehicleSession *session = m_sessions.value(id);
+    return session ? session->telemetryManager() : NULL;
+}
+
+void VehicleManager::setSelectedVehicle(int id)
+{
+    if (id == m_selected || (id != PRIMARY_VEHICLE && !m_sessions.contains(id)))
+        return;
+
+    m_selected = id;
+    emit selectedVehicleChanged(id);
+}
+
+/**
+ * @brief VehicleManager::getFleetObjects An object instance of every vehicle
+ * that has it, in the order of getVehicles()
+ */
+QList<UAVObject*> VehicleManager::getFleetObjects(const QString &name, quint32 instId) const
+{
+    QList<UAVObject*> objs;
+    foreach (int id, getVehicles()) {
+        UAVObject *obj = getObjectManager(id)->getObject(name, instId);
+        if (obj)
+            objs.append(obj);
+    }
+    return objs;
+}
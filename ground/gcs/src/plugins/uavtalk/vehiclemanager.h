@@ -0,0 +1,113 @@
+/**
+ ******************************************************************************
+ *
+ * @file       vehiclemanager.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup UAVTalkPlugin UAVTalk Plugin
+ * @{
+ * @brief Telemetry sessions with several vehicles at once
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef VEHICLEMANAGER_H
+#define VEHICLEMANAGER_H
+
+#include "uavtalk_global.h"
+#include "telemetrymanager.h"
+#include "uavobjectmanager.h"
+#include <QIODevice>
+#include <QMap>
+#include <QObject>
+#include <QThread>
+
+/**
+ * One more vehicle: its own object manager, filled with all the objects,
+ * and its own UAVTalk, telemetry and telemetry monitor running in a thread
+ * of the session on a link it owns.
+ */
+class UAVTALK_EXPORT VehicleSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    VehicleSession(const QString &name, QIODevice *device, QObject *parent = 0);
+    ~VehicleSession();
+
+    QString name() const { return m_name; }
+    UAVObjectManager* objectManager() const { return m_objMngr; }
+    TelemetryManager* telemetryManager() const { return m_telMngr; }
+    bool isConnected() const { return m_telMngr->isConnected(); }
+
+signals:
+    void connected();
+    void disconnected();
+
+private:
+    QString m_name;
+    QThread m_thread;
+    QIODevice *m_device;
+    UAVObjectManager *m_objMngr;
+    TelemetryManager *m_telMngr;
+};
+
+/**
+ * The vehicles the GCS talks to. The one on the connection of the
+ * connection manager is always there as PRIMARY_VEHICLE, with the global
+ * object manager, the others are added by -vehicle on the command line or
+ * by addVehicle(). Gadgets either bind to the objects of the selected
+ * vehicle, following selectedVehicleChanged(), or aggregate over all of
+ * them with getFleetObjects().
+ */
+class UAVTALK_EXPORT VehicleManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int PRIMARY_VEHICLE = 0;
+
+    VehicleManager(QObject *parent = 0);
+    ~VehicleManager();
+
+    int addVehicle(const QString &name, QIODevice *device);
+    int openVehicle(const QString &name, const QString &address);
+    void removeVehicle(int id);
+
+    QList<int> getVehicles() const;
+    QString getVehicleName(int id) const;
+    UAVObjectManager* getObjectManager(int id) const;
+    TelemetryManager* getTelemetryManager(int id) const;
+
+    int getSelectedVehicle() const { return m_selected; }
+    void setSelectedVehicle(int id);
+    UAVObjectManager* getSelectedObjectManager() const { return getObjectManager(m_selected); }
+
+    QList<UAVObject*> getFleetObjects(const QString &name, quint32 instId = 0) const;
+
+signals:
+    void vehicleAdded(int id);
+    void vehicleRemoved(int id);
+    void selectedVehicleChanged(int id);
+
+private:
+    QMap<int, VehicleSession*> m_sessions;
+    int m_nextId;
+    int m_selected;
+};
+
+#endif // VEHICLEMANAGER_H
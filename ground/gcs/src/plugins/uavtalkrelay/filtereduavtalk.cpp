@@ -35,19 +35,27 @@ FilteredUavTalk::FilteredUavTalk(QIODevice *iodev, UAVObjectManager *objMngr,
 {
 }
 
+//! Only touched from the relay's network thread, where all the clients live
+FilteredUavTalk *FilteredUavTalk::s_updating = NULL;
+
 /**
- * @brief FilteredUavTalk::sendObjectSlot Called whenever an object is updated by
- * the local GCS and sends it to the remote GCS is the rules allow it.
- * @param obj The UAVObject to possibly send
+ * Write a frame the relay serialized once for all the clients
  */
-void FilteredUavTalk::sendObjectSlot(UAVObject *obj)
+void FilteredUavTalk::relayFrame(quint32 objId, const QByteArray &frame)
 {
-    UavTalkRelayComon::accessType access=m_rules.value(obj->getObjID(),m_defaultRule);
+    UavTalkRelayComon::accessType access=m_rules.value(objId,m_defaultRule);
     if(access==UavTalkRelayComon::WriteOnly || access==UavTalkRelayComon::None)
         return;
-    if(obj==GCSTelemetryStats::GetInstance(objMngr))
+
+    // Drop rather than queue without limit for a slave that can't keep up
+    if (io.isNull() || !io->isWritable() || io->bytesToWrite() >= TX_BUFFER_SIZE) {
+        ++stats.txErrors;
         return;
-    sendObject(obj,false,false);
+    }
+
+    io->write(frame);
+    ++stats.txObjects;
+    stats.txBytes += frame.size();
 }
 
 /**
@@ -81,10 +89,9 @@ bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         {
             // Get object and update its data
             UAVObject* tobj = objMngr->getObject(objId);
-            bool wasCon=disconnect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            s_updating = this;
             obj = updateObject(objId, instId, data);
-            if(wasCon)
-                connect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            s_updating = NULL;
             UAVMetaObject * mobj=dynamic_cast<UAVMetaObject*>(tobj);
             if(mobj)
                 tobj->updated();
@@ -102,10 +109,9 @@ bool FilteredUavTalk::receiveObject(quint8 type, quint32 objId, quint16 instId,
         {
             // Get object and update its data
             UAVObject* tobj = objMngr->getObject(objId);
-            bool wasCon=disconnect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            s_updating = this;
             obj = updateObject(objId, instId, data);
-            if(wasCon)
-                connect(tobj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(sendObjectSlot(UAVObject*)));
+            s_updating = NULL;
             UAVMetaObject * mobj=dynamic_cast<UAVMetaObject*>(tobj);
             if(mobj)
                 tobj->updated();
@@ -45,12 +45,16 @@ public:
     //! Called when an uavtalk packet is received from the slave.  Updates master based on filtering rules
     bool receiveObject(quint8 type, quint32 objId, quint16 instId, quint8* data, qint32 length);
 
-public slots:
-    //! Called whenever an object is updated either locally in the master GCS or from the main
-    //! telemetry connection, but NOT as a consquence of the receiveObject method
-    void sendObjectSlot(UAVObject *obj);
+    //! Write an object update that was already serialized, if the rules let
+    //! this slave read the object
+    void relayFrame(quint32 objId, const QByteArray &frame);
+
+    //! The client whose received update is being applied right now, if any
+    static FilteredUavTalk *updatingClient() { return s_updating; }
 
 private:
+    static FilteredUavTalk *s_updating;
+
     QHash<quint32,UavTalkRelayComon::accessType> m_rules;
     UavTalkRelayComon::accessType m_defaultRule;
 };
@@ -27,11 +27,32 @@
 
 #include "uavtalkrelay.h"
 #include "QMessageBox"
-#include <QPointer>
 #include "filtereduavtalk.h"
+#include "gcstelemetrystats.h"
+
+/*
+ * Every object update is serialized once, in the thread that updated it,
+ * and the frame is handed to the network thread which writes it to all the
+ * clients whose rules let them read the object. The clients and their
+ * sockets live in that thread as well, so neither the packing nor the
+ * socket writes load the GUI thread, however many slaves are connected.
+ */
 
 UavTalkRelay::UavTalkRelay(UAVObjectManager *ObjMngr, QString IpAdress, quint16 Port,QHash<QString,QHash<quint32,UavTalkRelayComon::accessType> > rules,UavTalkRelayComon::accessType defaultRule):m_IpAddress(IpAdress),m_Port(Port),m_ObjMngr(ObjMngr),m_rules(rules),m_DefaultRule(defaultRule)
 {
+    m_fanout = new RelayFanout();
+    m_fanout->moveToThread(&m_networkThread);
+    m_networkThread.start();
+
+    // Serialize each update once, directly in the thread that emits it
+    QVector< QVector<UAVObject*> > list = m_ObjMngr->getObjectsVector();
+    foreach (const QVector<UAVObject*> &instances, list) {
+        foreach (UAVObject *obj, instances)
+            newObject(obj);
+    }
+    connect(m_ObjMngr, SIGNAL(newObject(UAVObject*)), this, SLOT(newObject(UAVObject*)));
+    connect(m_ObjMngr, SIGNAL(newInstance(UAVObject*)), this, SLOT(newObject(UAVObject*)));
+
     tcpServer = new QTcpServer(this);
     // if we did not find one, use IPv4 localhost
     if (m_IpAddress.isEmpty())
@@ -44,6 +65,14 @@ UavTalkRelay::UavTalkRelay(UAVObjectManager *ObjMngr, QString IpAdress, quint16
     qDebug()<<__FUNCTION__<<"SERVER listening on "<<tcpServer->serverAddress()<<tcpServer->serverPort();
 }
 
+UavTalkRelay::~UavTalkRelay()
+{
+    // The clients are children of the fanout and go with it
+    QMetaObject::invokeMethod(m_fanout, "deleteLater");
+    m_networkThread.quit();
+    m_networkThread.wait();
+}
+
 void UavTalkRelay::setPort(quint16 value)
 {
     m_Port=value;
@@ -74,28 +103,72 @@ void UavTalkRelay::newConnection()
 {
     qDebug()<<__FUNCTION__<<"NEW CONNECTION";
     QTcpSocket *clientConnection = tcpServer->nextPendingConnection();
-    connect(clientConnection, SIGNAL(disconnected()),
-            clientConnection, SLOT(deleteLater()));
     qDebug()<<clientConnection->peerAddress().toString();
     QHash<quint32,UavTalkRelayComon::accessType> temp= m_rules.value(clientConnection->peerAddress().toString());
     temp.unite(m_rules.value("*"));
-    QPointer<FilteredUavTalk> uav=new FilteredUavTalk(clientConnection,m_ObjMngr,temp,m_DefaultRule);
-    uavTalkList.append(uav);
+
+    // The connection moves to the network thread together with its client
+    FilteredUavTalk *uav = new FilteredUavTalk(clientConnection,m_ObjMngr,temp,m_DefaultRule);
+    clientConnection->setParent(uav);
+    uav->moveToThread(&m_networkThread);
     connect(clientConnection, SIGNAL(disconnected()),
             uav, SLOT(deleteLater()));
-    QVector< QVector<UAVObject*> > list = m_ObjMngr->getObjectsVector();
-    QVector< QVector<UAVObject*> >::const_iterator i;
-    QVector<UAVObject*>::const_iterator j;
-    int objects = 0;
-
-    const QVector< QVector<UAVObject*> >::iterator iEnd = list.end();
-    for (i = list.constBegin(); i != iEnd; ++i)
-    {
-        QVector<UAVObject*>::const_iterator jEnd = (*i).constEnd();
-        for (j = (*i).constBegin(); j != jEnd; ++j)
-        {
-            connect(*j, SIGNAL(objectUpdated(UAVObject*)), uav.data(), SLOT(sendObjectSlot(UAVObject*)));
-            objects++;
-        }
+
+    QMetaObject::invokeMethod(m_fanout, "addClient", Qt::QueuedConnection,
+                              Q_ARG(QObject*, uav));
+}
+
+void UavTalkRelay::newObject(UAVObject *obj)
+{
+    connect(obj, SIGNAL(objectUpdated(UAVObject*)), this, SLOT(objectUpdated(UAVObject*)),
+            Qt::DirectConnection);
+}
+
+/**
+ * Called in whatever thread updated the object
+ */
+void UavTalkRelay::objectUpdated(UAVObject *obj)
+{
+    if (m_fanout->clientCount() == 0)
+        return;
+    if (obj->getObjID() == GCSTelemetryStats::OBJID)
+        return;
+
+    QByteArray frame = UAVTalk::encodeObject(obj);
+    if (frame.isEmpty())
+        return;
+
+    // Updates received from a slave are not echoed back to it
+    QObject *origin = NULL;
+    if (QThread::currentThread() == &m_networkThread)
+        origin = FilteredUavTalk::updatingClient();
+
+    QMetaObject::invokeMethod(m_fanout, "broadcast", Qt::QueuedConnection,
+                              Q_ARG(quint32, obj->getObjID()),
+                              Q_ARG(QByteArray, frame),
+                              Q_ARG(QObject*, origin));
+}
+
+void RelayFanout::addClient(QObject *client)
+{
+    client->setParent(this);
+    m_clients.append(QPointer<FilteredUavTalk>(static_cast<FilteredUavTalk *>(client)));
+    m_clientCount.ref();
+    connect(client, SIGNAL(destroyed()), this, SLOT(clientDestroyed()));
+}
+
+void RelayFanout::clientDestroyed()
+{
+    m_clientCount.deref();
+}
+
+void RelayFanout::broadcast(quint32 objId, const QByteArray &frame, QObject *origin)
+{
+    for (int i = m_clients.size() - 1; i >= 0; --i) {
+        FilteredUavTalk *client = m_clients.at(i).data();
+        if (client == NULL)
+            m_clients.removeAt(i);
+        else if (client != origin)
+            client->relayFrame(objId, frame);
     }
 }
@@ -29,17 +29,42 @@
 #include <QObject>
 #include <QTcpServer>
 #include <QNetworkSession>
+#include <QThread>
+#include <QAtomicInt>
+#include <QPointer>
 #include <coreplugin/connectionmanager.h>
 #include <QTcpSocket>
 #include "uavobjectmanager.h"
 #include "uavtalkrelay_global.h"
 
 class FilteredUavTalk;
+
+/**
+ * Lives in the relay's network thread together with the client connections
+ * and writes every update, already serialized, to each of them.
+ */
+class RelayFanout: public QObject
+{
+    Q_OBJECT
+public:
+    RelayFanout() {}
+    int clientCount() const { return m_clientCount.load(); }
+public slots:
+    void addClient(QObject *client);
+    void broadcast(quint32 objId, const QByteArray &frame, QObject *origin);
+private slots:
+    void clientDestroyed();
+private:
+    QList< QPointer<FilteredUavTalk> > m_clients;
+    QAtomicInt m_clientCount;
+};
+
 class UavTalkRelay: public QObject
 {
     Q_OBJECT
 public:
     UavTalkRelay(UAVObjectManager * ObjMngr,QString IpAdress,quint16 Port,QHash<QString,QHash<quint32,UavTalkRelayComon::accessType> > rules,UavTalkRelayComon::accessType defaultRule);
+    ~UavTalkRelay();
     quint16 Port(){return m_Port;}
     QString IpAdress(){return m_IpAddress;}
     void setPort(quint16 value);
@@ -48,6 +73,8 @@ public:
     void restartServer();
 private slots:
     void newConnection();
+    void newObject(UAVObject *obj);
+    void objectUpdated(UAVObject *obj);
 private:
     QString m_IpAddress;
     quint16 m_Port;
@@ -57,7 +84,8 @@ private:
     UAVObjectManager * m_ObjMngr;
     QHash<QString,QHash<quint32,UavTalkRelayComon::accessType> > m_rules;
     UavTalkRelayComon::accessType m_DefaultRule;
-    QList< QPointer<FilteredUavTalk> > uavTalkList;
+    QThread m_networkThread;
+    RelayFanout *m_fanout;
 };
 
 #endif // UAVTALKRELAY_H
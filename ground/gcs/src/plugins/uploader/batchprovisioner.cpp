@@ -0,0 +1,306 @@
+/**
+ ******************************************************************************
+ *
+ * @file       batchprovisioner.cpp
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup  Uploader Uploader Plugin
+ * @{
+ * @brief Flashes and configures every connected board in bootloader at once
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <stdio.h>
+
+#include "batchprovisioner.h"
+#include "fileutils.h"
+#include "devicedescriptorstruct.h"
+#include "uavobjectutilmanager.h"
+#include "coreplugin/icore.h"
+#include "coreplugin/connectionmanager.h"
+#include "coreplugin/boardmanager.h"
+
+using namespace uploader;
+
+#define DESCRIPTION_LENGTH 100
+#define USER_DESCRIPTION_LENGTH 20
+
+ProvisioningJob::ProvisioningJob(const USBPortInfo &port, const QByteArray &firmware,
+                                 const QMap<int, QByteArray> &partitions, QObject *parent) :
+    QObject(parent),
+    m_port(port),
+    m_firmware(firmware),
+    m_pending(partitions),
+    m_partition(-1),
+    m_verified(0),
+    m_step(FIRMWARE)
+{
+    m_name = port.serialNumber.isEmpty() ? QString("%0:%1").arg(port.vendorID, 4, 16, QChar('0'))
+                                                           .arg(port.productID, 4, 16, QChar('0'))
+                                         : port.serialNumber;
+
+    connect(&m_dfu, SIGNAL(uploadFinished(tl_dfu::Status)), this, SLOT(onUploadFinished(tl_dfu::Status)));
+    connect(&m_dfu, SIGNAL(downloadFinished(bool)), this, SLOT(onDownloadFinished(bool)));
+}
+
+/**
+ * @brief ProvisioningJob::start Opens the bootloader of the board, checks the
+ * firmware is built for it and starts the firmware upload
+ */
+void ProvisioningJob::start()
+{
+    if (!m_dfu.OpenBootloaderComs(m_port)) {
+        fail(tr("could not open coms with the bootloader"));
+        return;
+    }
+
+    m_device = m_dfu.findCapabilities();
+
+    deviceDescriptorStruct descriptor;
+    if (!UAVObjectUtilManager::descriptionToStructure(m_firmware.right(DESCRIPTION_LENGTH), descriptor)) {
+        fail(tr("the firmware has no metadata"));
+        return;
+    }
+    if (descriptor.boardType != (m_device.ID >> 8)) {
+        fail(tr("the firmware is for board type 0x%0, the board is 0x%1")
+             .arg(descriptor.boardType, 0, 16).arg(m_device.ID >> 8, 0, 16));
+        return;
+    }
+    if ((quint32)m_firmware.length() > m_device.SizeOfCode) {
+        fail(tr("the firmware does not fit the board"));
+        return;
+    }
+
+    // Same metadata as the uploader gadget writes, with an empty user field
+    m_description = m_firmware.right(DESCRIPTION_LENGTH);
+    m_description.chop(USER_DESCRIPTION_LENGTH);
+    m_description.append(QByteArray(USER_DESCRIPTION_LENGTH, ' '));
+
+    m_step = FIRMWARE;
+    m_dfu.UploadPartitionThreaded(m_firmware, DFU_PARTITION_FW, m_device.SizeOfCode);
+}
+
+void ProvisioningJob::onUploadFinished(tl_dfu::Status status)
+{
+    if (status != tl_dfu::Last_operation_Success) {
+        fail(tr("%0 upload failed").arg(m_dfu.partitionStringFromLabel(m_step == PARTITION ?
+                 (dfu_partition_label)m_partition : (m_step == FIRMWARE ? DFU_PARTITION_FW : DFU_PARTITION_DESC))));
+        return;
+    }
+
+    switch (m_step) {
+    case FIRMWARE:
+        m_step = DESCRIPTION;
+        m_dfu.UploadPartitionThreaded(m_description, DFU_PARTITION_DESC, DESCRIPTION_LENGTH);
+        break;
+    case DESCRIPTION:
+        // The bootloader computes the firmware CRC over the whole code area
+        m_device = m_dfu.findCapabilities();
+        if (m_device.FW_CRC != tl_dfu::DFUObject::CRCFromQBArray(m_firmware, m_device.SizeOfCode)) {
+            fail(tr("firmware CRC mismatch after upload"));
+            return;
+        }
+        nextPartition();
+        break;
+    case PARTITION:
+        // Read it back to verify, the bootloader has no CRC for these
+        m_step = VERIFY;
+        m_readBack.clear();
+        m_dfu.DownloadPartitionThreaded(&m_readBack, (dfu_partition_label)m_partition, m_transfer.length());
+        break;
+    default:
+        break;
+    }
+}
+
+void ProvisioningJob::onDownloadFinished(bool result)
+{
+    if (m_step != VERIFY)
+        return;
+
+    if (!result || m_readBack.left(m_transfer.length()) != m_transfer) {
+        fail(tr("%0 partition did not verify").arg(m_dfu.partitionStringFromLabel((dfu_partition_label)m_partition)));
+        return;
+    }
+
+    ++m_verified;
+    nextPartition();
+}
+
+/**
+ * @brief ProvisioningJob::nextPartition Uploads the next partition of the bundle,
+ * or boots the board once they are all written
+ */
+void ProvisioningJob::nextPartition()
+{
+    if (m_pending.isEmpty()) {
+        succeed();
+        return;
+    }
+
+    m_partition = m_pending.firstKey();
+    m_transfer = m_pending.take(m_partition);
+
+    if (m_partition >= m_device.PartitionSizes.length() ||
+            (quint32)m_transfer.length() > m_device.PartitionSizes.at(m_partition)) {
+        fail(tr("the board has no room for partition %0").arg(m_partition));
+        return;
+    }
+
+    m_step = PARTITION;
+    m_dfu.UploadPartitionThreaded(m_transfer, (dfu_partition_label)m_partition, m_transfer.length());
+}
+
+void ProvisioningJob::fail(const QString &message)
+{
+    m_dfu.CloseBootloaderComs();
+    emit finished(false, message);
+}
+
+void ProvisioningJob::succeed()
+{
+    m_dfu.JumpToApp(false);
+    m_dfu.CloseBootloaderComs();
+    emit finished(true, tr("firmware %0 bytes, %1 partitions verified")
+                  .arg(m_firmware.length()).arg(m_verified));
+}
+
+BatchProvisioner::BatchProvisioner(const QString &firmwareFile, const QString &bundleFile, QObject *parent) :
+    QObject(parent),
+    m_firmwareFile(firmwareFile),
+    m_bundleFile(bundleFile),
+    m_remaining(0),
+    m_failed(0),
+    m_running(true)
+{
+}
+
+/**
+ * @brief BatchProvisioner::start Loads the firmware and the bundle and starts a
+ * job for every board in bootloader state
+ */
+void BatchProvisioner::start()
+{
+    QFile file(m_firmwareFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        fprintf(stderr, "provision: could not read %s\n", qPrintable(m_firmwareFile));
+        m_failed = 1;
+        finish();
+        return;
+    }
+    QByteArray firmware = file.readAll();
+    file.close();
+
+    QMap<int, QByteArray> partitions;
+    if (!m_bundleFile.isEmpty() && !loadBundle(partitions)) {
+        fprintf(stderr, "provision: could not read the bundle %s\n", qPrintable(m_bundleFile));
+        m_failed = 1;
+        finish();
+        return;
+    }
+
+    // Keep the telemetry off the boards while they are provisioned
+    Core::ICore::instance()->connectionManager()->suspendPolling();
+
+    Core::BoardManager* brdMgr = Core::ICore::instance()->boardManager();
+    QList<USBPortInfo> devices;
+    foreach (int vendorID, brdMgr->getKnownVendorIDs())
+        devices.append(USBMonitor::instance()->availableDevices(vendorID, -1, -1, USBMonitor::Bootloader));
+
+    fprintf(stdout, "provision: %d boards in bootloader\n", devices.length());
+    fflush(stdout);
+
+    foreach (USBPortInfo port, devices) {
+        ProvisioningJob *job = new ProvisioningJob(port, firmware, partitions, this);
+        connect(job, SIGNAL(finished(bool,QString)), this, SLOT(onJobFinished(bool,QString)));
+        m_jobs.append(job);
+    }
+
+    m_remaining = m_jobs.length();
+    if (m_remaining == 0) {
+        finish();
+        return;
+    }
+
+    // Opening the coms is synchronous, the transfers then overlap
+    foreach (ProvisioningJob *job, m_jobs)
+        job->start();
+}
+
+void BatchProvisioner::onJobFinished(bool success, QString message)
+{
+    ProvisioningJob *job = qobject_cast<ProvisioningJob *>(sender());
+    fprintf(stdout, "provision: %s %s: %s\n", job ? qPrintable(job->name()) : "?",
+            success ? "OK" : "FAILED", qPrintable(message));
+    fflush(stdout);
+
+    if (!success)
+        ++m_failed;
+
+    if (--m_remaining == 0)
+        finish();
+}
+
+/**
+ * @brief BatchProvisioner::loadBundle Reads a partition bundle saved by the
+ * uploader gadget. The firmware, its metadata and the bootloader are skipped,
+ * the firmware file covers the first two and a batch never rewrites the last.
+ */
+bool BatchProvisioner::loadBundle(QMap<int, QByteArray> &partitions)
+{
+    QDir dir = QDir::temp();
+    QString extractDir = QString("tlprovision%0").arg(QCoreApplication::applicationPid());
+    if (!dir.mkdir(extractDir))
+        return false;
+    dir.cd(extractDir);
+
+    bool ok = FileUtils::extractAll(m_bundleFile, dir);
+    foreach (QFileInfo fileInfo, dir.entryInfoList(QDir::Files, QDir::Name)) {
+        if (!ok)
+            break;
+
+        int label = fileInfo.fileName().remove(".bin").toInt(&ok);
+        if (!ok)
+            break;
+        if (label == DFU_PARTITION_FW || label == DFU_PARTITION_DESC || label == DFU_PARTITION_BL)
+            continue;
+
+        QFile file(fileInfo.absoluteFilePath());
+        ok = file.open(QIODevice::ReadOnly);
+        if (ok)
+            partitions.insert(label, file.readAll());
+    }
+
+    FileUtils::removeDir(dir.absolutePath());
+    return ok;
+}
+
+void BatchProvisioner::finish()
+{
+    m_running = false;
+    Core::ICore::instance()->connectionManager()->resumePolling();
+
+    fprintf(stdout, "provision: %d of %d boards failed\n", m_failed, m_jobs.length());
+    fflush(stdout);
+
+    QCoreApplication::exit(m_failed ? 1 : 0);
+}
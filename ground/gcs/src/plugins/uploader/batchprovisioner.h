@@ -0,0 +1,115 @@
+/**
+ ******************************************************************************
+ *
+ * @file       batchprovisioner.h
+ * @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+ * @addtogroup GCSPlugins GCS Plugins
+ * @{
+ * @addtogroup  Uploader Uploader Plugin
+ * @{
+ * @brief Flashes and configures every connected board in bootloader at once
+ *****************************************************************************/
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ */
+
+#ifndef BATCHPROVISIONER_H
+#define BATCHPROVISIONER_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include "tl_dfu.h"
+#include "uploader_global.h"
+
+namespace uploader {
+
+/**
+ * @brief Provisions one board: firmware, firmware metadata, then the partitions
+ * of the bundle, each read back and compared, then boots it. All transfers run
+ * in the thread of its own DFUObject, so the jobs of a batch run concurrently.
+ */
+class ProvisioningJob : public QObject
+{
+    Q_OBJECT
+
+public:
+    ProvisioningJob(const USBPortInfo &port, const QByteArray &firmware,
+                    const QMap<int, QByteArray> &partitions, QObject *parent = 0);
+    void start();
+    QString name() const { return m_name; }
+
+signals:
+    void finished(bool success, QString message);
+
+private slots:
+    void onUploadFinished(tl_dfu::Status status);
+    void onDownloadFinished(bool result);
+
+private:
+    enum Step { FIRMWARE, DESCRIPTION, PARTITION, VERIFY };
+
+    void nextPartition();
+    void fail(const QString &message);
+    void succeed();
+
+    USBPortInfo m_port;
+    QString m_name;
+    tl_dfu::DFUObject m_dfu;
+    tl_dfu::device m_device;
+    QByteArray m_firmware;
+    QByteArray m_description;
+    QMap<int, QByteArray> m_pending;
+    int m_partition;
+    int m_verified;
+    QByteArray m_transfer;
+    QByteArray m_readBack;
+    Step m_step;
+};
+
+/**
+ * @brief Runs a @ref ProvisioningJob for every board in bootloader
+ * Started by the -provision command line option of the uploader plugin,
+ * prints a line per board and quits the GCS with the number of failures
+ */
+class UPLOADER_EXPORT BatchProvisioner : public QObject
+{
+    Q_OBJECT
+
+public:
+    BatchProvisioner(const QString &firmwareFile, const QString &bundleFile, QObject *parent = 0);
+    bool isRunning() const { return m_running; }
+
+public slots:
+    void start();
+
+private slots:
+    void onJobFinished(bool success, QString message);
+
+private:
+    bool loadBundle(QMap<int, QByteArray> &partitions);
+    void finish();
+
+    QString m_firmwareFile;
+    QString m_bundleFile;
+    QList<ProvisioningJob *> m_jobs;
+    int m_remaining;
+    int m_failed;
+    bool m_running;
+};
+
+}
+
+#endif // BATCHPROVISIONER_H
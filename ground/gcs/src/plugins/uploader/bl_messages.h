@@ -63,6 +63,9 @@ enum bl_commands {
     BL_MSG_STATUS_REQ,
     BL_MSG_STATUS_REP,
     BL_MSG_WIPE_PARTITION,
+    BL_MSG_SECTOR_CRC_REQ,
+    BL_MSG_SECTOR_CRC_REP,
+    BL_MSG_WRITE_RANGE_START,
 
     BL_MSG_WRITE_START = 0x27,
 };
@@ -135,6 +138,8 @@ struct msg_capabilities_rep_specific {
 #define BL_CAP_EXTENSION_MAGIC 0x3456
 	uint16_t cap_extension_magic;
 	uint32_t partition_sizes[10];
+#define BL_CAP_FLAG_SECTOR_CRC 0x01	/* Supports SECTOR_CRC and WRITE_RANGE_START */
+	uint8_t cap_flags;
 #endif	/* BL_INCLUDE_CAP_EXTENSIONS */
 };
 
@@ -166,6 +171,7 @@ PACK(struct msg_xfer_start {
 	uint8_t label;
 	uint8_t words_in_last_packet;
 	uint32_t expected_crc; /* only used in writes */
+	uint32_t partition_offset; /* only used in range writes */
 });
 
 #define XFER_BYTES_PER_PACKET 56
@@ -187,6 +193,18 @@ struct msg_wipe_partition {
 	uint8_t label;
 };
 
+PACK(struct msg_sector_crc_req {
+	uint32_t partition_offset;
+	uint8_t label;
+});
+
+PACK(struct msg_sector_crc_rep {
+	uint32_t sector_offset;
+	uint32_t sector_size; /* 0 past the end of the partition */
+	uint32_t crc;
+	uint8_t label;
+});
+
 PACK(union msg_contents {
     struct msg_capabilities_req cap_req;
     struct msg_capabilities_rep_all cap_rep_all;
@@ -201,6 +219,8 @@ PACK(union msg_contents {
     struct msg_status_req status_req;
     struct msg_status_rep status_rep;
     struct msg_wipe_partition wipe_partition;
+    struct msg_sector_crc_req sector_crc_req;
+    struct msg_sector_crc_rep sector_crc_rep;
     uint8_t pad[62];
 });
 
@@ -38,7 +38,7 @@
 
 using namespace tl_dfu;
 
-DFUObject::DFUObject() : open(false)
+DFUObject::DFUObject() : open(false), sectorCRC(false)
 {
     qRegisterMetaType<tl_dfu::Status>("TL_DFU::Status");
 }
@@ -96,6 +96,61 @@ bool DFUObject::StartUpload(qint32 const & numberOfBytes, dfu_partition_label co
 }
 
 
+/**
+  Tells the board to get ready to rewrite part of a partition. Only the
+  sectors covered by the range are erased, so it must start at the
+  beginning of a sector.
+  @param offset offset of the range within the partition
+  @param numberOfBytes number of bytes of the transfer
+  @param label partition where the data will be uploaded to
+  @param crc crc value of the range once written
+  @returns result of the requested operation
+  */
+bool DFUObject::StartRangeUpload(quint32 offset, qint32 const & numberOfBytes, dfu_partition_label const & label, quint32 crc)
+{
+    messagePackets msg = CalculatePadding(numberOfBytes);
+    bl_messages message;
+    memset(&message, 0, sizeof(message));
+    message.flags_command = BL_MSG_WRITE_RANGE_START;
+    message.v.xfer_start.expected_crc = ntohl(crc);
+    message.v.xfer_start.packets_in_transfer = ntohl(msg.numberOfPackets);
+    message.v.xfer_start.words_in_last_packet = msg.lastPacketCount;
+    message.v.xfer_start.label = label;
+    message.v.xfer_start.partition_offset = ntohl(offset);
+
+    int result = SendData(message);
+    TL_DFU_QXTLOG_DEBUG(QString("StartRangeUpload offset:%0 bytes:%1").arg(offset).arg(numberOfBytes));
+    return result > 0;
+}
+
+/**
+  Asks the board for the CRC of the sector holding an offset
+  @param label partition to look into
+  @param offset offset within the partition
+  @param sectorOffset beginning of the sector, within the partition
+  @param sectorSize size of the sector, 0 past the end of the partition
+  @param crc crc value of the sector as programmed
+  @returns true if the board replied
+  */
+bool DFUObject::SectorCRC(dfu_partition_label const & label, quint32 offset, quint32 &sectorOffset, quint32 &sectorSize, quint32 &crc)
+{
+    bl_messages message;
+    memset(&message, 0, sizeof(message));
+    message.flags_command = BL_MSG_SECTOR_CRC_REQ;
+    message.v.sector_crc_req.partition_offset = ntohl(offset);
+    message.v.sector_crc_req.label = label;
+    if (SendData(message) < 1)
+        return false;
+
+    if (ReceiveData(message) < 1 || message.flags_command != BL_MSG_SECTOR_CRC_REP)
+        return false;
+
+    sectorOffset = ntohl(message.v.sector_crc_rep.sector_offset);
+    sectorSize = ntohl(message.v.sector_crc_rep.sector_size);
+    crc = ntohl(message.v.sector_crc_rep.crc);
+    return true;
+}
+
 /**
   Does the actual data upload to the board. Needs to be called once the
   board is ready to accept data following a StartUpload command, and it is erased.
@@ -370,6 +425,9 @@ device DFUObject::findCapabilities()
     message.v.cap_rep_specific.device_number = 1;
     currentDevice.FW_CRC = ntohl(message.v.cap_rep_specific.fw_crc);
     currentDevice.SizeOfCode = ntohl(message.v.cap_rep_specific.fw_size);
+    currentDevice.SectorCRC = currentDevice.CapExt &&
+            (message.v.cap_rep_specific.cap_flags & BL_CAP_FLAG_SECTOR_CRC);
+    sectorCRC = currentDevice.SectorCRC;
     if(currentDevice.CapExt)
     {
         for(int partition = 0;partition < 10;++partition)
@@ -412,7 +470,13 @@ bool DFUObject::OpenBootloaderComs(USBPortInfo port)
     QTimer::singleShot(200,&m_eventloop, SLOT(quit()));
     m_eventloop.exec();
     hid_init();
-    m_hidHandle = hid_open(port.vendorID, port.productID, NULL);
+    // Open this board by its serial, several can be in the bootloader at once
+    if (port.serialNumber.isEmpty()) {
+        m_hidHandle = hid_open(port.vendorID, port.productID, NULL);
+    } else {
+        std::wstring serial = port.serialNumber.toStdWString();
+        m_hidHandle = hid_open(port.vendorID, port.productID, serial.c_str());
+    }
     if ( m_hidHandle )
     {
         QTimer::singleShot(200,&m_eventloop, SLOT(quit()));
@@ -513,6 +577,9 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
         return tl_dfu::abort;;
     }
 
+    if (sectorCRC && partition != DFU_PARTITION_DESC && partition != DFU_PARTITION_BL)
+        return UploadPartitionDelta(sourceArray, partition);
+
     quint32 crc = DFUObject::CRCFromQBArray(sourceArray, threadJob.partition_size);
     TL_DFU_QXTLOG_DEBUG( QString("NEW FIRMWARE CRC=%0").arg(crc));
 
@@ -564,6 +631,104 @@ tl_dfu::Status DFUObject::UploadPartition(QByteArray &sourceArray, dfu_partition
     return ret;
 }
 
+/**
+  Uploads a partition by only rewriting the sectors that differ from what
+  the board holds, then checks every sector again.
+  @param sourceArray array containing the data to upload, padded to words
+  @param partition destination partition
+  @returns status of the board after upload
+  */
+tl_dfu::Status DFUObject::UploadPartitionDelta(QByteArray &sourceArray, dfu_partition_label partition)
+{
+    struct Sector {
+        quint32 offset;
+        quint32 size;
+        quint32 crc;
+        bool changed;
+    };
+    QVector<Sector> sectors;
+
+    emit operationProgress(QString(tr("Comparing %0")).arg(partitionStringFromLabel(partition)), -1);
+
+    quint32 offset = 0;
+    forever {
+        Sector sector;
+        quint32 deviceCrc;
+        if (!SectorCRC(partition, offset, sector.offset, sector.size, deviceCrc))
+            return tl_dfu::abort;
+        if (sector.size == 0)
+            break;
+
+        sector.crc = CRCFromQBArray(sourceArray.mid(sector.offset, sector.size), sector.size);
+        sector.changed = sector.crc != deviceCrc;
+        sectors.append(sector);
+        offset = sector.offset + sector.size;
+    }
+
+    if (sectors.isEmpty())
+        return tl_dfu::abort;
+
+    // The descriptor is written after the firmware without an erase, so
+    // the sector that holds it is always erased here
+    if (partition == DFU_PARTITION_FW)
+        sectors.last().changed = true;
+
+    int changed = 0;
+    foreach (const Sector &sector, sectors)
+        if (sector.changed)
+            ++changed;
+    TL_DFU_QXTLOG_DEBUG(QString("Rewriting %0 of %1 sectors").arg(changed).arg(sectors.size()));
+
+    tl_dfu::Status ret = tl_dfu::Last_operation_Success;
+    for (int first = 0; first < sectors.size(); ) {
+        if (!sectors[first].changed) {
+            ++first;
+            continue;
+        }
+
+        // Rewrite a run of changed sectors in a single transfer
+        int last = first;
+        while (last + 1 < sectors.size() && sectors[last + 1].changed)
+            ++last;
+
+        quint32 start = sectors[first].offset;
+        quint32 length = sectors[last].offset + sectors[last].size - start;
+        QByteArray range = sourceArray.mid(start, length);
+        range.append(QByteArray(length - range.length() + XFER_BYTES_PER_PACKET, 255));
+        quint32 crc = CRCFromQBArray(range, length);
+
+        emit operationProgress(QString(tr("Uploading %0")).arg(partitionStringFromLabel(partition)), -1);
+        if (!StartRangeUpload(start, length, partition, crc))
+            return tl_dfu::abort;
+        ret = StatusRequest();
+        if (ret != tl_dfu::uploading) {
+            // A refused range leaves the board in the state of the last one
+            return (ret == tl_dfu::Last_operation_Success) ? tl_dfu::abort : ret;
+        }
+        if (!UploadData(length, range) || !EndOperation())
+            return StatusRequest();
+        ret = StatusRequest();
+        if (ret != tl_dfu::Last_operation_Success)
+            return ret;
+
+        first = last + 1;
+    }
+
+    // Check the whole partition now holds the new image
+    foreach (const Sector &sector, sectors) {
+        quint32 sectorOffset, sectorSize, deviceCrc;
+        if (!SectorCRC(partition, sector.offset, sectorOffset, sectorSize, deviceCrc))
+            return tl_dfu::abort;
+        if (deviceCrc != sector.crc) {
+            TL_DFU_QXTLOG_DEBUG(QString("Sector at %0 does not match after upload").arg(sector.offset));
+            return tl_dfu::CRC_Fail;
+        }
+    }
+
+    TL_DFU_QXTLOG_DEBUG("Firmware Uploading succeeded");
+    return ret;
+}
+
 /**
   Copies one array into another inverting endianess
   @param source source array
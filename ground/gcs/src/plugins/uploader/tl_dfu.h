@@ -73,6 +73,7 @@ struct device
     QVector<quint32> PartitionSizes;
     int HW_Rev;
     bool CapExt;
+    bool SectorCRC;
 };
 
 class DFUObject : public QThread
@@ -116,6 +117,8 @@ private:
     bool DownloadPartition(QByteArray *fw, qint32 const & numberOfBytes, const dfu_partition_label &partition);
     tl_dfu::Status UploadPartition(QByteArray &sfile, dfu_partition_label partition);
 
+    tl_dfu::Status UploadPartitionDelta(QByteArray &sfile, dfu_partition_label partition);
+
     // Helper functions:
     QString StatusToString(tl_dfu::Status  const & status);
     static quint32 CRC32WideFast(quint32 Crc, quint32 Size, quint32 *Buffer);
@@ -134,6 +137,8 @@ private:
     hid_device *m_hidHandle;
 
     bool StartUpload(qint32  const &numberOfBytes, const dfu_partition_label &label, quint32 crc);
+    bool StartRangeUpload(quint32 offset, qint32 const &numberOfBytes, const dfu_partition_label &label, quint32 crc);
+    bool SectorCRC(const dfu_partition_label &label, quint32 offset, quint32 &sectorOffset, quint32 &sectorSize, quint32 &crc);
     bool UploadData(qint32 const & numberOfPackets,QByteArray  & data);
 
     typedef struct ThreadJobStruc
@@ -152,6 +157,7 @@ private:
     ThreadJobStruc threadJob;
 
     bool open;
+    bool sectorCRC;
 protected:
     void run();// Executes the upload or download operations
 };
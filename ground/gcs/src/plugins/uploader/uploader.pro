@@ -13,13 +13,15 @@ HEADERS += uploadergadget.h \
     uploader_global.h \
     fileutils.h \
     bl_messages.h \
-    tl_dfu.h
+    tl_dfu.h \
+    batchprovisioner.h
 SOURCES += uploadergadget.cpp \
     uploadergadgetfactory.cpp \
     uploadergadgetwidget.cpp \
     uploaderplugin.cpp \
     fileutils.cpp \
-    tl_dfu.cpp
+    tl_dfu.cpp \
+    batchprovisioner.cpp
 OTHER_FILES += Uploader.pluginspec \
     Uploader.json
 
@@ -32,6 +32,7 @@
 #include "uploadergadgetwidget.h"
 #include "firmwareiapobj.h"
 #include "fileutils.h"
+#include "batchprovisioner.h"
 #include "coreplugin/icore.h"
 #include "rawhid/rawhidplugin.h"
 
@@ -433,6 +434,11 @@ void UploaderGadgetWidget::onRescueButtonClick()
  */
 void UploaderGadgetWidget::onBootloaderDetected()
 {
+    // The boards belong to the batch while one runs
+    BatchProvisioner *provisioner = pm->getObject<BatchProvisioner>();
+    if (provisioner && provisioner->isRunning())
+        return;
+
     Core::BoardManager* brdMgr = Core::ICore::instance()->boardManager();
     QList<USBPortInfo> devices;
     foreach(int vendorID, brdMgr->getKnownVendorIDs()) {
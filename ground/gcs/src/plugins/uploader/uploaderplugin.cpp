@@ -26,11 +26,13 @@
  */
 #include "uploaderplugin.h"
 #include "uploadergadgetfactory.h"
+#include "batchprovisioner.h"
 #include <QtPlugin>
 #include <QStringList>
+#include <QTimer>
 #include <extensionsystem/pluginmanager.h>
 
-UploaderPlugin::UploaderPlugin()
+UploaderPlugin::UploaderPlugin() : provisioner(NULL)
 {
    // Do nothing
 }
@@ -42,8 +44,15 @@ UploaderPlugin::~UploaderPlugin()
 
 bool UploaderPlugin::initialize(const QStringList& args, QString *errMsg)
 {
-   Q_UNUSED(args);
    Q_UNUSED(errMsg);
+
+   int index = args.indexOf("-provision");
+   if (index >= 0 && index + 1 < args.length())
+       provisionFirmware = args.at(index + 1);
+   index = args.indexOf("-provision-bundle");
+   if (index >= 0 && index + 1 < args.length())
+       provisionBundle = args.at(index + 1);
+
    mf = new UploaderGadgetFactory(this);
    addAutoReleasedObject(mf);
    return true;
@@ -51,7 +60,13 @@ bool UploaderPlugin::initialize(const QStringList& args, QString *errMsg)
 
 void UploaderPlugin::extensionsInitialized()
 {
-   // Do nothing
+   if (provisionFirmware.isEmpty())
+       return;
+
+   // Headless batch, started once the event loop runs
+   provisioner = new BatchProvisioner(provisionFirmware, provisionBundle, this);
+   addAutoReleasedObject(provisioner);
+   QTimer::singleShot(0, provisioner, SLOT(start()));
 }
 
 void UploaderPlugin::shutdown()
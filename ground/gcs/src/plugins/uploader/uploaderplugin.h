@@ -48,6 +48,7 @@
 
 namespace uploader {
     class UploaderGadgetFactory;
+    class BatchProvisioner;
 }
 
 using namespace uploader;
@@ -65,5 +66,8 @@ public:
    void shutdown();
 private:
    UploaderGadgetFactory *mf;
+   BatchProvisioner *provisioner;
+   QString provisionFirmware;
+   QString provisionBundle;
 };
 #endif // UPLOADERPLUGIN_H
@@ -67,6 +67,38 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
 	}
     }
 
+    // Lay out the UAVObject arena with the hot objects together: sensor
+    // data first, then the other state objects, multi instance objects and
+    // finally the settings that are hardly touched after boot
+    QString arenaSlots, arenaList;
+    for (int pass = 0; pass < 4; ++pass) {
+        for (int objidx = 0; objidx < parser->getNumObjects(); ++objidx) {
+            ObjectInfo* info=parser->getObjectByIndex(objidx);
+            int objPass;
+            if (info->isSettings)
+                objPass = 3;
+            else if (!info->isSingleInst)
+                objPass = 2;
+            else if (info->isSingleWriter)
+                objPass = 0;
+            else
+                objPass = 1;
+            if (objPass != pass)
+                continue;
+
+            arenaSlots.append("#ifdef UAVOBJ_INIT_" + info->namelc + "\r\n");
+            arenaSlots.append(QString("#define UAVOBJ_ARENA_SLOT_%1 UAVOBJ_ARENA_SLOT(0x%2, %3, %4, %5, %6)\r\n")
+                              .arg(info->namelc)
+                              .arg(info->id, 8, 16, QChar('0')).arg(info->isSingleInst ? 1 : 0)
+                              .arg(info->isSettings ? 1 : 0).arg(info->isSingleWriter ? 1 : 0)
+                              .arg(parser->getNumBytes(objidx)));
+            arenaSlots.append("#else\r\n");
+            arenaSlots.append("#define UAVOBJ_ARENA_SLOT_" + info->namelc + "\r\n");
+            arenaSlots.append("#endif\r\n");
+            arenaList.append(" \\\r\n\tUAVOBJ_ARENA_SLOT_" + info->namelc);
+        }
+    }
+
     // Write the flight object inialization files
     flightInitTemplate.replace( QString("$(OBJINC)"), objInc);
     flightInitTemplate.replace( QString("$(OBJINIT)"), flightObjInit);
@@ -79,6 +111,8 @@ bool UAVObjectGeneratorFlight::generate(UAVObjectParser* parser,QString template
 
     // Write the flight object initialization header
     flightInitIncludeTemplate.replace( QString("$(SIZECALCULATION)"), QString().setNum(sizeCalc));
+    flightInitIncludeTemplate.replace( QString("$(ARENASLOTS)"), arenaSlots);
+    flightInitIncludeTemplate.replace( QString("$(ARENALIST)"), arenaList);
     res = writeFileIfDiffrent( flightOutputPath.absolutePath() + "/uavobjectsinit.h",
                      flightInitIncludeTemplate );
     if (!res) {
@@ -401,7 +435,6 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo* info)
             }
         }
     }
-    outCode.replace(QString("$(SETGETFIELDS)"), setgetfields);
 
     // Replace the $(SETGETFIELDSEXTERN) tag
      QString setgetfieldsextern;
@@ -423,7 +456,47 @@ bool UAVObjectGeneratorFlight::process_object(ObjectInfo* info)
 					.arg( info->fields[n]->name ) );
          }
      }
-     outInclude.replace(QString("$(SETGETFIELDSEXTERN)"), setgetfieldsextern);
+
+    // Single instance objects have their accessors inlined in the header,
+    // going straight to the object manager's single instance path
+    if (info->isSingleInst)
+    {
+        outInclude.replace(QString("$(GETDATA)"),
+                           QString("UAVObjGetSingleDataField(%1Handle(), dataOut, 0, sizeof(%1Data))").arg(info->name));
+        outInclude.replace(QString("$(SETDATA)"),
+                           QString("UAVObjSetSingleDataField(%1Handle(), dataIn, 0, sizeof(%1Data))").arg(info->name));
+
+        QString setgetfieldsinline;
+        for (int n = 0; n < info->fields.length(); ++n)
+        {
+            QString size = QString("sizeof(%1)").arg(fieldTypeStrC[info->fields[n]->type]);
+            if (info->fields[n]->numElements > 1)
+                size = QString("%1*%2").arg(info->fields[n]->numElements).arg(size);
+
+            /* SET */
+            setgetfieldsinline.append( QString("static inline void %2%3Set( %1 *New%3 ) { UAVObjSetSingleDataField(%2Handle(), (void*)New%3, offsetof( %2Data, %3), %4); }\r\n")
+                                       .arg( fieldTypeStrC[info->fields[n]->type] )
+                                       .arg( info->name )
+                                       .arg( info->fields[n]->name )
+                                       .arg( size ) );
+
+            /* GET */
+            setgetfieldsinline.append( QString("static inline void %2%3Get( %1 *New%3 ) { UAVObjGetSingleDataField(%2Handle(), (void*)New%3, offsetof( %2Data, %3), %4); }\r\n")
+                                       .arg( fieldTypeStrC[info->fields[n]->type] )
+                                       .arg( info->name )
+                                       .arg( info->fields[n]->name )
+                                       .arg( size ) );
+        }
+        outInclude.replace(QString("$(SETGETFIELDSEXTERN)"), setgetfieldsinline);
+        outCode.replace(QString("$(SETGETFIELDS)"), QString());
+    }
+    else
+    {
+        outInclude.replace(QString("$(GETDATA)"), QString("UAVObjGetData(%1Handle(), dataOut)").arg(info->name));
+        outInclude.replace(QString("$(SETDATA)"), QString("UAVObjSetData(%1Handle(), dataIn)").arg(info->name));
+        outCode.replace(QString("$(SETGETFIELDS)"), setgetfields);
+        outInclude.replace(QString("$(SETGETFIELDSEXTERN)"), setgetfieldsextern);
+    }
 
     // Write the flight code
     bool res = writeFileIfDiffrent( flightOutputPath.absolutePath() + "/" + info->namelc + ".c", outCode );
@@ -25,6 +25,7 @@
  */
 
 #include "uavobjectgeneratorgcs.h"
+#include <QMap>
 using namespace std;
 
 bool UAVObjectGeneratorGCS::generate(UAVObjectParser* parser,QString templatepath,QString outputpath) {
@@ -141,6 +142,21 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     }
     outInclude.replace(QString("$(DATAFIELDS)"), fields);
 
+    // Replace the $(DATASWAP) tag, byte swaps of the multi byte fields
+    // by their offset in DataFields
+    QString dataSwap;
+    int fieldOffset = 0;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        if (info->fields[n]->numBytes > 1)
+            dataSwap.append( QString("    swapElements(&((quint8*)&swapped)[%1], %2, %3);\n")
+                             .arg(fieldOffset)
+                             .arg(info->fields[n]->numBytes)
+                             .arg(info->fields[n]->numElements) );
+        fieldOffset += info->fields[n]->numBytes * info->fields[n]->numElements;
+    }
+    outCode.replace(QString("$(DATASWAP)"), dataSwap);
+
     // Replace $(PROPERTIES) and related tags
     QString properties;
     QString propertiesImpl;
@@ -195,6 +211,18 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
                     QString("    void %1Changed(quint32 index, %2 value);\n")
                     .arg(field->name).arg(type);
 
+            //bulk getter, copies all elements under a single lock
+            propertyGetters +=
+                    QString("    void get%1Array(%2 *out) const;\n")
+                    .arg(field->name).arg(type);
+            propertiesImpl +=
+                    QString("void %1::get%2Array(%3 *out) const\n"
+                            "{\n"
+                            "   QMutexLocker locker(mutex);\n"
+                            "   memcpy(out, data.%2, sizeof(data.%2));\n"
+                            "}\n")
+                    .arg(info->name).arg(field->name).arg(type);
+
             for (int elementIndex = 0; elementIndex < field->numElements; elementIndex++) {
                 QString elementName = field->elementNames[elementIndex];
                 properties += QString("    Q_PROPERTY(%1 %2 READ get%2 WRITE set%2 NOTIFY %2Changed);\n")
@@ -294,6 +322,9 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
     QString finit;
     for (int n = 0; n < info->fields.length(); ++n)
     {
+        // Limits, parsed here rather than each time the GCS starts
+        QString limitArgs = form_limit_tables(info, info->fields[n], finit);
+
         // Setup element names
         QString varElemName = info->fields[n]->name + "ElemNames";
         finit.append( QString("    QStringList %1;\n").arg(varElemName) );
@@ -339,22 +370,22 @@ bool UAVObjectGeneratorGCS::process_object(ObjectInfo* info)
 
             finit.append("};\n");
 
-            finit.append( QString("    fields.append( new UAVObjectField(QString(\"%1\"), QString(\"%2\"), UAVObjectField::ENUM, %3, %4, %5, QString(\"%6\"), FIELD_DESCRIPTIONS[\"%1\"]));\n")
+            finit.append( QString("    descriptors.append( UAVObjectField::DescriptorPtr(new UAVObjectField::Descriptor(QString(\"%1\"), QString(\"%2\"), UAVObjectField::ENUM, %3, %4, %5, %6, FIELD_DESCRIPTIONS[\"%1\"])));\n")
                           .arg(info->fields[n]->name)
                           .arg(info->fields[n]->units)
                           .arg(varElemName)
                           .arg(info->fields[n]->name + "EnumOptions")
                           .arg(info->fields[n]->name + "EnumIndices")
-                          .arg(info->fields[n]->limitValues));
+                          .arg(limitArgs));
         }
         // For all other types
         else {
-            finit.append( QString("    fields.append( new UAVObjectField(QString(\"%1\"), QString(\"%2\"), UAVObjectField::%3, %4, QStringList(), QList<int>(), QString(\"%5\"), FIELD_DESCRIPTIONS[\"%1\"]));\n")
+            finit.append( QString("    descriptors.append( UAVObjectField::DescriptorPtr(new UAVObjectField::Descriptor(QString(\"%1\"), QString(\"%2\"), UAVObjectField::%3, %4, QStringList(), QList<int>(), %5, FIELD_DESCRIPTIONS[\"%1\"])));\n")
                           .arg(info->fields[n]->name)
                           .arg(info->fields[n]->units)
                           .arg(fieldTypeStrCPPClass[info->fields[n]->type])
                           .arg(varElemName)
-                          .arg(info->fields[n]->limitValues));
+                          .arg(limitArgs));
         }
     }
     outCode.replace(QString("$(FIELDSINIT)"), finit);
@@ -517,3 +548,100 @@ QString UAVObjectGeneratorGCS::escape_raw_string(QString raw)
 {
     return raw.replace("\\", "\\\\").replace("\"", "\\\"").simplified();
 }
+
+/**
+ * Parses the limits of a field and appends them to tables as constant
+ * arrays of UAVObjectField::LimitRule and their values.
+ * The format is %TY:VAL1:VAL2,%TY:VAL1 with one entry per element and
+ * several rules of an element separated by ';'. TY is EQ, NE, BE, BI or
+ * SM and may be preceded by a 4 digit hex board type, as in %0901NE:64.
+ * Returns the arguments to pass to the UAVObjectField::Descriptor.
+ */
+QString UAVObjectGeneratorGCS::form_limit_tables(ObjectInfo* info, FieldInfo* field, QString& tables)
+{
+    QMap<QString, QString> limitTypes;
+    limitTypes["EQ"] = "EQUAL";
+    limitTypes["NE"] = "NOT_EQUAL";
+    limitTypes["BE"] = "BETWEEN";
+    limitTypes["BI"] = "BIGGER";
+    limitTypes["SM"] = "SMALLER";
+
+    QString rules;
+    int numRules = 0;
+    QStringList values;
+
+    QStringList perElement = field->limitValues.split(",");
+    for (int index = 0; index < perElement.length(); ++index) {
+        foreach (const QString &ruleStr, perElement[index].split(";")) {
+            QString rule = ruleStr.trimmed();
+            if (rule.isEmpty())
+                continue;
+
+            QStringList parts = rule.split(":");
+            QString head = parts.takeFirst().trimmed();
+
+            bool boardValid = false;
+            int board = 0;
+            if (head.length() == 7)
+                board = head.mid(1, 4).toInt(&boardValid, 16);
+
+            QString type = limitTypes.value(head.right(2));
+
+            if (!head.startsWith("%") || (head.length() != 3 && !boardValid) ||
+                    type.isEmpty() || index >= field->numElements) {
+                cout << "Warning: ignoring invalid limit \"" << rule.toStdString()
+                     << "\" of " << info->name.toStdString() << "."
+                     << field->name.toStdString() << endl;
+                continue;
+            }
+
+            int first = values.length();
+            foreach (const QString &valueStr, parts) {
+                QString value = valueStr.trimmed();
+                switch (field->type) {
+                case FIELDTYPE_ENUM:
+                    if (!field->options.contains(value))
+                        cout << "Warning: limit of " << info->name.toStdString()
+                             << "." << field->name.toStdString()
+                             << " names an unknown option " << value.toStdString() << endl;
+                    values.append(QString::number(field->options.indexOf(value)));
+                    break;
+                case FIELDTYPE_FLOAT32:
+                    values.append(QString::number(value.toDouble(), 'g', 17));
+                    break;
+                case FIELDTYPE_UINT8:
+                case FIELDTYPE_UINT16:
+                case FIELDTYPE_UINT32:
+                    values.append(QString::number(value.toULong()));
+                    break;
+                default:
+                    values.append(QString::number(value.toLong()));
+                }
+            }
+
+            rules.append(QString("        { %1, 0x%2, UAVObjectField::%3, %4, %5 },\n")
+                         .arg(index)
+                         .arg(board, 4, 16, QChar('0'))
+                         .arg(type)
+                         .arg(first)
+                         .arg(values.length() - first));
+            ++numRules;
+        }
+    }
+
+    if (numRules == 0)
+        return QString("NULL, 0, NULL");
+
+    QString rulesVar = field->name + "LimitRules";
+    QString valuesVar = field->name + "LimitValues";
+
+    tables.append(QString("    static const UAVObjectField::LimitRule %1[] = {\n%2    };\n")
+                  .arg(rulesVar).arg(rules));
+    if (values.isEmpty())
+        return QString("%1, %2, NULL").arg(rulesVar).arg(numRules);
+
+    tables.append(QString("    static const double %1[] = { %2 };\n")
+                  .arg(valuesVar).arg(values.join(", ")));
+
+    return QString("%1, %2, %3").arg(rulesVar).arg(numRules).arg(valuesVar);
+}
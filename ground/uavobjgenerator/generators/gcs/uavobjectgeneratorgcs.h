@@ -41,6 +41,7 @@ private:
     QString form_enum_name(const QString& objectName,
             const QString& fieldName, const QString& option);
     QString escape_raw_string(QString raw);
+    QString form_limit_tables(ObjectInfo* info, FieldInfo* field, QString& tables);
 
     QString gcsCodeTemplate,gcsIncludeTemplate;
     QStringList fieldTypeStrCPP,fieldTypeStrCPPClass;
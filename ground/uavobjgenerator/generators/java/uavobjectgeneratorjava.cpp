@@ -150,59 +150,55 @@ bool UAVObjectGeneratorJava::process_object(ObjectInfo* info)
     }
     outCode.replace(QString("$(FIELDSINIT)"), finit);
 
-    // Replace the $(INITFIELDS) tag
+    // Replace the $(FIELDINDICES) tag
+    QString fieldindices;
+    for (int n = 0; n < info->fields.length(); ++n)
+    {
+        fieldindices.append( QString("\tpublic static final int FIELD_%1 = %2;\n")
+                             .arg( info->fields[n]->name.toUpper() )
+                             .arg( n ) );
+    }
+    outCode.replace(QString("$(FIELDINDICES)"), fieldindices);
+
+    // Replace the $(INITFIELDS) tag, the defaults are set through the typed
+    // setters so loading an object does not box every value
     QString initfields;
     for (int n = 0; n < info->fields.length(); ++n)
     {
-        if (!info->fields[n]->defaultValues.isEmpty() )
+        FieldInfo *field = info->fields[n];
+        if (field->defaultValues.isEmpty())
+            continue;
+
+        for (int idx = 0; idx < field->numElements; ++idx)
         {
-            // For non-array fields
-            if ( info->fields[n]->numElements == 1)
-            {
-                if ( info->fields[n]->type == FIELDTYPE_ENUM )
-                {
-                    initfields.append( QString("\t\tgetField(\"%1\").setValue(\"%2\");\n")
-                                .arg( info->fields[n]->name )
-                                .arg( info->fields[n]->defaultValues[0] ) );
-                }
-                else if ( info->fields[n]->type == FIELDTYPE_FLOAT32 )
-                {
-                    initfields.append( QString("\t\tgetField(\"%1\").setValue(%2);\n")
-                                .arg( info->fields[n]->name )
-                                .arg( info->fields[n]->defaultValues[0].toFloat() ) );
-                }
-                else
-                {
-                    initfields.append( QString("\t\tgetField(\"%1\").setValue(%2);\n")
-                                .arg( info->fields[n]->name )
-                                .arg( info->fields[n]->defaultValues[0].toInt() ) );
-                }
+            QString value;
+            QString setter;
+            if ( field->type == FIELDTYPE_ENUM ) {
+                const QStringList &options = field->parent ? field->parent->options : field->options;
+                setter = "setInt";
+                value = QString::number( options.indexOf(field->defaultValues[idx]) );
             }
-            else
-            {
-                // Initialize all fields in the array
-                for (int idx = 0; idx < info->fields[n]->numElements; ++idx)
-                {
-                    if ( info->fields[n]->type == FIELDTYPE_ENUM ) {
-                        initfields.append( QString("\t\tgetField(\"%1\").setValue(\"%3\",%2);\n")
-                                    .arg( info->fields[n]->name )
-                                    .arg( idx )
-                                    .arg( info->fields[n]->defaultValues[idx] ) );
-                    }
-                    else if ( info->fields[n]->type == FIELDTYPE_FLOAT32 ) {
-                        initfields.append( QString("\t\tgetField(\"%1\").setValue(%3,%2);\n")
-                                    .arg( info->fields[n]->name )
-                                    .arg( idx )
-                                    .arg( info->fields[n]->defaultValues[idx].toFloat() ) );
-                    }
-                    else {
-                        initfields.append( QString("\t\tgetField(\"%1\").setValue(%3,%2);\n")
-                                    .arg( info->fields[n]->name )
-                                    .arg( idx )
-                                    .arg( info->fields[n]->defaultValues[idx].toInt() ) );
-                    }
-                }
+            else if ( field->type == FIELDTYPE_FLOAT32 ) {
+                setter = "setFloat";
+                value = QString::number( field->defaultValues[idx].toFloat() ) + "f";
+            }
+            else {
+                setter = "setLong";
+                value = QString::number( field->defaultValues[idx].toLongLong() ) + "L";
             }
+
+            // For non-array fields
+            if ( field->numElements == 1)
+                initfields.append( QString("\t\tgetField(FIELD_%1).%2(%3);\n")
+                                   .arg( field->name.toUpper() )
+                                   .arg( setter )
+                                   .arg( value ) );
+            else
+                initfields.append( QString("\t\tgetField(FIELD_%1).%2(%3,%4);\n")
+                                   .arg( field->name.toUpper() )
+                                   .arg( setter )
+                                   .arg( value )
+                                   .arg( idx ) );
         }
     }
 
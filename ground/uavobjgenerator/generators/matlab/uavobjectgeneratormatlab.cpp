@@ -33,14 +33,17 @@ bool UAVObjectGeneratorMatlab::generate(UAVObjectParser* parser,QString template
         << "uint8" << "uint16" << "uint32" << "single" << "uint8";
     fieldSizeStrMatlab << "1" << "2" << "4"
         << "1" << "2" << "4" << "4" << "1";
+    fieldTypeStrMex << "FIELD_INT8" << "FIELD_INT16" << "FIELD_INT32"
+        << "FIELD_UINT8" << "FIELD_UINT16" << "FIELD_UINT32" << "FIELD_FLOAT" << "FIELD_ENUM";
 
     QDir matlabTemplatePath = QDir( templatepath + QString("ground/gcs/src/plugins/uavobjects"));
     QDir matlabOutputPath = QDir( outputpath + QString("matlab") );
     matlabOutputPath.mkpath(matlabOutputPath.absolutePath());
 
     QString matlabCodeTemplate = readFile( matlabTemplatePath.absoluteFilePath( "uavobjecttemplate.m") );
+    QString mexCodeTemplate = readFile( matlabTemplatePath.absoluteFilePath( "uavobjectmextemplate.c") );
 
-    if (matlabCodeTemplate.isEmpty() ) {
+    if (matlabCodeTemplate.isEmpty() || mexCodeTemplate.isEmpty() ) {
         std::cerr << "Problem reading matlab templates" << endl;
         return false;
     }
@@ -57,8 +60,13 @@ bool UAVObjectGeneratorMatlab::generate(UAVObjectParser* parser,QString template
     matlabCodeTemplate.replace( QString("$(SAVEOBJECTSCODE)"), matlabSaveObjectsCode);
     matlabCodeTemplate.replace( QString("$(ALLOCATIONCODE)"), matlabAllocationCode);
     matlabCodeTemplate.replace( QString("$(EXPORTCSVCODE)"), matlabExportCsvCode);
+    matlabCodeTemplate.replace( QString("$(MEXCOPYCODE)"), matlabMexCopyCode);
+
+    mexCodeTemplate.replace( QString("$(MEXFIELDTABLES)"), mexFieldTables);
+    mexCodeTemplate.replace( QString("$(MEXOBJECTTABLE)"), mexObjectTable);
 
     bool res = writeFile( matlabOutputPath.absolutePath() + "/LogConvert.m.pass1", matlabCodeTemplate );
+    res = res && writeFile( matlabOutputPath.absolutePath() + "/LogConvertMex.c.pass1", mexCodeTemplate );
     if (!res) {
         cout << "Error: Could not write output files" << endl;
         return false;
@@ -186,6 +194,26 @@ bool UAVObjectGeneratorMatlab::process_object(ObjectInfo* info, int numBytes)
 //	OPLog2csv(ActuatorCommand, 'ActuatorCommand', logfile)
 
 
+    //======================================================================//
+    // Generate the MEX parser tables (will replace the $(MEXFIELDTABLES) //
+    // and $(MEXOBJECTTABLE) tags) and the copy out of its result         //
+    //======================================================================//
+    mexFieldTables.append("static const struct mex_field " + objectName + "_fields[] = {\n");
+    for (int n = 0; n < info->fields.length(); ++n) {
+        mexFieldTables.append("\t{ \"" + info->fields[n]->name + "\", " +
+                              fieldTypeStrMex[info->fields[n]->type] + ", " +
+                              QString::number(info->fields[n]->numElements) + " },\n");
+    }
+    mexFieldTables.append("};\n\n");
+
+    mexObjectTable.append("\t{ 0x" + QString("%1").arg(info->id, 8, 16, QChar('0')).toUpper() +
+                          ", \"" + objectName + "\", " + (info->isSingleInst ? "true" : "false") +
+                          ", " + numBytesString + ", " + objectName + "_fields, " +
+                          QString::number(info->fields.length()) + " },\n");
+
+    matlabMexCopyCode.append("\t" + objectTableName + " = mexObjects." + objectTableName + ";\n");
+
+
 
     return true;
 }
@@ -42,8 +42,12 @@ private:
     QString matlabAllocationCode;
     QString matlabSaveObjectsCode;
     QString matlabExportCsvCode;
+    QString matlabMexCopyCode;
+    QString mexFieldTables;
+    QString mexObjectTable;
     QStringList fieldTypeStrMatlab;
     QStringList fieldSizeStrMatlab;
+    QStringList fieldTypeStrMex;
 
 };
 
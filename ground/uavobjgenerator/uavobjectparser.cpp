@@ -882,6 +882,19 @@ QString UAVObjectParser::processObjectAttributes(QDomNode& node, ObjectInfo* inf
     if ( info->isSettings && !info->isSingleInst )
         return QString("Object: Settings objects can not have multiple instances");
 
+    // Get singlewriter attribute if present
+    attr = attributes.namedItem("singlewriter");
+    if ( attr.isNull() || attr.nodeValue().compare(QString("false")) == 0 )
+        info->isSingleWriter = false;
+    else if ( attr.nodeValue().compare(QString("true")) == 0 )
+        info->isSingleWriter = true;
+    else
+        return QString("Object:singlewriter attribute value is invalid");
+
+    // Only plain single instance objects can be flagged as single writer
+    if ( info->isSingleWriter && (info->isSettings || !info->isSingleInst) )
+        return QString("Object: Only single instance data objects can be single writer");
+
     // Done
     return QString();
 }
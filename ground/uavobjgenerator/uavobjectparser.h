@@ -99,6 +99,7 @@ struct ObjectInfo_s {
     quint32 id;
     bool isSingleInst;
     bool isSettings;
+    bool isSingleWriter; /** Only one flight task ever writes the object **/
     AccessMode gcsAccess;
     AccessMode flightAccess;
     bool flightTelemetryAcked;
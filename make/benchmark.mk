@@ -0,0 +1,72 @@
+###############################################################################
+# @file       benchmark.mk
+# @author     Tau Labs, http://taulabs.org, Copyright (C) 2016
+# @addtogroup 
+# @{
+# @addtogroup 
+# @{
+# @brief Makefile template for host side benchmarks
+###############################################################################
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, write to the Free Software Foundation, Inc.,
+# 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+#
+
+# The harness shared by all the benchmarks
+BM_COMMON_DIR := $(ROOT_DIR)/flight/benchmarks/common
+
+# Flags passed to the C++ compiler.
+CXXFLAGS += -Wall -Wextra -Wno-missing-field-initializers
+
+# Where the results are compared to, and the regression threshold in percent
+BM_BASELINE  ?= $(OUTDIR)/../baselines/$(TARGET).txt
+override BM_BASELINE := $(abspath $(BM_BASELINE))
+BM_TOLERANCE ?= 10
+
+#################################
+#
+# Template to build the benchmark
+#
+#################################
+
+# Need to disable THUMB mode for benchmarks
+override THUMB :=
+
+EXTRAINCDIRS    += . $(BM_COMMON_DIR)
+BMMOCKSRC       := $(wildcard ./*.c)
+ALLSRC          := $(SRC) $(BMMOCKSRC)
+ALLCPPSRC       := $(wildcard ./*.cpp) $(BM_COMMON_DIR)/benchmark_main.cpp
+ALLSRCBASE      := $(notdir $(basename $(ALLSRC) $(ALLCPPSRC)))
+ALLOBJ          := $(addprefix $(OUTDIR)/, $(addsuffix .o, $(ALLSRCBASE)))
+
+# Unlike the unit tests, everything is built with the flags of the Makefile
+# of the benchmark and without coverage hooks, so that it times like it runs
+$(foreach src,$(ALLSRC),$(eval $(call COMPILE_C_TEMPLATE,$(src))))
+$(foreach src,$(ALLCPPSRC),$(eval $(call COMPILE_CXX_TEMPLATE,$(src),-I$(BM_COMMON_DIR))))
+
+$(eval $(call LINK_CXX_TEMPLATE,$(OUTDIR)/$(TARGET).elf,$(ALLOBJ)))
+
+.PHONY: elf
+elf: $(OUTDIR)/$(TARGET).elf
+
+.PHONY: run
+run: $(OUTDIR)/$(TARGET).elf
+	$(V0) @echo " BENCH RUN $(MSG_EXTRA)  $(call toprel, $<)"
+	$(V1) cd $(OUTDIR) && $< --baseline=$(BM_BASELINE) --tolerance=$(BM_TOLERANCE)
+
+.PHONY: baseline
+baseline: $(OUTDIR)/$(TARGET).elf
+	$(V0) @echo " BENCH BASE $(MSG_EXTRA) $(call toprel, $(BM_BASELINE))"
+	$(V1) mkdir -p $(dir $(BM_BASELINE))
+	$(V1) cd $(OUTDIR) && $< --save-baseline=$(BM_BASELINE)
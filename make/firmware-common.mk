@@ -6,12 +6,15 @@ ifneq ($(NO_AUTO_UAVO),YES)
 # Common UAVOs to all targets:
 
 UAVOBJSRCFILENAMES += accels
+UAVOBJSRCFILENAMES += boottiming
 UAVOBJSRCFILENAMES += firmwareiapobj
 UAVOBJSRCFILENAMES += flightstatus
 UAVOBJSRCFILENAMES += flighttelemetrystats
 UAVOBJSRCFILENAMES += gcsreceiver
 UAVOBJSRCFILENAMES += gcstelemetrystats
+UAVOBJSRCFILENAMES += memorystats
 UAVOBJSRCFILENAMES += modulesettings
+UAVOBJSRCFILENAMES += mutexstats
 UAVOBJSRCFILENAMES += objectpersistence
 UAVOBJSRCFILENAMES += receiveractivity
 UAVOBJSRCFILENAMES += sessionmanaging
@@ -19,6 +22,7 @@ UAVOBJSRCFILENAMES += systemalarms
 UAVOBJSRCFILENAMES += systemsettings
 UAVOBJSRCFILENAMES += systemstats
 UAVOBJSRCFILENAMES += taskinfo
+UAVOBJSRCFILENAMES += telemetrysnapshotsettings
 UAVOBJSRCFILENAMES += watchdogstatus
 
 ifneq ($(UAVO_MINIMAL),YES)
@@ -34,6 +38,7 @@ UAVOBJSRCFILENAMES += attitudesettings
 UAVOBJSRCFILENAMES += baroaltitude
 UAVOBJSRCFILENAMES += cameradesired
 UAVOBJSRCFILENAMES += camerastabsettings
+UAVOBJSRCFILENAMES += controlloopstatus
 UAVOBJSRCFILENAMES += fixedwingairspeeds
 UAVOBJSRCFILENAMES += fixedwingpathfollowerstatus
 UAVOBJSRCFILENAMES += flightbatterysettings
@@ -42,6 +47,7 @@ UAVOBJSRCFILENAMES += gpsposition
 UAVOBJSRCFILENAMES += gpsvelocity
 UAVOBJSRCFILENAMES += gyros
 UAVOBJSRCFILENAMES += homelocation
+UAVOBJSRCFILENAMES += latencystatus
 UAVOBJSRCFILENAMES += manualcontrolcommand
 UAVOBJSRCFILENAMES += manualcontrolsettings
 UAVOBJSRCFILENAMES += mixersettings
@@ -71,6 +77,7 @@ UAVOBJSRCFILENAMES += baroairspeed
 UAVOBJSRCFILENAMES += fixedwingpathfollowersettings
 UAVOBJSRCFILENAMES += gpssatellites
 UAVOBJSRCFILENAMES += gpstime
+UAVOBJSRCFILENAMES += gyronotchsettings
 UAVOBJSRCFILENAMES += gyrosbias
 UAVOBJSRCFILENAMES += inssettings
 UAVOBJSRCFILENAMES += insstate
@@ -79,16 +86,22 @@ UAVOBJSRCFILENAMES += magbias
 UAVOBJSRCFILENAMES += magnetometer
 UAVOBJSRCFILENAMES += nedaccel
 UAVOBJSRCFILENAMES += nedposition
+UAVOBJSRCFILENAMES += opticalflow
+UAVOBJSRCFILENAMES += opticalflowsettings
+UAVOBJSRCFILENAMES += pathlookahead
 UAVOBJSRCFILENAMES += pathplannersettings
 UAVOBJSRCFILENAMES += rangefinderdistance
 UAVOBJSRCFILENAMES += stateestimation
 UAVOBJSRCFILENAMES += velocitydesired
+UAVOBJSRCFILENAMES += vibrationanalysisbands
 UAVOBJSRCFILENAMES += vibrationanalysisoutput
 UAVOBJSRCFILENAMES += vibrationanalysissettings
 UAVOBJSRCFILENAMES += vtolpathfollowersettings
 UAVOBJSRCFILENAMES += vtolpathfollowerstatus
 UAVOBJSRCFILENAMES += waypoint
 UAVOBJSRCFILENAMES += waypointactive
+UAVOBJSRCFILENAMES += waypointupload
+UAVOBJSRCFILENAMES += waypointuploadstatus
 endif # UAVO_NAV
 
 endif # !UAVO_MINIMAL
@@ -104,6 +117,14 @@ endif
 
 CFLAGS += $(foreach UAVOBJSRCFILE,$(UAVOBJSRCFILENAMES),-DUAVOBJ_INIT_$(UAVOBJSRCFILE) )
 
+# Lets the object manager size its ID lookup table
+CFLAGS += -DUAVOBJ_NUM_OBJECTS=$(words $(UAVOBJSRCFILENAMES))
+
+# Bounded-error trig in the control loops instead of libm, see misc_math.h
+ifeq ($(FAST_MATH_APPROX), YES)
+CFLAGS += -DMISC_MATH_FAST
+endif
+
 # List of all source files.
 ALLSRC     =  $(ASRC) $(SRC) $(CPPSRC)
 # List of all source files without directory and file-extension.
@@ -55,7 +55,7 @@ EXTRAINCDIRS    += .
 UTMOCKSRC       := $(wildcard ./*.c)
 ALLSRC          := $(SRC) $(UTMOCKSRC)
 ALLCPPSRC       := $(wildcard ./*.cpp) $(GTEST_DIR)/src/gtest_main.cc
-ALLSRCBASE      := $(notdir $(basename $(ALLSRC) $(ALLCPPSRC)))
+ALLSRCBASE      := $(notdir $(basename $(ALLSRC) $(CPPSRC) $(ALLCPPSRC)))
 ALLOBJ          := $(addprefix $(OUTDIR)/, $(addsuffix .o, $(ALLSRCBASE)))
 
 # Build mock versions of APIs required to wrap the code being unit tested
@@ -64,6 +64,7 @@ $(foreach src,$(UTMOCKSRC),$(eval $(call COMPILE_C_TEMPLATE,$(src))))
 # Build the code being unit tested.
 # Enable gcov flags for these files so we can measure the coverage of our unit test
 $(foreach src,$(SRC),$(eval $(call COMPILE_C_TEMPLATE,$(src),$(GCOV_CFLAGS))))
+$(foreach src,$(CPPSRC),$(eval $(call COMPILE_CXX_TEMPLATE,$(src),$(GCOV_CFLAGS))))
 
 # Build any C++ supporting files
 $(foreach src,$(ALLCPPSRC),$(eval $(call COMPILE_CXX_TEMPLATE,$(src))))
@@ -88,7 +89,7 @@ run: $(OUTDIR)/$(TARGET).elf
 	$(V0) @echo " TEST RUN  $(MSG_EXTRA)  $(call toprel, $<)"
 	$(V1) $<
 
-GCOV_INPUT_FILES := $(notdir $(SRC))
+GCOV_INPUT_FILES := $(notdir $(SRC) $(CPPSRC))
 $(foreach src,$(GCOV_INPUT_FILES),$(eval $(call GCOV_TEMPLATE,$(src))))
 
 .PHONY: gcov
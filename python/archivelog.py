@@ -0,0 +1,67 @@
+#!/usr/bin/python -B
+
+"""Imports logs into a columnar archive and queries fields across them.
+
+  ./archivelog.py import fleet logs/*.tll
+  ./archivelog.py list fleet
+  ./archivelog.py query fleet Gyros x y z --start 10 --end 60
+
+A query prints the number of rows and the range of each field per flight,
+use taulabs.archive.Archive from python to work with the arrays.
+"""
+
+import argparse
+
+from taulabs import archive
+
+def main():
+    parser = argparse.ArgumentParser(description="Columnar archive of logs")
+    parser.add_argument("-j", "--processes", type=int, default=None,
+                        help="number of worker processes, default one per CPU")
+    sub = parser.add_subparsers(dest="command")
+
+    p = sub.add_parser("import", help="decode logs into the archive")
+    p.add_argument("archive")
+    p.add_argument("logs", nargs="+")
+    p.add_argument("-g", "--githash",
+                   help="override githash for UAVO XML definitions")
+    p.add_argument("-f", "--force", action="store_true",
+                   help="decode logs again that are already imported")
+
+    p = sub.add_parser("list", help="list the flights in the archive")
+    p.add_argument("archive")
+
+    p = sub.add_parser("query", help="read fields of an object across flights")
+    p.add_argument("archive")
+    p.add_argument("object")
+    p.add_argument("fields", nargs="+")
+    p.add_argument("--start", type=float, help="start time in seconds")
+    p.add_argument("--end", type=float, help="end time in seconds")
+
+    args = parser.parse_args()
+
+    arc = archive.Archive(args.archive)
+
+    if args.command == "import":
+        flights = arc.import_logs(args.logs, githash=args.githash,
+                overwrite=args.force, processes=args.processes)
+        for (log, flight) in zip(args.logs, flights):
+            print "%s -> %s" % (log, flight)
+
+    elif args.command == "list":
+        for (name, meta) in sorted(arc.flights().items()):
+            print "%s: %s, %s, %d objects" % (name, meta['source'],
+                    meta['githash'], len(meta['objects']))
+
+    elif args.command == "query":
+        results = arc.query(args.object, args.fields, start=args.start,
+                end=args.end, processes=args.processes)
+        for (name, cols) in sorted(results.items()):
+            print "%s: %d rows" % (name, len(cols['time']))
+            for field in args.fields:
+                col = cols[field]
+                if len(col):
+                    print "  %s: %s .. %s" % (field, col.min(axis=0), col.max(axis=0))
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,44 @@
+#!/usr/bin/python -B
+
+"""Extract the blackbox frames of a compact onboard log as CSV.
+
+The frames are stored in fixed point, this converts them back to deg/s for
+the rates and to fractions of the full actuator range for the stabilization
+terms.  Must match flight/Libraries/inc/blackbox.h."""
+
+import sys
+
+RATE_SCALE = 10.0
+TERM_SCALE = 10000.0
+
+AXES = ('Roll', 'Pitch', 'Yaw')
+RATE_FIELDS = ('Gyro', 'Setpoint')
+TERM_FIELDS = ('PTerm', 'ITerm', 'DTerm', 'Output')
+
+def main():
+    from taulabs import telemetry
+    uavo_list = telemetry.get_telemetry_by_args(desc="Extract blackbox frames")
+
+    frame_class = uavo_list.uavo_defs.find_by_name('BlackboxFrame')
+
+    columns = ['Time']
+    for f in RATE_FIELDS + TERM_FIELDS:
+        columns.extend([f + a for a in AXES])
+    columns.extend(['Actuator%d' % i for i in range(8)])
+    print ','.join(columns)
+
+    for frame in uavo_list:
+        if not isinstance(frame, frame_class):
+            continue
+
+        row = ['%.6f' % (frame.Time / 1e6)]
+        for f in RATE_FIELDS:
+            row.extend(['%.1f' % (v / RATE_SCALE) for v in getattr(frame, f)])
+        for f in TERM_FIELDS:
+            row.extend(['%.4f' % (v / TERM_SCALE) for v in getattr(frame, f)])
+        row.extend(['%d' % v for v in frame.Actuator])
+        print ','.join(row)
+
+#-------------------------------------------------------------------------------
+if __name__ == "__main__":
+    main()
@@ -4,7 +4,7 @@ import sys
 from taulabs import telemetry
 
 def main():
-    uavo_list = telemetry.get_telemetry_by_args()
+    uavo_list = telemetry.get_telemetry_by_args(bulk=True)
 
     # Start the log viwer app
     from PyQt4 import QtGui
@@ -5,7 +5,74 @@ from matplotlib.backends.backend_qt4agg import FigureCanvasQTAgg as FigureCanvas
 from matplotlib.backends.backend_qt4agg import NavigationToolbar2QT as NavigationToolbar
 import matplotlib.pyplot as plt
 
-import random
+import numpy as np
+
+class MinMaxPyramid():
+    """ A series with min/max envelopes precomputed at coarser and coarser
+    levels, so a view of any span draws about one point per pixel. """
+
+    # Samples merged per step of the pyramid
+    FACTOR = 4
+
+    # Levels stop once this short
+    MIN_LEN = 512
+
+    def __init__(self, t, y):
+        t = np.asarray(t, dtype=np.float64).ravel()
+        y = np.asarray(y, dtype=np.float64).ravel()
+
+        self.t = t
+        self.y = y
+
+        # Each level is (start time, min, max) of its blocks
+        self.levels = []
+
+        lo, hi = y, y
+        while len(t) > self.MIN_LEN:
+            starts = np.arange(0, len(t), self.FACTOR)
+            t = t[starts]
+            lo = np.minimum.reduceat(lo, starts)
+            hi = np.maximum.reduceat(hi, starts)
+            self.levels.append((t, lo, hi))
+
+    @staticmethod
+    def _span(t, t0, t1):
+        """ Indices covering [t0, t1] plus a point each side, so the line
+        runs to the edges of the view """
+        first = max(np.searchsorted(t, t0) - 1, 0)
+        last = min(np.searchsorted(t, t1, side='right') + 1, len(t))
+        return first, last
+
+    @staticmethod
+    def _envelope(level, first, last):
+        (t, lo, hi) = level
+        return (np.repeat(t[first:last], 2),
+                np.column_stack((lo[first:last], hi[first:last])).ravel())
+
+    def overview(self):
+        """ Returns the coarsest points covering the whole series """
+
+        if not self.levels:
+            return self.t, self.y
+
+        return self._envelope(self.levels[-1], 0, len(self.levels[-1][0]))
+
+    def visible(self, t0, t1, pixels):
+        """ Returns the points to draw for the time range [t0, t1] on an axis
+        the given number of pixels wide """
+
+        first, last = self._span(self.t, t0, t1)
+        if last - first <= 2 * pixels or not self.levels:
+            return self.t[first:last], self.y[first:last]
+
+        # The finest level with at most a block per pixel, each drawn as
+        # its min and max so spikes survive
+        for level in self.levels:
+            first, last = self._span(level[0], t0, t1)
+            if last - first <= pixels:
+                break
+
+        return self._envelope(level, first, last)
 
 class Window(QtGui.QDialog):
     def __init__(self, parent=None):
@@ -61,9 +128,14 @@ class Window(QtGui.QDialog):
         self.uavo_list = None
         self.uavo_defs = None
 
+        # Pyramids by series, kept across redraws, and the lines shown
+        self.pyramids = {}
+        self.traces = []
+
     def resizeEvent( self, event ):
         if self.uavo_defs is not None:
             plt.tight_layout()
+            self.update_visible()
 
     def toggleRotation(self, state):
         self.attitude_rotated = state == QtCore.Qt.Checked
@@ -91,9 +163,33 @@ class Window(QtGui.QDialog):
 
         self.uavo_list = uavo_list
         self.uavo_defs = uavo_defs
+        self.pyramids = {}
 
         self.draw()
 
+    def trace(self, ax, key, t, y, fmt='-', label=None):
+        """ Plots a series decimated to the current view """
+
+        pyramid = self.pyramids.get(key)
+        if pyramid is None:
+            pyramid = MinMaxPyramid(t, y)
+            self.pyramids[key] = pyramid
+
+        # The overview sets the autoscaled limits, update_visible() refines
+        (t, y) = pyramid.overview()
+        line, = ax.plot(t, y, fmt, label=label)
+        self.traces.append((ax, line, pyramid))
+
+    def update_visible(self, changed=None):
+        """ Refills the lines for the visible range at screen resolution """
+
+        for (ax, line, pyramid) in self.traces:
+            t0, t1 = ax.get_xlim()
+            pixels = max(int(ax.bbox.width), 1)
+            line.set_data(*pyramid.visible(t0, t1, pixels))
+
+        self.canvas.draw_idle()
+
     def draw(self):
 
         uavo_list = self.uavo_list
@@ -110,36 +206,36 @@ class Window(QtGui.QDialog):
         pd = uavo_list.as_numpy_array(UAVO_PathDesired)
 
         plt.clf()
+        self.traces = []
+        trace = self.trace
 
         # create an axis
         if self.altitude:
             ax1 = self.figure.add_subplot(231)
         else:
             ax1 = self.figure.add_subplot(221)
-        ax1.plot(pos['time'],pos['North'],'.-',label="North")
-        ax1.plot(pos['time'],pos['East'],'.-',label="East")
+        trace(ax1, 'pos.North', pos['time'], pos['North'], '.-', label="North")
+        trace(ax1, 'pos.East', pos['time'], pos['East'], '.-', label="East")
         if self.path_desired:
-            ax1.plot(pd['time'],pd['End'][:,0], 'o-', label="PD North")
-            ax1.plot(pd['time'],pd['End'][:,1], 'o-', label="PD East")
+            trace(ax1, 'pd.North', pd['time'], pd['End'][:,0], 'o-', label="PD North")
+            trace(ax1, 'pd.East', pd['time'], pd['End'][:,1], 'o-', label="PD East")
         if self.gps_position:
-            ax1.plot(ned['time'],ned['North'], '*-', label="GPS North")
-            ax1.plot(ned['time'],ned['East'], '*-', label="GPS East")
+            trace(ax1, 'ned.North', ned['time'], ned['North'], '*-', label="GPS North")
+            trace(ax1, 'ned.East', ned['time'], ned['East'], '*-', label="GPS East")
         plt.xlabel('Time (s)')
         plt.ylabel('Pos (m)')
         plt.legend()
 
-        plt.xlim(pos['time'][0],pos['time'][0]+60)
-
         if self.altitude:
             ax2 = self.figure.add_subplot(232, sharex=ax1)
         else:
             ax2 = self.figure.add_subplot(222, sharex=ax1)
-        ax2.plot(vel['time'],vel['North'],'.-',label="North")
-        ax2.plot(vel['time'],vel['East'],'.-',label="East")
+        trace(ax2, 'vel.North', vel['time'], vel['North'], '.-', label="North")
+        trace(ax2, 'vel.East', vel['time'], vel['East'], '.-', label="East")
         if self.gps_velocity:
             gv = uavo_list.as_numpy_array(UAVO_GPSVelocity)
-            ax2.plot(gv['time'],gv['North'],'*-',label="GPS North")
-            ax2.plot(gv['time'],gv['East'],'*-',label="GPS East")
+            trace(ax2, 'gv.North', gv['time'], gv['North'], '*-', label="GPS North")
+            trace(ax2, 'gv.East', gv['time'], gv['East'], '*-', label="GPS East")
         plt.xlabel('Time (s)')
         plt.ylabel('Vel (m/s)')
         plt.legend()
@@ -157,16 +253,16 @@ class Window(QtGui.QDialog):
             yaw = att['Yaw'][:,0]
             north = pitch * cos(yaw) + roll * -sin(yaw)
             east = pitch * sin(yaw) + roll * cos(yaw)
-            ax3.plot(att['time'],north,'.-',label="North")
-            ax3.plot(att['time'],east,'.-',label="East")
+            trace(ax3, 'att.North', att['time'], north, '.-', label="North")
+            trace(ax3, 'att.East', att['time'], east, '.-', label="East")
         else:
-            ax3.plot(att['time'],att['Roll'],'.-',label="Roll")
-            ax3.plot(att['time'],att['Pitch'],'.-',label="Pitch")
+            trace(ax3, 'att.Roll', att['time'], att['Roll'], '.-', label="Roll")
+            trace(ax3, 'att.Pitch', att['time'], att['Pitch'], '.-', label="Pitch")
 
         if self.stab_desired:
             sd = uavo_list.as_numpy_array(UAVO_StabilizationDesired)
-            ax3.plot(sd['time'],sd['Roll'],'o-',label="Roll Desired")
-            ax3.plot(sd['time'],sd['Pitch'],'o-',label="Pitch Desired")
+            trace(ax3, 'sd.Roll', sd['time'], sd['Roll'], 'o-', label="Roll Desired")
+            trace(ax3, 'sd.Pitch', sd['time'], sd['Pitch'], 'o-', label="Pitch Desired")
         plt.xlabel('Time (s)')
         plt.ylabel('Angle (deg)')
         plt.legend()
@@ -177,9 +273,9 @@ class Window(QtGui.QDialog):
         else:
             ax4 = self.figure.add_subplot(224, sharex=ax1)
         gyros = uavo_list.as_numpy_array(UAVO_Gyros)
-        ax4.plot(gyros['time'],gyros['x'],'.-',label="Roll")
-        ax4.plot(gyros['time'],gyros['y'],'.-',label="Pitch")
-        ax4.plot(gyros['time'],gyros['z'],'.-',label="Yaw")
+        trace(ax4, 'gyros.x', gyros['time'], gyros['x'], '.-', label="Roll")
+        trace(ax4, 'gyros.y', gyros['time'], gyros['y'], '.-', label="Pitch")
+        trace(ax4, 'gyros.z', gyros['time'], gyros['z'], '.-', label="Yaw")
         plt.xlabel('Time (s)')
         plt.ylabel('Rate (deg/s)')
         plt.legend()
@@ -187,21 +283,21 @@ class Window(QtGui.QDialog):
         if self.altitude:
             ax5 = self.figure.add_subplot(233, sharex=ax1)
             baro = uavo_list.as_numpy_array(UAVO_BaroAltitude)
-            ax5.plot(pos['time'],-pos['Down'],label="Altitude")
-            ax5.plot(baro['time'],baro['Altitude']-baro['Altitude'][0,0],label="Baro")
+            trace(ax5, 'pos.Up', pos['time'], -pos['Down'], label="Altitude")
+            trace(ax5, 'baro.Altitude', baro['time'], baro['Altitude']-baro['Altitude'][0,0], label="Baro")
             if self.gps_position:
-                ax5.plot(ned['time'],-ned['Down'],label="GPS")
+                trace(ax5, 'ned.Up', ned['time'], -ned['Down'], label="GPS")
             if self.path_desired:
-                ax5.plot(pd['time'],-pd['End'][:,2], 'o-', label="PD Down")
+                trace(ax5, 'pd.Up', pd['time'], -pd['End'][:,2], 'o-', label="PD Down")
             plt.xlabel('Time (s)')
             plt.ylabel('Pos (m)')
             plt.legend()
 
             ax6 = self.figure.add_subplot(236, sharex=ax1)
-            ax6.plot(vel['time'],-vel['Down'],label="Estimate")
+            trace(ax6, 'vel.Up', vel['time'], -vel['Down'], label="Estimate")
             if self.gps_velocity:
                 gv = uavo_list.as_numpy_array(UAVO_GPSVelocity)
-                ax6.plot(gv['time'],-gv['Down'],label="GPS")
+                trace(ax6, 'gv.Up', gv['time'], -gv['Down'], label="GPS")
             plt.xlabel('Time (s)')
             plt.ylabel('Vel (m/s)')
             plt.legend()
@@ -209,8 +305,12 @@ class Window(QtGui.QDialog):
 
         plt.tight_layout()
 
+        # Pans and zooms only refill the lines, the axes share the time
+        ax1.callbacks.connect('xlim_changed', self.update_visible)
+        ax1.set_xlim(pos['time'][0],pos['time'][0]+60)
+
         # refresh canvas
-        self.canvas.draw()
+        self.update_visible()
 
 if __name__ == '__main__':
     app = QtGui.QApplication(sys.argv)
@@ -0,0 +1,430 @@
+#!/usr/bin/python -B
+
+"""Flies a scripted scenario on many posix simulations at once, one for
+each combination of the swept settings, and reports how each one did.
+
+Every run starts its own sim_posix.elf in a fresh directory (so it begins
+from the default settings) with its ports moved out of the way of the
+others, sends the scenario setup and the swept settings over UAVTalk, and
+then commands a series of attitude steps through the GCS receiver.  The
+whole telemetry stream of each run is recorded as a GCS log next to it.
+
+Per run the report has the RMS attitude tracking error, the settle time
+and overshoot of the steps, the CPU load the flight code reports and the
+host CPU time the simulation used.
+
+Example, sweeping the roll rate loop:
+
+  ./sitl_sweep.py -o sweep \\
+      --set 'StabilizationSettings.RollRatePID[0]=0.0015,0.002,0.003' \\
+      --set 'StabilizationSettings.RollRatePID[1]=0.001,0.002'
+"""
+
+import argparse
+import csv
+import itertools
+import math
+import multiprocessing
+import os
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+# Insert the parent directory into the module import search path.
+sys.path.insert(1, os.path.dirname(sys.path[0]))
+
+from taulabs import telemetry
+
+#-------------------------------------------------------------------------------
+# The default scenario: a quad in attitude mode flown by the GCS receiver
+SETUP = [
+    ('SystemSettings', {'AirframeType': 'QuadX'}),
+    ('ManualControlSettings', {
+        'ChannelGroups[0:5]': ['GCS'] * 5,
+        'ChannelNumber[0:5]': [1, 2, 3, 4, 5],
+        'ChannelMin[0:5]': [1000] * 5,
+        'ChannelNeutral[0:5]': [1000, 1500, 1500, 1500, 1000],
+        'ChannelMax[0:5]': [2000] * 5,
+        'Arming': 'Always Armed',
+        'FlightModeNumber': 1,
+        'FlightModePosition[0]': 'Stabilized1',
+        'Stabilization1Settings': ['Attitude', 'Attitude', 'Rate'],
+        }),
+    ]
+
+#: (seconds after the setup, roll deg, pitch deg), held until the next step
+STEPS = [
+    (2.0, 0, 0),
+    (4.0, 20, 0),
+    (7.0, -20, 0),
+    (10.0, 0, 0),
+    (13.0, 0, 20),
+    (16.0, 0, -20),
+    (19.0, 0, 0),
+    ]
+
+DURATION = 22.0
+
+#: Throttle stick while flying the steps, 0 to 1
+THROTTLE = 0.5
+
+#: A step has settled once the error stays within this part of it
+SETTLE_BAND = 0.05
+SETTLE_MIN_DEG = 1.0
+
+#: Ports of the simulation, each run moves them all by a multiple of this
+PORT = 9000
+PORT_STRIDE = 10
+
+#-------------------------------------------------------------------------------
+def parse_assignment(text):
+    """ Splits 'Object.Field[index]=v1,v2' into its parts and the values. """
+    target, sep, values = text.partition('=')
+    if sep != '=' or '.' not in target:
+        raise ValueError("Expected Object.Field[index]=values, got %s" % text)
+
+    obj_name, field = target.split('.', 1)
+    return obj_name, field, [parse_value(v) for v in values.split(',')]
+
+def parse_value(text):
+    text = text.strip()
+    for conv in (int, float):
+        try:
+            return conv(text)
+        except ValueError:
+            pass
+    return text
+
+def apply_field(obj, field, value):
+    """ Returns obj with field (optionally field[i] or field[i:j]) set to
+    value.  Enum options can be given by name. """
+
+    index = None
+    if field.endswith(']'):
+        field, _, index = field[:-1].partition('[')
+        if ':' in index:
+            start, _, end = index.partition(':')
+            index = slice(int(start), int(end))
+        else:
+            index = int(index)
+
+    def to_raw(v):
+        enum = getattr(obj, 'ENUM_' + field, None)
+        if enum is not None and not isinstance(v, (int, long)):
+            return enum[v]
+        return v
+
+    if isinstance(value, list):
+        value = [to_raw(v) for v in value]
+    else:
+        value = to_raw(value)
+
+    current = getattr(obj, field)
+    if index is None:
+        if isinstance(current, tuple) and not isinstance(value, list):
+            value = [value] * len(current)
+        new = tuple(value) if isinstance(current, tuple) else value
+    else:
+        new = list(current)
+        new[index] = value
+        new = tuple(new)
+
+    return obj._replace(**{field: new})
+
+#-------------------------------------------------------------------------------
+class RecordingTelemetry(telemetry.NetworkTelemetry):
+    """ Network telemetry that writes everything it receives to a GCS log """
+
+    def __init__(self, log_file, *args, **kwargs):
+        self.log_file = log_file
+        self.log_start = time.time()
+        telemetry.NetworkTelemetry.__init__(self, *args, **kwargs)
+
+    def _receive(self, finish_time):
+        data = telemetry.NetworkTelemetry._receive(self, finish_time)
+        if data:
+            ms = int((time.time() - self.log_start) * 1000)
+            self.log_file.write(struct.pack('<Iq', ms, len(data)) + data)
+        return data
+
+def write_log_header(log_file, githash):
+    log_file.write('Tau Labs git hash:\n%s\n%s\n##\n' % (githash, '0' * 40))
+
+def connect(port, log_file, proc, timeout=10.0):
+    """ Connects to the simulation once it listens, or gives up. """
+    deadline = time.time() + timeout
+    while True:
+        try:
+            return RecordingTelemetry(log_file, port=port, service_in_iter=False,
+                    keep_history=False)
+        except socket.error:
+            if proc.poll() is not None or time.time() > deadline:
+                raise
+            time.sleep(0.1)
+
+def send_settings(tStream, settings, timeout=2.0):
+    """ Fetches each object, changes the given fields and sends it back.
+
+    Objects without fields are only fetched. """
+    for obj_name, fields in settings:
+        cls = tStream.uavo_defs.find_by_name(obj_name)
+        if cls is None:
+            raise ValueError("No object %s" % obj_name)
+
+        tStream.request_object(cls)
+        deadline = time.time() + timeout
+        while tStream.get_last_values().get(cls) is None and time.time() < deadline:
+            time.sleep(0.01)
+
+        # Fall back on the defaults a fresh board would have
+        obj = tStream.get_last_values().get(cls) or cls._make_to_send()
+        if not fields:
+            continue
+
+        for field, value in sorted(fields.items()):
+            obj = apply_field(obj, field, value)
+
+        tStream.send_object(obj)
+
+def stick_channels(roll, pitch, rollmax, pitchmax):
+    """ GCS receiver channels for an attitude, in the SETUP mapping """
+    def pwm(deg, maximum):
+        return int(1500 + 500 * max(-1.0, min(1.0, float(deg) / maximum)))
+
+    return [1000 + int(500 * 2 * THROTTLE), pwm(roll, rollmax),
+            pwm(pitch, pitchmax), 1500, 1000, 0, 0, 0]
+
+#-------------------------------------------------------------------------------
+def quat_to_rp(q1, q2, q3, q4):
+    """ Roll and pitch in degrees, like Quaternion2RPY """
+    R13 = 2 * (q2 * q4 - q1 * q3)
+    R23 = 2 * (q3 * q4 + q1 * q2)
+    R33 = q1 * q1 - q2 * q2 - q3 * q3 + q4 * q4
+    roll = math.degrees(math.atan2(R23, R33))
+    pitch = math.degrees(math.asin(max(-1.0, min(1.0, -R13))))
+    return roll, pitch
+
+def setpoint_at(t):
+    roll, pitch = 0, 0
+    for (step_t, r, p) in STEPS:
+        if t < step_t:
+            break
+        roll, pitch = r, p
+    return roll, pitch
+
+def compute_metrics(samples, cpu_loads):
+    """ samples is a list of (t, roll, pitch) relative to the first step """
+    metrics = {}
+
+    errors = []
+    for (t, roll, pitch) in samples:
+        if t < STEPS[0][0] or t > DURATION:
+            continue
+        sp_roll, sp_pitch = setpoint_at(t)
+        errors.append((sp_roll - roll) ** 2 + (sp_pitch - pitch) ** 2)
+
+    metrics['rms_error_deg'] = math.sqrt(sum(errors) / len(errors)) if errors else ''
+
+    settle_times = []
+    overshoots = []
+    unsettled = 0
+    for i in range(1, len(STEPS)):
+        (t0, r0, p0), (t1, r1, p1) = STEPS[i - 1], STEPS[i]
+        t_end = STEPS[i + 1][0] if i + 1 < len(STEPS) else DURATION
+        size = math.hypot(r1 - r0, p1 - p0)
+        if size == 0:
+            continue
+
+        band = max(SETTLE_BAND * size, SETTLE_MIN_DEG)
+        window = [s for s in samples if t1 <= s[0] < t_end]
+        if not window:
+            unsettled += 1
+            continue
+
+        settled_at = None
+        overshoot = 0.0
+        for (t, roll, pitch) in window:
+            err = math.hypot(r1 - roll, p1 - pitch)
+            if err > band:
+                settled_at = None
+            elif settled_at is None:
+                settled_at = t
+
+            # How far it went past the setpoint, along the step
+            along = ((roll - r0) * (r1 - r0) + (pitch - p0) * (p1 - p0)) / size
+            overshoot = max(overshoot, along - size)
+
+        overshoots.append(100.0 * overshoot / size)
+        if settled_at is None:
+            unsettled += 1
+        else:
+            settle_times.append(settled_at - t1)
+
+    metrics['settle_time_mean_s'] = sum(settle_times) / len(settle_times) if settle_times else ''
+    metrics['settle_time_max_s'] = max(settle_times) if settle_times else ''
+    metrics['unsettled_steps'] = unsettled
+    metrics['overshoot_max_pct'] = max(overshoots) if overshoots else ''
+    metrics['cpu_load_mean_pct'] = sum(cpu_loads) / float(len(cpu_loads)) if cpu_loads else ''
+
+    return metrics
+
+#-------------------------------------------------------------------------------
+def run_case(args):
+    """ Flies the scenario once, in a worker process. """
+    (index, case, options) = args
+
+    # Workers run one case at a time, so their number keeps the ports apart
+    worker = multiprocessing.current_process()._identity
+    slot = worker[0] if worker else 1
+    offset = slot * PORT_STRIDE
+
+    run_dir = os.path.join(options.output, 'run%04d' % index)
+    if not os.path.isdir(run_dir):
+        os.makedirs(run_dir)
+
+    stdout = open(os.path.join(run_dir, 'sim.txt'), 'w')
+    log_file = open(os.path.join(run_dir, 'telemetry.tll'), 'wb')
+    write_log_header(log_file, options.githash)
+
+    # The margin leaves time to connect and send the setup
+    cmd = [options.elf, '-p', str(offset), '-t', str(int(DURATION + 30))]
+    proc = subprocess.Popen(cmd, cwd=run_dir, stdout=stdout, stderr=subprocess.STDOUT)
+
+    result = {'run': index}
+    result.update(dict(('%s.%s' % (o, f), v) for (o, f, v) in case))
+
+    try:
+        tStream = connect(PORT + offset, log_file, proc)
+        tStream.start_thread()
+        tStream.wait_connection()
+
+        # The swept settings come after the scenario, so they win
+        settings = list(SETUP)
+        for (obj_name, field, value) in case:
+            settings.append((obj_name, {field: value}))
+        settings.append(('StabilizationSettings', {}))
+        send_settings(tStream, settings)
+
+        stab_cls = tStream.uavo_defs.find_by_name('StabilizationSettings')
+        stab = tStream.get_last_values().get(stab_cls) or stab_cls._make_to_send()
+        rcvr_cls = tStream.uavo_defs.find_by_name('GCSReceiver')
+        att_cls = tStream.uavo_defs.find_by_name('AttitudeActual')
+        stats_cls = tStream.uavo_defs.find_by_name('SystemStats')
+
+        attitudes = tStream.subscribe(att_cls)
+        stats = tStream.subscribe(stats_cls)
+
+        start = time.time()
+        for (step_t, roll, pitch) in STEPS:
+            time.sleep(max(0, start + step_t - time.time()))
+            tStream.send_object(rcvr_cls._make_to_send(
+                Channel=stick_channels(roll, pitch, stab.RollMax, stab.PitchMax),
+                Sequence=0))
+        time.sleep(max(0, start + DURATION - time.time()))
+
+        samples = []
+        for obj in attitudes.get_all():
+            roll, pitch = quat_to_rp(obj.q1, obj.q2, obj.q3, obj.q4)
+            samples.append((obj.time / 1000.0 - start, roll, pitch))
+        cpu_loads = [obj.CPULoad for obj in stats.get_all()]
+
+        result.update(compute_metrics(samples, cpu_loads))
+        result['status'] = 'ok'
+    except Exception as e:
+        result['status'] = 'failed: %s' % e
+    finally:
+        if proc.poll() is None:
+            proc.terminate()
+
+        # Host CPU time the whole simulation took
+        (_, _, usage) = os.wait4(proc.pid, 0)
+        result['host_cpu_s'] = usage.ru_utime + usage.ru_stime
+
+        log_file.close()
+        stdout.close()
+
+    return result
+
+#-------------------------------------------------------------------------------
+def main():
+    global SETUP, STEPS, DURATION
+
+    root = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..')
+
+    parser = argparse.ArgumentParser(description="Sweep settings over simulated flights")
+    parser.add_argument("--elf",
+                        default = os.path.join(root, 'build', 'sim_posix', 'sim_posix.elf'),
+                        help    = "the posix simulation to run")
+    parser.add_argument("-j", "--jobs", type=int,
+                        default = multiprocessing.cpu_count(),
+                        help    = "simulations flown at once (default one per core)")
+    parser.add_argument("-o", "--output",
+                        default = "sitl_sweep",
+                        help    = "directory for the runs and report.csv")
+    parser.add_argument("--set", action="append", default=[],
+                        metavar = "OBJ.FIELD[i]=V1,V2,..",
+                        help    = "values to sweep, every combination is flown")
+    parser.add_argument("--scenario",
+                        help    = "python file replacing SETUP, STEPS and DURATION")
+    options = parser.parse_args()
+
+    if options.scenario:
+        scenario = {}
+        execfile(options.scenario, scenario)
+        SETUP = scenario.get('SETUP', SETUP)
+        STEPS = scenario.get('STEPS', STEPS)
+        DURATION = scenario.get('DURATION', DURATION)
+
+    if not os.path.isfile(options.elf):
+        parser.error("%s is missing, build it with 'make sim_posix'" % options.elf)
+
+    try:
+        options.githash = subprocess.check_output(['git', 'rev-parse', 'HEAD'], cwd=root).strip()
+    except (OSError, subprocess.CalledProcessError):
+        options.githash = '0' * 40
+
+    sweeps = [parse_assignment(s) for s in options.set]
+    axes = [[(o, f, v) for v in values] for (o, f, values) in sweeps]
+    cases = list(itertools.product(*axes))
+
+    print "Flying %d case(s), %d at a time" % (len(cases), options.jobs)
+
+    if not os.path.isdir(options.output):
+        os.makedirs(options.output)
+
+    pool = multiprocessing.Pool(options.jobs)
+    work = [(i, case, options) for i, case in enumerate(cases)]
+    results = []
+    for result in pool.imap_unordered(run_case, work):
+        print "run%04d: %s" % (result['run'], result['status'])
+        results.append(result)
+    pool.close()
+    pool.join()
+
+    results.sort(key=lambda r: r['run'])
+
+    columns = ['run'] + ['%s.%s' % (o, f) for (o, f, _) in sweeps] + \
+        ['rms_error_deg', 'settle_time_mean_s', 'settle_time_max_s',
+         'unsettled_steps', 'overshoot_max_pct', 'cpu_load_mean_pct',
+         'host_cpu_s', 'status']
+
+    with open(os.path.join(options.output, 'report.csv'), 'wb') as f:
+        writer = csv.DictWriter(f, columns, extrasaction='ignore')
+        writer.writeheader()
+        writer.writerows(results)
+
+    # Best tracking first
+    print
+    print "%-8s %10s %10s %10s  %s" % ('run', 'rms deg', 'settle s', 'cpu s', 'settings')
+    scored = [r for r in results if r.get('rms_error_deg') not in (None, '')]
+    for r in sorted(scored, key=lambda r: r['rms_error_deg']):
+        settle = r['settle_time_mean_s']
+        print "run%04d %10.2f %10s %10.1f  %s" % (r['run'], r['rms_error_deg'],
+            '%.2f' % settle if settle != '' else '-', r['host_cpu_s'],
+            ' '.join('%s.%s=%s' % (o, f, r['%s.%s' % (o, f)]) for (o, f, _) in sweeps))
+
+#-------------------------------------------------------------------------------
+if __name__ == "__main__":
+    main()
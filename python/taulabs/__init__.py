@@ -7,3 +7,4 @@ from . import uavo
 from . import uavo_collection
 from . import uavtalk
 from . import telemetry
+from . import archive
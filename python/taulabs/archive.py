@@ -0,0 +1,226 @@
+"""
+Columnar archive of many logs, for analysis across flights.
+
+Copyright (C) 2016 Tau Labs, http://taulabs.org
+Licensed under the GNU LGPL version 2.1 or any later version (see COPYING.LESSER)
+
+Each imported log becomes a directory of the archive with one numpy .npz
+file per object type.  In it every field is a column of its own (the
+'time' column in seconds is the time index, multi instance objects also
+get 'inst_id'), and each column is a separately deflated member of the
+zip.  Reading some fields of an object therefore only inflates those
+columns, and only for the flights that have the object at all:
+
+  archive/
+    <flight>/meta.json          source, git hash and per object row counts
+    <flight>/<ObjectName>.npz   columns of the object
+
+The columns are decoded with the definitions of the git hash the log was
+made with, so flights of different versions sit side by side; a query
+just skips flights where a requested field does not exist.
+"""
+
+import hashlib
+import json
+import multiprocessing
+import os
+
+META_FILE = 'meta.json'
+
+def _flight_id(path, data):
+    """ Names a flight after its log and a hash of its contents, so that
+    importing the same log twice lands in the same place. """
+
+    base = os.path.splitext(os.path.basename(path))[0]
+    return '%s-%s' % (base, hashlib.sha1(data).hexdigest()[:12])
+
+def _import_log(args):
+    """ Decodes one log into the archive, runs in a worker process """
+
+    (archive_path, log_path, githash, overwrite) = args
+
+    import numpy as np
+    import StringIO
+
+    from taulabs import telemetry, uavtalk
+
+    with open(log_path, 'rb') as f:
+        data = f.read()
+
+    flight = _flight_id(log_path, data)
+    flight_path = os.path.join(archive_path, flight)
+
+    if os.path.exists(os.path.join(flight_path, META_FILE)) and not overwrite:
+        return (flight, None)
+
+    file_obj = StringIO.StringIO(data)
+    header_githash, compact_log = telemetry.parse_log_header(file_obj)
+    if githash is None:
+        githash = header_githash
+
+    uavo_defs = telemetry.load_uavo_defs(githash)
+    buf = file_obj.read()
+
+    if compact_log:
+        columns = uavtalk.scan_compact_stream(uavo_defs, buf)
+    else:
+        columns = uavtalk.scan_stream(uavo_defs, buf, gcs_timestamps=True)
+
+    if not os.path.isdir(flight_path):
+        os.makedirs(flight_path)
+
+    objects = {}
+    for (obj, timestamps, instance_ids, raw) in columns.values():
+        arr = obj.from_bytes_array(raw, timestamps, instance_ids)
+        if len(arr) == 0:
+            continue
+
+        cols = dict((name, arr[name]) for name in arr.dtype.names
+                if name not in ('name', 'uavo_id'))
+        np.savez_compressed(os.path.join(flight_path, obj._name + '.npz'),
+                **cols)
+
+        objects[obj._name] = {
+            'rows' : len(arr),
+            'start' : float(arr['time'].min()),
+            'end' : float(arr['time'].max()),
+        }
+
+    meta = {
+        'source' : os.path.abspath(log_path),
+        'githash' : githash,
+        'compact' : compact_log,
+        'objects' : objects,
+    }
+
+    # Written last, a flight without it is an interrupted import
+    with open(os.path.join(flight_path, META_FILE), 'w') as f:
+        json.dump(meta, f, indent=1, sort_keys=True)
+
+    return (flight, meta)
+
+def _scan_flight(args):
+    """ Reads the requested columns of one flight, runs in a worker process """
+
+    (flight_path, obj_name, fields, start, end) = args
+
+    import numpy as np
+
+    try:
+        npz = np.load(os.path.join(flight_path, obj_name + '.npz'))
+    except IOError:
+        return None
+
+    try:
+        if any(field not in npz.files for field in fields):
+            return None
+
+        t = npz['time']
+        result = { 'time' : t }
+        for field in fields:
+            if field != 'time':
+                result[field] = npz[field]
+    finally:
+        npz.close()
+
+    if start is not None or end is not None:
+        keep = np.ones(len(t), dtype=bool)
+        if start is not None:
+            keep &= t >= start
+        if end is not None:
+            keep &= t <= end
+
+        for name in result:
+            result[name] = result[name][keep]
+
+    return result
+
+class Archive():
+    """ An archive of decoded logs that is queried by object and field """
+
+    def __init__(self, path):
+        """ Opens or creates the archive in the directory path """
+
+        self.path = path
+        if not os.path.isdir(path):
+            os.makedirs(path)
+
+    def flights(self):
+        """ Returns the meta data of all flights, by flight name """
+
+        result = {}
+        for name in sorted(os.listdir(self.path)):
+            meta_path = os.path.join(self.path, name, META_FILE)
+            if os.path.isfile(meta_path):
+                with open(meta_path) as f:
+                    result[name] = json.load(f)
+
+        return result
+
+    def import_logs(self, log_paths, githash=None, overwrite=False,
+            processes=None):
+        """ Decodes logs into the archive, several at a time.
+
+         - log_paths: GCS or onboard logs with a header
+         - githash: decode with these definitions instead of the header's
+         - overwrite: decode again logs that are already in the archive
+         - processes: number of worker processes, default one per CPU
+
+        Returns the names of the flights, in the order of log_paths.
+        """
+
+        jobs = [(self.path, p, githash, overwrite) for p in log_paths]
+
+        pool = multiprocessing.Pool(processes)
+        try:
+            results = pool.map(_import_log, jobs)
+        finally:
+            pool.close()
+            pool.join()
+
+        return [flight for (flight, meta) in results]
+
+    def query(self, obj_name, fields, flights=None, start=None, end=None,
+            processes=None):
+        """ Reads some fields of an object across many flights in parallel.
+
+         - obj_name: the object name, like 'Gyros'
+         - fields: the field names, 'time' and 'inst_id' are columns too
+         - flights: names of the flights to scan, default all that have
+           the object
+         - start, end: only rows within this time range, in seconds
+         - processes: number of worker processes, default one per CPU
+
+        Returns a dictionary by flight name of dictionaries by field name of
+        numpy arrays.  Flights without the object or one of the fields are
+        left out.
+        """
+
+        if isinstance(fields, basestring):
+            fields = [fields]
+
+        candidates = []
+        for (name, meta) in self.flights().items():
+            if flights is not None and name not in flights:
+                continue
+            info = meta['objects'].get(obj_name)
+            if info is None:
+                continue
+            if start is not None and info['end'] < start:
+                continue
+            if end is not None and info['start'] > end:
+                continue
+            candidates.append(name)
+
+        jobs = [(os.path.join(self.path, name), obj_name, fields, start, end)
+                for name in candidates]
+
+        pool = multiprocessing.Pool(processes)
+        try:
+            results = pool.map(_scan_flight, jobs)
+        finally:
+            pool.close()
+            pool.join()
+
+        return dict((name, r) for (name, r) in zip(candidates, results)
+                if r is not None)
@@ -12,13 +12,144 @@ import select
 import errno
 
 import threading
+import collections
 
 import uavtalk, uavo_collection, uavo
 
 import os
+import fcntl
 
 from abc import ABCMeta, abstractmethod
 
+# Most bytes read from a link at once, and parsed as one batch
+READ_SIZE = 65536
+
+def load_uavo_defs(githash=None):
+    """ Loads the UAVO definitions of a git revision, or of this source tree. """
+
+    uavo_defs = uavo_collection.UAVOCollection()
+
+    if githash:
+        uavo_defs.from_git_hash(githash)
+    else:
+        xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
+                                "shared", "uavobjectdefinition")
+        uavo_defs.from_uavo_xml_path(xml_path)
+
+    return uavo_defs
+
+def parse_log_header(file_obj):
+    """ Reads the header the GCS and the onboard logging write.
+
+    Returns the git hash the log is based on and whether the log is in the
+    compact format.
+    """
+
+    # Check the header signature
+    #    First line is "Tau Labs git hash:"
+    #    Second line is the actual git hash
+    #    Third line is the UAVO hash
+    #    Fourth line is "##", or "##compact" for onboard logs in
+    #    the compact format
+    sig = file_obj.readline()
+    if sig != 'Tau Labs git hash:\n':
+        print "Source file does not have a recognized header signature"
+        print '|' + sig + '|'
+        raise IOError("no header signature")
+    # Determine the git hash that this log file is based on
+    githash = file_obj.readline()[:-1]
+    if githash.find(':') != -1:
+        import re
+        githash = re.search(':(\w*)\W', githash).group(1)
+
+    print "Log file is based on git hash: %s" % githash
+
+    uavohash = file_obj.readline()
+    divider = file_obj.readline()
+
+    return githash, divider == uavtalk.COMPACT_MARKER
+
+class Subscription():
+    """
+    Queue of the received instances of one object class, filled by the
+    thread servicing the connection.
+    """
+
+    def __init__(self, maxlen=None, overwrite=False):
+        """ Creates an empty queue.  Use TelemetryBase.subscribe().
+
+         - maxlen: most instances held, None for no limit
+         - overwrite: when full, drop the oldest instance instead of making
+             the service thread wait for the consumer.  With maxlen=1 the
+             queue is a slot holding the latest value.
+        """
+
+        self.items = collections.deque()
+        self.maxlen = maxlen
+        self.overwrite = overwrite
+        self.dropped = 0
+        self.closed = False
+        self.cond = threading.Condition()
+
+    def _full(self):
+        return self.maxlen is not None and len(self.items) >= self.maxlen
+
+    def put(self, obj):
+        """ Queues an instance.  Blocks while full unless overwriting, which
+        holds off reading the link until the consumer catches up. """
+
+        with self.cond:
+            if self.overwrite:
+                if self._full():
+                    self.items.popleft()
+                    self.dropped += 1
+            else:
+                while self._full() and not self.closed:
+                    self.cond.wait()
+
+            self.items.append(obj)
+            self.cond.notifyAll()
+
+    def get(self, timeout=None):
+        """ Returns the oldest queued instance, waiting up to timeout seconds
+        for one.  Returns None on timeout or once the stream has ended. """
+
+        if timeout is not None:
+            finish_time = time.time() + timeout
+
+        with self.cond:
+            while not self.items and not self.closed:
+                if timeout is None:
+                    self.cond.wait()
+                else:
+                    remaining = finish_time - time.time()
+                    if remaining <= 0:
+                        break
+                    self.cond.wait(remaining)
+
+            if not self.items:
+                return None
+
+            obj = self.items.popleft()
+            self.cond.notifyAll()
+
+            return obj
+
+    def get_all(self):
+        """ Returns everything queued, without waiting. """
+
+        with self.cond:
+            objs = list(self.items)
+            self.items.clear()
+            self.cond.notifyAll()
+
+            return objs
+
+    def close(self):
+        with self.cond:
+            self.closed = True
+            self.cond.notifyAll()
+
 class TelemetryBase():
     """
     Basic (abstract) implementation of telemetry used by all stream types.
@@ -29,7 +160,8 @@ class TelemetryBase():
 
     def __init__(self, githash=None, service_in_iter=True,
             iter_blocks=True, use_walltime=True, do_handshaking=False,
-            gcs_timestamps=False, name=None):
+            gcs_timestamps=False, name=None, compact_log=False,
+            keep_history=True):
 
         """Instantiates a telemetry instance.  Called only by derived classes.
          - githash: revision control id of the UAVO's used to communicate.
@@ -47,22 +179,23 @@ class TelemetryBase():
          - gcs_timestamps: if true, this means we are reading from a file with
              the GCS timestamp protocol.
          - name: a filename to store into .filename for legacy purposes
+         - compact_log: if true, the stream is an onboard log in the compact
+             format.
+         - keep_history: if true, keep every object received for iteration.
+             Long running links that read through subscribe() or
+             get_last_values() can turn it off to bound memory.
         """
 
-        uavo_defs = uavo_collection.UAVOCollection()
-
-        if githash:
-            uavo_defs.from_git_hash(githash)
-        else:
-            xml_path = os.path.join(os.path.dirname(__file__), "..", "..",
-                                    "shared", "uavobjectdefinition")
-            uavo_defs.from_uavo_xml_path(xml_path)
+        uavo_defs = load_uavo_defs(githash)
 
         self.githash = githash
 
         self.uavo_defs = uavo_defs
-        self.uavtalk_generator = uavtalk.process_stream(uavo_defs,
-            use_walltime=use_walltime, gcs_timestamps=gcs_timestamps)
+        if compact_log:
+            self.uavtalk_generator = uavtalk.process_compact_stream(uavo_defs)
+        else:
+            self.uavtalk_generator = uavtalk.process_stream(uavo_defs,
+                use_walltime=use_walltime, gcs_timestamps=gcs_timestamps)
 
         self.uavtalk_generator.send(None)
 
@@ -72,6 +205,12 @@ class TelemetryBase():
 
         self.cond = threading.Condition()
 
+        self.keep_history = keep_history
+        self.subscriptions = {}
+        self.service_thread = None
+
+        self.send_lock = threading.Lock()
+
         self.service_in_iter = service_in_iter
         self.iter_blocks = iter_blocks
 
@@ -158,8 +297,31 @@ class TelemetryBase():
                 Status=self.GCSTelemetryStats.ENUM_Status[handshake])
 
     def send_object(self, obj):
+        """ Sends an object.  With a service thread running this only queues
+        it, and the thread writes everything queued since its last pass at
+        once, so scripts can send at a high rate without a write each. """
         self._send(uavtalk.send_object(obj))
 
+    def subscribe(self, match_class, maxlen=None, overwrite=False):
+        """ Returns a Subscription that receives every instance of
+        match_class from now on.  See Subscription for maxlen and overwrite.
+        """
+        sub = Subscription(maxlen, overwrite)
+
+        with self.cond:
+            if self.eof:
+                sub.close()
+            self.subscriptions.setdefault(match_class, []).append(sub)
+
+        return sub
+
+    def unsubscribe(self, sub):
+        with self.cond:
+            for subs in self.subscriptions.values():
+                if sub in subs:
+                    subs.remove(sub)
+        sub.close()
+
     def __handle_handshake(self, obj):
         if obj.name == "UAVO_FlightTelemetryStats":
             # Handle the telemetry handshaking
@@ -202,7 +364,8 @@ class TelemetryBase():
         with self.cond:
             # keep everything in ram forever
             # for now-- in case we wanna see
-            self.uavo_list.extend(objs)
+            if self.keep_history:
+                self.uavo_list.extend(objs)
 
             if frames == '':
                 self.eof=True
@@ -212,6 +375,20 @@ class TelemetryBase():
 
             self.cond.notifyAll()
 
+            subscriptions = dict((cls, list(subs)) for (cls, subs)
+                    in self.subscriptions.items() if subs)
+
+        # Delivered outside the lock, a full queue may block here
+        if subscriptions:
+            for obj in objs:
+                for sub in subscriptions.get(obj.__class__, ()):
+                    sub.put(obj)
+
+        if frames == '':
+            for subs in subscriptions.values():
+                for sub in subs:
+                    sub.close()
+
     def get_last_values(self):
         """ Returns the last instance of each kind of object received. """
         with self.cond:
@@ -249,6 +426,8 @@ class TelemetryBase():
 
         t.daemon=True
 
+        self.service_thread = t
+
         t.start()
 
     def service_connection(self, timeout=None):
@@ -278,6 +457,10 @@ class TelemetryBase():
     def _send(self, msg):
         return
 
+    def _wake(self):
+        """ Makes the service thread look at the send queue """
+        return
+
     def _done(self):
         with self.cond:
             return self.eof
@@ -320,9 +503,19 @@ class BidirTelemetry(TelemetryBase):
     def _send(self, msg):
         """ Send a string to the controller """
 
-        self.send_buf += msg
+        with self.send_lock:
+            self.send_buf += msg
 
-        self._do_io(0)
+        if self.service_thread is None:
+            self._do_io(0)
+        else:
+            self._wake()
+
+    def _sent(self, written):
+        """ Drops what was written from the send queue """
+
+        with self.send_lock:
+            self.send_buf = self.send_buf[written:]
 
     @abstractmethod
     def _do_io(self, finish_time):
@@ -351,17 +544,34 @@ class FDTelemetry(BidirTelemetry):
 
         self.fd = fd
 
+        # Lets senders interrupt the select of the service thread
+        self.wake_rd, self.wake_wr = os.pipe()
+        for wake_fd in (self.wake_rd, self.wake_wr):
+            fcntl.fcntl(wake_fd, fcntl.F_SETFL,
+                    fcntl.fcntl(wake_fd, fcntl.F_GETFL) | os.O_NONBLOCK)
+
+    def _wake(self):
+        try:
+            os.write(self.wake_wr, 'w')
+        except OSError as err:
+            # Already pending
+            if err.errno != errno.EAGAIN:
+                raise
+
     # Call select and do one set of IO operations.
     def _do_io(self, finish_time):
-        rdSet = []
+        rdSet = [self.wake_rd]
         wrSet = []
 
         did_stuff = False
 
-        if len(self.recv_buf) < 1024:
+        if len(self.recv_buf) < READ_SIZE:
             rdSet.append(self.fd)
 
-        if len(self.send_buf) > 0:
+        with self.send_lock:
+            pending = self.send_buf
+
+        if len(pending) > 0:
             wrSet.append(self.fd)
 
         now = time.time()
@@ -373,12 +583,19 @@ class FDTelemetry(BidirTelemetry):
 
             r,w,e = select.select(rdSet, wrSet, [], tm)
 
-        if r:
+        if self.wake_rd in r:
+            try:
+                os.read(self.wake_rd, 64)
+            except OSError as err:
+                if err.errno != errno.EAGAIN:
+                    raise
+
+        if self.fd in r:
             # Shouldn't throw an exception-- they just told us
             # it was ready for read.
             # TODO: Figure out why read sometimes fails when using sockets
             try:
-                chunk = os.read(self.fd, 1024)
+                chunk = os.read(self.fd, READ_SIZE)
                 if chunk == '':
                     raise RuntimeError("stream closed")
 
@@ -392,10 +609,10 @@ class FDTelemetry(BidirTelemetry):
                     raise
 
         if w:
-            written = os.write(self.fd, self.send_buf)
+            written = os.write(self.fd, pending)
 
             if written > 0:
-                self.send_buf = self.send_buf[written:]
+                self._sent(written)
 
             did_stuff = True
 
@@ -452,7 +669,7 @@ class SerialTelemetry(BidirTelemetry):
 
         while not did_stuff:
             try:
-                chunk = self.ser.read(1024)
+                chunk = self.ser.read(READ_SIZE)
 
                 if chunk != '':
                     did_stuff = True
@@ -461,12 +678,15 @@ class SerialTelemetry(BidirTelemetry):
                 # Ignore this; looks like a pyserial bug
                 pass
 
-            if self.send_buf != '':
+            with self.send_lock:
+                pending = self.send_buf
+
+            if pending != '':
                 try:
-                    written = self.ser.write(self.send_buf)
+                    written = self.ser.write(pending)
 
                     if written > 0:
-                        self.send_buf = self.send_buf[written:]
+                        self._sent(written)
                         did_stuff = True
                 except pyserial.SerialTimeoutException:
                     pass
@@ -498,26 +718,10 @@ class FileTelemetry(TelemetryBase):
         self.f = file_obj
 
         if parse_header:
-            # Check the header signature
-            #    First line is "Tau Labs git hash:"
-            #    Second line is the actual git hash
-            #    Third line is the UAVO hash
-            #    Fourth line is "##"
-            sig = self.f.readline()
-            if sig != 'Tau Labs git hash:\n':
-                print "Source file does not have a recognized header signature"
-                print '|' + sig + '|'
-                raise IOError("no header signature")
-            # Determine the git hash that this log file is based on
-            githash = self.f.readline()[:-1]
-            if githash.find(':') != -1:
-                import re
-                githash = re.search(':(\w*)\W', githash).group(1)
-
-            print "Log file is based on git hash: %s" % githash
-
-            uavohash = self.f.readline()
-            divider = self.f.readline()
+            githash, compact_log = parse_log_header(self.f)
+
+            if compact_log:
+                kwargs['compact_log'] = True
 
             TelemetryBase.__init__(self, service_in_iter=False, iter_blocks=True,
                 do_handshaking=False, githash=githash, use_walltime=False,
@@ -536,9 +740,72 @@ class FileTelemetry(TelemetryBase):
 
         return buf
 
+class BulkFileTelemetry():
+    """ Decodes a whole log at once into one numpy array per object type
+
+    The log is scanned once for frame boundaries and the updates are grouped
+    by object, each type is only decoded (with np.frombuffer) when it is
+    asked for.  Unlike FileTelemetry it does not keep a list of the
+    individual objects, it only offers as_numpy_array().
+    """
+
+    def __init__(self, file_obj, parse_header=False, githash=None,
+            gcs_timestamps=False, name=None, compact_log=False):
+        """ Instantiates a telemetry instance reading a whole file.
+
+         - file_obj: the file object to read from
+         - parse_header: whether to read a header like the GCS writes from the
+           file.
+         - githash, gcs_timestamps, compact_log: as for TelemetryBase
+        """
+
+        if parse_header:
+            githash, compact_log = parse_log_header(file_obj)
+
+        self.githash = githash
+        self.uavo_defs = load_uavo_defs(githash)
+        self.filename = name
+
+        buf = file_obj.read()
+
+        if compact_log:
+            self.columns = uavtalk.scan_compact_stream(self.uavo_defs, buf)
+        else:
+            self.columns = uavtalk.scan_stream(self.uavo_defs, buf,
+                gcs_timestamps=gcs_timestamps)
+
+        self.arrays = {}
+
+    def as_numpy_array(self, match_class, filter_cond=None):
+        """ Returns all received instances of a given object as a numpy array.
+
+        match_class: the UAVO_* class you'd like to match.
+        filter_cond: an optional function selecting rows of the array.
+        """
+
+        import numpy as np
+
+        arr = self.arrays.get(match_class._id)
+        if arr is None:
+            column = self.columns.get('{0:08x}'.format(match_class._id))
+            if column is None:
+                return np.array([])
+
+            (obj, timestamps, instance_ids, data) = column
+            arr = obj.from_bytes_array(data, timestamps, instance_ids)
+            self.arrays[match_class._id] = arr
+
+        if filter_cond is not None:
+            arr = arr[np.array([bool(filter_cond(x)) for x in arr], dtype=bool)]
+
+        return arr
+
 def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
-        iter_blocks=True):
-    """ Parses command line to decide how to get a telemetry object. """
+        iter_blocks=True, bulk=False):
+    """ Parses command line to decide how to get a telemetry object.
+
+    With bulk, files are decoded at once into a BulkFileTelemetry.
+    """
     # Setup the command line arguments.
     import argparse
     parser = argparse.ArgumentParser(description=desc)
@@ -597,6 +864,10 @@ def get_telemetry_by_args(desc="Process telemetry", service_in_iter=True,
     if os.path.isfile(args.source):
         file_obj = file(args.source, 'rb')
 
+        if bulk:
+            return telemetry.BulkFileTelemetry(file_obj, parse_header=parse_header,
+                githash=githash, gcs_timestamps=args.timestamped, name=args.source)
+
         t = telemetry.FileTelemetry(file_obj, parse_header=parse_header,
             gcs_timestamps=args.timestamped, name=args.source)
 
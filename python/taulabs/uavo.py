@@ -87,6 +87,52 @@ class UAVTupleClass():
 
         return cls._make(field_values)
 
+    @classmethod
+    def packed_dtype(cls):
+        """ Returns the numpy dtype of the serialized object.
+
+        It is generated from the format of _packstruct, so np.frombuffer()
+        with it reads the same values as from_bytes() does.
+        """
+        import numpy as np
+
+        counts_codes = re.findall('(\\d+)(\\w)', cls._packstruct.format)
+        field_names = cls._fields[len(cls._fields) - len(counts_codes):]
+
+        return np.dtype([(field_name, '<' + code, (int(count),))
+                         for field_name, (count, code) in zip(field_names, counts_codes)])
+
+    @classmethod
+    def from_bytes_array(cls, data, timestamps, instance_ids=None):
+        """ Deserializes many instances of this object into a numpy array.
+
+         - data: a sequence of serialized objects, or a string with all of
+           them back to back
+         - timestamps: the timestamp in ms of each instance
+         - instance_ids: the instance id of each instance for multi
+           instance objects
+
+        The array has the same _dtype as as_numpy_array() produces.
+        """
+        import numpy as np
+
+        if not isinstance(data, str):
+            data = ''.join(data)
+
+        packed = np.frombuffer(data, dtype=cls.packed_dtype())
+
+        result = np.zeros(len(packed), dtype=cls._dtype)
+        result['name'] = cls._name
+        result['time'] = np.asarray(timestamps, dtype='double') / 1000.0
+        result['uavo_id'] = cls._id
+        if not cls._single and instance_ids is not None:
+            result['inst_id'] = instance_ids
+
+        for field_name in packed.dtype.names:
+            result[field_name] = packed[field_name]
+
+        return result
+
     def __repr__(self):
         """ String representation of the contents """
         rep = self.__class__.__name__ + '('
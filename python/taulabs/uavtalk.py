@@ -12,7 +12,8 @@ this interface.
 import struct
 import time
 
-__all__ = [ "send_object", "process_stream" ]
+__all__ = [ "send_object", "process_stream", "process_compact_stream",
+            "scan_stream", "scan_compact_stream" ]
 
 # Constants used for UAVTalk parsing
 (MIN_HEADER_LENGTH, MAX_HEADER_LENGTH, MAX_PAYLOAD_LENGTH) = (8, 12, (256-12))
@@ -20,6 +21,27 @@ __all__ = [ "send_object", "process_stream" ]
 (TYPE_MASK, TYPE_VER) = (0x78, 0x20)
 (TIMESTAMPED) = (0x80)
 (TYPE_OBJ, TYPE_OBJ_REQ, TYPE_OBJ_ACK, TYPE_ACK, TYPE_NACK, TYPE_OBJ_TS, TYPE_OBJ_ACK_TS) = (0x00, 0x01, 0x02, 0x03, 0x04, 0x80, 0x82)
+TYPE_OBJ_DELTA = 0x05
+
+# Deltas carry a mask of changed chunks, each object is split in up to 32
+delta_mask_fmt = struct.Struct('<I')
+DELTA_CHUNKS = 32
+
+# Bundles carry several single instance objects, each behind an id and size
+TYPE_OBJ_BUNDLE = 0x06
+bundle_entry_fmt = struct.Struct('<LB')
+
+# Snapshots are bundles copied at one time, the object id is their version
+# and the payload starts with the time of the copy in ms
+TYPE_OBJ_SNAPSHOT = TIMESTAMPED | TYPE_OBJ_BUNDLE
+snapshot_time_fmt = struct.Struct('<L')
+
+# Compact onboard logs, see flight/Modules/Logging/logging.c
+COMPACT_MARKER = '##compact\n'
+COMPACT_HEADER_SIG = 'Tau Labs git hash:\n'
+(COMPACT_TIME, COMPACT_MULTI_INSTANCE) = (0xFF, 0x01)
+compact_entry_fmt = struct.Struct('<BLHB')
+compact_time_fmt = struct.Struct('<BL')
 
 # Serialization of header elements
 
@@ -67,6 +89,9 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
 
     pending_pieces = []
 
+    # Last data of each single instance object, deltas are applied to it
+    last_data = {}
+
     while True:
         # If we don't have sufficient data buffered, join up any chunks we've 
         # been given to ensure pending_pieces is empty for the rest of this loop.
@@ -131,62 +156,22 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
             continue    # go to top to look for sync
     
         pack_type &= ~ TYPE_MASK
-        
-        if pack_len < MIN_HEADER_LENGTH or pack_len > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH:
-            print "badlen %d"%(pack_len)
-            buf_offset += 1
-            continue
-        
-        # Search for object.
-        uavo_key = '{0:08x}'.format(objId)
-        if not uavo_key in uavo_defs:
-            #print "Unknown object 0x" + uavo_key
-            obj = None
-        else:
-            obj = uavo_defs[uavo_key]
 
-        # Determine data length
-        if pack_type == TYPE_OBJ_REQ or pack_type == TYPE_ACK or pack_type == TYPE_NACK:
-            obj_len = 0
-            timestamp_len = 0
-            obj = None
-        else:
-            if obj is not None:
-                timestamp_len = timestamp_fmt.size if pack_type == TYPE_OBJ_TS or pack_type == TYPE_OBJ_ACK_TS else 0
-                obj_len = obj.get_size_of_data()
-            else:
-                # we don't know anything, so fudge to keep sync.
-                timestamp_len = 0
-                obj_len = pack_len - header_fmt.size
+        layout = frame_layout(uavo_defs, pack_type, pack_len, objId)
+        if isinstance(layout, str):
+            print layout
 
-        if obj is not None and not obj._single:
-            instance_len = 2
-        else:
-            instance_len = 0
-
-        # Check length and determine next state
-        if obj_len >= MAX_PAYLOAD_LENGTH:
-            print "bad len-- bad xml?"
-            #should never happen; requires invalid uavo xml
+            # packet error, consume a byte to try syncing right after
+            # where we did...
             buf_offset += 1
             continue
 
+        (uavo_key, obj, instance_len, timestamp_len, obj_len) = layout
+
         # calc_size, AKA timestamp, and obj data
         # as appropriate, plus our current header
         # also equivalent to the offset of the CRC in the packet
-
-        calc_size = header_fmt.size + instance_len + timestamp_len + obj_len
-
-        # Check the lengths match
-        if calc_size != pack_len:
-            print "mismatched size id=%s %d vs %d, type %d"%(uavo_key,
-                calc_size, pack_len, pack_type)
-
-            # packet error - mismatched packet size
-            # Consume a byte to try syncing right after where we
-            # did...
-            buf_offset += 1
-            continue
+        calc_size = pack_len
 
         # OK, at this point we are seriously hoping to receive
         # a packet.  Time for another loop to make sure we have
@@ -236,9 +221,43 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
         if gcs_timestamps:
             timestamp = overrideTimestamp
 
+        if pack_type == TYPE_OBJ_BUNDLE or pack_type == TYPE_OBJ_SNAPSHOT:
+            offset = header_fmt.size + buf_offset
+            bundle = buf[offset:offset + obj_len]
+
+            if pack_type == TYPE_OBJ_SNAPSHOT:
+                if not use_walltime and not gcs_timestamps:
+                    timestamp = snapshot_time_fmt.unpack_from(bundle)[0]
+                bundle = bundle[snapshot_time_fmt.size:]
+
+            for (uavo_key, obj, data) in split_bundle(uavo_defs, bundle):
+                last_data[uavo_key] = data
+
+                objInstance = obj.from_bytes(data, timestamp, None)
+                received += 1
+                if not (received % 20000):
+                    print "received %d objs"%(received)
+
+                next_recv = yield objInstance
+
+                if next_recv is not None and next_recv != '':
+                    pending_pieces.append(next_recv)
+
+            buf_offset += calc_size + 1
+            continue
+
         if obj is not None:
             offset = header_fmt.size + instance_len + timestamp_len + buf_offset
-            objInstance = obj.from_bytes(buf, timestamp, instance_id, offset=offset)
+            data = buf[offset:offset + obj_len]
+
+            if pack_type == TYPE_OBJ_DELTA:
+                data = apply_delta(obj, last_data.get(uavo_key), data)
+
+            if obj._single and data is not None:
+                last_data[uavo_key] = data
+
+        if obj is not None and data is not None:
+            objInstance = obj.from_bytes(data, timestamp, instance_id)
             received += 1
             if not (received % 20000):
                 print "received %d objs"%(received)
@@ -252,6 +271,421 @@ def process_stream(uavo_defs, use_walltime=False, gcs_timestamps=False):
         if next_recv is not None and next_recv != '':
             pending_pieces.append(next_recv)
 
+def frame_layout(uavo_defs, pack_type, pack_len, objId):
+    """Works out the layout of a frame from its header.
+
+    pack_type is the type without the version bits.  Returns a tuple of the
+    object key, its definition (None if the frame carries no object data)
+    and the lengths of the instance id, timestamp and object data, or a
+    string describing why the header is invalid."""
+
+    if pack_len < MIN_HEADER_LENGTH or pack_len > MAX_HEADER_LENGTH + MAX_PAYLOAD_LENGTH:
+        return "badlen %d"%(pack_len)
+
+    # Search for object.
+    uavo_key = '{0:08x}'.format(objId)
+    obj = uavo_defs.get(uavo_key)
+
+    # Determine data length
+    if pack_type == TYPE_OBJ_REQ or pack_type == TYPE_ACK or pack_type == TYPE_NACK:
+        obj_len = 0
+        timestamp_len = 0
+        obj = None
+    elif pack_type == TYPE_OBJ_DELTA and obj is not None and obj._single:
+        timestamp_len = 0
+        obj_len = pack_len - header_fmt.size
+    elif pack_type == TYPE_OBJ_SNAPSHOT:
+        # The id is a version, the objects are in the payload
+        timestamp_len = 0
+        obj_len = pack_len - header_fmt.size
+        obj = None
+        if obj_len < snapshot_time_fmt.size:
+            return "short snapshot"
+    else:
+        if obj is not None:
+            timestamp_len = timestamp_fmt.size if pack_type == TYPE_OBJ_TS or pack_type == TYPE_OBJ_ACK_TS else 0
+            obj_len = obj.get_size_of_data()
+        else:
+            # we don't know anything, so fudge to keep sync.
+            timestamp_len = 0
+            obj_len = pack_len - header_fmt.size
+
+    if obj is not None and not obj._single:
+        instance_len = 2
+    else:
+        instance_len = 0
+
+    # Check length
+    if obj_len >= MAX_PAYLOAD_LENGTH:
+        #should never happen; requires invalid uavo xml
+        return "bad len-- bad xml?"
+
+    calc_size = header_fmt.size + instance_len + timestamp_len + obj_len
+
+    # Check the lengths match
+    if calc_size != pack_len:
+        return "mismatched size id=%s %d vs %d, type %d"%(uavo_key,
+            calc_size, pack_len, pack_type)
+
+    return (uavo_key, obj, instance_len, timestamp_len, obj_len)
+
+def scan_stream(uavo_defs, buf, gcs_timestamps=False):
+    """Splits a complete UAVTalk stream into the updates of each object.
+
+    This is the bulk counterpart of process_stream(): the whole buffer is
+    walked once and the data of every update is only sliced, not decoded.
+    Returns a dict of object key to a tuple of the object definition and
+    lists of timestamps (ms), instance ids and data, to be turned into
+    arrays with from_bytes_array().
+
+    With gcs_timestamps the log framing delimits every frame, so the CRC is
+    only checked on raw streams where garbage has to be skipped."""
+
+    columns = {}
+    last_data = {}
+
+    timestamp_base = 0
+    last_timestamp = 0
+
+    sync = chr(SYNC_VAL)
+    pos = 0
+    end = len(buf)
+
+    while True:
+        if gcs_timestamps:
+            if pos + logheader_fmt.size > len(buf):
+                break
+            (timestamp, length) = logheader_fmt.unpack_from(buf, pos)
+            pos += logheader_fmt.size
+            end = pos + length
+            if end > len(buf):
+                break
+            next_pos = end
+        else:
+            next_pos = None
+
+        while True:
+            pos = buf.find(sync, pos, end)
+            if pos < 0 or pos + header_fmt.size > end:
+                break
+
+            (_, pack_type, pack_len, objId) = header_fmt.unpack_from(buf, pos)
+
+            if (pack_type & TYPE_MASK) != TYPE_VER:
+                pos += 1
+                continue
+
+            pack_type &= ~ TYPE_MASK
+
+            layout = frame_layout(uavo_defs, pack_type, pack_len, objId)
+            if isinstance(layout, str) or pos + pack_len + 1 > end:
+                pos += 1
+                continue
+
+            (uavo_key, obj, instance_len, timestamp_len, obj_len) = layout
+
+            if not gcs_timestamps and calcCRC(buf[pos:pos + pack_len]) != buf[pos + pack_len]:
+                pos += 1
+                continue
+
+            offset = pos + header_fmt.size
+            pos += pack_len + 1
+
+            if obj is None and pack_type != TYPE_OBJ_BUNDLE and pack_type != TYPE_OBJ_SNAPSHOT:
+                continue
+
+            if instance_len:
+                instance_id = instance_fmt.unpack_from(buf, offset)[0]
+            else:
+                instance_id = None
+
+            if gcs_timestamps:
+                pass
+            elif timestamp_len:
+                timestamp = timestamp_fmt.unpack_from(buf, offset + instance_len)[0]
+
+                # handle wraparound
+                if timestamp < last_timestamp:
+                    timestamp_base = timestamp_base + 65536
+                last_timestamp = timestamp
+                timestamp += timestamp_base
+            else:
+                timestamp = last_timestamp
+
+            offset += instance_len + timestamp_len
+            data = buf[offset:offset + obj_len]
+
+            if pack_type == TYPE_OBJ_SNAPSHOT:
+                if not gcs_timestamps:
+                    timestamp = snapshot_time_fmt.unpack_from(data)[0]
+                data = data[snapshot_time_fmt.size:]
+                updates = [(key, o, d, None) for (key, o, d) in split_bundle(uavo_defs, data)]
+            elif pack_type == TYPE_OBJ_BUNDLE:
+                updates = [(key, o, d, None) for (key, o, d) in split_bundle(uavo_defs, data)]
+            else:
+                if pack_type == TYPE_OBJ_DELTA:
+                    data = apply_delta(obj, last_data.get(uavo_key), data)
+                    if data is None:
+                        continue
+                updates = [(uavo_key, obj, data, instance_id)]
+
+            for (key, o, d, inst) in updates:
+                if o._single:
+                    last_data[key] = d
+
+                column = columns.get(key)
+                if column is None:
+                    column = columns[key] = (o, [], [], [])
+                column[1].append(timestamp)
+                column[2].append(inst)
+                column[3].append(d)
+
+        if next_pos is None:
+            break
+        pos = next_pos
+
+    return columns
+
+def scan_compact_stream(uavo_defs, buf):
+    """Splits a complete onboard log in the compact format like scan_stream().
+
+    buf starts with the short code table right after the COMPACT_MARKER line
+    of the header, as for process_compact_stream()."""
+
+    columns = {}
+    codes = None
+    timestamp = 0
+    pos = 0
+
+    while pos < len(buf):
+        if codes is None:
+            # Parse the table, it ends with a time record
+            end = pos
+            while end < len(buf) and buf[end] != chr(COMPACT_TIME):
+                end += compact_entry_fmt.size
+            if end >= len(buf):
+                break
+
+            codes = {}
+            for i in xrange(pos, end, compact_entry_fmt.size):
+                (code, objId, size, flags) = compact_entry_fmt.unpack_from(buf, i)
+                key = '{0:08x}'.format(objId)
+                obj = uavo_defs.get(key)
+                if obj is not None and obj.get_size_of_data() != size:
+                    print "size of %08x does not match the definitions" % (objId)
+                    obj = None
+                codes[code] = (key, obj, size, bool(flags & COMPACT_MULTI_INSTANCE))
+
+            pos = end
+            continue
+
+        code = ord(buf[pos])
+
+        if buf.startswith(COMPACT_HEADER_SIG, pos):
+            marker = buf.find(COMPACT_MARKER, pos)
+            if marker < 0:
+                # Only the UAVTalk format is left
+                break
+            pos = marker + len(COMPACT_MARKER)
+            codes = None
+            continue
+
+        if code == COMPACT_TIME:
+            if len(buf) - pos < compact_time_fmt.size:
+                break
+            timestamp = compact_time_fmt.unpack_from(buf, pos)[1]
+            pos += compact_time_fmt.size
+            continue
+
+        if code not in codes:
+            # Corrupted, look for the next record that makes sense
+            pos += 1
+            continue
+
+        (key, obj, size, multi) = codes[code]
+        header_len = 4 if multi else 2
+
+        if len(buf) - pos < header_len + size:
+            break
+
+        timestamp += ord(buf[pos + 1])
+
+        if obj is not None:
+            column = columns.get(key)
+            if column is None:
+                column = columns[key] = (obj, [], [], [])
+            column[1].append(timestamp)
+            column[2].append(instance_fmt.unpack_from(buf, pos + 2)[0] if multi else None)
+            column[3].append(buf[pos + header_len:pos + header_len + size])
+
+        pos += header_len + size
+
+    return columns
+
+def process_compact_stream(uavo_defs):
+    """Generator function that parses the compact format of onboard logs.
+
+    Used like process_stream().  The stream starts with the short code table
+    right after the COMPACT_MARKER line of the header; the header of a log
+    that was appended later is skipped and its table replaces the old one."""
+
+    buf = ''
+    pos = 0
+    codes = None
+    timestamp = 0
+    starved = False
+
+    while True:
+        next_recv = None
+
+        if codes is None:
+            # Parse the table, it ends with a time record
+            end = pos
+            while end < len(buf) and buf[end] != chr(COMPACT_TIME):
+                end += compact_entry_fmt.size
+
+            if end >= len(buf):
+                rx = yield None
+                if rx is None:
+                    return
+                buf = buf[pos:] + rx
+                pos = 0
+                continue
+
+            codes = {}
+            for i in xrange(pos, end, compact_entry_fmt.size):
+                (code, objId, size, flags) = compact_entry_fmt.unpack_from(buf, i)
+                obj = uavo_defs.get('{0:08x}'.format(objId))
+                if obj is not None and obj.get_size_of_data() != size:
+                    print "size of %08x does not match the definitions" % (objId)
+                    obj = None
+                codes[code] = (obj, size, bool(flags & COMPACT_MULTI_INSTANCE))
+
+            pos = end
+            continue
+
+        if pos >= len(buf):
+            rx = yield None
+            if rx is None:
+                return
+            buf = rx
+            pos = 0
+            continue
+
+        # What looks like the start of the header of an appended log needs
+        # more data to tell, unless there is no more
+        rest = buf[pos:pos + len(COMPACT_HEADER_SIG)]
+        if rest != COMPACT_HEADER_SIG and COMPACT_HEADER_SIG.startswith(rest) and not starved:
+            rx = yield None
+            if rx is None:
+                return
+            starved = (rx == '')
+            buf = buf[pos:] + rx
+            pos = 0
+            continue
+        starved = False
+
+        code = ord(buf[pos])
+
+        if buf.startswith(COMPACT_HEADER_SIG, pos):
+            marker = buf.find(COMPACT_MARKER, pos)
+            if marker < 0:
+                # Only the UAVTalk format is left
+                return
+            pos = marker + len(COMPACT_MARKER)
+            codes = None
+            continue
+
+        if code == COMPACT_TIME:
+            if len(buf) - pos < compact_time_fmt.size:
+                return
+            timestamp = compact_time_fmt.unpack_from(buf, pos)[1]
+            pos += compact_time_fmt.size
+            continue
+
+        if code not in codes:
+            # Corrupted, look for the next record that makes sense
+            pos += 1
+            continue
+
+        (obj, size, multi) = codes[code]
+        header_len = 4 if multi else 2
+
+        if len(buf) - pos < header_len + size:
+            rx = yield None
+            if rx is None:
+                return
+            buf = buf[pos:] + rx
+            pos = 0
+            continue
+
+        timestamp += ord(buf[pos + 1])
+
+        if multi:
+            instance_id = instance_fmt.unpack_from(buf, pos + 2)[0]
+        else:
+            instance_id = None
+
+        if obj is not None:
+            data = buf[pos + header_len:pos + header_len + size]
+            next_recv = yield obj.from_bytes(data, timestamp, instance_id)
+
+        pos += header_len + size
+
+        if next_recv is not None and next_recv != '':
+            buf = buf[pos:] + next_recv
+            pos = 0
+
+def apply_delta(obj, last, delta):
+    """Merge the chunks of a delta into the last data of an object.
+
+    Returns None if there is no earlier data to apply it to or the delta
+    does not match the object."""
+
+    if last is None or len(delta) < delta_mask_fmt.size:
+        return None
+
+    size = obj.get_size_of_data()
+    chunk = (size + DELTA_CHUNKS - 1) // DELTA_CHUNKS
+    mask = delta_mask_fmt.unpack_from(delta)[0]
+
+    pieces = []
+    pos = delta_mask_fmt.size
+    for i in xrange(0, (size + chunk - 1) // chunk):
+        start = i * chunk
+        end = min(start + chunk, size)
+        if mask & (1 << i):
+            pieces.append(delta[pos:pos + end - start])
+            pos += end - start
+        else:
+            pieces.append(last[start:end])
+
+    if pos != len(delta):
+        return None
+
+    return ''.join(pieces)
+
+def split_bundle(uavo_defs, bundle):
+    """Generator over the known objects in the payload of a bundle.
+
+    Yields tuples of the object key, its definition and its data. Objects
+    that are unknown or do not match their definition are skipped."""
+
+    pos = 0
+    while pos + bundle_entry_fmt.size <= len(bundle):
+        (objId, size) = bundle_entry_fmt.unpack_from(bundle, pos)
+        pos += bundle_entry_fmt.size
+
+        if pos + size > len(bundle):
+            return
+
+        uavo_key = '{0:08x}'.format(objId)
+        obj = uavo_defs.get(uavo_key)
+        if obj is not None and obj._single and obj.get_size_of_data() == size:
+            yield (uavo_key, obj, bundle[pos:pos + size])
+
+        pos += size
+
 def send_object(obj):
     """Generates a string containing a UAVTalk packet describing this object"""
 
@@ -265,6 +699,26 @@ def send_object(obj):
 
     return packet
 
+def send_snapshot(objs, version, timestamp=0):
+    """Generates a UAVTalk packet that sets several single instance objects
+    at once, the board applies all of them or none.
+
+    version must increase with every snapshot sent, starting at 1."""
+
+    payload = snapshot_time_fmt.pack(timestamp & 0xFFFFFFFF)
+    for obj in objs:
+        data = obj.to_bytes()
+        payload += bundle_entry_fmt.pack(obj._id, len(data)) + data
+
+    hdr = header_fmt.pack(SYNC_VAL, TYPE_OBJ_SNAPSHOT | TYPE_VER,
+        header_fmt.size + len(payload), version)
+
+    packet = hdr + payload
+
+    packet += calcCRC(packet)
+
+    return packet
+
 def request_object(obj):
     """Makes a request for this object"""
     packet = header_fmt.pack(SYNC_VAL, TYPE_OBJ_REQ | TYPE_VER,
@@ -0,0 +1,198 @@
+#!/usr/bin/python -B
+
+"""Show the onboard event trace of a compact log.
+
+Firmware built with ENABLE_TRACE=YES stamps thread switches, interrupts,
+queue operations and object events with the cycle counter and logs them in
+TraceBlock records.  This lists the events in time order, or with --plot
+draws a timeline with a row per thread, showing when it ran, a row per
+interrupt and ticks for the other events.  The event codes must match
+flight/PiOS/inc/pios_trace.h."""
+
+import sys
+
+(THREAD_IN, ISR_ENTER, ISR_EXIT, QUEUE_SEND, QUEUE_RECEIVE, UAVO_EVENT,
+        CALLBACK_ENTER, CALLBACK_EXIT, MARK) = range(1, 10)
+
+EVENT_NAMES = { THREAD_IN : 'ThreadIn', ISR_ENTER : 'ISREnter',
+        ISR_EXIT : 'ISRExit', QUEUE_SEND : 'QueueSend',
+        QUEUE_RECEIVE : 'QueueReceive', UAVO_EVENT : 'UAVOEvent',
+        CALLBACK_ENTER : 'CallbackEnter', CALLBACK_EXIT : 'CallbackExit',
+        MARK : 'Mark' }
+
+ISR_SOURCES = { 1 : 'SPI', 2 : 'USART', 3 : 'TIM' }
+
+UAVO_EVENTS = ((0x01, 'unpacked'), (0x02, 'updated'), (0x04, 'manual'),
+        (0x08, 'periodic'), (0x10, 'request'), (0x40, 'throttled'))
+
+NO_INDEX = 0xFF
+
+def object_names(uavo_defs, buf):
+    """ Maps the short codes of the objects to their names, from the table
+    at the start of the compact log """
+
+    from taulabs import uavtalk
+
+    names = {}
+    pos = 0
+    while pos < len(buf) and buf[pos] != chr(uavtalk.COMPACT_TIME):
+        (code, objId, size, flags) = uavtalk.compact_entry_fmt.unpack_from(buf, pos)
+        obj = uavo_defs.get('{0:08x}'.format(objId))
+        if obj is not None:
+            names[code] = obj._name
+        pos += uavtalk.compact_entry_fmt.size
+
+    return names
+
+def read_events(uavo_defs, buf):
+    """ Returns the events of all TraceBlock records as arrays of the time in
+    us since the first event, the event code and the argument, followed by
+    the log time in s of the first block and the number of dropped events """
+
+    import numpy as np
+    from taulabs import uavtalk
+
+    block_class = uavo_defs.find_by_name('TraceBlock')
+
+    blocks = None
+    for (obj, timestamps, instance_ids, raw) in uavtalk.scan_compact_stream(uavo_defs, buf).values():
+        if obj is block_class:
+            blocks = obj.from_bytes_array(raw, timestamps, instance_ids)
+
+    if blocks is None or len(blocks) == 0:
+        return None
+
+    counts = blocks['Count'].reshape(len(blocks))
+    keep = np.arange(blocks['Cycles'].shape[1]) < counts[:, np.newaxis]
+
+    cycles = blocks['Cycles'][keep].astype(np.uint32)
+    events = blocks['Event'][keep]
+    args = blocks['Arg'][keep]
+
+    # The counter wraps, the events are in order and never that far apart
+    steps = np.diff(cycles).astype(np.uint32).astype(np.float64)
+    elapsed = np.concatenate(([0.0], np.cumsum(steps)))
+
+    cycles_per_us = float(blocks['CyclesPerUs'].flat[0])
+    times = elapsed / max(cycles_per_us, 1.0)
+
+    return (times, events, args, blocks['time'][0], int(blocks['Dropped'].sum()))
+
+def describe(event, arg, names):
+    """ Text for one event """
+
+    if event == THREAD_IN:
+        return 'thread %04x' % arg
+    if event in (ISR_ENTER, ISR_EXIT):
+        return '%s %02x' % (ISR_SOURCES.get(arg >> 8, '?'), arg & 0xFF)
+    if event in (QUEUE_SEND, QUEUE_RECEIVE):
+        return 'queue %04x' % arg
+    if event == UAVO_EVENT:
+        flags = [n for (bit, n) in UAVO_EVENTS if (arg >> 8) & bit]
+        return '%s %s' % (names.get(arg & 0xFF, 'object %d' % (arg & 0xFF)), ','.join(flags))
+    if event in (CALLBACK_ENTER, CALLBACK_EXIT):
+        if arg == NO_INDEX:
+            return 'timer'
+        return names.get(arg, 'object %d' % arg)
+    return '%d' % arg
+
+def print_events(times, events, args, names):
+    for (t, event, arg) in zip(times, events, args):
+        print '%12.1f %-14s %s' % (t, EVENT_NAMES.get(event, '?'), describe(event, arg, names))
+
+def plot_events(times, events, args, names):
+    """ Draws a row per thread and interrupt with the spans they ran, and
+    ticks for the queue, object and marker events """
+
+    import matplotlib.pyplot as plt
+
+    rows = {}
+    spans = {}
+
+    def row(label):
+        if label not in rows:
+            rows[label] = len(rows)
+            spans[label] = []
+        return label
+
+    running = None
+    isr_start = {}
+    ticks = []
+
+    for (t, event, arg) in zip(times, events, args):
+        if event == THREAD_IN:
+            if running is not None:
+                spans[running[0]].append((running[1], t - running[1]))
+            running = (row(describe(event, arg, names)), t)
+        elif event == ISR_ENTER:
+            isr_start[arg] = t
+        elif event == ISR_EXIT and arg in isr_start:
+            label = row(describe(event, arg, names))
+            spans[label].append((isr_start[arg], t - isr_start.pop(arg)))
+        elif event != ISR_EXIT:
+            ticks.append((t, event, describe(event, arg, names)))
+
+    fig, ax = plt.subplots()
+
+    for (label, idx) in rows.items():
+        ax.broken_barh(spans[label], (idx - 0.4, 0.8))
+
+    tick_row = len(rows)
+    for (t, event, text) in ticks:
+        ax.plot([t, t], [tick_row - 0.4, tick_row + 0.4], color='k', linewidth=0.5)
+
+    labels = sorted(rows, key=rows.get) + ['events']
+    ax.set_yticks(range(len(labels)))
+    ax.set_yticklabels(labels)
+    ax.set_xlabel('time (us)')
+
+    plt.show()
+
+def main():
+    import argparse
+    parser = argparse.ArgumentParser(description="Show the event trace of a compact onboard log")
+
+    parser.add_argument("-g", "--githash",
+                        action  = "store",
+                        dest    = "githash",
+                        help    = "override githash for UAVO XML definitions")
+
+    parser.add_argument("-p", "--plot",
+                        action  = "store_true",
+                        default = False,
+                        help    = "draw a timeline instead of listing the events")
+
+    parser.add_argument("log",
+                        help  = "onboard log in the compact format")
+
+    args = parser.parse_args()
+
+    from taulabs import telemetry
+
+    with open(args.log, 'rb') as f:
+        githash, compact_log = telemetry.parse_log_header(f)
+        buf = f.read()
+
+    if not compact_log:
+        print "Only logs in the compact format have a trace"
+        sys.exit(1)
+
+    uavo_defs = telemetry.load_uavo_defs(args.githash or githash)
+    names = object_names(uavo_defs, buf)
+
+    trace = read_events(uavo_defs, buf)
+    if trace is None:
+        print "The log has no trace, build the firmware with ENABLE_TRACE=YES"
+        sys.exit(1)
+
+    (times, events, event_args, start, dropped) = trace
+    print "%d events from %.3f s on, %d dropped" % (len(times), start, dropped)
+
+    if args.plot:
+        plot_events(times, events, event_args, names)
+    else:
+        print_events(times, events, event_args, names)
+
+#-------------------------------------------------------------------------------
+if __name__ == "__main__":
+    main()
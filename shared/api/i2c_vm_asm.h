@@ -65,6 +65,10 @@ enum i2c_vm_opcodes {
 
 	/* UAVO operations */
 	I2C_VM_OP_SEND_UAVO,    /* Send UAV Object */
+
+	/* Register I2C operations, added last to keep stored programs valid */
+	I2C_VM_OP_READ_REG,     /* Read device registers in one transfer */
+	I2C_VM_OP_WRITE_REG,    /* Write a device register in one transfer */
 };
 
 /* Register names */
@@ -120,6 +124,8 @@ enum i2c_vm_reg_names {
 #define I2C_VM_ASM_SET_DEV_ADDR(addr)              (I2C_VM_ASM(I2C_VM_OP_SET_DEV_ADDR, (addr), 0, 0))
 #define I2C_VM_ASM_READ_I2C(addr, length)          (I2C_VM_ASM(I2C_VM_OP_READ, (addr), (length), 0))
 #define I2C_VM_ASM_WRITE_I2C(addr, length)         (I2C_VM_ASM(I2C_VM_OP_WRITE, (addr), (length), 0))
+#define I2C_VM_ASM_READ_REG_I2C(reg, addr, length) (I2C_VM_ASM(I2C_VM_OP_READ_REG, (reg), (addr), (length)))
+#define I2C_VM_ASM_WRITE_REG_I2C(reg, value)       (I2C_VM_ASM(I2C_VM_OP_WRITE_REG, (reg), (value), 0))
 
 /* UAVO operations */
 #define I2C_VM_ASM_SEND_UAVO()                     (I2C_VM_ASM(I2C_VM_OP_SEND_UAVO, 0, 0, 0))